@@ -0,0 +1,107 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file DenseProfiles2D.h
+/// \author Nicolo' Jacazio <nicolo.jacazio@cern.ch>, CERN
+/// \brief Running moments of several TProfile2D with the same binning, accumulated in one array and added to the profiles when flushed
+///
+/// The values of a track are all filled in the same (x, y) cell: the cell is found once and the sum, sum of squares
+/// and count of each profile are stored next to each other, instead of one profile fill (and bin search) per value.
+/// The profiles stay the output, so that they can be merged as before.
+
+#ifndef ALICE3_CORE_DENSEPROFILES2D_H_
+#define ALICE3_CORE_DENSEPROFILES2D_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <TProfile2D.h>
+
+namespace o2::analysis::alice3
+{
+
+/// Moments of a set of profiles between two flushes
+class DenseProfiles2D
+{
+ public:
+  /// \param profiles  profiles to which the moments are added, the first one defines the binning
+  void setup(std::vector<std::shared_ptr<TProfile2D>> const& profiles)
+  {
+    mProfiles = profiles;
+    const std::size_t nCells = static_cast<std::size_t>(profiles[0]->GetNcells());
+    mMoments.assign(nCells * mProfiles.size(), Moments{});
+    mFilledCells.clear();
+    mIsFilled.assign(nCells, false);
+  }
+
+  /// \return cell of (x, y), common to all the profiles
+  int findCell(double x, double y) const { return mProfiles[0]->FindFixBin(x, y); }
+
+  /// Fills the value of the profile with index profile in the cell of findCell
+  void fill(int cell, std::size_t profile, double value)
+  {
+    if (!mIsFilled[cell]) {
+      mIsFilled[cell] = true;
+      mFilledCells.push_back(cell);
+    }
+    auto& moments = mMoments[cell * mProfiles.size() + profile];
+    moments.sum += value;
+    moments.sum2 += value * value;
+    ++moments.count;
+  }
+
+  /// Adds the moments to the profiles, as unit weight fills, and clears them
+  void flush()
+  {
+    for (std::size_t index = 0; index < mProfiles.size(); index++) {
+      TProfile2D* profile = mProfiles[index].get();
+      const bool hasBinSumw2 = profile->GetBinSumw2()->fN > 0;
+      std::size_t entries = 0;
+      for (auto cell : mFilledCells) {
+        auto& moments = mMoments[cell * mProfiles.size() + index];
+        if (moments.count == 0) {
+          continue;
+        }
+        profile->fArray[cell] += moments.sum;
+        profile->GetSumw2()->fArray[cell] += moments.sum2;
+        profile->SetBinEntries(cell, profile->GetBinEntries(cell) + moments.count);
+        if (hasBinSumw2) {
+          profile->GetBinSumw2()->fArray[cell] += moments.count;
+        }
+        entries += moments.count;
+        moments = Moments{};
+      }
+      profile->SetEntries(profile->GetEntries() + entries);
+    }
+    for (auto cell : mFilledCells) {
+      mIsFilled[cell] = false;
+    }
+    mFilledCells.clear();
+  }
+
+ private:
+  struct Moments {
+    double sum = 0.;
+    double sum2 = 0.;
+    uint32_t count = 0;
+  };
+
+  std::vector<std::shared_ptr<TProfile2D>> mProfiles{}; ///< profiles to which the moments are added
+  std::vector<Moments> mMoments{};                      ///< moments of the profiles, the ones of a cell are contiguous
+  std::vector<int> mFilledCells{};                      ///< cells with values since the last flush
+  std::vector<bool> mIsFilled{};                        ///< flag of the cells in mFilledCells
+};
+
+} // namespace o2::analysis::alice3
+
+#endif // ALICE3_CORE_DENSEPROFILES2D_H_
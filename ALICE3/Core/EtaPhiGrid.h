@@ -0,0 +1,122 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file EtaPhiGrid.h
+/// \brief Spatial hash of objects (e.g. calorimeter clusters) in cells of (eta, phi), for the association with tracks
+///
+/// The objects of an event are sorted by cell once, with a counting sort into a flat array, so that the candidates of
+/// a track are only the objects of the cells overlapping its (delta eta, delta phi) window instead of all the objects of
+/// the event. Phi is periodic, the objects outside of the eta range are kept in the first and last cells.
+
+#ifndef ALICE3_CORE_ETAPHIGRID_H_
+#define ALICE3_CORE_ETAPHIGRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o2::analysis::alice3
+{
+
+class EtaPhiGrid
+{
+ public:
+  /// \param etaMin  lower edge of the eta range
+  /// \param etaMax  upper edge of the eta range
+  /// \param nEta  number of cells in eta
+  /// \param nPhi  number of cells in phi, over [0, 2 pi)
+  void setup(float etaMin, float etaMax, int nEta, int nPhi)
+  {
+    mEtaMin = etaMin;
+    mNEta = std::max(nEta, 1);
+    mNPhi = std::max(nPhi, 1);
+    mInvEtaWidth = mNEta / (etaMax - etaMin);
+    mInvPhiWidth = mNPhi / TwoPi;
+    mFirst.assign(mNEta * mNPhi + 1, 0);
+  }
+
+  /// Sorts the objects by cell, their position in the input being the index given back by forEachCandidate
+  void fill(std::vector<float> const& etas, std::vector<float> const& phis)
+  {
+    const int nObjects = etas.size();
+    const int nCells = mNEta * mNPhi;
+    mCells.resize(nObjects);
+    std::fill(mFirst.begin(), mFirst.end(), 0);
+    for (int i = 0; i < nObjects; ++i) {
+      mCells[i] = etaCell(etas[i]) * mNPhi + phiCell(phis[i]);
+      ++mFirst[mCells[i] + 1];
+    }
+    for (int cell = 0; cell < nCells; ++cell) {
+      mFirst[cell + 1] += mFirst[cell];
+    }
+    mObjects.resize(nObjects);
+    mNext.assign(mFirst.begin(), mFirst.end() - 1);
+    for (int i = 0; i < nObjects; ++i) {
+      mObjects[mNext[mCells[i]]++] = i;
+    }
+  }
+
+  /// Calls func(index) for each object in the cells overlapping [eta - deltaEta, eta + deltaEta] x [phi - deltaPhi, phi + deltaPhi]
+  /// The objects are those of the cells, the caller applies the exact window
+  template <typename F>
+  void forEachCandidate(float eta, float phi, float deltaEta, float deltaPhi, F&& func) const
+  {
+    const int etaFirst = etaCell(eta - deltaEta);
+    const int etaLast = etaCell(eta + deltaEta);
+    // all the phi cells if the window covers the full azimuth, without visiting a cell twice
+    const int nPhiCells = std::min(static_cast<int>(std::floor((phi + deltaPhi) * mInvPhiWidth)) - static_cast<int>(std::floor((phi - deltaPhi) * mInvPhiWidth)) + 1, mNPhi);
+    const int phiFirst = phiCell(phi - deltaPhi);
+    for (int iEta = etaFirst; iEta <= etaLast; ++iEta) {
+      for (int iPhi = 0; iPhi < nPhiCells; ++iPhi) {
+        const int cell = iEta * mNPhi + (phiFirst + iPhi) % mNPhi;
+        for (int i = mFirst[cell]; i < mFirst[cell + 1]; ++i) {
+          func(mObjects[i]);
+        }
+      }
+    }
+  }
+
+  /// \return phi difference in [-pi, pi)
+  static float deltaPhi(float phi1, float phi2)
+  {
+    float delta = std::fmod(phi1 - phi2 + Pi, TwoPi);
+    return delta < 0 ? delta + Pi : delta - Pi;
+  }
+
+ private:
+  static constexpr float Pi = static_cast<float>(M_PI);
+  static constexpr float TwoPi = static_cast<float>(2. * M_PI);
+
+  int etaCell(float eta) const
+  {
+    return std::clamp(static_cast<int>(std::floor((eta - mEtaMin) * mInvEtaWidth)), 0, mNEta - 1);
+  }
+
+  int phiCell(float phi) const
+  {
+    int cell = static_cast<int>(std::floor(phi * mInvPhiWidth)) % mNPhi;
+    return cell < 0 ? cell + mNPhi : cell;
+  }
+
+  float mEtaMin = 0.f;
+  float mInvEtaWidth = 1.f;
+  float mInvPhiWidth = 1.f;
+  int mNEta = 1;
+  int mNPhi = 1;
+  std::vector<int> mFirst;   ///< position of the first object of each cell in mObjects, and total number of objects
+  std::vector<int> mNext;    ///< next free position of each cell during the fill
+  std::vector<int> mCells;   ///< cell of each object
+  std::vector<int> mObjects; ///< objects sorted by cell
+};
+
+} // namespace o2::analysis::alice3
+
+#endif // ALICE3_CORE_ETAPHIGRID_H_
@@ -19,6 +19,8 @@
 #ifndef O2_ANALYSIS_PID_TOFRESOALICE3_H_
 #define O2_ANALYSIS_PID_TOFRESOALICE3_H_
 
+#include <array>
+
 // O2 includes
 #include "PID/ParamBase.h"
 #include "PID/DetectorResponse.h"
@@ -83,6 +85,44 @@ float TOFResoALICE3ParamTrack(const T& track, const Parameters& parameters)
   // return TOFResoALICE3Param(track.p(), track.sigma1Pt(), collision.collisionTimeRes() * 1000.f, track.length(), o2::track::pid_constants::sMasses[id], parameters);
 }
 
+/// Expected resolution and Nsigma of a track for all the mass hypotheses, same values as TOFResoALICE3ParamTrack and the Nsigma of ALICE3pidTOFTask.
+/// The quantities that do not depend on the mass hypothesis (momentum resolution, measured time, collision) are computed once per track
+template <typename T>
+void TOFResoALICE3ParamTrackAllSpecies(const T& track, const Parameters& parameters,
+                                       std::array<float, o2::track::PID::NIDs>& expSigma,
+                                       std::array<float, o2::track::PID::NIDs>& nSigma)
+{
+  const float BETA = tan(0.25f * static_cast<float>(M_PI) - 0.5f * atan(track.tgl()));
+  const float sigmaP = sqrt(track.pt() * track.pt() * track.sigma1Pt() * track.sigma1Pt() + (BETA * BETA - 1.f) / (BETA * (BETA * BETA + 1.f)) * (track.tgl() / sqrt(track.tgl() * track.tgl() + 1.f) - 1.f) * track.sigmaTgl() * track.sigmaTgl());
+  const float momentum = track.p();
+  const float length = track.length();
+  const float evtimereso = track.collision().collisionTimeRes() * 1000.f;
+  const bool hasTOF = track.hasTOF();
+  const float tof = hasTOF ? (track.trackTime() - track.collision().collisionTime()) * 1000.f : 0.f;
+  const float expMom = track.tofExpMom() / kCSPEED;
+  // Terms of TOFResoALICE3Param independent of the mass
+  const float p2 = momentum * momentum;
+  const float Lc = length / 0.0299792458f;
+  const float ep = sigmaP * momentum;
+  for (int id = 0; id < o2::track::PID::NIDs; id++) {
+    if (momentum <= 0) {
+      expSigma[id] = -999.f;
+    } else {
+      const float mass2 = o2::track::pid_constants::sMasses2Z[id] * o2::track::pid_constants::sMasses2Z[id];
+      const float etexp = Lc * mass2 / p2 / sqrt(mass2 + p2) * ep;
+      expSigma[id] = sqrt(etexp * etexp + parameters[0] * parameters[0] + evtimereso * evtimereso);
+    }
+    if (!hasTOF) {
+      nSigma[id] = -999.f;
+      continue;
+    }
+    // Same as ExpTimes::ComputeExpectedTime
+    const float massZ = o2::track::pid_constants::sMasses2Z[id];
+    const float expTime = length * sqrt((massZ * massZ) + (expMom * expMom)) / (kCSPEED * expMom);
+    nSigma[id] = (tof - expTime) / expSigma[id];
+  }
+}
+
 } // namespace o2::pid::tof
 
 #endif
@@ -16,6 +16,10 @@
 ///         Only the tables for the mass hypotheses requested are filled, the others are sent empty.
 ///
 
+#include <array>
+#include <filesystem>
+#include <string>
+
 // O2 includes
 #include "Framework/AnalysisTask.h"
 #include "Framework/HistogramRegistry.h"
@@ -90,6 +94,11 @@ struct ALICE3pidTOFTask {
   Configurable<std::string> sigmaname{"param-sigma", "TOFResoALICE3", "Name of the parametrization for the expected sigma, used in both file and CCDB mode"};
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
+  Configurable<bool> reloadParameters{"reload-parameters", false, "Check at each data frame if the parametrization changed (file modified or new CCDB object) and reload it"};
+  // Running variables
+  std::string parametrizationPath = "";
+  std::filesystem::file_time_type paramFileTime{};
+  const Parameters* lastCCDBParameters = nullptr;
 
   void init(o2::framework::InitContext&)
   {
@@ -106,29 +115,42 @@ struct ALICE3pidTOFTask {
     if (!fname.empty()) { // Loading the parametrization from file
       LOG(info) << "Loading parametrization from file" << fname << ", using param: " << sigmaname;
       resoParameters.LoadParamFromFile(fname.data(), sigmaname.value.data());
+      paramFileTime = std::filesystem::last_write_time(fname);
     } else { // Loading it from CCDB
-      const std::string path = "Analysis/ALICE3/PID/TOF/Parameters";
-      resoParameters.SetParameters(ccdb->getForTimeStamp<Parameters>(path + "/" + sigmaname.value, timestamp.value));
+      parametrizationPath = "Analysis/ALICE3/PID/TOF/Parameters/" + sigmaname.value;
+      lastCCDBParameters = ccdb->getForTimeStamp<Parameters>(parametrizationPath, timestamp.value);
+      resoParameters.SetParameters(lastCCDBParameters);
     }
   }
 
-  template <o2::track::PID::ID id>
-  float sigma(Trks::iterator track)
-  {
-    return o2::pid::tof::TOFResoALICE3ParamTrack<id>(track, resoParameters);
-  }
-  template <o2::track::PID::ID id>
-  float nsigma(Trks::iterator track)
+  /// Loads the parametrization again if the file was modified or if the CCDB object changed, e.g. between the configurations of a detector scan
+  void updateParameters()
   {
-    if (!track.hasTOF()) {
-      return -999.f;
+    const std::string fname = paramfile.value;
+    if (!fname.empty()) {
+      const auto fileTime = std::filesystem::last_write_time(fname);
+      if (fileTime == paramFileTime) {
+        return;
+      }
+      LOG(info) << "Parametrization file " << fname << " modified, loading it again";
+      resoParameters.LoadParamFromFile(fname.data(), sigmaname.value.data());
+      paramFileTime = fileTime;
+      return;
+    }
+    const Parameters* ccdbParameters = ccdb->getForTimeStamp<Parameters>(parametrizationPath, timestamp.value);
+    if (ccdbParameters == lastCCDBParameters) { // Same cached object
+      return;
     }
-    return ((track.trackTime() - track.collision().collisionTime()) * 1000.f - tof::ExpTimes<Trks::iterator, id>::ComputeExpectedTime(track.tofExpMom() / o2::pid::tof::kCSPEED,
-                                                                                                                                      track.length())) /
-           sigma<id>(track);
+    LOG(info) << "New parametrization object on CCDB for path " << parametrizationPath << ", using it";
+    resoParameters.SetParameters(ccdbParameters);
+    lastCCDBParameters = ccdbParameters;
   }
+
   void process(Trks const& tracks, Coll const&)
   {
+    if (reloadParameters) {
+      updateParameters();
+    }
     tablePIDEl.reserve(tracks.size());
     tablePIDMu.reserve(tracks.size());
     tablePIDPi.reserve(tracks.size());
@@ -138,16 +160,19 @@ struct ALICE3pidTOFTask {
     tablePIDTr.reserve(tracks.size());
     tablePIDHe.reserve(tracks.size());
     tablePIDAl.reserve(tracks.size());
+    std::array<float, PID::NIDs> expSigma;
+    std::array<float, PID::NIDs> nSigma;
     for (auto const& trk : tracks) {
-      tablePIDEl(sigma<PID::Electron>(trk), nsigma<PID::Electron>(trk));
-      tablePIDMu(sigma<PID::Muon>(trk), nsigma<PID::Muon>(trk));
-      tablePIDPi(sigma<PID::Pion>(trk), nsigma<PID::Pion>(trk));
-      tablePIDKa(sigma<PID::Kaon>(trk), nsigma<PID::Kaon>(trk));
-      tablePIDPr(sigma<PID::Proton>(trk), nsigma<PID::Proton>(trk));
-      tablePIDDe(sigma<PID::Deuteron>(trk), nsigma<PID::Deuteron>(trk));
-      tablePIDTr(sigma<PID::Triton>(trk), nsigma<PID::Triton>(trk));
-      tablePIDHe(sigma<PID::Helium3>(trk), nsigma<PID::Helium3>(trk));
-      tablePIDAl(sigma<PID::Alpha>(trk), nsigma<PID::Alpha>(trk));
+      o2::pid::tof::TOFResoALICE3ParamTrackAllSpecies(trk, resoParameters, expSigma, nSigma);
+      tablePIDEl(expSigma[PID::Electron], nSigma[PID::Electron]);
+      tablePIDMu(expSigma[PID::Muon], nSigma[PID::Muon]);
+      tablePIDPi(expSigma[PID::Pion], nSigma[PID::Pion]);
+      tablePIDKa(expSigma[PID::Kaon], nSigma[PID::Kaon]);
+      tablePIDPr(expSigma[PID::Proton], nSigma[PID::Proton]);
+      tablePIDDe(expSigma[PID::Deuteron], nSigma[PID::Deuteron]);
+      tablePIDTr(expSigma[PID::Triton], nSigma[PID::Triton]);
+      tablePIDHe(expSigma[PID::Helium3], nSigma[PID::Helium3]);
+      tablePIDAl(expSigma[PID::Alpha], nSigma[PID::Alpha]);
     }
   }
 };
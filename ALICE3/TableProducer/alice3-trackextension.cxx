@@ -13,6 +13,9 @@
 // Task performing basic track selection for the ALICE3.
 //
 
+#include <array>
+#include <vector>
+
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/AnalysisTask.h"
 #include "Framework/runDataProcessing.h"
@@ -27,13 +30,24 @@ struct TrackExtensionTask {
   Configurable<float> magField{"magField", 5.f, "Magnetic field for the propagation to the primary vertex in kG"};
   Produces<aod::TracksDCA> extendedTrackQuantities;
 
+  TrackParBatch batch;
+  std::vector<float> dcaXY;
+  std::vector<float> dcaZ;
+
   void process(aod::Tracks const& tracks, aod::Collisions const&)
   {
-    std::array<float, 2> dca{1e10f, 1e10f};
+    // all the tracks of the data frame are propagated in one pass over the batch columns
+    batch.clear();
+    batch.reserve(tracks.size());
     for (auto& track : tracks) {
-      auto trackPar = getTrackPar(track);
-      trackPar.propagateParamToDCA({track.collision().posX(), track.collision().posY(), track.collision().posZ()}, magField, &dca);
-      extendedTrackQuantities(dca[0], dca[1]);
+      auto collision = track.collision();
+      batch.push_back(track, std::array<float, 3>{collision.posX(), collision.posY(), collision.posZ()});
+    }
+    dcaXY.resize(batch.size());
+    dcaZ.resize(batch.size());
+    propagateToDCABatch(batch, magField, dcaXY.data(), dcaZ.data());
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      extendedTrackQuantities(dcaXY[i], dcaZ[i]);
     }
   }
 };
@@ -16,9 +16,13 @@
 /// \brief  Task to use the ALICE3 ECAL table
 ///
 
+#include <cmath>
+#include <vector>
+
 // O2 includes
 #include "Framework/AnalysisTask.h"
 #include "ALICE3/DataModel/ECAL.h"
+#include "ALICE3/Core/EtaPhiGrid.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "ReconstructionDataFormats/PID.h"
 #include "Framework/HistogramRegistry.h"
@@ -97,9 +101,85 @@ struct ecalQaMc {
   }
 };
 
+struct ecalTrackMatchingQa { // Association of the tracks with the ECAL clusters, through a grid of the clusters in (eta, phi)
+  Configurable<float> maxDeltaEta{"maxDeltaEta", 0.05f, "Maximum eta difference between a track and its cluster"};
+  Configurable<float> maxDeltaPhi{"maxDeltaPhi", 0.1f, "Maximum phi difference between a track and its cluster"};
+  Configurable<float> gridEtaMin{"gridEtaMin", -4.f, "Lower edge in eta of the cluster grid"};
+  Configurable<float> gridEtaMax{"gridEtaMax", 4.f, "Upper edge in eta of the cluster grid"};
+  Configurable<int> gridNEta{"gridNEta", 80, "Number of eta cells of the cluster grid"};
+  Configurable<int> gridNPhi{"gridNPhi", 64, "Number of phi cells of the cluster grid"};
+
+  HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::QAObject};
+  o2::analysis::alice3::EtaPhiGrid grid;
+  std::vector<float> clusterEtas;
+  std::vector<float> clusterPhis;
+  std::vector<float> clusterEnergies;
+  std::vector<int> clusterParticles;
+
+  void init(o2::framework::InitContext&)
+  {
+    if (!doprocessMatching) {
+      return;
+    }
+    grid.setup(gridEtaMin, gridEtaMax, gridNEta, gridNPhi);
+    histos.add("deltaEta", ";#eta_{track} - #eta_{ECAL};Entries", HistType::kTH1F, {{100, -0.1, 0.1}});
+    histos.add("deltaPhi", ";#varphi_{track} - #varphi_{ECAL} (rad);Entries", HistType::kTH1F, {{100, -0.2, 0.2}});
+    histos.add("nCandidates", ";Clusters in the cells of the track window;Entries", HistType::kTH1F, {{100, -0.5, 99.5}});
+    histos.add("energyOverpVsp", ";#it{p} (GeV/#it{c});#it{E}/#it{p};Entries", HistType::kTH2F, {{100, 0, 100}, {100, 0, 2}});
+    histos.add("energyOverpVspSameParticle", ";#it{p} (GeV/#it{c});#it{E}/#it{p};Entries", HistType::kTH2F, {{100, 0, 100}, {100, 0, 2}});
+  }
+
+  using TrksMC = soa::Join<aod::Tracks, aod::McTrackLabels>;
+  void processMatching(aod::Collision const&,
+                       TrksMC const& tracks,
+                       aod::ECALs const& ecals)
+  {
+    clusterEtas.clear();
+    clusterPhis.clear();
+    clusterEnergies.clear();
+    clusterParticles.clear();
+    for (auto const& ecal : ecals) {
+      clusterEtas.push_back(std::asinh(ecal.pz() / std::hypot(ecal.px(), ecal.py())));
+      clusterPhis.push_back(ecal.posPhi());
+      clusterEnergies.push_back(ecal.e());
+      clusterParticles.push_back(ecal.mcparticleId());
+    }
+    grid.fill(clusterEtas, clusterPhis);
+
+    for (auto const& track : tracks) {
+      // closest cluster in the elliptic (eta, phi) window
+      int closest = -1;
+      int nCandidates = 0;
+      float closestDistance = 1.f;
+      grid.forEachCandidate(track.eta(), track.phi(), maxDeltaEta, maxDeltaPhi, [&](int iCluster) {
+        ++nCandidates;
+        const float dEta = (track.eta() - clusterEtas[iCluster]) / maxDeltaEta;
+        const float dPhi = o2::analysis::alice3::EtaPhiGrid::deltaPhi(track.phi(), clusterPhis[iCluster]) / maxDeltaPhi;
+        const float distance = dEta * dEta + dPhi * dPhi;
+        if (distance <= closestDistance) {
+          closestDistance = distance;
+          closest = iCluster;
+        }
+      });
+      histos.fill(HIST("nCandidates"), nCandidates);
+      if (closest < 0) {
+        continue;
+      }
+      histos.fill(HIST("deltaEta"), track.eta() - clusterEtas[closest]);
+      histos.fill(HIST("deltaPhi"), o2::analysis::alice3::EtaPhiGrid::deltaPhi(track.phi(), clusterPhis[closest]));
+      histos.fill(HIST("energyOverpVsp"), track.p(), clusterEnergies[closest] / track.p());
+      if (track.mcParticleId() == clusterParticles[closest]) {
+        histos.fill(HIST("energyOverpVspSameParticle"), track.p(), clusterEnergies[closest] / track.p());
+      }
+    }
+  }
+  PROCESS_SWITCH(ecalTrackMatchingQa, processMatching, "Associate the tracks with the ECAL clusters", false);
+};
+
 WorkflowSpec defineDataProcessing(ConfigContext const& cfg)
 {
   auto workflow = WorkflowSpec{adaptAnalysisTask<ecalIndexBuilder>(cfg)};
   workflow.push_back(adaptAnalysisTask<ecalQaMc>(cfg));
+  workflow.push_back(adaptAnalysisTask<ecalTrackMatchingQa>(cfg));
   return workflow;
 }
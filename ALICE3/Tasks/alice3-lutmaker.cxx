@@ -13,11 +13,18 @@
 /// \brief Task to extract LUTs for the fast simulation from full simulation
 /// \since 27/04/2021
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 // O2 includes
 #include "Framework/AnalysisTask.h"
 #include "ReconstructionDataFormats/Track.h"
 #include "SimulationDataFormat/MCUtils.h"
 
+// O2Physics includes
+#include "ALICE3/Core/DenseProfiles2D.h"
+
 using namespace o2;
 using namespace framework;
 using namespace framework::expressions;
@@ -62,6 +69,45 @@ struct Alice3LutMaker {
   Configurable<int> ptLog{"pt-log", 1, "Flag to use a logarithmic pT axis, in this case the pT limits are the expontents"};
 
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
+  // Moments of the covariance matrix profiles ("CovMat_*"), in the order of the getters of getCovMatValues, and of the efficiency
+  static constexpr int nCovMatElements = 30;
+  static constexpr int efficiencyIndex = nCovMatElements;
+  o2::analysis::alice3::DenseProfiles2D denseProfiles;
+
+  template <typename TrackType>
+  static std::array<float, nCovMatElements> getCovMatValues(const TrackType& track)
+  {
+    return {track.sigmaY(),
+            track.sigmaZ(),
+            track.sigmaSnp(),
+            track.sigmaTgl(),
+            track.sigma1Pt(),
+            track.rhoZY(),
+            track.rhoSnpY(),
+            track.rhoSnpZ(),
+            track.rhoTglY(),
+            track.rhoTglZ(),
+            track.rhoTglSnp(),
+            track.rho1PtY(),
+            track.rho1PtZ(),
+            track.rho1PtSnp(),
+            track.rho1PtTgl(),
+            track.cYY(),
+            track.cZY(),
+            track.cZZ(),
+            track.cSnpY(),
+            track.cSnpZ(),
+            track.cSnpSnp(),
+            track.cTglY(),
+            track.cTglZ(),
+            track.cTglSnp(),
+            track.cTglTgl(),
+            track.c1PtY(),
+            track.c1PtZ(),
+            track.c1PtSnp(),
+            track.c1PtTgl(),
+            track.c1Pt21Pt2()};
+  }
 
   void init(InitContext&)
   {
@@ -115,6 +161,37 @@ struct Alice3LutMaker {
     histos.add("CovMat_c1Pt21Pt2", "c1Pt21Pt2" + commonTitle, kTProfile2D, {axisPt, axisEta});
 
     histos.add("Efficiency", "Efficiency" + commonTitle, kTProfile2D, {axisPt, axisEta});
+    denseProfiles.setup({histos.get<TProfile2D>(HIST("CovMat_sigmaY")),
+                         histos.get<TProfile2D>(HIST("CovMat_sigmaZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_sigmaSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_sigmaTgl")),
+                         histos.get<TProfile2D>(HIST("CovMat_sigma1Pt")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoZY")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoSnpY")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoSnpZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoTglY")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoTglZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_rhoTglSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_rho1PtY")),
+                         histos.get<TProfile2D>(HIST("CovMat_rho1PtZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_rho1PtSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_rho1PtTgl")),
+                         histos.get<TProfile2D>(HIST("CovMat_cYY")),
+                         histos.get<TProfile2D>(HIST("CovMat_cZY")),
+                         histos.get<TProfile2D>(HIST("CovMat_cZZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_cSnpY")),
+                         histos.get<TProfile2D>(HIST("CovMat_cSnpZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_cSnpSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_cTglY")),
+                         histos.get<TProfile2D>(HIST("CovMat_cTglZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_cTglSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_cTglTgl")),
+                         histos.get<TProfile2D>(HIST("CovMat_c1PtY")),
+                         histos.get<TProfile2D>(HIST("CovMat_c1PtZ")),
+                         histos.get<TProfile2D>(HIST("CovMat_c1PtSnp")),
+                         histos.get<TProfile2D>(HIST("CovMat_c1PtTgl")),
+                         histos.get<TProfile2D>(HIST("CovMat_c1Pt21Pt2")),
+                         histos.get<TProfile2D>(HIST("Efficiency"))});
 
     if (!addQA) { // Only if QA histograms are enabled
       return;
@@ -207,37 +284,11 @@ struct Alice3LutMaker {
       histos.fill(HIST("pt"), mcParticle.pt());
       histos.fill(HIST("eta"), mcParticle.eta());
 
-      histos.fill(HIST("CovMat_sigmaY"), mcParticle.pt(), mcParticle.eta(), track.sigmaY());
-      histos.fill(HIST("CovMat_sigmaZ"), mcParticle.pt(), mcParticle.eta(), track.sigmaZ());
-      histos.fill(HIST("CovMat_sigmaSnp"), mcParticle.pt(), mcParticle.eta(), track.sigmaSnp());
-      histos.fill(HIST("CovMat_sigmaTgl"), mcParticle.pt(), mcParticle.eta(), track.sigmaTgl());
-      histos.fill(HIST("CovMat_sigma1Pt"), mcParticle.pt(), mcParticle.eta(), track.sigma1Pt());
-      histos.fill(HIST("CovMat_rhoZY"), mcParticle.pt(), mcParticle.eta(), track.rhoZY());
-      histos.fill(HIST("CovMat_rhoSnpY"), mcParticle.pt(), mcParticle.eta(), track.rhoSnpY());
-      histos.fill(HIST("CovMat_rhoSnpZ"), mcParticle.pt(), mcParticle.eta(), track.rhoSnpZ());
-      histos.fill(HIST("CovMat_rhoTglY"), mcParticle.pt(), mcParticle.eta(), track.rhoTglY());
-      histos.fill(HIST("CovMat_rhoTglZ"), mcParticle.pt(), mcParticle.eta(), track.rhoTglZ());
-      histos.fill(HIST("CovMat_rhoTglSnp"), mcParticle.pt(), mcParticle.eta(), track.rhoTglSnp());
-      histos.fill(HIST("CovMat_rho1PtY"), mcParticle.pt(), mcParticle.eta(), track.rho1PtY());
-      histos.fill(HIST("CovMat_rho1PtZ"), mcParticle.pt(), mcParticle.eta(), track.rho1PtZ());
-      histos.fill(HIST("CovMat_rho1PtSnp"), mcParticle.pt(), mcParticle.eta(), track.rho1PtSnp());
-      histos.fill(HIST("CovMat_rho1PtTgl"), mcParticle.pt(), mcParticle.eta(), track.rho1PtTgl());
-
-      histos.fill(HIST("CovMat_cYY"), mcParticle.pt(), mcParticle.eta(), track.cYY());
-      histos.fill(HIST("CovMat_cZY"), mcParticle.pt(), mcParticle.eta(), track.cZY());
-      histos.fill(HIST("CovMat_cZZ"), mcParticle.pt(), mcParticle.eta(), track.cZZ());
-      histos.fill(HIST("CovMat_cSnpY"), mcParticle.pt(), mcParticle.eta(), track.cSnpY());
-      histos.fill(HIST("CovMat_cSnpZ"), mcParticle.pt(), mcParticle.eta(), track.cSnpZ());
-      histos.fill(HIST("CovMat_cSnpSnp"), mcParticle.pt(), mcParticle.eta(), track.cSnpSnp());
-      histos.fill(HIST("CovMat_cTglY"), mcParticle.pt(), mcParticle.eta(), track.cTglY());
-      histos.fill(HIST("CovMat_cTglZ"), mcParticle.pt(), mcParticle.eta(), track.cTglZ());
-      histos.fill(HIST("CovMat_cTglSnp"), mcParticle.pt(), mcParticle.eta(), track.cTglSnp());
-      histos.fill(HIST("CovMat_cTglTgl"), mcParticle.pt(), mcParticle.eta(), track.cTglTgl());
-      histos.fill(HIST("CovMat_c1PtY"), mcParticle.pt(), mcParticle.eta(), track.c1PtY());
-      histos.fill(HIST("CovMat_c1PtZ"), mcParticle.pt(), mcParticle.eta(), track.c1PtZ());
-      histos.fill(HIST("CovMat_c1PtSnp"), mcParticle.pt(), mcParticle.eta(), track.c1PtSnp());
-      histos.fill(HIST("CovMat_c1PtTgl"), mcParticle.pt(), mcParticle.eta(), track.c1PtTgl());
-      histos.fill(HIST("CovMat_c1Pt21Pt2"), mcParticle.pt(), mcParticle.eta(), track.c1Pt21Pt2());
+      const int cell = denseProfiles.findCell(mcParticle.pt(), mcParticle.eta());
+      const auto covMatValues = getCovMatValues(track);
+      for (int i = 0; i < nCovMatElements; i++) {
+        denseProfiles.fill(cell, i, covMatValues[i]);
+      }
 
       if (!addQA) { // Only if QA histograms are enabled
         continue;
@@ -276,6 +327,8 @@ struct Alice3LutMaker {
       histos.fill(HIST("QA/CovMat_c1Pt21Pt2"), mcParticle.pt(), mcParticle.eta(), track.c1Pt21Pt2());
     }
     histos.fill(HIST("multiplicity"), ntrks);
+    recoTracks.resize(ntrks);
+    std::sort(recoTracks.begin(), recoTracks.end());
 
     for (const auto& mcParticle : mcParticles) {
       if (mcParticle.pdgCode() != pdg) {
@@ -285,12 +338,10 @@ struct Alice3LutMaker {
         continue;
       }
 
-      if (std::find(recoTracks.begin(), recoTracks.end(), mcParticle.globalIndex()) != recoTracks.end()) {
-        histos.fill(HIST("Efficiency"), mcParticle.pt(), mcParticle.eta(), 1.);
-      } else {
-        histos.fill(HIST("Efficiency"), mcParticle.pt(), mcParticle.eta(), 0.);
-      }
+      const bool isReconstructed = std::binary_search(recoTracks.begin(), recoTracks.end(), mcParticle.globalIndex());
+      denseProfiles.fill(denseProfiles.findCell(mcParticle.pt(), mcParticle.eta()), efficiencyIndex, isReconstructed ? 1. : 0.);
     }
+    denseProfiles.flush();
   }
 };
 
@@ -47,3 +47,19 @@ void TriggerAliases::AddClassIdToAlias(uint32_t aliasId, int classId)
     mAliasToTriggerMaskNext50[aliasId] |= 1ull << (classId - 50);
   }
 }
+
+void TriggerAliasMasks::Build(const TriggerAliases& aliases)
+{
+  mMasks.fill(0);
+  mMasksNext50.fill(0);
+  for (auto& al : aliases.GetAliasToTriggerMaskMap()) {
+    if (al.first < kNaliases) {
+      mMasks[al.first] |= al.second;
+    }
+  }
+  for (auto& al : aliases.GetAliasToTriggerMaskNext50Map()) {
+    if (al.first < kNaliases) {
+      mMasksNext50[al.first] |= al.second;
+    }
+  }
+}
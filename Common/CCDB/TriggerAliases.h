@@ -12,6 +12,7 @@
 #ifndef TriggerAliases_H
 #define TriggerAliases_H
 
+#include <array>
 #include <cstdint>
 #include <map>
 #include <string>
@@ -66,4 +67,27 @@ class TriggerAliases
   ClassDefNV(TriggerAliases, 5)
 };
 
+/// Trigger class masks of all the aliases in flat arrays, built once per TriggerAliases object,
+/// from which the fired aliases of a bc are evaluated together without any map lookup
+class TriggerAliasMasks
+{
+ public:
+  void Build(const TriggerAliases& aliases);
+
+  /// \return bitmask of the aliases with a fired class in the masks of the first and next 50 classes
+  uint32_t GetFiredAliases(uint64_t triggerMask, uint64_t triggerMaskNext50) const
+  {
+    uint32_t fired = 0;
+    for (int i = 0; i < kNaliases; i++) {
+      fired |= static_cast<uint32_t>(((triggerMask & mMasks[i]) | (triggerMaskNext50 & mMasksNext50[i])) != 0) << i;
+    }
+    return fired;
+  }
+
+ private:
+  static_assert(kNaliases <= 32, "fired aliases are stored in a 32-bit mask");
+  std::array<uint64_t, kNaliases> mMasks{};       ///< classes 0-49 of each alias
+  std::array<uint64_t, kNaliases> mMasksNext50{}; ///< classes 50-99 of each alias
+};
+
 #endif
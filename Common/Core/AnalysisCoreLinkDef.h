@@ -24,3 +24,4 @@
 #pragma link C++ class o2::pid::tof::TOFReso + ;
 #pragma link C++ class o2::pid::tof::TOFResoParams + ;
 #pragma link C++ class OrbitRange + ;
+#pragma link C++ class BCRangeIndex + ;
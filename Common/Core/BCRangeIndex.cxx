@@ -0,0 +1,132 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+//
+// Sorted index of disjoint global BC ranges
+//
+
+#include "Common/Core/BCRangeIndex.h"
+#include <algorithm>
+#include <numeric>
+#include "CommonConstants/LHCConstants.h"
+#include "TCollection.h"
+
+ClassImp(BCRangeIndex)
+
+  void BCRangeIndex::AddRange(uint64_t firstBC, uint64_t lastBC)
+{
+  if (lastBC < firstBC) {
+    std::swap(firstBC, lastBC);
+  }
+  // ranges added in increasing order, e.g. data frame by data frame, keep the index compacted
+  if (fCompacted && !fFirstBCs.empty()) {
+    if (firstBC <= fLastBCs.back() + 1 && firstBC >= fFirstBCs.back()) {
+      fLastBCs.back() = std::max(fLastBCs.back(), lastBC);
+      return;
+    }
+    fCompacted = firstBC > fLastBCs.back();
+  }
+  fFirstBCs.push_back(firstBC);
+  fLastBCs.push_back(lastBC);
+}
+
+void BCRangeIndex::Compact()
+{
+  if (fCompacted) {
+    return;
+  }
+  std::vector<size_t> order(fFirstBCs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return fFirstBCs[a] < fFirstBCs[b]; });
+
+  std::vector<uint64_t> firstBCs;
+  std::vector<uint64_t> lastBCs;
+  for (auto i : order) {
+    if (!firstBCs.empty() && fFirstBCs[i] <= lastBCs.back() + 1) {
+      lastBCs.back() = std::max(lastBCs.back(), fLastBCs[i]);
+    } else {
+      firstBCs.push_back(fFirstBCs[i]);
+      lastBCs.push_back(fLastBCs[i]);
+    }
+  }
+  fFirstBCs.swap(firstBCs);
+  fLastBCs.swap(lastBCs);
+  fCompacted = true;
+}
+
+bool BCRangeIndex::Contains(uint64_t bc) const
+{
+  return Overlaps(bc, bc);
+}
+
+bool BCRangeIndex::Overlaps(uint64_t firstBC, uint64_t lastBC) const
+{
+  if (!fCompacted) {
+    printf("Warning: BC range index queried before Compact()\n");
+  }
+  // last range starting before the end of the block
+  auto next = std::upper_bound(fFirstBCs.begin(), fFirstBCs.end(), lastBC);
+  if (next == fFirstBCs.begin()) {
+    return false;
+  }
+  return fLastBCs[next - fFirstBCs.begin() - 1] >= firstBC;
+}
+
+bool BCRangeIndex::OverlapsOrbits(uint32_t firstOrbit, uint32_t lastOrbit) const
+{
+  return Overlaps(uint64_t(firstOrbit) * o2::constants::lhc::LHCMaxBunches, (uint64_t(lastOrbit) + 1) * o2::constants::lhc::LHCMaxBunches - 1);
+}
+
+uint64_t BCRangeIndex::GetNBCs() const
+{
+  uint64_t nBCs = 0;
+  for (size_t i = 0; i < fFirstBCs.size(); i++) {
+    nBCs += fLastBCs[i] - fFirstBCs[i] + 1;
+  }
+  return nBCs;
+}
+
+Long64_t BCRangeIndex::Merge(TCollection* list)
+{
+  // Merge a list of BCRangeIndex objects
+  // Stores the union of the ranges of all merged indices
+  // Returns the number of merged objects (including this).
+
+  if (!list) {
+    return 0;
+  }
+
+  if (list->IsEmpty()) {
+    return 1;
+  }
+
+  Long64_t count = 0;
+  TIterator* iter = list->MakeIterator();
+  TObject* obj = nullptr;
+  while ((obj = iter->Next())) {
+    BCRangeIndex* entry = dynamic_cast<BCRangeIndex*>(obj);
+    if (entry == nullptr) {
+      continue;
+    }
+    if (fRunNumber != entry->GetRunNumber()) {
+      printf("Warning: merging of BC range indices for different runs is forbidden\n");
+      continue;
+    }
+    for (size_t i = 0; i < entry->GetNRanges(); i++) {
+      AddRange(entry->GetFirstBC(i), entry->GetLastBC(i));
+    }
+    count++;
+  }
+  delete iter;
+  Compact();
+
+  return count + 1;
+}
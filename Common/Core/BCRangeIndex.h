@@ -0,0 +1,57 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+//
+// Sorted index of disjoint global BC ranges, e.g. the BCs of the selected events of a skim.
+// Stored next to the AO2D, it tells with a binary search whether a data frame
+// or a block of BCs contains any selected BC, so it can be skipped without reading its tables.
+//
+
+#ifndef BCRangeIndex_H
+#define BCRangeIndex_H
+
+#include <vector>
+#include "TNamed.h"
+class TCollection;
+
+class BCRangeIndex : public TNamed
+{
+ public:
+  BCRangeIndex(const char* name = "bcRangeIndex") : TNamed(name, name), fRunNumber(0), fFirstBCs(), fLastBCs(), fCompacted(true) {}
+  ~BCRangeIndex() {}
+  void SetRunNumber(uint32_t runNumber) { fRunNumber = runNumber; }
+  uint32_t GetRunNumber() const { return fRunNumber; }
+
+  // Adds the range [firstBC, lastBC] of global BCs, Compact() must be called before any query
+  void AddRange(uint64_t firstBC, uint64_t lastBC);
+  // Sorts the ranges and merges the overlapping and adjacent ones
+  void Compact();
+
+  // Queries, by binary search on the compacted ranges
+  bool Contains(uint64_t bc) const;
+  bool Overlaps(uint64_t firstBC, uint64_t lastBC) const;
+  bool OverlapsOrbits(uint32_t firstOrbit, uint32_t lastOrbit) const;
+
+  size_t GetNRanges() const { return fFirstBCs.size(); }
+  uint64_t GetFirstBC(size_t i) const { return fFirstBCs[i]; }
+  uint64_t GetLastBC(size_t i) const { return fLastBCs[i]; }
+  uint64_t GetNBCs() const;
+  Long64_t Merge(TCollection* list);
+
+ private:
+  uint32_t fRunNumber;
+  std::vector<uint64_t> fFirstBCs; // first BC of each range, sorted
+  std::vector<uint64_t> fLastBCs;  // last BC of each range, included
+  bool fCompacted;                 //! ranges sorted and disjoint
+  ClassDef(BCRangeIndex, 1)
+};
+
+#endif
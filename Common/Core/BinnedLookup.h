@@ -0,0 +1,88 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file BinnedLookup.h
+/// \brief Flat copy of the bin contents of a 1D histogram for fast per-event lookups
+///
+/// The histogram is compiled once, e.g. when a new calibration is loaded, into contiguous arrays.
+/// The lookup follows TH1::GetBinContent(TH1::FindFixBin(x)) exactly, underflow and overflow included,
+/// without the virtual calls and the TArray indirections of the histogram.
+
+#ifndef O2PHYSICS_COMMON_CORE_BINNEDLOOKUP_H_
+#define O2PHYSICS_COMMON_CORE_BINNEDLOOKUP_H_
+
+#include <algorithm>
+#include <vector>
+
+#include <TH1.h>
+
+namespace o2::analysis
+{
+
+/// Bin contents of a 1D histogram indexed by the value of the x axis
+class BinnedLookup
+{
+ public:
+  /// Copies the binning and the bin contents of a histogram
+  /// \param histogram  source histogram, not needed after the call
+  void compile(const TH1* histogram)
+  {
+    const TAxis* axis = histogram->GetXaxis();
+    mNBins = axis->GetNbins();
+    mXMin = axis->GetXmin();
+    mXMax = axis->GetXmax();
+    mUniform = axis->GetXbins()->GetSize() == 0;
+    mEdges.clear();
+    if (!mUniform) {
+      mEdges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + mNBins + 1);
+    }
+    mContents.resize(mNBins + 2);
+    for (int bin = 0; bin <= mNBins + 1; ++bin) {
+      mContents[bin] = histogram->GetBinContent(bin);
+    }
+  }
+
+  /// \return true if a histogram has been compiled
+  bool isCompiled() const { return !mContents.empty(); }
+
+  /// Bin of a value, with the conventions of TAxis::FindFixBin
+  /// \param x  value on the x axis
+  /// \return 0 for underflow, nbins + 1 for overflow
+  int findBin(double x) const
+  {
+    if (x < mXMin) {
+      return 0;
+    }
+    if (!(x < mXMax)) {
+      return mNBins + 1;
+    }
+    if (mUniform) {
+      return std::min(1 + static_cast<int>(mNBins * (x - mXMin) / (mXMax - mXMin)), mNBins);
+    }
+    return static_cast<int>(std::upper_bound(mEdges.begin(), mEdges.end(), x) - mEdges.begin());
+  }
+
+  /// Content of the bin of a value
+  /// \param x  value on the x axis
+  double eval(double x) const { return mContents[findBin(x)]; }
+
+ private:
+  int mNBins = 0;                ///< number of bins
+  double mXMin = 0.;             ///< low edge of the first bin
+  double mXMax = 0.;             ///< high edge of the last bin
+  bool mUniform = true;          ///< equidistant bins, indexed without search
+  std::vector<double> mEdges;    ///< bin edges, only for variable binning
+  std::vector<double> mContents; ///< bin contents, underflow and overflow included
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_BINNEDLOOKUP_H_
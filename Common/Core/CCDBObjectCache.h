@@ -0,0 +1,177 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file CCDBObjectCache.h
+/// \brief In-memory cache of the CCDB objects of one path, keyed by their validity interval
+///
+/// All the objects valid during a run are fetched the first time the run is seen, so that the
+/// lookups by timestamp in the processing loop are answered from memory without any CCDB access.
+
+#ifndef O2PHYSICS_COMMON_CORE_CCDBOBJECTCACHE_H_
+#define O2PHYSICS_COMMON_CORE_CCDBOBJECTCACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "CCDB/CcdbApi.h"
+#include "Framework/Logger.h"
+#include "Common/Core/ProcessCounters.h"
+
+namespace o2::analysis
+{
+
+/// Objects of one CCDB path kept in memory for the lifetime of a task
+template <typename T>
+class CCDBObjectCache
+{
+ public:
+  /// Configures the cache, to be called once, e.g. in init()
+  /// \param url  CCDB URL
+  /// \param path  path of the objects
+  /// \param rctPath  path of the RCT objects with the SOR/EOR timestamps of the runs
+  /// \param createdNotAfter  objects uploaded later than this timestamp (ms) are ignored, 0: no limit
+  void init(const std::string& url, const std::string& path, const std::string& rctPath = "RCT/Info/RunInformation", int64_t createdNotAfter = 0)
+  {
+    mApi.init(url);
+    mPath = path;
+    mRCTPath = rctPath;
+    mCreatedNotAfter = createdNotAfter > 0 ? std::to_string(createdNotAfter) : "";
+  }
+
+  /// Gets the object valid at a timestamp, all the objects of the run are fetched the first time the run is seen
+  /// \param runNumber  run of the timestamp
+  /// \param timestamp  timestamp (ms)
+  /// \return object owned by the cache
+  const T* getForRun(int runNumber, int64_t timestamp)
+  {
+    if (mPrefetchedRuns.count(runNumber) == 0) {
+      prefetchRun(runNumber);
+    }
+    return get(timestamp);
+  }
+
+  /// Gets the object valid at a timestamp, fetching it if it is not in memory
+  /// \param timestamp  timestamp (ms)
+  /// \return object owned by the cache
+  const T* get(int64_t timestamp)
+  {
+    if (mLastEntry != nullptr && mLastEntry->contains(timestamp)) {
+      return mLastEntry->object.get();
+    }
+    mLastEntry = find(timestamp);
+    if (mLastEntry == nullptr) {
+      mLastEntry = fetch(timestamp);
+    }
+    if (mLastEntry == nullptr) {
+      LOGF(fatal, "Cannot find CCDB object in path '%s' for timestamp %lld", mPath.data(), static_cast<long long>(timestamp));
+    }
+    return mLastEntry->object.get();
+  }
+
+  /// Fetches all the objects valid between the SOR and the EOR of a run
+  /// \param runNumber  run of interest
+  void prefetchRun(int runNumber)
+  {
+    mPrefetchedRuns.insert(runNumber);
+    std::map<std::string, std::string> metadata;
+    auto headers = mApi.retrieveHeaders(mRCTPath + "/" + std::to_string(runNumber), metadata, -1);
+    if (headers.count("SOR") == 0 || headers.count("EOR") == 0) {
+      LOGF(warning, "Cannot find SOR/EOR of run %i in path '%s', objects in path '%s' are fetched on demand", runNumber, mRCTPath.data(), mPath.data());
+      return;
+    }
+    const int64_t sor = std::atoll(headers["SOR"].c_str());
+    const int64_t eor = std::atoll(headers["EOR"].c_str());
+    int nFetched = 0;
+    for (int64_t timestamp = sor; timestamp < eor;) {
+      const Entry* entry = find(timestamp);
+      if (entry == nullptr) {
+        entry = fetch(timestamp);
+        if (entry == nullptr) {
+          break;
+        }
+        nFetched++;
+      }
+      if (entry->validUntil <= timestamp) {
+        break;
+      }
+      timestamp = entry->validUntil;
+    }
+    LOGF(info, "Prefetched %i objects in path '%s' for run %i (%lld -> %lld)", nFetched, mPath.data(), runNumber, static_cast<long long>(sor), static_cast<long long>(eor));
+  }
+
+  /// Number of objects in memory
+  size_t size() const { return mEntries.size(); }
+
+ private:
+  /// Object with its validity interval [validFrom, validUntil)
+  struct Entry {
+    int64_t validFrom = 0;
+    int64_t validUntil = 0;
+    std::unique_ptr<T> object = nullptr;
+    bool contains(int64_t timestamp) const { return timestamp >= validFrom && timestamp < validUntil; }
+  };
+
+  /// Finds the object valid at a timestamp among the ones in memory
+  const Entry* find(int64_t timestamp) const
+  {
+    // Entries are sorted by start of validity: the candidate is the last one starting before the timestamp
+    auto next = mEntries.upper_bound(timestamp);
+    if (next == mEntries.begin()) {
+      return nullptr;
+    }
+    const Entry& entry = std::prev(next)->second;
+    return entry.contains(timestamp) ? &entry : nullptr;
+  }
+
+  /// Fetches from CCDB the object valid at a timestamp
+  const Entry* fetch(int64_t timestamp)
+  {
+    std::map<std::string, std::string> metadata, headers;
+    const auto start = std::chrono::steady_clock::now();
+    T* object = mApi.retrieveFromTFileAny<T>(mPath, metadata, timestamp, &headers, "", mCreatedNotAfter);
+    auto& counters = processCounters();
+    counters.ccdbFetches++;
+    counters.ccdbTime += elapsedMilliseconds(start);
+    if (object == nullptr) {
+      return nullptr;
+    }
+    if (headers.count("Valid-From") == 0 || headers.count("Valid-Until") == 0) {
+      LOGF(fatal, "Validity of CCDB object in path '%s' not found in metadata", mPath.data());
+    }
+    Entry entry;
+    entry.validFrom = std::atoll(headers["Valid-From"].c_str());
+    entry.validUntil = std::atoll(headers["Valid-Until"].c_str());
+    entry.object.reset(object);
+    LOGF(debug, "Fetched CCDB object in path '%s' valid for %lld -> %lld", mPath.data(), static_cast<long long>(entry.validFrom), static_cast<long long>(entry.validUntil));
+    const int64_t validFrom = entry.validFrom;
+    auto inserted = mEntries.insert_or_assign(validFrom, std::move(entry));
+    return &inserted.first->second;
+  }
+
+  o2::ccdb::CcdbApi mApi;            ///< API to access CCDB
+  std::string mPath = "";            ///< path of the objects
+  std::string mRCTPath = "";         ///< path of the RCT objects with the SOR/EOR timestamps
+  std::string mCreatedNotAfter = ""; ///< upload time limit of the objects, empty: no limit
+  std::map<int64_t, Entry> mEntries; ///< objects sorted by start of validity
+  std::set<int> mPrefetchedRuns;     ///< runs whose objects were already fetched
+  const Entry* mLastEntry = nullptr; ///< entry of the last lookup, consecutive lookups usually fall into it
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_CCDBOBJECTCACHE_H_
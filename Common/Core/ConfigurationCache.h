@@ -0,0 +1,131 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ConfigurationCache.h
+/// \brief On-disk cache of the objects that a task builds in init from its configuration (e.g. cuts parsed from strings)
+///
+/// Each object is stored in its own ROOT file of the cache directory, named after the 64-bit FNV-1a hash of the
+/// configuration string. The configuration string is stored next to the object and compared when reading, so that
+/// a hash collision gives a miss. The string must contain everything the object depends on, including the version of
+/// the code building it. The files are written under a temporary name and renamed, so that concurrent jobs sharing
+/// the directory never read a partial file.
+
+#ifndef O2PHYSICS_COMMON_CORE_CONFIGURATIONCACHE_H_
+#define O2PHYSICS_COMMON_CORE_CONFIGURATIONCACHE_H_
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <TFile.h>
+#include <TObjString.h>
+#include <TSystem.h>
+
+#include "Framework/Logger.h"
+
+namespace o2::analysis
+{
+
+/// \return 64-bit FNV-1a hash of a string, the same in every process
+inline std::uint64_t configurationHash(std::string_view configuration)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : configuration) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+class ConfigurationCache
+{
+ public:
+  /// \param directory  directory of the cache, created if needed; empty: cache disabled
+  void setDirectory(std::string const& directory)
+  {
+    mDirectory = directory;
+    if (!mDirectory.empty()) {
+      gSystem->mkdir(mDirectory.c_str(), true);
+    }
+  }
+
+  bool isEnabled() const { return !mDirectory.empty(); }
+
+  /// \return file of the objects of a configuration
+  std::string path(std::string const& configuration) const
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.root", static_cast<unsigned long long>(configurationHash(configuration)));
+    return mDirectory + "/" + name;
+  }
+
+  /// \return object stored for the configuration, null if the cache is disabled or does not hold it
+  template <typename T>
+  std::unique_ptr<T> load(std::string const& configuration) const
+  {
+    if (!isEnabled()) {
+      return nullptr;
+    }
+    const std::string file = path(configuration);
+    if (gSystem->AccessPathName(file.c_str())) { // true if the file does not exist
+      return nullptr;
+    }
+    std::unique_ptr<TFile> input(TFile::Open(file.c_str(), "READ"));
+    if (!input || input->IsZombie()) {
+      return nullptr;
+    }
+    std::unique_ptr<TObjString> stored(input->Get<TObjString>("configuration"));
+    if (!stored || stored->GetString() != configuration.c_str()) {
+      return nullptr;
+    }
+    std::unique_ptr<T> object(input->Get<T>("object"));
+    if (object) {
+      LOGF(info, "Read the objects of the configuration from %s", file);
+    }
+    return object;
+  }
+
+  /// Stores the object built for the configuration, nothing if the cache is disabled
+  void store(std::string const& configuration, TObject const& object) const
+  {
+    if (!isEnabled()) {
+      return;
+    }
+    const std::string file = path(configuration);
+    const std::string temporary = file + "." + std::to_string(getpid()) + ".tmp";
+    {
+      std::unique_ptr<TFile> output(TFile::Open(temporary.c_str(), "RECREATE"));
+      if (!output || output->IsZombie()) {
+        LOGF(warning, "Could not write the configuration cache file %s", temporary);
+        return;
+      }
+      TObjString stored(configuration.c_str());
+      output->WriteTObject(&stored, "configuration");
+      output->WriteTObject(&object, "object");
+      output->Close();
+    }
+    if (std::rename(temporary.c_str(), file.c_str()) != 0) {
+      LOGF(warning, "Could not move the configuration cache file to %s", file);
+      std::remove(temporary.c_str());
+    }
+  }
+
+ private:
+  std::string mDirectory{};
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_CONFIGURATIONCACHE_H_
@@ -0,0 +1,156 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file CpuDispatch.h
+/// \brief Runtime selection of the instruction set of the vectorized kernels
+///
+/// A kernel is written once, as an inline function, and compiled for each instruction set by a wrapper carrying the
+/// O2_SIMD_TARGET_AVX2 or O2_SIMD_TARGET_AVX512 attribute, which inlines it (O2_SIMD_FLATTEN):
+///
+///   inline void scaleImpl(float* x, std::size_t n, float a) { for (std::size_t i = 0; i < n; i++) x[i] *= a; }
+///   O2_SIMD_TARGET_AVX2 O2_SIMD_FLATTEN void scaleAvx2(float* x, std::size_t n, float a) { scaleImpl(x, n, a); }
+///   O2_SIMD_TARGET_AVX512 O2_SIMD_FLATTEN void scaleAvx512(float* x, std::size_t n, float a) { scaleImpl(x, n, a); }
+///   const o2::analysis::simd::Dispatched<void (*)(float*, std::size_t, float)> scale{scaleImpl, scaleAvx2, scaleAvx512};
+///   scale(x, n, a);
+///
+/// The level is detected from the CPU at the first use. It can be lowered, e.g. to compare the results of the generic and
+/// of the vectorized builds, with the O2PHYSICS_SIMD_LEVEL environment variable (generic, avx2, avx512) or with setLevel().
+/// A level above the one supported by the CPU is never selected. Off x86-64, or with compilers without the target
+/// attribute, all the wrappers compile the generic code.
+
+#ifndef O2PHYSICS_COMMON_CORE_CPUDISPATCH_H_
+#define O2PHYSICS_COMMON_CORE_CPUDISPATCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define O2_SIMD_X86 1
+#define O2_SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define O2_SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")))
+#define O2_SIMD_FLATTEN __attribute__((flatten))
+#else
+#define O2_SIMD_X86 0
+#define O2_SIMD_TARGET_AVX2
+#define O2_SIMD_TARGET_AVX512
+#define O2_SIMD_FLATTEN
+#endif
+
+namespace o2::analysis::simd
+{
+
+enum class Level : int {
+  kGeneric = 0,
+  kAVX2 = 1,
+  kAVX512 = 2
+};
+
+inline const char* getLevelName(Level level)
+{
+  switch (level) {
+    case Level::kAVX2:
+      return "avx2";
+    case Level::kAVX512:
+      return "avx512";
+    default:
+      return "generic";
+  }
+}
+
+/// \return level of the given name (generic, avx2, avx512), or kAVX512 (no restriction) if the name is empty or unknown
+inline Level parseLevel(const std::string& name)
+{
+  if (name == "generic") {
+    return Level::kGeneric;
+  } else if (name == "avx2") {
+    return Level::kAVX2;
+  }
+  return Level::kAVX512;
+}
+
+/// \return highest level supported by the CPU
+inline Level detectLevel()
+{
+#if O2_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+    return Level::kAVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Level::kAVX2;
+  }
+#endif
+  return Level::kGeneric;
+}
+
+namespace detail
+{
+inline std::atomic<int>& currentLevel()
+{
+  static std::atomic<int> level{[]() {
+    Level selected = detectLevel();
+    if (const char* name = std::getenv("O2PHYSICS_SIMD_LEVEL")) {
+      selected = std::min(selected, parseLevel(name));
+    }
+    return static_cast<int>(selected);
+  }()};
+  return level;
+}
+} // namespace detail
+
+/// \return level used by the kernels
+inline Level getLevel()
+{
+  return static_cast<Level>(detail::currentLevel().load(std::memory_order_relaxed));
+}
+
+/// Sets the level used by the kernels, capped to the one supported by the CPU
+/// \return the level actually set
+inline Level setLevel(Level level)
+{
+  const Level selected = std::min(level, detectLevel());
+  detail::currentLevel().store(static_cast<int>(selected), std::memory_order_relaxed);
+  return selected;
+}
+inline Level setLevel(const std::string& name) { return setLevel(parseLevel(name)); }
+
+/// Implementations of a kernel for each level, the one of the current level being called
+template <typename TFunction>
+struct Dispatched {
+  TFunction generic;
+  TFunction avx2;
+  TFunction avx512;
+
+  TFunction get() const
+  {
+    switch (getLevel()) {
+      case Level::kAVX512:
+        return avx512;
+      case Level::kAVX2:
+        return avx2;
+      default:
+        return generic;
+    }
+  }
+
+  template <typename... TArgs>
+  decltype(auto) operator()(TArgs&&... args) const
+  {
+    return get()(std::forward<TArgs>(args)...);
+  }
+};
+
+} // namespace o2::analysis::simd
+
+#endif // O2PHYSICS_COMMON_CORE_CPUDISPATCH_H_
@@ -0,0 +1,83 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file DCAFitterCache.h
+/// \brief Long-lived DCAFitterN instances for the secondary-vertex builders
+///
+/// The fitters are configured once per task and their magnetic field is updated
+/// only when it changes, instead of building a new fitter for every collision.
+
+#ifndef O2PHYSICS_COMMON_CORE_DCAFITTERCACHE_H_
+#define O2PHYSICS_COMMON_CORE_DCAFITTERCACHE_H_
+
+#include "DetectorsVertexing/DCAFitterN.h"
+
+namespace o2::analysis
+{
+
+/// Settings of a DCAFitterN that do not depend on the run conditions
+struct DCAFitterSettings {
+  bool propagateToPCA = true;     ///< create tracks version propagated to PCA
+  double maxR = 200.;             ///< reject PCA's above this radius
+  double minParamChange = 1.e-3;  ///< stop iterations if largest change of any X is smaller than this
+  double minRelChi2Change = 0.9;  ///< stop iterations if chi2/chi2old > this
+  double maxDZIni = 1.e9;         ///< reject (if>0) PCA candidate if tracks DZ exceeds threshold
+  double maxChi2 = -1.;           ///< max. chi2 at PCA, the DCAFitterN default is kept if negative
+  bool useAbsDCA = true;          ///< minimise abs. distance rather than chi2
+};
+
+/// DCAFitterN kept for the lifetime of a task
+template <int N>
+class DCAFitterCache
+{
+ public:
+  /// Applies the settings that do not depend on the run conditions, to be called once, e.g. in init()
+  /// \param settings  fitter settings
+  void configure(const DCAFitterSettings& settings)
+  {
+    mFitter.setPropagateToPCA(settings.propagateToPCA);
+    mFitter.setMaxR(settings.maxR);
+    mFitter.setMinParamChange(settings.minParamChange);
+    mFitter.setMinRelChi2Change(settings.minRelChi2Change);
+    mFitter.setMaxDZIni(settings.maxDZIni);
+    if (settings.maxChi2 >= 0.) {
+      mFitter.setMaxChi2(settings.maxChi2);
+    }
+    mFitter.setUseAbsDCA(settings.useAbsDCA);
+    mIsConfigured = true;
+  }
+
+  /// Gets the fitter for a given magnetic field, which is set only if it changed since the last call
+  /// \param bz  magnetic field along z (kG)
+  /// \return configured fitter
+  o2::vertexing::DCAFitterN<N>& get(float bz)
+  {
+    if (!mIsConfigured) {
+      LOG(fatal) << "DCAFitterCache used before being configured";
+    }
+    if (!mIsBzSet || bz != mBz) {
+      mFitter.setBz(bz);
+      mBz = bz;
+      mIsBzSet = true;
+    }
+    return mFitter;
+  }
+
+ private:
+  o2::vertexing::DCAFitterN<N> mFitter; ///< fitter
+  float mBz = 0.f;                      ///< magnetic field currently set in the fitter (kG)
+  bool mIsBzSet = false;                ///< whether the magnetic field has been set
+  bool mIsConfigured = false;           ///< whether the settings have been applied
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_DCAFITTERCACHE_H_
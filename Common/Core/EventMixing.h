@@ -12,8 +12,134 @@
 #ifndef ANALYSIS_CORE_EVENTMIXING_H_
 #define ANALYSIS_CORE_EVENTMIXING_H_
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace eventmixing
 {
+
+/// Binning of the mixing variables, to be set up once and used for every collision.
+/// Each axis is given by its bin edges: uniform axes find the bin with one multiplication, the others with a binary search.
+/// The bin of a collision over all the axes is row-major, the first axis being the slowest varying one.
+class MixingBinning
+{
+ public:
+  MixingBinning() = default;
+
+  /// Adds an axis
+  /// \param edges Bin edges in increasing order, at least two
+  void addAxis(const std::vector<float>& edges)
+  {
+    Axis axis;
+    axis.edges = edges;
+    axis.nBins = edges.size() > 1 ? edges.size() - 1 : 0;
+    if (axis.nBins > 0) {
+      axis.low = edges.front();
+      axis.high = edges.back();
+      const double width = (static_cast<double>(axis.high) - axis.low) / axis.nBins;
+      axis.isUniform = width > 0.;
+      for (int i = 1; i < axis.nBins && axis.isUniform; i++) {
+        axis.isUniform = std::abs(edges[i] - (axis.low + i * width)) <= 1.e-5 * width;
+      }
+      axis.invWidth = axis.isUniform ? 1. / width : 0.;
+    }
+    mAxes.push_back(axis);
+  }
+
+  /// Number of axes
+  int getNAxes() const { return mAxes.size(); }
+
+  /// Number of bins of an axis
+  int getNBins(int axis) const { return mAxes[axis].nBins; }
+
+  /// Total number of bins over all the axes
+  int getNBins() const
+  {
+    int nBins = 1;
+    for (const auto& axis : mAxes) {
+      nBins *= axis.nBins;
+    }
+    return nBins;
+  }
+
+  /// Bin edges of an axis
+  const std::vector<float>& getEdges(int axis) const { return mAxes[axis].edges; }
+
+  /// Finds the bin of a value along one axis, bins include their lower edge only
+  /// \param axis Index of the axis
+  /// \param value Value of the variable of the axis
+  /// \return Bin, -1 if the value is outside of the axis
+  int findBin(int axis, float value) const { return mAxes[axis].findBin(value); }
+
+  /// Finds the bin over all the axes
+  /// \param values Values of the variables, one per axis
+  /// \return Bin, -1 if any value is outside of its axis
+  int getBin(const float* values) const
+  {
+    int bin = 0;
+    for (const auto& axis : mAxes) {
+      const int axisBin = axis.findBin(*values++);
+      if (axisBin < 0) {
+        return -1;
+      }
+      bin = bin * axis.nBins + axisBin;
+    }
+    return bin;
+  }
+
+  /// Finds the bin over all the axes
+  /// \param values Values of the variables, one per axis
+  /// \return Bin, -1 if any value is outside of its axis
+  template <typename... Ts>
+  int getBinOf(Ts... values) const
+  {
+    const float valueArray[] = {static_cast<float>(values)...};
+    return getBin(valueArray);
+  }
+
+  /// Extracts the bin along one axis from the bin over all the axes
+  /// \param axis Index of the axis
+  /// \param bin Bin over all the axes
+  int getAxisBin(int axis, int bin) const
+  {
+    for (int i = mAxes.size() - 1; i > axis; i--) {
+      bin /= mAxes[i].nBins;
+    }
+    return bin % mAxes[axis].nBins;
+  }
+
+ private:
+  struct Axis {
+    std::vector<float> edges;
+    int nBins = 0;
+    float low = 0.f;
+    float high = 0.f;
+    bool isUniform = false;
+    double invWidth = 0.;
+
+    int findBin(float value) const
+    {
+      if (!(value >= low && value < high)) {
+        return -1;
+      }
+      if (!isUniform) {
+        return std::upper_bound(edges.begin(), edges.end(), value) - edges.begin() - 1;
+      }
+      int bin = std::min(static_cast<int>((value - low) * invWidth), nBins - 1);
+      // the rounding can move a value close to an edge into the neighbouring bin
+      if (value < edges[bin]) {
+        bin--;
+      } else if (value >= edges[bin + 1]) {
+        bin++;
+      }
+      return bin;
+    }
+  };
+
+  std::vector<Axis> mAxes;
+};
+
 /// Calculate hash for an element based on 2 properties and their bins.
 /// \tparam T1 Data type of the configurable of the z-vertex and multiplicity bins
 /// \tparam T2 Data type of the value of the z-vertex and multiplicity
@@ -25,25 +151,33 @@ namespace eventmixing
 template <typename T1, typename T2>
 static int getMixingBin(const T1& vtxBins, const T1& multBins, const T2& vtx, const T2& mult)
 {
-  // underflow
-  if (vtx < vtxBins.at(0)) {
+  // underflow and overflow
+  if (!(vtx >= vtxBins.front() && vtx < vtxBins.back())) {
     return -1;
   }
-  if (mult < multBins.at(0)) {
+  if (!(mult >= multBins.front() && mult < multBins.back())) {
     return -1;
   }
+  // index of the first edge above the value
+  const int i = std::upper_bound(vtxBins.begin(), vtxBins.end(), vtx) - vtxBins.begin();
+  const int j = std::upper_bound(multBins.begin(), multBins.end(), mult) - multBins.begin();
+  return i + j * (vtxBins.size() + 1);
+}
 
-  for (unsigned int i = 1; i < vtxBins.size(); i++) {
-    if (vtx < vtxBins.at(i)) {
-      for (unsigned int j = 1; j < multBins.size(); j++) {
-        if (mult < multBins.at(j)) {
-          return i + j * (vtxBins.size() + 1);
-        }
-      }
-    }
+/// Calculate hash for an element based on 2 properties, same as above with a binning set up once
+/// \param binning Binning with the z-vertex and the multiplicity axes
+/// \param vtx Value of the z-vertex of the collision
+/// \param mult Multiplicity of the collision
+/// \return Hash of the event
+template <typename T>
+static int getMixingBin(const MixingBinning& binning, const T& vtx, const T& mult)
+{
+  const int i = binning.findBin(0, vtx);
+  const int j = binning.findBin(1, mult);
+  if (i < 0 || j < 0) {
+    return -1;
   }
-  // overflow
-  return -1;
+  return (i + 1) + (j + 1) * (binning.getNBins(0) + 2);
 }
 }; // namespace eventmixing
 
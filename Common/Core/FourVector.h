@@ -0,0 +1,178 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file FourVector.h
+/// \brief Lightweight float four-vector and pair kinematics, to replace TLorentzVector in the pair loops
+///
+/// FourVector holds (px, py, pz, e) in four floats, with no virtual table and no heap allocation, so that it can be
+/// created on the stack in the innermost loops. The arithmetic is constexpr; the derived quantities follow the
+/// conventions of TLorentzVector (M() is negative for space-like vectors, Rapidity() is computed from e and pz).
+/// PairKinematicsBatch computes the mass, pT and rapidity of many pairs from SoA inputs in one loop which the
+/// compiler can vectorize.
+
+#ifndef O2PHYSICS_COMMON_CORE_FOURVECTOR_H_
+#define O2PHYSICS_COMMON_CORE_FOURVECTOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace o2::analysis
+{
+
+/// Four-momentum (px, py, pz, e)
+struct FourVector {
+  float px = 0.f;
+  float py = 0.f;
+  float pz = 0.f;
+  float e = 0.f;
+
+  constexpr FourVector() = default;
+  constexpr FourVector(float x, float y, float z, float t) : px(x), py(y), pz(z), e(t) {}
+
+  /// \return four-vector of a particle of given momentum and mass
+  static FourVector fromXYZM(float x, float y, float z, float mass)
+  {
+    return {x, y, z, std::sqrt(x * x + y * y + z * z + mass * mass)};
+  }
+
+  /// \return four-vector of a particle of given transverse momentum, pseudorapidity, azimuth and mass
+  static FourVector fromPtEtaPhiM(float pt, float eta, float phi, float mass)
+  {
+    return fromXYZM(pt * std::cos(phi), pt * std::sin(phi), pt * std::sinh(eta), mass);
+  }
+
+  constexpr FourVector operator+(const FourVector& other) const { return {px + other.px, py + other.py, pz + other.pz, e + other.e}; }
+  constexpr FourVector operator-(const FourVector& other) const { return {px - other.px, py - other.py, pz - other.pz, e - other.e}; }
+  constexpr FourVector operator*(float scale) const { return {px * scale, py * scale, pz * scale, e * scale}; }
+  constexpr FourVector& operator+=(const FourVector& other)
+  {
+    px += other.px;
+    py += other.py;
+    pz += other.pz;
+    e += other.e;
+    return *this;
+  }
+
+  /// \return Minkowski product with the (+, -, -, -) metric
+  constexpr float dot(const FourVector& other) const { return e * other.e - px * other.px - py * other.py - pz * other.pz; }
+  constexpr float P2() const { return px * px + py * py + pz * pz; }
+  constexpr float Pt2() const { return px * px + py * py; }
+  constexpr float M2() const { return e * e - P2(); }
+
+  float P() const { return std::sqrt(P2()); }
+  float Pt() const { return std::sqrt(Pt2()); }
+  /// \return invariant mass, negative for space-like vectors as in TLorentzVector
+  float M() const
+  {
+    const float m2 = M2();
+    return m2 < 0.f ? -std::sqrt(-m2) : std::sqrt(m2);
+  }
+  float Mt() const { return std::sqrt(std::max(e * e - pz * pz, 0.f)); }
+  float Phi() const { return std::atan2(py, px); }
+  float Rapidity() const { return 0.5f * std::log((e + pz) / (e - pz)); }
+  float Eta() const
+  {
+    const float p = P();
+    return 0.5f * std::log((p + pz) / (p - pz));
+  }
+
+  /// \return cosine of the angle between the momenta of two vectors
+  float cosAngle(const FourVector& other) const
+  {
+    const float norm = std::sqrt(P2() * other.P2());
+    return norm > 0.f ? (px * other.px + py * other.py + pz * other.pz) / norm : 1.f;
+  }
+  /// \return opening angle between the momenta of two vectors
+  float angle(const FourVector& other) const { return std::acos(std::clamp(cosAngle(other), -1.f, 1.f)); }
+
+  /// Boost by the velocity (bx, by, bz), with the convention of TLorentzVector::Boost
+  void boost(float bx, float by, float bz)
+  {
+    const float b2 = bx * bx + by * by + bz * bz;
+    if (b2 <= 0.f) {
+      return;
+    }
+    const float gamma = 1.f / std::sqrt(1.f - b2);
+    const float bp = bx * px + by * py + bz * pz;
+    const float gamma2 = (gamma - 1.f) / b2;
+    px += gamma2 * bp * bx + gamma * bx * e;
+    py += gamma2 * bp * by + gamma * by * e;
+    pz += gamma2 * bp * bz + gamma * bz * e;
+    e = gamma * (e + bp);
+  }
+  /// \return copy boosted to the rest frame of frame
+  FourVector inRestFrameOf(const FourVector& frame) const
+  {
+    FourVector boosted = *this;
+    boosted.boost(-frame.px / frame.e, -frame.py / frame.e, -frame.pz / frame.e);
+    return boosted;
+  }
+};
+
+/// Mass, transverse momentum and rapidity of pairs of particles, computed in batches
+/// The momenta are filled in SoA layout, one entry per pair, then compute() fills the outputs of all the pairs.
+struct PairKinematicsBatch {
+  std::vector<float> px1, py1, pz1, m1;
+  std::vector<float> px2, py2, pz2, m2;
+  std::vector<float> mass, pt, y;
+
+  std::size_t size() const { return px1.size(); }
+  void clear()
+  {
+    for (auto* column : {&px1, &py1, &pz1, &m1, &px2, &py2, &pz2, &m2}) {
+      column->clear();
+    }
+  }
+  void reserve(std::size_t n)
+  {
+    for (auto* column : {&px1, &py1, &pz1, &m1, &px2, &py2, &pz2, &m2, &mass, &pt, &y}) {
+      column->reserve(n);
+    }
+  }
+  void push_back(float x1, float y1, float z1, float mass1, float x2, float y2, float z2, float mass2)
+  {
+    px1.push_back(x1);
+    py1.push_back(y1);
+    pz1.push_back(z1);
+    m1.push_back(mass1);
+    px2.push_back(x2);
+    py2.push_back(y2);
+    pz2.push_back(z2);
+    m2.push_back(mass2);
+  }
+
+  /// Fills mass, pt and y of all the pairs
+  void compute()
+  {
+    const std::size_t n = size();
+    mass.resize(n);
+    pt.resize(n);
+    y.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+      const float e1 = std::sqrt(px1[i] * px1[i] + py1[i] * py1[i] + pz1[i] * pz1[i] + m1[i] * m1[i]);
+      const float e2 = std::sqrt(px2[i] * px2[i] + py2[i] * py2[i] + pz2[i] * pz2[i] + m2[i] * m2[i]);
+      const float sumPx = px1[i] + px2[i];
+      const float sumPy = py1[i] + py2[i];
+      const float sumPz = pz1[i] + pz2[i];
+      const float sumE = e1 + e2;
+      const float pt2 = sumPx * sumPx + sumPy * sumPy;
+      mass[i] = std::sqrt(std::max(sumE * sumE - pt2 - sumPz * sumPz, 0.f));
+      pt[i] = std::sqrt(pt2);
+      y[i] = 0.5f * std::log((sumE + sumPz) / (sumE - sumPz));
+    }
+  }
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_FOURVECTOR_H_
@@ -0,0 +1,159 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file FrameArena.h
+/// \brief Monotonic arena for the temporary containers of a process function, with an STL allocator
+///
+/// The containers built for each collision or candidate (selected daughters, index maps...) take their memory from the
+/// arena of the task by bumping a pointer, and freeing does nothing. reset() makes the whole memory available again
+/// at once, e.g. at the beginning of each process call, so that after the first data frames no memory is requested
+/// from the heap anymore:
+///   FrameArena mArena;                    // member of the task
+///   mArena.reset();                       // beginning of the process function
+///   ArenaVector<int> ids(n, -1, ArenaAllocator<int>(mArena));
+/// The containers must not outlive the reset. The blocks used by a data frame are merged into one at the reset, so that
+/// the arena settles on a single block of the size of the largest data frame. Reserving the size of the containers
+/// avoids the copies left behind by their growth. Not thread safe: one arena per thread.
+
+#ifndef O2PHYSICS_COMMON_CORE_FRAMEARENA_H_
+#define O2PHYSICS_COMMON_CORE_FRAMEARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace o2::analysis
+{
+
+class FrameArena
+{
+ public:
+  /// \param blockSize  size of the first block (bytes), allocated at the first request
+  explicit FrameArena(std::size_t blockSize = 1 << 16) : mBlockSize(blockSize) {}
+  FrameArena(FrameArena const&) = delete;
+  FrameArena& operator=(FrameArena const&) = delete;
+
+  /// \return memory of at least bytes, aligned to alignment (a power of 2)
+  void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+  {
+    auto aligned = alignedPosition(alignment);
+    if (mBlocks.empty() || aligned + bytes > mBlocks.back().size) {
+      addBlock(bytes + alignment);
+      aligned = alignedPosition(alignment);
+    }
+    auto* memory = mBlocks.back().memory.get() + aligned;
+    mUsed += aligned + bytes - mPosition;
+    mPosition = aligned + bytes;
+    return memory;
+  }
+
+  /// Makes all the memory available again; the memory allocated since the last reset must not be used anymore
+  void reset()
+  {
+    if (mBlocks.size() > 1) {
+      // one block holding all the memory of the last data frame
+      std::size_t size = 0;
+      for (auto const& block : mBlocks) {
+        size += block.size;
+      }
+      mBlocks.clear();
+      mBlocks.push_back(Block{std::make_unique<std::byte[]>(size), size});
+    }
+    mPeak = std::max(mPeak, mUsed);
+    mPosition = 0;
+    mUsed = 0;
+  }
+
+  /// \return bytes allocated since the last reset, alignment included
+  std::size_t used() const { return mUsed; }
+  /// \return max. bytes allocated between two resets
+  std::size_t peak() const { return std::max(mPeak, mUsed); }
+  /// \return bytes held by the arena
+  std::size_t capacity() const
+  {
+    std::size_t size = 0;
+    for (auto const& block : mBlocks) {
+      size += block.size;
+    }
+    return size;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<std::byte[]> memory;
+    std::size_t size = 0;
+  };
+
+  /// \return first position of the last block aligned to alignment, at or after the first free byte
+  std::size_t alignedPosition(std::size_t alignment) const
+  {
+    if (mBlocks.empty()) {
+      return 0;
+    }
+    const auto base = reinterpret_cast<std::uintptr_t>(mBlocks.back().memory.get());
+    return ((base + mPosition + alignment - 1) & ~(std::uintptr_t{alignment} - 1)) - base;
+  }
+
+  void addBlock(std::size_t minSize)
+  {
+    const std::size_t size = std::max({minSize, mBlockSize, mBlocks.empty() ? std::size_t{0} : 2 * mBlocks.back().size});
+    mBlocks.push_back(Block{std::make_unique<std::byte[]>(size), size});
+    mPosition = 0;
+  }
+
+  std::size_t mBlockSize;     ///< size of the first block
+  std::vector<Block> mBlocks; ///< blocks, the last one being filled
+  std::size_t mPosition = 0;  ///< first free byte of the last block
+  std::size_t mUsed = 0;      ///< bytes allocated since the last reset
+  std::size_t mPeak = 0;      ///< max. of mUsed at the resets
+};
+
+/// STL allocator taking its memory from a FrameArena
+template <typename T>
+class ArenaAllocator
+{
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena& arena) noexcept : mArena(&arena) {}
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const& other) noexcept : mArena(other.arena())
+  {
+  }
+
+  T* allocate(std::size_t n) { return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T*, std::size_t) noexcept {}
+
+  FrameArena* arena() const noexcept { return mArena; }
+
+  template <typename U>
+  bool operator==(ArenaAllocator<U> const& other) const noexcept
+  {
+    return mArena == other.arena();
+  }
+  template <typename U>
+  bool operator!=(ArenaAllocator<U> const& other) const noexcept
+  {
+    return mArena != other.arena();
+  }
+
+ private:
+  FrameArena* mArena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_FRAMEARENA_H_
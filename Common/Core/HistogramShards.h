@@ -0,0 +1,319 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file HistogramShards.h
+/// \brief Dense per-chunk accumulators of booked histograms, filled concurrently and added to the histograms once per data frame
+///
+/// A task registers the histograms filled by a parallel kernel (those of a HistogramRegistry, of a HistogramManager list,
+/// the profiles of a container...) and gets one shard per chunk of the kernel, e.g. per chunk of ThreadPool::parallelFor:
+///   int hDeltaPhi = shards.add(registry.get<TH1>(HIST("deltaPhi")).get());
+///   shards.setNShards(nChunks);
+///   pool.parallelFor(n, nChunks, [&](auto iChunk, auto first, auto last) { ... shards.shard(iChunk).fill(hDeltaPhi, dPhi); });
+///   shards.flush(); // e.g. at the end of the process function
+/// Each shard holds the bin sums, the sums of squared weights and the statistics of the histograms in flat arrays which
+/// only its chunk writes, so that the fills take no lock. flush() adds the shards to the histograms bin by bin in shard
+/// order, so that the result does not depend on the scheduling, and resets them. TH1, TH2, TH3 and their profiles are
+/// supported, with the fill semantics of ROOT (under- and overflows, statistics of the in-range fills, profile range).
+
+#ifndef O2PHYSICS_COMMON_CORE_HISTOGRAMSHARDS_H_
+#define O2PHYSICS_COMMON_CORE_HISTOGRAMSHARDS_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <TAxis.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TH3.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+
+#include "Framework/Logger.h"
+#include "Common/Core/ThreadPool.h"
+
+namespace o2::analysis
+{
+
+class HistogramShards
+{
+ public:
+  /// Layout of a registered histogram in the arrays of the shards
+  struct Layout {
+    TH1* target = nullptr;                   ///< histogram the shards are added to
+    int dimension = 1;                       ///< number of axes
+    bool isProfile = false;                  ///< whether the histogram is a TProfile, TProfile2D or TProfile3D
+    std::array<TAxis const*, 3> axes{};      ///< axes of the histogram
+    std::array<int, 3> nCells{1, 1, 1};      ///< number of bins of each axis, under- and overflow included
+    int nBins = 0;                           ///< total number of bins, under- and overflows included
+    double profileMin = 0., profileMax = 0.; ///< range of the profiled value, no range if equal
+    std::size_t offset = 0;                  ///< position of the arrays of the histogram in the arrays of a shard
+  };
+
+  /// Sums of the fills of a histogram in a shard, besides the bins
+  struct Summary {
+    std::array<double, 13> stats{}; ///< statistics, in the order of TH1::GetStats
+    double entries = 0.;            ///< number of fills
+    bool weighted = false;          ///< whether a weight differed from 1
+    bool filled = false;            ///< whether there is something to add
+  };
+
+  /// Accumulators of the histograms filled by one chunk
+  class Shard
+  {
+   public:
+    /// Fills a histogram with weight 1, the coordinates being those of its axes, followed by the value for a profile
+    template <typename... Ts>
+    void fill(int histogram, Ts... coordinates)
+    {
+      fillWeighted(histogram, 1., coordinates...);
+    }
+
+    /// Fills a histogram with a weight
+    template <typename... Ts>
+    void fillWeighted(int histogram, double weight, Ts... coordinates)
+    {
+      static_assert(sizeof...(Ts) >= 1 && sizeof...(Ts) <= 4, "1 to 3 axes, and the value of a profile");
+      const double values[] = {static_cast<double>(coordinates)...};
+      fillValues(histogram, weight, values, sizeof...(Ts));
+    }
+
+   private:
+    friend class HistogramShards;
+
+    void fillValues(int histogram, double w, double const* values, int nValues)
+    {
+      auto const& layout = (*mLayouts)[histogram];
+      if (nValues != layout.dimension + layout.isProfile) {
+        LOGF(fatal, "HistogramShards: %d values to fill %s, which needs %d", nValues, layout.target->GetName(), layout.dimension + layout.isProfile);
+      }
+      int bin = 0;
+      bool inRange = true;
+      for (int axis = layout.dimension - 1; axis >= 0; --axis) {
+        const int axisBin = layout.axes[axis]->FindFixBin(values[axis]);
+        inRange = inRange && axisBin > 0 && axisBin < layout.nCells[axis] - 1;
+        bin = bin * layout.nCells[axis] + axisBin;
+      }
+      double* sums = mSums.data() + layout.offset;
+      auto& summary = mSummaries[histogram];
+      if (layout.isProfile) {
+        const double v = values[layout.dimension];
+        if (layout.profileMin != layout.profileMax && !(v >= layout.profileMin && v <= layout.profileMax)) {
+          return;
+        }
+        sums[bin] += w * v;
+        sums[layout.nBins + bin] += w * v * v;
+        sums[2 * layout.nBins + bin] += w;
+        sums[3 * layout.nBins + bin] += w * w;
+      } else {
+        sums[bin] += w;
+        sums[layout.nBins + bin] += w * w;
+      }
+      summary.entries += 1.;
+      summary.weighted = summary.weighted || w != 1.;
+      summary.filled = true;
+      if (!inRange && !TH1::GetStatOverflowsBehaviour()) {
+        return;
+      }
+      auto& s = summary.stats;
+      const double x = values[0];
+      s[0] += w;
+      s[1] += w * w;
+      s[2] += w * x;
+      s[3] += w * x * x;
+      int next = 4;
+      if (layout.dimension >= 2) {
+        const double y = values[1];
+        s[4] += w * y;
+        s[5] += w * y * y;
+        s[6] += w * x * y;
+        next = 7;
+      }
+      if (layout.dimension == 3) {
+        const double y = values[1], z = values[2];
+        s[7] += w * z;
+        s[8] += w * z * z;
+        s[9] += w * x * z;
+        s[10] += w * y * z;
+        next = 11;
+      }
+      if (layout.isProfile) {
+        const double v = values[layout.dimension];
+        s[next] += w * v;
+        s[next + 1] += w * v * v;
+      }
+    }
+
+    std::vector<Layout> const* mLayouts = nullptr;
+    std::vector<double> mSums;       ///< arrays of the histograms: bin sums, sums of squares, profile bin entries and their sums of squares
+    std::vector<Summary> mSummaries; ///< summary of each histogram
+  };
+
+  HistogramShards() = default;
+  HistogramShards(HistogramShards const&) = delete;
+  HistogramShards& operator=(HistogramShards const&) = delete;
+
+  /// Registers a booked histogram, which must outlive the shards
+  /// \return index of the histogram in the fills
+  int add(TH1* histogram)
+  {
+    Layout layout;
+    layout.target = histogram;
+    layout.dimension = histogram->GetDimension();
+    layout.axes = {histogram->GetXaxis(), histogram->GetYaxis(), histogram->GetZaxis()};
+    layout.nBins = 1;
+    for (int axis = 0; axis < layout.dimension; ++axis) {
+      layout.nCells[axis] = layout.axes[axis]->GetNbins() + 2;
+      layout.nBins *= layout.nCells[axis];
+    }
+    if (auto* profile = dynamic_cast<TProfile*>(histogram)) {
+      layout.isProfile = true;
+      layout.profileMin = profile->GetYmin();
+      layout.profileMax = profile->GetYmax();
+    } else if (auto* profile2D = dynamic_cast<TProfile2D*>(histogram)) {
+      layout.isProfile = true;
+      layout.profileMin = profile2D->GetZmin();
+      layout.profileMax = profile2D->GetZmax();
+    } else if (auto* profile3D = dynamic_cast<TProfile3D*>(histogram)) {
+      layout.isProfile = true;
+      layout.profileMin = profile3D->GetTmin();
+      layout.profileMax = profile3D->GetTmax();
+    }
+    layout.offset = mLayouts.empty() ? 0 : mLayouts.back().offset + nArrays(mLayouts.back()) * mLayouts.back().nBins;
+    mLayouts.push_back(layout);
+    for (auto& shard : mShards) {
+      allocate(shard);
+    }
+    return mLayouts.size() - 1;
+  }
+
+  /// Allocates the shards, one for each chunk of the kernels
+  void setNShards(int nShards)
+  {
+    mShards.resize(std::max(nShards, 1));
+    for (auto& shard : mShards) {
+      allocate(shard);
+    }
+  }
+
+  int nShards() const { return mShards.size(); }
+
+  /// \return shard of a chunk, written only by the thread processing it
+  Shard& shard(int iShard) { return mShards[iShard]; }
+
+  /// Adds the shards to the histograms, in shard order, and resets them: e.g. once per data frame, and in any case
+  /// before the output is written. The histograms are independent and can be processed in parallel
+  /// \param nChunks  max. number of chunks of histograms processed in parallel by the threads of the pool
+  void flush(int nChunks = 1)
+  {
+    ThreadPool::instance().parallelFor(mLayouts.size(), std::max(nChunks, 1), [this](std::size_t, std::size_t first, std::size_t last) {
+      for (auto histogram = first; histogram < last; ++histogram) {
+        flushHistogram(histogram);
+      }
+    });
+  }
+
+ private:
+  static int nArrays(Layout const& layout) { return layout.isProfile ? 4 : 2; }
+
+  void allocate(Shard& shard)
+  {
+    shard.mLayouts = &mLayouts;
+    shard.mSums.resize(mLayouts.empty() ? 0 : mLayouts.back().offset + nArrays(mLayouts.back()) * mLayouts.back().nBins, 0.);
+    shard.mSummaries.resize(mLayouts.size());
+  }
+
+  template <typename TProfileType>
+  static void addProfileBin(TProfileType* target, int bin, double entries, double entriesSumw2)
+  {
+    if (entries != 0.) {
+      target->SetBinEntries(bin, target->GetBinEntries(bin) + entries);
+    }
+    if (target->GetBinSumw2()->fN > 0) {
+      target->GetBinSumw2()->GetArray()[bin] += entriesSumw2;
+    }
+  }
+
+  void flushHistogram(std::size_t histogram)
+  {
+    auto const& layout = mLayouts[histogram];
+    TH1* target = layout.target;
+    // the statistics are taken before touching the bins, GetStats could otherwise recompute them from the bins
+    double stats[13] = {0.};
+    target->GetStats(stats);
+    double entries = target->GetEntries();
+    bool filled = false, weighted = false;
+    for (auto& shard : mShards) {
+      auto& summary = shard.mSummaries[histogram];
+      if (!summary.filled) {
+        continue;
+      }
+      for (std::size_t i = 0; i < summary.stats.size(); ++i) {
+        stats[i] += summary.stats[i];
+      }
+      entries += summary.entries;
+      filled = true;
+      weighted = weighted || summary.weighted;
+      summary = Summary{};
+    }
+    if (!filled) {
+      return;
+    }
+    // as TH1::Fill, the structure of the sums of squared weights is created at the first weight which differs from 1
+    TProfile* profile = dynamic_cast<TProfile*>(target);
+    TProfile2D* profile2D = profile ? nullptr : dynamic_cast<TProfile2D*>(target);
+    TProfile3D* profile3D = (profile || profile2D) ? nullptr : dynamic_cast<TProfile3D*>(target);
+    if (weighted) {
+      const bool hasSumw2 = profile ? profile->GetBinSumw2()->fN > 0 : profile2D ? profile2D->GetBinSumw2()->fN > 0 : profile3D ? profile3D->GetBinSumw2()->fN > 0 : target->GetSumw2N() > 0;
+      if (!hasSumw2) {
+        target->Sumw2();
+      }
+    }
+    double* sumw2 = target->GetSumw2N() > 0 ? target->GetSumw2()->GetArray() : nullptr;
+    std::array<double, 4> binSums{};
+    for (int bin = 0; bin < layout.nBins; ++bin) {
+      binSums.fill(0.);
+      for (auto const& shard : mShards) {
+        double const* sums = shard.mSums.data() + layout.offset;
+        for (int array = 0; array < nArrays(layout); ++array) {
+          binSums[array] += sums[array * layout.nBins + bin];
+        }
+      }
+      if (binSums[0] != 0.) {
+        target->AddBinContent(bin, binSums[0]);
+      }
+      if (sumw2) {
+        sumw2[bin] += binSums[1];
+      }
+      if (profile) {
+        addProfileBin(profile, bin, binSums[2], binSums[3]);
+      } else if (profile2D) {
+        addProfileBin(profile2D, bin, binSums[2], binSums[3]);
+      } else if (profile3D) {
+        addProfileBin(profile3D, bin, binSums[2], binSums[3]);
+      }
+    }
+    for (auto& shard : mShards) {
+      std::fill_n(shard.mSums.begin() + layout.offset, nArrays(layout) * layout.nBins, 0.);
+    }
+    target->PutStats(stats);
+    target->SetEntries(entries);
+  }
+
+  std::vector<Layout> mLayouts; ///< registered histograms
+  std::vector<Shard> mShards;   ///< one per chunk
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_HISTOGRAMSHARDS_H_
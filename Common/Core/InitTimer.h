@@ -0,0 +1,101 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file InitTimer.h
+/// \brief Opt-in wall time of the steps of the init of a task (e.g. parsing of the cuts, loading of the models)
+///
+/// A task declares one InitTimer, enables it from a configurable and opens a scope for each step of its init:
+///   auto step = timer.measure("cuts");
+/// The time of each step and the total are printed by print(), typically at the end of init. Without enable()
+/// the scopes do nothing.
+
+#ifndef O2PHYSICS_COMMON_CORE_INITTIMER_H_
+#define O2PHYSICS_COMMON_CORE_INITTIMER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Framework/Logger.h"
+
+namespace o2::analysis
+{
+
+/// Timing of the steps of the init of a task
+class InitTimer
+{
+ public:
+  /// Measurement of one step, recorded when it goes out of scope
+  class Scope
+  {
+   public:
+    Scope(InitTimer* timer, std::string step) : mTimer(timer), mStep(std::move(step))
+    {
+      if (mTimer) {
+        mStart = std::chrono::steady_clock::now();
+      }
+    }
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+    ~Scope()
+    {
+      if (mTimer) {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - mStart;
+        mTimer->mSteps.emplace_back(mStep, elapsed.count());
+      }
+    }
+
+   private:
+    InitTimer* mTimer = nullptr; ///< null if the timing is disabled
+    std::string mStep;
+    std::chrono::steady_clock::time_point mStart{};
+  };
+
+  /// Enables the timing
+  /// \param name  name of the timer in the printout, e.g. the task name
+  void enable(std::string const& name)
+  {
+    mName = name;
+    mEnabled = true;
+  }
+
+  bool isEnabled() const { return mEnabled; }
+
+  /// Starts the measurement of a step
+  Scope measure(std::string const& step) { return Scope(mEnabled ? this : nullptr, step); }
+
+  /// Prints the time of the steps measured so far and their total
+  void print() const
+  {
+    if (!mEnabled) {
+      return;
+    }
+    double total = 0.;
+    for (auto const& [step, time] : mSteps) {
+      LOGF(info, "[%s] init step %s: %.1f ms", mName, step, time);
+      total += time;
+    }
+    LOGF(info, "[%s] init steps total: %.1f ms", mName, total);
+  }
+
+  /// \return steps measured so far, with their wall time in ms
+  std::vector<std::pair<std::string, double>> const& steps() const { return mSteps; }
+
+ private:
+  std::string mName{};
+  bool mEnabled = false;
+  std::vector<std::pair<std::string, double>> mSteps{};
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_INITTIMER_H_
@@ -0,0 +1,96 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file IntervalIndex.h
+/// \brief Index of closed intervals (e.g. collision time windows in BCs) for overlap queries
+
+#ifndef O2_ANALYSIS_INTERVALINDEX_H_
+#define O2_ANALYSIS_INTERVALINDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/// Index of closed intervals [first, last] with an identifier, e.g. the BC windows of the collisions
+/// \note The intervals are sorted by their first value. Since no interval is longer than the longest one,
+/// the intervals overlapping a query range start in a window found by binary search, which gives the
+/// same answer as an interval tree in O(log n + k) for intervals of similar lengths.
+template <typename T = uint64_t>
+class IntervalIndex
+{
+ public:
+  /// Adds an interval, the index must be built before querying.
+  /// \param first  first value of the interval
+  /// \param last  last value of the interval
+  /// \param id  identifier of the interval, e.g. the collision index
+  void add(T first, T last, int64_t id)
+  {
+    mIntervals.push_back({first, last, id});
+    mBuilt = false;
+  }
+
+  /// Sorts the intervals.
+  void build()
+  {
+    std::sort(mIntervals.begin(), mIntervals.end(), [](Interval const& a, Interval const& b) { return a.first < b.first || (a.first == b.first && a.id < b.id); });
+    mMaxLength = 0;
+    for (auto const& interval : mIntervals) {
+      mMaxLength = std::max(mMaxLength, interval.last - interval.first);
+    }
+    mBuilt = true;
+  }
+
+  void clear()
+  {
+    mIntervals.clear();
+    mMaxLength = 0;
+    mBuilt = false;
+  }
+
+  bool isBuilt() const { return mBuilt; }
+  std::size_t size() const { return mIntervals.size(); }
+
+  /// Finds the intervals overlapping the range [first, last].
+  /// \param first  first value of the range
+  /// \param last  last value of the range
+  /// \param ids  identifiers of the overlapping intervals, appended in increasing order of the interval start
+  void findOverlaps(T first, T last, std::vector<int64_t>& ids) const
+  {
+    // intervals starting before first - mMaxLength end before first
+    T firstStart = first > mMaxLength ? first - mMaxLength : T{0};
+    auto it = std::lower_bound(mIntervals.begin(), mIntervals.end(), firstStart, [](Interval const& interval, T value) { return interval.first < value; });
+    for (; it != mIntervals.end() && it->first <= last; ++it) {
+      if (it->last >= first) {
+        ids.push_back(it->id);
+      }
+    }
+  }
+
+  /// Finds the intervals containing a value.
+  /// \param value  value to look for
+  /// \param ids  identifiers of the intervals containing the value
+  void findContaining(T value, std::vector<int64_t>& ids) const
+  {
+    findOverlaps(value, value, ids);
+  }
+
+ private:
+  struct Interval {
+    T first;
+    T last;
+    int64_t id;
+  };
+  std::vector<Interval> mIntervals{}; ///< intervals sorted by their first value
+  T mMaxLength = 0;                   ///< length of the longest interval
+  bool mBuilt = false;                ///< whether the intervals are sorted
+};
+
+#endif // O2_ANALYSIS_INTERVALINDEX_H_
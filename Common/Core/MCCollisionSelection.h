@@ -0,0 +1,86 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MCCollisionSelection.h
+/// \brief Flags of the MC collisions reconstructed as a selected collision, built once per data frame
+///
+/// The flags are a dense byte array indexed by MC collision, filled from the MC labels of the reconstructed
+/// collisions. Whether an MC collision (or the MC collision of a particle) was reconstructed and selected is then one
+/// access, in place of a search in the list of the selected collisions.
+
+#ifndef O2PHYSICS_COMMON_CORE_MCCOLLISIONSELECTION_H_
+#define O2PHYSICS_COMMON_CORE_MCCOLLISIONSELECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace o2::analysis
+{
+
+class MCCollisionSelection
+{
+ public:
+  /// Flags the MC collisions of the reconstructed collisions passing the selection
+  /// \param nMcCollisions  number of MC collisions of the data frame
+  /// \param collisions  reconstructed collisions, joined with their MC collision labels
+  /// \param isSelected  selection of the reconstructed collisions, e.g. on the event selection bits
+  template <typename TCollisions, typename TSelection>
+  void build(std::size_t nMcCollisions, TCollisions const& collisions, TSelection&& isSelected)
+  {
+    mSelected.assign(nMcCollisions, 0);
+    for (const auto& collision : collisions) {
+      if (!collision.has_mcCollision() || !isSelected(collision)) {
+        continue;
+      }
+      select(collision.mcCollisionId());
+    }
+  }
+
+  /// Flags the MC collisions of all the reconstructed collisions
+  template <typename TCollisions>
+  void build(std::size_t nMcCollisions, TCollisions const& collisions)
+  {
+    build(nMcCollisions, collisions, [](const auto&) { return true; });
+  }
+
+  /// Flags an MC collision, ignored if out of range
+  void select(int64_t mcCollisionId)
+  {
+    if (mcCollisionId >= 0 && static_cast<std::size_t>(mcCollisionId) < mSelected.size()) {
+      mSelected[mcCollisionId] = 1;
+    }
+  }
+
+  /// Removes the flag of an MC collision, e.g. failing a generator-level selection
+  void deselect(int64_t mcCollisionId)
+  {
+    if (mcCollisionId >= 0 && static_cast<std::size_t>(mcCollisionId) < mSelected.size()) {
+      mSelected[mcCollisionId] = 0;
+    }
+  }
+
+  /// \return whether the MC collision was reconstructed and selected, false for a negative label
+  bool isSelected(int64_t mcCollisionId) const
+  {
+    return mcCollisionId >= 0 && static_cast<std::size_t>(mcCollisionId) < mSelected.size() && mSelected[mcCollisionId];
+  }
+
+  /// \return number of MC collisions
+  std::size_t getNMcCollisions() const { return mSelected.size(); }
+
+ private:
+  std::vector<uint8_t> mSelected; ///< flag of each MC collision
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_MCCOLLISIONSELECTION_H_
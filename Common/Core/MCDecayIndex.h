@@ -0,0 +1,151 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MCDecayIndex.h
+/// \brief Index of the MC decays matched at the generated level, for the matching of reconstructed candidates
+
+#ifndef O2_ANALYSIS_MCDECAYINDEX_H_
+#define O2_ANALYSIS_MCDECAYINDEX_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+/// Index of the MC particles matched to a decay channel at the generated level
+/// \note Filled once per data frame from the generated-level matching (RecoDecay::isMatchedMCGen),
+/// it replaces the walk through the decay tree of RecoDecay::getMatchedMCRec by a lookup of the
+/// mother of the first prong and of the final daughters recorded for it.
+/// The results are the same as RecoDecay::getMatchedMCRec for the default depthMax = 1,
+/// provided that the generated-level matching was done with the same expected decay.
+class MCDecayIndex
+{
+ public:
+  /// Clears the index.
+  /// \param nParticles  number of MC particles
+  void reset(std::size_t nParticles)
+  {
+    mFlags.assign(nParticles, 0);
+    mOrigins.assign(nParticles, 0);
+    mDaughterRanges.assign(nParticles, {0, 0});
+    mDaughters.clear();
+  }
+
+  /// Records the decay matched for an MC particle.
+  /// \param position  position of the particle in the MC particle table
+  /// \param flag  generated-level matching flag
+  /// \param origin  origin of the particle
+  /// \param daughters  global indices of the final daughters found by the matching
+  void setDecay(std::size_t position, int8_t flag, int8_t origin, std::vector<int> const& daughters)
+  {
+    mFlags[position] = flag;
+    mOrigins[position] = origin;
+    mDaughterRanges[position] = {static_cast<int>(mDaughters.size()), static_cast<int>(daughters.size())};
+    mDaughters.insert(mDaughters.end(), daughters.begin(), daughters.end());
+  }
+
+  /// \param position  position of the particle in the MC particle table
+  /// \return generated-level matching flag of the particle
+  int8_t getFlag(std::size_t position) const { return mFlags[position]; }
+
+  /// \param position  position of the particle in the MC particle table
+  /// \return origin of the particle
+  int8_t getOrigin(std::size_t position) const { return mOrigins[position]; }
+
+  /// Checks whether the reconstructed decay candidate is the expected decay.
+  /// \param particlesMC  table with MC particles
+  /// \param arrDaughters  array of candidate daughters
+  /// \param PDGMother  expected mother PDG code
+  /// \param flagDecay  generated-level flag of the expected decay, regardless of the sign
+  /// \param acceptAntiParticles  switch to accept the antiparticle version of the expected decay
+  /// \param sign  antiparticle indicator of the found mother w.r.t. PDGMother; 1 if particle, -1 if antiparticle, 0 if mother not found
+  /// \return index of the mother particle if the mother and daughters are correct, -1 otherwise
+  template <std::size_t N, typename T, typename U>
+  int getMatchedMCRec(const T& particlesMC,
+                      const std::array<U, N>& arrDaughters,
+                      int PDGMother,
+                      int8_t flagDecay,
+                      bool acceptAntiParticles = false,
+                      int8_t* sign = nullptr) const
+  {
+    if (sign) {
+      *sign = 0;
+    }
+    for (std::size_t iProng = 0; iProng < N; ++iProng) {
+      if (!arrDaughters[iProng].has_mcParticle()) {
+        return -1;
+      }
+    }
+    // Find the first direct mother of the first prong with the expected PDG code.
+    auto particle0 = arrDaughters[0].mcParticle();
+    if (!particle0.has_mothers()) {
+      return -1;
+    }
+    int8_t sgn = 0;
+    int indexMother = -1;
+    for (auto iMother = particle0.mothersIds().front(); iMother <= particle0.mothersIds().back(); ++iMother) {
+      auto PDGParticleIMother = particlesMC.rawIteratorAt(iMother - particlesMC.offset()).pdgCode();
+      if (PDGParticleIMother == PDGMother) {
+        sgn = 1;
+      } else if (acceptAntiParticles && PDGParticleIMother == -PDGMother) {
+        sgn = -1;
+      } else {
+        continue;
+      }
+      indexMother = iMother;
+      break;
+    }
+    if (indexMother < 0) {
+      return -1;
+    }
+    // The mother must have decayed via the expected channel at the generated level.
+    auto positionMother = indexMother - particlesMC.offset();
+    if (std::abs(mFlags[positionMother]) != flagDecay) {
+      return -1;
+    }
+    // Each prong must be a different final daughter of the mother.
+    // The PDG codes of the final daughters were checked by the generated-level matching.
+    auto [begin, count] = mDaughterRanges[positionMother];
+    if (count != static_cast<int>(N)) {
+      return -1;
+    }
+    std::array<int, N> daughtersLeft;
+    std::copy(mDaughters.begin() + begin, mDaughters.begin() + begin + count, daughtersLeft.begin());
+    for (std::size_t iProng = 0; iProng < N; ++iProng) {
+      int indexProng = arrDaughters[iProng].mcParticleId();
+      bool isDaughterFound = false;
+      for (auto& indexDaughter : daughtersLeft) {
+        if (indexDaughter == indexProng) {
+          indexDaughter = -1; // rejects twin daughters
+          isDaughterFound = true;
+          break;
+        }
+      }
+      if (!isDaughterFound) {
+        return -1;
+      }
+    }
+    if (sign) {
+      *sign = sgn;
+    }
+    return indexMother;
+  }
+
+ private:
+  std::vector<int8_t> mFlags{};                        ///< generated-level matching flags per MC particle
+  std::vector<int8_t> mOrigins{};                      ///< origins per MC particle
+  std::vector<std::pair<int, int>> mDaughterRanges{}; ///< (first, number) of the final daughters of each MC particle in mDaughters
+  std::vector<int> mDaughters{};                       ///< global indices of the final daughters of the matched decays
+};
+
+#endif // O2_ANALYSIS_MCDECAYINDEX_H_
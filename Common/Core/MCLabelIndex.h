@@ -0,0 +1,89 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MCLabelIndex.h
+/// \brief Index of the reconstructed tracks of each MC particle, built once per data frame
+///
+/// The entries (e.g. the tracks) are sorted by the MC particle of their label with a counting sort: the entries of
+/// particle p are at positions [offset(p), offset(p + 1)) of one array, in increasing order. Multiply reconstructed
+/// particles are the ones with more than one entry. The index replaces the per-particle vectors of track indices,
+/// without any allocation per particle.
+
+#ifndef O2PHYSICS_COMMON_CORE_MCLABELINDEX_H_
+#define O2PHYSICS_COMMON_CORE_MCLABELINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace o2::analysis
+{
+
+class MCLabelIndex
+{
+ public:
+  /// Entries of an MC particle
+  struct Range {
+    const int64_t* mBegin;
+    const int64_t* mEnd;
+    const int64_t* begin() const { return mBegin; }
+    const int64_t* end() const { return mEnd; }
+    std::size_t size() const { return mEnd - mBegin; }
+    int64_t operator[](std::size_t i) const { return mBegin[i]; }
+  };
+
+  /// Builds the index
+  /// \param nParticles  number of MC particles
+  /// \param labels  MC particle of each entry, the entries with a negative or out of range label are not indexed
+  /// \param entries  value stored for each entry, e.g. the track global index; the position of the entry if empty
+  void build(std::size_t nParticles, std::vector<int> const& labels, std::vector<int64_t> const& entries = {})
+  {
+    mOffsets.assign(nParticles + 1, 0);
+    for (int label : labels) {
+      if (label >= 0 && static_cast<std::size_t>(label) < nParticles) {
+        mOffsets[label + 1]++;
+      }
+    }
+    for (std::size_t i = 0; i < nParticles; i++) {
+      mOffsets[i + 1] += mOffsets[i];
+    }
+    mEntries.resize(mOffsets[nParticles]);
+    mCursors.assign(mOffsets.begin(), mOffsets.end() - 1);
+    for (std::size_t i = 0; i < labels.size(); i++) {
+      const int label = labels[i];
+      if (label >= 0 && static_cast<std::size_t>(label) < nParticles) {
+        mEntries[mCursors[label]++] = entries.empty() ? static_cast<int64_t>(i) : entries[i];
+      }
+    }
+  }
+
+  /// \return number of MC particles
+  std::size_t getNParticles() const { return mOffsets.empty() ? 0 : mOffsets.size() - 1; }
+  /// \return number of indexed entries
+  std::size_t getNEntries() const { return mEntries.size(); }
+
+  /// \return number of entries of the MC particle
+  std::size_t count(std::size_t particle) const { return mOffsets[particle + 1] - mOffsets[particle]; }
+  /// \return entries of the MC particle
+  Range entries(std::size_t particle) const
+  {
+    return {mEntries.data() + mOffsets[particle], mEntries.data() + mOffsets[particle + 1]};
+  }
+
+ private:
+  std::vector<std::size_t> mOffsets; ///< first entry of each particle, and total number of entries
+  std::vector<std::size_t> mCursors; ///< filling position of each particle during build
+  std::vector<int64_t> mEntries;     ///< entries sorted by particle
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_MCLABELINDEX_H_
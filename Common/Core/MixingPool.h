@@ -0,0 +1,191 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MixingPool.h
+/// \brief Pool of event snapshots for event mixing, kept across dataframes
+///
+/// Each mixing category keeps up to a fixed number of events, stored as compact track snapshots chosen by the task.
+/// The mixing depth is therefore independent of the dataframe size, and the memory is bounded by a global cap:
+/// when it is reached the oldest events of the pool are dropped, whatever their category.
+
+#ifndef O2PHYSICS_COMMON_CORE_MIXINGPOOL_H_
+#define O2PHYSICS_COMMON_CORE_MIXINGPOOL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace o2::analysis
+{
+
+/// Event mixing pool of track snapshots of type TTrack, per mixing category
+template <typename TTrack>
+class MixingPool
+{
+ public:
+  /// Policy used when a category is full
+  enum class Replacement {
+    FIFO = 0, ///< the oldest event of the category is replaced
+    Reservoir ///< a random event is replaced, so that the pool is a uniform sample of all the events seen (reservoir sampling)
+  };
+
+  /// Configures the pool, to be called once, e.g. in init()
+  /// \param depth  maximum number of events per category
+  /// \param maxBytes  maximum memory of the stored events, 0: no limit
+  /// \param replacement  policy used when a category is full
+  /// \param seed  seed of the random replacements
+  void init(int depth, size_t maxBytes = 0, Replacement replacement = Replacement::FIFO, uint32_t seed = 0)
+  {
+    mDepth = depth;
+    mMaxBytes = maxBytes;
+    mReplacement = replacement;
+    mGenerator.seed(seed);
+    clear();
+  }
+
+  /// Calls a function for each event stored in a category, from the oldest to the newest
+  /// \param category  mixing category
+  /// \param function  called with the track snapshots of each event, as const std::vector<TTrack>&
+  template <typename F>
+  void forEachEvent(int category, F&& function) const
+  {
+    auto found = mCategories.find(category);
+    if (found == mCategories.end()) {
+      return;
+    }
+    for (const auto& event : found->second.events) {
+      function(event.tracks);
+    }
+  }
+
+  /// Adds an event to a category, after it was mixed with the events already stored
+  /// \param category  mixing category
+  /// \param tracks  track snapshots of the event
+  void add(int category, std::vector<TTrack>&& tracks)
+  {
+    if (mDepth <= 0) {
+      return;
+    }
+    Category& cat = mCategories[category];
+    cat.nSeen++;
+    Event event{mNextSerial++, std::move(tracks)};
+    const size_t bytes = getBytes(event);
+
+    if (static_cast<int>(cat.events.size()) < mDepth) {
+      cat.events.push_back(std::move(event));
+      mNEvents++;
+    } else if (mReplacement == Replacement::FIFO) {
+      mBytes -= getBytes(cat.events.front());
+      cat.events.pop_front();
+      cat.events.push_back(std::move(event));
+    } else {
+      // keep the new event with probability depth / number of events seen, replacing a random one
+      const uint64_t slot = std::uniform_int_distribution<uint64_t>(0, cat.nSeen - 1)(mGenerator);
+      if (slot >= static_cast<uint64_t>(mDepth)) {
+        return;
+      }
+      mBytes -= getBytes(cat.events[slot]);
+      cat.events[slot] = std::move(event);
+    }
+    mBytes += bytes;
+    mOrder.emplace_back(category, mNextSerial - 1);
+    evict();
+    if (mOrder.size() > 2 * mNEvents + 64) {
+      compactOrder();
+    }
+  }
+
+  /// Removes all the events
+  void clear()
+  {
+    mCategories.clear();
+    mOrder.clear();
+    mNEvents = 0;
+    mBytes = 0;
+  }
+
+  /// Number of events stored in a category
+  int getNEvents(int category) const
+  {
+    auto found = mCategories.find(category);
+    return found == mCategories.end() ? 0 : found->second.events.size();
+  }
+
+  /// Memory of the stored events in bytes
+  size_t getBytes() const { return mBytes; }
+
+ private:
+  struct Event {
+    uint64_t serial; ///< insertion order in the pool
+    std::vector<TTrack> tracks;
+  };
+
+  struct Category {
+    std::deque<Event> events;
+    uint64_t nSeen = 0; ///< events offered to the category, for the reservoir sampling
+  };
+
+  static size_t getBytes(const Event& event) { return sizeof(Event) + event.tracks.capacity() * sizeof(TTrack); }
+
+  /// Drops the oldest events of the pool until the memory is below the cap
+  void evict()
+  {
+    while (mMaxBytes > 0 && mBytes > mMaxBytes && !mOrder.empty()) {
+      const auto [category, serial] = mOrder.front();
+      mOrder.pop_front();
+      auto& events = mCategories[category].events;
+      // events replaced by the reservoir sampling are already gone
+      for (auto event = events.begin(); event != events.end(); ++event) {
+        if (event->serial == serial) {
+          mBytes -= getBytes(*event);
+          events.erase(event);
+          mNEvents--;
+          break;
+        }
+      }
+    }
+  }
+
+  /// Drops the insertion records of the events which were replaced
+  void compactOrder()
+  {
+    std::vector<std::pair<uint64_t, int>> stored;
+    stored.reserve(mNEvents);
+    for (const auto& [category, cat] : mCategories) {
+      for (const auto& event : cat.events) {
+        stored.emplace_back(event.serial, category);
+      }
+    }
+    std::sort(stored.begin(), stored.end());
+    mOrder.clear();
+    for (const auto& [serial, category] : stored) {
+      mOrder.emplace_back(category, serial);
+    }
+  }
+
+  int mDepth = 0;                                ///< maximum number of events per category
+  size_t mMaxBytes = 0;                          ///< memory cap, 0: no limit
+  Replacement mReplacement = Replacement::FIFO;  ///< policy used when a category is full
+  std::mt19937_64 mGenerator;                    ///< generator of the random replacements
+  std::unordered_map<int, Category> mCategories; ///< stored events per category
+  std::deque<std::pair<int, uint64_t>> mOrder;   ///< category and serial of the stored events, oldest first
+  uint64_t mNextSerial = 0;                      ///< serial of the next event
+  size_t mNEvents = 0;                           ///< number of stored events
+  size_t mBytes = 0;                             ///< memory of the stored events
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_MIXINGPOOL_H_
@@ -0,0 +1,286 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file OnnxSessionRegistry.h
+/// \brief Process-wide registry of the ONNX runtime sessions used by the ML clients
+///
+/// A single Ort::Env, optionally with a global thread pool, is created per process and
+/// each model is loaded only once, whatever the number of tasks or classes using it.
+/// With a model cache directory, the graph optimised when a model is first loaded is saved there and the
+/// later jobs load the optimised graph without optimising it again.
+
+#ifndef O2PHYSICS_COMMON_CORE_ONNXSESSIONREGISTRY_H_
+#define O2PHYSICS_COMMON_CORE_ONNXSESSIONREGISTRY_H_
+
+#include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <TH1.h>
+
+#include "Common/Core/ConfigurationCache.h"
+#include "Common/Core/ProcessCounters.h"
+#include "Framework/Logger.h"
+
+namespace o2::analysis
+{
+
+/// Settings of an ONNX runtime session; the same model loaded with different settings gives different sessions
+struct OnnxSessionSettings {
+  bool enableOptimization = false; ///< use GraphOptimizationLevel::ORT_ENABLE_EXTENDED
+  int nThreadsIntraOp = 0;         ///< threads within an operator, 0: ONNX runtime default; ignored with the global thread pool
+  int nThreadsInterOp = 0;         ///< threads across operators, 0: ONNX runtime default; ignored with the global thread pool
+  int executionProvider = 0;       ///< 0: CPU, 1: CUDA, 2: TensorRT, falling back to CPU if not available
+  std::string modelCacheDir = "";  ///< directory of the optimised models, shared by the jobs; empty: no cache
+
+  std::string key() const
+  {
+    return std::to_string(enableOptimization) + "_" + std::to_string(nThreadsIntraOp) + "_" + std::to_string(nThreadsInterOp) + "_" + std::to_string(executionProvider);
+  }
+};
+
+/// ONNX model shared among the clients of the registry
+class OnnxModel
+{
+ public:
+  OnnxModel(Ort::Env& env, const std::string& path, Ort::SessionOptions& sessionOptions) : mPath(path)
+  {
+    mSession = std::make_unique<Ort::Experimental::Session>(env, path, sessionOptions);
+    mInputNames = mSession->GetInputNames();
+    mInputShapes = mSession->GetInputShapes();
+    mOutputNames = mSession->GetOutputNames();
+    mOutputShapes = mSession->GetOutputShapes();
+    mInputElementType = mSession->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+  }
+
+  /// Runs the model
+  /// \param inputTensors  input tensors, one per input node
+  /// \return output tensors, one per output node
+  std::vector<Ort::Value> run(std::vector<Ort::Value>& inputTensors)
+  {
+    auto start = std::chrono::steady_clock::now();
+    auto outputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
+    fillLatency(start);
+    return outputTensors;
+  }
+
+  /// Runs the model writing the output into preallocated tensors
+  /// \param inputTensors  input tensors, one per input node
+  /// \param outputTensors  output tensors, one per output node, viewing buffers owned by the caller
+  void run(std::vector<Ort::Value>& inputTensors, std::vector<Ort::Value>& outputTensors)
+  {
+    auto start = std::chrono::steady_clock::now();
+    mSession->Run(mInputNames, inputTensors, mOutputNames, outputTensors);
+    fillLatency(start);
+  }
+
+  /// Runs the model on a batch of entries stored row by row, shape [nEntries x nFeatures]
+  /// \param inputValues  input features, nEntries * getNFeatures() values
+  /// \return output tensors, one per output node, with nEntries rows
+  template <typename T>
+  std::vector<Ort::Value> runBatch(std::vector<T>& inputValues)
+  {
+    const int64_t nFeatures = getNFeatures();
+    std::vector<int64_t> inputShape{static_cast<int64_t>(inputValues.size()) / nFeatures, nFeatures};
+    std::vector<Ort::Value> inputTensors;
+    inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<T>(inputValues.data(), inputValues.size(), inputShape));
+    return run(inputTensors);
+  }
+
+  /// Attaches a histogram filled with the duration of every run in microseconds
+  void setLatencyHistogram(std::shared_ptr<TH1> histLatency) { mHistLatency = histLatency; }
+
+  Ort::Experimental::Session& session() { return *mSession; }
+  const std::string& path() const { return mPath; }
+  const std::vector<std::string>& inputNames() const { return mInputNames; }
+  const std::vector<std::vector<int64_t>>& inputShapes() const { return mInputShapes; }
+  const std::vector<std::string>& outputNames() const { return mOutputNames; }
+  const std::vector<std::vector<int64_t>>& outputShapes() const { return mOutputShapes; }
+  int inputElementType() const { return mInputElementType; } ///< ONNXTensorElementDataType of the first input
+  int64_t getNFeatures() const { return mInputShapes[0].back(); }
+
+ private:
+  void fillLatency(const std::chrono::steady_clock::time_point& start)
+  {
+    const double latency = elapsedMilliseconds(start);
+    auto& counters = processCounters();
+    counters.onnxRuns++;
+    counters.onnxTime += latency;
+    if (mHistLatency) {
+      mHistLatency->Fill(1.e3 * latency);
+    }
+  }
+
+  std::string mPath;                                               ///< model file
+  std::unique_ptr<Ort::Experimental::Session> mSession;            ///< session of the model
+  std::vector<std::string> mInputNames;                            ///< input node names
+  std::vector<std::vector<int64_t>> mInputShapes;                  ///< input node shapes
+  std::vector<std::string> mOutputNames;                           ///< output node names
+  std::vector<std::vector<int64_t>> mOutputShapes;                 ///< output node shapes
+  int mInputElementType = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED; ///< data type of the first input
+  std::shared_ptr<TH1> mHistLatency = nullptr;                     ///< latency of the runs (us), optional
+};
+
+/// Process-wide registry owning the ONNX runtime environment and the sessions of all the models
+class OnnxSessionRegistry
+{
+ public:
+  static OnnxSessionRegistry& instance()
+  {
+    static OnnxSessionRegistry registry;
+    return registry;
+  }
+
+  OnnxSessionRegistry(const OnnxSessionRegistry&) = delete;
+  OnnxSessionRegistry& operator=(const OnnxSessionRegistry&) = delete;
+
+  /// Makes all sessions share one thread pool, to be called before the first model is loaded
+  /// \param nThreadsIntraOp  threads within an operator, 0: ONNX runtime default
+  /// \param nThreadsInterOp  threads across operators, 0: ONNX runtime default
+  void useGlobalThreadPool(int nThreadsIntraOp, int nThreadsInterOp)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEnv) {
+      LOG(warning) << "ONNX runtime environment already created, the global thread pool setting is ignored";
+      return;
+    }
+    mUseGlobalThreadPool = true;
+    mNThreadsIntraOpGlobal = nThreadsIntraOp;
+    mNThreadsInterOpGlobal = nThreadsInterOp;
+  }
+
+  /// Gets a model, loading it if it is not in the registry yet
+  /// \param path  ONNX model file
+  /// \param settings  session settings
+  /// \param reload  load the file again even if it is in the registry, e.g. after it was overwritten by a new download
+  /// \return model shared with the other clients using the same file and settings
+  std::shared_ptr<OnnxModel> getModel(const std::string& path, const OnnxSessionSettings& settings = {}, bool reload = false)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::string key = path + "|" + settings.key();
+    auto model = mModels.find(key);
+    if (model != mModels.end() && !reload) {
+      LOG(info) << "Reusing ONNX session for " << path;
+      return model->second;
+    }
+
+    Ort::SessionOptions sessionOptions;
+    if (settings.enableOptimization) {
+      sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+    }
+    if (mUseGlobalThreadPool) {
+      sessionOptions.DisablePerSessionThreads();
+    } else {
+      if (settings.nThreadsIntraOp > 0) {
+        sessionOptions.SetIntraOpNumThreads(settings.nThreadsIntraOp);
+      }
+      if (settings.nThreadsInterOp > 0) {
+        sessionOptions.SetInterOpNumThreads(settings.nThreadsInterOp);
+      }
+    }
+    appendExecutionProviders(sessionOptions, settings.executionProvider);
+
+    std::string loadedPath = path;
+    std::string optimizedPath, temporaryPath;
+    if (!settings.modelCacheDir.empty()) {
+      optimizedPath = getOptimizedModelPath(path, settings);
+      if (std::filesystem::exists(optimizedPath)) {
+        LOG(info) << "Using the optimised ONNX model " << optimizedPath << " of " << path;
+        loadedPath = optimizedPath;
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+      } else {
+        // the saved graph must not depend on the hardware of the job, the layout optimisations are not applied
+        temporaryPath = optimizedPath + "." + std::to_string(getpid()) + ".tmp";
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+        sessionOptions.SetOptimizedModelFilePath(temporaryPath.c_str());
+      }
+    }
+
+    LOG(info) << "Loading ONNX model " << loadedPath;
+    auto newModel = std::make_shared<OnnxModel>(getEnv(), loadedPath, sessionOptions);
+    if (!temporaryPath.empty() && std::rename(temporaryPath.c_str(), optimizedPath.c_str()) != 0) {
+      LOG(warning) << "Could not save the optimised ONNX model to " << optimizedPath;
+      std::remove(temporaryPath.c_str());
+    }
+    mModels[key] = newModel; // clients of a replaced model keep their own reference to it
+    return newModel;
+  }
+
+ private:
+  OnnxSessionRegistry() = default;
+
+  Ort::Env& getEnv()
+  {
+    if (!mEnv) {
+      if (mUseGlobalThreadPool) {
+        Ort::ThreadingOptions threadingOptions;
+        threadingOptions.SetGlobalIntraOpNumThreads(mNThreadsIntraOpGlobal);
+        threadingOptions.SetGlobalInterOpNumThreads(mNThreadsInterOpGlobal);
+        mEnv = std::make_unique<Ort::Env>(threadingOptions, ORT_LOGGING_LEVEL_WARNING, "o2physics-onnx");
+      } else {
+        mEnv = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "o2physics-onnx");
+      }
+    }
+    return *mEnv;
+  }
+
+  /// \return file of the optimised model in the cache, which changes with the model file and the session settings
+  static std::string getOptimizedModelPath(const std::string& path, const OnnxSessionSettings& settings)
+  {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(path, error);
+    const auto time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    const std::string configuration = path + "|" + std::to_string(size) + "|" + std::to_string(time) + "|" + settings.key();
+    std::filesystem::create_directories(settings.modelCacheDir, error);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.onnx", static_cast<unsigned long long>(configurationHash(configuration)));
+    return settings.modelCacheDir + "/" + name;
+  }
+
+  /// Appends the execution providers in order of priority, the CPU is always the fallback
+  static void appendExecutionProviders(Ort::SessionOptions& sessionOptions, int executionProvider)
+  {
+    try {
+      if (executionProvider == 2) {
+        OrtTensorRTProviderOptions trtOptions{};
+        sessionOptions.AppendExecutionProvider_TensorRT(trtOptions);
+        LOG(info) << "Using the TensorRT execution provider";
+      }
+      if (executionProvider == 1 || executionProvider == 2) {
+        OrtCUDAProviderOptions cudaOptions{};
+        sessionOptions.AppendExecutionProvider_CUDA(cudaOptions);
+        LOG(info) << "Using the CUDA execution provider";
+      }
+    } catch (const Ort::Exception& exception) {
+      LOG(warning) << "Requested execution provider is not available, falling back to CPU: " << exception.what();
+    }
+  }
+
+  std::unique_ptr<Ort::Env> mEnv = nullptr;                  ///< environment shared by all sessions
+  bool mUseGlobalThreadPool = false;                         ///< whether the sessions share the thread pool of the environment
+  int mNThreadsIntraOpGlobal = 0;                            ///< intra-op threads of the global thread pool
+  int mNThreadsInterOpGlobal = 0;                            ///< inter-op threads of the global thread pool
+  std::map<std::string, std::shared_ptr<OnnxModel>> mModels; ///< models by file and settings
+  std::mutex mMutex;                                         ///< protects the lazy creation of environment and models
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_ONNXSESSIONREGISTRY_H_
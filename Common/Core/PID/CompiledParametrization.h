@@ -0,0 +1,100 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CompiledParametrization.h
+/// \since  14/10/2026
+/// \brief  Parametrization of the PID response with the function and the number of parameters known at compile time.
+///         The parameters of a Parametrization (or of PidParameters) loaded from file or CCDB are copied once into a
+///         fixed-size array, and the response is then evaluated without virtual call nor access through the generic
+///         parameter container, for a single input or for a batch of inputs.
+///
+
+#ifndef O2_ANALYSIS_PID_COMPILEDPARAMETRIZATION_H_
+#define O2_ANALYSIS_PID_COMPILEDPARAMETRIZATION_H_
+
+#include <array>
+#include <cstddef>
+
+#include "Framework/Logger.h"
+#include "Common/Core/PID/ParamBase.h"
+
+namespace o2::pid
+{
+
+/// \brief Parametrization evaluating a fixed function with a fixed number of parameters
+/// \tparam TFunction Function of the parametrization, with the number of parameters in
+///         `static constexpr int nParameters` and the evaluation in `static pidvar_t evaluate(const P& parameters, const pidvar_t* x)`,
+///         shared with the Parametrization it replaces so that both give the same values
+template <typename TFunction>
+class CompiledParametrization
+{
+ public:
+  static constexpr int nParameters = TFunction::nParameters;
+
+  CompiledParametrization() = default;
+
+  /// Constructor from the values of the parameters
+  explicit CompiledParametrization(const std::array<pidvar_t, nParameters>& parameters) : mParameters(parameters) {}
+
+  /// Copies the parameters of a parametrization
+  /// \param parametrization Parametrization, expected to implement TFunction
+  /// \return false, keeping the current parameters, if the number of parameters is not nParameters
+  bool compile(const Parametrization& parametrization)
+  {
+    const Parameters parameters = parametrization.GetParameters();
+    if (parameters.size() != nParameters) {
+      LOG(warning) << "Cannot compile parametrization " << parametrization.GetName() << " with " << parameters.size() << " parameters instead of " << nParameters;
+      return false;
+    }
+    for (int i = 0; i < nParameters; i++) {
+      mParameters[i] = parameters[i];
+    }
+    return true;
+  }
+
+  /// Copies the parameters of a parameter container of the same size
+  void compile(const PidParameters<nParameters>& parameters)
+  {
+    for (int i = 0; i < nParameters; i++) {
+      mParameters[i] = parameters[i];
+    }
+  }
+
+  /// Getter for the value of the parametrization
+  /// \param x array of the variables of the parametrization
+  pidvar_t operator()(const pidvar_t* x) const { return TFunction::evaluate(mParameters, x); }
+
+  /// Batch evaluation
+  /// \param x variables of the n inputs, nVariables consecutive values per input
+  /// \param nVariables number of variables per input
+  /// \param n number of inputs
+  /// \param values output of the n values
+  void operator()(const pidvar_t* x, const std::size_t nVariables, const std::size_t n, pidvar_t* values) const
+  {
+    for (std::size_t i = 0; i < n; i++) {
+      values[i] = TFunction::evaluate(mParameters, x + i * nVariables);
+    }
+  }
+
+  /// Getter of the parameter at position i
+  pidvar_t operator[](const unsigned int i) const { return mParameters[i]; }
+
+  /// Getter for the parameters
+  const std::array<pidvar_t, nParameters>& GetParameters() const { return mParameters; }
+
+ private:
+  std::array<pidvar_t, nParameters> mParameters{}; ///< Parameters of the parametrization
+};
+
+} // namespace o2::pid
+
+#endif // O2_ANALYSIS_PID_COMPILEDPARAMETRIZATION_H_
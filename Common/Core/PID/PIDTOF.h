@@ -27,6 +27,7 @@
 #include "Framework/Logger.h"
 #include "ReconstructionDataFormats/PID.h"
 #include "Framework/DataTypes.h"
+#include "Common/Core/PID/CompiledParametrization.h"
 
 namespace o2::pid::tof
 {
@@ -199,6 +200,34 @@ class ExpTimes
   /// \param track Track of interest
   static float GetExpectedSigmaTracking(const DetectorResponse& response, const TrackType& track) { return GetExpectedSigma(response, track, GetExpectedSignal(track), 0.f); }
 
+  /// Gets the expected resolution of the t-texp-t0, same as with a DetectorResponse holding the parametrization it was compiled from
+  /// \param reso Compiled resolution parametrization, with the inputs of TOFReso
+  /// \param track Track of interest
+  /// \param tofSignal TOF signal of the track of interest
+  /// \param collisionTimeRes Collision time resolution of the track of interest
+  template <typename TFunction>
+  static float GetExpectedSigma(const CompiledParametrization<TFunction>& reso, const TrackType& track, const float tofSignal, const float collisionTimeRes)
+  {
+    if (!track.hasTOF()) {
+      return defaultReturnValue;
+    }
+    const float x[4] = {track.p(), tofSignal, collisionTimeRes, mMassZ};
+    const float value = reso(x);
+    return value >= 0.f ? value : 0.f;
+  }
+
+  /// Gets the expected resolution of the t-texp-t0
+  /// \param reso Compiled resolution parametrization
+  /// \param track Track of interest
+  template <typename TFunction>
+  static float GetExpectedSigma(const CompiledParametrization<TFunction>& reso, const TrackType& track) { return GetExpectedSigma(reso, track, track.tofSignal(), track.tofEvTime()); }
+
+  /// Gets the expected resolution of the time measurement, uses the expected time and no event time resolution
+  /// \param reso Compiled resolution parametrization
+  /// \param track Track of interest
+  template <typename TFunction>
+  static float GetExpectedSigmaTracking(const CompiledParametrization<TFunction>& reso, const TrackType& track) { return GetExpectedSigma(reso, track, GetExpectedSignal(track), 0.f); }
+
   /// Gets the separation between the measured signal and the expected one
   /// \param track Track of interest
   /// \param collisionTime Collision time
@@ -228,6 +257,20 @@ class ExpTimes
   /// \param track Track of interest
   static float GetSeparation(const TOFResoParams& parameters, const TrackType& track) { return GetSeparation(parameters, track, track.tofEvTime(), track.tofEvTimeErr()); }
 
+  /// Gets the number of sigmas with respect the expected time
+  /// \param reso Compiled resolution parametrization
+  /// \param track Track of interest
+  /// \param collisionTime Collision time
+  /// \param collisionTimeRes Collision time resolution of the track of interest
+  template <typename TFunction>
+  static float GetSeparation(const CompiledParametrization<TFunction>& reso, const TrackType& track, const float collisionTime, const float collisionTimeRes) { return track.hasTOF() ? GetDelta(track, collisionTime) / GetExpectedSigma(reso, track, track.tofSignal(), collisionTimeRes) : defaultReturnValue; }
+
+  /// Gets the number of sigmas with respect the expected time
+  /// \param reso Compiled resolution parametrization
+  /// \param track Track of interest
+  template <typename TFunction>
+  static float GetSeparation(const CompiledParametrization<TFunction>& reso, const TrackType& track) { return GetSeparation(reso, track, track.tofEvTime(), track.tofEvTimeErr()); }
+
   /// Gets the expected resolution of the measurement from the track time and from the collision time, explicitly passed as argument
   /// \param response Detector response with parameters
   /// \param track Track of interest
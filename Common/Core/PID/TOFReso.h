@@ -21,22 +21,24 @@
 
 // O2 includes
 #include "ReconstructionDataFormats/PID.h"
+#include "Common/Core/PID/CompiledParametrization.h"
 
 namespace o2::pid::tof
 {
 
-class TOFReso : public Parametrization
-{
- public:
-  TOFReso() : Parametrization("TOFReso", 5){};
-  ~TOFReso() override = default;
-  /// Operator to compute the expected value of the TOF Resolution
+/// Function of the TOF resolution parametrization, shared by TOFReso and its compiled form TOFResoCompiled
+struct TOFResoFunction {
+  static constexpr int nParameters = 5;
+
+  /// Computes the expected value of the TOF Resolution
+  /// \param parameters Parameters of the parametrization
   /// \param x Array with the input used to compute the response:
   /// x[0] -> track momentum
   /// x[1] -> TOF signal
   /// x[2] -> event time resolution
   /// x[3] -> particle mass
-  float operator()(const float* x) const override
+  template <typename ParametersType>
+  static float evaluate(const ParametersType& parameters, const float* x)
   {
     const float mom = abs(x[0]);
     if (mom <= 0) {
@@ -45,13 +47,25 @@ class TOFReso : public Parametrization
     const float time = x[1];
     const float evtimereso = x[2];
     const float mass = x[3];
-    const float dpp = mParameters[0] + mParameters[1] * mom + mParameters[2] * mass / mom; // mean relative pt resolution;
+    const float dpp = parameters[0] + parameters[1] * mom + parameters[2] * mass / mom; // mean relative pt resolution;
     const float sigma = dpp * time / (1. + mom * mom / (mass * mass));
-    return sqrt(sigma * sigma + mParameters[3] * mParameters[3] / mom / mom + mParameters[4] * mParameters[4] + evtimereso * evtimereso);
+    return sqrt(sigma * sigma + parameters[3] * parameters[3] / mom / mom + parameters[4] * parameters[4] + evtimereso * evtimereso);
   }
+};
+
+class TOFReso : public Parametrization
+{
+ public:
+  TOFReso() : Parametrization("TOFReso", TOFResoFunction::nParameters){};
+  ~TOFReso() override = default;
+  /// Operator to compute the expected value of the TOF Resolution, see TOFResoFunction
+  float operator()(const float* x) const override { return TOFResoFunction::evaluate(mParameters, x); }
   ClassDefOverride(TOFReso, 1);
 };
 
+/// TOF resolution parametrization evaluated without virtual call, compiled from a TOFReso object
+using TOFResoCompiled = CompiledParametrization<TOFResoFunction>;
+
 } // namespace o2::pid::tof
 
 #endif
@@ -0,0 +1,235 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TOFResponseLUT.h
+/// \since  14/10/2026
+/// \brief  Lookup table of the momentum dependent terms of the TOF expected times and resolutions.
+///         The track length and the TOF signal enter the response linearly and the other resolution
+///         terms are added in quadrature, so one table in momentum per mass hypothesis is enough.
+///         The momentum bin is found once per track and shared by all the mass hypotheses.
+///
+
+#ifndef O2_ANALYSIS_PID_TOFRESPONSELUT_H_
+#define O2_ANALYSIS_PID_TOFRESPONSELUT_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Framework/Logger.h"
+#include "ReconstructionDataFormats/PID.h"
+#include "PID/PIDTOF.h"
+
+namespace o2::pid::tof
+{
+
+/// \brief Tabulated TOF response for all the mass hypotheses, in bins uniform in log(p)
+class TOFResponseLUT
+{
+ public:
+  static constexpr int nSpecies = o2::track::PID::NIDs; ///< number of mass hypotheses
+  static constexpr int nParameters = 5;                 ///< number of parameters of TOFResoParams
+
+  /// Momentum bin with the linear interpolation weight of its upper edge, index < 0 if outside the table
+  struct Bin {
+    int index = -1;
+    float weight = 0.f;
+    bool isValid() const { return index >= 0; }
+  };
+
+  TOFResponseLUT() = default;
+  ~TOFResponseLUT() = default;
+
+  /// Fills the table
+  /// \param parameters Detector response parameters
+  /// \param nBins Number of bins, uniform in log(p)
+  /// \param pMin Lower edge of the table in GeV/c
+  /// \param pMax Upper edge of the table in GeV/c
+  void build(const TOFResoParams& parameters, const int nBins, const float pMin, const float pMax)
+  {
+    if (nBins < 1 || pMin <= 0.f || pMax <= pMin) {
+      LOG(fatal) << "Invalid binning of the TOF response table: " << nBins << " bins in [" << pMin << ", " << pMax << "] GeV/c";
+    }
+    mNBins = nBins;
+    mLogPMin = std::log(pMin);
+    mLogPMax = std::log(pMax);
+    mInvStep = nBins / (mLogPMax - mLogPMin);
+    for (int i = 0; i < nParameters; i++) {
+      mParameters[i] = parameters[i];
+    }
+    for (int id = 0; id < nSpecies; id++) {
+      mExpTimePerLength[id].resize(nBins + 1);
+      mSigmaPerSignal[id].resize(nBins + 1);
+      for (int i = 0; i <= nBins; i++) {
+        const float mom = std::exp(mLogPMin + i / mInvStep);
+        mExpTimePerLength[id][i] = computeExpTimePerLength(id, mom);
+        mSigmaPerSignal[id][i] = computeSigmaPerSignal(id, mom);
+      }
+    }
+    mIsBuilt = true;
+  }
+
+  /// Checks whether the table was filled with other parameters than the ones given
+  /// \param parameters Detector response parameters
+  bool needsRebuild(const TOFResoParams& parameters) const
+  {
+    if (!mIsBuilt) {
+      return true;
+    }
+    for (int i = 0; i < nParameters; i++) {
+      if (mParameters[i] != parameters[i]) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Computes the largest relative deviation of the interpolated terms from the analytic ones,
+  /// sampled at the bin centres where the linear interpolation is the least accurate
+  float validate() const
+  {
+    float maxDeviation = 0.f;
+    for (int i = 0; i < mNBins; i++) {
+      const float mom = std::exp(mLogPMin + (i + 0.5f) / mInvStep);
+      const Bin bin = findBin(mom);
+      for (int id = 0; id < nSpecies; id++) {
+        const float expTime = computeExpTimePerLength(id, mom);
+        const float sigma = computeSigmaPerSignal(id, mom);
+        maxDeviation = std::max(maxDeviation, std::abs(getExpTimePerLength(id, bin) / expTime - 1.f));
+        if (sigma != 0.f) {
+          maxDeviation = std::max(maxDeviation, std::abs(getSigmaPerSignal(id, bin) / sigma - 1.f));
+        }
+      }
+    }
+    return maxDeviation;
+  }
+
+  /// Finds the bin of a momentum, to be done once per track for all the mass hypotheses
+  /// \param mom Momentum in GeV/c
+  Bin findBin(const float mom) const
+  {
+    Bin bin;
+    if (mom <= 0.f) {
+      return bin;
+    }
+    const float x = (std::log(mom) - mLogPMin) * mInvStep;
+    if (x < 0.f || x >= mNBins) {
+      return bin;
+    }
+    bin.index = static_cast<int>(x);
+    bin.weight = x - bin.index;
+    return bin;
+  }
+
+  /// Inputs of a track shared by all the mass hypotheses
+  struct TrackInputs {
+    Bin binExpMom;                    ///< bin of the TOF expected momentum
+    Bin binMom;                       ///< bin of the track momentum
+    float length = 0.f;               ///< track length in cm
+    float tofSignal = 0.f;            ///< TOF signal in ps
+    float delta = 0.f;                ///< TOF signal minus collision time in ps
+    float massIndependentTerm2 = 0.f; ///< squared resolution terms not depending on the mass hypothesis
+    bool isValid() const { return binExpMom.isValid() && binMom.isValid(); }
+  };
+
+  /// Computes the inputs of a track, to be done once for all the mass hypotheses.
+  /// If the momenta are outside of the table the inputs are not valid and the analytic response should be used.
+  /// \param expMom TOF expected momentum in GeV/c
+  /// \param mom Momentum in GeV/c
+  /// \param length Track length in cm
+  /// \param tofSignal TOF signal in ps
+  /// \param collisionTime Collision time in ps
+  /// \param collisionTimeRes Collision time resolution in ps
+  TrackInputs getTrackInputs(const float expMom, const float mom, const float length, const float tofSignal, const float collisionTime, const float collisionTimeRes) const
+  {
+    TrackInputs inputs;
+    inputs.binExpMom = findBin(expMom);
+    inputs.binMom = findBin(mom);
+    if (!inputs.isValid()) {
+      return inputs;
+    }
+    inputs.length = length;
+    inputs.tofSignal = tofSignal;
+    inputs.delta = tofSignal - collisionTime;
+    inputs.massIndependentTerm2 = getMassIndependentTerm2(mom, collisionTimeRes);
+    return inputs;
+  }
+
+  /// Gets the number of sigmas with respect the expected time, same as ExpTimes::GetSeparation
+  /// \param id Mass hypothesis
+  /// \param inputs Valid inputs of the track of interest
+  float getSeparation(const int id, const TrackInputs& inputs) const
+  {
+    return (inputs.delta - getExpectedSignal(id, inputs.binExpMom, inputs.length)) / getExpectedSigma(id, inputs.binMom, inputs.tofSignal, inputs.massIndependentTerm2);
+  }
+
+  /// Gets the expected time of a track from the bin of its TOF expected momentum
+  /// \param id Mass hypothesis
+  /// \param binExpMom Bin of the TOF expected momentum
+  /// \param length Track length in cm
+  float getExpectedSignal(const int id, const Bin& binExpMom, const float length) const { return length * getExpTimePerLength(id, binExpMom); }
+
+  /// Gets the expected resolution of the t-texp-t0
+  /// \param id Mass hypothesis
+  /// \param binMom Bin of the track momentum
+  /// \param tofSignal TOF signal of the track
+  /// \param massIndependentTerm2 Squared resolution terms not depending on the mass hypothesis, see getMassIndependentTerm2
+  float getExpectedSigma(const int id, const Bin& binMom, const float tofSignal, const float massIndependentTerm2) const
+  {
+    const float sigma = getSigmaPerSignal(id, binMom) * tofSignal;
+    return std::sqrt(sigma * sigma + massIndependentTerm2);
+  }
+
+  /// Gets the squared resolution terms not depending on the mass hypothesis, to be computed once per track
+  /// \param mom Momentum in GeV/c
+  /// \param collisionTimeRes Collision time resolution of the track
+  float getMassIndependentTerm2(const float mom, const float collisionTimeRes) const
+  {
+    return mParameters[3] * mParameters[3] / mom / mom + mParameters[4] * mParameters[4] + collisionTimeRes * collisionTimeRes;
+  }
+
+  bool isBuilt() const { return mIsBuilt; }
+
+ private:
+  float interpolate(const std::vector<float>& values, const Bin& bin) const { return values[bin.index] + bin.weight * (values[bin.index + 1] - values[bin.index]); }
+  float getExpTimePerLength(const int id, const Bin& bin) const { return interpolate(mExpTimePerLength[id], bin); }
+  float getSigmaPerSignal(const int id, const Bin& bin) const { return interpolate(mSigmaPerSignal[id], bin); }
+
+  /// Same as ExpTimes::ComputeExpectedTime for a unit length
+  static float computeExpTimePerLength(const int id, const float mom)
+  {
+    const float massZ = o2::track::pid_constants::sMasses2Z[id];
+    return std::sqrt(massZ * massZ + mom * mom) / (kCSPEED * mom);
+  }
+
+  /// Same as the momentum dependent term of ExpTimes::GetExpectedSigma for a unit TOF signal
+  float computeSigmaPerSignal(const int id, const float mom) const
+  {
+    const float massZ = o2::track::pid_constants::sMasses2Z[id];
+    const float dpp = mParameters[0] + mParameters[1] * mom + mParameters[2] * massZ / mom;
+    return dpp / (1.f + mom * mom / (massZ * massZ));
+  }
+
+  bool mIsBuilt = false;                                      ///< whether the table was filled
+  int mNBins = 0;                                             ///< number of bins
+  float mLogPMin = 0.f;                                       ///< log of the lower edge
+  float mLogPMax = 0.f;                                       ///< log of the upper edge
+  float mInvStep = 0.f;                                       ///< inverse of the bin width in log(p)
+  std::array<float, nParameters> mParameters{};               ///< parameters the table was filled with
+  std::array<std::vector<float>, nSpecies> mExpTimePerLength; ///< expected time per unit length (ps/cm) at the bin edges
+  std::array<std::vector<float>, nSpecies> mSigmaPerSignal;   ///< momentum dependent resolution per unit TOF signal at the bin edges
+};
+
+} // namespace o2::pid::tof
+
+#endif // O2_ANALYSIS_PID_TOFRESPONSELUT_H_
@@ -20,6 +20,8 @@
 #include <array>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include "Framework/Logger.h"
 // O2 includes
 #include "ReconstructionDataFormats/PID.h"
@@ -29,6 +31,56 @@
 namespace o2::pid::tpc
 {
 
+/// Approximations of log2, exp2 and pow for the batch evaluation of the response, without branches so that the loops can be vectorized.
+/// The relative deviation from the float functions of std is below 5e-6 for normal positive arguments and exponents in [-126, 127].
+namespace fastmath
+{
+inline float log2(const float x)
+{
+  int32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  int32_t exponent = ((bits >> 23) & 0xff) - 127;
+  bits = (bits & 0x007fffff) | 0x3f800000; // Mantissa in [1, 2)
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+  const int32_t high = m > 1.41421356f; // Mantissa moved to [sqrt(1/2), sqrt(2)) for the convergence of the series
+  m = m * (1.f - 0.5f * high);
+  exponent += high;
+  // log(m) = 2 atanh(t), |t| < 0.172
+  const float t = (m - 1.f) / (m + 1.f);
+  const float t2 = t * t;
+  const float logm = 2.f * t * (1.f + t2 * (1.f / 3.f + t2 * (1.f / 5.f + t2 * (1.f / 7.f + t2 * (1.f / 9.f)))));
+  return static_cast<float>(exponent) + logm * 1.44269504f;
+}
+
+inline float exp2(float y)
+{
+  const float below = y < -126.f;
+  const float above = y > 127.f;
+  y = y * (1.f - below - above) - 126.f * below + 127.f * above;
+  const int32_t exponent = static_cast<int32_t>(y + 127.5f); // Argument positive: the truncation is the rounding of y + 127
+  // 2^f = exp(f log2), |f log2| < 0.347
+  const float z = (y - static_cast<float>(exponent - 127)) * 0.693147181f;
+  const float poly = 1.f + z * (1.f + z * (1.f / 2.f + z * (1.f / 6.f + z * (1.f / 24.f + z * (1.f / 120.f + z * (1.f / 720.f))))));
+  const int32_t bits = exponent << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return poly * scale;
+}
+
+inline float pow(const float x, const float a) { return exp2(a * log2(x)); }
+
+inline float log(const float x) { return 0.693147181f * log2(x); }
+
+/// Bethe-Bloch parametrization of o2::tpc::BetheBlochAleph, with beta^kp4 computed as (1 + 1/bg^2)^(-kp4/2)
+inline float betheBlochAleph(const float bg, const std::array<float, 5>& kp)
+{
+  const float aa = exp2(-0.5f * kp[3] * log2(1.f + 1.f / (bg * bg)));
+  const float bb = log(kp[2] + exp2(-kp[4] * log2(bg)));
+  return (kp[1] - aa - bb) * kp[0] / aa;
+}
+} // namespace fastmath
+
 /// \brief Class to handle the TPC PID response
 
 class Response
@@ -83,6 +135,24 @@ class Response
   /// Gets relative dEdx resolution contribution due to relative pt resolution
   float GetRelativeResolutiondEdx(const float p, const float mass, const float charge, const float resol) const;
 
+  /// Track quantities for the batch evaluation of the response, one entry per track in each array.
+  /// The tracks without TPC are not flagged: their values have to be ignored by the caller
+  struct TrackBatch {
+    const float* tpcInnerParam = nullptr; /// Momentum at the inner wall of the TPC
+    const float* tpcSignal = nullptr;     /// TPC dE/dx
+    const float* tpcNClsFound = nullptr;  /// Number of found TPC clusters
+    const float* tgl = nullptr;           /// Tangent of the dip angle, only for the non default resolution
+    const float* signed1Pt = nullptr;     /// Charge over pt, only for the non default resolution
+    const float* multTPC = nullptr;       /// TPC multiplicity of the collision of the track, only for the non default resolution
+    std::size_t size = 0;
+  };
+  /// Batch versions of GetExpectedSignal, GetExpectedSigma and GetNumberOfSigma for one mass hypothesis: the output arrays have tracks.size entries.
+  /// They use the approximations of fastmath: for betagamma > 0.05 the relative deviation from the single track functions is below 1e-5
+  /// for the expected signal and the default resolution, below 2e-4 for the non default resolution
+  void GetExpectedSignals(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSignal) const;
+  void GetExpectedSigmas(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSigma) const;
+  void GetNumberOfSigmas(const TrackBatch& tracks, const o2::track::PID::ID id, float* nSigma) const;
+
   void PrintAll() const;
 
  private:
@@ -95,6 +165,8 @@ class Response
   bool mUseDefaultResolutionParam = true;
   float nClNorm = 152.f;
 
+  void EvaluateBatch(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSignal, float* expSigma) const;
+
   ClassDefNV(Response, 3);
 
 }; // class Response
@@ -179,6 +251,76 @@ inline float Response::GetRelativeResolutiondEdx(const float p, const float mass
   return deltaRel;
 }
 
+/// Batch evaluation, the expected signal is computed only if expSignal is not null and the expected sigma only if expSigma is not null
+inline void Response::EvaluateBatch(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSignal, float* expSigma) const
+{
+  const float invMass = 1.f / o2::track::pid_constants::sMasses[id];
+  const float chargeFactor = std::pow((float)o2::track::pid_constants::sCharges[id], mChargeFactor);
+  if (expSignal) {
+    for (std::size_t i = 0; i < tracks.size; i++) {
+      const float bethe = mMIP * fastmath::betheBlochAleph(tracks.tpcInnerParam[i] * invMass, mBetheBlochParams) * chargeFactor;
+      expSignal[i] = bethe >= 0.f ? bethe : -999.f;
+    }
+  }
+  if (!expSigma) {
+    return;
+  }
+  if (mUseDefaultResolutionParam) {
+    for (std::size_t i = 0; i < tracks.size; i++) {
+      const float ncl = tracks.tpcNClsFound[i];
+      const float reso = tracks.tpcSignal[i] * mResolutionParamsDefault[0] * (ncl > 0.f ? std::sqrt(1.f + mResolutionParamsDefault[1] / ncl) : 1.f);
+      expSigma[i] = reso >= 0.f ? reso : -999.f;
+    }
+    return;
+  }
+  std::array<float, 8> resoParams;
+  for (std::size_t k = 0; k < resoParams.size(); k++) {
+    resoParams[k] = mResolutionParams[k];
+  }
+  const float res0Squared = resoParams[0] * resoParams[0];
+  const float res1Squared = resoParams[1] * resoParams[1];
+  const float invMultNormalization = 1.f / mMultNormalization;
+  for (std::size_t i = 0; i < tracks.size; i++) {
+    const float bg = tracks.tpcInnerParam[i] * invMass;
+    const float dEdx = fastmath::betheBlochAleph(bg, mBetheBlochParams) * chargeFactor;
+    // Relative resolution due to the relative momentum resolution, as in GetRelativeResolutiondEdx
+    const float deltaP = resoParams[3] * std::sqrt(dEdx);
+    const float dEdx2 = fastmath::betheBlochAleph(bg * (1.f + deltaP), mBetheBlochParams) * chargeFactor;
+    const float relReso = std::abs(dEdx2 - dEdx) / dEdx;
+
+    const float invdEdx = 1.f / dEdx;
+    const float sqrtNcl = std::sqrt(nClNorm / tracks.tpcNClsFound[i]);
+    const float logInvdEdxTgl = fastmath::log2(invdEdx) - 0.5f * fastmath::log2(1.f + tracks.tgl[i] * tracks.tgl[i]); // log2(1 / dEdx / sqrt(1 + tgl^2))
+    const float invdEdxTgl = fastmath::exp2(logInvdEdxTgl);
+    const float mult = tracks.multTPC[i] * invMultNormalization;
+    const float term4 = resoParams[4] * tracks.signed1Pt[i];
+    const float term5 = mult * resoParams[6];
+    const float term6 = mult * invdEdxTgl * resoParams[7];
+    const float reso = std::sqrt(res0Squared * invdEdx + res1Squared * (sqrtNcl * resoParams[5]) * fastmath::exp2(resoParams[2] * logInvdEdxTgl) + sqrtNcl * relReso * relReso + term4 * term4 + term5 * term5 + term6 * term6) * dEdx * mMIP;
+    expSigma[i] = reso >= 0.f ? reso : -999.f;
+  }
+}
+
+inline void Response::GetExpectedSignals(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSignal) const
+{
+  EvaluateBatch(tracks, id, expSignal, nullptr);
+}
+
+inline void Response::GetExpectedSigmas(const TrackBatch& tracks, const o2::track::PID::ID id, float* expSigma) const
+{
+  EvaluateBatch(tracks, id, nullptr, expSigma);
+}
+
+inline void Response::GetNumberOfSigmas(const TrackBatch& tracks, const o2::track::PID::ID id, float* nSigma) const
+{
+  std::vector<float> expSignal(tracks.size);
+  EvaluateBatch(tracks, id, expSignal.data(), nSigma);
+  for (std::size_t i = 0; i < tracks.size; i++) {
+    const bool isValid = expSignal[i] >= 0.f && nSigma[i] >= 0.f;
+    nSigma[i] = isValid ? (tracks.tpcSignal[i] - expSignal[i]) / nSigma[i] : -999.f;
+  }
+}
+
 inline void Response::PrintAll() const
 {
   LOGP(info, "==== TPC PID response parameters: ====");
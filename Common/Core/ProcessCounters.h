@@ -0,0 +1,52 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ProcessCounters.h
+/// \brief Counters of the current thread updated by the shared helpers (CCDB caches, ONNX models, allocations)
+///
+/// The counters only grow: the ProcessTimer scopes attribute to a process function the difference between their
+/// values at the end and at the beginning of its calls. They are plain thread-local values, so that updating them
+/// costs no synchronisation; the work done by other threads (e.g. the workers of the ThreadPool) is not attributed.
+
+#ifndef O2PHYSICS_COMMON_CORE_PROCESSCOUNTERS_H_
+#define O2PHYSICS_COMMON_CORE_PROCESSCOUNTERS_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace o2::analysis
+{
+
+struct ProcessCounters {
+  std::uint64_t allocations = 0;    ///< allocations, counted if O2PHYSICS_PROCESSTIMER_COUNT_ALLOCATIONS is defined
+  std::uint64_t allocatedBytes = 0; ///< bytes requested by the allocations
+  std::uint64_t ccdbFetches = 0;    ///< objects retrieved from CCDB
+  double ccdbTime = 0.;             ///< wall time of the CCDB retrievals (ms)
+  std::uint64_t onnxRuns = 0;       ///< ONNX inference calls
+  double onnxTime = 0.;             ///< wall time of the ONNX inference calls (ms)
+};
+
+/// \return counters of the current thread
+inline ProcessCounters& processCounters()
+{
+  static thread_local ProcessCounters counters;
+  return counters;
+}
+
+/// \return wall time since start (ms)
+inline double elapsedMilliseconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_PROCESSCOUNTERS_H_
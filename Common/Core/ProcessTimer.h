@@ -0,0 +1,319 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ProcessTimer.h
+/// \brief Opt-in wall time, call, row and allocation counters of the process functions of a task
+///
+/// A task declares one ProcessTimer, calls init() with the names of its process functions when the timing is enabled
+/// and opens a scope at the beginning of each process function:
+///   auto scope = timer.measure(kProcessWSlice, tracks.size());
+/// The totals of each function are filled in histograms of the task registry (written to AnalysisResults) and
+/// printed at the end of the job; the wall time of each data frame is filled in a distribution per function.
+/// Without init() the scopes do nothing.
+///
+/// The allocations are counted if O2PHYSICS_PROCESSTIMER_COUNT_ALLOCATIONS is defined before including this header,
+/// which then replaces the global operator new: define it in a single translation unit of the workflow.
+///
+/// The standard metrics of each function (see Metrics: rows, wall and CPU time, allocations, CCDB retrievals and ONNX
+/// inferences done in its calls, peak memory of the process) are also filled in the histogram ProcessTimer/metrics, and
+/// written at the end of the job to a JSON file if setMetricsFile() was called or O2PHYSICS_METRICS_DIR is set, to
+/// <dir>/<name>.<pid>.metrics.json. Scripts/aggregate_task_metrics.py merges these files into a report of the train.
+/// The peak memory is a maximum: in merged AnalysisResults files its bins are summed, use the JSON files for it.
+
+#ifndef O2PHYSICS_COMMON_CORE_PROCESSTIMER_H_
+#define O2PHYSICS_COMMON_CORE_PROCESSTIMER_H_
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <TH1.h>
+#include <TH2.h>
+
+#include "Framework/HistogramRegistry.h"
+#include "Framework/Logger.h"
+#include "Common/Core/ProcessCounters.h"
+
+namespace o2::analysis
+{
+
+/// Number of allocations of the current thread since its start, zero if they are not counted
+inline std::uint64_t& processTimerAllocations()
+{
+  return processCounters().allocations;
+}
+
+/// \return CPU time of the current thread (ms)
+inline double threadCpuTime()
+{
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return 1.e3 * time.tv_sec + 1.e-6 * time.tv_nsec;
+}
+
+/// \return peak resident memory of the process (kB)
+inline double peakResidentMemory()
+{
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024.; // bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/// Timing of the process functions of a task
+class ProcessTimer
+{
+ public:
+  /// Measurement of one call, the totals are updated when it goes out of scope
+  class Scope
+  {
+   public:
+    Scope(ProcessTimer* timer, int function, std::size_t rows) : mTimer(timer), mFunction(function), mRows(rows)
+    {
+      if (mTimer) {
+        mCounters = processCounters();
+        mCpuStart = threadCpuTime();
+        mStart = std::chrono::steady_clock::now();
+      }
+    }
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+    ~Scope()
+    {
+      if (mTimer) {
+        const double elapsed = elapsedMilliseconds(mStart);
+        const double cpuTime = threadCpuTime() - mCpuStart;
+        auto const& counters = processCounters();
+        Totals call;
+        call.calls = 1;
+        call.time = elapsed;
+        call.cpuTime = cpuTime;
+        call.rows = mRows;
+        call.allocations = counters.allocations - mCounters.allocations;
+        call.allocatedBytes = counters.allocatedBytes - mCounters.allocatedBytes;
+        call.ccdbFetches = counters.ccdbFetches - mCounters.ccdbFetches;
+        call.ccdbTime = counters.ccdbTime - mCounters.ccdbTime;
+        call.onnxRuns = counters.onnxRuns - mCounters.onnxRuns;
+        call.onnxTime = counters.onnxTime - mCounters.onnxTime;
+        mTimer->record(mFunction, call);
+      }
+    }
+
+   private:
+    ProcessTimer* mTimer = nullptr; ///< null if the timing is disabled
+    int mFunction = 0;
+    std::size_t mRows = 0;
+    ProcessCounters mCounters{}; ///< counters of the thread at the start
+    double mCpuStart = 0.;
+    std::chrono::steady_clock::time_point mStart{};
+  };
+
+  /// Standard metrics, in the order of the bins of ProcessTimer/metrics and with the names of the JSON file
+  enum Metrics { kCalls = 0,
+                 kRows,
+                 kWallTime,
+                 kCpuTime,
+                 kAllocations,
+                 kAllocatedBytes,
+                 kCcdbFetches,
+                 kCcdbTime,
+                 kOnnxRuns,
+                 kOnnxTime,
+                 kPeakMemory,
+                 kNMetrics };
+  static constexpr const char* MetricNames[kNMetrics] = {"calls", "rows", "wallTimeMs", "cpuTimeMs", "allocations", "allocatedBytes",
+                                                         "ccdbFetches", "ccdbTimeMs", "onnxRuns", "onnxTimeMs", "peakMemoryKB"};
+
+  ~ProcessTimer()
+  {
+    printSummary();
+    writeMetrics();
+  }
+
+  /// Enables the timing and creates its histograms
+  /// \param registry  histogram registry of the task
+  /// \param functions  names of the process functions, in the order of the indices passed to measure()
+  /// \param name  name of the timer in the summary
+  void init(o2::framework::HistogramRegistry& registry, std::vector<std::string> const& functions, std::string const& name)
+  {
+    using o2::framework::HistType;
+    mName = name;
+    mTotals.assign(functions.size(), Totals{});
+    mFunctions = functions;
+    const int nFunctions = functions.size();
+    const o2::framework::AxisSpec functionAxis{nFunctions, -0.5, nFunctions - 0.5, ""};
+    mCalls = registry.add<TH1>("ProcessTimer/calls", "Calls of the process functions;;calls", HistType::kTH1D, {functionAxis});
+    mTime = registry.add<TH1>("ProcessTimer/time", "Wall time of the process functions;;wall time (ms)", HistType::kTH1D, {functionAxis});
+    mRows = registry.add<TH1>("ProcessTimer/rows", "Rows processed by the process functions;;rows", HistType::kTH1D, {functionAxis});
+    mAllocations = registry.add<TH1>("ProcessTimer/allocations", "Allocations of the process functions;;allocations", HistType::kTH1D, {functionAxis});
+    // logarithmic time binning from 1 us to 100 s
+    std::vector<double> timeBins;
+    for (int i = 0; i <= 80; i++) {
+      timeBins.push_back(std::pow(10., -3. + i / 10.));
+    }
+    mTimePerDF = registry.add<TH2>("ProcessTimer/timePerDF", "Wall time per data frame;;wall time (ms)", HistType::kTH2D, {functionAxis, {timeBins, ""}});
+    mMetrics = registry.add<TH2>("ProcessTimer/metrics", "Metrics of the process functions;;", HistType::kTH2D, {functionAxis, {kNMetrics, -0.5, kNMetrics - 0.5, ""}});
+    for (int i = 0; i < nFunctions; i++) {
+      for (auto* axis : {mCalls->GetXaxis(), mTime->GetXaxis(), mRows->GetXaxis(), mAllocations->GetXaxis(), mTimePerDF->GetXaxis(), mMetrics->GetXaxis()}) {
+        axis->SetBinLabel(i + 1, functions[i].c_str());
+      }
+    }
+    for (int i = 0; i < kNMetrics; i++) {
+      mMetrics->GetYaxis()->SetBinLabel(i + 1, MetricNames[i]);
+    }
+    if (const char* directory = std::getenv("O2PHYSICS_METRICS_DIR"); directory != nullptr && mMetricsFile.empty()) {
+      mMetricsFile = std::string(directory) + "/" + name + "." + std::to_string(getpid()) + ".metrics.json";
+    }
+  }
+
+  /// Writes the metrics to a JSON file at the end of the job, in place of the one given by O2PHYSICS_METRICS_DIR
+  void setMetricsFile(std::string const& file) { mMetricsFile = file; }
+
+  /// \return true if init() was called
+  bool isEnabled() const { return !mTotals.empty(); }
+
+  /// Starts the measurement of one call of a process function
+  /// \param function  index of the function in the names given to init()
+  /// \param rows  number of rows processed by the call (e.g. tracks in the data frame)
+  Scope measure(int function, std::size_t rows = 0) { return Scope(isEnabled() ? this : nullptr, function, rows); }
+
+  /// Prints the totals of the functions which were called, done at the end of the job
+  void printSummary() const
+  {
+    for (std::size_t i = 0; i < mTotals.size(); i++) {
+      const auto& totals = mTotals[i];
+      if (totals.calls == 0) {
+        continue;
+      }
+      LOGF(info, "[%s] %s: %llu calls, %.1f ms (%.3f ms per call, %.3f us per row), %.1f ms CPU, %llu rows, %llu allocations", mName, mFunctions[i], totals.calls, totals.time, totals.time / totals.calls,
+           totals.rows > 0 ? 1.e3 * totals.time / totals.rows : 0., totals.cpuTime, totals.rows, totals.allocations);
+    }
+  }
+
+  /// Writes the metrics of the functions to the JSON file, if any
+  void writeMetrics() const
+  {
+    if (mMetricsFile.empty() || !isEnabled()) {
+      return;
+    }
+    std::ofstream output(mMetricsFile);
+    if (!output) {
+      LOGF(warning, "[%s] Could not write the metrics to %s", mName, mMetricsFile);
+      return;
+    }
+    output.precision(15);
+    output << "{\n  \"task\": \"" << mName << "\",\n  \"" << MetricNames[kPeakMemory] << "\": " << peakResidentMemory() << ",\n  \"functions\": {";
+    for (std::size_t i = 0; i < mTotals.size(); i++) {
+      const auto values = mTotals[i].values();
+      output << (i == 0 ? "" : ",") << "\n    \"" << mFunctions[i] << "\": {";
+      for (int metric = 0; metric < kPeakMemory; metric++) {
+        output << (metric == 0 ? "" : ", ") << "\"" << MetricNames[metric] << "\": " << values[metric];
+      }
+      output << "}";
+    }
+    output << "\n  }\n}\n";
+  }
+
+ private:
+  struct Totals {
+    unsigned long long calls = 0;
+    double time = 0.;    ///< wall time (ms)
+    double cpuTime = 0.; ///< CPU time of the calling thread (ms)
+    unsigned long long rows = 0;
+    unsigned long long allocations = 0;
+    unsigned long long allocatedBytes = 0;
+    unsigned long long ccdbFetches = 0;
+    double ccdbTime = 0.; ///< ms
+    unsigned long long onnxRuns = 0;
+    double onnxTime = 0.; ///< ms
+
+    /// \return metrics, in the order of Metrics, without the peak memory
+    std::array<double, kPeakMemory> values() const
+    {
+      return {static_cast<double>(calls), static_cast<double>(rows), time, cpuTime, static_cast<double>(allocations), static_cast<double>(allocatedBytes),
+              static_cast<double>(ccdbFetches), ccdbTime, static_cast<double>(onnxRuns), onnxTime};
+    }
+  };
+
+  void record(int function, Totals const& call)
+  {
+    auto& totals = mTotals[function];
+    totals.calls++;
+    totals.time += call.time;
+    totals.cpuTime += call.cpuTime;
+    totals.rows += call.rows;
+    totals.allocations += call.allocations;
+    totals.allocatedBytes += call.allocatedBytes;
+    totals.ccdbFetches += call.ccdbFetches;
+    totals.ccdbTime += call.ccdbTime;
+    totals.onnxRuns += call.onnxRuns;
+    totals.onnxTime += call.onnxTime;
+    mCalls->Fill(function);
+    mTime->Fill(function, call.time);
+    mRows->Fill(function, call.rows);
+    mAllocations->Fill(function, call.allocations);
+    mTimePerDF->Fill(function, call.time);
+    const auto values = call.values();
+    for (int metric = 0; metric < kPeakMemory; metric++) {
+      if (values[metric] != 0.) {
+        mMetrics->Fill(function, metric, values[metric]);
+      }
+    }
+    const double peakMemory = peakResidentMemory();
+    mMetrics->SetBinContent(function + 1, kPeakMemory + 1, std::max(peakMemory, mMetrics->GetBinContent(function + 1, kPeakMemory + 1)));
+  }
+
+  std::string mName{};
+  std::vector<std::string> mFunctions{};
+  std::vector<Totals> mTotals{}; ///< empty if the timing is disabled
+  std::shared_ptr<TH1> mCalls = nullptr;
+  std::shared_ptr<TH1> mTime = nullptr;
+  std::shared_ptr<TH1> mRows = nullptr;
+  std::shared_ptr<TH1> mAllocations = nullptr;
+  std::shared_ptr<TH2> mTimePerDF = nullptr;
+  std::shared_ptr<TH2> mMetrics = nullptr;
+  std::string mMetricsFile{}; ///< JSON file of the metrics, empty: not written
+};
+
+} // namespace o2::analysis
+
+#ifdef O2PHYSICS_PROCESSTIMER_COUNT_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+  auto& counters = o2::analysis::processCounters();
+  ++counters.allocations;
+  counters.allocatedBytes += size;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+#endif
+
+#endif // O2PHYSICS_COMMON_CORE_PROCESSTIMER_H_
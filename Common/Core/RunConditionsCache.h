@@ -0,0 +1,199 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file RunConditionsCache.h
+/// \brief Per run magnetic field, mean vertex, material LUT and geometry shared by the tasks of a process
+///
+/// The GRP (or GRPMagField), the mean vertex and the magnetic field of the propagator are set up once per run
+/// and per process, whichever task sees the run first. The material LUT and the geometry are loaded once per process.
+/// Tasks call update(bc) outside of their hot loops and get a callback when the run changes.
+
+#ifndef O2PHYSICS_COMMON_CORE_RUNCONDITIONSCACHE_H_
+#define O2PHYSICS_COMMON_CORE_RUNCONDITIONSCACHE_H_
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "CCDB/BasicCCDBManager.h"
+#include "DataFormatsCalibration/MeanVertexObject.h"
+#include "DataFormatsParameters/GRPMagField.h"
+#include "DataFormatsParameters/GRPObject.h"
+#include "DetectorsBase/GeometryManager.h"
+#include "DetectorsBase/MatLayerCylSet.h"
+#include "DetectorsBase/Propagator.h"
+#include "Framework/Logger.h"
+#include "Common/Core/ProcessCounters.h"
+
+namespace o2::analysis
+{
+
+/// CCDB paths and objects to load
+struct RunConditionsSettings {
+  std::string grpPath = "GLO/GRP/GRP";                 ///< GRPObject, tried first
+  std::string grpmagPath = "GLO/Config/GRPMagField";   ///< GRPMagField, used if there is no GRPObject
+  std::string meanVertexPath = "GLO/Calib/MeanVertex"; ///< mean vertex
+  std::string lutPath = "GLO/Param/MatLUT";            ///< material LUT
+  std::string geoPath = "GLO/Config/GeometryAligned";  ///< geometry
+  bool useGRPObject = true;                            ///< try the GRPObject before the GRPMagField
+  bool loadMeanVertex = false;                         ///< fetch the mean vertex of each run
+  bool loadMatLUT = true;                              ///< load the material LUT and attach it to the propagator
+  bool loadGeometry = true;                            ///< load the geometry if not already loaded
+};
+
+/// Conditions of one run, the objects are copies owned by the store, the CCDB manager keeping only the last one of each path
+struct RunConditions {
+  int runNumber = -1;
+  float bz = 0.f;                                                      ///< nominal magnetic field (kG)
+  std::shared_ptr<const o2::parameters::GRPObject> grpo;               ///< null if the field was taken from the GRPMagField
+  std::shared_ptr<const o2::parameters::GRPMagField> grpmag;           ///< null if the field was taken from the GRPObject
+  std::shared_ptr<const o2::dataformats::MeanVertexObject> meanVertex; ///< null unless loadMeanVertex is set
+};
+
+/// Run conditions of a task, backed by a store shared by all the tasks of the process
+class RunConditionsCache
+{
+ public:
+  /// Configures the cache and loads the run independent objects, to be called once, e.g. in init()
+  /// \param ccdb  CCDB manager of the task, its cache is used for the CCDB accesses
+  /// \param settings  paths and objects to load
+  void init(o2::ccdb::BasicCCDBManager* ccdb, RunConditionsSettings const& settings = {})
+  {
+    mCCDB = ccdb;
+    mSettings = settings;
+    if (mSettings.loadMatLUT && lut() == nullptr) {
+      lut() = o2::base::MatLayerCylSet::rectifyPtrFromFile(mCCDB->get<o2::base::MatLayerCylSet>(mSettings.lutPath));
+    }
+    if (mSettings.loadGeometry && !o2::base::GeometryManager::isGeometryLoaded()) {
+      mCCDB->get<TGeoManager>(mSettings.geoPath);
+    }
+  }
+
+  /// Sets a function called with the new conditions each time the run changes
+  void setRunChangeCallback(std::function<void(RunConditions const&)> callback) { mCallback = std::move(callback); }
+
+  /// Sets up the conditions of the run of a bunch crossing if it differs from the current one
+  /// \param bc  bunch crossing with timestamp
+  /// \return true if the run changed
+  template <typename TBC>
+  bool update(TBC const& bc)
+  {
+    if (bc.runNumber() == mConditions.runNumber) {
+      return false;
+    }
+    auto found = store().find(bc.runNumber());
+    if (found == store().end()) {
+      found = store().emplace(bc.runNumber(), fetch(bc.runNumber(), bc.timestamp())).first;
+    } else if (mSettings.loadMeanVertex && found->second.meanVertex == nullptr) {
+      // the run was set up by a task not using the mean vertex
+      found->second.meanVertex = fetchMeanVertex(bc.runNumber(), bc.timestamp());
+    }
+    mConditions = found->second;
+    // the propagator is a process-wide singleton, its field is only reset when the run changes
+    if (fieldRun() != mConditions.runNumber) {
+      if (mConditions.grpo != nullptr) {
+        o2::base::Propagator::initFieldFromGRP(mConditions.grpo.get());
+      } else {
+        o2::base::Propagator::initFieldFromGRP(mConditions.grpmag.get());
+      }
+      if (lut() != nullptr) {
+        o2::base::Propagator::Instance()->setMatLUT(lut());
+      }
+      fieldRun() = mConditions.runNumber;
+    }
+    if (mCallback) {
+      mCallback(mConditions);
+    }
+    return true;
+  }
+
+  RunConditions const& get() const { return mConditions; }
+  int runNumber() const { return mConditions.runNumber; }
+  float getBz() const { return mConditions.bz; }
+  const o2::dataformats::MeanVertexObject* getMeanVertex() const { return mConditions.meanVertex.get(); }
+  o2::base::MatLayerCylSet* getMatLUT() const { return lut(); }
+
+ private:
+  RunConditions fetch(int runNumber, uint64_t timestamp)
+  {
+    RunConditions conditions;
+    conditions.runNumber = runNumber;
+    const o2::parameters::GRPObject* grpo = nullptr;
+    if (mSettings.useGRPObject) {
+      grpo = getForTimeStamp<o2::parameters::GRPObject>(mSettings.grpPath, timestamp);
+    }
+    if (grpo != nullptr) {
+      conditions.grpo = std::make_shared<const o2::parameters::GRPObject>(*grpo);
+      conditions.bz = grpo->getNominalL3Field();
+    } else {
+      auto grpmag = getForTimeStamp<o2::parameters::GRPMagField>(mSettings.grpmagPath, timestamp);
+      if (grpmag == nullptr) {
+        LOGF(fatal, "Neither GRPObject (%s) nor GRPMagField (%s) available in CCDB for run %d at timestamp %llu", mSettings.grpPath.data(), mSettings.grpmagPath.data(), runNumber, static_cast<unsigned long long>(timestamp));
+      }
+      conditions.grpmag = std::make_shared<const o2::parameters::GRPMagField>(*grpmag);
+      conditions.bz = grpmag->getNominalL3Field();
+    }
+    if (mSettings.loadMeanVertex) {
+      conditions.meanVertex = fetchMeanVertex(runNumber, timestamp);
+    }
+    LOGF(info, "Run %d: magnetic field of %f kG from its %s CCDB object", runNumber, conditions.bz, conditions.grpo != nullptr ? "GRP" : "GRPMagField");
+    return conditions;
+  }
+
+  /// Retrieves an object through the CCDB manager, counted in the ProcessCounters of the thread
+  template <typename T>
+  T* getForTimeStamp(std::string const& path, uint64_t timestamp)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    T* object = mCCDB->getForTimeStamp<T>(path, timestamp);
+    auto& counters = processCounters();
+    counters.ccdbFetches++;
+    counters.ccdbTime += elapsedMilliseconds(start);
+    return object;
+  }
+
+  std::shared_ptr<const o2::dataformats::MeanVertexObject> fetchMeanVertex(int runNumber, uint64_t timestamp)
+  {
+    auto meanVertex = getForTimeStamp<o2::dataformats::MeanVertexObject>(mSettings.meanVertexPath, timestamp);
+    if (meanVertex == nullptr) {
+      LOGF(fatal, "Mean vertex (%s) not available in CCDB for run %d at timestamp %llu", mSettings.meanVertexPath.data(), runNumber, static_cast<unsigned long long>(timestamp));
+    }
+    return std::make_shared<const o2::dataformats::MeanVertexObject>(*meanVertex);
+  }
+
+  // process-wide state, shared by all the instances
+  static std::map<int, RunConditions>& store()
+  {
+    static std::map<int, RunConditions> conditions;
+    return conditions;
+  }
+  static int& fieldRun()
+  {
+    static int run = -1;
+    return run;
+  }
+  static o2::base::MatLayerCylSet*& lut()
+  {
+    static o2::base::MatLayerCylSet* matLut = nullptr;
+    return matLut;
+  }
+
+  o2::ccdb::BasicCCDBManager* mCCDB = nullptr;
+  RunConditionsSettings mSettings;
+  RunConditions mConditions;
+  std::function<void(RunConditions const&)> mCallback;
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_RUNCONDITIONSCACHE_H_
@@ -0,0 +1,59 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file SparseOutput.h
+/// \brief Sparse output mode of the multidimensional histograms of a task
+///
+/// Many QA histograms have large 2D and 3D binnings of which only a few bins are filled. Booked as THnSparse they
+/// store and merge only the filled bins, which makes the output smaller and the merging of the train jobs faster.
+/// A task maps the types of these histograms with getOutputHistType(type, useSparseOutput) when it books them, and
+/// fills them as before with registry.fill(). The histograms must not be retrieved with get<TH2>/get<TH3> then.
+/// Scripts/densify_sparse_histograms.py converts them back to TH2/TH3 at read time.
+
+#ifndef O2PHYSICS_COMMON_CORE_SPARSEOUTPUT_H_
+#define O2PHYSICS_COMMON_CORE_SPARSEOUTPUT_H_
+
+#include "Framework/HistogramSpec.h"
+
+namespace o2::analysis
+{
+
+/// \return sparse type with the same bin content type as a 2D or 3D histogram type if sparse is true, the type otherwise
+constexpr o2::framework::HistType getOutputHistType(o2::framework::HistType type, bool sparse)
+{
+  using o2::framework::HistType;
+  if (!sparse) {
+    return type;
+  }
+  switch (type) {
+    case HistType::kTH2C:
+    case HistType::kTH3C:
+      return HistType::kTHnSparseC;
+    case HistType::kTH2S:
+    case HistType::kTH3S:
+      return HistType::kTHnSparseS;
+    case HistType::kTH2I:
+    case HistType::kTH3I:
+      return HistType::kTHnSparseI;
+    case HistType::kTH2F:
+    case HistType::kTH3F:
+      return HistType::kTHnSparseF;
+    case HistType::kTH2D:
+    case HistType::kTH3D:
+      return HistType::kTHnSparseD;
+    default:
+      return type;
+  }
+}
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_SPARSEOUTPUT_H_
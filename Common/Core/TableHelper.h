@@ -18,9 +18,12 @@
 #ifndef O2PHYSICS_COMMON_CORE_TABLEHELPER_H_
 #define O2PHYSICS_COMMON_CORE_TABLEHELPER_H_
 
+#include "Framework/DataSpecUtils.h"
 #include "Framework/InitContext.h"
 #include "Framework/RunningWorkflowInfo.h"
+#include <set>
 #include <string>
+#include <vector>
 
 /// Function to check if a table is required in a workflow
 /// @param initContext initContext of the init function
@@ -38,14 +41,28 @@ bool isTableRequiredInWorkflow(o2::framework::InitContext& initContext, const st
   return false;
 }
 
-/// Function to enable or disable a configurable flag, depending on the fact that a table is needed or not
+/// Function to get the names of all the tables required in a workflow, to check many tables without scanning the workflow again for each of them
 /// @param initContext initContext of the init function
-/// @param table name of the table to check for
+inline std::set<std::string> getTablesRequiredInWorkflow(o2::framework::InitContext& initContext)
+{
+  std::set<std::string> tables;
+  auto& workflows = initContext.services().get<o2::framework::RunningWorkflowInfo const>();
+  for (auto const& device : workflows.devices) {
+    for (auto const& input : device.inputs) {
+      tables.insert(input.matcher.binding);
+    }
+  }
+  return tables;
+}
+
+/// Function to enable or disable a configurable flag, depending on the fact that a table is needed or not
+/// @param isRequired whether the table is required in the workflow
+/// @param table name of the table, for the log
 /// @param flag configurable flag to set, only if initially set to -1. Initial values of 0 or 1 will be kept disregarding the table usage in the workflow.
 template <typename FlagType>
-void enableFlagIfTableRequired(o2::framework::InitContext& initContext, const std::string& table, FlagType& flag)
+void enableFlagIfRequired(bool isRequired, const std::string& table, FlagType& flag)
 {
-  if (isTableRequiredInWorkflow(initContext, table)) {
+  if (isRequired) {
     if (flag < 0) {
       flag.value = 1;
       LOG(info) << "Auto-enabling table: " + table;
@@ -58,4 +75,62 @@ void enableFlagIfTableRequired(o2::framework::InitContext& initContext, const st
   }
 }
 
+/// Function to enable or disable a configurable flag, depending on the fact that a table is needed or not
+/// @param initContext initContext of the init function
+/// @param table name of the table to check for
+/// @param flag configurable flag to set, only if initially set to -1. Initial values of 0 or 1 will be kept disregarding the table usage in the workflow.
+template <typename FlagType>
+void enableFlagIfTableRequired(o2::framework::InitContext& initContext, const std::string& table, FlagType& flag)
+{
+  enableFlagIfRequired(isTableRequiredInWorkflow(initContext, table), table, flag);
+}
+
+/// Same as above, with the tables required in the workflow from getTablesRequiredInWorkflow, computed once for all the flags of a task
+/// @param requiredTables tables required in the workflow
+/// @param table name of the table to check for
+/// @param flag configurable flag to set, only if initially set to -1
+template <typename FlagType>
+void enableFlagIfTableRequired(const std::set<std::string>& requiredTables, const std::string& table, FlagType& flag)
+{
+  enableFlagIfRequired(requiredTables.count(table) > 0, table, flag);
+}
+
+/// Output of a device of the workflow and the devices consuming it
+struct TableUsage {
+  std::string producer;               ///< device producing the output
+  std::string table;                  ///< binding of the output, the table name for the tables of the analysis tasks
+  std::vector<std::string> consumers; ///< devices with an input matching the output, the AOD writer included
+};
+
+/// Function to get, for each output of the devices of a workflow, the devices which consume it
+/// @param initContext initContext of the init function
+/// @note outputs without consumers are computed for nothing, their producers can be configured to skip them
+inline std::vector<TableUsage> getTableUsageInWorkflow(o2::framework::InitContext& initContext)
+{
+  std::vector<TableUsage> usages;
+  auto& workflows = initContext.services().get<o2::framework::RunningWorkflowInfo const>();
+  for (auto const& producer : workflows.devices) {
+    for (auto const& output : producer.outputs) {
+      auto concrete = o2::framework::DataSpecUtils::asOptionalConcreteDataMatcher(output.matcher);
+      if (!concrete) {
+        continue;
+      }
+      TableUsage usage{producer.name, output.matcher.binding.value, {}};
+      for (auto const& consumer : workflows.devices) {
+        if (consumer.name == producer.name) {
+          continue;
+        }
+        for (auto const& input : consumer.inputs) {
+          if (o2::framework::DataSpecUtils::match(input.matcher, *concrete)) {
+            usage.consumers.push_back(consumer.name);
+            break;
+          }
+        }
+      }
+      usages.push_back(usage);
+    }
+  }
+  return usages;
+}
+
 #endif
@@ -0,0 +1,485 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ThreadPool.h
+/// \brief Thread pool shared by the multi-threaded kernels of the tasks of a process (DPL device)
+///
+/// The pool runs coreBudget() - 1 worker threads, the threads waiting for their tasks (e.g. the DPL thread calling a
+/// process function) executing queued tasks meanwhile, so that the kernels of all the tasks of a device together use
+/// at most coreBudget() cores instead of each starting its own threads. The budget is the number of cores the process
+/// may run on, or the value of the environment variable O2PHYSICS_CORE_BUDGET, or the value given to setCoreBudget().
+///
+/// Each worker has its own queue: the tasks submitted by a worker go to its queue, which it processes last in first
+/// out, and the idle workers steal the oldest tasks of the other queues. The workers run on the cores of the NUMA node
+/// of the thread starting them first, spilling over to the next nodes only when the budget exceeds the node, so that
+/// the kernels do not move their data across the sockets. With setPinning(true) each worker is bound to a single core.
+/// The workers are started at the first parallel call, i.e. in the process functions, after the devices are forked.
+///
+/// parallelFor() splits a range in contiguous chunks which depend only on the number of items and of chunks, and
+/// passes the chunk index, so that the partial results stored per chunk and merged in chunk order (reduceOrdered,
+/// addHistogramsOrdered) do not depend on the number of threads nor on the scheduling.
+
+#ifndef O2PHYSICS_COMMON_CORE_THREADPOOL_H_
+#define O2PHYSICS_COMMON_CORE_THREADPOOL_H_
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <TH1.h>
+
+namespace o2::analysis
+{
+
+class ThreadPool
+{
+ public:
+  /// \return pool of the process
+  static ThreadPool& instance()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+  ~ThreadPool() { stop(); }
+
+  /// Sets the number of cores used by the kernels of the process, the waiting threads included
+  /// Must be called while no kernel runs, typically in init. 0: default (see coreBudget)
+  void setCoreBudget(int nCores)
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    const int budget = nCores > 0 ? nCores : defaultCoreBudget();
+    if (budget != mCoreBudget) {
+      stopWorkers();
+      mCoreBudget = budget;
+    }
+  }
+
+  /// \return number of cores used by the kernels of the process, the waiting threads included
+  int coreBudget()
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    if (mCoreBudget == 0) {
+      mCoreBudget = defaultCoreBudget();
+    }
+    return mCoreBudget;
+  }
+
+  /// Binds each worker to a single core instead of the cores of its NUMA nodes. Must be called while no kernel runs
+  void setPinning(bool pinning)
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    if (pinning != mPinning) {
+      stopWorkers();
+      mPinning = pinning;
+    }
+  }
+
+  /// \return number of chunks of a range: one per nItemsPerChunkMin items (at least one), at most nChunksMax
+  static std::size_t nChunks(std::size_t nItems, std::size_t nItemsPerChunkMin, int nChunksMax)
+  {
+    return std::clamp<std::size_t>(nItems / std::max<std::size_t>(nItemsPerChunkMin, 1), 1, std::max(nChunksMax, 1));
+  }
+
+  /// Calls func(iChunk, first, last) for nChunks contiguous chunks [first, last) of [0, nItems), concurrently
+  /// The chunks have ceil(nItems / nChunks) items, the last one possibly fewer; the calling thread runs the first one
+  template <typename F>
+  void parallelFor(std::size_t nItems, std::size_t nChunks, F&& func);
+
+  /// Submits a task, executed inline if the pool has no workers. Used by TaskGroup
+  void submit(std::function<void()> task)
+  {
+    ensureStarted();
+    if (mQueues.empty()) {
+      task();
+      return;
+    }
+    const std::size_t iQueue = tlsWorker < mQueues.size() ? tlsWorker : mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+    {
+      std::lock_guard<std::mutex> lock(mQueues[iQueue]->mutex);
+      mQueues[iQueue]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      ++mNQueued;
+    }
+    mCondition.notify_one();
+  }
+
+  /// Executes one queued task, in the calling thread
+  /// \return false if no task was queued
+  bool runOne()
+  {
+    std::function<void()> task;
+    if (!pop(tlsWorker, task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  /// \return number of worker threads, started if needed
+  std::size_t nWorkers()
+  {
+    ensureStarted();
+    return mQueues.size();
+  }
+
+  /// \return cores of the process, those of the NUMA node of the calling thread first, then those of the next nodes
+  static std::vector<int> coresByNumaNode()
+  {
+    std::vector<int> allowed;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+          allowed.push_back(cpu);
+        }
+      }
+    }
+    // nodes of the allowed cores, from /sys/devices/system/node/node<N>/cpulist, e.g. "0-15,32-47"
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; ++node) {
+      std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (!input) {
+        break;
+      }
+      std::vector<int> cores;
+      std::string range;
+      while (std::getline(input, range, ',')) {
+        int first = -1, last = -1;
+        char dash = 0;
+        std::istringstream parser(range);
+        if (!(parser >> first)) {
+          continue;
+        }
+        last = (parser >> dash >> last) ? last : first;
+        for (int cpu = first; cpu <= last; ++cpu) {
+          if (std::binary_search(allowed.begin(), allowed.end(), cpu)) {
+            cores.push_back(cpu);
+          }
+        }
+      }
+      nodes.push_back(std::move(cores));
+    }
+    const int current = sched_getcpu();
+    const auto first = std::find_if(nodes.begin(), nodes.end(), [current](auto const& cores) { return std::find(cores.begin(), cores.end(), current) != cores.end(); });
+    if (first != nodes.end()) {
+      std::rotate(nodes.begin(), first, nodes.end());
+      std::vector<int> ordered;
+      for (auto const& cores : nodes) {
+        ordered.insert(ordered.end(), cores.begin(), cores.end());
+      }
+      if (ordered.size() == allowed.size()) {
+        return ordered;
+      }
+    }
+#endif
+    return allowed;
+  }
+
+ private:
+  ThreadPool() = default;
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  static int defaultCoreBudget()
+  {
+    if (const char* budget = std::getenv("O2PHYSICS_CORE_BUDGET")) {
+      if (int value = std::atoi(budget); value > 0) {
+        return value;
+      }
+    }
+    const auto cores = coresByNumaNode();
+    return cores.empty() ? std::max<int>(std::thread::hardware_concurrency(), 1) : static_cast<int>(cores.size());
+  }
+
+  void ensureStarted()
+  {
+    if (mStarted.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    if (mStarted.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (mCoreBudget == 0) {
+      mCoreBudget = defaultCoreBudget();
+    }
+    const std::size_t nWorkers = mCoreBudget - 1;
+    const auto cores = coresByNumaNode();
+    mStop = false;
+    for (std::size_t iWorker = 0; iWorker < nWorkers; ++iWorker) {
+      mQueues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t iWorker = 0; iWorker < nWorkers; ++iWorker) {
+      std::vector<int> workerCores;
+      if (!cores.empty()) {
+        const std::size_t nUsed = std::min<std::size_t>(mCoreBudget, cores.size());
+        if (mPinning) {
+          // the first core of the budget is left to the calling threads
+          workerCores.push_back(cores[(iWorker + 1) % nUsed]);
+        } else {
+          workerCores.assign(cores.begin(), cores.begin() + nUsed);
+        }
+      }
+      mWorkers.emplace_back([this, iWorker, workerCores] { work(iWorker, workerCores); });
+    }
+    mStarted.store(true, std::memory_order_release);
+  }
+
+  void work(std::size_t iWorker, std::vector<int> const& cores)
+  {
+#if defined(__linux__)
+    if (!cores.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : cores) {
+        CPU_SET(cpu, &set);
+      }
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    tlsWorker = iWorker;
+    while (true) {
+      if (runOne()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this] { return mStop || mNQueued > 0; });
+      if (mStop && mNQueued <= 0) {
+        return;
+      }
+    }
+  }
+
+  /// Takes the newest task of the queue of the worker, otherwise the oldest task of the other queues
+  bool pop(std::size_t iWorker, std::function<void()>& task)
+  {
+    const std::size_t nQueues = mQueues.size();
+    if (nQueues == 0) {
+      return false;
+    }
+    const std::size_t own = iWorker < nQueues ? iWorker : 0;
+    for (std::size_t i = 0; i < nQueues; ++i) {
+      auto& queue = *mQueues[(own + i) % nQueues];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+      if (i == 0 && iWorker < nQueues) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      std::lock_guard<std::mutex> countLock(mMutex);
+      --mNQueued;
+      return true;
+    }
+    return false;
+  }
+
+  /// Joins the workers, called with mStartMutex locked and no task queued
+  void stopWorkers()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto& worker : mWorkers) {
+      worker.join();
+    }
+    mWorkers.clear();
+    mQueues.clear();
+    mStarted.store(false, std::memory_order_release);
+  }
+
+  void stop()
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    stopWorkers();
+  }
+
+  static inline thread_local std::size_t tlsWorker = static_cast<std::size_t>(-1); ///< index of the worker of the thread, -1 if not a worker
+
+  std::mutex mStartMutex;                         ///< protects the configuration and the start of the workers
+  std::atomic<bool> mStarted{false};              ///< whether the workers of the current configuration are started
+  int mCoreBudget = 0;                            ///< cores used by the kernels, 0: not yet set
+  bool mPinning = false;                          ///< whether each worker is bound to a single core
+  std::vector<std::unique_ptr<Queue>> mQueues;    ///< queue of each worker
+  std::vector<std::thread> mWorkers;              ///< worker threads
+  std::atomic<std::size_t> mNextQueue{0};         ///< queue of the next task submitted by a thread which is not a worker
+  std::mutex mMutex;                              ///< protects mNQueued and mStop
+  std::condition_variable mCondition;             ///< signals the workers of new tasks or of the stop
+  long mNQueued = 0;                              ///< number of queued tasks
+  bool mStop = false;                             ///< whether the workers must stop
+};
+
+/// Group of tasks executed by the pool, e.g. one per collision, waited for together
+/// The waiting thread executes queued tasks, so that groups can be nested in tasks without idle workers.
+class TaskGroup
+{
+ public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::instance()) : mPool(pool) {}
+  TaskGroup(TaskGroup const&) = delete;
+  TaskGroup& operator=(TaskGroup const&) = delete;
+
+  /// Waits for the tasks, their exceptions being discarded: call wait() to get them
+  ~TaskGroup()
+  {
+    waitTasks();
+  }
+
+  /// Submits a task, which must not access the group
+  template <typename F>
+  void run(F&& task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      ++mNPending;
+    }
+    mPool.submit([this, task = std::forward<F>(task)]() mutable {
+      std::exception_ptr exception;
+      try {
+        task();
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      // the group may be destroyed as soon as the count is decremented
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (exception && !mException) {
+        mException = exception;
+      }
+      if (--mNPending == 0) {
+        mDone.notify_all();
+      }
+    });
+  }
+
+  /// Waits for the tasks submitted so far and rethrows the first exception they threw
+  void wait()
+  {
+    waitTasks();
+    std::exception_ptr exception;
+    std::swap(exception, mException);
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+ private:
+  void waitTasks()
+  {
+    while (true) {
+      if (mPool.runOne()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mMutex);
+      if (mNPending == 0) {
+        return;
+      }
+      // woken up regularly to execute the tasks queued meanwhile, e.g. by nested groups
+      mDone.wait_for(lock, std::chrono::microseconds(200), [this] { return mNPending == 0; });
+      if (mNPending == 0) {
+        return;
+      }
+    }
+  }
+
+  ThreadPool& mPool;
+  std::mutex mMutex;                  ///< protects mNPending and mException
+  std::condition_variable mDone;      ///< signals the completion of the last task
+  int mNPending = 0;                  ///< number of tasks not yet completed
+  std::exception_ptr mException;      ///< first exception thrown by the tasks
+};
+
+template <typename F>
+void ThreadPool::parallelFor(std::size_t nItems, std::size_t nChunks, F&& func)
+{
+  if (nItems == 0) {
+    return;
+  }
+  nChunks = std::clamp<std::size_t>(nChunks, 1, nItems);
+  const std::size_t nItemsPerChunk = (nItems + nChunks - 1) / nChunks;
+  nChunks = (nItems + nItemsPerChunk - 1) / nItemsPerChunk;
+  auto runChunk = [&](std::size_t iChunk) {
+    const std::size_t first = iChunk * nItemsPerChunk;
+    func(iChunk, first, std::min(nItems, first + nItemsPerChunk));
+  };
+  if (nChunks == 1 || nWorkers() == 0) {
+    for (std::size_t iChunk = 0; iChunk < nChunks; ++iChunk) {
+      runChunk(iChunk);
+    }
+    return;
+  }
+  TaskGroup group(*this);
+  for (std::size_t iChunk = 1; iChunk < nChunks; ++iChunk) {
+    group.run([&runChunk, iChunk] { runChunk(iChunk); });
+  }
+  runChunk(0);
+  group.wait();
+}
+
+/// Merges the partial results of the chunks into the first one, in chunk order, with merge(target, partial)
+/// \return merged result
+template <typename T, typename F>
+T& reduceOrdered(std::vector<T>& partials, F&& merge)
+{
+  for (std::size_t i = 1; i < partials.size(); ++i) {
+    merge(partials[0], partials[i]);
+  }
+  return partials[0];
+}
+
+/// Adds the partial histograms of the chunks to a histogram, in chunk order, so that the sums of weights are the same
+/// whatever the number of threads and the scheduling
+template <typename THist>
+void addHistogramsOrdered(TH1& target, std::vector<THist> const& partials)
+{
+  for (auto const& partial : partials) {
+    if (partial) {
+      target.Add(&*partial);
+    }
+  }
+}
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_THREADPOOL_H_
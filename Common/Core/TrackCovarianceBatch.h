@@ -0,0 +1,203 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file TrackCovarianceBatch.h
+/// \brief Covariance matrices of a batch of tracks in SoA layout, with the sigmas and correlations derived in one pass,
+///        and dense fixed-binning accumulators to histogram them
+///
+/// The 15 elements of the covariance matrix of the (y, z, snp, tgl, q/pt) parameters are stored in the order of the
+/// AO2D columns (cYY, cZY, cZZ, cSnpY, ...), one vector per element. compute() derives the 5 sigmas and the 10
+/// correlation coefficients of all the tracks with loops which the compiler can vectorize. DenseHistogram counts the
+/// values of a quantity in a plain array, which is added to a ROOT histogram once per batch.
+/// The loops of compute() are dispatched to the instruction set selected at runtime (see CpuDispatch.h).
+
+#ifndef O2PHYSICS_COMMON_CORE_TRACKCOVARIANCEBATCH_H_
+#define O2PHYSICS_COMMON_CORE_TRACKCOVARIANCEBATCH_H_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "Common/Core/CpuDispatch.h"
+
+namespace o2::analysis
+{
+
+namespace covariance_kernels
+{
+inline void sigmasImpl(const float* diagonal, float* sigma, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    sigma[i] = std::sqrt(std::fmax(diagonal[i], 0.f));
+  }
+}
+inline void correlationsImpl(const float* element, const float* sigmaRow, const float* sigmaColumn, float* correlation, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    const float norm = sigmaRow[i] * sigmaColumn[i];
+    correlation[i] = norm > 0.f ? element[i] / norm : 0.f;
+  }
+}
+O2_SIMD_TARGET_AVX2 O2_SIMD_FLATTEN inline void sigmasAvx2(const float* diagonal, float* sigma, std::size_t n) { sigmasImpl(diagonal, sigma, n); }
+O2_SIMD_TARGET_AVX512 O2_SIMD_FLATTEN inline void sigmasAvx512(const float* diagonal, float* sigma, std::size_t n) { sigmasImpl(diagonal, sigma, n); }
+O2_SIMD_TARGET_AVX2 O2_SIMD_FLATTEN inline void correlationsAvx2(const float* element, const float* sigmaRow, const float* sigmaColumn, float* correlation, std::size_t n) { correlationsImpl(element, sigmaRow, sigmaColumn, correlation, n); }
+O2_SIMD_TARGET_AVX512 O2_SIMD_FLATTEN inline void correlationsAvx512(const float* element, const float* sigmaRow, const float* sigmaColumn, float* correlation, std::size_t n) { correlationsImpl(element, sigmaRow, sigmaColumn, correlation, n); }
+
+inline const simd::Dispatched<void (*)(const float*, float*, std::size_t)> sigmas{sigmasImpl, sigmasAvx2, sigmasAvx512};
+inline const simd::Dispatched<void (*)(const float*, const float*, const float*, float*, std::size_t)> correlations{correlationsImpl, correlationsAvx2, correlationsAvx512};
+} // namespace covariance_kernels
+
+/// Histogram with a fixed binning, with the underflow and overflow bins numbered as in ROOT
+class DenseHistogram
+{
+ public:
+  DenseHistogram() = default;
+  DenseHistogram(int nBins, float min, float max) : mNBins(nBins), mMin(min), mScale(nBins / (max - min)), mCounts(nBins + 2, 0.) {}
+
+  /// \return accumulator with the binning of a ROOT histogram, given by pointer or by any handle with operator->
+  template <typename THist>
+  static DenseHistogram fromHistogram(THist& hist)
+  {
+    return DenseHistogram(hist->GetNbinsX(), hist->GetXaxis()->GetXmin(), hist->GetXaxis()->GetXmax());
+  }
+
+  void fill(float value)
+  {
+    add(bin(value));
+  }
+  void fill(const float* values, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; i++) {
+      add(bin(values[i]));
+    }
+  }
+  void fill(const std::vector<float>& values) { fill(values.data(), values.size()); }
+
+  /// Adds the counts to a ROOT histogram of the same binning and resets them, visiting only the filled bins
+  template <typename THist>
+  void flush(THist& hist)
+  {
+    if (mFilled.empty()) {
+      return;
+    }
+    for (int i : mFilled) {
+      hist->AddBinContent(i, mCounts[i]);
+      mCounts[i] = 0.;
+    }
+    mFilled.clear();
+    hist->ResetStats();
+  }
+
+  const std::vector<double>& counts() const { return mCounts; }
+
+ private:
+  void add(int i)
+  {
+    if (mCounts[i] == 0.) {
+      mFilled.push_back(i);
+    }
+    mCounts[i] += 1.;
+  }
+
+  int bin(float value) const
+  {
+    if (!(value >= mMin)) {
+      return 0; // underflow, and NaN
+    }
+    const float x = (value - mMin) * mScale;
+    return x < mNBins ? 1 + static_cast<int>(x) : mNBins + 1;
+  }
+
+  int mNBins = 0;
+  float mMin = 0.f;
+  float mScale = 1.f;
+  std::vector<double> mCounts;
+  std::vector<int> mFilled; ///< bins with non-zero counts, so that frequent flushes of fine binnings stay cheap
+};
+
+/// Covariance matrices of a batch of tracks, one vector per element
+struct TrackCovarianceBatch {
+  enum Element {
+    kYY = 0,
+    kZY,
+    kZZ,
+    kSnpY,
+    kSnpZ,
+    kSnpSnp,
+    kTglY,
+    kTglZ,
+    kTglSnp,
+    kTglTgl,
+    k1PtY,
+    k1PtZ,
+    k1PtSnp,
+    k1PtTgl,
+    k1Pt21Pt2,
+    kNElements
+  };
+  static constexpr int kNParameters = 5;                           ///< y, z, snp, tgl, q/pt
+  static constexpr int kNCorrelations = kNElements - kNParameters; ///< ZY, SnpY, SnpZ, TglY, ..., 1PtTgl
+  static constexpr std::array<int, kNParameters> kDiagonal = {kYY, kZZ, kSnpSnp, kTglTgl, k1Pt21Pt2};
+
+  std::array<std::vector<float>, kNElements> elements;
+  std::array<std::vector<float>, kNParameters> sigmas;
+  std::array<std::vector<float>, kNCorrelations> correlations;
+
+  std::size_t size() const { return elements[0].size(); }
+  void clear()
+  {
+    for (auto& element : elements) {
+      element.clear();
+    }
+  }
+  void reserve(std::size_t n)
+  {
+    for (auto& element : elements) {
+      element.reserve(n);
+    }
+  }
+
+  /// Adds the covariance matrix of a track with the accessors of the TracksCov table
+  template <typename TTrack>
+  void push_back(const TTrack& track)
+  {
+    const float values[kNElements] = {track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
+                                      track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
+                                      track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2()};
+    for (int i = 0; i < kNElements; i++) {
+      elements[i].push_back(values[i]);
+    }
+  }
+
+  /// Fills the sigmas and the correlation coefficients of all the tracks, the correlations being 0 if a sigma is not positive
+  void compute()
+  {
+    const std::size_t n = size();
+    for (int p = 0; p < kNParameters; p++) {
+      sigmas[p].resize(n);
+      covariance_kernels::sigmas(elements[kDiagonal[p]].data(), sigmas[p].data(), n);
+    }
+    // element (row, column) of the lower triangle at row * (row + 1) / 2 + column
+    int iCorrelation = 0;
+    for (int row = 1; row < kNParameters; row++) {
+      for (int column = 0; column < row; column++) {
+        auto& correlation = correlations[iCorrelation++];
+        correlation.resize(n);
+        covariance_kernels::correlations(elements[row * (row + 1) / 2 + column].data(), sigmas[row].data(), sigmas[column].data(), correlation.data(), n);
+      }
+    }
+  }
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_TRACKCOVARIANCEBATCH_H_
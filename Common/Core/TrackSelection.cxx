@@ -14,6 +14,7 @@
 //
 
 #include "Common/Core/TrackSelection.h"
+#include <algorithm>
 
 bool TrackSelection::FulfillsITSHitRequirements(uint8_t itsClusterMap)
 {
@@ -29,4 +30,147 @@ bool TrackSelection::FulfillsITSHitRequirements(uint8_t itsClusterMap)
   return true;
 }
 
+void TrackSelection::TrackColumns::resize(size_t n)
+{
+  trackType.resize(n);
+  pt.resize(n);
+  eta.resize(n);
+  tpcNClsFound.resize(n);
+  tpcNClsCrossedRows.resize(n);
+  tpcCrossedRowsOverFindableCls.resize(n);
+  tpcChi2NCl.resize(n);
+  itsNCls.resize(n);
+  itsChi2NCl.resize(n);
+  flags.resize(n);
+  hasTPC.resize(n);
+  hasITS.resize(n);
+  itsClusterMap.resize(n);
+  dcaXY.resize(n);
+  dcaZ.resize(n);
+}
+
+void TrackSelection::FillLookupTables()
+{
+  for (int map = 0; map < 256; ++map) {
+    mPassesITSHits[map] = FulfillsITSHitRequirements(static_cast<uint8_t>(map));
+  }
+
+  mUseDcaXYPtTable = false;
+  if (!mMaxDcaXYPtDep) {
+    return;
+  }
+  bool nonIncreasing = true;
+  bool nonDecreasing = true;
+  for (int edge = 0; edge <= kNDcaXYPtBins; ++edge) {
+    mDcaXYPtEdges[edge] = edge * kDcaXYPtBinWidth;
+    mDcaXYPtDepValues[edge] = mMaxDcaXYPtDep(mDcaXYPtEdges[edge]);
+    if (edge > 0) {
+      nonIncreasing = nonIncreasing && !(mDcaXYPtDepValues[edge] > mDcaXYPtDepValues[edge - 1]);
+      nonDecreasing = nonDecreasing && !(mDcaXYPtDepValues[edge] < mDcaXYPtDepValues[edge - 1]);
+    }
+  }
+  // the values at the bin edges bracket the cut inside the bin only for a monotonic function
+  mUseDcaXYPtTable = nonIncreasing || nonDecreasing;
+}
+
+bool TrackSelection::PassesDcaXYPtDep(float pt, float dcaXY) const
+{
+  const float absDcaXY = std::abs(dcaXY);
+  if (mUseDcaXYPtTable && pt >= 0.f && pt < mDcaXYPtEdges[kNDcaXYPtBins]) {
+    const int bin = std::min(static_cast<int>(pt / kDcaXYPtBinWidth), kNDcaXYPtBins - 1);
+    if (pt >= mDcaXYPtEdges[bin] && pt <= mDcaXYPtEdges[bin + 1]) {
+      const float low = std::min(mDcaXYPtDepValues[bin], mDcaXYPtDepValues[bin + 1]);
+      const float high = std::max(mDcaXYPtDepValues[bin], mDcaXYPtDepValues[bin + 1]);
+      if (absDcaXY <= low) {
+        return true;
+      }
+      if (absDcaXY > high) {
+        return false;
+      }
+    }
+  }
+  return absDcaXY <= mMaxDcaXYPtDep(pt);
+}
+
+void TrackSelection::IsSelectedMasks(TrackColumns const& columns, std::vector<uint16_t>& masks)
+{
+  FillLookupTables();
+  masks.assign(columns.size(), 0);
+  for (int cut = 0; cut < static_cast<int>(TrackCuts::kNCuts); ++cut) {
+    SetCutBits(columns, static_cast<TrackCuts>(cut), masks, false);
+  }
+}
+
+void TrackSelection::SetCutBits(TrackColumns const& columns, TrackCuts cut, std::vector<uint16_t>& masks, bool fillLookupTables)
+{
+  if (fillLookupTables) {
+    FillLookupTables();
+  }
+
+  const size_t nTracks = columns.size();
+  auto setCut = [&](auto&& passes) {
+    const uint16_t bit = 1 << static_cast<int>(cut);
+    for (size_t i = 0; i < nTracks; ++i) {
+      masks[i] |= passes(i) ? bit : 0;
+    }
+  };
+  auto isRun2 = [&](size_t i) {
+    return columns.trackType[i] == o2::aod::track::Run2Track || columns.trackType[i] == o2::aod::track::Run2Tracklet;
+  };
+
+  switch (cut) {
+    case TrackCuts::kTrackType:
+      setCut([&](size_t i) { return columns.trackType[i] == mTrackType; });
+      break;
+    case TrackCuts::kPtRange:
+      setCut([&](size_t i) { return columns.pt[i] >= mMinPt && columns.pt[i] <= mMaxPt; });
+      break;
+    case TrackCuts::kEtaRange:
+      setCut([&](size_t i) { return columns.eta[i] >= mMinEta && columns.eta[i] <= mMaxEta; });
+      break;
+    case TrackCuts::kTPCNCls:
+      setCut([&](size_t i) { return columns.tpcNClsFound[i] >= mMinNClustersTPC; });
+      break;
+    case TrackCuts::kTPCCrossedRows:
+      setCut([&](size_t i) { return columns.tpcNClsCrossedRows[i] >= mMinNCrossedRowsTPC; });
+      break;
+    case TrackCuts::kTPCCrossedRowsOverNCls:
+      setCut([&](size_t i) { return columns.tpcCrossedRowsOverFindableCls[i] >= mMinNCrossedRowsOverFindableClustersTPC; });
+      break;
+    case TrackCuts::kTPCChi2NDF:
+      setCut([&](size_t i) { return columns.tpcChi2NCl[i] <= mMaxChi2PerClusterTPC; });
+      break;
+    case TrackCuts::kTPCRefit:
+      setCut([&](size_t i) { return !mRequireTPCRefit || (isRun2(i) ? (columns.flags[i] & o2::aod::track::TPCrefit) != 0 : columns.hasTPC[i] != 0); });
+      break;
+    case TrackCuts::kITSNCls:
+      setCut([&](size_t i) { return columns.itsNCls[i] >= mMinNClustersITS; });
+      break;
+    case TrackCuts::kITSChi2NDF:
+      setCut([&](size_t i) { return columns.itsChi2NCl[i] <= mMaxChi2PerClusterITS; });
+      break;
+    case TrackCuts::kITSRefit:
+      setCut([&](size_t i) { return !mRequireITSRefit || (isRun2(i) ? (columns.flags[i] & o2::aod::track::ITSrefit) != 0 : columns.hasITS[i] != 0); });
+      break;
+    case TrackCuts::kITSHits:
+      setCut([&](size_t i) { return mPassesITSHits[columns.itsClusterMap[i]] != 0; });
+      break;
+    case TrackCuts::kGoldenChi2:
+      setCut([&](size_t i) { return !(isRun2(i) && mRequireGoldenChi2) || (columns.flags[i] & o2::aod::track::GoldenChi2) != 0; });
+      break;
+    case TrackCuts::kDCAxy:
+      if (mMaxDcaXYPtDep) {
+        setCut([&](size_t i) { return PassesDcaXYPtDep(columns.pt[i], columns.dcaXY[i]); });
+      } else {
+        setCut([&](size_t i) { return std::abs(columns.dcaXY[i]) <= mMaxDcaXY; });
+      }
+      break;
+    case TrackCuts::kDCAz:
+      setCut([&](size_t i) { return std::abs(columns.dcaZ[i]) <= mMaxDcaZ; });
+      break;
+    default:
+      break;
+  }
+}
+
 const std::string TrackSelection::mCutNames[static_cast<int>(TrackSelection::TrackCuts::kNCuts)] = {"TrackType", "PtRange", "EtaRange", "TPCNCls", "TPCCrossedRows", "TPCCrossedRowsOverNCls", "TPCChi2NDF", "TPCRefit", "ITSNCls", "ITSChi2NDF", "ITSRefit", "ITSHits", "GoldenChi2", "DCAxy", "DCAz"};
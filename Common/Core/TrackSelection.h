@@ -18,6 +18,9 @@
 
 #include "Framework/Logger.h"
 #include "Framework/DataTypes.h"
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <set>
 #include <vector>
 #include "Rtypes.h"
@@ -48,6 +51,74 @@ class TrackSelection
 
   static const std::string mCutNames[static_cast<int>(TrackCuts::kNCuts)];
 
+  // mask of a track passing all the cuts
+  static constexpr uint16_t kAllCutsMask = (1 << static_cast<int>(TrackCuts::kNCuts)) - 1;
+
+  // Contiguous copies of the track columns used by the cuts, for the evaluation over whole tables
+  struct TrackColumns {
+    std::vector<uint8_t> trackType;
+    std::vector<float> pt;
+    std::vector<float> eta;
+    std::vector<int16_t> tpcNClsFound;
+    std::vector<int16_t> tpcNClsCrossedRows;
+    std::vector<float> tpcCrossedRowsOverFindableCls;
+    std::vector<float> tpcChi2NCl;
+    std::vector<uint8_t> itsNCls;
+    std::vector<float> itsChi2NCl;
+    std::vector<uint32_t> flags;
+    std::vector<uint8_t> hasTPC;
+    std::vector<uint8_t> hasITS;
+    std::vector<uint8_t> itsClusterMap;
+    std::vector<float> dcaXY;
+    std::vector<float> dcaZ;
+
+    size_t size() const { return pt.size(); }
+    void resize(size_t n);
+
+    // Copies the columns of a table with the track, track extra and DCA columns
+    template <typename T>
+    void fill(T const& tracks)
+    {
+      resize(tracks.size());
+      size_t i = 0;
+      for (auto& track : tracks) {
+        trackType[i] = track.trackType();
+        pt[i] = track.pt();
+        eta[i] = track.eta();
+        tpcNClsFound[i] = track.tpcNClsFound();
+        tpcNClsCrossedRows[i] = track.tpcNClsCrossedRows();
+        tpcCrossedRowsOverFindableCls[i] = track.tpcCrossedRowsOverFindableCls();
+        tpcChi2NCl[i] = track.tpcChi2NCl();
+        itsNCls[i] = track.itsNCls();
+        itsChi2NCl[i] = track.itsChi2NCl();
+        flags[i] = track.flags();
+        hasTPC[i] = track.hasTPC();
+        hasITS[i] = track.hasITS();
+        itsClusterMap[i] = track.itsClusterMap();
+        dcaXY[i] = track.dcaXY();
+        dcaZ[i] = track.dcaZ();
+        ++i;
+      }
+    }
+  };
+
+  // Same as IsSelectedMask for all the tracks of a table, each cut is evaluated as a branch-free
+  // comparison over the columns, which the compiler can vectorize. The pT dependent DCAxy cut
+  // is looked up in a table of its values, the function is only called close to the threshold.
+  void IsSelectedMasks(TrackColumns const& columns, std::vector<uint16_t>& masks);
+
+  // Evaluates a single cut over all the tracks of a table, setting its bit in the masks of the passing
+  // tracks. The masks must have one entry per track. The lookup tables only need to be filled once
+  // when several cuts of this selection are evaluated on the same table.
+  void SetCutBits(TrackColumns const& columns, TrackCuts cut, std::vector<uint16_t>& masks, bool fillLookupTables = true);
+
+  template <typename T>
+  void IsSelectedMasks(T const& tracks, std::vector<uint16_t>& masks)
+  {
+    mColumns.fill(tracks);
+    IsSelectedMasks(mColumns, masks);
+  }
+
   // Temporary function to check if track passes selection criteria. To be replaced by framework filters.
   template <typename T>
   bool IsSelected(T const& track)
@@ -178,10 +249,10 @@ class TrackSelection
         return (isRun2 && mRequireGoldenChi2) ? (track.flags() & o2::aod::track::GoldenChi2) : true;
 
       case TrackCuts::kDCAxy:
-        return abs(track.dcaXY()) <= ((mMaxDcaXYPtDep) ? mMaxDcaXYPtDep(track.pt()) : mMaxDcaXY);
+        return std::abs(track.dcaXY()) <= ((mMaxDcaXYPtDep) ? mMaxDcaXYPtDep(track.pt()) : mMaxDcaXY);
 
       case TrackCuts::kDCAz:
-        return abs(track.dcaZ()) <= mMaxDcaZ;
+        return std::abs(track.dcaZ()) <= mMaxDcaZ;
 
       default:
         return false;
@@ -255,6 +326,8 @@ class TrackSelection
 
  private:
   bool FulfillsITSHitRequirements(uint8_t itsClusterMap);
+  void FillLookupTables();
+  bool PassesDcaXYPtDep(float pt, float dcaXY) const;
 
   o2::aod::track::TrackTypeEnum mTrackType{o2::aod::track::TrackTypeEnum::Track};
 
@@ -281,7 +354,16 @@ class TrackSelection
   // vector of ITS requirements (minNRequiredHits in specific requiredLayers)
   std::vector<std::pair<int8_t, std::set<uint8_t>>> mRequiredITSHits{};
 
-  ClassDefNV(TrackSelection, 1);
+  // lookup tables of the table-wide evaluation, rebuilt at each call from the cuts above
+  static constexpr int kNDcaXYPtBins = 2000;       // bins of the pT dependent DCAxy cut table
+  static constexpr float kDcaXYPtBinWidth = 0.01f; // GeV/c, the table covers 0 < pT < 20 GeV/c
+  uint8_t mPassesITSHits[256];                     //! ITS hit requirements for each cluster map
+  float mDcaXYPtEdges[kNDcaXYPtBins + 1];          //! pT at the edges of the DCAxy table bins
+  float mDcaXYPtDepValues[kNDcaXYPtBins + 1];      //! pT dependent DCAxy cut at the bin edges
+  bool mUseDcaXYPtTable{false};                    //! the cut is monotonic, the table can be used
+  TrackColumns mColumns;                           //! columns of the last table
+
+  ClassDefNV(TrackSelection, 2);
 };
 
 #endif
@@ -17,6 +17,9 @@
 #ifndef O2_ANALYSIS_TRACKSELECTORPID_H_
 #define O2_ANALYSIS_TRACKSELECTORPID_H_
 
+#include <cstdint>
+#include <vector>
+
 #include <TPDGCode.h>
 
 #include "Framework/Logger.h"
@@ -581,4 +584,41 @@ class TrackSelectorPID
   float mPtBayesMax = 100.; ///< maximum pT for Bayesian PID [GeV/c]
 };
 
+/// Combined PID (TPC + TOF) status of the tracks of a table for one selector.
+/// The status of a track is evaluated the first time it is requested and then read by track index,
+/// so tracks shared by many candidates are checked only once.
+
+class TrackSelectorPIDCache
+{
+ public:
+  /// Standard constructor
+  /// \param selector  configured selector, copied
+  explicit TrackSelectorPIDCache(const TrackSelectorPID& selector) : mSelector(selector) {}
+
+  /// Forgets the cached statuses, to be called for each new track table.
+  /// \param nTracks  number of tracks of the table
+  void reset(std::size_t nTracks)
+  {
+    mStatus.assign(nTracks, StatusNotEvaluated);
+  }
+
+  /// Returns status of combined PID (TPC + TOF) selection for a given track, see TrackSelectorPID::getStatusTrackPIDAll.
+  /// \param track  track of the table given to reset
+  template <typename T>
+  int getStatusTrackPIDAll(const T& track)
+  {
+    auto& status = mStatus[track.globalIndex()];
+    if (status == StatusNotEvaluated) {
+      status = mSelector.getStatusTrackPIDAll(track);
+    }
+    return status;
+  }
+
+ private:
+  static constexpr int8_t StatusNotEvaluated = -1;
+
+  TrackSelectorPID mSelector;  ///< selector
+  std::vector<int8_t> mStatus; ///< status of each track of the table, StatusNotEvaluated if not yet requested
+};
+
 #endif // O2_ANALYSIS_TRACKSELECTORPID_H_
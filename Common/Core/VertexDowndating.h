@@ -0,0 +1,147 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file VertexDowndating.h
+/// \brief Analytic removal of tracks from a primary vertex fit, as an alternative to a full refit of the vertex
+///
+/// The vertex fit is the covariance-weighted least-squares fit of the linearized tracks: each track, described in its
+/// local frame by its (y, z) at x and its slopes, constrains the vertex with an information matrix A_i = J_i^T W_i J_i,
+/// W_i being the inverse of the (y, z) covariance. The inverse of the vertex covariance is the sum of the A_i, so that
+/// removing a track amounts to subtracting its A_i and its information vector from the ones of the stored vertex, in O(1)
+/// per track. The robust weights and the systematic errors of PVertexer are not accounted for, so the result is an
+/// approximation of its refit, exact for a plain least-squares fit.
+
+#ifndef O2PHYSICS_COMMON_CORE_VERTEXDOWNDATING_H_
+#define O2PHYSICS_COMMON_CORE_VERTEXDOWNDATING_H_
+
+#include <array>
+#include <cmath>
+
+namespace o2::analysis
+{
+
+class VertexDowndating
+{
+ public:
+  /// Sets the vertex to downdate
+  /// \param pos vertex position (x, y, z)
+  /// \param cov vertex covariance (xx, xy, yy, xz, yz, zz)
+  /// \return false if the covariance cannot be inverted
+  bool setVertex(const std::array<float, 3>& pos, const std::array<float, 6>& cov)
+  {
+    double c[3][3];
+    unpack(cov, c);
+    if (!invert(c, mInfo)) {
+      return false;
+    }
+    for (int i = 0; i < 3; i++) {
+      mInfoVec[i] = mInfo[i][0] * pos[0] + mInfo[i][1] * pos[1] + mInfo[i][2] * pos[2];
+    }
+    return true;
+  }
+
+  /// Removes the contribution of a track to the vertex fit
+  /// \param alpha, x, y, z, snp, tgl track parameters in the local frame, close to the vertex
+  /// \param sigY2, sigZY, sigZ2 covariance of the track y and z
+  /// \return false if the track covariance cannot be inverted, in which case nothing is removed
+  bool removeTrack(float alpha, float x, float y, float z, float snp, float tgl, float sigY2, float sigZY, float sigZ2)
+  {
+    const double det = static_cast<double>(sigY2) * sigZ2 - static_cast<double>(sigZY) * sigZY;
+    if (!(det > 0.)) {
+      return false;
+    }
+    const double w[2][2] = {{sigZ2 / det, -sigZY / det}, {-sigZY / det, sigY2 / det}};
+    const double csp = std::sqrt((1. - snp) * (1. + snp));
+    const double tgP = snp / csp;
+    const double tgL = tgl / csp;
+    const double cosA = std::cos(alpha);
+    const double sinA = std::sin(alpha);
+    // residuals r = c + J v of the straight track model y(xl) = y + tgP (xl - x), z(xl) = z + tgL (xl - x),
+    // with the vertex v in the global frame and xl its local x
+    const double j[2][3] = {{tgP * cosA + sinA, tgP * sinA - cosA, 0.}, {tgL * cosA, tgL * sinA, -1.}};
+    const double c[2] = {y - tgP * x, z - tgL * x};
+    double wj[2][3];
+    for (int k = 0; k < 2; k++) {
+      for (int i = 0; i < 3; i++) {
+        wj[k][i] = w[k][0] * j[0][i] + w[k][1] * j[1][i];
+      }
+    }
+    for (int i = 0; i < 3; i++) {
+      for (int l = 0; l < 3; l++) {
+        mInfo[i][l] -= j[0][i] * wj[0][l] + j[1][i] * wj[1][l];
+      }
+      mInfoVec[i] += wj[0][i] * c[0] + wj[1][i] * c[1];
+    }
+    return true;
+  }
+
+  /// Removes a track given as a TrackParCov
+  template <typename TTrackParCov>
+  bool removeTrack(const TTrackParCov& track)
+  {
+    return removeTrack(track.getAlpha(), track.getX(), track.getY(), track.getZ(), track.getSnp(), track.getTgl(), track.getSigmaY2(), track.getSigmaZY(), track.getSigmaZ2());
+  }
+
+  /// Gets the vertex without the removed tracks
+  /// \param pos vertex position (x, y, z)
+  /// \param cov vertex covariance (xx, xy, yy, xz, yz, zz)
+  /// \return false if the remaining information matrix is not positive definite, e.g. if too few tracks are left
+  bool getVertex(std::array<float, 3>& pos, std::array<float, 6>& cov) const
+  {
+    double c[3][3];
+    if (!invert(mInfo, c) || !(c[0][0] > 0. && c[1][1] > 0. && c[2][2] > 0.)) {
+      return false;
+    }
+    for (int i = 0; i < 3; i++) {
+      pos[i] = c[i][0] * mInfoVec[0] + c[i][1] * mInfoVec[1] + c[i][2] * mInfoVec[2];
+    }
+    cov = {static_cast<float>(c[0][0]), static_cast<float>(c[0][1]), static_cast<float>(c[1][1]),
+           static_cast<float>(c[0][2]), static_cast<float>(c[1][2]), static_cast<float>(c[2][2])};
+    return true;
+  }
+
+ private:
+  static void unpack(const std::array<float, 6>& cov, double (&m)[3][3])
+  {
+    m[0][0] = cov[0];
+    m[0][1] = m[1][0] = cov[1];
+    m[1][1] = cov[2];
+    m[0][2] = m[2][0] = cov[3];
+    m[1][2] = m[2][1] = cov[4];
+    m[2][2] = cov[5];
+  }
+
+  /// Inverse of a symmetric 3x3 matrix, false if it is singular or not positive definite
+  static bool invert(const double (&m)[3][3], double (&inv)[3][3])
+  {
+    const double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const double det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (!(det > 0.) || !(m[0][0] > 0.) || !(c00 > 0.)) {
+      return false;
+    }
+    inv[0][0] = c00 / det;
+    inv[0][1] = inv[1][0] = c01 / det;
+    inv[0][2] = inv[2][0] = c02 / det;
+    inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+    inv[1][2] = inv[2][1] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det;
+    inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+    return true;
+  }
+
+  double mInfo[3][3] = {};  ///< inverse of the vertex covariance
+  double mInfoVec[3] = {};  ///< information vector, mInfo times the vertex position
+};
+
+} // namespace o2::analysis
+
+#endif // O2PHYSICS_COMMON_CORE_VERTEXDOWNDATING_H_
@@ -11,10 +11,14 @@
 
 #include <map>
 #include <list>
+#include <deque>
+#include <vector>
+#include <future>
 #include <fstream>
 #include <getopt.h>
 
 #include "TSystem.h"
+#include "TROOT.h"
 #include "TFile.h"
 #include "TTree.h"
 #include "TList.h"
@@ -63,6 +67,18 @@ const char* getTableName(const char* branchName, const char* treeName)
   return tableName;
 }
 
+bool hasIndexColumns(TTree* tree)
+{
+  // index columns have to be shifted entry by entry, trees without them can be copied as they are
+  TObjArray* branches = tree->GetListOfBranches();
+  for (int i = 0; i < branches->GetEntriesFast(); ++i) {
+    if (TString(((TBranch*)branches->UncheckedAt(i))->GetName()).BeginsWith("fIndex")) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // AOD merger with correct index rewriting
 // No need to know the datamodel because the branch names follow a canonical standard (identified by fIndex)
 int main(int argc, char* argv[])
@@ -71,6 +87,11 @@ int main(int argc, char* argv[])
   std::string outputFileName("AO2D.root");
   long maxDirSize = 100000000;
   bool skipNonExistingFiles = false;
+  int nParallel = 0;
+  bool fastCopy = false;
+  long maxDirEntries = 0;
+  std::string targetTable("O2track");
+  std::string manifestFileName("");
   int exitCode = 0; // 0: success, >0: failure
 
   int option_index = 0;
@@ -80,6 +101,11 @@ int main(int argc, char* argv[])
     {"max-size", required_argument, nullptr, 2},
     {"skip-non-existing-files", no_argument, nullptr, 3},
     {"help", no_argument, nullptr, 4},
+    {"parallel", required_argument, nullptr, 5},
+    {"fast-copy", no_argument, nullptr, 6},
+    {"max-entries", required_argument, nullptr, 7},
+    {"target-table", required_argument, nullptr, 8},
+    {"manifest", required_argument, nullptr, 9},
     {nullptr, 0, nullptr, 0}};
 
   while (true) {
@@ -100,7 +126,22 @@ int main(int argc, char* argv[])
       printf("  --output <outputfile.root>   Target output ROOT file. Default: %s\n", outputFileName.c_str());
       printf("  --max-size <size in Bytes>   Target directory size. Default: %ld\n", maxDirSize);
       printf("  --skip-non-existing-files    Flag to allow skipping of non-existing files in the input list.\n");
+      printf("  --parallel <n>               Number of input files opened ahead in parallel and of threads for (de)compression. Default: %d (serial)\n", nParallel);
+      printf("  --fast-copy                  Copy the compressed baskets of the trees without index columns instead of refilling them entry by entry.\n");
+      printf("  --max-entries <entries>      Target number of entries of the target table per directory, 0 for no limit. Default: %ld\n", maxDirEntries);
+      printf("  --target-table <table>       Table whose entries are counted for --max-entries. Default: %s\n", targetTable.c_str());
+      printf("  --manifest <manifest.json>   Writes the entries and sizes of the tables of each output directory to this file. Default: none\n");
       return -1;
+    } else if (c == 5) {
+      nParallel = atoi(optarg);
+    } else if (c == 6) {
+      fastCopy = true;
+    } else if (c == 7) {
+      maxDirEntries = atol(optarg);
+    } else if (c == 8) {
+      targetTable = optarg;
+    } else if (c == 9) {
+      manifestFileName = optarg;
     } else {
       return -2;
     }
@@ -110,43 +151,117 @@ int main(int argc, char* argv[])
   printf("  Input file: %s\n", inputCollection.c_str());
   printf("  Ouput file name: %s\n", outputFileName.c_str());
   printf("  Maximal folder size (uncompressed): %ld\n", maxDirSize);
+  if (maxDirEntries > 0) {
+    printf("  Maximal folder entries of table %s: %ld\n", targetTable.c_str(), maxDirEntries);
+  }
   if (skipNonExistingFiles) {
     printf("  WARNING: Skipping non-existing files.\n");
   }
+  if (nParallel > 0) {
+    printf("  Parallel input files and (de)compression threads: %d\n", nParallel);
+    ROOT::EnableThreadSafety();
+    ROOT::EnableImplicitMT(nParallel);
+  }
+  if (fastCopy) {
+    printf("  Fast copy of the trees without index columns enabled\n");
+  }
 
   std::map<std::string, TTree*> trees;
   std::map<std::string, int> offsets;
   std::map<std::string, int> unassignedIndexOffset;
 
+  TMap* metaData = nullptr;
+  int totalMergedDFs = 0;
+  int mergedDFs = 0;
+
   auto outputFile = TFile::Open(outputFileName.c_str(), "RECREATE", "", 501);
   TDirectory* outputDir = nullptr;
   long currentDirSize = 0;
+  long currentDirEntries = 0;
+  std::string currentParentFile("");
+  TMap parentFiles;
+  parentFiles.SetOwnerKeyValue(true, true);
+  std::ofstream manifest;
+  if (!manifestFileName.empty()) {
+    manifest.open(manifestFileName);
+    manifest << "[";
+  }
+  int nClosedDirs = 0;
+
+  // Writes the trees of the current output folder and records its content
+  auto closeFolder = [&]() {
+    if (!currentParentFile.empty()) {
+      parentFiles.Add(new TObjString(outputDir->GetName()), new TObjString(currentParentFile.c_str()));
+    }
+    if (manifest.is_open()) {
+      manifest << (nClosedDirs > 0 ? "," : "") << "\n  {\"name\": \"" << outputDir->GetName() << "\", \"inputDFs\": " << mergedDFs << ", \"parentFile\": \"" << currentParentFile << "\", \"tables\": [";
+    }
+    int nTables = 0;
+    for (auto const& tree : trees) {
+      // printf("Writing %s\n", tree.first.c_str());
+      outputDir->cd();
+      tree.second->Write();
+      if (manifest.is_open()) {
+        manifest << (nTables++ > 0 ? ", " : "") << "{\"name\": \"" << tree.first << "\", \"entries\": " << tree.second->GetEntries() << ", \"totBytes\": " << tree.second->GetTotBytes() << ", \"zipBytes\": " << tree.second->GetZipBytes() << "}";
+      }
+      delete tree.second;
+    }
+    if (manifest.is_open()) {
+      manifest << "]}";
+    }
+    ++nClosedDirs;
+    outputDir = nullptr;
+    trees.clear();
+    offsets.clear();
+    mergedDFs = 0;
+  };
+
+  // Whether adding a dataframe brings the folder further from the target than it is without it
+  auto overshoots = [](long current, long added, long target) {
+    return target > 0 && current + added > target && current + added - target > target - current;
+  };
 
   std::ifstream in;
   in.open(inputCollection);
+  std::vector<TString> inputFileNames;
   TString line;
-  bool connectedToAliEn = false;
-  TMap* metaData = nullptr;
-  int totalMergedDFs = 0;
-  int mergedDFs = 0;
-  while (in.good() && exitCode == 0) {
+  while (in.good()) {
     in >> line;
-
-    if (line.Length() == 0) {
-      continue;
+    if (line.Length() > 0) {
+      inputFileNames.push_back(line);
     }
+  }
 
-    if (line.BeginsWith("alien:") && !connectedToAliEn) {
+  for (auto const& inputFileName : inputFileNames) {
+    if (inputFileName.BeginsWith("alien:")) {
       printf("Connecting to AliEn...");
       TGrid::Connect("alien:");
-      connectedToAliEn = true; // Only try once
+      break; // Only try once
     }
+  }
 
-    printf("Processing input file: %s\n", line.Data());
+  // Opening the next input files in parallel while the current one is merged: mostly latency on remote files
+  std::deque<std::future<TFile*>> openedFiles;
+  size_t nextFileToOpen = 0;
+  auto openAhead = [&]() {
+    while (nextFileToOpen < inputFileNames.size() && openedFiles.size() <= static_cast<size_t>(nParallel)) {
+      openedFiles.push_back(std::async(nParallel > 0 ? std::launch::async : std::launch::deferred, [fileName = inputFileNames[nextFileToOpen]]() { return TFile::Open(fileName); }));
+      ++nextFileToOpen;
+    }
+  };
 
-    auto inputFile = TFile::Open(line);
+  for (auto const& inputFileName : inputFileNames) {
+    if (exitCode != 0) {
+      break;
+    }
+    openAhead();
+
+    printf("Processing input file: %s\n", inputFileName.Data());
+
+    auto inputFile = openedFiles.front().get();
+    openedFiles.pop_front();
     if (!inputFile) {
-      printf("Error: Could not open input file %s.\n", line.Data());
+      printf("Error: Could not open input file %s.\n", inputFileName.Data());
       if (skipNonExistingFiles) {
         continue;
       } else {
@@ -158,6 +273,7 @@ int main(int argc, char* argv[])
 
     TList* keyList = inputFile->GetListOfKeys();
     keyList->Sort();
+    auto parentFilesCurrentFile = (TMap*)inputFile->Get("parentFiles");
 
     for (auto key1 : *keyList) {
       if (((TObjString*)key1)->GetString().EqualTo("metaData")) {
@@ -190,8 +306,6 @@ int main(int argc, char* argv[])
       auto dfName = ((TObjString*)key1)->GetString().Data();
 
       printf("  Processing folder %s\n", dfName);
-      ++mergedDFs;
-      ++totalMergedDFs;
       auto folder = (TDirectoryFile*)inputFile->Get(dfName);
       auto treeList = folder->GetListOfKeys();
 
@@ -218,6 +332,40 @@ int main(int argc, char* argv[])
         }
       }
 
+      // load the trees to know the size of the DF before merging it
+      std::map<std::string, TTree*> inputTrees;
+      long dfSize = 0;
+      long dfEntries = 0;
+      for (auto key2 : *treeList) {
+        auto treeName = ((TObjString*)key2)->GetString().Data();
+        if (inputTrees.count(treeName) == 0) {
+          auto inputTree = (TTree*)inputFile->Get(Form("%s/%s", dfName, treeName));
+          inputTrees[treeName] = inputTree;
+          dfSize += inputTree->GetTotBytes();
+          if (targetTable == removeVersionSuffix(treeName)) {
+            dfEntries += inputTree->GetEntries();
+          }
+        }
+      }
+      std::string parentFile("");
+      if (parentFilesCurrentFile != nullptr && parentFilesCurrentFile->GetValue(dfName) != nullptr) {
+        parentFile = ((TObjString*)parentFilesCurrentFile->GetValue(dfName))->GetString().Data();
+      }
+
+      // close the current folder before this DF if it gets closer to the targets without it or if the parent file changes
+      if (outputDir) {
+        if (overshoots(currentDirSize, dfSize, maxDirSize) || overshoots(currentDirEntries, dfEntries, maxDirEntries)) {
+          printf("Adding %ld bytes and %ld entries of %s would overshoot the targets: %ld bytes, %ld entries. Closing folder %s.\n", dfSize, dfEntries, targetTable.c_str(), currentDirSize, currentDirEntries, outputDir->GetName());
+          closeFolder();
+        } else if (parentFile != currentParentFile) {
+          printf("Parent file changes from %s to %s. Closing folder %s.\n", currentParentFile.c_str(), parentFile.c_str(), outputDir->GetName());
+          closeFolder();
+        }
+      }
+      currentParentFile = parentFile;
+      ++mergedDFs;
+      ++totalMergedDFs;
+
       std::list<std::string> foundTrees;
 
       for (auto key2 : *treeList) {
@@ -230,7 +378,7 @@ int main(int argc, char* argv[])
         }
         foundTrees.push_back(treeName);
 
-        auto inputTree = (TTree*)inputFile->Get(Form("%s/%s", dfName, treeName));
+        auto inputTree = inputTrees[treeName];
         printf("    Tree %s has %lld entries\n", treeName, inputTree->GetEntries());
 
         if (trees.count(treeName) == 0) {
@@ -244,6 +392,7 @@ int main(int argc, char* argv[])
           if (!outputDir) {
             outputDir = outputFile->mkdir(dfName);
             currentDirSize = 0;
+            currentDirEntries = 0;
             printf("Writing to output folder %s\n", dfName);
           }
           outputDir->cd();
@@ -256,6 +405,14 @@ int main(int argc, char* argv[])
         }
 
         auto outputTree = trees[treeName];
+        if (fastCopy && !hasIndexColumns(inputTree)) {
+          // no index to shift: compressed baskets are copied without unzipping (falls back to entry-by-entry copy if not possible)
+          outputTree->CopyEntries(inputTree, -1, "fast");
+          currentDirSize += inputTree->GetTotBytes();
+          delete inputTree;
+          continue;
+        }
+
         // register index and connect VLA columns
         std::vector<std::pair<int*, int>> indexList;
         std::vector<char*> vlaPointers;
@@ -364,8 +521,12 @@ int main(int argc, char* argv[])
       }
 
       // update offsets
+      currentDirEntries = 0;
       for (auto const& tree : trees) {
         offsets[removeVersionSuffix(tree.first.c_str())] = tree.second->GetEntries();
+        if (targetTable == removeVersionSuffix(tree.first.c_str())) {
+          currentDirEntries += tree.second->GetEntries();
+        }
       }
 
       // check for not found tables
@@ -378,21 +539,28 @@ int main(int argc, char* argv[])
 
       if (currentDirSize > maxDirSize) {
         printf("Maximum size reached: %ld. Closing folder %s.\n", currentDirSize, dfName);
-        for (auto const& tree : trees) {
-          // printf("Writing %s\n", tree.first.c_str());
-          outputDir->cd();
-          tree.second->Write();
-          delete tree.second;
-        }
-        outputDir = nullptr;
-        trees.clear();
-        offsets.clear();
-        mergedDFs = 0;
+        closeFolder();
+      } else if (maxDirEntries > 0 && currentDirEntries >= maxDirEntries) {
+        printf("Maximum entries of %s reached: %ld. Closing folder %s.\n", targetTable.c_str(), currentDirEntries, dfName);
+        closeFolder();
       }
     }
+    delete parentFilesCurrentFile;
     inputFile->Close();
   }
 
+  if (outputDir) {
+    closeFolder();
+  }
+  if (parentFiles.GetEntries() > 0) {
+    outputFile->cd();
+    parentFiles.Write("parentFiles", TObject::kSingleKey);
+  }
+  if (manifest.is_open()) {
+    manifest << "\n]\n";
+    manifest.close();
+  }
+
   outputFile->Write();
   outputFile->Close();
 
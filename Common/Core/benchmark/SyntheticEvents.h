@@ -0,0 +1,209 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file SyntheticEvents.h
+/// \brief Synthetic collisions and tracks for the micro-benchmarks of the core kernels
+///
+/// The tracks have the accessors of the AO2D track, track extra, DCA, TOF and TPC columns used by the kernels, with
+/// values drawn from simple but realistic distributions: exponential pt, flat eta and phi, cluster counts and DCAs around
+/// the selection cuts. The multiplicity of the collisions follows a pp (negative binomial) or a Pb-Pb (flat in centrality)
+/// profile. The generator is seeded, so that the benchmarks always run on the same events.
+
+#ifndef COMMON_CORE_BENCHMARK_SYNTHETICEVENTS_H_
+#define COMMON_CORE_BENCHMARK_SYNTHETICEVENTS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Framework/DataTypes.h"
+
+namespace o2::analysis::bench
+{
+
+/// Collision with the columns used by the kernels
+struct SyntheticCollision {
+  float mPosX = 0.f;
+  float mPosY = 0.f;
+  float mPosZ = 0.f;
+  float mMultTPC = 0.f;
+  float mMultV0M = 0.f;
+
+  float posX() const { return mPosX; }
+  float posY() const { return mPosY; }
+  float posZ() const { return mPosZ; }
+  float multTPC() const { return mMultTPC; }
+  float multV0M() const { return mMultV0M; }
+};
+
+/// Track with the columns used by the kernels
+struct SyntheticTrack {
+  float mPt = 1.f;
+  float mEta = 0.f;
+  float mPhi = 0.f;
+  int8_t mSign = 1;
+  uint8_t mTrackType = o2::aod::track::Run2Track;
+  uint32_t mFlags = 0;
+  int16_t mTPCNClsFound = 0;
+  int16_t mTPCNClsCrossedRows = 0;
+  float mTPCCrossedRowsOverFindableCls = 0.f;
+  float mTPCChi2NCl = 0.f;
+  float mTPCSignal = 0.f;
+  uint8_t mITSNCls = 0;
+  uint8_t mITSClusterMap = 0;
+  float mITSChi2NCl = 0.f;
+  float mDcaXY = 0.f;
+  float mDcaZ = 0.f;
+  bool mHasTOF = false;
+  float mLength = 0.f;
+  float mTOFSignal = 0.f;
+  float mTOFEvTime = 0.f;
+  float mTOFEvTimeErr = 0.f;
+
+  float pt() const { return mPt; }
+  float eta() const { return mEta; }
+  float phi() const { return mPhi; }
+  float p() const { return mPt * std::cosh(mEta); }
+  float px() const { return mPt * std::cos(mPhi); }
+  float py() const { return mPt * std::sin(mPhi); }
+  float pz() const { return mPt * std::sinh(mEta); }
+  float tgl() const { return std::sinh(mEta); }
+  float signed1Pt() const { return mSign / mPt; }
+  float sigma1Pt() const { return 0.01f / mPt; }
+  int8_t sign() const { return mSign; }
+  uint8_t trackType() const { return mTrackType; }
+  uint32_t flags() const { return mFlags; }
+  bool hasTPC() const { return mTPCNClsFound > 0; }
+  bool hasITS() const { return mITSNCls > 0; }
+  bool hasTOF() const { return mHasTOF; }
+  int16_t tpcNClsFound() const { return mTPCNClsFound; }
+  int16_t tpcNClsCrossedRows() const { return mTPCNClsCrossedRows; }
+  float tpcCrossedRowsOverFindableCls() const { return mTPCCrossedRowsOverFindableCls; }
+  float tpcChi2NCl() const { return mTPCChi2NCl; }
+  float tpcSignal() const { return mTPCSignal; }
+  float tpcInnerParam() const { return p(); }
+  uint8_t itsNCls() const { return mITSNCls; }
+  uint8_t itsClusterMap() const { return mITSClusterMap; }
+  float itsChi2NCl() const { return mITSChi2NCl; }
+  float dcaXY() const { return mDcaXY; }
+  float dcaZ() const { return mDcaZ; }
+  float length() const { return mLength; }
+  float tofSignal() const { return mTOFSignal; }
+  float tofEvTime() const { return mTOFEvTime; }
+  float tofEvTimeErr() const { return mTOFEvTimeErr; }
+  float tofExpMom() const { return p() * 0.0299792458f; } // Run 2 convention: p times the speed of light in cm/ps
+  float trackTime() const { return 0.f; }
+  uint32_t pidForTracking() const { return 2; } // pion
+};
+
+/// Multiplicity profile of the collisions
+enum class CollisionSystem { kPP = 0,
+                             kPbPb };
+
+inline std::string getSystemName(CollisionSystem system) { return system == CollisionSystem::kPP ? "pp" : "PbPb"; }
+
+/// Seeded generator of collisions and of their tracks
+class EventGenerator
+{
+ public:
+  /// \param multiplicityScale  factor applied to the mean multiplicity of the profile
+  explicit EventGenerator(CollisionSystem system, uint32_t seed = 12345, double multiplicityScale = 1.) : mSystem(system), mMultiplicityScale(multiplicityScale), mEngine(seed) {}
+
+  /// \return number of tracks of the next collision
+  int generateMultiplicity()
+  {
+    if (mSystem == CollisionSystem::kPP) {
+      // negative binomial as a gamma mixture of Poisson distributions, mean 12 tracks, k = 1.5
+      std::gamma_distribution<double> gamma(1.5, mMultiplicityScale * 12. / 1.5);
+      std::poisson_distribution<int> poisson(gamma(mEngine));
+      return std::max(1, poisson(mEngine));
+    }
+    // flat in the 0-90% centrality, with about 4000 tracks in the most central collisions
+    std::uniform_real_distribution<double> centrality(0., 90.);
+    std::poisson_distribution<int> poisson(mMultiplicityScale * 4000. * std::exp(-centrality(mEngine) / 18.));
+    return std::max(1, poisson(mEngine));
+  }
+
+  /// Fills a collision and its tracks
+  void generate(SyntheticCollision& collision, std::vector<SyntheticTrack>& tracks)
+  {
+    std::normal_distribution<float> gausXY(0.f, 0.005f);
+    std::normal_distribution<float> gausZ(0.f, 6.f);
+    const int multiplicity = generateMultiplicity();
+    collision.mPosX = gausXY(mEngine);
+    collision.mPosY = gausXY(mEngine);
+    collision.mPosZ = gausZ(mEngine);
+    collision.mMultTPC = multiplicity;
+    collision.mMultV0M = 8.f * multiplicity;
+
+    std::exponential_distribution<float> pt(1.f / 0.6f);
+    std::uniform_real_distribution<float> eta(-1.2f, 1.2f);
+    std::uniform_real_distribution<float> phi(0.f, 2.f * static_cast<float>(M_PI));
+    std::uniform_real_distribution<float> flat(0.f, 1.f);
+    std::normal_distribution<float> gaus(0.f, 1.f);
+    tracks.resize(multiplicity);
+    for (auto& track : tracks) {
+      track.mPt = 0.05f + pt(mEngine);
+      track.mEta = eta(mEngine);
+      track.mPhi = phi(mEngine);
+      track.mSign = flat(mEngine) < 0.5f ? -1 : 1;
+      track.mFlags = (flat(mEngine) < 0.9f ? o2::aod::track::TPCrefit : 0) | (flat(mEngine) < 0.85f ? o2::aod::track::ITSrefit : 0) | (flat(mEngine) < 0.95f ? o2::aod::track::GoldenChi2 : 0);
+      track.mTPCNClsFound = static_cast<int16_t>(40 + 119 * flat(mEngine));
+      track.mTPCNClsCrossedRows = static_cast<int16_t>(track.mTPCNClsFound + 5 * flat(mEngine));
+      track.mTPCCrossedRowsOverFindableCls = 0.7f + 0.4f * flat(mEngine);
+      track.mTPCChi2NCl = 0.5f + 4.f * flat(mEngine);
+      track.mITSNCls = static_cast<uint8_t>(7 * flat(mEngine));
+      track.mITSClusterMap = static_cast<uint8_t>(64 * flat(mEngine));
+      track.mITSChi2NCl = 40.f * flat(mEngine);
+      track.mDcaXY = 0.05f * gaus(mEngine);
+      track.mDcaZ = 0.5f * gaus(mEngine);
+      const float p = track.p();
+      // dE/dx around the pion Bethe-Bloch curve and a TOF time for a pion at the radius of the TOF
+      track.mTPCSignal = 50.f * (1.f + 1.f / (p * p)) * (1.f + 0.07f * gaus(mEngine));
+      track.mHasTOF = p > 0.3f && flat(mEngine) < 0.6f;
+      track.mLength = 370.f * std::cosh(track.mEta);
+      const float beta = p / std::sqrt(p * p + 0.13957f * 0.13957f);
+      track.mTOFEvTime = 20.f * gaus(mEngine);
+      track.mTOFEvTimeErr = 20.f;
+      track.mTOFSignal = track.mLength / (beta * 0.0299792458f) + track.mTOFEvTime + 80.f * gaus(mEngine);
+    }
+  }
+
+ private:
+  CollisionSystem mSystem;
+  double mMultiplicityScale = 1.;
+  std::mt19937 mEngine;
+};
+
+/// Collisions and tracks generated once, the tracks of all the collisions are contiguous
+struct SyntheticDataFrame {
+  std::vector<SyntheticCollision> collisions;
+  std::vector<std::vector<SyntheticTrack>> tracksPerCollision;
+  std::vector<SyntheticTrack> tracks;
+
+  SyntheticDataFrame(CollisionSystem system, int nCollisions, uint32_t seed = 12345)
+  {
+    EventGenerator generator(system, seed);
+    collisions.resize(nCollisions);
+    tracksPerCollision.resize(nCollisions);
+    for (int i = 0; i < nCollisions; i++) {
+      generator.generate(collisions[i], tracksPerCollision[i]);
+      tracks.insert(tracks.end(), tracksPerCollision[i].begin(), tracksPerCollision[i].end());
+    }
+  }
+};
+
+} // namespace o2::analysis::bench
+
+#endif // COMMON_CORE_BENCHMARK_SYNTHETICEVENTS_H_
@@ -0,0 +1,315 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file benchCoreKernels.cxx
+/// \brief Micro-benchmarks of the core kernels on synthetic pp and Pb-Pb data frames
+///
+/// Each benchmark runs over a data frame of pp (argument 0) or Pb-Pb (argument 1) collisions generated once with a fixed
+/// seed, and reports the number of processed items (tracks, pairs or collisions) per second.
+/// The results can be written in a machine-readable format with the options of Google Benchmark, e.g.
+///   o2-bench-core-kernels --benchmark_format=json --benchmark_out=coreKernels.json
+/// and compared between two builds with the compare.py tool of Google Benchmark.
+
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ReconstructionDataFormats/PID.h"
+
+#include "Common/Core/EventMixing.h"
+#include "Common/Core/PID/PIDTOF.h"
+#include "Common/Core/PID/TPCPIDResponse.h"
+#include "Common/Core/RecoDecay.h"
+#include "Common/Core/TrackCovarianceBatch.h"
+#include "Common/Core/TrackSelection.h"
+#include "Common/Core/TrackSelectionDefaults.h"
+#include "Common/Core/benchmark/SyntheticEvents.h"
+#include "PWGCF/FemtoDream/FemtoDreamMath.h"
+#include "PWGCF/GenericFramework/GFWCumulant.h"
+
+using namespace o2::analysis::bench;
+
+namespace
+{
+constexpr int nCollisionsPP = 2000;
+constexpr int nCollisionsPbPb = 20;
+constexpr float massPion = 0.13957f;
+constexpr float massKaon = 0.493677f;
+
+/// Data frame of the system of the benchmark argument, generated at the first use
+const SyntheticDataFrame& getDataFrame(const benchmark::State& state)
+{
+  static std::map<CollisionSystem, std::unique_ptr<SyntheticDataFrame>> dataFrames;
+  const auto system = static_cast<CollisionSystem>(state.range(0));
+  auto& dataFrame = dataFrames[system];
+  if (!dataFrame) {
+    dataFrame = std::make_unique<SyntheticDataFrame>(system, system == CollisionSystem::kPP ? nCollisionsPP : nCollisionsPbPb);
+  }
+  return *dataFrame;
+}
+
+void setCounters(benchmark::State& state, std::size_t itemsPerIteration)
+{
+  state.SetItemsProcessed(state.iterations() * itemsPerIteration);
+  state.SetLabel(getSystemName(static_cast<CollisionSystem>(state.range(0))));
+}
+} // namespace
+
+/// Invariant mass and cosine of pointing angle of consecutive track pairs
+static void BM_RecoDecayMassCPA(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  const std::array<double, 2> masses{massPion, massKaon};
+  std::size_t nPairs = 0;
+  for (auto _ : state) {
+    nPairs = 0;
+    for (std::size_t c = 0; c < dataFrame.collisions.size(); c++) {
+      const auto& collision = dataFrame.collisions[c];
+      const auto& tracks = dataFrame.tracksPerCollision[c];
+      const std::array<float, 3> pv{collision.posX(), collision.posY(), collision.posZ()};
+      for (std::size_t i = 1; i < tracks.size(); i++) {
+        const std::array<float, 3> mom0{tracks[i - 1].px(), tracks[i - 1].py(), tracks[i - 1].pz()};
+        const std::array<float, 3> mom1{tracks[i].px(), tracks[i].py(), tracks[i].pz()};
+        const std::array<float, 3> sv{pv[0] + 0.01f * mom0[0], pv[1] + 0.01f * mom0[1], pv[2] + 0.01f * mom0[2]};
+        benchmark::DoNotOptimize(RecoDecay::m(std::array{mom0, mom1}, masses));
+        benchmark::DoNotOptimize(RecoDecay::cpa(pv, sv, RecoDecay::pVec(mom0, mom1)));
+        nPairs++;
+      }
+    }
+  }
+  setCounters(state, nPairs);
+}
+BENCHMARK(BM_RecoDecayMassCPA)->Arg(0)->Arg(1);
+
+/// Global track selection, one track at a time
+static void BM_TrackSelectionIsSelected(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  TrackSelection selection = getGlobalTrackSelection();
+  for (auto _ : state) {
+    for (const auto& track : dataFrame.tracks) {
+      benchmark::DoNotOptimize(selection.IsSelected(track));
+    }
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_TrackSelectionIsSelected)->Arg(0)->Arg(1);
+
+/// Global track selection, all the tracks of the data frame at once
+static void BM_TrackSelectionIsSelectedMasks(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  TrackSelection selection = getGlobalTrackSelection();
+  std::vector<uint16_t> masks;
+  for (auto _ : state) {
+    selection.IsSelectedMasks(dataFrame.tracks, masks);
+    benchmark::DoNotOptimize(masks.data());
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_TrackSelectionIsSelectedMasks)->Arg(0)->Arg(1);
+
+/// Mixing bin of the collisions, with the bin edges and with a binning set up once
+static void BM_EventMixingGetMixingBin(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  const std::vector<float> vtxBins{-10.f, -8.f, -6.f, -4.f, -2.f, 0.f, 2.f, 4.f, 6.f, 8.f, 10.f};
+  const std::vector<float> multBins{0.f, 200.f, 400.f, 800.f, 1600.f, 3200.f, 6400.f, 12800.f, 25600.f, 51200.f};
+  for (auto _ : state) {
+    for (const auto& collision : dataFrame.collisions) {
+      benchmark::DoNotOptimize(eventmixing::getMixingBin(vtxBins, multBins, collision.posZ(), collision.multV0M()));
+    }
+  }
+  setCounters(state, dataFrame.collisions.size());
+}
+BENCHMARK(BM_EventMixingGetMixingBin)->Arg(0)->Arg(1);
+
+static void BM_EventMixingGetMixingBinBinning(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  eventmixing::MixingBinning binning;
+  binning.addAxis({-10.f, -8.f, -6.f, -4.f, -2.f, 0.f, 2.f, 4.f, 6.f, 8.f, 10.f});
+  binning.addAxis({0.f, 200.f, 400.f, 800.f, 1600.f, 3200.f, 6400.f, 12800.f, 25600.f, 51200.f});
+  for (auto _ : state) {
+    for (const auto& collision : dataFrame.collisions) {
+      benchmark::DoNotOptimize(eventmixing::getMixingBin(binning, collision.posZ(), collision.multV0M()));
+    }
+  }
+  setCounters(state, dataFrame.collisions.size());
+}
+BENCHMARK(BM_EventMixingGetMixingBinBinning)->Arg(0)->Arg(1);
+
+/// TOF Nsigma of the pion, kaon and proton hypotheses
+static void BM_TOFExpTimesSeparation(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  const o2::pid::tof::TOFResoParams parameters;
+  using ResponsePi = o2::pid::tof::ExpTimes<SyntheticTrack, o2::track::PID::Pion>;
+  using ResponseKa = o2::pid::tof::ExpTimes<SyntheticTrack, o2::track::PID::Kaon>;
+  using ResponsePr = o2::pid::tof::ExpTimes<SyntheticTrack, o2::track::PID::Proton>;
+  for (auto _ : state) {
+    for (const auto& track : dataFrame.tracks) {
+      benchmark::DoNotOptimize(ResponsePi::GetSeparation(parameters, track));
+      benchmark::DoNotOptimize(ResponseKa::GetSeparation(parameters, track));
+      benchmark::DoNotOptimize(ResponsePr::GetSeparation(parameters, track));
+    }
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_TOFExpTimesSeparation)->Arg(0)->Arg(1);
+
+/// TPC Nsigma of the pion hypothesis, one track at a time
+static void BM_TPCResponseNumberOfSigma(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  const o2::pid::tpc::Response response;
+  for (auto _ : state) {
+    for (std::size_t c = 0; c < dataFrame.collisions.size(); c++) {
+      for (const auto& track : dataFrame.tracksPerCollision[c]) {
+        benchmark::DoNotOptimize(response.GetNumberOfSigma(dataFrame.collisions[c], track, o2::track::PID::Pion));
+      }
+    }
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_TPCResponseNumberOfSigma)->Arg(0)->Arg(1);
+
+/// TPC Nsigma of the pion hypothesis, all the tracks of the data frame at once
+static void BM_TPCResponseNumberOfSigmas(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  const o2::pid::tpc::Response response;
+  const std::size_t nTracks = dataFrame.tracks.size();
+  std::vector<float> tpcInnerParam(nTracks), tpcSignal(nTracks), tpcNClsFound(nTracks), tgl(nTracks), signed1Pt(nTracks), multTPC(nTracks), nSigma(nTracks);
+  std::size_t i = 0;
+  for (std::size_t c = 0; c < dataFrame.collisions.size(); c++) {
+    for (const auto& track : dataFrame.tracksPerCollision[c]) {
+      tpcInnerParam[i] = track.tpcInnerParam();
+      tpcSignal[i] = track.tpcSignal();
+      tpcNClsFound[i] = track.tpcNClsFound();
+      tgl[i] = track.tgl();
+      signed1Pt[i] = track.signed1Pt();
+      multTPC[i] = dataFrame.collisions[c].multTPC();
+      i++;
+    }
+  }
+  const o2::pid::tpc::Response::TrackBatch batch{tpcInnerParam.data(), tpcSignal.data(), tpcNClsFound.data(), tgl.data(), signed1Pt.data(), multTPC.data(), nTracks};
+  for (auto _ : state) {
+    response.GetNumberOfSigmas(batch, o2::track::PID::Pion, nSigma.data());
+    benchmark::DoNotOptimize(nSigma.data());
+  }
+  setCounters(state, nTracks);
+}
+BENCHMARK(BM_TPCResponseNumberOfSigmas)->Arg(0)->Arg(1);
+
+/// Q-vectors of the harmonics 1 to 6 and powers 0 to 4 of each collision, one particle at a time
+static void BM_GFWCumulantFillArray(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  GFWCumulant cumulant;
+  cumulant.SetType(GFWCumulant::kFull);
+  cumulant.CreateComplexVectorArray(7, 5, 1);
+  for (auto _ : state) {
+    for (const auto& tracks : dataFrame.tracksPerCollision) {
+      cumulant.ResetQs();
+      for (const auto& track : tracks) {
+        cumulant.FillArray(track.eta(), 0, track.phi());
+      }
+      benchmark::DoNotOptimize(cumulant.fQRe.data());
+    }
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_GFWCumulantFillArray)->Arg(0)->Arg(1);
+
+/// Same as BM_GFWCumulantFillArray, with the batch fill of each collision
+static void BM_GFWCumulantFillArrayBatch(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  GFWCumulant cumulant;
+  cumulant.SetType(GFWCumulant::kFull);
+  cumulant.CreateComplexVectorArray(7, 5, 1);
+  std::vector<double> eta, phi, weight;
+  std::vector<int> ptBin;
+  for (auto _ : state) {
+    for (const auto& tracks : dataFrame.tracksPerCollision) {
+      cumulant.ResetQs();
+      eta.resize(tracks.size());
+      phi.resize(tracks.size());
+      weight.assign(tracks.size(), 1.);
+      ptBin.assign(tracks.size(), 0);
+      for (std::size_t i = 0; i < tracks.size(); i++) {
+        eta[i] = tracks[i].eta();
+        phi[i] = tracks[i].phi();
+      }
+      cumulant.FillArray(tracks.size(), eta.data(), ptBin.data(), phi.data(), weight.data());
+      benchmark::DoNotOptimize(cumulant.fQRe.data());
+    }
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_GFWCumulantFillArrayBatch)->Arg(0)->Arg(1);
+
+/// k* of consecutive proton pairs
+static void BM_FemtoDreamMathGetkstar(benchmark::State& state)
+{
+  const auto& dataFrame = getDataFrame(state);
+  constexpr float massProton = 0.938272f;
+  for (auto _ : state) {
+    for (std::size_t i = 1; i < dataFrame.tracks.size(); i++) {
+      benchmark::DoNotOptimize(o2::analysis::femtoDream::FemtoDreamMath::getkstar(dataFrame.tracks[i - 1], massProton, dataFrame.tracks[i], massProton));
+    }
+  }
+  setCounters(state, dataFrame.tracks.size() - 1);
+}
+BENCHMARK(BM_FemtoDreamMathGetkstar)->Arg(0)->Arg(1);
+
+/// Sigmas and correlations of the covariance matrices of all the tracks of the data frame, and their dense histograms
+static void BM_TrackCovarianceBatch(benchmark::State& state)
+{
+  using o2::analysis::DenseHistogram;
+  using o2::analysis::TrackCovarianceBatch;
+  const auto& dataFrame = getDataFrame(state);
+  // covariance matrices with resolutions scaling with 1/pt and fixed correlations
+  TrackCovarianceBatch batch;
+  const float rho[TrackCovarianceBatch::kNCorrelations] = {0.1f, 0.5f, 0.05f, 0.05f, 0.5f, 0.02f, -0.6f, -0.05f, -0.3f, -0.03f};
+  for (const auto& track : dataFrame.tracks) {
+    const float sigma[TrackCovarianceBatch::kNParameters] = {0.002f + 0.01f / track.pt(), 0.002f + 0.01f / track.pt(), 0.001f, 0.001f, 0.01f / track.pt()};
+    int iCorrelation = 0;
+    for (int row = 0; row < TrackCovarianceBatch::kNParameters; row++) {
+      for (int column = 0; column < row; column++) {
+        batch.elements[row * (row + 1) / 2 + column].push_back(rho[iCorrelation++] * sigma[row] * sigma[column]);
+      }
+      batch.elements[row * (row + 1) / 2 + row].push_back(sigma[row] * sigma[row]);
+    }
+  }
+  std::array<DenseHistogram, TrackCovarianceBatch::kNParameters> sigmaHistos;
+  sigmaHistos.fill(DenseHistogram(1000, 0.f, 0.1f));
+  std::array<DenseHistogram, TrackCovarianceBatch::kNCorrelations> correlationHistos;
+  correlationHistos.fill(DenseHistogram(200, -1.f, 1.f));
+  for (auto _ : state) {
+    batch.compute();
+    for (int i = 0; i < TrackCovarianceBatch::kNParameters; i++) {
+      sigmaHistos[i].fill(batch.sigmas[i]);
+    }
+    for (int i = 0; i < TrackCovarianceBatch::kNCorrelations; i++) {
+      correlationHistos[i].fill(batch.correlations[i]);
+    }
+    benchmark::DoNotOptimize(correlationHistos.back().counts().data());
+  }
+  setCounters(state, dataFrame.tracks.size());
+}
+BENCHMARK(BM_TrackCovarianceBatch)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -17,6 +17,10 @@
 #ifndef O2_ANALYSIS_TRACKUTILITIES_H_
 #define O2_ANALYSIS_TRACKUTILITIES_H_
 
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 #include "ReconstructionDataFormats/Track.h"
 #include "ReconstructionDataFormats/Vertex.h"
 #include "Common/Core/RecoDecay.h"
@@ -90,4 +94,227 @@ auto getRotatedCovMatrixXX(const T& matrix, U phi, V theta)
          + matrix[5] * st * st;               // covZZ
 }
 
+/// Helix of a track in the bending plane, in float precision, used for fast estimates of the closest approach of track pairs.
+struct TrackHelixXY {
+  float xC;  ///< x of the circle centre (cm)
+  float yC;  ///< y of the circle centre (cm)
+  float r;   ///< signed radius of the circle (cm), positive for anticlockwise motion
+  float x0;  ///< x of the reference point (cm)
+  float y0;  ///< y of the reference point (cm)
+  float z0;  ///< z of the reference point (cm)
+  float pt;  ///< transverse momentum (GeV/c)
+  float tgl; ///< tangent of the dip angle
+};
+
+/// Extracts the helix of a track at its reference point.
+/// \param trackPar  track parametrisation
+/// \param bz  magnetic field along z (kG)
+/// \return helix in the global frame; a straight track is returned with zero radius
+template <typename T>
+TrackHelixXY getTrackHelixXY(const T& trackPar, float bz)
+{
+  constexpr float b2c = -0.299792458e-3f; // kG * (GeV/c)^-1 to cm^-1, same convention as o2::constants::math::B2C
+  constexpr float crvMin = 1.e-6f;        // below this curvature the circle cannot be handled in float precision
+  TrackHelixXY helix;
+  const float cosAlpha = std::cos(trackPar.getAlpha());
+  const float sinAlpha = std::sin(trackPar.getAlpha());
+  const float snp = trackPar.getSnp();
+  const float csp = std::sqrt((1.f - snp) * (1.f + snp));
+  const float crv = trackPar.getQ2Pt() * bz * b2c;
+  helix.x0 = cosAlpha * trackPar.getX() - sinAlpha * trackPar.getY();
+  helix.y0 = sinAlpha * trackPar.getX() + cosAlpha * trackPar.getY();
+  helix.z0 = trackPar.getZ();
+  helix.pt = trackPar.getPt();
+  helix.tgl = trackPar.getTgl();
+  helix.r = std::abs(crv) < crvMin ? 0.f : 1.f / crv;
+  // the centre lies at a distance r on the left of the direction of motion {cos(alpha + phi), sin(alpha + phi)}
+  const float dirX = cosAlpha * csp - sinAlpha * snp;
+  const float dirY = sinAlpha * csp + cosAlpha * snp;
+  helix.xC = helix.x0 - dirY * helix.r;
+  helix.yC = helix.y0 + dirX * helix.r;
+  return helix;
+}
+
+/// Estimates the closest approach of two tracks from the crossings of their helices in the bending plane.
+/// If the circles cross, the crossing with the smaller distance in z is taken, otherwise the points of closest approach in the bending plane.
+/// \param helix0,helix1  helices of the two tracks
+/// \param pca  {x, y, z} estimated point of closest approach, half way between the tracks
+/// \param pVec0,pVec1  estimated momenta of the two tracks at the point of closest approach
+/// \return estimated distance of closest approach (cm), negative if no estimate could be made
+inline float getHelixClosestApproach(const TrackHelixXY& helix0, const TrackHelixXY& helix1, std::array<float, 3>& pca, std::array<float, 3>& pVec0, std::array<float, 3>& pVec1)
+{
+  const float r0 = std::abs(helix0.r);
+  const float r1 = std::abs(helix1.r);
+  const float dxC = helix1.xC - helix0.xC;
+  const float dyC = helix1.yC - helix0.yC;
+  const float dC = std::sqrt(dxC * dxC + dyC * dyC);
+  if (r0 == 0.f || r1 == 0.f || dC < 1.e-6f) {
+    return -1.f;
+  }
+  const float ux = dxC / dC;
+  const float uy = dyC / dC;
+
+  // candidate points on circle 0 and circle 1
+  std::array<std::array<float, 4>, 2> points;
+  int nPoints = 1;
+  if (dC > r0 + r1) { // separate circles
+    points[0] = {helix0.xC + r0 * ux, helix0.yC + r0 * uy, helix1.xC - r1 * ux, helix1.yC - r1 * uy};
+  } else if (dC < std::abs(r0 - r1)) { // one circle inside the other
+    const float sign = r0 > r1 ? 1.f : -1.f;
+    points[0] = {helix0.xC + sign * r0 * ux, helix0.yC + sign * r0 * uy, helix1.xC + sign * r1 * ux, helix1.yC + sign * r1 * uy};
+  } else { // crossing circles
+    const float a = (r0 * r0 - r1 * r1 + dC * dC) / (2.f * dC);
+    const float h = std::sqrt(std::max(0.f, r0 * r0 - a * a));
+    const float xM = helix0.xC + a * ux;
+    const float yM = helix0.yC + a * uy;
+    points[0] = {xM - h * uy, yM + h * ux, xM - h * uy, yM + h * ux};
+    points[1] = {xM + h * uy, yM - h * ux, xM + h * uy, yM - h * ux};
+    nPoints = 2;
+  }
+
+  // z of a track at a point of its circle, from the signed arc length from the reference point
+  auto getZ = [](const TrackHelixXY& helix, float x, float y) {
+    const float xRef = helix.x0 - helix.xC;
+    const float yRef = helix.y0 - helix.yC;
+    const float xP = x - helix.xC;
+    const float yP = y - helix.yC;
+    const float dPhi = std::atan2(xRef * yP - yRef * xP, xRef * xP + yRef * yP);
+    return helix.z0 + helix.tgl * dPhi * helix.r;
+  };
+
+  float dca2 = -1.f;
+  for (int iPoint = 0; iPoint < nPoints; ++iPoint) {
+    const auto& point = points[iPoint];
+    const float z0 = getZ(helix0, point[0], point[1]);
+    const float z1 = getZ(helix1, point[2], point[3]);
+    const float dist2 = (point[2] - point[0]) * (point[2] - point[0]) + (point[3] - point[1]) * (point[3] - point[1]) + (z1 - z0) * (z1 - z0);
+    if (dca2 >= 0.f && dist2 >= dca2) {
+      continue;
+    }
+    dca2 = dist2;
+    pca = {0.5f * (point[0] + point[2]), 0.5f * (point[1] + point[3]), 0.5f * (z0 + z1)};
+    // the direction of motion is the radius vector rotated by 90 degrees, towards the sign of the curvature
+    pVec0 = {-(point[1] - helix0.yC) / helix0.r * helix0.pt, (point[0] - helix0.xC) / helix0.r * helix0.pt, helix0.pt * helix0.tgl};
+    pVec1 = {-(point[3] - helix1.yC) / helix1.r * helix1.pt, (point[2] - helix1.xC) / helix1.r * helix1.pt, helix1.pt * helix1.tgl};
+  }
+  return std::sqrt(dca2);
+}
+
+/// Parameters of a batch of tracks and of their vertices, one entry per track in each array, for propagateToDCABatch.
+struct TrackParBatch {
+  std::vector<float> x, alpha, y, z, snp, tgl, q2pt; ///< track parametrisation
+  std::vector<float> xV, yV, zV;                     ///< vertex of each track
+
+  std::size_t size() const { return x.size(); }
+
+  void clear()
+  {
+    for (auto* column : {&x, &alpha, &y, &z, &snp, &tgl, &q2pt, &xV, &yV, &zV}) {
+      column->clear();
+    }
+  }
+
+  void reserve(std::size_t n)
+  {
+    for (auto* column : {&x, &alpha, &y, &z, &snp, &tgl, &q2pt, &xV, &yV, &zV}) {
+      column->reserve(n);
+    }
+  }
+
+  /// \param track  track with the parametrisation columns
+  /// \param vertex  {x, y, z} of the vertex
+  template <typename T, typename V>
+  void push_back(const T& track, const V& vertex)
+  {
+    x.push_back(track.x());
+    alpha.push_back(track.alpha());
+    y.push_back(track.y());
+    z.push_back(track.z());
+    snp.push_back(track.snp());
+    tgl.push_back(track.tgl());
+    q2pt.push_back(track.signed1Pt());
+    xV.push_back(vertex[0]);
+    yV.push_back(vertex[1]);
+    zV.push_back(vertex[2]);
+  }
+};
+
+/// Propagates a batch of tracks to the DCA to their vertex in a constant field, as TrackParametrization::propagateParamToDCA.
+/// The loop runs on the columns of the batch and the rotation to the DCA frame is done without trigonometric functions,
+/// the result agrees with propagateParamToDCA within float rounding.
+/// \param tracks  tracks and vertices
+/// \param bz  magnetic field along z (kG)
+/// \param dcaXY,dcaZ  output arrays with tracks.size() entries, set to 1e10 for the tracks which cannot be propagated
+/// \param maxD  maximum estimated distance to the vertex (cm), as in propagateParamToDCA
+inline void propagateToDCABatch(const TrackParBatch& tracks, float bz, float* dcaXY, float* dcaZ, float maxD = 999.f)
+{
+  constexpr float b2c = -0.299792458e-3f; // kG * (GeV/c)^-1 to cm^-1, same convention as o2::constants::math::B2C
+  constexpr float almost0 = 1.17549e-38f; // o2::constants::math::Almost0
+  constexpr float almost1 = 1.f - almost0;
+  constexpr float invalid = 1e10f;
+  constexpr float pi = 3.14159265358979323846f;
+  for (std::size_t i = 0; i < tracks.size(); i++) {
+    dcaXY[i] = invalid;
+    dcaZ[i] = invalid;
+    const float cosAlpha = std::cos(tracks.alpha[i]);
+    const float sinAlpha = std::sin(tracks.alpha[i]);
+    const float snp = tracks.snp[i];
+    const float csp = std::sqrt((1.f - snp) * (1.f + snp));
+    // vertex in the track frame
+    float xV = tracks.xV[i] * cosAlpha + tracks.yV[i] * sinAlpha;
+    float yV = -tracks.xV[i] * sinAlpha + tracks.yV[i] * cosAlpha;
+    const float dx = tracks.x[i] - xV;
+    const float dy = tracks.y[i] - yV;
+    // impact parameter neglecting the curvature
+    if (std::abs(dx * snp - dy * csp) > maxD) {
+      continue;
+    }
+    const float crv = tracks.q2pt[i] * bz * b2c;
+    const float tgfv = -(crv * dx - snp) / (crv * dy + csp);
+    const float sinRot = tgfv / std::sqrt(1.f + tgfv * tgfv);
+    const float cosRot = std::abs(tgfv) > almost0 ? sinRot / tgfv : almost1;
+    // vertex and track in the frame rotated by asin(sinRot)
+    const float xVRot = xV * cosRot + yV * sinRot;
+    yV = -xV * sinRot + yV * cosRot;
+    xV = xVRot;
+    if (std::abs(snp) > almost1) {
+      continue;
+    }
+    const float f1 = snp * cosRot - csp * sinRot;
+    if (std::abs(f1) > almost1) {
+      continue;
+    }
+    const float xRot = tracks.x[i] * cosRot + tracks.y[i] * sinRot;
+    float yRot = -tracks.x[i] * sinRot + tracks.y[i] * cosRot;
+    float zRot = tracks.z[i];
+    // propagation along x to the vertex
+    const float dxProp = xV - xRot;
+    if (std::abs(dxProp) >= almost0) {
+      const float x2r = crv * dxProp;
+      const float f2 = f1 + x2r;
+      if (std::abs(f2) > almost1) {
+        continue;
+      }
+      const float r1 = std::sqrt((1.f - f1) * (1.f + f1));
+      const float r2 = std::sqrt((1.f - f2) * (1.f + f2));
+      if (std::abs(r1) < almost0 || std::abs(r2) < almost0) {
+        continue;
+      }
+      const float dy2dx = (f1 + f2) / (r1 + r2);
+      yRot += dxProp * dy2dx;
+      if (std::abs(x2r) < 0.05f) {
+        zRot += dxProp * (r2 + f2 * dy2dx) * tracks.tgl[i];
+      } else { // arc length from the rotation angle, for the large steps
+        float rot = std::asin(r1 * f2 - r2 * f1);
+        if (f1 * f1 + f2 * f2 > 1.f && f1 * f2 < 0.f) { // special cases of large rotations or large abs angles
+          rot = f2 > 0.f ? pi - rot : -pi - rot;
+        }
+        zRot += tracks.tgl[i] / crv * rot;
+      }
+    }
+    dcaXY[i] = yRot - yV;
+    dcaZ[i] = zRot - tracks.zV[i];
+  }
+}
+
 #endif // O2_ANALYSIS_TRACKUTILITIES_H_
@@ -0,0 +1,43 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CollisionSlices.h
+/// \brief  Ranges of the tracks, forward tracks, MFT tracks and V0s of each collision, produced by the collision-slices task
+///
+/// The ranges are slice index columns, joinable with the Collisions: a task subscribing to the target table gets the
+/// rows of a collision with e.g. collision.tracks_as<MyTracks>(), without slicing the table by the collision index again.
+/// Empty ranges are checked with has_tracks() etc. The target tables must be sorted by collision index, as for grouping.
+///
+
+#ifndef O2_ANALYSIS_COLLISIONSLICES_H_
+#define O2_ANALYSIS_COLLISIONSLICES_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace collslice
+{
+DECLARE_SOA_SLICE_INDEX_COLUMN(Track, tracks);       //! Tracks of the collision
+DECLARE_SOA_SLICE_INDEX_COLUMN(FwdTrack, fwdtracks); //! Forward tracks of the collision
+DECLARE_SOA_SLICE_INDEX_COLUMN(MFTTrack, mfttracks); //! MFT tracks of the collision
+DECLARE_SOA_SLICE_INDEX_COLUMN(V0, v0s);             //! V0s of the collision
+} // namespace collslice
+
+DECLARE_SOA_TABLE(CollisionSlices, "AOD", "COLLSLICES", //! Ranges of the rows of each collision in the track and V0 tables, joinable with the Collisions
+                  collslice::TrackIdSlice, collslice::FwdTrackIdSlice, collslice::MFTTrackIdSlice, collslice::V0IdSlice);
+using CollisionSlice = CollisionSlices::iterator;
+
+using CollisionsWithSlices = soa::Join<Collisions, CollisionSlices>;
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_COLLISIONSLICES_H_
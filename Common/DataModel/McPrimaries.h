@@ -0,0 +1,49 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   McPrimaries.h
+/// \brief  Compact generator-level table of the primary particles in acceptance, written by the mc-primaries task
+///
+/// Each row keeps the kinematics, the PDG code and the charge of one selected MC particle, the charge being looked up
+/// once in the PDG database by the producer. The index of the MC particle gives access to its mothers and daughters
+/// when a task needs them. Generator-level studies grouped by MC collision then read a few columns of the selected
+/// particles instead of the full McParticles.
+///
+
+#ifndef O2_ANALYSIS_MCPRIMARIES_H_
+#define O2_ANALYSIS_MCPRIMARIES_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace mcprimary
+{
+DECLARE_SOA_INDEX_COLUMN(McCollision, mcCollision); //! MC collision of the particle
+DECLARE_SOA_INDEX_COLUMN(McParticle, mcParticle);   //! MC particle, with the mothers and the daughters
+DECLARE_SOA_COLUMN(Pt, pt, float);                  //! Transverse momentum
+DECLARE_SOA_COLUMN(Eta, eta, float);                //! Pseudorapidity
+DECLARE_SOA_COLUMN(Phi, phi, float);                //! Azimuthal angle, in [0, 2 pi)
+DECLARE_SOA_COLUMN(PdgCode, pdgCode, int);          //! PDG code
+DECLARE_SOA_COLUMN(Charge, charge, int8_t);         //! Charge in units of |e|/3, as in the PDG database, 0 for unknown codes
+DECLARE_SOA_DYNAMIC_COLUMN(IsCharged, isCharged,    //! Whether the absolute charge is at least |e|
+                           [](int8_t charge) -> bool { return charge >= 3 || charge <= -3; });
+} // namespace mcprimary
+
+DECLARE_SOA_TABLE(McPrimaries, "AOD", "MCPRIMARY", //! Selected primary MC particles, grouped by MC collision
+                  mcprimary::McCollisionId, mcprimary::McParticleId,
+                  mcprimary::Pt, mcprimary::Eta, mcprimary::Phi, mcprimary::PdgCode, mcprimary::Charge,
+                  mcprimary::IsCharged<mcprimary::Charge>);
+using McPrimary = McPrimaries::iterator;
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_MCPRIMARIES_H_
@@ -1042,6 +1042,16 @@ DECLARE_SOA_COLUMN(BayesHe, bayesHe, binned_prob_t);                //! Bayesian
 DECLARE_SOA_COLUMN(BayesAl, bayesAl, binned_prob_t);                //! Bayesian probability for alpha expressed in %
 DECLARE_SOA_COLUMN(BayesProb, bayesProb, binned_prob_t);            //! Bayesian probability of the most probable ID
 DECLARE_SOA_COLUMN(BayesID, bayesID, o2::track::pid_constants::ID); //! Most probable ID
+// Bayesian probabilities with full precision
+DECLARE_SOA_COLUMN(BayesFullEl, bayesFullEl, float); //! Bayesian probability for electron
+DECLARE_SOA_COLUMN(BayesFullMu, bayesFullMu, float); //! Bayesian probability for muon
+DECLARE_SOA_COLUMN(BayesFullPi, bayesFullPi, float); //! Bayesian probability for pion
+DECLARE_SOA_COLUMN(BayesFullKa, bayesFullKa, float); //! Bayesian probability for kaon
+DECLARE_SOA_COLUMN(BayesFullPr, bayesFullPr, float); //! Bayesian probability for proton
+DECLARE_SOA_COLUMN(BayesFullDe, bayesFullDe, float); //! Bayesian probability for deuteron
+DECLARE_SOA_COLUMN(BayesFullTr, bayesFullTr, float); //! Bayesian probability for triton
+DECLARE_SOA_COLUMN(BayesFullHe, bayesFullHe, float); //! Bayesian probability for helium3
+DECLARE_SOA_COLUMN(BayesFullAl, bayesFullAl, float); //! Bayesian probability for alpha
 
 } // namespace pidbayes
 
@@ -1068,6 +1078,12 @@ DECLARE_SOA_TABLE(pidBayesAl, "AOD", "pidBayesAl", //! Binned (in percentage) Ba
 // Table for the most probable particle
 DECLARE_SOA_TABLE(pidBayes, "AOD", "pidBayes", pidbayes::BayesProb, pidbayes::BayesID); //! Index of the most probable ID and its bayesian probability
 
+// Table with the full precision probabilities of all the particle hypotheses
+DECLARE_SOA_TABLE(pidBayesFull, "AOD", "pidBayesFull", //! Bayesian probabilities (between 0 and 1) of all the particle hypotheses, 0 for the disabled ones
+                  pidbayes::BayesFullEl, pidbayes::BayesFullMu, pidbayes::BayesFullPi,
+                  pidbayes::BayesFullKa, pidbayes::BayesFullPr, pidbayes::BayesFullDe,
+                  pidbayes::BayesFullTr, pidbayes::BayesFullHe, pidbayes::BayesFullAl);
+
 } // namespace o2::aod
 
 #endif // O2_FRAMEWORK_PIDRESPONSE_H_
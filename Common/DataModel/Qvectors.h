@@ -0,0 +1,74 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   Qvectors.h
+/// \brief  Per-collision Q-vectors of the barrel tracks, produced by the qvectors-table task
+///
+/// The Q-vectors are the raw sums Q_n = sum_i w_i^p exp(i n phi_i) over the selected tracks, for the harmonics n = 2, 3, 4,
+/// in the full eta range and in the negative and positive eta sub-events separated by the eta gap. The weights w_i are
+/// the NUA (and optionally NUE) weights, p is configurable. The sums of weights and the numbers of tracks are given for
+/// the normalisation, which is left to the consumer.
+///
+
+#ifndef O2_ANALYSIS_QVECTORS_H_
+#define O2_ANALYSIS_QVECTORS_H_
+
+#include <cmath>
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace qvec
+{
+DECLARE_SOA_COLUMN(Q2XFull, q2xFull, float); //! Re(Q_2), full eta range
+DECLARE_SOA_COLUMN(Q2YFull, q2yFull, float); //! Im(Q_2), full eta range
+DECLARE_SOA_COLUMN(Q2XNeg, q2xNeg, float);   //! Re(Q_2), negative eta sub-event
+DECLARE_SOA_COLUMN(Q2YNeg, q2yNeg, float);   //! Im(Q_2), negative eta sub-event
+DECLARE_SOA_COLUMN(Q2XPos, q2xPos, float);   //! Re(Q_2), positive eta sub-event
+DECLARE_SOA_COLUMN(Q2YPos, q2yPos, float);   //! Im(Q_2), positive eta sub-event
+DECLARE_SOA_COLUMN(Q3XFull, q3xFull, float); //! Re(Q_3), full eta range
+DECLARE_SOA_COLUMN(Q3YFull, q3yFull, float); //! Im(Q_3), full eta range
+DECLARE_SOA_COLUMN(Q3XNeg, q3xNeg, float);   //! Re(Q_3), negative eta sub-event
+DECLARE_SOA_COLUMN(Q3YNeg, q3yNeg, float);   //! Im(Q_3), negative eta sub-event
+DECLARE_SOA_COLUMN(Q3XPos, q3xPos, float);   //! Re(Q_3), positive eta sub-event
+DECLARE_SOA_COLUMN(Q3YPos, q3yPos, float);   //! Im(Q_3), positive eta sub-event
+DECLARE_SOA_COLUMN(Q4XFull, q4xFull, float); //! Re(Q_4), full eta range
+DECLARE_SOA_COLUMN(Q4YFull, q4yFull, float); //! Im(Q_4), full eta range
+DECLARE_SOA_COLUMN(Q4XNeg, q4xNeg, float);   //! Re(Q_4), negative eta sub-event
+DECLARE_SOA_COLUMN(Q4YNeg, q4yNeg, float);   //! Im(Q_4), negative eta sub-event
+DECLARE_SOA_COLUMN(Q4XPos, q4xPos, float);   //! Re(Q_4), positive eta sub-event
+DECLARE_SOA_COLUMN(Q4YPos, q4yPos, float);   //! Im(Q_4), positive eta sub-event
+DECLARE_SOA_COLUMN(SumWFull, sumWFull, float); //! Sum of the track weights, full eta range
+DECLARE_SOA_COLUMN(SumWNeg, sumWNeg, float);   //! Sum of the track weights, negative eta sub-event
+DECLARE_SOA_COLUMN(SumWPos, sumWPos, float);   //! Sum of the track weights, positive eta sub-event
+DECLARE_SOA_COLUMN(NTrkFull, nTrkFull, int);   //! Number of tracks, full eta range
+DECLARE_SOA_COLUMN(NTrkNeg, nTrkNeg, int);     //! Number of tracks, negative eta sub-event
+DECLARE_SOA_COLUMN(NTrkPos, nTrkPos, int);     //! Number of tracks, positive eta sub-event
+DECLARE_SOA_DYNAMIC_COLUMN(Psi2Full, psi2Full, //! Second harmonic event plane angle, full eta range
+                           [](float qx, float qy) -> float { return std::atan2(qy, qx) / 2.f; });
+DECLARE_SOA_DYNAMIC_COLUMN(Psi3Full, psi3Full, //! Third harmonic event plane angle, full eta range
+                           [](float qx, float qy) -> float { return std::atan2(qy, qx) / 3.f; });
+} // namespace qvec
+
+DECLARE_SOA_TABLE(Qvectors, "AOD", "QVECTORS", //! Barrel Q-vectors, joinable with the collisions
+                  qvec::Q2XFull, qvec::Q2YFull, qvec::Q2XNeg, qvec::Q2YNeg, qvec::Q2XPos, qvec::Q2YPos,
+                  qvec::Q3XFull, qvec::Q3YFull, qvec::Q3XNeg, qvec::Q3YNeg, qvec::Q3XPos, qvec::Q3YPos,
+                  qvec::Q4XFull, qvec::Q4YFull, qvec::Q4XNeg, qvec::Q4YNeg, qvec::Q4XPos, qvec::Q4YPos,
+                  qvec::SumWFull, qvec::SumWNeg, qvec::SumWPos,
+                  qvec::NTrkFull, qvec::NTrkNeg, qvec::NTrkPos,
+                  qvec::Psi2Full<qvec::Q2XFull, qvec::Q2YFull>,
+                  qvec::Psi3Full<qvec::Q3XFull, qvec::Q3YFull>);
+using Qvector = Qvectors::iterator;
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_QVECTORS_H_
@@ -0,0 +1,46 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TrackKinematics.h
+/// \brief  Momentum components and charge of the tracks, stored once per data frame by the track-kinematics task
+///
+/// pt, eta and phi are already expression columns of the Tracks, while p, px, py, pz and sign are dynamic columns,
+/// evaluated from signed1Pt, tgl, snp and alpha at each access. This table stores them as real columns, joinable
+/// with the Tracks. The getters have the kine prefix, so that they do not clash with the ones of the Tracks in a join.
+///
+
+#ifndef O2_ANALYSIS_TRACKKINEMATICS_H_
+#define O2_ANALYSIS_TRACKKINEMATICS_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace trackkine
+{
+DECLARE_SOA_COLUMN(KineP, kineP, float);        //! Momentum
+DECLARE_SOA_COLUMN(KinePx, kinePx, float);      //! Momentum along x
+DECLARE_SOA_COLUMN(KinePy, kinePy, float);      //! Momentum along y
+DECLARE_SOA_COLUMN(KinePz, kinePz, float);      //! Momentum along z
+DECLARE_SOA_COLUMN(KineSign, kineSign, int8_t); //! Charge sign, +1 or -1
+} // namespace trackkine
+
+DECLARE_SOA_TABLE(TracksKinematics, "AOD", "TRACKKINE", //! Momentum components and sign of the tracks, joinable with the Tracks
+                  trackkine::KineP, trackkine::KinePx, trackkine::KinePy, trackkine::KinePz, trackkine::KineSign);
+using TrackKinematics = TracksKinematics::iterator;
+
+// Joins of the most used track tables with the kinematics
+using TracksWithKinematics = soa::Join<Tracks, TracksKinematics>;
+using FullTracksWithKinematics = soa::Join<Tracks, TracksExtra, TracksKinematics>;
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_TRACKKINEMATICS_H_
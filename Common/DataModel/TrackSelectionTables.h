@@ -90,6 +90,10 @@ DECLARE_DYN_TRKSEL_COLUMN(IsGlobalTrackWoPtEta, isGlobalTrackWoPtEta, TrackSelec
 DECLARE_DYN_TRKSEL_COLUMN(IsGlobalTrackWoDCA, isGlobalTrackWoDCA, TrackSelectionFlags::kGlobalTrackWoDCA);       //! Passed the combined track cut: kGlobalTrackWoDCA
 #undef DECLARE_DYN_TRKSEL_COLUMN
 
+// Columns of the multi-selection producer, one bit per configured selection
+DECLARE_SOA_COLUMN(TrackSelectionBits, trackSelectionBits, uint32_t); //! Bit i set if the track passed all the cuts of the i-th configured selection
+DECLARE_SOA_DYNAMIC_COLUMN(PassedSelection, passedSelection, [](uint32_t bits, int iSelection) -> bool { return (bits >> iSelection) & 1u; }); //! Passed all the cuts of the i-th configured selection
+
 } // namespace track
 DECLARE_SOA_TABLE(TracksDCA, "AOD", "TRACKDCA", //! DCA information for the track
                   track::DcaXY,
@@ -120,6 +124,10 @@ DECLARE_SOA_TABLE(TrackSelection, "AOD", "TRACKSELECTION", //! Information on th
                   track::IsGlobalTrackWoPtEta<track::TrackCutFlag>,
                   track::IsGlobalTrackWoDCA<track::TrackCutFlag>);
 
+DECLARE_SOA_TABLE(TrackSelectionsMulti, "AOD", "TRKSELMULTI", //! Decisions of the named track selections of track-selection-multi
+                  track::TrackSelectionBits,
+                  track::PassedSelection<track::TrackSelectionBits>);
+
 } // namespace o2::aod
 
 #endif // O2_ANALYSIS_TRACKSELECTIONTABLES_H_
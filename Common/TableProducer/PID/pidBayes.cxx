@@ -21,6 +21,10 @@
 #include "Framework/HistogramRegistry.h"
 #include "Framework/RunningWorkflowInfo.h"
 #include "Framework/Array2D.h"
+#include <TH2.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <CCDB/BasicCCDBManager.h>
 #include "Common/Core/PID/TPCPIDResponse.h"
 #include "Common/DataModel/Multiplicity.h"
@@ -46,16 +50,17 @@ struct bayesPid {
   using Coll = soa::Join<aod::Collisions, aod::Mults>;
 
   // Tables to produce
-  Produces<o2::aod::pidBayesEl> tablePIDEl; /// Table for the Electron
-  Produces<o2::aod::pidBayesMu> tablePIDMu; /// Table for the Muon
-  Produces<o2::aod::pidBayesPi> tablePIDPi; /// Table for the Pion
-  Produces<o2::aod::pidBayesKa> tablePIDKa; /// Table for the Kaon
-  Produces<o2::aod::pidBayesPr> tablePIDPr; /// Table for the Proton
-  Produces<o2::aod::pidBayesDe> tablePIDDe; /// Table for the Deuteron
-  Produces<o2::aod::pidBayesTr> tablePIDTr; /// Table for the Triton
-  Produces<o2::aod::pidBayesHe> tablePIDHe; /// Table for the Helium3
-  Produces<o2::aod::pidBayesAl> tablePIDAl; /// Table for the Alpha
-  Produces<o2::aod::pidBayes> tableBayes;   /// Table of the most probable particle type
+  Produces<o2::aod::pidBayesEl> tablePIDEl;  /// Table for the Electron
+  Produces<o2::aod::pidBayesMu> tablePIDMu;  /// Table for the Muon
+  Produces<o2::aod::pidBayesPi> tablePIDPi;  /// Table for the Pion
+  Produces<o2::aod::pidBayesKa> tablePIDKa;  /// Table for the Kaon
+  Produces<o2::aod::pidBayesPr> tablePIDPr;  /// Table for the Proton
+  Produces<o2::aod::pidBayesDe> tablePIDDe;  /// Table for the Deuteron
+  Produces<o2::aod::pidBayesTr> tablePIDTr;  /// Table for the Triton
+  Produces<o2::aod::pidBayesHe> tablePIDHe;  /// Table for the Helium3
+  Produces<o2::aod::pidBayesAl> tablePIDAl;  /// Table for the Alpha
+  Produces<o2::aod::pidBayes> tableBayes;    /// Table of the most probable particle type
+  Produces<o2::aod::pidBayesFull> tableFull; /// Table of the full precision probabilities
 
   /// Types of probabilities that can be computed N.B. the order is important, detectors first!
   enum ProbType : int { kTOF = 0,  /// Probabilities with the TOF detector
@@ -85,6 +90,8 @@ struct bayesPid {
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> ccdbPathTOF{"ccdbPathTOF", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
   Configurable<std::string> ccdbPathTPC{"ccdbPathTPC", "Analysis/PID/TPC/Response", "Path of the TPC parametrization on the CCDB"};
+  Configurable<std::string> ccdbPathPriors{"ccdbPathPriors", "", "Path of the prior probabilities on the CCDB (TH2 of p vs species, bin i + 1 of the y axis for the PID index i), flat priors if empty"};
+  Configurable<int> nPriorBins{"nPriorBins", 500, "Number of uniform momentum bins of the prior lookup table"};
   Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
   // Configuration flags to include and exclude particle hypotheses
   // Configurable<LabeledArray<int>> pid{"pid",
@@ -99,30 +106,53 @@ struct bayesPid {
   Configurable<int> pidTr{"pid-tr", -1, {"Produce PID information for the Triton mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidHe{"pid-he", -1, {"Produce PID information for the Helium3 mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
+  Configurable<int> pidFull{"pid-full", -1, {"Produce the full precision probabilities of all the enabled mass hypotheses, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
 
-  std::array<std::array<float, PID::NIDs>, kNProb> Probability; /// Probabilities for all the cases defined in ProbType
-  std::vector<PID::ID> enabledSpecies;                          /// Enabled species
+  std::array<std::array<float, PID::NIDs>, kNProb> Probability;   /// Probabilities for all the cases defined in ProbType
+  std::array<std::array<float, PID::NIDs>, kNDet> LogProbability; /// Logarithm of the detector probabilities, up to a constant common to the species
+  std::vector<PID::ID> enabledSpecies;                            /// Enabled species
+  std::array<bool, PID::NIDs> isEnabledSpecies{false};            /// Enabled species, by PID index
+
+  // Prior probabilities, logarithm in (species, p) bins
+  std::vector<float> logPriorTable; /// Logarithm of the priors, nPriorBins momentum bins for each PID index
+  float priorPMin = 0.f;            /// Lower edge of the momentum bins of the priors
+  float priorInvBinWidth = 0.f;     /// Inverse of the width of the momentum bins of the priors
 
   /// Checker of the species that are enabled and initializer of the probabilities
   template <ProbType detIndex, o2::track::PID::ID pid>
   bool checkEnabled()
   {
     static_assert(detIndex < kNDet && detIndex >= 0);
-    if (!enabledDet[detIndex]) {
-      LOG(debug) << "Detector " << detectorName[detIndex] << " disabled";
-      return false; // Setting the probability to 1 if the detector is disabled
+    if (!enabledDet[detIndex] || !isEnabledSpecies[pid]) {
+      return false;
     }
-    LOG(debug) << "Detector " << detectorName[detIndex] << " enabled with " << enabledSpecies.size() << " species";
-
-    for (const auto enabledPid : enabledSpecies) { // Checking that the species is enabled
-      LOG(debug) << "Testing " << PID::getName(enabledPid) << " " << (int)enabledPid << " vs " << (int)pid;
-      if (enabledPid == pid) {
-        LOG(debug) << "Particle " << PID::getName(enabledPid) << " enabled";
-        Probability[detIndex][pid] = 1.f / enabledSpecies.size(); // set flat distribution (no decision yet)
-        return true;
+    LogProbability[detIndex][pid] = 0.f; // set flat distribution (no decision yet)
+    return true;
+  }
+
+  /// Fills the lookup table of the priors from a TH2 of p vs species
+  void setPriors(const TH2* priors)
+  {
+    const TAxis* axisP = priors->GetXaxis();
+    priorPMin = axisP->GetXmin();
+    priorInvBinWidth = nPriorBins / (axisP->GetXmax() - axisP->GetXmin());
+    logPriorTable.assign(PID::NIDs * nPriorBins, 0.f);
+    for (int id = 0; id < PID::NIDs; id++) {
+      for (int bin = 0; bin < nPriorBins; bin++) {
+        const float prior = priors->GetBinContent(axisP->FindFixBin(priorPMin + (bin + 0.5f) / priorInvBinWidth), id + 1);
+        logPriorTable[id * nPriorBins + bin] = prior > 0.f ? std::log(prior) : -std::numeric_limits<float>::infinity();
       }
     }
-    return false;
+  }
+
+  /// Logarithm of the prior of the species at momentum p, the priors are flat if none are loaded
+  float logPrior(const PID::ID id, const float p) const
+  {
+    if (logPriorTable.empty()) {
+      return 0.f;
+    }
+    const int bin = std::clamp(static_cast<int>((p - priorPMin) * priorInvBinWidth), 0, nPriorBins - 1);
+    return logPriorTable[id * nPriorBins + bin];
   }
 
   float fRange = 5.f;
@@ -134,6 +164,10 @@ struct bayesPid {
         Probability[i][j] = 1.f;
       }
     }
+    Probability[kBayesian].fill(0.f); // The disabled species are never the most probable ones
+    for (int i = 0; i < kNDet; i++) {
+      LogProbability[i].fill(0.f);
+    }
     // Enabling detectors
     enabledDet[kTOF] = enableTOF;
     enabledDet[kTPC] = enableTPC;
@@ -177,6 +211,16 @@ struct bayesPid {
         enableFlag(PID::Triton, pidTr);
         enableFlag(PID::Helium3, pidHe);
         enableFlag(PID::Alpha, pidAl);
+        if (input.matcher.binding == "pidBayesFull") {
+          if (pidFull < 0) {
+            pidFull.value = 1;
+            LOG(info) << "Auto-enabling table: pidBayesFull";
+          } else if (pidFull > 0) {
+            LOG(info) << "Table enabled: pidBayesFull";
+          } else {
+            LOG(info) << "Table disabled: pidBayesFull";
+          }
+        }
       }
     }
 
@@ -202,6 +246,9 @@ struct bayesPid {
 
     enabledSpecies.shrink_to_fit();
     std::sort(enabledSpecies.begin(), enabledSpecies.end());
+    for (const auto enabledPid : enabledSpecies) {
+      isEnabledSpecies[enabledPid] = true;
+    }
     if (enabledSpecies.size() == 0) { // No enabled species
       LOG(fatal) << "No species are enabled";
     } else if (enabledSpecies.size() > PID::NIDs) { // Too many enabled species
@@ -247,6 +294,13 @@ struct bayesPid {
       LOGP(info, "Loading TPC response from CCDB, using path: {} for timestamp {}", pathTPC, time);
       responseTPC.PrintAll();
     }
+    if (!ccdbPathPriors.value.empty()) {
+      if (nPriorBins <= 0) {
+        LOG(fatal) << "nPriorBins must be positive";
+      }
+      LOGP(info, "Loading the prior probabilities from CCDB, using path: {} for timestamp {}", ccdbPathPriors.value, timestamp.value);
+      setPriors(ccdb->getForTimeStamp<TH2>(ccdbPathPriors.value, timestamp.value));
+    }
   }
 
   /// Computes PID probabilities for the TPC
@@ -259,7 +313,6 @@ struct bayesPid {
     }
 
     const float dedx = track.tpcSignal();
-    bool mismatch = true;
 
     // if (fTuneMConData && ((fTuneMConDataMask & kDetTPC) == kDetTPC)){
     //   dedx = GetTPCsignalTunedOnData(track);
@@ -270,19 +323,11 @@ struct bayesPid {
     //  bethe = fTPCResponse.GetExpectedSignal(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
     //  sigma = fTPCResponse.GetExpectedSigma(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
 
-    if (abs(dedx - bethe) > fRange * sigma) {
-      // Probability[kTPC][pid] = exp(-0.5 * fRange * fRange) / sigma; // BUG fix
-      Probability[kTPC][pid] = exp(-0.5 * fRange * fRange);
+    if (abs(dedx - bethe) > fRange * sigma) { // mismatch
+      LogProbability[kTPC][pid] = -std::log(static_cast<float>(PID::NIDs));
     } else {
       // Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma)) / sigma; //BUG fix
-      Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma));
-      mismatch = false;
-    }
-    if (Probability[kTPC][pid] <= 0.f) {
-      Probability[kTPC][pid] = 0.f;
-    }
-    if (mismatch) {
-      Probability[kTPC][pid] = 1.f / Probability[kTPC].size();
+      LogProbability[kTPC][pid] = -0.5f * (dedx - bethe) * (dedx - bethe) / (sigma * sigma);
     }
   }
 
@@ -362,68 +407,44 @@ struct bayesPid {
     const float sig = responseTOFPID.GetExpectedSigma(Response[kTOF], track);
 
     if (nsigmas < fTOFtail) {
-      Probability[kTOF][pid] = exp(-0.5 * nsigmas * nsigmas) / sig;
+      LogProbability[kTOF][pid] = -0.5f * nsigmas * nsigmas - std::log(sig);
     } else {
-      Probability[kTOF][pid] = exp(-(nsigmas - fTOFtail * 0.5) * fTOFtail) / sig;
+      LogProbability[kTOF][pid] = -(nsigmas - fTOFtail * 0.5f) * fTOFtail - std::log(sig);
     }
 
-    Probability[kTOF][pid] += fgTOFmismatchProb * mismPropagationFactor[pid];
-    LOG(debug) << "For " << pid_constants::sNames[pid] << " with signal " << track.tofSignal() << " computing exp time " << expTime << " and sigma " << sig << " and nsigma " << nsigmas << " probability " << Probability[kTOF][pid];
-  }
-
-  /// Calculate probabilities from all enabled detectors and species
-  void MergeProbabilities()
-  {
-    LOG(debug) << "Merging probabilities";
-
-    float probSum[kNDet + 1] = {0.f}; /// Summed probabilities for all detectors + 1 for the sum of all detectors
-
-    for (const auto enabledPid : enabledSpecies) {
-      Probability[kMerged][enabledPid] = 1.f;
-      for (int det = 0; det < kNDet; det++) {
-        probSum[det] += Probability[det][enabledPid];
-        Probability[kMerged][enabledPid] *= Probability[det][enabledPid];
-      }
-      probSum[kNDet] += Probability[kMerged][enabledPid];
-      LOG(debug) << "For " << PID::getName(enabledPid);
-      for (int det = 0; det < kNDet; det++) {
-        if (enabledDet[det]) {
-          LOG(debug) << "\t" << detectorName[det] << " Probability " << Probability[det][enabledPid];
-        }
-      }
-      LOG(debug) << "\tCombined: " << Probability[kMerged][enabledPid];
+    if (fgTOFmismatchProb > 0.f) {
+      LogProbability[kTOF][pid] = std::log(std::exp(LogProbability[kTOF][pid]) + fgTOFmismatchProb * mismPropagationFactor[pid]);
     }
-    for (int det = 0; det < kNDet; det++) {
-      if (enabledDet[det]) {
-        LOG(debug) << "\tSum " << detectorName[det] << " Probability " << probSum[det];
-      }
-    }
-    LOG(debug) << "\tSum combined: " << probSum[kNDet];
+    LOG(debug) << "For " << pid_constants::sNames[pid] << " with signal " << track.tofSignal() << " computing exp time " << expTime << " and sigma " << sig << " and nsigma " << nsigmas << " log probability " << LogProbability[kTOF][pid];
   }
 
-  /// Calculate Bayesian probabilities
-  void ComputeBayesProbabilities()
+  /// Calculate Bayesian probabilities of all the enabled species at once, from the detector probabilities and the priors at momentum p
+  /// The products are sums of logarithms, shifted by the largest one before the exponential so that they cannot underflow
+  void ComputeBayesProbabilities(const float p)
   {
-    LOG(debug) << "Computing bayes probabilities";
-
-    float sum = 0.;
-    for (const auto enabledPid : enabledSpecies) {
-      LOG(debug) << "Adding " << Probability[kMerged][enabledPid] << " with prior " << Probability[kPrior][enabledPid];
-      sum += Probability[kMerged][enabledPid] * Probability[kPrior][enabledPid];
+    const int nSpecies = enabledSpecies.size();
+    std::array<float, PID::NIDs> logPosterior;
+    float maxLogPosterior = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < nSpecies; i++) {
+      const auto enabledPid = enabledSpecies[i];
+      logPosterior[i] = LogProbability[kTOF][enabledPid] + LogProbability[kTPC][enabledPid] + logPrior(enabledPid, p);
+      maxLogPosterior = std::max(maxLogPosterior, logPosterior[i]);
     }
-    if (sum <= 0) {
+    if (maxLogPosterior == -std::numeric_limits<float>::infinity()) {
       LOG(warning) << "Invalid probability densities or prior probabilities";
-      for (long unsigned int i = 0; i < Probability[kBayesian].size(); i++) {
-        Probability[kBayesian][i] = 1.f / Probability[kBayesian].size();
+      for (const auto enabledPid : enabledSpecies) {
+        Probability[kBayesian][enabledPid] = 1.f / nSpecies;
       }
       return;
     }
-    for (const auto enabledPid : enabledSpecies) {
-      Probability[kBayesian][enabledPid] = Probability[kMerged][enabledPid] * Probability[kPrior][enabledPid] / sum;
-      // if (probDensityMism) {
-      //   probDensityMism[enabledPid] *= Probability[kPrior][enabledPid] / sum;
-      // }
-      LOG(debug) << "For " << PID::getName(enabledPid) << " merged prob. " << Probability[kMerged][enabledPid] << " prior " << Probability[kPrior][enabledPid] << " sum " << sum << " bayesian Probability: " << Probability[kBayesian][enabledPid];
+    std::array<float, PID::NIDs> posterior;
+    float sum = 0.f;
+    for (int i = 0; i < nSpecies; i++) {
+      posterior[i] = std::exp(logPosterior[i] - maxLogPosterior);
+      sum += posterior[i];
+    }
+    for (int i = 0; i < nSpecies; i++) {
+      Probability[kBayesian][enabledSpecies[i]] = posterior[i] / sum;
     }
   }
 
@@ -439,6 +460,7 @@ struct bayesPid {
     };
 
     tableBayes.reserve(tracks.size());
+    makeTable(pidFull, tableFull);
     makeTable(pidEl, tablePIDEl);
     makeTable(pidMu, tablePIDMu);
     makeTable(pidPi, tablePIDPi);
@@ -472,9 +494,7 @@ struct bayesPid {
       ComputeTOFProbability<PID::Helium3>(trk);
       ComputeTOFProbability<PID::Alpha>(trk);
 
-      MergeProbabilities();
-
-      ComputeBayesProbabilities();
+      ComputeBayesProbabilities(trk.p());
 
       if (pidEl == 1) {
         tablePIDEl(Probability[kBayesian][PID::Electron] * 100.f);
@@ -503,6 +523,12 @@ struct bayesPid {
       if (pidAl == 1) {
         tablePIDAl(Probability[kBayesian][PID::Alpha] * 100.f);
       }
+      if (pidFull == 1) {
+        const auto& prob = Probability[kBayesian];
+        tableFull(prob[PID::Electron], prob[PID::Muon], prob[PID::Pion],
+                  prob[PID::Kaon], prob[PID::Proton], prob[PID::Deuteron],
+                  prob[PID::Triton], prob[PID::Helium3], prob[PID::Alpha]);
+      }
       const auto mostProbable = std::max_element(Probability[kBayesian].begin(), Probability[kBayesian].end());
       tableBayes((*mostProbable) * 100.f, std::distance(Probability[kBayesian].begin(), mostProbable));
     }
@@ -26,7 +26,10 @@
 // O2Physics includes
 #include "TableHelper.h"
 #include "pidTOFBase.h"
+#include "PID/TOFResponseLUT.h"
 #include "DPG/Tasks/AOTTrack/PID/qaPIDTOF.h"
+#include "Common/Core/CCDBObjectCache.h"
+#include "Common/Core/ProcessTimer.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -63,6 +66,13 @@ struct tofPid {
   Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
   Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
   Configurable<bool> enableTimeDependentResponse{"enableTimeDependentResponse", false, "Flag to use the collision timestamp to fetch the PID Response"};
+  Configurable<std::string> rctPath{"rct-path", "RCT/Info/RunInformation", "path to the ccdb RCT objects for the SOR/EOR timestamps, used to prefetch the time dependent response of a run"};
+  // Configuration of the response lookup table
+  Configurable<bool> useResponseLUT{"useResponseLUT", false, "Flag to compute the expected times and sigmas from a lookup table in momentum instead of the analytic response"};
+  Configurable<int> responseLUTNBins{"responseLUTNBins", 2000, "Number of bins of the response lookup table, uniform in log(p)"};
+  Configurable<float> responseLUTPMin{"responseLUTPMin", 0.05f, "Lower momentum edge of the response lookup table (GeV/c), the analytic response is used below"};
+  Configurable<float> responseLUTPMax{"responseLUTPMax", 20.f, "Upper momentum edge of the response lookup table (GeV/c), the analytic response is used above"};
+  Configurable<float> responseLUTMaxDeviation{"responseLUTMaxDeviation", 1.e-5f, "Maximum relative deviation of the response lookup table from the analytic response, the analytic response is used if it is exceeded"};
   // Configuration flags to include and exclude particle hypotheses
   Configurable<int> pidEl{"pid-el", -1, {"Produce PID information for the Electron mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidMu{"pid-mu", -1, {"Produce PID information for the Muon mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
@@ -73,18 +83,57 @@ struct tofPid {
   Configurable<int> pidTr{"pid-tr", -1, {"Produce PID information for the Triton mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidHe{"pid-he", -1, {"Produce PID information for the Helium3 mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
+  Configurable<bool> enableTiming{"enableTiming", false, "Flag to measure the wall time and the processed tracks of the process functions"};
   // Running variables
   std::string parametrizationPath = "";
+  o2::analysis::CCDBObjectCache<o2::pid::tof::TOFResoParams> mRespParamsCache; // Time dependent parametrizations of the runs being processed
+  o2::pid::tof::TOFResponseLUT mRespLUT;                                       // Lookup table of the response for the current parameters
+  bool mRespLUTValid = false;                                                  // Lookup table enabled and within the accuracy bound for the current parameters
+  HistogramRegistry timingHistos{"TimingHistos", {}, OutputObjHandlingPolicy::AnalysisObject};
+  o2::analysis::ProcessTimer mTimer; // Timing of the process functions, enabled by enableTiming
+  enum TimedFunctions { kProcessWSlice = 0,
+                        kProcessWoSlice };
+
+  /// Fills the response lookup table again if the parameters changed and checks its accuracy
+  void updateResponseLUT()
+  {
+    if (!useResponseLUT || !mRespLUT.needsRebuild(mRespParams)) {
+      return;
+    }
+    mRespLUT.build(mRespParams, responseLUTNBins, responseLUTPMin, responseLUTPMax);
+    const float maxDeviation = mRespLUT.validate();
+    mRespLUTValid = maxDeviation <= responseLUTMaxDeviation;
+    if (!mRespLUTValid) {
+      LOG(warning) << "TOF response lookup table deviates by " << maxDeviation << " from the analytic response, above the bound " << responseLUTMaxDeviation.value << ": using the analytic response";
+    } else {
+      LOG(info) << "Built TOF response lookup table with " << responseLUTNBins.value << " bins, maximum relative deviation " << maxDeviation;
+    }
+  }
+
+  /// Gets the inputs of the response lookup table for a track, not valid if the table cannot be used for it
+  template <typename TrackType>
+  o2::pid::tof::TOFResponseLUT::TrackInputs getResponseLUTInputs(const TrackType& track) const
+  {
+    if (!mRespLUTValid || !track.hasTOF()) {
+      return {};
+    }
+    const float expMom = track.trackType() == o2::aod::track::Run2Track ? track.tofExpMom() / o2::pid::tof::kCSPEED : track.tofExpMom();
+    return mRespLUT.getTrackInputs(expMom, track.p(), track.length(), track.tofSignal(), track.tofEvTime(), track.tofEvTimeErr());
+  }
 
   void init(o2::framework::InitContext& initContext)
   {
     if (doprocessWSlice == true && doprocessWoSlice == true) {
       LOGF(fatal, "Cannot enable processWoSlice and processWSlice at the same time. Please choose one.");
     }
+    if (enableTiming) {
+      mTimer.init(timingHistos, {"processWSlice", "processWoSlice"}, "tof-pid");
+    }
 
     // Checking the tables are requested in the workflow and enabling them
+    const auto requiredTables = getTablesRequiredInWorkflow(initContext);
     auto enableFlag = [&](const std::string particle, Configurable<int>& flag) {
-      enableFlagIfTableRequired(initContext, "pidTOF" + particle, flag);
+      enableFlagIfTableRequired(requiredTables, "pidTOF" + particle, flag);
     };
 
     enableFlag("El", pidEl);
@@ -103,7 +152,8 @@ struct tofPid {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
     // Not later than now objects
-    ccdb->setCreatedNotAfter(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    const int64_t createdNotAfter = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    ccdb->setCreatedNotAfter(createdNotAfter);
     //
     const std::string fname = paramfile.value;
     if (!fname.empty()) { // Loading the parametrization from file
@@ -115,8 +165,13 @@ struct tofPid {
         LOG(info) << "Loading exp. sigma parametrization from CCDB, using path: '" << parametrizationPath << "' for timestamp " << timestamp.value;
         mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp.value));
         mRespParams.Print();
+      } else {
+        mRespParamsCache.init(url.value, parametrizationPath, rctPath.value, createdNotAfter);
       }
     }
+    if (!enableTimeDependentResponse) {
+      updateResponseLUT();
+    }
   }
 
   using Trks = soa::Join<aod::Tracks, aod::TracksExtra, aod::TOFSignal, aod::TOFEvTime, aod::pidEvTimeFlags>;
@@ -126,6 +181,7 @@ struct tofPid {
   using ResponseImplementation = o2::pid::tof::ExpTimes<Trks::iterator, pid>;
   void processWSlice(Trks const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const&)
   {
+    auto timing = mTimer.measure(kProcessWSlice, tracks.size());
     constexpr auto responseEl = ResponseImplementation<PID::Electron>();
     constexpr auto responseMu = ResponseImplementation<PID::Muon>();
     constexpr auto responsePi = ResponseImplementation<PID::Pion>();
@@ -183,32 +239,35 @@ struct tofPid {
 
       // Fill new table for the tracks in a collision
       lastCollisionId = track.collisionId(); // Cache last collision ID
-      timestamp.value = track.collision().bc_as<aod::BCsWithTimestamps>().timestamp();
+      const auto& bc = track.collision().bc_as<aod::BCsWithTimestamps>();
+      timestamp.value = bc.timestamp();
       if (enableTimeDependentResponse) {
         LOG(debug) << "Updating parametrization from path '" << parametrizationPath << "' and timestamp " << timestamp.value;
-        mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
+        mRespParams.SetParameters(mRespParamsCache.getForRun(bc.runNumber(), timestamp.value));
+        updateResponseLUT();
       }
 
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
       for (auto const& trkInColl : tracksInCollision) { // Loop on tracks
+        const auto lutInputs = getResponseLUTInputs(trkInColl);
         // Check and fill enabled tables
-        auto makeTable = [&trkInColl, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+        auto makeTable = [&trkInColl, &lutInputs, this](const Configurable<int>& flag, auto& table, const auto& responsePID, const PID::ID id) {
           if (flag.value != 1) {
             return;
           }
-          aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(mRespParams, trkInColl),
+          aod::pidutils::packInTable<aod::pidtof_tiny::binning>(lutInputs.isValid() ? mRespLUT.getSeparation(id, lutInputs) : responsePID.GetSeparation(mRespParams, trkInColl),
                                                                 table);
         };
 
-        makeTable(pidEl, tablePIDEl, responseEl);
-        makeTable(pidMu, tablePIDMu, responseMu);
-        makeTable(pidPi, tablePIDPi, responsePi);
-        makeTable(pidKa, tablePIDKa, responseKa);
-        makeTable(pidPr, tablePIDPr, responsePr);
-        makeTable(pidDe, tablePIDDe, responseDe);
-        makeTable(pidTr, tablePIDTr, responseTr);
-        makeTable(pidHe, tablePIDHe, responseHe);
-        makeTable(pidAl, tablePIDAl, responseAl);
+        makeTable(pidEl, tablePIDEl, responseEl, PID::Electron);
+        makeTable(pidMu, tablePIDMu, responseMu, PID::Muon);
+        makeTable(pidPi, tablePIDPi, responsePi, PID::Pion);
+        makeTable(pidKa, tablePIDKa, responseKa, PID::Kaon);
+        makeTable(pidPr, tablePIDPr, responsePr, PID::Proton);
+        makeTable(pidDe, tablePIDDe, responseDe, PID::Deuteron);
+        makeTable(pidTr, tablePIDTr, responseTr, PID::Triton);
+        makeTable(pidHe, tablePIDHe, responseHe, PID::Helium3);
+        makeTable(pidAl, tablePIDAl, responseAl, PID::Alpha);
       }
     }
   }
@@ -216,6 +275,7 @@ struct tofPid {
 
   void processWoSlice(Trks const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const&)
   {
+    auto timing = mTimer.measure(kProcessWoSlice, tracks.size());
     constexpr auto responseEl = ResponseImplementation<PID::Electron>();
     constexpr auto responseMu = ResponseImplementation<PID::Muon>();
     constexpr auto responsePi = ResponseImplementation<PID::Pion>();
@@ -269,29 +329,32 @@ struct tofPid {
 
       if (enableTimeDependentResponse && (track.collisionId() != lastCollisionId)) { // Time dependent calib is enabled and this is a new collision
         lastCollisionId = track.collisionId();                                       // Cache last collision ID
-        timestamp.value = track.collision().bc_as<aod::BCsWithTimestamps>().timestamp();
+        const auto& bc = track.collision().bc_as<aod::BCsWithTimestamps>();
+        timestamp.value = bc.timestamp();
         LOG(debug) << "Updating parametrization from path '" << parametrizationPath << "' and timestamp " << timestamp.value;
-        mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
+        mRespParams.SetParameters(mRespParamsCache.getForRun(bc.runNumber(), timestamp.value));
+        updateResponseLUT();
       }
 
+      const auto lutInputs = getResponseLUTInputs(track);
       // Check and fill enabled tables
-      auto makeTable = [&track, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+      auto makeTable = [&track, &lutInputs, this](const Configurable<int>& flag, auto& table, const auto& responsePID, const PID::ID id) {
         if (flag.value != 1) {
           return;
         }
-        aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(mRespParams, track),
+        aod::pidutils::packInTable<aod::pidtof_tiny::binning>(lutInputs.isValid() ? mRespLUT.getSeparation(id, lutInputs) : responsePID.GetSeparation(mRespParams, track),
                                                               table);
       };
 
-      makeTable(pidEl, tablePIDEl, responseEl);
-      makeTable(pidMu, tablePIDMu, responseMu);
-      makeTable(pidPi, tablePIDPi, responsePi);
-      makeTable(pidKa, tablePIDKa, responseKa);
-      makeTable(pidPr, tablePIDPr, responsePr);
-      makeTable(pidDe, tablePIDDe, responseDe);
-      makeTable(pidTr, tablePIDTr, responseTr);
-      makeTable(pidHe, tablePIDHe, responseHe);
-      makeTable(pidAl, tablePIDAl, responseAl);
+      makeTable(pidEl, tablePIDEl, responseEl, PID::Electron);
+      makeTable(pidMu, tablePIDMu, responseMu, PID::Muon);
+      makeTable(pidPi, tablePIDPi, responsePi, PID::Pion);
+      makeTable(pidKa, tablePIDKa, responseKa, PID::Kaon);
+      makeTable(pidPr, tablePIDPr, responsePr, PID::Proton);
+      makeTable(pidDe, tablePIDDe, responseDe, PID::Deuteron);
+      makeTable(pidTr, tablePIDTr, responseTr, PID::Triton);
+      makeTable(pidHe, tablePIDHe, responseHe, PID::Helium3);
+      makeTable(pidAl, tablePIDAl, responseAl, PID::Alpha);
     }
   }
   PROCESS_SWITCH(tofPid, processWoSlice, "Process without track slices", false);
@@ -27,6 +27,8 @@
 #include "Common/DataModel/FT0Corrected.h"
 #include "TableHelper.h"
 #include "pidTOFBase.h"
+#include "pidTOFEventTime.h"
+#include "PID/TOFReso.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -100,12 +102,19 @@ struct tofEventTime {
   bool enableTable = false;
   // Detector response and input parameters
   DetectorResponse response;
+  o2::pid::tof::TOFResoCompiled compiledReso; // Loaded resolution without virtual call, if it is a TOFReso
+  bool useCompiledReso = false;
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   Configurable<std::string> paramfile{"param-file", "", "Path to the parametrization object, if emtpy the parametrization is not taken from file"};
   Configurable<std::string> sigmaname{"param-sigma", "TOFReso", "Name of the parametrization for the expected sigma, used in both file and CCDB mode"};
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
   Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
+  Configurable<int> maxTracksCombinatorial{"maxTracksCombinatorial", 30, "Maximum number of TOF tracks for the combinatorial event time, above it the iterative one is used. -1: always combinatorial"};
+  Configurable<int> maxIterations{"maxIterations", 10, "Maximum number of iterations of the iterative event time"};
+  Configurable<float> nSigmaOutlier{"nSigmaOutlier", 3.f, "Tracks farther than this (in sigma) from the iterative event time for all hypotheses are not used"};
+  Configurable<bool> validateEvTime{"validateEvTime", false, "Compute both the combinatorial and iterative event times and fill their differences"};
+  HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
 
   void init(o2::framework::InitContext& initContext)
   {
@@ -137,6 +146,12 @@ struct tofEventTime {
       return;
     }
     LOG(info) << "Table TOFEvTime enabled!";
+    if (validateEvTime) {
+      const AxisSpec multAxis{100, 0, 100, "Tracks for the combinatorial TOF event time"};
+      histos.add("validation/evTimeDiff", "", kTH2F, {multAxis, {200, -100, 100, "t_{ev}^{iterative} - t_{ev}^{combinatorial} (ps)"}});
+      histos.add("validation/evTimeErrDiff", "", kTH2F, {multAxis, {200, -100, 100, "#sigma_{t_{ev}}^{iterative} - #sigma_{t_{ev}}^{combinatorial} (ps)"}});
+      histos.add("validation/multDiff", "", kTH2F, {multAxis, {41, -20.5, 20.5, "N^{iterative} - N^{combinatorial}"}});
+    }
 
     // Getting the parametrization parameters
     ccdb->setURL(url.value);
@@ -157,6 +172,57 @@ struct tofEventTime {
       LOG(info) << "Loading exp. sigma parametrization from CCDB, using path: " << path << " for timestamp " << timestamp.value;
       response.LoadParam(DetectorResponse::kSigma, ccdb->getForTimeStamp<Parametrization>(path, timestamp.value));
     }
+    // The TOFReso parametrization is evaluated per track and per hypothesis: its parameters are copied once for a direct evaluation
+    if (auto reso = dynamic_cast<const o2::pid::tof::TOFReso*>(response.GetParam(DetectorResponse::kSigma))) {
+      useCompiledReso = compiledReso.compile(*reso);
+    }
+    LOG(info) << "Exp. sigma parametrization " << (useCompiledReso ? "compiled" : "evaluated through the generic interface");
+  }
+
+  /// Computes the TOF event time of a collision and passes it to fill, with the combinatorial algorithm
+  /// up to maxTracksCombinatorial TOF tracks and with the iterative one above
+  template <typename TrackType, typename F>
+  void computeEvTimeTOF(const TrackType& tracksInCollision, F&& fill)
+  {
+    if (useCompiledReso) {
+      computeEvTimeTOF(tracksInCollision, compiledReso, fill);
+    } else {
+      computeEvTimeTOF(tracksInCollision, response, fill);
+    }
+  }
+
+  /// Same as above, with the expected resolutions from responseParameters
+  template <typename TrackType, typename ResponseParametersType, typename F>
+  void computeEvTimeTOF(const TrackType& tracksInCollision, const ResponseParametersType& responseParameters, F&& fill)
+  {
+    using TrackIterator = TrksEvTime::iterator;
+    bool useIterative = false;
+    if (maxTracksCombinatorial >= 0) {
+      int nTracksForTOF = 0;
+      for (auto const& trk : tracksInCollision) {
+        nTracksForTOF += filterForTOFEventTime(trk);
+      }
+      useIterative = nTracksForTOF > maxTracksCombinatorial;
+    }
+    if (!validateEvTime) {
+      if (useIterative) {
+        fill(o2::pid::tof::evTimeMakerIterative<TrackIterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, responseParameters, diamond, maxIterations, nSigmaOutlier));
+      } else {
+        fill(evTimeMakerForTracks<TrackIterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, responseParameters, diamond));
+      }
+      return;
+    }
+    const auto evTimeCombinatorial = evTimeMakerForTracks<TrackIterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, responseParameters, diamond);
+    const auto evTimeIterative = o2::pid::tof::evTimeMakerIterative<TrackIterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, responseParameters, diamond, maxIterations, nSigmaOutlier);
+    const int mult = evTimeCombinatorial.mEventTimeMultiplicity;
+    histos.fill(HIST("validation/evTimeDiff"), mult, evTimeIterative.mEventTime - evTimeCombinatorial.mEventTime);
+    histos.fill(HIST("validation/evTimeErrDiff"), mult, evTimeIterative.mEventTimeError - evTimeCombinatorial.mEventTimeError);
+    histos.fill(HIST("validation/multDiff"), mult, evTimeIterative.mEventTimeMultiplicity - mult);
+    if (useIterative) {
+      fill(evTimeIterative);
+    } else {
+      fill(evTimeCombinatorial);
+    }
   }
 
   ///
@@ -216,26 +282,27 @@ struct tofEventTime {
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
 
       // First make table for event time
-      const auto evTimeTOF = evTimeMakerForTracks<TrksEvTime::iterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, response, diamond);
-      int nGoodTracksForTOF = 0;
-      float et = evTimeTOF.mEventTime;
-      float erret = evTimeTOF.mEventTimeError;
-      float errDiamond = diamond * 33.356409f;
-
-      for (auto const& trk : tracksInCollision) { // Loop on Tracks
-        if constexpr (removeTOFEvTimeBias) {
-          evTimeTOF.removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, et, erret, 2);
-        }
-        uint8_t flags = 0;
-        if (erret < errDiamond) {
-          flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeTOF;
-        } else {
-          et = 0;
-          erret = errDiamond;
+      computeEvTimeTOF(tracksInCollision, [&](const auto& evTimeTOF) {
+        int nGoodTracksForTOF = 0;
+        float et = evTimeTOF.mEventTime;
+        float erret = evTimeTOF.mEventTimeError;
+        float errDiamond = diamond * 33.356409f;
+
+        for (auto const& trk : tracksInCollision) { // Loop on Tracks
+          if constexpr (removeTOFEvTimeBias) {
+            evTimeTOF.template removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, et, erret, 2);
+          }
+          uint8_t flags = 0;
+          if (erret < errDiamond) {
+            flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeTOF;
+          } else {
+            et = 0;
+            erret = errDiamond;
+          }
+          tableFlags(flags);
+          tableEvTime(et, erret, evTimeTOF.mEventTimeMultiplicity);
         }
-        tableFlags(flags);
-        tableEvTime(et, erret, evTimeTOF.mEventTimeMultiplicity);
-      }
+      });
     }
   }
   PROCESS_SWITCH(tofEventTime, processNoFT0, "Process without FT0", true);
@@ -271,60 +338,60 @@ struct tofEventTime {
       const auto& collision = t.collision_as<EvTimeCollisions>();
 
       // Compute the TOF event time
-      const auto evTimeTOF = evTimeMakerForTracks<TrksEvTime::iterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, response, diamond);
-
-      float t0AC[2] = {.0f, 999.f};                                       // Value and error of T0A or T0C or T0AC
-      float t0TOF[2] = {evTimeTOF.mEventTime, evTimeTOF.mEventTimeError}; // Value and error of TOF
-
-      uint8_t flags = 0;
-      int nGoodTracksForTOF = 0;
-      float eventTime = 0.f;
-      float sumOfWeights = 0.f;
-      float weight = 0.f;
-      float errDiamond = diamond * 33.356409f;
-      float weightDiamond = 1. / (errDiamond * errDiamond);
-
-      for (auto const& trk : tracksInCollision) { // Loop on Tracks
-        // Reset the flag
-        flags = 0;
-        // Reset the event time
-        eventTime = 0.f;
-        sumOfWeights = 0.f;
-        weight = 0.f;
-        // Remove the bias on TOF ev. time
-        if constexpr (removeTOFEvTimeBias) {
-          evTimeTOF.removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, t0TOF[0], t0TOF[1], 2);
-        }
-        if (t0TOF[1] < errDiamond) {
-          flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeTOF;
+      computeEvTimeTOF(tracksInCollision, [&](const auto& evTimeTOF) {
+        float t0AC[2] = {.0f, 999.f};                                       // Value and error of T0A or T0C or T0AC
+        float t0TOF[2] = {evTimeTOF.mEventTime, evTimeTOF.mEventTimeError}; // Value and error of TOF
 
-          weight = 1.f / (t0TOF[1] * t0TOF[1]);
-          eventTime += t0TOF[0] * weight;
-          sumOfWeights += weight;
-        }
+        uint8_t flags = 0;
+        int nGoodTracksForTOF = 0;
+        float eventTime = 0.f;
+        float sumOfWeights = 0.f;
+        float weight = 0.f;
+        float errDiamond = diamond * 33.356409f;
+        float weightDiamond = 1. / (errDiamond * errDiamond);
+
+        for (auto const& trk : tracksInCollision) { // Loop on Tracks
+          // Reset the flag
+          flags = 0;
+          // Reset the event time
+          eventTime = 0.f;
+          sumOfWeights = 0.f;
+          weight = 0.f;
+          // Remove the bias on TOF ev. time
+          if constexpr (removeTOFEvTimeBias) {
+            evTimeTOF.template removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, t0TOF[0], t0TOF[1], 2);
+          }
+          if (t0TOF[1] < errDiamond) {
+            flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeTOF;
 
-        if (collision.has_foundFT0()) { // T0 measurement is available
-          // const auto& ft0 = collision.foundFT0();
-          if (collision.t0ACValid()) {
-            t0AC[0] = collision.t0AC();
-            t0AC[1] = collision.t0resolution();
-            flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeT0AC;
+            weight = 1.f / (t0TOF[1] * t0TOF[1]);
+            eventTime += t0TOF[0] * weight;
+            sumOfWeights += weight;
           }
 
-          weight = 1.f / (t0AC[1] * t0AC[1]);
-          eventTime += t0AC[0] * weight;
-          sumOfWeights += weight;
-        }
+          if (collision.has_foundFT0()) { // T0 measurement is available
+            // const auto& ft0 = collision.foundFT0();
+            if (collision.t0ACValid()) {
+              t0AC[0] = collision.t0AC();
+              t0AC[1] = collision.t0resolution();
+              flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeT0AC;
+            }
+
+            weight = 1.f / (t0AC[1] * t0AC[1]);
+            eventTime += t0AC[0] * weight;
+            sumOfWeights += weight;
+          }
 
-        if (sumOfWeights < weightDiamond) { // avoiding sumOfWeights = 0 or worse that diamond
-          eventTime = 0;
-          sumOfWeights = weightDiamond;
-          tableFlags(0);
-        } else {
-          tableFlags(flags);
+          if (sumOfWeights < weightDiamond) { // avoiding sumOfWeights = 0 or worse that diamond
+            eventTime = 0;
+            sumOfWeights = weightDiamond;
+            tableFlags(0);
+          } else {
+            tableFlags(flags);
+          }
+          tableEvTime(eventTime / sumOfWeights, sqrt(1. / sumOfWeights), evTimeTOF.mEventTimeMultiplicity);
         }
-        tableEvTime(eventTime / sumOfWeights, sqrt(1. / sumOfWeights), evTimeTOF.mEventTimeMultiplicity);
-      }
+      });
     }
   }
   PROCESS_SWITCH(tofEventTime, processFT0, "Process with FT0", false);
@@ -0,0 +1,179 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   pidTOFEventTime.h
+/// \author Nicolò Jacazio nicolo.jacazio@cern.ch
+/// \brief  Iterative TOF event time for the collisions with many TOF tracks.
+///         The combinatorial search of o2::tof::evTimeMakerFromParam tests the mass hypotheses of all the tracks together,
+///         its cost grows steeply with the number of tracks. Here each track takes the hypothesis closest to the current
+///         event time and the event time is recomputed from the assigned tracks, until the assignment is stable:
+///         the cost is (number of tracks) x (number of iterations).
+///
+
+#ifndef COMMON_TABLEPRODUCER_PID_PIDTOFEVENTTIME_H_
+#define COMMON_TABLEPRODUCER_PID_PIDTOFEVENTTIME_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "ReconstructionDataFormats/PID.h"
+#include "PID/DetectorResponse.h"
+
+namespace o2::pid::tof
+{
+
+/// Event time of one collision, with the contributions of the tracks to remove their bias
+/// Same interface as o2::tof::eventTimeContainer
+struct IterativeEventTime {
+  float mEventTime = 0.f;          /// Event time (ps)
+  float mEventTimeError = 999.f;   /// Event time error (ps)
+  int mEventTimeMultiplicity = 0;  /// Number of tracks used for the event time
+  float mSumOfWeights = 0.f;       /// Sum of the weights of the used tracks
+  std::vector<float> mTrackT0;     /// t - t_exp of the tracks passing the selection, for their assigned hypothesis
+  std::vector<float> mTrackWeight; /// 1 / sigma^2 of the tracks passing the selection, 0 if the track is not used
+
+  /// Event time and error without the contribution of the track, to be called for all the tracks in the order of the event time computation
+  /// \param nGoodTracks number of tracks passing the selection before this one, incremented if this passes it
+  /// \param minTrack minimum number of remaining tracks to keep the event time
+  template <typename trackType, bool (*trackFilter)(const trackType&)>
+  void removeBias(const trackType& track, int& nGoodTracks, float& evTime, float& evTimeErr, const int& minTrack = 2) const
+  {
+    evTime = mEventTime;
+    evTimeErr = mEventTimeError;
+    if (!trackFilter(track)) {
+      return;
+    }
+    const int index = nGoodTracks++;
+    if (mTrackWeight[index] <= 0.f) { // Track not used
+      return;
+    }
+    if (mEventTimeMultiplicity - 1 < minTrack) {
+      evTime = 0.f;
+      evTimeErr = 999.f;
+      return;
+    }
+    const float sumOfWeights = mSumOfWeights - mTrackWeight[index];
+    evTime = (mEventTime * mSumOfWeights - mTrackT0[index] * mTrackWeight[index]) / sumOfWeights;
+    evTimeErr = 1.f / std::sqrt(sumOfWeights);
+  }
+};
+
+/// Iterative event time from the tracks of a collision, with the pion, kaon and proton hypotheses
+/// \param tracks tracks of the collision
+/// \param responseParameters TOF response (DetectorResponse or compiled resolution), for the expected resolution of the tracks
+/// \param diamond size of the collision diamond (cm), the error of the event time if it cannot be computed
+/// \param maxIterations maximum number of reassignments of the hypotheses
+/// \param nSigmaOutlier tracks farther than this from the event time for all hypotheses are not used
+template <typename trackType,
+          bool (*trackFilter)(const trackType&),
+          template <typename T, o2::track::PID::ID> typename response,
+          typename trackTypeContainer,
+          typename responseParametersType>
+IterativeEventTime evTimeMakerIterative(const trackTypeContainer& tracks,
+                                        const responseParametersType& responseParameters,
+                                        const float diamond = 6.0,
+                                        const int maxIterations = 10,
+                                        const float nSigmaOutlier = 3.f)
+{
+  static constexpr int nHypotheses = 3;
+  IterativeEventTime result;
+  result.mEventTimeError = diamond * 33.356409f;
+
+  // t - t_exp and 1 / sigma^2 of each hypothesis, computed once per track
+  std::vector<std::array<float, nHypotheses>> t0s;
+  std::vector<std::array<float, nHypotheses>> weights;
+  for (auto const& track : tracks) {
+    if (!trackFilter(track)) {
+      continue;
+    }
+    const std::array<float, nHypotheses> expTimes = {response<trackType, o2::track::PID::Pion>::GetExpectedSignal(track),
+                                                     response<trackType, o2::track::PID::Kaon>::GetExpectedSignal(track),
+                                                     response<trackType, o2::track::PID::Proton>::GetExpectedSignal(track)};
+    const std::array<float, nHypotheses> sigmas = {response<trackType, o2::track::PID::Pion>::GetExpectedSigmaTracking(responseParameters, track),
+                                                   response<trackType, o2::track::PID::Kaon>::GetExpectedSigmaTracking(responseParameters, track),
+                                                   response<trackType, o2::track::PID::Proton>::GetExpectedSigmaTracking(responseParameters, track)};
+    auto& t0 = t0s.emplace_back();
+    auto& weight = weights.emplace_back();
+    for (int h = 0; h < nHypotheses; h++) {
+      t0[h] = track.tofSignal() - expTimes[h];
+      weight[h] = sigmas[h] > 0.f ? 1.f / (sigmas[h] * sigmas[h]) : 0.f;
+    }
+  }
+  const int nTracks = t0s.size();
+  result.mTrackT0.assign(nTracks, 0.f);
+  result.mTrackWeight.assign(nTracks, 0.f);
+  if (nTracks < 2) {
+    return result;
+  }
+
+  // Start from the median with the pion hypothesis, robust against the mismatches
+  std::vector<float> pionT0(nTracks);
+  for (int i = 0; i < nTracks; i++) {
+    pionT0[i] = t0s[i][0];
+  }
+  std::nth_element(pionT0.begin(), pionT0.begin() + nTracks / 2, pionT0.end());
+  float eventTime = pionT0[nTracks / 2];
+
+  std::vector<int> assigned(nTracks, -2); // Hypothesis of each track, -1 if not used
+  const float maxPull2 = nSigmaOutlier * nSigmaOutlier;
+  for (int iteration = 0; iteration < maxIterations; iteration++) {
+    bool changed = false;
+    float sumOfWeights = 0.f;
+    float sumOfT0 = 0.f;
+    int nUsed = 0;
+    for (int i = 0; i < nTracks; i++) {
+      int best = -1;
+      float bestPull2 = maxPull2;
+      for (int h = 0; h < nHypotheses; h++) {
+        const float pull2 = (t0s[i][h] - eventTime) * (t0s[i][h] - eventTime) * weights[i][h];
+        if (weights[i][h] > 0.f && pull2 < bestPull2) {
+          best = h;
+          bestPull2 = pull2;
+        }
+      }
+      changed |= best != assigned[i];
+      assigned[i] = best;
+      if (best < 0) {
+        continue;
+      }
+      sumOfWeights += weights[i][best];
+      sumOfT0 += t0s[i][best] * weights[i][best];
+      nUsed++;
+    }
+    if (nUsed < 2) {
+      result.mEventTimeMultiplicity = nUsed;
+      return result;
+    }
+    eventTime = sumOfT0 / sumOfWeights;
+    result.mSumOfWeights = sumOfWeights;
+    result.mEventTimeMultiplicity = nUsed;
+    if (!changed) {
+      break;
+    }
+  }
+
+  result.mEventTime = eventTime;
+  result.mEventTimeError = 1.f / std::sqrt(result.mSumOfWeights);
+  for (int i = 0; i < nTracks; i++) {
+    if (assigned[i] >= 0) {
+      result.mTrackT0[i] = t0s[i][assigned[i]];
+      result.mTrackWeight[i] = weights[i][assigned[i]];
+    }
+  }
+  return result;
+}
+
+} // namespace o2::pid::tof
+
+#endif // COMMON_TABLEPRODUCER_PID_PIDTOFEVENTTIME_H_
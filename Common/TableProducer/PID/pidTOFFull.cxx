@@ -27,6 +27,7 @@
 #include "TableHelper.h"
 #include "pidTOFBase.h"
 #include "DPG/Tasks/AOTTrack/PID/qaPIDTOF.h"
+#include "Common/Core/CCDBObjectCache.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -63,6 +64,7 @@ struct tofPidFull {
   Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
   Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
   Configurable<bool> enableTimeDependentResponse{"enableTimeDependentResponse", false, "Flag to use the collision timestamp to fetch the PID Response"};
+  Configurable<std::string> rctPath{"rct-path", "RCT/Info/RunInformation", "path to the ccdb RCT objects for the SOR/EOR timestamps, used to prefetch the time dependent response of a run"};
   // Configuration flags to include and exclude particle hypotheses
   Configurable<int> pidEl{"pid-el", -1, {"Produce PID information for the Electron mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidMu{"pid-mu", -1, {"Produce PID information for the Muon mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
@@ -75,6 +77,7 @@ struct tofPidFull {
   Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   // Running variables
   std::string parametrizationPath = "";
+  o2::analysis::CCDBObjectCache<o2::pid::tof::TOFResoParams> mRespParamsCache; // Time dependent parametrizations of the runs being processed
 
   void init(o2::framework::InitContext& initContext)
   {
@@ -83,8 +86,9 @@ struct tofPidFull {
     }
 
     // Checking the tables are requested in the workflow and enabling them
+    const auto requiredTables = getTablesRequiredInWorkflow(initContext);
     auto enableFlag = [&](const std::string particle, Configurable<int>& flag) {
-      enableFlagIfTableRequired(initContext, "pidTOFFull" + particle, flag);
+      enableFlagIfTableRequired(requiredTables, "pidTOFFull" + particle, flag);
     };
 
     enableFlag("El", pidEl);
@@ -103,7 +107,8 @@ struct tofPidFull {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
     // Not later than now objects
-    ccdb->setCreatedNotAfter(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    const int64_t createdNotAfter = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    ccdb->setCreatedNotAfter(createdNotAfter);
     //
     const std::string fname = paramfile.value;
     if (!fname.empty()) { // Loading the parametrization from file
@@ -115,6 +120,8 @@ struct tofPidFull {
         LOG(info) << "Loading exp. sigma parametrization from CCDB, using path: '" << parametrizationPath << "' for timestamp " << timestamp.value;
         mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp.value));
         mRespParams.Print();
+      } else {
+        mRespParamsCache.init(url.value, parametrizationPath, rctPath.value, createdNotAfter);
       }
     }
   }
@@ -182,10 +189,11 @@ struct tofPidFull {
 
       // Fill new table for the tracks in a collision
       lastCollisionId = track.collisionId(); // Cache last collision ID
-      timestamp.value = track.collision().bc_as<aod::BCsWithTimestamps>().timestamp();
+      const auto& bc = track.collision().bc_as<aod::BCsWithTimestamps>();
+      timestamp.value = bc.timestamp();
       if (enableTimeDependentResponse) {
         LOG(debug) << "Updating parametrization from path '" << parametrizationPath << "' and timestamp " << timestamp.value;
-        mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
+        mRespParams.SetParameters(mRespParamsCache.getForRun(bc.runNumber(), timestamp.value));
       }
 
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
@@ -267,9 +275,10 @@ struct tofPidFull {
 
       if (enableTimeDependentResponse && (track.collisionId() != lastCollisionId)) { // Time dependent calib is enabled and this is a new collision
         lastCollisionId = track.collisionId();                                       // Cache last collision ID
-        timestamp.value = track.collision().bc_as<aod::BCsWithTimestamps>().timestamp();
+        const auto& bc = track.collision().bc_as<aod::BCsWithTimestamps>();
+        timestamp.value = bc.timestamp();
         LOG(debug) << "Updating parametrization from path '" << parametrizationPath << "' and timestamp " << timestamp.value;
-        mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
+        mRespParams.SetParameters(mRespParamsCache.getForRun(bc.runNumber(), timestamp.value));
       }
 
       // Check and fill enabled tables
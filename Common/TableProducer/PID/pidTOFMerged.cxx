@@ -0,0 +1,281 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   pidTOFMerged.cxx
+/// \author Nicolò Jacazio nicolo.jacazio@cern.ch
+/// \brief  Task to produce the tiny and full PID tables for TOF, the beta and the mass tables in a single pass on the tracks.
+///         Replaces pid-tof, pid-tof-full and pid-tof-beta when more than one of them is needed: the Nsigma of each mass
+///         hypothesis is computed once and served to both the tiny and the full table, beta is computed once for the beta and the mass tables.
+///         The tables are produced if they are required in the workflow. Do not run it together with the tasks it replaces.
+///         QA histograms for the TOF PID can be produced by adding `--add-qa 1` to the workflow
+///
+
+// O2 includes
+#include <CCDB/BasicCCDBManager.h>
+#include "Framework/AnalysisTask.h"
+#include "ReconstructionDataFormats/Track.h"
+
+// O2Physics includes
+#include "TableHelper.h"
+#include "pidTOFBase.h"
+#include "DPG/Tasks/AOTTrack/PID/qaPIDTOF.h"
+#include "Common/Core/CCDBObjectCache.h"
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::pid;
+using namespace o2::framework::expressions;
+using namespace o2::track;
+
+void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
+{
+  std::vector<ConfigParamSpec> options{{"add-qa", VariantType::Int, 0, {"Produce TOF PID QA histograms"}}};
+  std::swap(workflowOptions, options);
+}
+
+#include "Framework/runDataProcessing.h"
+
+/// Task to produce the response tables
+struct tofPidMerged {
+  // Tables to produce
+  Produces<o2::aod::pidTOFEl> tablePIDEl;
+  Produces<o2::aod::pidTOFMu> tablePIDMu;
+  Produces<o2::aod::pidTOFPi> tablePIDPi;
+  Produces<o2::aod::pidTOFKa> tablePIDKa;
+  Produces<o2::aod::pidTOFPr> tablePIDPr;
+  Produces<o2::aod::pidTOFDe> tablePIDDe;
+  Produces<o2::aod::pidTOFTr> tablePIDTr;
+  Produces<o2::aod::pidTOFHe> tablePIDHe;
+  Produces<o2::aod::pidTOFAl> tablePIDAl;
+  Produces<o2::aod::pidTOFFullEl> tablePIDFullEl;
+  Produces<o2::aod::pidTOFFullMu> tablePIDFullMu;
+  Produces<o2::aod::pidTOFFullPi> tablePIDFullPi;
+  Produces<o2::aod::pidTOFFullKa> tablePIDFullKa;
+  Produces<o2::aod::pidTOFFullPr> tablePIDFullPr;
+  Produces<o2::aod::pidTOFFullDe> tablePIDFullDe;
+  Produces<o2::aod::pidTOFFullTr> tablePIDFullTr;
+  Produces<o2::aod::pidTOFFullHe> tablePIDFullHe;
+  Produces<o2::aod::pidTOFFullAl> tablePIDFullAl;
+  Produces<aod::pidTOFbeta> tablePIDBeta;
+  Produces<aod::pidTOFmass> tablePIDTOFMass;
+  // Detector response parameters
+  o2::pid::tof::TOFResoParams mRespParams;
+  Service<o2::ccdb::BasicCCDBManager> ccdb;
+  Configurable<std::string> paramfile{"param-file", "", "Path to the parametrization object, if emtpy the parametrization is not taken from file"};
+  Configurable<std::string> sigmaname{"param-sigma", "TOFResoParams", "Name of the parametrization for the expected sigma, used in both file and CCDB mode"};
+  Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
+  Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
+  Configurable<long> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
+  Configurable<bool> enableTimeDependentResponse{"enableTimeDependentResponse", false, "Flag to use the collision timestamp to fetch the PID Response"};
+  Configurable<std::string> rctPath{"rct-path", "RCT/Info/RunInformation", "path to the ccdb RCT objects for the SOR/EOR timestamps, used to prefetch the time dependent response of a run"};
+  Configurable<float> expreso{"tof-expreso", 80, "Expected resolution for the computation of the expected beta"};
+  // Configuration flags to include and exclude particle hypotheses
+  Configurable<int> pidEl{"pid-el", -1, {"Produce PID information for the Electron mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidMu{"pid-mu", -1, {"Produce PID information for the Muon mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidPi{"pid-pi", -1, {"Produce PID information for the Pion mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidKa{"pid-ka", -1, {"Produce PID information for the Kaon mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidPr{"pid-pr", -1, {"Produce PID information for the Proton mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidDe{"pid-de", -1, {"Produce PID information for the Deuterons mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidTr{"pid-tr", -1, {"Produce PID information for the Triton mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidHe{"pid-he", -1, {"Produce PID information for the Helium3 mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding tiny and full tables can be set off (0) or on (1)"}};
+  // Running variables
+  std::string parametrizationPath = "";
+  o2::analysis::CCDBObjectCache<o2::pid::tof::TOFResoParams> mRespParamsCache; // Time dependent parametrizations of the runs being processed
+  std::array<bool, PID::NIDs> enableTableTiny{};                               // Tiny tables to fill, per mass hypothesis
+  std::array<bool, PID::NIDs> enableTableFull{};                               // Full tables to fill, per mass hypothesis
+  bool enableTableBeta = false;
+  bool enableTableMass = false;
+
+  void init(o2::framework::InitContext& initContext)
+  {
+    // Checking the tables are requested in the workflow and enabling them
+    auto enableFlag = [&](const std::string particle, const Configurable<int>& flag, const PID::ID id) {
+      if (flag.value == 0) {
+        LOG(info) << "Tables disabled for " << particle;
+        return;
+      }
+      enableTableTiny[id] = flag.value == 1 || isTableRequiredInWorkflow(initContext, "pidTOF" + particle);
+      enableTableFull[id] = flag.value == 1 || isTableRequiredInWorkflow(initContext, "pidTOFFull" + particle);
+      if (enableTableTiny[id]) {
+        LOG(info) << "Table enabled: pidTOF" + particle;
+      }
+      if (enableTableFull[id]) {
+        LOG(info) << "Table enabled: pidTOFFull" + particle;
+      }
+    };
+
+    enableFlag("El", pidEl, PID::Electron);
+    enableFlag("Mu", pidMu, PID::Muon);
+    enableFlag("Pi", pidPi, PID::Pion);
+    enableFlag("Ka", pidKa, PID::Kaon);
+    enableFlag("Pr", pidPr, PID::Proton);
+    enableFlag("De", pidDe, PID::Deuteron);
+    enableFlag("Tr", pidTr, PID::Triton);
+    enableFlag("He", pidHe, PID::Helium3);
+    enableFlag("Al", pidAl, PID::Alpha);
+
+    enableTableBeta = isTableRequiredInWorkflow(initContext, "pidTOFbeta");
+    enableTableMass = isTableRequiredInWorkflow(initContext, "pidTOFmass");
+    responseBeta.mExpectedResolution = expreso.value;
+
+    // Getting the parametrization parameters
+    ccdb->setURL(url.value);
+    ccdb->setTimestamp(timestamp.value);
+    ccdb->setCaching(true);
+    ccdb->setLocalObjectValidityChecking();
+    // Not later than now objects
+    const int64_t createdNotAfter = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    ccdb->setCreatedNotAfter(createdNotAfter);
+    //
+    const std::string fname = paramfile.value;
+    if (!fname.empty()) { // Loading the parametrization from file
+      LOG(info) << "Loading exp. sigma parametrization from file" << fname << ", using param: " << sigmaname.value;
+      mRespParams.LoadParamFromFile(fname.data(), sigmaname.value);
+    } else { // Loading it from CCDB
+      parametrizationPath = ccdbPath.value + "/" + sigmaname.value;
+      if (!enableTimeDependentResponse) {
+        LOG(info) << "Loading exp. sigma parametrization from CCDB, using path: '" << parametrizationPath << "' for timestamp " << timestamp.value;
+        mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp.value));
+        mRespParams.Print();
+      } else {
+        mRespParamsCache.init(url.value, parametrizationPath, rctPath.value, createdNotAfter);
+      }
+    }
+  }
+
+  using Trks = soa::Join<aod::Tracks, aod::TracksExtra, aod::TOFSignal, aod::TOFEvTime, aod::pidEvTimeFlags>;
+  tof::Beta<Trks::iterator> responseBeta;
+  template <o2::track::PID::ID pid>
+  using ResponseImplementation = o2::pid::tof::ExpTimes<Trks::iterator, pid>;
+  void process(Trks const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const&)
+  {
+    constexpr auto responseEl = ResponseImplementation<PID::Electron>();
+    constexpr auto responseMu = ResponseImplementation<PID::Muon>();
+    constexpr auto responsePi = ResponseImplementation<PID::Pion>();
+    constexpr auto responseKa = ResponseImplementation<PID::Kaon>();
+    constexpr auto responsePr = ResponseImplementation<PID::Proton>();
+    constexpr auto responseDe = ResponseImplementation<PID::Deuteron>();
+    constexpr auto responseTr = ResponseImplementation<PID::Triton>();
+    constexpr auto responseHe = ResponseImplementation<PID::Helium3>();
+    constexpr auto responseAl = ResponseImplementation<PID::Alpha>();
+
+    auto reserveTable = [&tracks, this](const PID::ID id, auto& tableTiny, auto& tableFull) {
+      if (enableTableTiny[id]) {
+        tableTiny.reserve(tracks.size());
+      }
+      if (enableTableFull[id]) {
+        tableFull.reserve(tracks.size());
+      }
+    };
+
+    reserveTable(PID::Electron, tablePIDEl, tablePIDFullEl);
+    reserveTable(PID::Muon, tablePIDMu, tablePIDFullMu);
+    reserveTable(PID::Pion, tablePIDPi, tablePIDFullPi);
+    reserveTable(PID::Kaon, tablePIDKa, tablePIDFullKa);
+    reserveTable(PID::Proton, tablePIDPr, tablePIDFullPr);
+    reserveTable(PID::Deuteron, tablePIDDe, tablePIDFullDe);
+    reserveTable(PID::Triton, tablePIDTr, tablePIDFullTr);
+    reserveTable(PID::Helium3, tablePIDHe, tablePIDFullHe);
+    reserveTable(PID::Alpha, tablePIDAl, tablePIDFullAl);
+    if (enableTableBeta) {
+      tablePIDBeta.reserve(tracks.size());
+    }
+    if (enableTableMass) {
+      tablePIDTOFMass.reserve(tracks.size());
+    }
+
+    int lastCollisionId = -1;          // Last collision ID analysed
+    for (auto const& track : tracks) { // Loop on all tracks
+      // Beta does not depend on the response parameters, same values as pid-tof-beta also for the tracks without collision
+      if (enableTableBeta || enableTableMass) {
+        const float beta = responseBeta.GetBeta(track);
+        if (enableTableBeta) {
+          const float expSigmaBeta = responseBeta.GetExpectedSigma(track);
+          tablePIDBeta(beta,
+                       expSigmaBeta,
+                       responseBeta.GetExpectedSignal<o2::track::PID::Electron>(track),
+                       expSigmaBeta,
+                       (beta - responseBeta.GetExpectedSignal<o2::track::PID::Electron>(track)) / expSigmaBeta);
+        }
+        if (enableTableMass) {
+          tablePIDTOFMass(o2::pid::tof::TOFMass<Trks::iterator>::GetTOFMass(track, beta));
+        }
+      }
+
+      if (!track.has_collision()) { // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
+        auto makeTableEmpty = [this](const PID::ID id, auto& tableTiny, auto& tableFull) {
+          if (enableTableTiny[id]) {
+            aod::pidutils::packInTable<aod::pidtof_tiny::binning>(-999.f, tableTiny);
+          }
+          if (enableTableFull[id]) {
+            tableFull(-999.f, -999.f);
+          }
+        };
+
+        makeTableEmpty(PID::Electron, tablePIDEl, tablePIDFullEl);
+        makeTableEmpty(PID::Muon, tablePIDMu, tablePIDFullMu);
+        makeTableEmpty(PID::Pion, tablePIDPi, tablePIDFullPi);
+        makeTableEmpty(PID::Kaon, tablePIDKa, tablePIDFullKa);
+        makeTableEmpty(PID::Proton, tablePIDPr, tablePIDFullPr);
+        makeTableEmpty(PID::Deuteron, tablePIDDe, tablePIDFullDe);
+        makeTableEmpty(PID::Triton, tablePIDTr, tablePIDFullTr);
+        makeTableEmpty(PID::Helium3, tablePIDHe, tablePIDFullHe);
+        makeTableEmpty(PID::Alpha, tablePIDAl, tablePIDFullAl);
+
+        continue;
+      }
+
+      if (enableTimeDependentResponse && (track.collisionId() != lastCollisionId)) { // Time dependent calib is enabled and this is a new collision
+        lastCollisionId = track.collisionId();                                       // Cache last collision ID
+        const auto& bc = track.collision().bc_as<aod::BCsWithTimestamps>();
+        timestamp.value = bc.timestamp();
+        LOG(debug) << "Updating parametrization from path '" << parametrizationPath << "' and timestamp " << timestamp.value;
+        mRespParams.SetParameters(mRespParamsCache.getForRun(bc.runNumber(), timestamp.value));
+      }
+
+      // Nsigma computed once for the tiny and the full tables, the expected sigma of the full tables as in pid-tof-full
+      auto makeTable = [&track, this](const PID::ID id, auto& tableTiny, auto& tableFull, const auto& responsePID) {
+        if (!enableTableTiny[id] && !enableTableFull[id]) {
+          return;
+        }
+        const float nSigma = responsePID.GetSeparation(mRespParams, track);
+        if (enableTableTiny[id]) {
+          aod::pidutils::packInTable<aod::pidtof_tiny::binning>(nSigma, tableTiny);
+        }
+        if (enableTableFull[id]) {
+          tableFull(responsePID.GetExpectedSigma(mRespParams, track), nSigma);
+        }
+      };
+
+      makeTable(PID::Electron, tablePIDEl, tablePIDFullEl, responseEl);
+      makeTable(PID::Muon, tablePIDMu, tablePIDFullMu, responseMu);
+      makeTable(PID::Pion, tablePIDPi, tablePIDFullPi, responsePi);
+      makeTable(PID::Kaon, tablePIDKa, tablePIDFullKa, responseKa);
+      makeTable(PID::Proton, tablePIDPr, tablePIDFullPr, responsePr);
+      makeTable(PID::Deuteron, tablePIDDe, tablePIDFullDe, responseDe);
+      makeTable(PID::Triton, tablePIDTr, tablePIDFullTr, responseTr);
+      makeTable(PID::Helium3, tablePIDHe, tablePIDFullHe, responseHe);
+      makeTable(PID::Alpha, tablePIDAl, tablePIDFullAl, responseAl);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  auto workflow = WorkflowSpec{adaptAnalysisTask<tofPidMerged>(cfgc)};
+  if (cfgc.options().get<int>("add-qa")) {
+    workflow.push_back(adaptAnalysisTask<tofPidQa>(cfgc));
+  }
+
+  return workflow;
+}
@@ -33,6 +33,7 @@
 #include "Common/DataModel/Multiplicity.h"
 #include "TableHelper.h"
 #include "Common/TableProducer/PID/pidTPCML.h"
+#include "Common/Core/CCDBObjectCache.h"
 #include "DPG/Tasks/AOTTrack/PID/qaPIDTPC.h"
 
 using namespace o2;
@@ -78,12 +79,16 @@ struct tpcPid {
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TPC/Response", "Path of the TPC parametrization on the CCDB"};
   Configurable<long> ccdbTimestamp{"ccdb-timestamp", 0, "timestamp of the object used to query in CCDB the detector response. Exceptions: -1 gets the latest object, 0 gets the run dependent timestamp"};
+  Configurable<std::string> rctPath{"rct-path", "RCT/Info/RunInformation", "path to the ccdb RCT objects for the SOR/EOR timestamps, used to prefetch the run dependent response"};
   // Parameters for loading network from a file / downloading the file
   Configurable<bool> useNetworkCorrection{"useNetworkCorrection", 0, "(bool) Wether or not to use the network correction for the TPC dE/dx signal"};
   Configurable<bool> autofetchNetworks{"autofetchNetworks", 1, "(bool) Automatically fetches networks from CCDB for the correct run number"};
   Configurable<std::string> networkPathLocally{"networkPathLocally", "network.onnx", "(std::string) Path to the local .onnx file. If autofetching is enabled, then this is where the files will be downloaded"};
   Configurable<bool> enableNetworkOptimizations{"enableNetworkOptimizations", 1, "(bool) If the neural network correction is used, this enables GraphOptimizationLevel::ORT_ENABLE_EXTENDED in the ONNX session"};
   Configurable<std::string> networkPathCCDB{"networkPathCCDB", "Analysis/PID/TPC/ML", "Path on CCDB"};
+  Configurable<int> networkNThreadsIntraOp{"networkNThreadsIntraOp", 0, "(int) Number of ONNX runtime threads within an operator of the network, 0 is the ONNX runtime default"};
+  Configurable<int> networkNThreadsInterOp{"networkNThreadsInterOp", 0, "(int) Number of ONNX runtime threads across operators of the network, 0 is the ONNX runtime default"};
+  Configurable<int> networkExecutionProvider{"networkExecutionProvider", 0, "(int) ONNX runtime execution provider of the network: 0 CPU, 1 CUDA, 2 TensorRT (falls back to CPU if not available)"};
   // Configuration flags to include and exclude particle hypotheses
   Configurable<int> pidEl{"pid-el", -1, {"Produce PID information for the Electron mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidMu{"pid-mu", -1, {"Produce PID information for the Muon mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
@@ -97,12 +102,15 @@ struct tpcPid {
 
   // Paramatrization configuration
   bool useCCDBParam = false;
+  o2::analysis::CCDBObjectCache<o2::pid::tpc::Response> responseCache; // Run dependent responses of the runs being processed
+  const o2::pid::tpc::Response* lastResponse = nullptr;                // Response currently loaded in response
 
   void init(o2::framework::InitContext& initContext)
   {
     // Checking the tables are requested in the workflow and enabling them
+    const auto requiredTables = getTablesRequiredInWorkflow(initContext);
     auto enableFlag = [&](const std::string particle, Configurable<int>& flag) {
-      enableFlagIfTableRequired(initContext, "pidTPC" + particle, flag);
+      enableFlagIfTableRequired(requiredTables, "pidTPC" + particle, flag);
     };
     enableFlag("El", pidEl);
     enableFlag("Mu", pidMu);
@@ -132,13 +140,16 @@ struct tpcPid {
 
       ccdb->setCaching(true);
       ccdb->setLocalObjectValidityChecking();
-      ccdb->setCreatedNotAfter(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+      const int64_t createdNotAfter = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      ccdb->setCreatedNotAfter(createdNotAfter);
       if (time != 0) {
         LOGP(info, "Initialising TPC PID response for fixed timestamp {}:", time);
         ccdb->setTimestamp(time);
         response.SetParameters(ccdb->getForTimeStamp<o2::pid::tpc::Response>(path, time));
-      } else
+      } else {
+        responseCache.init(url.value, path, rctPath.value, createdNotAfter);
         LOGP(info, "Initialising default TPC PID response:");
+      }
       response.PrintAll();
     }
 
@@ -163,7 +174,10 @@ struct tpcPid {
             Network temp_net(networkPathLocally.value,
                              strtoul(headers["Valid-From"].c_str(), NULL, 0),
                              strtoul(headers["Valid-Until"].c_str(), NULL, 0),
-                             enableNetworkOptimizations.value);
+                             enableNetworkOptimizations.value,
+                             networkNThreadsIntraOp.value,
+                             networkNThreadsInterOp.value,
+                             networkExecutionProvider.value);
             network = temp_net;
             network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
           } else {
@@ -176,7 +190,10 @@ struct tpcPid {
           }
           LOG(info) << "Using local file [" << networkPathLocally.value << "] for the TPC PID response correction.";
           Network temp_net(networkPathLocally.value,
-                           enableNetworkOptimizations.value);
+                           enableNetworkOptimizations.value,
+                           networkNThreadsIntraOp.value,
+                           networkNThreadsInterOp.value,
+                           networkExecutionProvider.value);
           network = temp_net;
           network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
         }
@@ -235,7 +252,10 @@ struct tpcPid {
             Network temp_net(networkPathLocally.value,
                              strtoul(headers["Valid-From"].c_str(), NULL, 0),
                              strtoul(headers["Valid-Until"].c_str(), NULL, 0),
-                             enableNetworkOptimizations.value);
+                             enableNetworkOptimizations.value,
+                             networkNThreadsIntraOp.value,
+                             networkNThreadsInterOp.value,
+                             networkExecutionProvider.value);
             network = temp_net;
             network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
           } else {
@@ -254,36 +274,33 @@ struct tpcPid {
 
       float duration_network = 0;
 
-      std::vector<float> track_properties(track_prop_size);
-      unsigned long counter_track_props = 0;
-      int loop_counter = 0;
+      std::vector<float> track_properties(track_prop_size * 9);
+      unsigned long counter_track = 0;
 
       // Filling a std::vector<float> to be evaluated by the network
-      // Evaluation on single tracks brings huge overhead: Thus evaluation is done on one large vector
-      for (int i = 0; i < 9; i++) { // Loop over particle number for which network correction is used
-        for (auto const& trk : tracks) {
+      // Evaluation on single tracks brings huge overhead: Thus all mass hypotheses of all tracks are evaluated in one large vector
+      // The entries are ordered by mass hypothesis first, as expected when reading network_prediction
+      for (auto const& trk : tracks) {
+        const float multTPC = collisions.iteratorAt(trk.collisionId()).multTPC() / 11000.;
+        const float nClNorm = std::sqrt(nNclNormalization / trk.tpcNClsFound());
+        for (int i = 0; i < 9; i++) { // Loop over particle number for which network correction is used
+          const unsigned long counter_track_props = (i * tracks_size + counter_track) * input_dimensions;
           track_properties[counter_track_props] = trk.tpcInnerParam();
           track_properties[counter_track_props + 1] = trk.tgl();
           track_properties[counter_track_props + 2] = trk.signed1Pt();
           track_properties[counter_track_props + 3] = o2::track::pid_constants::sMasses[i];
-          track_properties[counter_track_props + 4] = collisions.iteratorAt(trk.collisionId()).multTPC() / 11000.;
-          track_properties[counter_track_props + 5] = std::sqrt(nNclNormalization / trk.tpcNClsFound());
-          counter_track_props += input_dimensions;
-        }
-
-        auto start_network_eval = std::chrono::high_resolution_clock::now();
-        float* output_network = network.evalNetwork(track_properties);
-        auto stop_network_eval = std::chrono::high_resolution_clock::now();
-        duration_network += std::chrono::duration<float, std::ratio<1, 1000000000>>(stop_network_eval - start_network_eval).count();
-        for (unsigned long i = 0; i < prediction_size; i += output_dimensions) {
-          for (int j = 0; j < output_dimensions; j++) {
-            network_prediction[i + j + prediction_size * loop_counter] = output_network[i + j];
-          }
+          track_properties[counter_track_props + 4] = multTPC;
+          track_properties[counter_track_props + 5] = nClNorm;
         }
+        counter_track++;
+      }
 
-        counter_track_props = 0;
-        loop_counter += 1;
+      auto start_network_eval = std::chrono::high_resolution_clock::now();
+      if (!network.evalNetwork(track_properties, network_prediction.data())) {
+        LOG(fatal) << "Evaluation of the network for the TPC PID response correction failed";
       }
+      auto stop_network_eval = std::chrono::high_resolution_clock::now();
+      duration_network += std::chrono::duration<float, std::ratio<1, 1000000000>>(stop_network_eval - start_network_eval).count();
       track_properties.clear();
 
       auto stop_network_total = std::chrono::high_resolution_clock::now();
@@ -299,7 +316,11 @@ struct tpcPid {
       if (useCCDBParam && ccdbTimestamp.value == 0 && trk.has_collision() && trk.collisionId() != lastCollisionId) { // Updating parametrization only if the initial timestamp is 0
         lastCollisionId = trk.collisionId();
         const auto& bc = collisions.iteratorAt(trk.collisionId()).bc_as<aod::BCsWithTimestamps>();
-        response.SetParameters(ccdb->getForTimeStamp<o2::pid::tpc::Response>(ccdbPath.value, bc.timestamp()));
+        const auto* runResponse = responseCache.getForRun(bc.runNumber(), bc.timestamp());
+        if (runResponse != lastResponse) { // Parameters are copied only when the validity interval changes
+          response.SetParameters(runResponse);
+          lastResponse = runResponse;
+        }
       }
       // Check and fill enabled tables
       auto makeTable = [&trk, &collisions, &network_prediction, &count_tracks, &tracks_size, this](const Configurable<int>& flag, auto& table, const o2::track::PID::ID pid) {
@@ -24,6 +24,7 @@
 // O2 includes
 #include "Framework/Logger.h"
 #include "Common/TableProducer/PID/pidTPCML.h"
+#include "Common/Core/OnnxSessionRegistry.h"
 #include "ReconstructionDataFormats/PID.h"
 #include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
 
@@ -39,32 +40,25 @@ std::string Network::printShape(const std::vector<int64_t>& v)
   return ss.str();
 }
 
-Network::Network(std::string path,
-                 bool enableOptimization = true)
+void Network::initSession(const std::string& path, bool enableOptimization, int nThreadsIntraOp, int nThreadsInterOp, int executionProvider, bool reload)
 {
 
   /*
-  Constructor: Creating a class instance from a file and enabling optimizations with the boolean option.
-  - Input:
-    -- pathLocally:         std::string   ; Path to the model file;
-    -- loadFromAlien:       bool          ; Download network from AliEn directory (true) or use local file (false)
-    -- pathAlien:           std::string   ; if loadFromAlien is true, then the network will be downloaded from pathAlien
-    -- enableOptimization:  bool          ; enabling optimizations for the loaded model in the session options;
+  Function: Getting the session of the model from the process-wide registry, which loads each file only once
   */
 
-  LOG(info) << "--- Neural Network for the TPC PID response correction ---";
+  o2::analysis::OnnxSessionSettings settings;
+  settings.enableOptimization = enableOptimization;
+  settings.nThreadsIntraOp = nThreadsIntraOp;
+  settings.nThreadsInterOp = nThreadsInterOp;
+  settings.executionProvider = executionProvider;
+  LOG(info) << "ONNX runtime threads: intra-op " << nThreadsIntraOp << ", inter-op " << nThreadsInterOp << " (0: default)";
+  mModel = o2::analysis::OnnxSessionRegistry::instance().getModel(path, settings, reload);
 
-  mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "pid-neural-network");
-  if (enableOptimization) {
-    sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-  }
-
-  mSession.reset(new Ort::Experimental::Session{*mEnv, path, sessionOptions});
-
-  mInputNames = mSession->GetInputNames();
-  mInputShapes = mSession->GetInputShapes();
-  mOutputNames = mSession->GetOutputNames();
-  mOutputShapes = mSession->GetOutputShapes();
+  mInputNames = mModel->inputNames();
+  mInputShapes = mModel->inputShapes();
+  mOutputNames = mModel->outputNames();
+  mOutputShapes = mModel->outputShapes();
 
   LOG(info) << "Input Nodes:";
   for (size_t i = 0; i < mInputNames.size(); i++) {
@@ -76,6 +70,31 @@ Network::Network(std::string path,
     LOG(info) << "\t" << mOutputNames[i] << " : " << printShape(mOutputShapes[i]);
   }
 
+} // function Network::initSession(const std::string&, bool, int, int, int, bool)
+
+Network::Network(std::string path,
+                 bool enableOptimization = true,
+                 int nThreadsIntraOp,
+                 int nThreadsInterOp,
+                 int executionProvider)
+{
+
+  /*
+  Constructor: Creating a class instance from a file and enabling optimizations with the boolean option.
+  - Input:
+    -- pathLocally:         std::string   ; Path to the model file;
+    -- loadFromAlien:       bool          ; Download network from AliEn directory (true) or use local file (false)
+    -- pathAlien:           std::string   ; if loadFromAlien is true, then the network will be downloaded from pathAlien
+    -- enableOptimization:  bool          ; enabling optimizations for the loaded model in the session options;
+    -- nThreadsIntraOp:     int           ; number of threads used within an operator, 0 is the ONNX runtime default;
+    -- nThreadsInterOp:     int           ; number of threads used across operators, 0 is the ONNX runtime default;
+    -- executionProvider:   int           ; ExecutionProvider of the session (CPU, CUDA, TensorRT);
+  */
+
+  LOG(info) << "--- Neural Network for the TPC PID response correction ---";
+
+  initSession(path, enableOptimization, nThreadsIntraOp, nThreadsInterOp, executionProvider, false);
+
   LOG(info) << "--- Network initialized! ---";
 
 } // Network::Network(std::string, bool)
@@ -83,7 +102,10 @@ Network::Network(std::string path,
 Network::Network(std::string path,
                  unsigned long start,
                  unsigned long end,
-                 bool enableOptimization = true)
+                 bool enableOptimization = true,
+                 int nThreadsIntraOp,
+                 int nThreadsInterOp,
+                 int executionProvider)
 {
 
   /*
@@ -93,31 +115,14 @@ Network::Network(std::string path,
     -- start:               unsigned long ; Timestamp validity of model (start)
     -- pathAlien:           unsigned long ; Timestamp validity of model (end)
     -- enableOptimization:  bool          ; enabling optimizations for the loaded model in the session options;
+    -- nThreadsIntraOp:     int           ; number of threads used within an operator, 0 is the ONNX runtime default;
+    -- nThreadsInterOp:     int           ; number of threads used across operators, 0 is the ONNX runtime default;
+    -- executionProvider:   int           ; ExecutionProvider of the session (CPU, CUDA, TensorRT);
   */
 
   LOG(info) << "--- Neural Network for the TPC PID response correction ---";
 
-  mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "pid-neural-network");
-  if (enableOptimization) {
-    sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-  }
-
-  mSession.reset(new Ort::Experimental::Session{*mEnv, path, sessionOptions});
-
-  mInputNames = mSession->GetInputNames();
-  mInputShapes = mSession->GetInputShapes();
-  mOutputNames = mSession->GetOutputNames();
-  mOutputShapes = mSession->GetOutputShapes();
-
-  LOG(info) << "Input Nodes:";
-  for (size_t i = 0; i < mInputNames.size(); i++) {
-    LOG(info) << "\t" << mInputNames[i] << " : " << printShape(mInputShapes[i]);
-  }
-
-  LOG(info) << "Output Nodes:";
-  for (size_t i = 0; i < mOutputNames.size(); i++) {
-    LOG(info) << "\t" << mOutputNames[i] << " : " << printShape(mOutputShapes[i]);
-  }
+  initSession(path, enableOptimization, nThreadsIntraOp, nThreadsInterOp, executionProvider, true); // the file is downloaded again for each validity range
 
   valid_from = start;
   valid_until = end;
@@ -138,9 +143,7 @@ Network& Network::operator=(Network& inst)
     -- *this:   Network&        ; An instance with the private properties of the "inst" (input) instance;
   */
 
-  mEnv = inst.mEnv;
-  mSession = inst.mSession;
-  // sessionOptions = inst.sessionOptions; // Comment (Christian): Somehow the session options throw an error when trying to copy
+  mModel = inst.mModel;
   mInputNames = inst.mInputNames;
   mInputShapes = inst.mInputShapes;
   mOutputNames = inst.mOutputNames;
@@ -189,13 +192,14 @@ float* Network::evalNetwork(std::vector<Ort::Value> input)
   try {
     LOG(debug) << "Shape of input (tensor): " << printShape(input[0].GetTensorTypeAndShapeInfo().GetShape());
 
-    auto outputTensors = mSession->Run(mInputNames, input, mOutputNames);
-    float* output_values = outputTensors[0].GetTensorMutableData<float>();
+    auto outputTensors = mModel->run(input);
     LOG(debug) << "Shape of output (tensor): " << printShape(outputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
 
-    // std::vector<float> output_vals(std::begin(output_values), std::end(output_values));
+    // The output tensor is released when going out of scope: keep a copy
+    const float* output_values = outputTensors[0].GetTensorData<float>();
+    mOutputValues.assign(output_values, output_values + outputTensors[0].GetTensorTypeAndShapeInfo().GetElementCount());
 
-    return output_values;
+    return mOutputValues.data();
 
   } catch (const Ort::Exception& exception) {
     LOG(error) << "Error running model inference: " << exception.what();
@@ -225,11 +229,14 @@ float* Network::evalNetwork(std::vector<float> input)
   try {
 
     LOG(debug) << "Shape of input (vector): " << printShape(input_shape);
-    auto outputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
+    auto outputTensors = mModel->run(inputTensors);
     LOG(debug) << "Shape of output (tensor): " << printShape(outputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
-    float* output_values = outputTensors[0].GetTensorMutableData<float>();
 
-    return output_values;
+    // The output tensor is released when going out of scope: keep a copy
+    const float* output_values = outputTensors[0].GetTensorData<float>();
+    mOutputValues.assign(output_values, output_values + outputTensors[0].GetTensorTypeAndShapeInfo().GetElementCount());
+
+    return mOutputValues.data();
 
   } catch (const Ort::Exception& exception) {
 
@@ -240,4 +247,41 @@ float* Network::evalNetwork(std::vector<float> input)
 
 } // function Network::evalNetwork(std::vector<float>)
 
+bool Network::evalNetwork(const std::vector<float>& input, float* output)
+{
+
+  /*
+ Function: Evaluating the network for a batch of inputs in a single run, writing the result in place
+ - Input:
+   -- input:         std::vector<float>    ; The inputs of n = input.size()/input_nodes entries, one row per entry and hypothesis;
+   -- output:        float*                ; Buffer of at least n * output_nodes floats receiving the network output;
+ - Output:
+   -- success:       bool                  ; False if the evaluation failed;
+ */
+
+  const int64_t size = input.size();
+  const int64_t nEntries = size / mInputShapes[0][1];
+  std::vector<int64_t> input_shape{nEntries, mInputShapes[0][1]};
+  std::vector<int64_t> output_shape{nEntries, mOutputShapes[0][1]};
+  std::vector<Ort::Value> inputTensors;
+  std::vector<Ort::Value> outputTensors;
+  // Non-owning views: no copy of the input and the output is written directly into the caller's buffer
+  inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(const_cast<float*>(input.data()), size, input_shape));
+  outputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(output, nEntries * mOutputShapes[0][1], output_shape));
+
+  try {
+
+    LOG(debug) << "Shape of input (batch): " << printShape(input_shape);
+    mModel->run(inputTensors, outputTensors);
+    return true;
+
+  } catch (const Ort::Exception& exception) {
+
+    LOG(error) << "Error running model inference: " << exception.what();
+
+    return false;
+  }
+
+} // function Network::evalNetwork(const std::vector<float>&, float*)
+
 } // namespace o2::pid::tpc
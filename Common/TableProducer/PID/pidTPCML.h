@@ -28,16 +28,28 @@
 #include <array>
 #include <string>
 
+namespace o2::analysis
+{
+class OnnxModel;
+} // namespace o2::analysis
+
 namespace o2::pid::tpc
 {
 class Network
 {
 
  public:
+  // ONNX runtime execution providers which can be requested for the session
+  enum ExecutionProvider {
+    kCPU = 0,
+    kCUDA,
+    kTensorRT
+  };
+
   // Constructor, destructor and copy-constructor
   Network() = default;
-  Network(std::string, bool);
-  Network(std::string, unsigned long, unsigned long, bool); // initialization with timestamps
+  Network(std::string, bool, int nThreadsIntraOp = 0, int nThreadsInterOp = 0, int executionProvider = ExecutionProvider::kCPU);
+  Network(std::string, unsigned long, unsigned long, bool, int nThreadsIntraOp = 0, int nThreadsInterOp = 0, int executionProvider = ExecutionProvider::kCPU); // initialization with timestamps
   ~Network() = default;
 
   // Operators
@@ -47,6 +59,7 @@ class Network
   std::vector<Ort::Value> createTensor(std::array<float, 6>) const; // create a std::vector<Ort::Value> (= ONNX tensor) for model input
   float* evalNetwork(std::vector<Ort::Value>);                      // evaluate the network on a std::vector<Ort::Value> (= ONNX tensor)
   float* evalNetwork(std::vector<float>);                           // evaluate the network on a std::vector<float>
+  bool evalNetwork(const std::vector<float>&, float*);              // evaluate the network on a batch of entries, writing the output in place
 
   // Getters & Setters
   int getInputDimensions() const { return mInputShapes[0][1]; }
@@ -61,10 +74,8 @@ class Network
   unsigned long valid_from = 0;
   unsigned long valid_until = 0;
 
-  // Environment variables for the ONNX runtime
-  std::shared_ptr<Ort::Env> mEnv = nullptr;
-  std::shared_ptr<Ort::Experimental::Session> mSession = nullptr;
-  Ort::SessionOptions sessionOptions;
+  // Model and session, shared through the process-wide ONNX session registry
+  std::shared_ptr<o2::analysis::OnnxModel> mModel = nullptr;
 
   // Input & Output specifications of the loaded network
   std::vector<std::string> mInputNames;
@@ -72,11 +83,17 @@ class Network
   std::vector<std::string> mOutputNames;
   std::vector<std::vector<int64_t>> mOutputShapes;
 
+  // Output of the last evaluation returned as float*
+  std::vector<float> mOutputValues;
+
+  // Internal function for getting the session from the registry
+  void initSession(const std::string& path, bool enableOptimization, int nThreadsIntraOp, int nThreadsInterOp, int executionProvider, bool reload);
+
   // Internal function for printing the shape of tensors: See https://github.com/saganatt/PID_ML_in_O2 or O2Physics/Tools/PIDML/simpleApplyPidOnnxModel.cxx
   std::string printShape(const std::vector<int64_t>& v);
 
   // Class version
-  ClassDefNV(Network, 3);
+  ClassDefNV(Network, 4);
 
 }; // class Network
 
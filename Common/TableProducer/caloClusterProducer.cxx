@@ -29,6 +29,11 @@
 #include "PHOSBase/Geometry.h"
 #include "PHOSReconstruction/Clusterer.h"
 
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 using namespace o2::framework;
 using namespace o2;
 
@@ -37,24 +42,84 @@ struct caloClusterProducerTask {
   Configurable<std::string> calorimeter{"caloType", "BOTH", "PHOS, EMCAL, BOTH"};
   Configurable<bool> isMC{"isMC", 0, "0 - data, 1 - MC"};
   Configurable<bool> useCoreE{"coreE", 0, "0 - full energy, 1 - core energy"};
+  Configurable<int> nThreads{"nThreads", 1, "Number of threads clusterizing the PHOS BCs of a data frame"};
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
+  // Clusterizer with its input and output containers, one per thread
+  // The containers are kept from one data frame to the next, so that their memory is reused
+  struct PHOSClusterizerSlot {
+    std::unique_ptr<o2::phos::Clusterer> clusterizer;
+    std::vector<o2::phos::TriggerRecord> cellTRs;
+    std::vector<o2::phos::CluElement> cluElements;
+    std::vector<o2::phos::Cluster> clusters;
+    std::vector<o2::phos::TriggerRecord> clusterTrigRecs;
+    o2::dataformats::MCTruthContainer<o2::phos::MCLabel> cellTruth;
+    o2::dataformats::MCTruthContainer<o2::phos::MCLabel> clusterTruth;
+  };
+  // minimal number of BCs of a thread, below which running the clusterization in parallel does not pay off
+  static constexpr std::size_t kNBCsPerThreadMin = 50;
+
   std::unique_ptr<o2::phos::Geometry> geomPHOS;
-  std::unique_ptr<o2::phos::Clusterer> clusterizerPHOS;
+  std::vector<PHOSClusterizerSlot> phosSlots;
   std::vector<o2::phos::Cell> phosCells;
   std::vector<o2::phos::TriggerRecord> phosCellTRs;
-  std::vector<o2::phos::CluElement> outputCluElements;
-  std::vector<o2::phos::Cluster> outputPHOSClusters;
-  std::vector<o2::phos::TriggerRecord> outputPHOSClusterTrigRecs;
+  std::unordered_map<int64_t, int> bcMap;
+  int mRunNumber = -1;
 
   void init(o2::framework::InitContext&)
   {
     ccdb->setURL(o2::base::NameConf::getCCDBServer());
+    ccdb->setCaching(true);
     if (calorimeter->compare("PHOS") == 0 || calorimeter->compare("BOTH") == 0) {
       geomPHOS = std::make_unique<o2::phos::Geometry>("PHOS");
-      clusterizerPHOS = std::make_unique<o2::phos::Clusterer>();
+      phosSlots.resize(std::max(1, nThreads.value));
+      for (auto& slot : phosSlots) {
+        slot.clusterizer = std::make_unique<o2::phos::Clusterer>();
+      }
+    }
+  }
+
+  // Sets the bad map and calibration of the clusterizers, once per run
+  void updatePHOSCalibration(int runNumber)
+  {
+    if (runNumber == mRunNumber) {
+      return;
+    }
+    o2::phos::BadChannelsMap* badMap = ccdb->get<o2::phos::BadChannelsMap>("PHS/Calib/BadMap");
+    o2::phos::CalibParams* calibParams = ccdb->get<o2::phos::CalibParams>("PHS/Calib/CalibParams");
+    if (!badMap) {
+      LOG(fatal) << "Can not get PHOS Bad Map";
+    }
+    if (!calibParams) {
+      LOG(fatal) << "Can not get PHOS calibration";
+    }
+    for (auto& slot : phosSlots) {
+      slot.clusterizer->setBadMap(badMap);
+      slot.clusterizer->setCalibration(calibParams);
     }
+    mRunNumber = runNumber;
+  }
+
+  // Clusterizes the cell trigger records [first, last) of phosCellTRs with the clusterizer of slot
+  void clusterizePHOS(PHOSClusterizerSlot& slot, std::size_t first, std::size_t last)
+  {
+    slot.cellTRs.assign(phosCellTRs.begin() + first, phosCellTRs.begin() + last);
+    slot.cluElements.clear();
+    slot.clusters.clear();
+    slot.clusterTrigRecs.clear();
+    slot.cellTruth.clear();
+    slot.clusterTruth.clear();
+    // TODO process MC info
+    slot.clusterizer->processCells(phosCells, slot.cellTRs, isMC ? &slot.cellTruth : nullptr,
+                                   slot.clusters, slot.cluElements, slot.clusterTrigRecs, slot.clusterTruth);
+  }
+
+  // Index of the collision of a BC, 0 for the BCs without collision as before
+  int collisionOfBC(int64_t globalBC) const
+  {
+    auto found = bcMap.find(globalBC);
+    return found != bcMap.end() ? found->second : 0;
   }
 
   void process(o2::aod::BCs const& bcs,
@@ -64,7 +129,8 @@ struct caloClusterProducerTask {
   {
     // Make map between collision and BC tables
     //  map: (bcId_long,collision index)
-    std::map<int64_t, int> bcMap;
+    bcMap.clear();
+    bcMap.reserve(colls.size());
     int collId = 0;
     // TODO! handle several collisions assigned to same BC
     for (auto cl : colls) {
@@ -78,101 +144,95 @@ struct caloClusterProducerTask {
       // clusterize
       // Fill output table
 
-      // calibration may be updated by CCDB fetcher
-      o2::phos::BadChannelsMap* badMap = ccdb->get<o2::phos::BadChannelsMap>("PHS/Calib/BadMap");
-      o2::phos::CalibParams* calibParams = ccdb->get<o2::phos::CalibParams>("PHS/Calib/CalibParams");
-      if (badMap) {
-        clusterizerPHOS->setBadMap(badMap);
-      } else {
-        LOG(fatal) << "Can not get PHOS Bad Map";
-      }
-      if (calibParams) {
-        clusterizerPHOS->setCalibration(calibParams);
-      } else {
-        LOG(fatal) << "Can not get PHOS calibration";
+      if (bcs.size() > 0) {
+        updatePHOSCalibration(bcs.begin().runNumber());
       }
 
       phosCells.clear();
       phosCells.reserve(cells.size());
       phosCellTRs.clear();
       phosCellTRs.reserve(bcs.size());
-      outputCluElements.clear();
-      outputPHOSClusters.clear();
-      outputPHOSClusterTrigRecs.clear();
 
       o2::InteractionRecord ir;
       for (auto& c : cells) {
         if (c.caloType() != 0) // PHOS
           continue;
+        const auto globalBC = c.bc().globalBC();
         if (phosCellTRs.size() == 0) { // first cell, first TrigRec
-          ir.setFromLong(c.bc().globalBC());
+          ir.setFromLong(globalBC);
           phosCellTRs.emplace_back(ir, 0, 0); // BC,first cell, ncells
         }
-        if (static_cast<long unsigned int>(phosCellTRs.back().getBCData().toLong()) != c.bc().globalBC()) { // switch to new BC
+        if (static_cast<long unsigned int>(phosCellTRs.back().getBCData().toLong()) != globalBC) { // switch to new BC
           // switch to another BC: set size and create next TriRec
           phosCellTRs.back().setNumberOfObjects(phosCells.size() - phosCellTRs.back().getFirstEntry());
           // Next event/trig rec.
-          ir.setFromLong(c.bc().globalBC());
+          ir.setFromLong(globalBC);
           phosCellTRs.emplace_back(ir, phosCells.size(), 0);
         }
         phosCells.emplace_back(c.cellNumber(), c.amplitude(), c.time(),
                                static_cast<o2::phos::ChannelType_t>(c.cellType()));
-        // TODO process MC info
       }
       // Set number of cells in last TrigRec
       if (phosCellTRs.size() > 0) {
         phosCellTRs.back().setNumberOfObjects(phosCells.size() - phosCellTRs.back().getFirstEntry());
       }
 
-      // clusterize
-      if (isMC) {
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> cellTruth;
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> outputTruthCont;
-        clusterizerPHOS->processCells(phosCells, phosCellTRs, &cellTruth,
-                                      outputPHOSClusters, outputCluElements, outputPHOSClusterTrigRecs, outputTruthCont);
-      } else {
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> dummyMC;
-        clusterizerPHOS->processCells(phosCells, phosCellTRs, nullptr,
-                                      outputPHOSClusters, outputCluElements, outputPHOSClusterTrigRecs, dummyMC);
+      // clusterize, the BCs are split in contiguous ranges given to the clusterizers of the threads
+      const std::size_t nBCs = phosCellTRs.size();
+      const std::size_t nUsedSlots = std::clamp<std::size_t>(nBCs / kNBCsPerThreadMin, 1, phosSlots.size());
+      const std::size_t nBCsPerSlot = (nBCs + nUsedSlots - 1) / nUsedSlots;
+      std::vector<std::thread> threads;
+      for (std::size_t iSlot = 1; iSlot < nUsedSlots; iSlot++) {
+        threads.emplace_back([this, iSlot, nBCs, nBCsPerSlot]() {
+          clusterizePHOS(phosSlots[iSlot], std::min(nBCs, iSlot * nBCsPerSlot), std::min(nBCs, (iSlot + 1) * nBCsPerSlot));
+        });
+      }
+      clusterizePHOS(phosSlots[0], 0, std::min(nBCs, nBCsPerSlot));
+      for (auto& thread : threads) {
+        thread.join();
       }
 
-      // Fill output
-      for (auto& cluTR : outputPHOSClusterTrigRecs) {
-        int firstClusterInEvent = cluTR.getFirstEntry();
-        int lastClusterInEvent = firstClusterInEvent + cluTR.getNumberOfObjects();
-        // find collision corresponding to current BC
-        auto clvtx = colls.begin() + (bcMap[cluTR.getBCData().toLong()]);
-
-        // Extract primary vertex
-        TVector3 vtx = {clvtx.posX(), clvtx.posY(), clvtx.posZ()};
-
-        for (int i = firstClusterInEvent; i < lastClusterInEvent; i++) {
-          o2::phos::Cluster& clu = outputPHOSClusters[i];
-          float e = (useCoreE) ? clu.getCoreEnergy() : clu.getEnergy();
-          if (e == 0) {
-            continue;
-          }
-          float x, z;
-          clu.getLocalPosition(x, z);
-          int mod = clu.module();
-          TVector3 globaPos;
-          geomPHOS->local2Global(mod, x, z, globaPos);
-          // TODO: correction for depth and non-perpendicular insideence
-          TVector3 mom = globaPos - vtx;
-          if (mom.Mag() == 0) { // should not happpen
-            continue;
+      // Fill output, in the order of the BCs
+      for (std::size_t iSlot = 0; iSlot < nUsedSlots; iSlot++) {
+        auto& slot = phosSlots[iSlot];
+        for (auto& cluTR : slot.clusterTrigRecs) {
+          int firstClusterInEvent = cluTR.getFirstEntry();
+          int lastClusterInEvent = firstClusterInEvent + cluTR.getNumberOfObjects();
+          // find collision corresponding to current BC
+          const int collisionId = collisionOfBC(cluTR.getBCData().toLong());
+          auto clvtx = colls.begin() + collisionId;
+
+          // Extract primary vertex
+          TVector3 vtx = {clvtx.posX(), clvtx.posY(), clvtx.posZ()};
+
+          for (int i = firstClusterInEvent; i < lastClusterInEvent; i++) {
+            o2::phos::Cluster& clu = slot.clusters[i];
+            float e = (useCoreE) ? clu.getCoreEnergy() : clu.getEnergy();
+            if (e == 0) {
+              continue;
+            }
+            float x, z;
+            clu.getLocalPosition(x, z);
+            int mod = clu.module();
+            TVector3 globaPos;
+            geomPHOS->local2Global(mod, x, z, globaPos);
+            // TODO: correction for depth and non-perpendicular insideence
+            TVector3 mom = globaPos - vtx;
+            if (mom.Mag() == 0) { // should not happpen
+              continue;
+            }
+            mom.SetMag(e);
+            // Track/CPV match will be done in independent task
+            float trackdist = 999.;
+            int trackindex = -1;
+            float lambdaShort = 0., lambdaLong = 0.;
+            clu.getElipsAxis(lambdaShort, lambdaLong);
+
+            clusters(collisionId, kPHOS, mom.X(), mom.Y(), mom.Z(), e,
+                     mod, clu.getMultiplicity(), globaPos.X(), globaPos.Y(), globaPos.Z(),
+                     clu.getTime(), clu.getNExMax(), lambdaShort, lambdaLong, trackdist, trackindex,
+                     clu.firedTrigger(), clu.getDistanceToBadChannel());
           }
-          mom.SetMag(e);
-          // Track/CPV match will be done in independent task
-          float trackdist = 999.;
-          int trackindex = -1;
-          float lambdaShort = 0., lambdaLong = 0.;
-          clu.getElipsAxis(lambdaShort, lambdaLong);
-
-          clusters(bcMap[cluTR.getBCData().toLong()], kPHOS, mom.X(), mom.Y(), mom.Z(), e,
-                   mod, clu.getMultiplicity(), globaPos.X(), globaPos.Y(), globaPos.Z(),
-                   clu.getTime(), clu.getNExMax(), lambdaShort, lambdaLong, trackdist, trackindex,
-                   clu.firedTrigger(), clu.getDistanceToBadChannel());
         }
       }
     } // end isPHOS
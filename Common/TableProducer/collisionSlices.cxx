@@ -0,0 +1,77 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   collisionSlices.cxx
+/// \brief  Task producing the ranges of the tracks, forward tracks, MFT tracks and V0s of each collision,
+///         with one scan of the collision index of each table per data frame, shared by all the tasks of the train
+///
+
+#include <vector>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Common/DataModel/CollisionSlices.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct CollisionSlicesTask {
+  Produces<aod::CollisionSlices> collisionSlices;
+
+  // first and last row of each collision, -1 if the collision has no row
+  std::vector<int> mFirst[4];
+  std::vector<int> mLast[4];
+
+  template <typename TTable>
+  void findRanges(TTable const& table, int iTable, int nCollisions)
+  {
+    auto& first = mFirst[iTable];
+    auto& last = mLast[iTable];
+    first.assign(nCollisions, -1);
+    last.assign(nCollisions, -1);
+    int row = 0;
+    for (auto& entry : table) {
+      const int collisionId = entry.collisionId();
+      if (collisionId >= 0 && collisionId < nCollisions) {
+        if (first[collisionId] < 0) {
+          first[collisionId] = row;
+        }
+        last[collisionId] = row;
+      }
+      row++;
+    }
+  }
+
+  void process(aod::Collisions const& collisions, aod::Tracks const& tracks, aod::FwdTracks const& fwdtracks, aod::MFTTracks const& mfttracks, aod::V0s const& v0s)
+  {
+    const int nCollisions = collisions.size();
+    findRanges(tracks, 0, nCollisions);
+    findRanges(fwdtracks, 1, nCollisions);
+    findRanges(mfttracks, 2, nCollisions);
+    findRanges(v0s, 3, nCollisions);
+
+    collisionSlices.reserve(nCollisions);
+    for (int i = 0; i < nCollisions; i++) {
+      int trackSlice[2] = {mFirst[0][i], mLast[0][i]};
+      int fwdTrackSlice[2] = {mFirst[1][i], mLast[1][i]};
+      int mftTrackSlice[2] = {mFirst[2][i], mLast[2][i]};
+      int v0Slice[2] = {mFirst[3][i], mLast[3][i]};
+      collisionSlices(trackSlice, fwdTrackSlice, mftTrackSlice, v0Slice);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<CollisionSlicesTask>(cfgc, TaskName{"collision-slices"})};
+}
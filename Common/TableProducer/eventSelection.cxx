@@ -24,6 +24,9 @@ using namespace o2::framework;
 #include "Framework/HistogramRegistry.h"
 #include "DataFormatsFT0/Digit.h"
 #include "TH1F.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
 using namespace evsel;
 
 using BCsWithRun2InfosTimestampsAndMatches = soa::Join<aod::BCs, aod::Run2BCInfos, aod::Timestamps, aod::Run2MatchedToBCSparse>;
@@ -35,6 +38,19 @@ struct BcSelectionTask {
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
 
+  // Run 3: global BC and FIT timing of each BC row, for the beam-gas checks in the preceding BCs
+  std::vector<uint64_t> globalBCs;
+  std::vector<float> timesV0A;
+  std::vector<float> timesT0A;
+  std::vector<float> timesT0C;
+  std::vector<float> timesFDA;
+  std::vector<float> timesFDC;
+
+  // Run 2: alias masks of the last TriggerAliases object from CCDB, rebuilt when the object or the run changes
+  TriggerAliasMasks aliasMasks;
+  TriggerAliases* lastAliases = nullptr;
+  int lastAliasRun = -1;
+
   void init(InitContext&)
   {
     // ccdb->setURL("http://ccdb-test.cern.ch:8080");
@@ -57,15 +73,16 @@ struct BcSelectionTask {
     for (auto& bc : bcs) {
       EventSelectionParams* par = ccdb->getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", bc.timestamp());
       TriggerAliases* aliases = ccdb->getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", bc.timestamp());
+      if (aliases != lastAliases || bc.runNumber() != lastAliasRun) {
+        aliasMasks.Build(*aliases);
+        lastAliases = aliases;
+        lastAliasRun = bc.runNumber();
+      }
       // fill fired aliases
       int32_t alias[kNaliases] = {0};
-      uint64_t triggerMask = bc.triggerMask();
-      for (auto& al : aliases->GetAliasToTriggerMaskMap()) {
-        alias[al.first] |= (triggerMask & al.second) > 0;
-      }
-      uint64_t triggerMaskNext50 = bc.triggerMaskNext50();
-      for (auto& al : aliases->GetAliasToTriggerMaskNext50Map()) {
-        alias[al.first] |= (triggerMaskNext50 & al.second) > 0;
+      uint32_t firedAliases = aliasMasks.GetFiredAliases(bc.triggerMask(), bc.triggerMaskNext50());
+      for (int i = 0; i < kNaliases; i++) {
+        alias[i] = (firedAliases >> i) & 1;
       }
       alias[kALL] = 1;
 
@@ -188,8 +205,25 @@ struct BcSelectionTask {
                    aod::FT0s const&,
                    aod::FDDs const&)
   {
+    globalBCs.resize(bcs.size());
+    timesV0A.resize(bcs.size());
+    timesT0A.resize(bcs.size());
+    timesT0C.resize(bcs.size());
+    timesFDA.resize(bcs.size());
+    timesFDC.resize(bcs.size());
+    for (auto& bc : bcs) {
+      auto iBC = bc.globalIndex();
+      globalBCs[iBC] = bc.globalBC();
+      timesV0A[iBC] = bc.has_fv0a() ? bc.fv0a().time() : -999.f;
+      timesT0A[iBC] = bc.has_ft0() ? bc.ft0().timeA() : -999.f;
+      timesT0C[iBC] = bc.has_ft0() ? bc.ft0().timeC() : -999.f;
+      timesFDA[iBC] = bc.has_fdd() ? bc.fdd().timeA() : -999.f;
+      timesFDC[iBC] = bc.has_fdd() ? bc.fdd().timeC() : -999.f;
+    }
+
     for (auto bc : bcs) {
       EventSelectionParams* par = ccdb->getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", bc.timestamp());
+      const int64_t iBC = bc.globalIndex();
 
       // TODO: fill fired aliases for run3
       int32_t alias[kNaliases] = {0};
@@ -198,39 +232,34 @@ struct BcSelectionTask {
       // get timing info from ZDC, FV0, FT0 and FDD
       float timeZNA = bc.has_zdc() ? bc.zdc().timeZNA() : -999.f;
       float timeZNC = bc.has_zdc() ? bc.zdc().timeZNC() : -999.f;
-      float timeV0A = bc.has_fv0a() ? bc.fv0a().time() : -999.f;
-      float timeT0A = bc.has_ft0() ? bc.ft0().timeA() : -999.f;
-      float timeT0C = bc.has_ft0() ? bc.ft0().timeC() : -999.f;
-      float timeFDA = bc.has_fdd() ? bc.fdd().timeA() : -999.f;
-      float timeFDC = bc.has_fdd() ? bc.fdd().timeC() : -999.f;
+      float timeV0A = timesV0A[iBC];
+      float timeT0A = timesT0A[iBC];
+      float timeT0C = timesT0C[iBC];
+      float timeFDA = timesFDA[iBC];
+      float timeFDC = timesFDC[iBC];
       float timeV0ABG = -999.f;
       float timeT0ABG = -999.f;
       float timeT0CBG = -999.f;
       float timeFDABG = -999.f;
       float timeFDCBG = -999.f;
 
-      uint64_t globalBC = bc.globalBC();
-      // move to previous bcs to check beam-gas in FT0, FV0 and FDD
-      int64_t backwardMoveCount = 0;
+      uint64_t globalBC = globalBCs[iBC];
+      // look at the previous bcs (sorted by global BC) to check beam-gas in FT0, FV0 and FDD
       int64_t deltaBC = 6; // up to 6 bcs back
-      while (bc.globalBC() + deltaBC >= globalBC) {
-        if (bc == bcs.begin()) {
-          break;
+      for (int64_t jBC = iBC - 1; jBC >= 0; --jBC) {
+        if (globalBCs[jBC] + 1 == globalBC) {
+          timeV0ABG = timesV0A[jBC];
+          timeT0ABG = timesT0A[jBC];
+          timeT0CBG = timesT0C[jBC];
         }
-        --bc;
-        backwardMoveCount++;
-        if (bc.globalBC() + 1 == globalBC) {
-          timeV0ABG = bc.has_fv0a() ? bc.fv0a().time() : -999.f;
-          timeT0ABG = bc.has_ft0() ? bc.ft0().timeA() : -999.f;
-          timeT0CBG = bc.has_ft0() ? bc.ft0().timeC() : -999.f;
+        if (globalBCs[jBC] + 5 == globalBC) {
+          timeFDABG = timesFDA[jBC];
+          timeFDCBG = timesFDC[jBC];
         }
-        if (bc.globalBC() + 5 == globalBC) {
-          timeFDABG = bc.has_fdd() ? bc.fdd().timeA() : -999.f;
-          timeFDCBG = bc.has_fdd() ? bc.fdd().timeC() : -999.f;
+        if (globalBCs[jBC] + deltaBC < globalBC) {
+          break;
         }
       }
-      // move back to initial position
-      bc.moveByIndex(backwardMoveCount);
 
       // applying timing selections
       bool bbV0A = timeV0A > par->fV0ABBlower && timeV0A < par->fV0ABBupper;
@@ -308,6 +337,9 @@ struct EventSelectionTask {
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
 
+  // Run 3 bulk mode: global BC and row of the BCs with a matched FT0, sorted by global BC
+  std::vector<std::pair<uint64_t, int64_t>> ft0BCs;
+
   void init(InitContext&)
   {
     // ccdb->setURL("http://ccdb-test.cern.ch:8080");
@@ -315,6 +347,10 @@ struct EventSelectionTask {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
 
+    if (doprocessRun3 && doprocessRun3Bulk) {
+      LOGF(fatal, "Enable only one of processRun3 and processRun3Bulk");
+    }
+
     histos.add("hColCounterAll", "", kTH1F, {{1, 0., 1.}});
     histos.add("hColCounterAcc", "", kTH1F, {{1, 0., 1.}});
   }
@@ -448,6 +484,59 @@ struct EventSelectionTask {
       }                                                       // else keep backward bc
     }
 
+    fillRun3(bc);
+  }
+  PROCESS_SWITCH(EventSelectionTask, processRun3, "Process Run3 event selection", false);
+
+  void processRun3Bulk(aod::Collisions const& cols, BCsWithBcSels const& bcs)
+  {
+    // index of the BCs with FT0 in the data frame, to match each collision with a binary search instead of a BC by BC scan
+    ft0BCs.clear();
+    for (auto& bc : bcs) {
+      if (bc.has_foundFT0()) {
+        ft0BCs.emplace_back(bc.globalBC(), bc.globalIndex());
+      }
+    }
+
+    for (auto& col : cols) {
+      auto bc = col.bc_as<BCsWithBcSels>();
+      uint64_t apprBC = bc.globalBC();
+      int64_t meanBC = apprBC - std::lround(col.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+      int64_t deltaBC = std::ceil(col.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * 4);
+      // use custom delta
+      if (customDeltaBC > 0) {
+        deltaBC = customDeltaBC;
+      }
+
+      int64_t iBC = bc.globalIndex();
+      if (!bc.has_foundFT0()) { // search in +/-4 sigma around meanBC, same choices as the scan of processRun3
+        // first BC with FT0 after the nominal bc and last one before
+        auto forward = std::lower_bound(ft0BCs.begin(), ft0BCs.end(), std::make_pair(apprBC, int64_t(-1)));
+        int64_t forwardBcDist = deltaBC + 1;
+        if (forward != ft0BCs.end() && int64_t(forward->first) <= meanBC + deltaBC) {
+          forwardBcDist = forward->first - meanBC;
+        }
+        int64_t backwardBcDist = deltaBC + 1;
+        if (forward != ft0BCs.begin() && int64_t(std::prev(forward)->first) >= meanBC - deltaBC) {
+          backwardBcDist = meanBC - std::prev(forward)->first;
+        }
+        if (forwardBcDist > deltaBC && backwardBcDist > deltaBC) {
+          // keep nominal bc if neighbouring ft0 is not found
+        } else if (forwardBcDist < backwardBcDist) {
+          iBC = forward->second;
+        } else {
+          iBC = std::prev(forward)->second;
+        }
+      }
+
+      fillRun3(bcs.iteratorAt(iBC));
+    }
+  }
+  PROCESS_SWITCH(EventSelectionTask, processRun3Bulk, "Process Run3 event selection for all the collisions of a data frame at once", false);
+
+  template <typename TBC>
+  void fillRun3(TBC const& bc)
+  {
     int32_t foundBC = bc.globalIndex();
     int32_t foundFT0 = bc.foundFT0Id();
     int32_t foundFV0 = bc.foundFV0Id();
@@ -510,7 +599,6 @@ struct EventSelectionTask {
           multRingV0A, multRingV0C, spdClusters, nTkl, sel7, sel8,
           foundBC, foundFT0, foundFV0, foundFDD);
   }
-  PROCESS_SWITCH(EventSelectionTask, processRun3, "Process Run3 event selection", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
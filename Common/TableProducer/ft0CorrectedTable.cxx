@@ -21,37 +21,76 @@ using namespace o2::framework;
 #include "CommonConstants/PhysicsConstants.h"
 #include "Common/DataModel/FT0Corrected.h"
 #include "DataFormatsFT0/Digit.h"
+
+#include "Common/Core/CpuDispatch.h"
 #include <bitset>
+#include <vector>
 
 using namespace o2::aod;
+
+namespace
+{
+// vertex-corrected times of n collisions, 1e10 for the sides without trigger or without FT0
+inline void correctTimesImpl(const float* posZ, const float* timeA, const float* timeC, const uint8_t* fired, float* t0A, float* t0C, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    const float vertexCorr = posZ[i] / o2::constants::physics::LightSpeedCm2NS;
+    t0A[i] = (fired[i] & 1) ? timeA[i] + vertexCorr : 1e10f;
+    t0C[i] = (fired[i] & 2) ? timeC[i] - vertexCorr : 1e10f;
+  }
+}
+O2_SIMD_TARGET_AVX2 O2_SIMD_FLATTEN void correctTimesAvx2(const float* posZ, const float* timeA, const float* timeC, const uint8_t* fired, float* t0A, float* t0C, std::size_t n) { correctTimesImpl(posZ, timeA, timeC, fired, t0A, t0C, n); }
+O2_SIMD_TARGET_AVX512 O2_SIMD_FLATTEN void correctTimesAvx512(const float* posZ, const float* timeA, const float* timeC, const uint8_t* fired, float* t0A, float* t0C, std::size_t n) { correctTimesImpl(posZ, timeA, timeC, fired, t0A, t0C, n); }
+const o2::analysis::simd::Dispatched<void (*)(const float*, const float*, const float*, const uint8_t*, float*, float*, std::size_t)> correctTimes{correctTimesImpl, correctTimesAvx2, correctTimesAvx512};
+} // namespace
+
 struct FT0CorrectedTable {
   Produces<o2::aod::FT0sCorrected> table;
   using BCsWithMatchings = soa::Join<aod::BCs, aod::Run3MatchedToBCSparse>;
   using CollisionEvSel = soa::Join<aod::Collisions, aod::EvSels>::iterator;
 
+  // columns gathered for all the collisions of the time frame
+  std::vector<float> mPosZ;
+  std::vector<float> mTimeA;
+  std::vector<float> mTimeC;
+  std::vector<uint8_t> mFired; // bit 0: OrA, bit 1: OrC
+  std::vector<float> mT0A;
+  std::vector<float> mT0C;
+
   void process(BCsWithMatchings const& bcs, soa::Join<aod::Collisions, aod::EvSels> const& collisions, aod::FT0s const& ft0s)
   {
+    const std::size_t n = collisions.size();
+    mPosZ.resize(n);
+    mTimeA.resize(n);
+    mTimeC.resize(n);
+    mFired.resize(n);
+    mT0A.resize(n);
+    mT0C.resize(n);
+
+    // gather the FT0 times through the index of the matched FT0 entry
+    std::size_t i = 0;
     for (auto& collision : collisions) {
-      float vertexPV = collision.posZ();
-      float vertex_corr = vertexPV / o2::constants::physics::LightSpeedCm2NS;
-      float t0A = 1e10;
-      float t0C = 1e10;
+      mPosZ[i] = collision.posZ();
+      mTimeA[i] = 0.f;
+      mTimeC[i] = 0.f;
+      mFired[i] = 0;
       if (collision.has_foundFT0()) {
-        auto ft0 = collision.foundFT0();
+        auto ft0 = ft0s.rawIteratorAt(collision.foundFT0Id());
         std::bitset<8> triggers = ft0.triggerMask();
-        bool ora = triggers[o2::ft0::Triggers::bitA];
-        bool orc = triggers[o2::ft0::Triggers::bitC];
-        LOGF(debug, "triggers OrA %i OrC %i ", ora, orc);
-        LOGF(debug, " T0A = %f, T0C %f, vertex_corr %f", ft0.timeA(), ft0.timeC(), vertex_corr);
-        if (ora) {
-          t0A = ft0.timeA() + vertex_corr;
-        }
-        if (orc) {
-          t0C = ft0.timeC() - vertex_corr;
-        }
+        mTimeA[i] = ft0.timeA();
+        mTimeC[i] = ft0.timeC();
+        mFired[i] = (triggers[o2::ft0::Triggers::bitA] ? 1 : 0) | (triggers[o2::ft0::Triggers::bitC] ? 2 : 0);
+        LOGF(debug, "triggers OrA %i OrC %i, T0A = %f, T0C %f", mFired[i] & 1, (mFired[i] >> 1) & 1, mTimeA[i], mTimeC[i]);
       }
-      LOGF(debug, " T0 collision time T0A = %f, T0C = %f", t0A, t0C);
-      table(t0A, t0C);
+      i++;
+    }
+
+    correctTimes(mPosZ.data(), mTimeA.data(), mTimeC.data(), mFired.data(), mT0A.data(), mT0C.data(), n);
+
+    table.reserve(n);
+    for (i = 0; i < n; i++) {
+      LOGF(debug, " T0 collision time T0A = %f, T0C = %f", mT0A[i], mT0C[i]);
+      table(mT0A[i], mT0C[i]);
     }
   }
 };
@@ -20,25 +20,31 @@ using namespace o2::framework;
 struct McConverter {
   Produces<aod::StoredMcParticles_001> mcParticles_001;
 
+  // mothers of the current particle, reused for all the particles to avoid one allocation per row
+  std::vector<int> mothers;
+
   void process(aod::StoredMcParticles_000 const& mcParticles_000)
   {
+    mcParticles_001.reserve(mcParticles_000.size());
+    mothers.reserve(2);
     for (auto& p : mcParticles_000) {
-
-      std::vector<int> mothers;
-      if (p.mother0Id() >= 0) {
-        mothers.push_back(p.mother0Id());
+      const int mother0Id = p.mother0Id();
+      const int mother1Id = p.mother1Id();
+      const int daughter0Id = p.daughter0Id();
+      const int daughter1Id = p.daughter1Id();
+
+      mothers.clear();
+      if (mother0Id >= 0) {
+        mothers.push_back(mother0Id);
       }
-      if (p.mother1Id() >= 0) {
-        mothers.push_back(p.mother1Id());
+      if (mother1Id >= 0) {
+        mothers.push_back(mother1Id);
       }
 
       int daughters[2] = {-1, -1};
-      if (p.daughter0Id() >= 0 && p.daughter1Id() >= 0) {
-        daughters[0] = p.daughter0Id();
-        daughters[1] = p.daughter1Id();
-      } else if (p.daughter0Id() >= 0) {
-        daughters[0] = p.daughter0Id();
-        daughters[1] = p.daughter0Id();
+      if (daughter0Id >= 0) {
+        daughters[0] = daughter0Id;
+        daughters[1] = daughter1Id >= 0 ? daughter1Id : daughter0Id;
       }
 
       mcParticles_001(p.mcCollisionId(), p.pdgCode(), p.statusCode(), p.flags(),
@@ -0,0 +1,74 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   mcPrimaries.cxx
+/// \brief  Task writing the McPrimaries table, the MC particles in acceptance that are physical primaries,
+///         with their kinematics, PDG code and charge, for generator-level studies
+///
+
+#include <unordered_map>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Common/DataModel/McPrimaries.h"
+#include "TDatabasePDG.h"
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::framework::expressions;
+
+struct McPrimariesTask {
+  Produces<aod::McPrimaries> mcPrimaries;
+  Service<TDatabasePDG> pdg;
+
+  Configurable<float> etaMax{"etaMax", 5.f, "Maximum absolute pseudorapidity of the particles"};
+  Configurable<float> ptMin{"ptMin", 0.f, "Minimum transverse momentum of the particles"};
+  Configurable<bool> physicalPrimaryOnly{"physicalPrimaryOnly", true, "Keep only the physical primaries"};
+  Configurable<bool> chargedOnly{"chargedOnly", false, "Keep only the particles with an absolute charge of at least |e|"};
+
+  std::unordered_map<int, int8_t> charges; ///< charge of the PDG codes already looked up, in units of |e|/3
+
+  Filter acceptance = (nabs(aod::mcparticle::eta) < etaMax) && (aod::mcparticle::pt >= ptMin) &&
+                      ifnode(physicalPrimaryOnly.node() == true,
+                             (aod::mcparticle::flags & (uint8_t)o2::aod::mcparticle::enums::PhysicalPrimary) == (uint8_t)o2::aod::mcparticle::enums::PhysicalPrimary,
+                             true);
+
+  int8_t getCharge(int pdgCode)
+  {
+    auto found = charges.find(pdgCode);
+    if (found != charges.end()) {
+      return found->second;
+    }
+    auto particle = pdg->GetParticle(pdgCode);
+    int8_t charge = particle != nullptr ? static_cast<int8_t>(particle->Charge()) : 0;
+    charges.emplace(pdgCode, charge);
+    return charge;
+  }
+
+  void process(soa::Filtered<aod::McParticles> const& particles)
+  {
+    mcPrimaries.reserve(particles.size());
+    for (auto& particle : particles) {
+      const int8_t charge = getCharge(particle.pdgCode());
+      if (chargedOnly && charge > -3 && charge < 3) {
+        continue;
+      }
+      mcPrimaries(particle.mcCollisionId(), particle.globalIndex(), particle.pt(), particle.eta(), particle.phi(), particle.pdgCode(), charge);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<McPrimariesTask>(cfgc, TaskName{"mc-primaries"})};
+}
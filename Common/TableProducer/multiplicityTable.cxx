@@ -25,7 +25,10 @@ void customize(std::vector<ConfigParamSpec>& workflowOptions)
 #include <CCDB/BasicCCDBManager.h>
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Multiplicity.h"
+#include "Common/Core/TableHelper.h"
 #include "iostream"
+#include <cmath>
+#include <vector>
 
 struct MultiplicityTableTaskIndexed {
   Produces<aod::Mults> mult;
@@ -40,10 +43,11 @@ struct MultiplicityTableTaskIndexed {
   Partition<soa::Join<aod::Tracks, aod::TracksExtra>> pvContribTracksEta1 = (nabs(aod::track::eta) < 1.0f) && ((aod::track::flags & (uint32_t)o2::aod::track::PVContributor) == (uint32_t)o2::aod::track::PVContributor);
 
   //Configurable
-  Configurable<int> doVertexZeq{"doVertexZeq", 1, "if 1: do vertex Z eq mult table"};
+  Configurable<int> doVertexZeq{"doVertexZeq", 1, "if 1: do vertex Z eq mult table, if -1: only if the MultZeqs table is required in the workflow, not filled otherwise"};
   Configurable<int> doDummyZeq{"doDummyZeq", 0, "if 1: do dummy Z vertex Eq (will make non-eq equal to eq)"};
 
   int mRunNumber;
+  bool fillMultZeqs = true;
   bool lCalibLoaded;
   TList* lCalibObjects;
   TProfile* hVtxZFV0A;
@@ -53,13 +57,30 @@ struct MultiplicityTableTaskIndexed {
   TProfile* hVtxZFDDC;
   TProfile* hVtxZNTracks;
 
+  // per data frame buffers of the bulk mode, indexed by detector row or by collision
+  std::vector<float> lFV0ASums;
+  std::vector<float> lFT0ASums;
+  std::vector<float> lFT0CSums;
+  std::vector<float> lFDDASums;
+  std::vector<float> lFDDCSums;
+  std::vector<int> lNTPC;
+  std::vector<int> lNContribs;
+  std::vector<int> lNContribsEta1;
+
   void init(InitContext& context)
   {
-    if (doprocessRun2 == false && doprocessRun3 == false) {
-      LOGF(fatal, "Neither processRun2 nor processRun3 enabled. Please choose one.");
+    int nEnabled = static_cast<int>(doprocessRun2) + static_cast<int>(doprocessRun3) + static_cast<int>(doprocessRun3Bulk);
+    if (nEnabled == 0) {
+      LOGF(fatal, "Neither processRun2, processRun3 nor processRun3Bulk enabled. Please choose one.");
+    }
+    if (nEnabled > 1) {
+      LOGF(fatal, "Cannot enable more than one of processRun2, processRun3 and processRun3Bulk at the same time. Please choose one.");
     }
-    if (doprocessRun2 == true && doprocessRun3 == true) {
-      LOGF(fatal, "Cannot enable processRun2 and processRun3 at the same time. Please choose one.");
+
+    if (doVertexZeq < 0) {
+      fillMultZeqs = isTableRequiredInWorkflow(context, "MultZeqs");
+      doVertexZeq.value = fillMultZeqs;
+      LOGF(info, "MultZeqs table %s", fillMultZeqs ? "required, vertex Z equalisation enabled" : "not required, not filled");
     }
 
     mRunNumber = 0;
@@ -78,6 +99,90 @@ struct MultiplicityTableTaskIndexed {
     ccdb->setFatalWhenNull(false); //don't fatal, please - exception is caught explicitly (as it should)
   }
 
+  /// Sums the channel amplitudes of a detector
+  /// The four independent partial sums let the compiler vectorize the reduction
+  template <typename T>
+  static float sumAmplitudes(T const& amplitudes)
+  {
+    float partial[4] = {0.f, 0.f, 0.f, 0.f};
+    const size_t n = amplitudes.size();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      partial[0] += amplitudes[i];
+      partial[1] += amplitudes[i + 1];
+      partial[2] += amplitudes[i + 2];
+      partial[3] += amplitudes[i + 3];
+    }
+    for (; i < n; ++i) {
+      partial[0] += amplitudes[i];
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+  }
+
+  /// Loads the vertex-Z equalisation profiles when the run changes
+  template <typename TBC>
+  void loadCalibration(TBC const& bc)
+  {
+    if (doVertexZeq < 1 || doDummyZeq > 0 || bc.runNumber() == mRunNumber) {
+      return;
+    }
+    mRunNumber = bc.runNumber(); //mark this run as at least tried
+    lCalibObjects = ccdb->getForTimeStamp<TList>("Centrality/Calibration", bc.timestamp());
+    if (lCalibObjects) {
+      hVtxZFV0A = (TProfile*)lCalibObjects->FindObject("hVtxZFV0A");
+      hVtxZFT0A = (TProfile*)lCalibObjects->FindObject("hVtxZFT0A");
+      hVtxZFT0C = (TProfile*)lCalibObjects->FindObject("hVtxZFT0C");
+      hVtxZFDDA = (TProfile*)lCalibObjects->FindObject("hVtxZFDDA");
+      hVtxZFDDC = (TProfile*)lCalibObjects->FindObject("hVtxZFDDC");
+      hVtxZNTracks = (TProfile*)lCalibObjects->FindObject("hVtxZNTracksPV");
+      lCalibLoaded = true;
+      //Capture error
+      if (!hVtxZFV0A || !hVtxZFT0A || !hVtxZFT0C || !hVtxZFDDA || !hVtxZFDDC || !hVtxZNTracks) {
+        LOGF(info, "Problem loading CCDB objects! Please check");
+        lCalibLoaded = false;
+      }
+    }
+  }
+
+  /// Fills the Run 3 multiplicity and vertex-Z equalised multiplicity tables of one collision
+  void fillRun3(float posZ, float multFV0A, float multFT0A, float multFT0C, float multFDDA, float multFDDC, int multTPC, int multNContribs, int multNContribsEta1)
+  {
+    float multFV0C = 0.f;
+    float multZNA = 0.f;
+    float multZNC = 0.f;
+    int multTracklets = 0;
+
+    float multZeqFV0A = 0.f;
+    float multZeqFT0A = 0.f;
+    float multZeqFT0C = 0.f;
+    float multZeqFDDA = 0.f;
+    float multZeqFDDC = 0.f;
+    float multZeqNContribs = 0.f;
+
+    if (fabs(posZ) < 15.0f && lCalibLoaded) {
+      multZeqFV0A = hVtxZFV0A->Interpolate(0.0) * multFV0A / hVtxZFV0A->Interpolate(posZ);
+      multZeqFT0A = hVtxZFT0A->Interpolate(0.0) * multFT0A / hVtxZFT0A->Interpolate(posZ);
+      multZeqFT0C = hVtxZFT0C->Interpolate(0.0) * multFT0C / hVtxZFT0C->Interpolate(posZ);
+      multZeqFDDA = hVtxZFDDA->Interpolate(0.0) * multFDDA / hVtxZFDDA->Interpolate(posZ);
+      multZeqFDDC = hVtxZFDDC->Interpolate(0.0) * multFDDC / hVtxZFDDC->Interpolate(posZ);
+      multZeqNContribs = hVtxZNTracks->Interpolate(0.0) * multNContribs / hVtxZNTracks->Interpolate(posZ);
+    }
+    if (doDummyZeq) {
+      multZeqFV0A = multFV0A;
+      multZeqFT0A = multFT0A;
+      multZeqFT0C = multFT0C;
+      multZeqFDDA = multFDDA;
+      multZeqFDDC = multFDDC;
+      multZeqNContribs = multNContribs;
+    }
+
+    LOGF(debug, "multFV0A=%5.0f multFV0C=%5.0f multFT0A=%5.0f multFT0C=%5.0f multFDDA=%5.0f multFDDC=%5.0f multZNA=%6.0f multZNC=%6.0f multTracklets=%i multTPC=%i", multFV0A, multFV0C, multFT0A, multFT0C, multFDDA, multFDDC, multZNA, multZNC, multTracklets, multTPC);
+    mult(multFV0A, multFV0C, multFT0A, multFT0C, multFDDA, multFDDC, multZNA, multZNC, multTracklets, multTPC, multNContribs, multNContribsEta1);
+    if (fillMultZeqs) {
+      multzeq(multZeqFV0A, multZeqFT0A, multZeqFT0C, multZeqFDDA, multZeqFDDC, multZeqNContribs);
+    }
+  }
+
   void processRun2(aod::Run2MatchedSparse::iterator const& collision, soa::Join<aod::Tracks, aod::TracksExtra> const& tracksExtra, aod::BCs const&, aod::Zdcs const&, aod::FV0As const& fv0as, aod::FV0Cs const& fv0cs, aod::FT0s const& ft0s)
   {
     float multFV0A = 0.f;
@@ -129,21 +234,10 @@ struct MultiplicityTableTaskIndexed {
   void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Join<aod::Tracks, aod::TracksExtra> const& tracksExtra, soa::Join<aod::BCs, aod::Timestamps> const& bcs, aod::Zdcs const& zdcs, aod::FV0As const& fv0as, aod::FT0s const& ft0s, aod::FDDs const& fdds)
   {
     float multFV0A = 0.f;
-    float multFV0C = 0.f;
     float multFT0A = 0.f;
     float multFT0C = 0.f;
     float multFDDA = 0.f;
     float multFDDC = 0.f;
-    float multZNA = 0.f;
-    float multZNC = 0.f;
-    int multTracklets = 0;
-
-    float multZeqFV0A = 0.f;
-    float multZeqFT0A = 0.f;
-    float multZeqFT0C = 0.f;
-    float multZeqFDDA = 0.f;
-    float multZeqFDDC = 0.f;
-    float multZeqNContribs = 0.f;
 
     auto tracksGrouped = tracksWithTPC->sliceByCached(aod::track::collisionId, collision.globalIndex());
     auto pvContribsGrouped = pvContribTracks->sliceByCached(aod::track::collisionId, collision.globalIndex());
@@ -153,76 +247,85 @@ struct MultiplicityTableTaskIndexed {
     int multNContribsEta1 = pvContribsEta1Grouped.size();
 
     /* check the previous run number */
-    auto bc = collision.bc_as<soa::Join<aod::BCs, aod::Timestamps>>();
-    if (doVertexZeq > 0 && doDummyZeq < 1) {
-      if (bc.runNumber() != mRunNumber) {
-        mRunNumber = bc.runNumber(); //mark this run as at least tried
-        lCalibObjects = ccdb->getForTimeStamp<TList>("Centrality/Calibration", bc.timestamp());
-        if (lCalibObjects) {
-          hVtxZFV0A = (TProfile*)lCalibObjects->FindObject("hVtxZFV0A");
-          hVtxZFT0A = (TProfile*)lCalibObjects->FindObject("hVtxZFT0A");
-          hVtxZFT0C = (TProfile*)lCalibObjects->FindObject("hVtxZFT0C");
-          hVtxZFDDA = (TProfile*)lCalibObjects->FindObject("hVtxZFDDA");
-          hVtxZFDDC = (TProfile*)lCalibObjects->FindObject("hVtxZFDDC");
-          hVtxZNTracks = (TProfile*)lCalibObjects->FindObject("hVtxZNTracksPV");
-          lCalibLoaded = true;
-          //Capture error
-          if (!hVtxZFV0A || !hVtxZFT0A || !hVtxZFT0C || !hVtxZFDDA || !hVtxZFDDC || !hVtxZNTracks) {
-            LOGF(info, "Problem loading CCDB objects! Please check");
-            lCalibLoaded = false;
-          }
-        }
-      }
-    }
+    loadCalibration(collision.bc_as<soa::Join<aod::BCs, aod::Timestamps>>());
+
     // using FT0 row index from event selection task
     if (collision.has_foundFT0()) {
       auto ft0 = collision.foundFT0();
-      for (auto amplitude : ft0.amplitudeA()) {
-        multFT0A += amplitude;
-      }
-      for (auto amplitude : ft0.amplitudeC()) {
-        multFT0C += amplitude;
-      }
+      multFT0A = sumAmplitudes(ft0.amplitudeA());
+      multFT0C = sumAmplitudes(ft0.amplitudeC());
     }
     // using FDD row index from event selection task
     if (collision.has_foundFDD()) {
       auto fdd = collision.foundFDD();
-      for (auto amplitude : fdd.chargeA()) {
-        multFDDA += amplitude;
-      }
-      for (auto amplitude : fdd.chargeC()) {
-        multFDDC += amplitude;
-      }
+      multFDDA = sumAmplitudes(fdd.chargeA());
+      multFDDC = sumAmplitudes(fdd.chargeC());
     }
     // using FV0 row index from event selection task
     if (collision.has_foundFV0()) {
-      auto fv0 = collision.foundFV0();
-      for (auto amplitude : fv0.amplitude()) {
-        multFV0A += amplitude;
-      }
+      multFV0A = sumAmplitudes(collision.foundFV0().amplitude());
     }
-    if (fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
-      multZeqFV0A = hVtxZFV0A->Interpolate(0.0) * multFV0A / hVtxZFV0A->Interpolate(collision.posZ());
-      multZeqFT0A = hVtxZFT0A->Interpolate(0.0) * multFT0A / hVtxZFT0A->Interpolate(collision.posZ());
-      multZeqFT0C = hVtxZFT0C->Interpolate(0.0) * multFT0C / hVtxZFT0C->Interpolate(collision.posZ());
-      multZeqFDDA = hVtxZFDDA->Interpolate(0.0) * multFDDA / hVtxZFDDA->Interpolate(collision.posZ());
-      multZeqFDDC = hVtxZFDDC->Interpolate(0.0) * multFDDC / hVtxZFDDC->Interpolate(collision.posZ());
-      multZeqNContribs = hVtxZNTracks->Interpolate(0.0) * multNContribs / hVtxZNTracks->Interpolate(collision.posZ());
+    fillRun3(collision.posZ(), multFV0A, multFT0A, multFT0C, multFDDA, multFDDC, multTPC, multNContribs, multNContribsEta1);
+  }
+  PROCESS_SWITCH(MultiplicityTableTaskIndexed, processRun3, "Produce Run 3 multiplicity tables", false);
+
+  /// Same tables as processRun3, for the whole data frame at once: the detector amplitudes are reduced
+  /// table by table and the track counts are accumulated in a single pass over the tracks, then the
+  /// collisions pick their sums through the FT0/FV0/FDD row indices of the event selection
+  void processRun3Bulk(soa::Join<aod::Collisions, aod::EvSels> const& collisions, soa::Join<aod::Tracks, aod::TracksExtra> const& tracksExtra, soa::Join<aod::BCs, aod::Timestamps> const& bcs, aod::FV0As const& fv0as, aod::FT0s const& ft0s, aod::FDDs const& fdds)
+  {
+    lFV0ASums.resize(fv0as.size());
+    for (auto& fv0 : fv0as) {
+      lFV0ASums[fv0.globalIndex()] = sumAmplitudes(fv0.amplitude());
     }
-    if (doDummyZeq) {
-      multZeqFV0A = multFV0A;
-      multZeqFT0A = multFT0A;
-      multZeqFT0C = multFT0C;
-      multZeqFDDA = multFDDA;
-      multZeqFDDC = multFDDC;
-      multZeqNContribs = multNContribs;
+    lFT0ASums.resize(ft0s.size());
+    lFT0CSums.resize(ft0s.size());
+    for (auto& ft0 : ft0s) {
+      lFT0ASums[ft0.globalIndex()] = sumAmplitudes(ft0.amplitudeA());
+      lFT0CSums[ft0.globalIndex()] = sumAmplitudes(ft0.amplitudeC());
+    }
+    lFDDASums.resize(fdds.size());
+    lFDDCSums.resize(fdds.size());
+    for (auto& fdd : fdds) {
+      lFDDASums[fdd.globalIndex()] = sumAmplitudes(fdd.chargeA());
+      lFDDCSums[fdd.globalIndex()] = sumAmplitudes(fdd.chargeC());
     }
 
-    LOGF(debug, "multFV0A=%5.0f multFV0C=%5.0f multFT0A=%5.0f multFT0C=%5.0f multFDDA=%5.0f multFDDC=%5.0f multZNA=%6.0f multZNC=%6.0f multTracklets=%i multTPC=%i", multFV0A, multFV0C, multFT0A, multFT0C, multFDDA, multFDDC, multZNA, multZNC, multTracklets, multTPC);
-    mult(multFV0A, multFV0C, multFT0A, multFT0C, multFDDA, multFDDC, multZNA, multZNC, multTracklets, multTPC, multNContribs, multNContribsEta1);
-    multzeq(multZeqFV0A, multZeqFT0A, multZeqFT0C, multZeqFDDA, multZeqFDDC, multZeqNContribs);
+    // same selections as the tracksWithTPC, pvContribTracks and pvContribTracksEta1 partitions
+    lNTPC.assign(collisions.size(), 0);
+    lNContribs.assign(collisions.size(), 0);
+    lNContribsEta1.assign(collisions.size(), 0);
+    for (auto& track : tracksExtra) {
+      if (!track.has_collision()) {
+        continue;
+      }
+      auto iColl = track.collisionId();
+      if (track.tpcNClsFindable() > (uint8_t)0) {
+        lNTPC[iColl]++;
+      }
+      if ((track.flags() & (uint32_t)o2::aod::track::PVContributor) == (uint32_t)o2::aod::track::PVContributor) {
+        if (fabs(track.eta()) < 0.8f) {
+          lNContribs[iColl]++;
+        }
+        if (fabs(track.eta()) < 1.0f) {
+          lNContribsEta1[iColl]++;
+        }
+      }
+    }
+
+    for (auto& collision : collisions) {
+      loadCalibration(collision.bc_as<soa::Join<aod::BCs, aod::Timestamps>>());
+      auto iColl = collision.globalIndex();
+      fillRun3(collision.posZ(),
+               collision.has_foundFV0() ? lFV0ASums[collision.foundFV0Id()] : 0.f,
+               collision.has_foundFT0() ? lFT0ASums[collision.foundFT0Id()] : 0.f,
+               collision.has_foundFT0() ? lFT0CSums[collision.foundFT0Id()] : 0.f,
+               collision.has_foundFDD() ? lFDDASums[collision.foundFDDId()] : 0.f,
+               collision.has_foundFDD() ? lFDDCSums[collision.foundFDDId()] : 0.f,
+               lNTPC[iColl], lNContribs[iColl], lNContribsEta1[iColl]);
+    }
   }
-  PROCESS_SWITCH(MultiplicityTableTaskIndexed, processRun3, "Produce Run 3 multiplicity tables", false);
+  PROCESS_SWITCH(MultiplicityTableTaskIndexed, processRun3Bulk, "Produce Run 3 multiplicity tables for the whole data frame at once", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -0,0 +1,132 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   qVectorsTable.cxx
+/// \brief  Task producing the barrel Q-vectors of each collision (harmonics 2, 3, 4; full eta range and eta sub-events),
+///         so that the event-plane and flow tasks of a train do not all recompute them from the tracks
+///
+/// The tracks are weighted with the NUA weights of a GFWWeights object from the CCDB, optionally multiplied by its NUE weights.
+///
+
+#include <cmath>
+#include <string>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "CCDB/BasicCCDBManager.h"
+#include "Common/DataModel/TrackSelectionTables.h"
+#include "Common/DataModel/Qvectors.h"
+#include "PWGCF/GenericFramework/GFWWeights.h"
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::framework::expressions;
+
+struct QVectorsTable {
+  Produces<aod::Qvectors> qVectors;
+
+  Configurable<float> cfgCutPtMin{"cfgCutPtMin", 0.2f, "Minimal pT for tracks"};
+  Configurable<float> cfgCutPtMax{"cfgCutPtMax", 12.0f, "Maximal pT for tracks"};
+  Configurable<float> cfgCutEta{"cfgCutEta", 0.8f, "Eta range for tracks"};
+  Configurable<float> cfgEtaGap{"cfgEtaGap", 0.4f, "Minimal |eta| of the tracks of the negative and positive eta sub-events"};
+  Configurable<int> cfgNPow{"cfgNPow", 1, "Power of the track weights in the Q-vectors"};
+  Configurable<std::string> cfgWeights{"cfgWeights", "", "CCDB path to the GFWWeights object, no weights if empty"};
+  Configurable<bool> cfgUseNUE{"cfgUseNUE", false, "Multiply the NUA weights with the NUE weights of the GFWWeights object"};
+
+  Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
+  Configurable<long> nolaterthan{"ccdb-no-later-than", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), "latest acceptable timestamp of creation for the object"};
+  Service<ccdb::BasicCCDBManager> ccdb;
+
+  Filter trackFilter = (nabs(aod::track::eta) < cfgCutEta) && (aod::track::pt > cfgCutPtMin) && (aod::track::pt < cfgCutPtMax) && ((requireGlobalTrackInFilter()) || (aod::track::isGlobalTrackSDD == (uint8_t) true));
+  using MyTracks = soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>>;
+
+  GFWWeights* mWeights = nullptr;
+  int mRunNumber = -1;
+
+  // Sums of a sub-event: Q_n for n = 2, 3, 4, sum of weights and number of tracks
+  struct SubEvent {
+    float qx[3] = {0.f, 0.f, 0.f};
+    float qy[3] = {0.f, 0.f, 0.f};
+    float sumW = 0.f;
+    int nTrk = 0;
+
+    void add(float w, const float (&c)[3], const float (&s)[3])
+    {
+      for (int i = 0; i < 3; i++) {
+        qx[i] += w * c[i];
+        qy[i] += w * s[i];
+      }
+      sumW += w;
+      nTrk++;
+    }
+  };
+
+  void init(InitContext const&)
+  {
+    ccdb->setURL(url.value);
+    ccdb->setCaching(true);
+    ccdb->setLocalObjectValidityChecking();
+    ccdb->setCreatedNotAfter(nolaterthan.value);
+  }
+
+  void process(aod::Collision const& collision, aod::BCsWithTimestamps const&, MyTracks const& tracks)
+  {
+    auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+    if (!cfgWeights.value.empty() && bc.runNumber() != mRunNumber) {
+      mWeights = ccdb->getForTimeStamp<GFWWeights>(cfgWeights.value, bc.timestamp());
+      if (!mWeights) {
+        LOGF(warning, "Could not load the GFWWeights from %s for run %d, the tracks are not weighted", cfgWeights.value.c_str(), bc.runNumber());
+      }
+      mRunNumber = bc.runNumber();
+    }
+
+    SubEvent full, neg, pos;
+    const float vtxz = collision.posZ();
+    for (auto& track : tracks) {
+      float w = 1.f;
+      if (mWeights) {
+        w = mWeights->GetNUA(track.phi(), track.eta(), vtxz);
+        if (cfgUseNUE) {
+          w *= mWeights->GetNUE(track.pt(), track.eta(), vtxz);
+        }
+      }
+      if (cfgNPow != 1) {
+        w = std::pow(w, static_cast<float>(cfgNPow));
+      }
+      // cos(n phi) and sin(n phi) for n = 2, 3, 4 from the multiple-angle formulas
+      const float c1 = std::cos(track.phi());
+      const float s1 = std::sin(track.phi());
+      const float c2 = c1 * c1 - s1 * s1;
+      const float s2 = 2.f * s1 * c1;
+      const float c[3] = {c2, c2 * c1 - s2 * s1, c2 * c2 - s2 * s2};
+      const float s[3] = {s2, s2 * c1 + c2 * s1, 2.f * s2 * c2};
+      full.add(w, c, s);
+      if (track.eta() < -cfgEtaGap) {
+        neg.add(w, c, s);
+      } else if (track.eta() > cfgEtaGap) {
+        pos.add(w, c, s);
+      }
+    }
+
+    qVectors(full.qx[0], full.qy[0], neg.qx[0], neg.qy[0], pos.qx[0], pos.qy[0],
+             full.qx[1], full.qy[1], neg.qx[1], neg.qy[1], pos.qx[1], pos.qy[1],
+             full.qx[2], full.qy[2], neg.qx[2], neg.qy[2], pos.qx[2], pos.qy[2],
+             full.sumW, neg.sumW, pos.sumW,
+             full.nTrk, neg.nTrk, pos.nTrk);
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<QVectorsTable>(cfgc, TaskName{"qvectors-table"})};
+}
@@ -0,0 +1,228 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   syntheticAODGenerator.cxx
+/// \brief  Source of synthetic Run 3 AO2D tables, for the throughput benchmarks of the workflows.
+///         The BCs, collisions, tracks at the innermost update, their covariance and extra information, the FIT and ZDC
+///         tables and optionally the MC collisions, particles and labels are produced for nDataFrames data frames.
+///         They are written to an AO2D file with the writer of the workflow:
+///           o2-analysis-synthetic-aod-generator --aod-writer-keep dangling --aod-writer-resfile AO2D_synthetic -b
+///         The multiplicity follows the pp or Pb-Pb profile of Common/Core/benchmark/SyntheticEvents.h and the filled BCs
+///         contain 1 + Poisson(pileUp) collisions. The tracks are pions, kaons and protons with a TPC signal and a TOF time
+///         consistent with their mass. The number of generated collisions and tracks is written to summaryFile.
+///
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/ControlService.h"
+#include "Framework/runDataProcessing.h"
+
+#include "Common/Core/benchmark/SyntheticEvents.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct SyntheticAODGenerator {
+  Produces<aod::BCs> bcs;
+  Produces<aod::Collisions> collisions;
+  Produces<aod::StoredTracksIU> tracks;
+  Produces<aod::StoredTracksCovIU> tracksCov;
+  Produces<aod::StoredTracksExtra> tracksExtra;
+  Produces<aod::FT0s> ft0s;
+  Produces<aod::FV0As> fv0as;
+  Produces<aod::FDDs_001> fdds;
+  Produces<aod::Zdcs> zdcs;
+  Produces<aod::McCollisions> mcCollisions;
+  Produces<aod::StoredMcParticles_001> mcParticles;
+  Produces<aod::McTrackLabels> mcTrackLabels;
+  Produces<aod::McCollisionLabels> mcCollisionLabels;
+
+  Configurable<int> nDataFrames{"nDataFrames", 10, "Number of data frames to generate"};
+  Configurable<int> nCollisionsPerDataFrame{"nCollisionsPerDataFrame", 1000, "Number of collisions per data frame"};
+  Configurable<std::string> system{"system", "pp", "Multiplicity profile of the collisions: pp or PbPb"};
+  Configurable<float> multiplicityScale{"multiplicityScale", 1.f, "Factor applied to the mean multiplicity of the profile"};
+  Configurable<float> pileUp{"pileUp", 0.f, "Mean number of additional collisions in the BC of a collision"};
+  Configurable<bool> produceMC{"produceMC", true, "Fill the MC collisions, particles and labels, the tables are sent empty otherwise"};
+  Configurable<int> runNumber{"runNumber", 523308, "Run number of the BCs, it must exist in the CCDB for the workflows fetching the run conditions"};
+  Configurable<int64_t> firstGlobalBC{"firstGlobalBC", 0, "Global BC of the first BC"};
+  Configurable<int> seed{"seed", 12345, "Seed of the random generator"};
+  Configurable<std::string> summaryFile{"summaryFile", "synthetic-aod-summary.json", "File with the number of generated data frames, collisions and tracks, not written if empty"};
+
+  static constexpr int nBCsPerOrbit = 3564;
+  static constexpr float cSpeed = 0.0299792458f; // cm/ps
+  static constexpr std::array<int, 3> pdgCodes = {211, 321, 2212};
+  static constexpr std::array<float, 3> masses = {0.13957f, 0.493677f, 0.938272f};
+  static constexpr std::array<float, 3> abundances = {0.8f, 0.92f, 1.f}; // cumulative fractions of pions, kaons and protons
+
+  std::mt19937 mEngine;
+  std::unique_ptr<o2::analysis::bench::EventGenerator> mMultiplicity;
+  int mDataFrame = 0;
+  int64_t mGlobalBC = 0;
+  std::size_t mNCollisions = 0;
+  std::size_t mNTracks = 0;
+
+  void init(InitContext&)
+  {
+    if (system.value != "pp" && system.value != "PbPb") {
+      LOG(fatal) << "Unknown system " << system.value << ", expected pp or PbPb";
+    }
+    const auto profile = system.value == "pp" ? o2::analysis::bench::CollisionSystem::kPP : o2::analysis::bench::CollisionSystem::kPbPb;
+    mEngine.seed(seed.value);
+    mMultiplicity = std::make_unique<o2::analysis::bench::EventGenerator>(profile, seed.value + 1, multiplicityScale.value);
+    mGlobalBC = firstGlobalBC.value;
+  }
+
+  void run(ProcessingContext& pc)
+  {
+    if (mDataFrame >= nDataFrames) {
+      writeSummary();
+      pc.services().get<ControlService>().endOfStream();
+      pc.services().get<ControlService>().readyToQuit(QuitRequest::Me);
+      return;
+    }
+    std::uniform_real_distribution<float> flat(0.f, 1.f);
+    std::normal_distribution<float> gaus(0.f, 1.f);
+    std::exponential_distribution<float> ptSpectrum(1.f / 0.6f);
+    std::poisson_distribution<int> pileUpCollisions(pileUp > 0.f ? pileUp.value : 1.f);
+    std::geometric_distribution<int> emptyBCs(0.05);
+
+    int bcIndex = -1;
+    int nCollisionsInBC = 0;
+    int trackIndex = 0;
+    for (int collisionIndex = 0; collisionIndex < nCollisionsPerDataFrame; collisionIndex++) {
+      if (nCollisionsInBC == 0) { // new filled BC, with its FIT and ZDC signals
+        mGlobalBC += 1 + emptyBCs(mEngine);
+        bcIndex++;
+        nCollisionsInBC = 1 + (pileUp > 0.f ? pileUpCollisions(mEngine) : 0);
+        bcs(runNumber.value, mGlobalBC, 0);
+        fillFITAndZDC(bcIndex, nCollisionsInBC, flat);
+      }
+      nCollisionsInBC--;
+
+      const int multiplicity = mMultiplicity->generateMultiplicity();
+      const float posX = 0.005f * gaus(mEngine);
+      const float posY = 0.005f * gaus(mEngine);
+      const float posZ = 6.f * gaus(mEngine);
+      const float collisionTime = 0.1f * gaus(mEngine); // ns, relative to the BC
+      const float vertexResolution = 0.01f / std::sqrt(static_cast<float>(multiplicity));
+      const float vertexVariance = vertexResolution * vertexResolution;
+      collisions(bcIndex, posX + vertexResolution * gaus(mEngine), posY + vertexResolution * gaus(mEngine), posZ + vertexResolution * gaus(mEngine),
+                 vertexVariance, 0.f, 0.f, vertexVariance, 0.f, vertexVariance, 0, 1.f, multiplicity, collisionTime, 0.02f);
+      if (produceMC) {
+        mcCollisions(bcIndex, 0, posX, posY, posZ, collisionTime, 1.f, system.value == "pp" ? 0.f : 15.f * std::sqrt(flat(mEngine)));
+        mcCollisionLabels(collisionIndex, 0);
+      }
+
+      for (int i = 0; i < multiplicity; i++) {
+        const float r = flat(mEngine);
+        const int species = r < abundances[0] ? 0 : (r < abundances[1] ? 1 : 2);
+        const float mass = masses[species];
+        const float pt = 0.05f + ptSpectrum(mEngine);
+        const float eta = 2.4f * flat(mEngine) - 1.2f;
+        const float phi = 2.f * static_cast<float>(M_PI) * flat(mEngine);
+        const int sign = flat(mEngine) < 0.5f ? -1 : 1;
+        const float p = pt * std::cosh(eta);
+        const float tgl = std::sinh(eta);
+
+        // track at the vertex in the frame of its azimuth, smeared by the DCA resolution
+        const float cosPhi = std::cos(phi);
+        const float sinPhi = std::sin(phi);
+        const float x = posX * cosPhi + posY * sinPhi;
+        const float y = -posX * sinPhi + posY * cosPhi + (0.002f + 0.003f / pt) * gaus(mEngine);
+        const float z = posZ + (0.002f + 0.003f / pt) * gaus(mEngine);
+        const float signed1Pt = sign / (pt * (1.f + 0.01f * gaus(mEngine)));
+        tracks(collisionIndex, o2::aod::track::Track, x, phi, y, z, 0.f, tgl, signed1Pt);
+        tracksCov(0.003f / pt, 0.003f / pt, 0.001f, 0.001f, 0.01f / pt, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        // TPC dE/dx from a simplified Bethe-Bloch and TOF time from the mass, relative to the pion hypothesis of the tracking
+        const float betaGamma = p / mass;
+        const float dEdx = 50.f * (1.f + 1.f / (betaGamma * betaGamma)) * (1.f + 0.07f * gaus(mEngine));
+        const bool hasTOF = p > 0.3f && flat(mEngine) < 0.6f;
+        const float length = 370.f * std::cosh(eta);
+        const float expectedTime = length * std::sqrt(p * p + mass * mass) / (p * cSpeed);
+        const float expectedTimePion = length * std::sqrt(p * p + masses[0] * masses[0]) / (p * cSpeed);
+        const float trackTime = collisionTime + (expectedTime - expectedTimePion + 80.f * gaus(mEngine)) * 1.e-3f; // ns
+        const uint32_t flags = 2u << 28;                                                                         // pion as PID for the tracking, in the upper 4 bits
+        const uint8_t tpcNClsFindable = 160;
+        const uint8_t tpcNClsFound = static_cast<uint8_t>(70 + 89 * flat(mEngine));
+        tracksExtra(p, flags, static_cast<uint8_t>(flat(mEngine) < 0.1f ? 0x7e : 0x7f), tpcNClsFindable, static_cast<int8_t>(tpcNClsFindable - tpcNClsFound),
+                    static_cast<int8_t>(tpcNClsFindable - tpcNClsFound - 2), 0, 0, 2.f * flat(mEngine) + 0.5f, 1.f + 2.f * flat(mEngine), -1.f, hasTOF ? 1.f : -1.f,
+                    dEdx, 0.f, hasTOF ? length : -999.f, hasTOF ? p : 0.f, -999.f, -999.f, trackTime, 0.08f);
+        if (produceMC) {
+          const float energy = std::sqrt(p * p + mass * mass);
+          mcParticles(collisionIndex, sign * pdgCodes[species], 1, 0, std::vector<int>{}, std::array<int, 2>{-1, -1}.data(), 1.f,
+                      pt * cosPhi, pt * sinPhi, pt * tgl, energy, posX, posY, posZ, collisionTime);
+          mcTrackLabels(trackIndex, 0);
+        }
+        trackIndex++;
+      }
+      mNTracks += multiplicity;
+    }
+    mNCollisions += nCollisionsPerDataFrame;
+    mGlobalBC += nBCsPerOrbit; // the next data frame starts in a later orbit
+    mDataFrame++;
+  }
+
+  /// FIT and ZDC signals of a BC, proportional to the number of collisions in it
+  void fillFITAndZDC(int bcIndex, int nCollisionsInBC, std::uniform_real_distribution<float>& flat)
+  {
+    std::vector<float> amplitudeA, amplitudeC, amplitudeV0A;
+    std::vector<uint8_t> channelA, channelC, channelV0A;
+    for (uint8_t channel = 0; channel < 96; channel++) {
+      amplitudeA.push_back(nCollisionsInBC * 10.f * flat(mEngine));
+      channelA.push_back(channel);
+    }
+    for (uint8_t channel = 96; channel < 208; channel++) {
+      amplitudeC.push_back(nCollisionsInBC * 10.f * flat(mEngine));
+      channelC.push_back(channel - 96);
+    }
+    for (uint8_t channel = 0; channel < 48; channel++) {
+      amplitudeV0A.push_back(nCollisionsInBC * 20.f * flat(mEngine));
+      channelV0A.push_back(channel);
+    }
+    ft0s(bcIndex, amplitudeA, channelA, amplitudeC, channelC, 0.f, 0.f, 0x1);
+    fv0as(bcIndex, amplitudeV0A, channelV0A, 0.f, 0x1);
+    int16_t chargeA[8] = {0};
+    int16_t chargeC[8] = {0};
+    for (int i = 0; i < 8; i++) {
+      chargeA[i] = static_cast<int16_t>(nCollisionsInBC * 50 * flat(mEngine));
+      chargeC[i] = static_cast<int16_t>(nCollisionsInBC * 50 * flat(mEngine));
+    }
+    fdds(bcIndex, chargeA, chargeC, 0.f, 0.f, 0x1);
+    float sectors[4] = {0.f, 0.f, 0.f, 0.f};
+    zdcs(bcIndex, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, sectors, sectors, sectors, sectors, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f);
+  }
+
+  void writeSummary() const
+  {
+    if (summaryFile.value.empty()) {
+      return;
+    }
+    std::ofstream summary(summaryFile.value);
+    summary << "{\"dataFrames\": " << mDataFrame << ", \"collisions\": " << mNCollisions << ", \"tracks\": " << mNTracks
+            << ", \"system\": \"" << system.value << "\", \"pileUp\": " << pileUp.value << ", \"mc\": " << (produceMC ? "true" : "false") << "}\n";
+    LOG(info) << "Generated " << mNCollisions << " collisions and " << mNTracks << " tracks in " << mDataFrame << " data frames";
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<SyntheticAODGenerator>(cfgc)};
+}
@@ -54,53 +54,60 @@ struct TimestampTask {
     }
   }
 
-  void process(aod::BC const& bc)
+  /// Gets the orbit-reset timestamp of a run, from the cache or from CCDB if the run was not requested before
+  /// \param runNumber run of interest
+  /// \return orbit-reset timestamp in us
+  int64_t getOrbitResetTimestamp(const int runNumber)
   {
-    int runNumber = bc.runNumber();
-    // We need to set the orbit-reset timestamp for the run number.
-    // This is done with caching if the run number was already processed before.
-    // If not the orbit-reset timestamp for the run number is queried from CCDB and added to the cache
-    if (runNumber == lastRunNumber) { // The run number coincides to the last run processed
-      LOGF(debug, "Using orbit-reset timestamp from last call");
-    } else if (mapRunToOrbitReset.count(runNumber)) { // The run number was already requested before: getting it from cache!
+    auto cached = mapRunToOrbitReset.find(runNumber);
+    if (cached != mapRunToOrbitReset.end()) { // The run number was already requested before: getting it from cache!
       LOGF(debug, "Getting orbit-reset timestamp from cache");
-      orbitResetTimestamp = mapRunToOrbitReset[runNumber];
-    } else { // The run was not requested before: need to acccess CCDB!
-      LOGF(debug, "Getting start-of-run timestamp from CCDB");
-      std::map<std::string, std::string> metadata, headers;
-      const std::string run_path = Form("%s/%i", rct_path.value.data(), runNumber);
-      headers = ccdb_api.retrieveHeaders(run_path, metadata, -1);
-      if (headers.count("SOR") == 0) {
-        LOGF(fatal, "Cannot find start-of-run timestamp for run number in path '%s'.", run_path.data());
-      }
-      int64_t sorTimestamp = atol(headers["SOR"].c_str()); // timestamp of the SOR in ms
-
-      bool isUnanchoredRun3MC = runNumber >= 300000 && runNumber < 500000;
-      if (isRun2MC || isUnanchoredRun3MC) {
-        // isRun2MC: bc/orbit distributions are not simulated in Run2 MC. All bcs are set to 0.
-        // isUnanchoredRun3MC: assuming orbit-reset is done in the beginning of each run
-        // Setting orbit-reset timestamp to start-of-run timestamp
-        orbitResetTimestamp = sorTimestamp * 1000; // from ms to us
-      } else {
-        LOGF(debug, "Getting orbit-reset timestamp using start-of-run timestamp from CCDB");
-        auto ctp = ccdb->getForTimeStamp<std::vector<Long64_t>>(orbit_reset_path.value.data(), sorTimestamp);
-        orbitResetTimestamp = (*ctp)[0];
-      }
-
-      // Adding the timestamp to the cache map
-      std::pair<std::map<int, int64_t>::iterator, bool> check;
-      check = mapRunToOrbitReset.insert(std::pair<int, int64_t>(runNumber, orbitResetTimestamp));
-      if (!check.second) {
-        LOGF(fatal, "Run number %i already existed with a orbit-reset timestamp of %llu", runNumber, check.first->second);
-      }
-      LOGF(info, "Add new run number %i with orbit-reset timestamp %llu to cache", runNumber, orbitResetTimestamp);
+      return cached->second;
+    }
+    // The run was not requested before: need to acccess CCDB!
+    LOGF(debug, "Getting start-of-run timestamp from CCDB");
+    std::map<std::string, std::string> metadata, headers;
+    const std::string run_path = Form("%s/%i", rct_path.value.data(), runNumber);
+    headers = ccdb_api.retrieveHeaders(run_path, metadata, -1);
+    if (headers.count("SOR") == 0) {
+      LOGF(fatal, "Cannot find start-of-run timestamp for run number in path '%s'.", run_path.data());
     }
+    int64_t sorTimestamp = atol(headers["SOR"].c_str()); // timestamp of the SOR in ms
 
-    if (verbose.value) {
-      LOGF(info, "Orbit-reset timestamp for run number %i found: %llu us", runNumber, orbitResetTimestamp);
+    int64_t runOrbitResetTimestamp = 0;
+    bool isUnanchoredRun3MC = runNumber >= 300000 && runNumber < 500000;
+    if (isRun2MC || isUnanchoredRun3MC) {
+      // isRun2MC: bc/orbit distributions are not simulated in Run2 MC. All bcs are set to 0.
+      // isUnanchoredRun3MC: assuming orbit-reset is done in the beginning of each run
+      // Setting orbit-reset timestamp to start-of-run timestamp
+      runOrbitResetTimestamp = sorTimestamp * 1000; // from ms to us
+    } else {
+      LOGF(debug, "Getting orbit-reset timestamp using start-of-run timestamp from CCDB");
+      auto ctp = ccdb->getForTimeStamp<std::vector<Long64_t>>(orbit_reset_path.value.data(), sorTimestamp);
+      runOrbitResetTimestamp = (*ctp)[0];
     }
 
-    timestampTable((orbitResetTimestamp + int64_t(bc.globalBC() * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000); // us -> ms
+    // Adding the timestamp to the cache map
+    mapRunToOrbitReset.emplace(runNumber, runOrbitResetTimestamp);
+    LOGF(info, "Add new run number %i with orbit-reset timestamp %llu to cache", runNumber, runOrbitResetTimestamp);
+    return runOrbitResetTimestamp;
+  }
+
+  void process(aod::BCs const& bcs)
+  {
+    timestampTable.reserve(bcs.size());
+    // BCs come in contiguous blocks of the same run: the orbit-reset timestamp is resolved once per block
+    for (auto const& bc : bcs) {
+      const int runNumber = bc.runNumber();
+      if (runNumber != lastRunNumber) {
+        orbitResetTimestamp = getOrbitResetTimestamp(runNumber);
+        lastRunNumber = runNumber;
+        if (verbose.value) {
+          LOGF(info, "Orbit-reset timestamp for run number %i found: %llu us", runNumber, orbitResetTimestamp);
+        }
+      }
+      timestampTable((orbitResetTimestamp + int64_t(bc.globalBC() * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000); // us -> ms
+    }
   }
 };
 
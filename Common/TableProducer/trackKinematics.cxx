@@ -0,0 +1,47 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   trackKinematics.cxx
+/// \brief  Task storing the momentum components and the sign of the tracks in the TracksKinematics table, once per data frame,
+///         so that the tasks of a train read them from contiguous columns instead of evaluating the dynamic columns
+///
+
+#include <cmath>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Common/DataModel/TrackKinematics.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct TrackKinematicsTask {
+  Produces<aod::TracksKinematics> tracksKinematics;
+
+  void process(aod::Tracks const& tracks)
+  {
+    tracksKinematics.reserve(tracks.size());
+    for (auto& track : tracks) {
+      // same as the dynamic columns, with pt and phi read once from the expression columns
+      const float pt = track.pt();
+      const float tgl = track.tgl();
+      const float phi = track.phi();
+      tracksKinematics(pt * std::sqrt(1.f + tgl * tgl), pt * std::cos(phi), pt * std::sin(phi), pt * tgl, track.signed1Pt() > 0.f ? 1 : -1);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<TrackKinematicsTask>(cfgc, TaskName{"track-kinematics"})};
+}
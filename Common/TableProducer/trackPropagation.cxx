@@ -19,6 +19,8 @@
 #include "Framework/RunningWorkflowInfo.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/RunConditionsCache.h"
+#include "Common/Core/ThreadPool.h"
 #include "ReconstructionDataFormats/DCA.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
@@ -31,6 +33,9 @@
 #include "DataFormatsCalibration/MeanVertexObject.h"
 #include "CommonConstants/GeomConstants.h"
 
+#include <algorithm>
+#include <vector>
+
 // The Run 3 AO2D stores the tracks at the point of innermost update. For a track with ITS this is the innermost (or second innermost)
 // ITS layer. For a track without ITS, this is the TPC inner wall or for loopers in the TPC even a radius beyond that.
 // In order to use the track parameters, the tracks have to be propagated to the collision vertex which is done by this task.
@@ -38,6 +43,9 @@
 //
 // This task is not needed for Run 2 converted data.
 // There are two versions of the task (see process flags), one producing also the covariance matrix and the other only the tracks table.
+//
+// The tracks of a data frame are first copied to buffers, ordered by collision, propagated in parallel in up to nThreads chunks by the threads of the pool
+// (each working on a contiguous range of collisions, so that the vertex is shared by consecutive tracks) and written to the tables in row order.
 
 using namespace o2;
 using namespace o2::framework;
@@ -55,25 +63,42 @@ struct TrackPropagation {
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
   bool fillTracksDCA = false;
-  int runNumber = -1;
 
   o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
 
   const o2::dataformats::MeanVertexObject* mVtx = nullptr;
-  o2::parameters::GRPMagField* grpmag = nullptr;
-  o2::base::MatLayerCylSet* lut = nullptr;
+  o2::analysis::RunConditionsCache runConditions;
 
   Configurable<std::string> ccdburl{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> lutPath{"lutPath", "GLO/Param/MatLUT", "Path of the Lut parametrization"};
   Configurable<std::string> geoPath{"geoPath", "GLO/Config/GeometryAligned", "Path of the geometry file"};
   Configurable<std::string> grpmagPath{"grpmagPath", "GLO/Config/GRPMagField", "CCDB path of the GRPMagField object"};
   Configurable<std::string> mVtxPath{"mVtxPath", "GLO/Calib/MeanVertex", "Path of the mean vertex file"};
+  Configurable<int> nThreads{"nThreads", 1, "max. number of chunks of the tracks of a data frame propagated in parallel by the threads of the pool"};
+  Configurable<int> coreBudget{"coreBudget", 0, "cores used by the thread pool of the device, this thread included (0: cores of the process or O2PHYSICS_CORE_BUDGET)"};
+  Configurable<float> minPtCovPropagation{"minPtCovPropagation", 0.f, "processCovariance: tracks below this pT are propagated without covariance matrix, which is kept at the innermost update point"};
+  Configurable<float> maxEtaCovPropagation{"maxEtaCovPropagation", 1e10f, "processCovariance: tracks beyond this |eta| are propagated without covariance matrix, which is kept at the innermost update point"};
+
+  static constexpr int kNoPropagation = -1;         // vertex index of the tracks filled unpropagated
+  static constexpr int kNTracksPerThreadMin = 1000; // below this, tracks are not worth a thread
+
+  // per data frame buffers, indexed by track row, apart from the propagation order
+  std::vector<o2::track::TrackPar> trackPars;
+  std::vector<o2::track::TrackParCov> trackParCovs;
+  std::vector<gpu::gpustd::array<float, 2>> dcaInfos;
+  std::vector<o2::dataformats::DCA> dcaInfoCovs;
+  std::vector<int> vertexIds;                        // row of the collision, number of collisions for the mean vertex, kNoPropagation
+  std::vector<o2::dataformats::VertexBase> vertices; // collisions, followed by the mean vertex
+  std::vector<int> propagationOrder;                 // rows of the tracks to propagate, grouped by vertex
 
   void init(o2::framework::InitContext& initContext)
   {
     if (doprocessCovariance == true && doprocessStandard == true) {
       LOGF(fatal, "Cannot enable processStandard and processCovariance at the same time. Please choose one.");
     }
+    if (coreBudget > 0) {
+      o2::analysis::ThreadPool::instance().setCoreBudget(coreBudget);
+    }
 
     // Checking if the tables are requested in the workflow and enabling them
     auto& workflows = initContext.services().get<RunningWorkflowInfo const>();
@@ -89,23 +114,71 @@ struct TrackPropagation {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
 
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(lutPath));
-    if (!o2::base::GeometryManager::isGeometryLoaded()) {
-      ccdb->get<TGeoManager>(geoPath);
+    o2::analysis::RunConditionsSettings settings;
+    settings.grpmagPath = grpmagPath;
+    settings.meanVertexPath = mVtxPath;
+    settings.lutPath = lutPath;
+    settings.geoPath = geoPath;
+    settings.useGRPObject = false;
+    settings.loadMeanVertex = true;
+    runConditions.init(&(*ccdb), settings);
+    runConditions.setRunChangeCallback([this](o2::analysis::RunConditions const& conditions) { mVtx = conditions.meanVertex.get(); });
+  }
+
+  /// Copies the vertices of the data frame, the mean vertex being appended after the collisions
+  void fillVertices(aod::Collisions const& collisions)
+  {
+    vertices.resize(collisions.size() + 1);
+    for (auto& collision : collisions) {
+      auto& vtx = vertices[collision.globalIndex()];
+      vtx.setPos({collision.posX(), collision.posY(), collision.posZ()});
+      vtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
     }
+    auto& vtx = vertices.back();
+    vtx.setPos({mVtx->getX(), mVtx->getY(), mVtx->getZ()});
+    vtx.setCov(mVtx->getSigmaX() * mVtx->getSigmaX(), 0.0f, mVtx->getSigmaY() * mVtx->getSigmaY(), 0.0f, 0.0f, mVtx->getSigmaZ() * mVtx->getSigmaZ());
   }
 
-  void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
+  /// Stores the vertex to which a track is propagated, if any
+  template <typename TTrack>
+  void setVertexId(TTrack const& track)
   {
-    if (runNumber == bc.runNumber()) {
-      return;
+    // Only propagate tracks which have passed the innermost wall of the TPC (e.g. skipping loopers etc). Others fill unpropagated.
+    int vertexId = kNoPropagation;
+    if (track.x() < o2::constants::geom::XTPCInnerRef + 0.1) {
+      vertexId = track.has_collision() ? track.collisionId() : static_cast<int>(vertices.size()) - 1;
+    }
+    vertexIds[track.globalIndex()] = vertexId;
+  }
+
+  /// Orders the tracks to propagate by vertex (counting sort) and propagates them in parallel
+  /// \param propagate  function propagating the track of a given row
+  template <typename TPropagate>
+  void propagateAll(TPropagate&& propagate)
+  {
+    std::vector<int> offsets(vertices.size() + 1, 0);
+    for (auto vertexId : vertexIds) {
+      if (vertexId != kNoPropagation) {
+        ++offsets[vertexId + 1];
+      }
+    }
+    for (size_t iVtx = 1; iVtx < offsets.size(); ++iVtx) {
+      offsets[iVtx] += offsets[iVtx - 1];
     }
-    grpmag = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(grpmagPath, bc.timestamp());
-    LOG(info) << "Setting magnetic field to current " << grpmag->getL3Current() << " A for run " << bc.runNumber() << " from its GRPMagField CCDB object";
-    o2::base::Propagator::initFieldFromGRP(grpmag);
-    o2::base::Propagator::Instance()->setMatLUT(lut);
-    mVtx = ccdb->getForTimeStamp<o2::dataformats::MeanVertexObject>(mVtxPath, bc.timestamp());
-    runNumber = bc.runNumber();
+    propagationOrder.resize(offsets.back());
+    for (size_t iTrack = 0; iTrack < vertexIds.size(); ++iTrack) {
+      if (vertexIds[iTrack] != kNoPropagation) {
+        propagationOrder[offsets[vertexIds[iTrack]]++] = iTrack;
+      }
+    }
+
+    auto propagateRange = [&](size_t first, size_t last) {
+      for (auto i = first; i < last; ++i) {
+        propagate(propagationOrder[i]);
+      }
+    };
+    const size_t nTracks = propagationOrder.size();
+    o2::analysis::ThreadPool::instance().parallelFor(nTracks, o2::analysis::ThreadPool::nChunks(nTracks, kNTracksPerThreadMin, nThreads), [&](size_t, size_t first, size_t last) { propagateRange(first, last); });
   }
 
   template <typename TTrack, typename TTrackPar>
@@ -115,62 +188,67 @@ struct TrackPropagation {
     tracksParExtensionPropagated(trackPar.getPt(), trackPar.getP(), trackPar.getEta(), trackPar.getPhi());
   }
 
-  void processStandard(aod::StoredTracksIU const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const& bcs)
+  void processStandard(aod::StoredTracksIU const& tracks, aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs)
   {
     if (bcs.size() == 0) {
       return;
     }
-    initCCDB(bcs.begin());
+    runConditions.update(bcs.begin());
 
-    gpu::gpustd::array<float, 2> dcaInfo;
+    fillVertices(collisions);
+    trackPars.resize(tracks.size());
+    dcaInfos.assign(tracks.size(), {999, 999});
+    vertexIds.resize(tracks.size());
+    for (auto& track : tracks) {
+      trackPars[track.globalIndex()] = getTrackPar(track);
+      setVertexId(track);
+    }
+
+    propagateAll([this](int iTrack) {
+      o2::base::Propagator::Instance()->propagateToDCABxByBz(vertices[vertexIds[iTrack]].getXYZ(), trackPars[iTrack], 2.f, matCorr, &dcaInfos[iTrack]);
+    });
 
     for (auto& track : tracks) {
-      dcaInfo[0] = 999;
-      dcaInfo[1] = 999;
-      auto trackPar = getTrackPar(track);
-      // Only propagate tracks which have passed the innermost wall of the TPC (e.g. skipping loopers etc). Others fill unpropagated.
-      if (track.x() < o2::constants::geom::XTPCInnerRef + 0.1) {
-        if (track.has_collision()) {
-          auto const& collision = track.collision();
-          o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackPar, 2.f, matCorr, &dcaInfo);
-        } else {
-          o2::base::Propagator::Instance()->propagateToDCABxByBz({mVtx->getX(), mVtx->getY(), mVtx->getZ()}, trackPar, 2.f, matCorr, &dcaInfo);
-        }
-      }
-      FillTracksPar(track, trackPar);
+      FillTracksPar(track, trackPars[track.globalIndex()]);
       if (fillTracksDCA) {
-        tracksDCA(dcaInfo[0], dcaInfo[1]);
+        tracksDCA(dcaInfos[track.globalIndex()][0], dcaInfos[track.globalIndex()][1]);
       }
     }
   }
   PROCESS_SWITCH(TrackPropagation, processStandard, "Process without covariance", true);
 
-  void processCovariance(soa::Join<aod::StoredTracksIU, aod::TracksCovIU> const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const& bcs)
+  void processCovariance(soa::Join<aod::StoredTracksIU, aod::TracksCovIU> const& tracks, aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs)
   {
     if (bcs.size() == 0) {
       return;
     }
-    initCCDB(bcs.begin());
-
-    o2::dataformats::DCA dcaInfoCov;
-    o2::dataformats::VertexBase vtx;
+    runConditions.update(bcs.begin());
 
+    fillVertices(collisions);
+    trackParCovs.resize(tracks.size());
+    dcaInfoCovs.resize(tracks.size());
+    vertexIds.resize(tracks.size());
     for (auto& track : tracks) {
-      dcaInfoCov.set(999, 999, 999, 999, 999);
-      auto trackParCov = getTrackParCov(track);
-      // Only propagate tracks which have passed the innermost wall of the TPC (e.g. skipping loopers etc). Others fill unpropagated.
-      if (track.x() < o2::constants::geom::XTPCInnerRef + 0.1) {
-        if (track.has_collision()) {
-          auto const& collision = track.collision();
-          vtx.setPos({collision.posX(), collision.posY(), collision.posZ()});
-          vtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
-          o2::base::Propagator::Instance()->propagateToDCABxByBz(vtx, trackParCov, 2.f, matCorr, &dcaInfoCov);
-        } else {
-          vtx.setPos({mVtx->getX(), mVtx->getY(), mVtx->getZ()});
-          vtx.setCov(mVtx->getSigmaX() * mVtx->getSigmaX(), 0.0f, mVtx->getSigmaY() * mVtx->getSigmaY(), 0.0f, 0.0f, mVtx->getSigmaZ() * mVtx->getSigmaZ());
-          o2::base::Propagator::Instance()->propagateToDCABxByBz(vtx, trackParCov, 2.f, matCorr, &dcaInfoCov);
-        }
+      trackParCovs[track.globalIndex()] = getTrackParCov(track);
+      dcaInfoCovs[track.globalIndex()].set(999, 999, 999, 999, 999);
+      setVertexId(track);
+    }
+
+    propagateAll([this](int iTrack) {
+      auto& trackParCov = trackParCovs[iTrack];
+      if (trackParCov.getPt() < minPtCovPropagation || std::abs(trackParCov.getEta()) > maxEtaCovPropagation) {
+        // cheap preselection failed: only the track parameters are propagated
+        gpu::gpustd::array<float, 2> dcaInfo{999, 999};
+        o2::base::Propagator::Instance()->propagateToDCABxByBz(vertices[vertexIds[iTrack]].getXYZ(), static_cast<o2::track::TrackPar&>(trackParCov), 2.f, matCorr, &dcaInfo);
+        dcaInfoCovs[iTrack].set(dcaInfo[0], dcaInfo[1], 999, 999, 999);
+      } else {
+        o2::base::Propagator::Instance()->propagateToDCABxByBz(vertices[vertexIds[iTrack]], trackParCov, 2.f, matCorr, &dcaInfoCovs[iTrack]);
       }
+    });
+
+    for (auto& track : tracks) {
+      auto const& trackParCov = trackParCovs[track.globalIndex()];
+      auto const& dcaInfoCov = dcaInfoCovs[track.globalIndex()];
       FillTracksPar(track, trackParCov);
       if (fillTracksDCA) {
         tracksDCA(dcaInfoCov.getY(), dcaInfoCov.getZ());
@@ -20,11 +20,11 @@
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/RunConditionsCache.h"
 #include "ReconstructionDataFormats/DCA.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
 #include "CommonUtils/NameConf.h"
-#include "DataFormatsParameters/GRPObject.h"
 #include <CCDB/BasicCCDBManager.h>
 
 using namespace o2;
@@ -56,9 +56,7 @@ struct TrackExtension {
   Produces<aod::TracksDCA> extendedTrackQuantities;
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
-  o2::base::MatLayerCylSet* lut;
-  int mRunNumber;
-  float mMagField;
+  o2::analysis::RunConditionsCache runConditions;
 
   void init(InitContext& context)
   {
@@ -68,13 +66,11 @@ struct TrackExtension {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
 
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbpath_lut));
-
-    if (!o2::base::GeometryManager::isGeometryLoaded()) {
-      ccdb->get<TGeoManager>(ccdbpath_geo);
-    }
-    mRunNumber = 0;
-    mMagField = 0.0;
+    o2::analysis::RunConditionsSettings settings;
+    settings.grpPath = ccdbpath_grp;
+    settings.lutPath = ccdbpath_lut;
+    settings.geoPath = ccdbpath_geo;
+    runConditions.init(&(*ccdb), settings);
   }
 
   void processRun2(aod::FullTracks const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const&)
@@ -85,20 +81,10 @@ struct TrackExtension {
       std::array<float, 2> dca{1e10f, 1e10f};
       if (track.has_collision()) {
         if (track.trackType() == o2::aod::track::TrackTypeEnum::Run2Track && track.itsChi2NCl() != 0.f && track.tpcChi2NCl() != 0.f && std::abs(track.x()) < 10.f) {
-          auto bc = track.collision_as<aod::Collisions>().bc_as<aod::BCsWithTimestamps>();
-          if (mRunNumber != bc.runNumber()) {
-            o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbpath_grp, bc.timestamp());
-            if (grpo != nullptr) {
-              mMagField = grpo->getNominalL3Field();
-              LOGF(info, "Setting magnetic field to %f kG for run %d", mMagField, bc.runNumber());
-            } else {
-              LOGF(fatal, "GRP object is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-            }
-            mRunNumber = bc.runNumber();
-          }
+          runConditions.update(track.collision_as<aod::Collisions>().bc_as<aod::BCsWithTimestamps>());
           auto trackPar = getTrackPar(track);
           auto const& collision = track.collision();
-          trackPar.propagateParamToDCA({collision.posX(), collision.posY(), collision.posZ()}, mMagField, &dca);
+          trackPar.propagateParamToDCA({collision.posX(), collision.posY(), collision.posZ()}, runConditions.getBz(), &dca);
         }
       }
       extendedTrackQuantities(dca[0], dca[1]);
@@ -123,18 +109,7 @@ struct TrackExtension {
       std::array<float, 2> dca{1e10f, 1e10f};
       if (track.has_collision()) {
         if (track.trackType() == o2::aod::track::TrackTypeEnum::Track) {
-          auto bc = track.collision_as<aod::Collisions>().bc_as<aod::BCsWithTimestamps>();
-          if (mRunNumber != bc.runNumber()) {
-            auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbpath_grp, bc.timestamp());
-            if (grpo != nullptr) {
-              o2::base::Propagator::initFieldFromGRP(grpo);
-              o2::base::Propagator::Instance()->setMatLUT(lut);
-              LOGF(info, "Setting magnetic field to %d kG for run %d from its GRP CCDB object", grpo->getNominalL3Field(), bc.runNumber());
-            } else {
-              LOGF(fatal, "GRP object is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-            }
-            mRunNumber = bc.runNumber();
-          }
+          runConditions.update(track.collision_as<aod::Collisions>().bc_as<aod::BCsWithTimestamps>());
           auto trackPar = getTrackPar(track);
           auto const& collision = track.collision();
           gpu::gpustd::array<float, 2> dcaInfo;
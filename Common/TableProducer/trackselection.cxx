@@ -24,6 +24,7 @@
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/TableHelper.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -37,14 +38,16 @@ using namespace o2::framework::expressions;
 struct TrackSelectionTask {
   // FIXME: this will be removed once we can get this via meta data
   Configurable<bool> isRun3{"isRun3", false, "temp option to enable run3 mode"};
+  Configurable<int> produceTable{"produceTable", 1, "Produce the TrackSelection table: 0 - no, 1 - yes, -1 - only if it is required in the workflow"};
 
   Produces<aod::TrackSelection> filterTable;
 
   TrackSelection globalTracks;
   TrackSelection globalTracksSDD;
 
-  void init(InitContext&)
+  void init(InitContext& initContext)
   {
+    enableFlagIfTableRequired(initContext, "TrackSelection", produceTable);
     globalTracks = getGlobalTrackSelection();
     globalTracksSDD = getGlobalTrackSelectionSDD();
 
@@ -53,11 +56,22 @@ struct TrackSelectionTask {
     }
   }
 
+  TrackSelection::TrackColumns trackColumns;
+  std::vector<uint16_t> globalMasks;
+  std::vector<uint16_t> globalSDDMasks;
+
   void process(soa::Join<aod::FullTracks, aod::TracksDCA> const& tracks)
   {
-    for (auto& track : tracks) {
-      filterTable((uint8_t)globalTracksSDD.IsSelected(track),
-                  globalTracks.IsSelectedMask(track));
+    if (produceTable < 1) {
+      return;
+    }
+    // the columns are copied once and shared by the two selections
+    trackColumns.fill(tracks);
+    globalTracks.IsSelectedMasks(trackColumns, globalMasks);
+    globalTracksSDD.IsSelectedMasks(trackColumns, globalSDDMasks);
+    for (size_t i = 0; i < trackColumns.size(); ++i) {
+      filterTable((uint8_t)(globalSDDMasks[i] == TrackSelection::kAllCutsMask),
+                  globalMasks[i]);
     }
   }
 };
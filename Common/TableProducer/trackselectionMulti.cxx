@@ -0,0 +1,218 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   trackselectionMulti.cxx
+///
+/// \brief Task evaluating several named track selections in one pass over the tracks.
+///        Bit i of the produced mask is set if the track passed all the cuts of the i-th configured selection.
+///
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+#include "Common/Core/TrackSelection.h"
+#include "Common/DataModel/TrackSelectionTables.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+namespace
+{
+enum SelectionParameter {
+  kTrackType = 0,
+  kMinPt,
+  kMaxPt,
+  kMinEta,
+  kMaxEta,
+  kMinNClsTPC,
+  kMinNCrossedRowsTPC,
+  kMinNCrossedRowsOverFindableTPC,
+  kMaxChi2PerClsTPC,
+  kRequireTPCRefit,
+  kMinNClsITS,
+  kMaxChi2PerClsITS,
+  kRequireITSRefit,
+  kITSHits,
+  kRequireGoldenChi2,
+  kMaxDcaXY,
+  kMaxDcaZ,
+  kNSelectionParameters
+};
+static const std::vector<std::string> parameterNames{
+  "TrackType", "MinPt", "MaxPt", "MinEta", "MaxEta",
+  "MinNClsTPC", "MinNCrossedRowsTPC", "MinNCrossedRowsOverFindableTPC", "MaxChi2PerClsTPC", "RequireTPCRefit",
+  "MinNClsITS", "MaxChi2PerClsITS", "RequireITSRefit", "ITSHits", "RequireGoldenChi2",
+  "MaxDcaXY", "MaxDcaZ"};
+static constexpr int nDefaultSelections = 4;
+static const std::vector<std::string> defaultSelectionNames{"Global", "GlobalSDD", "ITSOnly", "TPCOnly"};
+// ITSHits: 0 no requirement, 1 one hit in the SPD, 2 no hit in the SPD and one in the first SDD layer
+// MaxDcaXY: a negative value selects the pT dependent cut of the global tracks
+static constexpr float defaultSelections[nDefaultSelections][kNSelectionParameters]{
+  {254.f, 0.1f, 1e10f, -0.8f, 0.8f, 0.f, 70.f, 0.8f, 4.f, 1.f, 0.f, 36.f, 1.f, 1.f, 1.f, -1.f, 2.f},      /*Global*/
+  {254.f, 0.1f, 1e10f, -0.8f, 0.8f, 0.f, 70.f, 0.8f, 4.f, 1.f, 0.f, 36.f, 1.f, 2.f, 1.f, -1.f, 2.f},      /*GlobalSDD*/
+  {254.f, 0.1f, 1e10f, -0.8f, 0.8f, 0.f, 0.f, 0.f, 1e10f, 0.f, 4.f, 36.f, 1.f, 1.f, 0.f, -1.f, 2.f},      /*ITSOnly*/
+  {254.f, 0.1f, 1e10f, -0.8f, 0.8f, 50.f, 70.f, 0.8f, 4.f, 1.f, 0.f, 1e10f, 0.f, 0.f, 0.f, 2.4f, 3.2f}}; /*TPCOnly*/
+
+// configuration parameters each cut depends on, a cut is evaluated once for all the selections sharing them
+static const std::vector<std::vector<int>> cutParameters{
+  {kTrackType},                      /*kTrackType*/
+  {kMinPt, kMaxPt},                  /*kPtRange*/
+  {kMinEta, kMaxEta},                /*kEtaRange*/
+  {kMinNClsTPC},                     /*kTPCNCls*/
+  {kMinNCrossedRowsTPC},             /*kTPCCrossedRows*/
+  {kMinNCrossedRowsOverFindableTPC}, /*kTPCCrossedRowsOverNCls*/
+  {kMaxChi2PerClsTPC},               /*kTPCChi2NDF*/
+  {kRequireTPCRefit},                /*kTPCRefit*/
+  {kMinNClsITS},                     /*kITSNCls*/
+  {kMaxChi2PerClsITS},               /*kITSChi2NDF*/
+  {kRequireITSRefit},                /*kITSRefit*/
+  {kITSHits},                        /*kITSHits*/
+  {kRequireGoldenChi2},              /*kGoldenChi2*/
+  {kMaxDcaXY},                       /*kDCAxy*/
+  {kMaxDcaZ}};                       /*kDCAz*/
+} // namespace
+
+//****************************************************************************************
+/**
+ * Produce the multi-selection track filter table.
+ */
+//****************************************************************************************
+struct MultiTrackSelectionTask {
+  // FIXME: this will be removed once we can get this via meta data
+  Configurable<bool> isRun3{"isRun3", false, "temp option to enable run3 mode, overrides the track type of all the selections"};
+  Configurable<LabeledArray<float>> cfgSelections{"selections", {defaultSelections[0], nDefaultSelections, kNSelectionParameters, defaultSelectionNames, parameterNames}, "Named track selections, one per row, bit i of the mask corresponds to row i"};
+
+  Produces<aod::TrackSelectionsMulti> filterTable;
+
+  std::vector<TrackSelection> selections;
+  // for each selection and cut, the earlier selection whose result is reused, -1 if the cut is evaluated
+  std::vector<std::array<int, static_cast<int>(TrackSelection::TrackCuts::kNCuts)>> sharedCuts;
+  TrackSelection::TrackColumns trackColumns;
+  std::vector<std::vector<uint16_t>> masks;
+  std::vector<uint32_t> selectionBits;
+
+  float parameter(int iSelection, int iParameter)
+  {
+    if (iParameter == kTrackType && isRun3) {
+      return static_cast<float>(o2::aod::track::TrackTypeEnum::Track);
+    }
+    return cfgSelections->get(iSelection, iParameter);
+  }
+
+  void init(InitContext&)
+  {
+    const int nSelections = cfgSelections->getLabelsRows().size();
+    if (nSelections > 32) {
+      LOGF(fatal, "At most 32 track selections can be stored in the mask, %d configured", nSelections);
+    }
+    for (int iSel = 0; iSel < nSelections; ++iSel) {
+      TrackSelection selection;
+      selection.SetTrackType(static_cast<o2::aod::track::TrackTypeEnum>(static_cast<int>(parameter(iSel, kTrackType))));
+      selection.SetPtRange(parameter(iSel, kMinPt), parameter(iSel, kMaxPt));
+      selection.SetEtaRange(parameter(iSel, kMinEta), parameter(iSel, kMaxEta));
+      selection.SetMinNClustersTPC(static_cast<int>(parameter(iSel, kMinNClsTPC)));
+      selection.SetMinNCrossedRowsTPC(static_cast<int>(parameter(iSel, kMinNCrossedRowsTPC)));
+      selection.SetMinNCrossedRowsOverFindableClustersTPC(parameter(iSel, kMinNCrossedRowsOverFindableTPC));
+      selection.SetMaxChi2PerClusterTPC(parameter(iSel, kMaxChi2PerClsTPC));
+      selection.SetRequireTPCRefit(parameter(iSel, kRequireTPCRefit) > 0.5f);
+      selection.SetMinNClustersITS(static_cast<int>(parameter(iSel, kMinNClsITS)));
+      selection.SetMaxChi2PerClusterITS(parameter(iSel, kMaxChi2PerClsITS));
+      selection.SetRequireITSRefit(parameter(iSel, kRequireITSRefit) > 0.5f);
+      switch (static_cast<int>(parameter(iSel, kITSHits))) {
+        case 0:
+          break;
+        case 1:
+          selection.SetRequireHitsInITSLayers(1, {0, 1}); // one hit in any SPD layer
+          break;
+        case 2:
+          selection.SetRequireNoHitsInITSLayers({0, 1}); // no hit in SPD layers
+          selection.SetRequireHitsInITSLayers(1, {2});   // one hit in first SDD layer
+          break;
+        default:
+          LOGF(fatal, "Unknown ITS hit requirement %d for track selection %s", static_cast<int>(parameter(iSel, kITSHits)), cfgSelections->getLabelsRows()[iSel].c_str());
+      }
+      selection.SetRequireGoldenChi2(parameter(iSel, kRequireGoldenChi2) > 0.5f);
+      if (parameter(iSel, kMaxDcaXY) < 0.f) {
+        selection.SetMaxDcaXYPtDep([](float pt) { return 0.0105f + 0.0350f / pow(pt, 1.1f); });
+      } else {
+        selection.SetMaxDcaXY(parameter(iSel, kMaxDcaXY));
+      }
+      selection.SetMaxDcaZ(parameter(iSel, kMaxDcaZ));
+      selections.push_back(selection);
+
+      auto& shared = sharedCuts.emplace_back();
+      for (int iCut = 0; iCut < static_cast<int>(TrackSelection::TrackCuts::kNCuts); ++iCut) {
+        shared[iCut] = -1;
+        for (int iOther = 0; iOther < iSel && shared[iCut] < 0; ++iOther) {
+          // the first selection with these parameters is the one which evaluated the cut
+          bool same = true;
+          for (auto iParameter : cutParameters[iCut]) {
+            same = same && parameter(iSel, iParameter) == parameter(iOther, iParameter);
+          }
+          if (same) {
+            shared[iCut] = iOther;
+          }
+        }
+      }
+      LOGF(info, "Track selection %d: %s", iSel, cfgSelections->getLabelsRows()[iSel].c_str());
+    }
+    masks.resize(nSelections);
+  }
+
+  void process(soa::Join<aod::FullTracks, aod::TracksDCA> const& tracks)
+  {
+    trackColumns.fill(tracks);
+    const size_t nTracks = trackColumns.size();
+    selectionBits.assign(nTracks, 0);
+    for (size_t iSel = 0; iSel < selections.size(); ++iSel) {
+      auto& mask = masks[iSel];
+      mask.assign(nTracks, 0);
+      bool fillLookupTables = true;
+      for (int iCut = 0; iCut < static_cast<int>(TrackSelection::TrackCuts::kNCuts); ++iCut) {
+        const int iShared = sharedCuts[iSel][iCut];
+        if (iShared < 0) {
+          selections[iSel].SetCutBits(trackColumns, static_cast<TrackSelection::TrackCuts>(iCut), mask, fillLookupTables);
+          fillLookupTables = false;
+        } else {
+          const uint16_t bit = 1 << iCut;
+          const auto& sharedMask = masks[iShared];
+          for (size_t i = 0; i < nTracks; ++i) {
+            mask[i] |= sharedMask[i] & bit;
+          }
+        }
+      }
+      const uint32_t selectionBit = 1u << iSel;
+      for (size_t i = 0; i < nTracks; ++i) {
+        selectionBits[i] |= (mask[i] == TrackSelection::kAllCutsMask) ? selectionBit : 0u;
+      }
+    }
+    for (size_t i = 0; i < nTracks; ++i) {
+      filterTable(selectionBits[i]);
+    }
+  }
+};
+
+//****************************************************************************************
+/**
+ * Workflow definition.
+ */
+//****************************************************************************************
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  WorkflowSpec workflow{adaptAnalysisTask<MultiTrackSelectionTask>(cfgc, TaskName{"track-selection-multi"})};
+  return workflow;
+}
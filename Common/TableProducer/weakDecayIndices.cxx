@@ -12,22 +12,62 @@
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 
+#include <arrow/array.h>
+#include <arrow/table.h>
+#include <vector>
+
 using namespace o2;
 using namespace o2::framework;
 
 // Converts V0 and cascade version 000 to 001
 // Build indices to group V0s and cascades to collisions
+// The index columns are read in bulk from the arrow tables, and the collision of each track is gathered from the
+// collision index column of the tracks, instead of dereferencing the track iterators of each V0 and cascade
+
+namespace
+{
+// Copies an int32 column of a table into a contiguous vector
+template <typename TColumn, typename TTable>
+std::vector<int> readIntColumn(TTable const& table)
+{
+  std::vector<int> values;
+  values.reserve(table.size());
+  auto column = table.asArrowTable()->GetColumnByName(TColumn::mLabel);
+  for (int iChunk = 0; iChunk < column->num_chunks(); iChunk++) {
+    auto chunk = std::static_pointer_cast<arrow::NumericArray<arrow::Int32Type>>(column->chunk(iChunk));
+    values.insert(values.end(), chunk->raw_values(), chunk->raw_values() + chunk->length());
+  }
+  return values;
+}
+
+// Collision index of the track of each entry of trackIds
+std::vector<int> gatherCollisionIds(std::vector<int> const& trackIds, std::vector<int> const& trackCollisionIds)
+{
+  std::vector<int> collisionIds(trackIds.size());
+  for (size_t i = 0; i < trackIds.size(); i++) {
+    collisionIds[i] = trackCollisionIds[trackIds[i]];
+  }
+  return collisionIds;
+}
+} // namespace
 
 struct WeakDecayIndicesV0 {
   Produces<aod::V0s_001> v0s_001;
 
   void process(aod::V0s_000 const& v0s, aod::Tracks const& tracks)
   {
-    for (auto& v0 : v0s) {
-      if (v0.posTrack().collisionId() != v0.negTrack().collisionId()) {
-        LOGF(fatal, "V0 %d has inconsistent collision information (%d, %d)", v0.globalIndex(), v0.posTrack().collisionId(), v0.negTrack().collisionId());
+    const auto trackCollisionIds = readIntColumn<aod::track::CollisionId>(tracks);
+    const auto posTrackIds = readIntColumn<aod::v0::PosTrackId>(v0s);
+    const auto negTrackIds = readIntColumn<aod::v0::NegTrackId>(v0s);
+    const auto posCollisionIds = gatherCollisionIds(posTrackIds, trackCollisionIds);
+    const auto negCollisionIds = gatherCollisionIds(negTrackIds, trackCollisionIds);
+
+    v0s_001.reserve(posTrackIds.size());
+    for (size_t i = 0; i < posTrackIds.size(); i++) {
+      if (posCollisionIds[i] != negCollisionIds[i]) {
+        LOGF(fatal, "V0 %d has inconsistent collision information (%d, %d)", (int)i, posCollisionIds[i], negCollisionIds[i]);
       }
-      v0s_001(v0.posTrack().collisionId(), v0.posTrackId(), v0.negTrackId());
+      v0s_001(posCollisionIds[i], posTrackIds[i], negTrackIds[i]);
     }
   }
 };
@@ -38,12 +78,22 @@ struct WeakDecayIndicesCascades {
 
   void process(aod::V0s const& v0s, aod::Cascades_000 const& cascades, aod::Tracks const& tracks)
   {
-    for (auto& cascade : cascades) {
-      if (cascade.bachelor().collisionId() != cascade.v0().posTrack().collisionId() || cascade.v0().posTrack().collisionId() != cascade.v0().negTrack().collisionId()) {
-        LOGF(fatal, "Cascade %d has inconsistent collision information (%d, %d, %d) track ids %d %d %d", cascade.globalIndex(), cascade.bachelor().collisionId(),
-             cascade.v0().posTrack().collisionId(), cascade.v0().negTrack().collisionId(), cascade.bachelorId(), cascade.v0().posTrackId(), cascade.v0().negTrackId());
+    const auto trackCollisionIds = readIntColumn<aod::track::CollisionId>(tracks);
+    const auto v0PosCollisionIds = gatherCollisionIds(readIntColumn<aod::v0::PosTrackId>(v0s), trackCollisionIds);
+    const auto v0NegCollisionIds = gatherCollisionIds(readIntColumn<aod::v0::NegTrackId>(v0s), trackCollisionIds);
+    const auto v0Ids = readIntColumn<aod::cascade::V0Id>(cascades);
+    const auto bachelorIds = readIntColumn<aod::cascade::BachelorId>(cascades);
+    const auto bachelorCollisionIds = gatherCollisionIds(bachelorIds, trackCollisionIds);
+
+    cascades_001.reserve(v0Ids.size());
+    for (size_t i = 0; i < v0Ids.size(); i++) {
+      const int posCollisionId = v0PosCollisionIds[v0Ids[i]];
+      const int negCollisionId = v0NegCollisionIds[v0Ids[i]];
+      if (bachelorCollisionIds[i] != posCollisionId || posCollisionId != negCollisionId) {
+        LOGF(fatal, "Cascade %d has inconsistent collision information (%d, %d, %d) track ids %d %d %d", (int)i, bachelorCollisionIds[i],
+             posCollisionId, negCollisionId, bachelorIds[i], v0s.rawIteratorAt(v0Ids[i]).posTrackId(), v0s.rawIteratorAt(v0Ids[i]).negTrackId());
       }
-      cascades_001(cascade.bachelor().collisionId(), cascade.v0Id(), cascade.bachelorId());
+      cascades_001(bachelorCollisionIds[i], v0Ids[i], bachelorIds[i]);
     }
   }
 };
@@ -20,6 +20,8 @@
 #include "DataFormatsParameters/GRPLHCIFData.h"
 #include "TH1F.h"
 #include "TH2F.h"
+#include <array>
+#include <string>
 using namespace o2::framework;
 using namespace o2;
 using namespace evsel;
@@ -27,6 +29,60 @@ using namespace evsel;
 using BCsRun2 = soa::Join<aod::BCs, aod::Run2BCInfos, aod::Timestamps, aod::BcSels, aod::Run2MatchedToBCSparse>;
 using BCsRun3 = soa::Join<aod::BCs, aod::Timestamps, aod::BcSels, aod::Run3MatchedToBCSparse>;
 
+/// Alias and selection counters of one data frame, accumulated in plain arrays and added once to the counter histograms
+struct SelectionCounters {
+  std::array<uint64_t, kNaliases> bcAll{};                       ///< bcs per alias
+  std::array<uint64_t, kNaliases> colAll{};                      ///< collisions per alias
+  std::array<uint64_t, kNaliases> colAcc{};                      ///< accepted collisions per alias
+  std::array<uint64_t, kNsel> sel{};                             ///< counted collisions per selection bit
+  std::array<std::array<uint64_t, kNsel>, kNaliases> aliasSel{}; ///< collisions per alias and selection bit
+  uint64_t nBCs = 0;                                             ///< bcs, each one filled kNaliases times in hBcCounterAll
+  uint64_t nSelFills = 0;                                        ///< collisions counted in hSelCounter, each one filled kNsel times
+
+  void reset() { *this = SelectionCounters{}; }
+
+  /// Counts the aliases of a bc
+  template <typename TBC>
+  void countBC(TBC const& bc)
+  {
+    auto alias = bc.alias();
+    for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
+      bcAll[iAlias] += alias[iAlias] != 0;
+    }
+    nBCs++;
+  }
+
+  /// Counts the aliases of a collision, of all of them and of the accepted ones, and the aliases x selection bits
+  template <typename TCollision>
+  void countCollision(TCollision const& col, bool accepted)
+  {
+    auto alias = col.alias();
+    auto selection = col.selection();
+    for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
+      if (!alias[iAlias]) {
+        continue;
+      }
+      colAll[iAlias]++;
+      colAcc[iAlias] += accepted;
+      auto& row = aliasSel[iAlias];
+      for (int i = 0; i < kNsel; i++) {
+        row[i] += selection[i] != 0;
+      }
+    }
+  }
+
+  /// Counts the selection bits of a collision
+  template <typename TCollision>
+  void countSelection(TCollision const& col)
+  {
+    auto selection = col.selection();
+    for (int i = 0; i < kNsel; i++) {
+      sel[i] += selection[i] != 0;
+    }
+    nSelFills++;
+  }
+};
+
 struct EventSelectionQaTask {
   Configurable<bool> isMC{"isMC", 0, "0 - data, 1 - MC"};
   Configurable<double> minGlobalBC{"minGlobalBC", 0, "minimum global bc"};
@@ -35,12 +91,15 @@ struct EventSelectionQaTask {
   Configurable<int> nOrbits{"nOrbits", 10000, "number of orbits"};
   Configurable<int> refBC{"refBC", 1238, "reference bc"};
   Configurable<bool> isLowFlux{"isLowFlux", 1, "1 - low flux (pp, pPb), 0 - high flux (PbPb)"};
+  Configurable<bool> summaryOnly{"summaryOnly", false, "fill only the alias and selection counters, the per-run summaries and the orbit time series, not the detector histograms"};
+  Configurable<bool> doPerRunSummary{"doPerRunSummary", false, "fill the alias and selection counters per run, in histograms with one row per run"};
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
   bool* applySelection = NULL;
   int nBCsPerOrbit = 3564;
   int lastRunNumber = -1;
+  SelectionCounters counters;
 
   std::bitset<o2::constants::lhc::LHCMaxBunches> beamPatternA;
   std::bitset<o2::constants::lhc::LHCMaxBunches> beamPatternC;
@@ -55,6 +114,50 @@ struct EventSelectionQaTask {
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
 
+    histos.add("hColCounterAll", "", kTH1F, {{kNaliases, 0, kNaliases}});
+    histos.add("hColCounterAcc", "", kTH1F, {{kNaliases, 0, kNaliases}});
+    histos.add("hBcCounterAll", "", kTH1F, {{kNaliases, 0, kNaliases}});
+    histos.add("hSelCounter", "", kTH1F, {{kNsel, 0, kNsel}});
+    histos.add("hSelMask", "", kTH1F, {{kNsel, 0, kNsel}});
+    histos.add("hAliasSelCounter", "All events;;", kTH2F, {{kNaliases, 0, kNaliases}, {kNsel, 0, kNsel}});
+    histos.add("hOrbitAll", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
+    histos.add("hOrbitCol", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
+
+    for (int i = 0; i < kNsel; i++) {
+      histos.get<TH1>(HIST("hSelCounter"))->GetXaxis()->SetBinLabel(i + 1, selectionLabels[i]);
+      histos.get<TH1>(HIST("hSelMask"))->GetXaxis()->SetBinLabel(i + 1, selectionLabels[i]);
+      histos.get<TH2>(HIST("hAliasSelCounter"))->GetYaxis()->SetBinLabel(i + 1, selectionLabels[i]);
+    }
+    for (int i = 0; i < kNaliases; i++) {
+      histos.get<TH1>(HIST("hColCounterAll"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+      histos.get<TH1>(HIST("hColCounterAcc"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+      histos.get<TH1>(HIST("hBcCounterAll"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+      histos.get<TH2>(HIST("hAliasSelCounter"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+    }
+
+    // per-run counters, with one extendable row per run instead of a set of histograms per run
+    if (doPerRunSummary) {
+      histos.add("hRunBcCounterAll", "All bcs;run;", kTH2F, {{1, 0, 1}, {kNaliases, 0, kNaliases}});
+      histos.add("hRunColCounterAll", "All events;run;", kTH2F, {{1, 0, 1}, {kNaliases, 0, kNaliases}});
+      histos.add("hRunColCounterAcc", "Accepted events;run;", kTH2F, {{1, 0, 1}, {kNaliases, 0, kNaliases}});
+      histos.add("hRunSelCounter", "All events;run;", kTH2F, {{1, 0, 1}, {kNsel, 0, kNsel}});
+      for (auto const& h : {histos.get<TH2>(HIST("hRunBcCounterAll")), histos.get<TH2>(HIST("hRunColCounterAll")), histos.get<TH2>(HIST("hRunColCounterAcc"))}) {
+        h->GetXaxis()->SetCanExtend(true);
+        for (int i = 0; i < kNaliases; i++) {
+          h->GetYaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+        }
+      }
+      auto hRunSelCounter = histos.get<TH2>(HIST("hRunSelCounter"));
+      hRunSelCounter->GetXaxis()->SetCanExtend(true);
+      for (int i = 0; i < kNsel; i++) {
+        hRunSelCounter->GetYaxis()->SetBinLabel(i + 1, selectionLabels[i]);
+      }
+    }
+
+    if (summaryOnly) {
+      return;
+    }
+
     float maxMultV0M = isLowFlux ? 40000 : 40000;
     float maxMultV0A = isLowFlux ? 30000 : 30000;
     float maxMultV0C = isLowFlux ? 30000 : 30000;
@@ -129,19 +232,11 @@ struct EventSelectionQaTask {
     histos.add("hSPDOnVsOfAcc", "Accepted events;Offline FOR;Online FOR", kTH2F, {{300, 0., isLowFlux ? 300. : 1200.}, {300, 0., isLowFlux ? 300. : 1200.}});
     histos.add("hV0C3vs012Acc", "Accepted events;V0C012 multiplicity;V0C3 multiplicity", kTH2F, {{200, 0., 800.}, {300, 0., 300.}});
 
-    histos.add("hColCounterAll", "", kTH1F, {{kNaliases, 0, kNaliases}});
-    histos.add("hColCounterAcc", "", kTH1F, {{kNaliases, 0, kNaliases}});
-    histos.add("hBcCounterAll", "", kTH1F, {{kNaliases, 0, kNaliases}});
-    histos.add("hSelCounter", "", kTH1F, {{kNsel, 0, kNsel}});
-    histos.add("hSelMask", "", kTH1F, {{kNsel, 0, kNsel}});
-
     histos.add("hGlobalBcAll", ";;", kTH1F, {{nGlobalBCs, minGlobalBC, minGlobalBC + nGlobalBCs}});
     histos.add("hGlobalBcCol", ";;", kTH1F, {{nGlobalBCs, minGlobalBC, minGlobalBC + nGlobalBCs}});
     histos.add("hGlobalBcFT0", ";;", kTH1F, {{nGlobalBCs, minGlobalBC, minGlobalBC + nGlobalBCs}});
     histos.add("hGlobalBcFV0", ";;", kTH1F, {{nGlobalBCs, minGlobalBC, minGlobalBC + nGlobalBCs}});
     histos.add("hGlobalBcFDD", ";;", kTH1F, {{nGlobalBCs, minGlobalBC, minGlobalBC + nGlobalBCs}});
-    histos.add("hOrbitAll", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
-    histos.add("hOrbitCol", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
     histos.add("hOrbitFT0", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
     histos.add("hOrbitFV0", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
     histos.add("hOrbitFDD", ";;", kTH1F, {{nOrbits, minOrbit, minOrbit + nOrbits}});
@@ -207,15 +302,67 @@ struct EventSelectionQaTask {
     histos.add("hVertexYMC", "", kTH1F, {{1000, -1, 1}});
     histos.add("hVertexZMC", "", kTH1F, {{1000, -10, 10}});
 
-    for (int i = 0; i < kNsel; i++) {
-      histos.get<TH1>(HIST("hSelCounter"))->GetXaxis()->SetBinLabel(i + 1, selectionLabels[i]);
-      histos.get<TH1>(HIST("hSelMask"))->GetXaxis()->SetBinLabel(i + 1, selectionLabels[i]);
+  }
+
+  /// Adds counts to the bins firstBin, firstBin + stride, ... of a histogram, as fills of weight 1, and nZeroFills fills of weight 0
+  /// \note the sum of weights squared is kept as with Fill, which enables it at the first fill of weight 0
+  static void addCounts(TH1* h, uint64_t const* counts, int n, int firstBin, int stride, uint64_t nZeroFills = 0)
+  {
+    if (nZeroFills > 0 && h->GetSumw2N() == 0) {
+      h->Sumw2();
+    }
+    const bool hasSumw2 = h->GetSumw2N() > 0;
+    uint64_t nFills = nZeroFills;
+    for (int i = 0; i < n; i++) {
+      if (counts[i] == 0) {
+        continue;
+      }
+      const int bin = firstBin + i * stride;
+      h->AddBinContent(bin, counts[i]);
+      if (hasSumw2) {
+        h->GetSumw2()->fArray[bin] += counts[i];
+      }
+      nFills += counts[i];
     }
+    if (nFills > 0) {
+      h->SetEntries(h->GetEntries() + nFills);
+    }
+  }
+
+  /// Adds the counters of the data frame to the counter histograms, and to the row of the run in the per-run summaries
+  void flushCounters(int runNumber)
+  {
+    uint64_t nBcAliases = 0;
+    uint64_t nSelBits = 0;
     for (int i = 0; i < kNaliases; i++) {
-      histos.get<TH1>(HIST("hColCounterAll"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
-      histos.get<TH1>(HIST("hColCounterAcc"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
-      histos.get<TH1>(HIST("hBcCounterAll"))->GetXaxis()->SetBinLabel(i + 1, aliasLabels[i]);
+      nBcAliases += counters.bcAll[i];
+    }
+    for (int i = 0; i < kNsel; i++) {
+      nSelBits += counters.sel[i];
     }
+    addCounts(histos.get<TH1>(HIST("hBcCounterAll")).get(), counters.bcAll.data(), kNaliases, 1, 1, counters.nBCs * kNaliases - nBcAliases);
+    addCounts(histos.get<TH1>(HIST("hColCounterAll")).get(), counters.colAll.data(), kNaliases, 1, 1);
+    addCounts(histos.get<TH1>(HIST("hColCounterAcc")).get(), counters.colAcc.data(), kNaliases, 1, 1);
+    addCounts(histos.get<TH1>(HIST("hSelCounter")).get(), counters.sel.data(), kNsel, 1, 1, counters.nSelFills * kNsel - nSelBits);
+    auto hAliasSel = histos.get<TH2>(HIST("hAliasSelCounter"));
+    for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
+      if (counters.colAll[iAlias] > 0) {
+        addCounts(hAliasSel.get(), counters.aliasSel[iAlias].data(), kNsel, hAliasSel->GetBin(iAlias + 1, 1), kNaliases + 2);
+      }
+    }
+
+    if (doPerRunSummary && (counters.nBCs > 0 || counters.nSelFills > 0)) {
+      const std::string runLabel = std::to_string(runNumber);
+      auto addRow = [&runLabel](std::shared_ptr<TH2> const& h, uint64_t const* counts, int n) {
+        const int runBin = h->GetXaxis()->FindBin(runLabel.c_str()); // adds the run label if not yet there
+        addCounts(h.get(), counts, n, h->GetBin(runBin, 1), h->GetNbinsX() + 2);
+      };
+      addRow(histos.get<TH2>(HIST("hRunBcCounterAll")), counters.bcAll.data(), kNaliases);
+      addRow(histos.get<TH2>(HIST("hRunColCounterAll")), counters.colAll.data(), kNaliases);
+      addRow(histos.get<TH2>(HIST("hRunColCounterAcc")), counters.colAcc.data(), kNaliases);
+      addRow(histos.get<TH2>(HIST("hRunSelCounter")), counters.sel.data(), kNsel);
+    }
+    counters.reset();
   }
 
   void processRun2(
@@ -240,25 +387,14 @@ struct EventSelectionQaTask {
 
     // bc-based event selection qa
     for (auto& bc : bcs) {
-      for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
-        histos.fill(HIST("hBcCounterAll"), iAlias, bc.alias()[iAlias]);
-      }
+      counters.countBC(bc);
     }
 
     // collision-based event selection qa
     for (auto& col : cols) {
       auto selection = col.selection();
       bool sel1 = selection[kIsINT1] & selection[kNoBGV0A] & selection[kNoBGV0C] & selection[kNoTPCLaserWarmUp] & selection[kNoTPCHVdip];
-
-      for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
-        if (!col.alias()[iAlias]) {
-          continue;
-        }
-        histos.fill(HIST("hColCounterAll"), iAlias, 1);
-        if ((!isINT1period && col.sel7()) || (isINT1period && sel1)) {
-          histos.fill(HIST("hColCounterAcc"), iAlias, 1);
-        }
-      }
+      counters.countCollision(col, (!isINT1period && col.sel7()) || (isINT1period && sel1));
 
       bool mb = isMC;
       mb |= !isINT1period && col.alias()[kINT7];
@@ -267,16 +403,17 @@ struct EventSelectionQaTask {
       if (!mb) {
         continue;
       }
-      for (int i = 0; i < kNsel; i++) {
-        histos.fill(HIST("hSelCounter"), i, col.selection()[i]);
-      }
+      counters.countSelection(col);
 
       auto bc = col.bc_as<BCsRun2>();
       uint64_t globalBC = bc.globalBC();
       uint64_t orbit = globalBC / nBCsPerOrbit;
       int localBC = globalBC % nBCsPerOrbit;
-      histos.fill(HIST("hGlobalBcAll"), globalBC);
       histos.fill(HIST("hOrbitAll"), orbit);
+      if (summaryOnly) {
+        continue;
+      }
+      histos.fill(HIST("hGlobalBcAll"), globalBC);
       histos.fill(HIST("hBcAll"), localBC);
       if (col.selection()[kIsBBV0A] || col.selection()[kIsBBV0C]) {
         histos.fill(HIST("hGlobalBcFV0"), globalBC);
@@ -397,6 +534,7 @@ struct EventSelectionQaTask {
       histos.fill(HIST("hV0C3vs012Acc"), multRingV0C012, multRingV0C3);
       histos.fill(HIST("hV0C012vsTklAcc"), nTracklets, multRingV0C012);
     }
+    flushCounters(bcs.size() > 0 ? bcs.iteratorAt(0).runNumber() : 0);
   }
   PROCESS_SWITCH(EventSelectionQaTask, processRun2, "Process Run2 event selection QA", true);
 
@@ -424,6 +562,9 @@ struct EventSelectionQaTask {
 
     // background studies
     for (auto& bc : bcs) {
+      if (summaryOnly) {
+        break;
+      }
       int localBC = bc.globalBC() % nBCsPerOrbit;
       float timeV0A = bc.has_fv0a() ? bc.fv0a().time() : -999.f;
       float timeT0A = bc.has_ft0() ? bc.ft0().timeA() : -999.f;
@@ -455,7 +596,7 @@ struct EventSelectionQaTask {
     }
 
     // per-DF info to deduce FT0 rate
-    if (bcs.size() > 0) {
+    if (bcs.size() > 0 && !summaryOnly) {
       uint64_t orbit = bcs.iteratorAt(0).globalBC() / nBCsPerOrbit;
       histos.fill(HIST("hDFstartOrbit"), orbit);
       histos.fill(HIST("hFT0sPerDF"), orbit, ft0s.size());
@@ -463,12 +604,14 @@ struct EventSelectionQaTask {
 
     // bc-based event selection qa
     for (auto& bc : bcs) {
-      for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
-        histos.fill(HIST("hBcCounterAll"), iAlias, bc.alias()[iAlias]);
-      }
+      counters.countBC(bc);
       uint64_t globalBC = bc.globalBC();
       uint64_t orbit = globalBC / nBCsPerOrbit;
       int localBC = globalBC % nBCsPerOrbit;
+      histos.fill(HIST("hOrbitAll"), orbit);
+      if (summaryOnly) {
+        continue;
+      }
       float timeZNA = bc.has_zdc() ? bc.zdc().timeZNA() : -999.f;
       float timeZNC = bc.has_zdc() ? bc.zdc().timeZNC() : -999.f;
       float timeV0A = bc.has_fv0a() ? bc.fv0a().time() : -999.f;
@@ -494,7 +637,6 @@ struct EventSelectionQaTask {
       }
 
       histos.fill(HIST("hGlobalBcAll"), globalBC);
-      histos.fill(HIST("hOrbitAll"), orbit);
       histos.fill(HIST("hBcAll"), localBC);
 
       // FV0
@@ -569,27 +711,18 @@ struct EventSelectionQaTask {
 
     // collision-based event selection qa
     for (auto& col : cols) {
-      for (int iAlias = 0; iAlias < kNaliases; iAlias++) {
-        if (!col.alias()[iAlias]) {
-          continue;
-        }
-        histos.fill(HIST("hColCounterAll"), iAlias, 1);
-        if (!col.sel8()) {
-          continue;
-        }
-        histos.fill(HIST("hColCounterAcc"), iAlias, 1);
-      }
-
-      for (int i = 0; i < kNsel; i++) {
-        histos.fill(HIST("hSelCounter"), i, col.selection()[i]);
-      }
+      counters.countCollision(col, col.sel8());
+      counters.countSelection(col);
 
       auto bc = col.bc_as<BCsRun3>();
       uint64_t globalBC = bc.globalBC();
       uint64_t orbit = globalBC / nBCsPerOrbit;
       int localBC = globalBC % nBCsPerOrbit;
-      histos.fill(HIST("hGlobalBcCol"), globalBC);
       histos.fill(HIST("hOrbitCol"), orbit);
+      if (summaryOnly) {
+        continue;
+      }
+      histos.fill(HIST("hGlobalBcCol"), globalBC);
       histos.fill(HIST("hBcCol"), localBC);
 
       auto tracksGrouped = tracks.sliceBy(perCollision, col.globalIndex());
@@ -695,11 +828,15 @@ struct EventSelectionQaTask {
       histos.fill(HIST("hMultFDCacc"), multFDC);
       histos.fill(HIST("hNcontribAcc"), nContributors);
     }
+    flushCounters(runNumber);
   }
   PROCESS_SWITCH(EventSelectionQaTask, processRun3, "Process Run3 event selection QA", false);
 
   void processMCRun3(aod::McCollisions const& mcCols, BCsRun3 const& bcs)
   {
+    if (summaryOnly) {
+      return;
+    }
     for (auto& mcCol : mcCols) {
       auto bc = mcCol.bc_as<BCsRun3>();
       uint64_t globalBC = bc.globalBC();
@@ -12,19 +12,25 @@
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 #include "ReconstructionDataFormats/Track.h"
+#include "Common/Core/TrackCovarianceBatch.h"
 
 #include <TFile.h>
 #include <TH1F.h>
 #include <cmath>
 #include <array>
+#include <string>
 namespace o2::aod
 {
 } // namespace o2::aod
 
 using namespace o2;
 using namespace o2::framework;
+using o2::analysis::DenseHistogram;
+using o2::analysis::TrackCovarianceBatch;
 
 struct ValidationQa {
+  Configurable<std::string> simdLevel{"simdLevel", "", "Instruction set of the vectorized kernels (generic, avx2, avx512), empty for the best one of the CPU"};
+
   OutputObj<TH1F> hpt_nocuts{TH1F("hpt_nocuts", "pt tracks (#GeV)", 100, 0., 10.)};
   OutputObj<TH1F> hrun_number{TH1F("hrun_number", "run number", 1000, 0., 1000000.)};
   OutputObj<TH1F> hfCYY{TH1F("hfCYY", "cYY", 1000, 0., 150.)};
@@ -42,28 +48,87 @@ struct ValidationQa {
   OutputObj<TH1F> hfC1PtSnp{TH1F("hfC1PtSnp", "c1PtSnp", 1000, -0.8, 1.)};
   OutputObj<TH1F> hfC1PtTgl{TH1F("hfC1PtTgl", "c1PtTgl", 1000, -0.3, 0.1)};
   OutputObj<TH1F> hfC1Pt21Pt2{TH1F("hfC1Pt21Pt2", "c1Pt21Pt2", 1000, -0.3, 0.1)};
+  // sigmas and correlation coefficients derived from the covariance matrix
+  OutputObj<TH1F> hfSigmaY{TH1F("hfSigmaY", "sigmaY", 1000, 0., 12.5)};
+  OutputObj<TH1F> hfSigmaZ{TH1F("hfSigmaZ", "sigmaZ", 1000, 0., 12.5)};
+  OutputObj<TH1F> hfSigmaSnp{TH1F("hfSigmaSnp", "sigmaSnp", 1000, 0., 0.35)};
+  OutputObj<TH1F> hfSigmaTgl{TH1F("hfSigmaTgl", "sigmaTgl", 1000, 0., 0.5)};
+  OutputObj<TH1F> hfSigma1Pt{TH1F("hfSigma1Pt", "sigma1Pt", 1000, 0., 1.)};
+  OutputObj<TH1F> hfRhoZY{TH1F("hfRhoZY", "rhoZY", 200, -1., 1.)};
+  OutputObj<TH1F> hfRhoSnpY{TH1F("hfRhoSnpY", "rhoSnpY", 200, -1., 1.)};
+  OutputObj<TH1F> hfRhoSnpZ{TH1F("hfRhoSnpZ", "rhoSnpZ", 200, -1., 1.)};
+  OutputObj<TH1F> hfRhoTglY{TH1F("hfRhoTglY", "rhoTglY", 200, -1., 1.)};
+  OutputObj<TH1F> hfRhoTglZ{TH1F("hfRhoTglZ", "rhoTglZ", 200, -1., 1.)};
+  OutputObj<TH1F> hfRhoTglSnp{TH1F("hfRhoTglSnp", "rhoTglSnp", 200, -1., 1.)};
+  OutputObj<TH1F> hfRho1PtY{TH1F("hfRho1PtY", "rho1PtY", 200, -1., 1.)};
+  OutputObj<TH1F> hfRho1PtZ{TH1F("hfRho1PtZ", "rho1PtZ", 200, -1., 1.)};
+  OutputObj<TH1F> hfRho1PtSnp{TH1F("hfRho1PtSnp", "rho1PtSnp", 200, -1., 1.)};
+  OutputObj<TH1F> hfRho1PtTgl{TH1F("hfRho1PtTgl", "rho1PtTgl", 200, -1., 1.)};
+
+  // histograms of the covariance elements, sigmas and correlations, in the order of TrackCovarianceBatch
+  std::array<OutputObj<TH1F>*, TrackCovarianceBatch::kNElements> mElementHistos = {&hfCYY, &hfCZY, &hfCZZ, &hfCSnpY, &hfCSnpZ, &hfCSnpSnp, &hfCTglY, &hfCTglZ, &hfCTglSnp, &hfCTglTgl, &hfC1PtY, &hfC1PtZ, &hfC1PtSnp, &hfC1PtTgl, &hfC1Pt21Pt2};
+  std::array<OutputObj<TH1F>*, TrackCovarianceBatch::kNParameters> mSigmaHistos = {&hfSigmaY, &hfSigmaZ, &hfSigmaSnp, &hfSigmaTgl, &hfSigma1Pt};
+  std::array<OutputObj<TH1F>*, TrackCovarianceBatch::kNCorrelations> mCorrelationHistos = {&hfRhoZY, &hfRhoSnpY, &hfRhoSnpZ, &hfRhoTglY, &hfRhoTglZ, &hfRhoTglSnp, &hfRho1PtY, &hfRho1PtZ, &hfRho1PtSnp, &hfRho1PtTgl};
+
+  TrackCovarianceBatch mBatch;
+  std::vector<float> mPt;
+  DenseHistogram mPtDense;
+  std::array<DenseHistogram, TrackCovarianceBatch::kNElements> mElementDense;
+  std::array<DenseHistogram, TrackCovarianceBatch::kNParameters> mSigmaDense;
+  std::array<DenseHistogram, TrackCovarianceBatch::kNCorrelations> mCorrelationDense;
+
+  void init(InitContext const&)
+  {
+    if (!simdLevel.value.empty()) {
+      o2::analysis::simd::setLevel(simdLevel.value);
+    }
+    LOGF(info, "Vectorized kernels running with the %s instruction set", o2::analysis::simd::getLevelName(o2::analysis::simd::getLevel()));
+    mPtDense = DenseHistogram::fromHistogram(hpt_nocuts);
+    for (int i = 0; i < TrackCovarianceBatch::kNElements; i++) {
+      mElementDense[i] = DenseHistogram::fromHistogram(*mElementHistos[i]);
+    }
+    for (int i = 0; i < TrackCovarianceBatch::kNParameters; i++) {
+      mSigmaDense[i] = DenseHistogram::fromHistogram(*mSigmaHistos[i]);
+    }
+    for (int i = 0; i < TrackCovarianceBatch::kNCorrelations; i++) {
+      mCorrelationDense[i] = DenseHistogram::fromHistogram(*mCorrelationHistos[i]);
+    }
+  }
 
-  void process(aod::Collision const& collision, aod::BCs const& bcs, soa::Join<aod::Tracks, aod::TracksCov> const& tracks)
+  void process(aod::Collisions const& collisions, aod::BCs const& bcs, soa::Join<aod::Tracks, aod::TracksCov> const& tracks)
   {
-    hrun_number->Fill(collision.bc().runNumber());
-    LOGF(info, "Tracks for collision: %d", tracks.size());
+    for (auto& collision : collisions) {
+      hrun_number->Fill(collision.bc().runNumber());
+    }
+    LOGF(debug, "Tracks in the data frame: %d", tracks.size());
+
+    // covariance matrices of all the tracks of the data frame associated to a collision, then one pass per quantity
+    mBatch.clear();
+    mBatch.reserve(tracks.size());
+    mPt.clear();
+    mPt.reserve(tracks.size());
     for (auto& track : tracks) {
-      hpt_nocuts->Fill(track.pt());
-      hfCYY->Fill(track.cYY());
-      hfCZY->Fill(track.cZY());
-      hfCZZ->Fill(track.cZZ());
-      hfCSnpY->Fill(track.cSnpY());
-      hfCSnpZ->Fill(track.cSnpZ());
-      hfCSnpSnp->Fill(track.cSnpSnp());
-      hfCTglY->Fill(track.cTglY());
-      hfCTglZ->Fill(track.cTglZ());
-      hfCTglSnp->Fill(track.cTglSnp());
-      hfCTglTgl->Fill(track.cTglTgl());
-      hfC1PtY->Fill(track.c1PtY());
-      hfC1PtZ->Fill(track.c1PtZ());
-      hfC1PtSnp->Fill(track.c1PtSnp());
-      hfC1PtTgl->Fill(track.c1PtTgl());
-      hfC1Pt21Pt2->Fill(track.c1Pt21Pt2());
+      if (!track.has_collision()) {
+        continue;
+      }
+      mPt.push_back(track.pt());
+      mBatch.push_back(track);
+    }
+    mBatch.compute();
+
+    mPtDense.fill(mPt);
+    mPtDense.flush(hpt_nocuts);
+    for (int i = 0; i < TrackCovarianceBatch::kNElements; i++) {
+      mElementDense[i].fill(mBatch.elements[i]);
+      mElementDense[i].flush(*mElementHistos[i]);
+    }
+    for (int i = 0; i < TrackCovarianceBatch::kNParameters; i++) {
+      mSigmaDense[i].fill(mBatch.sigmas[i]);
+      mSigmaDense[i].flush(*mSigmaHistos[i]);
+    }
+    for (int i = 0; i < TrackCovarianceBatch::kNCorrelations; i++) {
+      mCorrelationDense[i].fill(mBatch.correlations[i]);
+      mCorrelationDense[i].flush(*mCorrelationHistos[i]);
     }
   }
 };
@@ -16,7 +16,9 @@
 // - victor.gonzalez@cern.ch
 // - david.dobrigkeit.chinellato@cern.ch
 //
+#include <thread>
 #include "TList.h"
+#include "TROOT.h"
 #include "TDirectory.h"
 #include "TFile.h"
 #include "TH1F.h"
@@ -117,10 +119,70 @@ Bool_t multCalibrator::Calibrate()
 
   cout << "Saving calibration file..." << endl;
   fOut->Write();
+  //close the files, such that many runs can be calibrated in one session
+  //the precision histogram stays owned by this object
+  if (fPrecisionHistogram)
+    fPrecisionHistogram->SetDirectory(0);
+  fOut->Close();
+  fileInput->Close();
+  delete fOut;
+  delete fileInput;
   cout << "Done! Enjoy!" << endl;
   return kTRUE;
 }
 
+//________________________________________________________________
+Bool_t multCalibrator::CalibrateRuns(const std::vector<TString>& lInputFiles, const std::vector<TString>& lOutputFiles, Int_t lNThreads)
+{
+  // Function meant to generate the calibration OADB of many runs
+  //
+  // --- input : lInputFiles, one per run
+  // --- output: lOutputFiles, one per run
+  //
+  // Each run is calibrated by its own multCalibrator, sharing the
+  // boundaries of this object, and the runs are distributed over threads
+
+  if (lInputFiles.size() != lOutputFiles.size()) {
+    cout << "Please provide one output file per input file!" << endl;
+    return kFALSE;
+  }
+  const Long_t lNRuns = lInputFiles.size();
+  if (lNThreads < 1)
+    lNThreads = 1;
+  if (lNThreads > lNRuns)
+    lNThreads = lNRuns;
+  cout << "=== CALIBRATING " << lNRuns << " RUNS WITH " << lNThreads << " THREADS ===" << endl;
+
+  //files and histograms are created concurrently
+  ROOT::EnableThreadSafety();
+
+  std::vector<Char_t> lSuccess(lNRuns, kFALSE);
+  auto lCalibrateI = [&](Int_t lFirst) {
+    for (Long_t iRun = lFirst; iRun < lNRuns; iRun += lNThreads) {
+      multCalibrator lCalibrator(Form("%s_%ld", GetName(), iRun), GetTitle());
+      lCalibrator.SetBoundaries(lNDesiredBoundaries, lDesiredBoundaries);
+      lCalibrator.SetInputFile(lInputFiles[iRun]);
+      lCalibrator.SetOutputFile(lOutputFiles[iRun]);
+      lSuccess[iRun] = lCalibrator.Calibrate();
+    }
+  };
+  std::vector<std::thread> lThreads;
+  for (Int_t iThread = 1; iThread < lNThreads; iThread++)
+    lThreads.emplace_back(lCalibrateI, iThread);
+  lCalibrateI(0);
+  for (auto& lThread : lThreads)
+    lThread.join();
+
+  Bool_t lReturnValue = kTRUE;
+  for (Long_t iRun = 0; iRun < lNRuns; iRun++) {
+    if (!lSuccess[iRun]) {
+      cout << "Calibration failed for input file " << lInputFiles[iRun].Data() << endl;
+      lReturnValue = kFALSE;
+    }
+  }
+  return lReturnValue;
+}
+
 Double_t multCalibrator::GetRawMax(TH1D* histo)
 {
   //This function gets the max X value (right edge) which is filled.
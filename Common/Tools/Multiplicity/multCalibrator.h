@@ -23,6 +23,7 @@
 #include "TNamed.h"
 #include "TH1D.h"
 #include <map>
+#include <vector>
 
 using namespace std;
 
@@ -60,6 +61,10 @@ class multCalibrator : public TNamed
   //Master Function in this Class: To be called once filenames are set
   Bool_t Calibrate();
 
+  //Batch mode: calibrates many runs (one input and one output file each) in parallel,
+  //with the boundaries of this object. Returns kTRUE if all runs were calibrated
+  Bool_t CalibrateRuns(const std::vector<TString>& lInputFiles, const std::vector<TString>& lOutputFiles, Int_t lNThreads = 4);
+
   //Aux function. Keep public, accessible outside as rather useful utility
   TH1F* GetCalibrationHistogram(TH1D* histoRaw, TString lHistoName = "hCalib");
 
@@ -25,6 +25,8 @@
  *
  **********************************************/
 
+#include <algorithm>
+#include <thread>
 #include "multGlauberNBDFitter.h"
 #include "TList.h"
 #include "TFile.h"
@@ -33,6 +35,7 @@
 #include "TVirtualFitter.h"
 #include "TProfile.h"
 #include "TFitResult.h"
+#include "Math/PdfFuncMathCore.h"
 
 ClassImp(multGlauberNBDFitter);
 
@@ -53,7 +56,12 @@ multGlauberNBDFitter::multGlauberNBDFitter() : TNamed(),
                                                ff(0.8),
                                                fnorm(100),
                                                fFitOptions("R0"),
-                                               fFitNpx(5000)
+                                               fFitNpx(5000),
+                                               fNThreads(1),
+                                               fTermsValid(kFALSE),
+                                               fTermsMu(0),
+                                               fTermsk(0),
+                                               fPointsValid(kFALSE)
 {
   // Constructor
   fNpart = new Double_t[fMaxNpNcPairs];
@@ -93,7 +101,12 @@ multGlauberNBDFitter::multGlauberNBDFitter(const char* name, const char* title)
                                                                                   ff(0.8),
                                                                                   fnorm(100),
                                                                                   fFitOptions("R0"),
-                                                                                  fFitNpx(5000)
+                                                                                  fFitNpx(5000),
+                                                                                  fNThreads(1),
+                                                                                  fTermsValid(kFALSE),
+                                                                                  fTermsMu(0),
+                                                                                  fTermsk(0),
+                                                                                  fPointsValid(kFALSE)
 {
   //Named constructor
   fNpart = new Double_t[fMaxNpNcPairs];
@@ -144,7 +157,6 @@ Double_t multGlauberNBDFitter::ProbDistrib(Double_t* x, Double_t* par)
 //Master fitter function
 {
   Double_t lMultValue = x[0];
-  Double_t lProbability = 0.0;
   ffChanged = kTRUE;
   const Double_t lAlmost0 = 1.e-13;
   //Comment this line in order to make the code evaluate Nancestor all the time
@@ -174,27 +186,96 @@ Double_t multGlauberNBDFitter::ProbDistrib(Double_t* x, Double_t* par)
       return 0;
     }
     fhNanc->Scale(1. / fhNanc->Integral());
+    fTermsValid = kFALSE;
+  }
+  //______________________________________________________
+  //Recalculate the NBD terms of the ancestor bins in case mu or k changed
+  if (!fTermsValid || fTermsMu != par[0] || fTermsk != par[1]) {
+    InitAncestorTerms(par[0], par[1]);
+    fPointsValid = kFALSE;
   }
   //______________________________________________________
   //Actually evaluate function
+  //The fitted points are evaluated together, in parallel, at the first call with new parameters
+  if (fNThreads > 1 && !fPointX.empty()) {
+    auto lPoint = std::lower_bound(fPointX.begin(), fPointX.end(), lMultValue);
+    if (lPoint != fPointX.end() && *lPoint == lMultValue) {
+      if (!fPointsValid) {
+        const Long_t lNPoints = fPointX.size();
+        fPointValue.resize(lNPoints);
+        auto lEvaluate = [&](Int_t lFirst) {
+          for (Long_t iPoint = lFirst; iPoint < lNPoints; iPoint += fNThreads)
+            fPointValue[iPoint] = EvaluateAncestorTerms(fPointX[iPoint]);
+        };
+        std::vector<std::thread> lThreads;
+        for (Int_t iThread = 1; iThread < fNThreads; iThread++)
+          lThreads.emplace_back(lEvaluate, iThread);
+        lEvaluate(0);
+        for (auto& lThread : lThreads)
+          lThread.join();
+        fPointsValid = kTRUE;
+      }
+      return par[3] * fPointValue[lPoint - fPointX.begin()];
+    }
+  }
+  //______________________________________________________
+  return par[3] * EvaluateAncestorTerms(lMultValue);
+}
+
+//______________________________________________________
+void multGlauberNBDFitter::InitAncestorTerms(Double_t lMu, Double_t lk)
+{
+  //The NBD parameters of each ancestor bin do not depend on the multiplicity:
+  //compute them once per (mu, k) instead of once per evaluated point
+  fTermCount.clear();
+  fTermk.clear();
+  fTermp.clear();
+  fTermLnGammak.clear();
+  fTermLogMuOverk.clear();
+  fTermLogOnePlusMuOverk.clear();
   Int_t lStartBin = fhNanc->FindBin(0.0) + 1;
   for (Long_t iNanc = lStartBin; iNanc < fhNanc->GetNbinsX() + 1; iNanc++) {
-    Double_t lNancestors = fhNanc->GetBinCenter(iNanc);
     Double_t lNancestorCount = fhNanc->GetBinContent(iNanc);
-    //if(lNancestorCount<1e-12&&lNancestors>10) break;
-
-    Double_t lThisMu = (((Double_t)lNancestors)) * par[0];
-    Double_t lThisk = (((Double_t)lNancestors)) * par[1];
-    Double_t lpval = TMath::Power(1.0 + lThisMu / lThisk, -1);
-    fNBD->SetParameter(1, lThisk);
-    fNBD->SetParameter(0, lpval);
-    Double_t lMult = 0.0;
-    if (lMultValue > 1e-6)
-      lMult = fAncestorMode != 2 ? fNBD->Eval(lMultValue) : ContinuousNBD(lMultValue, lThisMu, lThisk);
-    lProbability += lNancestorCount * lMult;
+    if (lNancestorCount == 0)
+      continue;
+    Double_t lNancestors = fhNanc->GetBinCenter(iNanc);
+    Double_t lThisMu = (((Double_t)lNancestors)) * lMu;
+    Double_t lThisk = (((Double_t)lNancestors)) * lk;
+    fTermCount.push_back(lNancestorCount);
+    fTermk.push_back(lThisk);
+    fTermp.push_back(TMath::Power(1.0 + lThisMu / lThisk, -1));
+    fTermLnGammak.push_back(TMath::LnGamma(lThisk));
+    fTermLogMuOverk.push_back(TMath::Log(lThisMu / lThisk));
+    fTermLogOnePlusMuOverk.push_back(TMath::Log(1.0 + lThisMu / lThisk));
   }
-  //______________________________________________________
-  return par[3] * lProbability;
+  fTermsMu = lMu;
+  fTermsk = lk;
+  fTermsValid = kTRUE;
+}
+
+//______________________________________________________
+Double_t multGlauberNBDFitter::EvaluateAncestorTerms(Double_t lMultValue) const
+{
+  //Sum of the NBDs of the ancestor bins, weighted by their count
+  //Only reads the precomputed terms, so it can be called concurrently
+  Double_t lProbability = 0.0;
+  if (lMultValue <= 1e-6)
+    return lProbability;
+  const size_t lNTerms = fTermCount.size();
+  if (fAncestorMode != 2) {
+    const unsigned int lMult = static_cast<unsigned int>(lMultValue);
+    for (size_t iTerm = 0; iTerm < lNTerms; iTerm++)
+      lProbability += fTermCount[iTerm] * ROOT::Math::negative_binomial_pdf(lMult, fTermp[iTerm], fTermk[iTerm]);
+  } else {
+    //same as ContinuousNBD, with the terms not depending on n precomputed
+    const Double_t lLnGammaN = TMath::LnGamma(lMultValue + 1.);
+    for (size_t iTerm = 0; iTerm < lNTerms; iTerm++) {
+      Double_t F = TMath::LnGamma(lMultValue + fTermk[iTerm]) - lLnGammaN - fTermLnGammak[iTerm];
+      F += lMultValue * fTermLogMuOverk[iTerm] - (lMultValue + fTermk[iTerm]) * fTermLogOnePlusMuOverk[iTerm];
+      lProbability += fTermCount[iTerm] * TMath::Exp(F);
+    }
+  }
+  return lProbability;
 }
 
 //________________________________________________________________
@@ -269,6 +350,24 @@ Bool_t multGlauberNBDFitter::DoFit()
     return kFALSE;
   }
 
+  //Make sure the ancestor distribution is recalculated with the current Npart, Ncoll pairs
+  fCurrentf = -1;
+  fTermsValid = kFALSE;
+
+  //Points at which the fit evaluates the function: bin centers of the fitted histogram in the fit range
+  fPointX.clear();
+  fPointsValid = kFALSE;
+  if (fNThreads > 1) {
+    Double_t lLoRange, lHiRange;
+    fGlauberNBD->GetRange(lLoRange, lHiRange);
+    for (Int_t ibin = 1; ibin < fhV0M->GetNbinsX() + 1; ibin++) {
+      Double_t lCenter = fhV0M->GetBinCenter(ibin);
+      if (lCenter >= lLoRange && lCenter <= lHiRange)
+        fPointX.push_back(lCenter);
+    }
+    cout << "---> Fit function will be evaluated with " << fNThreads << " threads" << endl;
+  }
+
   TStopwatch* timer = new TStopwatch();
   timer->Start(kTRUE);
   if (fAncestorMode == 0)
@@ -285,6 +384,7 @@ Bool_t multGlauberNBDFitter::DoFit()
   fitptr = fhV0M->Fit("fGlauberNBD", fFitOptions.Data());
 
   timer->Stop();
+  fPointX.clear();
   Double_t lTotalTime = timer->RealTime();
   cout << "---> Fitting took " << lTotalTime << " seconds" << endl;
 
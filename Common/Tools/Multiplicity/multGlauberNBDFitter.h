@@ -13,6 +13,7 @@
 #define MULTGLAUBERNBDFITTER_H
 
 #include <iostream>
+#include <vector>
 #include "TNamed.h"
 #include "TF1.h"
 #include "TH1.h"
@@ -72,6 +73,10 @@ class multGlauberNBDFitter : public TNamed
   void SetFitOptions(TString lOpt);
   void SetFitNpx(Long_t lNpx);
 
+  //Number of threads over which the fit function is evaluated at the fitted points
+  void SetNThreads(Int_t lNThreads) { fNThreads = lNThreads; }
+  Int_t GetNThreads() { return fNThreads; }
+
   //For ancestor mode 2
   Double_t ContinuousNBD(Double_t n, Double_t mu, Double_t k);
 
@@ -81,6 +86,12 @@ class multGlauberNBDFitter : public TNamed
   //void    Print(Option_t *option="") const;
 
  private:
+  //Precompute the NBD terms of the ancestor bins for a given mu, k
+  void InitAncestorTerms(Double_t lMu, Double_t lk);
+
+  //Glauber x NBD at a multiplicity value, without normalization, from the precomputed terms
+  Double_t EvaluateAncestorTerms(Double_t lMultValue) const;
+
   //This function serves as the (analytical) NBD
   TF1* fNBD;
 
@@ -115,6 +126,24 @@ class multGlauberNBDFitter : public TNamed
   TString fFitOptions;
   Long_t fFitNpx;
 
-  ClassDef(multGlauberNBDFitter, 1);
+  Int_t fNThreads;
+
+  //NBD terms of the non-empty ancestor bins, valid for fTermsMu, fTermsk and the current f
+  Bool_t fTermsValid;                           //!
+  Double_t fTermsMu;                            //!
+  Double_t fTermsk;                             //!
+  std::vector<Double_t> fTermCount;             //! normalized count of the ancestor bin
+  std::vector<Double_t> fTermk;                 //! k of the NBD
+  std::vector<Double_t> fTermp;                 //! p of the NBD
+  std::vector<Double_t> fTermLnGammak;          //! ln Gamma(k)
+  std::vector<Double_t> fTermLogMuOverk;        //! ln(mu/k)
+  std::vector<Double_t> fTermLogOnePlusMuOverk; //! ln(1+mu/k)
+
+  //Function at the fitted points, evaluated in parallel once per parameter set
+  std::vector<Double_t> fPointX;     //! bin centers of the fitted histogram in the fit range
+  std::vector<Double_t> fPointValue; //! function without normalization at fPointX
+  Bool_t fPointsValid;               //!
+
+  ClassDef(multGlauberNBDFitter, 2);
 };
 #endif
@@ -20,6 +20,8 @@
 #include <boost/program_options.hpp>
 #include <FairLogger.h>
 #include "TFile.h"
+#include <iomanip>
+#include <sstream>
 
 // Global executable arguments
 namespace bpo = boost::program_options;
@@ -167,3 +169,17 @@ void setupTimestamps(long& timestamp,
     validityStop = 4108971600000;
   }
 }
+
+/// Prints the parameters of a compiled parametrization (e.g. o2::pid::tof::TOFResoCompiled) as a C++ definition,
+/// to use the parametrization as a constant without loading it from CCDB
+template <typename CompiledType>
+void printCompiledParametrization(const CompiledType& compiled, const std::string& typeName)
+{
+  std::ostringstream definition;
+  definition << std::setprecision(9) << "const " << typeName << " compiled{{";
+  for (int i = 0; i < CompiledType::nParameters; i++) {
+    definition << (i > 0 ? ", " : "") << compiled[i];
+  }
+  definition << "}};";
+  LOG(info) << definition.str();
+}
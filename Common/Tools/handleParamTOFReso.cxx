@@ -142,8 +142,11 @@ int main(int argc, char* argv[])
               << ccdbTimestamp << " -> " << timeStampToHReadble(ccdbTimestamp);
     reso = retrieveFromCCDB<TOFResoParams>(ccdbPath, ccdbTimestamp);
     reso->Print();
+    TOFResoCompiled compiled;
+    compiled.compile(*reso);
+    printCompiledParametrization(compiled, "TOFResoCompiled");
     using RespImp = ExpTimes<DebugTrack, 2>;
-    LOG(info) << "TOF expected resolution at p=" << debugTrack.p() << " GeV/c and mass " << RespImp::mMassZ << ":" << RespImp::GetExpectedSigma(*reso, debugTrack);
+    LOG(info) << "TOF expected resolution at p=" << debugTrack.p() << " GeV/c and mass " << RespImp::mMassZ << ":" << RespImp::GetExpectedSigma(*reso, debugTrack) << ", compiled: " << RespImp::GetExpectedSigma(compiled, debugTrack);
   } else { // Create and test + performance
     LOG(info) << "Creating TOF parametrization and testing";
     reso = new TOFResoParams();
@@ -155,6 +158,9 @@ int main(int argc, char* argv[])
       resoOld->SetParameters(resoparams);
     }
     response.LoadParam(DetectorResponse::kSigma, resoOld);
+    TOFResoCompiled compiled;
+    compiled.compile(*resoOld);
+    printCompiledParametrization(compiled, "TOFResoCompiled");
     // Draw it
     using RespImp = ExpTimes<DebugTrack, 2>;
     //
@@ -168,6 +174,9 @@ int main(int argc, char* argv[])
     graphs["NSigmaOld"] = new TGraph();
     graphs["durationExpSigmaOld"] = new TGraph();
     graphs["durationNSigmaOld"] = new TGraph();
+    //
+    graphs["ExpSigmaCompiled"] = new TGraph();
+    graphs["durationExpSigmaCompiled"] = new TGraph();
     const int nsamp = 1000;
     for (int i = 0; i < nsamp; i++) {
       debugTrack.mp += 0.01f;
@@ -199,6 +208,16 @@ int main(int argc, char* argv[])
       duration = duration_cast<nanoseconds>(stop - start).count();
       graphs["NSigmaOld"]->SetPoint(i, debugTrack.p(), RespImp::GetSeparation(*reso, debugTrack));
       graphs["durationNSigmaOld"]->SetPoint(i + 1, i, duration);
+      //
+      start = high_resolution_clock::now();
+      RespImp::GetExpectedSigma(compiled, debugTrack);
+      stop = high_resolution_clock::now();
+      duration = duration_cast<nanoseconds>(stop - start).count();
+      graphs["ExpSigmaCompiled"]->SetPoint(i, debugTrack.p(), RespImp::GetExpectedSigma(compiled, debugTrack));
+      graphs["durationExpSigmaCompiled"]->SetPoint(i + 1, i, duration);
+      if (RespImp::GetExpectedSigma(compiled, debugTrack) != RespImp::GetExpectedSigma(response, debugTrack)) {
+        LOG(fatal) << "Compiled parametrization differs from " << resoOld->GetName() << " at p=" << debugTrack.p();
+      }
     }
     TFile fdebug("/tmp/tofParamDebug.root", "UPDATE");
     TString dn = Form("%i", fdebug.GetListOfKeys()->GetEntries());
@@ -0,0 +1,63 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   tableUsageReport.cxx
+/// \brief  Workflow reporting, for the workflow it is attached to, the produced tables and the devices consuming them.
+///         The tables without consumers are computed for nothing: their producers can be configured to skip them,
+///         with the -1 (auto) flags of e.g. the PID, centrality, multiplicity and track selection producers.
+///         Usage: o2-analysis-... | o2-analysis-table-usage-report --aod-file AO2D.root
+///
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Common/Core/TableHelper.h"
+#include <algorithm>
+#include <string>
+
+using namespace o2;
+using namespace o2::framework;
+
+struct TableUsageReport {
+  Configurable<bool> unusedOnly{"unusedOnly", true, "Report only the produced tables without consumers"};
+  Configurable<std::string> producerFilter{"producerFilter", "", "Report only the tables of the devices whose name contains this string"};
+
+  void init(InitContext& initContext)
+  {
+    const std::string filter = producerFilter;
+    int nReported = 0;
+    int nUnused = 0;
+    for (auto const& usage : getTableUsageInWorkflow(initContext)) {
+      if (usage.producer.find(filter) == std::string::npos || usage.producer.rfind("internal-dpl-", 0) == 0) {
+        continue;
+      }
+      const bool unused = usage.consumers.empty();
+      nUnused += unused;
+      if (unusedOnly && !unused) {
+        continue;
+      }
+      std::string consumers;
+      for (auto const& consumer : usage.consumers) {
+        consumers += (consumers.empty() ? "" : ", ") + consumer;
+      }
+      LOGF(info, "%s: %s -> %s", usage.producer.c_str(), usage.table.c_str(), unused ? "UNUSED" : consumers.c_str());
+      nReported++;
+    }
+    LOGF(info, "%d produced tables reported, %d of them without consumers", nReported, nUnused);
+  }
+
+  void process(aod::Collisions const&) {}
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<TableUsageReport>(cfgc)};
+}
@@ -20,6 +20,8 @@
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/PIDResponse.h"
+#include "DPG/Tasks/TPC/tpcSkimsDownsampling.h"
+#include "PWGMM/Mult/Core/denseCounts.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -77,6 +79,7 @@ struct tofPidQa {
   Configurable<bool> applyTrackCut{"applyTrackCut", false, "Flag to apply standard track cuts"};
   Configurable<bool> applyRapidityCut{"applyRapidityCut", false, "Flag to apply rapidity cut"};
   Configurable<bool> enableEvTimeSplitting{"enableEvTimeSplitting", false, "Flag to enable histograms splitting depending on the Event Time used"};
+  Configurable<float> samplingFraction{"samplingFraction", 1.f, "Fraction of the collisions used by processAllFull, sampled deterministically from the global BC"};
 
   template <o2::track::PID::ID id>
   void initPerParticle(const AxisSpec& pAxis, const AxisSpec& ptAxis)
@@ -85,19 +88,23 @@ struct tofPidQa {
     bool enableFullHistos = false;
     int enabledProcesses = 0;
     switch (id) { // Skipping disabled particles
-#define particleCase(particleId)                                 \
-  case PID::particleId:                                          \
-    if (!doprocess##particleId && !doprocessFull##particleId) {  \
-      return;                                                    \
-    }                                                            \
-    if (doprocess##particleId) {                                 \
-      enabledProcesses++;                                        \
-    }                                                            \
-    if (doprocessFull##particleId) {                             \
-      enableFullHistos = true;                                   \
-      enabledProcesses++;                                        \
-    }                                                            \
-    LOGF(info, "Enabled TOF QA for %s %s", #particleId, pT[id]); \
+#define particleCase(particleId)                                                         \
+  case PID::particleId:                                                                  \
+    if (!doprocess##particleId && !doprocessFull##particleId && !doprocessAllFull) {     \
+      return;                                                                            \
+    }                                                                                    \
+    if (doprocess##particleId) {                                                         \
+      enabledProcesses++;                                                                \
+    }                                                                                    \
+    if (doprocessFull##particleId) {                                                     \
+      enableFullHistos = true;                                                           \
+      enabledProcesses++;                                                                \
+    }                                                                                    \
+    if (doprocessAllFull) {                                                              \
+      enableFullHistos = true;                                                           \
+      enabledProcesses++;                                                                \
+    }                                                                                    \
+    LOGF(info, "Enabled TOF QA for %s %s", #particleId, pT[id]);                         \
     break;
 
       particleCase(Electron);
@@ -222,6 +229,12 @@ struct tofPidQa {
     static_for<0, 8>([&](auto i) {
       initPerParticle<i>(pAxis, ptAxis);
     });
+
+    if (doprocessAllFull && !enableEvTimeSplitting) {
+      static_for<0, 8>([&](auto i) {
+        setupDenseHistograms<i>();
+      });
+    }
   }
 
   template <bool fillHistograms, typename CollisionType, typename TrackType>
@@ -485,6 +498,136 @@ struct tofPidQa {
   makeProcessFunction(aod::pidTOFFullHe, Helium3);
   makeProcessFunction(aod::pidTOFFullAl, Alpha);
 #undef makeProcessFunction
+
+  // QA of the full tables of all the species in one pass
+  /// Counts of the per-species histograms of processAllFull, added to the histograms once per data frame
+  struct DenseSpeciesHistograms {
+    o2::analysis::mult::DenseCounts2D nsigma;
+    o2::analysis::mult::DenseCounts2D nsigmapt;
+    o2::analysis::mult::DenseCounts2D nsigmapospt;
+    o2::analysis::mult::DenseCounts2D nsigmanegpt;
+    o2::analysis::mult::DenseCounts2D expected;
+    o2::analysis::mult::DenseCounts2D expectedDiff;
+    o2::analysis::mult::DenseCounts2D expSigma;
+
+    void flush()
+    {
+      nsigma.flush();
+      nsigmapt.flush();
+      nsigmapospt.flush();
+      nsigmanegpt.flush();
+      expected.flush();
+      expectedDiff.flush();
+      expSigma.flush();
+    }
+  };
+  std::array<DenseSpeciesHistograms, Np> denseHistograms;
+  std::vector<bool> selectedCollisions;
+  std::vector<float> collisionTimes; // ps
+
+  template <o2::track::PID::ID id>
+  void setupDenseHistograms()
+  {
+    auto& dense = denseHistograms[id];
+    dense.nsigma.setup(histos.get<TH2>(HIST(hnsigma[id])));
+    dense.nsigmapt.setup(histos.get<TH2>(HIST(hnsigmapt[id])));
+    dense.nsigmapospt.setup(histos.get<TH2>(HIST(hnsigmapospt[id])));
+    dense.nsigmanegpt.setup(histos.get<TH2>(HIST(hnsigmanegpt[id])));
+    dense.expected.setup(histos.get<TH2>(HIST(hexpected[id])));
+    dense.expectedDiff.setup(histos.get<TH2>(HIST(hexpected_diff[id])));
+    dense.expSigma.setup(histos.get<TH2>(HIST(hexpsigma[id])));
+  }
+
+  template <o2::track::PID::ID id, typename TrackType>
+  void fillAllFull(TrackType const& t, const float p, const float pt, const float tof, const int evTimeIndex)
+  {
+    if (applyRapidityCut) {
+      if (abs(t.rapidity(PID::getMass(id))) > 0.5) {
+        return;
+      }
+    }
+    const auto nsigma = o2::aod::pidutils::tofNSigma<id>(t);
+    const auto diff = o2::aod::pidutils::tofExpSignalDiff<id>(t);
+    const auto expSigma = o2::aod::pidutils::tofExpSigma<id>(t);
+    if (enableEvTimeSplitting) {
+      histos.fill(HIST(hnsigma[id]), p, nsigma, evTimeIndex);
+      histos.fill(HIST(hnsigmapt[id]), pt, nsigma, evTimeIndex);
+      if (t.sign() > 0) {
+        histos.fill(HIST(hnsigmapospt[id]), pt, nsigma, evTimeIndex);
+      } else {
+        histos.fill(HIST(hnsigmanegpt[id]), pt, nsigma, evTimeIndex);
+      }
+      histos.fill(HIST(hexpected[id]), p, tof - diff);
+      histos.fill(HIST(hexpected_diff[id]), p, diff, evTimeIndex);
+      histos.fill(HIST(hexpsigma[id]), p, expSigma);
+      return;
+    }
+    auto& dense = denseHistograms[id];
+    dense.nsigma.fill(p, nsigma);
+    dense.nsigmapt.fill(pt, nsigma);
+    if (t.sign() > 0) {
+      dense.nsigmapospt.fill(pt, nsigma);
+    } else {
+      dense.nsigmanegpt.fill(pt, nsigma);
+    }
+    dense.expected.fill(p, tof - diff);
+    dense.expectedDiff.fill(p, diff);
+    dense.expSigma.fill(p, expSigma);
+  }
+
+  using TrackCandidatesAllFull = soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                                           aod::pidEvTimeFlags, aod::TOFSignal,
+                                           aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi,
+                                           aod::pidTOFFullKa, aod::pidTOFFullPr, aod::pidTOFFullDe,
+                                           aod::pidTOFFullTr, aod::pidTOFFullHe, aod::pidTOFFullAl>;
+  void processAllFull(soa::Join<aod::Collisions, aod::EvSels> const& collisions,
+                      TrackCandidatesAllFull const& tracks,
+                      aod::BCs const&)
+  {
+    // the collisions are selected first, then the tracks of the data frame are read once for all the species
+    selectedCollisions.assign(collisions.size(), false);
+    collisionTimes.assign(collisions.size(), 0.f);
+    for (auto const& collision : collisions) {
+      if (samplingFraction < 1.f && o2::tpcskims::hashUniform(0, collision.bc_as<aod::BCs>().globalBC(), 0) >= samplingFraction) {
+        continue;
+      }
+      if (!isEventSelected<false>(collision, tracks)) {
+        continue;
+      }
+      selectedCollisions[collision.globalIndex()] = true;
+      collisionTimes[collision.globalIndex()] = collision.collisionTime() * 1000.f;
+    }
+
+    for (auto const& t : tracks) {
+      if (!t.has_collision() || !selectedCollisions[t.collisionId()]) {
+        continue;
+      }
+      if (!isTrackSelected<false>(collisions, t)) {
+        continue;
+      }
+      int evTimeIndex = 1;
+      if (t.isEvTimeTOF() && t.isEvTimeT0AC()) {
+        evTimeIndex = 4;
+      } else if (t.isEvTimeT0AC()) {
+        evTimeIndex = 3;
+      } else if (t.isEvTimeTOF()) {
+        evTimeIndex = 2;
+      }
+      const float p = t.p();
+      const float pt = t.pt();
+      const float tof = t.tofSignal() - collisionTimes[t.collisionId()];
+      static_for<0, 8>([&](auto i) {
+        fillAllFull<i>(t, p, pt, tof, evTimeIndex);
+      });
+    }
+
+    if (!enableEvTimeSplitting) {
+      for (auto& dense : denseHistograms) {
+        dense.flush();
+      }
+    }
+  }
+  PROCESS_SWITCH(tofPidQa, processAllFull, "Process all the hypotheses in one pass for full TOF PID QA", false);
 };
 
 /// Task to produce the TOF QA plots for Beta
@@ -25,10 +25,12 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "qaIndexBitmap.h"
 
 // ROOT includes
 #include "TPDGCode.h"
 #include "TEfficiency.h"
+#include "THn.h"
 #include "TList.h"
 
 using namespace o2::framework;
@@ -78,6 +80,11 @@ struct QaEfficiency {
   // Task configuration
   Configurable<bool> makeEff{"make-eff", false, "Flag to produce the efficiency with TEfficiency"};
   Configurable<int> applyEvSel{"applyEvSel", 0, "Flag to apply event selection: 0 -> no event selection, 1 -> Run 2 event selection, 2 -> Run 3 event selection"};
+  // Dense grids configuration
+  Configurable<bool> doDenseGrid{"do-dense-grid", false, "Flag to fill the MC numerators and denominators in dense (species, charge, origin, pT, eta, phi) grids instead of the histograms per species and charge"};
+  Configurable<int> densePtBins{"dense-pt-bins", 50, "Number of pT bins of the dense grids"};
+  Configurable<int> denseEtaBins{"dense-eta-bins", 20, "Number of eta bins of the dense grids"};
+  Configurable<int> densePhiBins{"dense-phi-bins", 18, "Number of phi bins of the dense grids"};
 
   OutputObj<TList> listEfficiencyMC{"EfficiencyMC"};
   OutputObj<TList> listEfficiencyData{"EfficiencyData"};
@@ -514,6 +521,71 @@ struct QaEfficiency {
                                                               "MC/tr/neg/pteta/den", "MC/he/neg/pteta/den", "MC/al/neg/pteta/den",
                                                               "MC/all/neg/pteta/den"};
 
+  // Dense grids: integer counts vs (species, charge, origin, pT, eta, phi), the species axis has the enabled species only
+  std::vector<int> denseSpecies; // species id of the bins of the species axis
+  // numerators with the MC and with the track kinematics, numerator with TOF, denominator
+  std::shared_ptr<THn> denseNum, denseNumTrk, denseNumTof, denseDen;
+  static constexpr int nDenseAxes = 6;
+
+  void makeDenseGrids()
+  {
+    const bool doSpecies[nSpecies] = {doEl, doMu, doPi, doKa, doPr, doDe, doTr, doHe, doAl, doUnId};
+    denseSpecies.clear();
+    for (int id = 0; id < nSpecies; id++) {
+      if (doSpecies[id]) {
+        denseSpecies.push_back(id);
+      }
+    }
+    const int nDenseSpecies = denseSpecies.size();
+    const AxisSpec axisSpecies{nDenseSpecies, -0.5, nDenseSpecies - 0.5, "species"};
+    const AxisSpec axisCharge{2, -0.5, 1.5, "charge (pos, neg)"};
+    const AxisSpec axisOrigin{3, -0.5, 2.5, "origin (primary, decay, material)"};
+    AxisSpec axisPt{densePtBins, ptMin, ptMax, "#it{p}_{T} (GeV/#it{c})"};
+    if (logPt) {
+      axisPt.makeLogarithmic();
+    }
+    const AxisSpec axisEta{denseEtaBins, etaMin, etaMax, "#it{#eta}"};
+    const AxisSpec axisPhi{densePhiBins, phiMin, phiMax, "#it{#varphi} (rad)"};
+
+    auto makeGrid = [&](const char* name, const char* title) {
+      auto h = histos.add<THn>(name, title, kTHnI, {axisSpecies, axisCharge, axisOrigin, axisPt, axisEta, axisPhi});
+      for (int i = 0; i < nDenseSpecies; i++) {
+        h->GetAxis(0)->SetBinLabel(i + 1, particleTitle[denseSpecies[i]]);
+      }
+      return h;
+    };
+    denseNum = makeGrid("MC/dense/num", "Numerator");
+    denseNumTrk = makeGrid("MC/dense/numtrk", "Numerator Track");
+    denseNumTof = makeGrid("MC/dense/numtof", "Numerator TOF");
+    denseDen = makeGrid("MC/dense/den", "Denominator");
+  }
+
+  // Bins of the particle on the charge, origin and kinematic axes of the dense grids, found once for all the species and grids
+  template <typename particleType>
+  void getDenseBins(int (&bins)[nDenseAxes], const particleType& mcParticle, float pt, float eta, float phi)
+  {
+    bins[0] = 0;
+    bins[1] = mcParticle.pdgCode() > 0 ? 1 : 2;
+    bins[2] = mcParticle.isPhysicalPrimary() ? 1 : (mcParticle.getProcess() == 4 ? 2 : 3);
+    bins[3] = denseDen->GetAxis(3)->FindFixBin(pt);
+    bins[4] = denseDen->GetAxis(4)->FindFixBin(eta);
+    bins[5] = denseDen->GetAxis(5)->FindFixBin(phi);
+  }
+
+  // Adds one count for each enabled species of the PDG code
+  void fillDenseGrid(THn* grid, int (&bins)[nDenseAxes], int pdgCode)
+  {
+    for (std::size_t i = 0; i < denseSpecies.size(); i++) {
+      const int id = denseSpecies[i];
+      if (PDGs[id] != 0 && std::abs(pdgCode) != PDGs[id]) {
+        continue;
+      }
+      bins[0] = i + 1;
+      grid->AddBinContent(grid->GetBin(bins));
+      grid->SetEntries(grid->GetEntries() + 1);
+    }
+  }
+
   template <o2::track::PID::ID id>
   void makeMCHistograms(const bool doMakeHistograms)
   {
@@ -701,6 +773,10 @@ struct QaEfficiency {
     histos.add("MC/trackLength", "Track length;Track length (cm)", kTH1D, {{2000, -1000, 1000}});
 
     listEfficiencyMC.setObject(new TList);
+    if (doDenseGrid) {
+      makeDenseGrids();
+      return;
+    }
     makeMCHistograms<o2::track::PID::Electron>(doEl);
     makeMCHistograms<o2::track::PID::Muon>(doMu);
     makeMCHistograms<o2::track::PID::Pion>(doPi);
@@ -1116,25 +1192,24 @@ struct QaEfficiency {
   }
 
   // MC process
+  o2::dpg::IndexBitmap recoEvt; // McCollisions with a selected reconstructed collision
   void processMC(const o2::aod::McParticles& mcParticles,
                  const o2::soa::Join<o2::aod::Collisions, o2::aod::McCollisionLabels, o2::aod::EvSels>& collisions,
                  const o2::soa::Join<o2::aod::Tracks, o2::aod::TracksExtra, o2::aod::McTrackLabels, o2::aod::TrackSelection>& tracks,
-                 const o2::aod::McCollisions&)
+                 const o2::aod::McCollisions& mcCollisions)
   {
 
-    std::vector<int64_t> recoEvt(collisions.size());
-    int nevts = 0;
+    recoEvt.reset(mcCollisions);
     for (const auto& collision : collisions) {
       if (!isCollisionSelected<false>(collision)) {
         continue;
       }
-      recoEvt[nevts++] = collision.mcCollision().globalIndex();
+      recoEvt.set(collision.mcCollision().globalIndex());
     }
-    recoEvt.resize(nevts);
 
     auto rejectParticle = [&](const auto& p, auto h, const int& offset = 0) {
       histos.fill(h, 1 + offset);
-      const auto evtReconstructed = std::find(recoEvt.begin(), recoEvt.end(), p.mcCollision().globalIndex()) != recoEvt.end();
+      const auto evtReconstructed = recoEvt.test(p.mcCollisionId());
       if (!evtReconstructed) { // Check that the event is reconstructed
         return true;
       }
@@ -1196,6 +1271,17 @@ struct QaEfficiency {
       histos.fill(HIST("MC/trackSelection"), 10);
       // Filling variable histograms
       histos.fill(HIST("MC/trackLength"), track.length());
+      if (doDenseGrid) {
+        int bins[nDenseAxes];
+        getDenseBins(bins, mcParticle, mcParticle.pt(), mcParticle.eta(), mcParticle.phi());
+        fillDenseGrid(denseNum.get(), bins, mcParticle.pdgCode());
+        if (track.hasTOF()) {
+          fillDenseGrid(denseNumTof.get(), bins, mcParticle.pdgCode());
+        }
+        getDenseBins(bins, mcParticle, track.pt(), track.eta(), track.phi());
+        fillDenseGrid(denseNumTrk.get(), bins, mcParticle.pdgCode());
+        continue;
+      }
       if (doEl) {
         fillMCTrackHistograms<0, o2::track::PID::Electron>(track);
         fillMCTrackHistograms<1, o2::track::PID::Electron>(track);
@@ -1256,6 +1342,12 @@ struct QaEfficiency {
       if (rejectParticle(mcParticle, HIST("MC/particleSelection"))) {
         continue;
       }
+      if (doDenseGrid) {
+        int bins[nDenseAxes];
+        getDenseBins(bins, mcParticle, mcParticle.pt(), mcParticle.eta(), mcParticle.phi());
+        fillDenseGrid(denseDen.get(), bins, mcParticle.pdgCode());
+        continue;
+      }
 
       if (doEl) {
         fillMCParticleHistograms<0, o2::track::PID::Electron>(mcParticle);
@@ -1309,6 +1401,9 @@ struct QaEfficiency {
       }
     }
     histos.fill(HIST("MC/eventMultiplicity"), dNdEta * 0.5f / 2.f);
+    if (doDenseGrid) { // efficiencies from the projections of the grids
+      return;
+    }
 
     // Fill TEfficiencies
     if (doEl) {
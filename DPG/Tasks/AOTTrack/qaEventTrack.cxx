@@ -21,6 +21,7 @@
 ///
 
 #include "qaEventTrack.h"
+#include "qaIndexBitmap.h"
 
 #include "Framework/AnalysisTask.h"
 #include "Framework/HistogramRegistry.h"
@@ -33,6 +34,7 @@
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/TableProducer/PID/pidTOFBase.h"
+#include "PWGMM/Mult/Core/denseCounts.h"
 
 #include "string"
 
@@ -72,6 +74,7 @@ struct qaEventTrack {
   Configurable<float> maxEta{"maxEta", 2.0f, "Maximum eta of accepted tracks"};
   Configurable<float> minPhi{"minPhi", -1.f, "Minimum phi of accepted tracks"};
   Configurable<float> maxPhi{"maxPhi", 10.f, "Maximum phi of accepted tracks"};
+  Configurable<std::vector<int>> multiTrackSelections{"multiTrackSelections", {1, 2, 3, 4, 5}, "Track selections (as in trackSelection, at most 32) filled in one pass by processDataMultiSelection"};
 
   // configurable binning of histograms
   ConfigurableAxis binsPt{"binsPt", {VARIABLE_WIDTH, 0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5, 2.0, 5.0, 10.0, 20.0, 50.0}, ""};
@@ -108,11 +111,29 @@ struct qaEventTrack {
   Preslice<aod::McParticles> perMcCollision = aod::mcparticle::mcCollisionId;
   Preslice<aod::Tracks> perRecoCollision = aod::track::collisionId;
 
+  // histograms of processDataMultiSelection, vs the position of the track selection in multiTrackSelections
+  enum MultiSelectionVariable {
+    kMultiSelPt = 0,
+    kMultiSelEta,
+    kMultiSelPhi,
+    kMultiSelDcaXY,
+    kMultiSelDcaZ,
+    kMultiSelITSNCls,
+    kMultiSelITSChi2NCl,
+    kMultiSelTPCNClsFound,
+    kMultiSelTPCCrossedRows,
+    kMultiSelTPCChi2NCl,
+    kNMultiSelVariables
+  };
+  std::array<o2::analysis::mult::DenseCounts2D, kNMultiSelVariables> multiSelCounts; // counts of the data frame, added to the histograms at its end
+  o2::dpg::IndexBitmap multiSelCollisions;                                          // selected collisions
+  std::vector<int> multiSelNTracks;                                                 // number of tracks per collision and track selection
+
   // constexpr char* strAllFilteredTracks = "KineUnmatchTracks";
   // constexpr char* strAllUnfilteredTracks = "KineUnmatchUnfilteredTracks";
   void init(InitContext const&)
   {
-    if (!doprocessData && !doprocessMC && !doprocessDataIU && !doprocessDataIUFiltered && !doprocessRun2ConvertedData && !doprocessRun2ConvertedMC) {
+    if (!doprocessData && !doprocessMC && !doprocessDataIU && !doprocessDataIUFiltered && !doprocessRun2ConvertedData && !doprocessRun2ConvertedMC && !doprocessDataMultiSelection) {
       LOGF(info, "No enabled QA, all histograms are disabled");
       return;
     }
@@ -313,6 +334,38 @@ struct qaEventTrack {
     histos.add("Tracks/TPC/tpcChi2NCl", "chi2 per cluster in TPC;chi2 / cluster TPC", kTH1D, {{100, 0, 10}});
     histos.add("Tracks/TPC/hasTPC", "pt distribution of tracks crossing TPC", kTH1D, {axisPt});
 
+    // several track selections in one pass
+    if (doprocessDataMultiSelection) {
+      const int nSelections = multiTrackSelections->size();
+      if (nSelections > 32) {
+        LOGF(fatal, "At most 32 track selections in multiTrackSelections, %d given", nSelections);
+      }
+      static constexpr const char* selectionNames[6] = {"No cut", "kGlobalTrack", "kGlobalTrackWoPtEta", "kGlobalTrackWoDCA", "kQualityTracks", "kInAcceptanceTracks"};
+      const AxisSpec axisSelection{nSelections, -0.5, nSelections - 0.5, "track selection"};
+      auto setSelectionLabels = [&](TAxis* axis) {
+        for (int i = 0; i < nSelections; i++) {
+          const int selection = multiTrackSelections->at(i);
+          axis->SetBinLabel(i + 1, (selection >= 0 && selection < 6) ? selectionNames[selection] : "unknown");
+        }
+      };
+      auto addMultiSel = [&](int variable, const char* name, const char* title, const AxisSpec& axis) {
+        auto h = histos.add<TH2>(Form("Tracks/MultiSel/%s", name), title, kTH2D, {axisSelection, axis});
+        setSelectionLabels(h->GetXaxis());
+        multiSelCounts[variable].setup(h);
+      };
+      addMultiSel(kMultiSelPt, "pt", "#it{p}_{T}", axisPt);
+      addMultiSel(kMultiSelEta, "eta", "#eta", axisEta);
+      addMultiSel(kMultiSelPhi, "phi", "#varphi", axisPhi);
+      addMultiSel(kMultiSelDcaXY, "dcaXY", "distance of closest approach in #it{xy} plane", {200, -0.15, 0.15, "#it{dcaXY} [cm]"});
+      addMultiSel(kMultiSelDcaZ, "dcaZ", "distance of closest approach in #it{z}", {200, -0.15, 0.15, "#it{dcaZ} [cm]"});
+      addMultiSel(kMultiSelITSNCls, "itsNCls", "number of found ITS clusters", {8, -0.5, 7.5, "# clusters ITS"});
+      addMultiSel(kMultiSelITSChi2NCl, "itsChi2NCl", "chi2 per ITS cluster", {100, 0, 40, "chi2 / cluster ITS"});
+      addMultiSel(kMultiSelTPCNClsFound, "tpcNClsFound", "number of found TPC clusters", {165, -0.5, 164.5, "# clusters TPC"});
+      addMultiSel(kMultiSelTPCCrossedRows, "tpcCrossedRows", "number of crossed TPC rows", {165, -0.5, 164.5, "# crossed rows TPC"});
+      addMultiSel(kMultiSelTPCChi2NCl, "tpcChi2NCl", "chi2 per cluster in TPC", {100, 0, 10, "chi2 / cluster TPC"});
+      setSelectionLabels(histos.add<TH2>("Events/MultiSel/nTracks", "", kTH2D, {axisSelection, axisTrackMultiplicity})->GetXaxis());
+    }
+
     // tracks vs tracks @ IU
     if (doprocessDataIU) {
       // Full distributions
@@ -435,6 +488,27 @@ struct qaEventTrack {
     return true;
   }
 
+  // Function to evaluate one of the track selections of trackSelection
+  template <typename T>
+  bool passesTrackSelection(const T& track, int selection)
+  {
+    switch (selection) {
+      case 0:
+        return true;
+      case 1:
+        return track.isGlobalTrack();
+      case 2:
+        return track.isGlobalTrackWoPtEta();
+      case 3:
+        return track.isGlobalTrackWoDCA();
+      case 4:
+        return track.isQualityTrack();
+      case 5:
+        return track.isInAcceptanceTrack();
+    }
+    return false;
+  }
+
   // Function to select collisions
   template <bool doFill, typename T>
   bool isSelectedCollision(const T& collision)
@@ -573,6 +647,62 @@ struct qaEventTrack {
   }
   PROCESS_SWITCH(qaEventTrack, processDataIUFiltered, "process IU filtered", true);
 
+  // Process function for several track selections in one pass over the tracks
+  void processDataMultiSelection(CollisionTableData const& collisions, TrackTableData const& tracks)
+  {
+    multiSelCollisions.reset(collisions);
+    for (const auto& collision : collisions) {
+      if (isSelectedCollision<false>(collision)) {
+        multiSelCollisions.set(collision.globalIndex());
+      }
+    }
+    const auto& selections = multiTrackSelections.value;
+    const int nSelections = selections.size();
+    multiSelNTracks.assign(collisions.size() * nSelections, 0);
+
+    for (const auto& track : tracks) {
+      if (!track.has_collision() || !multiSelCollisions.test(track.collisionId()) || !isSelectedTrack<false>(track)) {
+        continue;
+      }
+      // bit i for the track selection at position i of multiTrackSelections
+      uint32_t selectionMask = 0;
+      for (int i = 0; i < nSelections; i++) {
+        if (passesTrackSelection(track, selections[i])) {
+          selectionMask |= 1u << i;
+        }
+      }
+      if (selectionMask == 0) {
+        continue;
+      }
+      const std::array<float, kNMultiSelVariables> values{track.pt(), track.eta(), track.phi(),
+                                                          track.dcaXY(), track.dcaZ(),
+                                                          static_cast<float>(track.itsNCls()), track.itsChi2NCl(),
+                                                          static_cast<float>(track.tpcNClsFound()), static_cast<float>(track.tpcNClsCrossedRows()), track.tpcChi2NCl()};
+      for (int i = 0; i < nSelections; i++) {
+        if (!(selectionMask & (1u << i))) {
+          continue;
+        }
+        multiSelNTracks[(track.collisionId() - collisions.offset()) * nSelections + i]++;
+        for (int variable = 0; variable < kNMultiSelVariables; variable++) {
+          multiSelCounts[variable].fill(i, values[variable]);
+        }
+      }
+    }
+
+    for (auto& counts : multiSelCounts) {
+      counts.flush();
+    }
+    for (const auto& collision : collisions) {
+      if (!multiSelCollisions.test(collision.globalIndex())) {
+        continue;
+      }
+      for (int i = 0; i < nSelections; i++) {
+        histos.fill(HIST("Events/MultiSel/nTracks"), i, multiSelNTracks[(collision.globalIndex() - collisions.offset()) * nSelections + i]);
+      }
+    }
+  }
+  PROCESS_SWITCH(qaEventTrack, processDataMultiSelection, "process several track selections in one pass", false);
+
   // Process function for MC
   using CollisionTableMC = soa::Join<CollisionTableData, aod::McCollisionLabels>;
   using TrackTableMC = soa::Join<TrackTableData, aod::McTrackLabels>;
@@ -18,6 +18,7 @@
 ///
 
 #include "qaEventTrack.h"
+#include "qaIndexBitmap.h"
 
 #include "Framework/AnalysisTask.h"
 #include "Framework/HistogramRegistry.h"
@@ -187,7 +188,8 @@ struct qaEventTrackLiteProducer {
    * Fill reco level tables.
    */
   //**************************************************************************************************
-  int nTableEventCounter = 0; // Number of processed events
+  int nTableEventCounter = 0;          // Number of processed events
+  o2::dpg::IndexBitmap recoPartIndices; // McParticles of the collision matched to the selected tracks
   template <bool IS_MC, typename C, typename T, typename P>
   void fillDerivedTable(const C& collision, const T& tracks, const P& particles, const aod::BCs&)
   {
@@ -218,12 +220,16 @@ struct qaEventTrackLiteProducer {
       ++nTracks;
     }
     tableTracks.reserve(nTracks);
-    std::vector<int64_t> recoPartIndices(IS_MC ? nTracks : 0);
 
     if constexpr (IS_MC) { // Running only on MC
       tableRecoParticles.reserve(nTracks);
+      // only the particles of the MC collision are looked up
+      if (collision.has_mcCollision()) {
+        recoPartIndices.reset(particles.sliceBy(perMcCollision, collision.mcCollision().globalIndex()));
+      } else {
+        recoPartIndices.reset(0, 0);
+      }
     }
-    int64_t iTrack = 0;
     for (const auto& track : tracks) {
       if (!isSelectedTrack<IS_MC>(track)) {
         continue;
@@ -242,7 +248,7 @@ struct qaEventTrackLiteProducer {
       if constexpr (IS_MC) { // Running only on MC
         if (track.has_mcParticle()) {
           auto particle = track.mcParticle();
-          recoPartIndices[iTrack++] = particle.globalIndex();
+          recoPartIndices.set(particle.globalIndex());
           if (particle.isPhysicalPrimary()) {
             particleProduction = 0;
           } else if (particle.getProcess() == 4) {
@@ -267,8 +273,7 @@ struct qaEventTrackLiteProducer {
       const auto& particlesInCollision = particles.sliceBy(perMcCollision, collision.mcCollision().globalIndex());
       tableNonRecoParticles.reserve(particlesInCollision.size() - nTracks);
       for (const auto& particle : particlesInCollision) {
-        const auto partReconstructed = std::find(recoPartIndices.begin(), recoPartIndices.end(), particle.globalIndex()) != recoPartIndices.end();
-        if (partReconstructed) {
+        if (recoPartIndices.test(particle.globalIndex())) {
           continue;
         }
         if (particle.isPhysicalPrimary()) {
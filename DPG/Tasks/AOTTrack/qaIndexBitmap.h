@@ -0,0 +1,75 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   qaIndexBitmap.h
+/// \brief  Set of global indices of a table (e.g. the McParticles matched to the tracks) as a bitmap,
+///         for constant-time lookups instead of searching vectors of indices.
+///
+
+#ifndef DPG_TASKS_AOTTRACK_QAINDEXBITMAP_H_
+#define DPG_TASKS_AOTTRACK_QAINDEXBITMAP_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace o2::dpg
+{
+
+/// Bitmap over the global indices [first, first + size)
+class IndexBitmap
+{
+ public:
+  /// Clears the bitmap and sets its range.
+  void reset(int64_t first, int64_t size)
+  {
+    mFirst = first;
+    mSize = size > 0 ? size : 0;
+    mWords.assign((mSize + 63) / 64, 0);
+  }
+
+  /// Clears the bitmap and sets its range to the rows of a table or of a slice of it.
+  template <typename T>
+  void reset(T const& table)
+  {
+    reset(table.offset(), table.size());
+  }
+
+  /// \return false if the index is outside the range, in which case it is not stored
+  bool set(int64_t index)
+  {
+    const int64_t position = index - mFirst;
+    if (position < 0 || position >= mSize) {
+      return false;
+    }
+    mWords[position / 64] |= uint64_t{1} << (position % 64);
+    return true;
+  }
+
+  /// \return whether the index was set, false for the indices outside the range
+  bool test(int64_t index) const
+  {
+    const int64_t position = index - mFirst;
+    if (position < 0 || position >= mSize) {
+      return false;
+    }
+    return (mWords[position / 64] >> (position % 64)) & 1;
+  }
+
+ private:
+  int64_t mFirst = 0;           ///< first global index of the range
+  int64_t mSize = 0;            ///< number of indices of the range
+  std::vector<uint64_t> mWords; ///< bits of the indices
+};
+
+} // namespace o2::dpg
+
+#endif // DPG_TASKS_AOTTRACK_QAINDEXBITMAP_H_
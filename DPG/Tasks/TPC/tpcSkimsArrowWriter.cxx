@@ -0,0 +1,154 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file tpcSkimsArrowWriter.cxx
+/// \brief Task writing the TPC PID calibration skims and the DPG track tables to Arrow IPC stream files
+///
+/// Each table is appended to its own file (<outputPrefix>_<table>.arrows), one set of record batches of at most
+/// chunkSize rows per data frame. The batches are uncompressed, so that the files can be memory-mapped and read
+/// without copies (e.g. pyarrow.ipc.open_stream(pyarrow.memory_map(fileName))). The stream format is used
+/// instead of the file format since it has no footer: the files stay readable if the workflow is not closed cleanly.
+///
+/// O2
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+/// O2Physics
+#include "DPG/Tasks/AOTTrack/qaEventTrack.h"
+#include "tpcSkimsTableCreator.h"
+#include <memory>
+#include <string>
+
+using namespace o2;
+using namespace o2::framework;
+
+/// Arrow IPC stream of one table, opened at the first data frame with rows
+class SkimArrowStream
+{
+ public:
+  ~SkimArrowStream() { close(); }
+
+  /// Appends the rows of a data frame as record batches of at most chunkSize rows.
+  void write(std::shared_ptr<arrow::Table> const& table, std::string const& fileName, int64_t chunkSize)
+  {
+    if (table->num_rows() == 0) {
+      return;
+    }
+    if (!mWriter) {
+      auto file = arrow::io::FileOutputStream::Open(fileName);
+      if (!file.ok()) {
+        LOG(fatal) << "Cannot open " << fileName << ": " << file.status().ToString();
+      }
+      mFile = *file;
+      auto writer = arrow::ipc::MakeStreamWriter(mFile, table->schema());
+      if (!writer.ok()) {
+        LOG(fatal) << "Cannot write the Arrow stream " << fileName << ": " << writer.status().ToString();
+      }
+      mWriter = *writer;
+      LOG(info) << "Writing the skims to " << fileName;
+    }
+    arrow::TableBatchReader reader(*table);
+    reader.set_chunksize(chunkSize);
+    std::shared_ptr<arrow::RecordBatch> batch;
+    while (true) {
+      auto status = reader.ReadNext(&batch);
+      if (!status.ok()) {
+        LOG(fatal) << "Cannot read the batches of " << fileName << ": " << status.ToString();
+      }
+      if (!batch) {
+        break;
+      }
+      status = mWriter->WriteRecordBatch(*batch);
+      if (!status.ok()) {
+        LOG(fatal) << "Cannot write to " << fileName << ": " << status.ToString();
+      }
+    }
+    // the batches of the data frame are readable even if the stream is not closed
+    auto status = mFile->Flush();
+    if (!status.ok()) {
+      LOG(error) << "Cannot flush " << fileName << ": " << status.ToString();
+    }
+  }
+
+  void close()
+  {
+    if (mWriter) {
+      (void)mWriter->Close();
+      mWriter.reset();
+    }
+    if (mFile) {
+      (void)mFile->Close();
+      mFile.reset();
+    }
+  }
+
+ private:
+  std::shared_ptr<arrow::io::FileOutputStream> mFile = nullptr;     ///< output file
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> mWriter = nullptr; ///< stream writer, null until the first rows
+};
+
+struct TpcSkimsArrowWriter {
+  Configurable<std::string> outputPrefix{"outputPrefix", "skims", "Prefix of the output files, one per table: <prefix>_<table>.arrows"};
+  Configurable<int64_t> chunkSize{"chunkSize", 65536, "Maximum number of rows of the record batches"};
+
+  SkimArrowStream streamTPCV0;
+  SkimArrowStream streamTPCTOF;
+  SkimArrowStream streamDPGCollisions;
+  SkimArrowStream streamDPGTracks;
+  SkimArrowStream streamDPGRecoParticles;
+  SkimArrowStream streamDPGNonRecoParticles;
+
+  void init(o2::framework::InitContext&)
+  {
+    if (chunkSize <= 0) {
+      LOG(fatal) << "chunkSize must be positive";
+    }
+  }
+
+  std::string fileName(std::string const& table) const
+  {
+    return outputPrefix.value + "_" + table + ".arrows";
+  }
+
+  void processTPCV0(aod::SkimmedTPCV0Tree const& rows)
+  {
+    streamTPCV0.write(rows.asArrowTable(), fileName("SkimmedTPCV0Tree"), chunkSize);
+  }
+  PROCESS_SWITCH(TpcSkimsArrowWriter, processTPCV0, "Write the V0 skims of pid-tpc-skimscreation", false);
+
+  void processTPCTOF(aod::SkimmedTPCTOFTree const& rows)
+  {
+    streamTPCTOF.write(rows.asArrowTable(), fileName("SkimmedTPCTOFTree"), chunkSize);
+  }
+  PROCESS_SWITCH(TpcSkimsArrowWriter, processTPCTOF, "Write the TPC-TOF skims of pid-tpc-skimscreation", false);
+
+  void processDPGTracks(aod::DPGCollisions const& collisions, aod::DPGTracks const& tracks)
+  {
+    streamDPGCollisions.write(collisions.asArrowTable(), fileName("DPGCollisions"), chunkSize);
+    streamDPGTracks.write(tracks.asArrowTable(), fileName("DPGTracks"), chunkSize);
+  }
+  PROCESS_SWITCH(TpcSkimsArrowWriter, processDPGTracks, "Write the collisions and tracks of qa-event-track-lite-producer", false);
+
+  void processDPGParticles(aod::DPGRecoParticles const& recoParticles, aod::DPGNonRecoParticles const& nonRecoParticles)
+  {
+    streamDPGRecoParticles.write(recoParticles.asArrowTable(), fileName("DPGRecoParticles"), chunkSize);
+    streamDPGNonRecoParticles.write(nonRecoParticles.asArrowTable(), fileName("DPGNonRecoParticles"), chunkSize);
+  }
+  PROCESS_SWITCH(TpcSkimsArrowWriter, processDPGParticles, "Write the MC particles of qa-event-track-lite-producer", false);
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<TpcSkimsArrowWriter>(cfgc)};
+}
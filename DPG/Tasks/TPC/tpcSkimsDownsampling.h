@@ -0,0 +1,106 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file tpcSkimsDownsampling.h
+/// \brief Deterministic pT dependent downsampling of the TPC skims
+///
+/// The acceptance of a track only depends on (run, global track index, species) and on its pT,
+/// so the skims do not depend on how the input is split into jobs.
+
+#ifndef DPG_TASKS_TPC_TPCSKIMSDOWNSAMPLING_H_
+#define DPG_TASKS_TPC_TPCSKIMSDOWNSAMPLING_H_
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace o2::tpcskims
+{
+
+/// \return number uniformly distributed in [0, 1) from the key, splitmix64 finalizer
+inline double hashUniform(uint64_t run, uint64_t globalIndex, uint64_t species)
+{
+  uint64_t x = (run << 40) ^ globalIndex ^ (species << 56);
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x = x ^ (x >> 31);
+  return (x >> 11) * 0x1.0p-53;
+}
+
+/// Tsallis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
+/// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
+inline double tsalisCharged(double pt, double mass, double sqrts)
+{
+  const double a = 6.81, b = 59.24;
+  const double c = 0.082, d = 0.151;
+  const double mt = std::sqrt(mass * mass + pt * pt);
+  const double n = a + b / sqrts;
+  const double T = c + d / sqrts;
+  const double p0 = n * T;
+  return std::pow((1. + mt / p0), -n);
+}
+
+/// Downsampling weights of one species, tabulated in pT
+class TsalisDownsampling
+{
+ public:
+  /// \param ptMax  upper edge of the table, the weights above are computed on demand
+  /// \param nBins  number of pT bins of the table
+  void init(double mass, double sqrts, double ptMax = 20., int nBins = 4000)
+  {
+    mMass = mass;
+    mSqrts = sqrts;
+    mProbNorm = tsalisCharged(1., mass, sqrts);
+    mPtMax = ptMax;
+    mInvBinWidth = nBins / ptMax;
+    mWeights.resize(nBins + 1);
+    for (int i = 0; i <= nBins; i++) {
+      mWeights[i] = computeWeight(i / mInvBinWidth);
+    }
+  }
+
+  /// \return weight of the acceptance at pT, linear interpolation of the table
+  double weight(double pt) const
+  {
+    if (pt < 0. || pt >= mPtMax) {
+      return computeWeight(pt);
+    }
+    const double x = pt * mInvBinWidth;
+    const int bin = static_cast<int>(x);
+    const double f = x - bin;
+    return mWeights[bin] + f * (mWeights[bin + 1] - mWeights[bin]);
+  }
+
+  /// \return whether the track is kept, factor1Pt being the fraction kept at 1 GeV/c
+  bool accept(double pt, double factor1Pt, double u) const
+  {
+    return u * weight(pt) < factor1Pt;
+  }
+
+ private:
+  double computeWeight(double pt) const
+  {
+    const double prob = tsalisCharged(pt, mMass, mSqrts) * pt;
+    return (prob / mProbNorm) * pt * pt;
+  }
+
+  double mMass = 0.;
+  double mSqrts = 0.;
+  double mProbNorm = 1.;
+  double mPtMax = 0.;
+  double mInvBinWidth = 0.;
+  std::vector<double> mWeights{}; ///< weights at the bin edges
+};
+
+} // namespace o2::tpcskims
+
+#endif // DPG_TASKS_TPC_TPCSKIMSDOWNSAMPLING_H_
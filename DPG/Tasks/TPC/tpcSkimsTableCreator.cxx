@@ -29,8 +29,8 @@
 #include "Common/DataModel/EventSelection.h"
 
 #include "tpcSkimsTableCreator.h"
-/// ROOT
-#include "TRandom3.h"
+#include "tpcSkimsDownsampling.h"
+#include <array>
 #include <cmath>
 
 using namespace o2;
@@ -124,7 +124,7 @@ struct TreeWriterTpcV0 {
       return false;
     }
     /// Pion downsampling
-    if (downsamplingTsalisPions > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion]) == 0) {
+    if (downsamplingTsalisPions > 0. && downsampleTsalisCharged(track, downsamplingTsalisPions, o2::track::PID::Pion) == 0) {
       return false;
     }
     return true;
@@ -165,7 +165,7 @@ struct TreeWriterTpcV0 {
       return false;
     }
     /// Proton downsampling
-    if (downsamplingTsalisProtons > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton]) == 0) {
+    if (downsamplingTsalisProtons > 0. && downsampleTsalisCharged(track, downsamplingTsalisProtons, o2::track::PID::Proton) == 0) {
       return false;
     }
     return true;
@@ -235,7 +235,7 @@ struct TreeWriterTpcV0 {
   bool selectionElectron(T const& track)
   {
     /// Electron downsampling
-    if (downsamplingTsalisElectrons > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisElectrons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Electron]) == 0) {
+    if (downsamplingTsalisElectrons > 0. && downsampleTsalisCharged(track, downsamplingTsalisElectrons, o2::track::PID::Electron) == 0) {
       return false;
     }
     return true;
@@ -285,31 +285,16 @@ struct TreeWriterTpcV0 {
     }
   };
 
-  double tsalisCharged(double pt, double mass, double sqrts)
-  {
-    const double a = 6.81, b = 59.24;
-    const double c = 0.082, d = 0.151;
-    const double mt = std::sqrt(mass * mass + pt * pt);
-    const double n = a + b / sqrts;
-    const double T = c + d / sqrts;
-    const double p0 = n * T;
-    const double result = std::pow((1. + mt / p0), -n);
-    return result;
-  };
-
-  /// Random downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
+  /// Downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
   /// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
-  TRandom3* fRndm = new TRandom3(0);
-  int downsampleTsalisCharged(double pt, double factor1Pt, double sqrts, double mass)
+  /// The random number is a hash of (run, global track index, species), so the skims do not depend on the job splitting
+  std::array<o2::tpcskims::TsalisDownsampling, o2::track::PID::NIDs> tsalisDownsampling;
+  int runNumber = 0;
+  template <typename T>
+  int downsampleTsalisCharged(T const& track, double factor1Pt, const o2::track::PID::ID id)
   {
-    const double prob = tsalisCharged(pt, mass, sqrts) * pt;
-    const double probNorm = tsalisCharged(1., mass, sqrts);
-    int triggerMask = 0;
-    if ((fRndm->Rndm() * ((prob / probNorm) * pt * pt)) < factor1Pt) {
-      triggerMask = 1;
-    }
-
-    return triggerMask;
+    const double u = o2::tpcskims::hashUniform(runNumber, track.globalIndex(), id);
+    return tsalisDownsampling[id].accept(track.pt(), factor1Pt, u) ? 1 : 0;
   };
 
   /// Event selection
@@ -330,14 +315,18 @@ struct TreeWriterTpcV0 {
 
   void init(o2::framework::InitContext& initContext)
   {
+    for (int id = 0; id < o2::track::PID::NIDs; id++) {
+      tsalisDownsampling[id].init(o2::track::pid_constants::sMasses[id], sqrtSNN);
+    }
   }
 
-  void process(Coll::iterator const& collision, Trks const& tracks, aod::V0Datas const& v0s)
+  void process(Coll::iterator const& collision, Trks const& tracks, aod::V0Datas const& v0s, aod::BCs const&)
   {
     /// Check event slection
     if (!isEventSelected(collision, tracks)) {
       return;
     }
+    runNumber = collision.bc_as<aod::BCs>().runNumber();
 
     rowTPCTree.reserve(tracks.size());
 
@@ -420,33 +409,19 @@ struct TreeWriterTPCTOF {
   Configurable<float> downsamplingTsalisKaons{"downsamplingTsalisKaons", -1., "Downsampling factor to reduce the number of kaons"};
   Configurable<float> downsamplingTsalisPions{"downsamplingTsalisPions", -1., "Downsampling factor to reduce the number of pions"};
 
-  double tsalisCharged(double pt, double mass, double sqrts)
-  {
-    const double a = 6.81, b = 59.24;
-    const double c = 0.082, d = 0.151;
-    double mt = std::sqrt(mass * mass + pt * pt);
-    double n = a + b / sqrts;
-    double T = c + d / sqrts;
-    double p0 = n * T;
-    double result = pow((1. + mt / p0), -n);
-    return result;
-  };
-
-  /// Random downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
+  /// Downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
   /// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
-  TRandom3* fRndm = new TRandom3(0);
-  bool downsampleTsalisCharged(double pt, float factor1Pt, double sqrts, double mass)
+  /// The random number is a hash of (run, global track index, species), so the skims do not depend on the job splitting
+  std::array<o2::tpcskims::TsalisDownsampling, o2::track::PID::NIDs> tsalisDownsampling;
+  int runNumber = 0;
+  template <typename T>
+  bool downsampleTsalisCharged(T const& track, float factor1Pt, const o2::track::PID::ID id)
   {
     if (factor1Pt < 0.) {
       return true;
     }
-    const double prob = tsalisCharged(pt, mass, sqrts) * pt;
-    const double probNorm = tsalisCharged(1., mass, sqrts);
-    if ((fRndm->Rndm() * ((prob / probNorm) * pt * pt)) > factor1Pt) {
-      return false;
-    } else {
-      return true;
-    }
+    const double u = o2::tpcskims::hashUniform(runNumber, track.globalIndex(), id);
+    return tsalisDownsampling[id].accept(track.pt(), factor1Pt, u);
   };
 
   /// Function to fill trees
@@ -514,13 +489,17 @@ struct TreeWriterTPCTOF {
 
   void init(o2::framework::InitContext& initContext)
   {
+    for (int id = 0; id < o2::track::PID::NIDs; id++) {
+      tsalisDownsampling[id].init(o2::track::pid_constants::sMasses[id], sqrtSNN);
+    }
   }
-  void process(Coll::iterator const& collision, Trks const& tracks)
+  void process(Coll::iterator const& collision, Trks const& tracks, aod::BCs const&)
   {
     /// Check event selection
     if (!isEventSelected(collision, tracks)) {
       return;
     }
+    runNumber = collision.bc_as<aod::BCs>().runNumber();
     rowTPCTOFTree.reserve(tracks.size());
     for (auto const& trk : tracks) {
 
@@ -529,21 +508,21 @@ struct TreeWriterTPCTOF {
         continue;
       }
       /// Fill tree for protons
-      if (trk.tpcInnerParam() < maxMomTPCOnlyPr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPCOnlyPr && downsampleTsalisCharged(trk.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton])) {
+      if (trk.tpcInnerParam() < maxMomTPCOnlyPr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPCOnlyPr && downsampleTsalisCharged(trk, downsamplingTsalisProtons, o2::track::PID::Proton)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPr && std::abs(trk.tofNSigmaPr()) < nSigmaTOF_TPCTOF_Pr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPC_TPCTOF_Pr && downsampleTsalisCharged(trk.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton])) {
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPr && std::abs(trk.tofNSigmaPr()) < nSigmaTOF_TPCTOF_Pr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPC_TPCTOF_Pr && downsampleTsalisCharged(trk, downsamplingTsalisProtons, o2::track::PID::Proton)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
       }
       /// Fill tree for kaons
-      if (trk.tpcInnerParam() < maxMomTPCOnlyKa && std::abs(trk.tpcNSigmaKa()) < nSigmaTPCOnlyKa && downsampleTsalisCharged(trk.pt(), downsamplingTsalisKaons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Kaon])) {
+      if (trk.tpcInnerParam() < maxMomTPCOnlyKa && std::abs(trk.tpcNSigmaKa()) < nSigmaTPCOnlyKa && downsampleTsalisCharged(trk, downsamplingTsalisKaons, o2::track::PID::Kaon)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyKa && std::abs(trk.tofNSigmaKa()) < nSigmaTOF_TPCTOF_Ka && std::abs(trk.tpcNSigmaKa()) < nSigmaTPC_TPCTOF_Ka && downsampleTsalisCharged(trk.pt(), downsamplingTsalisKaons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Kaon])) {
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyKa && std::abs(trk.tofNSigmaKa()) < nSigmaTOF_TPCTOF_Ka && std::abs(trk.tpcNSigmaKa()) < nSigmaTPC_TPCTOF_Ka && downsampleTsalisCharged(trk, downsamplingTsalisKaons, o2::track::PID::Kaon)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
       }
       /// Fill tree pions
-      if (trk.tpcInnerParam() < maxMomTPCOnlyPi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPCOnlyPi && downsampleTsalisCharged(trk.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion])) {
+      if (trk.tpcInnerParam() < maxMomTPCOnlyPi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPCOnlyPi && downsampleTsalisCharged(trk, downsamplingTsalisPions, o2::track::PID::Pion)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPi && std::abs(trk.tofNSigmaPi()) < nSigmaTOF_TPCTOF_Pi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPC_TPCTOF_Pi && downsampleTsalisCharged(trk.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion])) {
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPi && std::abs(trk.tofNSigmaPi()) < nSigmaTOF_TPCTOF_Pi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPC_TPCTOF_Pi && downsampleTsalisCharged(trk, downsamplingTsalisPions, o2::track::PID::Pion)) {
         fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
       }
     } /// Loop tracks
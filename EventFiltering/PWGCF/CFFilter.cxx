@@ -30,6 +30,7 @@
 #include "PWGCF/FemtoDream/FemtoDreamPairCleaner.h"
 #include "PWGCF/FemtoDream/FemtoDreamDetaDphiStar.h"
 #include "PWGCF/FemtoDream/FemtoDreamContainer.h"
+#include "PWGCF/FemtoDream/FemtoDreamTripletSearch.h"
 
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Multiplicity.h"
@@ -37,6 +38,7 @@
 #include <cmath>
 #include <string>
 #include <bitset>
+#include <vector>
 
 namespace
 {
@@ -89,6 +91,8 @@ struct CFFilter {
   Configurable<int> Q3Trigger{"Q3Trigger", 0, "Choice which trigger to run"};
   Configurable<float> ldeltaPhiMax{"ldeltaPhiMax", 0.010, "Max limit of delta phi"};
   Configurable<float> ldeltaEtaMax{"ldeltaEtaMax", 0.010, "Max limit of delta eta"};
+  Configurable<bool> confPruneTriplets{"ConfPruneTriplets", true, "Test only the triplets whose pairs are compatible with the Q3 limit (the same event Q3 distributions are then filled below the limit only)"};
+  Configurable<int> confMaxTriplets{"ConfMaxTriplets", -1, "Maximum number of triplets tested per event and charge (-1: no limit)"};
 
   // Obtain particle and antiparticle candidates of protons and lambda hyperons for current femto collision
   Partition<o2::aod::FemtoDreamParticles> partsProton0Part = (o2::aod::femtodreamparticle::partType == Track) && ((o2::aod::femtodreamparticle::cut & kSignPlusMask) > kValue0); // Consider later: && ((o2::aod::femtodreamparticle::pidcut & knSigmaProton) > kValue0);
@@ -103,6 +107,7 @@ struct CFFilter {
   FemtoDreamPairCleaner<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kV0> pairCleanerTV;
   FemtoDreamDetaDphiStar<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kTrack> closePairRejectionTT;
   FemtoDreamDetaDphiStar<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kV0> closePairRejectionTV0;
+  FemtoDreamTripletSearch tripletSearch;
 
   bool isPIDSelected(aod::femtodreamparticle::cutContainerType const& pidcut, std::vector<int> const& vSpecies, kDetector iDet = kDetector::kTPC)
   {
@@ -146,6 +151,12 @@ struct CFFilter {
     registry.add("fMultiplicityAfter", "Multiplicity of events which passed ppp trigger", HistType::kTH1F, {{1000, 0, 1000}});
     registry.add("fZvtxBefore", "Zvtx of all processed events", HistType::kTH1F, {{1000, -15, 15}});
     registry.add("fZvtxAfter", "Zvtx of events which passed ppp trigger", HistType::kTH1F, {{1000, -15, 15}});
+    registry.add("fTestedTriplets", "Triplets tested per event and charge;;triplets", HistType::kTH2F, {{2, -0.5, 1.5}, {1000, 0, 1000}});
+    registry.add("fCappedSearches", "Searches stopped at the maximum number of triplets;;events", HistType::kTH1F, {{2, -0.5, 1.5}});
+    for (int iBin = 0; iBin < 2; iBin++) {
+      registry.get<TH2>(HIST("fTestedTriplets"))->GetXaxis()->SetBinLabel(iBin + 1, CfTriggerNames[iBin].data());
+      registry.get<TH1>(HIST("fCappedSearches"))->GetXaxis()->SetBinLabel(iBin + 1, CfTriggerNames[iBin].data());
+    }
 
     if (Q3Trigger == 0 || Q3Trigger == 11) {
       registry.add("fSameEventPartPPP", "CF - same event ppp distribution for particles;;events", HistType::kTH1F, {{8000, 0, 8}});
@@ -170,6 +181,116 @@ struct CFFilter {
   float mMassProton = TDatabasePDG::Instance()->GetParticle(2212)->Mass();
   float mMassLambda = TDatabasePDG::Instance()->GetParticle(3122)->Mass();
 
+  /// Adds a particle to the inputs of the triplet search.
+  /// \param part  particle
+  /// \param mass  mass hypothesis
+  /// \param kinematics  four-momenta of the triplet search
+  template <typename T>
+  void addTripletParticle(T const& part, float mass, std::vector<TripletParticle>& kinematics)
+  {
+    kinematics.push_back({part.px(), part.py(), part.pz(), std::sqrt(part.p() * part.p() + mass * mass)});
+  }
+
+  /// Fills the statistics of the last triplet search.
+  /// \param trigger  kPPP or kPPL
+  /// \param isComplete  the search was not stopped at the maximum number of triplets
+  void fillTripletStatistics(int trigger, bool isComplete)
+  {
+    registry.get<TH2>(HIST("fTestedTriplets"))->Fill(trigger, tripletSearch.getNTriplets());
+    if (!isComplete) {
+      registry.get<TH1>(HIST("fCappedSearches"))->Fill(trigger);
+    }
+  }
+
+  /// Counts the ppp triplets of one charge below the Q3 limit.
+  /// \param partsProton  protons of the collision
+  /// \param partsFemto  all particles of the collision, for the close pair rejection
+  /// \param magneticField  magnetic field of the collision
+  /// \param q3Limit  Q3 limit of the trigger
+  /// \param histQ3  same event Q3 distribution
+  /// \return number of triplets below the limit
+  template <typename T>
+  int countPPP(T const& partsProton, o2::aod::FemtoDreamParticles const& partsFemto, float magneticField, float q3Limit, std::shared_ptr<TH1> const& histQ3)
+  {
+    std::vector<typename T::iterator> protons;
+    std::vector<TripletParticle> kinematics;
+    for (auto& part : partsProton) {
+      if (isFullPIDSelectedProton(part.pidcut(), part.p())) {
+        protons.push_back(part);
+        addTripletParticle(part, mMassProton, kinematics);
+      }
+    }
+    int lowQ3Triplets = 0;
+    bool isComplete = tripletSearch.searchIdentical(kinematics, [&](int i, int j, int l) {
+      auto const &p1 = protons[i], &p2 = protons[j], &p3 = protons[l];
+      // Think if pair cleaning is needed in current framework
+      // Run close pair rejection
+      if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
+        return;
+      }
+      if (closePairRejectionTT.isClosePair(p1, p3, partsFemto, magneticField)) {
+        return;
+      }
+      if (closePairRejectionTT.isClosePair(p2, p3, partsFemto, magneticField)) {
+        return;
+      }
+      auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, p3, mMassProton);
+      histQ3->Fill(Q3);
+      if (Q3 < q3Limit) {
+        lowQ3Triplets++;
+      }
+    });
+    fillTripletStatistics(kPPP, isComplete);
+    return lowQ3Triplets;
+  }
+
+  /// Counts the ppL triplets of one charge below the Q3 limit.
+  /// \param partsProton  protons of the collision
+  /// \param partsLambda  lambdas of the collision, with the QA of all lambdas already filled
+  /// \param partsFemto  all particles of the collision, for the pair cleaning and the close pair rejection
+  /// \param magneticField  magnetic field of the collision
+  /// \param q3Limit  Q3 limit of the trigger
+  /// \param histQ3  same event Q3 distribution
+  /// \return number of triplets below the limit
+  template <typename T>
+  int countPPL(T const& partsProton, T const& partsLambda, o2::aod::FemtoDreamParticles const& partsFemto, float magneticField, float q3Limit, std::shared_ptr<TH1> const& histQ3)
+  {
+    std::vector<typename T::iterator> protons, lambdas;
+    std::vector<TripletParticle> kinematicsProtons, kinematicsLambdas;
+    for (auto& part : partsProton) {
+      if (isFullPIDSelectedProton(part.pidcut(), part.p())) {
+        protons.push_back(part);
+        addTripletParticle(part, mMassProton, kinematicsProtons);
+      }
+    }
+    for (auto& partLambda : partsLambda) {
+      if (pairCleanerTV.isCleanPair(partLambda, partLambda, partsFemto)) {
+        lambdas.push_back(partLambda);
+        addTripletParticle(partLambda, mMassLambda, kinematicsLambdas);
+      }
+    }
+    int lowQ3Triplets = 0;
+    bool isComplete = tripletSearch.searchTwoPlusOne(kinematicsProtons, kinematicsLambdas, [&](int i, int j, int l) {
+      auto const &p1 = protons[i], &p2 = protons[j], &partLambda = lambdas[l];
+      if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
+        return;
+      }
+      if (closePairRejectionTV0.isClosePair(p1, partLambda, partsFemto, magneticField)) {
+        return;
+      }
+      if (closePairRejectionTV0.isClosePair(p2, partLambda, partsFemto, magneticField)) {
+        return;
+      }
+      auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, partLambda, mMassLambda);
+      histQ3->Fill(Q3);
+      if (Q3 < q3Limit) {
+        lowQ3Triplets++;
+      }
+    });
+    fillTripletStatistics(kPPL, isComplete);
+    return lowQ3Triplets;
+  }
+
   void process(o2::aod::FemtoDreamCollision& col, o2::aod::FemtoDreamParticles& partsFemto)
   {
     auto partsProton0 = partsProton0Part->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, col.globalIndex());
@@ -216,87 +337,27 @@ struct CFFilter {
       auto Q3TriggerLimit = (std::vector<float>)confQ3TriggerLimit;
       // TRIGGER FOR PPP TRIPLETS
       if (Q3Trigger == 0 || Q3Trigger == 11) {
+        tripletSearch.init(confPruneTriplets ? Q3TriggerLimit.at(0) : -1.f, confMaxTriplets);
         if (partsProton0.size() >= 3) {
-          for (auto& [p1, p2, p3] : combinations(partsProton0, partsProton0, partsProton0)) {
-            if (!isFullPIDSelectedProton(p1.pidcut(), p1.p()) || !isFullPIDSelectedProton(p2.pidcut(), p2.p()) || !isFullPIDSelectedProton(p3.pidcut(), p3.p())) {
-              continue;
-            }
-            // Think if pair cleaning is needed in current framework
-            // Run close pair rejection
-            if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
-              continue;
-            }
-            if (closePairRejectionTT.isClosePair(p1, p3, partsFemto, magneticField)) {
-              continue;
-            }
-            if (closePairRejectionTT.isClosePair(p2, p3, partsFemto, magneticField)) {
-              continue;
-            }
-            auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, p3, mMassProton);
-            registry.get<TH1>(HIST("fSameEventPartPPP"))->Fill(Q3);
-            if (Q3 < Q3TriggerLimit.at(0)) {
-              lowQ3Triplets[0]++;
-            }
-          }
+          lowQ3Triplets[0] += countPPP(partsProton0, partsFemto, magneticField, Q3TriggerLimit.at(0), registry.get<TH1>(HIST("fSameEventPartPPP")));
         } // end if
 
         // if (lowQ3Triplets[0] == 0) // Use this in final version only, for testing comment { // if at least one triplet found in particles, no need to check antiparticles
         if (partsProton1.size() >= 3) {
-          for (auto& [p1, p2, p3] : combinations(partsProton1, partsProton1, partsProton1)) {
-
-            if (!isFullPIDSelectedProton(p1.pidcut(), p1.p()) || !isFullPIDSelectedProton(p2.pidcut(), p2.p()) || !isFullPIDSelectedProton(p3.pidcut(), p3.p())) {
-              continue;
-            }
-            // Think if pair cleaning is needed in current framework
-            // Run close pair rejection
-            if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
-              continue;
-            }
-            if (closePairRejectionTT.isClosePair(p1, p3, partsFemto, magneticField)) {
-              continue;
-            }
-            if (closePairRejectionTT.isClosePair(p2, p3, partsFemto, magneticField)) {
-              continue;
-            }
-            auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, p3, mMassProton);
-            registry.get<TH1>(HIST("fSameEventAntiPartPPP"))->Fill(Q3);
-            if (Q3 < Q3TriggerLimit.at(0)) {
-              lowQ3Triplets[0]++;
-            }
-          }
+          lowQ3Triplets[0] += countPPP(partsProton1, partsFemto, magneticField, Q3TriggerLimit.at(0), registry.get<TH1>(HIST("fSameEventAntiPartPPP")));
         } // end if
         //}
       }
       // __________________________________________________________________________________________________________
       // TRIGGER FOR PPL TRIPLETS
       if (Q3Trigger == 1 || Q3Trigger == 11) {
+        tripletSearch.init(confPruneTriplets ? Q3TriggerLimit.at(1) : -1.f, confMaxTriplets);
         if (partsLambda0.size() >= 1 && partsProton0.size() >= 2) {
           for (auto& partLambda : partsLambda0) {
             registry.get<TH1>(HIST("fPtPPL"))->Fill(partLambda.pt());
             registry.get<TH1>(HIST("fMinvLambda"))->Fill(partLambda.mLambda());
-            if (!pairCleanerTV.isCleanPair(partLambda, partLambda, partsFemto)) {
-              continue;
-            }
-            for (auto& [p1, p2] : combinations(partsProton0, partsProton0)) {
-              if (!isFullPIDSelectedProton(p1.pidcut(), p1.p()) || !isFullPIDSelectedProton(p2.pidcut(), p2.p())) {
-                continue;
-              }
-              if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
-                continue;
-              }
-              if (closePairRejectionTV0.isClosePair(p1, partLambda, partsFemto, magneticField)) {
-                continue;
-              }
-              if (closePairRejectionTV0.isClosePair(p2, partLambda, partsFemto, magneticField)) {
-                continue;
-              }
-              auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, partLambda, mMassLambda);
-              registry.get<TH1>(HIST("fSameEventPartPPL"))->Fill(Q3);
-              if (Q3 < Q3TriggerLimit.at(1)) {
-                lowQ3Triplets[1]++;
-              }
-            }
           }
+          lowQ3Triplets[1] += countPPL(partsProton0, partsLambda0, partsFemto, magneticField, Q3TriggerLimit.at(1), registry.get<TH1>(HIST("fSameEventPartPPL")));
         } // end if
 
         if (lowQ3Triplets[1] == 0) { // if at least one triplet found in particles, no need to check antiparticles
@@ -304,29 +365,8 @@ struct CFFilter {
             for (auto& partLambda : partsLambda1) {
               registry.get<TH1>(HIST("fPtAntiPPL"))->Fill(partLambda.pt());
               registry.get<TH1>(HIST("fMinvAntiLambda"))->Fill(partLambda.mAntiLambda());
-              if (!pairCleanerTV.isCleanPair(partLambda, partLambda, partsFemto)) {
-                continue;
-              }
-              for (auto& [p1, p2] : combinations(partsProton1, partsProton1)) {
-                if (!isFullPIDSelectedProton(p1.pidcut(), p1.p()) || !isFullPIDSelectedProton(p2.pidcut(), p2.p())) {
-                  continue;
-                }
-                if (closePairRejectionTT.isClosePair(p1, p2, partsFemto, magneticField)) {
-                  continue;
-                }
-                if (closePairRejectionTV0.isClosePair(p1, partLambda, partsFemto, magneticField)) {
-                  continue;
-                }
-                if (closePairRejectionTV0.isClosePair(p2, partLambda, partsFemto, magneticField)) {
-                  continue;
-                }
-                auto Q3 = FemtoDreamMath::getQ3(p1, mMassProton, p2, mMassProton, partLambda, mMassLambda);
-                registry.get<TH1>(HIST("fSameEventAntiPartPPL"))->Fill(Q3);
-                if (Q3 < Q3TriggerLimit.at(1)) {
-                  lowQ3Triplets[1]++;
-                }
-              }
             }
+            lowQ3Triplets[1] += countPPL(partsProton1, partsLambda1, partsFemto, magneticField, Q3TriggerLimit.at(1), registry.get<TH1>(HIST("fSameEventAntiPartPPL")));
           } // end if
         }
       }
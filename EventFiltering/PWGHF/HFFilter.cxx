@@ -29,7 +29,9 @@
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <string>
 #include "Math/Vector3D.h"
 #include "Math/Vector4D.h"
@@ -37,6 +39,8 @@
 
 // ML application
 #include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+#include "Common/Core/OnnxSessionRegistry.h"
+#include "Common/Core/InitTimer.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -252,8 +256,10 @@ struct HfFilter { // Main struct for HF triggers
   Produces<aod::HfFilters> tags;
   Produces<aod::HFTrigTrain2P> train2P;
   Produces<aod::HFTrigTrain3P> train3P;
+  Produces<aod::HfCandLogs> candLog;
 
   Configurable<bool> activateQA{"activateQA", false, "flag to enable QA histos"};
+  Configurable<bool> fillCandLog{"fillCandLog", false, "flag to fill the decision log of the candidates, used by the trigger QC"};
 
   // parameters for high-pT triggers
   Configurable<float> pTThreshold2Prong{"pTThreshold2Prong", 8., "pT treshold for high pT 2-prong candidates for kHighPt triggers in GeV/c"};
@@ -292,6 +298,8 @@ struct HfFilter { // Main struct for HF triggers
   // parameters for ML application with ONNX
   Configurable<bool> singleThreadInference{"singleThreadInference", true, "Run ML inference single thread"};
   Configurable<bool> applyML{"applyML", false, "Flag to enable or disable ML application"};
+  Configurable<std::string> onnxCacheDir{"onnxCacheDir", "", "Directory of the optimised ONNX models, shared by the jobs with the same models; empty: disabled"};
+  Configurable<bool> timeInit{"timeInit", false, "Flag to print the time of the steps of init"};
   Configurable<std::vector<double>> pTBinsBDT{"pTBinsBDT", std::vector<double>{hf_cuts_bdt_multiclass::pTBinsVec}, "track pT bin limits for BDT cut"};
 
   Configurable<std::string> onnxFileD0ToKPiConf{"onnxFileD0ToKPiConf", "/cvmfs/alice.cern.ch/data/analysis/2022/vAN-20220124/PWGHF/o2/trigger/XGBoostModel.onnx", "ONNX file for ML model for D0 candidates"};
@@ -326,25 +334,29 @@ struct HfFilter { // Main struct for HF triggers
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScoreBkg{};
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScorePrompt{};
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScoreNonPrompt{};
+  std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTLatency{};
 
-  // ONNX
-  // Ort::Env env;
-  std::array<std::vector<std::string>, kNCharmParticles> inputNamesML{};
+  // ONNX, sessions from the process-wide registry
   std::array<std::vector<std::vector<int64_t>>, kNCharmParticles> inputShapesML{};
-  std::array<std::vector<std::string>, kNCharmParticles> outputNamesML{};
-  std::array<std::vector<std::vector<int64_t>>, kNCharmParticles> outputShapesML{};
-  std::array<std::shared_ptr<Ort::Experimental::Session>, kNCharmParticles> sessionML = {nullptr, nullptr, nullptr, nullptr, nullptr};
-  std::array<Ort::SessionOptions, kNCharmParticles> sessionOptions{Ort::SessionOptions(), Ort::SessionOptions(), Ort::SessionOptions(), Ort::SessionOptions(), Ort::SessionOptions()};
+  std::array<std::shared_ptr<o2::analysis::OnnxModel>, kNCharmParticles> modelML = {nullptr, nullptr, nullptr, nullptr, nullptr};
   std::array<int, kNCharmParticles> dataTypeML{};
-  std::array<Ort::Env, kNCharmParticles> env = {
-    Ort::Env{ORT_LOGGING_LEVEL_ERROR, "ml-model-d0-triggers"},
-    Ort::Env{ORT_LOGGING_LEVEL_ERROR, "ml-model-dplus-triggers"},
-    Ort::Env{ORT_LOGGING_LEVEL_ERROR, "ml-model-ds-triggers"},
-    Ort::Env{ORT_LOGGING_LEVEL_ERROR, "ml-model-lc-triggers"},
-    Ort::Env{ORT_LOGGING_LEVEL_ERROR, "ml-model-xic-triggers"}};
+  std::array<bool, kNCharmParticles> isBatchableML{};                        // whether the model accepts a variable number of candidates
+  std::array<std::array<double, 3>, kNCharmParticles> thresholdBDTValues{}; // BDT thresholds (bkg, prompt, nonprompt), read once from the configurables
+
+  // BDT buffers of the candidates of one collision, evaluated in one batch per model
+  std::array<std::vector<float>, kNCharmParticles> featuresBDT{};
+  std::vector<double> featuresBDTDouble{};
+  std::array<std::vector<float>, kNCharmParticles> scoresBDT{}; // 3 scores per scored candidate
+  std::array<std::vector<int8_t>, kNCharmParticles> tagsBDT{};  // BDT tag per scored candidate
+  std::array<std::vector<int>, kNCharmParticles> posBDT{};      // position of each candidate of the collision in the BDT buffers, -1 if not scored
+
+  o2::analysis::InitTimer initTimer;
 
   void init(o2::framework::InitContext&)
   {
+    if (timeInit) {
+      initTimer.enable("hf-filter");
+    }
     cutsSingleTrackBeauty = {cutsTrackBeauty3Prong, cutsTrackBeauty4Prong};
 
     hProcessedEvents = registry.add<TH1>("fProcessedEvents", "HF - event filtered;;counts", HistType::kTH1F, {{kNtriggersHF + 2, -0.5, kNtriggersHF + 1.5}});
@@ -364,6 +376,7 @@ struct HfFilter { // Main struct for HF triggers
           hBDTScoreBkg[iCharmPart] = registry.add<TH1>(Form("f%sBDTScoreBkgDistr", charmParticleNames[iCharmPart].data()), Form("BDT background score distribution for %s;BDT background score;counts", charmParticleNames[iCharmPart].data()), HistType::kTH1F, {{100, 0., 1.}});
           hBDTScorePrompt[iCharmPart] = registry.add<TH1>(Form("f%sBDTScorePromptDistr", charmParticleNames[iCharmPart].data()), Form("BDT prompt score distribution for %s;BDT prompt score;counts", charmParticleNames[iCharmPart].data()), HistType::kTH1F, {{100, 0., 1.}});
           hBDTScoreNonPrompt[iCharmPart] = registry.add<TH1>(Form("f%sBDTScoreNonPromptDistr", charmParticleNames[iCharmPart].data()), Form("BDT nonprompt score distribution for %s;BDT nonprompt score;counts", charmParticleNames[iCharmPart].data()), HistType::kTH1F, {{100, 0., 1.}});
+          hBDTLatency[iCharmPart] = registry.add<TH1>(Form("f%sBDTLatency", charmParticleNames[iCharmPart].data()), Form("BDT inference latency for %s;latency (#mus);counts", charmParticleNames[iCharmPart].data()), HistType::kTH1F, {{200, 0., 1000.}});
         }
       }
       hMassVsPtC[kNCharmParticles] = registry.add<TH2>("fMassVsPtDStar", "#it{M} vs. #it{p}_{T} distribution of triggered DStar candidates;#it{p}_{T} (GeV/#it{c});#it{M} (GeV/#it{c}^{2});counts", HistType::kTH2F, {{100, 0., 50.}, {300, 1.60, 2.60}});
@@ -392,26 +405,27 @@ struct HfFilter { // Main struct for HF triggers
 
       for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
         if (onnxFiles[iCharmPart] != "") {
+          auto step = initTimer.measure(Form("model %s", charmParticleNames[iCharmPart].data()));
+          o2::analysis::OnnxSessionSettings sessionSettings;
           if (singleThreadInference) {
-            sessionOptions[iCharmPart].SetIntraOpNumThreads(1);
-            sessionOptions[iCharmPart].SetInterOpNumThreads(1);
+            sessionSettings.nThreadsIntraOp = 1;
+            sessionSettings.nThreadsInterOp = 1;
           }
-          sessionML[iCharmPart].reset(new Ort::Experimental::Session{env[iCharmPart], onnxFiles[iCharmPart], sessionOptions[iCharmPart]});
-          inputNamesML[iCharmPart] = sessionML[iCharmPart]->GetInputNames();
-          inputShapesML[iCharmPart] = sessionML[iCharmPart]->GetInputShapes();
+          sessionSettings.modelCacheDir = onnxCacheDir.value;
+          modelML[iCharmPart] = o2::analysis::OnnxSessionRegistry::instance().getModel(onnxFiles[iCharmPart], sessionSettings);
+          modelML[iCharmPart]->setLatencyHistogram(hBDTLatency[iCharmPart]);
+          inputShapesML[iCharmPart] = modelML[iCharmPart]->inputShapes();
+          isBatchableML[iCharmPart] = inputShapesML[iCharmPart][0][0] < 0;
           if (inputShapesML[iCharmPart][0][0] < 0) {
-            LOGF(warning, Form("Model for %s with negative input shape likely because converted with ummingbird, setting it to 1.", charmParticleNames[iCharmPart].data()));
+            LOGF(info, Form("Model for %s with negative input shape likely because converted with ummingbird, candidates evaluated in batches.", charmParticleNames[iCharmPart].data()));
             inputShapesML[iCharmPart][0][0] = 1;
           }
-          outputNamesML[iCharmPart] = sessionML[iCharmPart]->GetOutputNames();
-          outputShapesML[iCharmPart] = sessionML[iCharmPart]->GetOutputShapes();
-
-          Ort::TypeInfo typeInfo = sessionML[iCharmPart]->GetInputTypeInfo(0);
-          auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
-          dataTypeML[iCharmPart] = tensorInfo.GetElementType();
+          dataTypeML[iCharmPart] = modelML[iCharmPart]->inputElementType();
+          thresholdBDTValues[iCharmPart] = {thresholdBDTScores[iCharmPart].get(0u, "BDTbkg"), thresholdBDTScores[iCharmPart].get(0u, "BDTprompt"), thresholdBDTScores[iCharmPart].get(0u, "BDTnonprompt")};
         }
       }
     }
+    initTimer.print();
   }
 
   /// Single-track cuts for bachelor track of beauty candidates
@@ -696,25 +710,158 @@ struct HfFilter { // Main struct for HF triggers
     return retValue;
   }
 
-  /// Single-track cuts for bachelor track of beauty candidates
-  /// \param scores is a 3-element array with BDT out scores
-  /// \return 0 if rejected, otherwise bitmap with BIT(RecoDecay::OriginType::Prompt) and/or BIT(RecoDecay::OriginType::NonPrompt) on
-  template <typename T>
-  int8_t isBDTSelected(const T& scores, const int candType)
+  /// BDT selection of all the scored candidates of a species
+  /// \param iCharmPart is the charm-hadron species
+  /// Fills tagsBDT with 0 if rejected, otherwise bitmap with BIT(RecoDecay::OriginType::Prompt) and/or BIT(RecoDecay::OriginType::NonPrompt) on
+  void computeBDTTags(const int iCharmPart)
   {
-    int8_t retValue = 0;
+    const float thresholdBkg = thresholdBDTValues[iCharmPart][0];
+    const float thresholdPrompt = thresholdBDTValues[iCharmPart][1];
+    const float thresholdNonPrompt = thresholdBDTValues[iCharmPart][2];
+    const auto& scores = scoresBDT[iCharmPart];
+    auto& tags = tagsBDT[iCharmPart];
+    const size_t nCand = scores.size() / 3;
+    tags.resize(nCand);
+    // branchless, so that the loop can be vectorised; NaN scores (failed inference) are rejected
+    for (size_t iCand = 0; iCand < nCand; ++iCand) {
+      const int8_t isNotBkg = scores[3 * iCand] <= thresholdBkg;
+      const int8_t isPrompt = scores[3 * iCand + 1] < thresholdPrompt;
+      const int8_t isNonPrompt = scores[3 * iCand + 2] < thresholdNonPrompt;
+      tags[iCand] = isNotBkg * ((isPrompt << RecoDecay::OriginType::Prompt) | (isNonPrompt << RecoDecay::OriginType::NonPrompt));
+    }
+  }
+
+  /// Evaluation of the BDT of a species for all the candidates in featuresBDT
+  /// \param iCharmPart is the charm-hadron species
+  /// Fills scoresBDT with 3 scores per candidate, NaN if the inference failed
+  void evaluateBDT(const int iCharmPart)
+  {
+    const int64_t nFeatures = inputShapesML[iCharmPart][0].back();
+    const int64_t nCand = featuresBDT[iCharmPart].size() / nFeatures;
+    scoresBDT[iCharmPart].assign(3 * nCand, std::numeric_limits<float>::quiet_NaN());
+    if (nCand == 0) {
+      return;
+    }
+
+    // models with a fixed input shape are evaluated one candidate at a time
+    const int64_t batchSize = isBatchableML[iCharmPart] ? nCand : 1;
+    std::vector<int64_t> inputShape{batchSize, nFeatures};
+    for (int64_t firstCand = 0; firstCand < nCand; firstCand += batchSize) {
+      std::vector<Ort::Value> inputTensor;
+      if (dataTypeML[iCharmPart] == 1) {
+        inputTensor.push_back(Ort::Experimental::Value::CreateTensor<float>(&featuresBDT[iCharmPart][firstCand * nFeatures], batchSize * nFeatures, inputShape));
+      } else if (dataTypeML[iCharmPart] == 11) {
+        featuresBDTDouble.assign(featuresBDT[iCharmPart].begin() + firstCand * nFeatures, featuresBDT[iCharmPart].begin() + (firstCand + batchSize) * nFeatures);
+        inputTensor.push_back(Ort::Experimental::Value::CreateTensor<double>(featuresBDTDouble.data(), featuresBDTDouble.size(), inputShape));
+      } else {
+        LOG(fatal) << "Error running model inference: Unexpected input data type.";
+      }
 
-    if (scores[0] > thresholdBDTScores[candType].get(0u, "BDTbkg")) {
-      return retValue;
+      try {
+        auto outputTensor = modelML[iCharmPart]->run(inputTensor);
+        assert(outputTensor.size() == modelML[iCharmPart]->outputNames().size() && outputTensor[1].IsTensor());
+        auto typeInfo = outputTensor[1].GetTensorTypeAndShapeInfo();
+        assert(typeInfo.GetElementCount() == 3 * batchSize); // we need multiclass
+        auto scores = outputTensor[1].GetTensorData<float>();
+        std::copy(scores, scores + 3 * batchSize, scoresBDT[iCharmPart].begin() + 3 * firstCand);
+      } catch (const Ort::Exception& exception) {
+        // LOG(error) << "Error running model inference: " << exception.what();
+      }
     }
-    if (scores[1] < thresholdBDTScores[candType].get(0u, "BDTprompt")) {
-      retValue |= BIT(RecoDecay::OriginType::Prompt);
+  }
+
+  /// Evaluation of the BDTs for the 2-prong and 3-prong candidates of a collision, with one inference call per model
+  /// \param cand2Prongs are the 2-prong candidates of the collision
+  /// \param cand3Prongs are the 3-prong candidates of the collision
+  template <typename T2Prong, typename T3Prong>
+  void computeBDTScores(const T2Prong& cand2Prongs, const T3Prong& cand3Prongs)
+  {
+    for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+      featuresBDT[iCharmPart].clear();
+      posBDT[iCharmPart].clear();
     }
-    if (scores[2] < thresholdBDTScores[candType].get(0u, "BDTnonprompt")) {
-      retValue |= BIT(RecoDecay::OriginType::NonPrompt);
+
+    // TODO: add more feature configurations
+    if (onnxFiles[kD0] != "") {
+      posBDT[kD0].assign(cand2Prongs.size(), -1);
+      int iCand{0}, nScored{0};
+      for (const auto& cand2Prong : cand2Prongs) {
+        if (TESTBIT(cand2Prong.hfflag(), o2::aod::hf_cand_prong2::DecayType::D0ToPiK)) {
+          auto trackPos = cand2Prong.template index0_as<BigTracksWithProtonPID>();
+          auto trackNeg = cand2Prong.template index1_as<BigTracksWithProtonPID>();
+          featuresBDT[kD0].insert(featuresBDT[kD0].end(), {trackPos.pt(), trackPos.dcaXY(), trackPos.dcaZ(), trackNeg.pt(), trackNeg.dcaXY(), trackNeg.dcaZ()});
+          posBDT[kD0][iCand] = nScored++;
+        }
+        ++iCand;
+      }
     }
 
-    return retValue;
+    std::array<int, kNCharmParticles> nScored{0};
+    for (auto iCharmPart{1}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+      if (onnxFiles[iCharmPart] != "") {
+        posBDT[iCharmPart].assign(cand3Prongs.size(), -1);
+      }
+    }
+    int iCand{0};
+    for (const auto& cand3Prong : cand3Prongs) {
+      std::array<int8_t, kNCharmParticles - 1> is3Prong = {
+        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_prong3::DecayType::DPlusToPiKPi),
+        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_prong3::DecayType::DsToPiKK),
+        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_prong3::DecayType::LcToPKPi),
+        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_prong3::DecayType::XicToPKPi)};
+      bool hasFeatures{false};
+      std::array<float, 9> features{};
+      for (auto iCharmPart{1}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+        if (!is3Prong[iCharmPart - 1] || onnxFiles[iCharmPart] == "") {
+          continue;
+        }
+        if (!hasFeatures) {
+          auto trackFirst = cand3Prong.template index0_as<BigTracksWithProtonPID>();
+          auto trackSecond = cand3Prong.template index1_as<BigTracksWithProtonPID>();
+          auto trackThird = cand3Prong.template index2_as<BigTracksWithProtonPID>();
+          features = {trackFirst.pt(), trackFirst.dcaXY(), trackFirst.dcaZ(), trackSecond.pt(), trackSecond.dcaXY(), trackSecond.dcaZ(), trackThird.pt(), trackThird.dcaXY(), trackThird.dcaZ()};
+          hasFeatures = true;
+        }
+        featuresBDT[iCharmPart].insert(featuresBDT[iCharmPart].end(), features.begin(), features.end());
+        posBDT[iCharmPart][iCand] = nScored[iCharmPart]++;
+      }
+      ++iCand;
+    }
+
+    for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+      if (onnxFiles[iCharmPart] == "") {
+        continue;
+      }
+      evaluateBDT(iCharmPart);
+      computeBDTTags(iCharmPart);
+      if (activateQA) {
+        for (size_t iScored = 0; iScored < tagsBDT[iCharmPart].size(); ++iScored) {
+          const float* scores = &scoresBDT[iCharmPart][3 * iScored];
+          if (std::isnan(scores[0])) {
+            continue;
+          }
+          hBDTScoreBkg[iCharmPart]->Fill(scores[0]);
+          hBDTScorePrompt[iCharmPart]->Fill(scores[1]);
+          hBDTScoreNonPrompt[iCharmPart]->Fill(scores[2]);
+        }
+      }
+    }
+  }
+
+  /// Fills the decision log with a candidate of a species
+  /// \param collisionId is the index of the collision
+  /// \param prongs are the indices of the prongs, the third one -1 for 2-prong candidates
+  /// \param iCharmPart is the charm-hadron species
+  /// \param pt is the transverse momentum of the candidate
+  /// \param iCand is the position of the candidate in the collision, for its BDT scores
+  /// \param tags is the bitmap of aod::hfcandlog::TagBits
+  void logCandidate(const int64_t collisionId, const std::array<int, 3>& prongs, const int iCharmPart, const float pt, const int iCand, const uint8_t tags)
+  {
+    std::array<float, 3> scores{std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN()};
+    if (applyML && onnxFiles[iCharmPart] != "" && posBDT[iCharmPart][iCand] >= 0) {
+      std::copy_n(&scoresBDT[iCharmPart][3 * posBDT[iCharmPart][iCand]], 3, scores.begin());
+    }
+    candLog(collisionId, prongs[0], prongs[1], prongs[2], iCharmPart, pt, scores[0], scores[1], scores[2], tags);
   }
 
   /// Computation of the relative momentum between particle pairs
@@ -759,7 +906,13 @@ struct HfFilter { // Main struct for HF triggers
 
     int n2Prongs{0}, n3Prongs{0};
 
+    if (applyML) {
+      computeBDTScores(cand2Prongs, cand3Prongs);
+    }
+
+    int iCand2Prong{-1};
     for (const auto& cand2Prong : cand2Prongs) { // start loop over 2 prongs
+      ++iCand2Prong;
 
       if (!TESTBIT(cand2Prong.hfflag(), o2::aod::hf_cand_prong2::DecayType::D0ToPiK)) { // check if it's a D0
         continue;
@@ -772,56 +925,30 @@ struct HfFilter { // Main struct for HF triggers
 
       bool isCharmTagged{true}, isBeautyTagged{true};
 
-      // apply ML models
+      // apply ML models, evaluated in one batch for all the candidates of the collision
       if (applyML && onnxFiles[kD0] != "") {
-        isCharmTagged = false;
-        isBeautyTagged = false;
-        // TODO: add more feature configurations
-        std::vector<Ort::Value> inputTensorD0;
-        std::vector<float> inputFeaturesD0{trackPos.pt(), trackPos.dcaXY(), trackPos.dcaZ(), trackNeg.pt(), trackNeg.dcaXY(), trackNeg.dcaZ()};
-        std::vector<double> inputFeaturesDoD0{trackPos.pt(), trackPos.dcaXY(), trackPos.dcaZ(), trackNeg.pt(), trackNeg.dcaXY(), trackNeg.dcaZ()};
-        if (dataTypeML[kD0] == 1) {
-          inputTensorD0.push_back(Ort::Experimental::Value::CreateTensor<float>(inputFeaturesD0.data(), inputFeaturesD0.size(), inputShapesML[kD0][0]));
-        } else if (dataTypeML[kD0] == 11) {
-          inputTensorD0.push_back(Ort::Experimental::Value::CreateTensor<double>(inputFeaturesDoD0.data(), inputFeaturesDoD0.size(), inputShapesML[kD0][0]));
-        } else {
-          LOG(fatal) << "Error running model inference: Unexpected input data type.";
-        }
-
-        // double-check the dimensions of the input tensor
-        if (inputTensorD0[0].GetTensorTypeAndShapeInfo().GetShape()[0] > 0) { // vectorial models can have negative shape if the shape is unknown
-          assert(inputTensorD0[0].IsTensor() && inputTensorD0[0].GetTensorTypeAndShapeInfo().GetShape() == inputShapesML[kD0][0]);
-        }
-        try {
-          auto outputTensorD0 = sessionML[kD0]->Run(inputNamesML[kD0], inputTensorD0, outputNamesML[kD0]);
-          assert(outputTensorD0.size() == outputNamesML[kD0].size() && outputTensorD0[1].IsTensor());
-          auto typeInfo = outputTensorD0[1].GetTensorTypeAndShapeInfo();
-          assert(typeInfo.GetElementCount() == 3); // we need multiclass
-          auto scores = outputTensorD0[1].GetTensorMutableData<float>();
-
-          if (applyML && activateQA) {
-            hBDTScoreBkg[kD0]->Fill(scores[0]);
-            hBDTScorePrompt[kD0]->Fill(scores[1]);
-            hBDTScoreNonPrompt[kD0]->Fill(scores[2]);
-          }
-
-          int tagBDT = isBDTSelected(scores, kD0);
-          isCharmTagged = TESTBIT(tagBDT, RecoDecay::OriginType::Prompt);
-          isBeautyTagged = TESTBIT(tagBDT, RecoDecay::OriginType::NonPrompt);
-        } catch (const Ort::Exception& exception) {
-          //LOG(error) << "Error running model inference: " << exception.what();
-        }
+        int tagBDT = tagsBDT[kD0][posBDT[kD0][iCand2Prong]];
+        isCharmTagged = TESTBIT(tagBDT, RecoDecay::OriginType::Prompt);
+        isBeautyTagged = TESTBIT(tagBDT, RecoDecay::OriginType::NonPrompt);
       }
 
+      auto pVec2Prong = RecoDecay::pVec(pVecPos, pVecNeg);
+      auto pt2Prong = RecoDecay::pt(pVec2Prong);
+
       if (!isCharmTagged && !isBeautyTagged) {
+        if (fillCandLog) {
+          logCandidate(collision.globalIndex(), {cand2Prong.index0Id(), cand2Prong.index1Id(), -1}, kD0, pt2Prong, iCand2Prong, 0);
+        }
         continue;
       }
 
-      auto pVec2Prong = RecoDecay::pVec(pVecPos, pVecNeg);
-      auto pt2Prong = RecoDecay::pt(pVec2Prong);
-
       auto selD0 = isSelectedD0InMassRange(pVecPos, pVecNeg, pt2Prong);
 
+      if (fillCandLog) {
+        uint8_t tagsLog = (isCharmTagged << aod::hfcandlog::kCharmTagged) | (isBeautyTagged << aod::hfcandlog::kBeautyTagged) | ((selD0 > 0) << aod::hfcandlog::kInMassRange) | ((pt2Prong >= pTThreshold2Prong) << aod::hfcandlog::kHighPt);
+        logCandidate(collision.globalIndex(), {cand2Prong.index0Id(), cand2Prong.index1Id(), -1}, kD0, pt2Prong, iCand2Prong, tagsLog);
+      }
+
       if (pt2Prong >= pTThreshold2Prong) {
         keepEvent[kHighPt] = true;
         if (activateQA) {
@@ -890,7 +1017,9 @@ struct HfFilter { // Main struct for HF triggers
       } // end loop over tracks
     }   // end loop over 2-prong candidates
 
+    int iCand3Prong{-1};
     for (const auto& cand3Prong : cand3Prongs) { // start loop over 3 prongs
+      ++iCand3Prong;
 
       std::array<int8_t, kNCharmParticles - 1> is3Prong = {
         TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_prong3::DecayType::DPlusToPiKPi),
@@ -925,64 +1054,38 @@ struct HfFilter { // Main struct for HF triggers
       std::array<int8_t, kNCharmParticles - 1> isCharmTagged = is3Prong;
       std::array<int8_t, kNCharmParticles - 1> isBeautyTagged = is3Prong;
 
-      // apply ML models
+      // apply ML models, evaluated in one batch for all the candidates of the collision
       if (applyML) {
         isCharmTagged = std::array<int8_t, kNCharmParticles - 1>{0};
         isBeautyTagged = std::array<int8_t, kNCharmParticles - 1>{0};
 
-        // TODO: add more feature configurations
-        std::vector<float> inputFeatures{trackFirst.pt(), trackFirst.dcaXY(), trackFirst.dcaZ(), trackSecond.pt(), trackSecond.dcaXY(), trackSecond.dcaZ(), trackThird.pt(), trackThird.dcaXY(), trackThird.dcaZ()};
-        std::vector<double> inputFeaturesD{trackFirst.pt(), trackFirst.dcaXY(), trackFirst.dcaZ(), trackSecond.pt(), trackSecond.dcaXY(), trackSecond.dcaZ(), trackThird.pt(), trackThird.dcaXY(), trackThird.dcaZ()};
         for (auto iCharmPart{0}; iCharmPart < kNCharmParticles - 1; ++iCharmPart) {
           if (!is3Prong[iCharmPart] || onnxFiles[iCharmPart + 1] == "") {
             continue;
           }
+          int tagBDT = tagsBDT[iCharmPart + 1][posBDT[iCharmPart + 1][iCand3Prong]];
+          isCharmTagged[iCharmPart] = TESTBIT(tagBDT, RecoDecay::OriginType::Prompt);
+          isBeautyTagged[iCharmPart] = TESTBIT(tagBDT, RecoDecay::OriginType::NonPrompt);
+        }
+      }
 
-          std::vector<Ort::Value> inputTensor;
-          if (dataTypeML[iCharmPart + 1] == 1) {
-            inputTensor.push_back(Ort::Experimental::Value::CreateTensor<float>(inputFeatures.data(), inputFeatures.size(), inputShapesML[iCharmPart + 1][0]));
-          } else if (dataTypeML[iCharmPart + 1] == 11) {
-            inputTensor.push_back(Ort::Experimental::Value::CreateTensor<double>(inputFeaturesD.data(), inputFeaturesD.size(), inputShapesML[iCharmPart + 1][0]));
-          } else {
-            LOG(error) << "Error running model inference: Unexpected input data type.";
-          }
+      auto pVec3Prong = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird);
+      auto pt3Prong = RecoDecay::pt(pVec3Prong);
 
-          // double-check the dimensions of the input tensor
-          if (inputTensor[0].GetTensorTypeAndShapeInfo().GetShape()[0] > 0) { // vectorial models can have negative shape if the shape is unknown
-            assert(inputTensor[0].IsTensor() && inputTensor[0].GetTensorTypeAndShapeInfo().GetShape() == inputShapesML[iCharmPart + 1][0]);
-          }
-          try {
-            auto outputTensor = sessionML[iCharmPart + 1]->Run(inputNamesML[iCharmPart + 1], inputTensor, outputNamesML[iCharmPart + 1]);
-            assert(outputTensor.size() == outputNamesML[iCharmPart + 1].size() && outputTensor[1].IsTensor());
-            auto typeInfo = outputTensor[1].GetTensorTypeAndShapeInfo();
-            assert(typeInfo.GetElementCount() == 3); // we need multiclass
-            auto scores = outputTensor[1].GetTensorMutableData<float>();
-
-            if (applyML && activateQA) {
-              hBDTScoreBkg[iCharmPart + 1]->Fill(scores[0]);
-              hBDTScorePrompt[iCharmPart + 1]->Fill(scores[1]);
-              hBDTScoreNonPrompt[iCharmPart + 1]->Fill(scores[2]);
+      if (!std::accumulate(isCharmTagged.begin(), isCharmTagged.end(), 0) && !std::accumulate(isBeautyTagged.begin(), isBeautyTagged.end(), 0)) {
+        if (fillCandLog) {
+          for (auto iCharmPart{0}; iCharmPart < kNCharmParticles - 1; ++iCharmPart) {
+            if (is3Prong[iCharmPart]) {
+              logCandidate(collision.globalIndex(), {cand3Prong.index0Id(), cand3Prong.index1Id(), cand3Prong.index2Id()}, iCharmPart + 1, pt3Prong, iCand3Prong, 0);
             }
-
-            int tagBDT = isBDTSelected(scores, iCharmPart + 1);
-            isCharmTagged[iCharmPart] = TESTBIT(tagBDT, RecoDecay::OriginType::Prompt);
-            isBeautyTagged[iCharmPart] = TESTBIT(tagBDT, RecoDecay::OriginType::NonPrompt);
-          } catch (const Ort::Exception& exception) {
-            // LOG(error) << "Error running model inference: " << exception.what();
           }
         }
-      }
-
-      if (!std::accumulate(isCharmTagged.begin(), isCharmTagged.end(), 0) && !std::accumulate(isBeautyTagged.begin(), isBeautyTagged.end(), 0)) {
         continue;
       }
 
       if (std::accumulate(isCharmTagged.begin(), isCharmTagged.end(), 0)) {
         n3Prongs++;
       } // end multiple 3-prong selection
-
-      auto pVec3Prong = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird);
-      auto pt3Prong = RecoDecay::pt(pVec3Prong);
       float sign3Prong = trackFirst.signed1Pt() * trackSecond.signed1Pt() * trackThird.signed1Pt();
 
       std::array<int8_t, kNCharmParticles - 1> is3ProngInMass{0};
@@ -999,6 +1102,15 @@ struct HfFilter { // Main struct for HF triggers
         is3ProngInMass[3] = isSelectedXicInMassRange(pVecFirst, pVecThird, pVecSecond, pt3Prong, is3Prong[3]);
       }
 
+      if (fillCandLog) {
+        for (auto iCharmPart{0}; iCharmPart < kNCharmParticles - 1; ++iCharmPart) {
+          if (is3Prong[iCharmPart]) {
+            uint8_t tagsLog = ((isCharmTagged[iCharmPart] != 0) << aod::hfcandlog::kCharmTagged) | ((isBeautyTagged[iCharmPart] != 0) << aod::hfcandlog::kBeautyTagged) | ((is3ProngInMass[iCharmPart] != 0) << aod::hfcandlog::kInMassRange) | ((pt3Prong >= pTThreshold3Prong) << aod::hfcandlog::kHighPt);
+            logCandidate(collision.globalIndex(), {cand3Prong.index0Id(), cand3Prong.index1Id(), cand3Prong.index2Id()}, iCharmPart + 1, pt3Prong, iCand3Prong, tagsLog);
+          }
+        }
+      }
+
       if (pt3Prong >= pTThreshold3Prong) {
         keepEvent[kHighPt] = true;
         if (activateQA) {
@@ -13,6 +13,9 @@
 /// \file HFFilterQC.cxx
 /// \brief task for the quality assurance of the event selection with HFFilter.cxx
 ///
+/// processCandLog computes the trigger efficiencies and the purity of the trigger candidates from the decision log of
+/// HFFilter.cxx (fillCandLog), with the signal decays of the MC particles found once per time frame
+///
 /// \author Fabrizio Grosa <fabrizio.grosa@cern.ch>, CERN
 /// \author Biao Zhang <biao.zhang@cern.ch>, CCNU
 /// \author Alexandre Bigot <alexandre.bigot@cern.ch>, Strasbourg University
@@ -23,6 +26,8 @@
 #include "Framework/HistogramRegistry.h"
 #include "Framework/runDataProcessing.h"
 
+#include <vector>
+
 #include "EventFiltering/filterTables.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 
@@ -69,6 +74,16 @@ struct HfFilterQc { // Main struct for HF trigger QC
   std::array<std::shared_ptr<TH2>, kNtriggersHF + 2> hPartPerEvent{};
   std::array<std::shared_ptr<TH2>, kNtriggersHF + 2> hPtDistr{};
 
+  // purity of the logged candidates, and fraction of the signal decays with a tagged candidate
+  std::shared_ptr<TH2> hCandPtAll, hCandPtSignal, hCandPtTaggedAll, hCandPtTaggedSignal, hPtDistrTagged;
+
+  // signal decays of the MC particles of the time frame, found once for processCandLog
+  std::vector<int8_t> signalSpecies;                   // species of each MC particle, -1 if not a signal decay
+  std::vector<int> signalAncestor;                     // index of the signal decay a particle comes from, -1 if none
+  std::vector<std::vector<int>> signalsPerMcCollision; // indices of the signal decays of each MC collision
+  std::vector<bool> isSignalTagged;                    // whether the signal decay has a tagged candidate
+  std::vector<int> signalDaughters;
+
   HistogramRegistry registry{"registry", {}, OutputObjHandlingPolicy::AnalysisObject, true, true};
 
   void init(o2::framework::InitContext&)
@@ -88,6 +103,18 @@ struct HfFilterQc { // Main struct for HF trigger QC
         hPtDistr[iTrig]->GetXaxis()->SetBinLabel(iBin + 1, particleNames[iBin].data());
       }
     }
+    if (doprocessCandLog) {
+      hCandPtAll = registry.add<TH2>("hCandPtAll", "All logged candidates;;#it{p}_{T} (GeV/#it{c})", HistType::kTH2F, {{kNParticles, -0.5, kNParticles - 0.5}, {50, 0., 50.}});
+      hCandPtSignal = registry.add<TH2>("hCandPtSignal", "Logged signal candidates;;#it{p}_{T} (GeV/#it{c})", HistType::kTH2F, {{kNParticles, -0.5, kNParticles - 0.5}, {50, 0., 50.}});
+      hCandPtTaggedAll = registry.add<TH2>("hCandPtTaggedAll", "All tagged candidates;;#it{p}_{T} (GeV/#it{c})", HistType::kTH2F, {{kNParticles, -0.5, kNParticles - 0.5}, {50, 0., 50.}});
+      hCandPtTaggedSignal = registry.add<TH2>("hCandPtTaggedSignal", "Tagged signal candidates;;#it{p}_{T} (GeV/#it{c})", HistType::kTH2F, {{kNParticles, -0.5, kNParticles - 0.5}, {50, 0., 50.}});
+      hPtDistrTagged = registry.add<TH2>("hPtDistrTagged", "Signal decays with a tagged candidate;;#it{p}_{T} (GeV/#it{c})", HistType::kTH2F, {{kNParticles, -0.5, kNParticles - 0.5}, {50, -0.5, 10.5}});
+      for (const auto& histo : {hCandPtAll, hCandPtSignal, hCandPtTaggedAll, hCandPtTaggedSignal, hPtDistrTagged}) {
+        for (auto iBin = 0; iBin < kNParticles; ++iBin) {
+          histo->GetXaxis()->SetBinLabel(iBin + 1, particleNames[iBin].data());
+        }
+      }
+    }
   }
 
   /// Loops over particle species and checks whether the analysed particle is the correct one
@@ -125,8 +152,59 @@ struct HfFilterQc { // Main struct for HF trigger QC
     }
   }
 
-  void process(HfFilter const& filterDecision,
-               McParticles const& particlesMC)
+  /// Finds the species of the signal decay of an MC particle
+  /// \param pdgDau  tuple with PDG daughter codes for the desired decay
+  /// \param particlesMC  table with MC particles
+  /// \param particle  MC particle
+  /// \param daughters  indices of the daughters of the found decay
+  /// \return species of the decay, -1 if the particle is not a signal decay
+  template <size_t I = 0, typename... Ts, typename T, typename U>
+  int findSignalSpecies(std::tuple<Ts...> pdgDau,
+                        const T& particlesMC,
+                        const U& particle,
+                        std::vector<int>& daughters)
+  {
+    if constexpr (I == sizeof...(Ts)) {
+      return -1;
+    } else {
+      int8_t sign = 0;
+      if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdgCodes[I], std::get<I>(pdgDau), true, &sign, 2, &daughters)) {
+        return I;
+      }
+      return findSignalSpecies<I + 1>(pdgDau, particlesMC, particle, daughters);
+    }
+  }
+
+  /// Finds the signal decays of the MC particles, and the signal decay each MC particle comes from
+  template <typename T>
+  void buildSignalIndex(const T& particlesMC)
+  {
+    signalSpecies.assign(particlesMC.size(), -1);
+    signalAncestor.assign(particlesMC.size(), -1);
+    isSignalTagged.assign(particlesMC.size(), false);
+    for (auto& signals : signalsPerMcCollision) {
+      signals.clear();
+    }
+    for (auto const& particle : particlesMC) {
+      signalDaughters.clear();
+      int species = findSignalSpecies(pdgDaughters, particlesMC, particle, signalDaughters);
+      if (species < 0) {
+        continue;
+      }
+      const auto iParticle = particle.globalIndex();
+      signalSpecies[iParticle] = species;
+      for (auto iDaughter : signalDaughters) {
+        signalAncestor[iDaughter] = iParticle;
+      }
+      if (particle.mcCollisionId() >= static_cast<int>(signalsPerMcCollision.size())) {
+        signalsPerMcCollision.resize(particle.mcCollisionId() + 1);
+      }
+      signalsPerMcCollision[particle.mcCollisionId()].push_back(iParticle);
+    }
+  }
+
+  void processDecisions(HfFilter const& filterDecision,
+                        McParticles const& particlesMC)
   {
     bool hasHighPt = filterDecision.hasHfHighPt();
     bool hasBeauty = filterDecision.hasHfBeauty();
@@ -151,6 +229,87 @@ struct HfFilterQc { // Main struct for HF trigger QC
       }
     }
   }
+
+  PROCESS_SWITCH(HfFilterQc, processDecisions, "Compute the trigger efficiencies from the MC particles of each event", true);
+
+  void processCandLog(soa::Join<Collisions, McCollisionLabels, HfFilters> const& collisions,
+                      HfCandLogs const& candLogs,
+                      McParticles const& particlesMC,
+                      McTrackLabels const& trackLabels)
+  {
+    buildSignalIndex(particlesMC);
+
+    // trigger efficiencies, from the signal decays of the MC collision of each event
+    for (auto const& collision : collisions) {
+      if (!collision.has_mcCollision() || collision.mcCollisionId() >= static_cast<int>(signalsPerMcCollision.size())) {
+        continue;
+      }
+      bool hasHighPt = collision.hasHfHighPt();
+      bool hasBeauty = collision.hasHfBeauty();
+      bool hasFemto = collision.hasHfFemto();
+      bool hasDoubleCharm = collision.hasHfDoubleCharm();
+      bool isTriggered = hasHighPt || hasBeauty || hasFemto || hasDoubleCharm;
+      auto triggerDecision = std::array{isTriggered, hasHighPt, hasBeauty, hasFemto, hasDoubleCharm};
+
+      std::array<int, kNParticles> nPart{0};
+      for (auto iParticle : signalsPerMcCollision[collision.mcCollisionId()]) {
+        const int species = signalSpecies[iParticle];
+        const double pt = particlesMC.rawIteratorAt(iParticle).pt();
+        nPart[species]++;
+        hPtDistr[0]->Fill(species, pt);
+        for (auto iTrig = 0; iTrig < kNtriggersHF + 1; ++iTrig) {
+          if (triggerDecision[iTrig]) {
+            hPtDistr[iTrig + 1]->Fill(species, pt);
+          }
+        }
+      }
+      for (auto iPart = 0; iPart < kNParticles; ++iPart) {
+        hPartPerEvent[0]->Fill(iPart, nPart[iPart]);
+        for (auto iTrig = 0; iTrig < kNtriggersHF + 1; ++iTrig) {
+          if (triggerDecision[iTrig]) {
+            hPartPerEvent[iTrig + 1]->Fill(iPart, nPart[iPart]);
+          }
+        }
+      }
+    }
+
+    // purity of the candidates, matched through the MC labels of their prongs
+    for (auto const& cand : candLogs) {
+      int ancestor = -1;
+      for (auto prongId : {cand.prong0Id(), cand.prong1Id(), cand.prong2Id()}) {
+        if (prongId < 0) {
+          continue;
+        }
+        auto label = trackLabels.rawIteratorAt(prongId);
+        int prongAncestor = label.mcParticleId() >= 0 ? signalAncestor[label.mcParticleId()] : -1;
+        if (prongAncestor < 0 || (ancestor >= 0 && prongAncestor != ancestor)) {
+          ancestor = -1;
+          break;
+        }
+        ancestor = prongAncestor;
+      }
+      const bool isSignal = ancestor >= 0 && signalSpecies[ancestor] == cand.candType();
+      const bool isTagged = TESTBIT(cand.tags(), hfcandlog::kCharmTagged) || TESTBIT(cand.tags(), hfcandlog::kBeautyTagged);
+      hCandPtAll->Fill(cand.candType(), cand.pt());
+      if (isTagged) {
+        hCandPtTaggedAll->Fill(cand.candType(), cand.pt());
+      }
+      if (isSignal) {
+        hCandPtSignal->Fill(cand.candType(), cand.pt());
+        if (isTagged) {
+          hCandPtTaggedSignal->Fill(cand.candType(), cand.pt());
+          isSignalTagged[ancestor] = true;
+        }
+      }
+    }
+    for (size_t iParticle = 0; iParticle < isSignalTagged.size(); ++iParticle) {
+      if (isSignalTagged[iParticle]) {
+        hPtDistrTagged->Fill(signalSpecies[iParticle], particlesMC.rawIteratorAt(iParticle).pt());
+      }
+    }
+  }
+
+  PROCESS_SWITCH(HfFilterQc, processCandLog, "Compute the trigger efficiencies and the candidate purity from the decision log of the HF filter", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfg)
@@ -25,13 +25,16 @@
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/DataModel/EMCALClusters.h"
 #include "PWGJE/Core/JetFinder.h"
+#include "PWGJE/Core/JetPatchFinder.h"
 
 #include "../filterTables.h"
 
 #include "Framework/HistogramRegistry.h"
 
+#include <algorithm>
 #include <cmath>
 #include <string>
+#include <vector>
 #include <TMath.h>
 
 using namespace o2;
@@ -54,6 +57,14 @@ struct jetFilter {
 
   Configurable<float> cfgJetChEtaCut{"cfgJetChEtaCut", 0.9, "Eta range for charged jets"};
 
+  //clustering of the pre-selected events
+  Configurable<float> cfgJetR{"cfgJetR", 0.4, "Resolution parameter of the charged jets clustered in the filter"};
+  Configurable<float> cfgTrackPtCut{"cfgTrackPtCut", 0.1, "Minimum constituent pT"};
+  Configurable<float> cfgTrackEtaCut{"cfgTrackEtaCut", 0.9, "Constituent eta cut"};
+  Configurable<float> cfgPatchCellSize{"cfgPatchCellSize", 0.1, "Size in eta and phi of the cells of the pre-selection grid"};
+  Configurable<float> cfgPatchThresholdFraction{"cfgPatchThresholdFraction", 0.5, "Events are clustered if a 2R x 2R patch has a pT sum above this fraction of the jet threshold"};
+  Configurable<int> cfgPreselectionValidation{"cfgPreselectionValidation", 0, "Cluster also one out of this number of events rejected by the pre-selection, to measure its efficiency (0: none)"};
+
   HistogramRegistry spectra{"spectra", {}, OutputObjHandlingPolicy::AnalysisObject, true, true};
 
   void init(o2::framework::InitContext&)
@@ -66,15 +77,48 @@ struct jetFilter {
     for (uint32_t iS{1}; iS <= highPtObjectsNames.size(); ++iS) {
       scalers->GetXaxis()->SetBinLabel(iS, highPtObjectsNames[iS - 1].data());
     }
+
+    if (doprocessPreselected) {
+      spectra.add("fMaxPatchPt", "maximum pT sum of the pre-selection patches", HistType::kTH1F, {{150, 0., +150., "patch #it{p}_{T} (GeV/#it{c})"}});
+      // efficiency of the pre-selection: ratio of the accepted to all the events at a given leading jet pT,
+      // the rejected events being weighted by the validation downscaling
+      auto preselection{std::get<std::shared_ptr<TH2>>(spectra.add("fPreselection", "leading charged jet pT of the clustered events", HistType::kTH2F, {{150, 0., +150., "leading charged jet #it{p}_{T} (GeV/#it{c})"}, {2, -0.5, 1.5, ""}}))};
+      preselection->GetYaxis()->SetBinLabel(1, "rejected");
+      preselection->GetYaxis()->SetBinLabel(2, "accepted");
+
+      patchFinder.setup(-cfgTrackEtaCut, cfgTrackEtaCut, cfgPatchCellSize, 2.f * cfgJetR);
+      jetFinder.etaMin = -cfgTrackEtaCut;
+      jetFinder.etaMax = cfgTrackEtaCut;
+      jetFinder.jetR = cfgJetR;
+    }
   }
 
   //declare filters on tracks and charged jets
   Filter collisionFilter = nabs(aod::collision::posZ) < cfgVertexCut;
   Filter jetChFilter = (nabs(aod::jet::eta) < cfgJetChEtaCut);
+  Filter trackFilter = (nabs(aod::track::eta) < cfgTrackEtaCut) && (requireGlobalTrackInFilter()) && (aod::track::pt > cfgTrackPtCut);
 
   using TrackCandidates = soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>>;
 
-  void process(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& collision, TrackCandidates const& tracks, aod::Jets const& jets)
+  JetPatchFinder patchFinder;
+  JetFinder jetFinder;
+  std::vector<fastjet::PseudoJet> inputParticles;
+  std::vector<fastjet::PseudoJet> jets;
+  int nRejectedSinceValidation = 0;
+
+  template <typename TCollision>
+  void fillDecisions(TCollision const& collision, bool const (&keepEvent)[kHighPtObjects])
+  {
+    //count events which passed the selections
+    for (int iDecision{0}; iDecision < kHighPtObjects; ++iDecision) {
+      if (keepEvent[iDecision]) {
+        spectra.fill(HIST("fProcessedEvents"), iDecision);
+      }
+    }
+    tags(collision, keepEvent[kJetChHighPt]);
+  }
+
+  void processJets(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& collision, TrackCandidates const& tracks, aod::Jets const& jets)
   {
     // collision process loop
     bool keepEvent[kHighPtObjects]{false};
@@ -90,14 +134,55 @@ struct jetFilter {
       }
     }
 
-    //count events which passed the selections
-    for (int iDecision{0}; iDecision < kHighPtObjects; ++iDecision) {
-      if (keepEvent[iDecision]) {
-        spectra.fill(HIST("fProcessedEvents"), iDecision);
+    fillDecisions(collision, keepEvent);
+  }
+  PROCESS_SWITCH(jetFilter, processJets, "Select the events with the jets of the jet finder", false);
+
+  // the charged jets are clustered in the filter only for the events with a patch of tracks close to the
+  // threshold, in place of clustering all the events in the jet finder
+  void processPreselected(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& collision, TrackCandidates const& tracks)
+  {
+    bool keepEvent[kHighPtObjects]{false};
+    spectra.fill(HIST("fCollZpos"), collision.posZ());
+
+    patchFinder.clear();
+    for (auto& track : tracks) {
+      patchFinder.fill(track.pt(), track.eta(), track.phi());
+    }
+    const float maxPatchPt = patchFinder.maxPatch();
+    spectra.fill(HIST("fMaxPatchPt"), maxPatchPt);
+    const bool preselected = maxPatchPt >= cfgPatchThresholdFraction * selectionJetChHighPt;
+    bool cluster = preselected;
+    if (!preselected && cfgPreselectionValidation > 0 && ++nRejectedSinceValidation >= cfgPreselectionValidation) {
+      nRejectedSinceValidation = 0;
+      cluster = true;
+    }
+
+    if (cluster) {
+      inputParticles.clear();
+      for (auto& track : tracks) {
+        fillConstituents(track, inputParticles);
+        inputParticles.back().set_user_index(track.globalIndex());
+      }
+      fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
+
+      float leadingPt = 0.f;
+      for (auto& jet : jets) {
+        if (std::abs(jet.eta()) < cfgJetChEtaCut) {
+          leadingPt = std::max(leadingPt, static_cast<float>(jet.pt()));
+        }
+      }
+      spectra.fill(HIST("fPreselection"), leadingPt, preselected ? 1 : 0, preselected ? 1. : static_cast<double>(cfgPreselectionValidation));
+      // the validation events are not kept, so that the trigger decision does not depend on the downscaling
+      if (preselected && leadingPt >= selectionJetChHighPt) {
+        spectra.fill(HIST("fJetChPtSelected"), leadingPt);
+        keepEvent[kJetChHighPt] = true;
       }
     }
-    tags(collision, keepEvent[kJetChHighPt]);
+
+    fillDecisions(collision, keepEvent);
   }
+  PROCESS_SWITCH(jetFilter, processPreselected, "Cluster the charged jets of the events passing the patch pre-selection", true);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfg)
@@ -20,6 +20,7 @@
 
 #include "Common/DataModel/EventSelection.h"
 #include "../filterTables.h"
+#include "../filterTrackCache.h"
 
 #include "Framework/HistogramRegistry.h"
 
@@ -100,20 +101,19 @@ struct nucleiFilter {
 
     for (auto& track : tracks) { // start loop over tracks
 
-      const float nSigmaTPC[nNuclei]{
-        track.tpcNSigmaDe(), track.tpcNSigmaTr(), track.tpcNSigmaHe(), track.tpcNSigmaAl()};
-      const float nSigmaTOF[nNuclei]{
-        track.tofNSigmaDe(), track.tofNSigmaTr(), track.tofNSigmaHe(), track.tofNSigmaAl()};
+      // same per-track features as the other LF filters, species in the order of nucleiNames
+      o2::analysis::filtering::TrackFeatures<o2::track::PID::Deuteron, o2::track::PID::Triton, o2::track::PID::Helium3, o2::track::PID::Alpha> features;
+      features.set(track);
 
       for (int iN{0}; iN < nNuclei; ++iN) {
-        float y{rapidity(track.pt() * charges[iN], track.eta(), masses[iN])};
-        if (y < yMin + yBeam || y > yMax + yBeam) {
+        if (features.tpcNSigma(iN) < cfgCutsPID->get(iN, 0u) || features.tpcNSigma(iN) > cfgCutsPID->get(iN, 1u)) {
           continue;
         }
-        if (nSigmaTPC[iN] < cfgCutsPID->get(iN, 0u) || nSigmaTPC[iN] > cfgCutsPID->get(iN, 1u)) {
+        float y{rapidity(features.pt() * charges[iN], features.eta(), masses[iN])};
+        if (y < yMin + yBeam || y > yMax + yBeam) {
           continue;
         }
-        if (track.pt() > cfgCutsPID->get(iN, 4u) && (nSigmaTOF[iN] < cfgCutsPID->get(iN, 2u) || nSigmaTOF[iN] > cfgCutsPID->get(iN, 3u))) {
+        if (features.pt() > cfgCutsPID->get(iN, 4u) && (features.tofNSigma(iN) < cfgCutsPID->get(iN, 2u) || features.tofNSigma(iN) > cfgCutsPID->get(iN, 3u))) {
           continue;
         }
         keepEvent[iN] = true;
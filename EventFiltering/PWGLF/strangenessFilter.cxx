@@ -41,11 +41,13 @@
 #include "Framework/ASoAHelpers.h"
 
 #include "../filterTables.h"
+#include "../filterTrackCache.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 using std::array;
+using o2::track::PID;
 
 struct strangenessFilter {
 
@@ -202,6 +204,8 @@ struct strangenessFilter {
   using DaughterTracks = soa::Join<aod::Tracks, aod::TracksCov, aod::TracksExtra, aod::TracksDCA, aod::TrackSelection, aod::pidTOFPi, aod::pidTPCPi, aod::pidTOFPr, aod::pidTPCPr>;
   using Cascades = aod::CascDataExt;
 
+  o2::analysis::filtering::TrackFeatureCache<PID::Pion, PID::Proton> daughterFeatures; // daughter tracks of the cascades of the collision
+
   ////////////////////////////////////////////////////////
   ////////// Strangeness Filter - Run 2 conv /////////////
   ////////////////////////////////////////////////////////
@@ -507,6 +511,9 @@ struct strangenessFilter {
     // Is event good? [0] = Omega, [1] = high-pT hadron + Xi, [2] = 2Xi, [3] = 3Xi, [4] = 4Xi, [5] single-Xi
     bool keepEvent[6]{false};
 
+    // PID and eta of the daughter tracks, read once for all the cascades
+    daughterFeatures.fill(dtracks);
+
     // constants
     const float ctauxi = 4.91;     // from PDG
     const float ctauomega = 2.461; // from PDG
@@ -532,9 +539,9 @@ struct strangenessFilter {
       }
       hCandidate->Fill(1.5);
       auto v0 = v0index.v0Data(); // de-reference index to correct v0data in case it exists
-      auto bachelor = casc.bachelor_as<DaughterTracks>();
-      auto posdau = v0.posTrack_as<DaughterTracks>();
-      auto negdau = v0.negTrack_as<DaughterTracks>();
+      const auto bachelor = daughterFeatures.get(casc.bachelorId(), [&]() { return casc.bachelor_as<DaughterTracks>(); });
+      const auto posdau = daughterFeatures.get(v0.posTrackId(), [&]() { return v0.posTrack_as<DaughterTracks>(); });
+      const auto negdau = daughterFeatures.get(v0.negTrackId(), [&]() { return v0.negTrack_as<DaughterTracks>(); });
 
       bool isXi = false;
       bool isXiYN = false;
@@ -561,27 +568,27 @@ struct strangenessFilter {
           continue;
         };
         hCandidate->Fill(3.5);
-        if (TMath::Abs(posdau.tpcNSigmaPi()) > nsigmatpc) {
+        if (TMath::Abs(posdau.tpcNSigma<PID::Pion>()) > nsigmatpc) {
           continue;
         };
         hCandidate->Fill(4.5);
-        if (TMath::Abs(negdau.tpcNSigmaPr()) > nsigmatpc) {
+        if (TMath::Abs(negdau.tpcNSigma<PID::Proton>()) > nsigmatpc) {
           continue;
         };
         hCandidate->Fill(5.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
+        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigma<PID::Proton>());
+        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigma<PID::Pion>());
+        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigma<PID::Pion>());
         if (
-          (TMath::Abs(posdau.tofNSigmaPi()) > nsigmatof) &&
-          (TMath::Abs(negdau.tofNSigmaPr()) > nsigmatof) &&
-          (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
+          (TMath::Abs(posdau.tofNSigma<PID::Pion>()) > nsigmatof) &&
+          (TMath::Abs(negdau.tofNSigma<PID::Proton>()) > nsigmatof) &&
+          (TMath::Abs(bachelor.tofNSigma<PID::Pion>()) > nsigmatof)) {
           continue;
         };
         hCandidate->Fill(6.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
+        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigma<PID::Proton>());
+        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigma<PID::Pion>());
+        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigma<PID::Pion>());
       } else {
         if (TMath::Abs(casc.dcanegtopv()) < dcamesontopv) {
           continue;
@@ -591,27 +598,27 @@ struct strangenessFilter {
           continue;
         };
         hCandidate->Fill(3.5);
-        if (TMath::Abs(posdau.tpcNSigmaPr()) > nsigmatpc) {
+        if (TMath::Abs(posdau.tpcNSigma<PID::Proton>()) > nsigmatpc) {
           continue;
         };
         hCandidate->Fill(5.5);
-        if (TMath::Abs(negdau.tpcNSigmaPi()) > nsigmatpc) {
+        if (TMath::Abs(negdau.tpcNSigma<PID::Pion>()) > nsigmatpc) {
           continue;
         };
         hCandidate->Fill(4.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
+        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigma<PID::Proton>());
+        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigma<PID::Pion>());
+        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigma<PID::Pion>());
         if (
-          (TMath::Abs(posdau.tofNSigmaPr()) > nsigmatof) &&
-          (TMath::Abs(negdau.tofNSigmaPi()) > nsigmatof) &&
-          (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
+          (TMath::Abs(posdau.tofNSigma<PID::Proton>()) > nsigmatof) &&
+          (TMath::Abs(negdau.tofNSigma<PID::Pion>()) > nsigmatof) &&
+          (TMath::Abs(bachelor.tofNSigma<PID::Pion>()) > nsigmatof)) {
           continue;
         };
         hCandidate->Fill(6.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
+        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigma<PID::Proton>());
+        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigma<PID::Pion>());
+        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigma<PID::Pion>());
       }
       // this selection differes for Xi and Omegas:
 
@@ -673,20 +680,20 @@ struct strangenessFilter {
         }
       }
 
-      isXi = (TMath::Abs(bachelor.tpcNSigmaPi()) < nsigmatpc) &&
+      isXi = (TMath::Abs(bachelor.tpcNSigma<PID::Pion>()) < nsigmatpc) &&
              (casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()) > casccospa) &&
              (casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()) > dcav0topv) &&
              (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < ximasswindow) &&
              (TMath::Abs(casc.mOmega() - RecoDecay::getMassPDG(3334)) > omegarej) &&
              (xiproperlifetime < properlifetimefactor * ctauxi) &&
              (TMath::Abs(casc.yXi()) < rapidity); // add PID on bachelor
-      isXiYN = (TMath::Abs(bachelor.tpcNSigmaPi()) < nsigmatpc) &&
+      isXiYN = (TMath::Abs(bachelor.tpcNSigma<PID::Pion>()) < nsigmatpc) &&
                (casc.cascradius() > 24.39) &&
                (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < ximasswindow) &&
                (TMath::Abs(casc.mOmega() - RecoDecay::getMassPDG(3334)) > omegarej) &&
                (xiproperlifetime < properlifetimefactor * ctauxi) &&
                (TMath::Abs(casc.yXi()) < rapidity); // add PID on bachelor
-      isOmega = (TMath::Abs(bachelor.tpcNSigmaPi()) < nsigmatpc) &&
+      isOmega = (TMath::Abs(bachelor.tpcNSigma<PID::Pion>()) < nsigmatpc) &&
                 (casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()) > casccospa) &&
                 (casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()) > dcav0topv) &&
                 (TMath::Abs(casc.mOmega() - RecoDecay::getMassPDG(3334)) < omegamasswindow) &&
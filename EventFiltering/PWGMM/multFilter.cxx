@@ -16,6 +16,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "../filterTables.h"
+#include "../filterEventFeatureCache.h"
 #include "Framework/HistogramRegistry.h"
 #include "Framework/StaticFor.h"
 #include <cmath>
@@ -48,6 +49,15 @@ struct multFilter {
          kLeadingPtTrack,
          kNtriggersMM };
 
+  // expensive event features, evaluated at their first use
+  enum { kFlatFV0 = 0,
+         kFlatFT0A,
+         kFlatFT0C,
+         kFlatMFT,
+         kFlatGlob,
+         kNFeatures };
+  o2::analysis::filtering::EventFeatureCache<kNFeatures> features;
+
   // event selection cuts
   Configurable<float> selHTrkMult{"selHTrkMult", 45., "global trk multiplicity threshold"};
   Configurable<float> selHMfddft0cfv0mft{"selHMfddft0cfv0mft", 237.0, "FDD+FV0+FT0C+MFT mult threshold"};
@@ -67,6 +77,12 @@ struct multFilter {
   Configurable<float> sel1Fft0cFv0{"sel1Fft0cfv0", 0.892, "1-flatenicity FT0C+FV0 threshold"};
   Configurable<float> selPtTrig{"selPtTrig", 11., "track pT leading threshold"};
 
+  // prerequisites of the flatenicity estimators, which are not computed (9999) for events below them
+  Configurable<float> cfgFlatMinAmpFV0{"cfgFlatMinAmpFV0", -1., "FV0 amplitude above which the FV0 flatenicity is computed, -1: always"};
+  Configurable<float> cfgFlatMinAmpFT0{"cfgFlatMinAmpFT0", -1., "FT0A (FT0C) amplitude above which the FT0A (FT0C) flatenicity is computed, -1: always"};
+  Configurable<float> cfgFlatMinMultMFT{"cfgFlatMinMultMFT", -1., "MFT track multiplicity above which the MFT flatenicity is computed, -1: always"};
+  Configurable<float> cfgFlatMinMultGlob{"cfgFlatMinMultGlob", -1., "global track multiplicity above which the global track flatenicity is computed, -1: always"};
+
   Produces<aod::MultFilters> tags;
 
   // acceptance cuts
@@ -223,25 +239,26 @@ struct multFilter {
   {
 
     bool keepEvent[kNtriggersMM]{false};
+    features.reset();
     auto vtxZ = collision.posZ();
     multiplicity.fill(HIST("fProcessedEvents"), 0);
     multiplicity.fill(HIST("fCollZpos"), collision.posZ());
     // global observables
     int multTrack = 0;
     float flPt = 0; // leading pT
-    double flatenicity_fv0 = 9999;
 
+    // the cheap estimators (amplitude sums and track counts) are computed first, the flatenicities being computed
+    // at their first use, only for the events above their prerequisites
     float sumAmpFV0 = 0;
     float sumAmpFV01to4Ch = 0;
     int innerFV0 = 32;
     const int nCells = 48; // 48 sectors in FV0
+    float RhoLattice[nCells];
+    for (Int_t iCh = 0; iCh < nCells; iCh++) {
+      RhoLattice[iCh] = 0;
+    }
 
     if (collision.has_foundFV0()) {
-      float RhoLattice[nCells];
-      for (Int_t iCh = 0; iCh < nCells; iCh++) {
-        RhoLattice[iCh] = 0;
-      }
-
       auto fv0 = collision.foundFV0();
       // LOGP(info, "amplitude.size()={}", fv0.amplitude().size());
       for (std::size_t ich = 0; ich < fv0.amplitude().size(); ich++) {
@@ -258,9 +275,10 @@ struct multFilter {
           RhoLattice[channelv0] = ampl_ch / 2.0; // two channels per bin
         }
       }
-
-      flatenicity_fv0 = GetFlatenicity(RhoLattice, nCells);
     }
+    auto flatenicityFV0 = [&]() {
+      return features.get(kFlatFV0, [&]() { return (collision.has_foundFV0() && sumAmpFV0 > cfgFlatMinAmpFV0) ? GetFlatenicity(RhoLattice, nCells) : 9999.f; });
+    };
 
     // FT0
     float sumAmpFT0A = 0.f;
@@ -303,8 +321,12 @@ struct multFilter {
       multiplicity.fill(HIST("hAmpT0AvsVtx"), vtxZ, sumAmpFT0A);
       multiplicity.fill(HIST("hAmpT0CvsVtx"), vtxZ, sumAmpFT0C);
     }
-    float flatenicity_t0a = GetFlatenicity(RhoLatticeT0A, nCellsT0A);
-    float flatenicity_t0c = GetFlatenicity(RhoLatticeT0C, nCellsT0C);
+    auto flatenicityT0A = [&]() {
+      return features.get(kFlatFT0A, [&]() { return sumAmpFT0A > cfgFlatMinAmpFT0 ? GetFlatenicity(RhoLatticeT0A, nCellsT0A) : 9999.f; });
+    };
+    auto flatenicityT0C = [&]() {
+      return features.get(kFlatFT0C, [&]() { return sumAmpFT0C > cfgFlatMinAmpFT0 ? GetFlatenicity(RhoLatticeT0C, nCellsT0C) : 9999.f; });
+    };
 
     // FDD
     float sumAmpFDDA = 0;
@@ -336,10 +358,6 @@ struct multFilter {
     float minEta1[nRings1] = {-3.60, -3.05};
     float maxPhi1[nSectors1] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
     float minPhi1[nSectors1] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
-    float RhoLattice1[nCells1];
-    for (int iCh = 0; iCh < nCells1; iCh++) {
-      RhoLattice1[iCh] = 0.0;
-    }
 
     for (auto& track : mfttracks) {
       float eta_a = track.eta();
@@ -351,18 +369,6 @@ struct multFilter {
       multiplicity.fill(HIST("hdNdetaMFT"), eta_a);
       multiplicity.fill(HIST("hPhiMFT"), phi_a);
 
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings1; ir++) {
-        for (int is = 0; is < nSectors1; is++) {
-          if (eta_a >= minEta1[ir] && eta_a < maxEta1[ir] &&
-              phi_a >= minPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1) &&
-              phi_a < maxPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1)) {
-            RhoLattice1[i_ch]++;
-          }
-          i_ch++;
-        }
-      }
-
       multMFTTrack++;
 
       if (eta_a > -3.4 || eta_a < -3.6) {
@@ -371,7 +377,37 @@ struct multFilter {
       multMFTTrackParc++;
     }
     multiplicity.fill(HIST("hMFTvsVtx"), vtxZ, multMFTTrack);
-    float flatenicity_mft = GetFlatenicity(RhoLattice1, nCells1);
+    auto flatenicityMFT = [&]() {
+      return features.get(kFlatMFT, [&]() {
+        if (!(multMFTTrack > cfgFlatMinMultMFT)) {
+          return 9999.f;
+        }
+        float RhoLattice1[nCells1];
+        for (int iCh = 0; iCh < nCells1; iCh++) {
+          RhoLattice1[iCh] = 0.0;
+        }
+        for (auto& track : mfttracks) {
+          float eta_a = track.eta();
+          float phi_a = track.phi();
+          o2::math_utils::bringTo02Pi(phi_a);
+          if (eta_a > -2.5 || eta_a < -3.6) { // the MFT eta coverage
+            continue;
+          }
+          int i_ch = 0;
+          for (int ir = 0; ir < nRings1; ir++) {
+            for (int is = 0; is < nSectors1; is++) {
+              if (eta_a >= minEta1[ir] && eta_a < maxEta1[ir] &&
+                  phi_a >= minPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1) &&
+                  phi_a < maxPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1)) {
+                RhoLattice1[i_ch]++;
+              }
+              i_ch++;
+            }
+          }
+        }
+        return GetFlatenicity(RhoLattice1, nCells1);
+      });
+    };
     // Globaltracks
     const int nRings2 = 4;
     const int nSectors2 = 8;
@@ -380,10 +416,6 @@ struct multFilter {
     float minEta2[nRings2] = {-0.8, -0.4, +0.0, +0.4};
     float maxPhi2[nSectors2] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
     float minPhi2[nSectors2] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
-    float RhoLattice2[nCells2];
-    for (int iCh = 0; iCh < nCells2; iCh++) {
-      RhoLattice2[iCh] = 0.0;
-    }
 
     for (auto& track : tracks) {
       if (!track.isGlobalTrack()) {
@@ -398,19 +430,37 @@ struct multFilter {
       if (flPt < pt_a) {
         flPt = pt_a;
       }
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings2; ir++) {
-        for (int is = 0; is < nSectors2; is++) {
-          if (eta_a >= minEta2[ir] && eta_a < maxEta2[ir] &&
-              phi_a >= minPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2) &&
-              phi_a < maxPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2)) {
-            RhoLattice2[i_ch]++;
+    }
+    auto flatenicityGlob = [&]() {
+      return features.get(kFlatGlob, [&]() {
+        if (!(multTrack > cfgFlatMinMultGlob)) {
+          return 9999.f;
+        }
+        float RhoLattice2[nCells2];
+        for (int iCh = 0; iCh < nCells2; iCh++) {
+          RhoLattice2[iCh] = 0.0;
+        }
+        for (auto& track : tracks) {
+          if (!track.isGlobalTrack()) {
+            continue;
+          }
+          float eta_a = track.eta();
+          float phi_a = track.phi();
+          int i_ch = 0;
+          for (int ir = 0; ir < nRings2; ir++) {
+            for (int is = 0; is < nSectors2; is++) {
+              if (eta_a >= minEta2[ir] && eta_a < maxEta2[ir] &&
+                  phi_a >= minPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2) &&
+                  phi_a < maxPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2)) {
+                RhoLattice2[i_ch]++;
+              }
+              i_ch++;
+            }
           }
-          i_ch++;
         }
-      }
-    }
-    float flatenicity_glob = GetFlatenicity(RhoLattice2, nCells2);
+        return GetFlatenicity(RhoLattice2, nCells2);
+      });
+    };
 
     float combined_estimator1 = 0;
     float combined_estimator2 = 0;
@@ -512,6 +562,11 @@ struct multFilter {
       combined_estimator6 += ampl6[i_6] * weigthsEta6[i_6];
     }
 
+    double flatenicity_fv0 = flatenicityFV0();
+    float flatenicity_mft = flatenicityMFT();
+    float flatenicity_glob = flatenicityGlob();
+    float flatenicity_t0a = flatenicityT0A();
+    float flatenicity_t0c = flatenicityT0C();
     float flatenicity_mft_glob = (flatenicity_mft + flatenicity_glob) / 2.0;
     float flatenicity_mft_fv0 = (flatenicity_mft + flatenicity_fv0) / 2.0;
     float flatenicity_mft_glob_fv0 =
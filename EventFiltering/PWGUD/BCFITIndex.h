@@ -0,0 +1,283 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_ANALYSIS_BCFITINDEX_
+#define O2_ANALYSIS_BCFITINDEX_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Window of BCs, given by the positions of its first and last BC in a BCFITIndex
+struct BCWindow {
+  int64_t first = 0;
+  int64_t last = -1;
+  int64_t size() const { return last - first + 1; }
+};
+
+// -----------------------------------------------------------------------------
+// Stable sort of the positions 0, ..., n-1 by global BC, with a LSD radix sort
+// on 16-bit digits of globalBC - min(globalBC). Only the digits up to the range
+// of the global BCs are sorted, i.e. one or two passes within a data frame.
+inline void sortByGlobalBC(std::vector<uint64_t> const& globalBCs, std::vector<int32_t>& order)
+{
+  const int32_t n = globalBCs.size();
+  order.resize(n);
+  std::iota(order.begin(), order.end(), 0);
+  if (n < 2) {
+    return;
+  }
+  auto [minIt, maxIt] = std::minmax_element(globalBCs.begin(), globalBCs.end());
+  const uint64_t minBC = *minIt;
+  const uint64_t range = *maxIt - minBC;
+  constexpr int nBits = 16;
+  constexpr uint64_t nBins = 1 << nBits;
+  std::vector<int32_t> sorted(n);
+  std::vector<int32_t> counts(nBins);
+  for (int shift = 0; shift < 64 && (range >> shift) > 0; shift += nBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    for (int32_t i = 0; i < n; i++) {
+      counts[((globalBCs[i] - minBC) >> shift) & (nBins - 1)]++;
+    }
+    int32_t offset = 0;
+    for (auto& count : counts) {
+      std::swap(count, offset);
+      offset += count;
+    }
+    for (int32_t i = 0; i < n; i++) {
+      int32_t pos = order[i];
+      sorted[counts[((globalBCs[pos] - minBC) >> shift) & (nBins - 1)]++] = pos;
+    }
+    order.swap(sorted);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Sorted global BCs of a data frame with the FIT amplitudes of each BC.
+// The index is filled once per data frame, so that the window of compatible
+// BCs of a collision is found with a binary search in the global BCs and the
+// FIT activity of the window is read from contiguous arrays, instead of moving
+// BC iterators and summing the FIT amplitudes for each collision and cut set.
+// When filled from the BCs table, the positions in the index are the rows of the table.
+class BCFITIndex
+{
+ public:
+  // FIT amplitudes, in the order of DGCutparHolder::FITAmpLimits
+  enum FITAmplitudes { kFV0A = 0,
+                       kFT0A,
+                       kFT0C,
+                       kFDDA,
+                       kFDDC,
+                       kNFITAmplitudes };
+
+  // fill the index from a BCs table joined with Run3MatchedToBCSparse
+  template <typename TBCs>
+  void fill(TBCs const& bcs)
+  {
+    clear(bcs.size());
+    for (auto const& bc : bcs) {
+      uint8_t hasSignal = 0;
+      std::array<float, kNFITAmplitudes> amplitudes{0.};
+      if (bc.has_foundFV0()) {
+        hasSignal |= (1 << kFV0A);
+        amplitudes[kFV0A] = sumAmplitudes<float>(bc.foundFV0().amplitude());
+      }
+      if (bc.has_foundFT0()) {
+        hasSignal |= (1 << kFT0A) | (1 << kFT0C);
+        amplitudes[kFT0A] = sumAmplitudes<float>(bc.foundFT0().amplitudeA());
+        amplitudes[kFT0C] = sumAmplitudes<float>(bc.foundFT0().amplitudeC());
+      }
+      if (bc.has_foundFDD()) {
+        hasSignal |= (1 << kFDDA) | (1 << kFDDC);
+        amplitudes[kFDDA] = sumAmplitudes<int16_t>(bc.foundFDD().chargeA());
+        amplitudes[kFDDC] = sumAmplitudes<int16_t>(bc.foundFDD().chargeC());
+      }
+      add(bc.globalBC(), bc.has_foundFT0() ? bc.foundFT0Id() : -1, hasSignal, amplitudes);
+    }
+    mNRows = bcs.size();
+    mTable = bcs.asArrowTable().get();
+    mFirstBC = mNRows > 0 ? mGlobalBC.front() : 0;
+    mLastBC = mNRows > 0 ? mGlobalBC.back() : 0;
+    mIsSorted = std::is_sorted(mGlobalBC.begin(), mGlobalBC.end());
+  }
+
+  // fill the index from a FT0s table, with one entry per BC with FT0 signal
+  // only the FT0 amplitudes are set, the entries are sorted by global BC
+  template <typename TFT0s>
+  void fillFromFT0s(TFT0s const& ft0s)
+  {
+    clear(ft0s.size());
+    std::vector<uint64_t> ft0BCs;
+    ft0BCs.reserve(ft0s.size());
+    for (auto const& ft0 : ft0s) {
+      ft0BCs.push_back(ft0.bc().globalBC());
+    }
+    std::vector<int32_t> order;
+    sortByGlobalBC(ft0BCs, order);
+    // a BC with several FT0 entries keeps the last one
+    for (std::size_t i = 0; i < order.size(); i++) {
+      if (i + 1 < order.size() && ft0BCs[order[i + 1]] == ft0BCs[order[i]]) {
+        continue;
+      }
+      auto ft0 = ft0s.iteratorAt(order[i]);
+      std::array<float, kNFITAmplitudes> amplitudes{0.};
+      amplitudes[kFT0A] = sumAmplitudes<float>(ft0.amplitudeA());
+      amplitudes[kFT0C] = sumAmplitudes<float>(ft0.amplitudeC());
+      add(ft0BCs[order[i]], order[i], (1 << kFT0A) | (1 << kFT0C), amplitudes);
+    }
+    mNRows = -1;
+    mTable = nullptr;
+    mIsSorted = true;
+  }
+
+  // fill the index from a BCs table if it was not yet filled from this table
+  // to be used in tasks processing one collision at a time
+  // returns true if the index was filled, i.e. at the first call of a data frame
+  template <typename TBCs>
+  bool update(TBCs const& bcs)
+  {
+    if (isFilledFrom(bcs)) {
+      return false;
+    }
+    fill(bcs);
+    return true;
+  }
+
+  // true if the index was filled from this BCs table
+  template <typename TBCs>
+  bool isFilledFrom(TBCs const& bcs) const
+  {
+    if (mNRows != bcs.size() || mTable != bcs.asArrowTable().get()) {
+      return false;
+    }
+    return mNRows == 0 || (bcs.iteratorAt(0).globalBC() == mFirstBC && bcs.iteratorAt(mNRows - 1).globalBC() == mLastBC);
+  }
+
+  int64_t size() const { return mGlobalBC.size(); }
+  uint64_t globalBC(int64_t position) const { return mGlobalBC[position]; }
+  int32_t ft0Id(int64_t position) const { return mFT0Id[position]; }
+  float amplitude(int64_t position, int detector) const { return mAmplitudes[detector][position]; }
+  bool hasSignal(int64_t position, int detector) const { return mHasSignal[position] & (1 << detector); }
+
+  // position of a global BC, -1 if not in the index
+  int64_t find(uint64_t globalBC) const
+  {
+    auto it = std::lower_bound(mGlobalBC.begin(), mGlobalBC.end(), globalBC);
+    return (it != mGlobalBC.end() && *it == globalBC) ? it - mGlobalBC.begin() : -1;
+  }
+
+  // window of the BCs in [minBC, maxBC] next to the BC at position
+  // if the BC at position is not in [minBC, maxBC], the window is this BC only
+  BCWindow getWindow(int64_t position, int64_t minBC, uint64_t maxBC) const
+  {
+    BCWindow window{position, position};
+    uint64_t bc = mGlobalBC[position];
+    if ((int64_t)bc < minBC || bc > maxBC) {
+      return window;
+    }
+    if (mIsSorted) {
+      // the BCs in [minBC, maxBC] are contiguous
+      window.first = std::lower_bound(mGlobalBC.begin(), mGlobalBC.begin() + position, (uint64_t)minBC) - mGlobalBC.begin();
+      window.last = std::upper_bound(mGlobalBC.begin() + position, mGlobalBC.end(), maxBC) - mGlobalBC.begin() - 1;
+      return window;
+    }
+    while (window.last + 1 < size() && mGlobalBC[window.last + 1] <= maxBC && (int64_t)mGlobalBC[window.last + 1] >= minBC) {
+      window.last++;
+    }
+    while (window.first > 0 && mGlobalBC[window.first - 1] <= maxBC && (int64_t)mGlobalBC[window.first - 1] >= minBC) {
+      window.first--;
+    }
+    return window;
+  }
+
+  // FIT activity of each BC for the amplitude limits lims, bit d (FITAmplitudes) is set
+  // if detector d has a signal with amplitude not below lims[d]
+  // the bitmasks are computed once per data frame for each set of limits
+  const std::vector<uint8_t>& activity(std::vector<float> const& lims)
+  {
+    for (auto const& [limits, bits] : mActivity) {
+      if (limits == lims) {
+        return bits;
+      }
+    }
+    std::vector<uint8_t> bits(size(), 0);
+    for (int d = 0; d < kNFITAmplitudes; d++) {
+      const float* amplitudes = mAmplitudes[d].data();
+      for (int64_t i = 0; i < size(); i++) {
+        bits[i] |= (((mHasSignal[i] >> d) & 1) && !(amplitudes[i] < lims[d])) << d;
+      }
+    }
+    mActivity.emplace_back(lims, std::move(bits));
+    return mActivity.back().second;
+  }
+
+  // true if all BCs in the window are clean, as cleanFIT
+  bool isCleanFIT(BCWindow const& window, std::vector<float> const& lims)
+  {
+    auto const& bits = activity(lims);
+    return std::all_of(bits.begin() + window.first, bits.begin() + window.last + 1, [](uint8_t b) { return b == 0; });
+  }
+
+ private:
+  // same accumulator types as FV0AmplitudeA, FT0AmplitudeA, and FDDAmplitudeA
+  template <typename T, typename TAmplitudes>
+  static T sumAmplitudes(TAmplitudes const& amps)
+  {
+    T totAmplitude = 0;
+    for (auto amp : amps) {
+      totAmplitude += amp;
+    }
+    return totAmplitude;
+  }
+
+  void clear(int64_t nReserve)
+  {
+    mGlobalBC.clear();
+    mGlobalBC.reserve(nReserve);
+    mFT0Id.clear();
+    mFT0Id.reserve(nReserve);
+    mHasSignal.clear();
+    mHasSignal.reserve(nReserve);
+    for (auto& amplitudes : mAmplitudes) {
+      amplitudes.clear();
+      amplitudes.reserve(nReserve);
+    }
+    mActivity.clear();
+  }
+
+  void add(uint64_t globalBC, int32_t ft0Id, uint8_t hasSignal, std::array<float, kNFITAmplitudes> const& amplitudes)
+  {
+    mGlobalBC.push_back(globalBC);
+    mFT0Id.push_back(ft0Id);
+    mHasSignal.push_back(hasSignal);
+    for (int d = 0; d < kNFITAmplitudes; d++) {
+      mAmplitudes[d].push_back(amplitudes[d]);
+    }
+  }
+
+  std::vector<uint64_t> mGlobalBC;                                         // global BCs
+  std::vector<int32_t> mFT0Id;                                             // FT0 index of each BC, -1 if none
+  std::vector<uint8_t> mHasSignal;                                         // bit d is set if detector d has a signal
+  std::array<std::vector<float>, kNFITAmplitudes> mAmplitudes;             // FIT amplitudes of each BC
+  std::vector<std::pair<std::vector<float>, std::vector<uint8_t>>> mActivity; // FIT activity for each set of limits
+  bool mIsSorted = true;                                                   // global BCs are sorted
+  int64_t mNRows = -1;                                                     // number of rows of the BCs table, -1 if not filled from BCs
+  const void* mTable = nullptr;                                            // BCs table the index was filled from
+  uint64_t mFirstBC = 0;                                                   // global BC of the first row
+  uint64_t mLastBC = 0;                                                    // global BC of the last row
+};
+
+// -----------------------------------------------------------------------------
+#endif // O2_ANALYSIS_BCFITINDEX_
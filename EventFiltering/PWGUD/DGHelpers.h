@@ -21,6 +21,7 @@
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "EventFiltering/PWGUD/DGCutparHolder.h"
+#include "EventFiltering/PWGUD/BCFITIndex.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -54,9 +55,16 @@ bool cleanCalo(T& bc, aod::Calos& calos, std::vector<float>& lims);
 template <typename TC>
 bool hasGoodPID(DGCutparHolder diffCuts, TC track);
 
+void compatibleBCLimits(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, uint64_t mostProbableBC, int nMinBCs, int64_t& minBC, uint64_t& maxBC);
+
 template <typename T>
 T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, T const& bcs, int nMinBCs = 7);
 
+BCWindow compatibleBCWindow(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, BCFITIndex const& bcIndex, int nMinBCs = 7);
+
+template <typename T>
+T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, T const& bcs, BCFITIndex const& bcIndex, int nMinBCs = 7);
+
 // -----------------------------------------------------------------------------
 // add here Selectors for different types of diffractive events
 // Selector for Double Gap events
@@ -92,6 +100,29 @@ struct DGSelector {
       }
     }
 
+    return IsSelectedTracks(diffCuts, collision, tracks, fwdtracks);
+  };
+
+  // Same as above, with the FIT activity of the compatible BCs taken from a BCFITIndex
+  template <typename CC, typename TCs, typename FWs>
+  int IsSelected(DGCutparHolder diffCuts, CC const& collision, BCFITIndex& bcIndex, BCWindow const& bcWindow, TCs& tracks, FWs& fwdtracks)
+  {
+    LOGF(debug, "Collision %f", collision.collisionTime());
+    LOGF(debug, "Number of close BCs: %i", bcWindow.size());
+
+    // check that there are no FIT signals in any of the compatible BCs
+    // Double Gap (DG) condition
+    if (!bcIndex.isCleanFIT(bcWindow, diffCuts.FITAmpLimits())) {
+      return 1;
+    }
+
+    return IsSelectedTracks(diffCuts, collision, tracks, fwdtracks);
+  };
+
+  // Selection of the tracks, once the FIT activity is checked
+  template <typename CC, typename TCs, typename FWs>
+  int IsSelectedTracks(DGCutparHolder& diffCuts, CC const& collision, TCs& tracks, FWs& fwdtracks)
+  {
     // no activity in muon arm
     LOGF(debug, "Muons %i", fwdtracks.size());
     for (auto& muon : fwdtracks) {
@@ -191,15 +222,11 @@ struct DGSelector {
 // around t_coll could potentially be the true BC. ndt is typically 4. The
 // total width of the time window is required to be at least 2*nMinBCs* LHCBunchSpacingNS.
 
-template <typename T>
-T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, T const& bcs, int nMinBCs)
+void compatibleBCLimits(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, uint64_t mostProbableBC, int nMinBCs, int64_t& minBC, uint64_t& maxBC)
 {
   LOGF(debug, "Collision time / resolution [ns]: %f / %f", collision.collisionTime(), collision.collisionTimeRes());
 
-  auto bcIter = collision.bc_as<T>();
-
   // due to the filling scheme the most probably BC may not be the one estimated from the collision time
-  uint64_t mostProbableBC = bcIter.globalBC();
   uint64_t meanBC = mostProbableBC - std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
 
   // enforce minimum number for deltaBC
@@ -208,11 +235,21 @@ T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collisi
     deltaBC = nMinBCs;
   }
 
-  int64_t minBC = meanBC - deltaBC;
-  uint64_t maxBC = meanBC + deltaBC;
+  minBC = meanBC - deltaBC;
+  maxBC = meanBC + deltaBC;
   if (minBC < 0) {
     minBC = 0;
   }
+}
+
+template <typename T>
+T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, T const& bcs, int nMinBCs)
+{
+  auto bcIter = collision.bc_as<T>();
+
+  int64_t minBC;
+  uint64_t maxBC;
+  compatibleBCLimits(collision, ndt, bcIter.globalBC(), nMinBCs, minBC, maxBC);
 
   // find slice of BCs table with BC in [minBC, maxBC]
   int64_t maxBCId = bcIter.globalIndex();
@@ -239,6 +276,31 @@ T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collisi
   return slice;
 }
 
+// -----------------------------------------------------------------------------
+// Same window of compatible BCs as compatibleBCs, found with a binary search
+// in a BCFITIndex filled from the BCs table of the data frame.
+// The positions of the window are the rows of the BCs table.
+BCWindow compatibleBCWindow(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, BCFITIndex const& bcIndex, int nMinBCs)
+{
+  int64_t minBC;
+  uint64_t maxBC;
+  compatibleBCLimits(collision, ndt, bcIndex.globalBC(collision.bcId()), nMinBCs, minBC, maxBC);
+
+  auto window = bcIndex.getWindow(collision.bcId(), minBC, maxBC);
+  LOGF(debug, "  BC range: %i (%d) - %i (%d)", minBC, window.first, maxBC, window.last);
+  return window;
+}
+
+template <typename T>
+T compatibleBCs(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, int ndt, T const& bcs, BCFITIndex const& bcIndex, int nMinBCs)
+{
+  auto window = compatibleBCWindow(collision, ndt, bcIndex, nMinBCs);
+
+  T slice{{bcs.asArrowTable()->Slice(window.first, window.size())}, (uint64_t)window.first};
+  bcs.copyIndexBindings(slice);
+  return slice;
+}
+
 // -----------------------------------------------------------------------------
 // function to check if track provides good PID information
 // Checks the nSigma for any particle assumption to be within limits.
@@ -76,6 +76,9 @@ struct DGFilterRun3 {
   // DG selector
   DGSelector dgSelector;
 
+  // global BCs and FIT activity of the BCs of the data frame
+  BCFITIndex bcIndex;
+
   // histograms with cut statistics
   // bin:
   //   1: All collisions
@@ -128,8 +131,8 @@ struct DGFilterRun3 {
                aod::FDDs& fdds)
   {
 
-    // nominal BC
-    auto bc = collision.bc_as<BCs>();
+    // BC index, filled once per data frame
+    bcIndex.update(bcs);
 
     // loop over 4 cases
     bool ccs[4]{false};
@@ -157,12 +160,12 @@ struct DGFilterRun3 {
           continue;
       }
 
-      // obtain slice of compatible BCs
-      auto bcRange = compatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
-      LOGF(debug, "  Number of compatible BCs in +- %i / %i dtcoll: %i", diffCuts.NDtcoll(), diffCuts.minNBCs(), bcRange.size());
+      // obtain window of compatible BCs
+      auto bcWindow = compatibleBCWindow(collision, diffCuts.NDtcoll(), bcIndex, diffCuts.minNBCs());
+      LOGF(debug, "  Number of compatible BCs in +- %i / %i dtcoll: %i", diffCuts.NDtcoll(), diffCuts.minNBCs(), bcWindow.size());
 
       // apply DG selection
-      auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bc, bcRange, tracks, fwdtracks);
+      auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bcIndex, bcWindow, tracks, fwdtracks);
 
       // save decision
       if (isDGEvent == 0) {
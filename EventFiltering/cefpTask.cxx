@@ -19,9 +19,11 @@
 
 #include "Framework/HistogramRegistry.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cstdio>
 #include <random>
+#include <thread>
 #include <fmt/format.h>
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
@@ -202,6 +204,8 @@ struct centralEventFilterTask {
 
   HistogramRegistry scalers{"scalers", {}, OutputObjHandlingPolicy::AnalysisObject, true, true};
   Produces<aod::CefpDecisions> tags;
+  Produces<aod::CefpTriggers> triggers;
+  Configurable<int> nThreads{"nThreads", 1, "max. number of threads unpacking the decisions of the filter tables"};
 
   FILTER_CONFIGURABLE(NucleiFilters);
   FILTER_CONFIGURABLE(DiffractionFilters);
@@ -229,6 +233,15 @@ struct centralEventFilterTask {
     mFiltered->GetXaxis()->SetBinLabel(1, "Total number of events");
     int bin{2};
 
+    // dictionary of the trigger bitmaps, stored with the scalers
+    int nBits = FillFiltersBitsMap(FiltersPack, mTriggerBits);
+    auto mTriggerBitsDictionary = std::get<std::shared_ptr<TH1>>(scalers.add("mTriggerBits", fmt::format("Trigger bits, dictionary version {};;", TriggerBitsVersion).data(), HistType::kTH1F, {{nBits, -0.5, nBits - 0.5}}));
+    for (auto& table : mTriggerBits) {
+      for (auto& column : table.second) {
+        mTriggerBitsDictionary->GetXaxis()->SetBinLabel(column.second + 1, column.first.data());
+      }
+    }
+
     // for (auto& spec : reinterpret_cast<std::unique_ptr<ConfigParamStore>*>(&(initc.mOptions))->get()->specs()) {
     //   std::cout << "Configuration available: " << spec.name << "\t" << int(spec.type) << std::endl;
     //   auto filterOpt = initc.mOptions.get<LabeledArray<float>>(spec.name.data());
@@ -265,8 +278,9 @@ struct centralEventFilterTask {
     auto mScalers{scalers.get<TH1>(HIST("mScalers"))};
     auto mFiltered{scalers.get<TH1>(HIST("mFiltered"))};
 
+    // 1. trigger columns of all the filter tables, read from the inputs in a single pass
     int64_t nEvents{-1};
-    std::vector<bool> outDecision;
+    triggerColumns.clear();
     for (auto& tableName : mDownscaling) {
       if (!pc.inputs().isValid(tableName.first)) {
         LOG(fatal) << tableName.first << " table is not valid.";
@@ -279,33 +293,68 @@ struct centralEventFilterTask {
         LOG(fatal) << "Inconsistent number of rows across trigger tables.";
       }
 
-      if (outDecision.size() == 0)
-        outDecision.resize(nEvents, false);
-
-      auto schema{tablePtr->schema()};
+      auto& tableBits{mTriggerBits[tableName.first]};
       for (auto& colName : tableName.second) {
-        int bin{mScalers->GetXaxis()->FindBin(colName.first.data())};
-        double binCenter{mScalers->GetXaxis()->GetBinCenter(bin)};
         auto column{tablePtr->GetColumnByName(colName.first)};
-        double downscaling{colName.second};
-        if (column) {
-          int entry = 0;
-          for (int64_t iC{0}; iC < column->num_chunks(); ++iC) {
-            auto chunk{column->chunk(iC)};
-            auto boolArray = std::static_pointer_cast<arrow::BooleanArray>(chunk);
-            for (int64_t iS{0}; iS < chunk->length(); ++iS) {
-              if (boolArray->Value(iS)) {
-                mScalers->Fill(binCenter);
-                if (mUniformGenerator(mGeneratorEngine) < downscaling) {
-                  mFiltered->Fill(binCenter);
-                  outDecision[entry] = true;
-                }
-              }
-              entry++;
+        auto columnBit{tableBits.find(colName.first)};
+        if (column && columnBit != tableBits.end()) {
+          int bin{mScalers->GetXaxis()->FindBin(colName.first.data())};
+          triggerColumns.push_back({column, uint64_t{1} << columnBit->second, mScalers->GetXaxis()->GetBinCenter(bin), colName.second});
+        }
+      }
+    }
+
+    // 2. unpacking of the decisions of the filters, concurrently on up to nThreads threads
+    firedRows.resize(triggerColumns.size());
+    auto unpackColumns = [&](std::size_t first, std::size_t last) {
+      for (std::size_t iCol = first; iCol < last; ++iCol) {
+        auto& fired{firedRows[iCol]};
+        fired.clear();
+        auto& column{triggerColumns[iCol].column};
+        int64_t entry{0};
+        for (int64_t iC{0}; iC < column->num_chunks(); ++iC) {
+          auto chunk{column->chunk(iC)};
+          auto boolArray = std::static_pointer_cast<arrow::BooleanArray>(chunk);
+          for (int64_t iS{0}; iS < chunk->length(); ++iS) {
+            if (boolArray->Value(iS)) {
+              fired.push_back(entry);
             }
+            entry++;
           }
         }
       }
+    };
+    const std::size_t nColumns{triggerColumns.size()};
+    const std::size_t nThreadsUsed{std::clamp<std::size_t>(static_cast<std::size_t>(std::max(nEvents, int64_t{0})) * nColumns / nDecisionsPerThreadMin, 1, std::max(1, nThreads.value))};
+    if (nThreadsUsed == 1) {
+      unpackColumns(0, nColumns);
+    } else {
+      const std::size_t nColumnsPerThread{(nColumns + nThreadsUsed - 1) / nThreadsUsed};
+      std::vector<std::thread> threads;
+      for (std::size_t iThread{1}; iThread < nThreadsUsed; ++iThread) {
+        threads.emplace_back(unpackColumns, std::min(nColumns, iThread * nColumnsPerThread), std::min(nColumns, (iThread + 1) * nColumnsPerThread));
+      }
+      unpackColumns(0, std::min(nColumns, nColumnsPerThread));
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+
+    // 3. scalers and downscaling, in the order of the columns to keep the sequence of random numbers
+    std::vector<bool> outDecision(std::max(nEvents, int64_t{0}), false);
+    std::vector<uint64_t> outFired(outDecision.size(), 0);
+    std::vector<uint64_t> outSelected(outDecision.size(), 0);
+    for (std::size_t iCol{0}; iCol < nColumns; ++iCol) {
+      auto& trigger{triggerColumns[iCol]};
+      for (auto entry : firedRows[iCol]) {
+        mScalers->Fill(trigger.binCenter);
+        outFired[entry] |= trigger.bit;
+        if (mUniformGenerator(mGeneratorEngine) < trigger.downscaling) {
+          mFiltered->Fill(trigger.binCenter);
+          outDecision[entry] = true;
+          outSelected[entry] |= trigger.bit;
+        }
+      }
     }
     mScalers->SetBinContent(1, mScalers->GetBinContent(1) + nEvents);
     mFiltered->SetBinContent(1, mFiltered->GetBinContent(1) + nEvents);
@@ -329,11 +378,24 @@ struct centralEventFilterTask {
       auto CollTimeArray = std::static_pointer_cast<arrow::NumericArray<arrow::DoubleType>>(chunkCollTime);
       for (int64_t iD{0}; iD < chunkBC->length(); ++iD) {
         tags(BCArray->Value(iD), CollTimeArray->Value(iD), outDecision[iD]);
+        triggers(outFired[iD], outSelected[iD]);
         entryD++;
       }
     }
   }
 
+  std::unordered_map<std::string, std::unordered_map<std::string, int>> mTriggerBits;
+
+  // boolean column of a filter table with its bit, scaler bin and downscaling
+  struct TriggerColumn {
+    std::shared_ptr<arrow::ChunkedArray> column;
+    uint64_t bit;
+    double binCenter;
+    double downscaling;
+  };
+  static constexpr std::size_t nDecisionsPerThreadMin{100000};
+  std::vector<TriggerColumn> triggerColumns;
+  std::vector<std::vector<int64_t>> firedRows; // rows with the trigger fired, for each trigger column
   std::mt19937_64 mGeneratorEngine;
   std::uniform_real_distribution<double> mUniformGenerator = std::uniform_real_distribution<double>(0., 1.);
 };
@@ -0,0 +1,62 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file filterEventFeatureCache.h
+/// \brief Per-event features (e.g. flatenicities) of one collision, computed at their first use and shared by the selections of a filter
+
+#ifndef O2_ANALYSIS_FILTEREVENTFEATURECACHE_H_
+#define O2_ANALYSIS_FILTEREVENTFEATURECACHE_H_
+
+#include <array>
+#include <bitset>
+
+namespace o2::analysis::filtering
+{
+
+/// Features of one event, each one computed by its selections at the first request and kept until the next event
+/// \note Expensive features are evaluated only if a selection asks for them, e.g. after the cheaper
+/// prerequisites of the selection are passed, and once per event however many selections use them.
+/// \tparam nFeatures  number of features, identified by the positions 0 to nFeatures - 1
+template <int nFeatures>
+class EventFeatureCache
+{
+ public:
+  /// Forgets the features of the previous event
+  void reset() { mComputed.reset(); }
+
+  /// \return feature of the event, computed with compute() if not yet done for this event
+  template <typename TCompute>
+  float get(int feature, TCompute&& compute)
+  {
+    if (!mComputed.test(feature)) {
+      mValues[feature] = compute();
+      mComputed.set(feature);
+    }
+    return mValues[feature];
+  }
+
+  /// Stores a feature computed together with others
+  void set(int feature, float value)
+  {
+    mValues[feature] = value;
+    mComputed.set(feature);
+  }
+
+  bool isComputed(int feature) const { return mComputed.test(feature); }
+
+ private:
+  std::array<float, nFeatures> mValues{}; ///< values of the features
+  std::bitset<nFeatures> mComputed;       ///< features computed for the current event
+};
+
+} // namespace o2::analysis::filtering
+
+#endif // O2_ANALYSIS_FILTEREVENTFEATURECACHE_H_
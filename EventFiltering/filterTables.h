@@ -12,6 +12,11 @@
 #define O2_ANALYSIS_TRIGGER_H_
 
 #include <array>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include "Framework/AnalysisDataModel.h"
 
 namespace o2::aod
@@ -87,12 +92,36 @@ DECLARE_SOA_COLUMN(LeadingPtTrack, hasLeadingPtTrack, bool);               //! e
 namespace decision
 {
 
-DECLARE_SOA_COLUMN(BCId, hasBCId, int);                     //! Bunch crossing Id
-DECLARE_SOA_COLUMN(CollisionTime, hasCollisionTime, float); //! Collision time
-DECLARE_SOA_COLUMN(CefpSelected, hasCefpSelected, bool);    //! CEFP decision
+DECLARE_SOA_COLUMN(BCId, hasBCId, int);                         //! Bunch crossing Id
+DECLARE_SOA_COLUMN(CollisionTime, hasCollisionTime, float);     //! Collision time
+DECLARE_SOA_COLUMN(CefpSelected, hasCefpSelected, bool);        //! CEFP decision
+DECLARE_SOA_COLUMN(TriggerFired, triggerFired, uint64_t);       //! Bitmap of the fired triggers, see TriggerBitsVersion
+DECLARE_SOA_COLUMN(TriggerSelected, triggerSelected, uint64_t); //! Bitmap of the triggers selected after downscaling
 
 } // namespace decision
 
+namespace hfcandlog
+{
+/// Bits of the tags of the HF candidates in the decision log
+enum TagBits : uint8_t {
+  kCharmTagged = 0, // prompt-tagged by the BDT, or preselected without ML
+  kBeautyTagged,    // non-prompt-tagged by the BDT, or preselected without ML
+  kInMassRange,     // in the charm-hadron mass window used for the beauty triggers
+  kHighPt           // above the pT threshold of the high-pT trigger
+};
+
+DECLARE_SOA_INDEX_COLUMN(Collision, collision);                   //!
+DECLARE_SOA_INDEX_COLUMN_FULL(Prong0, prong0, int, Tracks, "_0"); //! first prong
+DECLARE_SOA_INDEX_COLUMN_FULL(Prong1, prong1, int, Tracks, "_1"); //! second prong
+DECLARE_SOA_INDEX_COLUMN_FULL(Prong2, prong2, int, Tracks, "_2"); //! third prong, -1 for 2-prong candidates
+DECLARE_SOA_COLUMN(CandType, candType, int8_t);                   //! charm-hadron species: D0, D+, Ds+, Lc+, Xic+
+DECLARE_SOA_COLUMN(Pt, pt, float);                                //! transverse momentum
+DECLARE_SOA_COLUMN(BdtScoreBkg, bdtScoreBkg, float);              //! BDT background score, NaN if not evaluated
+DECLARE_SOA_COLUMN(BdtScorePrompt, bdtScorePrompt, float);        //! BDT prompt score, NaN if not evaluated
+DECLARE_SOA_COLUMN(BdtScoreNonPrompt, bdtScoreNonPrompt, float);  //! BDT non-prompt score, NaN if not evaluated
+DECLARE_SOA_COLUMN(Tags, tags, uint8_t);                          //! bitmap of TagBits
+} // namespace hfcandlog
+
 // nuclei
 DECLARE_SOA_TABLE(NucleiFilters, "AOD", "NucleiFilters", //!
                   filtering::H2, filtering::H3, filtering::He3, filtering::He4);
@@ -114,6 +143,14 @@ DECLARE_SOA_TABLE(HfFilters, "AOD", "HfFilters", //!
 
 using HfFilter = HfFilters::iterator;
 
+// decision log of the candidates of the HF triggers, one row per preselected candidate and species
+DECLARE_SOA_TABLE(HfCandLogs, "AOD", "HfCandLog", //!
+                  hfcandlog::CollisionId, hfcandlog::Prong0Id, hfcandlog::Prong1Id, hfcandlog::Prong2Id,
+                  hfcandlog::CandType, hfcandlog::Pt,
+                  hfcandlog::BdtScoreBkg, hfcandlog::BdtScorePrompt, hfcandlog::BdtScoreNonPrompt,
+                  hfcandlog::Tags);
+using HfCandLog = HfCandLogs::iterator;
+
 // correlations
 DECLARE_SOA_TABLE(CFFiltersTwoN, "AOD", "CFFiltersTwoN", //!
                   filtering::PD, filtering::LD);
@@ -147,6 +184,11 @@ DECLARE_SOA_TABLE(CefpDecisions, "AOD", "CefpDecision", //!
                   decision::BCId, decision::CollisionTime, decision::CefpSelected);
 using CefpDecision = CefpDecisions::iterator;
 
+// cefp trigger bitmaps, joinable with CefpDecisions
+DECLARE_SOA_TABLE(CefpTriggers, "AOD", "CefpTriggers", //!
+                  decision::TriggerFired, decision::TriggerSelected);
+using CefpTrigger = CefpTriggers::iterator;
+
 /// List of the available filters, the description of their tables and the name of the tasks
 constexpr int NumberOfFilters{9};
 constexpr std::array<char[32], NumberOfFilters> AvailableFilters{"NucleiFilters", "DiffractionFilters", "DqFilters", "HfFilters", "CFFiltersTwoN", "CFFilters", "JetFilters", "StrangenessFilters", "MultFilters"};
@@ -173,6 +215,85 @@ void FillFiltersMap(o2::framework::pack<T...>, std::unordered_map<std::string, s
   (addColumnsToMap<T>(typename T::iterator::persistent_columns_t{}, map), ...);
 }
 
+/// Version of the bit dictionary of the trigger bitmaps.
+/// The boolean columns of the filters are numbered in the order of FiltersPack and of their tables,
+/// the version must be increased whenever a filter or a column is added, removed or reordered.
+constexpr int TriggerBitsVersion{1};
+
+template <typename T, typename... C>
+void addBitsToMap(o2::framework::pack<C...>, std::unordered_map<std::string, std::unordered_map<std::string, int>>& map, int& bit)
+{
+  ((std::is_same_v<typename C::type, bool> ? (void)(map[MetadataTrait<T>::metadata::tableLabel()][C::columnLabel()] = bit++) : (void)0), ...);
+}
+
+/// Fills the bit of each boolean filter column, indexed by table and column label
+/// \return number of bits
+template <typename... T>
+int FillFiltersBitsMap(o2::framework::pack<T...>, std::unordered_map<std::string, std::unordered_map<std::string, int>>& map)
+{
+  int bit{0};
+  (addBitsToMap<T>(typename T::iterator::persistent_columns_t{}, map, bit), ...);
+  if (bit > 64) {
+    LOG(fatal) << "The " << bit << " trigger columns do not fit in the 64 bits of the trigger bitmaps";
+  }
+  return bit;
+}
+
+/// Mask of the bits of some triggers
+/// \param triggers  labels of the filter columns, e.g. "fHfHighPt"
+inline uint64_t TriggerMask(std::vector<std::string> const& triggers)
+{
+  std::unordered_map<std::string, std::unordered_map<std::string, int>> bits;
+  FillFiltersBitsMap(FiltersPack, bits);
+  uint64_t mask{0};
+  for (auto& trigger : triggers) {
+    bool found{false};
+    for (auto& table : bits) {
+      auto column = table.second.find(trigger);
+      if (column != table.second.end()) {
+        mask |= uint64_t{1} << column->second;
+        found = true;
+      }
+    }
+    if (!found) {
+      LOG(fatal) << "Unknown trigger " << trigger;
+    }
+  }
+  return mask;
+}
+
+/// Selects the rows of a table with a trigger bitmap column, e.g. from a skimmed AO2D, without reading the filter tables.
+/// A row passes if it has at least one bit of anyOf (ignored if 0) and all the bits of allOf.
+/// \param table  arrow table of CefpTriggers
+/// \param columnLabel  label of the bitmap column, "fTriggerFired" or "fTriggerSelected"
+/// \param rows  indices of the selected rows, appended
+inline void SelectTriggeredRows(std::shared_ptr<arrow::Table> const& table, std::string const& columnLabel, uint64_t anyOf, uint64_t allOf, std::vector<int64_t>& rows)
+{
+  auto column{table->GetColumnByName(columnLabel)};
+  if (!column) {
+    LOG(fatal) << "Missing trigger bitmap column " << columnLabel;
+  }
+  const uint64_t any{anyOf != 0 ? anyOf : ~uint64_t{0}};
+  std::vector<uint8_t> pass;
+  int64_t offset{0};
+  for (int64_t iC{0}; iC < column->num_chunks(); ++iC) {
+    auto chunk = std::static_pointer_cast<arrow::NumericArray<arrow::UInt64Type>>(column->chunk(iC));
+    const uint64_t* bitmaps{chunk->raw_values()};
+    const int64_t length{chunk->length()};
+    // branchless pass over the bitmaps, then gather of the selected rows
+    pass.resize(length);
+    for (int64_t i{0}; i < length; ++i) {
+      pass[i] = ((bitmaps[i] & any) != 0) & ((bitmaps[i] & allOf) == allOf);
+    }
+    for (int64_t i{0}; i < length; ++i) {
+      if (pass[i]) {
+        rows.push_back(offset + i);
+      }
+    }
+    offset += length;
+  }
+}
+
 template <typename... C>
 static std::vector<std::string> ColumnsNames(o2::framework::pack<C...>)
 {
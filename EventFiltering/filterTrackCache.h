@@ -0,0 +1,147 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file filterTrackCache.h
+/// \brief Per-track features (nsigma, DCA, selection bits) of the tracks of one collision, shared by the selections of a filter
+
+#ifndef O2_ANALYSIS_FILTERTRACKCACHE_H_
+#define O2_ANALYSIS_FILTERTRACKCACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ReconstructionDataFormats/PID.h"
+#include "Common/DataModel/PIDResponse.h"
+
+namespace o2::analysis::filtering
+{
+
+/// Bits of the track features
+enum TrackFeatureBits : uint8_t {
+  kHasTOF = 0,
+  kIsGlobalTrack
+};
+
+/// Features of one track for the species ids
+template <o2::track::PID::ID... ids>
+class TrackFeatures
+{
+ public:
+  static constexpr int nSpecies = sizeof...(ids);
+
+  /// \return position of the species id in the features
+  template <o2::track::PID::ID id>
+  static constexpr int index()
+  {
+    int position = -1, i = 0;
+    ((position = (ids == id && position < 0) ? i : position, ++i), ...);
+    return position;
+  }
+
+  template <o2::track::PID::ID id>
+  float tpcNSigma() const
+  {
+    static_assert(index<id>() >= 0, "species not in the features");
+    return mTPCNSigma[index<id>()];
+  }
+
+  template <o2::track::PID::ID id>
+  float tofNSigma() const
+  {
+    static_assert(index<id>() >= 0, "species not in the features");
+    return mTOFNSigma[index<id>()];
+  }
+
+  /// \param i  position of the species in the features
+  float tpcNSigma(int i) const { return mTPCNSigma[i]; }
+  /// \param i  position of the species in the features
+  float tofNSigma(int i) const { return mTOFNSigma[i]; }
+
+  float pt() const { return mPt; }
+  float eta() const { return mEta; }
+  float dcaXY() const { return mDcaXY; }
+  float dcaZ() const { return mDcaZ; }
+  bool hasTOF() const { return mBits & (1 << kHasTOF); }
+  bool isGlobalTrack() const { return mBits & (1 << kIsGlobalTrack); }
+
+  /// Reads the features of a track.
+  /// \param track  track joined with the TPC and TOF PID tables of the species, the DCA and the track selection
+  template <typename TTrack>
+  void set(TTrack const& track)
+  {
+    int i = 0;
+    ((mTPCNSigma[i] = o2::aod::pidutils::tpcNSigma<ids>(track), mTOFNSigma[i] = o2::aod::pidutils::tofNSigma<ids>(track), ++i), ...);
+    mPt = track.pt();
+    mEta = track.eta();
+    mDcaXY = track.dcaXY();
+    mDcaZ = track.dcaZ();
+    mBits = (track.hasTOF() << kHasTOF) | (track.isGlobalTrack() << kIsGlobalTrack);
+  }
+
+ private:
+  std::array<float, nSpecies> mTPCNSigma{}; ///< TPC nsigma of the species
+  std::array<float, nSpecies> mTOFNSigma{}; ///< TOF nsigma of the species
+  float mPt = 0.f;                          ///< pT
+  float mEta = 0.f;                         ///< eta
+  float mDcaXY = 0.f;                       ///< DCAxy to the PV
+  float mDcaZ = 0.f;                        ///< DCAz to the PV
+  uint8_t mBits = 0;                        ///< bits of TrackFeatureBits
+};
+
+/// Features of the tracks of one collision, read once and looked up by the global index of the tracks
+/// \note The candidates of a collision (e.g. cascades) share their daughter tracks: the features are read
+/// from the joined PID tables once per track instead of once per candidate, and the daughters are not
+/// dereferenced as joined iterators. Tracks outside the cached range are read on demand.
+template <o2::track::PID::ID... ids>
+class TrackFeatureCache
+{
+ public:
+  using Features = TrackFeatures<ids...>;
+
+  /// Reads the features of the tracks.
+  /// \param tracks  tracks of the collision, not filtered so that their global indices are contiguous
+  template <typename TTracks>
+  void fill(TTracks const& tracks)
+  {
+    mOffset = tracks.offset();
+    mFeatures.resize(tracks.size());
+    for (auto const& track : tracks) {
+      mFeatures[track.globalIndex() - mOffset].set(track);
+    }
+  }
+
+  /// \param globalIndex  global index of the track
+  /// \param getTrack  function returning the track iterator, called only if the track is not cached
+  /// \return features of the track
+  template <typename F>
+  Features get(int64_t globalIndex, F&& getTrack) const
+  {
+    const int64_t position = globalIndex - mOffset;
+    if (position >= 0 && position < static_cast<int64_t>(mFeatures.size())) {
+      return mFeatures[position];
+    }
+    Features features;
+    features.set(getTrack());
+    return features;
+  }
+
+  std::size_t size() const { return mFeatures.size(); }
+  Features const& operator[](std::size_t position) const { return mFeatures[position]; }
+
+ private:
+  int64_t mOffset = 0;               ///< global index of the first cached track
+  std::vector<Features> mFeatures{}; ///< features of the cached tracks, in the order of the tracks
+};
+
+} // namespace o2::analysis::filtering
+
+#endif // O2_ANALYSIS_FILTERTRACKCACHE_H_
@@ -18,6 +18,7 @@
 #include "ReconstructionDataFormats/BCRange.h"
 #include "filterTables.h"
 #include "PWGUD/DGHelpers.h"
+#include "Common/Core/BCRangeIndex.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -44,6 +45,9 @@ struct BCRangeSelector {
   // buffer for task output
   std::vector<o2::dataformats::IRFrame> res;
 
+  // index of the selected BC ranges of all the processed data frames, to be stored next to the skimmed AO2D
+  OutputObj<BCRangeIndex> bcRangeIndex{BCRangeIndex("bcRangeIndex")};
+
   void init(o2::framework::InitContext&)
   {
     cbcrs.reset();
@@ -96,7 +100,12 @@ struct BCRangeSelector {
       IR1.setFromLong(limit.first);
       IR2.setFromLong(limit.second);
       res.emplace_back(IR1, IR2);
+      bcRangeIndex->AddRange(IR1.toLong(), IR2.toLong());
+    }
+    if (bcs.size() > 0) {
+      bcRangeIndex->SetRunNumber(bcs.begin().runNumber());
     }
+    bcRangeIndex->Compact();
     // make res an output
     pc.outputs().snapshot({"PPF", "IFRAMES", 0, Lifetime::Timeframe}, res);
 
@@ -0,0 +1,332 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_ANALYSIS_BINNEDCORRELATIONS_H
+#define O2_ANALYSIS_BINNEDCORRELATIONS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Framework/Logger.h"
+
+// Two-particle correlations from per-event occupancy maps
+//
+// The trigger and associated particles of an event are histogrammed into (pT, eta, phi) grids, and the pair
+// distribution in (delta eta, delta phi) is the cross-correlation of the grids: in phi with a discrete Fourier
+// transform, in eta by direct convolution. Only filling the grids depends on the number N of particles, the rest on
+// the number of cells: the cost per event is O(N) plus a constant instead of O(N^2).
+//
+// A cell difference k stands for the pairs with a distance in ((k-1), (k+1)) cell widths, distributed as a triangle
+// for particles distributed uniformly within the cells. If the bin edges of the delta eta and delta phi axes are
+// multiples of the cell widths, giving half of the pairs to +- half a cell width thus fills the same bins as the
+// pairs would on average: the result matches the pair-by-pair filling within the statistical fluctuations of the
+// positions of the particles within the cells.
+// Only selections on single particles can be applied; the pT order is applied on the pT bins, which then must not
+// overlap between trigger and associated particles.
+
+class BinnedCorrelations
+{
+ public:
+  /// Sets up the grids
+  /// \param ptTriggerEdges  pT bin edges of the trigger particles
+  /// \param ptAssocEdges  pT bin edges of the associated particles
+  /// \param etaMax  particles are in |eta| < etaMax
+  /// \param etaCell  width of a cell in eta
+  /// \param nPhi  number of cells in phi in [0, 2 pi)
+  /// \param ptOrder  only pairs with pT,assoc < pT,trig
+  void init(const std::vector<double>& ptTriggerEdges, const std::vector<double>& ptAssocEdges, float etaMax, float etaCell, int nPhi, bool ptOrder)
+  {
+    mPtTriggerEdges = ptTriggerEdges;
+    mPtAssocEdges = ptAssocEdges;
+    mNPtTrigger = ptTriggerEdges.size() - 1;
+    mNPtAssoc = ptAssocEdges.size() - 1;
+    mEtaMin = -etaMax;
+    mEtaCell = etaCell;
+    mNEta = std::ceil(2 * etaMax / etaCell - 1e-6);
+    mNPhi = nPhi;
+    mNHalf = nPhi / 2 + 1;
+    mPhiCell = 2. * M_PI / nPhi;
+
+    mPairSelected.assign(mNPtTrigger * mNPtAssoc, true);
+    for (int i = 0; ptOrder && i < mNPtTrigger; i++) {
+      for (int j = 0; j < mNPtAssoc; j++) {
+        if (ptAssocEdges[j] >= ptTriggerEdges[i + 1]) {
+          mPairSelected[i * mNPtAssoc + j] = false;
+        } else if (ptAssocEdges[j + 1] > ptTriggerEdges[i]) {
+          LOGF(fatal, "Binned correlations: pT order requested but the associated pT bin %d overlaps with the trigger pT bin %d", j, i);
+        }
+      }
+    }
+
+    mCos.resize(mNPhi);
+    mSin.resize(mNPhi);
+    for (int k = 0; k < mNPhi; k++) {
+      mCos[k] = std::cos(2. * M_PI * k / mNPhi);
+      mSin[k] = std::sin(2. * M_PI * k / mNPhi);
+    }
+
+    mTrigger.resize(mNPtTrigger * mNEta * mNPhi);
+    mTrigger2.resize(mTrigger.size());
+    mTriggerRows.resize(mNPtTrigger * mNEta);
+    mAssoc.resize(mNPtAssoc * mNEta * mNPhi);
+    mAssoc2.resize(mAssoc.size());
+    mAssocRows.resize(mNPtAssoc * mNEta);
+    mSelf.resize(mNPtTrigger * mNPtAssoc);
+    mSelf2.resize(mSelf.size());
+    clear();
+  }
+
+  /// Removes all the particles, to be called for each event
+  void clear()
+  {
+    std::fill(mTrigger.begin(), mTrigger.end(), 0.);
+    std::fill(mTrigger2.begin(), mTrigger2.end(), 0.);
+    std::fill(mTriggerRows.begin(), mTriggerRows.end(), false);
+    std::fill(mAssoc.begin(), mAssoc.end(), 0.);
+    std::fill(mAssoc2.begin(), mAssoc2.end(), 0.);
+    std::fill(mAssocRows.begin(), mAssocRows.end(), false);
+    std::fill(mSelf.begin(), mSelf.end(), 0.);
+    std::fill(mSelf2.begin(), mSelf2.end(), 0.);
+    mWeighted = false;
+  }
+
+  void addTrigger(float pt, float eta, float phi, float weight)
+  {
+    add(mTrigger, mTrigger2, mTriggerRows, mPtTriggerEdges, pt, eta, phi, weight);
+  }
+
+  void addAssociated(float pt, float eta, float phi, float weight)
+  {
+    add(mAssoc, mAssoc2, mAssocRows, mPtAssocEdges, pt, eta, phi, weight);
+  }
+
+  /// Removes the pair of a particle with itself, for a particle added as trigger and as associated particle of the same event
+  /// \param weight  product of the trigger and associated weights of the particle
+  void removeSelfPair(float pt, float weight)
+  {
+    const int ptTrigger = findPtBin(mPtTriggerEdges, pt);
+    const int ptAssoc = findPtBin(mPtAssocEdges, pt);
+    if (ptTrigger < 0 || ptAssoc < 0) {
+      return;
+    }
+    mSelf[ptTrigger * mNPtAssoc + ptAssoc] += weight;
+    mSelf2[ptTrigger * mNPtAssoc + ptAssoc] += weight * weight;
+  }
+
+  double getPtTriggerCenter(int bin) const { return 0.5 * (mPtTriggerEdges[bin] + mPtTriggerEdges[bin + 1]); }
+  double getPtAssocCenter(int bin) const { return 0.5 * (mPtAssocEdges[bin] + mPtAssocEdges[bin + 1]); }
+
+  /// Correlates the trigger particles with the associated particles of an event (this object itself for the same event)
+  /// \param assoc  grids with the associated particles
+  /// \param fill  called as fill(ptTriggerBin, ptAssocBin, deltaEta, deltaPhi, sumw, sumw2) for the pairs at (deltaEta, deltaPhi),
+  ///              with deltaPhi in [-cell width / 2, 2 pi)
+  template <typename F>
+  void correlate(const BinnedCorrelations& assoc, F&& fill)
+  {
+    const bool weighted = mWeighted || assoc.mWeighted;
+    const int nDeltaEta = 2 * mNEta - 1;
+    const int nAcc = mNPtTrigger * mNPtAssoc * nDeltaEta;
+    mAccRe.assign(nAcc * mNHalf, 0.);
+    mAccIm.assign(nAcc * mNHalf, 0.);
+    mAccUsed.assign(nAcc, false);
+    if (weighted) {
+      mAcc2Re.assign(nAcc * mNHalf, 0.);
+      mAcc2Im.assign(nAcc * mNHalf, 0.);
+    }
+
+    transform(mTrigger, mTriggerRows, mTriggerRe, mTriggerIm);
+    transform(assoc.mAssoc, assoc.mAssocRows, mAssocRe, mAssocIm);
+    if (weighted) {
+      transform(mTrigger2, mTriggerRows, mTrigger2Re, mTrigger2Im);
+      transform(assoc.mAssoc2, assoc.mAssocRows, mAssoc2Re, mAssoc2Im);
+    }
+
+    // products of the transforms, summed over the pairs of eta cells with the same difference
+    for (int ptT = 0; ptT < mNPtTrigger; ptT++) {
+      for (int ptA = 0; ptA < mNPtAssoc; ptA++) {
+        if (!mPairSelected[ptT * mNPtAssoc + ptA]) {
+          continue;
+        }
+        for (int eta1 = 0; eta1 < mNEta; eta1++) {
+          const int row1 = ptT * mNEta + eta1;
+          if (!mTriggerRows[row1]) {
+            continue;
+          }
+          for (int eta2 = 0; eta2 < mNEta; eta2++) {
+            const int row2 = ptA * mNEta + eta2;
+            if (!assoc.mAssocRows[row2]) {
+              continue;
+            }
+            const int acc = (ptT * mNPtAssoc + ptA) * nDeltaEta + eta1 - eta2 + mNEta - 1;
+            mAccUsed[acc] = true;
+            multiplyAdd(mTriggerRe, mTriggerIm, row1, mAssocRe, mAssocIm, row2, mAccRe, mAccIm, acc);
+            if (weighted) {
+              multiplyAdd(mTrigger2Re, mTrigger2Im, row1, mAssoc2Re, mAssoc2Im, row2, mAcc2Re, mAcc2Im, acc);
+            }
+          }
+        }
+      }
+    }
+
+    std::vector<double>& pairs = mPairs;
+    std::vector<double>& pairs2 = mPairs2;
+    for (int ptT = 0; ptT < mNPtTrigger; ptT++) {
+      for (int ptA = 0; ptA < mNPtAssoc; ptA++) {
+        for (int k = 0; k < nDeltaEta; k++) {
+          const int acc = (ptT * mNPtAssoc + ptA) * nDeltaEta + k;
+          if (!mAccUsed[acc]) {
+            continue;
+          }
+          inverse(mAccRe, mAccIm, acc, pairs);
+          if (weighted) {
+            inverse(mAcc2Re, mAcc2Im, acc, pairs2);
+          } else {
+            pairs2 = pairs;
+          }
+          if (&assoc == this && k == mNEta - 1) {
+            pairs[0] -= mSelf[ptT * mNPtAssoc + ptA];
+            pairs2[0] -= weighted ? mSelf2[ptT * mNPtAssoc + ptA] : mSelf[ptT * mNPtAssoc + ptA];
+          }
+          // the transforms leave rounding noise in the cells without pairs, small compared to the total
+          const double threshold = 1e-9 * mAccRe[acc * mNHalf];
+          const float deltaEta = (k - mNEta + 1) * mEtaCell;
+          for (int kPhi = 0; kPhi < mNPhi; kPhi++) {
+            if (pairs[kPhi] <= threshold) {
+              continue;
+            }
+            const float deltaPhi = kPhi * mPhiCell;
+            const double sumw = 0.25 * pairs[kPhi];
+            const double sumw2 = 0.25 * pairs2[kPhi];
+            for (int i = 0; i < 4; i++) {
+              fill(ptT, ptA, deltaEta + ((i & 1) ? 0.5f : -0.5f) * mEtaCell, deltaPhi + ((i & 2) ? 0.5f : -0.5f) * mPhiCell, sumw, sumw2);
+            }
+          }
+        }
+      }
+    }
+  }
+
+ protected:
+  static int findPtBin(const std::vector<double>& edges, float pt)
+  {
+    if (!(pt >= edges.front() && pt < edges.back())) {
+      return -1;
+    }
+    return std::upper_bound(edges.begin(), edges.end(), pt) - edges.begin() - 1;
+  }
+
+  void add(std::vector<double>& grid, std::vector<double>& grid2, std::vector<bool>& rows, const std::vector<double>& ptEdges, float pt, float eta, float phi, float weight)
+  {
+    const int ptBin = findPtBin(ptEdges, pt);
+    const int etaBin = std::floor((eta - mEtaMin) / mEtaCell);
+    if (ptBin < 0 || etaBin < 0 || etaBin >= mNEta) {
+      return;
+    }
+    int phiBin = std::floor(phi / mPhiCell);
+    phiBin = ((phiBin % mNPhi) + mNPhi) % mNPhi;
+    const int row = ptBin * mNEta + etaBin;
+    rows[row] = true;
+    grid[row * mNPhi + phiBin] += weight;
+    grid2[row * mNPhi + phiBin] += weight * weight;
+    if (weight != 1.f) {
+      mWeighted = true;
+    }
+  }
+
+  /// Discrete Fourier transform in phi of the filled rows, frequencies 0 to nPhi / 2
+  void transform(const std::vector<double>& grid, const std::vector<bool>& rows, std::vector<double>& re, std::vector<double>& im) const
+  {
+    re.resize(rows.size() * mNHalf);
+    im.resize(rows.size() * mNHalf);
+    for (size_t row = 0; row < rows.size(); row++) {
+      if (!rows[row]) {
+        continue;
+      }
+      const double* x = &grid[row * mNPhi];
+      for (int m = 0; m < mNHalf; m++) {
+        double sumRe = 0, sumIm = 0;
+        for (int j = 0, jm = 0; j < mNPhi; j++, jm = (jm + m) % mNPhi) {
+          sumRe += x[j] * mCos[jm];
+          sumIm -= x[j] * mSin[jm];
+        }
+        re[row * mNHalf + m] = sumRe;
+        im[row * mNHalf + m] = sumIm;
+      }
+    }
+  }
+
+  /// Adds the transform of the cross-correlation of two rows, X1 * conj(X2)
+  void multiplyAdd(const std::vector<double>& re1, const std::vector<double>& im1, int row1, const std::vector<double>& re2, const std::vector<double>& im2, int row2, std::vector<double>& accRe, std::vector<double>& accIm, int acc) const
+  {
+    const double* a = &re1[row1 * mNHalf];
+    const double* b = &im1[row1 * mNHalf];
+    const double* c = &re2[row2 * mNHalf];
+    const double* d = &im2[row2 * mNHalf];
+    double* r = &accRe[acc * mNHalf];
+    double* s = &accIm[acc * mNHalf];
+    for (int m = 0; m < mNHalf; m++) {
+      r[m] += a[m] * c[m] + b[m] * d[m];
+      s[m] += b[m] * c[m] - a[m] * d[m];
+    }
+  }
+
+  /// Inverse transform of a real sequence from its frequencies 0 to nPhi / 2
+  void inverse(const std::vector<double>& re, const std::vector<double>& im, int acc, std::vector<double>& out) const
+  {
+    const double* r = &re[acc * mNHalf];
+    const double* s = &im[acc * mNHalf];
+    out.resize(mNPhi);
+    for (int k = 0; k < mNPhi; k++) {
+      double sum = r[0];
+      for (int m = 1, km = k; m < mNHalf; m++, km = (km + k) % mNPhi) {
+        // the frequency nPhi / 2 of an even nPhi has no conjugate partner
+        const double factor = (2 * m == mNPhi) ? 1. : 2.;
+        sum += factor * (r[m] * mCos[km] - s[m] * mSin[km]);
+      }
+      out[k] = sum / mNPhi;
+    }
+  }
+
+  std::vector<double> mPtTriggerEdges;
+  std::vector<double> mPtAssocEdges;
+  int mNPtTrigger = 0;
+  int mNPtAssoc = 0;
+  float mEtaMin = 0;
+  float mEtaCell = 0;
+  int mNEta = 0;
+  int mNPhi = 0;
+  int mNHalf = 0;    // number of frequencies kept by the transforms
+  double mPhiCell = 0;
+  std::vector<bool> mPairSelected; // per trigger and associated pT bin
+
+  std::vector<double> mTrigger;  // sum of weights per cell [pt][eta][phi]
+  std::vector<double> mTrigger2; // sum of squared weights per cell
+  std::vector<bool> mTriggerRows; // rows [pt][eta] with particles
+  std::vector<double> mAssoc;
+  std::vector<double> mAssoc2;
+  std::vector<bool> mAssocRows;
+  std::vector<double> mSelf;  // self pairs to remove per trigger and associated pT bin
+  std::vector<double> mSelf2;
+  bool mWeighted = false; // weights other than 1 were used
+
+  std::vector<double> mCos; // cos(2 pi k / nPhi)
+  std::vector<double> mSin;
+
+  // work space of correlate()
+  std::vector<double> mTriggerRe, mTriggerIm, mTrigger2Re, mTrigger2Im;
+  std::vector<double> mAssocRe, mAssocIm, mAssoc2Re, mAssoc2Im;
+  std::vector<double> mAccRe, mAccIm, mAcc2Re, mAcc2Im;
+  std::vector<bool> mAccUsed;
+  std::vector<double> mPairs, mPairs2;
+};
+
+#endif
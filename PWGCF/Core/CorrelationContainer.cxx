@@ -27,9 +27,14 @@
 #include "TCanvas.h"
 #include "TF1.h"
 #include "THn.h"
+#include "TArray.h"
+#include "TDirectory.h"
+#include "TROOT.h"
 #include "Framework/HistogramSpec.h"
 #include "CommonConstants/MathConstants.h"
 
+#include <thread>
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::constants::math;
@@ -57,7 +62,12 @@ CorrelationContainer::CorrelationContainer() : TNamed(),
                                                mSkipScaleMixedEvent(kFALSE),
                                                mCache(nullptr),
                                                mGetMultCacheOn(kFALSE),
-                                               mGetMultCache(nullptr)
+                                               mGetMultCache(nullptr),
+                                               mGetMultCacheStep(-1),
+                                               mProjectionCache(),
+                                               mProjectionCacheSize(0),
+                                               mPairFillAxes(),
+                                               mPairFillOffset(-1)
 {
   // Default constructor
 }
@@ -84,7 +94,12 @@ CorrelationContainer::CorrelationContainer(const char* name, const char* objTitl
                                                                                                    mSkipScaleMixedEvent(kFALSE),
                                                                                                    mCache(nullptr),
                                                                                                    mGetMultCacheOn(kFALSE),
-                                                                                                   mGetMultCache(nullptr)
+                                                                                                   mGetMultCache(nullptr),
+                                                                                                   mGetMultCacheStep(-1),
+                                                                                                   mProjectionCache(),
+                                                                                                   mProjectionCacheSize(0),
+                                                                                                   mPairFillAxes(),
+                                                                                                   mPairFillOffset(-1)
 {
   // correlationAxis has to provide a 6 length list of AxisSpec which contain:
   //   delta_eta, pt_assoc, pt_trig, multiplicity/centrality, delta_phi, vertex
@@ -111,6 +126,23 @@ CorrelationContainer::CorrelationContainer(const char* name, const char* objTitl
 
   mPairHist = HistFactory::createHist<StepTHnF>({"mPairHist", "d^{2}N_{ch}/d#varphid#eta", {HistType::kStepTHnF, pairAxis, fgkCFSteps}}).release();
 
+  // same binning as the axes of mPairHist, for the fast filling
+  if (userAxis.size() == 0) {
+    Long64_t stride = 1;
+    mPairFillAxes.resize(pairAxis.size());
+    for (int i = pairAxis.size() - 1; i >= 0; i--) {
+      FillAxis& axis = mPairFillAxes[i];
+      axis.mNbins = pairAxis[i].getNbins();
+      axis.mMin = pairAxis[i].binEdges.front();
+      axis.mMax = pairAxis[i].binEdges.back();
+      if (!pairAxis[i].nBins.has_value()) {
+        axis.mEdges = pairAxis[i].binEdges;
+      }
+      axis.mStride = stride;
+      stride *= axis.mNbins;
+    }
+  }
+
   std::vector<o2::framework::AxisSpec> triggerAxis({correlationAxis[2], correlationAxis[3], correlationAxis[5]});
   triggerAxis.insert(triggerAxis.end(), userAxis.begin(), userAxis.end());
   mTriggerHist = HistFactory::createHist<StepTHnF>({"mTriggerHist", "d^{2}N_{ch}/d#varphid#eta", {HistType::kStepTHnF, triggerAxis, fgkCFSteps}}).release();
@@ -139,7 +171,12 @@ CorrelationContainer::CorrelationContainer(const CorrelationContainer& c) : TNam
                                                                             mSkipScaleMixedEvent(kFALSE),
                                                                             mCache(nullptr),
                                                                             mGetMultCacheOn(kFALSE),
-                                                                            mGetMultCache(nullptr)
+                                                                            mGetMultCache(nullptr),
+                                                                            mGetMultCacheStep(-1),
+                                                                            mProjectionCache(),
+                                                                            mProjectionCacheSize(0),
+                                                                            mPairFillAxes(),
+                                                                            mPairFillOffset(-1)
 {
   //
   // CorrelationContainer copy constructor
@@ -177,6 +214,8 @@ CorrelationContainer::~CorrelationContainer()
     delete mCache;
     mCache = nullptr;
   }
+
+  clearProjectionCache();
 }
 
 //____________________________________________________________________
@@ -222,6 +261,8 @@ void CorrelationContainer::Copy(TObject& c) const
   target.mTrackEtaCut = mTrackEtaCut;
   target.mWeightPerEvent = mWeightPerEvent;
   target.mSkipScaleMixedEvent = mSkipScaleMixedEvent;
+  target.mPairFillAxes = mPairFillAxes;
+  target.mPairFillOffset = -1;
 }
 
 //____________________________________________________________________
@@ -268,6 +309,7 @@ Long64_t CorrelationContainer::Merge(TCollection* list)
 
     count++;
   }
+  clearProjectionCache();
   if (mPairHist) {
     mPairHist->Merge(lists[0]);
   }
@@ -388,10 +430,30 @@ void CorrelationContainer::getHistsZVtxMult(CorrelationContainer::CFStep step, F
   // a 2d histogram on event level (as fct of zvtx, multiplicity)
   // Histograms has to be deleted by the caller of the function
 
+  std::vector<Double_t> key;
+  if (mProjectionCacheSize > 0) {
+    // the ranges of the user axes are not reset and enter the projections
+    key = {0, (Double_t)step, ptTriggerMin, ptTriggerMax, mEtaMin, mEtaMax, mPtMin, mPtMax};
+    for (THnBase* grid : {mPairHist->getTHn(step), mTriggerHist->getTHn(step)}) {
+      for (Int_t i = (grid == mPairHist->getTHn(step)) ? 6 : 3; i < grid->GetNdimensions(); i++) {
+        Bool_t hasRange = grid->GetAxis(i)->TestBit(TAxis::kAxisRange);
+        key.push_back(hasRange ? grid->GetAxis(i)->GetFirst() : -1);
+        key.push_back(hasRange ? grid->GetAxis(i)->GetLast() : -1);
+      }
+    }
+    if (const ProjectionCacheEntry* entry = findProjection(key)) {
+      *trackHist = (THnBase*)entry->mTrackHist->Clone();
+      *eventHist = (TH2*)entry->mEventHist->Clone();
+      return;
+    }
+  }
+
   THnBase* sparse = mPairHist->getTHn(step);
   if (mGetMultCacheOn) {
-    if (!mGetMultCache) {
+    if (!mGetMultCache || mGetMultCacheStep != step) {
+      delete mGetMultCache;
       mGetMultCache = changeToThn(sparse);
+      mGetMultCacheStep = step;
       // should work but causes SEGV in ProjectionND below
     }
     sparse = mGetMultCache;
@@ -418,6 +480,10 @@ void CorrelationContainer::getHistsZVtxMult(CorrelationContainer::CFStep step, F
 
   resetBinLimits(sparse, 6);
   resetBinLimits(mTriggerHist->getTHn(step), 3);
+
+  if (mProjectionCacheSize > 0) {
+    addProjection(key, (THnBase*)(*trackHist)->Clone(), (TH2*)(*eventHist)->Clone());
+  }
 }
 
 TH2* CorrelationContainer::getPerTriggerYield(CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax, Bool_t normalizePerTrigger)
@@ -437,15 +503,29 @@ TH2* CorrelationContainer::getPerTriggerYield(CorrelationContainer::CFStep step,
 
   getHistsZVtxMult(step, ptTriggerMin, ptTriggerMax, &trackSameAll, &eventSameAll);
 
+  TH2* yield = projectPerTriggerYield(trackSameAll, eventSameAll, mCentralityMin, mCentralityMax, normalizePerTrigger);
+
+  delete trackSameAll;
+  delete eventSameAll;
+
+  return yield;
+}
+
+TH2* CorrelationContainer::projectPerTriggerYield(THnBase* trackSameAll, TH2* eventSameAll, Float_t centralityMin, Float_t centralityMax, Bool_t normalizePerTrigger)
+{
+  // per trigger yield in the given centrality range from the histograms of getHistsZVtxMult, whose axis ranges are changed
+
   TAxis* multAxis = trackSameAll->GetAxis(3);
   int multBinBegin = 1;
   int multBinEnd = multAxis->GetNbins();
-  if (mCentralityMin < mCentralityMax) {
-    multBinBegin = multAxis->FindBin(mCentralityMin + 1e-4);
-    multBinEnd = multAxis->FindBin(mCentralityMax - 1e-4);
+  if (centralityMin < centralityMax) {
+    multBinBegin = multAxis->FindBin(centralityMin + 1e-4);
+    multBinEnd = multAxis->FindBin(centralityMax - 1e-4);
     LOGF(info, "Using multiplicity range %d --> %d", multBinBegin, multBinEnd);
 
     trackSameAll->GetAxis(3)->SetRange(multBinBegin, multBinEnd);
+  } else {
+    trackSameAll->GetAxis(3)->SetRange(0, 0);
   }
 
   TAxis* vertexAxis = trackSameAll->GetAxis(2);
@@ -473,12 +553,158 @@ TH2* CorrelationContainer::getPerTriggerYield(CorrelationContainer::CFStep step,
   Float_t normalization = yield->GetXaxis()->GetBinWidth(1);
   yield->Scale(1.0 / normalization);
 
-  delete trackSameAll;
-  delete eventSameAll;
-
   return yield;
 }
 
+std::vector<TH2*> CorrelationContainer::getPerTriggerYields(CorrelationContainer::CFStep step, const std::vector<YieldSlice>& slices, Bool_t normalizePerTrigger, Int_t nThreads)
+{
+  // per trigger yields of the slices, see getPerTriggerYield
+  // the bulk projections change the axis ranges of the histograms of the class and are done serially, one per
+  // (trigger pT, associated pT) range; the slices are then projected in parallel, each thread from its own copies
+
+  std::vector<Int_t> group(slices.size());
+  std::vector<const YieldSlice*> groupRanges;
+  std::vector<THnBase*> trackHists;
+  std::vector<TH2*> eventHists;
+  const Float_t ptMin = mPtMin;
+  const Float_t ptMax = mPtMax;
+  for (size_t i = 0; i < slices.size(); i++) {
+    const YieldSlice& slice = slices[i];
+    size_t g = 0;
+    for (; g < groupRanges.size(); g++) {
+      if (groupRanges[g]->mPtTriggerMin == slice.mPtTriggerMin && groupRanges[g]->mPtTriggerMax == slice.mPtTriggerMax &&
+          groupRanges[g]->mPtAssocMin == slice.mPtAssocMin && groupRanges[g]->mPtAssocMax == slice.mPtAssocMax) {
+        break;
+      }
+    }
+    if (g == groupRanges.size()) {
+      THnBase* trackHist = nullptr;
+      TH2* eventHist = nullptr;
+      setPtRange(slice.mPtAssocMin, slice.mPtAssocMax);
+      getHistsZVtxMult(step, slice.mPtTriggerMin, slice.mPtTriggerMax, &trackHist, &eventHist);
+      groupRanges.push_back(&slice);
+      trackHists.push_back(trackHist);
+      eventHists.push_back(eventHist);
+    }
+    group[i] = g;
+  }
+  setPtRange(ptMin, ptMax);
+
+  nThreads = std::max(1, std::min(nThreads, (Int_t)slices.size()));
+  if (nThreads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+  Bool_t oldStatus = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+
+  // copies of the track histograms used by each thread, made before starting the threads
+  std::vector<std::vector<THnBase*>> copies(nThreads, std::vector<THnBase*>(trackHists.size(), nullptr));
+  for (size_t i = 0; i < slices.size(); i++) {
+    Int_t iThread = i % nThreads;
+    THnBase*& copy = copies[iThread][group[i]];
+    if (!copy) {
+      copy = (iThread == 0) ? trackHists[group[i]] : (THnBase*)trackHists[group[i]]->Clone();
+    }
+  }
+
+  std::vector<TH2*> yields(slices.size(), nullptr);
+  auto projectSlices = [&](Int_t iThread) {
+    for (size_t i = iThread; i < slices.size(); i += nThreads) {
+      yields[i] = projectPerTriggerYield(copies[iThread][group[i]], eventHists[group[i]], slices[i].mCentralityMin, slices[i].mCentralityMax, normalizePerTrigger);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (Int_t iThread = 1; iThread < nThreads; iThread++) {
+    threads.emplace_back(projectSlices, iThread);
+  }
+  projectSlices(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (Int_t iThread = 1; iThread < nThreads; iThread++) {
+    for (auto* copy : copies[iThread]) {
+      delete copy;
+    }
+  }
+  for (size_t g = 0; g < trackHists.size(); g++) {
+    delete trackHists[g];
+    delete eventHists[g];
+  }
+  TH1::AddDirectory(oldStatus);
+
+  return yields;
+}
+
+Int_t CorrelationContainer::writePerTriggerYields(TDirectory* dir, const char* prefix, CorrelationContainer::CFStep step, const std::vector<YieldSlice>& slices, Bool_t normalizePerTrigger, Int_t nThreads)
+{
+  // writes the per trigger yields of all the slices, computed in one pass with getPerTriggerYields
+
+  std::vector<TH2*> yields = getPerTriggerYields(step, slices, normalizePerTrigger, nThreads);
+  Int_t written = 0;
+  for (size_t i = 0; i < yields.size(); i++) {
+    const YieldSlice& slice = slices[i];
+    yields[i]->SetName(Form("%s_%d", prefix, (Int_t)i));
+    yields[i]->SetTitle(Form("%.2f < p_{T,trig} < %.2f, %.2f < p_{T,assoc} < %.2f, %.1f < centrality < %.1f", slice.mPtTriggerMin, slice.mPtTriggerMax, slice.mPtAssocMin, slice.mPtAssocMax, slice.mCentralityMin, slice.mCentralityMax));
+    if (dir->WriteTObject(yields[i]) > 0) {
+      written++;
+    }
+    delete yields[i];
+  }
+  return written;
+}
+
+void CorrelationContainer::setProjectionCacheSize(Int_t slots)
+{
+  mProjectionCacheSize = std::max(slots, 0);
+  while ((Int_t)mProjectionCache.size() > mProjectionCacheSize) {
+    delete mProjectionCache.front().mTrackHist;
+    delete mProjectionCache.front().mEventHist;
+    mProjectionCache.erase(mProjectionCache.begin());
+  }
+}
+
+void CorrelationContainer::clearProjectionCache()
+{
+  for (auto& entry : mProjectionCache) {
+    delete entry.mTrackHist;
+    delete entry.mEventHist;
+  }
+  mProjectionCache.clear();
+
+  delete mGetMultCache;
+  mGetMultCache = nullptr;
+  mGetMultCacheStep = -1;
+}
+
+const CorrelationContainer::ProjectionCacheEntry* CorrelationContainer::findProjection(const std::vector<Double_t>& key)
+{
+  // returns the entry of the key, moved to the end of the cache as the most recently used, or nullptr
+
+  for (size_t i = 0; i < mProjectionCache.size(); i++) {
+    if (mProjectionCache[i].mKey == key) {
+      std::rotate(mProjectionCache.begin() + i, mProjectionCache.begin() + i + 1, mProjectionCache.end());
+      return &mProjectionCache.back();
+    }
+  }
+  return nullptr;
+}
+
+void CorrelationContainer::addProjection(const std::vector<Double_t>& key, THnBase* trackHist, TH2* eventHist)
+{
+  // adds an entry to the cache, which takes ownership of the histograms, replacing the least recently used one if full
+
+  if (eventHist) {
+    eventHist->SetDirectory(nullptr);
+  }
+  if ((Int_t)mProjectionCache.size() >= mProjectionCacheSize) {
+    delete mProjectionCache.front().mTrackHist;
+    delete mProjectionCache.front().mEventHist;
+    mProjectionCache.erase(mProjectionCache.begin());
+  }
+  mProjectionCache.push_back({key, trackHist, eventHist});
+}
+
 TH2* CorrelationContainer::getSumOfRatios(CorrelationContainer* mixed, CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax, Bool_t normalizePerTrigger, Int_t stepForMixed, Int_t* trigger)
 {
   // Extract 2D per trigger yield with mixed event correction. The quantity is calculated for *each* vertex bin and multiplicity bin and then a sum of ratios is performed:
@@ -801,6 +1027,14 @@ THnBase* CorrelationContainer::getTrackEfficiencyND(CFStep step1, CFStep step2)
   // creates a track-level efficiency by dividing step2 by step1
   // in all dimensions but the particle species one
 
+  std::vector<Double_t> key;
+  if (mProjectionCacheSize > 0) {
+    key = {1, (Double_t)step1, (Double_t)step2, mEtaMin, mEtaMax};
+    if (const ProjectionCacheEntry* entry = findProjection(key)) {
+      return (THnBase*)entry->mTrackHist->Clone();
+    }
+  }
+
   StepTHn* sourceContainer = mTrackHistEfficiency;
   // step offset because we start with kCFStepAnaTopology
   step1 = (CFStep)((Int_t)step1 - (Int_t)kCFStepAnaTopology);
@@ -831,6 +1065,10 @@ THnBase* CorrelationContainer::getTrackEfficiencyND(CFStep step1, CFStep step2)
   delete generated;
   delete measured;
 
+  if (mProjectionCacheSize > 0) {
+    addProjection(key, (THnBase*)clone->Clone(), nullptr);
+  }
+
   return clone;
 }
 
@@ -1377,6 +1615,7 @@ void CorrelationContainer::deepCopy(CorrelationContainer* from)
 {
   // copies the entries of this object's members from the object <from> to this object
   // fills using the fill function and thus allows that the objects have different binning
+  clearProjectionCache();
 
   for (Int_t step = 0; step < mPairHist->getNSteps(); step++) {
     LOGF(info, "Copying step %d", step);
@@ -1413,6 +1652,7 @@ void CorrelationContainer::deepCopy(CorrelationContainer* from)
 void CorrelationContainer::symmetrizepTBins()
 {
   // copy pt,a < pt,t bins to pt,a > pt,t (inverting deltaphi and delta eta as it should be) including symmetric bins
+  clearProjectionCache();
 
   for (Int_t step = 0; step < mPairHist->getNSteps(); step++) {
     LOGF(info, "Copying step %d", step);
@@ -1484,6 +1724,7 @@ void CorrelationContainer::symmetrizepTBins()
 void CorrelationContainer::extendTrackingEfficiency(Bool_t verbose)
 {
   // fits the tracking efficiency at high pT with a constant and fills all bins with this tracking efficiency
+  clearProjectionCache();
 
   Float_t fitRangeBegin = 5.01;
   Float_t fitRangeEnd = 14.99;
@@ -1630,6 +1871,7 @@ void CorrelationContainer::Scale(Double_t factor)
 void CorrelationContainer::Reset()
 {
   // resets all contained histograms
+  clearProjectionCache();
 
   for (Int_t step = 0; step < mPairHist->getNSteps(); step++) {
     mPairHist->getTHn(step)->Reset();
@@ -1656,3 +1898,117 @@ void CorrelationContainer::fillEvent(Float_t centrality, CFStep step)
   // Fill per-event information
   mEventCount->Fill(step, centrality);
 }
+
+void CorrelationContainer::setPairFillTrigger(Float_t ptTrigger, Float_t multiplicity, Float_t posZ)
+{
+  // Finds the bins of the trigger axes (pt_trig, multiplicity/centrality, vertex) for the following fillPair(s) calls
+
+  if (mPairFillAxes.size() != 6) {
+    LOGF(fatal, "Fast filling of the pair histogram not available for this container (user axes or not created with its axes)");
+  }
+
+  const Int_t binPt = mPairFillAxes[2].findBin(ptTrigger);
+  const Int_t binMult = mPairFillAxes[3].findBin(multiplicity);
+  const Int_t binVertex = mPairFillAxes[5].findBin(posZ);
+  if (binPt < 0 || binMult < 0 || binVertex < 0) {
+    mPairFillOffset = -1;
+    return;
+  }
+  mPairFillOffset = binPt * mPairFillAxes[2].mStride + binMult * mPairFillAxes[3].mStride + binVertex * mPairFillAxes[5].mStride;
+}
+
+void CorrelationContainer::createPairFillArrays(CFStep step, Bool_t sumw2)
+{
+  // Lets the pair histogram create its containers for a step by a fill into its first bin, which is then undone.
+  // A fill with weight != 1 creates sumw2 as well, initialized with the entries (filled so far with weight 1)
+
+  Double_t positionAndWeight[7];
+  for (int i = 0; i < 6; i++) {
+    const FillAxis& axis = mPairFillAxes[i];
+    positionAndWeight[i] = axis.mEdges.empty() ? axis.mMin + 0.5 * (axis.mMax - axis.mMin) / axis.mNbins : 0.5 * (axis.mEdges[0] + axis.mEdges[1]);
+  }
+  positionAndWeight[6] = (sumw2 ? 0. : 1.);
+  mPairHist->Fill(step, 7, positionAndWeight);
+  if (!sumw2) {
+    mPairHist->getValues(step)->SetAt(mPairHist->getValues(step)->GetAt(0) - 1., 0);
+  }
+}
+
+void CorrelationContainer::fillPair(CFStep step, Float_t deltaEta, Float_t ptAssoc, Float_t deltaPhi, Float_t weight)
+{
+  // Fills one pair of the trigger set by setPairFillTrigger
+
+  fillPairs(step, 1, &deltaEta, &ptAssoc, &deltaPhi, &weight);
+}
+
+void CorrelationContainer::fillPairs(CFStep step, Int_t n, const Float_t* deltaEta, const Float_t* ptAssoc, const Float_t* deltaPhi, const Float_t* weight)
+{
+  // Fills n pairs of the trigger set by setPairFillTrigger, weight can be nullptr for weights 1
+
+  if (mPairFillOffset < 0 || n <= 0) {
+    return;
+  }
+
+  if (!mPairHist->getValues(step)) {
+    createPairFillArrays(step, kFALSE);
+  }
+  if (weight && !mPairHist->getSumw2(step)) {
+    for (Int_t i = 0; i < n; i++) {
+      if (weight[i] != 1.) {
+        createPairFillArrays(step, kTRUE);
+        break;
+      }
+    }
+  }
+  TArray* values = mPairHist->getValues(step);
+  TArray* sumw2 = mPairHist->getSumw2(step);
+
+  const FillAxis& axisEta = mPairFillAxes[0];
+  const FillAxis& axisPt = mPairFillAxes[1];
+  const FillAxis& axisPhi = mPairFillAxes[4];
+  for (Int_t i = 0; i < n; i++) {
+    const Int_t binEta = axisEta.findBin(deltaEta[i]);
+    const Int_t binPt = axisPt.findBin(ptAssoc[i]);
+    const Int_t binPhi = axisPhi.findBin(deltaPhi[i]);
+    if (binEta < 0 || binPt < 0 || binPhi < 0) {
+      continue;
+    }
+    const Long64_t bin = mPairFillOffset + binEta * axisEta.mStride + binPt * axisPt.mStride + binPhi * axisPhi.mStride;
+    const Double_t w = weight ? weight[i] : 1.;
+    values->SetAt(values->GetAt(bin) + w, bin);
+    if (sumw2) {
+      sumw2->SetAt(sumw2->GetAt(bin) + w * w, bin);
+    }
+  }
+}
+
+void CorrelationContainer::fillPairSum(CFStep step, Float_t deltaEta, Float_t ptAssoc, Float_t deltaPhi, Double_t sumw, Double_t sumw2)
+{
+  // Fills pairs of the trigger set by setPairFillTrigger, all in the same bin, by their sum of weights and sum of squared weights
+
+  if (mPairFillOffset < 0) {
+    return;
+  }
+  const Int_t binEta = mPairFillAxes[0].findBin(deltaEta);
+  const Int_t binPt = mPairFillAxes[1].findBin(ptAssoc);
+  const Int_t binPhi = mPairFillAxes[4].findBin(deltaPhi);
+  if (binEta < 0 || binPt < 0 || binPhi < 0) {
+    return;
+  }
+
+  if (!mPairHist->getValues(step)) {
+    createPairFillArrays(step, kFALSE);
+  }
+  // pairs with weights 1 only have sumw2 == sumw
+  if (sumw2 != sumw && !mPairHist->getSumw2(step)) {
+    createPairFillArrays(step, kTRUE);
+  }
+  TArray* values = mPairHist->getValues(step);
+  TArray* sumw2Array = mPairHist->getSumw2(step);
+
+  const Long64_t bin = mPairFillOffset + binEta * mPairFillAxes[0].mStride + binPt * mPairFillAxes[1].mStride + binPhi * mPairFillAxes[4].mStride;
+  values->SetAt(values->GetAt(bin) + sumw, bin);
+  if (sumw2Array) {
+    sumw2Array->SetAt(sumw2Array->GetAt(bin) + sumw2, bin);
+  }
+}
@@ -17,6 +17,8 @@
 #include "TNamed.h"
 #include "TString.h"
 #include "Framework/HistogramSpec.h"
+#include <algorithm>
+#include <vector>
 
 class TH1;
 class TH1F;
@@ -27,6 +29,7 @@ class TH1D;
 class TH2;
 class TH2D;
 class TCollection;
+class TDirectory;
 class THnSparse;
 class THnBase;
 class StepTHn;
@@ -71,6 +74,21 @@ class CorrelationContainer : public TNamed
   TH2* getSumOfRatios(CorrelationContainer* mixed, CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax, Bool_t normalizePerTrigger = kTRUE, Int_t stepForMixed = -1, Int_t* trigger = nullptr);
   TH1* getTriggersAsFunctionOfMultiplicity(CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax);
 
+  // Per-trigger yields of many slices in one pass: the bulk projection of getHistsZVtxMult is done once per
+  // (trigger pT, associated pT) range, and the centrality slices are projected from it in nThreads threads.
+  // The vertex range and the eta range of the class are used. The histograms have to be deleted by the caller
+  struct YieldSlice {
+    Float_t mPtTriggerMin;
+    Float_t mPtTriggerMax;
+    Float_t mPtAssocMin;
+    Float_t mPtAssocMax;
+    Float_t mCentralityMin;
+    Float_t mCentralityMax;
+  };
+  std::vector<TH2*> getPerTriggerYields(CorrelationContainer::CFStep step, const std::vector<YieldSlice>& slices, Bool_t normalizePerTrigger = kTRUE, Int_t nThreads = 1);
+  // writes the per-trigger yields of the slices to dir as <prefix>_<slice index>, returns the number of histograms written
+  Int_t writePerTriggerYields(TDirectory* dir, const char* prefix, CorrelationContainer::CFStep step, const std::vector<YieldSlice>& slices, Bool_t normalizePerTrigger = kTRUE, Int_t nThreads = 1);
+
   TH1* getTrackEfficiency(CFStep step1, CFStep step2, Int_t axis1, Int_t axis2 = -1, Int_t source = 1, Int_t axis3 = -1);
   THnBase* getTrackEfficiencyND(CFStep step1, CFStep step2);
   TH1* getEventEfficiency(CFStep step1, CFStep step2, Int_t axis1, Int_t axis2 = -1, Float_t ptTriggerMin = -1, Float_t ptTriggerMax = -1);
@@ -96,6 +114,15 @@ class CorrelationContainer : public TNamed
 
   void fillEvent(Float_t centrality, CFStep step);
 
+  // Fast filling of the pair histogram (not available with user axes): the bins of the trigger axes are found once per
+  // trigger particle with setPairFillTrigger and reused for all its pairs, the bins of the other axes are found by
+  // arithmetic for uniform axes and binary search otherwise. Same result as getPairHist()->Fill(...)
+  void setPairFillTrigger(Float_t ptTrigger, Float_t multiplicity, Float_t posZ);
+  void fillPair(CFStep step, Float_t deltaEta, Float_t ptAssoc, Float_t deltaPhi, Float_t weight = 1.);
+  void fillPairs(CFStep step, Int_t n, const Float_t* deltaEta, const Float_t* ptAssoc, const Float_t* deltaPhi, const Float_t* weight);
+  // adds several pairs in the same bin, given by the sum of their weights and of their squared weights
+  void fillPairSum(CFStep step, Float_t deltaEta, Float_t ptAssoc, Float_t deltaPhi, Double_t sumw, Double_t sumw2);
+
   void extendTrackingEfficiency(Bool_t verbose = kFALSE);
 
   void setEtaRange(Float_t etaMin, Float_t etaMax)
@@ -133,6 +160,12 @@ class CorrelationContainer : public TNamed
 
   void setGetMultCache(Bool_t flag = kTRUE) { mGetMultCacheOn = flag; }
 
+  // The results of getHistsZVtxMult and getTrackEfficiencyND are kept in a cache of the given number of slots (0: no cache),
+  // keyed by the step and the axis ranges, and returned as copies. The least recently used slot is replaced when the cache
+  // is full. The cache is cleared when the histograms are changed by the functions of the class, otherwise with clearProjectionCache
+  void setProjectionCacheSize(Int_t slots);
+  void clearProjectionCache();
+
   CorrelationContainer(const CorrelationContainer& c);
   CorrelationContainer& operator=(const CorrelationContainer& corr);
   virtual void Copy(TObject& c) const; // NOLINT: Making this override breaks compilation for unknown reason
@@ -144,7 +177,17 @@ class CorrelationContainer : public TNamed
 
  protected:
   void weightHistogram(TH3* hist1, TH1* hist2);
+  void createPairFillArrays(CFStep step, Bool_t sumw2);
   void multiplyHistograms(THnBase* grid, THnBase* target, TH1* histogram, Int_t var1, Int_t var2);
+  TH2* projectPerTriggerYield(THnBase* trackHist, TH2* eventHist, Float_t centralityMin, Float_t centralityMax, Bool_t normalizePerTrigger);
+
+  struct ProjectionCacheEntry {
+    std::vector<Double_t> mKey;
+    THnBase* mTrackHist;
+    TH2* mEventHist; // nullptr for the efficiencies
+  };
+  const ProjectionCacheEntry* findProjection(const std::vector<Double_t>& key);
+  void addProjection(const std::vector<Double_t>& key, THnBase* trackHist, TH2* eventHist);
 
   StepTHn* mPairHist;            // container for pair level distributions at all analysis steps
   StepTHn* mTriggerHist;         // container for "trigger" particle (single-particle) level distribution at all analysis steps
@@ -170,6 +213,29 @@ class CorrelationContainer : public TNamed
 
   Bool_t mGetMultCacheOn; //! cache for getHistsZVtxMult function active
   THnBase* mGetMultCache; //! cache for getHistsZVtxMult function
+  Int_t mGetMultCacheStep; //! step of mGetMultCache
+
+  std::vector<ProjectionCacheEntry> mProjectionCache; //! cache of the projections, most recently used last
+  Int_t mProjectionCacheSize;                         //! maximal number of entries of mProjectionCache
+
+  struct FillAxis {
+    Int_t mNbins;
+    Double_t mMin;
+    Double_t mMax;
+    std::vector<Double_t> mEdges; // empty for uniform axes
+    Long64_t mStride;             // step of the StepTHn bin index per bin of this axis
+    Int_t findBin(Double_t x) const
+    {
+      // same bin as TAxis::FindBin, counted from 0, -1 for under/overflow
+      if (x < mMin || !(x < mMax)) {
+        return -1;
+      }
+      Int_t bin = mEdges.empty() ? Int_t(mNbins * (x - mMin) / (mMax - mMin)) : Int_t(std::upper_bound(mEdges.begin(), mEdges.end(), x) - mEdges.begin()) - 1;
+      return bin < mNbins ? bin : -1;
+    }
+  };
+  std::vector<FillAxis> mPairFillAxes; //! axes of the pair histogram for the fast filling
+  Long64_t mPairFillOffset;            //! bin index of the trigger axes set by setPairFillTrigger, -1 if outside
 
   ClassDef(CorrelationContainer, 2) // underlying event histogram container
 };
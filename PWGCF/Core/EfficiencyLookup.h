@@ -0,0 +1,119 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_ANALYSIS_EFFICIENCYLOOKUP_H
+#define O2_ANALYSIS_EFFICIENCYLOOKUP_H
+
+#include <algorithm>
+#include <vector>
+
+#include <THn.h>
+#include <TAxis.h>
+
+#include "Framework/Logger.h"
+
+// Flattened copy of an efficiency THn with the axes (eta, pT, centrality, z vertex)
+//
+// The contents, including the underflow and overflow bins, are copied once when the THn is loaded, with the bins of
+// the last two axes outermost. The centrality and vertex bins are found once per event with setEvent(), so that the
+// efficiency of a track only needs the eta and pT bins, found with the same arithmetic as TAxis::FindBin on uniform
+// axes and with a binary search on variable ones. The values are the same as the ones of GetBinContent.
+
+class EfficiencyLookup
+{
+ public:
+  /// Copies the contents of the efficiency histogram, if it is not the one already copied
+  void update(const THn* eff)
+  {
+    if (eff == mSource) {
+      return;
+    }
+    mSource = eff;
+    if (eff->GetNdimensions() != kNAxes) {
+      LOGF(fatal, "Efficiency histogram with %d axes instead of (eta, pT, centrality, z vertex)", eff->GetNdimensions());
+    }
+    int size = 1;
+    for (int i = 0; i < kNAxes; i++) {
+      mAxes[i].set(eff->GetAxis(i));
+      size *= mAxes[i].nCells;
+    }
+    mContent.resize(size);
+    int bins[kNAxes];
+    int cell = 0;
+    for (bins[3] = 0; bins[3] < mAxes[3].nCells; bins[3]++) {
+      for (bins[2] = 0; bins[2] < mAxes[2].nCells; bins[2]++) {
+        for (bins[1] = 0; bins[1] < mAxes[1].nCells; bins[1]++) {
+          for (bins[0] = 0; bins[0] < mAxes[0].nCells; bins[0]++) {
+            mContent[cell++] = eff->GetBinContent(bins);
+          }
+        }
+      }
+    }
+    mEvent = mContent.data();
+  }
+
+  /// Selects the centrality and vertex bins of the event
+  void setEvent(float centrality, float posZ)
+  {
+    mEvent = mContent.data() + (mAxes[3].findBin(posZ) * mAxes[2].nCells + mAxes[2].findBin(centrality)) * mAxes[1].nCells * mAxes[0].nCells;
+  }
+
+  /// \return efficiency of a particle of the event
+  float get(float eta, float pt) const
+  {
+    return mEvent[mAxes[1].findBin(pt) * mAxes[0].nCells + mAxes[0].findBin(eta)];
+  }
+
+ private:
+  static constexpr int kNAxes = 4;
+
+  struct Axis {
+    int nBins = 0;
+    int nCells = 0; ///< bins including the underflow and overflow
+    double min = 0;
+    double max = 0;
+    std::vector<double> edges; ///< empty for a uniform axis
+
+    void set(const TAxis* axis)
+    {
+      nBins = axis->GetNbins();
+      nCells = nBins + 2;
+      min = axis->GetXmin();
+      max = axis->GetXmax();
+      edges.clear();
+      if (axis->GetXbins()->GetSize() > 0) {
+        edges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + axis->GetXbins()->GetSize());
+      }
+    }
+
+    /// same bin as TAxis::FindBin, for an axis which cannot be extended
+    int findBin(double x) const
+    {
+      if (x < min) {
+        return 0;
+      }
+      if (!(x < max)) {
+        return nBins + 1;
+      }
+      if (edges.empty()) {
+        return 1 + int(nBins * (x - min) / (max - min));
+      }
+      return std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+    }
+  };
+
+  const THn* mSource = nullptr;
+  Axis mAxes[kNAxes];
+  std::vector<float> mContent;
+  const float* mEvent = nullptr; ///< contents of the centrality and vertex bins of the current event
+};
+
+#endif
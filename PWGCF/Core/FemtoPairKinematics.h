@@ -0,0 +1,272 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file FemtoPairKinematics.h
+/// \brief Batched computation of the femtoscopic pair kinematics
+///
+/// The pairs are stored in SoA layout with the four-momenta of their particles, and k*, kT, mT and the
+/// invariant mass are computed in one branchless loop over the batch, which the compiler can vectorize.
+/// k* is obtained from the invariant expression k*^2 = ((q.P)^2 / P^2 - q^2) / 4, with q = p1 - p2 and
+/// P = p1 + p2, which is the same as boosting both particles to the pair rest frame.
+/// The four-momenta are computed once per particle and reused by all its pairs.
+/// The single pair kernels in femtokinematics are shared by the batch and by FemtoDreamMath/FemtoWorldMath.
+
+#ifndef O2_ANALYSIS_FEMTOPAIRKINEMATICS_H
+#define O2_ANALYSIS_FEMTOPAIRKINEMATICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace o2::analysis
+{
+
+namespace femtokinematics
+{
+
+/// \return energy of a particle
+inline float getEnergy(float px, float py, float pz, float mass)
+{
+  return std::sqrt(px * px + py * py + pz * pz + mass * mass);
+}
+
+/// Momentum components of a particle
+/// \param pt transverse momentum
+/// \param eta pseudorapidity
+/// \param phi azimuthal angle
+inline void getMomentum(float pt, float eta, float phi, float& px, float& py, float& pz)
+{
+  px = pt * std::cos(phi);
+  py = pt * std::sin(phi);
+  pz = pt * std::sinh(eta);
+}
+
+/// -q^2 of a pair, with q = (p1 - p2) - ((p1 - p2).P / P^2) P and P = p1 + p2, i.e. 4 k*^2
+inline float getQ2(float px1, float py1, float pz1, float e1, float px2, float py2, float pz2, float e2)
+{
+  const float sumPx = px1 + px2;
+  const float sumPy = py1 + py2;
+  const float sumPz = pz1 + pz2;
+  const float sumE = e1 + e2;
+  const float diffPx = px1 - px2;
+  const float diffPy = py1 - py2;
+  const float diffPz = pz1 - pz2;
+  const float diffE = e1 - e2;
+  const float sum2 = sumE * sumE - sumPx * sumPx - sumPy * sumPy - sumPz * sumPz;
+  const float diff2 = diffE * diffE - diffPx * diffPx - diffPy * diffPy - diffPz * diffPz;
+  const float diffSum = diffE * sumE - diffPx * sumPx - diffPy * sumPy - diffPz * sumPz;
+  return std::max(diffSum * diffSum / sum2 - diff2, 0.f);
+}
+
+/// k* of a pair, the momentum of the particles in the pair rest frame
+inline float getKstar(float px1, float py1, float pz1, float e1, float px2, float py2, float pz2, float e2)
+{
+  return 0.5f * std::sqrt(getQ2(px1, py1, pz1, e1, px2, py2, pz2, e2));
+}
+
+/// kT of a pair, half of the transverse momentum of the pair
+inline float getKT(float px1, float py1, float px2, float py2)
+{
+  const float sumPx = px1 + px2;
+  const float sumPy = py1 + py2;
+  return 0.5f * std::sqrt(sumPx * sumPx + sumPy * sumPy);
+}
+
+/// mT of a pair from its kT and the masses of the particles
+inline float getMT(float kT, float mass1, float mass2)
+{
+  const float halfMassSum = 0.5f * (mass1 + mass2);
+  return std::sqrt(kT * kT + halfMassSum * halfMassSum);
+}
+
+/// Computes k*, kT and mT of a list of pairs of particles stored as arrays
+/// \param px,py,pz,e four-momenta of the particles
+/// \param mass masses of the particles
+/// \param first,second positions of the two particles of each pair
+/// \param nPairs number of pairs
+/// \param kstar,kT,mT outputs, nPairs entries each
+inline void computePairs(const float* px, const float* py, const float* pz, const float* e, const float* mass,
+                         const int* first, const int* second, int nPairs, float* kstar, float* kT, float* mT)
+{
+  for (int i = 0; i < nPairs; ++i) {
+    const int i1 = first[i];
+    const int i2 = second[i];
+    kstar[i] = getKstar(px[i1], py[i1], pz[i1], e[i1], px[i2], py[i2], pz[i2], e[i2]);
+    kT[i] = getKT(px[i1], py[i1], px[i2], py[i2]);
+    mT[i] = getMT(kT[i], mass[i1], mass[i2]);
+  }
+}
+
+} // namespace femtokinematics
+
+/// Four-momenta of the particles of a table, indexed by their global index
+/// The entries are validated against the inputs of the calculation so they stay
+/// valid when the particle table changes
+class FemtoFourMomentumCache
+{
+ public:
+  struct FourMomentum {
+    float pt = -1.f; ///< negative: not calculated yet
+    float eta = 0.f;
+    float phi = 0.f;
+    float mass = 0.f;
+    float px = 0.f;
+    float py = 0.f;
+    float pz = 0.f;
+    float e = 0.f;
+  };
+
+  /// Four-momentum of a particle
+  /// \param part particle, with global index, pt, eta and phi
+  /// \param mass mass hypothesis of the particle
+  template <typename T>
+  const FourMomentum& get(const T& part, float mass)
+  {
+    const size_t index = part.globalIndex();
+    if (index >= mCache.size()) {
+      mCache.resize(index + 1);
+    }
+    FourMomentum& p = mCache[index];
+    const float pt = part.pt();
+    const float eta = part.eta();
+    const float phi = part.phi();
+    if (p.pt != pt || p.eta != eta || p.phi != phi || p.mass != mass) {
+      p.pt = pt;
+      p.eta = eta;
+      p.phi = phi;
+      p.mass = mass;
+      femtokinematics::getMomentum(pt, eta, phi, p.px, p.py, p.pz);
+      p.e = femtokinematics::getEnergy(p.px, p.py, p.pz, mass);
+    }
+    return p;
+  }
+
+ private:
+  std::vector<FourMomentum> mCache;
+};
+
+/// Batch of pairs and their kinematics
+class FemtoPairBatch
+{
+ public:
+  static constexpr int kBatchSize = 1024; ///< number of pairs after which the batch is full
+
+  /// Sets the mass hypotheses of the two particles of the pairs
+  void setMasses(float mass1, float mass2)
+  {
+    mMassOne = mass1;
+    mMassTwo = mass2;
+  }
+
+  /// Adds a pair to the batch
+  /// \param part1 particle one
+  /// \param part2 particle two
+  /// \param mult multiplicity of the event
+  /// \return true if the batch is full and has to be processed
+  template <typename T1, typename T2>
+  bool add(const T1& part1, const T2& part2, float mult)
+  {
+    const auto& p1 = mFourMomentaOne.get(part1, mMassOne);
+    const auto& p2 = mFourMomentaTwo.get(part2, mMassTwo);
+    mPx1.push_back(p1.px);
+    mPy1.push_back(p1.py);
+    mPz1.push_back(p1.pz);
+    mE1.push_back(p1.e);
+    mPx2.push_back(p2.px);
+    mPy2.push_back(p2.py);
+    mPz2.push_back(p2.pz);
+    mE2.push_back(p2.e);
+    mPt1.push_back(p1.pt);
+    mEta1.push_back(p1.eta);
+    mPhi1.push_back(p1.phi);
+    mPt2.push_back(p2.pt);
+    mEta2.push_back(p2.eta);
+    mPhi2.push_back(p2.phi);
+    mMult.push_back(mult);
+    return size() >= kBatchSize;
+  }
+
+  /// Computes the kinematics of all the pairs of the batch
+  void compute()
+  {
+    const int n = size();
+    mKstar.resize(n);
+    mKT.resize(n);
+    mMT.resize(n);
+    mMInv.resize(n);
+    const float* px1 = mPx1.data();
+    const float* py1 = mPy1.data();
+    const float* pz1 = mPz1.data();
+    const float* e1 = mE1.data();
+    const float* px2 = mPx2.data();
+    const float* py2 = mPy2.data();
+    const float* pz2 = mPz2.data();
+    const float* e2 = mE2.data();
+    float* kstar = mKstar.data();
+    float* kT = mKT.data();
+    float* mT = mMT.data();
+    float* mInv = mMInv.data();
+    for (int i = 0; i < n; ++i) {
+      kstar[i] = femtokinematics::getKstar(px1[i], py1[i], pz1[i], e1[i], px2[i], py2[i], pz2[i], e2[i]);
+      kT[i] = femtokinematics::getKT(px1[i], py1[i], px2[i], py2[i]);
+      mT[i] = femtokinematics::getMT(kT[i], mMassOne, mMassTwo);
+      const float sumPx = px1[i] + px2[i];
+      const float sumPy = py1[i] + py2[i];
+      const float sumPz = pz1[i] + pz2[i];
+      const float sumE = e1[i] + e2[i];
+      const float sum2 = sumE * sumE - sumPx * sumPx - sumPy * sumPy - sumPz * sumPz;
+      // as TLorentzVector::M(), negative for a space-like sum
+      mInv[i] = std::copysign(std::sqrt(std::fabs(sum2)), sum2);
+    }
+  }
+
+  /// Removes all the pairs of the batch
+  void clear()
+  {
+    for (auto* v : {&mPx1, &mPy1, &mPz1, &mE1, &mPx2, &mPy2, &mPz2, &mE2, &mPt1, &mEta1, &mPhi1, &mPt2, &mEta2, &mPhi2, &mMult}) {
+      v->clear();
+    }
+  }
+
+  int size() const { return mMult.size(); }
+
+  /// Kinematics of the pairs, valid after compute()
+  const std::vector<float>& getKstar() const { return mKstar; }
+  const std::vector<float>& getKT() const { return mKT; }
+  const std::vector<float>& getMT() const { return mMT; }
+  const std::vector<float>& getMInv() const { return mMInv; }
+  /// Properties of the particles of the pairs
+  const std::vector<float>& getPtOne() const { return mPt1; }
+  const std::vector<float>& getEtaOne() const { return mEta1; }
+  const std::vector<float>& getPhiOne() const { return mPhi1; }
+  const std::vector<float>& getPtTwo() const { return mPt2; }
+  const std::vector<float>& getEtaTwo() const { return mEta2; }
+  const std::vector<float>& getPhiTwo() const { return mPhi2; }
+  const std::vector<float>& getMult() const { return mMult; }
+
+ private:
+  float mMassOne = 0.f; ///< mass hypothesis of particle one
+  float mMassTwo = 0.f; ///< mass hypothesis of particle two
+  FemtoFourMomentumCache mFourMomentaOne;
+  FemtoFourMomentumCache mFourMomentaTwo;
+  /* the pairs */
+  std::vector<float> mPx1, mPy1, mPz1, mE1;
+  std::vector<float> mPx2, mPy2, mPz2, mE2;
+  std::vector<float> mPt1, mEta1, mPhi1;
+  std::vector<float> mPt2, mEta2, mPhi2;
+  std::vector<float> mMult;
+  /* their kinematics */
+  std::vector<float> mKstar, mKT, mMT, mMInv;
+};
+
+} // namespace o2::analysis
+
+#endif // O2_ANALYSIS_FEMTOPAIRKINEMATICS_H
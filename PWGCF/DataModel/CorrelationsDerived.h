@@ -11,6 +11,9 @@
 #ifndef O2_ANALYSIS_CFDERIVED_H
 #define O2_ANALYSIS_CFDERIVED_H
 
+#include <cmath>
+#include <cstdint>
+
 #include "Framework/ASoA.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Common/DataModel/Centrality.h"
@@ -20,12 +23,16 @@ namespace o2::aod
 namespace cfcollision
 {
 DECLARE_SOA_COLUMN(Multiplicity, multiplicity, float); //! Centrality/multiplicity value
+DECLARE_SOA_COLUMN(MixingBin, mixingBin, int);         //! Bin of the (vertex, multiplicity) mixing binning, -1 outside of it
 }
 DECLARE_SOA_TABLE_VERSIONED(CFCollisions, "AOD", "CFCOLLISION", 0, //!
                             o2::soa::Index<>,
                             bc::RunNumber, collision::PosZ,
                             cfcollision::Multiplicity, timestamp::Timestamp);
 using CFCollision = CFCollisions::iterator;
+DECLARE_SOA_TABLE(CFMixingBins, "AOD", "CFMIXINGBIN", //! Mixing bins of the collisions, joinable with CFCollisions
+                  cfcollision::MixingBin);
+using CFMixingBin = CFMixingBins::iterator;
 
 namespace cftrack
 {
@@ -41,6 +48,55 @@ DECLARE_SOA_TABLE(CFTracks, "AOD", "CFTRACK", //!
                   cftrack::Pt, cftrack::Eta, cftrack::Phi,
                   cftrack::Sign, track::TrackType);
 using CFTrack = CFTracks::iterator;
+
+// Compact version of CFTracks: the kinematics are stored with 16 bits each and the track selections of the
+// analyses run on the derived data are stored as a bitmask, so that they do not need to be applied again
+namespace cfcompacttrack
+{
+constexpr float kPtStep = 0.001f; // pT in steps of 1 MeV/c, saturated at 65.535 GeV/c
+constexpr float kEtaMax = 2.0f;   // eta in (-kEtaMax, kEtaMax), saturated outside
+constexpr float kEtaStep = 2.0f * kEtaMax / 65535.0f;
+constexpr float kPhiStep = 2.0f * static_cast<float>(M_PI) / 65536.0f;
+
+inline uint16_t packPt(float pt)
+{
+  return static_cast<uint16_t>(std::fmin(std::fmax(std::nearbyint(pt / kPtStep), 0.0f), 65535.0f));
+}
+inline uint16_t packEta(float eta)
+{
+  return static_cast<uint16_t>(std::fmin(std::fmax(std::nearbyint((eta + kEtaMax) / kEtaStep), 0.0f), 65535.0f));
+}
+inline uint16_t packPhi(float phi)
+{
+  // phi in [0, 2pi), the last step wrapping to 0
+  return static_cast<uint16_t>(static_cast<uint32_t>(std::nearbyint(phi / kPhiStep)) & 0xFFFF);
+}
+inline float unpackPt(uint16_t pt) { return pt * kPtStep; }
+inline float unpackEta(uint16_t eta) { return eta * kEtaStep - kEtaMax; }
+inline float unpackPhi(uint16_t phi) { return phi * kPhiStep; }
+
+DECLARE_SOA_INDEX_COLUMN(CFCollision, cfCollision); //! Index to collision
+DECLARE_SOA_COLUMN(PackedPt, packedPt, uint16_t);   //! pT, see packPt
+DECLARE_SOA_COLUMN(PackedEta, packedEta, uint16_t); //! Pseudorapidity, see packEta
+DECLARE_SOA_COLUMN(PackedPhi, packedPhi, uint16_t); //! Phi angle, see packPhi
+DECLARE_SOA_COLUMN(Sign, sign, int8_t);             //! Sign (positive, negative)
+DECLARE_SOA_COLUMN(Selection, selection, uint8_t);  //! Bit i set if the track passes the track selection i of the filter task
+DECLARE_SOA_DYNAMIC_COLUMN(Pt, pt,                  //! pT (GeV/c)
+                           [](uint16_t packedPt) -> float { return unpackPt(packedPt); });
+DECLARE_SOA_DYNAMIC_COLUMN(Eta, eta, //! Pseudorapidity
+                           [](uint16_t packedEta) -> float { return unpackEta(packedEta); });
+DECLARE_SOA_DYNAMIC_COLUMN(Phi, phi, //! Phi angle
+                           [](uint16_t packedPhi) -> float { return unpackPhi(packedPhi); });
+} // namespace cfcompacttrack
+DECLARE_SOA_TABLE(CFCompactTracks, "AOD", "CFCTRACK", //!
+                  o2::soa::Index<>,
+                  cfcompacttrack::CFCollisionId,
+                  cfcompacttrack::PackedPt, cfcompacttrack::PackedEta, cfcompacttrack::PackedPhi,
+                  cfcompacttrack::Sign, track::TrackType, cfcompacttrack::Selection,
+                  cfcompacttrack::Pt<cfcompacttrack::PackedPt>,
+                  cfcompacttrack::Eta<cfcompacttrack::PackedEta>,
+                  cfcompacttrack::Phi<cfcompacttrack::PackedPhi>);
+using CFCompactTrack = CFCompactTracks::iterator;
 } // namespace o2::aod
 
 #endif // O2_ANALYSIS_CFDERIVED_H
@@ -68,6 +68,22 @@ DECLARE_SOA_TABLE(ScannedTrueTracks, "AOD", "SCANTRUETRACKS", //! The generated
                   dptdptfilter::Eta,
                   dptdptfilter::Phi,
                   dptdptfilter::Sign<dptdptfilter::TrackacceptedAsOne, dptdptfilter::TrackacceptedAsTwo>);
+namespace dptdptfilter
+{
+DECLARE_SOA_COLUMN(NRecTracks, nrectracks, uint16_t);                        //! Number of tracks with a positive collision Id reconstructed from the particle
+DECLARE_SOA_COLUMN(NRecAcceptedTracks, nrecacceptedtracks, uint16_t);        //! Number of those tracks accepted, in accepted collisions
+DECLARE_SOA_COLUMN(CrossCollision, crosscollision, uint8_t);                 //! If the reconstructed tracks are assigned to different collisions
+DECLARE_SOA_COLUMN(CrossCollisionAccepted, crosscollisionaccepted, uint8_t); //! If the accepted tracks are assigned to different collisions
+DECLARE_SOA_DYNAMIC_COLUMN(MultiReconstructed, multireconstructed,           //! If the particle has been reconstructed more than once
+                           [](uint16_t nrectracks) -> bool { return nrectracks > 1; });
+} // namespace dptdptfilter
+DECLARE_SOA_TABLE(McParticleRecoMults, "AOD", "MCPARTRECOMULT", //! Multiplicity of reconstruction of the MC particles, joinable with McParticles
+                  dptdptfilter::NRecTracks,
+                  dptdptfilter::NRecAcceptedTracks,
+                  dptdptfilter::CrossCollision,
+                  dptdptfilter::CrossCollisionAccepted,
+                  dptdptfilter::MultiReconstructed<dptdptfilter::NRecTracks>);
+using McParticleRecoMult = McParticleRecoMults::iterator;
 } // namespace aod
 } // namespace o2
 
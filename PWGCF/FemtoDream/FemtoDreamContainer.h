@@ -19,6 +19,7 @@
 
 #include "Framework/HistogramRegistry.h"
 #include "FemtoDreamMath.h"
+#include "PWGCF/Core/FemtoPairKinematics.h"
 
 #include "Math/Vector4D.h"
 #include "TMath.h"
@@ -61,8 +62,9 @@ class FemtoDreamContainer
   /// \param multBins multiplicity binning for the histograms
   /// \param kTBins kT binning for the histograms
   /// \param mTBins mT binning for the histograms
+  /// \param folderPrefix Prefix of the output folder, e.g. to separate the cut variations
   template <typename T>
-  void init(HistogramRegistry* registry, T& kstarBins, T& multBins, T& kTBins, T& mTBins)
+  void init(HistogramRegistry* registry, T& kstarBins, T& multBins, T& kTBins, T& mTBins, std::string_view folderPrefix = "")
   {
     mHistogramRegistry = registry;
     std::string femtoObs;
@@ -75,17 +77,17 @@ class FemtoDreamContainer
     framework::AxisSpec kTAxis = {kTBins, "#it{k}_{T} (GeV/#it{c})"};
     framework::AxisSpec mTAxis = {mTBins, "#it{m}_{T} (GeV/#it{c}^{2})"};
 
-    std::string folderName = static_cast<std::string>(mFolderSuffix[mEventType]);
-    mHistogramRegistry->add((folderName + "relPairDist").c_str(), ("; " + femtoObs + "; Entries").c_str(), kTH1F, {femtoObsAxis});
-    mHistogramRegistry->add((folderName + "relPairkT").c_str(), "; #it{k}_{T} (GeV/#it{c}); Entries", kTH1F, {kTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarkT").c_str(), ("; " + femtoObs + "; #it{k}_{T} (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, kTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarmT").c_str(), ("; " + femtoObs + "; #it{m}_{T} (GeV/#it{c}^{2})").c_str(), kTH2F, {femtoObsAxis, mTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarMult").c_str(), ("; " + femtoObs + "; Multiplicity").c_str(), kTH2F, {femtoObsAxis, multAxis});
-    mHistogramRegistry->add((folderName + "kstarPtPart1").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 1 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
-    mHistogramRegistry->add((folderName + "kstarPtPart2").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 2 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
-    mHistogramRegistry->add((folderName + "MultPtPart1").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
-    mHistogramRegistry->add((folderName + "MultPtPart2").c_str(), "; #it{p} _{T} Particle 2 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
-    mHistogramRegistry->add((folderName + "PtPart1PtPart2").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); #it{p} _{T} Particle 2 (GeV/#it{c})", kTH2F, {{375, 0., 7.5}, {375, 0., 7.5}});
+    std::string folderName = static_cast<std::string>(folderPrefix) + static_cast<std::string>(mFolderSuffix[mEventType]);
+    mHistRelPairDist = mHistogramRegistry->add<TH1>((folderName + "relPairDist").c_str(), ("; " + femtoObs + "; Entries").c_str(), kTH1F, {femtoObsAxis});
+    mHistRelPairkT = mHistogramRegistry->add<TH1>((folderName + "relPairkT").c_str(), "; #it{k}_{T} (GeV/#it{c}); Entries", kTH1F, {kTAxis});
+    mHistRelPairkstarkT = mHistogramRegistry->add<TH2>((folderName + "relPairkstarkT").c_str(), ("; " + femtoObs + "; #it{k}_{T} (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, kTAxis});
+    mHistRelPairkstarmT = mHistogramRegistry->add<TH2>((folderName + "relPairkstarmT").c_str(), ("; " + femtoObs + "; #it{m}_{T} (GeV/#it{c}^{2})").c_str(), kTH2F, {femtoObsAxis, mTAxis});
+    mHistRelPairkstarMult = mHistogramRegistry->add<TH2>((folderName + "relPairkstarMult").c_str(), ("; " + femtoObs + "; Multiplicity").c_str(), kTH2F, {femtoObsAxis, multAxis});
+    mHistKstarPtPart1 = mHistogramRegistry->add<TH2>((folderName + "kstarPtPart1").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 1 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
+    mHistKstarPtPart2 = mHistogramRegistry->add<TH2>((folderName + "kstarPtPart2").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 2 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
+    mHistMultPtPart1 = mHistogramRegistry->add<TH2>((folderName + "MultPtPart1").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
+    mHistMultPtPart2 = mHistogramRegistry->add<TH2>((folderName + "MultPtPart2").c_str(), "; #it{p} _{T} Particle 2 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
+    mHistPtPart1PtPart2 = mHistogramRegistry->add<TH2>((folderName + "PtPart1PtPart2").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); #it{p} _{T} Particle 2 (GeV/#it{c})", kTH2F, {{375, 0., 7.5}, {375, 0., 7.5}});
   }
 
   /// Set the PDG codes of the two particles involved
@@ -95,9 +97,12 @@ class FemtoDreamContainer
   {
     mMassOne = TDatabasePDG::Instance()->GetParticle(pdg1)->Mass();
     mMassTwo = TDatabasePDG::Instance()->GetParticle(pdg2)->Mass();
+    mPairs.setMasses(mMassOne, mMassTwo);
   }
 
   /// Pass a pair to the container and compute all the relevant observables
+  /// The pairs are collected in a batch, whose observables are computed and histogrammed
+  /// when it is full or when flush() is called, which has to be done at the end of each process function
   /// \tparam T type of the femtodreamparticle
   /// \param part1 Particle one
   /// \param part2 Particle two
@@ -105,25 +110,41 @@ class FemtoDreamContainer
   template <typename T>
   void setPair(T const& part1, T const& part2, const int mult)
   {
-    float femtoObs;
+    if (mHistogramRegistry && mPairs.add(part1, part2, mult)) {
+      flush();
+    }
+  }
+
+  /// Compute the observables of the collected pairs and fill the histograms
+  void flush()
+  {
+    if (mPairs.size() == 0) {
+      return;
+    }
+    mPairs.compute();
+    const std::vector<float>* femtoObs = nullptr;
     if constexpr (mFemtoObs == femtoDreamContainer::Observable::kstar) {
-      femtoObs = FemtoDreamMath::getkstar(part1, mMassOne, part2, mMassTwo);
+      femtoObs = &mPairs.getKstar();
     }
-    const float kT = FemtoDreamMath::getkT(part1, mMassOne, part2, mMassTwo);
-    const float mT = FemtoDreamMath::getmT(part1, mMassOne, part2, mMassTwo);
-
-    if (mHistogramRegistry) {
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairDist"), femtoObs);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkT"), kT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarkT"), femtoObs, kT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarmT"), femtoObs, mT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarMult"), femtoObs, mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("kstarPtPart1"), femtoObs, part1.pt());
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("kstarPtPart2"), femtoObs, part2.pt());
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("MultPtPart1"), part1.pt(), mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("MultPtPart2"), part2.pt(), mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("PtPart1PtPart2"), part1.pt(), part2.pt());
+    const auto& kT = mPairs.getKT();
+    const auto& mT = mPairs.getMT();
+    const auto& mult = mPairs.getMult();
+    const auto& pt1 = mPairs.getPtOne();
+    const auto& pt2 = mPairs.getPtTwo();
+    for (int i = 0; i < mPairs.size(); ++i) {
+      const float obs = (*femtoObs)[i];
+      mHistRelPairDist->Fill(obs);
+      mHistRelPairkT->Fill(kT[i]);
+      mHistRelPairkstarkT->Fill(obs, kT[i]);
+      mHistRelPairkstarmT->Fill(obs, mT[i]);
+      mHistRelPairkstarMult->Fill(obs, mult[i]);
+      mHistKstarPtPart1->Fill(obs, pt1[i]);
+      mHistKstarPtPart2->Fill(obs, pt2[i]);
+      mHistMultPtPart1->Fill(pt1[i], mult[i]);
+      mHistMultPtPart2->Fill(pt2[i], mult[i]);
+      mHistPtPart1PtPart2->Fill(pt1[i], pt2[i]);
     }
+    mPairs.clear();
   }
 
  protected:
@@ -133,6 +154,17 @@ class FemtoDreamContainer
   static constexpr int mEventType = eventType;                                        ///< Type of the event (same/mixed, according to femtoDreamContainer::EventType)
   float mMassOne = 0.f;                                                               ///< PDG mass of particle 1
   float mMassTwo = 0.f;                                                               ///< PDG mass of particle 2
+  o2::analysis::FemtoPairBatch mPairs;                                                ///< Pairs collected for histogramming
+  std::shared_ptr<TH1> mHistRelPairDist;
+  std::shared_ptr<TH1> mHistRelPairkT;
+  std::shared_ptr<TH2> mHistRelPairkstarkT;
+  std::shared_ptr<TH2> mHistRelPairkstarmT;
+  std::shared_ptr<TH2> mHistRelPairkstarMult;
+  std::shared_ptr<TH2> mHistKstarPtPart1;
+  std::shared_ptr<TH2> mHistKstarPtPart2;
+  std::shared_ptr<TH2> mHistMultPtPart1;
+  std::shared_ptr<TH2> mHistMultPtPart2;
+  std::shared_ptr<TH2> mHistPtPart1PtPart2;
 };
 
 } // namespace o2::analysis::femtoDream
@@ -22,6 +22,9 @@
 #include "FemtoDreamV0Selection.h"
 
 #include <bitset>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -153,6 +156,46 @@ class FemtoDreamCutculator
     }
   }
 
+  /// Puts together the bits of one selection criterion for a given choice of the selection value
+  /// \tparam T Type of the selections of the criterion
+  /// \param selVec Selections (i.e. all values) of the criterion
+  /// \param input Chosen selection value
+  /// \param counter Position of the first bit of the criterion in the bit-wise container
+  /// \return bits of the criterion, at their position in the bit-wise container
+  template <typename T>
+  static aod::femtodreamparticle::cutContainerType getSelectionBits(T& selVec, float input, size_t counter)
+  {
+    aod::femtodreamparticle::cutContainerType output = 0;
+    int internal_index = 0;
+    for (auto sel : selVec) {
+      double signOffset;
+      switch (sel.getSelectionType()) {
+        case femtoDreamSelection::SelectionType::kEqual:
+          signOffset = 0.;
+          break;
+        case (femtoDreamSelection::SelectionType::kLowerLimit):
+        case (femtoDreamSelection::SelectionType::kAbsLowerLimit):
+          signOffset = 1.;
+          break;
+        case (femtoDreamSelection::SelectionType::kUpperLimit):
+        case (femtoDreamSelection::SelectionType::kAbsUpperLimit):
+          signOffset = -1.;
+          break;
+      }
+
+      /// for upper and lower limit we have to substract/add an epsilon so that the cut is actually fulfilled
+      if (sel.isSelected(input + signOffset * 1.e-6 * input)) {
+        output |= 1UL << counter;
+        for (int i = internal_index; i > 0; i--) {
+          output &= ~(1UL << (counter - i));
+        }
+      }
+      ++counter;
+      ++internal_index;
+    }
+    return output;
+  }
+
   /// This function investigates a given selection criterion. The available options are displayed in the terminal and the bit-wise container is put together according to the user input
   /// \tparam T1 Selection class under investigation
   /// \param T2  Selection type under investigation
@@ -160,8 +203,9 @@ class FemtoDreamCutculator
   /// \param counter Current position in the bit-wise container to modify
   /// \tparam objectSelection Selection class under investigation (FemtoDreamTrack/V0/../Selection)
   /// \param selectionType Selection type under investigation, as defined in the selection class
+  /// \return the chosen selection value
   template <typename T1, typename T2>
-  void checkForSelection(aod::femtodreamparticle::cutContainerType& output, size_t& counter, T1 objectSelection, T2 selectionType)
+  float checkForSelection(aod::femtodreamparticle::cutContainerType& output, size_t& counter, T1 objectSelection, T2 selectionType)
   {
     /// Output of the available selections and user input
     std::cout << "Selection: " << objectSelection.getSelectionHelper(selectionType) << " - (";
@@ -184,51 +228,63 @@ class FemtoDreamCutculator
 
     /// If the input is sane, the selection bit is put together
     if (inputSane) {
-      int internal_index = 0;
-      for (auto sel : selVec) {
-        double signOffset;
-        switch (sel.getSelectionType()) {
-          case femtoDreamSelection::SelectionType::kEqual:
-            signOffset = 0.;
-            break;
-          case (femtoDreamSelection::SelectionType::kLowerLimit):
-          case (femtoDreamSelection::SelectionType::kAbsLowerLimit):
-            signOffset = 1.;
-            break;
-          case (femtoDreamSelection::SelectionType::kUpperLimit):
-          case (femtoDreamSelection::SelectionType::kAbsUpperLimit):
-            signOffset = -1.;
-            break;
-        }
+      output |= getSelectionBits(selVec, input, counter);
+      counter += selVec.size();
+      return input;
+    } else {
+      std::cout << "Choice " << in << " not recognized - repeating\n";
+      return checkForSelection(output, counter, objectSelection, selectionType);
+    }
+  }
 
-        /// for upper and lower limit we have to substract/add an epsilon so that the cut is actually fulfilled
-        if (sel.isSelected(input + signOffset * 1.e-6 * input)) {
-          output |= 1UL << counter;
-          for (int i = internal_index; i > 0; i--) {
-            output &= ~(1UL << (counter - i));
-          }
+  /// Selection bits of the variations of single criteria around a chosen selection
+  /// Each variation changes the value of one criterion and keeps the chosen values of all the others,
+  /// so that the pair tasks can fill all of them in one pass over the same derived data
+  /// \tparam T Selection class under investigation
+  /// \param objectSelection Selection class under investigation (FemtoDreamTrack/V0/../Selection)
+  /// \param output Bit-wise container of the chosen selection
+  /// \param chosenValues Chosen value of each criterion, in the order of getSelectionVariables()
+  /// \return name and bit-wise container of each variation
+  template <typename T>
+  std::vector<std::pair<std::string, aod::femtodreamparticle::cutContainerType>> getVariations(T objectSelection, aod::femtodreamparticle::cutContainerType output, std::vector<float> const& chosenValues)
+  {
+    std::vector<std::pair<std::string, aod::femtodreamparticle::cutContainerType>> variations;
+    size_t counter = 0;
+    auto selectionVariables = objectSelection.getSelectionVariables();
+    for (size_t iVar = 0; iVar < selectionVariables.size(); ++iVar) {
+      auto selVec = objectSelection.getSelections(selectionVariables[iVar]);
+      const size_t nBits = selVec.size();
+      const auto criterionMask = static_cast<aod::femtodreamparticle::cutContainerType>(((1UL << nBits) - 1) << counter);
+      for (auto sel : selVec) {
+        const float value = sel.getSelectionValue();
+        if (std::abs(value - chosenValues[iVar]) < std::abs(1.e-6 * value)) {
+          continue;
         }
-        ++counter;
-        ++internal_index;
+        std::string name = objectSelection.getSelectionHelper(selectionVariables[iVar]) + " = " + std::to_string(value);
+        variations.emplace_back(name, (output & ~criterionMask) | getSelectionBits(selVec, value, counter));
       }
-    } else {
-      std::cout << "Choice " << in << " not recognized - repeating\n";
-      checkForSelection(output, counter, objectSelection, selectionType);
+      counter += nBits;
     }
+    return variations;
   }
 
   /// This function iterates over all selection types of a given class and puts together the bit-wise container
   /// \tparam T1 Selection class under investigation
   /// \tparam objectSelection Selection class under investigation (FemtoDreamTrack/V0/../Selection)
   /// \return the full selection bit-wise container that will be put to the user task incorporating the user choice of selections
+  /// \param variations if not null, filled with the variations of single criteria around the user choice
   template <typename T>
-  aod::femtodreamparticle::cutContainerType iterateSelection(T objectSelection)
+  aod::femtodreamparticle::cutContainerType iterateSelection(T objectSelection, std::vector<std::pair<std::string, aod::femtodreamparticle::cutContainerType>>* variations = nullptr)
   {
     aod::femtodreamparticle::cutContainerType output = 0;
     size_t counter = 0;
+    std::vector<float> chosenValues;
     auto selectionVariables = objectSelection.getSelectionVariables();
     for (auto selVarIt : selectionVariables) {
-      checkForSelection(output, counter, objectSelection, selVarIt);
+      chosenValues.push_back(checkForSelection(output, counter, objectSelection, selVarIt));
+    }
+    if (variations) {
+      *variations = getVariations(objectSelection, output, chosenValues);
     }
     return output;
   }
@@ -241,10 +297,11 @@ class FemtoDreamCutculator
     std::string in;
     std::cin >> in;
     aod::femtodreamparticle::cutContainerType output = -1;
+    std::vector<std::pair<std::string, aod::femtodreamparticle::cutContainerType>> variations;
     if (in.compare("T") == 0) {
-      output = iterateSelection(mTrackSel);
+      output = iterateSelection(mTrackSel, &variations);
     } else if (in.compare("V") == 0) {
-      output = iterateSelection(mV0Sel);
+      output = iterateSelection(mV0Sel, &variations);
     } else if (in.compare("C") == 0) {
       // output =  iterateSelection(mCascadeSel);
     } else {
@@ -261,6 +318,30 @@ class FemtoDreamCutculator
     for (auto id : mPIDspecies) {
       std::cout << o2::track::PID::getName(id) << " : " << index++ << std::endl;
     }
+    printVariations(variations);
+  }
+
+  /// Prints the selection bits of the variations of single criteria, on request of the user
+  /// \param variations name and bit-wise container of each variation
+  void printVariations(std::vector<std::pair<std::string, aod::femtodreamparticle::cutContainerType>> const& variations)
+  {
+    if (variations.empty()) {
+      return;
+    }
+    std::cout << "Do you want the selection bits of the " << variations.size() << " single cut variations (y/n)?\n";
+    std::cout << " > ";
+    std::string in;
+    std::cin >> in;
+    if (in.compare("y") != 0) {
+      return;
+    }
+    std::string list;
+    for (const auto& [name, bits] : variations) {
+      std::cout << std::bitset<8 * sizeof(aod::femtodreamparticle::cutContainerType)>(bits) << " " << bits << " : " << name << "\n";
+      list += (list.empty() ? "" : ", ") + std::to_string(static_cast<int>(bits));
+    }
+    std::cout << "List for the cut variations of the pair tasks:\n";
+    std::cout << "[" << list << "]\n";
   }
 
  private:
@@ -18,7 +18,9 @@
 
 #include "PWGCF/DataModel/FemtoDerived.h"
 #include "Framework/HistogramRegistry.h"
+#include <array>
 #include <string>
+#include <vector>
 
 namespace o2::analysis
 {
@@ -149,14 +151,23 @@ class FemtoDreamDetaDphiStar
   std::array<std::array<std::shared_ptr<TH2>, 2>, 2> histdetadpi{};
   std::array<std::array<std::shared_ptr<TH2>, 9>, 2> histdetadpiRadii{};
 
-  ///  Calculate phi at all required radii stored in tmpRadiiTPC
-  /// Magnetic field to be provided in Tesla
+  /// phi at the radii stored in tmpRadiiTPC of one particle, with the inputs it was calculated from
+  struct PhiStarCache {
+    float phi = 0.f;
+    float pt = -1.f; ///< negative: not calculated yet
+    float charge = 0.f;
+    float magfield = 0.f;
+    std::array<float, 9> phiStar{};
+  };
+  /// Cached phi at the TPC radii, indexed by the particle global index
+  /// The entries are validated against the inputs of the calculation so they can be reused across
+  /// the same and mixed event pairs, and are recalculated when the particle table changes
+  std::vector<PhiStarCache> mPhiStarCache;
+
+  ///  Get the charge from cutcontainer using masks
   template <typename T>
-  void PhiAtRadiiTPC(const T& part, std::vector<float>& tmpVec)
+  float GetCharge(const T& part)
   {
-
-    float phi0 = part.phi();
-    // Start: Get the charge from cutcontainer using masks
     float charge = 0.;
     if ((part.cut() & kSignMinusMask) == kValue0 && (part.cut() & kSignPlusMask) == kValue0) {
       charge = 0;
@@ -167,25 +178,47 @@ class FemtoDreamDetaDphiStar
     } else {
       LOG(fatal) << "FemtoDreamDetaDphiStar: Charge bits are set wrong!";
     }
-    // End: Get the charge from cutcontainer using masks
+    return charge;
+  }
+
+  ///  Calculate phi at all required radii stored in tmpRadiiTPC
+  /// Magnetic field to be provided in Tesla
+  /// The values are calculated once per particle and magnetic field, and then taken from the cache
+  template <typename T>
+  const std::array<float, 9>& PhiAtRadiiTPC(const T& part)
+  {
+    const size_t index = part.globalIndex();
+    if (index >= mPhiStarCache.size()) {
+      mPhiStarCache.resize(index + 1);
+    }
+    PhiStarCache& cache = mPhiStarCache[index];
+
+    float phi0 = part.phi();
+    float charge = GetCharge(part);
     float pt = part.pt();
-    for (size_t i = 0; i < 9; i++) {
-      tmpVec.push_back(phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
+    if (cache.pt != pt || cache.phi != phi0 || cache.charge != charge || cache.magfield != magfield) {
+      cache.phi = phi0;
+      cache.pt = pt;
+      cache.charge = charge;
+      cache.magfield = magfield;
+      for (size_t i = 0; i < 9; i++) {
+        cache.phiStar[i] = phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt));
+      }
     }
+    return cache.phiStar;
   }
 
   ///  Calculate average phi
   template <typename T1, typename T2>
   float AveragePhiStar(const T1& part1, const T2& part2, int iHist)
   {
-    std::vector<float> tmpVec1;
-    std::vector<float> tmpVec2;
-    PhiAtRadiiTPC(part1, tmpVec1);
-    PhiAtRadiiTPC(part2, tmpVec2);
+    // copy, the cache can grow when looking up the second particle
+    const std::array<float, 9> tmpVec1 = PhiAtRadiiTPC(part1);
+    const std::array<float, 9>& tmpVec2 = PhiAtRadiiTPC(part2);
     const int num = tmpVec1.size();
     float dPhiAvg = 0;
     for (int i = 0; i < num; i++) {
-      float dphi = tmpVec1.at(i) - tmpVec2.at(i);
+      float dphi = tmpVec1[i] - tmpVec2[i];
       dphi = TVector2::Phi_mpi_pi(dphi);
       dPhiAvg += dphi;
       if (plotForEveryRadii) {
@@ -0,0 +1,186 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file FemtoDreamTripletSearch.h
+/// \brief Search of the triplets below a Q3 limit from the pair relative momenta
+/// \author Laura Serksnyte, TU München, laura.serksnyte@cern.ch
+
+#ifndef ANALYSIS_TASKS_PWGCF_FEMTODREAM_FEMTODREAMTRIPLETSEARCH_H_
+#define ANALYSIS_TASKS_PWGCF_FEMTODREAM_FEMTODREAMTRIPLETSEARCH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "PWGCF/Core/FemtoPairKinematics.h"
+
+namespace o2::analysis::femtoDream
+{
+
+/// Four-momentum of a particle of the triplet search
+struct TripletParticle {
+  float px;
+  float py;
+  float pz;
+  float e;
+};
+
+/// \class FemtoDreamTripletSearch
+/// \brief Triplets with Q3 below a limit, without looping over all the combinations
+/// Q3^2 is the sum of the -q_ij^2 of the three pairs (see FemtoDreamMath::getQ3), each of them positive.
+/// A triplet can only be below the limit if each pair is, so the partners of each particle are
+/// kept in a list ordered by -q_ij^2 and the scan of a list stops as soon as two pairs exceed the limit.
+/// The cost is the one of the pairs plus the one of the triplets found, instead of N^3.
+class FemtoDreamTripletSearch
+{
+ public:
+  /// \param q3Max  Q3 limit of the triplets, a non-positive value searches all triplets
+  /// \param maxTriplets  maximum number of triplets passed per event, -1 for no limit
+  void init(float q3Max, int maxTriplets)
+  {
+    // small margin, the triplets are checked with FemtoDreamMath::getQ3 by the caller
+    mQ32Max = q3Max > 0.f ? q3Max * q3Max * 1.001f : std::numeric_limits<float>::max();
+    mMaxTriplets = maxTriplets;
+  }
+
+  /// \param part1  first particle
+  /// \param part2  second particle
+  /// \return -q_12^2 of the pair, as in FemtoDreamMath::getqij
+  static float getQ2(TripletParticle const& part1, TripletParticle const& part2)
+  {
+    return femtokinematics::getQ2(part1.px, part1.py, part1.pz, part1.e, part2.px, part2.py, part2.pz, part2.e);
+  }
+
+  /// Searches the triplets of identical particles (i < j < l).
+  /// \param parts  particles
+  /// \param process  function called with the positions (i, j, l) of each triplet below the limit
+  /// \return false if the search was stopped at the maximum number of triplets
+  template <typename F>
+  bool searchIdentical(std::vector<TripletParticle> const& parts, F&& process)
+  {
+    mNTriplets = 0;
+    const int n = parts.size();
+    fillPairs(parts, parts);
+    // partners of each particle with a larger position, ordered by -q^2
+    fillPartners(n, n, [](int i, int j) { return j > i; });
+    for (int i = 0; i < n; ++i) {
+      auto const& partners = mPartners[i];
+      for (std::size_t iJ = 0; iJ < partners.size(); ++iJ) {
+        const auto [q2ij, j] = partners[iJ];
+        for (std::size_t iL = 0; iL < partners.size(); ++iL) {
+          const auto [q2il, l] = partners[iL];
+          if (q2ij + q2il >= mQ32Max) {
+            break;
+          }
+          if (l <= j || q2ij + q2il + mQ2[j * n + l] >= mQ32Max) {
+            continue;
+          }
+          if (!countTriplet()) {
+            return false;
+          }
+          process(i, j, l);
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Searches the triplets of two identical particles (i < j) and a third one (l).
+  /// \param pairParts  identical particles
+  /// \param thirdParts  third particles
+  /// \param process  function called with the positions (i, j) in pairParts and l in thirdParts of each triplet below the limit
+  /// \return false if the search was stopped at the maximum number of triplets
+  template <typename F>
+  bool searchTwoPlusOne(std::vector<TripletParticle> const& pairParts, std::vector<TripletParticle> const& thirdParts, F&& process)
+  {
+    mNTriplets = 0;
+    const int nPair = pairParts.size();
+    const int nThird = thirdParts.size();
+    fillPairs(pairParts, pairParts);
+    std::vector<float> q2Identical(mQ2);
+    fillPairs(thirdParts, pairParts);
+    // partners of each third particle among the identical ones, ordered by -q^2
+    fillPartners(nThird, nPair, [](int, int) { return true; });
+    for (int l = 0; l < nThird; ++l) {
+      auto const& partners = mPartners[l];
+      for (std::size_t iI = 0; iI < partners.size(); ++iI) {
+        const auto [q2il, i] = partners[iI];
+        for (std::size_t iJ = 0; iJ < partners.size(); ++iJ) {
+          const auto [q2jl, j] = partners[iJ];
+          if (q2il + q2jl >= mQ32Max) {
+            break;
+          }
+          if (j <= i || q2il + q2jl + q2Identical[i * nPair + j] >= mQ32Max) {
+            continue;
+          }
+          if (!countTriplet()) {
+            return false;
+          }
+          process(i, j, l);
+        }
+      }
+    }
+    return true;
+  }
+
+  /// \return number of triplets passed in the last search
+  int getNTriplets() const { return mNTriplets; }
+
+ private:
+  /// Fills the -q^2 of all pairs (first, second) in mQ2.
+  void fillPairs(std::vector<TripletParticle> const& first, std::vector<TripletParticle> const& second)
+  {
+    const std::size_t nSecond = second.size();
+    mQ2.resize(first.size() * nSecond);
+    for (std::size_t i = 0; i < first.size(); ++i) {
+      for (std::size_t j = 0; j < nSecond; ++j) {
+        mQ2[i * nSecond + j] = getQ2(first[i], second[j]);
+      }
+    }
+  }
+
+  /// Fills the partners below the limit of each first particle from mQ2, ordered by -q^2.
+  template <typename Accept>
+  void fillPartners(int nFirst, int nSecond, Accept&& accept)
+  {
+    mPartners.resize(nFirst);
+    for (int i = 0; i < nFirst; ++i) {
+      mPartners[i].clear();
+      for (int j = 0; j < nSecond; ++j) {
+        if (accept(i, j) && mQ2[i * nSecond + j] < mQ32Max) {
+          mPartners[i].emplace_back(mQ2[i * nSecond + j], j);
+        }
+      }
+      std::sort(mPartners[i].begin(), mPartners[i].end());
+    }
+  }
+
+  bool countTriplet()
+  {
+    if (mMaxTriplets >= 0 && mNTriplets >= mMaxTriplets) {
+      return false;
+    }
+    ++mNTriplets;
+    return true;
+  }
+
+  float mQ32Max = std::numeric_limits<float>::max();      ///< Q3^2 limit of the search
+  int mMaxTriplets = -1;                                   ///< maximum number of triplets per search, -1 for no limit
+  int mNTriplets = 0;                                      ///< number of triplets passed in the last search
+  std::vector<float> mQ2;                                  ///< -q^2 of the pairs
+  std::vector<std::vector<std::pair<float, int>>> mPartners; ///< (-q^2, position) of the partners of each particle
+};
+
+} // namespace o2::analysis::femtoDream
+
+#endif // ANALYSIS_TASKS_PWGCF_FEMTODREAM_FEMTODREAMTRIPLETSEARCH_H_
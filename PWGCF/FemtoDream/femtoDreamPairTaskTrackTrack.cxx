@@ -81,6 +81,10 @@ struct femtoDreamPairTaskTrackTrack {
   /// Histogramming for particle 2
   FemtoDreamParticleHisto<aod::femtodreamparticle::ParticleType::kTrack, 2> trackHistoPartTwo;
 
+  /// Cut variations, filled in the same pass into their own folders VariationN/
+  Configurable<std::vector<int>> ConfCutVariationsPartOne{"ConfCutVariationsPartOne", std::vector<int>{}, "Particle 1 - Selection bits of the cut variations from cutCulator, applied to the particles passing ConfCutPartOne"};
+  Configurable<std::vector<int>> ConfCutVariationsPartTwo{"ConfCutVariationsPartTwo", std::vector<int>{}, "Particle 2 - Selection bits of the cut variations from cutCulator, empty: same as particle 1"};
+
   /// Histogramming for Event
   FemtoDreamEventHisto eventHisto;
 
@@ -103,6 +107,9 @@ struct femtoDreamPairTaskTrackTrack {
 
   FemtoDreamContainer<femtoDreamContainer::EventType::same, femtoDreamContainer::Observable::kstar> sameEventCont;
   FemtoDreamContainer<femtoDreamContainer::EventType::mixed, femtoDreamContainer::Observable::kstar> mixedEventCont;
+  std::vector<FemtoDreamContainer<femtoDreamContainer::EventType::same, femtoDreamContainer::Observable::kstar>> sameEventVariationConts;
+  std::vector<FemtoDreamContainer<femtoDreamContainer::EventType::mixed, femtoDreamContainer::Observable::kstar>> mixedEventVariationConts;
+  std::vector<aod::femtodreamparticle::cutContainerType> vCutVariationsPartOne, vCutVariationsPartTwo;
   FemtoDreamPairCleaner<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kTrack> pairCleaner;
   FemtoDreamDetaDphiStar<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kTrack> pairCloseRejection;
   /// Histogram output
@@ -132,6 +139,43 @@ struct femtoDreamPairTaskTrackTrack {
 
     vPIDPartOne = ConfPIDPartOne;
     vPIDPartTwo = ConfPIDPartTwo;
+
+    for (auto cut : (std::vector<int>)ConfCutVariationsPartOne) {
+      vCutVariationsPartOne.push_back(static_cast<aod::femtodreamparticle::cutContainerType>(cut));
+    }
+    for (auto cut : (std::vector<int>)ConfCutVariationsPartTwo) {
+      vCutVariationsPartTwo.push_back(static_cast<aod::femtodreamparticle::cutContainerType>(cut));
+    }
+    if (vCutVariationsPartTwo.empty()) {
+      vCutVariationsPartTwo = vCutVariationsPartOne;
+    }
+    if (vCutVariationsPartTwo.size() != vCutVariationsPartOne.size()) {
+      LOGF(fatal, "ConfCutVariationsPartOne and ConfCutVariationsPartTwo must have the same number of variations");
+    }
+    sameEventVariationConts.resize(vCutVariationsPartOne.size());
+    mixedEventVariationConts.resize(vCutVariationsPartOne.size());
+    for (size_t iVar = 0; iVar < vCutVariationsPartOne.size(); ++iVar) {
+      const std::string folderPrefix = "Variation" + std::to_string(iVar) + "/";
+      sameEventVariationConts[iVar].init(&resultRegistry, CfgkstarBins, CfgMultBins, CfgkTBins, CfgmTBins, folderPrefix);
+      sameEventVariationConts[iVar].setPDGCodes(ConfPDGCodePartOne, ConfPDGCodePartTwo);
+      mixedEventVariationConts[iVar].init(&resultRegistry, CfgkstarBins, CfgMultBins, CfgkTBins, CfgmTBins, folderPrefix);
+      mixedEventVariationConts[iVar].setPDGCodes(ConfPDGCodePartOne, ConfPDGCodePartTwo);
+    }
+  }
+
+  /// Passes a pair to the containers of the cut variations both particles pass
+  /// \param containers Containers of the cut variations
+  /// \param p1 Particle one
+  /// \param p2 Particle two
+  /// \param mult Multiplicity of the event
+  template <typename C, typename T>
+  void setPairVariations(std::vector<C>& containers, T const& p1, T const& p2, const int mult)
+  {
+    for (size_t iVar = 0; iVar < containers.size(); ++iVar) {
+      if ((p1.cut() & vCutVariationsPartOne[iVar]) == vCutVariationsPartOne[iVar] && (p2.cut() & vCutVariationsPartTwo[iVar]) == vCutVariationsPartTwo[iVar]) {
+        containers[iVar].setPair(p1, p2, mult);
+      }
+    }
   }
 
   /// This function processes the same event and takes care of all the histogramming
@@ -189,6 +233,11 @@ struct femtoDreamPairTaskTrackTrack {
         continue;
       }
       sameEventCont.setPair(p1, p2, multCol);
+      setPairVariations(sameEventVariationConts, p1, p2, multCol);
+    }
+    sameEventCont.flush();
+    for (auto& container : sameEventVariationConts) {
+      container.flush();
     }
   }
 
@@ -231,8 +280,13 @@ struct femtoDreamPairTaskTrackTrack {
           }
         }
         mixedEventCont.setPair(p1, p2, collision1.multV0M());
+        setPairVariations(mixedEventVariationConts, p1, p2, collision1.multV0M());
       }
     }
+    mixedEventCont.flush();
+    for (auto& container : mixedEventVariationConts) {
+      container.flush();
+    }
   }
 
   PROCESS_SWITCH(femtoDreamPairTaskTrackTrack, processMixedEvent, "Enable processing mixed events", true);
@@ -164,6 +164,7 @@ struct femtoDreamPairTaskTrackV0 {
       }
       sameEventCont.setPair(p1, p2, multCol);
     }
+    sameEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoDreamPairTaskTrackV0, processSameEvent, "Enable processing same event", true);
@@ -202,6 +203,7 @@ struct femtoDreamPairTaskTrackV0 {
         mixedEventCont.setPair(p1, p2, collision1.multV0M());
       }
     }
+    mixedEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoDreamPairTaskTrackV0, processMixedEvent, "Enable processing mixed events", true);
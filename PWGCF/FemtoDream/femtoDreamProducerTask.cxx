@@ -11,12 +11,16 @@
 
 /// \file femtoDreamProducerTask.cxx
 /// \brief Tasks that produces the track tables used for the pairing
+/// The selections are evaluated once per track and V0 and their cut bits can be written both to the
+/// FemtoDream tables and, with processDataShared, to the FemtoWorld tables, so that the pair tasks of
+/// the two families run on the output of a single producer
 /// \author Laura Serksnyte, TU München, laura.serksnyte@tum.de
 
 #include "FemtoDreamCollisionSelection.h"
 #include "FemtoDreamTrackSelection.h"
 #include "FemtoDreamV0Selection.h"
 #include "PWGCF/DataModel/FemtoDerived.h"
+#include "PWGCF/FemtoWorld/DataModel/FemtoWorldDerived.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/AnalysisTask.h"
 #include "Framework/runDataProcessing.h"
@@ -57,6 +61,8 @@ using FemtoFullTracks = soa::Join<aod::FullTracks,
                                   aod::pidTPCKa, aod::pidTPCPr, aod::pidTPCDe,
                                   aod::pidTOFEl, aod::pidTOFMu, aod::pidTOFPi,
                                   aod::pidTOFKa, aod::pidTOFPr, aod::pidTOFDe>;
+/// tracks with the TOF beta in addition, needed by the FemtoWorld tables
+using FemtoFullTracksShared = soa::Join<FemtoFullTracks, aod::pidTOFbeta>;
 
 // using FilteredFullV0s = soa::Filtered<aod::V0Datas>; /// predefined Join table for o2::aod::V0s = soa::Join<o2::aod::TransientV0s, o2::aod::StoredV0s> to be used when we add v0Filter
 } // namespace o2::aod
@@ -86,6 +92,8 @@ struct femtoDreamProducerTask {
   Produces<aod::FemtoDreamParticlesMC> outputPartsMC;
   Produces<aod::FemtoDreamDebugParticles> outputDebugParts;
   Produces<aod::FemtoDreamDebugParticlesMC> outputDebugPartsMC;
+  Produces<aod::FemtoWorldCollisions> outputWorldCollision;
+  Produces<aod::FemtoWorldParticles> outputWorldParts;
 
   Configurable<bool> ConfDebugOutput{"ConfDebugOutput", true, "Debug output"};
 
@@ -168,11 +176,11 @@ struct femtoDreamProducerTask {
 
   void init(InitContext&)
   {
-    if (doprocessData == false && doprocessMC == false) {
-      LOGF(fatal, "Neither processData nor processMC enabled. Please choose one.");
+    if (doprocessData + doprocessDataShared + doprocessMC == 0) {
+      LOGF(fatal, "Neither processData, processDataShared nor processMC enabled. Please choose one.");
     }
-    if (doprocessData == true && doprocessMC == true) {
-      LOGF(fatal, "Cannot enable processData and processMC at the same time. Please choose one.");
+    if (doprocessData + doprocessDataShared + doprocessMC > 1) {
+      LOGF(fatal, "Cannot enable more than one of processData, processDataShared and processMC at the same time. Please choose one.");
     }
 
     colCuts.setCuts(ConfEvtZvtx, ConfEvtTriggerCheck, ConfEvtTriggerSel, ConfEvtOfflineCheck, ConfIsRun3);
@@ -339,7 +347,55 @@ struct femtoDreamProducerTask {
     }
   }
 
-  template <bool isMC, typename V0Type, typename TrackType, typename CollisionType>
+  /// Writes a particle to the FemtoWorld table, with the cut bits of the FemtoDream selection
+  /// \note The FemtoWorld track and V0 selections are copies of the FemtoDream ones with the same bit layout
+  /// \param track  track of the particle, or positive daughter of the V0
+  /// \param kinematics  pt, eta and phi of the particle
+  /// \param partType  type of the particle
+  /// \param cut  bit-wise container of the selection
+  /// \param pidcut  bit-wise container of the PID selection
+  /// \param tempFitVar  variable for the template fits
+  /// \param childIDs  rows of the children
+  /// \param mLambda  invariant mass of the V0 assuming a lambda
+  /// \param mAntiLambda  invariant mass of the V0 assuming an antilambda
+  template <typename TrackType>
+  void fillWorldParticle(TrackType const& track, std::array<float, 3> const& kinematics, uint8_t partType,
+                         aod::femtodreamparticle::cutContainerType cut, aod::femtodreamparticle::cutContainerType pidcut, float tempFitVar,
+                         int (&childIDs)[2], float mLambda, float mAntiLambda)
+  {
+    outputWorldParts(outputWorldCollision.lastIndex(),
+                     kinematics[0], kinematics[1], kinematics[2],
+                     partType, cut, pidcut, tempFitVar, childIDs, mLambda, mAntiLambda,
+                     track.sign(),
+                     track.beta(),
+                     track.itsChi2NCl(),
+                     track.tpcChi2NCl(),
+                     track.tpcNSigmaKa(),
+                     track.tofNSigmaKa(),
+                     (uint8_t)track.tpcNClsFound(),
+                     track.tpcNClsFindable(),
+                     (uint8_t)track.tpcNClsCrossedRows(),
+                     track.tpcNClsShared(),
+                     track.tpcInnerParam(),
+                     track.itsNCls(),
+                     track.itsNClsInnerBarrel(),
+                     track.dcaXY(),
+                     track.dcaZ(),
+                     track.tpcSignal(),
+                     track.tpcNSigmaStoreEl(),
+                     track.tpcNSigmaStorePi(),
+                     track.tpcNSigmaStoreKa(),
+                     track.tpcNSigmaStorePr(),
+                     track.tpcNSigmaStoreDe(),
+                     track.tofNSigmaStoreEl(),
+                     track.tofNSigmaStorePi(),
+                     track.tofNSigmaStoreKa(),
+                     track.tofNSigmaStorePr(),
+                     track.tofNSigmaStoreDe(),
+                     -999., -999., -999., -999., -999., -999.);
+  }
+
+  template <bool isMC, bool isShared = false, typename V0Type, typename TrackType, typename CollisionType>
   void fillCollisionsAndTracksAndV0(CollisionType const& col, TrackType const& tracks, V0Type const& fullV0s)
   {
 
@@ -350,6 +406,9 @@ struct femtoDreamProducerTask {
     if (!colCuts.isSelected(col)) {
       if (ConfIsTrigger) {
         outputCollision(col.posZ(), col.multFV0M(), colCuts.computeSphericity(col, tracks), mMagField);
+        if constexpr (isShared) {
+          outputWorldCollision(col.posZ(), col.multFV0M(), colCuts.computeSphericity(col, tracks), mMagField);
+        }
       }
       return;
     }
@@ -365,6 +424,9 @@ struct femtoDreamProducerTask {
     } else {
       outputCollision(vtxZ, mult, spher, mMagField);
     }
+    if constexpr (isShared) {
+      outputWorldCollision(vtxZ, ConfIsRun3 ? col.multFT0M() : mult, spher, mMagField);
+    }
 
     int childIDs[2] = {0, 0};    // these IDs are necessary to keep track of the children
     std::vector<int> tmpIDtrack; // this vector keeps track of the matching of the primary track table row <-> aod::track table global index
@@ -388,6 +450,12 @@ struct femtoDreamProducerTask {
                   cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kPID),
                   track.dcaXY(),
                   childIDs, 0, 0);
+      if constexpr (isShared) {
+        fillWorldParticle(track, {track.pt(), track.eta(), track.phi()}, aod::femtoworldparticle::ParticleType::kTrack,
+                          cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kCuts),
+                          cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kPID),
+                          track.dcaXY(), childIDs, 0, 0);
+      }
       tmpIDtrack.push_back(track.globalIndex());
       if (ConfDebugOutput) {
         fillDebugParticle<true>(track);
@@ -428,6 +496,11 @@ struct femtoDreamProducerTask {
           childIDs[1] = 0;
           outputParts(outputCollision.lastIndex(), v0.positivept(), v0.positiveeta(), v0.positivephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosPID), 0., childIDs, 0, 0);
           const int rowOfPosTrack = outputParts.lastIndex();
+          if constexpr (isShared) {
+            fillWorldParticle(postrack, {v0.positivept(), v0.positiveeta(), v0.positivephi()}, aod::femtoworldparticle::ParticleType::kV0Child,
+                              cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosCuts),
+                              cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosPID), 0., childIDs, 0, 0);
+          }
           if constexpr (isMC) {
             fillMCParticle(postrack);
           }
@@ -438,11 +511,22 @@ struct femtoDreamProducerTask {
           childIDs[1] = rowInPrimaryTrackTableNeg;
           outputParts(outputCollision.lastIndex(), v0.negativept(), v0.negativeeta(), v0.negativephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegPID), 0., childIDs, 0, 0);
           const int rowOfNegTrack = outputParts.lastIndex();
+          if constexpr (isShared) {
+            fillWorldParticle(negtrack, {v0.negativept(), v0.negativeeta(), v0.negativephi()}, aod::femtoworldparticle::ParticleType::kV0Child,
+                              cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegCuts),
+                              cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegPID), 0., childIDs, 0, 0);
+          }
           if constexpr (isMC) {
             fillMCParticle(negtrack);
           }
           int indexChildID[2] = {rowOfPosTrack, rowOfNegTrack};
           outputParts(outputCollision.lastIndex(), v0.pt(), v0.eta(), v0.phi(), aod::femtodreamparticle::ParticleType::kV0, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kV0), 0, v0.v0cosPA(col.posX(), col.posY(), col.posZ()), indexChildID, v0.mLambda(), v0.mAntiLambda());
+          if constexpr (isShared) {
+            // the FemtoWorld V0 rows carry the positive daughter information, the children rows are the same in both tables
+            fillWorldParticle(postrack, {v0.pt(), v0.eta(), v0.phi()}, aod::femtoworldparticle::ParticleType::kV0,
+                              cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kV0), 0,
+                              v0.v0cosPA(col.posX(), col.posY(), col.posZ()), indexChildID, v0.mLambda(), v0.mAntiLambda());
+          }
           if (ConfDebugOutput) {
             fillDebugParticle<true>(postrack); // QA for positive daughter
             fillDebugParticle<true>(negtrack); // QA for negative daughter
@@ -466,6 +550,16 @@ struct femtoDreamProducerTask {
   }
   PROCESS_SWITCH(femtoDreamProducerTask, processData, "Provide experimental data", true);
 
+  void processDataShared(aod::FemtoFullCollision const& col, aod::BCsWithTimestamps const&, aod::FemtoFullTracksShared const& tracks,
+                         o2::aod::V0Datas const& fullV0s) /// \todo with FilteredFullV0s
+  {
+    // get magnetic field for run
+    getMagneticFieldTesla(col.bc_as<aod::BCsWithTimestamps>());
+    // fill the tables of both FemtoDream and FemtoWorld
+    fillCollisionsAndTracksAndV0<false, true>(col, tracks, fullV0s);
+  }
+  PROCESS_SWITCH(femtoDreamProducerTask, processDataShared, "Provide experimental data, also to the FemtoWorld tables", false);
+
   void processMC(aod::FemtoFullCollisionMC const& col,
                  aod::BCsWithTimestamps const&,
                  soa::Join<aod::FemtoFullTracks, aod::McTrackLabels> const& tracks,
@@ -20,6 +20,7 @@
 
 #include "Framework/HistogramRegistry.h"
 #include "PWGCF/FemtoWorld/Core/FemtoWorldMath.h"
+#include "PWGCF/Core/FemtoPairKinematics.h"
 
 #include "Math/Vector4D.h"
 #include "TMath.h"
@@ -92,18 +93,18 @@ class FemtoWorldContainer
     framework::AxisSpec mInvAxis = {mInvBins, 0.0, 10.0};
 
     std::string folderName = static_cast<std::string>(mFolderSuffix[mEventType]);
-    mHistogramRegistry->add((folderName + "relPairDist").c_str(), ("; " + femtoObs + "; Entries").c_str(), kTH1F, {femtoObsAxis});
-    mHistogramRegistry->add((folderName + "relPairkT").c_str(), "; #it{k}_{T} (GeV/#it{c}); Entries", kTH1F, {kTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarkT").c_str(), ("; " + femtoObs + "; #it{k}_{T} (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, kTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarmT").c_str(), ("; " + femtoObs + "; #it{m}_{T} (GeV/#it{c}^{2})").c_str(), kTH2F, {femtoObsAxis, mTAxis});
-    mHistogramRegistry->add((folderName + "relPairkstarMult").c_str(), ("; " + femtoObs + "; Multiplicity").c_str(), kTH2F, {femtoObsAxis, multAxis});
-    mHistogramRegistry->add((folderName + "kstarPtPart1").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 1 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
-    mHistogramRegistry->add((folderName + "kstarPtPart2").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 2 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
-    mHistogramRegistry->add((folderName + "MultPtPart1").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
-    mHistogramRegistry->add((folderName + "MultPtPart2").c_str(), "; #it{p} _{T} Particle 2 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
-    mHistogramRegistry->add((folderName + "PtPart1PtPart2").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); #it{p} _{T} Particle 2 (GeV/#it{c})", kTH2F, {{375, 0., 7.5}, {375, 0., 7.5}});
-    mHistogramRegistry->add((folderName + "relPairDetaDphi").c_str(), ";  #Delta#varphi (rad); #Delta#eta", kTH2D, {phiAxis, etaAxis});
-    mHistogramRegistry->add((folderName + "relPairInvariantMass").c_str(), ";M_{K^{+}K^{-}} (GeV/#it{c}^{2});", kTH1D, {mInvAxis});
+    mHistRelPairDist = mHistogramRegistry->add<TH1>((folderName + "relPairDist").c_str(), ("; " + femtoObs + "; Entries").c_str(), kTH1F, {femtoObsAxis});
+    mHistRelPairkT = mHistogramRegistry->add<TH1>((folderName + "relPairkT").c_str(), "; #it{k}_{T} (GeV/#it{c}); Entries", kTH1F, {kTAxis});
+    mHistRelPairkstarkT = mHistogramRegistry->add<TH2>((folderName + "relPairkstarkT").c_str(), ("; " + femtoObs + "; #it{k}_{T} (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, kTAxis});
+    mHistRelPairkstarmT = mHistogramRegistry->add<TH2>((folderName + "relPairkstarmT").c_str(), ("; " + femtoObs + "; #it{m}_{T} (GeV/#it{c}^{2})").c_str(), kTH2F, {femtoObsAxis, mTAxis});
+    mHistRelPairkstarMult = mHistogramRegistry->add<TH2>((folderName + "relPairkstarMult").c_str(), ("; " + femtoObs + "; Multiplicity").c_str(), kTH2F, {femtoObsAxis, multAxis});
+    mHistKstarPtPart1 = mHistogramRegistry->add<TH2>((folderName + "kstarPtPart1").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 1 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
+    mHistKstarPtPart2 = mHistogramRegistry->add<TH2>((folderName + "kstarPtPart2").c_str(), ("; " + femtoObs + "; #it{p} _{T} Particle 2 (GeV/#it{c})").c_str(), kTH2F, {femtoObsAxis, {375, 0., 7.5}});
+    mHistMultPtPart1 = mHistogramRegistry->add<TH2>((folderName + "MultPtPart1").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
+    mHistMultPtPart2 = mHistogramRegistry->add<TH2>((folderName + "MultPtPart2").c_str(), "; #it{p} _{T} Particle 2 (GeV/#it{c}); Multiplicity", kTH2F, {{375, 0., 7.5}, multAxis});
+    mHistPtPart1PtPart2 = mHistogramRegistry->add<TH2>((folderName + "PtPart1PtPart2").c_str(), "; #it{p} _{T} Particle 1 (GeV/#it{c}); #it{p} _{T} Particle 2 (GeV/#it{c})", kTH2F, {{375, 0., 7.5}, {375, 0., 7.5}});
+    mHistRelPairDetaDphi = mHistogramRegistry->add<TH2>((folderName + "relPairDetaDphi").c_str(), ";  #Delta#varphi (rad); #Delta#eta", kTH2D, {phiAxis, etaAxis});
+    mHistRelPairInvariantMass = mHistogramRegistry->add<TH1>((folderName + "relPairInvariantMass").c_str(), ";M_{K^{+}K^{-}} (GeV/#it{c}^{2});", kTH1D, {mInvAxis});
   }
 
   /// Set the PDG codes of the two particles involved
@@ -113,9 +114,12 @@ class FemtoWorldContainer
   {
     mMassOne = TDatabasePDG::Instance()->GetParticle(pdg1)->Mass();
     mMassTwo = TDatabasePDG::Instance()->GetParticle(pdg2)->Mass();
+    mPairs.setMasses(mMassOne, mMassTwo);
   }
 
   /// Pass a pair to the container and compute all the relevant observables
+  /// The pairs are collected in a batch, whose observables are computed and histogrammed
+  /// when it is full or when flush() is called, which has to be done at the end of each process function
   /// \tparam T type of the femtoworldparticle
   /// \param part1 Particle one
   /// \param part2 Particle two
@@ -123,46 +127,56 @@ class FemtoWorldContainer
   template <typename T>
   void setPair(T const& part1, T const& part2, const int mult)
   {
-    float femtoObs;
-    if constexpr (mFemtoObs == femtoWorldContainer::Observable::kstar) {
-      femtoObs = FemtoWorldMath::getkstar(part1, mMassOne, part2, mMassTwo);
+    if (mHistogramRegistry && mPairs.add(part1, part2, mult)) {
+      flush();
     }
-    const float kT = FemtoWorldMath::getkT(part1, mMassOne, part2, mMassTwo);
-    const float mT = FemtoWorldMath::getmT(part1, mMassOne, part2, mMassTwo);
-
-    double delta_eta = part1.eta() - part2.eta();
-    double delta_phi = part1.phi() - part2.phi();
+  }
 
-    while (delta_phi < mPhiLow) {
-      delta_phi += TwoPI;
-    }
-    while (delta_phi > mPhiHigh) {
-      delta_phi -= TwoPI;
+  /// Compute the observables of the collected pairs and fill the histograms
+  void flush()
+  {
+    if (mPairs.size() == 0) {
+      return;
     }
-    TLorentzVector part1Vec;
-    part1Vec.SetPtEtaPhiM(part1.pt(), part1.eta(), part1.phi(), mMassOne);
-    TLorentzVector part2Vec;
-    part2Vec.SetPtEtaPhiM(part2.pt(), part2.eta(), part2.phi(), mMassTwo);
-
-    TLorentzVector sumVec(part1Vec);
-    sumVec += part2Vec;
-    if (mHistogramRegistry) {
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairInvariantMass"), sumVec.M());
+    mPairs.compute();
+    const std::vector<float>* femtoObs = nullptr;
+    if constexpr (mFemtoObs == femtoWorldContainer::Observable::kstar) {
+      femtoObs = &mPairs.getKstar();
     }
-
-    if (mHistogramRegistry) {
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairDist"), femtoObs);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkT"), kT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarkT"), femtoObs, kT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarmT"), femtoObs, mT);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairkstarMult"), femtoObs, mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("kstarPtPart1"), femtoObs, part1.pt());
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("kstarPtPart2"), femtoObs, part2.pt());
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("MultPtPart1"), part1.pt(), mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("MultPtPart2"), part2.pt(), mult);
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("PtPart1PtPart2"), part1.pt(), part2.pt());
-      mHistogramRegistry->fill(HIST(mFolderSuffix[mEventType]) + HIST("relPairDetaDphi"), delta_phi, delta_eta);
+    const auto& kT = mPairs.getKT();
+    const auto& mT = mPairs.getMT();
+    const auto& mInv = mPairs.getMInv();
+    const auto& mult = mPairs.getMult();
+    const auto& pt1 = mPairs.getPtOne();
+    const auto& pt2 = mPairs.getPtTwo();
+    const auto& eta1 = mPairs.getEtaOne();
+    const auto& eta2 = mPairs.getEtaTwo();
+    const auto& phi1 = mPairs.getPhiOne();
+    const auto& phi2 = mPairs.getPhiTwo();
+    for (int i = 0; i < mPairs.size(); ++i) {
+      const float obs = (*femtoObs)[i];
+      double delta_eta = eta1[i] - eta2[i];
+      double delta_phi = phi1[i] - phi2[i];
+      while (delta_phi < mPhiLow) {
+        delta_phi += TwoPI;
+      }
+      while (delta_phi > mPhiHigh) {
+        delta_phi -= TwoPI;
+      }
+      mHistRelPairInvariantMass->Fill(mInv[i]);
+      mHistRelPairDist->Fill(obs);
+      mHistRelPairkT->Fill(kT[i]);
+      mHistRelPairkstarkT->Fill(obs, kT[i]);
+      mHistRelPairkstarmT->Fill(obs, mT[i]);
+      mHistRelPairkstarMult->Fill(obs, mult[i]);
+      mHistKstarPtPart1->Fill(obs, pt1[i]);
+      mHistKstarPtPart2->Fill(obs, pt2[i]);
+      mHistMultPtPart1->Fill(pt1[i], mult[i]);
+      mHistMultPtPart2->Fill(pt2[i], mult[i]);
+      mHistPtPart1PtPart2->Fill(pt1[i], pt2[i]);
+      mHistRelPairDetaDphi->Fill(delta_phi, delta_eta);
     }
+    mPairs.clear();
   }
 
  protected:
@@ -174,6 +188,19 @@ class FemtoWorldContainer
   float mMassTwo = 0.f;                                                               ///< PDG mass of particle 2
   double mPhiLow;
   double mPhiHigh;
+  o2::analysis::FemtoPairBatch mPairs; ///< Pairs collected for histogramming
+  std::shared_ptr<TH1> mHistRelPairDist;
+  std::shared_ptr<TH1> mHistRelPairkT;
+  std::shared_ptr<TH2> mHistRelPairkstarkT;
+  std::shared_ptr<TH2> mHistRelPairkstarmT;
+  std::shared_ptr<TH2> mHistRelPairkstarMult;
+  std::shared_ptr<TH2> mHistKstarPtPart1;
+  std::shared_ptr<TH2> mHistKstarPtPart2;
+  std::shared_ptr<TH2> mHistMultPtPart1;
+  std::shared_ptr<TH2> mHistMultPtPart2;
+  std::shared_ptr<TH2> mHistPtPart1PtPart2;
+  std::shared_ptr<TH2> mHistRelPairDetaDphi;
+  std::shared_ptr<TH1> mHistRelPairInvariantMass;
 };
 
 } // namespace o2::analysis::femtoWorld
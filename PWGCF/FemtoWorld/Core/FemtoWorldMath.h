@@ -22,6 +22,8 @@
 #include "TLorentzVector.h"
 #include "TMath.h"
 
+#include "PWGCF/Core/FemtoPairKinematics.h"
+
 #include <iostream>
 
 namespace o2::analysis::femtoWorld
@@ -41,24 +43,11 @@ class FemtoWorldMath
   template <typename T>
   static float getkstar(const T& part1, const float mass1, const T& part2, const float mass2)
   {
-    const ROOT::Math::PtEtaPhiMVector vecpart1(part1.pt(), part1.eta(), part1.phi(), mass1);
-    const ROOT::Math::PtEtaPhiMVector vecpart2(part2.pt(), part2.eta(), part2.phi(), mass2);
-    const ROOT::Math::PtEtaPhiMVector trackSum = vecpart1 + vecpart2;
-
-    const float beta = trackSum.Beta();
-    const float betax = beta * std::cos(trackSum.Phi()) * std::sin(trackSum.Theta());
-    const float betay = beta * std::sin(trackSum.Phi()) * std::sin(trackSum.Theta());
-    const float betaz = beta * std::cos(trackSum.Theta());
-
-    ROOT::Math::PxPyPzMVector PartOneCMS(vecpart1);
-    ROOT::Math::PxPyPzMVector PartTwoCMS(vecpart2);
-
-    const ROOT::Math::Boost boostPRF = ROOT::Math::Boost(-betax, -betay, -betaz);
-    PartOneCMS = boostPRF(PartOneCMS);
-    PartTwoCMS = boostPRF(PartTwoCMS);
-
-    const ROOT::Math::PxPyPzMVector trackRelK = PartOneCMS - PartTwoCMS;
-    return 0.5 * trackRelK.P();
+    float px1, py1, pz1, px2, py2, pz2;
+    femtokinematics::getMomentum(part1.pt(), part1.eta(), part1.phi(), px1, py1, pz1);
+    femtokinematics::getMomentum(part2.pt(), part2.eta(), part2.phi(), px2, py2, pz2);
+    return femtokinematics::getKstar(px1, py1, pz1, femtokinematics::getEnergy(px1, py1, pz1, mass1),
+                                     px2, py2, pz2, femtokinematics::getEnergy(px2, py2, pz2, mass2));
   }
   /// Compute the qij of a pair of particles
   /// \tparam T type of tracks
@@ -119,10 +108,8 @@ class FemtoWorldMath
   template <typename T>
   static float getkT(const T& part1, const float mass1, const T& part2, const float mass2)
   {
-    const ROOT::Math::PtEtaPhiMVector vecpart1(part1.pt(), part1.eta(), part1.phi(), mass1);
-    const ROOT::Math::PtEtaPhiMVector vecpart2(part2.pt(), part2.eta(), part2.phi(), mass2);
-    const ROOT::Math::PtEtaPhiMVector trackSum = vecpart1 + vecpart2;
-    return 0.5 * trackSum.Pt();
+    const float phi1 = part1.phi(), phi2 = part2.phi();
+    return femtokinematics::getKT(part1.pt() * std::cos(phi1), part1.pt() * std::sin(phi1), part2.pt() * std::cos(phi2), part2.pt() * std::sin(phi2));
   }
 
   /// Compute the transverse mass of a pair of particles
@@ -134,7 +121,7 @@ class FemtoWorldMath
   template <typename T>
   static float getmT(const T& part1, const float mass1, const T& part2, const float mass2)
   {
-    return std::sqrt(std::pow(getkT(part1, mass1, part2, mass2), 2.) + std::pow(0.5 * (mass1 + mass2), 2.));
+    return femtokinematics::getMT(getkT(part1, mass1, part2, mass2), mass1, mass2);
   }
 };
 
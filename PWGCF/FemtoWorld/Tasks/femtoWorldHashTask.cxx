@@ -31,21 +31,21 @@ struct femtoWorldPairHashTask {
   Configurable<std::vector<float>> CfgMultBins{"CfgMultBins", std::vector<float>{0.0f, 20.0f, 40.0f, 60.0f, 80.0f, 100.0f, 200.0f, 99999.f}, "Mixing bins - multiplicity"};
   // Configurable<std::vector<float>> CfgMultBins{"CfgMultBins", std::vector<float>{0.0f, 4.0f, 8.0f, 12.0f, 16.0f, 20.0f, 24.0f, 28.0f, 32.0f, 36.0f, 40.0f, 44.0f, 48.0f, 52.0f, 56.0f, 60.0f, 64.0f, 68.0f, 72.0f, 76.0f, 80.0f, 84.0f, 88.0f, 92.0f, 96.0f, 100.0f, 200.0f, 99999.f}, "Mixing bins - multiplicity"};
 
-  std::vector<float> CastCfgVtxBins, CastCfgMultBins;
+  eventmixing::MixingBinning mixingBinning; ///< z-vertex and multiplicity axes, set up once
 
   Produces<aod::Hashes> hashes;
 
   void init(InitContext&)
   {
-    /// here the Configurables are passed to std::vectors
-    CastCfgVtxBins = (std::vector<float>)CfgVtxBins;
-    CastCfgMultBins = (std::vector<float>)CfgMultBins;
+    /// here the Configurables are passed to the binning
+    mixingBinning.addAxis(CfgVtxBins.value);
+    mixingBinning.addAxis(CfgMultBins.value);
   }
 
   void process(o2::aod::FemtoWorldCollision const& col)
   {
     /// the hash of the collision is computed and written to table
-    hashes(eventmixing::getMixingBin(CastCfgVtxBins, CastCfgMultBins, col.posZ(), col.multV0M()));
+    hashes(eventmixing::getMixingBin(mixingBinning, col.posZ(), col.multV0M()));
   }
 };
 
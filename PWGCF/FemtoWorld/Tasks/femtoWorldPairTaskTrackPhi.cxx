@@ -167,6 +167,7 @@ struct femtoWorldPairTaskTrackPhi {
       }
       sameEventCont.setPair(p1, p2, multCol);
     }
+    sameEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackPhi, processSameEvent, "Enable processing same event", true);
@@ -205,6 +206,7 @@ struct femtoWorldPairTaskTrackPhi {
         mixedEventCont.setPair(p1, p2, collision1.multV0M());
       }
     }
+    mixedEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackPhi, processMixedEvent, "Enable processing mixed events", true);
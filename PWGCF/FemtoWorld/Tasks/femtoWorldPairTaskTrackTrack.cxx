@@ -376,6 +376,7 @@ struct femtoWorldPairTaskTrackTrack {
       }
       sameEventCont.setPair(p1, p2, multCol);
     }
+    sameEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackTrack, processSameEvent, "Enable processing same event", true);
@@ -431,6 +432,7 @@ struct femtoWorldPairTaskTrackTrack {
         mixedEventCont.setPair(p1, p2, collision1.multV0M());
       }
     }
+    mixedEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackTrack, processMixedEvent, "Enable processing mixed events", true);
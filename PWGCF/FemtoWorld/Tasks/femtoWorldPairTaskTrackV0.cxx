@@ -167,6 +167,7 @@ struct femtoWorldPairTaskTrackV0 {
       }
       sameEventCont.setPair(p1, p2, multCol);
     }
+    sameEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackV0, processSameEvent, "Enable processing same event", true);
@@ -205,6 +206,7 @@ struct femtoWorldPairTaskTrackV0 {
         mixedEventCont.setPair(p1, p2, collision1.multV0M());
       }
     }
+    mixedEventCont.flush();
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackV0, processMixedEvent, "Enable processing mixed events", true);
@@ -10,6 +10,14 @@
 // or submit itself to any jurisdiction.
 
 #include "FlowContainer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "TBuffer.h"
+#include "TROOT.h"
 
 ClassImp(FlowContainer);
 
@@ -25,7 +33,11 @@ FlowContainer::FlowContainer() : TNamed("", ""),
                                  fXAxis(0),
                                  fNbinsPt(0),
                                  fbinsPt(0),
-                                 fPropagateErrors(kFALSE){};
+                                 fPropagateErrors(kFALSE),
+                                 fSubBins(),
+                                 fSubStats(),
+                                 fNSubCells(0),
+                                 fSubFilled(kFALSE){};
 FlowContainer::FlowContainer(const char* name) : TNamed(name, name),
                                                  fProf(0),
                                                  fProfRand(0),
@@ -38,12 +50,30 @@ FlowContainer::FlowContainer(const char* name) : TNamed(name, name),
                                                  fXAxis(0),
                                                  fNbinsPt(0),
                                                  fbinsPt(0),
-                                                 fPropagateErrors(kFALSE){};
+                                                 fPropagateErrors(kFALSE),
+                                 fSubBins(),
+                                 fSubStats(),
+                                 fNSubCells(0),
+                                 fSubFilled(kFALSE){};
 FlowContainer::~FlowContainer()
 {
   delete fProf;
   delete fProfRand;
 };
+void FlowContainer::Streamer(TBuffer& R__b)
+{
+  // Subsample sums must be in fProfRand before the container is written
+  if (R__b.IsReading()) {
+    R__b.ReadClassBuffer(FlowContainer::Class(), this);
+    fSubBins.clear();
+    fSubStats.clear();
+    fNSubCells = 0;
+    fSubFilled = kFALSE;
+  } else {
+    FlushSubSamples();
+    R__b.WriteClassBuffer(FlowContainer::Class(), this);
+  }
+};
 void FlowContainer::Initialize(TObjArray* inputList, const o2::framework::AxisSpec axis, int nRandom)
 {
   std::vector<double> multiBins = axis.binEdges;
@@ -145,10 +175,142 @@ int FlowContainer::FillProfile(const char* hname, double multi, double corr, dou
   fProf->Fill(multi, yin, corr, w);
   if (fNRandom) {
     double rnind = rn * fNRandom;
-    ((TProfile2D*)fProfRand->At((int)rnind))->Fill(multi, yin, corr, w);
+    FillSubSample((int)rnind, multi, yin, corr, w);
   };
   return 0;
 };
+void FlowContainer::FillSubSample(int ind, double multi, double y, double corr, double w)
+{
+  // Same as TProfile2D::Fill of the subsample, but into the dense buffer
+  TProfile2D* tarprof = (TProfile2D*)fProfRand->At(ind);
+  if (tarprof->GetZmin() != tarprof->GetZmax()) {
+    tarprof->Fill(multi, y, corr, w);
+    return;
+  };
+  if (tarprof->GetNcells() != fNSubCells) {
+    FlushSubSamples();
+    fNSubCells = tarprof->GetNcells();
+    fSubBins.assign((size_t)fProfRand->GetEntries() * fNSubCells * kSubSums, 0.);
+    fSubStats.assign((size_t)fProfRand->GetEntries() * kSubStats, 0.);
+  };
+  fSubFilled = kTRUE;
+  double* stats = &fSubStats[(size_t)ind * kSubStats];
+  stats[0] += 1;
+  int binx = tarprof->GetXaxis()->FindBin(multi);
+  int biny = tarprof->GetYaxis()->FindBin(y);
+  if (binx < 0 || biny < 0)
+    return;
+  double* sums = &fSubBins[((size_t)ind * fNSubCells + tarprof->GetBin(binx, biny)) * kSubSums];
+  sums[0] += w;
+  sums[1] += w * corr;
+  sums[2] += w * corr * corr;
+  sums[3] += w * w;
+  if (!tarprof->GetStatOverflowsBehaviour() && (binx == 0 || binx > tarprof->GetNbinsX() || biny == 0 || biny > tarprof->GetNbinsY()))
+    return;
+  stats[1] += w;
+  stats[2] += w * w;
+  stats[3] += w * multi;
+  stats[4] += w * multi * multi;
+  stats[5] += w * y;
+  stats[6] += w * y * y;
+  stats[7] += w * multi * y;
+  stats[8] += w * corr;
+  stats[9] += w * corr * corr;
+};
+void FlowContainer::FlushSubSamples()
+{
+  if (!fSubFilled)
+    return;
+  fSubFilled = kFALSE;
+  double lstats[kSubStats - 1];
+  for (int i = 0; i < fProfRand->GetEntries(); i++) {
+    TProfile2D* tarprof = (TProfile2D*)fProfRand->At(i);
+    if (!tarprof->GetBinSumw2()->fN)
+      tarprof->Sumw2();
+    double* sums = &fSubBins[(size_t)i * fNSubCells * kSubSums];
+    double* stats = &fSubStats[(size_t)i * kSubStats];
+    double* farrTarg = tarprof->fArray;
+    double* sumw2Targ = tarprof->GetSumw2()->fArray;
+    double* binsw2Targ = tarprof->GetBinSumw2()->fArray;
+    for (int bin = 0; bin < fNSubCells; bin++, sums += kSubSums) {
+      if (sums[0] == 0 && sums[3] == 0)
+        continue;
+      tarprof->SetBinEntries(bin, tarprof->GetBinEntries(bin) + sums[0]);
+      farrTarg[bin] += sums[1];
+      sumw2Targ[bin] += sums[2];
+      binsw2Targ[bin] += sums[3];
+    };
+    if (stats[0] == 0)
+      continue;
+    tarprof->GetStats(lstats);
+    for (int j = 0; j < kSubStats - 1; j++)
+      lstats[j] += stats[j + 1];
+    tarprof->PutStats(lstats);
+    tarprof->SetEntries(tarprof->GetEntries() + stats[0]);
+  };
+  std::fill(fSubBins.begin(), fSubBins.end(), 0.);
+  std::fill(fSubStats.begin(), fSubStats.end(), 0.);
+};
+bool FlowContainer::AddToSubSamples(TObjArray* inarr)
+{
+  // Adds the subsamples of another container directly to the buffers, if both have the same subsamples and binning
+  if (!fProfRand || inarr->GetEntries() != fProfRand->GetEntries())
+    return kFALSE;
+  for (int i = 0; i < inarr->GetEntries(); i++) {
+    if (strcmp(inarr->At(i)->GetName(), fProfRand->At(i)->GetName()) ||
+        ((TProfile2D*)inarr->At(i))->GetNcells() != ((TProfile2D*)fProfRand->At(i))->GetNcells())
+      return kFALSE;
+  };
+  int lNCells = ((TProfile2D*)fProfRand->At(0))->GetNcells();
+  if (lNCells != fNSubCells) {
+    FlushSubSamples();
+    fNSubCells = lNCells;
+    fSubBins.assign((size_t)fProfRand->GetEntries() * fNSubCells * kSubSums, 0.);
+    fSubStats.assign((size_t)fProfRand->GetEntries() * kSubStats, 0.);
+  };
+  fSubFilled = kTRUE;
+  double lstats[kSubStats - 1];
+  for (int i = 0; i < inarr->GetEntries(); i++) {
+    TProfile2D* inprof = (TProfile2D*)inarr->At(i);
+    double* sums = &fSubBins[(size_t)i * fNSubCells * kSubSums];
+    double* stats = &fSubStats[(size_t)i * kSubStats];
+    double* farrIn = inprof->fArray;
+    double* sumw2In = inprof->GetSumw2()->fArray;
+    double* binsw2In = inprof->GetBinSumw2()->fN ? inprof->GetBinSumw2()->fArray : 0;
+    for (int bin = 0; bin < fNSubCells; bin++, sums += kSubSums) {
+      double lEnt = inprof->GetBinEntries(bin);
+      sums[0] += lEnt;
+      sums[1] += farrIn[bin];
+      sums[2] += sumw2In[bin];
+      sums[3] += binsw2In ? binsw2In[bin] : lEnt;
+    };
+    inprof->GetStats(lstats);
+    stats[0] += inprof->GetEntries();
+    for (int j = 0; j < kSubStats - 1; j++)
+      stats[j + 1] += lstats[j];
+  };
+  return kTRUE;
+};
+void FlowContainer::MergeSubProfiles(TObjArray* tarr)
+{
+  if (AddToSubSamples(tarr))
+    return;
+  FlushSubSamples();
+  if (!fProfRand) {
+    fProfRand = new TObjArray();
+    fProfRand->SetOwner(kTRUE);
+  };
+  for (int i = 0; i < tarr->GetEntries(); i++) {
+    if (!(fProfRand->FindObject(tarr->At(i)->GetName()))) {
+      fProfRand->Add((TProfile2D*)tarr->At(i)->Clone(tarr->At(i)->GetName()));
+      ((TProfile2D*)fProfRand->At(fProfRand->GetEntries() - 1))->SetDirectory(0);
+    } else {
+      TProfile2D* tarprof = (TProfile2D*)fProfRand->FindObject(tarr->At(i)->GetName());
+      if (!ProfileSubset::AddBinArrays(tarprof, (TProfile2D*)tarr->At(i)))
+        tarprof->Add((TProfile2D*)tarr->At(i));
+    };
+  };
+};
 void FlowContainer::OverrideProfileErrors(TProfile2D* inpf)
 {
   int nBinsX = fProf->GetNbinsX();
@@ -189,55 +351,70 @@ Long64_t FlowContainer::Merge(TCollection* collist)
   FlowContainer* l_FC = 0;
   TIter all_FC(collist);
   while ((l_FC = ((FlowContainer*)all_FC()))) {
-    TProfile2D* tpro = GetProfile();
-    TProfile2D* spro = l_FC->GetProfile();
-    if (!tpro) {
-      fProf = (TProfile2D*)spro->Clone(spro->GetName());
-      fProf->SetDirectory(0);
-    } else
-      tpro->Add(spro);
+    MergeContainer(l_FC);
     nmerged++;
-    TObjArray* tarr = l_FC->GetSubProfiles();
-    if (!tarr)
-      continue;
-    if (!fProfRand) {
-      fProfRand = new TObjArray();
-      fProfRand->SetOwner(kTRUE);
-    };
-    for (int i = 0; i < tarr->GetEntries(); i++) {
-      if (!(fProfRand->FindObject(tarr->At(i)->GetName()))) {
-        fProfRand->Add((TProfile2D*)tarr->At(i)->Clone(tarr->At(i)->GetName()));
-        ((TProfile2D*)fProfRand->At(fProfRand->GetEntries() - 1))->SetDirectory(0);
-      } else {
-        ((TProfile2D*)fProfRand->FindObject(tarr->At(i)->GetName()))->Add((TProfile2D*)tarr->At(i));
-      };
-    };
   };
   return nmerged;
 };
-void FlowContainer::ReadAndMerge(const char* filelist)
+void FlowContainer::MergeContainer(FlowContainer* lfc)
 {
-  FILE* flist = fopen(filelist, "r");
-  char str[150];
-  int nFiles = 0;
-  while (fscanf(flist, "%s\n", str) == 1)
-    nFiles++;
-  rewind(flist);
-  if (nFiles == 0) {
-    printf("No files to read!\n");
+  TProfile2D* spro = lfc->GetProfile();
+  if (!spro)
+    return;
+  TProfile2D* tpro = GetProfile();
+  if (!tpro) {
+    fProf = (TProfile2D*)spro->Clone(spro->GetName());
+    fProf->SetDirectory(0);
+  } else if (!ProfileSubset::AddBinArrays(tpro, spro))
+    tpro->Add(spro);
+  TObjArray* tarr = lfc->GetSubProfiles();
+  if (!tarr)
+    return;
+  MergeSubProfiles(tarr);
+};
+void FlowContainer::ReadAndMerge(const char* filelist, int nThreads)
+{
+  // With nThreads > 1, the files are shared between threads, each of them merging its files into its own container,
+  // and the containers of the threads are merged at the end
+  std::vector<std::string> files;
+  std::ifstream flist(filelist);
+  std::string str;
+  while (flist >> str)
+    files.push_back(str);
+  if (files.empty()) {
+    printf("No files to read!
+");
     return;
   };
-  for (int i = 0; i < nFiles; i++) {
-    fscanf(flist, "%s\n", str);
-    TFile* tf = new TFile(str, "READ");
-    if (tf->IsZombie()) {
-      printf("Could not open file %s!\n", str);
+  auto mergeFiles = [&files](FlowContainer* target, size_t first, size_t step) {
+    for (size_t i = first; i < files.size(); i += step) {
+      TFile* tf = TFile::Open(files[i].c_str(), "READ");
+      if (!tf || tf->IsZombie()) {
+        printf("Could not open file %s!\n", files[i].c_str());
+        delete tf;
+        continue;
+      };
+      target->PickAndMerge(tf);
       tf->Close();
-      continue;
+      delete tf;
     };
-    PickAndMerge(tf);
-    tf->Close();
   };
+  nThreads = std::clamp(nThreads, 1, (int)files.size());
+  if (nThreads == 1) {
+    mergeFiles(this, 0, 1);
+    return;
+  };
+  ROOT::EnableThreadSafety();
+  std::vector<std::unique_ptr<FlowContainer>> partials;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nThreads; i++) {
+    partials.push_back(std::make_unique<FlowContainer>(GetName()));
+    threads.emplace_back(mergeFiles, partials.back().get(), i, nThreads);
+  };
+  for (auto& thread : threads)
+    thread.join();
+  for (auto& partial : partials)
+    MergeContainer(partial.get());
 };
 void FlowContainer::PickAndMerge(TFile* tfi)
 {
@@ -246,29 +423,8 @@ void FlowContainer::PickAndMerge(TFile* tfi)
     printf("Could not pick up the %s from %s\n", this->GetName(), tfi->GetName());
     return;
   };
-  TProfile2D* spro = lfc->GetProfile();
-  TProfile2D* tpro = GetProfile();
-  if (!tpro) {
-    fProf = (TProfile2D*)spro->Clone(spro->GetName());
-    fProf->SetDirectory(0);
-  } else
-    tpro->Add(spro);
-  TObjArray* tarr = lfc->GetSubProfiles();
-  if (!tarr) {
-    return;
-  };
-  if (!fProfRand) {
-    fProfRand = new TObjArray();
-    fProfRand->SetOwner(kTRUE);
-  };
-  for (int i = 0; i < tarr->GetEntries(); i++) {
-    if (!(fProfRand->FindObject(tarr->At(i)->GetName()))) {
-      fProfRand->Add((TProfile2D*)tarr->At(i)->Clone(tarr->At(i)->GetName()));
-      ((TProfile2D*)fProfRand->At(fProfRand->GetEntries() - 1))->SetDirectory(0);
-    } else {
-      ((TProfile2D*)fProfRand->FindObject(tarr->At(i)->GetName()))->Add((TProfile2D*)tarr->At(i));
-    };
-  };
+  MergeContainer(lfc);
+  delete lfc;
 };
 bool FlowContainer::OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2)
 {
@@ -283,6 +439,7 @@ bool FlowContainer::OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2)
 }
 bool FlowContainer::OverrideMainWithSub(int ind, bool ExcludeChosen)
 {
+  FlushSubSamples();
   if (!fProfRand) {
     printf("Cannot override main profile with a randomized one. Random profile array does not exist.\n");
     return kFALSE;
@@ -315,6 +472,7 @@ bool FlowContainer::OverrideMainWithSub(int ind, bool ExcludeChosen)
 };
 bool FlowContainer::RandomizeProfile(int nSubsets)
 {
+  FlushSubSamples();
   if (!fProfRand) {
     printf("Cannot randomize profile, random array does not exist.\n");
     return kFALSE;
@@ -27,6 +27,7 @@
 #include "TAxis.h"
 #include "ProfileSubset.h"
 #include "Framework/HistogramSpec.h"
+#include <vector>
 
 class FlowContainer : public TNamed
 {
@@ -52,13 +53,19 @@ class FlowContainer : public TNamed
   int FillProfile(const char* hname, double multi, double y, double w, double rn);
   TProfile2D* GetProfile() { return fProf; };
   void OverrideProfileErrors(TProfile2D* inpf);
-  void ReadAndMerge(const char* infile);
+  void ReadAndMerge(const char* infile, int nThreads = 1); // nThreads > 1: files are read concurrently
   void PickAndMerge(TFile* tfi);
+  void MergeContainer(FlowContainer* lfc); // Add the main profile and the subsamples of another container
   bool OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2);
   bool OverrideMainWithSub(int subind, bool ExcludeChosen);
   bool RandomizeProfile(int nSubsets = 0);
   bool CreateStatisticsProfile(StatisticsType StatType, int arg);
-  TObjArray* GetSubProfiles() { return fProfRand; };
+  TObjArray* GetSubProfiles()
+  {
+    FlushSubSamples();
+    return fProfRand;
+  };
+  void FlushSubSamples(); // Write the accumulated subsample sums to fProfRand
   Long64_t Merge(TCollection* collist);
   void SetIDName(TString newname); //! do not store
   void SetPtRebin(int newval) { fPtRebin = newval; };
@@ -162,6 +169,16 @@ class FlowContainer : public TNamed
   double* fbinsPt;       //! Do not store; stored in fXAxis
   bool fPropagateErrors; //! do not store
   TProfile* GetRefFlowProfile(const char* order, double m1 = -1, double m2 = -1);
+  // Subsamples are filled into one dense buffer instead of their TProfile2D, and written to fProfRand only when needed
+  enum { kSubSums = 4,     // per bin: sum w, sum w*z, sum w*z^2, sum w^2
+         kSubStats = 10 }; // per subsample: entries and the 9 sums of TProfile2D::GetStats
+  std::vector<double> fSubBins;  //! do not store; kSubSums values per bin, fNSubCells bins per subsample
+  std::vector<double> fSubStats; //! do not store; kSubStats values per subsample
+  int fNSubCells;                //! do not store; number of bins of a subsample, including under/overflows
+  bool fSubFilled;               //! do not store; buffers hold sums not yet written to fProfRand
+  void FillSubSample(int ind, double multi, double y, double corr, double w);
+  bool AddToSubSamples(TObjArray* inarr);
+  void MergeSubProfiles(TObjArray* inarr);
   ClassDef(FlowContainer, 2);
 };
 
@@ -103,11 +103,40 @@ void GFW::Fill(double eta, int ptin, double phi, double weight, int mask, double
     CreateRegions();
   if (!fInitialized)
     return;
+  if (!fCorrCache.empty())
+    fCorrCache.clear(); // Q-vectors change
   for (int i = 0; i < (int)fRegions.size(); ++i) {
     if (fRegions.at(i).EtaMin < eta && fRegions.at(i).EtaMax > eta && (fRegions.at(i).BitMask & mask))
       fCumulants.at(i).FillArray(eta, ptin, phi, weight, SecondWeight);
   };
 };
+void GFW::Fill(int nPart, const double* eta, const int* ptin, const double* phi, const double* weight, const int* mask, const double* secondWeight)
+{
+  if (!fInitialized)
+    CreateRegions();
+  if (!fInitialized)
+    return;
+  if (!fCorrCache.empty())
+    fCorrCache.clear(); // Q-vectors change
+  fSelPt.resize(nPart);
+  fSelPhi.resize(nPart);
+  fSelWeight.resize(nPart);
+  fSelSecondWeight.resize(nPart);
+  for (int i = 0; i < (int)fRegions.size(); ++i) {
+    int nSel = 0;
+    for (int j = 0; j < nPart; ++j) {
+      if (fRegions.at(i).EtaMin < eta[j] && fRegions.at(i).EtaMax > eta[j] && (fRegions.at(i).BitMask & mask[j])) {
+        fSelPt[nSel] = ptin[j];
+        fSelPhi[nSel] = phi[j];
+        fSelWeight[nSel] = weight[j];
+        fSelSecondWeight[nSel] = secondWeight ? secondWeight[j] : -1;
+        nSel++;
+      };
+    };
+    if (nSel)
+      fCumulants.at(i).FillArray(nSel, nullptr, fSelPt.data(), fSelPhi.data(), fSelWeight.data(), fSelSecondWeight.data());
+  };
+};
 TComplex GFW::TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant* r1, GFWCumulant* r2, GFWCumulant* r3)
 {
   TComplex part1 = r1->Vec(n1, p1, ptbin);
@@ -125,6 +154,27 @@ TComplex GFW::RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* q
 };
 
 TComplex GFW::RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows)
+{
+  // Single Q-vectors are cheaper to get directly than through the cache
+  if (hars.size() < 2)
+    return RecursiveCorrUncached(qpoi, qref, qol, ptbin, hars, pows);
+  // The same sub-terms appear in many correlators and in the recursion: calculate each of them once per event
+  fCorrKey.clear();
+  fCorrKey.push_back(CumulantIndex(qpoi));
+  fCorrKey.push_back(CumulantIndex(qref));
+  fCorrKey.push_back(CumulantIndex(qol));
+  fCorrKey.push_back(ptbin);
+  fCorrKey.insert(fCorrKey.end(), hars.begin(), hars.end());
+  fCorrKey.insert(fCorrKey.end(), pows.begin(), pows.end());
+  auto cached = fCorrCache.find(fCorrKey);
+  if (cached != fCorrCache.end())
+    return cached->second;
+  vector<int> key = fCorrKey; // fCorrKey is reused by the recursion
+  TComplex val = RecursiveCorrUncached(qpoi, qref, qol, ptbin, hars, pows);
+  fCorrCache.emplace(std::move(key), val);
+  return val;
+};
+TComplex GFW::RecursiveCorrUncached(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows)
 {
   if ((pows.at(0) != 1) && qol)
     qpoi = qol; // if the power of POI is not unity, then always use overlap (if defined).
@@ -172,6 +222,7 @@ void GFW::Clear()
 {
   for (auto ptr = fCumulants.begin(); ptr != fCumulants.end(); ++ptr)
     ptr->ResetQs();
+  fCorrCache.clear();
   fCalculatedNames.clear();
   fCalculatedQs.clear();
 };
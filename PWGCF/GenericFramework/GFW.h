@@ -13,6 +13,7 @@
 #define GFW__H
 #include "GFWCumulant.h"
 #include <vector>
+#include <map>
 #include <utility>
 #include <algorithm>
 #include "TString.h"
@@ -69,6 +70,8 @@ class GFW
   void AddRegion(TString refName, int lNhar, int* lNparVec, double lEtaMin, double lEtaMax, int lNpT = 1, int BitMask = 1);
   int CreateRegions();
   void Fill(double eta, int ptin, double phi, double weight, int mask, double secondWeight = -1);
+  // Batch fill of nPart particles, secondWeight can be null if not used
+  void Fill(int nPart, const double* eta, const int* ptin, const double* phi, const double* weight, const int* mask, const double* secondWeight = nullptr);
   void Clear(); // { for(auto ptr = fCumulants.begin(); ptr!=fCumulants.end(); ++ptr) ptr->ResetQs(); };
   GFWCumulant GetCumulant(int index) { return fCumulants.at(index); };
   TComplex Calculate(TString config, bool SetHarmsToZero = kFALSE);
@@ -82,6 +85,11 @@ class GFW
   TComplex TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant*, GFWCumulant*, GFWCumulant*);
   TComplex RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows); // POI, Ref. flow, overlapping region
   TComplex RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars);                    // POI, Ref. flow, overlapping region
+  TComplex RecursiveCorrUncached(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows);
+  // Correlators and sub-terms calculated since the last change of the Q-vectors, keyed by (regions, pt bin, harmonics, powers)
+  std::map<vector<int>, TComplex> fCorrCache; //!
+  vector<int> fCorrKey;                       //! lookup key, kept to avoid allocations
+  int CumulantIndex(GFWCumulant* cumulant) { return cumulant ? (int)(cumulant - fCumulants.data()) : -1; };
   // Deprecated and not used (for now):
   void AddRegion(Region inreg) { fRegions.push_back(inreg); };
   Region GetRegion(int index) { return fRegions.at(index); };
@@ -96,5 +104,10 @@ class GFW
   TComplex CalculateSingle(TString config);
 
   bool SetHarmonicsToZero(TString& instr);
+  // Particles of the batch fill selected for one region
+  vector<int> fSelPt;
+  vector<double> fSelPhi;
+  vector<double> fSelWeight;
+  vector<double> fSelSecondWeight;
 };
 #endif
\ No newline at end of file
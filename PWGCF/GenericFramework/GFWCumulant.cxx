@@ -10,14 +10,18 @@
 // or submit itself to any jurisdiction.
 
 #include "GFWCumulant.h"
+#include <algorithm>
 
-GFWCumulant::GFWCumulant() : fQvector(0),
+GFWCumulant::GFWCumulant() : fQRe(),
+                             fQIm(),
+                             fHarOffset(),
+                             fPtStride(0),
                              fUsed(kBlank),
                              fNEntries(-1),
                              fN(1),
                              fPow(1),
                              fPt(1),
-                             fFilledPts(0),
+                             fFilledPts(),
                              fInitialized(kFALSE){};
 
 GFWCumulant::~GFWCumulant(){
@@ -33,53 +37,133 @@ void GFWCumulant::FillArray(double eta, int ptin, double phi, double weight, dou
   else if (ptin < 0 || ptin >= fPt)
     return;
   fFilledPts[ptin] = kTRUE;
+  // cos(n phi) and sin(n phi) from the Chebyshev recurrence, starting from n = 0
+  double lCos1 = TMath::Cos(phi);
+  double lSin1 = TMath::Sin(phi);
+  double lCos = 1, lSin = 0, lCosPrev = lCos1, lSinPrev = -lSin1;
+  // If second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
+  // this is important when POIs are a subset of REFs and have different weights than REFs
+  double lHigherWeight = (SecondWeight > 0) ? SecondWeight : weight;
+  double* qre = fQRe.data() + ptin * fPtStride;
+  double* qim = fQIm.data() + ptin * fPtStride;
   for (int lN = 0; lN < fN; lN++) {
-    double lSin = TMath::Sin(lN * phi); // No need to recalculate for each power
-    double lCos = TMath::Cos(lN * phi); // No need to recalculate for each power
+    double lPrefactor = 1;
     for (int lPow = 0; lPow < PW(lN); lPow++) {
-      double lPrefactor = 0;
-      // Dont calculate it twice; multiplication is cheaper that power
-      // Also, if second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
-      // this is important when POIs are a subset of REFs and have different weights than REFs
-      if (SecondWeight > 0 && lPow > 1)
-        lPrefactor = TMath::Power(SecondWeight, lPow - 1) * weight;
-      else
-        lPrefactor = TMath::Power(weight, lPow);
-      double qsin = lPrefactor * lSin;
-      double qcos = lPrefactor * lCos;
-      fQvector[ptin][lN][lPow](fQvector[ptin][lN][lPow].Re() + qcos, fQvector[ptin][lN][lPow].Im() + qsin); //+=TComplex(qcos,qsin);
+      qre[fHarOffset[lN] + lPow] += lPrefactor * lCos;
+      qim[fHarOffset[lN] + lPow] += lPrefactor * lSin;
+      lPrefactor *= (lPow == 0) ? weight : lHigherWeight;
     };
+    double lCosNext = 2 * lCos1 * lCos - lCosPrev;
+    double lSinNext = 2 * lCos1 * lSin - lSinPrev;
+    lCosPrev = lCos;
+    lSinPrev = lSin;
+    lCos = lCosNext;
+    lSin = lSinNext;
   };
   Inc();
 };
-void GFWCumulant::ResetQs()
+void GFWCumulant::FillArray(int nPart, const double* eta, const int* ptin, const double* phi, const double* weight, const double* SecondWeight)
 {
-  if (!fNEntries)
-    return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
-  for (int i = 0; i < fPt; i++) {
-    fFilledPts[i] = kFALSE;
-    for (int lN = 0; lN < fN; lN++) {
-      for (int lPow = 0; lPow < PW(lN); lPow++) {
-        fQvector[i][lN][lPow](0., 0.);
+  if (!fInitialized)
+    CreateComplexVectorArray(1, 1, 1);
+  // Select the particles in range, keeping their pt bin and weights
+  fBatchPt.resize(nPart);
+  fBatchW.resize(nPart);
+  fBatchW2.resize(nPart);
+  for (int i = 0; i < 3; i++) {
+    fCos[i].resize(nPart);
+    fSin[i].resize(nPart);
+  };
+  fCos1.resize(nPart);
+  fSin1.resize(nPart);
+  fPref.resize(nPart);
+  int nAcc = 0;
+  for (int i = 0; i < nPart; i++) {
+    int lPt = (fPt == 1) ? 0 : ptin[i];
+    if (lPt < 0 || lPt >= fPt)
+      continue;
+    fFilledPts[lPt] = kTRUE;
+    fBatchPt[nAcc] = lPt;
+    fBatchW[nAcc] = weight[i];
+    fBatchW2[nAcc] = (SecondWeight && SecondWeight[i] > 0) ? SecondWeight[i] : weight[i];
+    fCos1[nAcc] = TMath::Cos(phi[i]);
+    fSin1[nAcc] = TMath::Sin(phi[i]);
+    nAcc++;
+  };
+  if (fNEntries < 0)
+    fNEntries = 0;
+  fNEntries += nAcc;
+  if (!nAcc)
+    return;
+  const double* lCos1 = fCos1.data();
+  const double* lSin1 = fSin1.data();
+  double* lPref = fPref.data();
+  // Harmonic n is computed in fCos/fSin[n%3] from the two previous ones: cos(n phi) = 2 cos(phi) cos((n-1) phi) - cos((n-2) phi)
+  for (int lN = 0; lN < fN; lN++) {
+    double* lCos = fCos[lN % 3].data();
+    double* lSin = fSin[lN % 3].data();
+    if (lN == 0) {
+      for (int i = 0; i < nAcc; i++) {
+        lCos[i] = 1;
+        lSin[i] = 0;
+      };
+    } else if (lN == 1) {
+      for (int i = 0; i < nAcc; i++) {
+        lCos[i] = lCos1[i];
+        lSin[i] = lSin1[i];
+      };
+    } else {
+      const double* lCosM1 = fCos[(lN - 1) % 3].data();
+      const double* lSinM1 = fSin[(lN - 1) % 3].data();
+      const double* lCosM2 = fCos[(lN - 2) % 3].data();
+      const double* lSinM2 = fSin[(lN - 2) % 3].data();
+      for (int i = 0; i < nAcc; i++) {
+        lCos[i] = 2 * lCos1[i] * lCosM1[i] - lCosM2[i];
+        lSin[i] = 2 * lCos1[i] * lSinM1[i] - lSinM2[i];
       };
     };
+    for (int i = 0; i < nAcc; i++)
+      lPref[i] = 1;
+    for (int lPow = 0; lPow < PW(lN); lPow++) {
+      int lInd = fHarOffset[lN] + lPow;
+      if (fPt == 1) {
+        // Single pt bin: plain reductions over the particles
+        double lRe = 0, lIm = 0;
+        for (int i = 0; i < nAcc; i++) {
+          lRe += lPref[i] * lCos[i];
+          lIm += lPref[i] * lSin[i];
+        };
+        fQRe[lInd] += lRe;
+        fQIm[lInd] += lIm;
+      } else {
+        for (int i = 0; i < nAcc; i++) {
+          fQRe[fBatchPt[i] * fPtStride + lInd] += lPref[i] * lCos[i];
+          fQIm[fBatchPt[i] * fPtStride + lInd] += lPref[i] * lSin[i];
+        };
+      };
+      const double* lW = (lPow == 0) ? fBatchW.data() : fBatchW2.data();
+      for (int i = 0; i < nAcc; i++)
+        lPref[i] *= lW[i];
+    };
   };
+};
+void GFWCumulant::ResetQs()
+{
+  if (!fNEntries)
+    return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
+  std::fill(fFilledPts.begin(), fFilledPts.end(), kFALSE);
+  std::fill(fQRe.begin(), fQRe.end(), 0.);
+  std::fill(fQIm.begin(), fQIm.end(), 0.);
   fNEntries = 0;
 };
 void GFWCumulant::DestroyComplexVectorArray()
 {
   if (!fInitialized)
     return;
-  for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      delete[] fQvector[i][l_n];
-    };
-  };
-  for (int i = 0; i < fPt; i++) {
-    delete[] fQvector[i];
-  };
-  delete[] fQvector;
-  delete[] fFilledPts;
+  fQRe.clear();
+  fQIm.clear();
+  fHarOffset.clear();
+  fFilledPts.clear();
   fInitialized = kFALSE;
   fNEntries = -1;
 };
@@ -98,17 +182,16 @@ void GFWCumulant::CreateComplexVectorArrayVarPower(int N, vector<int> PowVec, in
   fN = N;
   fPow = 0;
   fPt = Pt;
-  fFilledPts = new bool[Pt];
+  fFilledPts.assign(Pt, kFALSE);
   fPowVec = PowVec;
-  fQvector = new TComplex**[fPt];
-  for (int i = 0; i < fPt; i++) {
-    fQvector[i] = new TComplex*[fN];
-  };
+  fHarOffset.resize(fN);
+  fPtStride = 0;
   for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      fQvector[i][l_n] = new TComplex[PW(l_n)];
-    };
+    fHarOffset[l_n] = fPtStride;
+    fPtStride += PW(l_n);
   };
+  fQRe.assign(fPt * fPtStride, 0.);
+  fQIm.assign(fPt * fPtStride, 0.);
   ResetQs();
   fInitialized = kTRUE;
 };
@@ -119,6 +202,6 @@ TComplex GFWCumulant::Vec(int n, int p, int ptbin)
   if (ptbin >= fPt || ptbin < 0)
     ptbin = 0;
   if (n >= 0)
-    return fQvector[ptbin][n][p];
-  return TComplex::Conjugate(fQvector[ptbin][-n][p]);
+    return TComplex(fQRe[QIndex(ptbin, n, p)], fQIm[QIndex(ptbin, n, p)]);
+  return TComplex(fQRe[QIndex(ptbin, -n, p)], -fQIm[QIndex(ptbin, -n, p)]);
 };
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "TNamed.h"
 #include "TMath.h"
 #include "TAxis.h"
+#include <vector>
 using std::vector;
 class GFWCumulant
 {
@@ -23,6 +24,8 @@ class GFWCumulant
   ~GFWCumulant();
   void ResetQs();
   void FillArray(double eta, int ptin, double phi, double weight = 1, double SecondWeight = -1);
+  // Batch fill of nPart particles: SecondWeight can be null (no second weight), eta is not used (as above)
+  void FillArray(int nPart, const double* eta, const int* ptin, const double* phi, const double* weight, const double* SecondWeight = nullptr);
   enum UsedFlags_t { kBlank = 0,
                      kFull = 1,
                      kPt = 2 };
@@ -34,7 +37,12 @@ class GFWCumulant
   void Inc() { fNEntries++; };
   int GetN() { return fNEntries; };
   // protected:
-  TComplex*** fQvector;
+  // Q-vectors stored as separate real and imaginary arrays, index [ptbin][harmonic][power] flattened by QIndex()
+  vector<double> fQRe;
+  vector<double> fQIm;
+  vector<int> fHarOffset; //! Offset of each harmonic in a pt bin
+  int fPtStride;          //! Number of Q-vectors per pt bin
+  int QIndex(int ptbin, int n, int p) const { return ptbin * fPtStride + fHarOffset[n] + p; };
   unsigned int fUsed;
   int fNEntries;
   // Q-vectors. Could be done recursively, but maybe defining each one of them explicitly is easier to read
@@ -43,7 +51,7 @@ class GFWCumulant
   int fPow;                              //! Power
   vector<int> fPowVec;                   //! Powers array
   int fPt;                               //! fPt bins
-  bool* fFilledPts;
+  vector<bool> fFilledPts;
   bool fInitialized; // Arrays are initialized
   void CreateComplexVectorArray(int N = 1, int P = 1, int Pt = 1);
   void CreateComplexVectorArrayVarPower(int N = 1, vector<int> Pvec = {1}, int Pt = 1);
@@ -51,10 +59,21 @@ class GFWCumulant
   void DestroyComplexVectorArray();
   bool IsPtBinFilled(int ptb)
   {
-    if (!fFilledPts)
+    if (ptb < 0 || ptb >= (int)fFilledPts.size())
       return kFALSE;
     return fFilledPts[ptb];
   };
+
+ private:
+  // Scratch arrays of the batch fill, one value per accepted particle
+  vector<int> fBatchPt;    //!
+  vector<double> fBatchW;  //!
+  vector<double> fBatchW2; //!
+  vector<double> fCos[3];  //! cos(n phi) for the harmonics n, n-1, n-2
+  vector<double> fSin[3];  //! sin(n phi) for the harmonics n, n-1, n-2
+  vector<double> fCos1;    //! cos(phi)
+  vector<double> fSin1;    //! sin(phi)
+  vector<double> fPref;    //! weight prefactor of the current power
 };
 
 #endif
\ No newline at end of file
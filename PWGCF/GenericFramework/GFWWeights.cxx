@@ -10,7 +10,48 @@
 // or submit itself to any jurisdiction.
 
 #include "GFWWeights.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "TList.h"
 #include "TMath.h"
+#include "TROOT.h"
+void GFWWeightsLookup::Build(TH3D* inh, bool useFloat)
+{
+  Clear();
+  TAxis* ax[] = {inh->GetXaxis(), inh->GetYaxis(), inh->GetZaxis()};
+  int stride = 1;
+  for (int i = 0; i < 3; i++) {
+    fAxes[i].fNbins = ax[i]->GetNbins();
+    fAxes[i].fMin = ax[i]->GetXmin();
+    fAxes[i].fMax = ax[i]->GetXmax();
+    if (ax[i]->GetXbins()->fN)
+      fAxes[i].fEdges.assign(ax[i]->GetXbins()->fArray, ax[i]->GetXbins()->fArray + ax[i]->GetXbins()->fN);
+    stride *= fAxes[i].fNbins + 2;
+    fAxes[i].fStride = stride;
+  };
+  fUseFloat = useFloat;
+  if (fUseFloat)
+    fWeightsF.resize(stride);
+  else
+    fWeights.resize(stride);
+  for (int bin = 0; bin < stride; bin++) { // same bin numbering as TH3
+    double weight = inh->GetBinContent(bin);
+    weight = (weight != 0) ? 1. / weight : 1;
+    if (fUseFloat)
+      fWeightsF[bin] = weight;
+    else
+      fWeights[bin] = weight;
+  };
+};
+void GFWWeightsLookup::Clear()
+{
+  for (int i = 0; i < 3; i++)
+    fAxes[i].fEdges.clear();
+  fWeights.clear();
+  fWeightsF.clear();
+};
 GFWWeights::GFWWeights() : fDataFilled(kFALSE),
                            fMCFilled(kFALSE),
                            fW_data(0),
@@ -20,7 +61,10 @@ GFWWeights::GFWWeights() : fDataFilled(kFALSE),
                            fIntEff(0),
                            fAccInt(0),
                            fNbinsPt(0),
-                           fbinsPt(0){};
+                           fbinsPt(0),
+                           fFloatLookup(kFALSE),
+                           fNUALookup(),
+                           fNUELookup(){};
 GFWWeights::~GFWWeights()
 {
   delete fW_data;
@@ -133,25 +177,17 @@ double GFWWeights::GetNUA(double phi, double eta, double vz)
 {
   if (!fAccInt)
     CreateNUA();
-  int xind = fAccInt->GetXaxis()->FindBin(phi);
-  int etaind = fAccInt->GetYaxis()->FindBin(eta);
-  int vzind = fAccInt->GetZaxis()->FindBin(vz);
-  double weight = fAccInt->GetBinContent(xind, etaind, vzind);
-  if (weight != 0)
-    return 1. / weight;
-  return 1;
+  if (!fNUALookup.IsBuilt())
+    return 1;
+  return fNUALookup.Get(phi, eta, vz);
 }
 double GFWWeights::GetNUE(double pt, double eta, double vz)
 {
   if (!fEffInt)
     CreateNUE();
-  int xind = fEffInt->GetXaxis()->FindBin(pt);
-  int etaind = fEffInt->GetYaxis()->FindBin(eta);
-  int vzind = fEffInt->GetZaxis()->FindBin(vz);
-  double weight = fEffInt->GetBinContent(xind, etaind, vzind);
-  if (weight != 0)
-    return 1. / weight;
-  return 1;
+  if (!fNUELookup.IsBuilt())
+    return 1;
+  return fNUELookup.Get(pt, eta, vz);
 }
 double GFWWeights::FindMax(TH3D* inh, int& ix, int& iy, int& iz)
 {
@@ -225,6 +261,7 @@ void GFWWeights::CreateNUA(bool IntegrateOverCentAndPt)
       fAccInt->GetZaxis()->SetRange(1, fAccInt->GetNbinsZ());
     };
     fAccInt->GetYaxis()->SetRange(1, fAccInt->GetNbinsY());
+    fNUALookup.Build(fAccInt, fFloatLookup);
     return;
   };
 };
@@ -266,21 +303,12 @@ void GFWWeights::CreateNUE(bool IntegrateOverCentrality)
     den->RebinZ(5);
     fEffInt = (TH3D*)num->Clone("Efficiency_Integrated");
     fEffInt->Divide(den);
+    fNUELookup.Build(fEffInt, fFloatLookup);
     return;
   };
 };
-void GFWWeights::ReadAndMerge(TString filelinks, TString listName, bool addData, bool addRec, bool addGen)
+void GFWWeights::CreateArrays(bool addData, bool addRec, bool addGen)
 {
-  FILE* flist = fopen(filelinks.Data(), "r");
-  char str[150];
-  int nFiles = 0;
-  while (fscanf(flist, "%s\n", str) == 1)
-    nFiles++;
-  rewind(flist);
-  if (nFiles == 0) {
-    printf("No files to read!\n");
-    return;
-  };
   if (!fW_data && addData) {
     fW_data = new TObjArray();
     fW_data->SetName("Weights_Data");
@@ -296,31 +324,69 @@ void GFWWeights::ReadAndMerge(TString filelinks, TString listName, bool addData,
     fW_mcgen->SetName("Weights_MCGen");
     fW_mcgen->SetOwner(kTRUE);
   };
-  TFile* tf = 0;
-  for (int i = 0; i < nFiles; i++) {
-    fscanf(flist, "%s\n", str);
-    tf = new TFile(str, "READ");
-    if (tf->IsZombie()) {
-      printf("Could not open file %s!\n", str);
-      tf->Close();
-      continue;
-    };
-    TList* tl = (TList*)tf->Get(listName.Data());
-    GFWWeights* tw = (GFWWeights*)tl->FindObject(this->GetName());
-    if (!tw) {
-      printf("Could not fetch weights object from %s\n", str);
-      tf->Close();
-      continue;
+};
+void GFWWeights::MergeWeights(GFWWeights* lw, bool addData, bool addRec, bool addGen)
+{
+  CreateArrays(addData, addRec, addGen);
+  fDataFilled |= addData && lw->IsDataFilled();
+  fMCFilled |= (addRec || addGen) && lw->IsMCFilled();
+  if (addData)
+    AddArray(fW_data, lw->GetDataArray());
+  if (addRec)
+    AddArray(fW_mcrec, lw->GetRecArray());
+  if (addGen)
+    AddArray(fW_mcgen, lw->GetGenArray());
+};
+void GFWWeights::ReadAndMerge(TString filelinks, TString listName, bool addData, bool addRec, bool addGen, int nThreads)
+{
+  // With nThreads > 1, the files are shared between threads, each of them merging its files into its own weights,
+  // and the weights of the threads are merged at the end
+  std::vector<std::string> files;
+  std::ifstream flist(filelinks.Data());
+  std::string str;
+  while (flist >> str)
+    files.push_back(str);
+  if (files.empty()) {
+    printf("No files to read!\n");
+    return;
+  };
+  CreateArrays(addData, addRec, addGen);
+  auto mergeFiles = [&](GFWWeights* target, size_t first, size_t step) {
+    for (size_t i = first; i < files.size(); i += step) {
+      std::unique_ptr<TFile> tf(TFile::Open(files[i].c_str(), "READ"));
+      if (!tf || tf->IsZombie()) {
+        printf("Could not open file %s!\n", files[i].c_str());
+        continue;
+      };
+      std::unique_ptr<TList> tl((TList*)tf->Get(listName.Data()));
+      if (tl)
+        tl->SetOwner(kTRUE);
+      GFWWeights* tw = tl ? (GFWWeights*)tl->FindObject(GetName()) : 0;
+      if (!tw) {
+        printf("Could not fetch weights object from %s\n", files[i].c_str());
+        continue;
+      };
+      target->MergeWeights(tw, addData, addRec, addGen);
     };
-    if (addData)
-      AddArray(fW_data, tw->GetDataArray());
-    if (addRec)
-      AddArray(fW_mcrec, tw->GetRecArray());
-    if (addGen)
-      AddArray(fW_mcgen, tw->GetGenArray());
-    tf->Close();
-    delete tw;
   };
+  nThreads = std::clamp(nThreads, 1, (int)files.size());
+  if (nThreads == 1) {
+    mergeFiles(this, 0, 1);
+    return;
+  };
+  ROOT::EnableThreadSafety();
+  std::vector<std::unique_ptr<GFWWeights>> partials;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nThreads; i++) {
+    partials.push_back(std::make_unique<GFWWeights>());
+    partials.back()->SetName(GetName());
+    partials.back()->CreateArrays(addData, addRec, addGen);
+    threads.emplace_back(mergeFiles, partials.back().get(), i, nThreads);
+  };
+  for (auto& thread : threads)
+    thread.join();
+  for (auto& partial : partials)
+    MergeWeights(partial.get(), addData, addRec, addGen);
 };
 void GFWWeights::AddArray(TObjArray* targ, TObjArray* sour)
 {
@@ -348,31 +414,17 @@ void GFWWeights::OverwriteNUA()
   delete trash;
   fW_data->Add((TH3D*)fAccInt->Clone(ts.Data()));
   delete fAccInt;
+  fAccInt = 0;
+  fNUALookup.Clear();
 }
 Long64_t GFWWeights::Merge(TCollection* collist)
 {
   Long64_t nmerged = 0;
-  if (!fW_data) {
-    fW_data = new TObjArray();
-    fW_data->SetName("Weights_Data");
-    fW_data->SetOwner(kTRUE);
-  };
-  if (!fW_mcrec) {
-    fW_mcrec = new TObjArray();
-    fW_mcrec->SetName("Weights_MCRec");
-    fW_mcrec->SetOwner(kTRUE);
-  };
-  if (!fW_mcgen) {
-    fW_mcgen = new TObjArray();
-    fW_mcgen->SetName("Weights_MCGen");
-    fW_mcgen->SetOwner(kTRUE);
-  };
+  CreateArrays(kTRUE, kTRUE, kTRUE);
   GFWWeights* l_w = 0;
   TIter all_w(collist);
   while ((l_w = ((GFWWeights*)all_w()))) {
-    AddArray(fW_data, l_w->GetDataArray());
-    AddArray(fW_mcrec, l_w->GetRecArray());
-    AddArray(fW_mcgen, l_w->GetGenArray());
+    MergeWeights(l_w, kTRUE, kTRUE, kTRUE);
     nmerged++;
   };
   return nmerged;
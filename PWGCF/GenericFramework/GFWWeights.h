@@ -19,6 +19,48 @@
 #include "TFile.h"
 #include "TCollection.h"
 #include "TString.h"
+#include <algorithm>
+#include <vector>
+
+// Flattened table of the inverse bin contents of a TH3D (1 for empty bins), for weight lookups without FindBin.
+// Bins are found as TAxis::FindBin does, with arithmetic for uniform axes. The table is read-only once built,
+// so a const table can be shared between threads.
+class GFWWeightsLookup
+{
+ public:
+  GFWWeightsLookup() : fUseFloat(kFALSE){};
+  void Build(TH3D* inh, bool useFloat = kFALSE);
+  void Clear();
+  bool IsBuilt() const { return !fWeights.empty() || !fWeightsF.empty(); };
+  double Get(double x, double y, double z) const
+  {
+    int bin = fAxes[0].FindBin(x) + fAxes[0].fStride * fAxes[1].FindBin(y) + fAxes[1].fStride * fAxes[2].FindBin(z);
+    return fUseFloat ? fWeightsF[bin] : fWeights[bin];
+  };
+
+ private:
+  struct Axis {
+    int fNbins;
+    int fStride; // step of the table index for one bin of the next axis
+    double fMin;
+    double fMax;
+    std::vector<double> fEdges; // empty for uniform axes
+    int FindBin(double x) const
+    {
+      if (x < fMin)
+        return 0;
+      if (!(x < fMax))
+        return fNbins + 1;
+      if (fEdges.empty())
+        return 1 + static_cast<int>(fNbins * (x - fMin) / (fMax - fMin));
+      return std::upper_bound(fEdges.begin(), fEdges.end(), x) - fEdges.begin();
+    };
+  };
+  Axis fAxes[3];
+  bool fUseFloat;
+  std::vector<double> fWeights;
+  std::vector<float> fWeightsF;
+};
 
 class GFWWeights : public TNamed
 {
@@ -39,12 +81,18 @@ class GFWWeights : public TNamed
   TObjArray* GetDataArray() { return fW_data; };
   void CreateNUA(bool IntegrateOverCentAndPt = kTRUE);
   void CreateNUE(bool IntegrateOverCentrality = kTRUE);
+  void SetFloatLookup(bool newval) { fFloatLookup = newval; }; // store the lookup tables in single precision
+  const GFWWeightsLookup& GetNUALookup() const { return fNUALookup; };
+  const GFWWeightsLookup& GetNUELookup() const { return fNUELookup; };
+  TH3D* GetNUAMap() { return fAccInt; }; // NUA map of CreateNUA, the input of the NUA lookup
+  TH3D* GetNUEMap() { return fEffInt; }; // NUE map of CreateNUE, the input of the NUE lookup
   TH1D* GetIntegratedEfficiencyHist();
   bool CalculateIntegratedEff();
   double GetIntegratedEfficiency(double pt);
   void SetDataFilled(bool newval) { fDataFilled = newval; };
   void SetMCFilled(bool newval) { fMCFilled = newval; };
-  void ReadAndMerge(TString filelinks, TString listName = "OutputList", bool addData = kTRUE, bool addRec = kTRUE, bool addGen = kTRUE);
+  void ReadAndMerge(TString filelinks, TString listName = "OutputList", bool addData = kTRUE, bool addRec = kTRUE, bool addGen = kTRUE, int nThreads = 1); // nThreads > 1: files are read concurrently
+  void MergeWeights(GFWWeights* lw, bool addData = kTRUE, bool addRec = kTRUE, bool addGen = kTRUE);                                                      // Add the histograms of other weights
   void SetPtBins(int Nbins, double* bins);
   Long64_t Merge(TCollection* collist);
   void RebinNUA(int nX = 1, int nY = 2, int nZ = 5);
@@ -58,12 +106,16 @@ class GFWWeights : public TNamed
   TObjArray* fW_data;
   TObjArray* fW_mcrec;
   TObjArray* fW_mcgen;
-  TH3D* fEffInt;   //!
-  TH1D* fIntEff;   //!
-  TH3D* fAccInt;   //!
-  int fNbinsPt;    //! do not store
-  double* fbinsPt; //! do not store
+  TH3D* fEffInt;               //!
+  TH1D* fIntEff;               //!
+  TH3D* fAccInt;               //!
+  int fNbinsPt;                //! do not store
+  double* fbinsPt;             //! do not store
+  bool fFloatLookup;           //! do not store
+  GFWWeightsLookup fNUALookup; //! built by CreateNUA
+  GFWWeightsLookup fNUELookup; //! built by CreateNUE
   void AddArray(TObjArray* targ, TObjArray* sour);
+  void CreateArrays(bool addData, bool addRec, bool addGen);
   const char* GetBinName(double ptv, double v0mv, const char* pf = "")
   {
     int ptind = 0;  // GetPtBin(ptv);
@@ -16,5 +16,5 @@
 #pragma link C++ class GFW + ;
 #pragma link C++ class GFWCumulant + ;
 #pragma link C++ class ProfileSubset + ;
-#pragma link C++ class FlowContainer + ;
+#pragma link C++ class FlowContainer - ;
 #pragma link C++ class GFWWeights + ;
\ No newline at end of file
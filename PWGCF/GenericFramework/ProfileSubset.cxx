@@ -115,4 +115,46 @@ bool ProfileSubset::OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2)
     }
   }
   return kTRUE;
-}
\ No newline at end of file
+}
+bool ProfileSubset::AddBinArrays(TProfile2D* target, TProfile2D* source)
+{
+  // Adds the bin arrays and the statistics of source to target, without the consistency checks of TProfile2D::Add.
+  // Only the numbers of bins and the axis ranges are compared; returns kFALSE (and does nothing) if they differ
+  if (target->GetNcells() != source->GetNcells() || target->GetNbinsX() != source->GetNbinsX() || target->GetNbinsY() != source->GetNbinsY())
+    return kFALSE;
+  const TAxis* tx = target->GetXaxis();
+  const TAxis* ty = target->GetYaxis();
+  const TAxis* sx = source->GetXaxis();
+  const TAxis* sy = source->GetYaxis();
+  if (tx->GetXmin() != sx->GetXmin() || tx->GetXmax() != sx->GetXmax() || ty->GetXmin() != sy->GetXmin() || ty->GetXmax() != sy->GetXmax())
+    return kFALSE;
+  if (!target->GetBinSumw2()->fN)
+    target->Sumw2();
+  double tstats[TH1::kNstat] = {0};
+  double sstats[TH1::kNstat] = {0};
+  target->GetStats(tstats);
+  source->GetStats(sstats);
+  double* farrTarg = target->fArray;
+  double* sumw2Targ = target->GetSumw2()->fArray;
+  double* binsw2Targ = target->GetBinSumw2()->fArray;
+  const double* farrIn = source->fArray;
+  const double* sumw2In = source->GetSumw2()->fN ? source->GetSumw2()->fArray : 0;
+  const double* binsw2In = source->GetBinSumw2()->fN ? source->GetBinSumw2()->fArray : 0;
+  int nCells = target->GetNcells();
+  for (int bin = 0; bin < nCells; bin++) {
+    double lEnt = source->GetBinEntries(bin);
+    if (lEnt == 0 && farrIn[bin] == 0)
+      continue;
+    target->SetBinEntries(bin, target->GetBinEntries(bin) + lEnt);
+    farrTarg[bin] += farrIn[bin];
+    if (sumw2In)
+      sumw2Targ[bin] += sumw2In[bin];
+    binsw2Targ[bin] += binsw2In ? binsw2In[bin] : lEnt;
+  }
+  for (int i = 0; i < TH1::kNstat; i++)
+    tstats[i] += sstats[i];
+  double lEntries = target->GetEntries() + source->GetEntries();
+  target->PutStats(tstats);
+  target->SetEntries(lEntries);
+  return kTRUE;
+}
@@ -25,6 +25,7 @@ class ProfileSubset : public TProfile2D
   void OverrideBinContent(double x, double y, double x2, double y2, double val);
   void OverrideBinContent(double x, double y, double x2, double y2, TProfile2D* sourceProf);
   bool OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2);
+  static bool AddBinArrays(TProfile2D* target, TProfile2D* source); // Fast Add of two profiles of the same binning
 
   ClassDef(ProfileSubset, 2);
 };
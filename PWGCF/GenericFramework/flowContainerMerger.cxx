@@ -0,0 +1,192 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// Merges the FlowContainer objects of many analysis outputs (e.g. the outputs of the grid subjobs)
+// The files are read concurrently: each thread merges its files into its own containers, adding the bin arrays
+// directly and the subsamples through the dense subsample buffers, and the containers of the threads are merged
+// at the end. All the containers of a file are merged in one pass, so that each file is opened once.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <getopt.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TROOT.h"
+#include "TString.h"
+#include "TObjArray.h"
+#include "TObjString.h"
+
+#include "FlowContainer.h"
+
+// Collects the paths of the FlowContainer objects of a directory and of its subdirectories
+void findContainers(TDirectory* dir, const std::string& prefix, std::vector<std::string>& paths)
+{
+  TIter next(dir->GetListOfKeys());
+  while (TKey* key = (TKey*)next()) {
+    std::string path = prefix.empty() ? key->GetName() : prefix + "/" + key->GetName();
+    TClass* cl = TClass::GetClass(key->GetClassName());
+    if (!cl) {
+      continue;
+    }
+    if (cl->InheritsFrom(TDirectory::Class())) {
+      findContainers((TDirectory*)key->ReadObj(), path, paths);
+    } else if (cl->InheritsFrom(FlowContainer::Class())) {
+      paths.push_back(path);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::string inputCollection("input.txt");
+  std::string outputFileName("FlowContainerMerged.root");
+  std::string containerPaths;
+  int nThreads = 1;
+
+  while (true) {
+    static struct option long_options[] = {
+      {"input", required_argument, nullptr, 0},
+      {"output", required_argument, nullptr, 1},
+      {"paths", required_argument, nullptr, 2},
+      {"threads", required_argument, nullptr, 3},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "", long_options, &option_index);
+    if (c == -1) {
+      break;
+    } else if (c == 0) {
+      inputCollection = optarg;
+    } else if (c == 1) {
+      outputFileName = optarg;
+    } else if (c == 2) {
+      containerPaths = optarg;
+    } else if (c == 3) {
+      nThreads = atoi(optarg);
+    } else if (c == 'h') {
+      printf("FlowContainer merging tool. Options: \n");
+      printf("  --input <inputfile.txt>      Contains the files to be merged, one per line. Default: %s\n", inputCollection.c_str());
+      printf("  --output <outputfile.root>   Target output ROOT file. Default: %s\n", outputFileName.c_str());
+      printf("  --paths <dir/name,...>       Comma-separated paths of the containers in the files. Default: all the FlowContainer objects of the first file\n");
+      printf("  --threads <n>                Number of threads reading the files. Default: %d\n", nThreads);
+      return -1;
+    } else {
+      return -2;
+    }
+  }
+
+  std::vector<std::string> files;
+  std::ifstream in(inputCollection);
+  std::string line;
+  while (in >> line) {
+    files.push_back(line);
+  }
+  if (files.empty()) {
+    printf("No files to merge in %s\n", inputCollection.c_str());
+    return 1;
+  }
+
+  std::vector<std::string> paths;
+  if (!containerPaths.empty()) {
+    std::unique_ptr<TObjArray> tokens(TString(containerPaths).Tokenize(","));
+    for (int i = 0; i < tokens->GetEntries(); i++) {
+      paths.push_back(((TObjString*)tokens->At(i))->GetString().Data());
+    }
+  } else {
+    std::unique_ptr<TFile> first(TFile::Open(files[0].c_str(), "READ"));
+    if (!first || first->IsZombie()) {
+      printf("Could not open file %s to look for the containers\n", files[0].c_str());
+      return 1;
+    }
+    findContainers(first.get(), "", paths);
+  }
+  if (paths.empty()) {
+    printf("No FlowContainer to merge\n");
+    return 1;
+  }
+  printf("Merging %zu containers from %zu files with %d threads\n", paths.size(), files.size(), nThreads);
+
+  nThreads = std::max(1, std::min(nThreads, (int)files.size()));
+  if (nThreads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  // containers of each thread, in the order of paths
+  std::vector<std::vector<std::unique_ptr<FlowContainer>>> partials(nThreads);
+  for (auto& partial : partials) {
+    for (auto& path : paths) {
+      std::string name = path.substr(path.find_last_of('/') + 1);
+      partial.push_back(std::make_unique<FlowContainer>(name.c_str()));
+    }
+  }
+
+  std::atomic<size_t> nDone{0};
+  auto mergeFiles = [&](int iThread) {
+    for (size_t i = iThread; i < files.size(); i += nThreads) {
+      std::unique_ptr<TFile> file(TFile::Open(files[i].c_str(), "READ"));
+      if (!file || file->IsZombie()) {
+        printf("Could not open file %s, skipping it\n", files[i].c_str());
+        continue;
+      }
+      for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+        std::unique_ptr<FlowContainer> container(dynamic_cast<FlowContainer*>(file->Get(paths[ipath].c_str())));
+        if (!container) {
+          printf("Could not find %s in %s\n", paths[ipath].c_str(), files[i].c_str());
+          continue;
+        }
+        partials[iThread][ipath]->MergeContainer(container.get());
+      }
+      size_t done = ++nDone;
+      if (done % 100 == 0) {
+        printf("  %zu / %zu files merged\n", done, files.size());
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    threads.emplace_back(mergeFiles, iThread);
+  }
+  mergeFiles(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+      partials[0][ipath]->MergeContainer(partials[iThread][ipath].get());
+    }
+  }
+
+  std::unique_ptr<TFile> outputFile(TFile::Open(outputFileName.c_str(), "RECREATE"));
+  if (!outputFile || outputFile->IsZombie()) {
+    printf("Could not create the output file %s\n", outputFileName.c_str());
+    return 1;
+  }
+  for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+    const auto& path = paths[ipath];
+    TDirectory* dir = outputFile.get();
+    auto slash = path.find_last_of('/');
+    if (slash != std::string::npos) {
+      dir = outputFile->mkdir(path.substr(0, slash).c_str(), "", true);
+    }
+    dir->WriteTObject(partials[0][ipath].get(), partials[0][ipath]->GetName());
+  }
+  outputFile->Close();
+  printf("Merged %zu files into %s\n", nDone.load(), outputFileName.c_str());
+  return 0;
+}
@@ -0,0 +1,249 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// Merges the GFWWeights objects of many analysis outputs (e.g. the per-run NUA weights of the grid subjobs)
+// The files are read concurrently: each thread merges its files into its own weights, and the weights of the threads
+// are merged at the end. All the weights of a file are merged in one pass, so that each file is opened once.
+// With --compact, the data histograms of the merged weights are replaced by their normalised acceptance (see
+// GFWWeights::OverwriteNUA), which is what the NUA lookup is built from, so that the output only holds the final maps.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <getopt.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TROOT.h"
+#include "TString.h"
+#include "TObjArray.h"
+#include "TObjString.h"
+
+#include "GFWWeights.h"
+
+// Collects the paths of the GFWWeights objects of a directory, of its subdirectories and of its lists
+void findWeights(TDirectory* dir, const std::string& prefix, std::vector<std::string>& paths)
+{
+  TIter next(dir->GetListOfKeys());
+  while (TKey* key = (TKey*)next()) {
+    std::string path = prefix.empty() ? key->GetName() : prefix + "/" + key->GetName();
+    TClass* cl = TClass::GetClass(key->GetClassName());
+    if (!cl) {
+      continue;
+    }
+    if (cl->InheritsFrom(TDirectory::Class())) {
+      findWeights((TDirectory*)key->ReadObj(), path, paths);
+    } else if (cl->InheritsFrom(TList::Class())) {
+      std::unique_ptr<TList> list((TList*)key->ReadObj());
+      list->SetOwner(kTRUE);
+      for (TObject* obj : *list) {
+        if (obj->InheritsFrom(GFWWeights::Class())) {
+          paths.push_back(path + "/" + obj->GetName());
+        }
+      }
+    } else if (cl->InheritsFrom(GFWWeights::Class())) {
+      paths.push_back(path);
+    }
+  }
+}
+
+// Reads the weights at a path, either an object of a directory or an object of a list; the caller owns the result
+GFWWeights* readWeights(TFile* file, const std::string& path)
+{
+  TObject* obj = file->Get(path.c_str());
+  if (obj) {
+    return dynamic_cast<GFWWeights*>(obj);
+  }
+  auto slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    return nullptr;
+  }
+  std::unique_ptr<TList> list(dynamic_cast<TList*>(file->Get(path.substr(0, slash).c_str())));
+  if (!list) {
+    return nullptr;
+  }
+  GFWWeights* weights = dynamic_cast<GFWWeights*>(list->FindObject(path.substr(slash + 1).c_str()));
+  if (weights) {
+    list->Remove(weights);
+  }
+  list->SetOwner(kTRUE);
+  return weights;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string inputCollection("input.txt");
+  std::string outputFileName("GFWWeightsMerged.root");
+  std::string weightsPaths;
+  int nThreads = 1;
+  bool compact = false;
+
+  while (true) {
+    static struct option long_options[] = {
+      {"input", required_argument, nullptr, 0},
+      {"output", required_argument, nullptr, 1},
+      {"paths", required_argument, nullptr, 2},
+      {"threads", required_argument, nullptr, 3},
+      {"compact", no_argument, nullptr, 4},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "", long_options, &option_index);
+    if (c == -1) {
+      break;
+    } else if (c == 0) {
+      inputCollection = optarg;
+    } else if (c == 1) {
+      outputFileName = optarg;
+    } else if (c == 2) {
+      weightsPaths = optarg;
+    } else if (c == 3) {
+      nThreads = atoi(optarg);
+    } else if (c == 4) {
+      compact = true;
+    } else if (c == 'h') {
+      printf("GFWWeights merging tool. Options: \n");
+      printf("  --input <inputfile.txt>      Contains the files to be merged, one per line. Default: %s\n", inputCollection.c_str());
+      printf("  --output <outputfile.root>   Target output ROOT file. Default: %s\n", outputFileName.c_str());
+      printf("  --paths <dir/name,...>       Comma-separated paths of the weights in the files. Default: all the GFWWeights objects of the first file\n");
+      printf("  --threads <n>                Number of threads reading the files. Default: %d\n", nThreads);
+      printf("  --compact                    Store the normalised acceptance in place of the data histograms\n");
+      return -1;
+    } else {
+      return -2;
+    }
+  }
+
+  std::vector<std::string> files;
+  std::ifstream in(inputCollection);
+  std::string line;
+  while (in >> line) {
+    files.push_back(line);
+  }
+  if (files.empty()) {
+    printf("No files to merge in %s\n", inputCollection.c_str());
+    return 1;
+  }
+
+  std::vector<std::string> paths;
+  if (!weightsPaths.empty()) {
+    std::unique_ptr<TObjArray> tokens(TString(weightsPaths).Tokenize(","));
+    for (int i = 0; i < tokens->GetEntries(); i++) {
+      paths.push_back(((TObjString*)tokens->At(i))->GetString().Data());
+    }
+  } else {
+    std::unique_ptr<TFile> first(TFile::Open(files[0].c_str(), "READ"));
+    if (!first || first->IsZombie()) {
+      printf("Could not open file %s to look for the weights\n", files[0].c_str());
+      return 1;
+    }
+    findWeights(first.get(), "", paths);
+  }
+  if (paths.empty()) {
+    printf("No GFWWeights to merge\n");
+    return 1;
+  }
+  printf("Merging %zu weights from %zu files with %d threads\n", paths.size(), files.size(), nThreads);
+
+  nThreads = std::max(1, std::min(nThreads, (int)files.size()));
+  if (nThreads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  // weights of each thread, in the order of paths, created at the first weights read
+  std::vector<std::vector<std::unique_ptr<GFWWeights>>> partials(nThreads);
+  for (auto& partial : partials) {
+    partial.resize(paths.size());
+  }
+
+  std::atomic<size_t> nDone{0};
+  auto mergeFiles = [&](int iThread) {
+    for (size_t i = iThread; i < files.size(); i += nThreads) {
+      std::unique_ptr<TFile> file(TFile::Open(files[i].c_str(), "READ"));
+      if (!file || file->IsZombie()) {
+        printf("Could not open file %s, skipping it\n", files[i].c_str());
+        continue;
+      }
+      for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+        std::unique_ptr<GFWWeights> weights(readWeights(file.get(), paths[ipath]));
+        if (!weights) {
+          printf("Could not find %s in %s\n", paths[ipath].c_str(), files[i].c_str());
+          continue;
+        }
+        // the histograms are cloned, those read may belong to the file
+        auto& target = partials[iThread][ipath];
+        if (!target) {
+          target = std::make_unique<GFWWeights>();
+          target->SetName(weights->GetName());
+        }
+        target->MergeWeights(weights.get(), weights->GetDataArray() != nullptr, weights->GetRecArray() != nullptr, weights->GetGenArray() != nullptr);
+      }
+      size_t done = ++nDone;
+      if (done % 100 == 0) {
+        printf("  %zu / %zu files merged\n", done, files.size());
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    threads.emplace_back(mergeFiles, iThread);
+  }
+  mergeFiles(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+      auto& target = partials[0][ipath];
+      auto& source = partials[iThread][ipath];
+      if (!source) {
+        continue;
+      }
+      if (!target) {
+        target = std::move(source);
+      } else {
+        target->MergeWeights(source.get(), source->GetDataArray() != nullptr, source->GetRecArray() != nullptr, source->GetGenArray() != nullptr);
+      }
+    }
+  }
+
+  std::unique_ptr<TFile> outputFile(TFile::Open(outputFileName.c_str(), "RECREATE"));
+  if (!outputFile || outputFile->IsZombie()) {
+    printf("Could not create the output file %s\n", outputFileName.c_str());
+    return 1;
+  }
+  for (size_t ipath = 0; ipath < paths.size(); ipath++) {
+    auto& weights = partials[0][ipath];
+    if (!weights) {
+      printf("%s was not found in any file\n", paths[ipath].c_str());
+      continue;
+    }
+    if (compact && weights->GetDataArray() && weights->GetDataArray()->GetEntries() > 0) {
+      weights->OverwriteNUA();
+    }
+    const auto& path = paths[ipath];
+    TDirectory* dir = outputFile.get();
+    auto slash = path.find_last_of('/');
+    if (slash != std::string::npos) {
+      dir = outputFile->mkdir(path.substr(0, slash).c_str(), "", true);
+    }
+    dir->WriteTObject(weights.get(), weights->GetName());
+  }
+  outputFile->Close();
+  printf("Merged %zu files into %s\n", nDone.load(), outputFileName.c_str());
+  return 0;
+}
@@ -13,3 +13,6 @@ Configurable<float> Vz_min{"Vz_min", -10.0, "minimum vertex z range [cm]"};
 Configurable<float> Vz_max{"Vz_max", 10.0, "maximum vertex z range [cm]"};
 Configurable<float> pt_min{"pt_min", 0.2, "minimum track pt value [GeV/c]"};
 Configurable<float> pt_max{"pt_max", 5.0, "maximum track pt value [GeV/c]"};
+Configurable<bool> cfCalculateNestedLoops{"cfCalculateNestedLoops", false, "cross-check e-b-e the correlations with nested loops"};
+Configurable<float> cfNestedLoopsFraction{"cfNestedLoopsFraction", 1.0, "fraction of events, randomly sampled, in which the nested loops are calculated"};
+Configurable<int> cfMaxNestedLoopsParticles{"cfMaxNestedLoopsParticles", 2000, "nested loops are not calculated in events with more selected particles than this"};
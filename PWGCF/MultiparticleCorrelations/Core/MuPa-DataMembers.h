@@ -20,6 +20,7 @@
 // *) Particle histograms;
 // *) Q-vectors;
 // *) Multiparticle correlations (standard, isotropic, same harmonic);
+// *) Nested loops;
 // *) Particle weights;
 
 // a) Base list to hold all output objects ("grandmother" of all lists):
@@ -67,6 +68,8 @@ Bool_t fCalculateQvector = kTRUE;  // to calculate or not to calculate Q-vectors
 struct Qvector_Arrays {
   TComplex fQ[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}};       //! generic Q-vector
   TComplex fQvector[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}}; //! "integrated" Q-vector
+  GFWCumulant fQvectorCumulant;                                                                     //! "integrated" Q-vector, filled in one batch from ftaParticles, see FillQvector()
+  vector<Double_t> ftaParticles[2];                                                                 //! selected particles in the current event [0=azimuthal angles;1=particle weights]
 } qv_a;
 
 // *) Multiparticle correlations (standard, isotropic, same harmonic):
@@ -77,6 +80,17 @@ struct Correlations_Arrays {
   TProfile* fCorrelationsPro[4][6][3] = {{{NULL}}}; //! multiparticle correlations [2p=0,4p=1,6p=2,8p=3][n=1,n=2,...,n=6][0=integrated,1=vs. multiplicity,2=vs. centrality]
 } c_a;
 
+// *) Nested loops:
+TList* fNestedLoopsList = NULL;             // list to hold all nested loops objects
+TProfile* fNestedLoopsFlagsPro = NULL;      // profile to hold all flags for nested loops
+Bool_t fCalculateNestedLoops = kFALSE;      // cross-check e-b-e the correlations from Q-vectors with nested loops
+Double_t fNestedLoopsFraction = 1.;         // fraction of events, randomly sampled, in which the nested loops are calculated
+Int_t fMaxNestedLoopsParticles = 2000;      // nested loops are not calculated in events with more selected particles than this
+struct NestedLoops_Arrays {
+  TProfile* fNestedLoopsPro[4][6] = {{NULL}}; //! multiparticle correlations from nested loops [2p=0,4p=1,6p=2,8p=3][n=1,n=2,...,n=6], integrated only
+  TH1D* fNestedLoopsMismatchHist = NULL;      //! events in which nested loops and Q-vectors disagree, vs. harmonic
+} nl_a;
+
 // *) Particle weights:
 TList* fWeightsList = NULL;        //!<! list to hold all particle weights
 TProfile* fWeightsFlagsPro = NULL; //!<! profile to hold all flags for weights
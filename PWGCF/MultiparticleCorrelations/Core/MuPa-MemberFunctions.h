@@ -25,6 +25,7 @@
 // void BookParticleHistograms()
 // void BookQvectorHistograms()
 // void BookCorrelationsHistograms()
+// void BookNestedLoopsHistograms()
 // void BookWeightsHistograms()
 // void BookResultsHistograms()
 
@@ -34,7 +35,9 @@
 // Bool_t EventCuts(aod::Collision const& collision)
 // void FillParticleHistograms(aod::Track const& track, const Int_t rs, const Int_t ba); // reco or sim, before or after particle cuts
 // Bool_t ParticleCuts(aod::Track const& track)
+// void FillQvector();
 // void CalculateCorrelations();
+// void CalculateNestedLoops();
 
 // *) Q-vectors:
 // TComplex Q(Int_t n, Int_t p);
@@ -92,6 +95,11 @@ void DefaultConfiguration()
   // task->SetCalculateCorrelations(kTRUE);
   fCalculateCorrelations = kTRUE;
 
+  // task->SetCalculateNestedLoops(kFALSE);
+  fCalculateNestedLoops = cfCalculateNestedLoops;
+  fNestedLoopsFraction = cfNestedLoopsFraction;
+  fMaxNestedLoopsParticles = cfMaxNestedLoopsParticles;
+
 } // void DefaultConfiguration()
 
 //============================================================
@@ -209,6 +217,7 @@ void BookAndNestAllLists()
   // *) Control particle histograms;
   // *) Correlations;
   // *) Q-vectors;
+  // *) Nested loops;
   // *) Particle weights;
   // *) Results.
 
@@ -246,6 +255,12 @@ void BookAndNestAllLists()
   fCorrelationsList->SetOwner(kTRUE);
   fBaseList->Add(fCorrelationsList);
 
+  // *) Nested loops:
+  fNestedLoopsList = new TList();
+  fNestedLoopsList->SetName("NestedLoops");
+  fNestedLoopsList->SetOwner(kTRUE);
+  fBaseList->Add(fNestedLoopsList);
+
   // *) Particle weights:
   fWeightsList = new TList();
   fWeightsList->SetName("Weights");
@@ -361,7 +376,7 @@ void BookQvectorHistograms()
   // Book all Q-vector histograms.
 
   // a) Book the profile holding flags;
-  // b) ...
+  // b) Book the Q-vector filled in batches.
 
   if (fVerbose) {
     Green(__PRETTY_FUNCTION__);
@@ -381,7 +396,11 @@ void BookQvectorHistograms()
   fQvectorFlagsPro->Fill(2.5, gMaxCorrelator);
   fQvectorList->Add(fQvectorFlagsPro);
 
-  // b) ...
+  // b) Book the Q-vector filled in batches:
+  // Same components as qv_a.fQvector: harmonics 0,...,gMaxHarmonic*gMaxCorrelator, powers of weights 0,...,gMaxCorrelator, one pt bin
+  if (fCalculateQvector) {
+    qv_a.fQvectorCumulant.CreateComplexVectorArray(gMaxHarmonic * gMaxCorrelator + 1, gMaxCorrelator + 1, 1);
+  }
 
 } // void BookQvectorHistograms()
 
@@ -445,6 +464,64 @@ void BookCorrelationsHistograms()
 
 //============================================================
 
+void BookNestedLoopsHistograms()
+{
+  // Book all objects for nested loops.
+
+  // a) Book the profile holding flags;
+  // b) Common local labels;
+  // c) Histograms.
+
+  if (fVerbose) {
+    Green(__PRETTY_FUNCTION__);
+  }
+
+  // a) Book the profile holding flags:
+  fNestedLoopsFlagsPro = new TProfile("fNestedLoopsFlagsPro", "flags for nested loops", 3, 0., 3.);
+  fNestedLoopsFlagsPro->SetStats(kFALSE);
+  fNestedLoopsFlagsPro->SetLineColor(eColor);
+  fNestedLoopsFlagsPro->SetFillColor(eFillColor);
+  fNestedLoopsFlagsPro->GetXaxis()->SetLabelSize(0.05);
+  fNestedLoopsFlagsPro->GetXaxis()->SetBinLabel(1, "fCalculateNestedLoops");
+  fNestedLoopsFlagsPro->Fill(0.5, fCalculateNestedLoops);
+  fNestedLoopsFlagsPro->GetXaxis()->SetBinLabel(2, "fNestedLoopsFraction");
+  fNestedLoopsFlagsPro->Fill(1.5, fNestedLoopsFraction);
+  fNestedLoopsFlagsPro->GetXaxis()->SetBinLabel(3, "fMaxNestedLoopsParticles");
+  fNestedLoopsFlagsPro->Fill(2.5, fMaxNestedLoopsParticles);
+  fNestedLoopsList->Add(fNestedLoopsFlagsPro);
+
+  if (!fCalculateNestedLoops) {
+    return;
+  }
+
+  // b) Common local labels:
+  TString oVariable[4] = {"#varphi_{1}-#varphi_{2}", "#varphi_{1}+#varphi_{2}-#varphi_{3}-#varphi_{4}",
+                          "#varphi_{1}+#varphi_{2}+#varphi_{3}-#varphi_{4}-#varphi_{5}-#varphi_{6}",
+                          "#varphi_{1}+#varphi_{2}+#varphi_{3}+#varphi_{4}-#varphi_{5}-#varphi_{6}-#varphi_{7}-#varphi_{8}"};
+
+  // c) Histograms:
+  for (Int_t k = 0; k < 1; k++) // order [2p=0,4p=1,6p=2,8p=3] ... TBI 20220809 ... only 2p is ported, as in CalculateCorrelations()
+  {
+    for (Int_t n = 0; n < gMaxHarmonic; n++) // harmonic [n=1,n=2,...,n=6]
+    {
+      nl_a.fNestedLoopsPro[k][n] = new TProfile(Form("fNestedLoopsPro[%d][%d]", k, n), "nested loops", 1, 0., 1.);
+      nl_a.fNestedLoopsPro[k][n]->SetStats(kFALSE);
+      nl_a.fNestedLoopsPro[k][n]->Sumw2();
+      nl_a.fNestedLoopsPro[k][n]->GetXaxis()->SetBinLabel(1, "int");
+      nl_a.fNestedLoopsPro[k][n]->GetYaxis()->SetTitle(Form("#LT#LTcos[%s(%s)]#GT#GT", 1 == n + 1 ? "" : Form("%d", n + 1), oVariable[k].Data()));
+      fNestedLoopsList->Add(nl_a.fNestedLoopsPro[k][n]);
+    }
+  }
+
+  nl_a.fNestedLoopsMismatchHist = new TH1D("fNestedLoopsMismatchHist", "events in which nested loops and Q-vectors disagree", gMaxHarmonic, 0.5, gMaxHarmonic + 0.5);
+  nl_a.fNestedLoopsMismatchHist->SetStats(kFALSE);
+  nl_a.fNestedLoopsMismatchHist->GetXaxis()->SetTitle("harmonic");
+  fNestedLoopsList->Add(nl_a.fNestedLoopsMismatchHist);
+
+} // void BookNestedLoopsHistograms()
+
+//============================================================
+
 void BookWeightsHistograms()
 {
   // Book all objects for particle weights.
@@ -558,6 +635,11 @@ void ResetEventByEventQuantities()
     }
   } // if(fCalculateQvector)
 
+  // d) Reset ebe containers for nested loops:
+  // The selected particles are kept for the batch fill of Q-vectors as well
+  qv_a.ftaParticles[0].clear();
+  qv_a.ftaParticles[1].clear();
+
   // ... TBI 20220809 port the rest ...
 
 } // void ResetEventByEventQuantities()
@@ -727,6 +809,116 @@ void CalculateCorrelations()
 
 //============================================================
 
+void FillQvector()
+{
+  // Fill the "integrated" Q-vector from all selected particles of the current event in one batch.
+  // The batch fill of GFWCumulant evaluates cos(h*phi) and sin(h*phi) of all particles harmonic by harmonic,
+  // with the recurrence on h, and sums them in loops over contiguous arrays, instead of calling
+  // TMath::Cos and TMath::Sin for each particle, harmonic and power of weight.
+  // Convention is the same: Q_{h,p} = sum_i w_i^p exp(i*h*phi_i).
+
+  if (fVerbose) {
+    Green(__PRETTY_FUNCTION__);
+  }
+
+  Int_t nParticles = qv_a.ftaParticles[0].size();
+  qv_a.fQvectorCumulant.ResetQs();
+  qv_a.fQvectorCumulant.FillArray(nParticles, nullptr, nullptr, qv_a.ftaParticles[0].data(), qv_a.ftaParticles[1].data());
+  for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
+    for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) // weight power
+    {
+      qv_a.fQvector[h][wp] = qv_a.fQvectorCumulant.Vec(h, wp);
+    }
+  }
+
+} // void FillQvector()
+
+//============================================================
+
+void CalculateNestedLoops()
+{
+  // Calculate with nested loops the same correlations as in CalculateCorrelations(), and cross-check e-b-e the ones from Q-vectors.
+  // Nested loops are O(N^2), so they are calculated only in a randomly sampled fraction fNestedLoopsFraction of events,
+  // and not at all in events with more than fMaxNestedLoopsParticles selected particles.
+
+  // a) Sample the event;
+  // b) Nested loops: cos(n*dphi) for all harmonics at once from cos(dphi) and the recurrence on n;
+  // c) Fill the results and compare with Q-vectors.
+
+  if (fVerbose) {
+    Green(__PRETTY_FUNCTION__);
+  }
+
+  // a) Sample the event:
+  Int_t nParticles = qv_a.ftaParticles[0].size();
+  if (nParticles < 2 || nParticles > fMaxNestedLoopsParticles) {
+    return;
+  }
+  if (fNestedLoopsFraction < 1. && gRandom->Uniform() >= fNestedLoopsFraction) {
+    return;
+  }
+
+  // b) Nested loops:
+  // The pairs (i1,i2) and (i2,i1) contribute the same, since cos is even and the weight is symmetric, so only i2 > i1 is looped over.
+  // The inner loop runs over contiguous arrays and has no branches.
+  const Double_t* dPhi = qv_a.ftaParticles[0].data();
+  const Double_t* dWeight = qv_a.ftaParticles[1].data();
+  Double_t twoC[gMaxHarmonic] = {0.}; // sum of w1*w2*cos(n*(phi1-phi2)) over pairs
+  Double_t wTwo = 0.;                 // sum of w1*w2 over pairs
+  for (Int_t i1 = 0; i1 < nParticles - 1; i1++) {
+    Double_t dPhi1 = dPhi[i1];
+    Double_t dW1 = dWeight[i1];
+    for (Int_t i2 = i1 + 1; i2 < nParticles; i2++) {
+      Double_t w = dW1 * dWeight[i2];
+      Double_t c1 = TMath::Cos(dPhi1 - dPhi[i2]);
+      Double_t cPrev = 1., c = c1;
+      for (Int_t h = 0; h < gMaxHarmonic; h++) {
+        twoC[h] += w * c;
+        Double_t cNext = 2. * c1 * c - cPrev;
+        cPrev = c;
+        c = cNext;
+      }
+      wTwo += w;
+    }
+  }
+  if (!(wTwo > 0.)) {
+    return;
+  }
+
+  // c) Fill the results and compare with Q-vectors:
+  if (fCalculateQvector) {
+    ResetQ();
+    for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
+      for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) // weight power
+      {
+        qv_a.fQ[h][wp] = qv_a.fQvector[h][wp];
+      }
+    }
+  }
+  for (Int_t h = 1; h <= gMaxHarmonic; h++) // harmonic
+  {
+    Double_t nestedLoopValue = twoC[h - 1] / wTwo;
+    if (nl_a.fNestedLoopsPro[0][h - 1]) {
+      nl_a.fNestedLoopsPro[0][h - 1]->Fill(0.5, nestedLoopValue, 2. * wTwo); // Two(0,0) counts both orderings of a pair
+    }
+    if (!fCalculateQvector) {
+      continue;
+    }
+    Double_t wQvector = Two(0, 0).Re();
+    Double_t qvectorValue = wQvector > 0. ? Two(h, -h).Re() / wQvector : 0.;
+    if (TMath::Abs(qvectorValue - nestedLoopValue) > 1.e-5) {
+      Red(Form("nestedLoopValue = %f is not the same as twoC = %f, harmonic %d, %d particles", nestedLoopValue, qvectorValue, h, nParticles));
+      nl_a.fNestedLoopsMismatchHist->Fill(h);
+    }
+  }
+  if (fCalculateQvector) {
+    ResetQ();
+  }
+
+} // void CalculateNestedLoops()
+
+//============================================================
+
 TComplex Q(Int_t n, Int_t wp)
 {
   // Using the fact that Q{-n,p} = Q{n,p}^*.
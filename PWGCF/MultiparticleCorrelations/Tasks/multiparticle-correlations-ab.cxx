@@ -24,8 +24,11 @@ using namespace o2::framework;
 #include "Riostream.h"
 #include "TRandom3.h"
 #include <TComplex.h>
+#include <vector>
 using namespace std;
 
+#include "GFWCumulant.h"
+
 // *) Enums:
 #include "PWGCF/MultiparticleCorrelations/Core/MuPa-Enums.h"
 
@@ -86,6 +89,7 @@ struct MultiparticleCorrelationsAB // this name is used in lower-case format to
     BookParticleHistograms();
     BookQvectorHistograms();
     BookCorrelationsHistograms();
+    BookNestedLoopsHistograms();
     BookWeightsHistograms();
     BookResultsHistograms();
 
@@ -113,7 +117,7 @@ struct MultiparticleCorrelationsAB // this name is used in lower-case format to
     // *) Main loop over particles:
     Double_t dPhi = 0.; //, dPt = 0., dEta = 0.;
     // Double_t wPhi = 1., wPt = 1., wEta = 1.;
-    Double_t wToPowerP = 1.; // final particle weight raised to power p
+    Double_t wParticle = 1.; // final particle weight, raised to power p in the Q-vectors
     for (auto& track : tracks) {
 
       // *) Fill particle histograms for reconstructed data before particle cuts:
@@ -127,28 +131,35 @@ struct MultiparticleCorrelationsAB // this name is used in lower-case format to
       // *) Fill particle histograms for reconstructed data after particle cuts:
       FillParticleHistograms(track, eRec, eAfter);
 
-      // *) Fill Q-vectors:
+      // *) Keep the particle for the Q-vectors and nested loops:
       dPhi = track.phi();
       // dPt  = track.pt();
       // dEta = track.eta();
-      for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
-        for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) { // weight power
-          // if (fUseWeights[0]||fUseWeights[1]||fUseWeights[2]) {
-          //   wToPowerP = pow(wPhi*wPt*wEta,wp);
-          // }
-          qv_a.fQvector[h][wp] += TComplex(wToPowerP * TMath::Cos(h * dPhi), wToPowerP * TMath::Sin(h * dPhi));
-        } // for(Int_t wp=0;wp<gMaxCorrelator+1;wp++)
-      }   // for(Int_t h=0;h<gMaxHarmonic*gMaxCorrelator+1;h++)
+      // if (fUseWeights[0]||fUseWeights[1]||fUseWeights[2]) {
+      //   wParticle = wPhi*wPt*wEta;
+      // }
+      qv_a.ftaParticles[0].push_back(dPhi);
+      qv_a.ftaParticles[1].push_back(wParticle);
 
       fResultsHist->Fill(pw_a.fWeightsHist[wPHI]->GetBinContent(pw_a.fWeightsHist[wPHI]->FindBin(track.phi()))); // TBI 20220713 meaningless, only temporarily here to check if this is feasible
 
     } // for (auto& track : tracks)
 
+    // *) Fill Q-vectors, in one batch for all selected particles:
+    if (fCalculateQvector) {
+      FillQvector();
+    }
+
     // *) Calculate multiparticle correlations (standard, isotropic, same harmonic):
     if (fCalculateCorrelations) {
       CalculateCorrelations();
     }
 
+    // *) Cross-check the correlations with nested loops, in a sampled fraction of events:
+    if (fCalculateNestedLoops) {
+      CalculateNestedLoops();
+    }
+
     // *) Reset event-by-event objects:
     ResetEventByEventQuantities();
 
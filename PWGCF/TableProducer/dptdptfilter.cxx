@@ -16,6 +16,8 @@
 #include "Common/DataModel/Centrality.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
+#include "Common/Core/CpuDispatch.h"
+#include "Common/Core/TrackCovarianceBatch.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "PWGCF/Core/AnalysisConfigurableCuts.h"
 #include "PWGCF/DataModel/DptDptFiltered.h"
@@ -32,7 +34,9 @@
 #include <TH3.h>
 #include <TProfile3D.h>
 
+#include <array>
 #include <cmath>
+#include <vector>
 
 #include "dptdptfilter.h"
 
@@ -138,6 +142,115 @@ int trkMultPos[kDptDptNoOfSpecies];  // multiplicity of positive tracks
 int trkMultNeg[kDptDptNoOfSpecies];  // multiplicity of negative tracks
 int partMultPos[kDptDptNoOfSpecies]; // multiplicity of positive particles
 int partMultNeg[kDptDptNoOfSpecies]; // multiplicity of negative particles
+
+//============================================================================================
+// The DptDptFilter track identification
+//============================================================================================
+/// species of n tracks from the nsigmas of each species, electron to proton, combined in quadrature with the TOF
+/// ones when useTOF is set: the species of smallest nsigma if it is below 3 and no other species is, kWrongSpecies otherwise
+/// The combined nsigmas are compared squared, so that the loop is free of branches and of sqrt calls and can be vectorized
+inline void identifyTracksImpl(const float* const* tpcNSigmas, const float* const* tofNSigmas, const uint8_t* useTOF, int* species, std::size_t n)
+{
+  const float* tpc[kDptDptNoOfSpecies];
+  const float* tof[kDptDptNoOfSpecies];
+  for (int sp = kDptDptElectron; sp < kDptDptNoOfSpecies; ++sp) {
+    tpc[sp] = tpcNSigmas[sp];
+    tof[sp] = tofNSigmas[sp];
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    const bool withtof = useTOF[i];
+    const float threshold = withtof ? 3.0f * 3.0f : 3.0f;
+    float minnsigma = withtof ? 999.0f * 999.0f : 999.0f;
+    int spminnsigma = kWrongSpecies;
+    int ncompatible = 0;
+    auto consider = [&](int sp) {
+      const float tpcnsigma = tpc[sp][i];
+      const float tofnsigma = tof[sp][i];
+      const float nsigma = withtof ? tpcnsigma * tpcnsigma + tofnsigma * tofnsigma : tpcnsigma;
+      spminnsigma = (nsigma < minnsigma) ? sp : spminnsigma;
+      minnsigma = (nsigma < minnsigma) ? nsigma : minnsigma;
+      ncompatible += (nsigma < threshold) ? 1 : 0;
+    };
+    consider(kDptDptElectron);
+    consider(kDptDptMuon);
+    consider(kDptDptPion);
+    consider(kDptDptKaon);
+    consider(kDptDptProton);
+    species[i] = ((minnsigma < threshold) & (ncompatible == 1)) ? spminnsigma : int(kWrongSpecies);
+  }
+}
+O2_SIMD_TARGET_AVX2 O2_SIMD_FLATTEN void identifyTracksAvx2(const float* const* tpcNSigmas, const float* const* tofNSigmas, const uint8_t* useTOF, int* species, std::size_t n) { identifyTracksImpl(tpcNSigmas, tofNSigmas, useTOF, species, n); }
+O2_SIMD_TARGET_AVX512 O2_SIMD_FLATTEN void identifyTracksAvx512(const float* const* tpcNSigmas, const float* const* tofNSigmas, const uint8_t* useTOF, int* species, std::size_t n) { identifyTracksImpl(tpcNSigmas, tofNSigmas, useTOF, species, n); }
+const o2::analysis::simd::Dispatched<void (*)(const float* const*, const float* const*, const uint8_t*, int*, std::size_t)> identifyTracks{identifyTracksImpl, identifyTracksAvx2, identifyTracksAvx512};
+
+/// columns of the tracks of a collision, read once for the QA histograms, the identification and the scanned tracks table
+struct TrackBatch {
+  std::vector<float> p, pt, eta, phi, dcaxy, dcaz;
+  std::vector<int8_t> sign;
+  std::vector<uint8_t> asone, astwo;
+  std::vector<uint8_t> usetof;
+  std::array<std::vector<float>, kDptDptNoOfSpecies> tpcnsigmas;
+  std::array<std::vector<float>, kDptDptNoOfSpecies> tofnsigmas;
+  std::vector<int> species;
+
+  void clear()
+  {
+    for (auto* column : {&p, &pt, &eta, &phi, &dcaxy, &dcaz}) {
+      column->clear();
+    }
+    sign.clear();
+    asone.clear();
+    astwo.clear();
+    usetof.clear();
+    for (int sp = 0; sp < kDptDptNoOfSpecies; ++sp) {
+      tpcnsigmas[sp].clear();
+      tofnsigmas[sp].clear();
+    }
+    species.clear();
+  }
+  std::size_t size() const { return pt.size(); }
+};
+
+/// dense accumulators of the reconstructed track histograms, added to them once per collision
+struct TrackHistos {
+  DenseHistogram pB, ptB, ptPosB, ptNegB, etaB, phiB, dcaxyB, dcazB;
+  DenseHistogram etaA, phiA, dcaxyA, dcazA, fineDcaxyA, fineDcazA;
+  std::array<DenseHistogram, kDptDptNoOfSpecies> pA, ptA, ptPosA, ptNegA;
+
+  /// pairs of accumulator and histogram
+  template <typename Function>
+  void forEach(Function&& function)
+  {
+    function(pB, fhPB);
+    function(ptB, fhPtB);
+    function(ptPosB, fhPtPosB);
+    function(ptNegB, fhPtNegB);
+    function(etaB, fhEtaB);
+    function(phiB, fhPhiB);
+    function(dcaxyB, fhDCAxyB);
+    function(dcazB, fhDCAzB);
+    function(etaA, fhEtaA);
+    function(phiA, fhPhiA);
+    function(dcaxyA, fhDCAxyA);
+    function(dcazA, fhDCAzA);
+    function(fineDcaxyA, fhFineDCAxyA);
+    function(fineDcazA, fhFineDCAzA);
+    for (int sp = 0; sp < kDptDptNoOfSpecies; ++sp) {
+      function(pA[sp], fhPA[sp]);
+      function(ptA[sp], fhPtA[sp]);
+      function(ptPosA[sp], fhPtPosA[sp]);
+      function(ptNegA[sp], fhPtNegA[sp]);
+    }
+  }
+  void init()
+  {
+    forEach([](DenseHistogram& dense, TH1F*& histo) { dense = DenseHistogram::fromHistogram(histo); });
+  }
+  void flush()
+  {
+    forEach([](DenseHistogram& dense, TH1F*& histo) { dense.flush(histo); });
+  }
+};
 } // namespace o2::analysis::dptdptfilter
 
 using namespace dptdptfilter;
@@ -164,50 +277,8 @@ struct DptDptFilter {
   Produces<aod::DptDptCFAcceptedTrueCollisions> acceptedtrueevents;
   Produces<aod::ScannedTrueTracks> scannedtruetracks;
 
-  template <typename TrackObject>
-  void fillTrackHistosBeforeSelection(TrackObject const& track)
-  {
-    using namespace dptdptfilter;
-
-    fhPB->Fill(track.p());
-    fhPtB->Fill(track.pt());
-    fhEtaB->Fill(track.eta());
-    fhPhiB->Fill(track.phi());
-    if (track.sign() > 0) {
-      fhPtPosB->Fill(track.pt());
-    } else {
-      fhPtNegB->Fill(track.pt());
-    }
-    fhDCAxyB->Fill(track.dcaXY());
-    fhDCAzB->Fill(track.dcaZ());
-  }
-
-  template <typename TrackObject>
-  void fillTrackHistosAfterSelection(TrackObject const& track, MatchRecoGenSpecies sp)
-  {
-    using namespace dptdptfilter;
-
-    /* the charged species should have been called first so avoid double counting */
-    if (sp == kDptDptCharged) {
-      fhEtaA->Fill(track.eta());
-      fhPhiA->Fill(track.phi());
-      fhDCAxyA->Fill(track.dcaXY());
-      fhDCAzA->Fill(track.dcaZ());
-      if (track.dcaXY() < 1.0) {
-        fhFineDCAxyA->Fill(track.dcaXY());
-      }
-      if (track.dcaZ() < 1.0) {
-        fhFineDCAzA->Fill(track.dcaZ());
-      }
-    }
-    fhPA[sp]->Fill(track.p());
-    fhPtA[sp]->Fill(track.pt());
-    if (track.sign() > 0) {
-      fhPtPosA[sp]->Fill(track.pt());
-    } else {
-      fhPtNegA[sp]->Fill(track.pt());
-    }
-  }
+  TrackBatch trackBatch;
+  TrackHistos trackHistos;
 
   template <typename ParticleObject, typename MCCollisionObject>
   void fillParticleHistosBeforeSelection(ParticleObject const& particle, MCCollisionObject const& collision, float charge)
@@ -265,64 +336,6 @@ struct DptDptFilter {
     }
   }
 
-  template <typename TrackObject>
-  inline MatchRecoGenSpecies IdentifyTrack(TrackObject const& track)
-  {
-    using namespace o2::analysis::dptdptfilter;
-
-    float nsigmas[kDptDptNoOfSpecies];
-    if (track.p() < 0.8) {
-      nsigmas[kDptDptCharged] = 999.0f;
-      nsigmas[kDptDptElectron] = track.tpcNSigmaEl();
-      nsigmas[kDptDptMuon] = track.tpcNSigmaMu();
-      nsigmas[kDptDptPion] = track.tpcNSigmaPi();
-      nsigmas[kDptDptKaon] = track.tpcNSigmaKa();
-      nsigmas[kDptDptProton] = track.tpcNSigmaPr();
-    } else {
-      /* introduce require TOF flag */
-      if (track.hasTOF()) {
-        nsigmas[kDptDptCharged] = 999.0f;
-        nsigmas[kDptDptElectron] = sqrtf(track.tpcNSigmaEl() * track.tpcNSigmaEl() + track.tofNSigmaEl() * track.tofNSigmaEl());
-        nsigmas[kDptDptMuon] = sqrtf(track.tpcNSigmaMu() * track.tpcNSigmaMu() + track.tofNSigmaMu() * track.tofNSigmaMu());
-        nsigmas[kDptDptPion] = sqrtf(track.tpcNSigmaPi() * track.tpcNSigmaPi() + track.tofNSigmaPi() * track.tofNSigmaPi());
-        nsigmas[kDptDptKaon] = sqrtf(track.tpcNSigmaKa() * track.tpcNSigmaKa() + track.tofNSigmaKa() * track.tofNSigmaKa());
-        nsigmas[kDptDptProton] = sqrtf(track.tpcNSigmaPr() * track.tpcNSigmaPr() + track.tofNSigmaPr() * track.tofNSigmaPr());
-      } else {
-        nsigmas[kDptDptCharged] = 999.0f;
-        nsigmas[kDptDptElectron] = track.tpcNSigmaEl();
-        nsigmas[kDptDptMuon] = track.tpcNSigmaMu();
-        nsigmas[kDptDptPion] = track.tpcNSigmaPi();
-        nsigmas[kDptDptKaon] = track.tpcNSigmaKa();
-        nsigmas[kDptDptProton] = track.tpcNSigmaPr();
-      }
-    }
-    float min_nsigma = 999.0f;
-    MatchRecoGenSpecies sp_min_nsigma = kWrongSpecies;
-    for (int sp = 0; sp < kDptDptNoOfSpecies; ++sp) {
-      if (nsigmas[sp] < min_nsigma) {
-        min_nsigma = nsigmas[sp];
-        sp_min_nsigma = MatchRecoGenSpecies(sp);
-      }
-    }
-    bool doublematch = false;
-    if (min_nsigma < 3.0) {
-      for (int sp = 0; (sp < kDptDptNoOfSpecies) and not doublematch; ++sp) {
-        if (sp != sp_min_nsigma) {
-          if (nsigmas[sp] < 3.0) {
-            doublematch = true;
-          }
-        }
-      }
-      if (doublematch) {
-        return kWrongSpecies;
-      } else {
-        return sp_min_nsigma;
-      }
-    } else {
-      return kWrongSpecies;
-    }
-  }
-
   template <typename ParticleObject>
   inline MatchRecoGenSpecies IdentifyParticle(ParticleObject const& particle)
   {
@@ -363,9 +376,7 @@ struct DptDptFilter {
   }
 
   template <typename TrackObject>
-  MatchRecoGenSpecies trackIdentification(TrackObject const& track);
-  template <typename TrackObject>
-  bool selectTrack(TrackObject const& track, int64_t colix);
+  void gatherTrack(TrackObject const& track);
   template <typename TrackListObject>
   void filterTracks(TrackListObject const& ftracks, int colix);
   template <typename ParticleListObject, typename MCCollisionObject, typename CollisionIndex>
@@ -533,6 +544,7 @@ struct DptDptFilter {
         fOutputList->Add(fhNPosNegA[sp]);
         fOutputList->Add(fhDeltaNA[sp]);
       }
+      trackHistos.init();
     }
 
     if ((fDataType != kData) and (fDataType != kDataNoEvtSel)) {
@@ -669,72 +681,53 @@ struct DptDptFilter {
 };
 
 template <typename TrackObject>
-MatchRecoGenSpecies DptDptFilter::trackIdentification(TrackObject const& track)
+void DptDptFilter::gatherTrack(TrackObject const& track)
 {
   using namespace dptdptfilter;
 
-  MatchRecoGenSpecies sp = kWrongSpecies;
-  if (recoIdMethod == 0) {
-    sp = kDptDptCharged;
-  } else if (recoIdMethod == 1) {
+  /* tricky because the boolean columns issue */
+  uint8_t asone, astwo;
+  AcceptTrack(track, asone, astwo);
+
+  trackBatch.p.push_back(track.p());
+  trackBatch.pt.push_back(track.pt());
+  trackBatch.eta.push_back(track.eta());
+  trackBatch.phi.push_back(track.phi());
+  trackBatch.dcaxy.push_back(track.dcaXY());
+  trackBatch.dcaz.push_back(track.dcaZ());
+  trackBatch.sign.push_back(track.sign());
+  trackBatch.asone.push_back(asone);
+  trackBatch.astwo.push_back(astwo);
+
+  if (recoIdMethod == 1) {
     if constexpr (framework::has_type_v<aod::pidtpc_tiny::TPCNSigmaStorePi, typename TrackObject::all_columns>) {
-      sp = IdentifyTrack(track);
+      /* introduce require TOF flag */
+      trackBatch.usetof.push_back(not(track.p() < 0.8) and track.hasTOF());
+      trackBatch.tpcnsigmas[kDptDptElectron].push_back(track.tpcNSigmaEl());
+      trackBatch.tpcnsigmas[kDptDptMuon].push_back(track.tpcNSigmaMu());
+      trackBatch.tpcnsigmas[kDptDptPion].push_back(track.tpcNSigmaPi());
+      trackBatch.tpcnsigmas[kDptDptKaon].push_back(track.tpcNSigmaKa());
+      trackBatch.tpcnsigmas[kDptDptProton].push_back(track.tpcNSigmaPr());
+      trackBatch.tofnsigmas[kDptDptElectron].push_back(track.tofNSigmaEl());
+      trackBatch.tofnsigmas[kDptDptMuon].push_back(track.tofNSigmaMu());
+      trackBatch.tofnsigmas[kDptDptPion].push_back(track.tofNSigmaPi());
+      trackBatch.tofnsigmas[kDptDptKaon].push_back(track.tofNSigmaKa());
+      trackBatch.tofnsigmas[kDptDptProton].push_back(track.tofNSigmaPr());
     } else {
       LOGF(fatal, "Track identification required but PID information not present");
     }
-  } else if (recoIdMethod == 2) {
-    if constexpr (framework::has_type_v<aod::mctracklabel::McParticleId, typename TrackObject::all_columns>) {
-      sp = IdentifyParticle(track.template mcParticle_as<aod::McParticles>());
-    } else {
-      LOGF(fatal, "Track identification required from MC particle but MC information not present");
-    }
-  }
-  return sp;
-}
-
-template <typename TrackObject>
-bool DptDptFilter::selectTrack(TrackObject const& track, int64_t colix)
-{
-  using namespace dptdptfilter;
-
-  /* before track selection */
-  fillTrackHistosBeforeSelection(track);
-
-  /* track selection */
-  /* tricky because the boolean columns issue */
-  uint8_t asone, astwo;
-  AcceptTrack(track, asone, astwo);
-  if ((asone == uint8_t(true)) or (astwo == uint8_t(true))) {
-    /* the track has been accepted */
-    /* let's identify it */
-    /* TODO: probably this needs to go inside AcceptTrack */
-    MatchRecoGenSpecies sp = trackIdentification(track);
-    if (sp != kWrongSpecies) {
-      if (sp != kDptDptCharged) {
-        /* fill the charged histograms */
-        fillTrackHistosAfterSelection(track, kDptDptCharged);
-        /* update charged multiplicities */
-        if (asone == uint8_t(true)) {
-          trkMultPos[kDptDptCharged]++;
-        }
-        if (astwo == uint8_t(true)) {
-          trkMultNeg[kDptDptCharged]++;
-        }
-      }
-      /* fill the species histograms */
-      fillTrackHistosAfterSelection(track, sp);
-      /* update species multiplicities */
-      if (asone == uint8_t(true)) {
-        trkMultPos[sp]++;
-      }
-      if (astwo == uint8_t(true)) {
-        trkMultNeg[sp]++;
+  } else {
+    MatchRecoGenSpecies sp = kDptDptCharged;
+    if (recoIdMethod == 2) {
+      if constexpr (framework::has_type_v<aod::mctracklabel::McParticleId, typename TrackObject::all_columns>) {
+        /* only the accepted tracks are identified */
+        sp = ((asone == uint8_t(true)) or (astwo == uint8_t(true))) ? IdentifyParticle(track.template mcParticle_as<aod::McParticles>()) : kWrongSpecies;
+      } else {
+        LOGF(fatal, "Track identification required from MC particle but MC information not present");
       }
-      scannedtracks(colix, asone, astwo, track.pt(), track.eta(), track.phi());
-      return true;
     }
+    trackBatch.species.push_back(sp);
   }
-  return false;
 }
 
 template <typename ParticleListObject, typename MCCollisionObject, typename CollisionIndex>
@@ -799,76 +792,96 @@ void DptDptFilter::filterParticles(ParticleListObject const& particles, MCCollis
 }
 
 template <typename TrackListObject>
-void DptDptFilter::filterTracks(TrackListObject const&, int)
-{
-  LOGF(fatal, "Track filtering not implemented for the passed track table");
-}
-
-template <>
-void DptDptFilter::filterTracks<DptDptFullTracks>(DptDptFullTracks const& ftracks, int colix)
+void DptDptFilter::filterTracks(TrackListObject const& ftracks, int colix)
 {
   using namespace dptdptfilter;
 
-  int acceptedtracks = 0;
-
+  /* read the track columns once */
+  trackBatch.clear();
   for (auto& track : ftracks) {
-    /* before track selection */
-    if (selectTrack(track, colix)) {
-      acceptedtracks++;
+    if constexpr (framework::has_type_v<aod::mctracklabel::McParticleId, typename std::decay_t<decltype(track)>::all_columns>) {
+      if (track.mcParticleId() < 0) {
+        continue;
+      }
     }
+    gatherTrack(track);
   }
-  LOGF(DPTDPTFILTERLOGCOLLISIONS, "Accepted %d reconstructed tracks", acceptedtracks);
-}
+  const std::size_t ntracks = trackBatch.size();
 
-template <>
-void DptDptFilter::filterTracks<DptDptFullTracksDetLevel>(DptDptFullTracksDetLevel const& ftracks, int colix)
-{
-  using namespace dptdptfilter;
-
-  int acceptedtracks = 0;
-
-  for (auto& track : ftracks) {
-    if (not(track.mcParticleId() < 0)) {
-      /* before track selection */
-      if (selectTrack(track, colix)) {
-        acceptedtracks++;
-      }
+  /* identify the tracks */
+  if (recoIdMethod == 1) {
+    const float* tpcnsigmas[kDptDptNoOfSpecies];
+    const float* tofnsigmas[kDptDptNoOfSpecies];
+    for (int sp = 0; sp < kDptDptNoOfSpecies; ++sp) {
+      tpcnsigmas[sp] = trackBatch.tpcnsigmas[sp].data();
+      tofnsigmas[sp] = trackBatch.tofnsigmas[sp].data();
     }
+    trackBatch.species.resize(ntracks);
+    identifyTracks(tpcnsigmas, tofnsigmas, trackBatch.usetof.data(), trackBatch.species.data(), ntracks);
   }
-  LOGF(DPTDPTFILTERLOGCOLLISIONS, "Accepted %d reconstructed tracks", acceptedtracks);
-}
 
-template <>
-void DptDptFilter::filterTracks<DptDptFullTracksPID>(DptDptFullTracksPID const& ftracks, int colix)
-{
-  using namespace dptdptfilter;
+  /* before track selection */
+  trackHistos.pB.fill(trackBatch.p);
+  trackHistos.ptB.fill(trackBatch.pt);
+  trackHistos.etaB.fill(trackBatch.eta);
+  trackHistos.phiB.fill(trackBatch.phi);
+  trackHistos.dcaxyB.fill(trackBatch.dcaxy);
+  trackHistos.dcazB.fill(trackBatch.dcaz);
 
   int acceptedtracks = 0;
-
-  for (auto& track : ftracks) {
-    /* before track selection */
-    if (selectTrack(track, colix)) {
-      acceptedtracks++;
+  for (std::size_t i = 0; i < ntracks; ++i) {
+    const float pt = trackBatch.pt[i];
+    if (trackBatch.sign[i] > 0) {
+      trackHistos.ptPosB.fill(pt);
+    } else {
+      trackHistos.ptNegB.fill(pt);
     }
-  }
-  LOGF(DPTDPTFILTERLOGCOLLISIONS, "Accepted %d reconstructed tracks", acceptedtracks);
-}
 
-template <>
-void DptDptFilter::filterTracks<DptDptFullTracksPIDDetLevel>(DptDptFullTracksPIDDetLevel const& ftracks, int colix)
-{
-  using namespace dptdptfilter;
-
-  int acceptedtracks = 0;
+    /* track selection */
+    const uint8_t asone = trackBatch.asone[i];
+    const uint8_t astwo = trackBatch.astwo[i];
+    if (not((asone == uint8_t(true)) or (astwo == uint8_t(true)))) {
+      continue;
+    }
+    const int sp = trackBatch.species[i];
+    if (sp == kWrongSpecies) {
+      continue;
+    }
 
-  for (auto& track : ftracks) {
-    if (not(track.mcParticleId() < 0)) {
-      /* before track selection */
-      if (selectTrack(track, colix)) {
-        acceptedtracks++;
+    /* fill the charged histograms, and the species ones if identified */
+    trackHistos.etaA.fill(trackBatch.eta[i]);
+    trackHistos.phiA.fill(trackBatch.phi[i]);
+    trackHistos.dcaxyA.fill(trackBatch.dcaxy[i]);
+    trackHistos.dcazA.fill(trackBatch.dcaz[i]);
+    if (trackBatch.dcaxy[i] < 1.0) {
+      trackHistos.fineDcaxyA.fill(trackBatch.dcaxy[i]);
+    }
+    if (trackBatch.dcaz[i] < 1.0) {
+      trackHistos.fineDcazA.fill(trackBatch.dcaz[i]);
+    }
+    for (int isp : {int(kDptDptCharged), sp}) {
+      trackHistos.pA[isp].fill(trackBatch.p[i]);
+      trackHistos.ptA[isp].fill(pt);
+      if (trackBatch.sign[i] > 0) {
+        trackHistos.ptPosA[isp].fill(pt);
+      } else {
+        trackHistos.ptNegA[isp].fill(pt);
+      }
+      /* update the multiplicities */
+      if (asone == uint8_t(true)) {
+        trkMultPos[isp]++;
+      }
+      if (astwo == uint8_t(true)) {
+        trkMultNeg[isp]++;
+      }
+      if (sp == kDptDptCharged) {
+        break;
       }
     }
+    scannedtracks(colix, asone, astwo, pt, trackBatch.eta[i], trackBatch.phi[i]);
+    acceptedtracks++;
   }
+  trackHistos.flush();
   LOGF(DPTDPTFILTERLOGCOLLISIONS, "Accepted %d reconstructed tracks", acceptedtracks);
 }
 
@@ -20,6 +20,10 @@
 
 #include <TH3F.h>
 
+#include <array>
+#include <memory>
+#include <vector>
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
@@ -33,6 +37,15 @@ struct FilterCF {
   O2_DEFINE_CONFIGURABLE(cfgCutPt, float, 0.5f, "Minimal pT for tracks")
   O2_DEFINE_CONFIGURABLE(cfgCutEta, float, 0.8f, "Eta range for tracks")
 
+  // Compact output: a bit of CFCompactTracks::selection per entry of the vectors, at most 8
+  O2_DEFINE_CONFIGURABLE(cfgSelectionPtMin, std::vector<float>, (std::vector<float>{0.5f, 1.0f}), "Compact tracks: minimal pT of the track selection of each bit of the selection mask")
+  O2_DEFINE_CONFIGURABLE(cfgSelectionEtaMax, std::vector<float>, (std::vector<float>{0.8f, 0.8f}), "Compact tracks: eta range of the track selection of each bit of the selection mask")
+  O2_DEFINE_CONFIGURABLE(cfgSelectionGlobalOnly, std::vector<int>, (std::vector<int>{0, 0}), "Compact tracks: require global tracks (no SDD) for the track selection of each bit of the selection mask")
+
+  // Mixing binning stored in CFMixingBins, has to be the one of the correlation task
+  ConfigurableAxis axisVertex{"axisVertex", {7, -7, 7}, "vertex axis of the mixing binning"};
+  ConfigurableAxis axisMultiplicity{"axisMultiplicity", {VARIABLE_WIDTH, 0, 5, 10, 20, 30, 40, 50, 100.1}, "multiplicity / centrality axis of the mixing binning"};
+
   // Filters and input definitions
   Filter collisionZVtxFilter = nabs(aod::collision::posZ) < cfgCutVertex;
   Filter centralityFilter = aod::cent::centRun2V0M >= 0.0f && aod::cent::centRun2V0M <= 100.0f;
@@ -44,7 +57,23 @@ struct FilterCF {
   OutputObj<TH3F> etaphi{TH3F("etaphi", "centrality vs eta vs phi", 100, 0, 100, 100, -2, 2, 200, 0, 2 * M_PI)};
 
   Produces<aod::CFCollisions> outputCollisions;
+  Produces<aod::CFMixingBins> outputMixingBins;
   Produces<aod::CFTracks> outputTracks;
+  Produces<aod::CFCompactTracks> outputCompactTracks;
+
+  using BinningType = ColumnBinningPolicy<aod::collision::PosZ, aod::cent::CentRun2V0M>;
+  std::unique_ptr<BinningType> mBinning;
+
+  void init(InitContext&)
+  {
+    if (cfgSelectionPtMin->size() != cfgSelectionEtaMax->size() || cfgSelectionPtMin->size() != cfgSelectionGlobalOnly->size()) {
+      LOGF(fatal, "cfgSelectionPtMin, cfgSelectionEtaMax and cfgSelectionGlobalOnly have different sizes");
+    }
+    if (cfgSelectionPtMin->size() > 8) {
+      LOGF(fatal, "At most 8 track selections can be stored in the compact tracks, %d given", cfgSelectionPtMin->size());
+    }
+    mBinning = std::make_unique<BinningType>(std::array<std::vector<double>, 2>{axisVertex.value, axisMultiplicity.value}, true);
+  }
 
   void process(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>>::iterator const& collision, aod::BCsWithTimestamps const&, soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>> const& tracks)
   {
@@ -56,6 +85,11 @@ struct FilterCF {
 
     auto bc = collision.bc_as<aod::BCsWithTimestamps>();
     outputCollisions(bc.runNumber(), collision.posZ(), collision.centRun2V0M(), bc.timestamp());
+    outputMixingBins(mBinning->getBin({collision.posZ(), collision.centRun2V0M()}));
+
+    const auto& selectionPtMin = cfgSelectionPtMin.value;
+    const auto& selectionEtaMax = cfgSelectionEtaMax.value;
+    const auto& selectionGlobalOnly = cfgSelectionGlobalOnly.value;
 
     for (auto& track : tracks) {
       uint8_t trackType = 0;
@@ -67,6 +101,14 @@ struct FilterCF {
 
       outputTracks(outputCollisions.lastIndex(), track.pt(), track.eta(), track.phi(), track.sign(), trackType);
 
+      uint8_t selection = 0;
+      for (size_t i = 0; i < selectionPtMin.size(); i++) {
+        if (track.pt() > selectionPtMin[i] && std::abs(track.eta()) < selectionEtaMax[i] && (selectionGlobalOnly[i] == 0 || trackType == 1)) {
+          selection |= 1 << i;
+        }
+      }
+      outputCompactTracks(outputCollisions.lastIndex(), aod::cfcompacttrack::packPt(track.pt()), aod::cfcompacttrack::packEta(track.eta()), aod::cfcompacttrack::packPhi(track.phi()), track.sign(), trackType, selection);
+
       yields->Fill(collision.centRun2V0M(), track.pt(), track.eta());
       etaphi->Fill(collision.centRun2V0M(), track.eta(), track.phi());
     }
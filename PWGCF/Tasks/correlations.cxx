@@ -25,10 +25,13 @@
 #include "PWGCF/DataModel/CorrelationsDerived.h"
 #include "PWGCF/Core/CorrelationContainer.h"
 #include "PWGCF/Core/PairCuts.h"
+#include "PWGCF/Core/BinnedCorrelations.h"
+#include "PWGCF/Core/EfficiencyLookup.h"
 #include "DataFormatsParameters/GRPObject.h"
 
 #include <TH1F.h>
 #include <cmath>
+#include <vector>
 #include <TDirectory.h>
 #include <THn.h>
 
@@ -63,6 +66,10 @@ struct CorrelationTask {
   O2_DEFINE_CONFIGURABLE(cfgEfficiencyAssociated, std::string, "", "CCDB path to efficiency object for associated particles")
 
   O2_DEFINE_CONFIGURABLE(cfgNoMixedEvents, int, 5, "Number of mixed events per event")
+  O2_DEFINE_CONFIGURABLE(cfgCompactTrackSelection, int, 1, "Compact derived data: bits of the track selection mask of the filter task required for the tracks")
+
+  O2_DEFINE_CONFIGURABLE(cfgBinned, bool, false, "Binned correlations from per-event (pT, eta, phi) occupancy maps instead of pair loops, only with single-particle selections")
+  O2_DEFINE_CONFIGURABLE(cfgBinnedCells, int, 2, "Binned correlations: number of grid cells per bin of the delta eta and delta phi axes")
 
   ConfigurableAxis axisVertex{"axisVertex", {7, -7, 7}, "vertex axis for histograms"};
   ConfigurableAxis axisDeltaPhi{"axisDeltaPhi", {72, -PIHalf, PIHalf * 3}, "delta phi axis for histograms"};
@@ -84,8 +91,12 @@ struct CorrelationTask {
   Filter trackFilter = (nabs(aod::track::eta) < cfgCutEta) && (aod::track::pt > cfgCutPt) && ((requireGlobalTrackInFilter()) || (aod::track::isGlobalTrackSDD == (uint8_t) true));
   Filter cfTrackFilter = (nabs(aod::cftrack::eta) < cfgCutEta) && (aod::cftrack::pt > cfgCutPt);
 
+  // The compact derived tracks are selected in the filter task, only the selection mask is checked
+  Filter cfCompactTrackFilter = (aod::cfcompacttrack::selection & cfgCompactTrackSelection) == cfgCompactTrackSelection;
+
   using aodTracks = soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>>;
   using derivedTracks = soa::Filtered<aod::CFTracks>;
+  using compactTracks = soa::Filtered<aod::CFCompactTracks>;
 
   // Output definitions
   OutputObj<CorrelationContainer> same{"sameEvent"};
@@ -99,11 +110,19 @@ struct CorrelationTask {
 
   HistogramRegistry registry{"registry"};
   PairCuts mPairCuts;
+  // pairs of the current trigger particle, see fillCorrelations
+  std::vector<float> mPairDeltaEta, mPairPtAssoc, mPairDeltaPhi, mPairWeight;
+  // occupancy maps of the trigger and associated particles for cfgBinned, the second one for mixed events
+  BinnedCorrelations mBinned[2];
+  // flattened efficiency histograms, and the efficiencies of the tracks of the current event, see fillEfficiencies
+  EfficiencyLookup mEfficiencyTriggerLookup, mEfficiencyAssociatedLookup;
+  std::vector<float> mTriggerWeights, mAssociatedWeights;
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
   using aodCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>>;
   using derivedCollisions = soa::Filtered<aod::CFCollisions>;
+  using compactCollisions = soa::Filtered<soa::Join<aod::CFCollisions, aod::CFMixingBins>>;
   using BinningTypeAOD = ColumnBinningPolicy<aod::collision::PosZ, aod::cent::CentRun2V0M>;
   using BinningTypeDerived = ColumnBinningPolicy<aod::collision::PosZ, aod::cfcollision::Multiplicity>;
 
@@ -147,6 +166,10 @@ struct CorrelationTask {
     same->setTrackEtaCut(cfgCutEta);
     mixed->setTrackEtaCut(cfgCutEta);
 
+    if (cfgBinned) {
+      initBinned(corrAxis);
+    }
+
     // o2-ccdb-upload -p Users/jgrosseo/correlations/LHC15o -f /tmp/correction_2011_global.root -k correction
 
     ccdb->setURL("http://alice-ccdb.cern.ch");
@@ -157,6 +180,41 @@ struct CorrelationTask {
     ccdb->setCreatedNotAfter(now); // TODO must become global parameter from the train creation time
   }
 
+  void initBinned(const std::vector<AxisSpec>& corrAxis)
+  {
+    if (cfg.mPairCuts || cfgTwoTrackCut > 0 || cfgPairCharge != 0) {
+      LOGF(fatal, "Binned correlations cannot apply pair cuts, two-track cuts or pair charge selections");
+    }
+    const AxisSpec& axisEta = corrAxis[0];
+    const AxisSpec& axisPhi = corrAxis[4];
+    if (!axisEta.nBins.has_value() || !axisPhi.nBins.has_value()) {
+      LOGF(fatal, "Binned correlations need fixed-width delta eta and delta phi axes");
+    }
+    // the bin edges have to be multiples of the cell widths, see BinnedCorrelations
+    const double etaCell = (axisEta.binEdges[1] - axisEta.binEdges[0]) / axisEta.nBins.value() / cfgBinnedCells;
+    const double phiCell = (axisPhi.binEdges[1] - axisPhi.binEdges[0]) / axisPhi.nBins.value() / cfgBinnedCells;
+    const int nPhi = std::lround(TwoPI / phiCell);
+    if (std::abs(nPhi * phiCell - TwoPI) > 1e-4 || std::abs(axisPhi.binEdges[0] / phiCell - std::lround(axisPhi.binEdges[0] / phiCell)) > 1e-3 ||
+        std::abs(axisEta.binEdges[0] / etaCell - std::lround(axisEta.binEdges[0] / etaCell)) > 1e-3) {
+      LOGF(fatal, "Binned correlations: delta phi axis has to cover 2 pi and the axis edges have to be multiples of the cell widths");
+    }
+
+    auto getEdges = [](const AxisSpec& axis) {
+      if (!axis.nBins.has_value()) {
+        return axis.binEdges;
+      }
+      std::vector<double> edges;
+      for (int i = 0; i <= axis.nBins.value(); i++) {
+        edges.push_back(axis.binEdges[0] + i * (axis.binEdges[1] - axis.binEdges[0]) / axis.nBins.value());
+      }
+      return edges;
+    };
+    for (auto& binned : mBinned) {
+      binned.init(getEdges(corrAxis[2]), getEdges(corrAxis[1]), cfgCutEta, etaCell, nPhi, cfgPtOrder != 0);
+    }
+    LOGF(info, "Binned correlations with %d x %d cells in eta x phi", static_cast<int>(std::lround(2 * cfgCutEta / etaCell)), nPhi);
+  }
+
   int getMagneticField(uint64_t timestamp)
   {
     // TODO done only once (and not per run). Will be replaced by CCDBConfigurable
@@ -196,20 +254,82 @@ struct CorrelationTask {
   }
 
   template <typename TTarget, typename TTracks>
-  void fillCorrelations(TTarget target, TTracks tracks1, TTracks tracks2, float centrality, float posZ, int magField, float eventWeight)
+  void fillCorrelationsBinned(TTarget target, TTracks tracks1, TTracks tracks2, float centrality, float posZ, float eventWeight)
   {
-    // Cache efficiency for particles (too many FindBin lookups)
-    float* efficiencyAssociated = nullptr;
-    if (cfg.mEfficiencyAssociated) {
-      efficiencyAssociated = new float[tracks2.size()];
-      int i = 0;
-      for (auto& track : tracks2) {
-        efficiencyAssociated[i++] = getEfficiency(cfg.mEfficiencyAssociated, track.eta(), track.pt(), centrality, posZ);
+    // same event if both track tables are the ones of one collision
+    const bool sameEvent = tracks1.size() == tracks2.size() && tracks1.size() > 0 && tracks1.begin().globalIndex() == tracks2.begin().globalIndex();
+    BinnedCorrelations& triggers = mBinned[0];
+    BinnedCorrelations& associated = sameEvent ? mBinned[0] : mBinned[1];
+    triggers.clear();
+    associated.clear();
+    fillEfficiencies(tracks1, tracks2, centrality, posZ);
+
+    int i = -1;
+    for (auto& track1 : tracks1) {
+      i++;
+      if (cfgTriggerCharge != 0 && cfgTriggerCharge * track1.sign() < 0) {
+        continue;
+      }
+      float triggerWeight = 1.0;
+      if (cfg.mEfficiencyTrigger) {
+        triggerWeight = mTriggerWeights[i];
+      }
+      target->getTriggerHist()->Fill(CorrelationContainer::kCFStepReconstructed, track1.pt(), centrality, posZ, triggerWeight * eventWeight);
+      triggers.addTrigger(track1.pt(), track1.eta(), track1.phi(), triggerWeight * eventWeight);
+    }
+
+    i = -1;
+    for (auto& track2 : tracks2) {
+      i++;
+      if (cfgAssociatedCharge != 0 && cfgAssociatedCharge * track2.sign() < 0) {
+        continue;
+      }
+      float associatedWeight = 1.0;
+      if (cfg.mEfficiencyAssociated) {
+        associatedWeight = mAssociatedWeights[i];
+      }
+      associated.addAssociated(track2.pt(), track2.eta(), track2.phi(), associatedWeight);
+      if (sameEvent && (cfgTriggerCharge == 0 || cfgTriggerCharge * track2.sign() >= 0)) {
+        float triggerWeight = 1.0;
+        if (cfg.mEfficiencyTrigger) {
+          // same table, the track has the same index in tracks1
+          triggerWeight = mTriggerWeights[i];
+        }
+        associated.removeSelfPair(track2.pt(), triggerWeight * eventWeight * associatedWeight);
       }
     }
 
+    int lastPtTrigger = -1;
+    triggers.correlate(associated, [&](int ptTrigger, int ptAssoc, float deltaEta, float deltaPhi, double sumw, double sumw2) {
+      if (deltaPhi > 1.5f * PI) {
+        deltaPhi -= TwoPI;
+      }
+      if (deltaPhi < -PIHalf) {
+        deltaPhi += TwoPI;
+      }
+      if (ptTrigger != lastPtTrigger) {
+        target->setPairFillTrigger(triggers.getPtTriggerCenter(ptTrigger), centrality, posZ);
+        lastPtTrigger = ptTrigger;
+      }
+      target->fillPairSum(CorrelationContainer::kCFStepReconstructed, deltaEta, triggers.getPtAssocCenter(ptAssoc), deltaPhi, sumw, sumw2);
+    });
+  }
+
+  template <typename TTarget, typename TTracks>
+  void fillCorrelations(TTarget target, TTracks tracks1, TTracks tracks2, float centrality, float posZ, int magField, float eventWeight)
+  {
+    if (cfgBinned) {
+      fillCorrelationsBinned(target, tracks1, tracks2, centrality, posZ, eventWeight);
+      return;
+    }
+
+    // efficiencies of the particles computed once, not in the pair loop
+    fillEfficiencies(tracks1, tracks2, centrality, posZ);
+
+    int i1 = -1;
     for (auto& track1 : tracks1) {
       // LOGF(info, "Track %f | %f | %f  %d %d", track1.eta(), track1.phi(), track1.pt(), track1.isGlobalTrack(), track1.isGlobalTrackSDD());
+      i1++;
 
       if (cfgTriggerCharge != 0 && cfgTriggerCharge * track1.sign() < 0) {
         continue;
@@ -217,11 +337,18 @@ struct CorrelationTask {
 
       float triggerWeight = 1.0;
       if (cfg.mEfficiencyTrigger) {
-        triggerWeight = getEfficiency(cfg.mEfficiencyTrigger, track1.eta(), track1.pt(), centrality, posZ);
+        triggerWeight = mTriggerWeights[i1];
       }
 
       target->getTriggerHist()->Fill(CorrelationContainer::kCFStepReconstructed, track1.pt(), centrality, posZ, triggerWeight * eventWeight);
 
+      // pairs of this trigger are filled in one go, with the bins of the trigger axes found once
+      target->setPairFillTrigger(track1.pt(), centrality, posZ);
+      mPairDeltaEta.clear();
+      mPairPtAssoc.clear();
+      mPairDeltaPhi.clear();
+      mPairWeight.clear();
+
       int i = -1;
       for (auto& track2 : tracks2) {
         i++; // HACK
@@ -250,7 +377,7 @@ struct CorrelationTask {
 
         float associatedWeight = 1.0;
         if (cfg.mEfficiencyAssociated) {
-          associatedWeight = efficiencyAssociated[i];
+          associatedWeight = mAssociatedWeights[i];
         }
 
         float deltaPhi = track1.phi() - track2.phi();
@@ -261,13 +388,13 @@ struct CorrelationTask {
           deltaPhi += TwoPI;
         }
 
-        target->getPairHist()->Fill(CorrelationContainer::kCFStepReconstructed,
-                                    track1.eta() - track2.eta(), track2.pt(), track1.pt(), centrality, deltaPhi, posZ,
-                                    triggerWeight * associatedWeight * eventWeight);
+        mPairDeltaEta.push_back(track1.eta() - track2.eta());
+        mPairPtAssoc.push_back(track2.pt());
+        mPairDeltaPhi.push_back(deltaPhi);
+        mPairWeight.push_back(triggerWeight * associatedWeight * eventWeight);
       }
+      target->fillPairs(CorrelationContainer::kCFStepReconstructed, mPairDeltaEta.size(), mPairDeltaEta.data(), mPairPtAssoc.data(), mPairDeltaPhi.data(), mPairWeight.data());
     }
-
-    delete[] efficiencyAssociated;
   }
 
   // Version with explicit nested loop
@@ -317,6 +444,19 @@ struct CorrelationTask {
   }
   PROCESS_SWITCH(CorrelationTask, processSameDerived, "Process same event on derived data", false);
 
+  void processSameDerivedCompact(compactCollisions::iterator const& collision, compactTracks const& tracks)
+  {
+    LOGF(info, "processSameDerivedCompact: Tracks for collision: %d | Vertex: %.1f | V0M: %.1f", tracks.size(), collision.posZ(), collision.multiplicity());
+
+    const auto centrality = collision.multiplicity();
+
+    same->fillEvent(centrality, CorrelationContainer::kCFStepReconstructed);
+    registry.fill(HIST("eventcount"), -2);
+    fillQA(collision, centrality, tracks);
+    fillCorrelations(same, tracks, tracks, centrality, collision.posZ(), getMagneticField(collision.timestamp()), 1.0f);
+  }
+  PROCESS_SWITCH(CorrelationTask, processSameDerivedCompact, "Process same event on compact derived data", false);
+
   void processMixedAOD(aodCollisions& collisions, aodTracks const& tracks, aod::BCsWithTimestamps const&)
   {
     // TODO loading of efficiency histogram missing here, because it will happen somehow in the CCDBConfigurable
@@ -378,6 +518,30 @@ struct CorrelationTask {
   }
   PROCESS_SWITCH(CorrelationTask, processMixedDerived, "Process mixed events on derived data", false);
 
+  void processMixedDerivedCompact(compactCollisions& collisions, compactTracks const& tracks)
+  {
+    // the mixing bins are the ones computed by the filter task, whose binning has to match axisVertex and axisMultiplicity
+    NoBinningPolicy<aod::cfcollision::MixingBin> binning;
+    auto tracksTuple = std::make_tuple(tracks);
+    SameKindPair<compactCollisions, compactTracks, NoBinningPolicy<aod::cfcollision::MixingBin>> pairInProcess{binning, cfgNoMixedEvents, -1, collisions, tracksTuple}; // -1 is the number of the bin to skip
+
+    for (auto& [collision1, tracks1, collision2, tracks2] : pairInProcess) {
+      int bin = collision1.mixingBin();
+      // TODO get these from the mixed-event information
+      int eventsInBin = 5;
+      int isFirstEvent = true;
+      LOGF(info, "processMixedDerivedCompact: Mixed collisions bin: %d pair: %d (%.3f, %.3f), %d (%.3f, %.3f)", bin, collision1.globalIndex(), collision1.posZ(), collision1.multiplicity(), collision2.globalIndex(), collision2.posZ(), collision2.multiplicity());
+
+      if (isFirstEvent) {
+        registry.fill(HIST("eventcount"), bin);
+        mixed->fillEvent(collision1.multiplicity(), CorrelationContainer::kCFStepReconstructed);
+      }
+
+      fillCorrelations(mixed, tracks1, tracks2, collision1.multiplicity(), collision1.posZ(), getMagneticField(collision1.timestamp()), 1.0f / eventsInBin);
+    }
+  }
+  PROCESS_SWITCH(CorrelationTask, processMixedDerivedCompact, "Process mixed events on compact derived data", false);
+
   // Version with combinations
   void processWithCombinations(soa::Join<aod::Collisions, aod::CentRun2V0Ms>::iterator const& collision, aod::BCsWithTimestamps const&, soa::Filtered<aod::Tracks> const& tracks)
   {
@@ -437,14 +601,26 @@ struct CorrelationTask {
 
   PROCESS_SWITCH(CorrelationTask, processWithCombinations, "Process same event on AOD with combinations", false);
 
-  double getEfficiency(THn* eff, float eta, float pt, float centrality, float posZ)
+  // Efficiencies of the trigger particles of tracks1 and of the associated particles of tracks2, in the order of the tables
+  template <typename TTracks>
+  void fillEfficiencies(TTracks const& tracks1, TTracks const& tracks2, float centrality, float posZ)
   {
-    int effVars[4];
-    effVars[0] = eff->GetAxis(0)->FindBin(eta);
-    effVars[1] = eff->GetAxis(1)->FindBin(pt);
-    effVars[2] = eff->GetAxis(2)->FindBin(centrality);
-    effVars[3] = eff->GetAxis(3)->FindBin(posZ);
-    return eff->GetBinContent(effVars);
+    if (cfg.mEfficiencyTrigger) {
+      mEfficiencyTriggerLookup.update(cfg.mEfficiencyTrigger);
+      mEfficiencyTriggerLookup.setEvent(centrality, posZ);
+      mTriggerWeights.clear();
+      for (auto& track : tracks1) {
+        mTriggerWeights.push_back(mEfficiencyTriggerLookup.get(track.eta(), track.pt()));
+      }
+    }
+    if (cfg.mEfficiencyAssociated) {
+      mEfficiencyAssociatedLookup.update(cfg.mEfficiencyAssociated);
+      mEfficiencyAssociatedLookup.setEvent(centrality, posZ);
+      mAssociatedWeights.clear();
+      for (auto& track : tracks2) {
+        mAssociatedWeights.push_back(mEfficiencyAssociatedLookup.get(track.eta(), track.pt()));
+      }
+    }
   }
 };
 
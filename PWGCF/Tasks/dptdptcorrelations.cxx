@@ -34,8 +34,13 @@
 #include <TH3.h>
 #include <TProfile3D.h>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <ctime>
+#include <functional>
+#include <thread>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -60,11 +65,95 @@ float deltaphilow = 0.0 - deltaphibinwidth / 2.0;
 float deltaphiup = constants::math::TwoPI - deltaphibinwidth / 2.0;
 
 bool processpairs = false;
+int pairthreads = 1;                      // max. number of threads of the pair kernel
+constexpr long pairsperthreadmin = 20000; // min. number of track pairs per pair kernel thread
 std::string fTaskConfigurationString = "PendingToConfigure";
 
 PairCuts fPairCuts;              // pair suppression engine
 bool fUseConversionCuts = false; // suppress resonances and conversions
 bool fUseTwoTrackCut = false;    // suppress too close tracks
+
+/// \brief the accepted tracks of a collision, classified once per track type in compact arrays
+/// The store is filled in a single pass over the collision tracks and then used by the
+/// data collecting engine for the singles, the tracks and the pairs stages
+struct TrackStore {
+  /// \brief the tracks of one type, one or two
+  struct Tracks {
+    std::vector<float> eta;   ///< the track \f$\eta\f$
+    std::vector<float> phi;   ///< the track \f$\varphi\f$, not origin shifted
+    std::vector<float> pt;    ///< the track \f$p_T\f$
+    std::vector<short> sign;  ///< the track charge sign
+    std::vector<int> etaix;   ///< zero based \f$\eta\f$ bin index
+    std::vector<int> phiix;   ///< zero based, origin shifted, \f$\varphi\f$ bin index
+    std::vector<int> ptbin;   ///< \f$p_T\f$ bin, including underflow and overflow, as the \f$p_T\f$ histograms axes
+    std::vector<float> corr;  ///< the track NUA&NUE correction, filled by the data collecting engine
+    std::vector<float> ptavg; ///< the track \f$\langle p_T\rangle\f$, filled by the data collecting engine
+
+    int size() const { return pt.size(); }
+
+    void clear()
+    {
+      eta.clear();
+      phi.clear();
+      pt.clear();
+      sign.clear();
+      etaix.clear();
+      phiix.clear();
+      ptbin.clear();
+      corr.clear();
+      ptavg.clear();
+    }
+
+    void add(float teta, float tphi, float tpt, short tsign)
+    {
+      eta.push_back(teta);
+      phi.push_back(tphi);
+      pt.push_back(tpt);
+      sign.push_back(tsign);
+      etaix.push_back(int((teta - etalow) / etabinwidth));
+      /* consider a potential phi origin shift */
+      float sphi = (not(tphi < phiup)) ? tphi - constants::math::TwoPI : tphi;
+      phiix.push_back(int((sphi - philow) / phibinwidth));
+      /* as TAxis::FindFixBin */
+      if (tpt < ptlow) {
+        ptbin.push_back(0);
+      } else if (not(tpt < ptup)) {
+        ptbin.push_back(ptbins + 1);
+      } else {
+        ptbin.push_back(1 + int(ptbins * (double(tpt) - double(ptlow)) / (double(ptup) - double(ptlow))));
+      }
+    }
+  };
+
+  /// \brief one track of the store, with the accessors needed by the pair cuts
+  struct Track {
+    Tracks const* tracks;
+    int index;
+    float pt() const { return tracks->pt[index]; }
+    float eta() const { return tracks->eta[index]; }
+    float phi() const { return tracks->phi[index]; }
+    short sign() const { return tracks->sign[index]; }
+  };
+
+  Tracks tracks[2]; ///< the tracks type one and two
+
+  /// \brief classifies the tracks of a collision
+  /// \param colltracks the tracks of the collision, with their accepted as type one and two flags
+  template <typename TrackListObject>
+  void fill(TrackListObject const& colltracks)
+  {
+    tracks[0].clear();
+    tracks[1].clear();
+    for (auto& track : colltracks) {
+      if (track.trackacceptedasone() == uint8_t(true)) {
+        tracks[0].add(track.eta(), track.phi(), track.pt(), track.sign());
+      }
+      if (track.trackacceptedastwo() == uint8_t(true)) {
+        tracks[1].add(track.eta(), track.phi(), track.pt(), track.sign());
+      }
+    }
+  }
+};
 } // namespace correlationstask
 
 // Task for building <dpt,dpt> correlations
@@ -116,6 +205,43 @@ struct DptDptCorrelationsTask {
     const char* trackPairsNames[4] = {"OO", "OT", "TO", "TT"};
     bool ccdbstored = false;
 
+    /// \brief the pair magnitudes of the current collision
+    struct PairMagnitudes {
+      double n2 = 0;           ///< weighted number of track 1 track 2 pairs
+      double n2sup = 0;        ///< weighted number of track 1 track 2 suppressed pairs
+      double sum2PtPt = 0;     ///< accumulated sum of weighted track 1 track 2 \f${p_T}_1 {p_T}_2\f$
+      double sum2DptDpt = 0;   ///< accumulated sum of weighted \f$({p_T}_1- <{p_T}_1>) ({p_T}_2 - <{p_T}_2>)\f$
+      double n2nw = 0;         ///< not weighted number of track1 track 2 pairs
+      double sum2PtPtnw = 0;   ///< accumulated sum of not weighted track 1 track 2 \f${p_T}_1 {p_T}_2\f$
+      double sum2DptDptnw = 0; ///< accumulated sum of not weighted \f$({p_T}_1- <{p_T}_1>) ({p_T}_2 - <{p_T}_2>)\f$
+    };
+
+    /// \brief local accumulators of the pair histograms of one track combination
+    /// They are flushed into the histograms once per dataframe, see flushPairs()
+    struct PairAccumulator {
+      std::vector<double> n2;          ///< two-particle distribution vs the \f$\Delta\eta,\;\Delta\phi\f$ global bin
+      std::vector<double> sum2PtPt;    ///< two-particle \f$\sum {p_T}_1 {p_T}_2\f$ vs the \f$\Delta\eta,\;\Delta\phi\f$ global bin
+      std::vector<double> sum2DptDpt;  ///< two-particle \f$\sum ({p_T}_1- <{p_T}_1>) ({p_T}_2 - <{p_T}_2>)\f$ vs the \f$\Delta\eta,\;\Delta\phi\f$ global bin
+      std::vector<double> supN1N1;     ///< suppressed two-particle distribution vs the \f$\Delta\eta,\;\Delta\phi\f$ global bin
+      std::vector<double> supPt1Pt1;   ///< suppressed \f${p_T}_1 {p_T}_2\f$ vs the \f$\Delta\eta,\;\Delta\phi\f$ global bin
+      std::vector<double> n2PtPt;      ///< two-particle distribution vs the \f${p_T}_1, {p_T}_2\f$ global bin
+      std::vector<double> n2PtPtSumw2; ///< its sum of squared weights, only if the histogram has the Sumw2 structure
+      double n2PtPtStats[7] = {0};     ///< the TH2 statistics of the \f${p_T}_1, {p_T}_2\f$ filling
+      double n2PtPtEntries = 0;        ///< the entries of the \f${p_T}_1, {p_T}_2\f$ filling
+      double entries = 0;              ///< the entries of the differential histograms
+      double supEntries = 0;           ///< the entries of the suppressed differential histograms
+      bool filled = false;             ///< something to flush
+      /* scratch arrays of the pair kernel, one value per associated track */
+      std::vector<int> bin;
+      std::vector<int> ptptbin;
+      std::vector<double> w;
+      std::vector<double> wptpt;
+      std::vector<double> wdptdpt;
+      std::vector<double> wptptin;
+    };
+
+    std::vector<std::array<PairAccumulator, nTrackPairs>> fPairAccumulators; ///< pair accumulators, per pair kernel thread and track combination
+
     float isCCDBstored()
     {
       return ccdbstored;
@@ -210,56 +336,57 @@ struct DptDptCorrelationsTask {
       ccdbstored = true;
     }
 
-    template <typename TrackListObject>
-    std::vector<float>* getTrackCorrections(TrackListObject const& tracks, int tix, float zvtx)
+    /// \brief stores the NUA&NUE corrections of the tracks
+    /// \param tracks the tracks of the intended type
+    /// \param tix index, in the corrections bank, for the passed tracks
+    /// \param zvtx the collision vertex z coordinate
+    void fillTrackCorrections(correlationstask::TrackStore::Tracks& tracks, int tix, float zvtx)
     {
-      std::vector<float>* corr = new std::vector<float>(tracks.size(), 1.0f);
+      using namespace o2::analysis::dptdptfilter;
+
+      tracks.corr.assign(tracks.size(), 1.0f);
       if (fhNuaNue_vsZEtaPhiPt[tix] != nullptr) {
-        int index = 0;
-        for (auto t : tracks) {
-          (*corr)[index] = fhNuaNue_vsZEtaPhiPt[tix]->GetBinContent(zvtx, GetEtaPhiIndex(t) + 0.5, t.pt());
-          index++;
+        for (int index = 0; index < tracks.size(); ++index) {
+          tracks.corr[index] = fhNuaNue_vsZEtaPhiPt[tix]->GetBinContent(zvtx, tracks.etaix[index] * phibins + tracks.phiix[index] + 0.5, tracks.pt[index]);
         }
       }
-      return corr;
     }
 
-    template <typename TrackListObject>
-    std::vector<float>* getPtAvg(TrackListObject const& tracks, int tix)
+    /// \brief stores the \f$\langle p_T\rangle\f$ of the tracks
+    /// \param tracks the tracks of the intended type
+    /// \param tix index, in the \f$\langle p_T\rangle\f$ bank, for the passed tracks
+    void fillPtAverages(correlationstask::TrackStore::Tracks& tracks, int tix)
     {
-      std::vector<float>* ptavg = new std::vector<float>(tracks.size(), 0.0f);
+      tracks.ptavg.assign(tracks.size(), 0.0f);
       if (fhPtAvg_vsEtaPhi[tix] != nullptr) {
-        int index = 0;
-        for (auto t : tracks) {
-          (*ptavg)[index] = fhPtAvg_vsEtaPhi[tix]->GetBinContent(fhPtAvg_vsEtaPhi[tix]->FindBin(t.eta(), t.phi()));
-          index++;
+        for (int index = 0; index < tracks.size(); ++index) {
+          tracks.ptavg[index] = fhPtAvg_vsEtaPhi[tix]->GetBinContent(fhPtAvg_vsEtaPhi[tix]->FindBin(tracks.eta[index], tracks.phi[index]));
         }
       }
-      return ptavg;
     }
 
     /// \brief fills the singles histograms in singles execution mode
-    /// \param passedtracks filtered table with the tracks associated to the passed index
-    /// \param tix index, in the singles histogram bank, for the passed filetered track table
-    template <typename TrackListObject>
-    void processSingles(TrackListObject const& passedtracks, std::vector<float>* corrs, int tix, float zvtx)
+    /// \param passedtracks the tracks of the intended type
+    /// \param tix index, in the singles histogram bank, for the passed tracks
+    void processSingles(correlationstask::TrackStore::Tracks const& passedtracks, int tix, float zvtx)
     {
-      int index = 0;
-      for (auto& track : passedtracks) {
-        float corr = (*corrs)[index];
-        fhN1_vsPt[tix]->Fill(track.pt(), corr);
-        fhN1_vsZEtaPhiPt[tix]->Fill(zvtx, GetEtaPhiIndex(track) + 0.5, track.pt(), corr);
-        fhSum1Pt_vsZEtaPhiPt[tix]->Fill(zvtx, GetEtaPhiIndex(track) + 0.5, track.pt(), track.pt() * corr);
-        index++;
+      using namespace o2::analysis::dptdptfilter;
+
+      for (int index = 0; index < passedtracks.size(); ++index) {
+        float corr = passedtracks.corr[index];
+        float pt = passedtracks.pt[index];
+        int etaphiix = passedtracks.etaix[index] * phibins + passedtracks.phiix[index];
+        fhN1_vsPt[tix]->Fill(pt, corr);
+        fhN1_vsZEtaPhiPt[tix]->Fill(zvtx, etaphiix + 0.5, pt, corr);
+        fhSum1Pt_vsZEtaPhiPt[tix]->Fill(zvtx, etaphiix + 0.5, pt, pt * corr);
       }
     }
 
     /// \brief fills the singles histograms in pair execution mode
-    /// \param passedtracks filtered table with the tracks associated to the passed index
-    /// \param tix index, in the singles histogram bank, for the passed filetered track table
+    /// \param passedtracks the tracks of the intended type
+    /// \param tix index, in the singles histogram bank, for the passed tracks
     /// \param cmul centrality - multiplicity for the collision being analyzed
-    template <typename TrackListObject>
-    void processTracks(TrackListObject const& passedtracks, std::vector<float>* corrs, int tix, float cmul)
+    void processTracks(correlationstask::TrackStore::Tracks const& passedtracks, int tix, float cmul)
     {
       LOGF(DPTDPTLOGCOLLISIONS, "Processing %d tracks of type %d in a collision with cent/mult %f ", passedtracks.size(), tix, cmul);
 
@@ -268,17 +395,16 @@ struct DptDptCorrelationsTask {
       double sum1Pt = 0;   ///< accumulated sum of weighted track 1 \f$p_T\f$ for current collision
       double n1nw = 0;     ///< not weighted number of track 1 tracks for current collision
       double sum1Ptnw = 0; ///< accumulated sum of not weighted track 1 \f$p_T\f$ for current collision
-      int index = 0;
-      for (auto& track : passedtracks) {
-        float corr = (*corrs)[index];
+      for (int index = 0; index < passedtracks.size(); ++index) {
+        float corr = passedtracks.corr[index];
+        float pt = passedtracks.pt[index];
         n1 += corr;
-        sum1Pt += track.pt() * corr;
+        sum1Pt += pt * corr;
         n1nw += 1;
-        sum1Ptnw += track.pt();
+        sum1Ptnw += pt;
 
-        fhN1_vsEtaPhi[tix]->Fill(track.eta(), GetShiftedPhi(track.phi()), corr);
-        fhSum1Pt_vsEtaPhi[tix]->Fill(track.eta(), GetShiftedPhi(track.phi()), track.pt() * corr);
-        index++;
+        fhN1_vsEtaPhi[tix]->Fill(passedtracks.eta[index], GetShiftedPhi(passedtracks.phi[index]), corr);
+        fhSum1Pt_vsEtaPhi[tix]->Fill(passedtracks.eta[index], GetShiftedPhi(passedtracks.phi[index]), pt * corr);
       }
       fhN1_vsC[tix]->Fill(cmul, n1);
       fhSum1Pt_vsC[tix]->Fill(cmul, sum1Pt);
@@ -286,114 +412,364 @@ struct DptDptCorrelationsTask {
       fhSum1Ptnw_vsC[tix]->Fill(cmul, sum1Ptnw);
     }
 
-    /// \brief fills the pair histograms in pair execution mode
-    /// \param trks1 filtered table with the tracks associated to the first track in the pair
-    /// \param trks2 filtered table with the tracks associated to the second track in the pair
-    /// \param pix index, in the track combination histogram bank, for the passed filetered track tables
-    /// \param cmul centrality - multiplicity for the collision being analyzed
-    /// Be aware that at least in half of the cases traks1 and trks2 will have the same content
-    template <trackpairs pix, typename TrackOneListObject, typename TrackTwoListObject>
-    void processTrackPairs(TrackOneListObject const& trks1, TrackTwoListObject const& trks2, std::vector<float>* corrs1, std::vector<float>* corrs2, std::vector<float>* ptavgs1, std::vector<float>* ptavgs2, float cmul, int bfield)
+    /// \brief the pair kernel: accumulates the pairs of a range of trigger tracks
+    /// \param t1 the tracks associated to the first track in the pair
+    /// \param t2 the tracks associated to the second track in the pair
+    /// \param sametracks true if both track lists are the same, the pairs of a track with itself are then excluded
+    /// \param first the first trigger track of the range
+    /// \param last the trigger track after the last one of the range
+    /// \param acc the pair accumulator to fill
+    /// \param mag the pair magnitudes to update
+    /// For each trigger track the bins and weights of all its pairs are computed
+    /// in a first branchless loop, and added to the accumulators in a second one.
+    /// No pair cut is applied so the kernel only touches its accumulator and
+    /// several ranges can be processed in parallel.
+    void pairKernel(correlationstask::TrackStore::Tracks const& t1, correlationstask::TrackStore::Tracks const& t2, bool sametracks, int first, int last, PairAccumulator& acc, PairMagnitudes& mag)
+    {
+      using namespace correlationstask;
+      using namespace o2::analysis::dptdptfilter;
+
+      const int ntrks2 = t2.pt.size();
+      const int stride = deltaetabins + 2;
+      const int ptstride = ptbins + 2;
+      acc.bin.resize(ntrks2);
+      acc.ptptbin.resize(ntrks2);
+      acc.w.resize(ntrks2);
+      acc.wptpt.resize(ntrks2);
+      acc.wdptdpt.resize(ntrks2);
+      acc.wptptin.resize(ntrks2);
+      int* bin = acc.bin.data();
+      int* ptptbin = acc.ptptbin.data();
+      double* w = acc.w.data();
+      double* wptpt = acc.wptpt.data();
+      double* wdptdpt = acc.wdptdpt.data();
+      double* wptptin = acc.wptptin.data();
+      const int* etaix2 = t2.etaix.data();
+      const int* phiix2 = t2.phiix.data();
+      const int* ptbin2 = t2.ptbin.data();
+      const float* pt2 = t2.pt.data();
+      const float* corr2 = t2.corr.data();
+      const float* ptavg2 = t2.ptavg.data();
+      double* n2 = acc.n2.data();
+      double* sum2PtPt = acc.sum2PtPt.data();
+      double* sum2DptDpt = acc.sum2DptDpt.data();
+      double* n2PtPt = acc.n2PtPt.data();
+      double* n2PtPtSumw2 = acc.n2PtPtSumw2.empty() ? nullptr : acc.n2PtPtSumw2.data();
+
+      for (int i = first; i < last; ++i) {
+        const float pt1 = t1.pt[i];
+        const double corr1 = t1.corr[i];
+        const double ptavg1 = t1.ptavg[i];
+        const double dpt1w = corr1 * pt1 - ptavg1;
+        const double dpt1nw = pt1 - ptavg1;
+        /* the one based delta eta bin is etaix_1 - etaix_2 + etabins */
+        const int etaoffset = t1.etaix[i] + etabins;
+        const int phiix1 = t1.phiix[i];
+        const int ptbin1 = t1.ptbin[i];
+        /* the trigger track itself is skipped by splitting the associated tracks in two ranges */
+        const int self = sametracks ? i : ntrks2;
+        const int ranges[2][2] = {{0, std::min(self, ntrks2)}, {std::min(self + 1, ntrks2), ntrks2}};
+
+        double n2trk = 0;
+        double sum2PtPttrk = 0;
+        double sum2DptDpttrk = 0;
+        double sum2PtPtnwtrk = 0;
+        double sum2DptDptnwtrk = 0;
+        for (auto const& range : ranges) {
+          for (int j = range[0]; j < range[1]; ++j) {
+            int deltaphi_ix = phiix1 - phiix2[j];
+            deltaphi_ix += (deltaphi_ix < 0) ? phibins : 0;
+            bin[j] = (etaoffset - etaix2[j]) + stride * (deltaphi_ix + 1);
+            ptptbin[j] = ptbin1 + ptstride * ptbin2[j];
+            const double corr_2 = corr2[j];
+            const double ptavg_2 = ptavg2[j];
+            const double corr = corr1 * corr_2;
+            w[j] = corr;
+            wptpt[j] = pt1 * pt2[j] * corr;
+            wdptdpt[j] = dpt1w * (corr_2 * pt2[j] - ptavg_2);
+            /* only the pairs within the pT ranges enter in the statistics of the pT pT histogram */
+            wptptin[j] = (ptbin2[j] > 0 and ptbin2[j] <= ptbins) ? corr : 0.0;
+            n2trk += corr;
+            sum2PtPttrk += wptpt[j];
+            sum2DptDpttrk += wdptdpt[j];
+            sum2PtPtnwtrk += pt1 * pt2[j];
+            sum2DptDptnwtrk += dpt1nw * (pt2[j] - ptavg_2);
+          }
+        }
+        double sw = 0;
+        double sw2 = 0;
+        double swy = 0;
+        double swy2 = 0;
+        for (auto const& range : ranges) {
+          for (int j = range[0]; j < range[1]; ++j) {
+            n2[bin[j]] += w[j];
+            sum2PtPt[bin[j]] += wptpt[j];
+            sum2DptDpt[bin[j]] += wdptdpt[j];
+            n2PtPt[ptptbin[j]] += w[j];
+            if (n2PtPtSumw2 != nullptr) {
+              n2PtPtSumw2[ptptbin[j]] += w[j] * w[j];
+            }
+            sw += wptptin[j];
+            sw2 += wptptin[j] * wptptin[j];
+            swy += wptptin[j] * pt2[j];
+            swy2 += wptptin[j] * pt2[j] * pt2[j];
+          }
+        }
+        const int npairs = (ranges[0][1] - ranges[0][0]) + (ranges[1][1] - ranges[1][0]);
+        if (ptbin1 > 0 and ptbin1 <= ptbins) {
+          const double x = pt1;
+          acc.n2PtPtStats[0] += sw;
+          acc.n2PtPtStats[1] += sw2;
+          acc.n2PtPtStats[2] += sw * x;
+          acc.n2PtPtStats[3] += sw * x * x;
+          acc.n2PtPtStats[4] += swy;
+          acc.n2PtPtStats[5] += swy2;
+          acc.n2PtPtStats[6] += swy * x;
+        }
+        acc.n2PtPtEntries += npairs;
+        acc.filled = acc.filled or (npairs > 0);
+
+        mag.n2 += n2trk;
+        mag.sum2PtPt += sum2PtPttrk;
+        mag.sum2DptDpt += sum2DptDpttrk;
+        mag.n2nw += npairs;
+        mag.sum2PtPtnw += sum2PtPtnwtrk;
+        mag.sum2DptDptnw += sum2DptDptnwtrk;
+      }
+    }
+
+    /// \brief accumulates the pairs one by one, applying the pair cuts
+    /// \param t1 the tracks associated to the first track in the pair
+    /// \param t2 the tracks associated to the second track in the pair
+    /// \param acc the pair accumulator to fill
+    /// \param mag the pair magnitudes to update
+    /// \param bfield the magnetic field for the two-track cut
+    template <trackpairs pix>
+    void processTrackPairsWithCuts(correlationstask::TrackStore::Tracks const& t1, correlationstask::TrackStore::Tracks const& t2, PairAccumulator& acc, PairMagnitudes& mag, int bfield)
     {
       using namespace correlationstask;
 
-      /* process pair magnitudes */
-      double n2 = 0;           ///< weighted number of track 1 track 2 pairs for current collision
-      double n2sup = 0;        ///< weighted number of track 1 track 2 suppressed pairs for current collision
-      double sum2PtPt = 0;     ///< accumulated sum of weighted track 1 track 2 \f${p_T}_1 {p_T}_2\f$ for current collision
-      double sum2DptDpt = 0;   ///< accumulated sum of weighted number of track 1 tracks times weighted track 2 \f$p_T\f$ for current collision
-      double n2nw = 0;         ///< not weighted number of track1 track 2 pairs for current collision
-      double sum2PtPtnw = 0;   ///< accumulated sum of not weighted track 1 track 2 \f${p_T}_1 {p_T}_2\f$ for current collision
-      double sum2DptDptnw = 0; ///< accumulated sum of not weighted number of track 1 tracks times not weighted track 2 \f$p_T\f$ for current collision
-      int index1 = 0;
-
-      for (auto& track1 : trks1) {
-        double ptavg_1 = (*ptavgs1)[index1];
-        double corr1 = (*corrs1)[index1];
-        int index2 = 0;
-        for (auto& track2 : trks2) {
+      const int stride = deltaetabins + 2;
+      const int ptstride = ptbins + 2;
+      for (int index1 = 0; index1 < t1.size(); ++index1) {
+        TrackStore::Track track1{&t1, index1};
+        double ptavg_1 = t1.ptavg[index1];
+        double corr1 = t1.corr[index1];
+        for (int index2 = 0; index2 < t2.size(); ++index2) {
           /* checking the same track id condition */
           if constexpr (pix == kOO or pix == kTT) {
-            if (track1 == track2) {
+            if (index1 == index2) {
               /* exclude autocorrelations */
               continue;
             }
           }
+          TrackStore::Track track2{&t2, index2};
           /* process pair magnitudes */
-          double ptavg_2 = (*ptavgs2)[index2];
-          double corr2 = (*corrs2)[index2];
+          double ptavg_2 = t2.ptavg[index2];
+          double corr2 = t2.corr[index2];
           double corr = corr1 * corr2;
           double dptdptnw = (track1.pt() - ptavg_1) * (track2.pt() - ptavg_2);
           double dptdptw = (corr1 * track1.pt() - ptavg_1) * (corr2 * track2.pt() - ptavg_2);
 
           /* get the global bin for filling the differential histograms */
-          int globalbin = GetDEtaDPhiGlobalIndex(track1, track2);
+          int deltaphi_ix = t1.phiix[index1] - t2.phiix[index2];
+          if (deltaphi_ix < 0) {
+            deltaphi_ix += phibins;
+          }
+          int globalbin = (t1.etaix[index1] - t2.etaix[index2] + etabins) + stride * (deltaphi_ix + 1);
           if ((fUseConversionCuts and fPairCuts.conversionCuts(track1, track2)) or (fUseTwoTrackCut and fPairCuts.twoTrackCut(track1, track2, bfield))) {
             /* suppress the pair */
-            fhSupN1N1_vsDEtaDPhi[pix]->AddBinContent(globalbin, corr);
-            fhSupPt1Pt1_vsDEtaDPhi[pix]->AddBinContent(globalbin, track1.pt() * track2.pt() * corr);
-            n2sup += corr;
+            acc.supN1N1[globalbin] += corr;
+            acc.supPt1Pt1[globalbin] += track1.pt() * track2.pt() * corr;
+            mag.n2sup += corr;
           } else {
             /* count the pair */
-            n2 += corr;
-            sum2PtPt += track1.pt() * track2.pt() * corr;
-            sum2DptDpt += dptdptw;
-            n2nw += 1;
-            sum2PtPtnw += track1.pt() * track2.pt();
-            sum2DptDptnw += dptdptnw;
-
-            fhN2_vsDEtaDPhi[pix]->AddBinContent(globalbin, corr);
-            fhSum2DptDpt_vsDEtaDPhi[pix]->AddBinContent(globalbin, dptdptw);
-            fhSum2PtPt_vsDEtaDPhi[pix]->AddBinContent(globalbin, track1.pt() * track2.pt() * corr);
+            mag.n2 += corr;
+            mag.sum2PtPt += track1.pt() * track2.pt() * corr;
+            mag.sum2DptDpt += dptdptw;
+            mag.n2nw += 1;
+            mag.sum2PtPtnw += track1.pt() * track2.pt();
+            mag.sum2DptDptnw += dptdptnw;
+
+            acc.n2[globalbin] += corr;
+            acc.sum2DptDpt[globalbin] += dptdptw;
+            acc.sum2PtPt[globalbin] += track1.pt() * track2.pt() * corr;
           }
-          fhN2_vsPtPt[pix]->Fill(track1.pt(), track2.pt(), corr);
+          int ptptbin = t1.ptbin[index1] + ptstride * t2.ptbin[index2];
+          acc.n2PtPt[ptptbin] += corr;
+          if (not acc.n2PtPtSumw2.empty()) {
+            acc.n2PtPtSumw2[ptptbin] += corr * corr;
+          }
+          if (t1.ptbin[index1] > 0 and t1.ptbin[index1] <= ptbins and t2.ptbin[index2] > 0 and t2.ptbin[index2] <= ptbins) {
+            double x = track1.pt();
+            double y = track2.pt();
+            acc.n2PtPtStats[0] += corr;
+            acc.n2PtPtStats[1] += corr * corr;
+            acc.n2PtPtStats[2] += corr * x;
+            acc.n2PtPtStats[3] += corr * x * x;
+            acc.n2PtPtStats[4] += corr * y;
+            acc.n2PtPtStats[5] += corr * y * y;
+            acc.n2PtPtStats[6] += corr * x * y;
+          }
+          acc.n2PtPtEntries += 1;
+          acc.filled = true;
         }
       }
-      fhN2_vsC[pix]->Fill(cmul, n2);
-      fhSum2PtPt_vsC[pix]->Fill(cmul, sum2PtPt);
-      fhSum2DptDpt_vsC[pix]->Fill(cmul, sum2DptDpt);
-      fhN2nw_vsC[pix]->Fill(cmul, n2nw);
-      fhSum2PtPtnw_vsC[pix]->Fill(cmul, sum2PtPtnw);
-      fhSum2DptDptnw_vsC[pix]->Fill(cmul, sum2DptDptnw);
+    }
+
+    /// \brief fills the pair histograms in pair execution mode
+    /// \param t1 the tracks associated to the first track in the pair
+    /// \param t2 the tracks associated to the second track in the pair
+    /// \param pix index, in the track combination histogram bank, for the passed tracks
+    /// \param cmul centrality - multiplicity for the collision being analyzed
+    /// Be aware that at least in half of the cases t1 and t2 will be the same tracks
+    /// The differential histograms are filled through the pair accumulators, see flushPairs().
+    /// Without pair cuts the trigger tracks are split among up to pairthreads threads,
+    /// each with its own accumulator, so the result does not depend on the number of threads
+    template <trackpairs pix>
+    void processTrackPairs(correlationstask::TrackStore::Tracks const& t1, correlationstask::TrackStore::Tracks const& t2, float cmul, int bfield)
+    {
+      using namespace correlationstask;
+
+      constexpr bool sametracks = (pix == kOO or pix == kTT);
+      PairMagnitudes mag;
+      if (fUseConversionCuts or fUseTwoTrackCut) {
+        processTrackPairsWithCuts<pix>(t1, t2, fPairAccumulators[0][pix], mag, bfield);
+      } else {
+        const int ntrks1 = t1.pt.size();
+        const long npairs = long(ntrks1) * long(t2.pt.size());
+        const int nthreads = std::clamp<long>(npairs / pairsperthreadmin, 1, std::min<long>(fPairAccumulators.size(), std::max(ntrks1, 1)));
+        if (nthreads == 1) {
+          pairKernel(t1, t2, sametracks, 0, ntrks1, fPairAccumulators[0][pix], mag);
+        } else {
+          const int ntrksperthread = (ntrks1 + nthreads - 1) / nthreads;
+          std::vector<PairMagnitudes> mags(nthreads);
+          std::vector<std::thread> threads;
+          for (int ithread = 1; ithread < nthreads; ++ithread) {
+            const int first = std::min(ntrks1, ithread * ntrksperthread);
+            const int last = std::min(ntrks1, first + ntrksperthread);
+            threads.emplace_back(&DataCollectingEngine::pairKernel, this, std::cref(t1), std::cref(t2), sametracks, first, last, std::ref(fPairAccumulators[ithread][pix]), std::ref(mags[ithread]));
+          }
+          pairKernel(t1, t2, sametracks, 0, std::min(ntrks1, ntrksperthread), fPairAccumulators[0][pix], mags[0]);
+          for (auto& thread : threads) {
+            thread.join();
+          }
+          /* add them in thread order so the result does not depend on the threads timing */
+          for (auto const& m : mags) {
+            mag.n2 += m.n2;
+            mag.sum2PtPt += m.sum2PtPt;
+            mag.sum2DptDpt += m.sum2DptDpt;
+            mag.n2nw += m.n2nw;
+            mag.sum2PtPtnw += m.sum2PtPtnw;
+            mag.sum2DptDptnw += m.sum2DptDptnw;
+          }
+        }
+      }
+      fhN2_vsC[pix]->Fill(cmul, mag.n2);
+      fhSum2PtPt_vsC[pix]->Fill(cmul, mag.sum2PtPt);
+      fhSum2DptDpt_vsC[pix]->Fill(cmul, mag.sum2DptDpt);
+      fhN2nw_vsC[pix]->Fill(cmul, mag.n2nw);
+      fhSum2PtPtnw_vsC[pix]->Fill(cmul, mag.sum2PtPtnw);
+      fhSum2DptDptnw_vsC[pix]->Fill(cmul, mag.sum2DptDptnw);
       /* let's also update the number of entries in the differential histograms */
-      fhN2_vsDEtaDPhi[pix]->SetEntries(fhN2_vsDEtaDPhi[pix]->GetEntries() + n2);
-      fhSum2DptDpt_vsDEtaDPhi[pix]->SetEntries(fhSum2DptDpt_vsDEtaDPhi[pix]->GetEntries() + n2);
-      fhSum2PtPt_vsDEtaDPhi[pix]->SetEntries(fhSum2PtPt_vsDEtaDPhi[pix]->GetEntries() + n2);
-      fhSupN1N1_vsDEtaDPhi[pix]->SetEntries(fhSupN1N1_vsDEtaDPhi[pix]->GetEntries() + n2sup);
-      fhSupPt1Pt1_vsDEtaDPhi[pix]->SetEntries(fhSupPt1Pt1_vsDEtaDPhi[pix]->GetEntries() + n2sup);
+      fPairAccumulators[0][pix].entries += mag.n2;
+      fPairAccumulators[0][pix].supEntries += mag.n2sup;
+      fPairAccumulators[0][pix].filled = true;
     }
 
-    template <typename TrackOneListObject, typename TrackTwoListObject>
-    void processCollision(TrackOneListObject const& Tracks1, TrackTwoListObject const& Tracks2, float zvtx, float centmult, int bfield)
+    /// \brief adds the pair accumulators to the pair histograms and resets them
+    /// To be called once per dataframe, and in any case before the output is written
+    void flushPairs()
+    {
+      for (auto& accs : fPairAccumulators) {
+        for (int pix = 0; pix < nTrackPairs; ++pix) {
+          PairAccumulator& acc = accs[pix];
+          if (not acc.filled) {
+            continue;
+          }
+          TH2F* hdiff[5] = {fhN2_vsDEtaDPhi[pix], fhSum2PtPt_vsDEtaDPhi[pix], fhSum2DptDpt_vsDEtaDPhi[pix], fhSupN1N1_vsDEtaDPhi[pix], fhSupPt1Pt1_vsDEtaDPhi[pix]};
+          std::vector<double>* adiff[5] = {&acc.n2, &acc.sum2PtPt, &acc.sum2DptDpt, &acc.supN1N1, &acc.supPt1Pt1};
+          for (int h = 0; h < 5; ++h) {
+            std::vector<double>& values = *adiff[h];
+            for (int bin = 0; bin < static_cast<int>(values.size()); ++bin) {
+              if (values[bin] != 0) {
+                hdiff[h]->AddBinContent(bin, values[bin]);
+                values[bin] = 0;
+              }
+            }
+          }
+          for (int h = 0; h < 3; ++h) {
+            hdiff[h]->SetEntries(hdiff[h]->GetEntries() + acc.entries);
+          }
+          for (int h = 3; h < 5; ++h) {
+            hdiff[h]->SetEntries(hdiff[h]->GetEntries() + acc.supEntries);
+          }
+
+          /* the statistics are taken before touching the bin contents, GetStats could otherwise recompute them from the bins */
+          TH2F* hptpt = fhN2_vsPtPt[pix];
+          double stats[7];
+          hptpt->GetStats(stats);
+          for (int i = 0; i < 7; ++i) {
+            stats[i] += acc.n2PtPtStats[i];
+            acc.n2PtPtStats[i] = 0;
+          }
+          double entries = hptpt->GetEntries() + acc.n2PtPtEntries;
+          for (int bin = 0; bin < static_cast<int>(acc.n2PtPt.size()); ++bin) {
+            if (acc.n2PtPt[bin] != 0) {
+              hptpt->AddBinContent(bin, acc.n2PtPt[bin]);
+              acc.n2PtPt[bin] = 0;
+            }
+          }
+          if (not acc.n2PtPtSumw2.empty()) {
+            double* sumw2 = hptpt->GetSumw2()->GetArray();
+            for (size_t bin = 0; bin < acc.n2PtPtSumw2.size(); ++bin) {
+              sumw2[bin] += acc.n2PtPtSumw2[bin];
+              acc.n2PtPtSumw2[bin] = 0;
+            }
+          }
+          hptpt->PutStats(stats);
+          hptpt->SetEntries(entries);
+
+          acc.n2PtPtEntries = 0;
+          acc.entries = 0;
+          acc.supEntries = 0;
+          acc.filled = false;
+        }
+      }
+    }
+
+    /// \brief processes a collision
+    /// \param store the accepted tracks of the collision, their corrections and \f$\langle p_T\rangle\f$ are stored here
+    /// \param zvtx the collision vertex z coordinate
+    /// \param centmult the collision centrality - multiplicity
+    /// \param bfield the magnetic field for the two-track cut
+    void processCollision(correlationstask::TrackStore& store, float zvtx, float centmult, int bfield)
     {
       using namespace correlationstask;
-      std::vector<float>* corrs1 = getTrackCorrections(Tracks1, 0, zvtx);
-      std::vector<float>* corrs2 = getTrackCorrections(Tracks2, 1, zvtx);
+      TrackStore::Tracks& Tracks1 = store.tracks[0];
+      TrackStore::Tracks& Tracks2 = store.tracks[1];
+      fillTrackCorrections(Tracks1, 0, zvtx);
+      fillTrackCorrections(Tracks2, 1, zvtx);
 
       if (not processpairs) {
         /* process single tracks */
         fhVertexZA->Fill(zvtx);
-        processSingles(Tracks1, corrs1, 0, zvtx); /* track one */
-        processSingles(Tracks2, corrs2, 1, zvtx); /* track two */
+        processSingles(Tracks1, 0, zvtx); /* track one */
+        processSingles(Tracks2, 1, zvtx); /* track two */
       } else {
         /* process track magnitudes */
-        std::vector<float>* ptavgs1 = getPtAvg(Tracks1, 0);
-        std::vector<float>* ptavgs2 = getPtAvg(Tracks2, 1);
+        fillPtAverages(Tracks1, 0);
+        fillPtAverages(Tracks2, 1);
 
         /* TODO: the centrality should be chosen non detector dependent */
-        processTracks(Tracks1, corrs1, 0, centmult); /* track one */
-        processTracks(Tracks2, corrs2, 1, centmult); /* track one */
+        processTracks(Tracks1, 0, centmult); /* track one */
+        processTracks(Tracks2, 1, centmult); /* track one */
         /* process pair magnitudes */
-        processTrackPairs<kOO>(Tracks1, Tracks1, corrs1, corrs1, ptavgs1, ptavgs1, centmult, bfield);
-        processTrackPairs<kOT>(Tracks1, Tracks2, corrs1, corrs2, ptavgs1, ptavgs2, centmult, bfield);
-        processTrackPairs<kTO>(Tracks2, Tracks1, corrs2, corrs1, ptavgs2, ptavgs1, centmult, bfield);
-        processTrackPairs<kTT>(Tracks2, Tracks2, corrs2, corrs2, ptavgs2, ptavgs2, centmult, bfield);
-
-        delete ptavgs1;
-        delete ptavgs2;
+        processTrackPairs<kOO>(Tracks1, Tracks1, centmult, bfield);
+        processTrackPairs<kOT>(Tracks1, Tracks2, centmult, bfield);
+        processTrackPairs<kTO>(Tracks2, Tracks1, centmult, bfield);
+        processTrackPairs<kTT>(Tracks2, Tracks2, centmult, bfield);
       }
-      delete corrs1;
-      delete corrs2;
     }
 
     void init(TList* fOutputList)
@@ -523,6 +899,23 @@ struct DptDptCorrelationsTask {
           fOutputList->Add(fhSum2PtPtnw_vsC[i]);
           fOutputList->Add(fhSum2DptDptnw_vsC[i]);
         }
+
+        /* the pair accumulators, one set per pair kernel thread */
+        fPairAccumulators.resize(pairthreads);
+        for (auto& accs : fPairAccumulators) {
+          for (int i = 0; i < nTrackPairs; ++i) {
+            PairAccumulator& acc = accs[i];
+            acc.n2.assign(fhN2_vsDEtaDPhi[i]->GetNcells(), 0.0);
+            acc.sum2PtPt.assign(fhSum2PtPt_vsDEtaDPhi[i]->GetNcells(), 0.0);
+            acc.sum2DptDpt.assign(fhSum2DptDpt_vsDEtaDPhi[i]->GetNcells(), 0.0);
+            acc.supN1N1.assign(fhSupN1N1_vsDEtaDPhi[i]->GetNcells(), 0.0);
+            acc.supPt1Pt1.assign(fhSupPt1Pt1_vsDEtaDPhi[i]->GetNcells(), 0.0);
+            acc.n2PtPt.assign(fhN2_vsPtPt[i]->GetNcells(), 0.0);
+            if (fhN2_vsPtPt[i]->GetSumw2N() > 0) {
+              acc.n2PtPtSumw2.assign(fhN2_vsPtPt[i]->GetNcells(), 0.0);
+            }
+          }
+        }
       }
       TH1::AddDirectory(oldstatus);
     }
@@ -539,6 +932,9 @@ struct DptDptCorrelationsTask {
   /* the data collecting engine instances */
   DataCollectingEngine** dataCE;
 
+  /* the accepted tracks of the current collision, shared by the data collecting engines */
+  correlationstask::TrackStore fTrackStore;
+
   /* the input file structure from CCDB */
   TList* ccdblst = nullptr;
   bool loadfromccdb = false;
@@ -551,6 +947,7 @@ struct DptDptCorrelationsTask {
   Configurable<float> cfgTwoTrackCutMinRadius{"twotrackcutminradius", 0.8f, "Two-tracks cut: radius in m from which two-tracks cut is applied"};
 
   Configurable<bool> cfgProcessPairs{"processpairs", false, "Process pairs: false = no, just singles, true = yes, process pairs"};
+  Configurable<int> cfgPairThreads{"pairthreads", 1, "Max. number of threads of the pair processing, split over the trigger tracks. Not used with pair cuts"};
   Configurable<std::string> cfgCentSpec{"centralities", "00-05,05-10,10-20,20-30,30-40,40-50,50-60,60-70,70-80", "Centrality/multiplicity ranges in min-max separated by commas"};
 
   Configurable<o2::analysis::DptDptBinningCuts> cfgBinning{"binning",
@@ -584,6 +981,7 @@ struct DptDptCorrelationsTask {
     phiup = constants::math::TwoPI;
     phibinshift = cfgBinning->mPhibinshift;
     processpairs = cfgProcessPairs.value;
+    pairthreads = std::max(1, cfgPairThreads.value);
     loadfromccdb = cfginputfile.cfgCCDBPathName->length() > 0;
     /* update the potential binning change */
     etabinwidth = (etaup - etalow) / float(etabins);
@@ -743,15 +1141,15 @@ struct DptDptCorrelationsTask {
                                        (TH2*)ccdblst->FindObject(TString::Format("ptavgetaphi_%02d-%02d_m", int(fCentMultMin[ixDCE]), int(fCentMultMax[ixDCE])).Data()));
       }
 
-      Partition<o2::aod::ScannedTracks> TracksOne = aod::dptdptfilter::trackacceptedasone == uint8_t(true);
-      Partition<o2::aod::ScannedTracks> TracksTwo = aod::dptdptfilter::trackacceptedastwo == uint8_t(true);
-      TracksOne.bindTable(tracks);
-      TracksTwo.bindTable(tracks);
+      fTrackStore.fill(tracks);
 
       LOGF(DPTDPTLOGCOLLISIONS, "Accepted BC id %d collision with cent/mult %f and %d total tracks. Assigned DCE: %d", collision.bcId(), collision.centmult(), tracks.size(), ixDCE);
-      LOGF(DPTDPTLOGCOLLISIONS, "Accepted new collision with cent/mult %f and %d type one tracks and %d type two tracks. Assigned DCE: %d", collision.centmult(), TracksOne.size(), TracksTwo.size(), ixDCE);
+      LOGF(DPTDPTLOGCOLLISIONS, "Accepted new collision with cent/mult %f and %d type one tracks and %d type two tracks. Assigned DCE: %d", collision.centmult(), fTrackStore.tracks[0].size(), fTrackStore.tracks[1].size(), ixDCE);
       int bfield = (fUseConversionCuts or fUseTwoTrackCut) ? getMagneticField(collision.bc_as<aod::BCsWithTimestamps>().timestamp()) : 0;
-      dataCE[ixDCE]->processCollision(TracksOne, TracksTwo, collision.posZ(), collision.centmult(), bfield);
+      dataCE[ixDCE]->processCollision(fTrackStore, collision.posZ(), collision.centmult(), bfield);
+      if (not doprocessFlushRec) {
+        dataCE[ixDCE]->flushPairs();
+      }
     }
   }
   PROCESS_SWITCH(DptDptCorrelationsTask, processRecLevel, "Process reco level correlations", false);
@@ -774,18 +1172,44 @@ struct DptDptCorrelationsTask {
                                        (TH2*)ccdblst->FindObject(TString::Format("trueptavgetaphi_%02d-%02d_m", int(fCentMultMin[ixDCE]), int(fCentMultMax[ixDCE])).Data()));
       }
 
-      Partition<o2::aod::ScannedTrueTracks> TracksOne = aod::dptdptfilter::trackacceptedasone == uint8_t(true);
-      Partition<o2::aod::ScannedTrueTracks> TracksTwo = aod::dptdptfilter::trackacceptedastwo == uint8_t(true);
-      TracksOne.bindTable(tracks);
-      TracksTwo.bindTable(tracks);
+      fTrackStore.fill(tracks);
 
       LOGF(DPTDPTLOGCOLLISIONS, "Accepted BC id %d generated collision with cent/mult %f and %d total tracks. Assigned DCE: %d", collision.bcId(), collision.centmult(), tracks.size(), ixDCE);
-      LOGF(DPTDPTLOGCOLLISIONS, "Accepted new generated collision with cent/mult %f and %d type one tracks and %d type two tracks. Assigned DCE: %d", collision.centmult(), TracksOne.size(), TracksTwo.size(), ixDCE);
-      dataCE[ixDCE]->processCollision(TracksOne, TracksTwo, collision.posZ(), collision.centmult(), 0.0); /* TODO: this needs more thinking, suppressing pairs on filtered generator level */
+      LOGF(DPTDPTLOGCOLLISIONS, "Accepted new generated collision with cent/mult %f and %d type one tracks and %d type two tracks. Assigned DCE: %d", collision.centmult(), fTrackStore.tracks[0].size(), fTrackStore.tracks[1].size(), ixDCE);
+      dataCE[ixDCE]->processCollision(fTrackStore, collision.posZ(), collision.centmult(), 0.0); /* TODO: this needs more thinking, suppressing pairs on filtered generator level */
+      if (not doprocessFlushGen) {
+        dataCE[ixDCE]->flushPairs();
+      }
     }
   }
   PROCESS_SWITCH(DptDptCorrelationsTask, processGenLevel, "Process generator level correlations", false);
 
+  /// flushes the pair accumulators of the data collecting engines into the pair histograms
+  void flushPairs()
+  {
+    for (int i = 0; i < ncmranges; ++i) {
+      dataCE[i]->flushPairs();
+    }
+  }
+
+  /// flushes the pair histograms once per dataframe, after all its reco level collisions
+  /// if not enabled they are flushed after each collision
+  void processFlushRec(aod::DptDptCFAcceptedCollisions const& colls)
+  {
+    LOGF(DPTDPTLOGCOLLISIONS, "Flushing the pairs of %d reco level collisions", colls.size());
+    flushPairs();
+  }
+  PROCESS_SWITCH(DptDptCorrelationsTask, processFlushRec, "Flush the reco level pair histograms once per dataframe", false);
+
+  /// flushes the pair histograms once per dataframe, after all its generator level collisions
+  /// if not enabled they are flushed after each collision
+  void processFlushGen(aod::DptDptCFAcceptedTrueCollisions const& colls)
+  {
+    LOGF(DPTDPTLOGCOLLISIONS, "Flushing the pairs of %d generator level collisions", colls.size());
+    flushPairs();
+  }
+  PROCESS_SWITCH(DptDptCorrelationsTask, processFlushGen, "Flush the generator level pair histograms once per dataframe", false);
+
   /// cleans the output object when the task is not used
   void processCleaner(aod::Collisions const& colls)
   {
@@ -798,7 +1222,7 @@ struct DptDptCorrelationsTask {
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
 {
   WorkflowSpec workflow{
-    adaptAnalysisTask<DptDptCorrelationsTask>(cfgc, TaskName{"DptDptCorrelationsTaskRec"}, SetDefaultProcesses{{{"processRecLevel", true}, {"processCleaner", false}}}),
-    adaptAnalysisTask<DptDptCorrelationsTask>(cfgc, TaskName{"DptDptCorrelationsTaskGen"}, SetDefaultProcesses{{{"processGenLevel", true}, {"processCleaner", false}}})};
+    adaptAnalysisTask<DptDptCorrelationsTask>(cfgc, TaskName{"DptDptCorrelationsTaskRec"}, SetDefaultProcesses{{{"processRecLevel", true}, {"processFlushRec", true}, {"processCleaner", false}}}),
+    adaptAnalysisTask<DptDptCorrelationsTask>(cfgc, TaskName{"DptDptCorrelationsTaskGen"}, SetDefaultProcesses{{{"processGenLevel", true}, {"processFlushGen", true}, {"processCleaner", false}}})};
   return workflow;
 }
@@ -72,6 +72,9 @@ struct GenericFramework {
   GFW* fGFW = new GFW();
   std::vector<GFW::CorrConfig> corrconfigs;
   TRandom3* fRndm = new TRandom3(0);
+  // tracks of the collision, filled into the GFW in one batch
+  std::vector<double> fTrackEta, fTrackPhi, fTrackWeight;
+  std::vector<int> fTrackPtBin, fTrackMask;
 
   void init(InitContext const&)
   {
@@ -164,6 +167,9 @@ struct GenericFramework {
     float l_Random = fRndm->Rndm();
     float weff = 1, wacc = 1;
 
+    fTrackEta.clear();
+    fTrackPhi.clear();
+    fTrackWeight.clear();
     for (auto& track : tracks) {
       registry.fill(HIST("hPhi"), track.phi());
       registry.fill(HIST("hEta"), track.eta());
@@ -180,8 +186,13 @@ struct GenericFramework {
       else
         wacc = 1;
 
-      fGFW->Fill(track.eta(), 1, track.phi(), wacc * weff, 3);
+      fTrackEta.push_back(track.eta());
+      fTrackPhi.push_back(track.phi());
+      fTrackWeight.push_back(wacc * weff);
     }
+    fTrackPtBin.assign(fTrackEta.size(), 1);
+    fTrackMask.assign(fTrackEta.size(), 3);
+    fGFW->Fill(static_cast<int>(fTrackEta.size()), fTrackEta.data(), fTrackPtBin.data(), fTrackPhi.data(), fTrackWeight.data(), fTrackMask.data());
     for (unsigned long int l_ind = 0; l_ind < corrconfigs.size(); l_ind++) {
       FillFC(corrconfigs.at(l_ind), centrality, l_Random);
     };
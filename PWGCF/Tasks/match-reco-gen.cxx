@@ -16,6 +16,7 @@
 #include "Common/DataModel/Centrality.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
+#include "Common/Core/MCLabelIndex.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "PWGCF/Core/AnalysisConfigurableCuts.h"
 #include "PWGCF/DataModel/DptDptFiltered.h"
@@ -33,7 +34,10 @@
 #include <TH3.h>
 #include <TProfile3D.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -45,8 +49,10 @@ using namespace o2::framework::expressions;
 
 namespace o2::analysis::recogenmap
 {
-std::vector<std::vector<int64_t>> mclabelpos[2];
-std::vector<std::vector<int64_t>> mclabelneg[2];
+/// the tracks with positive label of each MC particle, for tracks with positive and negative collision Id, built once per DF
+o2::analysis::MCLabelIndex mclabelpos[2];
+/// the number of tracks with negative label, for tracks with positive and negative collision Id
+int64_t nmclabelneg[2] = {0, 0};
 } // namespace o2::analysis::recogenmap
 
 /// \brief Checks the correspondence generator level <=> detector level
@@ -67,6 +73,8 @@ struct CheckGeneratorLevelVsDetectorLevel {
   Configurable<bool> cfgTrackMultiRec{"trackmultirec", false, "Track muli-reconstructed particles: true, false. Default false"};
   Configurable<bool> cfgTrackCollAssoc{"trackcollassoc", false, "Track collision id association, track-mcparticle-mccollision vs. track-collision-mccollision: true, false. Default false"};
 
+  Produces<aod::McParticleRecoMults> recoMults;
+
   HistogramRegistry histos{"RecoGenHistograms", {}, OutputObjHandlingPolicy::AnalysisObject, true, true};
   typedef enum { kBEFORE = 0,
                  kAFTER } beforeafterselection;
@@ -75,6 +83,15 @@ struct CheckGeneratorLevelVsDetectorLevel {
   enum { kMATCH = 0,
          kDONTMATCH };
 
+  /* the labels and global indices of the tracks with positive and negative collision Id, to build the label index */
+  std::vector<int> trackLabels[2];
+  std::vector<int64_t> trackIndices[2];
+  /* the selection of each collision, evaluated once per DF: -1 not yet evaluated, 0 rejected, 1 accepted */
+  std::vector<int8_t> collisionSelected;
+  /* the per particle reconstruction multiplicity and cross collision flag, before and after the selection */
+  std::vector<uint16_t> particleNRec[2];
+  std::vector<uint8_t> particleCrossColl[2];
+
   void init(InitContext const&)
   {
     using namespace o2::analysis::recogenmap;
@@ -197,16 +214,26 @@ struct CheckGeneratorLevelVsDetectorLevel {
     static constexpr std::string_view dir[] = {"before/", "after/"};
     static constexpr std::string_view colldir[] = {"positivecolid/", "negativecolid/"};
 
-    int nrec_poslabel = 0;
-    int nrec_neglabel = 0;
+    int nrec_poslabel = mclabelpos[collsign].getNEntries();
+    int nrec_neglabel = nmclabelneg[collsign];
     int nrec_poslabel_crosscoll = 0;
 
+    if (collsign == kPOSITIVE) {
+      particleNRec[ba].assign(mcParticles.size(), 0);
+      particleCrossColl[ba].assign(mcParticles.size(), uint8_t(false));
+    }
+
     for (int ixpart = 0; ixpart < mcParticles.size(); ++ixpart) {
-      auto particle = mcParticles.iteratorAt(ixpart);
       /* multireconstructed tracks only for positive labels */
-      int nrec = mclabelpos[collsign][ixpart].size();
-      nrec_poslabel += mclabelpos[collsign][ixpart].size();
-      nrec_neglabel += mclabelneg[collsign][ixpart].size();
+      auto recs = mclabelpos[collsign].entries(ixpart);
+      int nrec = recs.size();
+      if (nrec == 0) {
+        continue;
+      }
+      auto particle = mcParticles.iteratorAt(ixpart);
+      if (collsign == kPOSITIVE) {
+        particleNRec[ba][ixpart] = std::min<int>(nrec, std::numeric_limits<uint16_t>::max());
+      }
 
       if (nrec > 1) {
         /* multireconstruction only from positive labels */
@@ -214,26 +241,24 @@ struct CheckGeneratorLevelVsDetectorLevel {
 
         if (collsign == kPOSITIVE) {
           /* check the cross collision reconstruction */
+          /* two of the tracks are in different collisions if one of them is not in the collision of the first one */
           bool crosscollfound = false;
-          for (unsigned int i = 0; (i < mclabelpos[collsign][ixpart].size()) and not crosscollfound; ++i) {
-            for (unsigned int j = i + 1; (j < mclabelpos[collsign][ixpart].size()) and not crosscollfound; ++j) {
-              auto track1 = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
-              auto track2 = tracks.iteratorAt(mclabelpos[collsign][ixpart][j]);
-
-              if (track1.collisionId() != track2.collisionId()) {
-                nrec_poslabel_crosscoll++;
-                crosscollfound = true;
-              }
+          auto firstcollid = tracks.iteratorAt(recs[0]).collisionId();
+          for (unsigned int i = 1; (i < recs.size()) and not crosscollfound; ++i) {
+            if (tracks.iteratorAt(recs[i]).collisionId() != firstcollid) {
+              nrec_poslabel_crosscoll++;
+              crosscollfound = true;
             }
           }
+          particleCrossColl[ba][ixpart] = uint8_t(crosscollfound);
           if (crosscollfound and (ba == kAFTER)) {
             if (cfgTrackMultiRec) {
               LOGF(info, "BEGIN multi-reconstructed: ==================================================================");
               LOGF(info, "Particle with index %d and pdg code %d assigned to MC collision %d, pT: %f, phi: %f, eta: %f",
                    particle.globalIndex(), particle.pdgCode(), particle.mcCollisionId(), particle.pt(), particle.phi(), particle.eta());
               LOGF(info, "With status %d and flags %0X and multi-reconstructed as: ==================================", particle.statusCode(), particle.flags());
-              for (unsigned int i = 0; i < mclabelpos[collsign][ixpart].size(); ++i) {
-                auto track = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
+              for (unsigned int i = 0; i < recs.size(); ++i) {
+                auto track = tracks.iteratorAt(recs[i]);
                 auto coll = colls.iteratorAt(track.collisionId());
                 LOGF(info, "Track with index %d and label %d assigned to collision %d, with associated MC collision %d",
                      track.globalIndex(), ixpart, track.collisionId(), coll.mcCollisionId());
@@ -244,10 +269,10 @@ struct CheckGeneratorLevelVsDetectorLevel {
           }
         }
 
-        for (unsigned int i = 0; i < mclabelpos[collsign][ixpart].size(); ++i) {
-          auto track1 = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
-          for (unsigned int j = i + 1; j < mclabelpos[collsign][ixpart].size(); ++j) {
-            auto track2 = tracks.iteratorAt(mclabelpos[collsign][ixpart][j]);
+        for (unsigned int i = 0; i < recs.size(); ++i) {
+          auto track1 = tracks.iteratorAt(recs[i]);
+          for (unsigned int j = i + 1; j < recs.size(); ++j) {
+            auto track2 = tracks.iteratorAt(recs[j]);
 
             float deltaeta = track1.eta() - track2.eta();
             float deltaphi = track1.phi() - track2.phi();
@@ -284,8 +309,8 @@ struct CheckGeneratorLevelVsDetectorLevel {
             histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("matchcollidmr"), kMATCH + 0.5f);
           }
         }
-      } else if (nrec > 0) {
-        auto track = tracks.iteratorAt(mclabelpos[collsign][ixpart][0]);
+      } else {
+        auto track = tracks.iteratorAt(recs[0]);
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecoeta"), track.eta(), particle.eta());
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecophi"), track.phi(), particle.phi());
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecopt"), track.pt(), particle.pt());
@@ -329,10 +354,9 @@ struct CheckGeneratorLevelVsDetectorLevel {
     using namespace o2::analysis::dptdptfilter;
 
     for (int i = 0; i < 2; ++i) {
-      mclabelpos[i].clear();
-      mclabelneg[i].clear();
-      mclabelpos[i].resize(mcParticles.size());
-      mclabelneg[i].resize(mcParticles.size());
+      trackLabels[i].clear();
+      trackIndices[i].clear();
+      nmclabelneg[i] = 0;
     }
 
     size_t nreco = tracks.size();
@@ -357,20 +381,17 @@ struct CheckGeneratorLevelVsDetectorLevel {
       int32_t label = track.mcParticleId();
 
       LOGF(MATCHRECGENLOGTRACKS, "Track with global Id %d and collision Id %d has label %d associated to MC collision %d", recix, track.collisionId(), label, track.template mcParticle_as<aod::McParticles>().mcCollisionId());
-      if (track.collisionId() < 0) {
-        if (label >= 0) {
-          mclabelpos[kNEGATIVE][label].push_back(recix);
-        } else {
-          mclabelneg[kNEGATIVE][-label].push_back(recix);
-        }
+      int collsign = (track.collisionId() < 0) ? kNEGATIVE : kPOSITIVE;
+      if (label >= 0) {
+        trackLabels[collsign].push_back(label);
+        trackIndices[collsign].push_back(recix);
       } else {
-        if (label >= 0) {
-          mclabelpos[kPOSITIVE][label].push_back(recix);
-        } else {
-          mclabelneg[kPOSITIVE][-label].push_back(recix);
-        }
+        nmclabelneg[collsign]++;
       }
     }
+    for (int i = 0; i < 2; ++i) {
+      mclabelpos[i].build(mcParticles.size(), trackLabels[i], trackIndices[i]);
+    }
 
     collectData<kBEFORE, kPOSITIVE>(tracks, mcParticles, collisions);
     collectData<kBEFORE, kNEGATIVE>(tracks, mcParticles, collisions);
@@ -383,10 +404,9 @@ struct CheckGeneratorLevelVsDetectorLevel {
     using namespace o2::analysis::dptdptfilter;
 
     for (int i = 0; i < 2; ++i) {
-      mclabelpos[i].clear();
-      mclabelneg[i].clear();
-      mclabelpos[i].resize(mcParticles.size());
-      mclabelneg[i].resize(mcParticles.size());
+      trackLabels[i].clear();
+      trackIndices[i].clear();
+      nmclabelneg[i] = 0;
     }
 
     size_t nreco = 0;
@@ -403,14 +423,19 @@ struct CheckGeneratorLevelVsDetectorLevel {
     }
 
     // Let's go through the reco-gen mapping to detect multi-reconstructed particles
+    collisionSelected.assign(collisions.size(), -1);
     for (auto& track : tracks) {
       int64_t recix = track.globalIndex();
       int32_t label = track.mcParticleId();
       if (not(label < 0)) {
         if (not(track.collisionId() < 0)) {
-          typename CollisionsObject::iterator coll = collisions.iteratorAt(track.collisionId());
-          float centormult = -100.0f;
-          if (IsEvtSelected(coll, centormult)) {
+          int8_t& collselected = collisionSelected[track.collisionId()];
+          if (collselected < 0) {
+            typename CollisionsObject::iterator coll = collisions.iteratorAt(track.collisionId());
+            float centormult = -100.0f;
+            collselected = IsEvtSelected(coll, centormult) ? 1 : 0;
+          }
+          if (collselected > 0) {
             uint8_t asone = uint8_t(false);
             uint8_t astwo = uint8_t(false);
 
@@ -420,23 +445,35 @@ struct CheckGeneratorLevelVsDetectorLevel {
               /* the track has been accepted */
               nreco++;
               LOGF(MATCHRECGENLOGTRACKS, "Accepted track with global Id %d and collision Id %d has label %d associated to MC collision %d", recix, track.collisionId(), label, track.template mcParticle_as<aod::McParticles>().mcCollisionId());
-              mclabelpos[kPOSITIVE][label].push_back(recix);
+              trackLabels[kPOSITIVE].push_back(label);
+              trackIndices[kPOSITIVE].push_back(recix);
             }
           }
         }
       }
     }
+    mclabelpos[kPOSITIVE].build(mcParticles.size(), trackLabels[kPOSITIVE], trackIndices[kPOSITIVE]);
     LOGF(info, "New dataframe (DF) with %d generated charged particles and %d reconstructed accepted tracks", ngen, nreco);
 
     collectData<kAFTER, kPOSITIVE>(tracks, mcParticles, collisions);
   }
 
+  /// \brief Publishes the reconstruction multiplicity of each MC particle, once both selection stages have been collected
+  void produceRecoMults(aod::McParticles const& mcParticles)
+  {
+    recoMults.reserve(mcParticles.size());
+    for (int ixpart = 0; ixpart < mcParticles.size(); ++ixpart) {
+      recoMults(particleNRec[kBEFORE][ixpart], particleNRec[kAFTER][ixpart], particleCrossColl[kBEFORE][ixpart], particleCrossColl[kAFTER][ixpart]);
+    }
+  }
+
   void processMapChecksWithCent(soa::Join<aod::FullTracks, aod::TracksDCA, aod::TrackSelection, aod::McTrackLabels> const& tracks,
                                 soa::Join<aod::CollisionsEvSelCent, aod::McCollisionLabels> const& collisions,
                                 aod::McParticles const& mcParticles)
   {
     processMapChecksBeforeCuts(tracks, collisions, mcParticles);
     processMapChecksAfterCuts(tracks, collisions, mcParticles);
+    produceRecoMults(mcParticles);
   }
   PROCESS_SWITCH(CheckGeneratorLevelVsDetectorLevel, processMapChecksWithCent, "Process detector <=> generator levels with centrality/multiplicity information", false);
 
@@ -446,6 +483,7 @@ struct CheckGeneratorLevelVsDetectorLevel {
   {
     processMapChecksBeforeCuts(tracks, collisions, mcParticles);
     processMapChecksAfterCuts(tracks, collisions, mcParticles);
+    produceRecoMults(mcParticles);
   }
   PROCESS_SWITCH(CheckGeneratorLevelVsDetectorLevel, processMapChecksWithoutCent, "Process detector <=> generator levels without centrality/multiplicity information", true);
 };
@@ -0,0 +1,234 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PWGDQ/Core/AnalysisCutEngine.h"
+
+#include "Framework/Logger.h"
+
+//____________________________________________________________________________
+AnalysisCutEngine::AnalysisCutEngine(int batchSize) : fBatchSize(batchSize),
+                                                      fNRows(0),
+                                                      fVarColumns(),
+                                                      fColumnVars(),
+                                                      fColumns(),
+                                                      fConditions(),
+                                                      fNodes(),
+                                                      fChildren(),
+                                                      fRootNodes(),
+                                                      fResults(),
+                                                      fMasks(batchSize, 0)
+{
+  //
+  // constructor
+  //
+  if (batchSize < 1) {
+    LOG(fatal) << "AnalysisCutEngine: invalid batch size " << batchSize;
+  }
+}
+
+//____________________________________________________________________________
+void AnalysisCutEngine::AddCut(const AnalysisCut* cut)
+{
+  //
+  // add a cut, to be done before any object is added to the batch
+  //
+  if (fNRows > 0) {
+    LOG(fatal) << "AnalysisCutEngine: cut " << cut->GetName() << " added while the batch is not empty";
+  }
+  if (fRootNodes.size() == 32) {
+    LOG(fatal) << "AnalysisCutEngine: at most 32 cuts are supported, cannot add " << cut->GetName();
+  }
+  fRootNodes.push_back(AddNode(cut));
+  fResults.resize(fNodes.size() * fBatchSize);
+}
+
+//____________________________________________________________________________
+int AnalysisCutEngine::AddNode(const AnalysisCut* cut)
+{
+  //
+  // flatten a cut into nodes, return the node of the cut
+  //
+  std::vector<int> children;
+  int type = kAND;
+  if (cut->IsA() == AnalysisCompositeCut::Class()) {
+    // same decision as AnalysisCompositeCut::IsSelected(): the cuts, then the composite cuts, combined with AND or OR
+    const AnalysisCompositeCut* composite = static_cast<const AnalysisCompositeCut*>(cut);
+    type = (composite->GetUseAND() ? kAND : kOR);
+    for (const auto& c : composite->GetCutList()) {
+      children.push_back(AddNode(&c));
+    }
+    for (const auto& c : composite->GetCompositeCutList()) {
+      children.push_back(AddNode(&c));
+    }
+  } else {
+    // same decision as AnalysisCut::IsSelected(): AND of all the cut containers
+    for (const auto& c : cut->GetCuts()) {
+      Condition cond;
+      cond.fColumn = GetColumn(c.fVar);
+      cond.fLow = c.fLow;
+      cond.fHigh = c.fHigh;
+      cond.fExclude = c.fExclude;
+      cond.fDepColumn = (c.fDepVar != -1 ? GetColumn(c.fDepVar) : -1);
+      cond.fDepLow = c.fDepLow;
+      cond.fDepHigh = c.fDepHigh;
+      cond.fDepExclude = c.fDepExclude;
+      cond.fDep2Column = (c.fDepVar2 != -1 ? GetColumn(c.fDepVar2) : -1);
+      cond.fDep2Low = c.fDep2Low;
+      cond.fDep2High = c.fDep2High;
+      cond.fDep2Exclude = c.fDep2Exclude;
+      cond.fFuncLow = c.fFuncLow;
+      cond.fFuncHigh = c.fFuncHigh;
+      fConditions.push_back(cond);
+
+      Node node = {kCondition, static_cast<int>(fConditions.size()) - 1, 0, 0};
+      fNodes.push_back(node);
+      children.push_back(fNodes.size() - 1);
+    }
+  }
+
+  Node node = {type, -1, static_cast<int>(fChildren.size()), static_cast<int>(children.size())};
+  fChildren.insert(fChildren.end(), children.begin(), children.end());
+  fNodes.push_back(node);
+  return fNodes.size() - 1;
+}
+
+//____________________________________________________________________________
+int AnalysisCutEngine::GetColumn(int var)
+{
+  //
+  // get the column of a variable, allocating it if needed
+  //
+  if (var >= static_cast<int>(fVarColumns.size())) {
+    fVarColumns.resize(var + 1, -1);
+  }
+  if (fVarColumns[var] < 0) {
+    fVarColumns[var] = fColumnVars.size();
+    fColumnVars.push_back(var);
+    fColumns.resize(fColumnVars.size() * fBatchSize);
+  }
+  return fVarColumns[var];
+}
+
+//____________________________________________________________________________
+void AnalysisCutEngine::AddRow(const float* values)
+{
+  //
+  // copy the values of the used variables into the columns
+  //
+  if (fNRows == fBatchSize) {
+    LOG(fatal) << "AnalysisCutEngine: batch full, Evaluate() and Clear() must be called first";
+  }
+  float* columns = fColumns.data();
+  for (size_t icol = 0; icol < fColumnVars.size(); ++icol) {
+    columns[icol * fBatchSize + fNRows] = values[fColumnVars[icol]];
+  }
+  fNRows++;
+}
+
+//____________________________________________________________________________
+void AnalysisCutEngine::EvaluateCondition(const Condition& cond, uint8_t* result) const
+{
+  //
+  // evaluate one cut container for all the objects in the batch
+  //
+  const int n = fNRows;
+  const float* x = Column(cond.fColumn);
+  const float* dep = (cond.fDepColumn >= 0 ? Column(cond.fDepColumn) : nullptr);
+  const float* dep2 = (cond.fDep2Column >= 0 ? Column(cond.fDep2Column) : nullptr);
+
+  if (cond.fFuncLow || cond.fFuncHigh) {
+    // limits depending on the first dependent variable: evaluate the functions only where the cut applies
+    for (int i = 0; i < n; ++i) {
+      bool applies = ((dep[i] > cond.fDepLow && dep[i] <= cond.fDepHigh) != cond.fDepExclude);
+      if (applies && dep2) {
+        applies = ((dep2[i] > cond.fDep2Low && dep2[i] <= cond.fDep2High) != cond.fDep2Exclude);
+      }
+      if (!applies) {
+        result[i] = 1;
+        continue;
+      }
+      float cutLow = (cond.fFuncLow ? cond.fFuncLow->Eval(dep[i]) : cond.fLow);
+      float cutHigh = (cond.fFuncHigh ? cond.fFuncHigh->Eval(dep[i]) : cond.fHigh);
+      result[i] = ((x[i] >= cutLow && x[i] <= cutHigh) != cond.fExclude);
+    }
+    return;
+  }
+
+  // constant limits: branchless loops over the columns
+  const float low = cond.fLow;
+  const float high = cond.fHigh;
+  const uint8_t exclude = cond.fExclude;
+  for (int i = 0; i < n; ++i) {
+    result[i] = ((x[i] >= low) & (x[i] <= high)) ^ exclude;
+  }
+  // the cut is considered passed where a dependent variable is not in its requested range
+  if (dep) {
+    const float depLow = cond.fDepLow;
+    const float depHigh = cond.fDepHigh;
+    const uint8_t depExclude = cond.fDepExclude;
+    for (int i = 0; i < n; ++i) {
+      result[i] |= ((dep[i] > depLow) & (dep[i] <= depHigh)) ^ depExclude ^ 1;
+    }
+  }
+  if (dep2) {
+    const float dep2Low = cond.fDep2Low;
+    const float dep2High = cond.fDep2High;
+    const uint8_t dep2Exclude = cond.fDep2Exclude;
+    for (int i = 0; i < n; ++i) {
+      result[i] |= ((dep2[i] > dep2Low) & (dep2[i] <= dep2High)) ^ dep2Exclude ^ 1;
+    }
+  }
+}
+
+//____________________________________________________________________________
+void AnalysisCutEngine::Evaluate()
+{
+  //
+  // evaluate all the nodes in order and fill the bit maps of the objects in the batch
+  //
+  const int n = fNRows;
+  for (size_t inode = 0; inode < fNodes.size(); ++inode) {
+    const Node& node = fNodes[inode];
+    uint8_t* result = Result(inode);
+    if (node.fType == kCondition) {
+      EvaluateCondition(fConditions[node.fCondition], result);
+      continue;
+    }
+    // an empty AND selects everything, an empty OR nothing
+    const uint8_t init = (node.fType == kAND ? 1 : 0);
+    for (int i = 0; i < n; ++i) {
+      result[i] = init;
+    }
+    for (int ichild = 0; ichild < node.fNChildren; ++ichild) {
+      const uint8_t* child = Result(fChildren[node.fFirstChild + ichild]);
+      if (node.fType == kAND) {
+        for (int i = 0; i < n; ++i) {
+          result[i] &= child[i];
+        }
+      } else {
+        for (int i = 0; i < n; ++i) {
+          result[i] |= child[i];
+        }
+      }
+    }
+  }
+
+  uint32_t* masks = fMasks.data();
+  for (int i = 0; i < n; ++i) {
+    masks[i] = 0;
+  }
+  for (size_t icut = 0; icut < fRootNodes.size(); ++icut) {
+    const uint8_t* result = Result(fRootNodes[icut]);
+    for (int i = 0; i < n; ++i) {
+      masks[i] |= (uint32_t(result[i]) << icut);
+    }
+  }
+}
@@ -0,0 +1,101 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Class evaluating a set of analysis cuts over a batch of objects
+//   The cuts (AnalysisCut or AnalysisCompositeCut) are flattened once into a list of nodes. The VarManager values of
+//   the objects are accumulated column by column and all the cuts are evaluated in one pass over the batch, giving
+//   one bit map per object with the bit i set if the object passed the i-th cut, like the loops over IsSelected().
+//   Cuts with constant limits are evaluated by branchless loops over the columns, which the compiler can vectorize.
+//
+
+#ifndef AnalysisCutEngine_H
+#define AnalysisCutEngine_H
+
+#include "PWGDQ/Core/AnalysisCut.h"
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+
+#include <cstdint>
+#include <vector>
+
+//_________________________________________________________________________
+class AnalysisCutEngine
+{
+ public:
+  AnalysisCutEngine(int batchSize = 1024);
+  ~AnalysisCutEngine() = default;
+
+  // Add a cut, the decision for the i-th added cut is stored in the bit i of the bit maps
+  void AddCut(const AnalysisCut* cut);
+  int GetNCuts() const { return fRootNodes.size(); }
+
+  // Add the values of an object to the batch; the batch must be evaluated once full
+  void AddRow(const float* values);
+  int GetNRows() const { return fNRows; }
+  bool IsFull() const { return fNRows == fBatchSize; }
+  // Evaluate all the cuts for the objects in the batch
+  void Evaluate();
+  uint32_t GetMask(int row) const { return fMasks[row]; }
+  const std::vector<uint32_t>& GetMasks() const { return fMasks; }
+  // Remove all the objects from the batch
+  void Clear() { fNRows = 0; }
+
+ private:
+  enum NodeType {
+    kCondition = 0, // one CutContainer of an AnalysisCut
+    kAND,           // AND of the children nodes
+    kOR             // OR of the children nodes
+  };
+
+  // CutContainer with the variables replaced by their column in the batch
+  struct Condition {
+    int fColumn;
+    float fLow;
+    float fHigh;
+    bool fExclude;
+    int fDepColumn; // -1 if not used
+    float fDepLow;
+    float fDepHigh;
+    bool fDepExclude;
+    int fDep2Column; // -1 if not used
+    float fDep2Low;
+    float fDep2High;
+    bool fDep2Exclude;
+    TF1* fFuncLow;  // function of the first dependent variable for the lower limit, owned by the cut
+    TF1* fFuncHigh; // function of the first dependent variable for the upper limit, owned by the cut
+  };
+
+  struct Node {
+    int fType;       // one of NodeType
+    int fCondition;  // condition of a kCondition node
+    int fFirstChild; // position of the first child in fChildren
+    int fNChildren;  // number of children
+  };
+
+  int fBatchSize;                // maximum number of objects in a batch
+  int fNRows;                    // number of objects in the current batch
+  std::vector<int> fVarColumns;  // column of each variable, -1 if not used by the cuts
+  std::vector<int> fColumnVars;  // variable of each column
+  std::vector<float> fColumns;   // values of the used variables, one column of fBatchSize values per variable
+  std::vector<Condition> fConditions;
+  std::vector<Node> fNodes;      // nodes ordered such that the children come before their parent
+  std::vector<int> fChildren;    // children of all the nodes, flattened
+  std::vector<int> fRootNodes;   // node of each added cut
+  std::vector<uint8_t> fResults; // decision of each node, fBatchSize values per node
+  std::vector<uint32_t> fMasks;  // decision bit maps of the objects in the batch
+
+  int AddNode(const AnalysisCut* cut);
+  int GetColumn(int var);
+  void EvaluateCondition(const Condition& cond, uint8_t* result) const;
+  const float* Column(int column) const { return fColumns.data() + static_cast<size_t>(column) * fBatchSize; }
+  uint8_t* Result(int node) { return fResults.data() + static_cast<size_t>(node) * fBatchSize; }
+};
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Composite cuts of the CutsLibrary built from a list of names, read from a ConfigurationCache when it holds them.
+// The cuts read from the cache register their variables in AnalysisCut::fgUsedVars, as AddCut does when a cut is
+// built, so that VarManager fills the same variables. The configuration of the cache includes the build time of the
+// translation unit, which is recompiled whenever the CutsLibrary changes.
+//
+
+#ifndef PWGDQ_CORE_CUTSCACHE_H_
+#define PWGDQ_CORE_CUTSCACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TObjArray.h>
+#include <TString.h>
+
+#include "Common/Core/ConfigurationCache.h"
+#include "PWGDQ/Core/AnalysisCut.h"
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+
+namespace o2::aod
+{
+namespace dqcuts
+{
+AnalysisCompositeCut* GetCompositeCut(const char* cutName);
+
+/// Registers the variables of a cut and of its sub-cuts in AnalysisCut::fgUsedVars
+inline void RegisterUsedVars(const AnalysisCut& cut)
+{
+  for (const auto& container : cut.GetCuts()) {
+    AnalysisCut::fgUsedVars.push_back(container.fVar);
+    if (container.fDepVar != -1) {
+      AnalysisCut::fgUsedVars.push_back(container.fDepVar);
+    }
+    if (container.fDepVar2 != -1) {
+      AnalysisCut::fgUsedVars.push_back(container.fDepVar2);
+    }
+  }
+  if (cut.IsA() == AnalysisCompositeCut::Class()) {
+    const auto& composite = static_cast<const AnalysisCompositeCut&>(cut);
+    for (const auto& subCut : composite.GetCutList()) {
+      RegisterUsedVars(subCut);
+    }
+    for (const auto& subCut : composite.GetCompositeCutList()) {
+      RegisterUsedVars(subCut);
+    }
+  }
+}
+
+/// \param cutNames  comma separated names of composite cuts of the CutsLibrary
+/// \param cache  cache of the cuts, possibly disabled
+/// \return the cuts, in the order of the names
+inline std::vector<AnalysisCompositeCut> GetCompositeCuts(const char* cutNames, const o2::analysis::ConfigurationCache& cache)
+{
+  std::vector<AnalysisCompositeCut> cuts;
+  const std::string configuration = std::string("dqcuts::GetCompositeCut ") + __DATE__ + " " + __TIME__ + " " + cutNames;
+  if (auto cached = cache.load<TObjArray>(configuration)) {
+    cached->SetOwner(kTRUE);
+    for (auto* cut : *cached) {
+      cuts.push_back(*static_cast<AnalysisCompositeCut*>(cut));
+      RegisterUsedVars(cuts.back());
+    }
+    return cuts;
+  }
+  std::unique_ptr<TObjArray> names(TString(cutNames).Tokenize(","));
+  for (int icut = 0; icut < names->GetEntries(); ++icut) {
+    cuts.push_back(*GetCompositeCut(names->At(icut)->GetName()));
+  }
+  if (cache.isEnabled()) {
+    TObjArray toStore(cuts.size());
+    for (auto& cut : cuts) {
+      toStore.Add(&cut);
+    }
+    cache.store(configuration, toStore);
+  }
+  return cuts;
+}
+} // namespace dqcuts
+} // namespace o2::aod
+
+#endif // PWGDQ_CORE_CUTSCACHE_H_
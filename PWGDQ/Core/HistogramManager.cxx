@@ -108,6 +108,10 @@ void HistogramManager::AddHistClass(const char* histClass)
   fMainList->Add(hList);
   std::list<std::vector<int>> varList;
   fVariablesMap[histClass] = varList;
+  fHistClassHandles[histClass] = fFillPlans.size();
+  FillPlan plan;
+  plan.className = histClass;
+  fFillPlans.push_back(plan);
   cout << "Adding histogram class " << histClass << endl;
   cout << "Variable map size :: " << fVariablesMap.size() << endl;
 }
@@ -182,6 +186,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "Adding histogram " << hname << endl;
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
+  InvalidateFillPlan(histClass);
 
   // create and configure histograms according to required options
   TH1* h = nullptr;
@@ -381,6 +386,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "Adding histogram " << hname << endl;
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
+  InvalidateFillPlan(histClass);
 
   TH1* h = nullptr;
   switch (dimension) {
@@ -549,6 +555,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "Adding histogram " << hname << endl;
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
+  InvalidateFillPlan(histClass);
 
   unsigned long int nbins = 1;
   THnBase* h = nullptr;
@@ -628,6 +635,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "Adding histogram " << hname << endl;
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
+  InvalidateFillPlan(histClass);
 
   // get the min and max for each axis
   double* xmin = new double[nDimensions];
@@ -683,125 +691,154 @@ void HistogramManager::FillHistClass(const char* className, Float_t* values)
   //
   //  fill a class of histograms
   //
+  // TODO: add some meaningfull error message if the class does not exist
+  FillHistClass(GetHistClassHandle(className), values);
+}
 
-  // get the needed histogram list
-  TList* hList = (TList*)fMainList->FindObject(className);
-  if (!hList) {
-    // TODO: add some meaningfull error message
-    /*cout << "Warning in HistogramManager::FillHistClass(): Histogram list " << className << " not found!" << endl;
-    cout << "         Histogram list not filled" << endl; */
-    return;
+//__________________________________________________________________
+int HistogramManager::GetHistClassHandle(const char* className) const
+{
+  //
+  // get the handle of a histogram class
+  //
+  auto handle = fHistClassHandles.find(className);
+  return (handle == fHistClassHandles.end() ? kNothing : handle->second);
+}
+
+//__________________________________________________________________
+void HistogramManager::InvalidateFillPlan(const char* histClass)
+{
+  //
+  // mark the fill plan of a class to be compiled again, e.g. after a histogram was added to it
+  //
+  int handle = GetHistClassHandle(histClass);
+  if (handle != kNothing) {
+    fFillPlans[handle].isCompiled = false;
   }
+}
 
-  // get the corresponding std::list containng identifiers to the needed variables to be filled
-  list varList = fVariablesMap[className];
+//__________________________________________________________________
+void HistogramManager::CompileFillPlan(FillPlan& plan)
+{
+  //
+  // resolve the histograms of a class and the variables needed to fill them
+  //
+  plan.entries.clear();
+  plan.vars.clear();
+  plan.isCompiled = true;
 
+  TList* hList = (TList*)fMainList->FindObject(plan.className.c_str());
+  if (!hList) {
+    return;
+  }
+  // NOTE: the histogram list and the std::list of variables contain the same number of elements and are synchronized
+  const std::list<std::vector<int>>& varList = fVariablesMap[plan.className];
   TIter next(hList);
-
-  TObject* h = nullptr;
-  bool isProfile;
-  bool isTHn;
-  int dimension = 0;
-  bool isSparse = kFALSE;
-  // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms. We should make this more dynamic
-  //       But maybe its better to have it like to avoid dynamically allocating this array in the histogram loop
-  double fillValues[20] = {0.0};
-  int varX = -1, varY = -1, varZ = -1, varT = -1, varW = -1;
-
-  // loop over the histogram and std::list
-  // NOTE: these two should contain the same number of elements and be synchronized, otherwise its a mess
   for (auto varIter = varList.begin(); varIter != varList.end(); varIter++) {
-    h = next(); // get the histogram
-    // decode information from the vector of indices
-    isProfile = (varIter->at(0) == 1 ? true : false);
-    isTHn = (varIter->at(1) > 0 ? true : false);
-    if (isTHn) {
-      dimension = varIter->at(1);
-    } else {
-      dimension = ((TH1*)h)->GetDimension();
+    TObject* h = next();
+    if (!h) {
+      break;
     }
-
-    // get the various variable indices
-    varW = varIter->at(2);
-    if (isTHn) {
-      for (int i = 0; i < dimension; i++) {
-        fillValues[i] = values[varIter->at(3 + i)];
-      }
+    FillPlanEntry entry;
+    entry.hist = h;
+    entry.varW = varIter->at(2);
+    entry.firstVar = plan.vars.size();
+    bool isProfile = (varIter->at(0) == 1);
+    int nTHnDimensions = varIter->at(1);
+    if (nTHnDimensions > 0) {
+      entry.kind = kTHn;
+      entry.nVars = nTHnDimensions;
     } else {
-      varX = varIter->at(3);
-      varY = varIter->at(4);
-      varZ = varIter->at(5);
-      varT = varIter->at(6);
+      int dimension = ((TH1*)h)->GetDimension();
+      entry.kind = (isProfile ? kProfile : kTH1) + dimension - 1;
+      entry.nVars = dimension + (isProfile ? 1 : 0);
+    }
+    for (int i = 0; i < entry.nVars; i++) {
+      plan.vars.push_back(varIter->at(3 + i));
     }
+    plan.entries.push_back(entry);
+  }
+}
 
-    if (!isTHn) {
-      switch (dimension) {
-        case 1:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile*)h)->Fill(values[varX], values[varY], values[varW]);
-            } else {
-              ((TProfile*)h)->Fill(values[varX], values[varY]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH1F*)h)->Fill(values[varX], values[varW]);
-            } else {
-              ((TH1F*)h)->Fill(values[varX]);
-            }
-          }
-          break;
-        case 2:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile2D*)h)->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              ((TProfile2D*)h)->Fill(values[varX], values[varY], values[varZ]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH2F*)h)->Fill(values[varX], values[varY], values[varW]);
-            } else {
-              ((TH2F*)h)->Fill(values[varX], values[varY]);
-            }
-          }
-          break;
-        case 3:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile3D*)h)->Fill(values[varX], values[varY], values[varZ], values[varT], values[varW]);
-            } else {
-              ((TProfile3D*)h)->Fill(values[varX], values[varY], values[varZ], values[varT]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH3F*)h)->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              ((TH3F*)h)->Fill(values[varX], values[varY], values[varZ]);
-            }
-          }
-          break;
-
-        default:
-          break;
-      } // end switch
-    }   // end if(!isTHn)
-    else {
-      if (varW > kNothing) {
-        if (isSparse) {
-          ((THnSparseF*)h)->Fill(fillValues, values[varW]);
+//__________________________________________________________________
+void HistogramManager::FillHistClass(int handle, Float_t* values)
+{
+  //
+  //  fill a class of histograms using its fill plan
+  //
+  if (handle < 0 || handle >= static_cast<int>(fFillPlans.size())) {
+    return;
+  }
+  FillPlan& plan = fFillPlans[handle];
+  if (!plan.isCompiled) {
+    CompileFillPlan(plan);
+  }
+
+  // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms. We should make this more dynamic
+  //       But maybe its better to have it like to avoid dynamically allocating this array in the histogram loop
+  double fillValues[20] = {0.0};
+
+  const int* vars = plan.vars.data();
+  for (const auto& entry : plan.entries) {
+    const int* v = vars + entry.firstVar;
+    bool isWeighted = (entry.varW > kNothing);
+    switch (entry.kind) {
+      case kTH1:
+        if (isWeighted) {
+          ((TH1F*)entry.hist)->Fill(values[v[0]], values[entry.varW]);
         } else {
-          ((THnF*)h)->Fill(fillValues, values[varW]);
+          ((TH1F*)entry.hist)->Fill(values[v[0]]);
         }
-      } else {
-        if (isSparse) {
-          ((THnSparseF*)h)->Fill(fillValues);
+        break;
+      case kTH2:
+        if (isWeighted) {
+          ((TH2F*)entry.hist)->Fill(values[v[0]], values[v[1]], values[entry.varW]);
         } else {
-          ((THnF*)h)->Fill(fillValues);
+          ((TH2F*)entry.hist)->Fill(values[v[0]], values[v[1]]);
         }
-      }
-    } // end else
-  }   // end loop over histograms
+        break;
+      case kTH3:
+        if (isWeighted) {
+          ((TH3F*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]], values[entry.varW]);
+        } else {
+          ((TH3F*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]]);
+        }
+        break;
+      case kProfile:
+        if (isWeighted) {
+          ((TProfile*)entry.hist)->Fill(values[v[0]], values[v[1]], values[entry.varW]);
+        } else {
+          ((TProfile*)entry.hist)->Fill(values[v[0]], values[v[1]]);
+        }
+        break;
+      case kProfile2D:
+        if (isWeighted) {
+          ((TProfile2D*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]], values[entry.varW]);
+        } else {
+          ((TProfile2D*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]]);
+        }
+        break;
+      case kProfile3D:
+        if (isWeighted) {
+          ((TProfile3D*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]], values[v[3]], values[entry.varW]);
+        } else {
+          ((TProfile3D*)entry.hist)->Fill(values[v[0]], values[v[1]], values[v[2]], values[v[3]]);
+        }
+        break;
+      case kTHn:
+        for (int i = 0; i < entry.nVars; i++) {
+          fillValues[i] = values[v[i]];
+        }
+        if (isWeighted) {
+          ((THnBase*)entry.hist)->Fill(fillValues, values[entry.varW]);
+        } else {
+          ((THnBase*)entry.hist)->Fill(fillValues);
+        }
+        break;
+      default:
+        break;
+    }
+  } // end loop over histograms
 }
 
 //____________________________________________________________________________________
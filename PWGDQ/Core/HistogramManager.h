@@ -47,6 +47,7 @@ class HistogramManager : public TNamed
       delete fMainList;
     }
     fMainList = list;
+    InvalidateFillPlans();
   }
 
   // Create a new histogram class
@@ -85,6 +86,10 @@ class HistogramManager : public TNamed
                     TString* axLabels = nullptr, int varW = -1, bool useSparse = kFALSE);
 
   void FillHistClass(const char* className, float* values);
+  // Get the handle of a histogram class, to be resolved once (e.g. in init()) and then used in the fill loops; kNothing if the class does not exist
+  int GetHistClassHandle(const char* className) const;
+  // Fill a class of histograms using its pre-resolved fill plan, without any string lookup
+  void FillHistClass(int handle, float* values);
 
   void SetUseDefaultVariableNames(bool flag) { fUseDefaultVariableNames = flag; };
   void SetDefaultVarNames(TString* vars, TString* units);
@@ -102,6 +107,41 @@ class HistogramManager : public TNamed
   bool* fUsedVars;                                                  //! flags of used variables
   std::map<std::string, std::list<std::vector<int>>> fVariablesMap; //!  map holding identifiers for all variables needed by histograms
 
+  // Fill plan of a histogram class: the histograms with their type and variable indices, resolved once from fVariablesMap
+  enum FillKind {
+    kTH1 = 0,
+    kTH2,
+    kTH3,
+    kProfile,
+    kProfile2D,
+    kProfile3D,
+    kTHn
+  };
+  struct FillPlanEntry {
+    TObject* hist; // histogram to be filled, owned by the class list
+    int kind;      // one of FillKind
+    int varW;      // variable used for weighting, kNothing if not weighted
+    int firstVar;  // position of the first axis variable in FillPlan::vars
+    int nVars;     // number of axis variables (including the profiled one)
+  };
+  struct FillPlan {
+    std::string className;
+    bool isCompiled = false;
+    std::vector<FillPlanEntry> entries;
+    std::vector<int> vars; // axis variables of all histograms, flattened
+  };
+  std::vector<FillPlan> fFillPlans;             //! fill plans indexed by handle
+  std::map<std::string, int> fHistClassHandles; //! handles of the histogram classes
+
+  void CompileFillPlan(FillPlan& plan);
+  void InvalidateFillPlan(const char* histClass);
+  void InvalidateFillPlans()
+  {
+    for (auto& plan : fFillPlans) {
+      plan.isCompiled = false;
+    }
+  }
+
   // various
   bool fUseDefaultVariableNames;    //! toggle the usage of default variable names and units
   unsigned long int fBinsAllocated; //! number of allocated bins
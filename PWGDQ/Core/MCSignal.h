@@ -84,6 +84,14 @@ class MCSignal : public TNamed
   {
     return fProngs[0].fNGenerations;
   }
+  const std::vector<MCProng>& GetProngs() const
+  {
+    return fProngs;
+  }
+  const std::vector<short>& GetCommonAncestorIdxs() const
+  {
+    return fCommonAncestorIdxs;
+  }
 
   template <typename U, typename... T>
   bool CheckSignal(bool checkSources, const U& mcStack, const T&... args)
@@ -0,0 +1,179 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PWGDQ/Core/MCSignalMatcher.h"
+
+//________________________________________________________________________________________________
+void MCSignalMatcher::AddSignal(MCSignal* signal)
+{
+  //
+  // add a signal, which has to outlive the matcher; signals checked in time, with too many generations or with a common ancestor required for a prong
+  //   but not for the first one (compared by MCSignal with the index of a previous call) are not compiled
+  //
+  Signal compiled{signal, signal->GetNProngs(), true, static_cast<int>(fProngs.size())};
+  const auto& prongs = signal->GetProngs();
+  const auto& ancestors = signal->GetCommonAncestorIdxs();
+  const bool firstAncestor = compiled.fNProngs > 1 && ancestors[0] >= 0 && ancestors[0] < prongs[0].fNGenerations;
+  for (int i = 0; i < compiled.fNProngs; i++) {
+    if (prongs[i].fCheckGenerationsInTime || prongs[i].fNGenerations > kMaxGenerations ||
+        (i > 0 && !firstAncestor && ancestors[i] >= 0 && ancestors[i] < prongs[i].fNGenerations)) {
+      compiled.fCompiled = false;
+    }
+  }
+  if (!compiled.fCompiled) {
+    fSignals.push_back(compiled);
+    return;
+  }
+
+  for (int i = 0; i < compiled.fNProngs; i++) {
+    const MCProng& prong = prongs[i];
+    fProngs.push_back({static_cast<int>(fGenerations.size()), prong.fNGenerations, static_cast<short>(compiled.fNProngs > 1 ? ancestors[i] : -1)});
+    for (int j = 0; j < prong.fNGenerations; j++) {
+      fGenerations.push_back({static_cast<int>(fSlotProngs.size()), prong.fSourceBits[j], prong.fExcludeSource[j], prong.fUseANDonSourceBitMap[j]});
+      fSlotProngs.push_back(&prongs[i]);
+      fSlotGenerations.push_back(j);
+    }
+    if (prong.fNGenerations > fMaxGenerations) {
+      fMaxGenerations = prong.fNGenerations;
+    }
+  }
+  fSignals.push_back(compiled);
+  // the number of slots changed, the PDG decisions have to be recomputed
+  fPDGDecisions.clear();
+}
+
+//________________________________________________________________________________________________
+const std::vector<uint64_t>& MCSignalMatcher::GetPDGDecisions(int pdg)
+{
+  //
+  // PDG decisions of all the slots for a PDG code, computed at the first occurence of the code
+  //
+  auto it = fPDGDecisions.find(pdg);
+  if (it != fPDGDecisions.end()) {
+    return it->second;
+  }
+  std::vector<uint64_t> decisions((fSlotProngs.size() + 63) / 64, 0);
+  for (size_t slot = 0; slot < fSlotProngs.size(); slot++) {
+    if (fSlotProngs[slot]->TestPDG(fSlotGenerations[slot], pdg)) {
+      decisions[slot / 64] |= (uint64_t(1) << (slot % 64));
+    }
+  }
+  return fPDGDecisions.emplace(pdg, std::move(decisions)).first->second;
+}
+
+//________________________________________________________________________________________________
+bool MCSignalMatcher::Evaluate(const Signal& signal, const History* histories, bool checkSources)
+{
+  //
+  // same decision as MCSignal::CheckSignal(), from the histories of the particles
+  //
+  int64_t ancestorIndex = -1;
+  for (int i = 0; i < signal.fNProngs; i++) {
+    const Prong& prong = fProngs[signal.fFirstProng + i];
+    const History& history = histories[i];
+    if (!EvaluateProng(prong, history, checkSources)) {
+      return false;
+    }
+    if (prong.fCommonAncestor >= 0 && prong.fCommonAncestor < prong.fNGenerations) {
+      if (i == 0) {
+        ancestorIndex = history.fIndex[prong.fCommonAncestor];
+      } else if (history.fIndex[prong.fCommonAncestor] != ancestorIndex) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//________________________________________________________________________________________________
+bool MCSignalMatcher::EvaluateProng(const Prong& prong, const History& history, bool checkSources)
+{
+  //
+  // decision for a single prong, without its common ancestor
+  //
+  // all the generations have to exist in the stack
+  if (history.fNGenerations < prong.fNGenerations) {
+    return false;
+  }
+  for (int j = 0; j < prong.fNGenerations; j++) {
+    if (!TestPDG(fGenerations[prong.fFirstGeneration + j].fSlot, history.fPDG[j])) {
+      return false;
+    }
+  }
+  return !checkSources || EvaluateSources(prong, history);
+}
+
+//________________________________________________________________________________________________
+uint32_t MCSignalMatcher::CheckPair(const Leg& leg1, const Leg& leg2) const
+{
+  //
+  // the prong decisions are ANDed, the common ancestors being compared only for the signals which require one
+  //
+  uint32_t decisions = leg1.fFirstProng & leg2.fSecondProng;
+  for (uint32_t candidates = decisions; candidates; candidates &= candidates - 1) {
+    const int isig = __builtin_ctz(candidates);
+    const Prong& first = fProngs[fSignals[isig].fFirstProng];
+    const Prong& second = fProngs[fSignals[isig].fFirstProng + 1];
+    if (second.fCommonAncestor < 0 || second.fCommonAncestor >= second.fNGenerations) {
+      continue;
+    }
+    // the compiled signals requiring a common ancestor for the second prong require it for the first one
+    if (leg1.fHistory.fIndex[first.fCommonAncestor] != leg2.fHistory.fIndex[second.fCommonAncestor]) {
+      decisions &= ~(uint32_t(1) << isig);
+    }
+  }
+  return decisions;
+}
+
+//________________________________________________________________________________________________
+uint32_t MCSignalMatcher::GetUncompiledSignals(int nProngs) const
+{
+  uint32_t signals = 0;
+  for (size_t isig = 0; isig < fSignals.size(); ++isig) {
+    if (fSignals[isig].fNProngs == nProngs && !fSignals[isig].fCompiled) {
+      signals |= (uint32_t(1) << isig);
+    }
+  }
+  return signals;
+}
+
+//________________________________________________________________________________________________
+bool MCSignalMatcher::EvaluateSources(const Prong& prong, const History& history) const
+{
+  //
+  // sources of a prong, as in MCSignal::CheckProng(): the history moves one generation back only after
+  //   a generation with required sources
+  //
+  int current = 0;
+  for (int j = 0; j < prong.fNGenerations; j++) {
+    const Generation& generation = fGenerations[prong.fFirstGeneration + j];
+    if (!generation.fSourceBits) {
+      continue;
+    }
+    uint64_t sourcesDecision = 0;
+    for (int source = MCProng::kPhysicalPrimary; source <= MCProng::kFromBackgroundEvent; source++) {
+      const uint64_t bit = uint64_t(1) << source;
+      if ((generation.fSourceBits & bit) && (generation.fExcludeSource & bit) != static_cast<uint64_t>((history.fSources[current] >> source) & 1)) {
+        sourcesDecision |= bit;
+      }
+    }
+    if (!sourcesDecision) {
+      return false;
+    }
+    if (generation.fUseANDonSourceBitMap && (sourcesDecision != generation.fSourceBits)) {
+      return false;
+    }
+    if (j < prong.fNGenerations - 1) {
+      current++;
+    }
+  }
+  return true;
+}
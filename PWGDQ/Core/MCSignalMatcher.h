@@ -0,0 +1,174 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Class evaluating a list of MC signals at once for a tuple of MC particles
+//   The signals are compiled when added: each generation of each prong gets one slot, and the PDG decisions of all the
+//   slots are computed once per PDG code and cached as a bit map. For each particle, the history (PDG code, source
+//   bits and index of its mothers) is walked only once, and all the signals are evaluated on it, giving one bit map
+//   with the bit i set if the particles match the i-th signal, like the loops over MCSignal::CheckSignal().
+//   Signals with prongs checked in time (through the daughters) are evaluated with MCSignal::CheckSignal().
+//   For pairs, the prong decisions of each leg can be computed once with FillLeg(), the 2-prong decisions of a pair
+//   being then the AND of the bit maps of its legs, with only the common ancestors to be compared (CheckPair()).
+//
+
+#ifndef MCSignalMatcher_H
+#define MCSignalMatcher_H
+
+#include "PWGDQ/Core/MCProng.h"
+#include "PWGDQ/Core/MCSignal.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//_________________________________________________________________________
+class MCSignalMatcher
+{
+ public:
+  static constexpr int kMaxGenerations = 16;
+
+  // History of a particle, the entry 0 is the particle itself
+  struct History {
+    int fNGenerations = 0; // number of recorded generations, fewer than requested if the history ends
+    std::array<int, kMaxGenerations> fPDG;
+    std::array<uint8_t, kMaxGenerations> fSources; // bit MCProng::Source set if the particle has the source
+    std::array<int64_t, kMaxGenerations> fIndex;
+  };
+
+  // Particle used as a leg of pairs, with the compiled 2-prong signals whose first and second prong it matches
+  struct Leg {
+    History fHistory;
+    uint32_t fFirstProng = 0;
+    uint32_t fSecondProng = 0;
+  };
+
+  MCSignalMatcher() = default;
+  ~MCSignalMatcher() = default;
+
+  // Add a signal, the decision for the i-th added signal is stored in the bit i of the bit maps
+  void AddSignal(MCSignal* signal);
+  int GetNSignals() const { return fSignals.size(); }
+  bool IsCompiled(int signal) const { return fSignals[signal].fCompiled; }
+
+  // Bit map of the signals matched by the particles; signals with a different number of prongs are not matched
+  template <typename U, typename... T>
+  uint32_t CheckSignals(bool checkSources, const U& mcStack, const T&... particles)
+  {
+    constexpr int nParticles = sizeof...(particles);
+    std::array<History, nParticles> histories;
+    int i = 0;
+    ((FillHistory<U>(particles, checkSources, histories[i++])), ...);
+
+    uint32_t decisions = 0;
+    for (size_t isig = 0; isig < fSignals.size(); ++isig) {
+      const auto& signal = fSignals[isig];
+      if (signal.fNProngs != nParticles) {
+        continue;
+      }
+      bool matched = signal.fCompiled ? Evaluate(signal, histories.data(), checkSources) : signal.fSignal->CheckSignal(checkSources, mcStack, particles...);
+      if (matched) {
+        decisions |= (uint32_t(1) << isig);
+      }
+    }
+    return decisions;
+  }
+
+  // Prong decisions of a particle for the compiled 2-prong signals, to be combined for all its pairs with CheckPair()
+  template <typename U, typename T>
+  void FillLeg(bool checkSources, const T& particle, Leg& leg)
+  {
+    FillHistory<U>(particle, checkSources, leg.fHistory);
+    leg.fFirstProng = 0;
+    leg.fSecondProng = 0;
+    for (size_t isig = 0; isig < fSignals.size(); ++isig) {
+      const auto& signal = fSignals[isig];
+      if (signal.fNProngs != 2 || !signal.fCompiled) {
+        continue;
+      }
+      if (EvaluateProng(fProngs[signal.fFirstProng], leg.fHistory, checkSources)) {
+        leg.fFirstProng |= (uint32_t(1) << isig);
+      }
+      if (EvaluateProng(fProngs[signal.fFirstProng + 1], leg.fHistory, checkSources)) {
+        leg.fSecondProng |= (uint32_t(1) << isig);
+      }
+    }
+  }
+  // Bit map of the compiled 2-prong signals matched by the pair of legs, the same as CheckSignals() for these signals
+  uint32_t CheckPair(const Leg& leg1, const Leg& leg2) const;
+  // Bit map of the signals with the given number of prongs which are not compiled, to be checked with CheckSignals()
+  uint32_t GetUncompiledSignals(int nProngs) const;
+
+ private:
+  // one generation of a prong
+  struct Generation {
+    int fSlot; // bit of the PDG decision in the bit maps of fPDGDecisions
+    uint64_t fSourceBits;
+    uint64_t fExcludeSource;
+    bool fUseANDonSourceBitMap;
+  };
+
+  struct Prong {
+    int fFirstGeneration; // position of the first generation in fGenerations
+    int fNGenerations;
+    short fCommonAncestor; // generation of the common ancestor, -1 if none
+  };
+
+  struct Signal {
+    MCSignal* fSignal;
+    int fNProngs;
+    bool fCompiled;   // false if evaluated with MCSignal::CheckSignal()
+    int fFirstProng;  // position of the first prong in fProngs
+  };
+
+  std::vector<Signal> fSignals;
+  std::vector<Prong> fProngs;
+  std::vector<Generation> fGenerations;
+  std::vector<const MCProng*> fSlotProngs; // prong and generation of each slot, to compute the PDG decisions
+  std::vector<int> fSlotGenerations;
+  int fMaxGenerations = 0; // largest number of generations of the compiled signals
+  std::unordered_map<int, std::vector<uint64_t>> fPDGDecisions; // PDG decisions of all the slots, per PDG code
+
+  template <typename U, typename T>
+  void FillHistory(const T& particle, bool checkSources, History& history) const;
+  const std::vector<uint64_t>& GetPDGDecisions(int pdg);
+  bool TestPDG(int slot, int pdg)
+  {
+    return (GetPDGDecisions(pdg)[slot / 64] >> (slot % 64)) & 1;
+  }
+  bool Evaluate(const Signal& signal, const History* histories, bool checkSources);
+  bool EvaluateProng(const Prong& prong, const History& history, bool checkSources);
+  bool EvaluateSources(const Prong& prong, const History& history) const;
+};
+
+//_________________________________________________________________________
+template <typename U, typename T>
+void MCSignalMatcher::FillHistory(const T& particle, bool checkSources, History& history) const
+{
+  // walk back in history through the first mothers, as MCSignal::CheckProng()
+  auto current = particle;
+  history.fNGenerations = 0;
+  for (int j = 0; j < fMaxGenerations; j++) {
+    history.fPDG[j] = current.pdgCode();
+    history.fSources[j] = !checkSources ? 0 : ((current.isPhysicalPrimary() ? (uint8_t(1) << MCProng::kPhysicalPrimary) : 0) |
+                                               (!current.producedByGenerator() ? (uint8_t(1) << MCProng::kProducedInTransport) : 0) |
+                                               (current.producedByGenerator() ? (uint8_t(1) << MCProng::kProducedByGenerator) : 0) |
+                                               (current.fromBackgroundEvent() ? (uint8_t(1) << MCProng::kFromBackgroundEvent) : 0));
+    history.fIndex[j] = current.globalIndex();
+    history.fNGenerations++;
+    if (j == fMaxGenerations - 1 || !current.has_mothers()) {
+      break;
+    }
+    current = current.template mothers_first_as<U>();
+  }
+}
+
+#endif
@@ -63,6 +63,7 @@ void MixingHandler::AddMixingVariable(int var, int nBins, float* binLims)
   varBins.Set(nBins, binLims);
   fVariableLimits.push_back(varBins);
   VarManager::SetUseVariable(var);
+  fIsInitialized = kFALSE;
 }
 
 //_________________________________________________________________________
@@ -111,11 +112,11 @@ void MixingHandler::Init()
   // Initialization of pools
   //       The correct event category will be retrieved using the function FindEventCategory()
   //
-  int size = 1;
-  for (auto v : fVariableLimits) {
-    size *= (v.GetSize() - 1);
+  fBinning = eventmixing::MixingBinning();
+  for (auto& v : fVariableLimits) {
+    fBinning.addAxis(std::vector<float>(v.GetArray(), v.GetArray() + v.GetSize()));
   }
-  (void)size;
+  fValues.resize(fVariables.size());
   fIsInitialized = kTRUE;
 }
 
@@ -132,33 +133,10 @@ int MixingHandler::FindEventCategory(float* values)
     Init();
   }
 
-  std::vector<int> bin;
-  int iVar = 0;
-  for (auto v = fVariableLimits.begin(); v != fVariableLimits.end(); v++, iVar++) {
-    int binValue = TMath::BinarySearch((*v).GetSize(), (*v).GetArray(), values[fVariables[iVar]]);
-    bin.push_back(binValue);
-    if (bin[iVar] == -1 || bin[iVar] == (*v).GetSize() - 1) {
-      return -1; // all variables must be inside limits
-    }
-  }
-
-  int category = 0;
-  int tempCategory = 1;
-  int iv1 = 0;
-  int iv2 = 0;
-  for (auto v1 = fVariables.begin(); v1 != fVariables.end(); v1++, iv1++) {
-    tempCategory = 1;
-    iv2 = iv1;
-    for (auto v2 = v1; v2 != fVariables.end(); v2++, iv2++) {
-      if (iv2 == iv1) {
-        tempCategory *= bin[iv2];
-      } else {
-        tempCategory *= (fVariableLimits[iv2].GetSize() - 1);
-      }
-    }
-    category += tempCategory;
+  for (size_t iVar = 0; iVar < fVariables.size(); ++iVar) {
+    fValues[iVar] = values[fVariables[iVar]];
   }
-  return category;
+  return fBinning.getBin(fValues.data()); // -1 unless all variables are inside limits
 }
 
 //_________________________________________________________________________
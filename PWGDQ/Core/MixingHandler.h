@@ -24,6 +24,7 @@
 #include <TList.h>
 #include <TString.h>
 
+#include "Common/Core/EventMixing.h"
 #include "PWGDQ/Core/HistogramManager.h"
 #include "PWGDQ/Core/VarManager.h"
 
@@ -58,6 +59,9 @@ class MixingHandler : public TNamed
   std::vector<TArrayF> fVariableLimits;
   std::vector<int> fVariables;
 
+  eventmixing::MixingBinning fBinning; //! binning of the mixing variables, set up in Init()
+  std::vector<float> fValues;          //! values of the mixing variables of the current event
+
   ClassDef(MixingHandler, 1);
 };
 
@@ -17,6 +17,7 @@
 #pragma link C++ class HistogramManager + ;
 #pragma link C++ class MixingHandler + ;
 #pragma link C++ class AnalysisCut + ;
+#pragma link C++ struct AnalysisCut::CutContainer + ;
 #pragma link C++ class AnalysisCompositeCut + ;
 #pragma link C++ class MCProng + ;
 #pragma link C++ class MCSignal + ;
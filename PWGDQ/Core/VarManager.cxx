@@ -21,10 +21,12 @@ bool VarManager::fgUsedVars[VarManager::kNVars] = {kFALSE};
 float VarManager::fgValues[VarManager::kNVars] = {0.0f};
 std::map<int, int> VarManager::fgRunMap;
 TString VarManager::fgRunStr = "";
-o2::vertexing::DCAFitterN<2> VarManager::fgFitterTwoProngBarrel;
-o2::vertexing::DCAFitterN<3> VarManager::fgFitterThreeProngBarrel;
-o2::vertexing::FwdDCAFitterN<2> VarManager::fgFitterTwoProngFwd;
-o2::vertexing::FwdDCAFitterN<3> VarManager::fgFitterThreeProngFwd;
+VarManager::Context VarManager::fgDefaultContext(VarManager::fgValues);
+
+namespace
+{
+thread_local VarManager::Context* gThreadContext = nullptr; // context selected by the calling thread, nullptr for the default one
+}
 
 //__________________________________________________________________
 VarManager::VarManager() : TObject()
@@ -38,6 +40,21 @@ VarManager::VarManager() : TObject()
 //__________________________________________________________________
 VarManager::~VarManager() = default;
 
+//__________________________________________________________________
+void VarManager::SetThreadContext(Context* context)
+{
+  //
+  // select the context used by the Fill functions called from this thread
+  //
+  gThreadContext = context;
+}
+
+//__________________________________________________________________
+VarManager::Context& VarManager::GetContext()
+{
+  return gThreadContext ? *gThreadContext : fgDefaultContext;
+}
+
 //__________________________________________________________________
 void VarManager::SetVariableDependencies()
 {
@@ -57,7 +74,7 @@ void VarManager::ResetValues(int startValue, int endValue, float* values)
   // reset all variables to an "innocent" value
   // NOTE: here we use -9999.0 as a neutral value, but depending on situation, this may not be the case
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
   for (Int_t i = startValue; i < endValue; ++i) {
     values[i] = -9999.;
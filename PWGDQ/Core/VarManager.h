@@ -24,6 +24,7 @@
 #include "Math/GenVector/Boost.h"
 #include <TRandom.h>
 
+#include <array>
 #include <vector>
 #include <map>
 #include <cmath>
@@ -362,27 +363,58 @@ class VarManager : public TObject
     return fgRunStr;
   }
 
+  // State of the Fill functions which cannot be shared between threads: the values buffer and the vertexing fitters.
+  // The static API uses a default context, which fills fgValues. A worker thread owns its context, selects it with
+  // SetThreadContext() and then configures its fitters with the Setup functions, which apply to the current context.
+  struct Context {
+    Context() : values(buffer) {}
+    explicit Context(float* valuesBuffer) : values(valuesBuffer) {}
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    float buffer[kNVars] = {0.0f}; // values buffer owned by the context, unused if an external one is given
+    float* values;                 // values filled when no explicit array is passed to the Fill functions
+    o2::vertexing::DCAFitterN<2> fitterTwoProngBarrel;
+    o2::vertexing::DCAFitterN<3> fitterThreeProngBarrel;
+    o2::vertexing::FwdDCAFitterN<2> fitterTwoProngFwd;
+    o2::vertexing::FwdDCAFitterN<3> fitterThreeProngFwd;
+  };
+  static void SetThreadContext(Context* context); // nullptr restores the default context for the calling thread
+  static Context& GetContext();                   // context of the calling thread
+
   // Setup the 2 prong DCAFitterN
   static void SetupTwoProngDCAFitter(float magField, bool propagateToPCA, float maxR, float maxDZIni, float minParamChange, float minRelChi2Change, bool useAbsDCA)
   {
-    fgFitterTwoProngBarrel.setBz(magField);
-    fgFitterTwoProngBarrel.setPropagateToPCA(propagateToPCA);
-    fgFitterTwoProngBarrel.setMaxR(maxR);
-    fgFitterTwoProngBarrel.setMaxDZIni(maxDZIni);
-    fgFitterTwoProngBarrel.setMinParamChange(minParamChange);
-    fgFitterTwoProngBarrel.setMinRelChi2Change(minRelChi2Change);
-    fgFitterTwoProngBarrel.setUseAbsDCA(useAbsDCA);
+    GetContext().fitterTwoProngBarrel.setBz(magField);
+    GetContext().fitterTwoProngBarrel.setPropagateToPCA(propagateToPCA);
+    GetContext().fitterTwoProngBarrel.setMaxR(maxR);
+    GetContext().fitterTwoProngBarrel.setMaxDZIni(maxDZIni);
+    GetContext().fitterTwoProngBarrel.setMinParamChange(minParamChange);
+    GetContext().fitterTwoProngBarrel.setMinRelChi2Change(minRelChi2Change);
+    GetContext().fitterTwoProngBarrel.setUseAbsDCA(useAbsDCA);
+  }
+
+  // Setup the 3 prong DCAFitterN
+  static void SetupThreeProngDCAFitter(float magField, bool propagateToPCA, float maxR, float maxDZIni, float minParamChange, float minRelChi2Change, bool useAbsDCA)
+  {
+    GetContext().fitterThreeProngBarrel.setBz(magField);
+    GetContext().fitterThreeProngBarrel.setPropagateToPCA(propagateToPCA);
+    GetContext().fitterThreeProngBarrel.setMaxR(maxR);
+    GetContext().fitterThreeProngBarrel.setMaxDZIni(maxDZIni);
+    GetContext().fitterThreeProngBarrel.setMinParamChange(minParamChange);
+    GetContext().fitterThreeProngBarrel.setMinRelChi2Change(minRelChi2Change);
+    GetContext().fitterThreeProngBarrel.setUseAbsDCA(useAbsDCA);
   }
 
   // Setup the 2 prong FwdDCAFitterN
   static void SetupTwoProngFwdDCAFitter(float magField, bool propagateToPCA, float maxR, float minParamChange, float minRelChi2Change, bool useAbsDCA)
   {
-    fgFitterTwoProngFwd.setBz(magField);
-    fgFitterTwoProngFwd.setPropagateToPCA(propagateToPCA);
-    fgFitterTwoProngFwd.setMaxR(maxR);
-    fgFitterTwoProngFwd.setMinParamChange(minParamChange);
-    fgFitterTwoProngFwd.setMinRelChi2Change(minRelChi2Change);
-    fgFitterTwoProngFwd.setUseAbsDCA(useAbsDCA);
+    GetContext().fitterTwoProngFwd.setBz(magField);
+    GetContext().fitterTwoProngFwd.setPropagateToPCA(propagateToPCA);
+    GetContext().fitterTwoProngFwd.setMaxR(maxR);
+    GetContext().fitterTwoProngFwd.setMinParamChange(minParamChange);
+    GetContext().fitterTwoProngFwd.setMinRelChi2Change(minRelChi2Change);
+    GetContext().fitterTwoProngFwd.setUseAbsDCA(useAbsDCA);
   }
   static auto getEventPlane(int harm, float qnxa, float qnya)
   {
@@ -390,9 +422,25 @@ class VarManager : public TObject
     return (1.0 / harm) * TMath::ATan(qnya / qnxa);
   };
 
-  template <uint32_t fillMap, typename T>
+  // Compile-time selection of the variables computed by FillEvent and FillTrack.
+  // The variables of an enabled table are all computed by default, those not in a VariableSet are skipped at compile time.
+  // NOTE: a set has to include the variables the derived ones are computed from, e.g. kPt and kEta for kP, kRunNo for kRunId
+  struct AllVariables {
+    static constexpr bool uses(int) { return true; }
+  };
+  template <int... vars>
+  struct VariableSet {
+    static constexpr bool uses(int var) { return ((var == vars) || ...); }
+  };
+  template <typename VarSet>
+  static bool IsUsed(int var)
+  {
+    return VarSet::uses(var) && fgUsedVars[var];
+  }
+
+  template <uint32_t fillMap, typename VarSet = AllVariables, typename T>
   static void FillEvent(T const& event, float* values = nullptr);
-  template <uint32_t fillMap, typename T>
+  template <uint32_t fillMap, typename VarSet = AllVariables, typename T>
   static void FillTrack(T const& track, float* values = nullptr);
   template <int pairType, uint32_t fillMap, typename T1, typename T2>
   static void FillPair(T1 const& t1, T2 const& t2, float* values = nullptr);
@@ -403,7 +451,11 @@ class VarManager : public TObject
   template <int pairType, uint32_t collFillMap, uint32_t fillMap, typename C, typename T>
   static void FillPairVertexing(C const& collision, T const& t1, T const& t2, float* values = nullptr);
   template <int candidateType, uint32_t collFillMap, uint32_t fillMap, typename C, typename T1>
-  static void FillDileptonTrackVertexing(C const& collision, T1 const& lepton1, T1 const& lepton2, T1 const& track, float* values);
+  static void FillDileptonTrackVertexing(C const& collision, T1 const& lepton1, T1 const& lepton2, T1 const& track, float* values, int dileptonProcCode = -1);
+  template <int candidateType, uint32_t fillMap, typename T1>
+  static int FitDileptonVertex(T1 const& lepton1, T1 const& lepton2, std::array<float, 3>& vertex);
+  template <uint32_t fillMap, typename T>
+  static float GetTrackDistanceToPoint(T const& track, const std::array<float, 3>& point);
   template <typename T1, typename T2>
   static void FillDileptonHadron(T1 const& dilepton, T2 const& hadron, float* values = nullptr, float hadronMass = 0.0f);
   template <typename C, typename A>
@@ -430,11 +482,10 @@ class VarManager : public TObject
 
   template <typename T, typename U, typename V>
   static auto getRotatedCovMatrixXX(const T& matrix, U phi, V theta);
+  template <typename T>
+  static o2::track::TrackParCov getBarrelTrackParCov(T const& track);
 
-  static o2::vertexing::DCAFitterN<2> fgFitterTwoProngBarrel;
-  static o2::vertexing::DCAFitterN<3> fgFitterThreeProngBarrel;
-  static o2::vertexing::FwdDCAFitterN<2> fgFitterTwoProngFwd;
-  static o2::vertexing::FwdDCAFitterN<3> fgFitterThreeProngFwd;
+  static Context fgDefaultContext; // context of the static API, filling fgValues
 
   VarManager& operator=(const VarManager& c);
   VarManager(const VarManager& c);
@@ -457,276 +508,452 @@ auto VarManager::getRotatedCovMatrixXX(const T& matrix, U phi, V theta)
          + matrix[5] * st * st;               // covZZ
 }
 
-template <uint32_t fillMap, typename T>
+template <typename T>
+o2::track::TrackParCov VarManager::getBarrelTrackParCov(T const& track)
+{
+  std::array<float, 5> pars = {track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt()};
+  std::array<float, 15> covs = {track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
+                                track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
+                                track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2()};
+  return o2::track::TrackParCov{track.x(), track.alpha(), pars, covs};
+}
+
+template <uint32_t fillMap, typename VarSet, typename T>
 void VarManager::FillEvent(T const& event, float* values)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   if constexpr ((fillMap & BC) > 0) {
-    values[kRunNo] = event.bc().runNumber(); // accessed via Collisions table
-    values[kBC] = event.bc().globalBC();
+    if constexpr (VarSet::uses(kRunNo)) {
+      values[kRunNo] = event.bc().runNumber(); // accessed via Collisions table
+    }
+    if constexpr (VarSet::uses(kBC)) {
+      values[kBC] = event.bc().globalBC();
+    }
   }
 
   if constexpr ((fillMap & CollisionTimestamp) > 0) {
-    values[kTimestamp] = event.timestamp();
+    if constexpr (VarSet::uses(kTimestamp)) {
+      values[kTimestamp] = event.timestamp();
+    }
   }
 
   if constexpr ((fillMap & Collision) > 0) {
     // TODO: trigger info from the event selection requires a separate flag
     //       so that it can be switched off independently of the rest of Collision variables (e.g. if event selection is not available)
-    if (fgUsedVars[kIsINT7]) {
+    if (IsUsed<VarSet>(kIsINT7)) {
       values[kIsINT7] = (event.alias()[kINT7] > 0);
     }
-    if (fgUsedVars[kIsEMC7]) {
+    if (IsUsed<VarSet>(kIsEMC7)) {
       values[kIsEMC7] = (event.alias()[kEMC7] > 0);
     }
-    if (fgUsedVars[kIsINT7inMUON]) {
+    if (IsUsed<VarSet>(kIsINT7inMUON)) {
       values[kIsINT7inMUON] = (event.alias()[kINT7inMUON] > 0);
     }
-    if (fgUsedVars[kIsMuonSingleLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonSingleLowPt7)) {
       values[kIsMuonSingleLowPt7] = (event.alias()[kMuonSingleLowPt7] > 0);
     }
-    if (fgUsedVars[kIsMuonSingleHighPt7]) {
+    if (IsUsed<VarSet>(kIsMuonSingleHighPt7)) {
       values[kIsMuonSingleHighPt7] = (event.alias()[kMuonSingleHighPt7] > 0);
     }
-    if (fgUsedVars[kIsMuonUnlikeLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonUnlikeLowPt7)) {
       values[kIsMuonUnlikeLowPt7] = (event.alias()[kMuonUnlikeLowPt7] > 0);
     }
-    if (fgUsedVars[kIsMuonLikeLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonLikeLowPt7)) {
       values[kIsMuonLikeLowPt7] = (event.alias()[kMuonLikeLowPt7] > 0);
     }
-    if (fgUsedVars[kIsCUP8]) {
+    if (IsUsed<VarSet>(kIsCUP8)) {
       values[kIsCUP8] = (event.alias()[kCUP8] > 0);
     }
-    if (fgUsedVars[kIsCUP9]) {
+    if (IsUsed<VarSet>(kIsCUP9)) {
       values[kIsCUP9] = (event.alias()[kCUP9] > 0);
     }
-    if (fgUsedVars[kIsMUP10]) {
+    if (IsUsed<VarSet>(kIsMUP10)) {
       values[kIsMUP10] = (event.alias()[kMUP10] > 0);
     }
-    if (fgUsedVars[kIsMUP11]) {
+    if (IsUsed<VarSet>(kIsMUP11)) {
       values[kIsMUP11] = (event.alias()[kMUP11] > 0);
     }
-    values[kVtxX] = event.posX();
-    values[kVtxY] = event.posY();
-    values[kVtxZ] = event.posZ();
-    values[kVtxNcontrib] = event.numContrib();
-    values[kVtxCovXX] = event.covXX();
-    values[kVtxCovXY] = event.covXY();
-    values[kVtxCovXZ] = event.covXZ();
-    values[kVtxCovYY] = event.covYY();
-    values[kVtxCovYZ] = event.covYZ();
-    values[kVtxCovZZ] = event.covZZ();
-    values[kVtxChi2] = event.chi2();
+    if constexpr (VarSet::uses(kVtxX)) {
+      values[kVtxX] = event.posX();
+    }
+    if constexpr (VarSet::uses(kVtxY)) {
+      values[kVtxY] = event.posY();
+    }
+    if constexpr (VarSet::uses(kVtxZ)) {
+      values[kVtxZ] = event.posZ();
+    }
+    if constexpr (VarSet::uses(kVtxNcontrib)) {
+      values[kVtxNcontrib] = event.numContrib();
+    }
+    if constexpr (VarSet::uses(kVtxCovXX)) {
+      values[kVtxCovXX] = event.covXX();
+    }
+    if constexpr (VarSet::uses(kVtxCovXY)) {
+      values[kVtxCovXY] = event.covXY();
+    }
+    if constexpr (VarSet::uses(kVtxCovXZ)) {
+      values[kVtxCovXZ] = event.covXZ();
+    }
+    if constexpr (VarSet::uses(kVtxCovYY)) {
+      values[kVtxCovYY] = event.covYY();
+    }
+    if constexpr (VarSet::uses(kVtxCovYZ)) {
+      values[kVtxCovYZ] = event.covYZ();
+    }
+    if constexpr (VarSet::uses(kVtxCovZZ)) {
+      values[kVtxCovZZ] = event.covZZ();
+    }
+    if constexpr (VarSet::uses(kVtxChi2)) {
+      values[kVtxChi2] = event.chi2();
+    }
   }
 
   if constexpr ((fillMap & CollisionCent) > 0) {
-    values[kCentVZERO] = event.centRun2V0M();
+    if constexpr (VarSet::uses(kCentVZERO)) {
+      values[kCentVZERO] = event.centRun2V0M();
+    }
   }
 
   // TODO: need to add EvSels and Cents tables, etc. in case of the central data model
 
   if constexpr ((fillMap & ReducedEvent) > 0) {
-    values[kRunNo] = event.runNumber();
-    values[kVtxX] = event.posX();
-    values[kVtxY] = event.posY();
-    values[kVtxZ] = event.posZ();
-    values[kVtxNcontrib] = event.numContrib();
+    if constexpr (VarSet::uses(kRunNo)) {
+      values[kRunNo] = event.runNumber();
+    }
+    if constexpr (VarSet::uses(kVtxX)) {
+      values[kVtxX] = event.posX();
+    }
+    if constexpr (VarSet::uses(kVtxY)) {
+      values[kVtxY] = event.posY();
+    }
+    if constexpr (VarSet::uses(kVtxZ)) {
+      values[kVtxZ] = event.posZ();
+    }
+    if constexpr (VarSet::uses(kVtxNcontrib)) {
+      values[kVtxNcontrib] = event.numContrib();
+    }
   }
 
   if constexpr ((fillMap & ReducedEventExtended) > 0) {
-    values[kBC] = event.globalBC();
-    values[kTimestamp] = event.timestamp();
-    values[kCentVZERO] = event.centRun2V0M();
-    if (fgUsedVars[kIsINT7]) {
+    if constexpr (VarSet::uses(kBC)) {
+      values[kBC] = event.globalBC();
+    }
+    if constexpr (VarSet::uses(kTimestamp)) {
+      values[kTimestamp] = event.timestamp();
+    }
+    if constexpr (VarSet::uses(kCentVZERO)) {
+      values[kCentVZERO] = event.centRun2V0M();
+    }
+    if (IsUsed<VarSet>(kIsINT7)) {
       values[kIsINT7] = (event.triggerAlias() & (uint32_t(1) << kINT7)) > 0;
     }
-    if (fgUsedVars[kIsEMC7]) {
+    if (IsUsed<VarSet>(kIsEMC7)) {
       values[kIsEMC7] = (event.triggerAlias() & (uint32_t(1) << kEMC7)) > 0;
     }
-    if (fgUsedVars[kIsINT7inMUON]) {
+    if (IsUsed<VarSet>(kIsINT7inMUON)) {
       values[kIsINT7inMUON] = (event.triggerAlias() & (uint32_t(1) << kINT7inMUON)) > 0;
     }
-    if (fgUsedVars[kIsMuonSingleLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonSingleLowPt7)) {
       values[kIsMuonSingleLowPt7] = (event.triggerAlias() & (uint32_t(1) << kMuonSingleLowPt7)) > 0;
     }
-    if (fgUsedVars[kIsMuonSingleHighPt7]) {
+    if (IsUsed<VarSet>(kIsMuonSingleHighPt7)) {
       values[kIsMuonSingleHighPt7] = (event.triggerAlias() & (uint32_t(1) << kMuonSingleHighPt7)) > 0;
     }
-    if (fgUsedVars[kIsMuonUnlikeLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonUnlikeLowPt7)) {
       values[kIsMuonUnlikeLowPt7] = (event.triggerAlias() & (uint32_t(1) << kMuonUnlikeLowPt7)) > 0;
     }
-    if (fgUsedVars[kIsMuonLikeLowPt7]) {
+    if (IsUsed<VarSet>(kIsMuonLikeLowPt7)) {
       values[kIsMuonLikeLowPt7] = (event.triggerAlias() & (uint32_t(1) << kMuonLikeLowPt7)) > 0;
     }
-    if (fgUsedVars[kIsCUP8]) {
+    if (IsUsed<VarSet>(kIsCUP8)) {
       values[kIsCUP8] = (event.triggerAlias() & (uint32_t(1) << kCUP8)) > 0;
     }
-    if (fgUsedVars[kIsCUP9]) {
+    if (IsUsed<VarSet>(kIsCUP9)) {
       values[kIsCUP9] = (event.triggerAlias() & (uint32_t(1) << kCUP9)) > 0;
     }
-    if (fgUsedVars[kIsMUP10]) {
+    if (IsUsed<VarSet>(kIsMUP10)) {
       values[kIsMUP10] = (event.triggerAlias() & (uint32_t(1) << kMUP10)) > 0;
     }
-    if (fgUsedVars[kIsMUP11]) {
+    if (IsUsed<VarSet>(kIsMUP11)) {
       values[kIsMUP11] = (event.triggerAlias() & (uint32_t(1) << kMUP11)) > 0;
     }
   }
 
   if constexpr ((fillMap & ReducedEventVtxCov) > 0) {
-    values[kVtxCovXX] = event.covXX();
-    values[kVtxCovXY] = event.covXY();
-    values[kVtxCovXZ] = event.covXZ();
-    values[kVtxCovYY] = event.covYY();
-    values[kVtxCovYZ] = event.covYZ();
-    values[kVtxCovZZ] = event.covZZ();
-    values[kVtxChi2] = event.chi2();
+    if constexpr (VarSet::uses(kVtxCovXX)) {
+      values[kVtxCovXX] = event.covXX();
+    }
+    if constexpr (VarSet::uses(kVtxCovXY)) {
+      values[kVtxCovXY] = event.covXY();
+    }
+    if constexpr (VarSet::uses(kVtxCovXZ)) {
+      values[kVtxCovXZ] = event.covXZ();
+    }
+    if constexpr (VarSet::uses(kVtxCovYY)) {
+      values[kVtxCovYY] = event.covYY();
+    }
+    if constexpr (VarSet::uses(kVtxCovYZ)) {
+      values[kVtxCovYZ] = event.covYZ();
+    }
+    if constexpr (VarSet::uses(kVtxCovZZ)) {
+      values[kVtxCovZZ] = event.covZZ();
+    }
+    if constexpr (VarSet::uses(kVtxChi2)) {
+      values[kVtxChi2] = event.chi2();
+    }
   }
 
   if constexpr ((fillMap & ReducedEventQvector) > 0) {
-    values[kQ2X0A] = event.q2x0a();
-    values[kQ2Y0A] = event.q2y0a();
-    values[kQ2X0B] = event.q2x0b();
-    values[kQ2Y0B] = event.q2y0b();
-    values[kQ2X0C] = event.q2x0c();
-    values[kQ2Y0C] = event.q2y0c();
-    values[kMultA] = event.multa();
-    values[kMultB] = event.multb();
-    values[kMultC] = event.multc();
-    values[kQ3X0A] = event.q3x0a();
-    values[kQ3Y0A] = event.q3y0a();
-    values[kQ3X0B] = event.q3x0b();
-    values[kQ3Y0B] = event.q3y0b();
-    values[kQ3X0C] = event.q3x0c();
-    values[kQ3Y0C] = event.q3y0c();
-    values[kR2SP] = (event.q2x0b() * event.q2x0c() + event.q2y0b() * event.q2y0c());
-    values[kR3SP] = (event.q3x0b() * event.q3x0c() + event.q3y0b() * event.q3y0c());
-    values[kR2EP] = TMath::Cos(2 * (getEventPlane(2, event.q2x0b(), event.q2y0b()) - getEventPlane(2, event.q2x0c(), event.q2y0c())));
-    values[kR3EP] = TMath::Cos(3 * (getEventPlane(3, event.q3x0b(), event.q3y0b()) - getEventPlane(3, event.q3x0c(), event.q3y0c())));
+    if constexpr (VarSet::uses(kQ2X0A)) {
+      values[kQ2X0A] = event.q2x0a();
+    }
+    if constexpr (VarSet::uses(kQ2Y0A)) {
+      values[kQ2Y0A] = event.q2y0a();
+    }
+    if constexpr (VarSet::uses(kQ2X0B)) {
+      values[kQ2X0B] = event.q2x0b();
+    }
+    if constexpr (VarSet::uses(kQ2Y0B)) {
+      values[kQ2Y0B] = event.q2y0b();
+    }
+    if constexpr (VarSet::uses(kQ2X0C)) {
+      values[kQ2X0C] = event.q2x0c();
+    }
+    if constexpr (VarSet::uses(kQ2Y0C)) {
+      values[kQ2Y0C] = event.q2y0c();
+    }
+    if constexpr (VarSet::uses(kMultA)) {
+      values[kMultA] = event.multa();
+    }
+    if constexpr (VarSet::uses(kMultB)) {
+      values[kMultB] = event.multb();
+    }
+    if constexpr (VarSet::uses(kMultC)) {
+      values[kMultC] = event.multc();
+    }
+    if constexpr (VarSet::uses(kQ3X0A)) {
+      values[kQ3X0A] = event.q3x0a();
+    }
+    if constexpr (VarSet::uses(kQ3Y0A)) {
+      values[kQ3Y0A] = event.q3y0a();
+    }
+    if constexpr (VarSet::uses(kQ3X0B)) {
+      values[kQ3X0B] = event.q3x0b();
+    }
+    if constexpr (VarSet::uses(kQ3Y0B)) {
+      values[kQ3Y0B] = event.q3y0b();
+    }
+    if constexpr (VarSet::uses(kQ3X0C)) {
+      values[kQ3X0C] = event.q3x0c();
+    }
+    if constexpr (VarSet::uses(kQ3Y0C)) {
+      values[kQ3Y0C] = event.q3y0c();
+    }
+    if constexpr (VarSet::uses(kR2SP)) {
+      values[kR2SP] = (event.q2x0b() * event.q2x0c() + event.q2y0b() * event.q2y0c());
+    }
+    if constexpr (VarSet::uses(kR3SP)) {
+      values[kR3SP] = (event.q3x0b() * event.q3x0c() + event.q3y0b() * event.q3y0c());
+    }
+    if constexpr (VarSet::uses(kR2EP)) {
+      values[kR2EP] = TMath::Cos(2 * (getEventPlane(2, event.q2x0b(), event.q2y0b()) - getEventPlane(2, event.q2x0c(), event.q2y0c())));
+    }
+    if constexpr (VarSet::uses(kR3EP)) {
+      values[kR3EP] = TMath::Cos(3 * (getEventPlane(3, event.q3x0b(), event.q3y0b()) - getEventPlane(3, event.q3x0c(), event.q3y0c())));
+    }
   }
 
   if constexpr ((fillMap & CollisionMC) > 0) {
-    values[kMCEventGeneratorId] = event.generatorsID();
-    values[kMCVtxX] = event.posX();
-    values[kMCVtxY] = event.posY();
-    values[kMCVtxZ] = event.posZ();
-    values[kMCEventTime] = event.t();
-    values[kMCEventWeight] = event.weight();
-    values[kMCEventImpParam] = event.impactParameter();
+    if constexpr (VarSet::uses(kMCEventGeneratorId)) {
+      values[kMCEventGeneratorId] = event.generatorsID();
+    }
+    if constexpr (VarSet::uses(kMCVtxX)) {
+      values[kMCVtxX] = event.posX();
+    }
+    if constexpr (VarSet::uses(kMCVtxY)) {
+      values[kMCVtxY] = event.posY();
+    }
+    if constexpr (VarSet::uses(kMCVtxZ)) {
+      values[kMCVtxZ] = event.posZ();
+    }
+    if constexpr (VarSet::uses(kMCEventTime)) {
+      values[kMCEventTime] = event.t();
+    }
+    if constexpr (VarSet::uses(kMCEventWeight)) {
+      values[kMCEventWeight] = event.weight();
+    }
+    if constexpr (VarSet::uses(kMCEventImpParam)) {
+      values[kMCEventImpParam] = event.impactParameter();
+    }
   }
 
   if constexpr ((fillMap & ReducedEventMC) > 0) {
-    values[kMCEventGeneratorId] = event.generatorsID();
-    values[kMCVtxX] = event.mcPosX();
-    values[kMCVtxY] = event.mcPosY();
-    values[kMCVtxZ] = event.mcPosZ();
-    values[kMCEventTime] = event.t();
-    values[kMCEventWeight] = event.weight();
-    values[kMCEventImpParam] = event.impactParameter();
+    if constexpr (VarSet::uses(kMCEventGeneratorId)) {
+      values[kMCEventGeneratorId] = event.generatorsID();
+    }
+    if constexpr (VarSet::uses(kMCVtxX)) {
+      values[kMCVtxX] = event.mcPosX();
+    }
+    if constexpr (VarSet::uses(kMCVtxY)) {
+      values[kMCVtxY] = event.mcPosY();
+    }
+    if constexpr (VarSet::uses(kMCVtxZ)) {
+      values[kMCVtxZ] = event.mcPosZ();
+    }
+    if constexpr (VarSet::uses(kMCEventTime)) {
+      values[kMCEventTime] = event.t();
+    }
+    if constexpr (VarSet::uses(kMCEventWeight)) {
+      values[kMCEventWeight] = event.weight();
+    }
+    if constexpr (VarSet::uses(kMCEventImpParam)) {
+      values[kMCEventImpParam] = event.impactParameter();
+    }
   }
 
   FillEventDerived(values);
 }
 
-template <uint32_t fillMap, typename T>
+template <uint32_t fillMap, typename VarSet, typename T>
 void VarManager::FillTrack(T const& track, float* values)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   // Quantities based on the basic table (contains just kine information and filter bits)
   if constexpr ((fillMap & Track) > 0 || (fillMap & Muon) > 0 || (fillMap & ReducedTrack) > 0 || (fillMap & ReducedMuon) > 0) {
-    values[kPt] = track.pt();
-    if (fgUsedVars[kPx]) {
+    if constexpr (VarSet::uses(kPt)) {
+      values[kPt] = track.pt();
+    }
+    if (IsUsed<VarSet>(kPx)) {
       values[kPx] = track.px();
     }
-    if (fgUsedVars[kPy]) {
+    if (IsUsed<VarSet>(kPy)) {
       values[kPy] = track.py();
     }
-    if (fgUsedVars[kPz]) {
+    if (IsUsed<VarSet>(kPz)) {
       values[kPz] = track.pz();
     }
-    values[kEta] = track.eta();
-    values[kPhi] = track.phi();
-    values[kCharge] = track.sign();
+    if constexpr (VarSet::uses(kEta)) {
+      values[kEta] = track.eta();
+    }
+    if constexpr (VarSet::uses(kPhi)) {
+      values[kPhi] = track.phi();
+    }
+    if constexpr (VarSet::uses(kCharge)) {
+      values[kCharge] = track.sign();
+    }
 
     if constexpr ((fillMap & ReducedTrack) > 0 && !((fillMap & Pair) > 0)) {
-      values[kIsGlobalTrack] = track.filteringFlags() & (uint64_t(1) << 0);
-      values[kIsGlobalTrackSDD] = track.filteringFlags() & (uint64_t(1) << 1);
+      if constexpr (VarSet::uses(kIsGlobalTrack)) {
+        values[kIsGlobalTrack] = track.filteringFlags() & (uint64_t(1) << 0);
+      }
+      if constexpr (VarSet::uses(kIsGlobalTrackSDD)) {
+        values[kIsGlobalTrackSDD] = track.filteringFlags() & (uint64_t(1) << 1);
+      }
 
-      values[kIsLegFromGamma] = bool(track.filteringFlags() & (uint64_t(1) << 2));
-      values[kIsLegFromK0S] = bool(track.filteringFlags() & (uint64_t(1) << 3));
-      values[kIsLegFromLambda] = bool(track.filteringFlags() & (uint64_t(1) << 4));
-      values[kIsLegFromAntiLambda] = bool(track.filteringFlags() & (uint64_t(1) << 5));
-      values[kIsLegFromOmega] = bool(track.filteringFlags() & (uint64_t(1) << 6));
+      if constexpr (VarSet::uses(kIsLegFromGamma)) {
+        values[kIsLegFromGamma] = bool(track.filteringFlags() & (uint64_t(1) << 2));
+      }
+      if constexpr (VarSet::uses(kIsLegFromK0S)) {
+        values[kIsLegFromK0S] = bool(track.filteringFlags() & (uint64_t(1) << 3));
+      }
+      if constexpr (VarSet::uses(kIsLegFromLambda)) {
+        values[kIsLegFromLambda] = bool(track.filteringFlags() & (uint64_t(1) << 4));
+      }
+      if constexpr (VarSet::uses(kIsLegFromAntiLambda)) {
+        values[kIsLegFromAntiLambda] = bool(track.filteringFlags() & (uint64_t(1) << 5));
+      }
+      if constexpr (VarSet::uses(kIsLegFromOmega)) {
+        values[kIsLegFromOmega] = bool(track.filteringFlags() & (uint64_t(1) << 6));
+      }
     }
   }
 
   // Quantities based on the barrel tables
   if constexpr ((fillMap & TrackExtra) > 0 || (fillMap & ReducedTrackBarrel) > 0) {
-    values[kPin] = track.tpcInnerParam();
-    if (fgUsedVars[kIsITSrefit]) {
+    if constexpr (VarSet::uses(kPin)) {
+      values[kPin] = track.tpcInnerParam();
+    }
+    if (IsUsed<VarSet>(kIsITSrefit)) {
       values[kIsITSrefit] = (track.flags() & o2::aod::track::ITSrefit) > 0; // NOTE: This is just for Run-2
     }
-    if (fgUsedVars[kTrackTimeResIsRange]) {
+    if (IsUsed<VarSet>(kTrackTimeResIsRange)) {
       values[kTrackTimeResIsRange] = (track.flags() & o2::aod::track::TrackTimeResIsRange) > 0; // NOTE: This is NOT for Run-2
     }
-    if (fgUsedVars[kIsTPCrefit]) {
+    if (IsUsed<VarSet>(kIsTPCrefit)) {
       values[kIsTPCrefit] = (track.flags() & o2::aod::track::TPCrefit) > 0; // NOTE: This is just for Run-2
     }
-    if (fgUsedVars[kPVContributor]) {
+    if (IsUsed<VarSet>(kPVContributor)) {
       values[kPVContributor] = (track.flags() & o2::aod::track::PVContributor) > 0; // NOTE: This is NOT for Run-2
     }
-    if (fgUsedVars[kIsGoldenChi2]) {
+    if (IsUsed<VarSet>(kIsGoldenChi2)) {
       values[kIsGoldenChi2] = (track.flags() & o2::aod::track::GoldenChi2) > 0; // NOTE: This is just for Run-2
     }
-    if (fgUsedVars[kOrphanTrack]) {
+    if (IsUsed<VarSet>(kOrphanTrack)) {
       values[kOrphanTrack] = (track.flags() & o2::aod::track::OrphanTrack) > 0; // NOTE: This is NOT for Run-2
     }
-    if (fgUsedVars[kIsSPDfirst]) {
+    if (IsUsed<VarSet>(kIsSPDfirst)) {
       values[kIsSPDfirst] = (track.itsClusterMap() & uint8_t(1)) > 0;
     }
-    if (fgUsedVars[kIsSPDboth]) {
+    if (IsUsed<VarSet>(kIsSPDboth)) {
       values[kIsSPDboth] = (track.itsClusterMap() & uint8_t(3)) > 0;
     }
-    if (fgUsedVars[kIsSPDany]) {
+    if (IsUsed<VarSet>(kIsSPDany)) {
       values[kIsSPDany] = (track.itsClusterMap() & uint8_t(1)) || (track.itsClusterMap() & uint8_t(2));
     }
-    values[kITSchi2] = track.itsChi2NCl();
-    values[kTPCncls] = track.tpcNClsFound();
-    values[kTPCchi2] = track.tpcChi2NCl();
-    values[kTrackLength] = track.length();
-    values[kTPCnclsCR] = track.tpcNClsCrossedRows();
-    values[kTRDPattern] = track.trdPattern();
+    if constexpr (VarSet::uses(kITSchi2)) {
+      values[kITSchi2] = track.itsChi2NCl();
+    }
+    if constexpr (VarSet::uses(kTPCncls)) {
+      values[kTPCncls] = track.tpcNClsFound();
+    }
+    if constexpr (VarSet::uses(kTPCchi2)) {
+      values[kTPCchi2] = track.tpcChi2NCl();
+    }
+    if constexpr (VarSet::uses(kTrackLength)) {
+      values[kTrackLength] = track.length();
+    }
+    if constexpr (VarSet::uses(kTPCnclsCR)) {
+      values[kTPCnclsCR] = track.tpcNClsCrossedRows();
+    }
+    if constexpr (VarSet::uses(kTRDPattern)) {
+      values[kTRDPattern] = track.trdPattern();
+    }
 
     if constexpr ((fillMap & TrackExtra) > 0) {
-      if (fgUsedVars[kITSncls]) {
+      if (IsUsed<VarSet>(kITSncls)) {
         values[kITSncls] = track.itsNCls(); // dynamic column
       }
     }
     if constexpr ((fillMap & ReducedTrackBarrel) > 0) {
-      if (fgUsedVars[kITSncls]) {
+      if (IsUsed<VarSet>(kITSncls)) {
         values[kITSncls] = 0.0;
         for (int i = 0; i < 7; ++i) {
           values[kITSncls] += ((track.itsClusterMap() & (1 << i)) ? 1 : 0);
         }
       }
-      values[kTrackDCAxy] = track.dcaXY();
-      values[kTrackDCAz] = track.dcaZ();
+      if constexpr (VarSet::uses(kTrackDCAxy)) {
+        values[kTrackDCAxy] = track.dcaXY();
+      }
+      if constexpr (VarSet::uses(kTrackDCAz)) {
+        values[kTrackDCAz] = track.dcaZ();
+      }
       if constexpr ((fillMap & ReducedTrackBarrelCov) > 0) {
-        if (fgUsedVars[kTrackDCAsigXY]) {
+        if (IsUsed<VarSet>(kTrackDCAsigXY)) {
           values[kTrackDCAsigXY] = track.dcaXY() / std::sqrt(track.cYY());
         }
-        if (fgUsedVars[kTrackDCAsigZ]) {
+        if (IsUsed<VarSet>(kTrackDCAsigZ)) {
           values[kTrackDCAsigZ] = track.dcaZ() / std::sqrt(track.cZZ());
         }
-        if (fgUsedVars[kTrackDCAresXY]) {
+        if (IsUsed<VarSet>(kTrackDCAresXY)) {
           values[kTrackDCAresXY] = std::sqrt(track.cYY());
         }
-        if (fgUsedVars[kTrackDCAresZ]) {
+        if (IsUsed<VarSet>(kTrackDCAresZ)) {
           values[kTrackDCAresZ] = std::sqrt(track.cZZ());
         }
       }
@@ -735,19 +962,23 @@ void VarManager::FillTrack(T const& track, float* values)
 
   // Quantities based on the barrel track selection table
   if constexpr ((fillMap & TrackDCA) > 0) {
-    values[kTrackDCAxy] = track.dcaXY();
-    values[kTrackDCAz] = track.dcaZ();
+    if constexpr (VarSet::uses(kTrackDCAxy)) {
+      values[kTrackDCAxy] = track.dcaXY();
+    }
+    if constexpr (VarSet::uses(kTrackDCAz)) {
+      values[kTrackDCAz] = track.dcaZ();
+    }
     if constexpr ((fillMap & TrackCov) > 0) {
-      if (fgUsedVars[kTrackDCAsigXY]) {
+      if (IsUsed<VarSet>(kTrackDCAsigXY)) {
         values[kTrackDCAsigXY] = track.dcaXY() / std::sqrt(track.cYY());
       }
-      if (fgUsedVars[kTrackDCAsigZ]) {
+      if (IsUsed<VarSet>(kTrackDCAsigZ)) {
         values[kTrackDCAsigZ] = track.dcaZ() / std::sqrt(track.cZZ());
       }
-      if (fgUsedVars[kTrackDCAresXY]) {
+      if (IsUsed<VarSet>(kTrackDCAresXY)) {
         values[kTrackDCAresXY] = std::sqrt(track.cYY());
       }
-      if (fgUsedVars[kTrackDCAresZ]) {
+      if (IsUsed<VarSet>(kTrackDCAresZ)) {
         values[kTrackDCAresZ] = std::sqrt(track.cZZ());
       }
     }
@@ -755,92 +986,190 @@ void VarManager::FillTrack(T const& track, float* values)
 
   // Quantities based on the barrel track selection table
   if constexpr ((fillMap & TrackSelection) > 0) {
-    values[kIsGlobalTrack] = track.isGlobalTrack();
-    values[kIsGlobalTrackSDD] = track.isGlobalTrackSDD();
+    if constexpr (VarSet::uses(kIsGlobalTrack)) {
+      values[kIsGlobalTrack] = track.isGlobalTrack();
+    }
+    if constexpr (VarSet::uses(kIsGlobalTrackSDD)) {
+      values[kIsGlobalTrackSDD] = track.isGlobalTrackSDD();
+    }
   }
 
   // Quantities based on the barrel covariance tables
   if constexpr ((fillMap & TrackCov) > 0 || (fillMap & ReducedTrackBarrelCov) > 0) {
-    values[kTrackCYY] = track.cYY();
-    values[kTrackCZZ] = track.cZZ();
-    values[kTrackCSnpSnp] = track.cSnpSnp();
-    values[kTrackCTglTgl] = track.cTglTgl();
-    values[kTrackC1Pt21Pt2] = track.c1Pt21Pt2();
+    if constexpr (VarSet::uses(kTrackCYY)) {
+      values[kTrackCYY] = track.cYY();
+    }
+    if constexpr (VarSet::uses(kTrackCZZ)) {
+      values[kTrackCZZ] = track.cZZ();
+    }
+    if constexpr (VarSet::uses(kTrackCSnpSnp)) {
+      values[kTrackCSnpSnp] = track.cSnpSnp();
+    }
+    if constexpr (VarSet::uses(kTrackCTglTgl)) {
+      values[kTrackCTglTgl] = track.cTglTgl();
+    }
+    if constexpr (VarSet::uses(kTrackC1Pt21Pt2)) {
+      values[kTrackC1Pt21Pt2] = track.c1Pt21Pt2();
+    }
   }
 
   // Quantities based on the barrel PID tables
   if constexpr ((fillMap & TrackPID) > 0 || (fillMap & ReducedTrackBarrelPID) > 0) {
-    values[kTPCnSigmaEl] = track.tpcNSigmaEl();
-    values[kTPCnSigmaMu] = track.tpcNSigmaMu();
-    values[kTPCnSigmaPi] = track.tpcNSigmaPi();
-    values[kTPCnSigmaKa] = track.tpcNSigmaKa();
-    values[kTPCnSigmaPr] = track.tpcNSigmaPr();
-    values[kTOFnSigmaEl] = track.tofNSigmaEl();
-    values[kTOFnSigmaMu] = track.tofNSigmaMu();
-    values[kTOFnSigmaPi] = track.tofNSigmaPi();
-    values[kTOFnSigmaKa] = track.tofNSigmaKa();
-    values[kTOFnSigmaPr] = track.tofNSigmaPr();
-    values[kTPCsignal] = track.tpcSignal();
-    values[kTRDsignal] = track.trdSignal();
-    values[kTOFbeta] = track.beta();
-    if (fgUsedVars[kTPCsignalRandomized] || fgUsedVars[kTPCnSigmaElRandomized] || fgUsedVars[kTPCnSigmaPiRandomized] || fgUsedVars[kTPCnSigmaPrRandomized]) {
+    if constexpr (VarSet::uses(kTPCnSigmaEl)) {
+      values[kTPCnSigmaEl] = track.tpcNSigmaEl();
+    }
+    if constexpr (VarSet::uses(kTPCnSigmaMu)) {
+      values[kTPCnSigmaMu] = track.tpcNSigmaMu();
+    }
+    if constexpr (VarSet::uses(kTPCnSigmaPi)) {
+      values[kTPCnSigmaPi] = track.tpcNSigmaPi();
+    }
+    if constexpr (VarSet::uses(kTPCnSigmaKa)) {
+      values[kTPCnSigmaKa] = track.tpcNSigmaKa();
+    }
+    if constexpr (VarSet::uses(kTPCnSigmaPr)) {
+      values[kTPCnSigmaPr] = track.tpcNSigmaPr();
+    }
+    if constexpr (VarSet::uses(kTOFnSigmaEl)) {
+      values[kTOFnSigmaEl] = track.tofNSigmaEl();
+    }
+    if constexpr (VarSet::uses(kTOFnSigmaMu)) {
+      values[kTOFnSigmaMu] = track.tofNSigmaMu();
+    }
+    if constexpr (VarSet::uses(kTOFnSigmaPi)) {
+      values[kTOFnSigmaPi] = track.tofNSigmaPi();
+    }
+    if constexpr (VarSet::uses(kTOFnSigmaKa)) {
+      values[kTOFnSigmaKa] = track.tofNSigmaKa();
+    }
+    if constexpr (VarSet::uses(kTOFnSigmaPr)) {
+      values[kTOFnSigmaPr] = track.tofNSigmaPr();
+    }
+    if constexpr (VarSet::uses(kTPCsignal)) {
+      values[kTPCsignal] = track.tpcSignal();
+    }
+    if constexpr (VarSet::uses(kTRDsignal)) {
+      values[kTRDsignal] = track.trdSignal();
+    }
+    if constexpr (VarSet::uses(kTOFbeta)) {
+      values[kTOFbeta] = track.beta();
+    }
+    if (IsUsed<VarSet>(kTPCsignalRandomized) || IsUsed<VarSet>(kTPCnSigmaElRandomized) || IsUsed<VarSet>(kTPCnSigmaPiRandomized) || IsUsed<VarSet>(kTPCnSigmaPrRandomized)) {
       // NOTE: this is needed temporarilly for the study of the impact of TPC pid degradation on the quarkonium triggers in high lumi pp
       //     This study involves a degradation from a dE/dx resolution of 5% to one of 6% (20% worsening)
       //     For this we smear the dE/dx and n-sigmas using a gaus distribution with a width of 3.3%
       //         which is approx the needed amount to get dE/dx to a resolution of 6%
       double randomX = gRandom->Gaus(0.0, 0.033);
-      values[kTPCsignalRandomized] = values[kTPCsignal] * (1.0 + randomX);
-      values[kTPCsignalRandomizedDelta] = values[kTPCsignal] * randomX;
-      values[kTPCnSigmaElRandomized] = values[kTPCnSigmaEl] * (1.0 + randomX);
-      values[kTPCnSigmaElRandomizedDelta] = values[kTPCnSigmaEl] * randomX;
-      values[kTPCnSigmaPiRandomized] = values[kTPCnSigmaPi] * (1.0 + randomX);
-      values[kTPCnSigmaPiRandomizedDelta] = values[kTPCnSigmaPi] * randomX;
-      values[kTPCnSigmaPrRandomized] = values[kTPCnSigmaPr] * (1.0 + randomX);
-      values[kTPCnSigmaPrRandomizedDelta] = values[kTPCnSigmaPr] * randomX;
+      values[kTPCsignalRandomized] = track.tpcSignal() * (1.0 + randomX);
+      values[kTPCsignalRandomizedDelta] = track.tpcSignal() * randomX;
+      values[kTPCnSigmaElRandomized] = track.tpcNSigmaEl() * (1.0 + randomX);
+      values[kTPCnSigmaElRandomizedDelta] = track.tpcNSigmaEl() * randomX;
+      values[kTPCnSigmaPiRandomized] = track.tpcNSigmaPi() * (1.0 + randomX);
+      values[kTPCnSigmaPiRandomizedDelta] = track.tpcNSigmaPi() * randomX;
+      values[kTPCnSigmaPrRandomized] = track.tpcNSigmaPr() * (1.0 + randomX);
+      values[kTPCnSigmaPrRandomizedDelta] = track.tpcNSigmaPr() * randomX;
     }
   }
 
   // Quantities based on the muon extra table
   if constexpr ((fillMap & ReducedMuonExtra) > 0 || (fillMap & Muon) > 0) {
-    values[kMuonNClusters] = track.nClusters();
-    values[kMuonPDca] = track.pDca();
-    values[kMCHBitMap] = track.mchBitMap();
-    values[kMuonRAtAbsorberEnd] = track.rAtAbsorberEnd();
-    values[kMuonChi2] = track.chi2();
-    values[kMuonChi2MatchMCHMID] = track.chi2MatchMCHMID();
-    values[kMuonChi2MatchMCHMFT] = track.chi2MatchMCHMFT();
-    values[kMuonMatchScoreMCHMFT] = track.matchScoreMCHMFT();
-    values[kMuonTrackType] = track.trackType();
+    if constexpr (VarSet::uses(kMuonNClusters)) {
+      values[kMuonNClusters] = track.nClusters();
+    }
+    if constexpr (VarSet::uses(kMuonPDca)) {
+      values[kMuonPDca] = track.pDca();
+    }
+    if constexpr (VarSet::uses(kMCHBitMap)) {
+      values[kMCHBitMap] = track.mchBitMap();
+    }
+    if constexpr (VarSet::uses(kMuonRAtAbsorberEnd)) {
+      values[kMuonRAtAbsorberEnd] = track.rAtAbsorberEnd();
+    }
+    if constexpr (VarSet::uses(kMuonChi2)) {
+      values[kMuonChi2] = track.chi2();
+    }
+    if constexpr (VarSet::uses(kMuonChi2MatchMCHMID)) {
+      values[kMuonChi2MatchMCHMID] = track.chi2MatchMCHMID();
+    }
+    if constexpr (VarSet::uses(kMuonChi2MatchMCHMFT)) {
+      values[kMuonChi2MatchMCHMFT] = track.chi2MatchMCHMFT();
+    }
+    if constexpr (VarSet::uses(kMuonMatchScoreMCHMFT)) {
+      values[kMuonMatchScoreMCHMFT] = track.matchScoreMCHMFT();
+    }
+    if constexpr (VarSet::uses(kMuonTrackType)) {
+      values[kMuonTrackType] = track.trackType();
+    }
   }
   // Quantities based on the muon covariance table
   if constexpr ((fillMap & ReducedMuonCov) > 0 || (fillMap & MuonCov) > 0) {
-    values[kMuonCXX] = track.cXX();
-    values[kMuonCYY] = track.cYY();
-    values[kMuonCPhiPhi] = track.cPhiPhi();
-    values[kMuonCTglTgl] = track.cTglTgl();
-    values[kMuonC1Pt21Pt2] = track.c1Pt21Pt2();
+    if constexpr (VarSet::uses(kMuonCXX)) {
+      values[kMuonCXX] = track.cXX();
+    }
+    if constexpr (VarSet::uses(kMuonCYY)) {
+      values[kMuonCYY] = track.cYY();
+    }
+    if constexpr (VarSet::uses(kMuonCPhiPhi)) {
+      values[kMuonCPhiPhi] = track.cPhiPhi();
+    }
+    if constexpr (VarSet::uses(kMuonCTglTgl)) {
+      values[kMuonCTglTgl] = track.cTglTgl();
+    }
+    if constexpr (VarSet::uses(kMuonC1Pt21Pt2)) {
+      values[kMuonC1Pt21Pt2] = track.c1Pt21Pt2();
+    }
   }
 
   // Quantities based on the pair table(s)
   if constexpr ((fillMap & Pair) > 0) {
-    values[kMass] = track.mass();
+    if constexpr (VarSet::uses(kMass)) {
+      values[kMass] = track.mass();
+    }
   }
 
   if constexpr ((fillMap & ParticleMC) > 0) {
-    values[kMCPdgCode] = track.pdgCode();
-    values[kMCParticleWeight] = track.weight();
-    values[kMCPx] = track.px();
-    values[kMCPy] = track.py();
-    values[kMCPz] = track.pz();
-    values[kMCE] = track.e();
-    values[kMCVx] = track.vx();
-    values[kMCVy] = track.vy();
-    values[kMCVz] = track.vz();
-    values[kMCPt] = track.pt();
-    values[kMCPhi] = track.phi();
-    values[kMCEta] = track.eta();
-    values[kMCY] = track.y();
-    values[kMCParticleGeneratorId] = track.producedByGenerator();
+    if constexpr (VarSet::uses(kMCPdgCode)) {
+      values[kMCPdgCode] = track.pdgCode();
+    }
+    if constexpr (VarSet::uses(kMCParticleWeight)) {
+      values[kMCParticleWeight] = track.weight();
+    }
+    if constexpr (VarSet::uses(kMCPx)) {
+      values[kMCPx] = track.px();
+    }
+    if constexpr (VarSet::uses(kMCPy)) {
+      values[kMCPy] = track.py();
+    }
+    if constexpr (VarSet::uses(kMCPz)) {
+      values[kMCPz] = track.pz();
+    }
+    if constexpr (VarSet::uses(kMCE)) {
+      values[kMCE] = track.e();
+    }
+    if constexpr (VarSet::uses(kMCVx)) {
+      values[kMCVx] = track.vx();
+    }
+    if constexpr (VarSet::uses(kMCVy)) {
+      values[kMCVy] = track.vy();
+    }
+    if constexpr (VarSet::uses(kMCVz)) {
+      values[kMCVz] = track.vz();
+    }
+    if constexpr (VarSet::uses(kMCPt)) {
+      values[kMCPt] = track.pt();
+    }
+    if constexpr (VarSet::uses(kMCPhi)) {
+      values[kMCPhi] = track.phi();
+    }
+    if constexpr (VarSet::uses(kMCEta)) {
+      values[kMCEta] = track.eta();
+    }
+    if constexpr (VarSet::uses(kMCY)) {
+      values[kMCY] = track.y();
+    }
+    if constexpr (VarSet::uses(kMCParticleGeneratorId)) {
+      values[kMCParticleGeneratorId] = track.producedByGenerator();
+    }
   }
 
   // Derived quantities which can be computed based on already filled variables
@@ -851,7 +1180,7 @@ template <int pairType, uint32_t fillMap, typename T1, typename T2>
 void VarManager::FillPair(T1 const& t1, T2 const& t2, float* values)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   float m1 = fgkElectronMass;
@@ -905,7 +1234,7 @@ void VarManager::FillPairME(T1 const& t1, T2 const& t2, float* values)
   // Lightweight fill function called from the innermost event mixing loop
   //
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   float m1 = fgkElectronMass;
@@ -933,7 +1262,7 @@ template <typename T1, typename T2>
 void VarManager::FillPairMC(T1 const& t1, T2 const& t2, float* values, PairCandidateType pairType)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   float m1 = fgkElectronMass;
@@ -967,7 +1296,7 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
   constexpr bool muonHasCov = ((fillMap & MuonCov) > 0 || (fillMap & ReducedMuonCov) > 0);
 
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   int procCode = 0;
@@ -987,7 +1316,7 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
                                     t2.cSnpSnp(), t2.cTglY(), t2.cTglZ(), t2.cTglSnp(), t2.cTglTgl(),
                                     t2.c1PtY(), t2.c1PtZ(), t2.c1PtSnp(), t2.c1PtTgl(), t2.c1Pt21Pt2()};
     o2::track::TrackParCov pars2{t2.x(), t2.alpha(), t2pars, t2covs};
-    procCode = fgFitterTwoProngBarrel.process(pars1, pars2);
+    procCode = GetContext().fitterTwoProngBarrel.process(pars1, pars2);
   } else if constexpr ((pairType == kJpsiToMuMu) && muonHasCov) {
     // Initialize track parameters for forward
     double chi21 = t1.chi2();
@@ -1004,7 +1333,7 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
                            t2.c1PtX(), t2.c1PtY(), t2.c1PtPhi(), t2.c1PtTgl(), t2.c1Pt21Pt2()};
     SMatrix55 t2covs(v2.begin(), v2.end());
     o2::track::TrackParCovFwd pars2{t2.z(), t2pars, t2covs, chi22};
-    procCode = fgFitterTwoProngFwd.process(pars1, pars2);
+    procCode = GetContext().fitterTwoProngFwd.process(pars1, pars2);
   } else {
     return;
   }
@@ -1047,12 +1376,12 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
     auto covMatrixPV = primaryVertex.getCov();
 
     if constexpr (pairType == kJpsiToEE && trackHasCov) {
-      secondaryVertex = fgFitterTwoProngBarrel.getPCACandidate();
-      bz = fgFitterTwoProngBarrel.getBz();
-      covMatrixPCA = fgFitterTwoProngBarrel.calcPCACovMatrix().Array();
-      auto chi2PCA = fgFitterTwoProngBarrel.getChi2AtPCACandidate();
-      auto trackParVar0 = fgFitterTwoProngBarrel.getTrack(0);
-      auto trackParVar1 = fgFitterTwoProngBarrel.getTrack(1);
+      secondaryVertex = GetContext().fitterTwoProngBarrel.getPCACandidate();
+      bz = GetContext().fitterTwoProngBarrel.getBz();
+      covMatrixPCA = GetContext().fitterTwoProngBarrel.calcPCACovMatrix().Array();
+      auto chi2PCA = GetContext().fitterTwoProngBarrel.getChi2AtPCACandidate();
+      auto trackParVar0 = GetContext().fitterTwoProngBarrel.getTrack(0);
+      auto trackParVar1 = GetContext().fitterTwoProngBarrel.getTrack(1);
       values[kVertexingChi2PCA] = chi2PCA;
       trackParVar0.getPxPyPzGlo(pvec0);
       trackParVar1.getPxPyPzGlo(pvec1);
@@ -1063,12 +1392,12 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
       m1 = fgkMuonMass;
       m2 = fgkMuonMass;
 
-      secondaryVertex = fgFitterTwoProngFwd.getPCACandidate();
-      bz = fgFitterTwoProngFwd.getBz();
-      covMatrixPCA = fgFitterTwoProngFwd.calcPCACovMatrix().Array();
-      auto chi2PCA = fgFitterTwoProngFwd.getChi2AtPCACandidate();
-      auto trackParVar0 = fgFitterTwoProngFwd.getTrack(0);
-      auto trackParVar1 = fgFitterTwoProngFwd.getTrack(1);
+      secondaryVertex = GetContext().fitterTwoProngFwd.getPCACandidate();
+      bz = GetContext().fitterTwoProngFwd.getBz();
+      covMatrixPCA = GetContext().fitterTwoProngFwd.calcPCACovMatrix().Array();
+      auto chi2PCA = GetContext().fitterTwoProngFwd.getChi2AtPCACandidate();
+      auto trackParVar0 = GetContext().fitterTwoProngFwd.getTrack(0);
+      auto trackParVar1 = GetContext().fitterTwoProngFwd.getTrack(1);
       values[kVertexingChi2PCA] = chi2PCA;
       pvec0[0] = trackParVar0.getPx();
       pvec0[1] = trackParVar0.getPy();
@@ -1112,14 +1441,18 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
 }
 
 template <int candidateType, uint32_t collFillMap, uint32_t fillMap, typename C, typename T1>
-void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton1, T1 const& lepton2, T1 const& track, float* values)
+void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton1, T1 const& lepton2, T1 const& track, float* values, int dileptonProcCode)
 {
+  //
+  // dileptonProcCode is the result of FitDileptonVertex() for this dilepton, if it was already fitted in this event:
+  //   the 2-prong fit is then not repeated for each track, and the 3-prong fit is skipped if the dilepton fit failed
+  //
 
   constexpr bool eventHasVtxCov = ((collFillMap & Collision) > 0 || (collFillMap & ReducedEventVtxCov) > 0);
   constexpr bool trackHasCov = ((fillMap & TrackCov) > 0 || (fillMap & ReducedTrackBarrelCov) > 0);
   constexpr bool muonHasCov = ((fillMap & MuonCov) > 0 || (fillMap & ReducedMuonCov) > 0);
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   float mtrack;
@@ -1155,8 +1488,8 @@ void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton
                            track.c1PtX(), track.c1PtY(), track.c1PtPhi(), track.c1PtTgl(), track.c1Pt21Pt2()};
     SMatrix55 t3covs(v3.begin(), v3.end());
     o2::track::TrackParCovFwd pars3{track.z(), t3pars, t3covs, chi23};
-    procCode = VarManager::fgFitterThreeProngFwd.process(pars1, pars2, pars3);
-    procCodeJpsi = VarManager::fgFitterTwoProngFwd.process(pars1, pars2);
+    procCodeJpsi = dileptonProcCode >= 0 ? dileptonProcCode : GetContext().fitterTwoProngFwd.process(pars1, pars2);
+    procCode = procCodeJpsi == 0 ? 0 : GetContext().fitterThreeProngFwd.process(pars1, pars2, pars3);
   } else if constexpr ((candidateType == kBtoJpsiEEK) && trackHasCov) {
     mlepton = fgkElectronMass;
     mtrack = fgkKaonMass;
@@ -1175,8 +1508,8 @@ void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton
                                          track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
                                          track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2()};
     o2::track::TrackParCov pars3{track.x(), track.alpha(), lepton3pars, lepton3covs};
-    procCode = VarManager::fgFitterThreeProngBarrel.process(pars1, pars2, pars3);
-    procCodeJpsi = VarManager::fgFitterTwoProngBarrel.process(pars1, pars2);
+    procCodeJpsi = dileptonProcCode >= 0 ? dileptonProcCode : GetContext().fitterTwoProngBarrel.process(pars1, pars2);
+    procCode = procCodeJpsi == 0 ? 0 : GetContext().fitterThreeProngBarrel.process(pars1, pars2, pars3);
   } else {
     return;
   }
@@ -1226,11 +1559,11 @@ void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton
     auto covMatrixPV = primaryVertex.getCov();
 
     if constexpr (candidateType == kBtoJpsiEEK && trackHasCov) {
-      secondaryVertex = fgFitterThreeProngBarrel.getPCACandidate();
-      covMatrixPCA = fgFitterThreeProngBarrel.calcPCACovMatrix().Array();
+      secondaryVertex = GetContext().fitterThreeProngBarrel.getPCACandidate();
+      covMatrixPCA = GetContext().fitterThreeProngBarrel.calcPCACovMatrix().Array();
     } else if constexpr (candidateType == kBcToThreeMuons && muonHasCov) {
-      secondaryVertex = fgFitterThreeProngFwd.getPCACandidate();
-      covMatrixPCA = fgFitterThreeProngFwd.calcPCACovMatrix().Array();
+      secondaryVertex = GetContext().fitterThreeProngFwd.getPCACandidate();
+      covMatrixPCA = GetContext().fitterThreeProngFwd.calcPCACovMatrix().Array();
     }
 
     double phi = std::atan2(secondaryVertex[1] - collision.posY(), secondaryVertex[0] - collision.posX());
@@ -1263,11 +1596,55 @@ void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton
   }
 }
 
+template <int candidateType, uint32_t fillMap, typename T1>
+int VarManager::FitDileptonVertex(T1 const& lepton1, T1 const& lepton2, std::array<float, 3>& vertex)
+{
+  //
+  // 2-prong fit of the dilepton of a dilepton-track candidate, to be done once per dilepton:
+  //   the result is passed to FillDileptonTrackVertexing() for each associated track and the vertex is used to preselect the tracks
+  //   returns the fitter process code, -1 if the fit is not implemented for this candidate type
+  //
+  constexpr bool trackHasCov = ((fillMap & TrackCov) > 0 || (fillMap & ReducedTrackBarrelCov) > 0);
+  if constexpr (candidateType == kBtoJpsiEEK && trackHasCov) {
+    auto& fitter = GetContext().fitterTwoProngBarrel;
+    int procCode = fitter.process(getBarrelTrackParCov(lepton1), getBarrelTrackParCov(lepton2));
+    if (procCode != 0) {
+      const auto& pca = fitter.getPCACandidate();
+      vertex = {static_cast<float>(pca[0]), static_cast<float>(pca[1]), static_cast<float>(pca[2])};
+    }
+    return procCode;
+  }
+  return -1;
+}
+
+template <uint32_t fillMap, typename T>
+float VarManager::GetTrackDistanceToPoint(T const& track, const std::array<float, 3>& point)
+{
+  //
+  // distance between a point and the straight line tangent to the barrel track at its reference point
+  //   cheap geometric estimate of the track DCA to a secondary vertex close to the primary one, to preselect the tracks entering the vertexing
+  //   returns 0 if the track has no covariance (parameters) table
+  //
+  constexpr bool trackHasCov = ((fillMap & TrackCov) > 0 || (fillMap & ReducedTrackBarrelCov) > 0);
+  if constexpr (trackHasCov) {
+    auto trackPar = getBarrelTrackParCov(track);
+    std::array<float, 3> xyz;
+    std::array<float, 3> pxpypz;
+    trackPar.getXYZGlo(xyz);
+    trackPar.getPxPyPzGlo(pxpypz);
+    const float d[3] = {point[0] - xyz[0], point[1] - xyz[1], point[2] - xyz[2]};
+    const float cross[3] = {d[1] * pxpypz[2] - d[2] * pxpypz[1], d[2] * pxpypz[0] - d[0] * pxpypz[2], d[0] * pxpypz[1] - d[1] * pxpypz[0]};
+    const float p2 = pxpypz[0] * pxpypz[0] + pxpypz[1] * pxpypz[1] + pxpypz[2] * pxpypz[2];
+    return p2 > 0.f ? std::sqrt((cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) / p2) : std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+  }
+  return 0.f;
+}
+
 template <typename C, typename A>
 void VarManager::FillQVectorFromGFW(C const& collision, A const& compA2, A const& compB2, A const& compC2, A const& compA3, A const& compB3, A const& compC3, float normA, float normB, float normC, float* values)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   // Fill Qn vectors from generic flow framework for different eta gap A, B, C (n=2,3)
@@ -1304,7 +1681,7 @@ void VarManager::FillPairVn(T1 const& t1, T2 const& t2, float* values)
 {
 
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   float m1 = fgkElectronMass;
@@ -1336,7 +1713,7 @@ template <typename T1, typename T2>
 void VarManager::FillDileptonHadron(T1 const& dilepton, T2 const& hadron, float* values, float hadronMass)
 {
   if (!values) {
-    values = fgValues;
+    values = GetContext().values;
   }
 
   if (fgUsedVars[kPairMass] || fgUsedVars[kPairPt] || fgUsedVars[kPairEta] || fgUsedVars[kPairPhi]) {
@@ -21,7 +21,9 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "MathUtils/Utils.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace o2::aod
 {
@@ -169,6 +171,177 @@ using ReducedTrackBarrel = ReducedTracksBarrel::iterator;
 using ReducedTrackBarrelCov = ReducedTracksBarrelCov::iterator;
 using ReducedTrackBarrelPID = ReducedTracksBarrelPID::iterator;
 
+// compact barrel track information, written instead of ReducedTracksBarrelCov and ReducedTracksBarrelPID on request
+// The getters are the same as the ones of the full tables, so the same VarManager fill maps read both
+namespace reducedtrackcompact
+{
+// nsigma binned on 8 bits in [-12.7, 12.7], with the under- and overflows in the first and last bins
+struct nsigmaBinning {
+  typedef int8_t binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = 12.7;
+  static constexpr float binned_min = -12.7;
+  static constexpr float bin_width = (binned_max - binned_min) / nbins;
+};
+
+inline nsigmaBinning::binned_t packNSigma(float nsigma)
+{
+  if (!(nsigma > nsigmaBinning::binned_min)) { // also catches NaN
+    return nsigmaBinning::underflowBin;
+  }
+  if (nsigma >= nsigmaBinning::binned_max) {
+    return nsigmaBinning::overflowBin;
+  }
+  return static_cast<nsigmaBinning::binned_t>(std::lround(nsigma / nsigmaBinning::bin_width));
+}
+
+// correlation coefficient on 8 bits, same convention as the Rho columns of the AO2D track covariance
+inline int8_t packRho(float rho)
+{
+  return static_cast<int8_t>(std::lround(std::clamp(rho * 128.f, -127.f, 127.f)));
+}
+
+// IEEE 754 half precision, used for the square roots of the diagonal elements of the covariance matrix
+inline uint16_t toHalf(float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+  if (exponent >= 31) { // overflow, infinity and NaN are all stored as the largest finite value
+    return sign | 0x7bff;
+  }
+  if (exponent <= 0) { // subnormal or zero
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    return sign | static_cast<uint16_t>((mantissa + (1u << (13 - exponent))) >> (14 - exponent));
+  }
+  const uint32_t rounded = ((static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+  return sign | static_cast<uint16_t>(std::min<uint32_t>(rounded, 0x7bff));
+}
+
+inline float fromHalf(uint16_t half)
+{
+  const float sign = (half & 0x8000) ? -1.f : 1.f;
+  const int exponent = (half >> 10) & 0x1f;
+  const int mantissa = half & 0x3ff;
+  if (exponent == 0) {
+    return sign * std::ldexp(static_cast<float>(mantissa), -24);
+  }
+  return sign * std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+}
+
+#define DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(COLUMN, GETTER)                    \
+  DECLARE_SOA_COLUMN(COLUMN##Store, GETTER##Store, nsigmaBinning::binned_t); \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, GETTER,                                 \
+                             [](nsigmaBinning::binned_t binned) -> float { return nsigmaBinning::bin_width * static_cast<float>(binned); });
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TPCNSigmaEl, tpcNSigmaEl)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TPCNSigmaMu, tpcNSigmaMu)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TPCNSigmaPi, tpcNSigmaPi)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TPCNSigmaKa, tpcNSigmaKa)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TPCNSigmaPr, tpcNSigmaPr)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TOFNSigmaEl, tofNSigmaEl)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TOFNSigmaMu, tofNSigmaMu)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TOFNSigmaPi, tofNSigmaPi)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TOFNSigmaKa, tofNSigmaKa)
+DECLARE_DQ_COMPACT_NSIGMA_COLUMNS(TOFNSigmaPr, tofNSigmaPr)
+#undef DECLARE_DQ_COMPACT_NSIGMA_COLUMNS
+
+DECLARE_SOA_COLUMN(SigmaYStore, sigmaYStore, uint16_t);       //! half precision sqrt(cYY)
+DECLARE_SOA_COLUMN(SigmaZStore, sigmaZStore, uint16_t);       //! half precision sqrt(cZZ)
+DECLARE_SOA_COLUMN(SigmaSnpStore, sigmaSnpStore, uint16_t);   //! half precision sqrt(cSnpSnp)
+DECLARE_SOA_COLUMN(SigmaTglStore, sigmaTglStore, uint16_t);   //! half precision sqrt(cTglTgl)
+DECLARE_SOA_COLUMN(Sigma1PtStore, sigma1PtStore, uint16_t);   //! half precision sqrt(c1Pt21Pt2)
+DECLARE_SOA_COLUMN(RhoZY, rhoZY, int8_t);                     //! correlation coefficient, times 128
+DECLARE_SOA_COLUMN(RhoSnpY, rhoSnpY, int8_t);                 //!
+DECLARE_SOA_COLUMN(RhoSnpZ, rhoSnpZ, int8_t);                 //!
+DECLARE_SOA_COLUMN(RhoTglY, rhoTglY, int8_t);                 //!
+DECLARE_SOA_COLUMN(RhoTglZ, rhoTglZ, int8_t);                 //!
+DECLARE_SOA_COLUMN(RhoTglSnp, rhoTglSnp, int8_t);             //!
+DECLARE_SOA_COLUMN(Rho1PtY, rho1PtY, int8_t);                 //!
+DECLARE_SOA_COLUMN(Rho1PtZ, rho1PtZ, int8_t);                 //!
+DECLARE_SOA_COLUMN(Rho1PtSnp, rho1PtSnp, int8_t);             //!
+DECLARE_SOA_COLUMN(Rho1PtTgl, rho1PtTgl, int8_t);             //!
+DECLARE_SOA_DYNAMIC_COLUMN(CYY, cYY,                          //!
+                           [](uint16_t s) -> float { return fromHalf(s) * fromHalf(s); });
+DECLARE_SOA_DYNAMIC_COLUMN(CZZ, cZZ, //!
+                           [](uint16_t s) -> float { return fromHalf(s) * fromHalf(s); });
+DECLARE_SOA_DYNAMIC_COLUMN(CSnpSnp, cSnpSnp, //!
+                           [](uint16_t s) -> float { return fromHalf(s) * fromHalf(s); });
+DECLARE_SOA_DYNAMIC_COLUMN(CTglTgl, cTglTgl, //!
+                           [](uint16_t s) -> float { return fromHalf(s) * fromHalf(s); });
+DECLARE_SOA_DYNAMIC_COLUMN(C1Pt21Pt2, c1Pt21Pt2, //!
+                           [](uint16_t s) -> float { return fromHalf(s) * fromHalf(s); });
+#define DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(COLUMN, GETTER)                    \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, GETTER,                                     \
+                             [](uint16_t s1, uint16_t s2, int8_t rho) -> float { \
+                               return (rho / 128.f) * fromHalf(s1) * fromHalf(s2); });
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CZY, cZY)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CSnpY, cSnpY)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CSnpZ, cSnpZ)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CTglY, cTglY)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CTglZ, cTglZ)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(CTglSnp, cTglSnp)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(C1PtY, c1PtY)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(C1PtZ, c1PtZ)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(C1PtSnp, c1PtSnp)
+DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN(C1PtTgl, c1PtTgl)
+#undef DECLARE_DQ_COMPACT_OFFDIAGONAL_COLUMN
+} // namespace reducedtrackcompact
+
+// barrel covariance matrix with half precision sigmas and 8 bit correlation coefficients
+DECLARE_SOA_TABLE(ReducedTracksBarrelCovCompact, "AOD", "RTBARRELCOVC", //!
+                  track::X, track::Alpha,
+                  track::Y, track::Z, track::Snp, track::Tgl, track::Signed1Pt,
+                  reducedtrackcompact::SigmaYStore, reducedtrackcompact::SigmaZStore, reducedtrackcompact::SigmaSnpStore,
+                  reducedtrackcompact::SigmaTglStore, reducedtrackcompact::Sigma1PtStore,
+                  reducedtrackcompact::RhoZY, reducedtrackcompact::RhoSnpY, reducedtrackcompact::RhoSnpZ,
+                  reducedtrackcompact::RhoTglY, reducedtrackcompact::RhoTglZ, reducedtrackcompact::RhoTglSnp,
+                  reducedtrackcompact::Rho1PtY, reducedtrackcompact::Rho1PtZ, reducedtrackcompact::Rho1PtSnp, reducedtrackcompact::Rho1PtTgl,
+                  reducedtrackcompact::CYY<reducedtrackcompact::SigmaYStore>,
+                  reducedtrackcompact::CZY<reducedtrackcompact::SigmaZStore, reducedtrackcompact::SigmaYStore, reducedtrackcompact::RhoZY>,
+                  reducedtrackcompact::CZZ<reducedtrackcompact::SigmaZStore>,
+                  reducedtrackcompact::CSnpY<reducedtrackcompact::SigmaSnpStore, reducedtrackcompact::SigmaYStore, reducedtrackcompact::RhoSnpY>,
+                  reducedtrackcompact::CSnpZ<reducedtrackcompact::SigmaSnpStore, reducedtrackcompact::SigmaZStore, reducedtrackcompact::RhoSnpZ>,
+                  reducedtrackcompact::CSnpSnp<reducedtrackcompact::SigmaSnpStore>,
+                  reducedtrackcompact::CTglY<reducedtrackcompact::SigmaTglStore, reducedtrackcompact::SigmaYStore, reducedtrackcompact::RhoTglY>,
+                  reducedtrackcompact::CTglZ<reducedtrackcompact::SigmaTglStore, reducedtrackcompact::SigmaZStore, reducedtrackcompact::RhoTglZ>,
+                  reducedtrackcompact::CTglSnp<reducedtrackcompact::SigmaTglStore, reducedtrackcompact::SigmaSnpStore, reducedtrackcompact::RhoTglSnp>,
+                  reducedtrackcompact::CTglTgl<reducedtrackcompact::SigmaTglStore>,
+                  reducedtrackcompact::C1PtY<reducedtrackcompact::Sigma1PtStore, reducedtrackcompact::SigmaYStore, reducedtrackcompact::Rho1PtY>,
+                  reducedtrackcompact::C1PtZ<reducedtrackcompact::Sigma1PtStore, reducedtrackcompact::SigmaZStore, reducedtrackcompact::Rho1PtZ>,
+                  reducedtrackcompact::C1PtSnp<reducedtrackcompact::Sigma1PtStore, reducedtrackcompact::SigmaSnpStore, reducedtrackcompact::Rho1PtSnp>,
+                  reducedtrackcompact::C1PtTgl<reducedtrackcompact::Sigma1PtStore, reducedtrackcompact::SigmaTglStore, reducedtrackcompact::Rho1PtTgl>,
+                  reducedtrackcompact::C1Pt21Pt2<reducedtrackcompact::Sigma1PtStore>);
+
+// barrel PID information with the nsigmas binned on 8 bits
+DECLARE_SOA_TABLE(ReducedTracksBarrelPIDCompact, "AOD", "RTBARRELPIDC", //!
+                  track::TPCSignal,
+                  reducedtrackcompact::TPCNSigmaElStore, reducedtrackcompact::TPCNSigmaMuStore,
+                  reducedtrackcompact::TPCNSigmaPiStore, reducedtrackcompact::TPCNSigmaKaStore, reducedtrackcompact::TPCNSigmaPrStore,
+                  pidtofbeta::Beta,
+                  reducedtrackcompact::TOFNSigmaElStore, reducedtrackcompact::TOFNSigmaMuStore,
+                  reducedtrackcompact::TOFNSigmaPiStore, reducedtrackcompact::TOFNSigmaKaStore, reducedtrackcompact::TOFNSigmaPrStore,
+                  track::TRDSignal,
+                  reducedtrackcompact::TPCNSigmaEl<reducedtrackcompact::TPCNSigmaElStore>,
+                  reducedtrackcompact::TPCNSigmaMu<reducedtrackcompact::TPCNSigmaMuStore>,
+                  reducedtrackcompact::TPCNSigmaPi<reducedtrackcompact::TPCNSigmaPiStore>,
+                  reducedtrackcompact::TPCNSigmaKa<reducedtrackcompact::TPCNSigmaKaStore>,
+                  reducedtrackcompact::TPCNSigmaPr<reducedtrackcompact::TPCNSigmaPrStore>,
+                  reducedtrackcompact::TOFNSigmaEl<reducedtrackcompact::TOFNSigmaElStore>,
+                  reducedtrackcompact::TOFNSigmaMu<reducedtrackcompact::TOFNSigmaMuStore>,
+                  reducedtrackcompact::TOFNSigmaPi<reducedtrackcompact::TOFNSigmaPiStore>,
+                  reducedtrackcompact::TOFNSigmaKa<reducedtrackcompact::TOFNSigmaKaStore>,
+                  reducedtrackcompact::TOFNSigmaPr<reducedtrackcompact::TOFNSigmaPrStore>);
+
+using ReducedTrackBarrelCovCompact = ReducedTracksBarrelCovCompact::iterator;
+using ReducedTrackBarrelPIDCompact = ReducedTracksBarrelPIDCompact::iterator;
+
 namespace reducedtrackMC
 {
 DECLARE_SOA_INDEX_COLUMN(ReducedMCEvent, reducedMCevent);                                   //!
@@ -33,10 +33,13 @@
 #include "PWGDQ/Core/HistogramManager.h"
 #include "PWGDQ/Core/AnalysisCut.h"
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/AnalysisCutEngine.h"
 #include "PWGDQ/Core/HistogramsLibrary.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 
 #include <iostream>
+#include <memory>
+#include <vector>
 using std::cout;
 using std::endl;
 
@@ -83,6 +86,8 @@ struct TableMaker {
   Produces<ReducedTracksBarrel> trackBarrel;
   Produces<ReducedTracksBarrelCov> trackBarrelCov;
   Produces<ReducedTracksBarrelPID> trackBarrelPID;
+  Produces<ReducedTracksBarrelCovCompact> trackBarrelCovCompact;
+  Produces<ReducedTracksBarrelPIDCompact> trackBarrelPIDCompact;
   Produces<ReducedMuons> muonBasic;
   Produces<ReducedMuonsExtra> muonExtra;
   Produces<ReducedMuonsCov> muonCov;
@@ -101,10 +106,14 @@ struct TableMaker {
   Configurable<bool> fConfigNoQA{"cfgNoQA", false, "If true, no QA histograms"};
   Configurable<bool> fConfigDetailedQA{"cfgDetailedQA", false, "If true, include more QA histograms (BeforeCuts classes and more)"};
   Configurable<bool> fIsRun2{"cfgIsRun2", false, "Whether we analyze Run-2 or Run-3 data"};
+  Configurable<int> fConfigCutBatchSize{"cfgCutBatchSize", 1024, "Number of barrel tracks evaluated at once by the cut engine if the QA is off, 0: evaluate the cuts track by track"};
+  Configurable<bool> fConfigCompactBarrel{"cfgCompactBarrel", false, "If true, write the compact barrel cov and PID tables (binned nsigmas, half precision cov) instead of the full ones"};
 
   AnalysisCompositeCut* fEventCut;              //! Event selection cut
   std::vector<AnalysisCompositeCut> fTrackCuts; //! Barrel track cuts
   std::vector<AnalysisCompositeCut> fMuonCuts;  //! Muon track cuts
+  std::unique_ptr<AnalysisCutEngine> fTrackCutEngine; //! Barrel track cuts evaluated over batches of tracks
+  std::vector<uint32_t> fTrackMasks;                  //! Barrel track cut decisions of the tracks of the current collision
 
   // TODO: filter on TPC dedx used temporarily until electron PID will be improved
   Filter barrelSelectedTracks = ifnode(fIsRun2.node() == true, aod::track::trackType == uint8_t(aod::track::Run2Track), aod::track::trackType == uint8_t(aod::track::Track)) && o2::aod::track::pt >= fConfigBarrelTrackPtLow && nabs(o2::aod::track::eta) <= 0.9f && o2::aod::track::tpcSignal >= fConfigMinTpcSignal && o2::aod::track::tpcSignal <= fConfigMaxTpcSignal && o2::aod::track::tpcChi2NCl < 4.0f && o2::aod::track::itsChi2NCl < 36.0f;
@@ -115,6 +124,14 @@ struct TableMaker {
   {
     DefineCuts();
 
+    // the QA histograms are filled track by track, so the batched evaluation is only used without QA
+    if (fConfigNoQA && !fConfigDetailedQA && fConfigCutBatchSize > 0) {
+      fTrackCutEngine = std::make_unique<AnalysisCutEngine>(fConfigCutBatchSize);
+      for (auto& cut : fTrackCuts) {
+        fTrackCutEngine->AddCut(&cut);
+      }
+    }
+
     VarManager::SetDefaultVarNames();
     fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
     fHistMan->SetUseDefaultVariableNames(kTRUE);
@@ -186,6 +203,14 @@ struct TableMaker {
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
   }
 
+  // Evaluate the cuts of the tracks in the batch of the cut engine, append their decisions and empty it
+  void evaluateTrackCuts()
+  {
+    fTrackCutEngine->Evaluate();
+    fTrackMasks.insert(fTrackMasks.end(), fTrackCutEngine->GetMasks().begin(), fTrackCutEngine->GetMasks().begin() + fTrackCutEngine->GetNRows());
+    fTrackCutEngine->Clear();
+  }
+
   // Templated function instantianed for all of the process functions
   template <uint32_t TEventFillMap, uint32_t TTrackFillMap, uint32_t TMuonFillMap, typename TEvent, typename TTracks, typename TMuons>
   void fullSkimming(TEvent const& collision, aod::BCs const& bcs, TTracks const& tracksBarrel, TMuons const& tracksMuon)
@@ -249,28 +274,59 @@ struct TableMaker {
     if constexpr (static_cast<bool>(TTrackFillMap)) {
       trackBasic.reserve(tracksBarrel.size());
       trackBarrel.reserve(tracksBarrel.size());
-      if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
-        trackBarrelCov.reserve(tracksBarrel.size());
+      if (fConfigCompactBarrel) {
+        if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
+          trackBarrelCovCompact.reserve(tracksBarrel.size());
+        }
+        trackBarrelPIDCompact.reserve(tracksBarrel.size());
+      } else {
+        if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
+          trackBarrelCov.reserve(tracksBarrel.size());
+        }
+        trackBarrelPID.reserve(tracksBarrel.size());
+      }
+
+      // without QA, the cuts of all the tracks of the collision are evaluated first with the cut engine
+      if (fTrackCutEngine) {
+        fTrackMasks.clear();
+        fTrackCutEngine->Clear();
+        for (auto& track : tracksBarrel) {
+          VarManager::FillTrack<TTrackFillMap>(track);
+          fTrackCutEngine->AddRow(VarManager::fgValues);
+          if (fTrackCutEngine->IsFull()) {
+            evaluateTrackCuts();
+          }
+        }
+        evaluateTrackCuts();
       }
-      trackBarrelPID.reserve(tracksBarrel.size());
 
       // loop over tracks
+      size_t iTrack = 0;
       for (auto& track : tracksBarrel) {
         trackFilteringTag = uint64_t(0);
         trackTempFilterMap = uint8_t(0);
-        VarManager::FillTrack<TTrackFillMap>(track);
-        if (fConfigDetailedQA) {
-          fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
-        }
-        // apply track cuts and fill stats histogram
-        int i = 0;
-        for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, i++) {
-          if ((*cut).IsSelected(VarManager::fgValues)) {
-            trackTempFilterMap |= (uint8_t(1) << i);
-            if (!fConfigNoQA) {
-              fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut).GetName()), VarManager::fgValues);
+        if (fTrackCutEngine) {
+          trackTempFilterMap = static_cast<uint8_t>(fTrackMasks[iTrack++]);
+          for (size_t i = 0; i < fTrackCuts.size(); i++) {
+            if (trackTempFilterMap & (uint8_t(1) << i)) {
+              ((TH1I*)fStatsList->At(1))->Fill(float(i));
+            }
+          }
+        } else {
+          VarManager::FillTrack<TTrackFillMap>(track);
+          if (fConfigDetailedQA) {
+            fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
+          }
+          // apply track cuts and fill stats histogram
+          int i = 0;
+          for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, i++) {
+            if ((*cut).IsSelected(VarManager::fgValues)) {
+              trackTempFilterMap |= (uint8_t(1) << i);
+              if (!fConfigNoQA) {
+                fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut).GetName()), VarManager::fgValues);
+              }
+              ((TH1I*)fStatsList->At(1))->Fill(float(i));
             }
-            ((TH1I*)fStatsList->At(1))->Fill(float(i));
           }
         }
         if (!trackTempFilterMap) {
@@ -301,19 +357,37 @@ struct TableMaker {
                     track.tpcNClsShared(), track.tpcChi2NCl(),
                     track.trdChi2(), track.trdPattern(), track.tofChi2(),
                     track.length(), track.dcaXY(), track.dcaZ());
-        if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
-          trackBarrelCov(track.x(), track.alpha(), track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt(),
-                         track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
-                         track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
-                         track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2());
+        if (fConfigCompactBarrel) {
+          using namespace o2::aod::reducedtrackcompact;
+          if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
+            // the correlation coefficients of the AO2D have the same 8 bit encoding and are copied as they are
+            trackBarrelCovCompact(track.x(), track.alpha(), track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt(),
+                                  toHalf(track.sigmaY()), toHalf(track.sigmaZ()), toHalf(track.sigmaSnp()), toHalf(track.sigmaTgl()), toHalf(track.sigma1Pt()),
+                                  track.rhoZY(), track.rhoSnpY(), track.rhoSnpZ(), track.rhoTglY(), track.rhoTglZ(),
+                                  track.rhoTglSnp(), track.rho1PtY(), track.rho1PtZ(), track.rho1PtSnp(), track.rho1PtTgl());
+          }
+          trackBarrelPIDCompact(track.tpcSignal(),
+                                packNSigma(track.tpcNSigmaEl()), packNSigma(track.tpcNSigmaMu()),
+                                packNSigma(track.tpcNSigmaPi()), packNSigma(track.tpcNSigmaKa()), packNSigma(track.tpcNSigmaPr()),
+                                track.beta(),
+                                packNSigma(track.tofNSigmaEl()), packNSigma(track.tofNSigmaMu()),
+                                packNSigma(track.tofNSigmaPi()), packNSigma(track.tofNSigmaKa()), packNSigma(track.tofNSigmaPr()),
+                                track.trdSignal());
+        } else {
+          if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
+            trackBarrelCov(track.x(), track.alpha(), track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt(),
+                           track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
+                           track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
+                           track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2());
+          }
+          trackBarrelPID(track.tpcSignal(),
+                         track.tpcNSigmaEl(), track.tpcNSigmaMu(),
+                         track.tpcNSigmaPi(), track.tpcNSigmaKa(), track.tpcNSigmaPr(),
+                         track.beta(),
+                         track.tofNSigmaEl(), track.tofNSigmaMu(),
+                         track.tofNSigmaPi(), track.tofNSigmaKa(), track.tofNSigmaPr(),
+                         track.trdSignal());
         }
-        trackBarrelPID(track.tpcSignal(),
-                       track.tpcNSigmaEl(), track.tpcNSigmaMu(),
-                       track.tpcNSigmaPi(), track.tpcNSigmaKa(), track.tpcNSigmaPr(),
-                       track.beta(),
-                       track.tofNSigmaEl(), track.tofNSigmaMu(),
-                       track.tofNSigmaPi(), track.tofNSigmaKa(), track.tofNSigmaPr(),
-                       track.trdSignal());
       }
     } // end if constexpr (TTrackFillMap)
 
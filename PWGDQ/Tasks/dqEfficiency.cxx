@@ -25,6 +25,7 @@
 #include "PWGDQ/Core/HistogramsLibrary.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 #include "PWGDQ/Core/MCSignal.h"
+#include "PWGDQ/Core/MCSignalMatcher.h"
 #include "PWGDQ/Core/MCSignalLibrary.h"
 #include <TMath.h>
 #include <TH1F.h>
@@ -162,6 +163,7 @@ struct AnalysisTrackSelection {
   HistogramManager* fHistMan;
   std::vector<AnalysisCompositeCut> fTrackCuts;
   std::vector<MCSignal> fMCSignals; // list of signals to be checked
+  MCSignalMatcher fMCSignalMatcher; // evaluates all the signals with one walk through the history of the MC particle
   std::vector<TString> fHistNamesReco;
   std::vector<std::vector<TString>> fHistNamesMCMatched;
 
@@ -190,6 +192,9 @@ struct AnalysisTrackSelection {
         fMCSignals.push_back(*sig);
       }
     }
+    for (auto& sig : fMCSignals) {
+      fMCSignalMatcher.AddSignal(&sig);
+    }
 
     // Configure histogram classes for each track cut;
     // Add histogram classes for each track cut and for each requested MC signal (reconstructed tracks with MC truth)
@@ -271,18 +276,11 @@ struct AnalysisTrackSelection {
 
       // compute MC matching decisions
       uint32_t mcDecision = 0;
-      int isig = 0;
-      for (auto sig = fMCSignals.begin(); sig != fMCSignals.end(); sig++, isig++) {
-        if constexpr ((TTrackFillMap & VarManager::ObjTypes::ReducedTrack) > 0) {
-          if ((*sig).CheckSignal(false, tracksMC, track.reducedMCTrack())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-        if constexpr ((TTrackFillMap & VarManager::ObjTypes::Track) > 0) {
-          if ((*sig).CheckSignal(false, tracksMC, track.template mcParticle_as<aod::McParticles_001>())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
+      if constexpr ((TTrackFillMap & VarManager::ObjTypes::ReducedTrack) > 0) {
+        mcDecision |= fMCSignalMatcher.CheckSignals(false, tracksMC, track.reducedMCTrack());
+      }
+      if constexpr ((TTrackFillMap & VarManager::ObjTypes::Track) > 0) {
+        mcDecision |= fMCSignalMatcher.CheckSignals(false, tracksMC, track.template mcParticle_as<aod::McParticles_001>());
       }
 
       // fill histograms
@@ -322,6 +320,7 @@ struct AnalysisMuonSelection {
   HistogramManager* fHistMan;
   std::vector<AnalysisCompositeCut> fTrackCuts;
   std::vector<MCSignal> fMCSignals; // list of signals to be checked
+  MCSignalMatcher fMCSignalMatcher; // evaluates all the signals with one walk through the history of the MC particle
   std::vector<TString> fHistNamesReco;
   std::vector<std::vector<TString>> fHistNamesMCMatched;
 
@@ -350,6 +349,9 @@ struct AnalysisMuonSelection {
         fMCSignals.push_back(*sig);
       }
     }
+    for (auto& sig : fMCSignals) {
+      fMCSignalMatcher.AddSignal(&sig);
+    }
 
     // Configure histogram classes for each track cut;
     // Add histogram classes for each track cut and for each requested MC signal (reconstructed tracks with MC truth)
@@ -435,18 +437,11 @@ struct AnalysisMuonSelection {
 
       // compute MC matching decisions
       uint32_t mcDecision = 0;
-      int isig = 0;
-      for (auto sig = fMCSignals.begin(); sig != fMCSignals.end(); sig++, isig++) {
-        if constexpr ((TMuonFillMap & VarManager::ObjTypes::ReducedMuon) > 0) {
-          if ((*sig).CheckSignal(false, muonsMC, muon.reducedMCTrack())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-        if constexpr ((TMuonFillMap & VarManager::ObjTypes::Muon) > 0) {
-          if ((*sig).CheckSignal(false, muonsMC, muon.template mcParticle_as<aod::McParticles_001>())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
+      if constexpr ((TMuonFillMap & VarManager::ObjTypes::ReducedMuon) > 0) {
+        mcDecision |= fMCSignalMatcher.CheckSignals(false, muonsMC, muon.reducedMCTrack());
+      }
+      if constexpr ((TMuonFillMap & VarManager::ObjTypes::Muon) > 0) {
+        mcDecision |= fMCSignalMatcher.CheckSignals(false, muonsMC, muon.template mcParticle_as<aod::McParticles_001>());
       }
 
       // fill histograms
@@ -502,6 +497,7 @@ struct AnalysisSameEventPairing {
   std::vector<std::vector<TString>> fBarrelMuonHistNames;
   std::vector<std::vector<TString>> fBarrelMuonHistNamesMCmatched;
   std::vector<MCSignal> fRecMCSignals;
+  MCSignalMatcher fRecMCSignalMatcher; // evaluates all the reconstructed signals with one walk through the history of each leg
   std::vector<MCSignal> fGenMCSignals;
 
   void init(o2::framework::InitContext& context)
@@ -533,6 +529,9 @@ struct AnalysisSameEventPairing {
         fRecMCSignals.push_back(*sig);
       }
     }
+    for (auto& sig : fRecMCSignals) {
+      fRecMCSignalMatcher.AddSignal(&sig);
+    }
 
     if (enableBarrelHistos) {
       TString cutNames = fConfigTrackCuts.value;
@@ -698,19 +697,12 @@ struct AnalysisSameEventPairing {
 
       // run MC matching for this pair
       uint32_t mcDecision = 0;
-      int isig = 0;
-      for (auto sig = fRecMCSignals.begin(); sig != fRecMCSignals.end(); sig++, isig++) {
-        if constexpr (TTrackFillMap & VarManager::ObjTypes::ReducedTrack || TTrackFillMap & VarManager::ObjTypes::ReducedMuon) { // for skimmed DQ model
-          if ((*sig).CheckSignal(false, tracksMC, t1.reducedMCTrack(), t2.reducedMCTrack())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-        if constexpr (TTrackFillMap & VarManager::ObjTypes::Track || TTrackFillMap & VarManager::ObjTypes::Muon) { // for Framework data model
-          if ((*sig).CheckSignal(false, tracksMC, t1.template mcParticle_as<aod::McParticles_001>(), t2.template mcParticle_as<aod::McParticles_001>())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-      } // end loop over MC signals
+      if constexpr (TTrackFillMap & VarManager::ObjTypes::ReducedTrack || TTrackFillMap & VarManager::ObjTypes::ReducedMuon) { // for skimmed DQ model
+        mcDecision |= fRecMCSignalMatcher.CheckSignals(false, tracksMC, t1.reducedMCTrack(), t2.reducedMCTrack());
+      }
+      if constexpr (TTrackFillMap & VarManager::ObjTypes::Track || TTrackFillMap & VarManager::ObjTypes::Muon) { // for Framework data model
+        mcDecision |= fRecMCSignalMatcher.CheckSignals(false, tracksMC, t1.template mcParticle_as<aod::McParticles_001>(), t2.template mcParticle_as<aod::McParticles_001>());
+      }
 
       dileptonFilterMap = twoTrackFilter;
       dileptonMcDecision = mcDecision;
@@ -39,6 +39,7 @@
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/Centrality.h"
+#include "Common/DataModel/Qvectors.h"
 #include <TH1F.h>
 #include <THashList.h>
 #include <TString.h>
@@ -316,7 +317,12 @@ struct AnalysisQvector {
 
     // Fill the VarManager::fgValues with the Q vector quantities
     VarManager::FillQVectorFromGFW(collision, Q2vec, Q2vecN, Q2vecP, Q3vec, Q3vecN, Q3vecP, nentries, nentriesN, nentriesP);
+    fillQvectorOutputs(nentries, nentriesN, nentriesP);
+  }
 
+  // Fill the QA histograms and the reduced event table with the Q vector quantities of VarManager::fgValues
+  void fillQvectorOutputs(int nentries, int nentriesN, int nentriesP)
+  {
     if (fConfigQA) {
       if (nentriesN * nentriesP * nentries != 0) {
         fHistMan->FillHistClass("Event_BeforeCuts", VarManager::fgValues);
@@ -338,6 +344,24 @@ struct AnalysisQvector {
     runFillQvector<gkEventFillMap, gkTrackFillMap>(collisions, bcs, tracks);
   }
 
+  // Process to fill Q vector in a reduced event table from the Q vectors of the qvectors-table task, instead of computing them from the tracks
+  //   sub-events A, B and C are the full eta range and the negative and positive eta sub-events, normalised by their numbers of tracks as in processQvector
+  //   NOTE: the track selection and the weights are the ones of the qvectors-table task; cfgNPow = 0 here corresponds to its cfgNPow = 0
+  void processQvectorFromTable(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms, aod::Qvectors>::iterator const& collision, aod::BCs const&)
+  {
+    VarManager::ResetValues(0, VarManager::kNVars);
+    VarManager::FillEvent<gkEventFillMap>(collision);
+
+    TComplex Q2vec(collision.q2xFull(), collision.q2yFull());
+    TComplex Q2vecN(collision.q2xNeg(), collision.q2yNeg());
+    TComplex Q2vecP(collision.q2xPos(), collision.q2yPos());
+    TComplex Q3vec(collision.q3xFull(), collision.q3yFull());
+    TComplex Q3vecN(collision.q3xNeg(), collision.q3yNeg());
+    TComplex Q3vecP(collision.q3xPos(), collision.q3yPos());
+    VarManager::FillQVectorFromGFW(collision, Q2vec, Q2vecN, Q2vecP, Q3vec, Q3vecN, Q3vecP, collision.nTrkFull(), collision.nTrkNeg(), collision.nTrkPos());
+    fillQvectorOutputs(collision.nTrkFull(), collision.nTrkNeg(), collision.nTrkPos());
+  }
+
   // TODO: dummy function for the case when no process function is enabled
   void processDummy(MyEvents&)
   {
@@ -345,6 +369,7 @@ struct AnalysisQvector {
   }
 
   PROCESS_SWITCH(AnalysisQvector, processQvector, "Run q-vector task", false);
+  PROCESS_SWITCH(AnalysisQvector, processQvectorFromTable, "Run q-vector task with the Q vectors of the qvectors-table task", false);
   PROCESS_SWITCH(AnalysisQvector, processDummy, "Dummy function", false);
 };
 
@@ -22,15 +22,25 @@
 #include "PWGDQ/Core/MixingHandler.h"
 #include "PWGDQ/Core/AnalysisCut.h"
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/AnalysisCutEngine.h"
 #include "PWGDQ/Core/HistogramsLibrary.h"
 #include "PWGDQ/Core/CutsLibrary.h"
+#include "PWGDQ/Core/CutsCache.h"
 #include "PWGDQ/Core/MixingLibrary.h"
+#include "Common/Core/MixingPool.h"
+#include "Common/Core/ConfigurationCache.h"
+#include "Common/Core/InitTimer.h"
 #include <TH1F.h>
 #include <THashList.h>
 #include <TString.h>
+#include <array>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <algorithm>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 using std::cout;
 using std::endl;
@@ -76,6 +86,9 @@ using MyBarrelTracks = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, a
 using MyBarrelTracksWithCov = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelCov, aod::ReducedTracksBarrelPID>;
 using MyBarrelTracksSelected = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPID, aod::BarrelTrackCuts>;
 using MyBarrelTracksSelectedWithCov = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelCov, aod::ReducedTracksBarrelPID, aod::BarrelTrackCuts>;
+// skims written with cfgCompactBarrel, the compact tables have the same getters and are read with the same fill maps
+using MyBarrelTracksCompact = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPIDCompact>;
+using MyBarrelTracksSelectedCompact = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPIDCompact, aod::BarrelTrackCuts>;
 
 using MyMuonTracks = soa::Join<aod::ReducedMuons, aod::ReducedMuonsExtra>;
 using MyMuonTracksSelected = soa::Join<aod::ReducedMuons, aod::ReducedMuonsExtra, aod::MuonTrackCuts>;
@@ -89,7 +102,7 @@ constexpr static uint32_t gkEventFillMapWithQvector = VarManager::ObjTypes::Redu
 constexpr static uint32_t gkEventFillMapWithCovQvector = VarManager::ObjTypes::ReducedEvent | VarManager::ObjTypes::ReducedEventExtended | VarManager::ObjTypes::ReducedEventVtxCov | VarManager::ObjTypes::ReducedEventQvector;
 
 constexpr static uint32_t gkTrackFillMap = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::ReducedTrackBarrel | VarManager::ObjTypes::ReducedTrackBarrelPID;
-// constexpr static uint32_t gkTrackFillMapWithCov = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::ReducedTrackBarrel | VarManager::ObjTypes::ReducedTrackBarrelCov | VarManager::ObjTypes::ReducedTrackBarrelPID;
+constexpr static uint32_t gkTrackFillMapWithCov = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::ReducedTrackBarrel | VarManager::ObjTypes::ReducedTrackBarrelCov | VarManager::ObjTypes::ReducedTrackBarrelPID;
 constexpr static uint32_t gkMuonFillMap = VarManager::ObjTypes::ReducedMuon | VarManager::ObjTypes::ReducedMuonExtra;
 constexpr static uint32_t gkMuonFillMapWithCov = VarManager::ObjTypes::ReducedMuon | VarManager::ObjTypes::ReducedMuonExtra | VarManager::ObjTypes::ReducedMuonCov;
 
@@ -190,27 +203,46 @@ struct AnalysisTrackSelection {
   // NOTE: For now, the candidate electron cuts must be provided first, then followed by any other needed selections
   Configurable<string> fConfigCuts{"cfgTrackCuts", "jpsiPID1", "Comma separated list of barrel track cuts"};
   Configurable<bool> fConfigQA{"cfgQA", false, "If true, fill QA histograms"};
+  Configurable<int> fConfigCutBatchSize{"cfgCutBatchSize", 1024, "Number of tracks evaluated at once by the cut engine if QA is off, 0: evaluate the cuts track by track"};
+  Configurable<string> fConfigInitCacheDir{"cfgInitCacheDir", "", "Directory of the cache of the cuts built from the configuration, shared by the jobs with the same cuts; empty: disabled"};
+  Configurable<bool> fConfigInitTiming{"cfgInitTiming", false, "If true, print the time of the steps of init"};
 
   HistogramManager* fHistMan;
   std::vector<AnalysisCompositeCut> fTrackCuts;
+  std::unique_ptr<AnalysisCutEngine> fCutEngine; // all the cuts evaluated over batches of tracks
+  int fHistClassBeforeCuts = HistogramManager::kNothing; // handles of the histogram classes, resolved once in init()
+  std::vector<int> fHistClassesCuts;
+  o2::analysis::InitTimer fInitTimer;
 
   void init(o2::framework::InitContext&)
   {
+    if (fConfigInitTiming) {
+      fInitTimer.enable("analysis-track-selection");
+    }
     TString cutNamesStr = fConfigCuts.value;
     if (!cutNamesStr.IsNull()) {
-      std::unique_ptr<TObjArray> objArray(cutNamesStr.Tokenize(","));
-      for (int icut = 0; icut < objArray->GetEntries(); ++icut) {
-        fTrackCuts.push_back(*dqcuts::GetCompositeCut(objArray->At(icut)->GetName()));
-      }
+      auto step = fInitTimer.measure("cuts");
+      o2::analysis::ConfigurationCache cache;
+      cache.setDirectory(fConfigInitCacheDir.value);
+      fTrackCuts = dqcuts::GetCompositeCuts(cutNamesStr.Data(), cache);
     }
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
 
+    // the QA histograms are filled track by track, so the batched evaluation is only used without QA
+    if (!fConfigQA && fConfigCutBatchSize > 0) {
+      fCutEngine = std::make_unique<AnalysisCutEngine>(fConfigCutBatchSize);
+      for (auto& cut : fTrackCuts) {
+        fCutEngine->AddCut(&cut);
+      }
+    }
+
     if (fConfigQA) {
       VarManager::SetDefaultVarNames();
       fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
       fHistMan->SetUseDefaultVariableNames(kTRUE);
       fHistMan->SetDefaultVarNames(VarManager::fgVariableNames, VarManager::fgVariableUnits);
 
+      auto step = fInitTimer.measure("histograms");
       // set one histogram directory for each defined track cut
       TString histDirNames = "TrackBarrel_BeforeCuts;";
       for (auto& cut : fTrackCuts) {
@@ -220,7 +252,13 @@ struct AnalysisTrackSelection {
       DefineHistograms(fHistMan, histDirNames.Data()); // define all histograms
       VarManager::SetUseVars(fHistMan->GetUsedVars()); // provide the list of required variables so that VarManager knows what to fill
       fOutputList.setObject(fHistMan->GetMainHistogramList());
+
+      fHistClassBeforeCuts = fHistMan->GetHistClassHandle("TrackBarrel_BeforeCuts");
+      for (auto& cut : fTrackCuts) {
+        fHistClassesCuts.push_back(fHistMan->GetHistClassHandle(Form("TrackBarrel_%s", cut.GetName())));
+      }
     }
+    fInitTimer.print();
   }
 
   template <uint32_t TEventFillMap, uint32_t TTrackFillMap, typename TEvent, typename TTracks>
@@ -234,11 +272,24 @@ struct AnalysisTrackSelection {
     uint32_t filterMap = 0;
     int iCut = 0;
 
+    if (fCutEngine) {
+      fCutEngine->Clear();
+      for (auto& track : tracks) {
+        VarManager::FillTrack<TTrackFillMap>(track);
+        fCutEngine->AddRow(VarManager::fgValues);
+        if (fCutEngine->IsFull()) {
+          fillTrackSelection();
+        }
+      }
+      fillTrackSelection();
+      return;
+    }
+
     for (auto& track : tracks) {
       filterMap = 0;
       VarManager::FillTrack<TTrackFillMap>(track);
       if (fConfigQA) { // TODO: make this compile time
-        fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassBeforeCuts, VarManager::fgValues);
       }
 
       iCut = 0;
@@ -246,7 +297,7 @@ struct AnalysisTrackSelection {
         if ((*cut).IsSelected(VarManager::fgValues)) {
           filterMap |= (uint32_t(1) << iCut);
           if (fConfigQA) { // TODO: make this compile time
-            fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut).GetName()), VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassesCuts[iCut], VarManager::fgValues);
           }
         }
       }
@@ -254,16 +305,31 @@ struct AnalysisTrackSelection {
     } // end loop over tracks
   }
 
+  // write the decisions of the tracks in the batch of the cut engine and empty it
+  void fillTrackSelection()
+  {
+    fCutEngine->Evaluate();
+    for (int i = 0; i < fCutEngine->GetNRows(); ++i) {
+      trackSel(static_cast<int>(fCutEngine->GetMask(i)));
+    }
+    fCutEngine->Clear();
+  }
+
   void processSkimmed(MyEvents::iterator const& event, MyBarrelTracks const& tracks)
   {
     runTrackSelection<gkEventFillMap, gkTrackFillMap>(event, tracks);
   }
+  void processSkimmedCompact(MyEvents::iterator const& event, MyBarrelTracksCompact const& tracks)
+  {
+    runTrackSelection<gkEventFillMap, gkTrackFillMap>(event, tracks);
+  }
   void processDummy(MyEvents&)
   {
     // do nothing
   }
 
   PROCESS_SWITCH(AnalysisTrackSelection, processSkimmed, "Run barrel track selection on DQ skimmed tracks", false);
+  PROCESS_SWITCH(AnalysisTrackSelection, processSkimmedCompact, "Run barrel track selection on DQ skimmed tracks with the compact PID table", false);
   PROCESS_SWITCH(AnalysisTrackSelection, processDummy, "Dummy function", false);
 };
 
@@ -272,27 +338,46 @@ struct AnalysisMuonSelection {
   OutputObj<THashList> fOutputList{"output"};
   Configurable<string> fConfigCuts{"cfgMuonCuts", "muonQualityCuts", "Comma separated list of muon cuts"};
   Configurable<bool> fConfigQA{"cfgQA", false, "If true, fill QA histograms"};
+  Configurable<int> fConfigCutBatchSize{"cfgCutBatchSize", 1024, "Number of muons evaluated at once by the cut engine if QA is off, 0: evaluate the cuts muon by muon"};
+  Configurable<string> fConfigInitCacheDir{"cfgInitCacheDir", "", "Directory of the cache of the cuts built from the configuration, shared by the jobs with the same cuts; empty: disabled"};
+  Configurable<bool> fConfigInitTiming{"cfgInitTiming", false, "If true, print the time of the steps of init"};
 
   HistogramManager* fHistMan;
   std::vector<AnalysisCompositeCut> fMuonCuts;
+  std::unique_ptr<AnalysisCutEngine> fCutEngine; // all the cuts evaluated over batches of muons
+  int fHistClassBeforeCuts = HistogramManager::kNothing; // handles of the histogram classes, resolved once in init()
+  std::vector<int> fHistClassesCuts;
+  o2::analysis::InitTimer fInitTimer;
 
   void init(o2::framework::InitContext&)
   {
+    if (fConfigInitTiming) {
+      fInitTimer.enable("analysis-muon-selection");
+    }
     TString cutNamesStr = fConfigCuts.value;
     if (!cutNamesStr.IsNull()) {
-      std::unique_ptr<TObjArray> objArray(cutNamesStr.Tokenize(","));
-      for (int icut = 0; icut < objArray->GetEntries(); ++icut) {
-        fMuonCuts.push_back(*dqcuts::GetCompositeCut(objArray->At(icut)->GetName()));
-      }
+      auto step = fInitTimer.measure("cuts");
+      o2::analysis::ConfigurationCache cache;
+      cache.setDirectory(fConfigInitCacheDir.value);
+      fMuonCuts = dqcuts::GetCompositeCuts(cutNamesStr.Data(), cache);
     }
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
 
+    // the QA histograms are filled muon by muon, so the batched evaluation is only used without QA
+    if (!fConfigQA && fConfigCutBatchSize > 0) {
+      fCutEngine = std::make_unique<AnalysisCutEngine>(fConfigCutBatchSize);
+      for (auto& cut : fMuonCuts) {
+        fCutEngine->AddCut(&cut);
+      }
+    }
+
     if (fConfigQA) {
       VarManager::SetDefaultVarNames();
       fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
       fHistMan->SetUseDefaultVariableNames(kTRUE);
       fHistMan->SetDefaultVarNames(VarManager::fgVariableNames, VarManager::fgVariableUnits);
 
+      auto step = fInitTimer.measure("histograms");
       // set one histogram directory for each defined track cut
       TString histDirNames = "TrackMuon_BeforeCuts;";
       for (auto& cut : fMuonCuts) {
@@ -302,7 +387,13 @@ struct AnalysisMuonSelection {
       DefineHistograms(fHistMan, histDirNames.Data()); // define all histograms
       VarManager::SetUseVars(fHistMan->GetUsedVars()); // provide the list of required variables so that VarManager knows what to fill
       fOutputList.setObject(fHistMan->GetMainHistogramList());
+
+      fHistClassBeforeCuts = fHistMan->GetHistClassHandle("TrackMuon_BeforeCuts");
+      for (auto& cut : fMuonCuts) {
+        fHistClassesCuts.push_back(fHistMan->GetHistClassHandle(Form("TrackMuon_%s", cut.GetName())));
+      }
     }
+    fInitTimer.print();
   }
 
   template <uint32_t TEventFillMap, uint32_t TMuonFillMap, typename TEvent, typename TMuons>
@@ -315,11 +406,24 @@ struct AnalysisMuonSelection {
     uint32_t filterMap = 0;
     int iCut = 0;
 
+    if (fCutEngine) {
+      fCutEngine->Clear();
+      for (auto& muon : muons) {
+        VarManager::FillTrack<TMuonFillMap>(muon);
+        fCutEngine->AddRow(VarManager::fgValues);
+        if (fCutEngine->IsFull()) {
+          fillMuonSelection();
+        }
+      }
+      fillMuonSelection();
+      return;
+    }
+
     for (auto& muon : muons) {
       filterMap = 0;
       VarManager::FillTrack<TMuonFillMap>(muon);
       if (fConfigQA) { // TODO: make this compile time
-        fHistMan->FillHistClass("TrackMuon_BeforeCuts", VarManager::fgValues);
+        fHistMan->FillHistClass(fHistClassBeforeCuts, VarManager::fgValues);
       }
 
       iCut = 0;
@@ -327,7 +431,7 @@ struct AnalysisMuonSelection {
         if ((*cut).IsSelected(VarManager::fgValues)) {
           filterMap |= (uint32_t(1) << iCut);
           if (fConfigQA) { // TODO: make this compile time
-            fHistMan->FillHistClass(Form("TrackMuon_%s", (*cut).GetName()), VarManager::fgValues);
+            fHistMan->FillHistClass(fHistClassesCuts[iCut], VarManager::fgValues);
           }
         }
       }
@@ -335,6 +439,16 @@ struct AnalysisMuonSelection {
     } // end loop over tracks
   }
 
+  // write the decisions of the muons in the batch of the cut engine and empty it
+  void fillMuonSelection()
+  {
+    fCutEngine->Evaluate();
+    for (int i = 0; i < fCutEngine->GetNRows(); ++i) {
+      muonSel(static_cast<int>(fCutEngine->GetMask(i)));
+    }
+    fCutEngine->Clear();
+  }
+
   void processSkimmed(MyEvents::iterator const& event, MyMuonTracks const& muons)
   {
     runMuonSelection<gkEventFillMap, gkMuonFillMap>(event, muons);
@@ -356,11 +470,31 @@ struct AnalysisEventMixing {
   // TODO: Create a configurable to specify exactly on which of the bits one should run the event mixing
   Configurable<string> fConfigTrackCuts{"cfgTrackCuts", "", "Comma separated list of barrel track cuts"};
   Configurable<string> fConfigMuonCuts{"cfgMuonCuts", "", "Comma separated list of muon cuts"};
+  Configurable<int> fConfigPoolDepth{"cfgPoolDepth", 0, "Number of events per mixing category kept across dataframes, 0: mix only events of the same dataframe"};
+  Configurable<float> fConfigPoolMaxMemory{"cfgPoolMaxMemory", 100.f, "Maximum memory of the mixing pool in MB, 0: no limit"};
+  Configurable<bool> fConfigPoolReservoir{"cfgPoolReservoir", false, "Replace random events of a full mixing category (reservoir sampling) instead of the oldest ones"};
 
   Filter filterEventSelected = aod::dqanalysisflags::isEventSelected == 1;
   Filter filterTrackSelected = aod::dqanalysisflags::isBarrelSelected > 0;
   Filter filterMuonTrackSelected = aod::dqanalysisflags::isMuonSelected > 0;
 
+  // Compact copy of a selected track, with the accessors used in the mixed event pairing
+  struct MixingTrack {
+    float fPt;
+    float fEta;
+    float fPhi;
+    int fSign;
+    uint32_t fFilter; // barrel or muon filter map
+    float pt() const { return fPt; }
+    float eta() const { return fEta; }
+    float phi() const { return fPhi; }
+    int sign() const { return fSign; }
+    uint32_t isBarrelSelected() const { return fFilter; }
+    uint32_t isMuonSelected() const { return fFilter; }
+  };
+  o2::analysis::MixingPool<MixingTrack> fPool;       // events of the previous dataframes, used if cfgPoolDepth > 0
+  o2::analysis::MixingPool<MixingTrack> fPoolBarrel; // barrel tracks of the previous events for the barrel-muon mixing, whose fPool keeps the muons
+
   HistogramManager* fHistMan;
   // NOTE: The bit mask is required to run pairing just based on the desired electron/muon candidate cuts
   uint32_t fTwoTrackFilterMask = 0;
@@ -434,22 +568,26 @@ struct AnalysisEventMixing {
     DefineHistograms(fHistMan, histNames.Data());    // define all histograms
     VarManager::SetUseVars(fHistMan->GetUsedVars()); // provide the list of required variables so that VarManager knows what to fill
     fOutputList.setObject(fHistMan->GetMainHistogramList());
+
+    auto replacement = fConfigPoolReservoir ? o2::analysis::MixingPool<MixingTrack>::Replacement::Reservoir : o2::analysis::MixingPool<MixingTrack>::Replacement::FIFO;
+    fPool.init(fConfigPoolDepth, static_cast<size_t>(fConfigPoolMaxMemory * 1024 * 1024), replacement);
+    if (context.mOptions.get<bool>("processBarrelMuonSkimmed")) {
+      fPoolBarrel.init(fConfigPoolDepth, static_cast<size_t>(fConfigPoolMaxMemory * 1024 * 1024), replacement);
+    }
   }
 
   template <int TPairType, typename TTracks1, typename TTracks2>
   void runMixedPairing(TTracks1 const& tracks1, TTracks2 const& tracks2)
   {
 
-    unsigned int ncuts = fTrackHistNames.size();
-    std::vector<std::vector<TString>> histNames = fTrackHistNames;
+    const std::vector<std::vector<TString>>* histNames = &fTrackHistNames;
     if constexpr (TPairType == pairTypeMuMu) {
-      ncuts = fMuonHistNames.size();
-      histNames = fMuonHistNames;
+      histNames = &fMuonHistNames;
     }
     if constexpr (TPairType == pairTypeEMu) {
-      ncuts = fTrackMuonHistNames.size();
-      histNames = fTrackMuonHistNames;
+      histNames = &fTrackMuonHistNames;
     }
+    const unsigned int ncuts = histNames->size();
 
     uint32_t twoTrackFilter = 0;
     for (auto& track1 : tracks1) {
@@ -474,21 +612,83 @@ struct AnalysisEventMixing {
           VarManager::FillPairVn<TPairType>(track1, track2);
         }
 
-        for (unsigned int icut = 0; icut < ncuts; icut++) {
-          if (twoTrackFilter & (uint32_t(1) << icut)) {
-            if (track1.sign() * track2.sign() < 0) {
-              fHistMan->FillHistClass(histNames[icut][0].Data(), VarManager::fgValues);
-            } else {
-              if (track1.sign() > 0) {
-                fHistMan->FillHistClass(histNames[icut][1].Data(), VarManager::fgValues);
-              } else {
-                fHistMan->FillHistClass(histNames[icut][2].Data(), VarManager::fgValues);
-              }
-            }
-          } // end if (filter bits)
-        }   // end for (cuts)
-      }     // end for (track2)
-    }       // end for (track1)
+        const int histIdx = (track1.sign() * track2.sign() < 0) ? 0 : (track1.sign() > 0 ? 1 : 2);
+        // loop over the set bits only, in increasing order
+        for (uint32_t cutBits = twoTrackFilter; cutBits != 0; cutBits &= (cutBits - 1)) {
+          const unsigned int icut = __builtin_ctz(cutBits);
+          if (icut >= ncuts) {
+            break;
+          }
+          fHistMan->FillHistClass((*histNames)[icut][histIdx].Data(), VarManager::fgValues);
+        } // end for (cuts)
+      }   // end for (track2)
+    }     // end for (track1)
+  }
+
+  // tracks of each event of the dataframe, by event index, so that the tracks of the mixed events are not searched in the slicer
+  template <typename TEvents, typename TTracks>
+  std::unordered_map<int64_t, TTracks> sliceByEvent(TEvents& events, TTracks const& tracks)
+  {
+    std::unordered_map<int64_t, TTracks> slices;
+    auto tracksTuple = std::make_tuple(tracks);
+    GroupSlicer slicerTracks(events, tracksTuple);
+    for (auto& slice : slicerTracks) {
+      auto eventTracks = std::get<TTracks>(slice.associatedTables());
+      eventTracks.bindExternalIndices(&events);
+      slices.emplace(slice.groupingElement().index(), eventTracks);
+    }
+    return slices;
+  }
+
+  // copy the tracks of an event to be stored in the mixing pool
+  template <bool TMuon, typename TTracks>
+  std::vector<MixingTrack> makeSnapshot(TTracks const& tracks)
+  {
+    std::vector<MixingTrack> snapshot;
+    snapshot.reserve(tracks.size());
+    for (auto& track : tracks) {
+      if constexpr (TMuon) {
+        snapshot.push_back({track.pt(), track.eta(), track.phi(), track.sign(), uint32_t(track.isMuonSelected())});
+      } else {
+        snapshot.push_back({track.pt(), track.eta(), track.phi(), track.sign(), uint32_t(track.isBarrelSelected())});
+      }
+    }
+    return snapshot;
+  }
+
+  // event mixing with the pool: each event is paired with the events of the same category stored from the previous events,
+  //   in this and in the previous dataframes, and then stored in the pool. For the barrel-muon mixing, the barrel tracks of the event
+  //   are paired with the stored muons and its muons with the stored barrel tracks
+  template <int TPairType, uint32_t TEventFillMap, typename TEvents, typename TTracks1, typename TTracks2>
+  void runPool(TEvents& events, TTracks1 const& tracks1, TTracks2 const& tracks2)
+  {
+    auto tracks1Tuple = std::make_tuple(tracks1);
+    auto tracks2Tuple = std::make_tuple(tracks2);
+    GroupSlicer slicerTracks1(events, tracks1Tuple);
+    GroupSlicer slicerTracks2(events, tracks2Tuple);
+    auto it2 = slicerTracks2.begin();
+    for (auto& slice1 : slicerTracks1) {
+      auto event = slice1.groupingElement();
+      auto eventTracks1 = std::get<TTracks1>(slice1.associatedTables());
+      auto eventTracks2 = std::get<TTracks2>(it2.associatedTables());
+      ++it2;
+      int category = event.mixingHash();
+      if (category < 0) {
+        continue;
+      }
+      VarManager::ResetValues(0, VarManager::kNVars);
+      VarManager::FillEvent<TEventFillMap>(event, VarManager::fgValues);
+      fPool.forEachEvent(category, [&](const std::vector<MixingTrack>& storedTracks) {
+        runMixedPairing<TPairType>(eventTracks1, storedTracks);
+      });
+      if constexpr (TPairType == pairTypeEMu) {
+        fPoolBarrel.forEachEvent(category, [&](const std::vector<MixingTrack>& storedTracks) {
+          runMixedPairing<TPairType>(storedTracks, eventTracks2);
+        });
+        fPoolBarrel.add(category, makeSnapshot<false>(eventTracks1));
+      }
+      fPool.add(category, makeSnapshot<TPairType != pairTypeEE>(eventTracks2));
+    }
   }
 
   // barrel-barrel and muon-muon event mixing
@@ -496,31 +696,15 @@ struct AnalysisEventMixing {
   void runSameSide(TEvents& events, TTracks const& tracks)
   {
     events.bindExternalIndices(&tracks);
-    auto tracksTuple = std::make_tuple(tracks);
-    GroupSlicer slicerTracks(events, tracksTuple);
+    if (fConfigPoolDepth > 0) {
+      runPool<TPairType, TEventFillMap>(events, tracks, tracks);
+      return;
+    }
+    auto tracksPerEvent = sliceByEvent(events, tracks);
     for (auto& [event1, event2] : selfCombinations(hashBin, 100, -1, events, events)) {
       VarManager::ResetValues(0, VarManager::kNVars);
       VarManager::FillEvent<TEventFillMap>(event1, VarManager::fgValues);
-      auto it1 = slicerTracks.begin();
-      for (auto& slice : slicerTracks) {
-        if (slice.groupingElement().index() == event1.index()) {
-          it1 = slice;
-          break;
-        }
-      }
-      auto tracks1 = std::get<TTracks>(it1.associatedTables());
-      tracks1.bindExternalIndices(&events);
-      auto it2 = slicerTracks.begin();
-      for (auto& slice : slicerTracks) {
-        if (slice.groupingElement().index() == event2.index()) {
-          it2 = slice;
-          break;
-        }
-      }
-      auto tracks2 = std::get<TTracks>(it2.associatedTables());
-      tracks2.bindExternalIndices(&events);
-
-      runMixedPairing<TPairType>(tracks1, tracks2);
+      runMixedPairing<TPairType>(tracksPerEvent.at(event1.index()), tracksPerEvent.at(event2.index()));
     } // end event loop
   }
 
@@ -529,33 +713,16 @@ struct AnalysisEventMixing {
   void runBarrelMuon(TEvents& events, TTracks const& tracks, TMuons const& muons)
   {
     events.bindExternalIndices(&muons);
-    auto tracksTuple = std::make_tuple(tracks);
-    auto muonsTuple = std::make_tuple(muons);
-    GroupSlicer slicerTracks(events, tracksTuple);
-    GroupSlicer slicerMuons(events, muonsTuple);
+    if (fConfigPoolDepth > 0) {
+      runPool<pairTypeEMu, TEventFillMap>(events, tracks, muons);
+      return;
+    }
+    auto tracksPerEvent = sliceByEvent(events, tracks);
+    auto muonsPerEvent = sliceByEvent(events, muons);
     for (auto& [event1, event2] : selfCombinations(hashBin, 100, -1, events, events)) {
       VarManager::ResetValues(0, VarManager::kNVars);
       VarManager::FillEvent<TEventFillMap>(event1, VarManager::fgValues);
-      auto it1 = slicerTracks.begin();
-      for (auto& slice : slicerTracks) {
-        if (slice.groupingElement().index() == event1.index()) {
-          it1 = slice;
-          break;
-        }
-      }
-      auto tracks1 = std::get<TTracks>(it1.associatedTables());
-      tracks1.bindExternalIndices(&events);
-      auto it2 = slicerMuons.begin();
-      for (auto& slice : slicerMuons) {
-        if (slice.groupingElement().index() == event2.index()) {
-          it2 = slice;
-          break;
-        }
-      }
-      auto muons2 = std::get<TMuons>(it2.associatedTables());
-      muons2.bindExternalIndices(&events);
-
-      runMixedPairing<pairTypeEMu>(tracks1, muons2);
+      runMixedPairing<pairTypeEMu>(tracksPerEvent.at(event1.index()), muonsPerEvent.at(event2.index()));
     } // end event loop
   }
 
@@ -606,12 +773,21 @@ struct AnalysisSameEventPairing {
   Configurable<string> url{"ccdb-url", "http://ccdb-test.cern.ch:8080", "url of the ccdb repository"};
   Configurable<string> ccdbPath{"ccdb-path", "Users/lm", "base path to the ccdb object"};
   Configurable<long> nolaterthan{"ccdb-no-later-than", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), "latest acceptable timestamp of creation for the object"};
+  Configurable<int> fConfigNThreads{"cfgNThreads", 1, "Max. number of threads computing the pair variables and the pair vertexing of an event"};
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   Filter filterEventSelected = aod::dqanalysisflags::isEventSelected == 1;
   // NOTE: the barrel filter map contains decisions for both electrons and hadrons used in the correlation task
   Filter filterBarrelTrackSelected = aod::dqanalysisflags::isBarrelSelected > 0;
   Filter filterMuonTrackSelected = aod::dqanalysisflags::isMuonSelected > 0;
 
+  // With several threads, the pairs of an event are filled in chunks: the pair variables and the vertexing are computed in parallel,
+  //   each worker thread with its own VarManager context (values and fitters), into one values array per pair.
+  //   The tables and the histograms are then filled from the main thread, in the order of the pairs
+  static constexpr size_t kNPairsPerThreadMin = 32; // below this, pairs are not worth a thread
+  static constexpr size_t kNPairsPerChunk = 4096;   // limits the memory of the pair values arrays
+  std::vector<std::unique_ptr<VarManager::Context>> fPairContexts; // contexts of the worker threads
+  std::vector<float> fPairValues;                                  // values of the pairs of a chunk, kNVars per pair
+
   HistogramManager* fHistMan;
 
   // NOTE: The track filter produced by the barrel track selection contain a number of electron cut decisions and one last cut for hadrons used in the
@@ -632,7 +808,7 @@ struct AnalysisSameEventPairing {
 
     // Keep track of all the histogram class names to avoid composing strings in the event mixing pairing
     TString histNames = "";
-    if (context.mOptions.get<bool>("processJpsiToEESkimmed") || context.mOptions.get<bool>("processVnJpsiToEESkimmed") || context.mOptions.get<bool>("processAllSkimmed")) {
+    if (context.mOptions.get<bool>("processJpsiToEESkimmed") || context.mOptions.get<bool>("processJpsiToEESkimmedCompact") || context.mOptions.get<bool>("processVnJpsiToEESkimmed") || context.mOptions.get<bool>("processAllSkimmed")) {
       TString cutNames = fConfigTrackCuts.value;
       if (!cutNames.IsNull()) {
         std::unique_ptr<TObjArray> objArray(cutNames.Tokenize(","));
@@ -698,6 +874,15 @@ struct AnalysisSameEventPairing {
 
     VarManager::SetupTwoProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true); // TODO: get these parameters from Configurables
     VarManager::SetupTwoProngFwdDCAFitter(5.0f, true, 200.0f, 1.0e-3f, 0.9f, true);
+
+    // the fitters of the worker threads are configured as the ones of the default context
+    for (int iThread = 1; iThread < fConfigNThreads.value; iThread++) {
+      fPairContexts.push_back(std::make_unique<VarManager::Context>());
+      VarManager::SetThreadContext(fPairContexts.back().get());
+      VarManager::SetupTwoProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true);
+      VarManager::SetupTwoProngFwdDCAFitter(5.0f, true, 200.0f, 1.0e-3f, 0.9f, true);
+    }
+    VarManager::SetThreadContext(nullptr);
   }
 
   // Template function to run same event pairing (barrel-barrel, muon-muon, barrel-muon)
@@ -705,73 +890,119 @@ struct AnalysisSameEventPairing {
   void runSameEventPairing(TEvent const& event, TTracks1 const& tracks1, TTracks2 const& tracks2)
   {
 
-    unsigned int ncuts = fTrackHistNames.size();
-    std::vector<std::vector<TString>> histNames = fTrackHistNames;
+    const std::vector<std::vector<TString>>* histNames = &fTrackHistNames;
     if constexpr (TPairType == pairTypeMuMu) {
-      ncuts = fMuonHistNames.size();
-      histNames = fMuonHistNames;
+      histNames = &fMuonHistNames;
     }
     if constexpr (TPairType == pairTypeEMu) {
-      ncuts = fTrackMuonHistNames.size();
-      histNames = fTrackMuonHistNames;
+      histNames = &fTrackMuonHistNames;
     }
+    const unsigned int ncuts = histNames->size();
+    constexpr bool eventHasQvector = ((TEventFillMap & VarManager::ObjTypes::ReducedEventQvector) > 0);
 
-    uint32_t twoTrackFilter = 0;
     uint32_t dileptonFilterMap = 0;
     uint32_t dileptonMcDecision = 0; // placeholder, copy of the dqEfficiency.cxx one
     dileptonList.reserve(1);
     dileptonExtraList.reserve(1);
-    for (auto& [t1, t2] : combinations(tracks1, tracks2)) {
+
+    auto pairFilter = [&](auto const& t1, auto const& t2) -> uint32_t {
       if constexpr (TPairType == VarManager::kJpsiToEE) {
-        twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected()) & fTwoTrackFilterMask;
+        return uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected()) & fTwoTrackFilterMask;
       }
       if constexpr (TPairType == VarManager::kJpsiToMuMu) {
-        twoTrackFilter = uint32_t(t1.isMuonSelected()) & uint32_t(t2.isMuonSelected()) & fTwoMuonFilterMask;
+        return uint32_t(t1.isMuonSelected()) & uint32_t(t2.isMuonSelected()) & fTwoMuonFilterMask;
       }
       if constexpr (TPairType == VarManager::kElectronMuon) {
-        twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isMuonSelected()) & fTwoTrackFilterMask;
-      }
-      if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
-        continue;
+        return uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isMuonSelected()) & fTwoTrackFilterMask;
       }
-      constexpr bool eventHasQvector = ((TEventFillMap & VarManager::ObjTypes::ReducedEventQvector) > 0);
-
+      return 0;
+    };
+    auto fillPairValues = [&](auto const& t1, auto const& t2, float* values) {
       // TODO: FillPair functions need to provide a template argument to discriminate between cases when cov matrix is available or not
-      VarManager::FillPair<TPairType, TTrackFillMap>(t1, t2);
+      VarManager::FillPair<TPairType, TTrackFillMap>(t1, t2, values);
       if constexpr ((TPairType == pairTypeEE) || (TPairType == pairTypeMuMu)) { // call this just for ee or mumu pairs
-        VarManager::FillPairVertexing<TPairType, TEventFillMap, TTrackFillMap>(event, t1, t2);
+        VarManager::FillPairVertexing<TPairType, TEventFillMap, TTrackFillMap>(event, t1, t2, values);
         if constexpr (eventHasQvector) {
-          VarManager::FillPairVn<TPairType>(t1, t2);
+          VarManager::FillPairVn<TPairType>(t1, t2, values);
         }
       }
-
+    };
+    auto fillPairOutputs = [&](auto const& t1, auto const& t2, uint32_t twoTrackFilter, float* values) {
       // TODO: provide the type of pair to the dilepton table (e.g. ee, mumu, emu...)
       dileptonFilterMap = twoTrackFilter;
-      dileptonList(event, VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt], VarManager::fgValues[VarManager::kEta], VarManager::fgValues[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
+      dileptonList(event, values[VarManager::kMass], values[VarManager::kPt], values[VarManager::kEta], values[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
 
       constexpr bool muonHasCov = ((TTrackFillMap & VarManager::ObjTypes::MuonCov) > 0 || (TTrackFillMap & VarManager::ObjTypes::ReducedMuonCov) > 0);
       if constexpr ((TPairType == pairTypeMuMu) && muonHasCov) {
-        dileptonExtraList(t1.globalIndex(), t2.globalIndex(), VarManager::fgValues[VarManager::kVertexingTauz], VarManager::fgValues[VarManager::kVertexingLz], VarManager::fgValues[VarManager::kVertexingLxy]);
+        dileptonExtraList(t1.globalIndex(), t2.globalIndex(), values[VarManager::kVertexingTauz], values[VarManager::kVertexingLz], values[VarManager::kVertexingLxy]);
       }
 
       if constexpr (eventHasQvector) {
-        dileptonFlowList(VarManager::fgValues[VarManager::kU2Q2], VarManager::fgValues[VarManager::kU3Q3], VarManager::fgValues[VarManager::kCos2DeltaPhi], VarManager::fgValues[VarManager::kCos3DeltaPhi]);
-      }
-
-      for (unsigned int icut = 0; icut < ncuts; icut++) {
-        if (twoTrackFilter & (uint32_t(1) << icut)) {
-          if (t1.sign() * t2.sign() < 0) {
-            fHistMan->FillHistClass(histNames[icut][0].Data(), VarManager::fgValues);
-          } else {
-            if (t1.sign() > 0) {
-              fHistMan->FillHistClass(histNames[icut][1].Data(), VarManager::fgValues);
-            } else {
-              fHistMan->FillHistClass(histNames[icut][2].Data(), VarManager::fgValues);
-            }
-          }
-        } // end if (filter bits)
-      }   // end for (cuts)
-    }     // end loop over pairs
+        dileptonFlowList(values[VarManager::kU2Q2], values[VarManager::kU3Q3], values[VarManager::kCos2DeltaPhi], values[VarManager::kCos3DeltaPhi]);
+      }
+
+      const int histIdx = (t1.sign() * t2.sign() < 0) ? 0 : (t1.sign() > 0 ? 1 : 2);
+      // loop over the set bits only, in increasing order
+      for (uint32_t cutBits = twoTrackFilter; cutBits != 0; cutBits &= (cutBits - 1)) {
+        const unsigned int icut = __builtin_ctz(cutBits);
+        if (icut >= ncuts) {
+          break;
+        }
+        fHistMan->FillHistClass((*histNames)[icut][histIdx].Data(), values);
+      } // end for (cuts)
+    };
+
+    if (fPairContexts.empty()) {
+      for (auto& [t1, t2] : combinations(tracks1, tracks2)) {
+        const uint32_t twoTrackFilter = pairFilter(t1, t2);
+        if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
+          continue;
+        }
+        fillPairValues(t1, t2, VarManager::fgValues);
+        fillPairOutputs(t1, t2, twoTrackFilter, VarManager::fgValues);
+      } // end loop over pairs
+      return;
+    }
+
+    // multi-threaded pairing: collect the pairs with at least one filter bit in common, then process them in chunks
+    std::vector<std::tuple<decltype(tracks1.begin()), decltype(tracks2.begin()), uint32_t>> pairs;
+    for (auto& [t1, t2] : combinations(tracks1, tracks2)) {
+      const uint32_t twoTrackFilter = pairFilter(t1, t2);
+      if (twoTrackFilter) {
+        pairs.emplace_back(t1, t2, twoTrackFilter);
+      }
+    }
+    for (size_t firstPair = 0; firstPair < pairs.size(); firstPair += kNPairsPerChunk) {
+      const size_t nPairs = std::min(kNPairsPerChunk, pairs.size() - firstPair);
+      fPairValues.resize(nPairs * VarManager::kNVars);
+      auto fillRange = [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i) {
+          float* values = &fPairValues[i * VarManager::kNVars];
+          std::copy(VarManager::fgValues, VarManager::fgValues + VarManager::kNVars, values); // event variables
+          fillPairValues(std::get<0>(pairs[firstPair + i]), std::get<1>(pairs[firstPair + i]), values);
+        }
+      };
+      auto fillRangeInContext = [&](VarManager::Context* pairContext, size_t first, size_t last) {
+        VarManager::SetThreadContext(pairContext);
+        fillRange(first, last);
+      };
+      const size_t nThreadsUsed = std::clamp<size_t>(nPairs / kNPairsPerThreadMin, 1, fPairContexts.size() + 1);
+      const size_t nPairsPerThread = (nPairs + nThreadsUsed - 1) / nThreadsUsed;
+      std::vector<std::thread> threads;
+      for (size_t iThread = 1; iThread < nThreadsUsed; ++iThread) {
+        const auto first = iThread * nPairsPerThread;
+        threads.emplace_back(fillRangeInContext, fPairContexts[iThread - 1].get(), first, std::min(nPairs, first + nPairsPerThread));
+      }
+      fillRange(0, std::min(nPairs, nPairsPerThread));
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      for (size_t i = 0; i < nPairs; ++i) {
+        const auto& [t1, t2, twoTrackFilter] = pairs[firstPair + i];
+        fillPairOutputs(t1, t2, twoTrackFilter, &fPairValues[i * VarManager::kNVars]);
+      }
+    } // end loop over chunks
   }
 
   void processJpsiToEESkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelected> const& tracks)
@@ -781,6 +1012,13 @@ struct AnalysisSameEventPairing {
     VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
     runSameEventPairing<VarManager::kJpsiToEE, gkEventFillMap, gkTrackFillMap>(event, tracks, tracks);
   }
+  void processJpsiToEESkimmedCompact(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelectedCompact> const& tracks)
+  {
+    // Reset the fValues array
+    VarManager::ResetValues(0, VarManager::kNVars);
+    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    runSameEventPairing<VarManager::kJpsiToEE, gkEventFillMap, gkTrackFillMap>(event, tracks, tracks);
+  }
   void processJpsiToMuMuSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyMuonTracksSelected> const& muons)
   {
     // Reset the fValues array
@@ -832,6 +1070,7 @@ struct AnalysisSameEventPairing {
   }
 
   PROCESS_SWITCH(AnalysisSameEventPairing, processJpsiToEESkimmed, "Run electron-electron pairing, with skimmed tracks", false);
+  PROCESS_SWITCH(AnalysisSameEventPairing, processJpsiToEESkimmedCompact, "Run electron-electron pairing, with skimmed tracks with the compact PID table", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processJpsiToMuMuSkimmed, "Run muon-muon pairing, with skimmed muons", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processJpsiToMuMuVertexingSkimmed, "Run muon-muon pairing and vertexing, with skimmed muons", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processVnJpsiToEESkimmed, "Run electron-electron pairing, with skimmed tracks for vn", false);
@@ -857,6 +1096,8 @@ struct AnalysisDileptonHadron {
   // TODO: For now this is only used to determine the position in the filter bit map for the hadron cut
   Configurable<string> fConfigTrackCuts{"cfgLeptonCuts", "", "Comma separated list of barrel track cuts"};
   Filter eventFilter = aod::dqanalysisflags::isEventSelected == 1;
+  Configurable<float> fConfigMaxHadronDistance{"cfgMaxHadronDistance", -1.0f, "Max. distance (cm) between the hadron, as a straight line, and the dilepton vertex for the triplet vertexing, no preselection if negative"};
+  Configurable<int> fConfigNThreads{"cfgNThreads", 1, "Max. number of threads computing the dilepton-hadron vertexing of a dilepton"};
   Filter dileptonFilter = aod::reducedpair::mass > 2.92f && aod::reducedpair::mass < 3.16f && aod::reducedpair::sign == 0;
 
   constexpr static uint32_t fgDileptonFillMap = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::Pair; // fill map
@@ -871,6 +1112,12 @@ struct AnalysisDileptonHadron {
   //      The current condition should be replaced when bitwise operators will become available in Filter expresions
   int fNHadronCutBit;
 
+  static constexpr size_t kNHadronsPerThreadMin = 8; // below this, 3-prong fits are not worth a thread
+  static constexpr size_t kNHadronsPerChunk = 1024;  // limits the memory of the triplet values arrays
+  std::vector<std::unique_ptr<VarManager::Context>> fTripletContexts; // contexts of the worker threads
+  std::vector<int64_t> fHadrons;                                      // hadrons of the current dilepton, as positions in the event tracks
+  std::vector<float> fTripletValues;                                  // values of the triplets of the current chunk
+
   void init(o2::framework::InitContext& context)
   {
     fValuesDilepton = new float[VarManager::kNVars];
@@ -882,12 +1129,29 @@ struct AnalysisDileptonHadron {
 
     // TODO: Create separate histogram directories for each selection used in the creation of the dileptons
     // TODO: Implement possibly multiple selections for the associated track ?
-    if (context.mOptions.get<bool>("processSkimmed")) {
-      DefineHistograms(fHistMan, "DileptonsSelected;DileptonHadronInvMass;DileptonHadronCorrelation"); // define all histograms
+    bool isBarrelVertexing = context.mOptions.get<bool>("processBtoJpsiEEKSkimmed");
+    if (context.mOptions.get<bool>("processSkimmed") || isBarrelVertexing) {
+      TString histNames = "DileptonsSelected;DileptonHadronInvMass;DileptonHadronCorrelation";
+      if (isBarrelVertexing) {
+        histNames += ";DileptonTrackInvMass";
+      }
+      DefineHistograms(fHistMan, histNames.Data()); // define all histograms
       VarManager::SetUseVars(fHistMan->GetUsedVars());
       fOutputList.setObject(fHistMan->GetMainHistogramList());
     }
 
+    if (isBarrelVertexing) {
+      VarManager::SetupTwoProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true); // TODO: get these parameters from Configurables
+      VarManager::SetupThreeProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true);
+      // the fitters of the worker threads are configured as the ones of the default context
+      for (int iThread = 1; iThread < fConfigNThreads.value; iThread++) {
+        fTripletContexts.push_back(std::make_unique<VarManager::Context>());
+        VarManager::SetThreadContext(fTripletContexts.back().get());
+        VarManager::SetupThreeProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true);
+      }
+      VarManager::SetThreadContext(nullptr);
+    }
+
     TString configCutNamesStr = fConfigTrackCuts.value;
     if (!configCutNamesStr.IsNull()) {
       std::unique_ptr<TObjArray> objArray(configCutNamesStr.Tokenize(","));
@@ -924,17 +1188,109 @@ struct AnalysisDileptonHadron {
     }
   }
 
+  // Template function to run dilepton - hadron combinations with the vertexing of the triplet (e.g. B -> Jpsi + K)
+  //   The dilepton vertex is fitted once and reused for all its hadrons, which can be preselected by their distance to it.
+  //   The 3-prong fits of the hadrons of a dilepton are shared between threads, the histograms are filled serially.
+  template <uint32_t TEventFillMap, uint32_t TTrackFillMap, typename TEvent, typename TTracks, typename TDileptons>
+  void runDileptonHadronVertexing(TEvent const& event, TTracks const& tracks, TDileptons const& dileptons)
+  {
+    VarManager::ResetValues(0, VarManager::kNVars, fValuesHadron);
+    VarManager::ResetValues(0, VarManager::kNVars, fValuesDilepton);
+    VarManager::FillEvent<TEventFillMap>(event, fValuesHadron);
+    VarManager::FillEvent<TEventFillMap>(event, fValuesDilepton);
+
+    for (auto dilepton : dileptons) {
+      VarManager::FillTrack<fgDileptonFillMap>(dilepton, fValuesDilepton);
+      fHistMan->FillHistClass("DileptonsSelected", fValuesDilepton);
+
+      auto lepton1 = tracks.rawIteratorAt(dilepton.index0Id() - tracks.offset());
+      auto lepton2 = tracks.rawIteratorAt(dilepton.index1Id() - tracks.offset());
+      std::array<float, 3> dileptonVertex = {event.posX(), event.posY(), event.posZ()};
+      const int dileptonProcCode = VarManager::FitDileptonVertex<VarManager::kBtoJpsiEEK, TTrackFillMap>(lepton1, lepton2, dileptonVertex);
+      const bool preselectHadrons = fConfigMaxHadronDistance.value > 0.0f && dileptonProcCode > 0;
+
+      fHadrons.clear();
+      for (auto& hadron : tracks) {
+        // TODO: Replace this with a Filter expression
+        if (!(uint32_t(hadron.isBarrelSelected()) & (uint32_t(1) << fNHadronCutBit))) {
+          continue;
+        }
+        if (hadron.globalIndex() == dilepton.index0Id() || hadron.globalIndex() == dilepton.index1Id()) {
+          continue;
+        }
+        if (preselectHadrons && VarManager::GetTrackDistanceToPoint<TTrackFillMap>(hadron, dileptonVertex) > fConfigMaxHadronDistance.value) {
+          continue;
+        }
+        fHadrons.push_back(hadron.globalIndex() - tracks.offset());
+      }
+
+      auto fillTripletValues = [&](int64_t iHadron, float* values) {
+        auto hadron = tracks.rawIteratorAt(iHadron);
+        VarManager::FillDileptonHadron(dilepton, hadron, values);
+        VarManager::FillDileptonTrackVertexing<VarManager::kBtoJpsiEEK, TEventFillMap, TTrackFillMap>(event, lepton1, lepton2, hadron, values, dileptonProcCode);
+      };
+      auto fillTripletOutputs = [&](float* values) {
+        fHistMan->FillHistClass("DileptonHadronInvMass", values);
+        fHistMan->FillHistClass("DileptonHadronCorrelation", values);
+        fHistMan->FillHistClass("DileptonTrackInvMass", values);
+      };
+
+      if (fTripletContexts.empty()) {
+        for (auto iHadron : fHadrons) {
+          fillTripletValues(iHadron, fValuesHadron);
+          fillTripletOutputs(fValuesHadron);
+        }
+        continue;
+      }
+
+      for (size_t firstHadron = 0; firstHadron < fHadrons.size(); firstHadron += kNHadronsPerChunk) {
+        const size_t nHadrons = std::min(kNHadronsPerChunk, fHadrons.size() - firstHadron);
+        fTripletValues.resize(nHadrons * VarManager::kNVars);
+        auto fillRange = [&](size_t first, size_t last) {
+          for (auto i = first; i < last; ++i) {
+            float* values = &fTripletValues[i * VarManager::kNVars];
+            std::copy(fValuesHadron, fValuesHadron + VarManager::kNVars, values); // event variables
+            fillTripletValues(fHadrons[firstHadron + i], values);
+          }
+        };
+        auto fillRangeInContext = [&](VarManager::Context* tripletContext, size_t first, size_t last) {
+          VarManager::SetThreadContext(tripletContext);
+          fillRange(first, last);
+        };
+        const size_t nThreadsUsed = std::clamp<size_t>(nHadrons / kNHadronsPerThreadMin, 1, fTripletContexts.size() + 1);
+        const size_t nHadronsPerThread = (nHadrons + nThreadsUsed - 1) / nThreadsUsed;
+        std::vector<std::thread> threads;
+        for (size_t iThread = 1; iThread < nThreadsUsed; ++iThread) {
+          const auto first = iThread * nHadronsPerThread;
+          threads.emplace_back(fillRangeInContext, fTripletContexts[iThread - 1].get(), first, std::min(nHadrons, first + nHadronsPerThread));
+        }
+        fillRange(0, std::min(nHadrons, nHadronsPerThread));
+        for (auto& thread : threads) {
+          thread.join();
+        }
+
+        for (size_t i = 0; i < nHadrons; ++i) {
+          fillTripletOutputs(&fTripletValues[i * VarManager::kNVars]);
+        }
+      } // end loop over chunks
+    }   // end loop over dileptons
+  }
+
   void processSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, MyBarrelTracksSelected const& tracks, soa::Filtered<aod::Dileptons> const& dileptons)
   {
     runDileptonHadron<gkEventFillMap>(event, tracks, dileptons);
   }
-  // TODO: Add process functions which use cov matrices for secondary vertexing (e.g. B->Jpsi + K)
+  void processBtoJpsiEEKSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, MyBarrelTracksSelectedWithCov const& tracks, soa::Filtered<soa::Join<aod::Dileptons, aod::DileptonsExtra>> const& dileptons)
+  {
+    runDileptonHadronVertexing<gkEventFillMapWithCov, gkTrackFillMapWithCov>(event, tracks, dileptons);
+  }
   void processDummy(MyEvents&)
   {
     // do nothing
   }
 
   PROCESS_SWITCH(AnalysisDileptonHadron, processSkimmed, "Run dilepton-hadron pairing, using skimmed data", false);
+  PROCESS_SWITCH(AnalysisDileptonHadron, processBtoJpsiEEKSkimmed, "Run dilepton-hadron pairing with the triplet vertexing (B -> Jpsi + K), using skimmed data with covariances", false);
   PROCESS_SWITCH(AnalysisDileptonHadron, processDummy, "Dummy function", false);
 };
 
@@ -999,6 +1355,10 @@ void DefineHistograms(HistogramManager* histMan, TString histClasses)
       dqhistograms::DefineHistograms(histMan, objArray->At(iclass)->GetName(), "dilepton-hadron-mass");
     }
 
+    if (classStr.Contains("DileptonTrackInvMass")) {
+      dqhistograms::DefineHistograms(histMan, objArray->At(iclass)->GetName(), "dilepton-track-mass");
+    }
+
     if (classStr.Contains("DileptonHadronCorrelation")) {
       dqhistograms::DefineHistograms(histMan, objArray->At(iclass)->GetName(), "dilepton-hadron-correlation");
     }
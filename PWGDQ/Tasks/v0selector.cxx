@@ -24,6 +24,7 @@
 #include "ReconstructionDataFormats/Track.h"
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "PWGEM/PhotonMeson/DataModel/gammaTables.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
@@ -300,7 +301,172 @@ struct v0selector {
     }
   }
 
-  void process(aod::Collisions const&, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, aod::V0s const& V0s, aod::Cascades const& Cascades)
+  // track quality of the V0 and cascade daughters
+  template <typename TTrack>
+  bool isSelectedDaughter(TTrack const& track)
+  {
+    return track.tpcNClsCrossedRows() >= mincrossedrows && track.tpcChi2NCl() <= maxchi2tpc;
+  }
+
+  // topological, Armenteros-Podolanski and PID selection of a V0 candidate, shared by the refit and the V0Datas modes
+  //   ppos and pneg are the momenta of the positive and negative daughters at the V0 vertex;
+  //   gammaRadius is the conversion radius used for the photon candidates, if a refined conversion point is available
+  template <typename TTrack>
+  void selectV0(std::map<int, uint8_t>& pidmap, TTrack const& posTrack, TTrack const& negTrack, int posTrackId, int negTrackId,
+                const array<float, 3>& ppos, const array<float, 3>& pneg, int cpos, int cneg, float V0dca, double V0CosinePA, float V0radius, float gammaRadius)
+  {
+    auto px = ppos[0] + pneg[0];
+    auto py = ppos[1] + pneg[1];
+    auto pz = ppos[2] + pneg[2];
+    auto pt = RecoDecay::sqrtSumOfSquares(px, py);
+    auto eta = RecoDecay::eta(array{px, py, pz});
+    auto phi = RecoDecay::phi(px, py);
+
+    registry.fill(HIST("hV0Pt"), pt);
+    registry.fill(HIST("hV0EtaPhi"), phi, eta);
+    registry.fill(HIST("hDCAxyPosToPV"), posTrack.dcaXY());
+    registry.fill(HIST("hDCAxyNegToPV"), negTrack.dcaXY());
+
+    registry.fill(HIST("hV0Radius"), V0radius);
+    registry.fill(HIST("hV0CosPA"), V0CosinePA);
+    registry.fill(HIST("hDCAV0Dau"), V0dca);
+
+    if (V0dca > dcav0dau) {
+      return;
+    }
+
+    if (V0CosinePA < v0cospa) {
+      return;
+    }
+
+    int v0id = checkV0(ppos, pneg);
+    float radius = v0id == kGamma ? gammaRadius : V0radius;
+    if (radius < v0Rmin || v0Rmax < radius) {
+      return;
+    }
+
+    float alpha = alphav0(ppos, pneg);
+    float qtarm = qtarmv0(ppos, pneg);
+    float phiv = phivv0(ppos, pneg, cpos, cneg, d_bz);
+    float psipair = psipairv0(ppos, pneg, d_bz);
+
+    registry.fill(HIST("hV0APplot"), alpha, qtarm);
+    registry.fill(HIST("hV0PhiV"), phiv);
+    registry.fill(HIST("hV0Psi"), psipair);
+
+    float mGamma = RecoDecay::m(array{ppos, pneg}, array{RecoDecay::getMassPDG(kElectron), RecoDecay::getMassPDG(kElectron)});
+    float mK0S = RecoDecay::m(array{ppos, pneg}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kPiPlus)});
+    float mLambda = RecoDecay::m(array{ppos, pneg}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
+    float mAntiLambda = RecoDecay::m(array{ppos, pneg}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
+
+    registry.fill(HIST("hMassGamma"), mGamma);
+    registry.fill(HIST("hMassK0S"), mK0S);
+    registry.fill(HIST("hMassLambda"), mLambda);
+    registry.fill(HIST("hMassAntiLambda"), mAntiLambda);
+
+    if (v0id < 0) {
+      // printf("This is not [Gamma/K0S/Lambda/AntiLambda] candidate.\n");
+      return;
+    }
+
+    if (v0id == kGamma && mGamma < 0.04 && TMath::Abs(posTrack.tpcNSigmaEl()) < 10 && TMath::Abs(negTrack.tpcNSigmaEl()) < 10) { // photon conversion
+      pidmap[posTrackId] |= (uint8_t(1) << kGamma);
+      pidmap[negTrackId] |= (uint8_t(1) << kGamma);
+      // printf("This is photon candidate.\n");
+    } else if (v0id == kK0S && (0.49 < mK0S && mK0S < 0.51) && TMath::Abs(posTrack.tpcNSigmaPi()) < 10 && TMath::Abs(negTrack.tpcNSigmaPi()) < 10) { // K0S-> pi pi
+      pidmap[posTrackId] |= (uint8_t(1) << kK0S);
+      pidmap[negTrackId] |= (uint8_t(1) << kK0S);
+      // printf("This is K0S candidate.\n");
+    } else if (v0id == kLambda && (1.112 < mLambda && mLambda < 1.120) && TMath::Abs(posTrack.tpcNSigmaPr()) < 10 && TMath::Abs(negTrack.tpcNSigmaPi()) < 10) { // L->p + pi-
+      pidmap[posTrackId] |= (uint8_t(1) << kLambda);
+      pidmap[negTrackId] |= (uint8_t(1) << kLambda);
+      // printf("This is Lambda candidate.\n");
+    } else if (v0id == kAntiLambda && (1.112 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(posTrack.tpcNSigmaPi()) < 10 && TMath::Abs(negTrack.tpcNSigmaPr()) < 10) { // Lbar -> pbar + pi+
+      pidmap[posTrackId] |= (uint8_t(1) << kAntiLambda);
+      pidmap[negTrackId] |= (uint8_t(1) << kAntiLambda);
+      // printf("This is Anti-Lambda candidate.\n");
+    }
+  }
+
+  // selection of an Omega candidate, shared by the refit and the CascData modes; the bachelor is tagged
+  //   pvecpos and pvecneg are the momenta of the V0 daughters at the V0 vertex, pvecbach the one of the bachelor at the cascade vertex
+  template <typename TTrack>
+  void selectCascade(std::map<int, uint8_t>& pidmap, TTrack const& posTrack, TTrack const& negTrack, TTrack const& bachelor, int bachelorId,
+                     const array<float, 3>& pvecpos, const array<float, 3>& pvecneg, const array<float, 3>& pvecbach, int cpos, int cneg,
+                     const array<float, 3>& pVtx, const array<float, 3>& v0vtx, const array<float, 3>& cascvtx, float V0dca, float Cascdca)
+  {
+    registry.fill(HIST("hCascCandidate"), 1.5);
+    registry.fill(HIST("hDCAV0Dau_Casc"), V0dca);
+    // if (V0dca > 1.0) {
+    //   return;
+    // }
+
+    const std::array<float, 3> pvecv0 = {pvecpos[0] + pvecneg[0], pvecpos[1] + pvecneg[1], pvecpos[2] + pvecneg[2]};
+    auto V0CosinePA = RecoDecay::cpa(pVtx, v0vtx, pvecv0);
+    registry.fill(HIST("hV0CosPA_Casc"), V0CosinePA);
+    // if (V0CosinePA < 0.97) {
+    //   return;
+    // }
+
+    registry.fill(HIST("hCascCandidate"), 2.5);
+    registry.fill(HIST("hDCACascDau"), Cascdca);
+    // if (Cascdca > 1.0) {
+    //   return;
+    // }
+
+    auto CascCosinePA = RecoDecay::cpa(pVtx, cascvtx, pvecbach);
+    registry.fill(HIST("hCascCosPA"), CascCosinePA);
+    // if(CascCosinePA < 0.998){
+    //   return;
+    // }
+
+    float mLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
+    float mAntiLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
+    float mXi = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kPiPlus)});
+    float mOmega = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kKPlus)});
+    registry.fill(HIST("hMassLambda_Casc"), mLambda);
+    registry.fill(HIST("hMassAntiLambda_Casc"), mAntiLambda);
+
+    // for Lambda->p + pi-
+    if (cpos > 0 && cneg < 0 && (1.112 < mLambda && mLambda < 1.120) && TMath::Abs(posTrack.tpcNSigmaPr()) < 10 && TMath::Abs(negTrack.tpcNSigmaPi()) < 10) {
+
+      if (bachelor.sign() < 0) {
+
+        if (TMath::Abs(bachelor.tpcNSigmaPi()) < 10) {
+          registry.fill(HIST("hMassXiMinus"), mXi);
+        }
+
+        if (TMath::Abs(mXi - 1.321) > 0.006) {
+          if (TMath::Abs(bachelor.tpcNSigmaKa()) < 10) {
+            registry.fill(HIST("hMassOmegaMinus"), mOmega);
+            if (TMath::Abs(mOmega - 1.672) < 0.006) {
+              pidmap[bachelorId] |= (uint8_t(1) << kOmega);
+            }
+          }
+        }
+      }
+    }
+
+    // for AntiLambda->pbar + pi+
+    if (cpos > 0 && cneg < 0 && (1.112 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(posTrack.tpcNSigmaPi()) < 10 && TMath::Abs(negTrack.tpcNSigmaPr()) < 10) {
+      if (bachelor.sign() > 0) {
+        if (TMath::Abs(bachelor.tpcNSigmaPi()) < 10) {
+          registry.fill(HIST("hMassXiPlus"), mXi);
+        }
+        if (TMath::Abs(mXi - 1.321) > 0.006) {
+          if (TMath::Abs(bachelor.tpcNSigmaKa()) < 10) {
+            registry.fill(HIST("hMassOmegaPlus"), mOmega);
+            if (TMath::Abs(mOmega - 1.672) < 0.006) {
+              pidmap[bachelorId] |= (uint8_t(1) << kOmega);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // V0 and cascade candidates refitted with private DCA fitters, from aod::V0s and aod::Cascades
+  void processRefit(aod::Collisions const&, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, aod::V0s const& V0s, aod::Cascades const& Cascades)
   {
     registry.fill(HIST("hEventCounter"), 0.5);
 
@@ -316,17 +482,7 @@ struct v0selector {
 
       // printf("V0.collisionId = %d , collision.globalIndex = %d\n",V0.collisionId(),collision.globalIndex());
 
-      if (V0.posTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-      if (V0.negTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-
-      if (V0.posTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-      if (V0.negTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
+      if (!isSelectedDaughter(V0.posTrack_as<FullTracksExt>()) || !isSelectedDaughter(V0.negTrack_as<FullTracksExt>())) {
         continue;
       }
 
@@ -403,80 +559,11 @@ struct v0selector {
         continue;
       }
 
-      auto px = pvec0[0] + pvec1[0];
-      auto py = pvec0[1] + pvec1[1];
-      auto pz = pvec0[2] + pvec1[2];
-      auto pt = RecoDecay::sqrtSumOfSquares(pvec0[0] + pvec1[0], pvec0[1] + pvec1[1]);
-      auto eta = RecoDecay::eta(array{px, py, pz});
-      auto phi = RecoDecay::phi(px, py);
-
       auto V0dca = fitter.getChi2AtPCACandidate(); // distance between 2 legs.
-      auto V0CosinePA = RecoDecay::cpa(pVtx, array{pos[0], pos[1], pos[2]}, array{px, py, pz});
+      auto V0CosinePA = RecoDecay::cpa(pVtx, array{pos[0], pos[1], pos[2]}, array{pvec0[0] + pvec1[0], pvec0[1] + pvec1[1], pvec0[2] + pvec1[2]});
       auto V0radius = RecoDecay::sqrtSumOfSquares(pos[0], pos[1]);
 
-      registry.fill(HIST("hV0Pt"), pt);
-      registry.fill(HIST("hV0EtaPhi"), phi, eta);
-      registry.fill(HIST("hDCAxyPosToPV"), V0.posTrack_as<FullTracksExt>().dcaXY());
-      registry.fill(HIST("hDCAxyNegToPV"), V0.negTrack_as<FullTracksExt>().dcaXY());
-
-      registry.fill(HIST("hV0Radius"), V0radius);
-      registry.fill(HIST("hV0CosPA"), V0CosinePA);
-      registry.fill(HIST("hDCAV0Dau"), V0dca);
-
-      if (V0dca > dcav0dau) {
-        continue;
-      }
-
-      if (V0CosinePA < v0cospa) {
-        continue;
-      }
-
-      if (V0radius < v0Rmin || v0Rmax < V0radius) {
-        continue;
-      }
-
-      float alpha = alphav0(pvec0, pvec1);
-      float qtarm = qtarmv0(pvec0, pvec1);
-      float phiv = phivv0(pvec0, pvec1, cpos, cneg, d_bz);
-      float psipair = psipairv0(pvec0, pvec1, d_bz);
-
-      registry.fill(HIST("hV0APplot"), alpha, qtarm);
-      registry.fill(HIST("hV0PhiV"), phiv);
-      registry.fill(HIST("hV0Psi"), psipair);
-
-      float mGamma = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kElectron), RecoDecay::getMassPDG(kElectron)});
-      float mK0S = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kPiPlus)});
-      float mLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
-      float mAntiLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
-
-      registry.fill(HIST("hMassGamma"), mGamma);
-      registry.fill(HIST("hMassK0S"), mK0S);
-      registry.fill(HIST("hMassLambda"), mLambda);
-      registry.fill(HIST("hMassAntiLambda"), mAntiLambda);
-
-      int v0id = checkV0(pvec0, pvec1);
-      if (v0id < 0) {
-        // printf("This is not [Gamma/K0S/Lambda/AntiLambda] candidate.\n");
-        continue;
-      }
-
-      if (v0id == kGamma && mGamma < 0.04 && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaEl()) < 10 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaEl()) < 10) { // photon conversion
-        pidmap[V0.posTrackId()] |= (uint8_t(1) << kGamma);
-        pidmap[V0.negTrackId()] |= (uint8_t(1) << kGamma);
-        // printf("This is photon candidate.\n");
-      } else if (v0id == kK0S && (0.49 < mK0S && mK0S < 0.51) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10) { // K0S-> pi pi
-        pidmap[V0.posTrackId()] |= (uint8_t(1) << kK0S);
-        pidmap[V0.negTrackId()] |= (uint8_t(1) << kK0S);
-        // printf("This is K0S candidate.\n");
-      } else if (v0id == kLambda && (1.112 < mLambda && mLambda < 1.120) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPr()) < 10 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10) { // L->p + pi-
-        pidmap[V0.posTrackId()] |= (uint8_t(1) << kLambda);
-        pidmap[V0.negTrackId()] |= (uint8_t(1) << kLambda);
-        // printf("This is Lambda candidate.\n");
-      } else if (v0id == kAntiLambda && (1.112 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPr()) < 10) { // Lbar -> pbar + pi+
-        pidmap[V0.posTrackId()] |= (uint8_t(1) << kAntiLambda);
-        pidmap[V0.negTrackId()] |= (uint8_t(1) << kAntiLambda);
-        // printf("This is Anti-Lambda candidate.\n");
-      }
+      selectV0(pidmap, V0.posTrack_as<FullTracksExt>(), V0.negTrack_as<FullTracksExt>(), V0.posTrackId(), V0.negTrackId(), pvec0, pvec1, cpos, cneg, V0dca, V0CosinePA, V0radius, V0radius);
 
       // printf("posTrackId = %d\n",V0.posTrackId());
       // printf("negTrackId = %d\n",V0.negTrackId());
@@ -536,7 +623,6 @@ struct v0selector {
       fitterCasc.setMaxChi2(1e9);
       fitterCasc.setUseAbsDCA(true);
 
-      std::array<float, 3> pos = {0.};
       std::array<float, 3> pvecpos = {0.};
       std::array<float, 3> pvecneg = {0.};
       std::array<float, 3> pvecbach = {0.};
@@ -560,17 +646,8 @@ struct v0selector {
         continue;
       }
       const auto& v0vtx = fitterV0.getPCACandidate();
-      for (int i = 0; i < 3; i++) {
-        pos[i] = v0vtx[i];
-      }
-
       auto V0dca = fitterV0.getChi2AtPCACandidate(); // distance between 2 legs.
-      registry.fill(HIST("hDCAV0Dau_Casc"), V0dca);
-      // if (V0dca > 1.0) {
-      //   continue;
-      // }
 
-      registry.fill(HIST("hCascCandidate"), 1.5);
       std::array<float, 21> cov0 = {0};
       std::array<float, 21> cov1 = {0};
       std::array<float, 21> covV0 = {0};
@@ -597,11 +674,6 @@ struct v0selector {
       std::array<float, 3> pVtx = {collision.posX(), collision.posY(), collision.posZ()};
       const std::array<float, 3> vertex = {(float)v0vtx[0], (float)v0vtx[1], (float)v0vtx[2]};
       const std::array<float, 3> pvecv0 = {pvecpos[0] + pvecneg[0], pvecpos[1] + pvecneg[1], pvecpos[2] + pvecneg[2]};
-      auto V0CosinePA = RecoDecay::cpa(pVtx, array{pos[0], pos[1], pos[2]}, pvecv0);
-      registry.fill(HIST("hV0CosPA_Casc"), V0CosinePA);
-      // if (V0CosinePA < 0.97) {
-      //   continue;
-      // }
 
       auto tV0 = o2::track::TrackParCov(vertex, pvecv0, covV0, 0);
       tV0.setQ2Pt(0); // No bending, please
@@ -610,74 +682,98 @@ struct v0selector {
         fitterCasc.propagateTracksToVertex();
         fitterCasc.getTrack(1).getPxPyPzGlo(pvecbach);
       } else {
+        registry.fill(HIST("hCascCandidate"), 1.5);
+        registry.fill(HIST("hDCAV0Dau_Casc"), V0dca);
+        registry.fill(HIST("hV0CosPA_Casc"), RecoDecay::cpa(pVtx, vertex, pvecv0));
         continue;
       }
-      registry.fill(HIST("hCascCandidate"), 2.5);
 
       auto Cascdca = fitterCasc.getChi2AtPCACandidate(); // distance between V0 and bachelor
-      registry.fill(HIST("hDCACascDau"), Cascdca);
-      // if (Cascdca > 1.0) {
-      //   continue;
-      // }
-
       const auto& cascvtx = fitterCasc.getPCACandidate();
-      auto CascCosinePA = RecoDecay::cpa(pVtx, array{cascvtx[0], cascvtx[1], cascvtx[2]}, pvecbach);
-      registry.fill(HIST("hCascCosPA"), CascCosinePA);
-      // if(CascCosinePA < 0.998){
-      //   continue;
-      // }
+      selectCascade(pidmap, casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>(), casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>(), casc.bachelor_as<FullTracksExt>(), casc.bachelorId(),
+                    pvecpos, pvecneg, pvecbach, cpos, cneg, pVtx, vertex, array{(float)cascvtx[0], (float)cascvtx[1], (float)cascvtx[2]}, V0dca, Cascdca);
+    } // end of cascades loop
 
-      float mLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
-      float mAntiLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
-      float mXi = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kPiPlus)});
-      float mOmega = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kKPlus)});
-      registry.fill(HIST("hMassLambda_Casc"), mLambda);
-      registry.fill(HIST("hMassAntiLambda_Casc"), mAntiLambda);
+    for (auto& track : tracks) {
+      // printf("setting pidmap[%lld] = %d\n",track.globalIndex(),pidmap[track.globalIndex()]);
+      v0bits(pidmap[track.globalIndex()]);
+    } // end of track loop
 
-      // for Lambda->p + pi-
-      if (cpos > 0 && cneg < 0 && (1.112 < mLambda && mLambda < 1.120) && TMath::Abs(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>().tpcNSigmaPr()) < 10 && TMath::Abs(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10) {
+  } // end of process
+  PROCESS_SWITCH(v0selector, processRefit, "Refit the V0 and cascade candidates from aod::V0s and aod::Cascades", true);
 
-        if (casc.bachelor_as<FullTracksExt>().sign() < 0) {
+  // V0 and cascade candidates of lambdakzeroBuilder and cascadeBuilder: only the selections of this task are applied, on top of the ones of the builders
+  //   The cuts on the DCA of the daughters to the PV use the DCAs stored by the builder, and are applied as a filter on the V0 table
+  Filter v0DaughterDCAFilter = nabs(aod::v0data::dcapostopv) >= dcamin && nabs(aod::v0data::dcanegtopv) >= dcamin && nabs(aod::v0data::dcapostopv) <= dcamax && nabs(aod::v0data::dcanegtopv) <= dcamax;
 
-          if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaPi()) < 10) {
-            registry.fill(HIST("hMassXiMinus"), mXi);
-          }
+  template <bool TRecalculatedVtx, typename TV0s>
+  void runV0Datas(aod::Collisions const& collisions, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, TV0s const& V0s, aod::CascDataExt const& cascades)
+  {
+    registry.fill(HIST("hEventCounter"), 0.5);
 
-          if (TMath::Abs(mXi - 1.321) > 0.006) {
-            if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaKa()) < 10) {
-              registry.fill(HIST("hMassOmegaMinus"), mOmega);
-              if (TMath::Abs(mOmega - 1.672) < 0.006) {
-                pidmap[casc.bachelorId()] |= (uint8_t(1) << kOmega);
-              }
-            }
-          }
-        }
+    std::map<int, uint8_t> pidmap;
+
+    for (auto& V0 : V0s) {
+      auto posTrack = V0.template posTrack_as<FullTracksExt>();
+      auto negTrack = V0.template negTrack_as<FullTracksExt>();
+      if (!isSelectedDaughter(posTrack) || !isSelectedDaughter(negTrack)) {
+        continue;
+      }
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
+        continue;
       }
+      auto collision = collisions.rawIteratorAt(V0.collisionId());
+      auto bc = collision.template bc_as<aod::BCsWithTimestamps>();
+      CheckAndUpdate(bc.runNumber(), bc.timestamp());
+      registry.fill(HIST("hV0Candidate"), 0.5);
 
-      // for AntiLambda->pbar + pi+
-      if (cpos > 0 && cneg < 0 && (1.112 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 10 && TMath::Abs(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>().tpcNSigmaPr()) < 10) {
-        if (casc.bachelor_as<FullTracksExt>().sign() > 0) {
-          if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaPi()) < 10) {
-            registry.fill(HIST("hMassXiPlus"), mXi);
-          }
-          if (TMath::Abs(mXi - 1.321) > 0.006) {
-            if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaKa()) < 10) {
-              registry.fill(HIST("hMassOmegaPlus"), mOmega);
-              if (TMath::Abs(mOmega - 1.672) < 0.006) {
-                pidmap[casc.bachelorId()] |= (uint8_t(1) << kOmega);
-              }
-            }
-          }
-        }
+      const std::array<float, 3> pVtx = {collision.posX(), collision.posY(), collision.posZ()};
+      const std::array<float, 3> pvec0 = {V0.pxpos(), V0.pypos(), V0.pzpos()};
+      const std::array<float, 3> pvec1 = {V0.pxneg(), V0.pyneg(), V0.pzneg()};
+      auto V0CosinePA = RecoDecay::cpa(pVtx, array{V0.x(), V0.y(), V0.z()}, array{pvec0[0] + pvec1[0], pvec0[1] + pvec1[1], pvec0[2] + pvec1[2]});
+      float gammaRadius = V0.v0radius();
+      if constexpr (TRecalculatedVtx) {
+        gammaRadius = V0.recalculatedVtxR();
+      }
+      selectV0(pidmap, posTrack, negTrack, V0.posTrackId(), V0.negTrackId(), pvec0, pvec1, posTrack.sign(), negTrack.sign(), V0.dcaV0daughters(), V0CosinePA, V0.v0radius(), gammaRadius);
+    } // end of V0 loop
+
+    for (auto& casc : cascades) {
+      registry.fill(HIST("hCascCandidate"), 0.5);
+      auto v0 = casc.template v0_as<aod::V0s>();
+      auto posTrack = v0.template posTrack_as<FullTracksExt>();
+      auto negTrack = v0.template negTrack_as<FullTracksExt>();
+      auto bachelor = casc.template bachelor_as<FullTracksExt>();
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
+        continue;
       }
+      if (posTrack.tpcNClsCrossedRows() < mincrossedrows || negTrack.tpcNClsCrossedRows() < mincrossedrows || bachelor.tpcNClsCrossedRows() < mincrossedrows) {
+        continue;
+      }
+      auto collision = collisions.rawIteratorAt(casc.collisionId());
+      const std::array<float, 3> pVtx = {collision.posX(), collision.posY(), collision.posZ()};
+      selectCascade(pidmap, posTrack, negTrack, bachelor, casc.bachelorId(),
+                    array{casc.pxpos(), casc.pypos(), casc.pzpos()}, array{casc.pxneg(), casc.pyneg(), casc.pzneg()}, array{casc.pxbach(), casc.pybach(), casc.pzbach()},
+                    posTrack.sign(), negTrack.sign(), pVtx, array{casc.xlambda(), casc.ylambda(), casc.zlambda()}, array{casc.x(), casc.y(), casc.z()},
+                    casc.dcaV0daughters(), casc.dcacascdaughters());
     } // end of cascades loop
 
     for (auto& track : tracks) {
-      // printf("setting pidmap[%lld] = %d\n",track.globalIndex(),pidmap[track.globalIndex()]);
       v0bits(pidmap[track.globalIndex()]);
     } // end of track loop
+  }
 
-  } // end of process
+  void processV0Datas(aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs, FullTracksExt const& tracks, soa::Filtered<aod::V0Datas> const& V0s, aod::CascDataExt const& cascades)
+  {
+    runV0Datas<false>(collisions, bcs, tracks, V0s, cascades);
+  }
+  PROCESS_SWITCH(v0selector, processV0Datas, "Select the V0 and cascade candidates of lambdakzeroBuilder and cascadeBuilder, without refit", false);
+
+  void processV0DatasRecalculatedVtx(aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs, FullTracksExt const& tracks, soa::Filtered<soa::Join<aod::V0Datas, aod::V0Recalculated>> const& V0s, aod::CascDataExt const& cascades)
+  {
+    runV0Datas<true>(collisions, bcs, tracks, V0s, cascades);
+  }
+  PROCESS_SWITCH(v0selector, processV0DatasRecalculatedVtx, "As processV0Datas, with the conversion point of skimmerGammaConversions for the photon radius cut", false);
 };
 
 struct trackPIDQA {
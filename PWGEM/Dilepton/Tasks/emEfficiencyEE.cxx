@@ -25,11 +25,14 @@
 #include "PWGDQ/Core/CutsLibrary.h"
 #include "PWGDQ/Core/MCSignal.h"
 #include "PWGDQ/Core/MCSignalLibrary.h"
+#include "PWGDQ/Core/MCSignalMatcher.h"
+#include "PWGEM/Dilepton/Utils/MomentumSmearing.h"
 #include <TMath.h>
 #include <TH1F.h>
 #include <THashList.h>
 #include <TLorentzVector.h>
 #include <TString.h>
+#include <cmath>
 #include <iostream>
 #include <vector>
 
@@ -74,6 +77,64 @@ constexpr static uint32_t gkParticleMCFillMap = VarManager::ObjTypes::ParticleMC
 void DefineHistograms(HistogramManager* histMan, TString histClasses);
 void SetBinsLinear(std::vector<double>& fBins, const double min, const double max, const unsigned int steps);
 
+// Four-vectors of the legs of an event in SoA layout, for the pair loops
+struct LegKinematics {
+  std::vector<double> fPx;
+  std::vector<double> fPy;
+  std::vector<double> fPz;
+  std::vector<double> fE;
+  std::vector<uint8_t> fFiducial;
+
+  void clear()
+  {
+    fPx.clear();
+    fPy.clear();
+    fPz.clear();
+    fE.clear();
+    fFiducial.clear();
+  }
+  void add(double pt, double eta, double phi, double mass, bool fiducial)
+  {
+    const double pz = pt * std::sinh(eta);
+    fPx.push_back(pt * std::cos(phi));
+    fPy.push_back(pt * std::sin(phi));
+    fPz.push_back(pz);
+    fE.push_back(std::sqrt(pt * pt + pz * pz + mass * mass));
+    fFiducial.push_back(fiducial);
+  }
+  // invariant mass and transverse momentum of the pair of legs i and j
+  void pair(size_t i, size_t j, double& mass, double& pt) const
+  {
+    const double px = fPx[i] + fPx[j];
+    const double py = fPy[i] + fPy[j];
+    const double pz = fPz[i] + fPz[j];
+    const double e = fE[i] + fE[j];
+    const double m2 = e * e - px * px - py * py - pz * pz;
+    mass = m2 > 0. ? std::sqrt(m2) : 0.;
+    pt = std::sqrt(px * px + py * py);
+  }
+};
+
+// Electron legs of an event: the kinematics and the decisions of the track cuts and of the MC signal prongs are
+// computed once per leg, so that the pair loops only AND bit maps
+struct DielectronLegs {
+  LegKinematics fKinematics;
+  LegKinematics fSmearedKinematics; // generated legs smeared with the parametrized resolution
+  std::vector<int> fSign;
+  std::vector<uint32_t> fCuts;
+  std::vector<MCSignalMatcher::Leg> fMC;
+
+  size_t size() const { return fSign.size(); }
+  void clear()
+  {
+    fKinematics.clear();
+    fSmearedKinematics.clear();
+    fSign.clear();
+    fCuts.clear();
+    fMC.clear();
+  }
+};
+
 struct AnalysisEventSelection {
 
   Produces<aod::EventCuts> eventSel;
@@ -735,6 +796,15 @@ struct AnalysisSameEventPairing {
   Configurable<double> fConfigMaxEta{"cfgMaxEta", 0.8, "Fiducial max eta for MC signal"};
   Configurable<bool> fConfigFlatTables{"cfgFlatTables", false, "Produce a single flat tables with all relevant information of the pairs and single tracks"};
 
+  // Parametrized smearing of the generated legs
+  Configurable<bool> fConfigSmearing{"cfgSmearing", false, "If true, fill the generated+smeared pairs with the parametrized resolution"};
+  Configurable<std::vector<float>> fConfigSmearingPt{"cfgSmearingPt", std::vector<float>{0.1f, 1.f, 10.f}, "pT points of the resolution parametrization (GeV/c), linearly interpolated"};
+  Configurable<std::vector<float>> fConfigSmearingResPt{"cfgSmearingResPt", std::vector<float>{0.02f, 0.01f, 0.03f}, "Relative pT resolution at the pT points"};
+  Configurable<std::vector<float>> fConfigSmearingResEta{"cfgSmearingResEta", std::vector<float>{0.004f, 0.002f, 0.001f}, "Eta resolution at the pT points"};
+  Configurable<std::vector<float>> fConfigSmearingResPhi{"cfgSmearingResPhi", std::vector<float>{0.01f, 0.004f, 0.001f}, "Phi resolution at the pT points (rad)"};
+  Configurable<int> fConfigSmearingBins{"cfgSmearingBins", 1000, "Number of pT bins of the smearing lookup table"};
+  Configurable<int> fConfigSmearingSeed{"cfgSmearingSeed", 0, "Seed of the smearing random numbers"};
+
   // TODO: here we specify signals, however signal decisions are precomputed and stored in mcReducedFlags
   // TODO: The tasks based on skimmed MC could/should rely ideally just on these flags
   // TODO:   special AnalysisCuts to be prepared in this direction
@@ -758,6 +828,13 @@ struct AnalysisSameEventPairing {
   // AnalysisCompositeCut* fEventCut; // Taken from event selection part
   std::vector<AnalysisCompositeCut> fTrackCuts; // list of track cuts
   std::vector<MCSignal> fMCSignals;             // list of signals with one prong to be checked: ULS 2D histos
+  MCSignalMatcher fMCSignalMatcher;             // prong decisions of the signals computed once per leg
+  uint32_t fUncompiledMCSignals = 0;            // signals checked per pair with MCSignal::CheckSignal()
+
+  // Legs of the current event and smearing
+  DielectronLegs fGenLegs;
+  DielectronLegs fRecLegs;
+  o2::pwgem::dilepton::MomentumSmearing fSmearing;
 
   // 2D histo vectors
   std::vector<TH2D*> fHistGenPair;
@@ -818,6 +895,14 @@ struct AnalysisSameEventPairing {
         // List of signal to be checked
       }
     }
+    for (auto& sig : fMCSignals) {
+      fMCSignalMatcher.AddSignal(&sig);
+    }
+    fUncompiledMCSignals = fMCSignalMatcher.GetUncompiledSignals(2);
+
+    if (fConfigSmearing && !fSmearing.Init(fConfigSmearingPt.value, fConfigSmearingResPt.value, fConfigSmearingResEta.value, fConfigSmearingResPhi.value, fConfigSmearingBins, fConfigSmearingSeed)) {
+      LOGF(fatal, "Invalid smearing parametrization: the pT points and the resolutions must have the same size and increasing pT");
+    }
 
     // Configure 2D histograms
     // Create List with generated particles
@@ -924,82 +1009,113 @@ struct AnalysisSameEventPairing {
     //
     Double_t masse = 0.00051099895; // 0.5 MeV/c2 -> 0.0005 GeV/c2
 
-    for (auto& [t1, t2] : combinations(groupedMCTracks, groupedMCTracks)) {
-
-      if ((abs(t1.pdgCode()) != 11) || (abs(t2.pdgCode()) != 11))
+    // electron legs, in the order of the MC stack
+    fGenLegs.clear();
+    std::vector<typename TTracksMC::iterator> mcLegs;
+    for (auto& t : groupedMCTracks) {
+      if (abs(t.pdgCode()) != 11) {
         continue;
-      if (t1.pdgCode() * t2.pdgCode() > 0)
-        continue; // ULS only
-
-      TLorentzVector Lvec1;
-      TLorentzVector Lvec2;
-      Lvec1.SetPtEtaPhiM(t1.pt(), t1.eta(), t1.phi(), masse);
-      Lvec2.SetPtEtaPhiM(t2.pt(), t2.eta(), t2.phi(), masse);
-      TLorentzVector LvecM = Lvec1 + Lvec2;
-      double mass = LvecM.M();
-      double pairpt = LvecM.Pt();
-      // double opangle = Lvec1.Angle(Lvec2.Vect());
-
-      // printf("Check before\n");
-      // Fiducial cut
-      Bool_t genfidcut = kTRUE;
-      if ((t1.eta() > fConfigMaxEta) || (t2.eta() > fConfigMaxEta) || (t1.eta() < fConfigMinEta) || (t2.eta() < fConfigMinEta) || (t1.pt() > fConfigMaxPt) || (t2.pt() > fConfigMaxPt) || (t1.pt() < fConfigMinPt) || (t2.pt() < fConfigMinPt))
-        genfidcut = kFALSE;
-
-      int isig = 0;
-      for (auto sig = fMCSignals.begin(); sig != fMCSignals.end(); sig++, isig++) {
-        if ((*sig).CheckSignal(true, groupedMCTracks, t1, t2)) {
+      }
+      fGenLegs.fSign.push_back(t.pdgCode() > 0 ? -1 : 1);
+      fGenLegs.fKinematics.add(t.pt(), t.eta(), t.phi(), masse, isFiducial(t.pt(), t.eta()));
+      if (fConfigSmearing) {
+        float pt = t.pt();
+        float eta = t.eta();
+        float phi = t.phi();
+        fSmearing.Smear(pt, eta, phi);
+        fGenLegs.fSmearedKinematics.add(pt, eta, phi, masse, isFiducial(pt, eta));
+      }
+      fGenLegs.fMC.emplace_back();
+      fMCSignalMatcher.FillLeg<TTracksMC>(true, t, fGenLegs.fMC.back());
+      if (fUncompiledMCSignals) {
+        mcLegs.push_back(t);
+      }
+    }
 
-          // not smeared
-          if (genfidcut)
-            dynamic_cast<TH2D*>(fHistGenPair.at(isig))->Fill(mass, pairpt);
-          // need to implement smeared
+    double mass = 0.;
+    double pairpt = 0.;
+    for (size_t i = 0; i < fGenLegs.size(); i++) {
+      for (size_t j = i + 1; j < fGenLegs.size(); j++) {
+        if (fGenLegs.fSign[i] == fGenLegs.fSign[j]) {
+          continue; // ULS only
+        }
+        uint32_t mcDecision = fMCSignalMatcher.CheckPair(fGenLegs.fMC[i], fGenLegs.fMC[j]);
+        if (fUncompiledMCSignals) {
+          mcDecision |= fMCSignalMatcher.CheckSignals(true, groupedMCTracks, mcLegs[i], mcLegs[j]) & fUncompiledMCSignals;
+        }
+        if (!mcDecision) {
+          continue;
+        }
+        // Fiducial cut, not smeared
+        if (fGenLegs.fKinematics.fFiducial[i] && fGenLegs.fKinematics.fFiducial[j]) {
+          fGenLegs.fKinematics.pair(i, j, mass, pairpt);
+          fillPairHistograms(fHistGenPair, mcDecision, mass, pairpt);
+        }
+        if (fConfigSmearing && fGenLegs.fSmearedKinematics.fFiducial[i] && fGenLegs.fSmearedKinematics.fFiducial[j]) {
+          fGenLegs.fSmearedKinematics.pair(i, j, mass, pairpt);
+          fillPairHistograms(fHistGenSmearedPair, mcDecision, mass, pairpt);
         }
       }
     } // end of true pairing loop
   }   // end runMCGen
-  template <uint32_t TTrackFillMap, typename TTracks, typename TTracksMC>
-  void runRecPair(TTracks const& tracks, TTracksMC const& tracksMC)
-  {
-    // Loop over two track combinations
-    uint8_t twoTrackFilter = 0;
-    // uint32_t dileptonFilterMap = 0;
-    // uint32_t dileptonMcDecision = 0;
-    // dileptonList.reserve(1);
 
-    for (auto& [t1, t2] : combinations(tracks, tracks)) {
+  bool isFiducial(float pt, float eta) const
+  {
+    return (eta <= fConfigMaxEta) && (eta >= fConfigMinEta) && (pt <= fConfigMaxPt) && (pt >= fConfigMinPt);
+  }
 
-      twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected());
+  // fill the histograms of the matched MC signals, the one of the signal i being at offset + i
+  void fillPairHistograms(std::vector<TH2D*>& histos, uint32_t mcDecision, double mass, double pairpt, size_t offset = 0)
+  {
+    for (; mcDecision; mcDecision &= mcDecision - 1) {
+      histos[offset + __builtin_ctz(mcDecision)]->Fill(mass, pairpt);
+    }
+  }
 
-      if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
-        continue;
+  template <uint32_t TTrackFillMap, typename TTracks, typename TTracksMC>
+  void runRecPair(TTracks const& tracks, TTracksMC const& tracksMC)
+  {
+    // legs, in the order of the tracks
+    fRecLegs.clear();
+    std::vector<typename TTracks::iterator> recLegs;
+    for (auto& t : tracks) {
+      fRecLegs.fCuts.push_back(uint32_t(t.isBarrelSelected()));
+      fRecLegs.fKinematics.add(t.pt(), t.eta(), t.phi(), fgkElectronMass, true);
+      fRecLegs.fMC.emplace_back();
+      if constexpr ((TTrackFillMap & VarManager::ObjTypes::ReducedTrack) > 0) { // for skimmed DQ model
+        fMCSignalMatcher.FillLeg<TTracksMC>(true, t.reducedMCTrack(), fRecLegs.fMC.back());
+      }
+      if (fUncompiledMCSignals) {
+        recLegs.push_back(t);
       }
-      VarManager::FillPair<VarManager::kJpsiToEE, TTrackFillMap>(t1, t2);
+    }
 
-      // run MC matching for this pair
-      uint32_t mcDecision = 0;
-      int isig = 0;
-      for (auto sig = fMCSignals.begin(); sig != fMCSignals.end(); sig++, isig++) {
+    // Loop over two track combinations
+    double mass = 0.;
+    double pairpt = 0.;
+    for (size_t i = 0; i < fRecLegs.fCuts.size(); i++) {
+      for (size_t j = i + 1; j < fRecLegs.fCuts.size(); j++) {
+        uint8_t twoTrackFilter = fRecLegs.fCuts[i] & fRecLegs.fCuts[j];
+        if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
+          continue;
+        }
 
+        // run MC matching for this pair
+        uint32_t mcDecision = 0;
         if constexpr ((TTrackFillMap & VarManager::ObjTypes::ReducedTrack) > 0) { // for skimmed DQ model
-          if ((*sig).CheckSignal(true, tracksMC, t1.reducedMCTrack(), t2.reducedMCTrack())) {
-            mcDecision |= (uint32_t(1) << isig);
+          mcDecision = fMCSignalMatcher.CheckPair(fRecLegs.fMC[i], fRecLegs.fMC[j]);
+          if (fUncompiledMCSignals) {
+            mcDecision |= fMCSignalMatcher.CheckSignals(true, tracksMC, recLegs[i].reducedMCTrack(), recLegs[j].reducedMCTrack()) & fUncompiledMCSignals;
           }
         }
-
-      } // end of loop MC signals
-
-      // dileptonFilterMap = twoTrackFilter;
-      // dileptonMcDecision = mcDecision;
-      // dileptonList(event, VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt], VarManager::fgValues[VarManager::kEta], VarManager::fgValues[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
-
-      for (unsigned int i = 0; i < fMCSignals.size(); i++) {
-        if (!(mcDecision & (uint32_t(1) << i))) {
+        if (!mcDecision) {
           continue;
         }
-        for (unsigned int j = 0; j < fTrackCuts.size(); j++) {
-          if (twoTrackFilter & (uint8_t(1) << j)) {
-            dynamic_cast<TH2D*>(fHistRecPair.at(j * fMCSignals.size() + i))->Fill(VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt]);
+
+        fRecLegs.fKinematics.pair(i, j, mass, pairpt);
+        for (unsigned int icut = 0; icut < fTrackCuts.size(); icut++) {
+          if (twoTrackFilter & (uint8_t(1) << icut)) {
+            fillPairHistograms(fHistRecPair, mcDecision, mass, pairpt, icut * fMCSignals.size());
           }
         }
       }
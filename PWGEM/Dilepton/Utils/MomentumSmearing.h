@@ -0,0 +1,102 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Parametrized detector response for generator level studies
+//   The relative pT resolution and the eta and phi resolutions are given at a few pT points and linearly interpolated
+//   into a lookup table with uniform pT bins, so that smearing a particle costs one table access and three gaussian
+//   numbers, in place of the full reconstruction. Above the last point the resolutions of the last point are used.
+//
+
+#ifndef PWGEM_DILEPTON_UTILS_MOMENTUMSMEARING_H_
+#define PWGEM_DILEPTON_UTILS_MOMENTUMSMEARING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace o2::pwgem::dilepton
+{
+
+class MomentumSmearing
+{
+ public:
+  struct Resolution {
+    float fPt;  // relative pT resolution
+    float fEta; // eta resolution
+    float fPhi; // phi resolution (rad)
+  };
+
+  MomentumSmearing() = default;
+
+  // Build the lookup table up to the last pT point, with nBins uniform bins
+  //   the vectors have the same size, at least one point, with increasing pT values
+  //   return false if the parametrization is not valid, in which case the particles are not smeared
+  bool Init(const std::vector<float>& pt, const std::vector<float>& resPt, const std::vector<float>& resEta, const std::vector<float>& resPhi, int nBins = 1000, unsigned int seed = 0)
+  {
+    fTable.clear();
+    fEngine.seed(seed);
+    const size_t n = pt.size();
+    if (n == 0 || resPt.size() != n || resEta.size() != n || resPhi.size() != n || nBins <= 0 || !std::is_sorted(pt.begin(), pt.end()) || !(pt.back() > 0.f)) {
+      return false;
+    }
+    fMaxPt = pt.back();
+    fScale = nBins / fMaxPt;
+    fTable.resize(nBins + 1);
+    size_t k = 0;
+    for (int i = 0; i <= nBins; i++) {
+      const float x = i / fScale;
+      while (k + 1 < n && pt[k + 1] < x) {
+        k++;
+      }
+      if (k + 1 == n || x <= pt[0]) {
+        const size_t point = (x <= pt[0]) ? 0 : n - 1;
+        fTable[i] = {resPt[point], resEta[point], resPhi[point]};
+        continue;
+      }
+      const float f = (pt[k + 1] > pt[k]) ? (x - pt[k]) / (pt[k + 1] - pt[k]) : 0.f;
+      fTable[i] = {resPt[k] + f * (resPt[k + 1] - resPt[k]), resEta[k] + f * (resEta[k + 1] - resEta[k]), resPhi[k] + f * (resPhi[k + 1] - resPhi[k])};
+    }
+    return true;
+  }
+  bool IsInitialized() const { return !fTable.empty(); }
+
+  const Resolution& GetResolution(float pt) const
+  {
+    const int bin = pt < fMaxPt ? static_cast<int>(std::max(pt, 0.f) * fScale) : static_cast<int>(fTable.size()) - 1;
+    return fTable[bin];
+  }
+
+  // Smear the kinematics of a particle in place, the azimuth being kept in [0, 2pi)
+  void Smear(float& pt, float& eta, float& phi)
+  {
+    if (fTable.empty()) {
+      return;
+    }
+    const Resolution& res = GetResolution(pt);
+    pt *= 1.f + res.fPt * fGaus(fEngine);
+    eta += res.fEta * fGaus(fEngine);
+    phi += res.fPhi * fGaus(fEngine);
+    constexpr float twoPi = 2.f * static_cast<float>(M_PI);
+    phi -= twoPi * std::floor(phi / twoPi);
+  }
+
+ private:
+  std::vector<Resolution> fTable;
+  float fMaxPt = 0.f;
+  float fScale = 1.f;
+  std::mt19937 fEngine;
+  std::normal_distribution<float> fGaus{0.f, 1.f};
+};
+
+} // namespace o2::pwgem::dilepton
+
+#endif // PWGEM_DILEPTON_UTILS_MOMENTUMSMEARING_H_
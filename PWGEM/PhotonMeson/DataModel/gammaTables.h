@@ -83,6 +83,71 @@ DECLARE_SOA_TABLE(V0Recalculated, "AOD", "V0RECALCULATED",
                   gammarecalculated::RecalculatedVtxZ,
                   gammarecalculated::RecalculatedVtxR<o2::aod::gammarecalculated::RecalculatedVtxX, o2::aod::gammarecalculated::RecalculatedVtxY>);
 
+// compact V0 photon table, the only input of the gamma conversion analysis in skimmed mode
+// it holds the quantities used by the cuts and histograms instead of the full V0 and daughter track tables
+namespace v0photonskim
+{
+DECLARE_SOA_COLUMN(X, x, float);               //! x of conversion point in cm
+DECLARE_SOA_COLUMN(Y, y, float);               //! y of conversion point in cm
+DECLARE_SOA_COLUMN(Z, z, float);               //! z of conversion point in cm
+DECLARE_SOA_COLUMN(Px, px, float);             //! Momentum in x in GeV/c
+DECLARE_SOA_COLUMN(Py, py, float);             //! Momentum in y in GeV/c
+DECLARE_SOA_COLUMN(Pz, pz, float);             //! Momentum in z in GeV/c
+DECLARE_SOA_COLUMN(Eta, eta, float);           //! Pseudorapidity
+DECLARE_SOA_COLUMN(Phi, phi, float);           //! Azimuthal angle
+DECLARE_SOA_COLUMN(CosPA, cosPA, float);       //! Cosine of the pointing angle with respect to the collision vertex
+DECLARE_SOA_COLUMN(Alpha, alpha, float);       //! Armenteros alpha
+DECLARE_SOA_COLUMN(QtArm, qtarm, float);       //! Armenteros qt
+DECLARE_SOA_COLUMN(PsiPair, psipair, float);   //! Psi pair angle
+DECLARE_SOA_COLUMN(PFracPos, pfracpos, float); //! Momentum fraction of the positive daughter
+DECLARE_SOA_COLUMN(PFracNeg, pfracneg, float); //! Momentum fraction of the negative daughter
+DECLARE_SOA_DYNAMIC_COLUMN(Pt, pt, [](float px, float py) { return TMath::Sqrt(px * px + py * py); });
+DECLARE_SOA_DYNAMIC_COLUMN(V0Radius, v0radius, [](float x, float y) { return TMath::Sqrt(x * x + y * y); });
+
+// daughter tracks
+DECLARE_SOA_COLUMN(PosEta, posEta, float);                                                     //! Pseudorapidity of the positive daughter
+DECLARE_SOA_COLUMN(PosPhi, posPhi, float);                                                     //! Azimuthal angle of the positive daughter
+DECLARE_SOA_COLUMN(PosPt, posPt, float);                                                       //! Transversal momentum of the positive daughter in GeV/c
+DECLARE_SOA_COLUMN(PosP, posP, float);                                                         //! Total momentum of the positive daughter in GeV/c
+DECLARE_SOA_COLUMN(PosTpcFoundOverFindableCls, posTpcFoundOverFindableCls, float);             //! Ratio of found over findable clusters of the positive daughter
+DECLARE_SOA_COLUMN(PosTpcCrossedRowsOverFindableCls, posTpcCrossedRowsOverFindableCls, float); //! Ratio crossed rows over findable clusters of the positive daughter
+DECLARE_SOA_COLUMN(PosTpcNSigmaEl, posTpcNSigmaEl, float);                                     //! TPC nsigma electron of the positive daughter
+DECLARE_SOA_COLUMN(PosTpcNSigmaPi, posTpcNSigmaPi, float);                                     //! TPC nsigma pion of the positive daughter
+DECLARE_SOA_COLUMN(PosTpcSignal, posTpcSignal, float);                                         //! TPC dE/dx of the positive daughter
+DECLARE_SOA_COLUMN(NegEta, negEta, float);                                                     //! Pseudorapidity of the negative daughter
+DECLARE_SOA_COLUMN(NegPhi, negPhi, float);                                                     //! Azimuthal angle of the negative daughter
+DECLARE_SOA_COLUMN(NegPt, negPt, float);                                                       //! Transversal momentum of the negative daughter in GeV/c
+DECLARE_SOA_COLUMN(NegP, negP, float);                                                         //! Total momentum of the negative daughter in GeV/c
+DECLARE_SOA_COLUMN(NegTpcFoundOverFindableCls, negTpcFoundOverFindableCls, float);             //! Ratio of found over findable clusters of the negative daughter
+DECLARE_SOA_COLUMN(NegTpcCrossedRowsOverFindableCls, negTpcCrossedRowsOverFindableCls, float); //! Ratio crossed rows over findable clusters of the negative daughter
+DECLARE_SOA_COLUMN(NegTpcNSigmaEl, negTpcNSigmaEl, float);                                     //! TPC nsigma electron of the negative daughter
+DECLARE_SOA_COLUMN(NegTpcNSigmaPi, negTpcNSigmaPi, float);                                     //! TPC nsigma pion of the negative daughter
+DECLARE_SOA_COLUMN(NegTpcSignal, negTpcSignal, float);                                         //! TPC dE/dx of the negative daughter
+} // namespace v0photonskim
+
+DECLARE_SOA_TABLE(V0PhotonsSkim, "AOD", "V0PHOTONSKIM", //!
+                  o2::soa::Index<>,
+                  v0data::CollisionId,
+                  v0photonskim::X, v0photonskim::Y, v0photonskim::Z,
+                  gammarecalculated::RecalculatedVtxX, gammarecalculated::RecalculatedVtxY, gammarecalculated::RecalculatedVtxZ,
+                  v0photonskim::Px, v0photonskim::Py, v0photonskim::Pz,
+                  v0photonskim::Eta, v0photonskim::Phi,
+                  v0photonskim::CosPA,
+                  v0photonskim::Alpha, v0photonskim::QtArm, v0photonskim::PsiPair,
+                  v0photonskim::PFracPos, v0photonskim::PFracNeg,
+                  v0photonskim::PosEta, v0photonskim::PosPhi, v0photonskim::PosPt, v0photonskim::PosP,
+                  v0photonskim::PosTpcFoundOverFindableCls, v0photonskim::PosTpcCrossedRowsOverFindableCls,
+                  v0photonskim::PosTpcNSigmaEl, v0photonskim::PosTpcNSigmaPi, v0photonskim::PosTpcSignal,
+                  v0photonskim::NegEta, v0photonskim::NegPhi, v0photonskim::NegPt, v0photonskim::NegP,
+                  v0photonskim::NegTpcFoundOverFindableCls, v0photonskim::NegTpcCrossedRowsOverFindableCls,
+                  v0photonskim::NegTpcNSigmaEl, v0photonskim::NegTpcNSigmaPi, v0photonskim::NegTpcSignal,
+
+                  // Dynamic columns
+                  v0photonskim::Pt<v0photonskim::Px, v0photonskim::Py>,
+                  v0photonskim::V0Radius<v0photonskim::X, v0photonskim::Y>,
+                  gammarecalculated::RecalculatedVtxR<gammarecalculated::RecalculatedVtxX, gammarecalculated::RecalculatedVtxY>);
+using V0PhotonSkim = V0PhotonsSkim::iterator;
+
 namespace gammamctrue
 {
 DECLARE_SOA_COLUMN(P, p, float); //! Absolute momentum in GeV/c
@@ -133,4 +198,12 @@ DECLARE_SOA_TABLE(McGammasTrue, "AOD", "MCGATRUE",
                   mcparticle::GetGenStatusCode<mcparticle::Flags, mcparticle::StatusCode>,
                   mcparticle::GetProcess<mcparticle::Flags, mcparticle::StatusCode>,
                   mcparticle::IsPhysicalPrimary<mcparticle::Flags>);
+
+namespace gammamctrue
+{
+DECLARE_SOA_INDEX_COLUMN_FULL(McGammaTrue, mcGammaTrue, int, McGammasTrue, ""); //! true photon of the V0, -1 if the V0 is not a confirmed photon
+} // namespace gammamctrue
+
+// index from each V0 to its entry in McGammasTrue, filled together with V0Recalculated such that it joins like it
+DECLARE_SOA_TABLE(V0McGammaIndex, "AOD", "V0MCGAMMAINDEX", gammamctrue::McGammaTrueId);
 } // namespace o2::aod
\ No newline at end of file
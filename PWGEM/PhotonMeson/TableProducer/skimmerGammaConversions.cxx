@@ -64,6 +64,8 @@ struct skimmerGammaConversions {
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<long> nolaterthan{"ccdb-no-later-than", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), "latest acceptable timestamp of creation for the object"};
 
+  Configurable<bool> fFillV0PhotonsSkim{"fFillV0PhotonsSkim", false, "fill the compact V0PhotonsSkim table, the only input of gammaConversions in processRecSkimmed"};
+
   HistogramRegistry fRegistry{
     "fRegistry",
     {
@@ -103,6 +105,8 @@ struct skimmerGammaConversions {
   Produces<aod::V0Recalculated> fFuncTableV0Recalculated;
   Produces<aod::V0DaughterMcParticles> fFuncTableMCTrackInformation;
   Produces<aod::MCParticleIndex> fIndexTableMCTrackIndex;
+  Produces<aod::V0PhotonsSkim> fFuncTableV0PhotonsSkim;
+  Produces<aod::V0McGammaIndex> fIndexTableV0McGamma;
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
@@ -175,6 +179,26 @@ struct skimmerGammaConversions {
       recalculatedVtx[2]);
   }
 
+  template <typename TCOLLISION, typename TV0, typename TTRACK>
+  void fillV0PhotonsSkimTable(TCOLLISION const& theCollision, TV0 const& theV0, TTRACK const& theTrackPos, TTRACK const& theTrackNeg, float* recalculatedVtx)
+  {
+    fFuncTableV0PhotonsSkim(
+      theV0.collisionId(),
+      theV0.x(), theV0.y(), theV0.z(),
+      recalculatedVtx[0], recalculatedVtx[1], recalculatedVtx[2],
+      theV0.px(), theV0.py(), theV0.pz(),
+      theV0.eta(), theV0.phi(),
+      theV0.v0cosPA(theCollision.posX(), theCollision.posY(), theCollision.posZ()),
+      theV0.alpha(), theV0.qtarm(), theV0.psipair(),
+      theV0.pfracpos(), theV0.pfracneg(),
+      theTrackPos.eta(), theTrackPos.phi(), theTrackPos.pt(), theTrackPos.p(),
+      theTrackPos.tpcFoundOverFindableCls(), theTrackPos.tpcCrossedRowsOverFindableCls(),
+      theTrackPos.tpcNSigmaEl(), theTrackPos.tpcNSigmaPi(), theTrackPos.tpcSignal(),
+      theTrackNeg.eta(), theTrackNeg.phi(), theTrackNeg.pt(), theTrackNeg.p(),
+      theTrackNeg.tpcFoundOverFindableCls(), theTrackNeg.tpcCrossedRowsOverFindableCls(),
+      theTrackNeg.tpcNSigmaEl(), theTrackNeg.tpcNSigmaPi(), theTrackNeg.tpcSignal());
+  }
+
   template <typename TTRACK>
   void fillfFuncTableMCTrackInformation(TTRACK theTrack, bool sameMother)
   {
@@ -213,6 +237,9 @@ struct skimmerGammaConversions {
       fillTrackTable(lV0, lTrackPos, true);
       fillTrackTable(lV0, lTrackNeg, false);
       fillV0RecalculatedTable(lV0, recalculatedVtx);
+      if (fFillV0PhotonsSkim) {
+        fillV0PhotonsSkimTable(theCollision, lV0, lTrackPos, lTrackNeg, recalculatedVtx);
+      }
     }
   }
   PROCESS_SWITCH(skimmerGammaConversions, processRec, "process reconstructed info only", true);
@@ -248,9 +275,11 @@ struct skimmerGammaConversions {
         auto lTrackPos = lV0.template posTrack_as<tracksAndTPCInfoMC>(); // positive daughter
         auto lTrackNeg = lV0.template negTrack_as<tracksAndTPCInfoMC>(); // negative daughter
 
+        int lMcGammaIndex = -1;
         eV0Confirmation lV0Status = isTrueV0(lV0,
                                              lTrackPos,
-                                             lTrackNeg);
+                                             lTrackNeg,
+                                             lMcGammaIndex);
 
         fRegistry.get<TH1>(HIST("hV0Confirmation"))->Fill(lV0Status);
 
@@ -260,6 +289,10 @@ struct skimmerGammaConversions {
         fillTrackTable(lV0, lTrackPos, true);
         fillTrackTable(lV0, lTrackNeg, false);
         fillV0RecalculatedTable(lV0, recalculatedVtx);
+        fIndexTableV0McGamma(lMcGammaIndex);
+        if (fFillV0PhotonsSkim) {
+          fillV0PhotonsSkimTable(lCollision, lV0, lTrackPos, lTrackNeg, recalculatedVtx);
+        }
       }
     }
   }
@@ -268,7 +301,8 @@ struct skimmerGammaConversions {
   template <typename TV0, typename TTRACK>
   eV0Confirmation isTrueV0(TV0 const& theV0,
                            TTRACK const& theTrackPos,
-                           TTRACK const& theTrackNeg)
+                           TTRACK const& theTrackNeg,
+                           int& theMcGammaIndex)
   {
     auto getMothersIndeces = [&](auto const& theMcParticle) {
       std::vector<int> lMothersIndeces{};
@@ -367,6 +401,7 @@ struct skimmerGammaConversions {
         lDaughter0Vx, lDaughter0Vy, lDaughter0Vz,
         lV0Radius,
         -1, -1);
+      theMcGammaIndex = fFuncTableMcGammasFromConfirmedV0s.lastIndex();
       break; // because we only want to look at the first mother. If there are more it will show up in fMotherSizesHisto
     }
     return kGoodMcMother;
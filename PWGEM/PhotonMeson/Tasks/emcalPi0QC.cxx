@@ -9,7 +9,9 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include <algorithm>
 #include <climits>
+#include <cmath>
 #include <cstdlib>
 #include <map>
 #include <memory>
@@ -24,6 +26,8 @@
 #include "Framework/ASoA.h"
 #include "Framework/HistogramRegistry.h"
 
+#include "Common/Core/EventMixing.h"
+#include "Common/Core/MixingPool.h"
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
 
@@ -35,9 +39,6 @@
 
 #include "CommonDataFormat/InteractionRecord.h"
 
-#include "TLorentzVector.h"
-#include "TVector3.h"
-
 // \struct Pi0QCTask
 /// \brief Simple monitoring task for EMCal clusters
 /// \author Joshua Koenig <joshua.konig@cern.ch>, Goethe University Frankfurt
@@ -48,12 +49,16 @@
 /// Simple event selection using the flag doEventSel is provided, which selects INT7 events if set to 1
 /// For pilot beam data, instead of relying on the event selection, one can veto specific BC IDS using the flag
 /// fDoVetoBCID.
+/// The photons of an event are sorted by decreasing energy, such that the pair loop stops at the first
+/// pair above the asymmetry cut. The background is estimated by rotation and, optionally, by mixing
+/// the photons with those of previous events of the same z-vertex and cluster multiplicity bin.
 
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 using collisionEvSelIt = o2::soa::Join<o2::aod::Collisions, o2::aod::EvSels>::iterator;
 using selectedClusters = o2::soa::Filtered<o2::aod::EMCALClusters>;
 using selectedCluster = o2::soa::Filtered<o2::aod::EMCALCluster>;
+using selectedClustersWithTracks = o2::soa::Filtered<o2::soa::Join<o2::aod::EMCALClusters, o2::aod::EMCALClusterTrackMatches>>;
 using selectedAmbiguousClusters = o2::soa::Filtered<o2::aod::EMCALAmbiguousClusters>;
 using selectedAmbiguousCluster = o2::soa::Filtered<o2::aod::EMCALAmbiguousCluster>;
 
@@ -68,11 +73,9 @@ struct Photon {
     py = energy * std::sin(theta) * std::sin(phi);
     pz = energy * std::cos(theta);
     pt = std::sqrt(px * px + py * py);
-    photon.SetPxPyPzE(px, py, pz, energy);
     id = clusid;
   }
 
-  TLorentzVector photon;
   float pt;
   float px;
   float py;
@@ -84,19 +87,27 @@ struct Photon {
   int id;
 };
 
-struct Meson {
-  Meson(Photon p1, Photon p2) : pgamma1(p1),
-                                pgamma2(p2)
+/// Momenta of the photons of an event in SoA layout, used by the pair loops
+struct PhotonArrays {
+  std::vector<float> px;
+  std::vector<float> py;
+  std::vector<float> pz;
+  std::vector<float> energy;
+
+  void assign(const std::vector<Photon>& photons)
   {
-    pMeson = p1.photon + p2.photon;
+    px.clear();
+    py.clear();
+    pz.clear();
+    energy.clear();
+    for (const auto& photon : photons) {
+      px.push_back(photon.px);
+      py.push_back(photon.py);
+      pz.push_back(photon.pz);
+      energy.push_back(photon.energy);
+    }
   }
-  Photon pgamma1;
-  Photon pgamma2;
-  TLorentzVector pMeson;
-
-  float getMass() const { return pMeson.M(); };
-  float getPt() const { return pMeson.Pt(); };
-  float getOpeningAngle() const { return pgamma1.photon.Angle(pgamma2.photon.Vect()); };
+  int size() const { return energy.size(); }
 };
 
 struct Pi0QCTask {
@@ -116,6 +127,11 @@ struct Pi0QCTask {
   Configurable<float> mMinEnergyCut{"MinEnergyCut", 0.7, "apply min cluster energy cut"};
   Configurable<int> mMinNCellsCut{"MinNCellsCut", 1, "apply min cluster number of cell cut"};
   Configurable<std::string> mClusterDefinition{"clusterDefinition", "kV3Default", "cluster definition to be selected, e.g. V3Default"};
+  Configurable<float> mMaxAsymmetry{"MaxAsymmetryCut", 1., "apply max energy asymmetry cut on the photon pairs"};
+  Configurable<float> mMinOpeningAngle{"MinOpeningAngleCut", 0., "apply min opening angle cut on the photon pairs (in rad)"};
+  Configurable<int> mMixingDepth{"MixingDepth", 0, "number of events per mixing bin used for the mixed event background, 0: no mixing"};
+  Configurable<std::vector<float>> mMixingVtxBins{"MixingVtxBins", std::vector<float>{-10.f, -5.f, 0.f, 5.f, 10.f}, "Mixing bins - z-vertex"};
+  Configurable<std::vector<float>> mMixingMultBins{"MixingMultBins", std::vector<float>{0.f, 5.f, 10.f, 20.f, 50.f, 10000.f}, "Mixing bins - number of clusters"};
   std::vector<int> mVetoBCIDs;
   std::vector<int> mSelectBCIDs;
 
@@ -125,8 +141,14 @@ struct Pi0QCTask {
   o2::aod::EMCALClusterDefinition clusDef = o2::aod::emcalcluster::getClusterDefinitionFromString(mClusterDefinition.value);
   Filter clusterDefinitionSelection = o2::aod::emcalcluster::definition == static_cast<int>(clusDef);
 
-  // define container for photons
+  // define container for photons, sorted by decreasing energy
   std::vector<Photon> mPhotons;
+  PhotonArrays mPhotonArrays;
+  float mCosMinOpeningAngle = 1.;
+
+  // photons of the previous events, for the mixed event background
+  eventmixing::MixingBinning mMixingBinning;
+  o2::analysis::MixingPool<Photon> mMixingPool;
 
   /// \brief Create output histograms and initialize geometry
   void init(InitContext const&)
@@ -164,6 +186,14 @@ struct Pi0QCTask {
     // meson related histograms
     mHistManager.add("invMassVsPt", "invariant mass and pT of meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
     mHistManager.add("invMassVsPtBackground", "invariant mass and pT of background meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
+    if (mMixingDepth > 0) {
+      mHistManager.add("invMassVsPtMixedBackground", "invariant mass and pT of mixed event background meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
+    }
+
+    mCosMinOpeningAngle = std::cos(mMinOpeningAngle.value);
+    mMixingBinning.addAxis(mMixingVtxBins.value);
+    mMixingBinning.addAxis(mMixingMultBins.value);
+    mMixingPool.init(mMixingDepth);
 
     if (mVetoBCID->length()) {
       std::stringstream parser(mVetoBCID.value);
@@ -187,7 +217,9 @@ struct Pi0QCTask {
     }
   }
   /// \brief Process EMCAL clusters that are matched to a collisions
-  void processCollisions(collisionEvSelIt const& theCollision, selectedClusters const& clusters, o2::aod::BCs const& bcs)
+  /// \tparam applyTrackVeto if true, the clusters matched to a track are rejected
+  template <bool applyTrackVeto, typename Clusters>
+  void processCollisionClusters(collisionEvSelIt const& theCollision, Clusters const& clusters, o2::aod::BCs const& bcs)
   {
     mHistManager.fill(HIST("eventsAll"), 1);
 
@@ -206,11 +238,28 @@ struct Pi0QCTask {
     mHistManager.fill(HIST("eventsSelected"), 1);
     mHistManager.fill(HIST("eventVertexZSelected"), theCollision.posZ());
 
-    ProcessClusters(theCollision, clusters, bcs);
+    ProcessClusters<applyTrackVeto>(theCollision, clusters, bcs);
     ProcessMesons(theCollision, clusters, bcs);
+    if (mMixingDepth > 0) {
+      ProcessMixedEvent(theCollision, clusters.size());
+    }
+  }
+
+  /// \brief Process EMCAL clusters that are matched to a collisions
+  void processCollisions(collisionEvSelIt const& theCollision, selectedClusters const& clusters, o2::aod::BCs const& bcs)
+  {
+    processCollisionClusters<false>(theCollision, clusters, bcs);
   }
   PROCESS_SWITCH(Pi0QCTask, processCollisions, "Process clusters from collision", false);
 
+  /// \brief Process EMCAL clusters that are matched to a collisions, rejecting the clusters matched to a track
+  /// Requires the emcal-track-matcher
+  void processCollisionsTrackVeto(collisionEvSelIt const& theCollision, selectedClustersWithTracks const& clusters, o2::aod::BCs const& bcs)
+  {
+    processCollisionClusters<true>(theCollision, clusters, bcs);
+  }
+  PROCESS_SWITCH(Pi0QCTask, processCollisionsTrackVeto, "Process clusters from collision with a veto on the clusters matched to a track", false);
+
   /// \brief Process EMCAL clusters that are not matched to a collision
   /// This is not needed for most users
   void processAmbiguous(o2::aod::BC const& bc, selectedAmbiguousClusters const& clusters)
@@ -237,7 +286,7 @@ struct Pi0QCTask {
   PROCESS_SWITCH(Pi0QCTask, processAmbiguous, "Process Ambiguous clusters", false);
 
   /// \brief Process EMCAL clusters that are matched to a collisions
-  template <typename Clusters>
+  template <bool applyTrackVeto, typename Clusters>
   void ProcessClusters(collisionEvSelIt const& theCollision, Clusters const& clusters, o2::aod::BCs const& bcs)
   {
     // clear photon vector
@@ -280,11 +329,19 @@ struct Pi0QCTask {
         LOG(debug) << "Cluster rejected because of time cut";
         continue;
       }
+      if constexpr (applyTrackVeto) {
+        if (cluster.nMatchedTracks() > 0) {
+          LOG(debug) << "Cluster rejected because of matched track";
+          continue;
+        }
+      }
 
       // put clusters in photon vector
       // ToDo: At the moment, the eta and phi values are not corrected for a shift of the primary vertex! Should only be a small effect but has to be corrected
       mPhotons.push_back(Photon(cluster.eta(), cluster.phi(), cluster.energy(), cluster.id()));
     }
+    std::sort(mPhotons.begin(), mPhotons.end(), [](const Photon& a, const Photon& b) { return a.energy > b.energy; });
+    mPhotonArrays.assign(mPhotons);
   }
 
   /// \brief Process meson candidates, caluclate invariant mass and pT and fill histograms
@@ -297,59 +354,127 @@ struct Pi0QCTask {
     }
 
     // loop over all photon combinations and build meson candidates
-    for (unsigned int ig1 = 0; ig1 < mPhotons.size(); ++ig1) {
-      for (unsigned int ig2 = ig1 + 1; ig2 < mPhotons.size(); ++ig2) {
-
-        // build meson from photons
-        Meson meson(mPhotons[ig1], mPhotons[ig2]);
-        mHistManager.fill(HIST("invMassVsPt"), meson.getMass(), meson.getPt());
+    // the photons are sorted by decreasing energy, so the asymmetry of the pairs of a photon increases with ig2
+    const int nPhotons = mPhotonArrays.size();
+    const float* px = mPhotonArrays.px.data();
+    const float* py = mPhotonArrays.py.data();
+    const float* pz = mPhotonArrays.pz.data();
+    const float* energy = mPhotonArrays.energy.data();
+    for (int ig1 = 0; ig1 < nPhotons; ++ig1) {
+      for (int ig2 = ig1 + 1; ig2 < nPhotons; ++ig2) {
+        if (!passesAsymmetry(energy[ig1], energy[ig2])) {
+          break;
+        }
+        if (!passesOpeningAngle(px[ig1] * px[ig2] + py[ig1] * py[ig2] + pz[ig1] * pz[ig2], energy[ig1], energy[ig2])) {
+          continue;
+        }
+        const float sumPx = px[ig1] + px[ig2];
+        const float sumPy = py[ig1] + py[ig2];
+        const float sumPz = pz[ig1] + pz[ig2];
+        const float sumE = energy[ig1] + energy[ig2];
+        mHistManager.fill(HIST("invMassVsPt"), getMass(sumPx, sumPy, sumPz, sumE), std::sqrt(sumPx * sumPx + sumPy * sumPy));
 
         // calculate background candidates (rotation background)
-        CalculateBackground(meson, ig1, ig2);
+        CalculateBackground(ig1, ig2, sumPx, sumPy, sumPz);
       }
     }
   }
 
   /// \brief Calculate background (using rotation background method)
-  void CalculateBackground(const Meson& meson, unsigned int ig1, unsigned int ig2)
+  /// \param ig1 index of the first photon of the pair
+  /// \param ig2 index of the second photon of the pair
+  /// \param sumPx momentum of the pair, used as rotation axis
+  void CalculateBackground(int ig1, int ig2, float sumPx, float sumPy, float sumPz)
   {
     // if less than 3 clusters are present, skip event
-    if (mPhotons.size() < 3) {
+    const int nPhotons = mPhotonArrays.size();
+    if (nPhotons < 3) {
+      return;
+    }
+    const float* px = mPhotonArrays.px.data();
+    const float* py = mPhotonArrays.py.data();
+    const float* pz = mPhotonArrays.pz.data();
+    const float* energy = mPhotonArrays.energy.data();
+
+    // rotate both photons by 90 degrees around the momentum of the pair: v' = k x v + k (k.v), with k the unit axis
+    const float norm = std::sqrt(sumPx * sumPx + sumPy * sumPy + sumPz * sumPz);
+    if (norm <= 0.f) {
       return;
     }
-    const double rotationAngle = M_PI / 2.0; //0.78539816339; // rotaion angle 90°
+    const float kx = sumPx / norm, ky = sumPy / norm, kz = sumPz / norm;
+    float rotated[2][4];
+    const int photons[2] = {ig1, ig2};
+    for (int i = 0; i < 2; i++) {
+      const int ig = photons[i];
+      const float dot = kx * px[ig] + ky * py[ig] + kz * pz[ig];
+      rotated[i][0] = ky * pz[ig] - kz * py[ig] + kx * dot;
+      rotated[i][1] = kz * px[ig] - kx * pz[ig] + ky * dot;
+      rotated[i][2] = kx * py[ig] - ky * px[ig] + kz * dot;
+      rotated[i][3] = energy[ig];
+    }
 
-    TLorentzVector lvRotationPhoton1; // photon candidates which get rotated
-    TLorentzVector lvRotationPhoton2; // photon candidates which get rotated
-    TVector3 lvRotationPion;          // rotation axis
-    for (unsigned int ig3 = 0; ig3 < mPhotons.size(); ++ig3) {
+    for (int ig3 = 0; ig3 < nPhotons; ++ig3) {
       // continue if photons are identical
       if (ig3 == ig1 || ig3 == ig2) {
         continue;
       }
-      // calculate rotation axis
-      lvRotationPion = (meson.pMeson).Vect();
-
-      // initialize photons for rotation
-      lvRotationPhoton1.SetPxPyPzE(mPhotons[ig1].px, mPhotons[ig1].py, mPhotons[ig1].pz, mPhotons[ig1].energy);
-      lvRotationPhoton2.SetPxPyPzE(mPhotons[ig2].px, mPhotons[ig2].py, mPhotons[ig2].pz, mPhotons[ig2].energy);
+      // build mesons from rotated photons
+      for (const auto& rot : rotated) {
+        if (!passesAsymmetry(rot[3], energy[ig3]) || !passesOpeningAngle(rot[0] * px[ig3] + rot[1] * py[ig3] + rot[2] * pz[ig3], rot[3], energy[ig3])) {
+          continue;
+        }
+        const float bkgPx = rot[0] + px[ig3];
+        const float bkgPy = rot[1] + py[ig3];
+        mHistManager.fill(HIST("invMassVsPtBackground"), getMass(bkgPx, bkgPy, rot[2] + pz[ig3], rot[3] + energy[ig3]), std::sqrt(bkgPx * bkgPx + bkgPy * bkgPy));
+      }
+    }
+  }
 
-      // rotate photons around rotation axis
-      lvRotationPhoton1.Rotate(rotationAngle, lvRotationPion);
-      lvRotationPhoton2.Rotate(rotationAngle, lvRotationPion);
+  /// \brief Pair the photons with those of the previous events of the same mixing bin, then store them
+  /// \param nClusters number of selected clusters of the event, used as multiplicity for the mixing bin
+  void ProcessMixedEvent(collisionEvSelIt const& theCollision, int nClusters)
+  {
+    const int bin = mMixingBinning.getBinOf(theCollision.posZ(), nClusters);
+    if (bin < 0 || mPhotons.empty()) {
+      return;
+    }
+    const int nPhotons = mPhotonArrays.size();
+    const float* px = mPhotonArrays.px.data();
+    const float* py = mPhotonArrays.py.data();
+    const float* pz = mPhotonArrays.pz.data();
+    const float* energy = mPhotonArrays.energy.data();
+    mMixingPool.forEachEvent(bin, [&](const std::vector<Photon>& mixedPhotons) {
+      for (const auto& mixed : mixedPhotons) {
+        for (int ig = 0; ig < nPhotons; ++ig) {
+          if (!passesAsymmetry(mixed.energy, energy[ig]) || !passesOpeningAngle(mixed.px * px[ig] + mixed.py * py[ig] + mixed.pz * pz[ig], mixed.energy, energy[ig])) {
+            continue;
+          }
+          const float sumPx = mixed.px + px[ig];
+          const float sumPy = mixed.py + py[ig];
+          mHistManager.fill(HIST("invMassVsPtMixedBackground"), getMass(sumPx, sumPy, mixed.pz + pz[ig], mixed.energy + energy[ig]), std::sqrt(sumPx * sumPx + sumPy * sumPy));
+        }
+      }
+    });
+    mMixingPool.add(bin, std::vector<Photon>(mPhotons));
+  }
 
-      // initialize Photon objects for rotated photons
-      Photon rotPhoton1(lvRotationPhoton1.Eta(), lvRotationPhoton1.Phi(), lvRotationPhoton1.E(), mPhotons[ig1].id);
-      Photon rotPhoton2(lvRotationPhoton2.Eta(), lvRotationPhoton2.Phi(), lvRotationPhoton2.E(), mPhotons[ig2].id);
+  /// \brief Energy asymmetry cut on a photon pair
+  bool passesAsymmetry(float energy1, float energy2) const
+  {
+    return std::abs(energy1 - energy2) <= mMaxAsymmetry * (energy1 + energy2);
+  }
 
-      // build meson from rotated photons
-      Meson mesonRotated1(rotPhoton1, mPhotons[ig3]);
-      Meson mesonRotated2(rotPhoton2, mPhotons[ig3]);
+  /// \brief Opening angle cut on a photon pair
+  /// \param dot scalar product of the photon momenta
+  bool passesOpeningAngle(float dot, float energy1, float energy2) const
+  {
+    return mMinOpeningAngle <= 0. || dot <= mCosMinOpeningAngle * energy1 * energy2;
+  }
 
-      // Fill histograms
-      mHistManager.fill(HIST("invMassVsPtBackground"), mesonRotated1.getMass(), mesonRotated1.getPt());
-      mHistManager.fill(HIST("invMassVsPtBackground"), mesonRotated2.getMass(), mesonRotated2.getPt());
-    }
+  /// \brief Invariant mass from the four-momentum of a pair
+  static float getMass(float px, float py, float pz, float e)
+  {
+    return std::sqrt(std::max(e * e - px * px - py * py - pz * pz, 0.f));
   }
 
   /// \brief Create binning for cluster energy/pT axis (variable bin size)
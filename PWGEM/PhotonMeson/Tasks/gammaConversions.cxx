@@ -22,6 +22,7 @@
 #include "Framework/runDataProcessing.h"
 #include "Common/Core/RecoDecay.h"
 
+#include <array>
 #include <TVector3.h>
 #include <TMath.h> // for ATan2, Cos, Sin, Sqrt
 
@@ -30,6 +31,7 @@ using namespace o2::framework;
 using namespace o2::framework::expressions;
 
 using V0DatasAdditional = soa::Join<aod::V0Datas, aod::V0Recalculated>;
+using V0DatasAdditionalMc = soa::Join<aod::V0Datas, aod::V0Recalculated, aod::V0McGammaIndex>;
 using V0DaughterTracksWithMC = soa::Join<aod::V0DaughterTracks, aod::MCParticleIndex>;
 
 // using collisionEvSelIt = soa::Join<aod::Collisions, aod::EvSels>::iterator;
@@ -196,11 +198,11 @@ struct GammaConversions {
       }
     };
 
-    if (doprocessRec && doprocessMc) {
-      LOGF(fatal, "Cannot enable doprocessRec and doprocessMc at the same time. Please choose one.");
+    if ((doprocessRec + doprocessRecSkimmed + doprocessMc) > 1) {
+      LOGF(fatal, "Cannot enable more than one of doprocessRec, doprocessRecSkimmed and doprocessMc at the same time. Please choose one.");
     }
 
-    if (doprocessRec) {
+    if (doprocessRec || doprocessRecSkimmed) {
       fHistoSuffixes[0] = "Rec";
     }
 
@@ -208,7 +210,7 @@ struct GammaConversions {
       fHistogramRegistry,
       lSpecialHistoDefinitions,
       nullptr /*theSuffix*/,
-      doprocessRec /*theCheckDataOnly*/);
+      doprocessRec || doprocessRecSkimmed /*theCheckDataOnly*/);
 
     // do some labeling
     addLablesToHisto1D(fMyRegistry.mV0.mSpecialHistos.mContainer, "hV0Selection", fPhotonCutLabels);
@@ -391,9 +393,8 @@ struct GammaConversions {
     return true;
   }
 
-  template <typename TV0, typename TMCGAMMATABLE>
-  void processMcPhoton(TMCGAMMATABLE const& theMcPhotonForThisV0AsTable,
-                       TV0 const& theV0,
+  template <typename TV0>
+  void processMcPhoton(TV0 const& theV0,
                        float const& theV0CosinePA,
                        bool theV0PassesRecCuts,
                        int PDGCode[],
@@ -402,12 +403,12 @@ struct GammaConversions {
   {
     fillV0McValidationHisto(eV0McValidation::kV0in);
 
-    // is a table that might be empty
-    if (theMcPhotonForThisV0AsTable.begin() == theMcPhotonForThisV0AsTable.end()) {
+    // the index is -1 if the V0 is not a confirmed photon
+    if (!theV0.has_mcGammaTrue()) {
       fillV0McValidationHisto(eV0McValidation::kFakeV0);
       return;
     }
-    auto const lMcPhoton = theMcPhotonForThisV0AsTable.begin();
+    auto const lMcPhoton = theV0.template mcGammaTrue_as<aod::McGammasTrue>();
 
     if (!v0IsGoodValidatedMcPhoton(lMcPhoton,
                                    theV0,
@@ -621,10 +622,32 @@ struct GammaConversions {
   }
   PROCESS_SWITCH(GammaConversions, processRec, "process reconstructed info", true);
 
-  Preslice<aod::McGammasTrue> gperV0 = aod::v0data::v0Id;
+  // same as processRec, reading only the compact V0PhotonsSkim table instead of the V0 and daughter track tables
+  void processRecSkimmed(aod::Collisions::iterator const& theCollision,
+                         aod::V0PhotonsSkim const& theV0s)
+  {
+    fillTH1(fMyRegistry.mCollision.mBeforeAfterRecCuts[kBeforeRecCuts].mV0Kind[kRec].mContainer,
+            "hCollisionZ",
+            theCollision.posZ());
+
+    for (auto& lV0 : theV0s) {
+      std::array<tSkimmedV0Daughter, 2> lTwoV0Daughters{
+        tSkimmedV0Daughter{lV0.posEta(), lV0.posPhi(), lV0.posPt(), lV0.posP(),
+                           lV0.posTpcFoundOverFindableCls(), lV0.posTpcCrossedRowsOverFindableCls(),
+                           lV0.posTpcNSigmaEl(), lV0.posTpcNSigmaPi(), lV0.posTpcSignal()},
+        tSkimmedV0Daughter{lV0.negEta(), lV0.negPhi(), lV0.negPt(), lV0.negP(),
+                           lV0.negTpcFoundOverFindableCls(), lV0.negTpcCrossedRowsOverFindableCls(),
+                           lV0.negTpcNSigmaEl(), lV0.negTpcNSigmaPi(), lV0.negTpcSignal()}};
+
+      if (!processV0(lV0, lV0.cosPA(), lTwoV0Daughters)) {
+        continue;
+      }
+    }
+  }
+  PROCESS_SWITCH(GammaConversions, processRecSkimmed, "process reconstructed info from the V0PhotonsSkim table only", false);
 
   void processMc(aod::Collisions::iterator const& theCollision,
-                 V0DatasAdditional const& theV0s,
+                 V0DatasAdditionalMc const& theV0s,
                  V0DaughterTracksWithMC const& theAllTracks,
                  aod::V0DaughterMcParticles const& TheAllTracksMC,
                  aod::McGammasTrue const& theV0sTrue)
@@ -652,10 +675,8 @@ struct GammaConversions {
                        McParticleMomentum,
                        lV0PassesRecCuts);
 
-      // check if it comes from a true photon (lMcPhotonForThisV0AsTable is a table that might be empty)
-      auto lMcPhotonForThisV0AsTable = theV0sTrue.sliceBy(gperV0, lV0.v0Id());
-      processMcPhoton(lMcPhotonForThisV0AsTable,
-                      lV0,
+      // check if it comes from a true photon
+      processMcPhoton(lV0,
                       lV0CosinePA,
                       lV0PassesRecCuts,
                       PDGCode,
@@ -162,4 +162,21 @@ struct tHistoRegistry {
   tHistoFolderCTV mCollision{mPath + "Collision/"};
   tHistoFolderCTV mTrack{mPath + "Track/"};
   tHistoFolderCTV mV0{mPath + "V0/"};
-};
\ No newline at end of file
+};
+
+// view of a V0 daughter stored in aod::V0PhotonsSkim, with the accessors of aod::V0DaughterTracks used by the track cuts and histograms
+struct tSkimmedV0Daughter {
+  float mEta, mPhi, mPt, mP;
+  float mTpcFoundOverFindableCls, mTpcCrossedRowsOverFindableCls;
+  float mTpcNSigmaEl, mTpcNSigmaPi, mTpcSignal;
+
+  float eta() const { return mEta; }
+  float phi() const { return mPhi; }
+  float pt() const { return mPt; }
+  float p() const { return mP; }
+  float tpcFoundOverFindableCls() const { return mTpcFoundOverFindableCls; }
+  float tpcCrossedRowsOverFindableCls() const { return mTpcCrossedRowsOverFindableCls; }
+  float tpcNSigmaEl() const { return mTpcNSigmaEl; }
+  float tpcNSigmaPi() const { return mTpcNSigmaPi; }
+  float tpcSignal() const { return mTpcSignal; }
+};
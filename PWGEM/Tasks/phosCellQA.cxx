@@ -90,11 +90,16 @@ struct phosCellQA {
       mHistManager.fill(HIST("eventsSelected"), 1);
       mHistManager.fill(HIST("eventBCSelected"), eventIR.bc);
     }
+    // the cells are sorted by BC, the interaction record is only updated when the BC changes
+    o2::InteractionRecord cellIR;
+    int64_t cellBCId = -1;
     for (const auto& cell : cells) {
       if (cell.caloType() != 0)
         continue;
-      o2::InteractionRecord cellIR;
-      cellIR.setFromLong(cell.bc().globalBC());
+      if (cell.bcId() != cellBCId) {
+        cellBCId = cell.bcId();
+        cellIR.setFromLong(cell.bc().globalBC());
+      }
       mHistManager.fill(HIST("cellBCAll"), cellIR.bc);
       if (mVetoBCID >= 0 && cellIR.bc == mVetoBCID)
         continue;
@@ -43,6 +43,7 @@ struct phosCluQA {
   o2::framework::Configurable<int> mVetoBCID{"vetoBCID", -1, "BC ID to be excluded"};
 
   o2::framework::HistogramRegistry mHistManager{"phosCluQAHistograms"};
+  std::vector<uint64_t> mCluGlobalBC;
 
   /// \brief Create output histograms
   void init(o2::framework::InitContext const&)
@@ -102,16 +103,20 @@ struct phosCluQA {
       mHistManager.fill(HIST("eventsSelected"), 1);
       mHistManager.fill(HIST("eventBCSelected"), eventIR.bc);
     }
+    // global BC of the collision of each cluster, looked up once and reused in the pair loop
+    mCluGlobalBC.clear();
+    mCluGlobalBC.reserve(clusters.size());
+    for (const auto& clu : clusters) {
+      mCluGlobalBC.push_back(clu.collision_as<o2::aod::Collisions>().bc_as<o2::aod::BCs>().globalBC());
+    }
     for (const auto& clu : clusters) {
       if (clu.caloType() != 0)
         continue;
-      clu.collision_as<o2::aod::Collisions>();
-      clu.collision_as<o2::aod::Collisions>().bc_as<o2::aod::BCs>();
       o2::InteractionRecord ir;
-      ir.setFromLong(clu.collision_as<o2::aod::Collisions>().bc_as<o2::aod::BCs>().globalBC());
+      ir.setFromLong(mCluGlobalBC[clu.globalIndex()]);
       mHistManager.fill(HIST("cluBCAll"), ir.bc);
 
-      LOG(info) << "E=" << clu.e() << " Time=" << clu.time();
+      LOG(debug) << "E=" << clu.e() << " Time=" << clu.time();
 
       if (mVetoBCID >= 0 && ir.bc == mVetoBCID)
         continue;
@@ -155,7 +160,7 @@ struct phosCluQA {
           m = sqrt(m);
         double pt = sqrt(pow(clu1.px() + clu2.px(), 2) +
                          pow(clu1.py() + clu2.py(), 2));
-        if (clu1.collision().bc().globalBC() == clu2.collision().bc().globalBC()) { // Real
+        if (mCluGlobalBC[clu1.globalIndex()] == mCluGlobalBC[clu2.globalIndex()]) { // Real
           if (clu1.mod() == 1 && clu2.mod() == 1) {
             mHistManager.fill(HIST("mggReM11"), m, pt);
           }
@@ -16,6 +16,8 @@
 #define HF_SELECTOR_CUTS_H_
 
 #include "Framework/Configurable.h"
+#include "Framework/Logger.h"
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -55,6 +57,79 @@ int findBin(T1 const& bins, T2 value)
   return std::distance(bins->begin(), std::upper_bound(bins->begin(), bins->end(), value)) - 1;
 }
 
+/// pT-binned cut matrix with the cut variables resolved at initialisation
+/// \note The selected columns of the configurable matrix are copied in a flat row-major array,
+/// so that the cuts are accessed by index instead of by label in the candidate loop.
+class PtBinnedCuts
+{
+ public:
+  /// Copies the selected cut variables of the matrix.
+  /// \param bins  pT bin limits
+  /// \param cuts  matrix of cuts with pT bins in rows and cut variables in columns
+  /// \param labels  labels of the cut variables to keep, their position defines the cut index
+  template <typename TBins, typename TCuts>
+  void compile(TBins const& bins, TCuts const& cuts, std::vector<std::string> const& labels)
+  {
+    mEdges.assign(bins->begin(), bins->end());
+    mNBins = mEdges.empty() ? 0 : mEdges.size() - 1;
+    mNCuts = labels.size();
+    auto labelsCols = cuts->getLabelsCols();
+    std::vector<int> columns(mNCuts);
+    for (std::size_t iCut = 0; iCut < mNCuts; ++iCut) {
+      auto found = std::find(labelsCols.begin(), labelsCols.end(), labels[iCut]);
+      if (found == labelsCols.end()) {
+        LOGF(fatal, "Cut variable \"%s\" not found in the cut matrix", labels[iCut].data());
+      }
+      columns[iCut] = std::distance(labelsCols.begin(), found);
+    }
+    mValues.resize(mNBins * mNCuts);
+    for (std::size_t iBin = 0; iBin < mNBins; ++iBin) {
+      for (std::size_t iCut = 0; iCut < mNCuts; ++iCut) {
+        mValues[iBin * mNCuts + iCut] = cuts->get(iBin, columns[iCut]);
+      }
+    }
+  }
+
+  /// Finds the pT bin, same result as findBin.
+  /// \param value  pT
+  /// \return index of the pT bin, -1 if outside the bin range
+  /// \note Counts the bin limits below the value without branching, faster than a binary search for the few bins of a selector.
+  int findBin(double value) const
+  {
+    std::size_t nBelow = 0;
+    for (auto edge : mEdges) {
+      nBelow += (value >= edge);
+    }
+    return (nBelow == 0 || nBelow > mNBins) ? -1 : static_cast<int>(nBelow) - 1;
+  }
+
+  /// Finds the pT bins of a batch of values.
+  /// \param values  pT values
+  /// \param bins  output pT bins, -1 if outside the bin range
+  template <typename TValues>
+  void findBins(TValues const& values, std::vector<int>& bins) const
+  {
+    bins.resize(values.size());
+    std::size_t i = 0;
+    for (auto value : values) {
+      bins[i++] = findBin(value);
+    }
+  }
+
+  /// \param bin  pT bin
+  /// \param iCut  index of the cut variable in the labels given at compilation
+  /// \return cut value
+  double get(int bin, int iCut) const { return mValues[bin * mNCuts + iCut]; }
+
+  std::size_t getNBins() const { return mNBins; }
+
+ private:
+  std::vector<double> mEdges{};  ///< pT bin limits
+  std::vector<double> mValues{}; ///< cut values, pT bin major
+  std::size_t mNBins = 0;        ///< number of pT bins
+  std::size_t mNCuts = 0;        ///< number of cut variables
+};
+
 // namespace per channel
 
 namespace hf_cuts_single_track
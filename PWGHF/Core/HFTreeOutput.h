@@ -0,0 +1,95 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file HFTreeOutput.h
+/// \brief Utilities for the reduced flat tables of the heavy-flavour tree creators
+
+#ifndef HF_TREE_OUTPUT_H_
+#define HF_TREE_OUTPUT_H_
+
+#include "Framework/Logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace o2::analysis::hf_tree
+{
+/// Binning of the nsigma values stored on 16 bits, with a bin width of 0.01
+struct BinningNSigma {
+ public:
+  typedef int16_t binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = 327.67;
+  static constexpr float binned_min = -327.67;
+  static constexpr float bin_width = (binned_max - binned_min) / nbins;
+};
+
+/// Packs a float into a binned value, same convention as pidutils::packInTable
+/// \param value  value to pack
+/// \return binned value, the float is recovered as binningType::bin_width * binned value
+template <typename binningType>
+typename binningType::binned_t packBinned(float value)
+{
+  if (value <= binningType::binned_min) {
+    return binningType::underflowBin;
+  }
+  if (value >= binningType::binned_max) {
+    return binningType::overflowBin;
+  }
+  if (value >= 0) {
+    return static_cast<typename binningType::binned_t>((value / binningType::bin_width) + 0.5f);
+  }
+  return static_cast<typename binningType::binned_t>((value / binningType::bin_width) - 0.5f);
+}
+
+/// pT-dependent downsampling of the candidates written in the trees
+/// \note The weight of a stored candidate is the inverse of the fraction kept in its pT bin,
+/// candidates outside the pT bins are all kept with unit weight.
+class PtDownsampler
+{
+ public:
+  /// \param bins  pT bin limits
+  /// \param fractions  fraction of the candidates to keep in each pT bin
+  void setup(std::vector<double> const& bins, std::vector<double> const& fractions)
+  {
+    if (!bins.empty() && fractions.size() + 1 != bins.size()) {
+      LOGF(fatal, "Downsampling: %d fractions given for %d pT bins", static_cast<int>(fractions.size()), static_cast<int>(bins.size()) - 1);
+    }
+    mBins = bins;
+    mFractions = fractions;
+  }
+
+  /// \param pt  candidate pT
+  /// \param pseudoRndm  uniform number in [0, 1) attached to the candidate
+  /// \return weight of the candidate, 0 if it is not kept
+  float getWeight(double pt, double pseudoRndm) const
+  {
+    if (mBins.empty() || pt < mBins.front() || pt >= mBins.back()) {
+      return 1.f;
+    }
+    auto fraction = mFractions[std::distance(mBins.begin(), std::upper_bound(mBins.begin(), mBins.end(), pt)) - 1];
+    if (pseudoRndm >= fraction) {
+      return 0.f;
+    }
+    return 1.f / fraction;
+  }
+
+ private:
+  std::vector<double> mBins{};      ///< pT bin limits
+  std::vector<double> mFractions{}; ///< fraction of kept candidates per pT bin
+};
+
+} // namespace o2::analysis::hf_tree
+
+#endif // HF_TREE_OUTPUT_H_
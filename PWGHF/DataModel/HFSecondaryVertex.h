@@ -199,6 +199,45 @@ DECLARE_SOA_TABLE(HfPvRefitProng3, "AOD", "HFPVREFITPRONG3", //!
                   hf_pvrefit_cand_prong3::PvRefitSigmaYZ,
                   hf_pvrefit_cand_prong3::PvRefitSigmaZ2);
 
+// secondary vertices fitted in the skimming, for the candidate creators to skip the refit
+namespace hf_skim_vertex
+{
+DECLARE_SOA_COLUMN(XSecondaryVertex, xSecondaryVertex, float); //!
+DECLARE_SOA_COLUMN(YSecondaryVertex, ySecondaryVertex, float); //!
+DECLARE_SOA_COLUMN(ZSecondaryVertex, zSecondaryVertex, float); //!
+DECLARE_SOA_COLUMN(SigmaX2, sigmaX2, float);                   //! covariance matrix of the secondary vertex
+DECLARE_SOA_COLUMN(SigmaXY, sigmaXY, float);                   //!
+DECLARE_SOA_COLUMN(SigmaY2, sigmaY2, float);                   //!
+DECLARE_SOA_COLUMN(SigmaXZ, sigmaXZ, float);                   //!
+DECLARE_SOA_COLUMN(SigmaYZ, sigmaYZ, float);                   //!
+DECLARE_SOA_COLUMN(SigmaZ2, sigmaZ2, float);                   //!
+DECLARE_SOA_COLUMN(Chi2PCA, chi2PCA, float);                   //! sum of (non-weighted) distances of the secondary vertex to its prongs
+DECLARE_SOA_COLUMN(PxProng0, pxProng0, float);                 //! momenta of the prongs at the secondary vertex
+DECLARE_SOA_COLUMN(PyProng0, pyProng0, float);                 //!
+DECLARE_SOA_COLUMN(PzProng0, pzProng0, float);                 //!
+DECLARE_SOA_COLUMN(PxProng1, pxProng1, float);                 //!
+DECLARE_SOA_COLUMN(PyProng1, pyProng1, float);                 //!
+DECLARE_SOA_COLUMN(PzProng1, pzProng1, float);                 //!
+DECLARE_SOA_COLUMN(PxProng2, pxProng2, float);                 //!
+DECLARE_SOA_COLUMN(PyProng2, pyProng2, float);                 //!
+DECLARE_SOA_COLUMN(PzProng2, pzProng2, float);                 //!
+} // namespace hf_skim_vertex
+
+DECLARE_SOA_TABLE(HfSkimVtxProng2, "AOD", "HFSKIMVTXPRONG2", //! secondary vertices of the 2-prong skims, joinable with Hf2Prongs
+                  hf_skim_vertex::XSecondaryVertex, hf_skim_vertex::YSecondaryVertex, hf_skim_vertex::ZSecondaryVertex,
+                  hf_skim_vertex::SigmaX2, hf_skim_vertex::SigmaXY, hf_skim_vertex::SigmaY2, hf_skim_vertex::SigmaXZ, hf_skim_vertex::SigmaYZ, hf_skim_vertex::SigmaZ2,
+                  hf_skim_vertex::Chi2PCA,
+                  hf_skim_vertex::PxProng0, hf_skim_vertex::PyProng0, hf_skim_vertex::PzProng0,
+                  hf_skim_vertex::PxProng1, hf_skim_vertex::PyProng1, hf_skim_vertex::PzProng1);
+
+DECLARE_SOA_TABLE(HfSkimVtxProng3, "AOD", "HFSKIMVTXPRONG3", //! secondary vertices of the 3-prong skims, joinable with Hf3Prongs
+                  hf_skim_vertex::XSecondaryVertex, hf_skim_vertex::YSecondaryVertex, hf_skim_vertex::ZSecondaryVertex,
+                  hf_skim_vertex::SigmaX2, hf_skim_vertex::SigmaXY, hf_skim_vertex::SigmaY2, hf_skim_vertex::SigmaXZ, hf_skim_vertex::SigmaYZ, hf_skim_vertex::SigmaZ2,
+                  hf_skim_vertex::Chi2PCA,
+                  hf_skim_vertex::PxProng0, hf_skim_vertex::PyProng0, hf_skim_vertex::PzProng0,
+                  hf_skim_vertex::PxProng1, hf_skim_vertex::PyProng1, hf_skim_vertex::PzProng1,
+                  hf_skim_vertex::PxProng2, hf_skim_vertex::PyProng2, hf_skim_vertex::PzProng2);
+
 // general decay properties
 namespace hf_cand
 {
@@ -479,6 +518,36 @@ DECLARE_SOA_TABLE(HfCandProng2MCGen, "AOD", "HFCANDP2MCGEN", //!
                   hf_cand_prong2::FlagMCMatchGen,
                   hf_cand_prong2::OriginMCGen);
 
+// kinematics of the 2-prong candidates computed once for all mass hypotheses
+namespace hf_cand_prong2_kine
+{
+DECLARE_SOA_COLUMN(MassD0, massD0, float);                       //! invariant mass in the D0 hypothesis
+DECLARE_SOA_COLUMN(MassD0bar, massD0bar, float);                 //! invariant mass in the D0bar hypothesis
+DECLARE_SOA_COLUMN(MassJpsiToEE, massJpsiToEE, float);           //! invariant mass in the J/psi → e+ e- hypothesis
+DECLARE_SOA_COLUMN(MassJpsiToMuMu, massJpsiToMuMu, float);       //! invariant mass in the J/psi → mu+ mu- hypothesis
+DECLARE_SOA_COLUMN(CosThetaStarD0, cosThetaStarD0, float);       //! cos(theta*) in the D0 hypothesis
+DECLARE_SOA_COLUMN(CosThetaStarD0bar, cosThetaStarD0bar, float); //! cos(theta*) in the D0bar hypothesis
+DECLARE_SOA_COLUMN(CtD0, ctD0, float);                           //! proper decay length in the D0 hypothesis
+DECLARE_SOA_COLUMN(CosPA, cosPA, float);                         //! cosine of pointing angle
+DECLARE_SOA_COLUMN(CosPAXY, cosPAXY, float);                     //! cosine of pointing angle in the transverse plane
+DECLARE_SOA_COLUMN(DecLength, decLength, float);                 //! decay length
+DECLARE_SOA_COLUMN(DecLengthXY, decLengthXY, float);             //! decay length in the transverse plane
+} // namespace hf_cand_prong2_kine
+
+// table joinable with HfCandProng2
+DECLARE_SOA_TABLE(HfCandProng2Kine, "AOD", "HFCANDP2KINE", //!
+                  hf_cand_prong2_kine::MassD0,
+                  hf_cand_prong2_kine::MassD0bar,
+                  hf_cand_prong2_kine::MassJpsiToEE,
+                  hf_cand_prong2_kine::MassJpsiToMuMu,
+                  hf_cand_prong2_kine::CosThetaStarD0,
+                  hf_cand_prong2_kine::CosThetaStarD0bar,
+                  hf_cand_prong2_kine::CtD0,
+                  hf_cand_prong2_kine::CosPA,
+                  hf_cand_prong2_kine::CosPAXY,
+                  hf_cand_prong2_kine::DecLength,
+                  hf_cand_prong2_kine::DecLengthXY);
+
 // cascade decay candidate table
 
 namespace hf_cand_casc
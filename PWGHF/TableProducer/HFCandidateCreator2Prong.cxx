@@ -19,6 +19,7 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/MCDecayIndex.h"
 #include "ReconstructionDataFormats/DCA.h"
 
 using namespace o2;
@@ -54,9 +55,17 @@ struct HFCandidateCreator2Prong {
   double massPiK{0.};
   double massKPi{0.};
 
-  void process(aod::Collisions const& collisions,
-               soa::Join<aod::Hf2Prongs, aod::HfPvRefitProng2> const& rowsTrackIndexProng2,
-               aod::BigTracks const& tracks)
+  void init(InitContext const&)
+  {
+    if (doprocessRefit == doprocessSkimVertex) {
+      LOGF(fatal, "Enable exactly one of processRefit and processSkimVertex");
+    }
+  }
+
+  /// Fills the candidate table from the 2-prong skims
+  /// \tparam useSkimVertex  take the secondary vertex fitted in the skimming instead of refitting it
+  template <bool useSkimVertex, typename TRows>
+  void fillCandidates(TRows const& rowsTrackIndexProng2)
   {
     // 2-prong vertex fitter
     o2::vertexing::DCAFitterN<2> df;
@@ -72,26 +81,41 @@ struct HFCandidateCreator2Prong {
     for (const auto& rowTrackIndexProng2 : rowsTrackIndexProng2) {
       auto track0 = rowTrackIndexProng2.index0_as<aod::BigTracks>();
       auto track1 = rowTrackIndexProng2.index1_as<aod::BigTracks>();
-      auto trackParVarPos1 = getTrackParCov(track0);
-      auto trackParVarNeg1 = getTrackParCov(track1);
+      auto trackParVar0 = getTrackParCov(track0);
+      auto trackParVar1 = getTrackParCov(track1);
       auto collision = track0.collision();
 
-      // reconstruct the 2-prong secondary vertex
-      if (df.process(trackParVarPos1, trackParVarNeg1) == 0) {
-        continue;
-      }
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
-      hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
-      auto trackParVar0 = df.getTrack(0);
-      auto trackParVar1 = df.getTrack(1);
-
-      // get track momenta
+      array<double, 3> secondaryVertex;
+      float chi2PCA;
+      array<float, 6> covMatrixPCA;
       array<float, 3> pvec0;
       array<float, 3> pvec1;
-      trackParVar0.getPxPyPzGlo(pvec0);
-      trackParVar1.getPxPyPzGlo(pvec1);
+      if constexpr (useSkimVertex) {
+        // secondary vertex and track momenta at it from the skimming,
+        // the impact parameters are obtained below from the tracks themselves
+        secondaryVertex = {rowTrackIndexProng2.xSecondaryVertex(), rowTrackIndexProng2.ySecondaryVertex(), rowTrackIndexProng2.zSecondaryVertex()};
+        chi2PCA = rowTrackIndexProng2.chi2PCA();
+        covMatrixPCA = {rowTrackIndexProng2.sigmaX2(), rowTrackIndexProng2.sigmaXY(), rowTrackIndexProng2.sigmaY2(), rowTrackIndexProng2.sigmaXZ(), rowTrackIndexProng2.sigmaYZ(), rowTrackIndexProng2.sigmaZ2()};
+        pvec0 = {rowTrackIndexProng2.pxProng0(), rowTrackIndexProng2.pyProng0(), rowTrackIndexProng2.pzProng0()};
+        pvec1 = {rowTrackIndexProng2.pxProng1(), rowTrackIndexProng2.pyProng1(), rowTrackIndexProng2.pzProng1()};
+        hCovSVXX->Fill(covMatrixPCA[0]);
+      } else {
+        // reconstruct the 2-prong secondary vertex
+        if (df.process(trackParVar0, trackParVar1) == 0) {
+          continue;
+        }
+        const auto& vertexPCA = df.getPCACandidate();
+        secondaryVertex = {vertexPCA[0], vertexPCA[1], vertexPCA[2]};
+        chi2PCA = df.getChi2AtPCACandidate();
+        covMatrixPCA = df.calcPCACovMatrixFlat();
+        hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
+        trackParVar0 = df.getTrack(0);
+        trackParVar1 = df.getTrack(1);
+
+        // get track momenta
+        trackParVar0.getPxPyPzGlo(pvec0);
+        trackParVar1.getPxPyPzGlo(pvec1);
+      }
 
       // get track impact parameters
       // This modifies track momenta!
@@ -153,16 +177,35 @@ struct HFCandidateCreator2Prong {
       }
     }
   }
+
+  void processRefit(aod::Collisions const& collisions,
+                    soa::Join<aod::Hf2Prongs, aod::HfPvRefitProng2> const& rowsTrackIndexProng2,
+                    aod::BigTracks const& tracks)
+  {
+    fillCandidates<false>(rowsTrackIndexProng2);
+  }
+  PROCESS_SWITCH(HFCandidateCreator2Prong, processRefit, "Refit the secondary vertices of the skims", true);
+
+  void processSkimVertex(aod::Collisions const& collisions,
+                         soa::Join<aod::Hf2Prongs, aod::HfPvRefitProng2, aod::HfSkimVtxProng2> const& rowsTrackIndexProng2,
+                         aod::BigTracks const& tracks)
+  {
+    fillCandidates<true>(rowsTrackIndexProng2);
+  }
+  PROCESS_SWITCH(HFCandidateCreator2Prong, processSkimVertex, "Use the secondary vertices fitted in the skimming (fillSkimVertices), without refit", false);
 };
 
 /// Extends the base table with expression columns.
 struct HFCandidateCreator2ProngExpressions {
   Produces<aod::HfCandProng2MCRec> rowMCMatchRec;
   Produces<aod::HfCandProng2MCGen> rowMCMatchGen;
+  Produces<aod::HfCandProng2Kine> rowKinematics;
 
   Spawns<aod::HfCandProng2Ext> rowCandidateProng2;
   void init(InitContext const&) {}
 
+  MCDecayIndex decayIndex; // generated-level matching of the MC particles, reused for the candidates
+
   /// Performs MC matching.
   void processMC(aod::BigTracksMC const& tracks,
                  aod::McParticles const& particlesMC)
@@ -171,29 +214,27 @@ struct HFCandidateCreator2ProngExpressions {
     int8_t sign = 0;
     int8_t flag = 0;
     int8_t origin = 0;
+    std::vector<int> listIndexDaughters{};
 
-    rowCandidateProng2->bindExternalIndices(&tracks);
-
-    // Match reconstructed candidates.
-    // Spawned table can be used directly
-    for (auto& candidate : *rowCandidateProng2) {
-      // Printf("New rec. candidate");
+    // Match generated particles.
+    // The matched decays are recorded in the index used for the reconstructed candidates.
+    decayIndex.reset(particlesMC.size());
+    for (auto& particle : particlesMC) {
+      // Printf("New gen. candidate");
       flag = 0;
       origin = 0;
-      auto arrayDaughters = array{candidate.index0_as<aod::BigTracksMC>(), candidate.index1_as<aod::BigTracksMC>()};
+      listIndexDaughters.clear();
 
       // D0(bar) → π± K∓
       // Printf("Checking D0(bar) → π± K∓");
-      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kD0, array{+kPiPlus, -kKPlus}, true, &sign);
-      if (indexRec > -1) {
+      if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kD0, array{+kPiPlus, -kKPlus}, true, &sign, 1, &listIndexDaughters)) {
         flag = sign * (1 << DecayType::D0ToPiK);
       }
 
       // J/ψ → e+ e−
       if (flag == 0) {
         // Printf("Checking J/ψ → e+ e−");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJpsi, array{+kElectron, -kElectron}, true);
-        if (indexRec > -1) {
+        if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kJpsi, array{+kElectron, -kElectron}, true, nullptr, 1, &listIndexDaughters)) {
           flag = 1 << DecayType::JpsiToEE;
         }
       }
@@ -201,37 +242,42 @@ struct HFCandidateCreator2ProngExpressions {
       // J/ψ → μ+ μ−
       if (flag == 0) {
         // Printf("Checking J/ψ → μ+ μ−");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJpsi, array{+kMuonPlus, -kMuonPlus}, true);
-        if (indexRec > -1) {
+        if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kJpsi, array{+kMuonPlus, -kMuonPlus}, true, nullptr, 1, &listIndexDaughters)) {
           flag = 1 << DecayType::JpsiToMuMu;
         }
       }
 
       // Check whether the particle is non-prompt (from a b quark).
       if (flag != 0) {
-        auto particle = particlesMC.rawIteratorAt(indexRec);
         origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        decayIndex.setDecay(particle.globalIndex() - particlesMC.offset(), flag, origin, listIndexDaughters);
       }
 
-      rowMCMatchRec(flag, origin);
+      rowMCMatchGen(flag, origin);
     }
 
-    // Match generated particles.
-    for (auto& particle : particlesMC) {
-      // Printf("New gen. candidate");
+    rowCandidateProng2->bindExternalIndices(&tracks);
+
+    // Match reconstructed candidates.
+    // Spawned table can be used directly
+    for (auto& candidate : *rowCandidateProng2) {
+      // Printf("New rec. candidate");
       flag = 0;
       origin = 0;
+      auto arrayDaughters = array{candidate.index0_as<aod::BigTracksMC>(), candidate.index1_as<aod::BigTracksMC>()};
 
       // D0(bar) → π± K∓
       // Printf("Checking D0(bar) → π± K∓");
-      if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kD0, array{+kPiPlus, -kKPlus}, true, &sign)) {
+      indexRec = decayIndex.getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kD0, 1 << DecayType::D0ToPiK, true, &sign);
+      if (indexRec > -1) {
         flag = sign * (1 << DecayType::D0ToPiK);
       }
 
       // J/ψ → e+ e−
       if (flag == 0) {
         // Printf("Checking J/ψ → e+ e−");
-        if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kJpsi, array{+kElectron, -kElectron}, true)) {
+        indexRec = decayIndex.getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJpsi, 1 << DecayType::JpsiToEE, true);
+        if (indexRec > -1) {
           flag = 1 << DecayType::JpsiToEE;
         }
       }
@@ -239,21 +285,49 @@ struct HFCandidateCreator2ProngExpressions {
       // J/ψ → μ+ μ−
       if (flag == 0) {
         // Printf("Checking J/ψ → μ+ μ−");
-        if (RecoDecay::isMatchedMCGen(particlesMC, particle, pdg::Code::kJpsi, array{+kMuonPlus, -kMuonPlus}, true)) {
+        indexRec = decayIndex.getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJpsi, 1 << DecayType::JpsiToMuMu, true);
+        if (indexRec > -1) {
           flag = 1 << DecayType::JpsiToMuMu;
         }
       }
 
-      // Check whether the particle is non-prompt (from a b quark).
+      // Origin of the matched mother, found at the generated level.
       if (flag != 0) {
-        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        origin = decayIndex.getOrigin(indexRec - particlesMC.offset());
       }
 
-      rowMCMatchGen(flag, origin);
+      rowMCMatchRec(flag, origin);
     }
   }
 
   PROCESS_SWITCH(HFCandidateCreator2ProngExpressions, processMC, "Process MC", false);
+
+  /// Stores the kinematics of all the mass hypotheses, to be read by the selectors and tasks instead of being recomputed.
+  void processKinematics(aod::Collisions const& collisions)
+  {
+    const array<double, 2> massesPiK{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kKPlus)};
+    const array<double, 2> massesKPi{massesPiK[1], massesPiK[0]};
+    const array<double, 2> massesEE{RecoDecay::getMassPDG(kElectron), RecoDecay::getMassPDG(kElectron)};
+    const array<double, 2> massesMuMu{RecoDecay::getMassPDG(kMuonPlus), RecoDecay::getMassPDG(kMuonMinus)};
+    const double massD0 = RecoDecay::getMassPDG(pdg::Code::kD0);
+
+    rowKinematics.reserve(rowCandidateProng2->size());
+    for (auto& candidate : *rowCandidateProng2) {
+      rowKinematics(candidate.m(massesPiK),
+                    candidate.m(massesKPi),
+                    candidate.m(massesEE),
+                    candidate.m(massesMuMu),
+                    candidate.cosThetaStar(massesPiK, massD0, 1),
+                    candidate.cosThetaStar(massesKPi, massD0, 0),
+                    candidate.ct(massD0),
+                    candidate.cpa(),
+                    candidate.cpaXY(),
+                    candidate.decayLength(),
+                    candidate.decayLengthXY());
+    }
+  }
+
+  PROCESS_SWITCH(HFCandidateCreator2ProngExpressions, processKinematics, "Store the candidate kinematics of all mass hypotheses", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
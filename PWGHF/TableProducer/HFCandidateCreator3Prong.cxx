@@ -59,9 +59,17 @@ struct HFCandidateCreator3Prong {
   double massK = RecoDecay::getMassPDG(kKPlus);
   double massPiKPi{0.};
 
-  void process(aod::Collisions const& collisions,
-               soa::Join<aod::Hf3Prongs, aod::HfPvRefitProng3> const& rowsTrackIndexProng3,
-               aod::BigTracks const& tracks)
+  void init(InitContext const&)
+  {
+    if (doprocessRefit == doprocessSkimVertex) {
+      LOGF(fatal, "Enable exactly one of processRefit and processSkimVertex");
+    }
+  }
+
+  /// Fills the candidate table from the 3-prong skims
+  /// \tparam useSkimVertex  take the secondary vertex fitted in the skimming instead of refitting it
+  template <bool useSkimVertex, typename TRows>
+  void fillCandidates(TRows const& rowsTrackIndexProng3)
   {
     // 3-prong vertex fitter
     o2::vertexing::DCAFitterN<3> df;
@@ -83,25 +91,41 @@ struct HFCandidateCreator3Prong {
       auto trackParVar2 = getTrackParCov(track2);
       auto collision = track0.collision();
 
-      // reconstruct the 3-prong secondary vertex
-      if (df.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
-        continue;
-      }
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
-      hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
-      trackParVar0 = df.getTrack(0);
-      trackParVar1 = df.getTrack(1);
-      trackParVar2 = df.getTrack(2);
-
-      // get track momenta
+      array<double, 3> secondaryVertex;
+      float chi2PCA;
+      array<float, 6> covMatrixPCA;
       array<float, 3> pvec0;
       array<float, 3> pvec1;
       array<float, 3> pvec2;
-      trackParVar0.getPxPyPzGlo(pvec0);
-      trackParVar1.getPxPyPzGlo(pvec1);
-      trackParVar2.getPxPyPzGlo(pvec2);
+      if constexpr (useSkimVertex) {
+        // secondary vertex and track momenta at it from the skimming,
+        // the impact parameters are obtained below from the tracks themselves
+        secondaryVertex = {rowTrackIndexProng3.xSecondaryVertex(), rowTrackIndexProng3.ySecondaryVertex(), rowTrackIndexProng3.zSecondaryVertex()};
+        chi2PCA = rowTrackIndexProng3.chi2PCA();
+        covMatrixPCA = {rowTrackIndexProng3.sigmaX2(), rowTrackIndexProng3.sigmaXY(), rowTrackIndexProng3.sigmaY2(), rowTrackIndexProng3.sigmaXZ(), rowTrackIndexProng3.sigmaYZ(), rowTrackIndexProng3.sigmaZ2()};
+        pvec0 = {rowTrackIndexProng3.pxProng0(), rowTrackIndexProng3.pyProng0(), rowTrackIndexProng3.pzProng0()};
+        pvec1 = {rowTrackIndexProng3.pxProng1(), rowTrackIndexProng3.pyProng1(), rowTrackIndexProng3.pzProng1()};
+        pvec2 = {rowTrackIndexProng3.pxProng2(), rowTrackIndexProng3.pyProng2(), rowTrackIndexProng3.pzProng2()};
+        hCovSVXX->Fill(covMatrixPCA[0]);
+      } else {
+        // reconstruct the 3-prong secondary vertex
+        if (df.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
+          continue;
+        }
+        const auto& vertexPCA = df.getPCACandidate();
+        secondaryVertex = {vertexPCA[0], vertexPCA[1], vertexPCA[2]};
+        chi2PCA = df.getChi2AtPCACandidate();
+        covMatrixPCA = df.calcPCACovMatrixFlat();
+        hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
+        trackParVar0 = df.getTrack(0);
+        trackParVar1 = df.getTrack(1);
+        trackParVar2 = df.getTrack(2);
+
+        // get track momenta
+        trackParVar0.getPxPyPzGlo(pvec0);
+        trackParVar1.getPxPyPzGlo(pvec1);
+        trackParVar2.getPxPyPzGlo(pvec2);
+      }
 
       // get track impact parameters
       // This modifies track momenta!
@@ -166,6 +190,22 @@ struct HFCandidateCreator3Prong {
       }
     }
   }
+
+  void processRefit(aod::Collisions const& collisions,
+                    soa::Join<aod::Hf3Prongs, aod::HfPvRefitProng3> const& rowsTrackIndexProng3,
+                    aod::BigTracks const& tracks)
+  {
+    fillCandidates<false>(rowsTrackIndexProng3);
+  }
+  PROCESS_SWITCH(HFCandidateCreator3Prong, processRefit, "Refit the secondary vertices of the skims", true);
+
+  void processSkimVertex(aod::Collisions const& collisions,
+                         soa::Join<aod::Hf3Prongs, aod::HfPvRefitProng3, aod::HfSkimVtxProng3> const& rowsTrackIndexProng3,
+                         aod::BigTracks const& tracks)
+  {
+    fillCandidates<true>(rowsTrackIndexProng3);
+  }
+  PROCESS_SWITCH(HFCandidateCreator3Prong, processSkimVertex, "Use the secondary vertices fitted in the skimming (fillSkimVertices), without refit", false);
 };
 
 /// Extends the base table with expression columns.
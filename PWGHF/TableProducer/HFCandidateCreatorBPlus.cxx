@@ -26,6 +26,7 @@
 #include "PWGHF/Core/HFSelectorCuts.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
 #include "ReconstructionDataFormats/V0.h"
+#include "PWGHF/Utils/HFChainedCandidates.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -35,6 +36,7 @@ using namespace o2::analysis;
 using namespace o2::aod::hf_cand;
 using namespace o2::aod::hf_cand_prong2;
 using namespace o2::aod::hf_cand_bplus;
+using namespace o2::analysis::hf_chained;
 
 void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 {
@@ -55,6 +57,10 @@ struct HfCandidateCreatorBplus {
   Configurable<double> minparamchange{"minparamchange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
   Configurable<double> minrelchi2change{"minrelchi2change", 0.9, "stop iterations if chi2/chi2old > this"};
   Configurable<bool> useabsdca{"useabsdca", true, "use absolute DCAs"};
+  Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "max. number of threads for the B vertex fits"};
+  Configurable<float> pruneMaxDca{"pruneMaxDca", -1., "max. estimated DCA of the pion to the D0 before the B vertex fit (cm), not applied if negative"};
+  Configurable<float> pruneMassMin{"pruneMassMin", 0., "min. B mass estimated before the vertex fit (GeV/c^2)"};
+  Configurable<float> pruneMassMax{"pruneMassMax", -1., "max. B mass estimated before the vertex fit (GeV/c^2), not applied if not above the min."};
 
   OutputObj<TH1F> hCovPVXX{TH1F("hCovPVXX", "2-prong candidates;XX element of cov. matrix of prim. vtx. position (cm^{2});entries", 100, 0., 1.e-4)};
   OutputObj<TH1F> hCovSVXX{TH1F("hCovSVXX", "2-prong candidates;XX element of cov. matrix of sec. vtx. position (cm^{2});entries", 100, 0., 0.2)};
@@ -69,32 +75,41 @@ struct HfCandidateCreatorBplus {
 
   Filter filterSelectCandidates = (aod::hf_selcandidate_d0::isSelD0 >= selectionFlagD0 || aod::hf_selcandidate_d0::isSelD0bar >= selectionFlagD0bar);
 
-  void process(aod::Collision const& collisions,
+  o2::analysis::DCAFitterCache<2> fitterD0; // fitter to redo D-vertex to get extrapolated daughter tracks
+  FitterPool<2> fitterPoolB;                 // fitters of the B vertices
+  CandidateIndex candidateIndex;
+  std::vector<Combination<2>> combinations;
+  PruningSettings pruning;
+  double massPi = RecoDecay::getMassPDG(kPiPlus);
+  double massD0 = RecoDecay::getMassPDG(pdg::Code::kD0);
+
+  void init(InitContext const&)
+  {
+    DCAFitterSettings settings;
+    settings.propagateToPCA = propdca;
+    settings.maxR = maxr;
+    settings.maxDZIni = 4.; // DCAFitterN default, maxdzini has never been applied to these fitters
+    settings.minParamChange = minparamchange;
+    settings.minRelChi2Change = minrelchi2change;
+    settings.useAbsDCA = useabsdca;
+    fitterD0.configure(settings);
+    fitterPoolB.configure(settings, nThreadsVertexing);
+    pruning = {pruneMaxDca, pruneMassMin, pruneMassMax};
+  }
+
+  void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<aod::HfCandProng2,
                                        aod::HFSelD0Candidate>> const& candidates,
                aod::BigTracks const& tracks)
   {
     hNEvents->Fill(0);
 
-    // Initialise fitter for B vertex
-    o2::vertexing::DCAFitterN<2> bfitter;
-    bfitter.setBz(bz);
-    bfitter.setPropagateToPCA(propdca);
-    bfitter.setMaxR(maxr);
-    bfitter.setMinParamChange(minparamchange);
-    bfitter.setMinRelChi2Change(minrelchi2change);
-    bfitter.setUseAbsDCA(useabsdca);
-
-    // Initial fitter to redo D-vertex to get extrapolated daughter tracks
-    o2::vertexing::DCAFitterN<2> df;
-    df.setBz(bz);
-    df.setPropagateToPCA(propdca);
-    df.setMaxR(maxr);
-    df.setMinParamChange(minparamchange);
-    df.setMinRelChi2Change(minrelchi2change);
-    df.setUseAbsDCA(useabsdca);
-
-    // loop over pairs of track indices
+    auto primaryVertex = getPrimaryVertex(collision);
+    auto covMatrixPV = primaryVertex.getCov();
+    candidateIndex.reset(primaryVertex, bz);
+    auto& df = fitterD0.get(bz);
+
+    // rebuild the D0 candidates once
     for (auto& candidate : candidates) {
       if (!(candidate.hfflag() & 1 << hf_cand_prong2::DecayType::D0ToPiK)) {
         continue;
@@ -112,10 +127,6 @@ struct HfCandidateCreatorBplus {
       auto prong1 = candidate.index1_as<aod::BigTracks>();
       auto prong0TrackParCov = getTrackParCov(prong0);
       auto prong1TrackParCov = getTrackParCov(prong1);
-      auto collision = prong0.collision();
-
-      // LOGF(info, "All track: %d (prong0); %d (prong1)", candidate.index0().globalIndex(), candidate.index1().globalIndex());
-      // LOGF(info, "All track pT: %f (prong0); %f (prong1)", prong0.pt(), prong1.pt());
 
       // reconstruct D0 secondary vertex
       if (df.process(prong0TrackParCov, prong1TrackParCov) == 0) {
@@ -124,91 +135,87 @@ struct HfCandidateCreatorBplus {
 
       prong0TrackParCov.propagateTo(candidate.xSecondaryVertex(), bz);
       prong1TrackParCov.propagateTo(candidate.xSecondaryVertex(), bz);
-      // std::cout << df.getTrack(0).getX() << " "<< "secVx=" << candidate.xSecondaryVertex() << std::endl;
 
       const std::array<float, 6> pCovMatrixD0 = df.calcPCACovMatrixFlat();
       // build a D0 neutral track
       auto trackD0 = o2::dataformats::V0(vertexD0, momentumD0, pCovMatrixD0, prong0TrackParCov, prong1TrackParCov, {0, 0}, {0, 0});
 
-      // loop over tracks for pi selection
-      // auto count = 0;
-      for (auto& track : tracks) {
-        // if(count % 100 == 0){
-        // LOGF(info, "Col: %d (cand); %d (track)", candidate.collisionId(), track.collisionId());
-        //   count++;
-        //  }
-
-        if (cutEtaTrkMax >= 0. && std::abs(track.eta()) > cutEtaTrkMax) {
-          continue;
-        }
-
-        hEtaPi->Fill(track.eta());
-
-        if (candidate.index0Id() == track.globalIndex() || candidate.index1Id() == track.globalIndex()) {
-          continue; // daughter track id and bachelor track id not the same
-        }
+      auto& d0 = candidateIndex.addParent(candidate.globalIndex(), trackD0, vertexD0, momentumD0);
+      d0.prongIds = {candidate.index0Id(), candidate.index1Id(), -1};
+      // D0 paired with pi-, D0bar with pi+
+      d0.selection = (candidate.isSelD0() >= selectionFlagD0 ? 1 : 0) | (candidate.isSelD0bar() >= selectionFlagD0bar ? 2 : 0);
+    }
+    if (candidateIndex.parents().empty()) {
+      return;
+    }
 
-        // Select D0pi- and D0(bar)pi+ pairs only
-        if (!((candidate.isSelD0() >= selectionFlagD0 && track.sign() < 0) || (candidate.isSelD0bar() >= selectionFlagD0bar && track.sign() > 0))) {
-          // Printf("D0: %d, D0bar%d, sign: %d", candidate.isSelD0(), candidate.isSelD0bar(), track.sign());
-          continue;
+    // D0pi- and D0(bar)pi+ combinations, pruned before the vertex fit
+    candidateIndex.fillBachelors(tracks, [this](auto const& track) { return !(cutEtaTrkMax >= 0. && std::abs(track.eta()) > cutEtaTrkMax); });
+    const std::array<float, 2> massesProngs = {static_cast<float>(massD0), static_cast<float>(massPi)};
+    combinations.clear();
+    for (const auto& d0 : candidateIndex.parents()) {
+      for (int sign : {-1, 1}) {
+        for (const auto& pion : candidateIndex.bachelors(sign)) {
+          hEtaPi->Fill(pion.eta);
+          if (d0.isProng(pion.globalIndex)) {
+            continue; // daughter track id and bachelor track id not the same
+          }
+          if (!(d0.selection & (sign < 0 ? 1 : 2))) {
+            continue;
+          }
+          if (!passPruning<1>(pruning, d0, {&pion}, massesProngs)) {
+            continue;
+          }
+          combinations.push_back({&d0, {&pion}});
         }
+      }
+    }
 
-        auto trackBach = getTrackParCov(track);
-        std::array<float, 3> pVecD0 = {0., 0., 0.};
-        std::array<float, 3> pVecBach = {0., 0., 0.};
-        std::array<float, 3> pVecBCand = {0., 0., 0.};
-
-        // find the DCA between the D0 and the bachelor track, for B+
-        if (bfitter.process(trackD0, trackBach) == 0) {
-          continue;
-        }
+    // find the DCA between the D0 and the bachelor track, for B+
+    fitterPoolB.fit(combinations, bz);
 
-        bfitter.propagateTracksToVertex();          // propagate the bachelor and D0 to the B+ vertex
-        bfitter.getTrack(0).getPxPyPzGlo(pVecD0);   // momentum of D0 at the B+ vertex
-        bfitter.getTrack(1).getPxPyPzGlo(pVecBach); // momentum of pi+ at the B+ vertex
-        const auto& BSecVertex = bfitter.getPCACandidate();
-        auto chi2PCA = bfitter.getChi2AtPCACandidate();
-        auto covMatrixPCA = bfitter.calcPCACovMatrixFlat();
-        hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
-
-        pVecBCand = RecoDecay::pVec(pVecD0, pVecBach);
-
-        // get track impact parameters
-        // This modifies track momenta!
-        auto primaryVertex = getPrimaryVertex(collision);
-        auto covMatrixPV = primaryVertex.getCov();
-        hCovPVXX->Fill(covMatrixPV[0]);
-        o2::dataformats::DCA impactParameter0;
-        o2::dataformats::DCA impactParameter1;
-
-        bfitter.getTrack(0).propagateToDCA(primaryVertex, bz, &impactParameter0);
-        bfitter.getTrack(1).propagateToDCA(primaryVertex, bz, &impactParameter1);
-
-        // get uncertainty of the decay length
-        double phi, theta;
-        getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, BSecVertex, phi, theta);
-        auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-        auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
-
-        int hfFlag = 1 << hf_cand_bplus::DecayType::BPlusToD0Pi;
-
-        // fill candidate table rows
-        rowCandidateBase(collision.globalIndex(),
-                         collision.posX(), collision.posY(), collision.posZ(),
-                         BSecVertex[0], BSecVertex[1], BSecVertex[2],
-                         errorDecayLength, errorDecayLengthXY,
-                         chi2PCA,
-                         pVecD0[0], pVecD0[1], pVecD0[2],
-                         pVecBach[0], pVecBach[1], pVecBach[2],
-                         impactParameter0.getY(), impactParameter1.getY(),
-                         std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         candidate.globalIndex(), track.globalIndex(), // index D0 and bachelor
-                         hfFlag);
-      } // track loop
-    }   // D0 cand loop
-  }     // process
-};      // struct
+    for (const auto& combination : combinations) {
+      if (!combination.isVertexFound) {
+        continue;
+      }
+      const auto& d0 = *combination.parent;
+      const auto& pion = *combination.bachelors[0];
+
+      const auto& pVecD0 = combination.pVecProngs[0];   // momentum of D0 at the B+ vertex
+      const auto& pVecBach = combination.pVecProngs[1]; // momentum of pi+ at the B+ vertex
+      const auto& BSecVertex = combination.secondaryVertex;
+      auto chi2PCA = combination.chi2PCA;
+      const auto& covMatrixPCA = combination.covMatrixPCA;
+      hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
+
+      // track impact parameters, computed once per D0 and per bachelor
+      hCovPVXX->Fill(covMatrixPV[0]);
+      const auto& impactParameter0 = d0.impactParameter;
+      const auto& impactParameter1 = pion.impactParameter;
+
+      // get uncertainty of the decay length
+      double phi, theta;
+      getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, BSecVertex, phi, theta);
+      auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
+      auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
+
+      int hfFlag = 1 << hf_cand_bplus::DecayType::BPlusToD0Pi;
+
+      // fill candidate table rows
+      rowCandidateBase(collision.globalIndex(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       BSecVertex[0], BSecVertex[1], BSecVertex[2],
+                       errorDecayLength, errorDecayLengthXY,
+                       chi2PCA,
+                       pVecD0[0], pVecD0[1], pVecD0[2],
+                       pVecBach[0], pVecBach[1], pVecBach[2],
+                       impactParameter0.getY(), impactParameter1.getY(),
+                       std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
+                       d0.globalIndex, pion.globalIndex, // index D0 and bachelor
+                       hfFlag);
+    } // B candidates
+  }   // process
+};    // struct
 
 /// Extends the base table with expression columns.
 struct HfCandidateCreatorBplusExpressions {
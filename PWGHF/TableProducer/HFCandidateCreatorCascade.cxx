@@ -71,26 +71,35 @@ struct HFCandidateCreatorCascade {
   double massLc = RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus);
   double mass2K0sP{0.};
 
+  o2::vertexing::DCAFitterN<2> df;              // 2-prong vertex fitter, the field being fixed
+  std::vector<o2::track::TrackParCov> v0Tracks; // neutral tracks of the V0s, built at their first cascade
+  std::vector<bool> v0TrackBuilt;
+
+  void init(InitContext const&)
+  {
+    df.setBz(bZ);
+    df.setPropagateToPCA(propDCA);
+    df.setMaxR(maxR);
+    df.setMaxDZIni(maxDZIni);
+    df.setMinParamChange(minParamChange);
+    df.setMinRelChi2Change(minRelChi2Change);
+    df.setUseAbsDCA(true);
+  }
+
   void process(aod::Collisions const&,
                aod::HfCascades const& rowsTrackIndexCasc,
                MyBigTracks const&,
                aod::V0sLinked const&,
-               aod::V0Datas const&
+               aod::V0Datas const& v0Datas
 #ifdef MY_DEBUG
                ,
                aod::McParticles& mcParticles
 #endif
   )
   {
-    // 2-prong vertex fitter
-    o2::vertexing::DCAFitterN<2> df;
-    df.setBz(bZ);
-    df.setPropagateToPCA(propDCA);
-    df.setMaxR(maxR);
-    df.setMaxDZIni(maxDZIni);
-    df.setMinParamChange(minParamChange);
-    df.setMinRelChi2Change(minRelChi2Change);
-    df.setUseAbsDCA(true);
+    // a K0S is paired with many bachelors: its track is built once per data frame
+    v0Tracks.resize(v0Datas.size());
+    v0TrackBuilt.assign(v0Datas.size(), false);
 
     // loop over pairs of track indeces
     for (const auto& casc : rowsTrackIndexCasc) {
@@ -122,14 +131,19 @@ struct HFCandidateCreatorCascade {
       MY_DEBUG_MSG(isLc, LOG(info) << "Processing the Lc with proton " << indexBach << " trackV0DaughPos " << indexV0DaughPos << " trackV0DaughNeg " << indexV0DaughNeg);
 
       auto trackParCovBach = getTrackParCov(bach);
-      auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos); // check that MyBigTracks does not need TracksDCA!
-      auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg); // check that MyBigTracks does not need TracksDCA!
-      trackParCovV0DaughPos.propagateTo(v0.posX(), bZ);             // propagate the track to the X closest to the V0 vertex
-      trackParCovV0DaughNeg.propagateTo(v0.negX(), bZ);             // propagate the track to the X closest to the V0 vertex
-      const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
-      const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
-      // we build the neutral track to then build the cascade
-      auto trackV0 = o2::dataformats::V0(vertexV0, momentumV0, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track (indices for v0 daughters set to 0 for now)
+      const auto iV0 = v0.globalIndex();
+      if (!v0TrackBuilt[iV0]) {
+        auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos); // check that MyBigTracks does not need TracksDCA!
+        auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg); // check that MyBigTracks does not need TracksDCA!
+        trackParCovV0DaughPos.propagateTo(v0.posX(), bZ);             // propagate the track to the X closest to the V0 vertex
+        trackParCovV0DaughNeg.propagateTo(v0.negX(), bZ);             // propagate the track to the X closest to the V0 vertex
+        const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
+        const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
+        // we build the neutral track to then build the cascade
+        v0Tracks[iV0] = o2::dataformats::V0(vertexV0, momentumV0, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track (indices for v0 daughters set to 0 for now)
+        v0TrackBuilt[iV0] = true;
+      }
+      const auto& trackV0 = v0Tracks[iV0];
 
       auto collision = bach.collision();
 
@@ -23,6 +23,7 @@
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
 #include "ALICE3/DataModel/ECAL.h"
+#include "PWGHF/Utils/HFChainedCandidates.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -32,6 +33,7 @@ using namespace o2::aod::hf_cand;
 using namespace o2::aod::hf_cand_prong2;
 using namespace o2::aod::hf_cand_chic;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::hf_chained;
 
 void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 {
@@ -72,6 +74,23 @@ struct HFCandidateCreatorChic {
   Configurable<double> cutYCandMax{"cutYCandMax", -1., "max. cand. rapidity"};
   Filter filterSelectCandidates = (aod::hf_selcandidate_jpsi::isSelJpsiToEE >= d_selectionFlagJpsi || aod::hf_selcandidate_jpsi::isSelJpsiToMuMu >= d_selectionFlagJpsi);
 
+  o2::analysis::DCAFitterCache<2> fitterJpsi; // 2-prong vertex fitter (to rebuild Jpsi vertex)
+  CandidateIndex candidateIndex;
+  std::vector<float> invMassJpsiToMuMu;                     // per Jpsi of the candidate index
+  std::vector<std::pair<int64_t, array<float, 3>>> photons; // index and momentum of the selected ECAL clusters
+
+  void init(InitContext const&)
+  {
+    o2::analysis::DCAFitterSettings settings;
+    settings.propagateToPCA = b_propdca;
+    settings.maxR = d_maxr;
+    settings.maxDZIni = d_maxdzini;
+    settings.minParamChange = d_minparamchange;
+    settings.minRelChi2Change = d_minrelchi2change;
+    settings.useAbsDCA = true;
+    fitterJpsi.configure(settings);
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<
                  aod::HfCandProng2,
@@ -79,17 +98,13 @@ struct HFCandidateCreatorChic {
                aod::BigTracks const& tracks,
                aod::ECALs const& ecals)
   {
-    // 2-prong vertex fitter (to rebuild Jpsi vertex)
-    o2::vertexing::DCAFitterN<2> df2;
-    df2.setBz(magneticField);
-    df2.setPropagateToPCA(b_propdca);
-    df2.setMaxR(d_maxr);
-    df2.setMaxDZIni(d_maxdzini);
-    df2.setMinParamChange(d_minparamchange);
-    df2.setMinRelChi2Change(d_minrelchi2change);
-    df2.setUseAbsDCA(true);
-
-    // loop over Jpsi candidates
+    auto primaryVertex = getPrimaryVertex(collision);
+    auto covMatrixPV = primaryVertex.getCov();
+    candidateIndex.reset(primaryVertex, magneticField);
+    invMassJpsiToMuMu.clear();
+    auto& df2 = fitterJpsi.get(magneticField);
+
+    // rebuild the Jpsi candidates once
     for (auto& jpsiCand : jpsiCands) {
       if (!(jpsiCand.hfflag() & 1 << hf_cand_prong2::DecayType::JpsiToEE) && !(jpsiCand.hfflag() & 1 << hf_cand_prong2::DecayType::JpsiToMuMu)) {
         continue;
@@ -124,30 +139,47 @@ struct HFCandidateCreatorChic {
       // define the Jpsi track
       auto trackJpsi = o2::dataformats::V0(vertexJpsi, pvecJpsi, covJpsi, prong0TrackParCov, prong1TrackParCov, {0, 0}, {0, 0}); //FIXME: also needs covxyz???
 
-      // -----------------------------------------------------------------
-      // loop over gamma candidates
-
-      for (auto& ecal : ecals) {
+      // get track impact parameters once per Jpsi
+      auto& jpsi = candidateIndex.addParent(jpsiCand.globalIndex(), trackJpsi, vertexJpsi, pvecJpsi);
+      jpsi.chi2PCA = df2.getChi2AtPCACandidate();
+      jpsi.hfflag = jpsiCand.hfflag();
+      jpsi.selection = (jpsiCand.isSelJpsiToEE() > 0 ? 1 : 0) | (jpsiCand.isSelJpsiToMuMu() > 0 ? 2 : 0);
+      invMassJpsiToMuMu.push_back(InvMassJpsiToMuMu(jpsiCand));
+    }
+    if (candidateIndex.parents().empty()) {
+      return;
+    }
 
-        if (ecal.e() < eneGammaMin) {
-          continue;
-        }
-        auto etagamma = RecoDecay::eta(array{ecal.px(), ecal.py(), ecal.pz()});
-        if (etagamma < etaGammaMin || etagamma > etaGammaMax) { // calcolare la pseudorapidità da posz
-          continue;
-        }
+    // -----------------------------------------------------------------
+    // select the gamma candidates once
+    photons.clear();
+    for (auto& ecal : ecals) {
+      if (ecal.e() < eneGammaMin) {
+        continue;
+      }
+      auto etagamma = RecoDecay::eta(array{ecal.px(), ecal.py(), ecal.pz()});
+      if (etagamma < etaGammaMin || etagamma > etaGammaMax) { // calcolare la pseudorapidità da posz
+        continue;
+      }
+      photons.emplace_back(ecal.globalIndex(), array<float, 3>{(float)ecal.px(), (float)ecal.py(), (float)ecal.pz()});
+    }
 
-        array<float, 3> pvecGamma{(float)ecal.px(), (float)ecal.py(), (float)ecal.pz()};
+    for (std::size_t iJpsi = 0; iJpsi < candidateIndex.parents().size(); iJpsi++) {
+      const auto& jpsi = candidateIndex.parents()[iJpsi];
+      const auto& pvecJpsi = jpsi.pVec;
+      const auto& impactParameter0 = jpsi.impactParameter;
 
-        // get track impact parameters
-        // This modifies track momenta!
+      int hfFlag = 0;
+      if (TESTBIT(jpsi.hfflag, hf_cand_prong2::DecayType::JpsiToMuMu)) {
+        SETBIT(hfFlag, hf_cand_chic::DecayType::ChicToJpsiToMuMuGamma); // dimuon channel
+      }
+      if (TESTBIT(jpsi.hfflag, hf_cand_prong2::DecayType::JpsiToEE)) {
+        SETBIT(hfFlag, hf_cand_chic::DecayType::ChicToJpsiToEEGamma); // dielectron channel
+      }
 
-        auto primaryVertex = getPrimaryVertex(collision);
-        auto covMatrixPV = primaryVertex.getCov();
+      // loop over gamma candidates
+      for (const auto& [indexGamma, pvecGamma] : photons) {
         hCovPVXX->Fill(covMatrixPV[0]);
-        o2::dataformats::DCA impactParameter0;
-        o2::dataformats::DCA impactParameter1;
-        trackJpsi.propagateToDCA(primaryVertex, magneticField, &impactParameter0);
 
         // get uncertainty of the decay length
         //double phi, theta;
@@ -155,34 +187,26 @@ struct HFCandidateCreatorChic {
         //auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
         //auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
 
-        int hfFlag = 0;
-        if (TESTBIT(jpsiCand.hfflag(), hf_cand_prong2::DecayType::JpsiToMuMu)) {
-          SETBIT(hfFlag, hf_cand_chic::DecayType::ChicToJpsiToMuMuGamma); // dimuon channel
-        }
-        if (TESTBIT(jpsiCand.hfflag(), hf_cand_prong2::DecayType::JpsiToEE)) {
-          SETBIT(hfFlag, hf_cand_chic::DecayType::ChicToJpsiToEEGamma); // dielectron channel
-        }
-
         // fill the candidate table for the chi_c here:
         rowCandidateBase(collision.globalIndex(),
                          collision.posX(), collision.posY(), collision.posZ(),
-                         0.f, 0.f, 0.f,               //    ChicsecondaryVertex[0], ChicsecondaryVertex[1], ChicsecondaryVertex[2],
-                         0.f, 0.f,                    // errorDecayLength, errorDecayLengthXY,
-                         df2.getChi2AtPCACandidate(), //chi2PCA of Jpsi
+                         0.f, 0.f, 0.f, //    ChicsecondaryVertex[0], ChicsecondaryVertex[1], ChicsecondaryVertex[2],
+                         0.f, 0.f,      // errorDecayLength, errorDecayLengthXY,
+                         jpsi.chi2PCA,  //chi2PCA of Jpsi
                          pvecJpsi[0], pvecJpsi[1], pvecJpsi[2],
                          pvecGamma[0], pvecGamma[1], pvecGamma[2],
                          impactParameter0.getY(), 0.f,                  // impactParameter1.getY(),
                          std::sqrt(impactParameter0.getSigmaY2()), 0.f, // std::sqrt(impactParameter1.getSigmaY2()),
-                         jpsiCand.globalIndex(), ecal.globalIndex(),
-                         hfFlag, InvMassJpsiToMuMu(jpsiCand));
+                         jpsi.globalIndex, indexGamma,
+                         hfFlag, invMassJpsiToMuMu[iJpsi]);
 
         // calculate invariant mass
         auto arrayMomenta = array{pvecJpsi, pvecGamma};
         massJpsiGamma = RecoDecay::m(std::move(arrayMomenta), array{massJpsi, 0.});
-        if (jpsiCand.isSelJpsiToEE() > 0) {
+        if (jpsi.selection & 1) {
           hMassChicToJpsiToEEGamma->Fill(massJpsiGamma);
         }
-        if (jpsiCand.isSelJpsiToMuMu() > 0) {
+        if (jpsi.selection & 2) {
           hMassChicToJpsiToMuMuGamma->Fill(massJpsiGamma);
         }
       } // ecal loop
@@ -22,6 +22,7 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "PWGHF/Utils/HFChainedCandidates.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -31,6 +32,7 @@ using namespace o2::aod::hf_cand_prong2;
 using namespace o2::aod::hf_cand_prong3;
 using namespace o2::aod::hf_cand_lb;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::hf_chained;
 
 void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 {
@@ -51,6 +53,10 @@ struct HFCandidateCreatorLb {
   Configurable<double> d_minparamchange{"d_minparamchange", 1.e-3, "stop iterations if largest change of any Lb is smaller than this"};
   Configurable<double> d_minrelchi2change{"d_minrelchi2change", 0.9, "stop iterations is chi2/chi2old > this"};
   Configurable<double> ptPionMin{"ptPionMin", 0.5, "minimum pion pT threshold (GeV/c)"};
+  Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "max. number of threads for the Lb vertex fits"};
+  Configurable<float> pruneMaxDca{"pruneMaxDca", -1., "max. estimated DCA of the pion to the Lc before the Lb vertex fit (cm), not applied if negative"};
+  Configurable<float> pruneMassMin{"pruneMassMin", 0., "min. Lb mass estimated before the vertex fit (GeV/c^2)"};
+  Configurable<float> pruneMassMax{"pruneMassMax", -1., "max. Lb mass estimated before the vertex fit (GeV/c^2), not applied if not above the min."};
 
   OutputObj<TH1F> hMassLcToPKPi{TH1F("hMassLcToPKPi", "#Lambda_{c}^{#plus} candidates;inv. mass (pK^{#minus} #pi^{#plus}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtLc{TH1F("hPtLc", "#Lambda_{c}^{#plus} candidates;#Lambda_{c}^{#plus} candidate #it{p}_{T} (GeV/#it{c});entries", 100, 0., 10.)};
@@ -68,33 +74,38 @@ struct HFCandidateCreatorLb {
   Configurable<double> cutYCandMax{"cutYCandMax", -1., "max. cand. rapidity"};
   Filter filterSelectCandidates = (aod::hf_selcandidate_lc::isSelLcpKpi >= d_selectionFlagLc || aod::hf_selcandidate_lc::isSelLcpiKp >= d_selectionFlagLc);
 
+  o2::analysis::DCAFitterCache<3> fitterLc; // 3-prong vertex fitter (to rebuild Lc vertex)
+  FitterPool<2> fitterPoolLb;                // 2-prong vertex fitters of the Lb candidates
+  CandidateIndex candidateIndex;
+  std::vector<Combination<2>> combinations;
+  PruningSettings pruning;
+
+  void init(InitContext const&)
+  {
+    o2::analysis::DCAFitterSettings settings;
+    settings.propagateToPCA = b_propdca;
+    settings.maxR = d_maxr;
+    settings.maxDZIni = d_maxdzini;
+    settings.minParamChange = d_minparamchange;
+    settings.minRelChi2Change = d_minrelchi2change;
+    settings.useAbsDCA = true;
+    fitterLc.configure(settings);
+    fitterPoolLb.configure(settings, nThreadsVertexing);
+    pruning = {pruneMaxDca, pruneMassMin, pruneMassMax};
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<
                  aod::HfCandProng3,
                  aod::HFSelLcCandidate>> const& lcCands,
                aod::BigTracks const& tracks)
   {
-    // 2-prong vertex fitter
-    o2::vertexing::DCAFitterN<2> df2;
-    df2.setBz(magneticField);
-    df2.setPropagateToPCA(b_propdca);
-    df2.setMaxR(d_maxr);
-    df2.setMaxDZIni(d_maxdzini);
-    df2.setMinParamChange(d_minparamchange);
-    df2.setMinRelChi2Change(d_minrelchi2change);
-    df2.setUseAbsDCA(true);
-
-    // 3-prong vertex fitter (to rebuild Lc vertex)
-    o2::vertexing::DCAFitterN<3> df3;
-    df3.setBz(magneticField);
-    df3.setPropagateToPCA(b_propdca);
-    df3.setMaxR(d_maxr);
-    df3.setMaxDZIni(d_maxdzini);
-    df3.setMinParamChange(d_minparamchange);
-    df3.setMinRelChi2Change(d_minrelchi2change);
-    df3.setUseAbsDCA(true);
-
-    // loop over Lc candidates
+    auto primaryVertex = getPrimaryVertex(collision);
+    auto covMatrixPV = primaryVertex.getCov();
+    candidateIndex.reset(primaryVertex, magneticField);
+    auto& df3 = fitterLc.get(magneticField);
+
+    // rebuild the Lc candidates once
     for (auto& lcCand : lcCands) {
       if (!(lcCand.hfflag() & 1 << o2::aod::hf_cand_prong3::DecayType::LcToPKPi)) {
         continue;
@@ -114,7 +125,6 @@ struct HFCandidateCreatorLb {
       auto trackParVar0 = getTrackParCov(track0);
       auto trackParVar1 = getTrackParCov(track1);
       auto trackParVar2 = getTrackParCov(track2);
-      auto collision = track0.collision();
 
       // reconstruct the 3-prong secondary vertex
       if (df3.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
@@ -132,83 +142,86 @@ struct HFCandidateCreatorLb {
       auto trackLc = o2::dataformats::V0(df3.getPCACandidatePos(), pvecLc, df3.calcPCACovMatrixFlat(),
                                          trackpK, trackParVar2, {0, 0}, {0, 0});
 
-      int index0Lc = track0.globalIndex();
-      int index1Lc = track1.globalIndex();
-      int index2Lc = track2.globalIndex();
-      //int charge = track0.sign() + track1.sign() + track2.sign();
+      auto& lc = candidateIndex.addParent(lcCand.globalIndex(), trackLc, df3.getPCACandidatePos(), pvecLc);
+      lc.prongIds = {track0.globalIndex(), track1.globalIndex(), track2.globalIndex()};
+      lc.selection = (lcCand.isSelLcpKpi() > 0 ? 1 : 0) | (lcCand.isSelLcpiKp() > 0 ? 2 : 0);
+    }
+    if (candidateIndex.parents().empty()) {
+      return;
+    }
 
-      for (auto& trackPion : tracks) {
-        if (trackPion.pt() < ptPionMin) {
+    // pi- and Lc combinations, pruned before the vertex fit
+    candidateIndex.fillBachelors(tracks, [this](auto const& track) { return track.pt() >= ptPionMin && track.sign() <= 0; });
+    const std::array<float, 2> massesProngs = {static_cast<float>(massLc), static_cast<float>(massPi)};
+    combinations.clear();
+    for (const auto& lc : candidateIndex.parents()) {
+      for (const auto& pion : candidateIndex.bachelors(-1)) {
+        if (lc.isProng(pion.globalIndex)) {
           continue;
         }
-        if (trackPion.sign() > 0) {
+        hPtPion->Fill(pion.pt);
+        if (!passPruning<1>(pruning, lc, {&pion}, massesProngs)) {
           continue;
         }
-        if (trackPion.globalIndex() == index0Lc || trackPion.globalIndex() == index1Lc || trackPion.globalIndex() == index2Lc) {
-          continue;
-        }
-        hPtPion->Fill(trackPion.pt());
-        array<float, 3> pvecPion;
-        auto trackParVarPi = getTrackParCov(trackPion);
+        combinations.push_back({&lc, {&pion}});
+      }
+    }
 
-        // reconstruct the 3-prong Lc vertex
-        if (df2.process(trackLc, trackParVarPi) == 0) {
-          continue;
-        }
+    // reconstruct the 2-prong Lb vertices
+    fitterPoolLb.fit(combinations, magneticField);
 
-        // calculate relevant properties
-        const auto& secondaryVertexLb = df2.getPCACandidate();
-        auto chi2PCA = df2.getChi2AtPCACandidate();
-        auto covMatrixPCA = df2.calcPCACovMatrixFlat();
-
-        df2.propagateTracksToVertex();
-        df2.getTrack(0).getPxPyPzGlo(pvecLc);
-        df2.getTrack(1).getPxPyPzGlo(pvecPion);
-
-        auto primaryVertex = getPrimaryVertex(collision);
-        auto covMatrixPV = primaryVertex.getCov();
-        o2::dataformats::DCA impactParameter0;
-        o2::dataformats::DCA impactParameter1;
-        trackLc.propagateToDCA(primaryVertex, magneticField, &impactParameter0);
-        trackParVarPi.propagateToDCA(primaryVertex, magneticField, &impactParameter1);
-
-        hCovSVXX->Fill(covMatrixPCA[0]);
-        hCovPVXX->Fill(covMatrixPV[0]);
-
-        // get uncertainty of the decay length
-        double phi, theta;
-        getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexLb, phi, theta);
-        auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-        auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
-
-        int hfFlag = 1 << hf_cand_lb::DecayType::LbToLcPi;
-
-        // fill the candidate table for the Lb here:
-        rowCandidateBase(collision.globalIndex(),
-                         collision.posX(), collision.posY(), collision.posZ(),
-                         secondaryVertexLb[0], secondaryVertexLb[1], secondaryVertexLb[2],
-                         errorDecayLength, errorDecayLengthXY,
-                         chi2PCA,
-                         pvecLc[0], pvecLc[1], pvecLc[2],
-                         pvecPion[0], pvecPion[1], pvecPion[2],
-                         impactParameter0.getY(), impactParameter1.getY(),
-                         std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         lcCand.globalIndex(), trackPion.globalIndex(),
-                         hfFlag);
-
-        // calculate invariant mass
-        auto arrayMomenta = array{pvecLc, pvecPion};
-        massLcPi = RecoDecay::m(std::move(arrayMomenta), array{massLc, massPi});
-        if (lcCand.isSelLcpKpi() > 0) {
-          hMassLbToLcPi->Fill(massLcPi);
-        }
-        if (lcCand.isSelLcpiKp() > 0) {
-          hMassLbToLcPi->Fill(massLcPi);
-        }
-      } // pi- loop
-    }   // Lc loop
-  }     // process
-};      // struct
+    for (const auto& combination : combinations) {
+      if (!combination.isVertexFound) {
+        continue;
+      }
+      const auto& lc = *combination.parent;
+      const auto& pion = *combination.bachelors[0];
+
+      // calculate relevant properties
+      const auto& secondaryVertexLb = combination.secondaryVertex;
+      auto chi2PCA = combination.chi2PCA;
+      const auto& covMatrixPCA = combination.covMatrixPCA;
+      const auto& pvecLc = combination.pVecProngs[0];
+      const auto& pvecPion = combination.pVecProngs[1];
+      const auto& impactParameter0 = lc.impactParameter;
+      const auto& impactParameter1 = pion.impactParameter;
+
+      hCovSVXX->Fill(covMatrixPCA[0]);
+      hCovPVXX->Fill(covMatrixPV[0]);
+
+      // get uncertainty of the decay length
+      double phi, theta;
+      getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexLb, phi, theta);
+      auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
+      auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
+
+      int hfFlag = 1 << hf_cand_lb::DecayType::LbToLcPi;
+
+      // fill the candidate table for the Lb here:
+      rowCandidateBase(collision.globalIndex(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       secondaryVertexLb[0], secondaryVertexLb[1], secondaryVertexLb[2],
+                       errorDecayLength, errorDecayLengthXY,
+                       chi2PCA,
+                       pvecLc[0], pvecLc[1], pvecLc[2],
+                       pvecPion[0], pvecPion[1], pvecPion[2],
+                       impactParameter0.getY(), impactParameter1.getY(),
+                       std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
+                       lc.globalIndex, pion.globalIndex,
+                       hfFlag);
+
+      // calculate invariant mass
+      auto arrayMomenta = array{pvecLc, pvecPion};
+      massLcPi = RecoDecay::m(std::move(arrayMomenta), array{massLc, massPi});
+      if (lc.selection & 1) {
+        hMassLbToLcPi->Fill(massLcPi);
+      }
+      if (lc.selection & 2) {
+        hMassLbToLcPi->Fill(massLcPi);
+      }
+    } // Lb candidates
+  }   // process
+};    // struct
 
 /// Extends the base table with expression columns.
 struct HFCandidateCreatorLbExpressions {
@@ -23,6 +23,7 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "PWGHF/Utils/HFChainedCandidates.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -31,6 +32,7 @@ using namespace o2::aod::hf_cand;
 using namespace o2::aod::hf_cand_prong2;
 using namespace o2::aod::hf_cand_x;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::hf_chained;
 
 void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 {
@@ -52,6 +54,10 @@ struct HFCandidateCreatorX {
   Configurable<double> d_minrelchi2change{"d_minrelchi2change", 0.9, "stop iterations is chi2/chi2old > this"};
   Configurable<double> ptPionMin{"ptPionMin", 1., "minimum pion pT threshold (GeV/c)"};
   Configurable<bool> b_dovalplots{"b_dovalplots", true, "do validation plots"};
+  Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "max. number of threads for the X vertex fits"};
+  Configurable<float> pruneMaxDca{"pruneMaxDca", -1., "max. estimated DCA of each pion to the Jpsi before the X vertex fit (cm), not applied if negative"};
+  Configurable<float> pruneMassMin{"pruneMassMin", 0., "min. X mass estimated before the vertex fit (GeV/c^2)"};
+  Configurable<float> pruneMassMax{"pruneMassMax", -1., "max. X mass estimated before the vertex fit (GeV/c^2), not applied if not above the min."};
 
   OutputObj<TH1F> hMassJpsiToEE{TH1F("hMassJpsiToEE", "J/#psi candidates;inv. mass (e^{#plus} e^{#minus}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hMassJpsiToMuMu{TH1F("hMassJpsiToMuMu", "J/#psi candidates;inv. mass (#mu^{#plus} #mu^{#minus}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
@@ -71,33 +77,38 @@ struct HFCandidateCreatorX {
   Configurable<double> diffMassJpsiPDG{"diffMassJpsiPDG", 0.07, "max. diff. between Jpsi rec. and PDG mass"};
   Filter filterSelectCandidates = (aod::hf_selcandidate_jpsi::isSelJpsiToEE >= d_selectionFlagJpsi || aod::hf_selcandidate_jpsi::isSelJpsiToMuMu >= d_selectionFlagJpsi);
 
+  o2::analysis::DCAFitterCache<2> fitterJpsi; // 2-prong vertex fitter (to rebuild Jpsi vertex)
+  FitterPool<3> fitterPoolX;                  // 3-prong vertex fitters of the X candidates
+  CandidateIndex candidateIndex;
+  std::vector<Combination<3>> combinations;
+  PruningSettings pruning;
+
+  void init(InitContext const&)
+  {
+    o2::analysis::DCAFitterSettings settings;
+    settings.propagateToPCA = b_propdca;
+    settings.maxR = d_maxr;
+    settings.maxDZIni = d_maxdzini;
+    settings.minParamChange = d_minparamchange;
+    settings.minRelChi2Change = d_minrelchi2change;
+    settings.useAbsDCA = true;
+    fitterJpsi.configure(settings);
+    fitterPoolX.configure(settings, nThreadsVertexing);
+    pruning = {pruneMaxDca, pruneMassMin, pruneMassMax};
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<
                  aod::HfCandProng2,
                  aod::HFSelJpsiCandidate>> const& jpsiCands,
                aod::BigTracks const& tracks)
   {
-    // 2-prong vertex fitter (to rebuild Jpsi vertex)
-    o2::vertexing::DCAFitterN<2> df2;
-    df2.setBz(magneticField);
-    df2.setPropagateToPCA(b_propdca);
-    df2.setMaxR(d_maxr);
-    df2.setMaxDZIni(d_maxdzini);
-    df2.setMinParamChange(d_minparamchange);
-    df2.setMinRelChi2Change(d_minrelchi2change);
-    df2.setUseAbsDCA(true);
-
-    // 3-prong vertex fitter
-    o2::vertexing::DCAFitterN<3> df3;
-    df3.setBz(magneticField);
-    df3.setPropagateToPCA(b_propdca);
-    df3.setMaxR(d_maxr);
-    df3.setMaxDZIni(d_maxdzini);
-    df3.setMinParamChange(d_minparamchange);
-    df3.setMinRelChi2Change(d_minrelchi2change);
-    df3.setUseAbsDCA(true);
-
-    // loop over Jpsi candidates
+    auto primaryVertex = getPrimaryVertex(collision);
+    auto covMatrixPV = primaryVertex.getCov();
+    candidateIndex.reset(primaryVertex, magneticField);
+    auto& df2 = fitterJpsi.get(magneticField);
+
+    // rebuild the Jpsi candidates once
     for (auto& jpsiCand : jpsiCands) {
       if (!(jpsiCand.hfflag() & 1 << hf_cand_prong2::DecayType::JpsiToEE) && !(jpsiCand.hfflag() & 1 << hf_cand_prong2::DecayType::JpsiToMuMu)) {
         continue;
@@ -139,109 +150,104 @@ struct HFCandidateCreatorX {
       // define the Jpsi track
       auto trackJpsi = o2::dataformats::V0(vertexJpsi, pvecJpsi, covJpsi, prong0TrackParCov, prong1TrackParCov, {0, 0}, {0, 0}); //FIXME: also needs covxyz???
 
-      // used to check that prongs used for Jpsi and X reco are not the same prongs
-      int index0Jpsi = jpsiCand.index0Id();
-      int index1Jpsi = jpsiCand.index1Id();
+      // the prongs used for Jpsi and X reco must not be the same
+      auto& jpsi = candidateIndex.addParent(jpsiCand.globalIndex(), trackJpsi, vertexJpsi, pvecJpsi);
+      jpsi.prongIds = {jpsiCand.index0Id(), jpsiCand.index1Id(), -1};
+      jpsi.hfflag = jpsiCand.hfflag();
+      jpsi.selection = (jpsiCand.isSelJpsiToEE() > 0 ? 1 : 0) | (jpsiCand.isSelJpsiToMuMu() > 0 ? 2 : 0);
+    }
+    if (candidateIndex.parents().empty()) {
+      return;
+    }
 
-      // loop over pi+ candidates
-      for (auto& trackPos : tracks) {
-        if (trackPos.pt() < ptPionMin) {
-          continue;
-        }
-        if (trackPos.sign() < 0) { // select only positive tracks - use partitions?
-          continue;
-        }
-        if (trackPos.globalIndex() == index0Jpsi) {
+    // Jpsi pi+ pi- combinations, pruned before the vertex fit
+    candidateIndex.fillBachelors(tracks, [this](auto const& track) { return track.pt() >= ptPionMin; });
+    const std::array<float, 3> massesProngs = {static_cast<float>(massJpsi), static_cast<float>(massPi), static_cast<float>(massPi)};
+    combinations.clear();
+    for (const auto& jpsi : candidateIndex.parents()) {
+      for (const auto& pionPos : candidateIndex.bachelors(+1)) {
+        if (jpsi.isProng(pionPos.globalIndex)) {
           continue;
         }
-
-        // loop over pi- candidates
-        for (auto& trackNeg : tracks) {
-          if (trackNeg.pt() < ptPionMin) {
+        for (const auto& pionNeg : candidateIndex.bachelors(-1)) {
+          if (jpsi.isProng(pionNeg.globalIndex)) {
             continue;
           }
-          if (trackNeg.sign() > 0) { // select only negative tracks - use partitions?
+          if (!passPruning<2>(pruning, jpsi, {&pionPos, &pionNeg}, massesProngs)) {
             continue;
           }
-          if (trackNeg.globalIndex() == index1Jpsi) {
-            continue;
-          }
-
-          auto trackParVarPos = getTrackParCov(trackPos);
-          auto trackParVarNeg = getTrackParCov(trackNeg);
-          array<float, 3> pvecPos;
-          array<float, 3> pvecNeg;
+          combinations.push_back({&jpsi, {&pionPos, &pionNeg}});
+        }
+      }
+    }
 
-          // reconstruct the 3-prong X vertex
-          if (df3.process(trackJpsi, trackParVarPos, trackParVarNeg) == 0) {
-            continue;
-          }
+    // reconstruct the 3-prong X vertices
+    fitterPoolX.fit(combinations, magneticField);
 
-          // calculate relevant properties
-          const auto& XsecondaryVertex = df3.getPCACandidate();
-          auto chi2PCA = df3.getChi2AtPCACandidate();
-          auto covMatrixPCA = df3.calcPCACovMatrixFlat();
-          hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
-
-          df3.propagateTracksToVertex();          // propagate the pions and Jpsi to the X vertex
-          df3.getTrack(0).getPxPyPzGlo(pvecJpsi); // update momentum of Jpsi at the X vertex
-          df3.getTrack(1).getPxPyPzGlo(pvecPos);  // momentum of pi+ at the X vertex
-          df3.getTrack(2).getPxPyPzGlo(pvecNeg);  // momentum of pi- at the X vertex
-
-          // get track impact parameters
-          // This modifies track momenta!
-          auto primaryVertex = getPrimaryVertex(collision);
-          auto covMatrixPV = primaryVertex.getCov();
-          hCovPVXX->Fill(covMatrixPV[0]);
-          o2::dataformats::DCA impactParameter0;
-          o2::dataformats::DCA impactParameter1;
-          o2::dataformats::DCA impactParameter2;
-          trackJpsi.propagateToDCA(primaryVertex, magneticField, &impactParameter0);
-          trackParVarPos.propagateToDCA(primaryVertex, magneticField, &impactParameter1);
-          trackParVarNeg.propagateToDCA(primaryVertex, magneticField, &impactParameter2);
-
-          // get uncertainty of the decay length
-          double phi, theta;
-          getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, XsecondaryVertex, phi, theta);
-          auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-          auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
-
-          int hfFlag = 0;
-          if (TESTBIT(jpsiCand.hfflag(), hf_cand_prong2::DecayType::JpsiToMuMu)) {
-            SETBIT(hfFlag, hf_cand_x::DecayType::XToJpsiToMuMuPiPi); // dimuon channel
-          }
-          if (TESTBIT(jpsiCand.hfflag(), hf_cand_prong2::DecayType::JpsiToEE)) {
-            SETBIT(hfFlag, hf_cand_x::DecayType::XToJpsiToEEPiPi); // dielectron channel
-          }
+    for (const auto& combination : combinations) {
+      if (!combination.isVertexFound) {
+        continue;
+      }
+      const auto& jpsi = *combination.parent;
+      const auto& pionPos = *combination.bachelors[0];
+      const auto& pionNeg = *combination.bachelors[1];
+
+      // calculate relevant properties
+      const auto& XsecondaryVertex = combination.secondaryVertex;
+      auto chi2PCA = combination.chi2PCA;
+      const auto& covMatrixPCA = combination.covMatrixPCA;
+      hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
+
+      const auto& pvecJpsi = combination.pVecProngs[0]; // momentum of Jpsi at the X vertex
+      const auto& pvecPos = combination.pVecProngs[1];  // momentum of pi+ at the X vertex
+      const auto& pvecNeg = combination.pVecProngs[2];  // momentum of pi- at the X vertex
+
+      // track impact parameters, computed once per Jpsi and per pion
+      hCovPVXX->Fill(covMatrixPV[0]);
+      const auto& impactParameter0 = jpsi.impactParameter;
+      const auto& impactParameter1 = pionPos.impactParameter;
+      const auto& impactParameter2 = pionNeg.impactParameter;
+
+      // get uncertainty of the decay length
+      double phi, theta;
+      getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, XsecondaryVertex, phi, theta);
+      auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
+      auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
+
+      int hfFlag = 0;
+      if (TESTBIT(jpsi.hfflag, hf_cand_prong2::DecayType::JpsiToMuMu)) {
+        SETBIT(hfFlag, hf_cand_x::DecayType::XToJpsiToMuMuPiPi); // dimuon channel
+      }
+      if (TESTBIT(jpsi.hfflag, hf_cand_prong2::DecayType::JpsiToEE)) {
+        SETBIT(hfFlag, hf_cand_x::DecayType::XToJpsiToEEPiPi); // dielectron channel
+      }
 
-          // fill the candidate table for the X here:
-          rowCandidateBase(collision.globalIndex(),
-                           collision.posX(), collision.posY(), collision.posZ(),
-                           XsecondaryVertex[0], XsecondaryVertex[1], XsecondaryVertex[2],
-                           errorDecayLength, errorDecayLengthXY,
-                           chi2PCA,
-                           pvecJpsi[0], pvecJpsi[1], pvecJpsi[2],
-                           pvecPos[0], pvecPos[1], pvecPos[2],
-                           pvecNeg[0], pvecNeg[1], pvecNeg[2],
-                           impactParameter0.getY(), impactParameter1.getY(), impactParameter2.getY(),
-                           std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()), std::sqrt(impactParameter2.getSigmaY2()),
-                           jpsiCand.globalIndex(), trackPos.globalIndex(), trackNeg.globalIndex(),
-                           hfFlag);
-
-          // calculate invariant mass
-          auto arrayMomenta = array{pvecJpsi, pvecPos, pvecNeg};
-          massJpsiPiPi = RecoDecay::m(std::move(arrayMomenta), array{massJpsi, massPi, massPi});
-          if (jpsiCand.isSelJpsiToEE() > 0) {
-            hMassXToJpsiToEEPiPi->Fill(massJpsiPiPi);
-          }
-          if (jpsiCand.isSelJpsiToMuMu() > 0) {
-            hMassXToJpsiToMuMuPiPi->Fill(massJpsiPiPi);
-          }
-        } // pi- loop
-      }   // pi+ loop
-    }     // Jpsi loop
-  }       // process
-};        // struct
+      // fill the candidate table for the X here:
+      rowCandidateBase(collision.globalIndex(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       XsecondaryVertex[0], XsecondaryVertex[1], XsecondaryVertex[2],
+                       errorDecayLength, errorDecayLengthXY,
+                       chi2PCA,
+                       pvecJpsi[0], pvecJpsi[1], pvecJpsi[2],
+                       pvecPos[0], pvecPos[1], pvecPos[2],
+                       pvecNeg[0], pvecNeg[1], pvecNeg[2],
+                       impactParameter0.getY(), impactParameter1.getY(), impactParameter2.getY(),
+                       std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()), std::sqrt(impactParameter2.getSigmaY2()),
+                       jpsi.globalIndex, pionPos.globalIndex, pionNeg.globalIndex,
+                       hfFlag);
+
+      // calculate invariant mass
+      auto arrayMomenta = array{pvecJpsi, pvecPos, pvecNeg};
+      massJpsiPiPi = RecoDecay::m(std::move(arrayMomenta), array{massJpsi, massPi, massPi});
+      if (jpsi.selection & 1) {
+        hMassXToJpsiToEEPiPi->Fill(massJpsiPiPi);
+      }
+      if (jpsi.selection & 2) {
+        hMassXToJpsiToMuMuPiPi->Fill(massJpsiPiPi);
+      }
+    } // X candidates
+  }   // process
+};    // struct
 
 /// Extends the base table with expression columns.
 struct HFCandidateCreatorXExpressions {
@@ -24,12 +24,14 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "PWGHF/Utils/HFChainedCandidates.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::aod::hf_cand;
 using namespace o2::aod::hf_cand_xicc;
 using namespace o2::framework::expressions; //FIXME not sure if this is needed
+using namespace o2::analysis::hf_chained;
 
 void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 {
@@ -62,32 +64,42 @@ struct HfCandidateCreatorXicc {
 
   Configurable<int> d_selectionFlagXic{"d_selectionFlagXic", 1, "Selection Flag for Xic"};
   Configurable<double> cutPtPionMin{"cutPtPionMin", 1., "min. pt pion track"};
+  Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "max. number of threads for the Xicc vertex fits"};
+  Configurable<float> pruneMaxDca{"pruneMaxDca", -1., "max. estimated DCA of the pion to the Xic before the Xicc vertex fit (cm), not applied if negative"};
+  Configurable<float> pruneMassMin{"pruneMassMin", 0., "min. Xicc mass estimated before the vertex fit (GeV/c^2)"};
+  Configurable<float> pruneMassMax{"pruneMassMax", -1., "max. Xicc mass estimated before the vertex fit (GeV/c^2), not applied if not above the min."};
   Filter filterSelectCandidates = (aod::hf_selcandidate_xic::isSelXicToPKPi >= d_selectionFlagXic || aod::hf_selcandidate_xic::isSelXicToPiKP >= d_selectionFlagXic);
 
+  o2::analysis::DCAFitterCache<3> fitterXic; // 3-prong vertex fitter to rebuild the Xic vertex
+  FitterPool<2> fitterPoolXicc;               // 2-prong vertex fitters to build the Xicc vertices
+  CandidateIndex candidateIndex;
+  std::vector<Combination<2>> combinations;
+  PruningSettings pruning;
+
+  void init(InitContext const&)
+  {
+    o2::analysis::DCAFitterSettings settings;
+    settings.propagateToPCA = b_propdca;
+    settings.maxR = d_maxr;
+    settings.maxDZIni = d_maxdzini;
+    settings.minParamChange = d_minparamchange;
+    settings.minRelChi2Change = d_minrelchi2change;
+    settings.useAbsDCA = true;
+    fitterXic.configure(settings);
+    fitterPoolXicc.configure(settings, nThreadsVertexing);
+    pruning = {pruneMaxDca, pruneMassMin, pruneMassMax};
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<aod::HfCandProng3, aod::HFSelXicToPKPiCandidate>> const& xicCands,
                aod::BigTracks const& tracks)
   {
-    // 3-prong vertex fitter to rebuild the Xic vertex
-    o2::vertexing::DCAFitterN<3> df3;
-    df3.setBz(magneticField);
-    df3.setPropagateToPCA(b_propdca);
-    df3.setMaxR(d_maxr);
-    df3.setMaxDZIni(d_maxdzini);
-    df3.setMinParamChange(d_minparamchange);
-    df3.setMinRelChi2Change(d_minrelchi2change);
-    df3.setUseAbsDCA(true);
-
-    // 2-prong vertex fitter to build the Xicc vertex
-    o2::vertexing::DCAFitterN<2> df2;
-    df2.setBz(magneticField);
-    df2.setPropagateToPCA(b_propdca);
-    df2.setMaxR(d_maxr);
-    df2.setMaxDZIni(d_maxdzini);
-    df2.setMinParamChange(d_minparamchange);
-    df2.setMinRelChi2Change(d_minrelchi2change);
-    df2.setUseAbsDCA(true);
+    auto primaryVertex = getPrimaryVertex(collision);
+    auto covMatrixPV = primaryVertex.getCov();
+    candidateIndex.reset(primaryVertex, magneticField);
+    auto& df3 = fitterXic.get(magneticField);
 
+    // rebuild the Xic candidates once
     for (auto& xicCand : xicCands) {
       if (!(xicCand.hfflag() & 1 << o2::aod::hf_cand_prong3::XicToPKPi)) {
         continue;
@@ -104,7 +116,6 @@ struct HfCandidateCreatorXicc {
       auto trackParVar0 = getTrackParCov(track0);
       auto trackParVar1 = getTrackParCov(track1);
       auto trackParVar2 = getTrackParCov(track2);
-      auto collision = track0.collision();
 
       // reconstruct the 3-prong secondary vertex
       if (df3.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
@@ -122,68 +133,71 @@ struct HfCandidateCreatorXicc {
       auto trackxic = o2::dataformats::V0(df3.getPCACandidatePos(), pvecxic, df3.calcPCACovMatrixFlat(),
                                           trackpK, trackParVar2, {0, 0}, {0, 0});
 
-      int index0Xic = track0.globalIndex();
-      int index1Xic = track1.globalIndex();
-      int index2Xic = track2.globalIndex();
-      int charge = track0.sign() + track1.sign() + track2.sign();
+      auto& xic = candidateIndex.addParent(xicCand.globalIndex(), trackxic, df3.getPCACandidatePos(), pvecxic);
+      xic.prongIds = {track0.globalIndex(), track1.globalIndex(), track2.globalIndex()};
+      xic.sign = track0.sign() + track1.sign() + track2.sign();
+    }
+    if (candidateIndex.parents().empty()) {
+      return;
+    }
 
-      for (auto& trackpion : tracks) {
-        if (trackpion.pt() < cutPtPionMin) {
-          continue;
-        }
-        if (trackpion.sign() * charge < 0) {
-          continue;
-        }
-        if (trackpion.globalIndex() == index0Xic || trackpion.globalIndex() == index1Xic || trackpion.globalIndex() == index2Xic) {
+    // pion and Xic combinations of the same charge, pruned before the vertex fit
+    candidateIndex.fillBachelors(tracks, [this](auto const& track) { return track.pt() >= cutPtPionMin; });
+    const std::array<float, 2> massesProngs = {static_cast<float>(massXic), static_cast<float>(massPi)};
+    combinations.clear();
+    for (const auto& xic : candidateIndex.parents()) {
+      for (const auto& pion : candidateIndex.bachelors(xic.sign)) {
+        if (xic.isProng(pion.globalIndex)) {
           continue;
         }
-        array<float, 3> pvecpion;
-        auto trackParVarPi = getTrackParCov(trackpion);
-
-        // reconstruct the 3-prong X vertex
-        if (df2.process(trackxic, trackParVarPi) == 0) {
+        if (!passPruning<1>(pruning, xic, {&pion}, massesProngs)) {
           continue;
         }
+        combinations.push_back({&xic, {&pion}});
+      }
+    }
 
-        // calculate relevant properties
-        const auto& secondaryVertexXicc = df2.getPCACandidate();
-        auto chi2PCA = df2.getChi2AtPCACandidate();
-        auto covMatrixPCA = df2.calcPCACovMatrixFlat();
+    // reconstruct the 2-prong Xicc vertices
+    fitterPoolXicc.fit(combinations, magneticField);
 
-        df2.propagateTracksToVertex();
-        df2.getTrack(0).getPxPyPzGlo(pvecxic);
-        df2.getTrack(1).getPxPyPzGlo(pvecpion);
+    for (const auto& combination : combinations) {
+      if (!combination.isVertexFound) {
+        continue;
+      }
+      const auto& xic = *combination.parent;
+      const auto& pion = *combination.bachelors[0];
 
-        auto primaryVertex = getPrimaryVertex(collision);
-        auto covMatrixPV = primaryVertex.getCov();
-        o2::dataformats::DCA impactParameter0;
-        o2::dataformats::DCA impactParameter1;
-        trackxic.propagateToDCA(primaryVertex, magneticField, &impactParameter0);
-        trackParVarPi.propagateToDCA(primaryVertex, magneticField, &impactParameter1);
+      // calculate relevant properties
+      const auto& secondaryVertexXicc = combination.secondaryVertex;
+      auto chi2PCA = combination.chi2PCA;
+      const auto& covMatrixPCA = combination.covMatrixPCA;
+      const auto& pvecxic = combination.pVecProngs[0];
+      const auto& pvecpion = combination.pVecProngs[1];
+      const auto& impactParameter0 = xic.impactParameter;
+      const auto& impactParameter1 = pion.impactParameter;
 
-        // get uncertainty of the decay length
-        double phi, theta;
-        getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexXicc, phi, theta);
-        auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-        auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
+      // get uncertainty of the decay length
+      double phi, theta;
+      getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexXicc, phi, theta);
+      auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
+      auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
 
-        int hfFlag = 1 << DecayType::XiccToXicPi;
+      int hfFlag = 1 << DecayType::XiccToXicPi;
 
-        rowCandidateBase(collision.globalIndex(),
-                         collision.posX(), collision.posY(), collision.posZ(),
-                         secondaryVertexXicc[0], secondaryVertexXicc[1], secondaryVertexXicc[2],
-                         errorDecayLength, errorDecayLengthXY,
-                         chi2PCA,
-                         pvecxic[0], pvecxic[1], pvecxic[2],
-                         pvecpion[0], pvecpion[1], pvecpion[2],
-                         impactParameter0.getY(), impactParameter1.getY(),
-                         std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         xicCand.globalIndex(), trackpion.globalIndex(),
-                         hfFlag);
-      } // if on selected Xicc
-    }   // loop over candidates
-  }     // end of process
-};      //end of struct
+      rowCandidateBase(collision.globalIndex(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       secondaryVertexXicc[0], secondaryVertexXicc[1], secondaryVertexXicc[2],
+                       errorDecayLength, errorDecayLengthXY,
+                       chi2PCA,
+                       pvecxic[0], pvecxic[1], pvecxic[2],
+                       pvecpion[0], pvecpion[1], pvecpion[2],
+                       impactParameter0.getY(), impactParameter1.getY(),
+                       std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
+                       xic.globalIndex, pion.globalIndex,
+                       hfFlag);
+    } // Xicc candidates
+  }   // end of process
+};    //end of struct
 
 /// Extends the base table with expression columns.
 struct HfCandidateCreatorXiccExpressions {
@@ -47,6 +47,30 @@ struct HFD0CandidateSelector {
   Configurable<std::vector<double>> pTBins{"pTBins", std::vector<double>{hf_cuts_d0_topik::pTBins_v}, "pT bin limits"};
   Configurable<LabeledArray<double>> cuts{"D0_to_pi_K_cuts", {hf_cuts_d0_topik::cuts[0], npTBins, nCutVars, pTBinLabels, cutVarLabels}, "D0 candidate selection per pT bin"};
 
+  // cut variables used by the selection, in the order of their indices in the compiled cuts
+  enum CutIndex { CutM = 0,
+                  CutCosThetaStar,
+                  CutPtK,
+                  CutPtPi,
+                  CutD0K,
+                  CutD0Pi,
+                  CutD0D0,
+                  CutCpa,
+                  CutCpaXY,
+                  CutDecLenXYNorm,
+                  CutDecLen,
+                  CutDecLenXY,
+                  CutDecLenMin };
+  PtBinnedCuts cutsCompiled; // cuts resolved by index at init
+
+  void init(InitContext const&)
+  {
+    if (doprocessCandidates == doprocessWithKinematics) {
+      LOGF(fatal, "Enable exactly one of processCandidates and processWithKinematics");
+    }
+    cutsCompiled.compile(pTBins, cuts, {"m", "cos theta*", "pT K", "pT Pi", "d0K", "d0pi", "d0d0", "cos pointing angle", "cos pointing angle xy", "normalized decay length XY", "decay length", "decay length XY", "minimum decay length"});
+  }
+
   /*
   /// Selection on goodness of daughter tracks
   /// \note should be applied at candidate selection
@@ -63,13 +87,14 @@ struct HFD0CandidateSelector {
   */
 
   /// Conjugate-independent topological cuts
+  /// \tparam useKinematics reads the kinematics from the HfCandProng2Kine table instead of computing them
   /// \param candidate is candidate
+  /// \param pTBin is the pT bin of the candidate
   /// \return true if candidate passes all cuts
-  template <typename T>
-  bool selectionTopol(const T& candidate)
+  template <bool useKinematics, typename T>
+  bool selectionTopol(const T& candidate, int pTBin)
   {
     auto candpT = candidate.pt();
-    auto pTBin = findBin(pTBins, candpT);
     if (pTBin == -1) {
       return false;
     }
@@ -78,20 +103,33 @@ struct HFD0CandidateSelector {
     if (candpT < d_pTCandMin || candpT >= d_pTCandMax) {
       return false;
     }
+
+    float cpa, cpaXY, decayLength, decayLengthXY;
+    if constexpr (useKinematics) {
+      cpa = candidate.cosPA();
+      cpaXY = candidate.cosPAXY();
+      decayLength = candidate.decLength();
+      decayLengthXY = candidate.decLengthXY();
+    } else {
+      cpa = candidate.cpa();
+      cpaXY = candidate.cpaXY();
+      decayLength = candidate.decayLength();
+      decayLengthXY = candidate.decayLengthXY();
+    }
     // product of daughter impact parameters
-    if (candidate.impactParameterProduct() > cuts->get(pTBin, "d0d0")) {
+    if (candidate.impactParameterProduct() > cutsCompiled.get(pTBin, CutD0D0)) {
       return false;
     }
     // cosine of pointing angle
-    if (candidate.cpa() < cuts->get(pTBin, "cos pointing angle")) {
+    if (cpa < cutsCompiled.get(pTBin, CutCpa)) {
       return false;
     }
     // cosine of pointing angle XY
-    if (candidate.cpaXY() < cuts->get(pTBin, "cos pointing angle xy")) {
+    if (cpaXY < cutsCompiled.get(pTBin, CutCpaXY)) {
       return false;
     }
     // normalised decay length in XY plane
-    if (candidate.decayLengthXYNormalised() < cuts->get(pTBin, "normalized decay length XY")) {
+    if (candidate.decayLengthXYNormalised() < cutsCompiled.get(pTBin, CutDecLenXYNorm)) {
       return false;
     }
     // candidate DCA
@@ -102,14 +140,14 @@ struct HFD0CandidateSelector {
     if (std::abs(candidate.impactParameterNormalised0()) < 0.5 || std::abs(candidate.impactParameterNormalised1()) < 0.5) {
       return false;
     }
-    double decayLengthCut = std::min((candidate.p() * 0.0066) + 0.01, cuts->get(pTBin, "minimum decay length"));
-    if (candidate.decayLength() * candidate.decayLength() < decayLengthCut * decayLengthCut) {
+    double decayLengthCut = std::min((candidate.p() * 0.0066) + 0.01, cutsCompiled.get(pTBin, CutDecLenMin));
+    if (decayLength * decayLength < decayLengthCut * decayLengthCut) {
       return false;
     }
-    if (candidate.decayLength() > cuts->get(pTBin, "decay length")) {
+    if (decayLength > cutsCompiled.get(pTBin, CutDecLen)) {
       return false;
     }
-    if (candidate.decayLengthXY() > cuts->get(pTBin, "decay length XY")) {
+    if (decayLengthXY > cutsCompiled.get(pTBin, CutDecLenXY)) {
       return false;
     }
     if (candidate.decayLengthNormalised() * candidate.decayLengthNormalised() < 1.0) {
@@ -119,56 +157,58 @@ struct HFD0CandidateSelector {
   }
 
   /// Conjugate-dependent topological cuts
+  /// \tparam useKinematics reads the kinematics from the HfCandProng2Kine table instead of computing them
   /// \param candidate is candidate
   /// \param trackPion is the track with the pion hypothesis
   /// \param trackKaon is the track with the kaon hypothesis
+  /// \param pTBin is the pT bin of the candidate
   /// \note trackPion = positive and trackKaon = negative for D0 selection and inverse for D0bar
   /// \return true if candidate passes all cuts for the given Conjugate
-  template <typename T1, typename T2>
-  bool selectionTopolConjugate(const T1& candidate, const T2& trackPion, const T2& trackKaon)
+  template <bool useKinematics, typename T1, typename T2>
+  bool selectionTopolConjugate(const T1& candidate, const T2& trackPion, const T2& trackKaon, int pTBin)
   {
-    auto candpT = candidate.pt();
-    auto pTBin = findBin(pTBins, candpT);
     if (pTBin == -1) {
       return false;
     }
 
-    // invariant-mass cut
-    if (trackPion.sign() > 0) {
-      if (std::abs(InvMassD0(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cuts->get(pTBin, "m")) {
-        return false;
-      }
+    float invMass;
+    if constexpr (useKinematics) {
+      invMass = trackPion.sign() > 0 ? candidate.massD0() : candidate.massD0bar();
     } else {
-      if (std::abs(InvMassD0bar(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cuts->get(pTBin, "m")) {
-        return false;
-      }
+      invMass = trackPion.sign() > 0 ? InvMassD0(candidate) : InvMassD0bar(candidate);
+    }
+
+    // invariant-mass cut
+    if (std::abs(invMass - RecoDecay::getMassPDG(pdg::Code::kD0)) > cutsCompiled.get(pTBin, CutM)) {
+      return false;
     }
 
     // cut on daughter pT
-    if (trackPion.pt() < cuts->get(pTBin, "pT Pi") || trackKaon.pt() < cuts->get(pTBin, "pT K")) {
+    if (trackPion.pt() < cutsCompiled.get(pTBin, CutPtPi) || trackKaon.pt() < cutsCompiled.get(pTBin, CutPtK)) {
       return false;
     }
 
     // cut on daughter DCA - need to add secondary vertex constraint here
-    if (std::abs(trackPion.dcaXY()) > cuts->get(pTBin, "d0pi") || std::abs(trackKaon.dcaXY()) > cuts->get(pTBin, "d0K")) {
+    if (std::abs(trackPion.dcaXY()) > cutsCompiled.get(pTBin, CutD0Pi) || std::abs(trackKaon.dcaXY()) > cutsCompiled.get(pTBin, CutD0K)) {
       return false;
     }
 
     // cut on cos(theta*)
-    if (trackPion.sign() > 0) {
-      if (std::abs(CosThetaStarD0(candidate)) > cuts->get(pTBin, "cos theta*")) {
-        return false;
-      }
+    float cosThetaStar;
+    if constexpr (useKinematics) {
+      cosThetaStar = trackPion.sign() > 0 ? candidate.cosThetaStarD0() : candidate.cosThetaStarD0bar();
     } else {
-      if (std::abs(CosThetaStarD0bar(candidate)) > cuts->get(pTBin, "cos theta*")) {
-        return false;
-      }
+      cosThetaStar = trackPion.sign() > 0 ? CosThetaStarD0(candidate) : CosThetaStarD0bar(candidate);
+    }
+    if (std::abs(cosThetaStar) > cutsCompiled.get(pTBin, CutCosThetaStar)) {
+      return false;
     }
 
     return true;
   }
 
-  void process(aod::HfCandProng2 const& candidates, aod::BigTracksPIDExtended const&)
+  template <bool useKinematics, typename TCandidates>
+  void runSelection(TCandidates const& candidates, aod::BigTracksPIDExtended const& tracks)
   {
     TrackSelectorPID selectorPion(kPiPlus);
     selectorPion.setRangePtTPC(d_pidTPCMinpT, d_pidTPCMaxpT);
@@ -181,6 +221,12 @@ struct HFD0CandidateSelector {
     TrackSelectorPID selectorKaon(selectorPion);
     selectorKaon.setPDG(kKPlus);
 
+    // PID statuses of the daughters, shared by the candidates
+    TrackSelectorPIDCache pidCachePion(selectorPion);
+    TrackSelectorPIDCache pidCacheKaon(selectorKaon);
+    pidCachePion.reset(tracks.size());
+    pidCacheKaon.reset(tracks.size());
+
     // looping over 2-prong candidates
     for (auto& candidate : candidates) {
 
@@ -209,7 +255,8 @@ struct HFD0CandidateSelector {
       */
 
       // conjugate-independent topological selection
-      if (!selectionTopol(candidate)) {
+      auto pTBin = cutsCompiled.findBin(candidate.pt());
+      if (!selectionTopol<useKinematics>(candidate, pTBin)) {
         hfSelD0Candidate(statusD0, statusD0bar, statusHFFlag, statusTopol, statusCand, statusPID);
         continue;
       }
@@ -219,9 +266,9 @@ struct HFD0CandidateSelector {
       // need to add special cuts (additional cuts on decay length and d0 norm)
 
       // conjugate-dependent topological selection for D0
-      bool topolD0 = selectionTopolConjugate(candidate, trackPos, trackNeg);
+      bool topolD0 = selectionTopolConjugate<useKinematics>(candidate, trackPos, trackNeg, pTBin);
       // conjugate-dependent topological selection for D0bar
-      bool topolD0bar = selectionTopolConjugate(candidate, trackNeg, trackPos);
+      bool topolD0bar = selectionTopolConjugate<useKinematics>(candidate, trackNeg, trackPos, pTBin);
 
       if (!topolD0 && !topolD0bar) {
         hfSelD0Candidate(statusD0, statusD0bar, statusHFFlag, statusTopol, statusCand, statusPID);
@@ -230,10 +277,10 @@ struct HFD0CandidateSelector {
       statusCand = 1;
 
       // track-level PID selection
-      int pidTrackPosKaon = selectorKaon.getStatusTrackPIDAll(trackPos);
-      int pidTrackPosPion = selectorPion.getStatusTrackPIDAll(trackPos);
-      int pidTrackNegKaon = selectorKaon.getStatusTrackPIDAll(trackNeg);
-      int pidTrackNegPion = selectorPion.getStatusTrackPIDAll(trackNeg);
+      int pidTrackPosKaon = pidCacheKaon.getStatusTrackPIDAll(trackPos);
+      int pidTrackPosPion = pidCachePion.getStatusTrackPIDAll(trackPos);
+      int pidTrackNegKaon = pidCacheKaon.getStatusTrackPIDAll(trackNeg);
+      int pidTrackNegPion = pidCachePion.getStatusTrackPIDAll(trackNeg);
 
       int pidD0 = -1;
       int pidD0bar = -1;
@@ -273,6 +320,18 @@ struct HFD0CandidateSelector {
       hfSelD0Candidate(statusD0, statusD0bar, statusHFFlag, statusTopol, statusCand, statusPID);
     }
   }
+
+  void processCandidates(aod::HfCandProng2 const& candidates, aod::BigTracksPIDExtended const& tracks)
+  {
+    runSelection<false>(candidates, tracks);
+  }
+  PROCESS_SWITCH(HFD0CandidateSelector, processCandidates, "Compute the candidate kinematics in the selection", true);
+
+  void processWithKinematics(soa::Join<aod::HfCandProng2, aod::HfCandProng2Kine> const& candidates, aod::BigTracksPIDExtended const& tracks)
+  {
+    runSelection<true>(candidates, tracks);
+  }
+  PROCESS_SWITCH(HFD0CandidateSelector, processWithKinematics, "Read the candidate kinematics stored by hf-cand-creator-2prong-expressions (processKinematics)", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
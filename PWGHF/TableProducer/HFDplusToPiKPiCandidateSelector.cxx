@@ -105,7 +105,7 @@ struct HFDplusToPiKPiCandidateSelector {
     return true;
   }
 
-  void process(aod::HfCandProng3 const& candidates, aod::BigTracksPID const&)
+  void process(aod::HfCandProng3 const& candidates, aod::BigTracksPID const& tracks)
   {
     TrackSelectorPID selectorPion(kPiPlus);
     selectorPion.setRangePtTPC(d_pidTPCMinpT, d_pidTPCMaxpT);
@@ -116,6 +116,12 @@ struct HFDplusToPiKPiCandidateSelector {
     TrackSelectorPID selectorKaon(selectorPion);
     selectorKaon.setPDG(kKPlus);
 
+    // PID statuses of the daughters, shared by the candidates
+    TrackSelectorPIDCache pidCachePion(selectorPion);
+    TrackSelectorPIDCache pidCacheKaon(selectorKaon);
+    pidCachePion.reset(tracks.size());
+    pidCacheKaon.reset(tracks.size());
+
     // looping over 3-prong candidates
     for (auto& candidate : candidates) {
 
@@ -150,9 +156,9 @@ struct HFDplusToPiKPiCandidateSelector {
       SETBIT(statusDplusToPiKPi, aod::SelectionStep::RecoTopol);
 
       // track-level PID selection
-      int pidTrackPos1Pion = selectorPion.getStatusTrackPIDAll(trackPos1);
-      int pidTrackNegKaon = selectorKaon.getStatusTrackPIDAll(trackNeg);
-      int pidTrackPos2Pion = selectorPion.getStatusTrackPIDAll(trackPos2);
+      int pidTrackPos1Pion = pidCachePion.getStatusTrackPIDAll(trackPos1);
+      int pidTrackNegKaon = pidCacheKaon.getStatusTrackPIDAll(trackNeg);
+      int pidTrackPos2Pion = pidCachePion.getStatusTrackPIDAll(trackPos2);
 
       if (pidTrackPos1Pion == TrackSelectorPID::Status::PIDRejected ||
           pidTrackNegKaon == TrackSelectorPID::Status::PIDRejected ||
@@ -53,6 +53,21 @@ struct HFLcCandidateSelector {
   Configurable<std::vector<double>> pTBins{"pTBins", std::vector<double>{hf_cuts_lc_topkpi::pTBins_v}, "pT bin limits"};
   Configurable<LabeledArray<double>> cuts{"Lc_to_p_K_pi_cuts", {hf_cuts_lc_topkpi::cuts[0], npTBins, nCutVars, pTBinLabels, cutVarLabels}, "Lc candidate selection per pT bin"};
 
+  // cut variables used by the selection, in the order of their indices in the compiled cuts
+  enum CutIndex { CutM = 0,
+                  CutPtP,
+                  CutPtK,
+                  CutPtPi,
+                  CutCpa,
+                  CutChi2PCA,
+                  CutDecLen };
+  PtBinnedCuts cutsCompiled; // cuts resolved by index at init
+
+  void init(InitContext const&)
+  {
+    cutsCompiled.compile(pTBins, cuts, {"m", "pT p", "pT K", "pT Pi", "cos pointing angle", "Chi2PCA", "decay length"});
+  }
+
   /*
   /// Selection on goodness of daughter tracks
   /// \note should be applied at candidate selection
@@ -70,13 +85,13 @@ struct HFLcCandidateSelector {
 
   /// Conjugate-independent topological cuts
   /// \param candidate is candidate
+  /// \param pTBin is the pT bin of the candidate
   /// \return true if candidate passes all cuts
   template <typename T>
-  bool selectionTopol(const T& candidate)
+  bool selectionTopol(const T& candidate, int pTBin)
   {
     auto candpT = candidate.pt();
 
-    int pTBin = findBin(pTBins, candpT);
     if (pTBin == -1) {
       return false;
     }
@@ -87,16 +102,16 @@ struct HFLcCandidateSelector {
     }
 
     // cosine of pointing angle
-    if (candidate.cpa() <= cuts->get(pTBin, "cos pointing angle")) {
+    if (candidate.cpa() <= cutsCompiled.get(pTBin, CutCpa)) {
       return false;
     }
 
     //candidate chi2PCA
-    if (candidate.chi2PCA() > cuts->get(pTBin, "Chi2PCA")) {
+    if (candidate.chi2PCA() > cutsCompiled.get(pTBin, CutChi2PCA)) {
       return false;
     }
 
-    if (candidate.decayLength() <= cuts->get(pTBin, "decay length")) {
+    if (candidate.decayLength() <= cutsCompiled.get(pTBin, CutDecLen)) {
       return false;
     }
     return true;
@@ -107,28 +122,26 @@ struct HFLcCandidateSelector {
   /// \param trackProton is the track with the proton hypothesis
   /// \param trackPion is the track with the pion hypothesis
   /// \param trackKaon is the track with the kaon hypothesis
+  /// \param pTBin is the pT bin of the candidate
   /// \return true if candidate passes all cuts for the given Conjugate
   template <typename T1, typename T2>
-  bool selectionTopolConjugate(const T1& candidate, const T2& trackProton, const T2& trackKaon, const T2& trackPion)
+  bool selectionTopolConjugate(const T1& candidate, const T2& trackProton, const T2& trackKaon, const T2& trackPion, int pTBin)
   {
-
-    auto candpT = candidate.pt();
-    int pTBin = findBin(pTBins, candpT);
     if (pTBin == -1) {
       return false;
     }
 
     // cut on daughter pT
-    if (trackProton.pt() < cuts->get(pTBin, "pT p") || trackKaon.pt() < cuts->get(pTBin, "pT K") || trackPion.pt() < cuts->get(pTBin, "pT Pi")) {
+    if (trackProton.pt() < cutsCompiled.get(pTBin, CutPtP) || trackKaon.pt() < cutsCompiled.get(pTBin, CutPtK) || trackPion.pt() < cutsCompiled.get(pTBin, CutPtPi)) {
       return false;
     }
 
     if (trackProton.globalIndex() == candidate.index0Id()) {
-      if (std::abs(InvMassLcpKpi(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cuts->get(pTBin, "m")) {
+      if (std::abs(InvMassLcpKpi(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cutsCompiled.get(pTBin, CutM)) {
         return false;
       }
     } else {
-      if (std::abs(InvMassLcpiKp(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cuts->get(pTBin, "m")) {
+      if (std::abs(InvMassLcpiKp(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cutsCompiled.get(pTBin, CutM)) {
         return false;
       }
     }
@@ -138,7 +151,7 @@ struct HFLcCandidateSelector {
 
   using TrksPID = soa::Join<aod::BigTracksPID, aod::pidBayesPi, aod::pidBayesKa, aod::pidBayesPr, aod::pidBayes>;
 
-  void process(aod::HfCandProng3 const& candidates, TrksPID const&)
+  void process(aod::HfCandProng3 const& candidates, TrksPID const& tracks)
   {
     TrackSelectorPID selectorPion(kPiPlus);
     selectorPion.setRangePtTPC(d_pidTPCMinpT, d_pidTPCMaxpT);
@@ -155,6 +168,14 @@ struct HFLcCandidateSelector {
     TrackSelectorPID selectorProton(selectorPion);
     selectorProton.setPDG(kProton);
 
+    // PID statuses of the daughters, shared by the candidates
+    TrackSelectorPIDCache pidCachePion(selectorPion);
+    TrackSelectorPIDCache pidCacheKaon(selectorKaon);
+    TrackSelectorPIDCache pidCacheProton(selectorProton);
+    pidCachePion.reset(tracks.size());
+    pidCacheKaon.reset(tracks.size());
+    pidCacheProton.reset(tracks.size());
+
     // looping over 3-prong candidates
     for (auto& candidate : candidates) {
 
@@ -182,15 +203,16 @@ struct HFLcCandidateSelector {
       // implement filter bit 4 cut - should be done before this task at the track selection level
 
       // conjugate-independent topological selection
-      if (!selectionTopol(candidate)) {
+      auto pTBin = cutsCompiled.findBin(candidate.pt());
+      if (!selectionTopol(candidate, pTBin)) {
         hfSelLcCandidate(statusLcpKpi, statusLcpiKp);
         continue;
       }
 
       // conjugate-dependent topological selection for Lc
 
-      bool topolLcpKpi = selectionTopolConjugate(candidate, trackPos1, trackNeg, trackPos2);
-      bool topolLcpiKp = selectionTopolConjugate(candidate, trackPos2, trackNeg, trackPos1);
+      bool topolLcpKpi = selectionTopolConjugate(candidate, trackPos1, trackNeg, trackPos2, pTBin);
+      bool topolLcpiKp = selectionTopolConjugate(candidate, trackPos2, trackNeg, trackPos1, pTBin);
 
       if (!topolLcpKpi && !topolLcpiKp) {
         hfSelLcCandidate(statusLcpKpi, statusLcpiKp);
@@ -208,11 +230,11 @@ struct HFLcCandidateSelector {
         pidLcpiKp = 1;
       } else {
         // track-level PID selection
-        int pidTrackPos1Proton = selectorProton.getStatusTrackPIDAll(trackPos1);
-        int pidTrackPos2Proton = selectorProton.getStatusTrackPIDAll(trackPos2);
-        int pidTrackPos1Pion = selectorPion.getStatusTrackPIDAll(trackPos1);
-        int pidTrackPos2Pion = selectorPion.getStatusTrackPIDAll(trackPos2);
-        int pidTrackNegKaon = selectorKaon.getStatusTrackPIDAll(trackNeg);
+        int pidTrackPos1Proton = pidCacheProton.getStatusTrackPIDAll(trackPos1);
+        int pidTrackPos2Proton = pidCacheProton.getStatusTrackPIDAll(trackPos2);
+        int pidTrackPos1Pion = pidCachePion.getStatusTrackPIDAll(trackPos1);
+        int pidTrackPos2Pion = pidCachePion.getStatusTrackPIDAll(trackPos2);
+        int pidTrackNegKaon = pidCacheKaon.getStatusTrackPIDAll(trackNeg);
 
         if (pidTrackPos1Proton == TrackSelectorPID::Status::PIDAccepted &&
             pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
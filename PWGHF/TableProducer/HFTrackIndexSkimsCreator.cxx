@@ -21,6 +21,8 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/DCAFitterCache.h"
+#include "Common/Core/ThreadPool.h"
 #include "Common/DataModel/EventSelection.h"
 //#include "Common/DataModel/Centrality.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
@@ -33,8 +35,11 @@
 #include "DataFormatsParameters/GRPObject.h"  // for PV refit
 #include "DetectorsBase/Propagator.h"         // for PV refit
 #include "DetectorsBase/GeometryManager.h"    // for PV refit
+#include "Common/Core/VertexDowndating.h"     // for PV refit
 
 #include <algorithm>
+#include <functional>
+#include <tuple>
 
 using namespace o2;
 using namespace o2::framework;
@@ -77,6 +82,38 @@ void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 
 #include "Framework/runDataProcessing.h"
 
+/// Removes the PV contributors not used from the vertex of the collision, with an analytic downdating of its fit
+/// \param collision is the collision with the vertex to downdate
+/// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the collision
+/// \param vecPvRefitContributorUsed is a vector with the contributors to keep set to true
+/// \param vtx is the downdated vertex
+/// \return false if the downdated vertex is not valid, e.g. with too few contributors left
+bool downdatePv(aod::Collision const& collision,
+                std::vector<o2::track::TrackParCov> const& vecPvContributorTrackParCov,
+                std::vector<bool> const& vecPvRefitContributorUsed,
+                o2::dataformats::VertexBase& vtx)
+{
+  o2::analysis::VertexDowndating downdating;
+  if (!downdating.setVertex({collision.posX(), collision.posY(), collision.posZ()}, {collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ()})) {
+    return false;
+  }
+  for (std::size_t i = 0; i < vecPvContributorTrackParCov.size(); i++) {
+    if (!vecPvRefitContributorUsed[i]) {
+      downdating.removeTrack(vecPvContributorTrackParCov[i]);
+    }
+  }
+  std::array<float, 3> pos;
+  std::array<float, 6> cov;
+  if (!downdating.getVertex(pos, cov)) {
+    return false;
+  }
+  vtx.setX(pos[0]);
+  vtx.setY(pos[1]);
+  vtx.setZ(pos[2]);
+  vtx.setCov(cov[0], cov[1], cov[2], cov[3], cov[4], cov[5]);
+  return true;
+}
+
 //#define MY_DEBUG
 
 #ifdef MY_DEBUG
@@ -245,6 +282,8 @@ struct HfTagSelTracks {
   Configurable<bool> debug{"debug", true, "debug mode"};
   Configurable<double> bz{"bz", 5., "bz field"};
   Configurable<bool> doPvRefit{"doPvRefit", false, "do PV refit excluding the considered track"};
+  Configurable<bool> doPvRefitDowndating{"doPvRefitDowndating", false, "remove the tracks from the PV with an analytic downdating of the stored vertex fit instead of a PVertexer refit"};
+  Configurable<bool> validatePvRefitDowndating{"validatePvRefitDowndating", false, "with doPvRefitDowndating, run also the PVertexer refit, keep its result and fill the differences with the downdated PV"};
   // quality cut
   Configurable<bool> doCutQuality{"doCutQuality", true, "apply quality cuts"};
   Configurable<bool> useIsGlobalTrack{"useIsGlobalTrack", false, "check isGlobalTrack status for tracks, for Run3 studies"};
@@ -346,6 +385,11 @@ struct HfTagSelTracks {
       registry.add("PvRefit/hPvRefitZChi2Minus1", "PV refit with #it{#chi}^{2}==#minus1", kTH2D, {axisCollisionZ, axisCollisionZOriginal});
       registry.add("PvRefit/hNContribPvRefitNotDoable", "N. contributors for PV refit not doable", kTH1D, {axisCollisionNContrib});
       registry.add("PvRefit/hNContribPvRefitChi2Minus1", "N. contributors orginal PV for PV refit #it{#chi}^{2}==#minus1", kTH1D, {axisCollisionNContrib});
+      if (doPvRefitDowndating && validatePvRefitDowndating) {
+        registry.add("PvRefit/hPvDowndatingDeltaXvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaX});
+        registry.add("PvRefit/hPvDowndatingDeltaYvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaY});
+        registry.add("PvRefit/hPvDowndatingDeltaZvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaZ});
+      }
 
       ccdb->setURL(ccdbUrl);
       ccdb->setCaching(true);
@@ -398,10 +442,10 @@ struct HfTagSelTracks {
                            std::array<float, 2>& dcaXYdcaZ)
   {
     std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
+    auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myTrack.globalIndex()); /// track global index
 
     /// Prepare the vertex refitting
     // Get the magnetic field for the Propagator
-    o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
     auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
     if (mRunNumber != bc.runNumber()) {
       auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbPathGrp, bc.timestamp());
@@ -415,6 +459,24 @@ struct HfTagSelTracks {
       mRunNumber = bc.runNumber();
     }
 
+    /// analytic downdating of the stored vertex, without PVertexer unless it is validated against it
+    o2::dataformats::VertexBase primVtxDowndated;
+    bool isDowndated = false;
+    if (doPvRefit && doPvRefitDowndating && trackIterator != vecPvContributorGlobId.end()) {
+      const int entry = std::distance(vecPvContributorGlobId.begin(), trackIterator);
+      vecPvRefitContributorUsed[entry] = false;
+      isDowndated = downdatePv(collision, vecPvContributorTrackParCov, vecPvRefitContributorUsed, primVtxDowndated);
+      vecPvRefitContributorUsed[entry] = true;
+    }
+    if (doPvRefit && doPvRefitDowndating && !validatePvRefitDowndating) {
+      registry.fill(HIST("PvRefit/hVerticesPerTrack"), 1);
+      if (isDowndated) {
+        registry.fill(HIST("PvRefit/hVerticesPerTrack"), 3);
+        propagateToRefittedPv(myTrack, primVtxDowndated, pvCoord, pvCovMatrix, dcaXYdcaZ);
+      }
+      return;
+    }
+
     // build the VertexBase to initialize the vertexer
     o2::dataformats::VertexBase primVtx;
     primVtx.setX(collision.posX());
@@ -445,7 +507,6 @@ struct HfTagSelTracks {
     bool recalcImpPar = false;
     if (doPvRefit && pvRefitDoable) {
       recalcImpPar = true;
-      auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myTrack.globalIndex()); /// track global index
       if (trackIterator != vecPvContributorGlobId.end()) {
 
         /// this track contributed to the PV fit: let's do the refit without it
@@ -482,6 +543,11 @@ struct HfTagSelTracks {
           registry.fill(HIST("PvRefit/hPvDeltaXvsNContrib"), primVtxRefitted.getNContributors(), deltaX);
           registry.fill(HIST("PvRefit/hPvDeltaYvsNContrib"), primVtxRefitted.getNContributors(), deltaY);
           registry.fill(HIST("PvRefit/hPvDeltaZvsNContrib"), primVtxRefitted.getNContributors(), deltaZ);
+          if (isDowndated) {
+            registry.fill(HIST("PvRefit/hPvDowndatingDeltaXvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getX() - primVtxDowndated.getX());
+            registry.fill(HIST("PvRefit/hPvDowndatingDeltaYvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getY() - primVtxDowndated.getY());
+            registry.fill(HIST("PvRefit/hPvDowndatingDeltaZvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getZ() - primVtxDowndated.getZ());
+          }
 
           // fill the newly calculated PV
           primVtxBaseRecalc.setX(primVtxRefitted.getX());
@@ -497,24 +563,7 @@ struct HfTagSelTracks {
     // updated value after PV recalculation
     if (recalcImpPar) {
 
-      /// Track propagation to the PV refit considering also the material budget
-      /// Mandatory for tracks updated at most only to the innermost ITS layer
-      auto trackPar = getTrackPar(myTrack);
-      o2::gpu::gpustd::array<float, 2> dcaInfo{-999., -999.};
-      if (o2::base::Propagator::Instance()->propagateToDCABxByBz({primVtxBaseRecalc.getX(), primVtxBaseRecalc.getY(), primVtxBaseRecalc.getZ()}, trackPar, 2.f, matCorr, &dcaInfo)) {
-        pvCoord[0] = primVtxBaseRecalc.getX();
-        pvCoord[1] = primVtxBaseRecalc.getY();
-        pvCoord[2] = primVtxBaseRecalc.getZ();
-        pvCovMatrix[0] = primVtxBaseRecalc.getSigmaX2();
-        pvCovMatrix[1] = primVtxBaseRecalc.getSigmaXY();
-        pvCovMatrix[2] = primVtxBaseRecalc.getSigmaY2();
-        pvCovMatrix[3] = primVtxBaseRecalc.getSigmaXZ();
-        pvCovMatrix[4] = primVtxBaseRecalc.getSigmaYZ();
-        pvCovMatrix[5] = primVtxBaseRecalc.getSigmaZ2();
-        dcaXYdcaZ[0] = dcaInfo[0]; // [cm]
-        dcaXYdcaZ[1] = dcaInfo[1]; // [cm]
-        // TODO: add DCAxy and DCAz uncertainties?
-      }
+      propagateToRefittedPv(myTrack, primVtxBaseRecalc, pvCoord, pvCovMatrix, dcaXYdcaZ);
 
       /// Track propagation to the PV refit done only ia geometrical way
       /// Correct only if no further material budget is crossed, namely for tracks already propagated to the original PV
@@ -541,6 +590,39 @@ struct HfTagSelTracks {
     return;
   } /// end of performPvRefitTrack function
 
+  /// Propagates a track to the refitted PV and stores the PV and the DCAs
+  /// \param myTrack is the track to propagate
+  /// \param primVtxBaseRecalc is the refitted PV
+  /// \param pvCoord is an array containing the coordinates of the refitted PV
+  /// \param pvCovMatrix is an array containing the covariance matrix values of the refitted PV
+  /// \param dcaXYdcaZ is an array containing the dcaXY and dcaZ of myTrack with respect to the refitted PV
+  void propagateToRefittedPv(BigTracks::iterator const& myTrack,
+                             o2::dataformats::VertexBase const& primVtxBaseRecalc,
+                             std::array<float, 3>& pvCoord,
+                             std::array<float, 6>& pvCovMatrix,
+                             std::array<float, 2>& dcaXYdcaZ)
+  {
+    /// Track propagation to the PV refit considering also the material budget
+    /// Mandatory for tracks updated at most only to the innermost ITS layer
+    o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
+    auto trackPar = getTrackPar(myTrack);
+    o2::gpu::gpustd::array<float, 2> dcaInfo{-999., -999.};
+    if (o2::base::Propagator::Instance()->propagateToDCABxByBz({primVtxBaseRecalc.getX(), primVtxBaseRecalc.getY(), primVtxBaseRecalc.getZ()}, trackPar, 2.f, matCorr, &dcaInfo)) {
+      pvCoord[0] = primVtxBaseRecalc.getX();
+      pvCoord[1] = primVtxBaseRecalc.getY();
+      pvCoord[2] = primVtxBaseRecalc.getZ();
+      pvCovMatrix[0] = primVtxBaseRecalc.getSigmaX2();
+      pvCovMatrix[1] = primVtxBaseRecalc.getSigmaXY();
+      pvCovMatrix[2] = primVtxBaseRecalc.getSigmaY2();
+      pvCovMatrix[3] = primVtxBaseRecalc.getSigmaXZ();
+      pvCovMatrix[4] = primVtxBaseRecalc.getSigmaYZ();
+      pvCovMatrix[5] = primVtxBaseRecalc.getSigmaZ2();
+      dcaXYdcaZ[0] = dcaInfo[0]; // [cm]
+      dcaXYdcaZ[1] = dcaInfo[1]; // [cm]
+      // TODO: add DCAxy and DCAz uncertainties?
+    }
+  }
+
   /// Partition for PV contributors
   Partition<MY_TYPE1> pvContributors = ((aod::track::flags & (uint32_t)aod::track::PVContributor) == (uint32_t)aod::track::PVContributor);
 
@@ -809,14 +891,20 @@ struct HfTrackIndexSkimsCreator {
   Produces<aod::Hf3Prongs> rowTrackIndexProng3;
   Produces<aod::HfCutStatusProng3> rowProng3CutStatus;
   Produces<aod::HfPvRefitProng3> rowProng3PVrefit;
+  Produces<aod::HfSkimVtxProng2> rowProng2Vertex;
+  Produces<aod::HfSkimVtxProng3> rowProng3Vertex;
 
   // Configurable<int> nCollsMax{"nCollsMax", -1, "Max collisions per file"}; //can be added to run over limited collisions per file - for tesing purposes
   Configurable<bool> debug{"debug", false, "debug mode"};
   Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
   Configurable<int> do3prong{"do3prong", 0, "do 3 prong"};
   Configurable<bool> doPvRefit{"doPvRefit", false, "do PV refit excluding the considered track"};
+  Configurable<bool> doPvRefitDowndating{"doPvRefitDowndating", false, "remove the tracks from the PV with an analytic downdating of the stored vertex fit instead of a PVertexer refit"};
+  Configurable<bool> validatePvRefitDowndating{"validatePvRefitDowndating", false, "with doPvRefitDowndating, run also the PVertexer refit, keep its result and fill the differences with the downdated PV"};
   // preselection parameters
   Configurable<double> pTTolerance{"pTTolerance", 0.1, "pT tolerance in GeV/c for applying preselections before vertex reconstruction"};
+  Configurable<bool> useHelixPreselection{"useHelixPreselection", false, "apply 2-prong cosp preselections on the helix crossing estimate of the secondary vertex before vertex reconstruction"};
+  Configurable<double> cospTolerance{"cospTolerance", 0.1, "cosp tolerance for applying preselections on the helix crossing estimate of the secondary vertex"};
   // vertexing parameters
   Configurable<double> bz{"bz", 5., "magnetic field kG"};
   Configurable<bool> propToDCA{"propToDCA", true, "create tracks version propagated to PCA"};
@@ -825,6 +913,9 @@ struct HfTrackIndexSkimsCreator {
   Configurable<double> maxDZIni{"maxDZIni", 4., "reject (if>0) PCA candidate if tracks DZ exceeds threshold"};
   Configurable<double> minParamChange{"minParamChange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
   Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations if chi2/chi2old > this"};
+  Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "max. number of chunks of the preselected combinations whose secondary vertices are reconstructed in parallel"};
+  Configurable<int> coreBudget{"coreBudget", 0, "cores used by the thread pool of the device, this thread included (0: cores of the process or O2PHYSICS_CORE_BUDGET)"};
+  Configurable<bool> fillSkimVertices{"fillSkimVertices", false, "store the fitted secondary vertices, for the candidate creators to skip the refit"};
   // D0 cuts
   Configurable<std::vector<double>> pTBinsD0ToPiK{"pTBinsD0ToPiK", std::vector<double>{hf_cuts_presel_2prong::pTBinsVec}, "pT bin limits for D0->piK pT-depentend cuts"};
   Configurable<LabeledArray<double>> cutsD0ToPiK{"cutsD0ToPiK", {hf_cuts_presel_2prong::cuts[0], hf_cuts_presel_2prong::npTBins, hf_cuts_presel_2prong::nCutVars, hf_cuts_presel_2prong::pTBinLabels, hf_cuts_presel_2prong::cutVarLabels}, "D0->piK selections per pT bin"};
@@ -888,6 +979,7 @@ struct HfTrackIndexSkimsCreator {
   static const int n3ProngDecays = hf_cand_prong3::DecayType::N3ProngDecays; // number of 3-prong hadron types
   static const int nCuts2Prong = 4;                                          // how many different selections are made on 2-prongs
   static const int nCuts3Prong = 4;                                          // how many different selections are made on 3-prongs
+  static const int nCombinationsPerThreadMin = 50;                           // min. number of prong combinations per vertexing thread
 
   std::array<std::array<std::array<double, 2>, 2>, n2ProngDecays> arrMass2Prong;
   std::array<std::array<std::array<double, 3>, 2>, n3ProngDecays> arrMass3Prong;
@@ -898,8 +990,20 @@ struct HfTrackIndexSkimsCreator {
   std::array<LabeledArray<double>, n3ProngDecays> cut3Prong;
   std::array<std::vector<double>, n3ProngDecays> pTBins3Prong;
 
+  // vertex fitters, updated only when the magnetic field changes
+  o2::analysis::DCAFitterCache<2> df2Cache;
+  o2::analysis::DCAFitterCache<3> df3Cache;
+
+  // lowest pT lower edge among the 2-prong and 3-prong pT bins, used to stop the combinatorial loops early
+  double pTMinCand2Prong = 0.;
+  double pTMinCand3Prong = 0.;
+
   void init(InitContext const&)
   {
+    if (coreBudget > 0) {
+      o2::analysis::ThreadPool::instance().setCoreBudget(coreBudget);
+    }
+
     arrMass2Prong[hf_cand_prong2::DecayType::D0ToPiK] = array{array{massPi, massK},
                                                               array{massK, massPi}};
 
@@ -928,6 +1032,27 @@ struct HfTrackIndexSkimsCreator {
     cut3Prong = {cutsDPlusToPiKPi, cutsLcToPKPi, cutsDsToPiKK, cutsXicToPKPi};
     pTBins3Prong = {pTBinsDPlusToPiKPi, pTBinsLcToPKPi, pTBinsDsToPiKK, pTBinsXicToPKPi};
 
+    // 2-prong and 3-prong vertex fitters
+    o2::analysis::DCAFitterSettings fitterSettings;
+    fitterSettings.propagateToPCA = propToDCA;
+    fitterSettings.maxR = maxRad;
+    fitterSettings.maxDZIni = maxDZIni;
+    fitterSettings.minParamChange = minParamChange;
+    fitterSettings.minRelChi2Change = minRelChi2Change;
+    fitterSettings.useAbsDCA = useAbsDCA;
+    df2Cache.configure(fitterSettings);
+    df3Cache.configure(fitterSettings);
+
+    // the candidate pT cannot exceed the scalar sum of the prong pT, so below these values no pT bin can be reached
+    pTMinCand2Prong = pTBins2Prong[0].front();
+    for (const auto& pTBins : pTBins2Prong) {
+      pTMinCand2Prong = std::min(pTMinCand2Prong, pTBins.front());
+    }
+    pTMinCand3Prong = pTBins3Prong[0].front();
+    for (const auto& pTBins : pTBins3Prong) {
+      pTMinCand3Prong = std::min(pTMinCand3Prong, pTBins.front());
+    }
+
     // needed for PV refitting
     if (doPvRefit) {
       AxisSpec axisCollisionX{100, -20.f, 20.f, "X (cm)"};
@@ -956,6 +1081,11 @@ struct HfTrackIndexSkimsCreator {
       registry.add("PvRefit/hPvRefitZChi2Minus1", "PV refit with #it{#chi}^{2}==#minus1", kTH2D, {axisCollisionZ, axisCollisionZOriginal});
       registry.add("PvRefit/hNContribPvRefitNotDoable", "N. contributors for PV refit not doable", kTH1D, {axisCollisionNContrib});
       registry.add("PvRefit/hNContribPvRefitChi2Minus1", "N. contributors orginal PV for PV refit #it{#chi}^{2}==#minus1", kTH1D, {axisCollisionNContrib});
+      if (doPvRefitDowndating && validatePvRefitDowndating) {
+        registry.add("PvRefit/hPvDowndatingDeltaXvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaX});
+        registry.add("PvRefit/hPvDowndatingDeltaYvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaY});
+        registry.add("PvRefit/hPvDowndatingDeltaZvsNContrib", "PV refit #minus downdated PV", kTH2D, {axisCollisionNContrib, axisCollisionDeltaZ});
+      }
 
       ccdb->setURL(ccdbUrl);
       ccdb->setCaching(true);
@@ -1121,6 +1251,48 @@ struct HfTrackIndexSkimsCreator {
     }
   }
 
+  /// Method to perform selections for 2-prong candidates on the helix crossing estimate of the secondary vertex, before vertex reconstruction
+  /// \param trackParVar0 is the first daughter track
+  /// \param trackParVar1 is the second daughter track
+  /// \param primVtx is the primary vertex
+  /// \param isSelected ia s bitmap with selection outcome
+  template <typename T1, typename T2>
+  void is2ProngHelixPreselected(T1 const& trackParVar0, T1 const& trackParVar1, T2 const& primVtx, int& isSelected)
+  {
+    /// FIXME: this would be better fixed by having a convention on the position of min and max in the 2D Array
+    static std::vector<int> cospIndex;
+    static auto cacheIndices = [](std::array<LabeledArray<double>, n2ProngDecays>& cut2Prong, std::vector<int>& cosp) {
+      cosp.resize(cut2Prong.size());
+      for (size_t iDecay2P = 0; iDecay2P < cut2Prong.size(); ++iDecay2P) {
+        cosp[iDecay2P] = cut2Prong[iDecay2P].colmap.find("cosp")->second;
+      }
+      return true;
+    };
+    cacheIndices(cut2Prong, cospIndex);
+
+    array<float, 3> secVtx;
+    array<float, 3> pvec0;
+    array<float, 3> pvec1;
+    if (getHelixClosestApproach(getTrackHelixXY(trackParVar0, bz), getTrackHelixXY(trackParVar1, bz), secVtx, pvec0, pvec1) < 0.f) {
+      return; // no estimate possible, leave the decision to the vertex reconstruction
+    }
+    auto pVecCand = RecoDecay::pVec(pvec0, pvec1);
+    auto cpa = RecoDecay::cpa(primVtx, secVtx, pVecCand);
+
+    for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
+      if (!TESTBIT(isSelected, iDecay2P)) {
+        continue;
+      }
+      auto pTBin = findBin(&pTBins2Prong[iDecay2P], RecoDecay::pt(pVecCand));
+      if (pTBin == -1) { // pT is checked after vertex reconstruction
+        continue;
+      }
+      if (cpa < cut2Prong[iDecay2P].get(pTBin, cospIndex[iDecay2P]) - cospTolerance) {
+        CLRBIT(isSelected, iDecay2P);
+      }
+    }
+  }
+
   /// Method to perform selections for 2-prong candidates after vertex reconstruction
   /// \param pVecCand is the array for the candidate momentum after reconstruction of secondary vertex
   /// \param secVtx is the secondary vertex
@@ -1248,6 +1420,33 @@ struct HfTrackIndexSkimsCreator {
                                 std::array<float, 6>& pvCovMatrix)
   {
     std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
+    for (uint64_t myGlobalID : vecCandPvContributorGlobId) {
+      auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myGlobalID); /// track global index
+      if (trackIterator != vecPvContributorGlobId.end()) {
+        /// this is a contributor, let's remove it for the PV refit
+        vecPvRefitContributorUsed[std::distance(vecPvContributorGlobId.begin(), trackIterator)] = false;
+      }
+    }
+
+    /// analytic downdating of the stored vertex, without PVertexer unless it is validated against it
+    o2::dataformats::VertexBase primVtxDowndated;
+    bool isDowndated = false;
+    if (doPvRefit && doPvRefitDowndating) {
+      isDowndated = downdatePv(collision, vecPvContributorTrackParCov, vecPvRefitContributorUsed, primVtxDowndated);
+      if (!validatePvRefitDowndating) {
+        registry.fill(HIST("PvRefit/verticesPerCandidate"), isDowndated ? 3 : 4);
+        if (!isDowndated) {
+          /// copy the original collision PV
+          primVtxDowndated.setX(collision.posX());
+          primVtxDowndated.setY(collision.posY());
+          primVtxDowndated.setZ(collision.posZ());
+          primVtxDowndated.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
+        }
+        pvCoord = {primVtxDowndated.getX(), primVtxDowndated.getY(), primVtxDowndated.getZ()};
+        pvCovMatrix = {primVtxDowndated.getSigmaX2(), primVtxDowndated.getSigmaXY(), primVtxDowndated.getSigmaY2(), primVtxDowndated.getSigmaXZ(), primVtxDowndated.getSigmaYZ(), primVtxDowndated.getSigmaZ2()};
+        return;
+      }
+    }
 
     /// Prepare the vertex refitting
     // Get the magnetic field for the Propagator
@@ -1295,16 +1494,7 @@ struct HfTrackIndexSkimsCreator {
     bool recalcPvRefit = false;
     if (doPvRefit && pvRefitDoable) {
       recalcPvRefit = true;
-      int nCandContr = 0;
-      for (uint64_t myGlobalID : vecCandPvContributorGlobId) {
-        auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myGlobalID); /// track global index
-        if (trackIterator != vecPvContributorGlobId.end()) {
-          /// this is a contributor, let's remove it for the PV refit
-          const int entry = std::distance(vecPvContributorGlobId.begin(), trackIterator);
-          vecPvRefitContributorUsed[entry] = false; /// remove the track from the PV refitting
-          nCandContr++;
-        }
-      }
+      const int nCandContr = std::count(vecPvRefitContributorUsed.begin(), vecPvRefitContributorUsed.end(), false);
 
       /// do the PV refit excluding the candidate daughters that originally contributed to fit it
       if (debug) {
@@ -1340,6 +1530,11 @@ struct HfTrackIndexSkimsCreator {
         registry.fill(HIST("PvRefit/hPvDeltaXvsNContrib"), primVtxRefitted.getNContributors(), deltaX);
         registry.fill(HIST("PvRefit/hPvDeltaYvsNContrib"), primVtxRefitted.getNContributors(), deltaY);
         registry.fill(HIST("PvRefit/hPvDeltaZvsNContrib"), primVtxRefitted.getNContributors(), deltaZ);
+        if (isDowndated) {
+          registry.fill(HIST("PvRefit/hPvDowndatingDeltaXvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getX() - primVtxDowndated.getX());
+          registry.fill(HIST("PvRefit/hPvDowndatingDeltaYvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getY() - primVtxDowndated.getY());
+          registry.fill(HIST("PvRefit/hPvDowndatingDeltaZvsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getZ() - primVtxDowndated.getZ());
+        }
 
         // fill the newly calculated PV
         primVtxBaseRecalc.setX(primVtxRefitted.getX());
@@ -1379,9 +1574,180 @@ struct HfTrackIndexSkimsCreator {
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HFSelCollision>>;
   using SelectedTracks = soa::Filtered<soa::Join<aod::BigTracks, aod::TracksDCA, aod::HFSelTrack, aod::HfPvRefitTrack>>;
 
-  // FIXME
-  // Partition<SelectedTracks> tracksPos = aod::track::signed1Pt > 0.f;
-  // Partition<SelectedTracks> tracksNeg = aod::track::signed1Pt < 0.f;
+  /// Prong combination passing the preselections, collected for the batched secondary-vertex reconstruction
+  template <std::size_t nProngs, int nDecays, int nCuts>
+  struct ProngCombination {
+    std::array<const SelectedTracks::iterator*, nProngs> prongs;      // daughter tracks, in the order of the output table
+    std::array<const o2::track::TrackParCov*, nProngs> trackParVars; // daughter track parameters
+    int isSelected;                                                  // bitmap with selection outcome
+    std::array<int, nDecays> whichHypo;                              // selected mass hypotheses
+    std::array<std::array<bool, nCuts>, nDecays> cutStatus;          // outcome of each selection (filled only in debug mode)
+    bool isVertexFound = false;                                      // outcome of the secondary-vertex reconstruction
+    std::array<double, 3> secondaryVertex;                           // reconstructed secondary vertex
+    std::array<std::array<float, 3>, nProngs> pVecProngs;            // daughter momenta at the secondary vertex
+    float chi2PCA;                                                   // chi2 at the secondary vertex (filled only if fillSkimVertices)
+    std::array<float, 6> covMatrixPCA;                               // covariance matrix of the secondary vertex (filled only if fillSkimVertices)
+  };
+  using Prong2Combination = ProngCombination<2, n2ProngDecays, nCuts2Prong>;
+  using Prong3Combination = ProngCombination<3, n3ProngDecays, nCuts3Prong>;
+
+  // per-collision lists of positive and negative prong candidates, sorted by decreasing pT
+  std::vector<SelectedTracks::iterator> tracksPos;
+  std::vector<SelectedTracks::iterator> tracksNeg;
+  std::vector<o2::track::TrackParCov> trackParVarsPos;
+  std::vector<o2::track::TrackParCov> trackParVarsNeg;
+  // per-collision batches of preselected combinations
+  std::vector<Prong2Combination> combinations2Prong;
+  std::vector<Prong3Combination> combinations3Prong;
+
+  /// Method to check whether a prong combination can still pass the pT preselection
+  /// \param pTSum is the scalar sum of the prong pT (upper bound of the candidate pT)
+  /// \param pTMin is the lowest pT lower edge of the considered candidate type
+  /// \return true if at least one pT bin can still be reached
+  bool isPtReachable(double pTSum, double pTMin)
+  {
+    return debug || pTSum + pTTolerance >= pTMin;
+  }
+
+  /// Method to fill the charge-separated prong lists, sorted by decreasing pT
+  /// \param tracks are the selected tracks of the current collision
+  template <typename T>
+  void fillSortedProngLists(T const& tracks)
+  {
+    tracksPos.clear();
+    tracksNeg.clear();
+    for (auto track = tracks.begin(); track != tracks.end(); ++track) {
+      if (!TESTBIT(track.isSelProng(), CandidateType::Cand2Prong) && !TESTBIT(track.isSelProng(), CandidateType::Cand3Prong)) {
+        continue;
+      }
+      if (track.signed1Pt() > 0) {
+        tracksPos.push_back(track);
+      } else if (track.signed1Pt() < 0) {
+        tracksNeg.push_back(track);
+      }
+    }
+    auto comparePt = [](const auto& track0, const auto& track1) {
+      return RecoDecay::pt(track0.pxProng(), track0.pyProng()) > RecoDecay::pt(track1.pxProng(), track1.pyProng());
+    };
+    std::stable_sort(tracksPos.begin(), tracksPos.end(), comparePt);
+    std::stable_sort(tracksNeg.begin(), tracksNeg.end(), comparePt);
+
+    trackParVarsPos.clear();
+    trackParVarsNeg.clear();
+    for (const auto& track : tracksPos) {
+      trackParVarsPos.push_back(getTrackParCov(track));
+    }
+    for (const auto& track : tracksNeg) {
+      trackParVarsNeg.push_back(getTrackParCov(track));
+    }
+  }
+
+  /// Method to reset the selection status of a prong combination
+  /// \param cutStatus is a 2D array with outcome of each selection
+  template <typename T>
+  void resetCutStatus(T& cutStatus)
+  {
+    for (auto& cutStatusDecay : cutStatus) {
+      cutStatusDecay.fill(true);
+    }
+  }
+
+  /// Method to reconstruct the secondary vertices of a batch of preselected prong combinations
+  /// The batch is split in up to nThreadsVertexing contiguous chunks fitted in parallel by the threads of the pool, each with its own copy of the fitter.
+  /// The results are stored in the combinations themselves, so the output does not depend on the number of threads.
+  /// \param fitter is the configured vertex fitter, used directly when running in a single thread
+  /// \param combinations are the preselected prong combinations
+  template <typename TFitter, typename TCombinations>
+  void fitCombinations(TFitter& fitter, TCombinations& combinations)
+  {
+    const bool fillVertexDetails = fillSkimVertices;
+    auto fitRange = [&combinations, fillVertexDetails](TFitter& fitterThread, std::size_t first, std::size_t last) {
+      for (auto iComb = first; iComb < last; ++iComb) {
+        auto& combination = combinations[iComb];
+        combination.isVertexFound = std::apply([&fitterThread](auto const*... trackParVar) { return fitterThread.process(*trackParVar...); }, combination.trackParVars) > 0;
+        if (!combination.isVertexFound) {
+          continue;
+        }
+        const auto& secondaryVertex = fitterThread.getPCACandidate();
+        combination.secondaryVertex = {secondaryVertex[0], secondaryVertex[1], secondaryVertex[2]};
+        for (auto iProng = 0u; iProng < combination.pVecProngs.size(); ++iProng) {
+          fitterThread.getTrack(iProng).getPxPyPzGlo(combination.pVecProngs[iProng]);
+        }
+        if (fillVertexDetails) {
+          combination.chi2PCA = fitterThread.getChi2AtPCACandidate();
+          combination.covMatrixPCA = fitterThread.calcPCACovMatrixFlat();
+        }
+      }
+    };
+
+    const std::size_t nCombinations = combinations.size();
+    const std::size_t nChunks = o2::analysis::ThreadPool::nChunks(nCombinations, nCombinationsPerThreadMin, nThreadsVertexing);
+    if (nChunks == 1) {
+      fitRange(fitter, 0, nCombinations);
+      return;
+    }
+    std::vector<TFitter> fittersChunk(nChunks, fitter);
+    o2::analysis::ThreadPool::instance().parallelFor(nCombinations, nChunks, [&](std::size_t iChunk, std::size_t first, std::size_t last) {
+      fitRange(fittersChunk[iChunk], first, last);
+    });
+  }
+
+  /// Method to get the primary vertex excluding the candidate daughters that contributed to it
+  /// \param prongs are the candidate daughters
+  /// \param bcWithTimeStamps is a table of bunch crossing joined with timestamps used to query the CCDB for B and material budget
+  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the current collision
+  /// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the current collision
+  /// \param pvCoord is an array initialised to the original PV where to store X, Y and Z values of refitted PV
+  /// \param pvCovMatrix is an array initialised to the original PV where to store the covariance matrix values of refitted PV
+  template <std::size_t nProngs>
+  void getPvRefitCand(std::array<const SelectedTracks::iterator*, nProngs> const& prongs,
+                      aod::BCsWithTimestamps const& bcWithTimeStamps,
+                      std::vector<int64_t> const& vecPvContributorGlobId,
+                      std::vector<o2::track::TrackParCov> const& vecPvContributorTrackParCov,
+                      std::array<float, 3>& pvCoord,
+                      std::array<float, 6>& pvCovMatrix)
+  {
+    registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
+
+    // Fill a vector with global ID of candidate daughters that are contributors
+    std::vector<int64_t> vecCandPvContributorGlobId = {};
+    const SelectedTracks::iterator* prongContr = nullptr;
+    for (const auto* prong : prongs) {
+      const auto globalIndex = (*prong).globalIndex();
+      if (std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), globalIndex) == vecPvContributorGlobId.end()) {
+        /// This track did not contribute to the original PV refit
+        if (debug) {
+          LOG(info) << "--- [" << nProngs << " prong] track with globalIndex " << globalIndex << " was not a PV contributor";
+        }
+        continue;
+      }
+      vecCandPvContributorGlobId.push_back(globalIndex);
+      prongContr = prong;
+    }
+    const auto nCandContr = vecCandPvContributorGlobId.size();
+
+    if (nCandContr >= 2) {
+      /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
+      if (debug) {
+        LOG(info) << "### [" << nProngs << " prong] Calling performPvRefitCandProngs for HF " << nProngs << " prong candidate, removing " << nCandContr << " daughters";
+      }
+      performPvRefitCandProngs((aod::Collision const&)(*prongs[0]).collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvCoord, pvCovMatrix);
+    } else if (nCandContr == 1) {
+      /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
+      if (debug) {
+        LOG(info) << "####### [" << nProngs << " prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
+      }
+      registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
+      pvCoord = {(*prongContr).pvRefitX(), (*prongContr).pvRefitY(), (*prongContr).pvRefitZ()};
+      pvCovMatrix = {(*prongContr).pvRefitSigmaX2(), (*prongContr).pvRefitSigmaXY(), (*prongContr).pvRefitSigmaY2(), (*prongContr).pvRefitSigmaXZ(), (*prongContr).pvRefitSigmaYZ(), (*prongContr).pvRefitSigmaZ2()};
+    } else {
+      /// 0 contributors among the HF candidate daughters
+      registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
+      if (debug) {
+        LOG(info) << "####### [" << nProngs << " prong] nCandContr==" << nCandContr << " ---> none of the candidate daughters contributed to the original PV fit, PV refit not redone";
+      }
+    }
+  }
 
   // int nColls{0}; //can be added to run over limited collisions per file - for tesing purposes
 
@@ -1441,48 +1807,31 @@ struct HfTrackIndexSkimsCreator {
     int n2ProngBit = BIT(n2ProngDecays) - 1; // bit value for 2-prong candidates where each candidiate is one bit and they are all set to 1
     int n3ProngBit = BIT(n3ProngDecays) - 1; // bit value for 3-prong candidates where each candidiate is one bit and they are all set to 1
 
-    bool cutStatus2Prong[n2ProngDecays][nCuts2Prong];
-    bool cutStatus3Prong[n3ProngDecays][nCuts3Prong];
     int nCutStatus2ProngBit = BIT(nCuts2Prong) - 1; // bit value for selection status for each 2-prong candidate where each selection is one bit and they are all set to 1
     int nCutStatus3ProngBit = BIT(nCuts3Prong) - 1; // bit value for selection status for each 3-prong candidate where each selection is one bit and they are all set to 1
 
-    int whichHypo2Prong[n2ProngDecays];
-    int whichHypo3Prong[n3ProngDecays];
-
-    // 2-prong vertex fitter
-    o2::vertexing::DCAFitterN<2> df2;
-    df2.setBz(bz);
-    df2.setPropagateToPCA(propToDCA);
-    df2.setMaxR(maxRad);
-    df2.setMaxDZIni(maxDZIni);
-    df2.setMinParamChange(minParamChange);
-    df2.setMinRelChi2Change(minRelChi2Change);
-    df2.setUseAbsDCA(useAbsDCA);
-
-    // 3-prong vertex fitter
-    o2::vertexing::DCAFitterN<3> df3;
-    df3.setBz(bz);
-    df3.setPropagateToPCA(propToDCA);
-    df3.setMaxR(maxRad);
-    df3.setMaxDZIni(maxDZIni);
-    df3.setMinParamChange(minParamChange);
-    df3.setMinRelChi2Change(minRelChi2Change);
-    df3.setUseAbsDCA(useAbsDCA);
+    // 2-prong and 3-prong vertex fitters, configured in init
+    auto& df2 = df2Cache.get(bz);
+    auto& df3 = df3Cache.get(bz);
 
     // used to calculate number of candidiates per event
     auto nCand2 = rowTrackIndexProng2.lastIndex();
     auto nCand3 = rowTrackIndexProng3.lastIndex();
 
-    // if there isn't at least a positive and a negative track, continue immediately
-    // if (tracksPos.size() < 1 || tracksNeg.size() < 1) {
-    //  return;
-    //}
+    fillSortedProngLists(tracks);
+
+    const double pTNegMax = tracksNeg.empty() ? 0. : RecoDecay::pt(tracksNeg[0].pxProng(), tracksNeg[0].pyProng());
+
+    combinations2Prong.clear();
+    combinations3Prong.clear();
 
     // first loop over positive tracks
-    // for (auto trackPos1 = tracksPos.begin(); trackPos1 != tracksPos.end(); ++trackPos1) {
-    for (auto trackPos1 = tracks.begin(); trackPos1 != tracks.end(); ++trackPos1) {
-      if (trackPos1.signed1Pt() < 0) {
-        continue;
+    for (auto iPos1 = 0u; iPos1 < tracksPos.size(); ++iPos1) {
+      const auto& trackPos1 = tracksPos[iPos1];
+      const double pTPos1 = RecoDecay::pt(trackPos1.pxProng(), trackPos1.pyProng());
+      // the lists are sorted by decreasing pT: if no candidate can reach the pT bins, neither can the following ones
+      if (!isPtReachable(pTPos1 + pTNegMax, pTMinCand2Prong) && (do3prong != 1 || !isPtReachable(pTPos1 + pTNegMax + std::max(pTPos1, pTNegMax), pTMinCand3Prong))) {
+        break;
       }
       bool sel2ProngStatusPos = TESTBIT(trackPos1.isSelProng(), CandidateType::Cand2Prong);
       bool sel3ProngStatusPos1 = TESTBIT(trackPos1.isSelProng(), CandidateType::Cand3Prong);
@@ -1490,13 +1839,13 @@ struct HfTrackIndexSkimsCreator {
         continue;
       }
 
-      auto trackParVarPos1 = getTrackParCov(trackPos1);
-
       // first loop over negative tracks
-      // for (auto trackNeg1 = tracksNeg.begin(); trackNeg1 != tracksNeg.end(); ++trackNeg1) {
-      for (auto trackNeg1 = tracks.begin(); trackNeg1 != tracks.end(); ++trackNeg1) {
-        if (trackNeg1.signed1Pt() > 0) {
-          continue;
+      for (auto iNeg1 = 0u; iNeg1 < tracksNeg.size(); ++iNeg1) {
+        const auto& trackNeg1 = tracksNeg[iNeg1];
+        const double pTNeg1 = RecoDecay::pt(trackNeg1.pxProng(), trackNeg1.pyProng());
+        // the third prong of a 3-prong candidate follows trackPos1 or trackNeg1 in the sorted lists and cannot be harder
+        if (!isPtReachable(pTPos1 + pTNeg1, pTMinCand2Prong) && (do3prong != 1 || !isPtReachable(pTPos1 + pTNeg1 + std::max(pTPos1, pTNeg1), pTMinCand3Prong))) {
+          break;
         }
         bool sel2ProngStatusNeg = TESTBIT(trackNeg1.isSelProng(), CandidateType::Cand2Prong);
         bool sel3ProngStatusNeg1 = TESTBIT(trackNeg1.isSelProng(), CandidateType::Cand3Prong);
@@ -1504,567 +1853,271 @@ struct HfTrackIndexSkimsCreator {
           continue;
         }
 
-        auto trackParVarNeg1 = getTrackParCov(trackNeg1);
-
-        int isSelected2ProngCand = n2ProngBit; // bitmap for checking status of two-prong candidates (1 is true, 0 is rejected)
-
-        if (debug) {
-          for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
-            for (int iCut = 0; iCut < nCuts2Prong; iCut++) {
-              cutStatus2Prong[iDecay2P][iCut] = true;
-            }
-          }
-        }
-
-        // 2-prong vertex reconstruction
-        if (sel2ProngStatusPos && sel2ProngStatusNeg) {
-
-          // 2-prong preselections
+        // 2-prong preselections
+        if (sel2ProngStatusPos && sel2ProngStatusNeg && isPtReachable(pTPos1 + pTNeg1, pTMinCand2Prong)) {
+          Prong2Combination combination2Prong;
+          combination2Prong.prongs = {&trackPos1, &trackNeg1};
+          combination2Prong.trackParVars = {&trackParVarsPos[iPos1], &trackParVarsNeg[iNeg1]};
+          combination2Prong.isSelected = n2ProngBit; // bitmap for checking status of two-prong candidates (1 is true, 0 is rejected)
+          resetCutStatus(combination2Prong.cutStatus);
           // TODO: in case of PV refit, the single-track DCA is calculated wrt two different PV vertices (only 1 track excluded)
-          is2ProngPreselected(trackPos1, trackNeg1, cutStatus2Prong, whichHypo2Prong, isSelected2ProngCand);
-
-          // secondary vertex reconstruction and further 2-prong selections
-          if (isSelected2ProngCand > 0 && df2.process(trackParVarPos1, trackParVarNeg1) > 0) { // should it be this or > 0 or are they equivalent
-            // get secondary vertex
-            const auto& secondaryVertex2 = df2.getPCACandidate();
-            // get track momenta
-            array<float, 3> pvec0;
-            array<float, 3> pvec1;
-            df2.getTrack(0).getPxPyPzGlo(pvec0);
-            df2.getTrack(1).getPxPyPzGlo(pvec1);
-
-            /// PV refit excluding the candidate daughters, if contributors
-            array<float, 3> pvRefitCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-            array<float, 6> pvRefitCovMatrix2Prong = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
-            if (doPvRefit) {
-              registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
-              int nCandContr = 2;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-              bool isTrackFirstContr = true;
-              bool isTrackSecondContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [2 Prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackFirstContr = false;
-              }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [2 Prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackSecondContr = false;
-              }
-              if (nCandContr == 2) {
-                /// Both the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                if (debug) {
-                  LOG(info) << "### [2 Prong] Calling performPvRefitCandProngs for HF 2 prong candidate";
-                }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, {trackPos1.globalIndex(), trackNeg1.globalIndex()}, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
-              } else if (nCandContr == 1) {
-                /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
-                if (debug) {
-                  LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
-                }
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
-                if (isTrackFirstContr && !isTrackSecondContr) {
-                  /// the first daughter is contributor, the second is not
-                  pvRefitCoord2Prong = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                  pvRefitCovMatrix2Prong = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                } else if (!isTrackFirstContr && isTrackSecondContr) {
-                  ///  the second daughter is contributor, the first is not
-                  pvRefitCoord2Prong = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                  pvRefitCovMatrix2Prong = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                }
-              } else {
-                /// 0 contributors among the HF candidate daughters
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
-                if (debug) {
-                  LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
-                }
-              }
-            }
-
-            auto pVecCandProng2 = RecoDecay::pVec(pvec0, pvec1);
-            // 2-prong selections after secondary vertex
-            array<float, 3> pvCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()};
-            if (doPvRefit) {
-              pvCoord2Prong[0] = pvRefitCoord2Prong[0];
-              pvCoord2Prong[1] = pvRefitCoord2Prong[1];
-              pvCoord2Prong[2] = pvRefitCoord2Prong[2];
-            }
-            is2ProngSelected(pVecCandProng2, secondaryVertex2, pvCoord2Prong, cutStatus2Prong, isSelected2ProngCand);
-
-            if (isSelected2ProngCand > 0) {
-              // fill table row
-              rowTrackIndexProng2(trackPos1.globalIndex(),
-                                  trackNeg1.globalIndex(), isSelected2ProngCand);
-              // fill table row with coordinates of PV refit
-              rowProng2PVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
-                               pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
-
-              if (debug) {
-                int Prong2CutStatus[n2ProngDecays];
-                for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
-                  Prong2CutStatus[iDecay2P] = nCutStatus2ProngBit;
-                  for (int iCut = 0; iCut < nCuts2Prong; iCut++) {
-                    if (!cutStatus2Prong[iDecay2P][iCut]) {
-                      CLRBIT(Prong2CutStatus[iDecay2P], iCut);
-                    }
-                  }
-                }
-                rowProng2CutStatus(Prong2CutStatus[0], Prong2CutStatus[1], Prong2CutStatus[2]); // FIXME when we can do this by looping over n2ProngDecays
-              }
-
-              // fill histograms
-              if (fillHistograms) {
-                registry.fill(HIST("hVtx2ProngX"), secondaryVertex2[0]);
-                registry.fill(HIST("hVtx2ProngY"), secondaryVertex2[1]);
-                registry.fill(HIST("hVtx2ProngZ"), secondaryVertex2[2]);
-                array<array<float, 3>, 2> arrMom = {pvec0, pvec1};
-                for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
-                  if (TESTBIT(isSelected2ProngCand, iDecay2P)) {
-                    if (whichHypo2Prong[iDecay2P] == 1 || whichHypo2Prong[iDecay2P] == 3) {
-                      auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][0]);
-                      switch (iDecay2P) {
-                        case hf_cand_prong2::DecayType::D0ToPiK:
-                          registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
-                          break;
-                        case hf_cand_prong2::DecayType::JpsiToEE:
-                          registry.fill(HIST("hMassJpsiToEE"), mass2Prong);
-                          break;
-                        case hf_cand_prong2::DecayType::JpsiToMuMu:
-                          registry.fill(HIST("hMassJpsiToMuMu"), mass2Prong);
-                          break;
-                      }
-                    }
-                    if (whichHypo2Prong[iDecay2P] >= 2) {
-                      auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][1]);
-                      if (iDecay2P == hf_cand_prong2::DecayType::D0ToPiK) {
-                        registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
-                      }
-                    }
-                  }
-                }
-              }
-            }
+          is2ProngPreselected(trackPos1, trackNeg1, combination2Prong.cutStatus, combination2Prong.whichHypo, combination2Prong.isSelected);
+          if (combination2Prong.isSelected > 0) {
+            combinations2Prong.push_back(combination2Prong);
           }
         }
 
-        // 3-prong vertex reconstruction
+        // 3-prong preselections
         if (do3prong == 1) {
           if (!sel3ProngStatusPos1 || !sel3ProngStatusNeg1) {
             continue;
           }
 
-          if (tracks.size() < 2) {
-            continue;
-          }
           // second loop over positive tracks
-          // for (auto trackPos2 = trackPos1 + 1; trackPos2 != tracksPos.end(); ++trackPos2) {
-          for (auto trackPos2 = trackPos1 + 1; trackPos2 != tracks.end(); ++trackPos2) {
-            if (trackPos2.signed1Pt() < 0) {
-              continue;
+          for (auto iPos2 = iPos1 + 1; iPos2 < tracksPos.size(); ++iPos2) {
+            const auto& trackPos2 = tracksPos[iPos2];
+            if (!isPtReachable(pTPos1 + pTNeg1 + RecoDecay::pt(trackPos2.pxProng(), trackPos2.pyProng()), pTMinCand3Prong)) {
+              break;
             }
             if (!TESTBIT(trackPos2.isSelProng(), CandidateType::Cand3Prong)) {
               continue;
             }
 
-            int isSelected3ProngCand = n3ProngBit;
-
-            if (debug) {
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                for (int iCut = 0; iCut < nCuts3Prong; iCut++) {
-                  cutStatus3Prong[iDecay3P][iCut] = true;
-                }
-              }
+            Prong3Combination combination3Prong;
+            combination3Prong.prongs = {&trackPos1, &trackNeg1, &trackPos2};
+            combination3Prong.trackParVars = {&trackParVarsPos[iPos1], &trackParVarsNeg[iNeg1], &trackParVarsPos[iPos2]};
+            combination3Prong.isSelected = n3ProngBit;
+            resetCutStatus(combination3Prong.cutStatus);
+            is3ProngPreselected(trackPos1, trackNeg1, trackPos2, combination3Prong.cutStatus, combination3Prong.whichHypo, combination3Prong.isSelected);
+            if (debug || combination3Prong.isSelected > 0) {
+              combinations3Prong.push_back(combination3Prong);
             }
+          }
 
-            // 3-prong preselections
-            is3ProngPreselected(trackPos1, trackNeg1, trackPos2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
-            if (!debug && isSelected3ProngCand == 0) {
-              continue;
+          // second loop over negative tracks
+          for (auto iNeg2 = iNeg1 + 1; iNeg2 < tracksNeg.size(); ++iNeg2) {
+            const auto& trackNeg2 = tracksNeg[iNeg2];
+            if (!isPtReachable(pTPos1 + pTNeg1 + RecoDecay::pt(trackNeg2.pxProng(), trackNeg2.pyProng()), pTMinCand3Prong)) {
+              break;
             }
-
-            // reconstruct the 3-prong secondary vertex
-            auto trackParVarPos2 = getTrackParCov(trackPos2);
-            if (df3.process(trackParVarPos1, trackParVarNeg1, trackParVarPos2) == 0) {
+            if (!TESTBIT(trackNeg2.isSelProng(), CandidateType::Cand3Prong)) {
               continue;
             }
-            // get secondary vertex
-            const auto& secondaryVertex3 = df3.getPCACandidate();
-            // get track momenta
-            array<float, 3> pvec0;
-            array<float, 3> pvec1;
-            array<float, 3> pvec2;
-            df3.getTrack(0).getPxPyPzGlo(pvec0);
-            df3.getTrack(1).getPxPyPzGlo(pvec1);
-            df3.getTrack(2).getPxPyPzGlo(pvec2);
-
-            /// PV refit excluding the candidate daughters, if contributors
-            array<float, 3> pvRefitCoord3Prong2Pos1Neg = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-            array<float, 6> pvRefitCovMatrix3Prong2Pos1Neg = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
-            if (doPvRefit) {
-              registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
-              int nCandContr = 3;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-              auto it_third_trk = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos2.globalIndex());
-              bool isTrackFirstContr = true;
-              bool isTrackSecondContr = true;
-              bool isTrackThirdContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackFirstContr = false;
-              }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackSecondContr = false;
-              }
-              if (it_third_trk == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackPos2 with globalIndex " << trackPos2.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackThirdContr = false;
-              }
-
-              // Fill a vector with global ID of candidate daughters that are contributors
-              std::vector<int64_t> vecCandPvContributorGlobId = {};
-              if (isTrackFirstContr) {
-                vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
-              }
-              if (isTrackSecondContr) {
-                vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
-              }
-              if (isTrackThirdContr) {
-                vecCandPvContributorGlobId.push_back(trackPos2.globalIndex());
-              }
 
-              if (nCandContr == 3 || nCandContr == 2) {
-                /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                if (debug) {
-                  LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
-                }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong2Pos1Neg, pvRefitCovMatrix3Prong2Pos1Neg);
-              } else if (nCandContr == 1) {
-                /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
-                if (debug) {
-                  LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
-                }
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
-                if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
-                  /// the first daughter is contributor, the second and the third are not
-                  pvRefitCoord3Prong2Pos1Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                  pvRefitCovMatrix3Prong2Pos1Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
-                  /// the second daughter is contributor, the first and the third are not
-                  pvRefitCoord3Prong2Pos1Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                  pvRefitCovMatrix3Prong2Pos1Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
-                  /// the third daughter is contributor, the first and the second are not
-                  pvRefitCoord3Prong2Pos1Neg = {trackPos2.pvRefitX(), trackPos2.pvRefitY(), trackPos2.pvRefitZ()};
-                  pvRefitCovMatrix3Prong2Pos1Neg = {trackPos2.pvRefitSigmaX2(), trackPos2.pvRefitSigmaXY(), trackPos2.pvRefitSigmaY2(), trackPos2.pvRefitSigmaXZ(), trackPos2.pvRefitSigmaYZ(), trackPos2.pvRefitSigmaZ2()};
-                }
-              } else {
-                /// 0 contributors among the HF candidate daughters
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
-                if (debug) {
-                  LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
-                }
-              }
+            Prong3Combination combination3Prong;
+            combination3Prong.prongs = {&trackNeg1, &trackPos1, &trackNeg2};
+            combination3Prong.trackParVars = {&trackParVarsNeg[iNeg1], &trackParVarsPos[iPos1], &trackParVarsNeg[iNeg2]};
+            combination3Prong.isSelected = n3ProngBit;
+            resetCutStatus(combination3Prong.cutStatus);
+            is3ProngPreselected(trackNeg1, trackPos1, trackNeg2, combination3Prong.cutStatus, combination3Prong.whichHypo, combination3Prong.isSelected);
+            if (debug || combination3Prong.isSelected > 0) {
+              combinations3Prong.push_back(combination3Prong);
             }
+          }
+        }
+      }
+    }
 
-            auto pVecCandProng3Pos = RecoDecay::pVec(pvec0, pvec1, pvec2);
-            // 3-prong selections after secondary vertex
-            array<float, 3> pvCoord3Prong2Pos1Neg = {collision.posX(), collision.posY(), collision.posZ()};
-            if (doPvRefit) {
-              pvCoord3Prong2Pos1Neg[0] = pvRefitCoord3Prong2Pos1Neg[0];
-              pvCoord3Prong2Pos1Neg[1] = pvRefitCoord3Prong2Pos1Neg[1];
-              pvCoord3Prong2Pos1Neg[2] = pvRefitCoord3Prong2Pos1Neg[2];
-            }
-            is3ProngSelected(pVecCandProng3Pos, secondaryVertex3, pvCoord3Prong2Pos1Neg, cutStatus3Prong, isSelected3ProngCand);
-            if (!debug && isSelected3ProngCand == 0) {
-              continue;
-            }
+    // cosp preselection of the 2-prong combinations on the helix crossing estimate of the secondary vertex
+    if (useHelixPreselection && !debug) {
+      array<float, 3> primVtx = {collision.posX(), collision.posY(), collision.posZ()};
+      for (auto& combination2Prong : combinations2Prong) {
+        is2ProngHelixPreselected(*combination2Prong.trackParVars[0], *combination2Prong.trackParVars[1], primVtx, combination2Prong.isSelected);
+      }
+      combinations2Prong.erase(std::remove_if(combinations2Prong.begin(), combinations2Prong.end(), [](const auto& combination2Prong) { return combination2Prong.isSelected == 0; }), combinations2Prong.end());
+    }
 
-            // fill table row
-            rowTrackIndexProng3(trackPos1.globalIndex(),
-                                trackNeg1.globalIndex(),
-                                trackPos2.globalIndex(), isSelected3ProngCand);
-            // fill table row of coordinates of PV refit
-            rowProng3PVrefit(pvRefitCoord3Prong2Pos1Neg[0], pvRefitCoord3Prong2Pos1Neg[1], pvRefitCoord3Prong2Pos1Neg[2],
-                             pvRefitCovMatrix3Prong2Pos1Neg[0], pvRefitCovMatrix3Prong2Pos1Neg[1], pvRefitCovMatrix3Prong2Pos1Neg[2], pvRefitCovMatrix3Prong2Pos1Neg[3], pvRefitCovMatrix3Prong2Pos1Neg[4], pvRefitCovMatrix3Prong2Pos1Neg[5]);
+    // secondary vertex reconstruction of the preselected combinations
+    fitCombinations(df2, combinations2Prong);
+    fitCombinations(df3, combinations3Prong);
 
-            if (debug) {
-              int Prong3CutStatus[n3ProngDecays];
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                Prong3CutStatus[iDecay3P] = nCutStatus3ProngBit;
-                for (int iCut = 0; iCut < nCuts3Prong; iCut++) {
-                  if (!cutStatus3Prong[iDecay3P][iCut]) {
-                    CLRBIT(Prong3CutStatus[iDecay3P], iCut);
-                  }
-                }
-              }
-              rowProng3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
-            }
+    // further 2-prong selections, in the order of the preselection
+    for (auto& combination2Prong : combinations2Prong) {
+      if (!combination2Prong.isVertexFound) {
+        continue;
+      }
+      const auto& secondaryVertex2 = combination2Prong.secondaryVertex;
+      const auto& arrMom = combination2Prong.pVecProngs;
 
-            // fill histograms
-            if (fillHistograms) {
-              registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
-              registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
-              registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
-              array<array<float, 3>, 3> arr3Mom = {pvec0, pvec1, pvec2};
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
-                  if (whichHypo3Prong[iDecay3P] == 1 || whichHypo3Prong[iDecay3P] == 3) {
-                    auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
-                    switch (iDecay3P) {
-                      case hf_cand_prong3::DecayType::DPlusToPiKPi:
-                        registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::DsToPiKK:
-                        registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::LcToPKPi:
-                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::XicToPKPi:
-                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                        break;
-                    }
-                  }
-                  if (whichHypo3Prong[iDecay3P] >= 2) {
-                    auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
-                    switch (iDecay3P) {
-                      case hf_cand_prong3::DecayType::DsToPiKK:
-                        registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::LcToPKPi:
-                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::XicToPKPi:
-                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                        break;
-                    }
-                  }
-                }
-              }
-            }
-          }
+      /// PV refit excluding the candidate daughters, if contributors
+      array<float, 3> pvRefitCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
+      array<float, 6> pvRefitCovMatrix2Prong = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
+      if (doPvRefit) {
+        getPvRefitCand(combination2Prong.prongs, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
+      }
 
-          // second loop over negative tracks
-          // for (auto trackNeg2 = trackNeg1 + 1; trackNeg2 != tracksNeg.end(); ++trackNeg2) {
-          for (auto trackNeg2 = trackNeg1 + 1; trackNeg2 != tracks.end(); ++trackNeg2) {
-            if (trackNeg2.signed1Pt() > 0) {
-              continue;
-            }
-            if (!TESTBIT(trackNeg2.isSelProng(), CandidateType::Cand3Prong)) {
-              continue;
-            }
+      auto pVecCandProng2 = RecoDecay::pVec(arrMom[0], arrMom[1]);
+      // 2-prong selections after secondary vertex
+      array<float, 3> pvCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()};
+      if (doPvRefit) {
+        pvCoord2Prong[0] = pvRefitCoord2Prong[0];
+        pvCoord2Prong[1] = pvRefitCoord2Prong[1];
+        pvCoord2Prong[2] = pvRefitCoord2Prong[2];
+      }
+      int& isSelected2ProngCand = combination2Prong.isSelected;
+      is2ProngSelected(pVecCandProng2, secondaryVertex2, pvCoord2Prong, combination2Prong.cutStatus, isSelected2ProngCand);
 
-            int isSelected3ProngCand = n3ProngBit;
+      if (isSelected2ProngCand > 0) {
+        // fill table row
+        rowTrackIndexProng2((*combination2Prong.prongs[0]).globalIndex(),
+                            (*combination2Prong.prongs[1]).globalIndex(), isSelected2ProngCand);
+        // fill table row with coordinates of PV refit
+        rowProng2PVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
+                         pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
+        // fill table row of the secondary vertex
+        if (fillSkimVertices) {
+          const auto& covMatrixPCA = combination2Prong.covMatrixPCA;
+          rowProng2Vertex(secondaryVertex2[0], secondaryVertex2[1], secondaryVertex2[2],
+                          covMatrixPCA[0], covMatrixPCA[1], covMatrixPCA[2], covMatrixPCA[3], covMatrixPCA[4], covMatrixPCA[5],
+                          combination2Prong.chi2PCA,
+                          arrMom[0][0], arrMom[0][1], arrMom[0][2],
+                          arrMom[1][0], arrMom[1][1], arrMom[1][2]);
+        }
 
-            if (debug) {
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                for (int iCut = 0; iCut < nCuts3Prong; iCut++) {
-                  cutStatus3Prong[iDecay3P][iCut] = true;
-                }
+        if (debug) {
+          int Prong2CutStatus[n2ProngDecays];
+          for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
+            Prong2CutStatus[iDecay2P] = nCutStatus2ProngBit;
+            for (int iCut = 0; iCut < nCuts2Prong; iCut++) {
+              if (!combination2Prong.cutStatus[iDecay2P][iCut]) {
+                CLRBIT(Prong2CutStatus[iDecay2P], iCut);
               }
             }
+          }
+          rowProng2CutStatus(Prong2CutStatus[0], Prong2CutStatus[1], Prong2CutStatus[2]); // FIXME when we can do this by looping over n2ProngDecays
+        }
 
-            // 3-prong preselections
-            is3ProngPreselected(trackNeg1, trackPos1, trackNeg2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
-            if (!debug && isSelected3ProngCand == 0) {
-              continue;
-            }
-
-            // reconstruct the 3-prong secondary vertex
-            auto trackParVarNeg2 = getTrackParCov(trackNeg2);
-            if (df3.process(trackParVarNeg1, trackParVarPos1, trackParVarNeg2) == 0) {
-              continue;
-            }
-
-            // get secondary vertex
-            const auto& secondaryVertex3 = df3.getPCACandidate();
-            // get track momenta
-            array<float, 3> pvec0;
-            array<float, 3> pvec1;
-            array<float, 3> pvec2;
-            df3.getTrack(0).getPxPyPzGlo(pvec0);
-            df3.getTrack(1).getPxPyPzGlo(pvec1);
-            df3.getTrack(2).getPxPyPzGlo(pvec2);
-
-            /// PV refit excluding the candidate daughters, if contributors
-            array<float, 3> pvRefitCoord3Prong1Pos2Neg = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-            array<float, 6> pvRefitCovMatrix3Prong1Pos2Neg = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
-            if (doPvRefit) {
-              registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
-              int nCandContr = 3;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-              auto it_third_trk = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg2.globalIndex());
-              bool isTrackFirstContr = true;
-              bool isTrackSecondContr = true;
-              bool isTrackThirdContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
-                }
-                nCandContr--;
-                isTrackFirstContr = false;
-              }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
+        // fill histograms
+        if (fillHistograms) {
+          registry.fill(HIST("hVtx2ProngX"), secondaryVertex2[0]);
+          registry.fill(HIST("hVtx2ProngY"), secondaryVertex2[1]);
+          registry.fill(HIST("hVtx2ProngZ"), secondaryVertex2[2]);
+          const auto& whichHypo2Prong = combination2Prong.whichHypo;
+          for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
+            if (TESTBIT(isSelected2ProngCand, iDecay2P)) {
+              if (whichHypo2Prong[iDecay2P] == 1 || whichHypo2Prong[iDecay2P] == 3) {
+                auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][0]);
+                switch (iDecay2P) {
+                  case hf_cand_prong2::DecayType::D0ToPiK:
+                    registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
+                    break;
+                  case hf_cand_prong2::DecayType::JpsiToEE:
+                    registry.fill(HIST("hMassJpsiToEE"), mass2Prong);
+                    break;
+                  case hf_cand_prong2::DecayType::JpsiToMuMu:
+                    registry.fill(HIST("hMassJpsiToMuMu"), mass2Prong);
+                    break;
                 }
-                nCandContr--;
-                isTrackSecondContr = false;
               }
-              if (it_third_trk == vecPvContributorGlobId.end()) {
-                /// This track did not contribute to the original PV refit
-                if (debug) {
-                  LOG(info) << "--- [3 prong] trackNeg2 with globalIndex " << trackNeg2.globalIndex() << " was not a PV contributor";
+              if (whichHypo2Prong[iDecay2P] >= 2) {
+                auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][1]);
+                if (iDecay2P == hf_cand_prong2::DecayType::D0ToPiK) {
+                  registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
                 }
-                nCandContr--;
-                isTrackThirdContr = false;
               }
+            }
+          }
+        }
+      }
+    }
 
-              // Fill a vector with global ID of candidate daughters that are contributors
-              std::vector<int64_t> vecCandPvContributorGlobId = {};
-              if (isTrackFirstContr) {
-                vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
-              }
-              if (isTrackSecondContr) {
-                vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
-              }
-              if (isTrackThirdContr) {
-                vecCandPvContributorGlobId.push_back(trackNeg2.globalIndex());
-              }
+    // further 3-prong selections, in the order of the preselection
+    for (auto& combination3Prong : combinations3Prong) {
+      if (!combination3Prong.isVertexFound) {
+        continue;
+      }
+      const auto& secondaryVertex3 = combination3Prong.secondaryVertex;
+      const auto& arr3Mom = combination3Prong.pVecProngs;
 
-              if (nCandContr == 3 || nCandContr == 2) {
-                /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                if (debug) {
-                  LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
-                }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong1Pos2Neg, pvRefitCovMatrix3Prong1Pos2Neg);
-              } else if (nCandContr == 1) {
-                /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
-                if (debug) {
-                  LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
-                }
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
-                if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
-                  /// the first daughter is contributor, the second and the third are not
-                  pvRefitCoord3Prong1Pos2Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                  pvRefitCovMatrix3Prong1Pos2Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
-                  /// the second daughter is contributor, the first and the third are not
-                  pvRefitCoord3Prong1Pos2Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                  pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
-                  /// the third daughter is contributor, the first and the second are not
-                  pvRefitCoord3Prong1Pos2Neg = {trackNeg2.pvRefitX(), trackNeg2.pvRefitY(), trackNeg2.pvRefitZ()};
-                  pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg2.pvRefitSigmaX2(), trackNeg2.pvRefitSigmaXY(), trackNeg2.pvRefitSigmaY2(), trackNeg2.pvRefitSigmaXZ(), trackNeg2.pvRefitSigmaYZ(), trackNeg2.pvRefitSigmaZ2()};
-                }
-              } else {
-                /// 0 contributors among the HF candidate daughters
-                registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
-                if (debug) {
-                  LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
-                }
-              }
-            }
+      /// PV refit excluding the candidate daughters, if contributors
+      array<float, 3> pvRefitCoord3Prong = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
+      array<float, 6> pvRefitCovMatrix3Prong = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
+      if (doPvRefit) {
+        getPvRefitCand(combination3Prong.prongs, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, pvRefitCoord3Prong, pvRefitCovMatrix3Prong);
+      }
 
-            auto pVecCandProng3Neg = RecoDecay::pVec(pvec0, pvec1, pvec2);
-            // 3-prong selections after secondary vertex
-            array<float, 3> pvCoord3Prong1Pos2Neg = {collision.posX(), collision.posY(), collision.posZ()};
-            if (doPvRefit) {
-              pvCoord3Prong1Pos2Neg[0] = pvRefitCoord3Prong1Pos2Neg[0];
-              pvCoord3Prong1Pos2Neg[1] = pvRefitCoord3Prong1Pos2Neg[1];
-              pvCoord3Prong1Pos2Neg[2] = pvRefitCoord3Prong1Pos2Neg[2];
-            }
-            is3ProngSelected(pVecCandProng3Neg, secondaryVertex3, pvCoord3Prong1Pos2Neg, cutStatus3Prong, isSelected3ProngCand);
-            if (!debug && isSelected3ProngCand == 0) {
-              continue;
-            }
+      auto pVecCandProng3 = RecoDecay::pVec(arr3Mom[0], arr3Mom[1], arr3Mom[2]);
+      // 3-prong selections after secondary vertex
+      array<float, 3> pvCoord3Prong = {collision.posX(), collision.posY(), collision.posZ()};
+      if (doPvRefit) {
+        pvCoord3Prong[0] = pvRefitCoord3Prong[0];
+        pvCoord3Prong[1] = pvRefitCoord3Prong[1];
+        pvCoord3Prong[2] = pvRefitCoord3Prong[2];
+      }
+      int& isSelected3ProngCand = combination3Prong.isSelected;
+      is3ProngSelected(pVecCandProng3, secondaryVertex3, pvCoord3Prong, combination3Prong.cutStatus, isSelected3ProngCand);
+      if (!debug && isSelected3ProngCand == 0) {
+        continue;
+      }
 
-            // fill table row
-            rowTrackIndexProng3(trackNeg1.globalIndex(),
-                                trackPos1.globalIndex(),
-                                trackNeg2.globalIndex(), isSelected3ProngCand);
-            // fill table row of coordinates of PV refit
-            rowProng3PVrefit(pvRefitCoord3Prong1Pos2Neg[0], pvRefitCoord3Prong1Pos2Neg[1], pvRefitCoord3Prong1Pos2Neg[2],
-                             pvRefitCovMatrix3Prong1Pos2Neg[0], pvRefitCovMatrix3Prong1Pos2Neg[1], pvRefitCovMatrix3Prong1Pos2Neg[2], pvRefitCovMatrix3Prong1Pos2Neg[3], pvRefitCovMatrix3Prong1Pos2Neg[4], pvRefitCovMatrix3Prong1Pos2Neg[5]);
+      // fill table row
+      rowTrackIndexProng3((*combination3Prong.prongs[0]).globalIndex(),
+                          (*combination3Prong.prongs[1]).globalIndex(),
+                          (*combination3Prong.prongs[2]).globalIndex(), isSelected3ProngCand);
+      // fill table row of coordinates of PV refit
+      rowProng3PVrefit(pvRefitCoord3Prong[0], pvRefitCoord3Prong[1], pvRefitCoord3Prong[2],
+                       pvRefitCovMatrix3Prong[0], pvRefitCovMatrix3Prong[1], pvRefitCovMatrix3Prong[2], pvRefitCovMatrix3Prong[3], pvRefitCovMatrix3Prong[4], pvRefitCovMatrix3Prong[5]);
+      // fill table row of the secondary vertex
+      if (fillSkimVertices) {
+        const auto& covMatrixPCA = combination3Prong.covMatrixPCA;
+        rowProng3Vertex(secondaryVertex3[0], secondaryVertex3[1], secondaryVertex3[2],
+                        covMatrixPCA[0], covMatrixPCA[1], covMatrixPCA[2], covMatrixPCA[3], covMatrixPCA[4], covMatrixPCA[5],
+                        combination3Prong.chi2PCA,
+                        arr3Mom[0][0], arr3Mom[0][1], arr3Mom[0][2],
+                        arr3Mom[1][0], arr3Mom[1][1], arr3Mom[1][2],
+                        arr3Mom[2][0], arr3Mom[2][1], arr3Mom[2][2]);
+      }
 
-            if (debug) {
-              int Prong3CutStatus[n3ProngDecays];
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                Prong3CutStatus[iDecay3P] = nCutStatus3ProngBit;
-                for (int iCut = 0; iCut < nCuts3Prong; iCut++) {
-                  if (!cutStatus3Prong[iDecay3P][iCut]) {
-                    CLRBIT(Prong3CutStatus[iDecay3P], iCut);
-                  }
-                }
-              }
-              rowProng3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
+      if (debug) {
+        int Prong3CutStatus[n3ProngDecays];
+        for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
+          Prong3CutStatus[iDecay3P] = nCutStatus3ProngBit;
+          for (int iCut = 0; iCut < nCuts3Prong; iCut++) {
+            if (!combination3Prong.cutStatus[iDecay3P][iCut]) {
+              CLRBIT(Prong3CutStatus[iDecay3P], iCut);
             }
+          }
+        }
+        rowProng3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
+      }
 
-            // fill histograms
-            if (fillHistograms) {
-              registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
-              registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
-              registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
-              array<array<float, 3>, 3> arr3Mom = {pvec0, pvec1, pvec2};
-              for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
-                if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
-                  if (whichHypo3Prong[iDecay3P] == 1 || whichHypo3Prong[iDecay3P] == 3) {
-                    auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
-                    switch (iDecay3P) {
-                      case hf_cand_prong3::DecayType::DPlusToPiKPi:
-                        registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::DsToPiKK:
-                        registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::LcToPKPi:
-                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::XicToPKPi:
-                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                        break;
-                    }
-                  }
-                  if (whichHypo3Prong[iDecay3P] >= 2) {
-                    auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
-                    switch (iDecay3P) {
-                      case hf_cand_prong3::DecayType::DsToPiKK:
-                        registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::LcToPKPi:
-                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                        break;
-                      case hf_cand_prong3::DecayType::XicToPKPi:
-                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                        break;
-                    }
-                  }
-                }
+      // fill histograms
+      if (fillHistograms) {
+        registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
+        registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
+        registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
+        const auto& whichHypo3Prong = combination3Prong.whichHypo;
+        for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
+          if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
+            if (whichHypo3Prong[iDecay3P] == 1 || whichHypo3Prong[iDecay3P] == 3) {
+              auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
+              switch (iDecay3P) {
+                case hf_cand_prong3::DecayType::DPlusToPiKPi:
+                  registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
+                  break;
+                case hf_cand_prong3::DecayType::DsToPiKK:
+                  registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
+                  break;
+                case hf_cand_prong3::DecayType::LcToPKPi:
+                  registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                  break;
+                case hf_cand_prong3::DecayType::XicToPKPi:
+                  registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                  break;
+              }
+            }
+            if (whichHypo3Prong[iDecay3P] >= 2) {
+              auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
+              switch (iDecay3P) {
+                case hf_cand_prong3::DecayType::DsToPiKK:
+                  registry.fill(HIST("hMassDsToPiKK"), mass3Prong);
+                  break;
+                case hf_cand_prong3::DecayType::LcToPKPi:
+                  registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                  break;
+                case hf_cand_prong3::DecayType::XicToPKPi:
+                  registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                  break;
               }
             }
           }
@@ -2171,6 +2224,44 @@ struct HfTrackIndexSkimsCreatorCascades {
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HFSelCollision>>;
   using FullTracksExt = soa::Join<aod::FullTracks, aod::TracksDCA>;
 
+  /// K0S candidate passing the V0 selections, with its neutral track built once per collision
+  struct SelectedV0 {
+    int64_t globalIndex;
+    float pt;
+    std::array<float, 3> momentum;
+    o2::track::TrackParCov track;
+#ifdef MY_DEBUG
+    int64_t indexDaughPos;
+    int64_t indexDaughNeg;
+#endif
+  };
+  /// bachelor passing the track selections
+  struct SelectedBachelor {
+    int64_t globalIndex;
+    float pt;
+    std::array<float, 3> momentum;
+    o2::track::TrackParCov track;
+#ifdef MY_DEBUG
+    int64_t index;
+#endif
+  };
+  std::vector<SelectedV0> selectedV0s;
+  std::vector<SelectedBachelor> selectedBachelors;
+
+  o2::vertexing::DCAFitterN<2> fitter; // 2-prong fitter, the field being fixed
+
+  void init(InitContext const&)
+  {
+    fitter.setBz(bZ);
+    fitter.setPropagateToPCA(propDCA);
+    fitter.setMaxR(maxR);
+    fitter.setMinParamChange(minParamChange);
+    fitter.setMinRelChi2Change(minRelChi2Change);
+    // fitter.setMaxDZIni(1e9); // used in cascadeproducer.cxx, but not for the 2 prongs
+    // fitter.setMaxChi2(1e9);  // used in cascadeproducer.cxx, but not for the 2 prongs
+    fitter.setUseAbsDCA(UseAbsDCA);
+  }
+
   void process(SelectedCollisions::iterator const& collision,
                aod::BCs const& bcs,
                // soa::Filtered<aod::V0Datas> const& V0s,
@@ -2182,20 +2273,84 @@ struct HfTrackIndexSkimsCreatorCascades {
 #endif
                ) // TODO: I am now assuming that the V0s are already filtered with my cuts (David's work to come)
   {
+    // first we select the K0S, once per collision instead of once per bachelor
+    selectedV0s.clear();
+    for (const auto& v0 : V0s) {
+      MY_DEBUG_MSG(1, LOG(info) << "*** Checking next K0S");
+      // selections on the V0 daughters
+      const auto& trackV0DaughPos = v0.posTrack_as<MyTracks>();
+      const auto& trackV0DaughNeg = v0.negTrack_as<MyTracks>();
+#ifdef MY_DEBUG
+      auto indexV0DaughPos = trackV0DaughPos.mcParticleId();
+      auto indexV0DaughNeg = trackV0DaughNeg.mcParticleId();
+      bool isK0SfromLc = isK0SfromLcFunc(indexV0DaughPos, indexV0DaughNeg, indexK0Spos, indexK0Sneg);
+#endif
+      MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S from Lc found, trackV0DaughPos --> " << indexV0DaughPos << ", trackV0DaughNeg --> " << indexV0DaughNeg);
 
-    // Define o2 fitter, 2-prong
-    o2::vertexing::DCAFitterN<2> fitter;
-    fitter.setBz(bZ);
-    fitter.setPropagateToPCA(propDCA);
-    fitter.setMaxR(maxR);
-    fitter.setMinParamChange(minParamChange);
-    fitter.setMinRelChi2Change(minRelChi2Change);
-    // fitter.setMaxDZIni(1e9); // used in cascadeproducer.cxx, but not for the 2 prongs
-    // fitter.setMaxChi2(1e9);  // used in cascadeproducer.cxx, but not for the 2 prongs
-    fitter.setUseAbsDCA(UseAbsDCA);
+      if (TPCRefitV0Daugh) {
+        if (!(trackV0DaughPos.trackType() & o2::aod::track::TPCrefit) ||
+            !(trackV0DaughNeg.trackType() & o2::aod::track::TPCrefit)) {
+          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to TPCrefit");
+          continue;
+        }
+      }
+      if (trackV0DaughPos.tpcNClsCrossedRows() < minCrossedRowsV0Daugh ||
+          trackV0DaughNeg.tpcNClsCrossedRows() < minCrossedRowsV0Daugh) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minCrossedRows");
+        continue;
+      }
+      // DCA of the daughters at the V0 building, as in the task that creates the V0s
+      if (std::abs(v0.dcapostopv()) < dcaXYPosToPV ||
+          std::abs(v0.dcanegtopv()) < dcaXYNegToPV) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to DCA to PV --> pos " << v0.dcapostopv() << ", neg " << v0.dcanegtopv());
+        continue;
+      }
+      if (trackV0DaughPos.pt() < ptMin || // to the filters? I can't for now, it is not in the tables
+          trackV0DaughNeg.pt() < ptMin) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minPt --> pos " << trackV0DaughPos.pt() << ", neg " << trackV0DaughNeg.pt() << " (cut " << ptMin << ")");
+        continue;
+      }
+      if (std::abs(trackV0DaughPos.eta()) > etaMax || // to the filters? I can't for now, it is not in the tables
+          std::abs(trackV0DaughNeg.eta()) > etaMax) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to eta --> pos " << trackV0DaughPos.eta() << ", neg " << trackV0DaughNeg.eta() << " (cut " << etaMax << ")");
+        continue;
+      }
 
-    // fist we loop over the bachelor candidate
+      // V0 invariant mass selection
+      if (std::abs(v0.mK0Short() - massK0s) > cutInvMassV0) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to invMass --> " << v0.mK0Short() - massK0s << " (cut " << cutInvMassV0 << ")");
+        continue; // should go to the filter, but since it is a dynamic column, I cannot use it there
+      }
+
+      // V0 cosPointingAngle selection
+      if (v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) < cosPAV0) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to cosPA --> " << v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) << " (cut " << cosPAV0 << ")");
+        continue;
+      }
+
+      MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "KEPT! K0S from Lc with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg);
+
+      const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
+      auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos);
+      trackParCovV0DaughPos.propagateTo(v0.posX(), bZ); // propagate the track to the X closest to the V0 vertex
+      auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg);
+      trackParCovV0DaughNeg.propagateTo(v0.negX(), bZ); // propagate the track to the X closest to the V0 vertex
+      const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
+      // we build the neutral track to then build the cascade
+      auto trackV0 = o2::dataformats::V0(vertexV0, momentumV0, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track
+      selectedV0s.push_back({v0.globalIndex(), static_cast<float>(RecoDecay::pt(momentumV0)), momentumV0, trackV0
+#ifdef MY_DEBUG
+                             ,
+                             indexV0DaughPos, indexV0DaughNeg
+#endif
+      });
+    }
+    if (selectedV0s.empty()) {
+      return;
+    }
 
+    // then the bachelors, with their track parametrisation computed once
+    selectedBachelors.clear();
     // for (const auto& bach : selectedTracks) {
     for (const auto& bach : tracks) {
 
@@ -2223,22 +2378,40 @@ struct HfTrackIndexSkimsCreatorCascades {
       }
       MY_DEBUG_MSG(isProtonFromLc, LOG(info) << "KEPT! proton from Lc with daughters " << indexBach);
 
-      auto trackBach = getTrackParCov(bach);
+      selectedBachelors.push_back({bach.globalIndex(), bach.pt(), {bach.px(), bach.py(), bach.pz()}, getTrackParCov(bach)
+#ifdef MY_DEBUG
+                                   ,
+                                   indexBach
+#endif
+      });
+    }
+
+    // both lists sorted by decreasing pT: the pT of the cascade cannot exceed the sum of the pT of its prongs,
+    // which the propagation does not change, so that the loops can stop at the first pair below the pT cut
+    std::sort(selectedV0s.begin(), selectedV0s.end(), [](const auto& a, const auto& b) { return a.pt > b.pt; });
+    std::sort(selectedBachelors.begin(), selectedBachelors.end(), [](const auto& a, const auto& b) { return a.pt > b.pt; });
+    const float ptMaxV0 = selectedV0s.front().pt;
+
+    for (const auto& bach : selectedBachelors) {
+      if (bach.pt + ptMaxV0 < cutCascPtCandMin) {
+        break;
+      }
+#ifdef MY_DEBUG
+      auto indexBach = bach.index;
+      bool isProtonFromLc = isProtonFromLcFunc(indexBach, indexProton);
+#endif
       // now we loop over the V0s
-      for (const auto& v0 : V0s) {
-        MY_DEBUG_MSG(1, LOG(info) << "*** Checking next K0S");
-        // selections on the V0 daughters
-        const auto& trackV0DaughPos = v0.posTrack_as<MyTracks>();
-        const auto& trackV0DaughNeg = v0.negTrack_as<MyTracks>();
+      for (const auto& v0 : selectedV0s) {
+        if (bach.pt + v0.pt < cutCascPtCandMin) {
+          break;
+        }
 #ifdef MY_DEBUG
-        auto indexV0DaughPos = trackV0DaughPos.mcParticleId();
-        auto indexV0DaughNeg = trackV0DaughNeg.mcParticleId();
+        auto indexV0DaughPos = v0.indexDaughPos;
+        auto indexV0DaughNeg = v0.indexDaughNeg;
         bool isK0SfromLc = isK0SfromLcFunc(indexV0DaughPos, indexV0DaughNeg, indexK0Spos, indexK0Sneg);
 
         bool isLc = isLcK0SpFunc(indexBach, indexV0DaughPos, indexV0DaughNeg, indexProton, indexK0Spos, indexK0Sneg);
 #endif
-        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S from Lc found, trackV0DaughPos --> " << indexV0DaughPos << ", trackV0DaughNeg --> " << indexV0DaughNeg);
-
         MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc,
                      LOG(info) << "ACCEPTED!!!";
                      LOG(info) << "proton belonging to a Lc found: label --> " << indexBach;
@@ -2246,72 +2419,19 @@ struct HfTrackIndexSkimsCreatorCascades {
 
         MY_DEBUG_MSG(isLc, LOG(info) << "Combination of K0S and p which correspond to a Lc found!");
 
-        if (TPCRefitV0Daugh) {
-          if (!(trackV0DaughPos.trackType() & o2::aod::track::TPCrefit) ||
-              !(trackV0DaughNeg.trackType() & o2::aod::track::TPCrefit)) {
-            MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to TPCrefit");
-            continue;
-          }
-        }
-        if (trackV0DaughPos.tpcNClsCrossedRows() < minCrossedRowsV0Daugh ||
-            trackV0DaughNeg.tpcNClsCrossedRows() < minCrossedRowsV0Daugh) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minCrossedRows");
-          continue;
-        }
-        //
-        // if (trackV0DaughPos.dcaXY() < dcaXYPosToPV ||   // to the filters?
-        //     trackV0DaughNeg.dcaXY() < dcaXYNegToPV) {
-        //   continue;
-        // }
-        //
-        if (trackV0DaughPos.pt() < ptMin || // to the filters? I can't for now, it is not in the tables
-            trackV0DaughNeg.pt() < ptMin) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minPt --> pos " << trackV0DaughPos.pt() << ", neg " << trackV0DaughNeg.pt() << " (cut " << ptMin << ")");
-          continue;
-        }
-        if (std::abs(trackV0DaughPos.eta()) > etaMax || // to the filters? I can't for now, it is not in the tables
-            std::abs(trackV0DaughNeg.eta()) > etaMax) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to eta --> pos " << trackV0DaughPos.eta() << ", neg " << trackV0DaughNeg.eta() << " (cut " << etaMax << ")");
-          continue;
-        }
-
-        // V0 invariant mass selection
-        if (std::abs(v0.mK0Short() - massK0s) > cutInvMassV0) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to invMass --> " << v0.mK0Short() - massK0s << " (cut " << cutInvMassV0 << ")");
-          continue; // should go to the filter, but since it is a dynamic column, I cannot use it there
-        }
-
-        // V0 cosPointingAngle selection
-        if (v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) < cosPAV0) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to cosPA --> " << v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) << " (cut " << cosPAV0 << ")");
-          continue;
-        }
-
-        const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
-
         // invariant-mass cut: we do it here, before updating the momenta of bach and V0 during the fitting to save CPU
         // TODO: but one should better check that the value here and after the fitter do not change significantly!!!
-        mass2K0sP = RecoDecay::m(array{array{bach.px(), bach.py(), bach.pz()}, momentumV0}, array{massP, massK0s});
+        mass2K0sP = RecoDecay::m(array{bach.momentum, v0.momentum}, array{massP, massK0s});
         if ((cutCascInvMassLc >= 0.) && (std::abs(mass2K0sP - massLc) > cutCascInvMassLc)) {
           MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc, LOG(info) << "True Lc from proton " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg << " rejected due to invMass cut: " << mass2K0sP << ", mass Lc " << massLc << " (cut " << cutCascInvMassLc << ")");
           continue;
         }
 
-        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "KEPT! K0S from Lc with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg);
-
-        auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos);
-        trackParCovV0DaughPos.propagateTo(v0.posX(), bZ); // propagate the track to the X closest to the V0 vertex
-        auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg);
-        trackParCovV0DaughNeg.propagateTo(v0.negX(), bZ); // propagate the track to the X closest to the V0 vertex
         std::array<float, 3> pVecV0 = {0., 0., 0.};
         std::array<float, 3> pVecBach = {0., 0., 0.};
 
-        const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
-        // we build the neutral track to then build the cascade
-        auto trackV0 = o2::dataformats::V0(vertexV0, momentumV0, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track
-
         // now we find the DCA between the V0 and the bachelor, for the cascade
-        int nCand2 = fitter.process(trackV0, trackBach);
+        int nCand2 = fitter.process(v0.track, bach.track);
         MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc, LOG(info) << "Fitter result = " << nCand2 << " proton = " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg);
         MY_DEBUG_MSG(isLc, LOG(info) << "Fitter result for true Lc = " << nCand2);
         if (nCand2 == 0) {
@@ -2339,8 +2459,8 @@ struct HfTrackIndexSkimsCreatorCascades {
         }
 
         // fill table row
-        rowTrackIndexCasc(bach.globalIndex(),
-                          v0.globalIndex());
+        rowTrackIndexCasc(bach.globalIndex,
+                          v0.globalIndex);
         // fill histograms
         if (doValPlots) {
           MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc && isLc, LOG(info) << "KEPT! True Lc from proton " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg);
@@ -21,12 +21,14 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "PWGHF/Core/HFTreeOutput.h"
 #include "Common/Core/trackUtilities.h"
 #include "ReconstructionDataFormats/DCA.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::aod::hf_cand_prong2;
+using namespace o2::analysis::hf_tree;
 
 namespace o2::aod
 {
@@ -65,6 +67,16 @@ DECLARE_SOA_COLUMN(Ct, ct, float);
 DECLARE_SOA_COLUMN(ImpactParameterProduct, impactParameterProduct, float);
 DECLARE_SOA_COLUMN(CosThetaStar, cosThetaStar, float);
 DECLARE_SOA_COLUMN(MCflag, mcflag, int8_t);
+// Binned nsigma of the reduced table, nsigma = BinningNSigma::bin_width * stored value
+DECLARE_SOA_COLUMN(NSigTPCPiBinned0, nsigTPCPiBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCKaBinned0, nsigTPCKaBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPiBinned0, nsigTOFPiBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFKaBinned0, nsigTOFKaBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPiBinned1, nsigTPCPiBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCKaBinned1, nsigTPCKaBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPiBinned1, nsigTOFPiBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFKaBinned1, nsigTOFKaBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(Weight, weight, float); //! inverse of the fraction of candidates kept by the downsampling
 // Events
 DECLARE_SOA_COLUMN(IsEventReject, isEventReject, int);
 DECLARE_SOA_COLUMN(RunNumber, runNumber, int);
@@ -126,6 +138,39 @@ DECLARE_SOA_TABLE(HfCandProng2Full, "AOD", "HFCANDP2Full",
                   full::E,
                   full::MCflag);
 
+// reduced table with the variables used for the ML training
+DECLARE_SOA_TABLE(HfCandProng2Lite, "AOD", "HFCANDP2Lite",
+                  hf_cand::Chi2PCA,
+                  full::DecayLength,
+                  full::DecayLengthXY,
+                  full::DecayLengthNormalised,
+                  full::DecayLengthXYNormalised,
+                  full::ImpactParameterNormalised0,
+                  full::PtProng0,
+                  full::ImpactParameterNormalised1,
+                  full::PtProng1,
+                  full::NSigTPCPiBinned0,
+                  full::NSigTPCKaBinned0,
+                  full::NSigTOFPiBinned0,
+                  full::NSigTOFKaBinned0,
+                  full::NSigTPCPiBinned1,
+                  full::NSigTPCKaBinned1,
+                  full::NSigTOFPiBinned1,
+                  full::NSigTOFKaBinned1,
+                  full::CandidateSelFlag,
+                  full::M,
+                  full::ImpactParameterProduct,
+                  full::CosThetaStar,
+                  full::Pt,
+                  full::CPA,
+                  full::CPAXY,
+                  full::Ct,
+                  full::Eta,
+                  full::Phi,
+                  full::Y,
+                  full::MCflag,
+                  full::Weight);
+
 DECLARE_SOA_TABLE(HfCandProng2FullEvents, "AOD", "HFCANDP2FullE",
                   collision::BCId,
                   collision::NumContrib,
@@ -150,9 +195,20 @@ struct CandidateTreeWriter {
   Produces<o2::aod::HfCandProng2Full> rowCandidateFull;
   Produces<o2::aod::HfCandProng2FullEvents> rowCandidateFullEvents;
   Produces<o2::aod::HfCandProng2FullParticles> rowCandidateFullParticles;
+  Produces<o2::aod::HfCandProng2Lite> rowCandidateLite;
+
+  Configurable<bool> fillCandidateFull{"fillCandidateFull", true, "Fill the table with all the candidate variables"};
+  Configurable<bool> fillCandidateLite{"fillCandidateLite", false, "Fill the reduced candidate table with binned nsigma and downsampling weights"};
+  Configurable<bool> fillEvents{"fillEvents", true, "Fill the table of events"};
+  Configurable<bool> fillParticles{"fillParticles", true, "Fill the table of generated particles"};
+  Configurable<std::vector<double>> downSamplePtBins{"downSamplePtBins", std::vector<double>{}, "pT bin limits of the downsampling of the reduced table (empty: keep all)"};
+  Configurable<std::vector<double>> downSampleFractions{"downSampleFractions", std::vector<double>{}, "Fraction of candidates kept in the reduced table per pT bin"};
+
+  PtDownsampler downsampler;
 
   void init(InitContext const&)
   {
+    downsampler.setup(downSamplePtBins, downSampleFractions);
   }
 
   void process(aod::Collisions const& collisions,
@@ -163,21 +219,30 @@ struct CandidateTreeWriter {
   {
 
     // Filling event properties
-    rowCandidateFullEvents.reserve(collisions.size());
-    for (auto& collision : collisions) {
-      rowCandidateFullEvents(
-        collision.bcId(),
-        collision.numContrib(),
-        collision.posX(),
-        collision.posY(),
-        collision.posZ(),
-        0,
-        1);
+    if (fillEvents) {
+      rowCandidateFullEvents.reserve(collisions.size());
+      for (auto& collision : collisions) {
+        rowCandidateFullEvents(
+          collision.bcId(),
+          collision.numContrib(),
+          collision.posX(),
+          collision.posY(),
+          collision.posZ(),
+          0,
+          1);
+      }
     }
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateFull) {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
+      auto trackPos = candidate.index0_as<aod::BigTracksPID>(); // positive daughter
+      auto trackNeg = candidate.index1_as<aod::BigTracksPID>(); // negative daughter
+      // same pseudo-random number for both mass hypotheses
+      double pseudoRndm = trackPos.pt() * 1000. - (long)(trackPos.pt() * 1000);
+      float weight = fillCandidateLite ? downsampler.getWeight(candidate.pt(), pseudoRndm) : 0.f;
       auto fillTable = [&](int CandFlag,
                            int FunctionSelection,
                            double FunctionInvMass,
@@ -185,10 +250,43 @@ struct CandidateTreeWriter {
                            double FunctionCt,
                            double FunctionY,
                            double FunctionE) {
-        if (FunctionSelection >= 1) {
+        if (FunctionSelection >= 1 && weight > 0.f) {
+          rowCandidateLite(
+            candidate.chi2PCA(),
+            candidate.decayLength(),
+            candidate.decayLengthXY(),
+            candidate.decayLengthNormalised(),
+            candidate.decayLengthXYNormalised(),
+            candidate.impactParameterNormalised0(),
+            candidate.ptProng0(),
+            candidate.impactParameterNormalised1(),
+            candidate.ptProng1(),
+            packBinned<BinningNSigma>(trackPos.tpcNSigmaPi()),
+            packBinned<BinningNSigma>(trackPos.tpcNSigmaKa()),
+            packBinned<BinningNSigma>(trackPos.tofNSigmaPi()),
+            packBinned<BinningNSigma>(trackPos.tofNSigmaKa()),
+            packBinned<BinningNSigma>(trackNeg.tpcNSigmaPi()),
+            packBinned<BinningNSigma>(trackNeg.tpcNSigmaKa()),
+            packBinned<BinningNSigma>(trackNeg.tofNSigmaPi()),
+            packBinned<BinningNSigma>(trackNeg.tofNSigmaKa()),
+            1 << CandFlag,
+            FunctionInvMass,
+            candidate.impactParameterProduct(),
+            FunctionCosThetaStar,
+            candidate.pt(),
+            candidate.cpa(),
+            candidate.cpaXY(),
+            FunctionCt,
+            candidate.eta(),
+            candidate.phi(),
+            FunctionY,
+            candidate.flagMCMatchRec(),
+            weight);
+        }
+        if (FunctionSelection >= 1 && fillCandidateFull) {
           rowCandidateFull(
-            candidate.index0_as<aod::BigTracksPID>().collision().bcId(),
-            candidate.index0_as<aod::BigTracksPID>().collision().numContrib(),
+            trackPos.collision().bcId(),
+            trackPos.collision().numContrib(),
             candidate.posX(),
             candidate.posY(),
             candidate.posZ(),
@@ -219,14 +317,14 @@ struct CandidateTreeWriter {
             candidate.impactParameter1(),
             candidate.errorImpactParameter0(),
             candidate.errorImpactParameter1(),
-            candidate.index0_as<aod::BigTracksPID>().tpcNSigmaPi(),
-            candidate.index0_as<aod::BigTracksPID>().tpcNSigmaKa(),
-            candidate.index0_as<aod::BigTracksPID>().tofNSigmaPi(),
-            candidate.index0_as<aod::BigTracksPID>().tofNSigmaKa(),
-            candidate.index1_as<aod::BigTracksPID>().tpcNSigmaPi(),
-            candidate.index1_as<aod::BigTracksPID>().tpcNSigmaKa(),
-            candidate.index1_as<aod::BigTracksPID>().tofNSigmaPi(),
-            candidate.index1_as<aod::BigTracksPID>().tofNSigmaKa(),
+            trackPos.tpcNSigmaPi(),
+            trackPos.tpcNSigmaKa(),
+            trackPos.tofNSigmaPi(),
+            trackPos.tofNSigmaKa(),
+            trackNeg.tpcNSigmaPi(),
+            trackNeg.tpcNSigmaKa(),
+            trackNeg.tofNSigmaPi(),
+            trackNeg.tofNSigmaKa(),
             1 << CandFlag,
             FunctionInvMass,
             candidate.impactParameterProduct(),
@@ -249,6 +347,9 @@ struct CandidateTreeWriter {
     }
 
     // Filling particle properties
+    if (!fillParticles) {
+      return;
+    }
     rowCandidateFullParticles.reserve(particles.size());
     for (auto& particle : particles) {
       if (std::abs(particle.flagMCMatchGen()) == 1 << DecayType::D0ToPiK) {
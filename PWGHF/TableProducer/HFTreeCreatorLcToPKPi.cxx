@@ -21,12 +21,14 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "PWGHF/Core/HFTreeOutput.h"
 #include "Common/Core/trackUtilities.h"
 #include "ReconstructionDataFormats/DCA.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::aod::hf_cand_prong3;
+using namespace o2::analysis::hf_tree;
 
 namespace o2::aod
 {
@@ -77,6 +79,26 @@ DECLARE_SOA_COLUMN(CPAXY, cpaXY, float);
 DECLARE_SOA_COLUMN(Ct, ct, float);
 DECLARE_SOA_COLUMN(MCflag, mcflag, int8_t);
 DECLARE_SOA_COLUMN(IsCandidateSwapped, isCandidateSwapped, int8_t);
+// Binned nsigma of the reduced table, nsigma = BinningNSigma::bin_width * stored value
+DECLARE_SOA_COLUMN(NSigTPCPiBinned0, nsigTPCPiBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCKaBinned0, nsigTPCKaBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPrBinned0, nsigTPCPrBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPiBinned0, nsigTOFPiBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFKaBinned0, nsigTOFKaBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPrBinned0, nsigTOFPrBinned0, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPiBinned1, nsigTPCPiBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCKaBinned1, nsigTPCKaBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPrBinned1, nsigTPCPrBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPiBinned1, nsigTOFPiBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFKaBinned1, nsigTOFKaBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPrBinned1, nsigTOFPrBinned1, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPiBinned2, nsigTPCPiBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCKaBinned2, nsigTPCKaBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTPCPrBinned2, nsigTPCPrBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPiBinned2, nsigTOFPiBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFKaBinned2, nsigTOFKaBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(NSigTOFPrBinned2, nsigTOFPrBinned2, BinningNSigma::binned_t);
+DECLARE_SOA_COLUMN(Weight, weight, float); //! inverse of the fraction of candidates kept by the downsampling
 // Events
 DECLARE_SOA_COLUMN(IsEventReject, isEventReject, int);
 DECLARE_SOA_COLUMN(RunNumber, runNumber, int);
@@ -155,6 +177,50 @@ DECLARE_SOA_TABLE(HfCandProng3Full, "AOD", "HFCANDP3Full",
                   full::MCflag,
                   full::IsCandidateSwapped);
 
+// reduced table with the variables used for the ML training
+DECLARE_SOA_TABLE(HfCandProng3Lite, "AOD", "HFCANDP3Lite",
+                  hf_cand::Chi2PCA,
+                  full::DecayLength,
+                  full::DecayLengthXY,
+                  full::DecayLengthNormalised,
+                  full::DecayLengthXYNormalised,
+                  full::ImpactParameterNormalised0,
+                  full::PtProng0,
+                  full::ImpactParameterNormalised1,
+                  full::PtProng1,
+                  full::ImpactParameterNormalised2,
+                  full::PtProng2,
+                  full::NSigTPCPiBinned0,
+                  full::NSigTPCKaBinned0,
+                  full::NSigTPCPrBinned0,
+                  full::NSigTOFPiBinned0,
+                  full::NSigTOFKaBinned0,
+                  full::NSigTOFPrBinned0,
+                  full::NSigTPCPiBinned1,
+                  full::NSigTPCKaBinned1,
+                  full::NSigTPCPrBinned1,
+                  full::NSigTOFPiBinned1,
+                  full::NSigTOFKaBinned1,
+                  full::NSigTOFPrBinned1,
+                  full::NSigTPCPiBinned2,
+                  full::NSigTPCKaBinned2,
+                  full::NSigTPCPrBinned2,
+                  full::NSigTOFPiBinned2,
+                  full::NSigTOFKaBinned2,
+                  full::NSigTOFPrBinned2,
+                  full::CandidateSelFlag,
+                  full::M,
+                  full::Pt,
+                  full::CPA,
+                  full::CPAXY,
+                  full::Ct,
+                  full::Eta,
+                  full::Phi,
+                  full::Y,
+                  full::MCflag,
+                  full::IsCandidateSwapped,
+                  full::Weight);
+
 DECLARE_SOA_TABLE(HfCandProng3FullEvents, "AOD", "HFCANDP3FullE",
                   collision::BCId,
                   collision::NumContrib,
@@ -179,21 +245,31 @@ struct CandidateTreeWriter {
   Produces<o2::aod::HfCandProng3Full> rowCandidateFull;
   Produces<o2::aod::HfCandProng3FullEvents> rowCandidateFullEvents;
   Produces<o2::aod::HfCandProng3FullParticles> rowCandidateFullParticles;
+  Produces<o2::aod::HfCandProng3Lite> rowCandidateLite;
+
+  Configurable<double> downSampleBkgFactor{"downSampleBkgFactor", 1., "Fraction of candidates to store in the tree"};
+  Configurable<bool> fillCandidateFull{"fillCandidateFull", true, "Fill the table with all the candidate variables"};
+  Configurable<bool> fillCandidateLite{"fillCandidateLite", false, "Fill the reduced candidate table with binned nsigma and downsampling weights"};
+  Configurable<bool> fillEvents{"fillEvents", true, "Fill the table of events"};
+  Configurable<bool> fillParticles{"fillParticles", true, "Fill the table of generated particles"};
+  Configurable<std::vector<double>> downSamplePtBins{"downSamplePtBins", std::vector<double>{}, "pT bin limits of the downsampling of the reduced table (empty: keep all)"};
+  Configurable<std::vector<double>> downSampleFractions{"downSampleFractions", std::vector<double>{}, "Fraction of candidates kept in the reduced table per pT bin"};
+
+  PtDownsampler downsampler;
 
   void init(InitContext const&)
   {
+    downsampler.setup(downSamplePtBins, downSampleFractions);
   }
 
-  Configurable<double> downSampleBkgFactor{"downSampleBkgFactor", 1., "Fraction of candidates to store in the tree"};
-
-  void processMC(aod::Collisions const& collisions,
-                 aod::McCollisions const& mccollisions,
-                 soa::Join<aod::HfCandProng3, aod::HfCandProng3MCRec, aod::HFSelLcCandidate> const& candidates,
-                 soa::Join<aod::McParticles, aod::HfCandProng3MCGen> const& particles,
-                 aod::BigTracksPID const& tracks)
+  /// Fills the event table
+  /// \param collisions are the collisions
+  template <typename T>
+  void fillEventTable(T const& collisions)
   {
-
-    // Filling event properties
+    if (!fillEvents) {
+      return;
+    }
     rowCandidateFullEvents.reserve(collisions.size());
     for (auto& collision : collisions) {
       rowCandidateFullEvents(
@@ -205,9 +281,77 @@ struct CandidateTreeWriter {
         0,
         1);
     }
+  }
+
+  /// Fills the reduced candidate table
+  /// \param candidate is the candidate
+  /// \param trackPos1, trackNeg, trackPos2 are the daughter tracks
+  /// \param candFlag is the mass hypothesis
+  /// \param invMass, ct, y are the mass-hypothesis-dependent variables
+  /// \param mcFlag and isSwapped are the MC matching flags, 0 for data
+  /// \param weight is the downsampling weight
+  template <typename TCand, typename TTrack>
+  void fillLiteTable(TCand const& candidate, TTrack const& trackPos1, TTrack const& trackNeg, TTrack const& trackPos2,
+                     int candFlag, float invMass, float ct, float y, int8_t mcFlag, int8_t isSwapped, float weight)
+  {
+    rowCandidateLite(
+      candidate.chi2PCA(),
+      candidate.decayLength(),
+      candidate.decayLengthXY(),
+      candidate.decayLengthNormalised(),
+      candidate.decayLengthXYNormalised(),
+      candidate.impactParameterNormalised0(),
+      candidate.ptProng0(),
+      candidate.impactParameterNormalised1(),
+      candidate.ptProng1(),
+      candidate.impactParameterNormalised2(),
+      candidate.ptProng2(),
+      packBinned<BinningNSigma>(trackPos1.tpcNSigmaPi()),
+      packBinned<BinningNSigma>(trackPos1.tpcNSigmaKa()),
+      packBinned<BinningNSigma>(trackPos1.tpcNSigmaPr()),
+      packBinned<BinningNSigma>(trackPos1.tofNSigmaPi()),
+      packBinned<BinningNSigma>(trackPos1.tofNSigmaKa()),
+      packBinned<BinningNSigma>(trackPos1.tofNSigmaPr()),
+      packBinned<BinningNSigma>(trackNeg.tpcNSigmaPi()),
+      packBinned<BinningNSigma>(trackNeg.tpcNSigmaKa()),
+      packBinned<BinningNSigma>(trackNeg.tpcNSigmaPr()),
+      packBinned<BinningNSigma>(trackNeg.tofNSigmaPi()),
+      packBinned<BinningNSigma>(trackNeg.tofNSigmaKa()),
+      packBinned<BinningNSigma>(trackNeg.tofNSigmaPr()),
+      packBinned<BinningNSigma>(trackPos2.tpcNSigmaPi()),
+      packBinned<BinningNSigma>(trackPos2.tpcNSigmaKa()),
+      packBinned<BinningNSigma>(trackPos2.tpcNSigmaPr()),
+      packBinned<BinningNSigma>(trackPos2.tofNSigmaPi()),
+      packBinned<BinningNSigma>(trackPos2.tofNSigmaKa()),
+      packBinned<BinningNSigma>(trackPos2.tofNSigmaPr()),
+      1 << candFlag,
+      invMass,
+      candidate.pt(),
+      candidate.cpa(),
+      candidate.cpaXY(),
+      ct,
+      candidate.eta(),
+      candidate.phi(),
+      y,
+      mcFlag,
+      isSwapped,
+      weight);
+  }
+
+  void processMC(aod::Collisions const& collisions,
+                 aod::McCollisions const& mccollisions,
+                 soa::Join<aod::HfCandProng3, aod::HfCandProng3MCRec, aod::HFSelLcCandidate> const& candidates,
+                 soa::Join<aod::McParticles, aod::HfCandProng3MCGen> const& particles,
+                 aod::BigTracksPID const& tracks)
+  {
+
+    // Filling event properties
+    fillEventTable(collisions);
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateFull) {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
       auto trackPos1 = candidate.index0_as<aod::BigTracksPID>(); // positive daughter (negative for the antiparticles)
       auto trackNeg = candidate.index1_as<aod::BigTracksPID>();  // negative daughter (positive for the antiparticles)
@@ -219,7 +363,15 @@ struct CandidateTreeWriter {
                            float FunctionY,
                            float FunctionE) {
         double pseudoRndm = trackPos1.pt() * 1000. - (long)(trackPos1.pt() * 1000);
-        if (FunctionSelection >= 1 && std::abs(candidate.flagMCMatchRec()) == 1 << DecayType::LcToPKPi && pseudoRndm < downSampleBkgFactor) {
+        if (FunctionSelection < 1 || std::abs(candidate.flagMCMatchRec()) != 1 << DecayType::LcToPKPi) {
+          return;
+        }
+        if (fillCandidateLite) {
+          if (float weight = downsampler.getWeight(candidate.pt(), pseudoRndm); weight > 0.f) {
+            fillLiteTable(candidate, trackPos1, trackNeg, trackPos2, CandFlag, FunctionInvMass, FunctionCt, FunctionY, candidate.flagMCMatchRec(), candidate.isCandidateSwapped(), weight);
+          }
+        }
+        if (fillCandidateFull && pseudoRndm < downSampleBkgFactor) {
           rowCandidateFull(
             trackPos1.collision().bcId(),
             trackPos1.collision().numContrib(),
@@ -300,6 +452,9 @@ struct CandidateTreeWriter {
     }
 
     // Filling particle properties
+    if (!fillParticles) {
+      return;
+    }
     rowCandidateFullParticles.reserve(particles.size());
     for (auto& particle : particles) {
       if (std::abs(particle.flagMCMatchGen()) == 1 << DecayType::LcToPKPi) {
@@ -321,20 +476,12 @@ struct CandidateTreeWriter {
   {
 
     // Filling event properties
-    rowCandidateFullEvents.reserve(collisions.size());
-    for (auto& collision : collisions) {
-      rowCandidateFullEvents(
-        collision.bcId(),
-        collision.numContrib(),
-        collision.posX(),
-        collision.posY(),
-        collision.posZ(),
-        0,
-        1);
-    }
+    fillEventTable(collisions);
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateFull) {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
       auto trackPos1 = candidate.index0_as<aod::BigTracksPID>(); // positive daughter (negative for the antiparticles)
       auto trackNeg = candidate.index1_as<aod::BigTracksPID>();  // negative daughter (positive for the antiparticles)
@@ -346,7 +493,15 @@ struct CandidateTreeWriter {
                            float FunctionY,
                            float FunctionE) {
         double pseudoRndm = trackPos1.pt() * 1000. - (long)(trackPos1.pt() * 1000);
-        if (FunctionSelection >= 1 && pseudoRndm < downSampleBkgFactor) {
+        if (FunctionSelection < 1) {
+          return;
+        }
+        if (fillCandidateLite) {
+          if (float weight = downsampler.getWeight(candidate.pt(), pseudoRndm); weight > 0.f) {
+            fillLiteTable(candidate, trackPos1, trackNeg, trackPos2, CandFlag, FunctionInvMass, FunctionCt, FunctionY, 0, 0, weight);
+          }
+        }
+        if (fillCandidateFull && pseudoRndm < downSampleBkgFactor) {
           rowCandidateFull(
             trackPos1.collision().bcId(),
             trackPos1.collision().numContrib(),
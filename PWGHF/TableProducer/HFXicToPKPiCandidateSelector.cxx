@@ -138,7 +138,7 @@ struct HFXicToPKPiCandidateSelector {
     return true;
   }
 
-  void process(aod::HfCandProng3 const& candidates, aod::BigTracksPID const&)
+  void process(aod::HfCandProng3 const& candidates, aod::BigTracksPID const& tracks)
   {
     TrackSelectorPID selectorPion(kPiPlus);
     selectorPion.setRangePtTPC(d_pidTPCMinpT, d_pidTPCMaxpT);
@@ -154,6 +154,14 @@ struct HFXicToPKPiCandidateSelector {
     TrackSelectorPID selectorProton(selectorPion);
     selectorProton.setPDG(kProton);
 
+    // PID statuses of the daughters, shared by the candidates
+    TrackSelectorPIDCache pidCachePion(selectorPion);
+    TrackSelectorPIDCache pidCacheKaon(selectorKaon);
+    TrackSelectorPIDCache pidCacheProton(selectorProton);
+    pidCachePion.reset(tracks.size());
+    pidCacheKaon.reset(tracks.size());
+    pidCacheProton.reset(tracks.size());
+
     // looping over 3-prong candidates
     for (auto& candidate : candidates) {
 
@@ -205,11 +213,11 @@ struct HFXicToPKPiCandidateSelector {
         pidXicToPiKP = 1;
       } else {
         // track-level PID selection
-        auto pidTrackPos1Proton = selectorProton.getStatusTrackPIDAll(trackPos1);
-        auto pidTrackPos2Proton = selectorProton.getStatusTrackPIDAll(trackPos2);
-        auto pidTrackPos1Pion = selectorPion.getStatusTrackPIDAll(trackPos1);
-        auto pidTrackPos2Pion = selectorPion.getStatusTrackPIDAll(trackPos2);
-        auto pidTrackNegKaon = selectorKaon.getStatusTrackPIDAll(trackNeg);
+        auto pidTrackPos1Proton = pidCacheProton.getStatusTrackPIDAll(trackPos1);
+        auto pidTrackPos2Proton = pidCacheProton.getStatusTrackPIDAll(trackPos2);
+        auto pidTrackPos1Pion = pidCachePion.getStatusTrackPIDAll(trackPos1);
+        auto pidTrackPos2Pion = pidCachePion.getStatusTrackPIDAll(trackPos2);
+        auto pidTrackNegKaon = pidCacheKaon.getStatusTrackPIDAll(trackNeg);
 
         if (pidTrackPos1Proton == TrackSelectorPID::Status::PIDAccepted &&
             pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
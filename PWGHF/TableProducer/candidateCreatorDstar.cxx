@@ -22,6 +22,10 @@
 
 #include "Framework/runDataProcessing.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 using namespace o2;
 using namespace o2::framework;
 // using namespace o2::aod::hf_cand;
@@ -30,6 +34,7 @@ using namespace o2::framework;
 /// Reconstruction of D* decay candidates
 struct HfCandidateCreatorDstar {
   Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
+  Configurable<double> deltaMassMax{"deltaMassMax", -1., "max. mass difference between the D* and the D0 (GeV/c^2), no cut if negative"};
 
   OutputObj<TH1F> hMass{TH1F("hMass", "D* candidates;inv. mass (#pi D^{0}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtPi{TH1F("hPtPi", "#pi candidates;#it{p}_{T} (GeV/#it{c});entries", 500, 0., 5.)};
@@ -40,35 +45,64 @@ struct HfCandidateCreatorDstar {
   double massPi = RecoDecay::getMassPDG(kPiPlus);
   double massD0 = RecoDecay::getMassPDG(pdg::Code::kD0);
 
+  // D0 quantities shared by all the D* candidates built with the same D0, computed for the first of them
+  struct D0Kinematics {
+    std::array<float, 3> pVec;
+    float ptProng0;
+    float ptProng1;
+    float energy;
+  };
+  std::vector<D0Kinematics> d0Kinematics;
+  std::vector<bool> d0Done;
+
   void process(aod::Collisions const&,
                aod::HfDstars const& rowsTrackIndexDstar,
                aod::BigTracks const&,
-               aod::Hf2Prongs const&)
+               aod::Hf2Prongs const& rowsTrackIndexProng2)
   {
+    d0Kinematics.resize(rowsTrackIndexProng2.size());
+    d0Done.assign(rowsTrackIndexProng2.size(), false);
+    const float massPiF = massPi;
+    const float massD0F = massD0;
+    const float massPi2 = massPiF * massPiF;
+    const float deltaMassMaxF = deltaMassMax;
+
     // loop over pairs of prong indices
     for (const auto& rowTrackIndexDstar : rowsTrackIndexDstar) {
-      auto trackPi = rowTrackIndexDstar.index0_as<aod::BigTracks>();
-      auto prongD0 = rowTrackIndexDstar.indexD0_as<aod::Hf2Prongs>();
-      auto trackD0Prong0 = prongD0.index0_as<aod::BigTracks>();
-      auto trackD0Prong1 = prongD0.index1_as<aod::BigTracks>();
-      // auto collisionPiId = trackPi.collisionId();
-      // auto collisionD0Id = trackD0Prong0.collisionId();
-
-      // LOGF(info, "Pi collision %ld, D0 collision %ld", collisionPiId, collisionD0Id);
+      const auto indexD0 = rowTrackIndexDstar.indexD0Id();
+      auto& d0 = d0Kinematics[indexD0];
+      if (!d0Done[indexD0]) {
+        auto prongD0 = rowTrackIndexDstar.indexD0_as<aod::Hf2Prongs>();
+        auto trackD0Prong0 = prongD0.index0_as<aod::BigTracks>();
+        auto trackD0Prong1 = prongD0.index1_as<aod::BigTracks>();
+        std::array<float, 3> pVecD0Prong0 = {trackD0Prong0.px(), trackD0Prong0.py(), trackD0Prong0.pz()};
+        std::array<float, 3> pVecD0Prong1 = {trackD0Prong1.px(), trackD0Prong1.py(), trackD0Prong1.pz()};
+        d0.pVec = RecoDecay::pVec(pVecD0Prong0, pVecD0Prong1);
+        d0.ptProng0 = RecoDecay::pt(pVecD0Prong0);
+        d0.ptProng1 = RecoDecay::pt(pVecD0Prong1);
+        d0.energy = std::sqrt(RecoDecay::p2(d0.pVec) + massD0F * massD0F);
+        d0Done[indexD0] = true;
+      }
 
+      auto trackPi = rowTrackIndexDstar.index0_as<aod::BigTracks>();
       std::array<float, 3> pVecPi = {trackPi.px(), trackPi.py(), trackPi.pz()};
-      std::array<float, 3> pVecD0Prong0 = {trackD0Prong0.px(), trackD0Prong0.py(), trackD0Prong0.pz()};
-      std::array<float, 3> pVecD0Prong1 = {trackD0Prong1.px(), trackD0Prong1.py(), trackD0Prong1.pz()};
-      auto pVecD0 = RecoDecay::pVec(pVecD0Prong0, pVecD0Prong1);
+
+      // mass from the float four-momenta, checked against the mass difference window before anything else
+      const float pSumX = pVecPi[0] + d0.pVec[0];
+      const float pSumY = pVecPi[1] + d0.pVec[1];
+      const float pSumZ = pVecPi[2] + d0.pVec[2];
+      const float eSum = std::sqrt(RecoDecay::p2(pVecPi) + massPi2) + d0.energy;
+      const float mass = std::sqrt(std::max(eSum * eSum - pSumX * pSumX - pSumY * pSumY - pSumZ * pSumZ, 0.f));
+      if (deltaMassMaxF >= 0.f && mass - massD0F > deltaMassMaxF) {
+        continue;
+      }
 
       // fill histograms
       if (fillHistograms) {
         hPtPi->Fill(RecoDecay::pt(pVecPi));
-        hPtD0->Fill(RecoDecay::pt(pVecD0));
-        hPtD0Prong0->Fill(RecoDecay::pt(pVecD0Prong0));
-        hPtD0Prong1->Fill(RecoDecay::pt(pVecD0Prong1));
-        // calculate invariant mass
-        auto mass = RecoDecay::m(std::array{pVecPi, pVecD0}, std::array{massPi, massD0});
+        hPtD0->Fill(RecoDecay::pt(d0.pVec));
+        hPtD0Prong0->Fill(d0.ptProng0);
+        hPtD0Prong1->Fill(d0.ptProng1);
         hMass->Fill(mass);
       }
     }
@@ -21,6 +21,9 @@
 #include "Framework/runDataProcessing.h"
 #include "PWGHF/DataModel/HFSecondaryVertex.h"
 #include "PWGHF/DataModel/HFCandidateSelectionTables.h"
+#include "Common/Core/IntervalIndex.h"
+#include <numeric>
+#include <thread>
 
 using namespace o2;
 using namespace o2::framework;
@@ -62,43 +65,49 @@ struct AddAmbiguousTrackInfo {
   Produces<o2::aod::TracksWithAmbiguousCollisionInfo> trackWithAmbiguousInfo;
   using TracksWithSel = soa::Join<aod::Tracks, aod::TrackSelection>;
 
+  IntervalIndex<uint64_t> collisionsBCs; // BCs of the collisions
+
   void process(TracksWithSel const& tracks,
                aod::AmbiguousTracks const& ambitracks,
                aod::Collisions const& collisions,
                aod::BCs const&)
   {
-    // loop over ambiguous tracks
-    std::vector<int> trackIndices{};
-    std::vector<int> ambTrackIndices{};
+    // index of the collisions by their BC
+    collisionsBCs.clear();
+    for (auto& collision : collisions) {
+      auto globalBC = collision.bc().globalBC();
+      collisionsBCs.add(globalBC, globalBC, collision.globalIndex());
+    }
+    collisionsBCs.build();
+
+    // ambiguous track associated to each global track
+    std::vector<int64_t> ambTrackIndices(tracks.size(), -1);
     for (auto& ambitrack : ambitracks) {
       auto track = ambitrack.track_as<TracksWithSel>(); // Obtain the corresponding track
-      if (track.isGlobalTrackWoDCA()) {                 // add info only for global tracks
-        trackIndices.push_back(track.globalIndex());
-        ambTrackIndices.push_back(ambitrack.globalIndex());
+      auto& ambTrackIndex = ambTrackIndices[track.globalIndex() - tracks.offset()];
+      if (track.isGlobalTrackWoDCA() && ambTrackIndex < 0) { // add info only for global tracks
+        ambTrackIndex = ambitrack.globalIndex();
       }
     }
     // loop over tracks
+    std::vector<int64_t> collIndicesFound{};
     for (auto& track : tracks) {
       std::vector<int> collIndices{};
       bool isAmbiguous = false;
       std::size_t nBC = 0;
-      if (track.isGlobalTrackWoDCA()) { // add info only for global tracks
-        auto trackIdx = track.globalIndex();
-        auto iter = std::find(trackIndices.begin(), trackIndices.end(), trackIdx);
-        if (iter != trackIndices.end()) {
-          isAmbiguous = true;
-          auto ambitrack = ambitracks.rawIteratorAt(ambTrackIndices[std::distance(trackIndices.begin(), iter)]);
-          nBC = ambitrack.bc().size();
-          for (auto& collision : collisions) {
-            uint64_t mostProbableBC = collision.bc().globalBC();
-            for (auto& bc : ambitrack.bc()) {
-              if (bc.globalBC() == mostProbableBC) {
-                collIndices.push_back(collision.globalIndex());
-                break;
-              }
-            }
-          }
+      auto ambTrackIndex = ambTrackIndices[track.globalIndex() - tracks.offset()];
+      if (ambTrackIndex >= 0) {
+        isAmbiguous = true;
+        auto ambitrack = ambitracks.rawIteratorAt(ambTrackIndex);
+        nBC = ambitrack.bc().size();
+        // collisions whose BC is one of the BCs of the track, in the order of the collision table
+        collIndicesFound.clear();
+        for (auto& bc : ambitrack.bc()) {
+          collisionsBCs.findContaining(bc.globalBC(), collIndicesFound);
         }
+        std::sort(collIndicesFound.begin(), collIndicesFound.end());
+        collIndicesFound.erase(std::unique(collIndicesFound.begin(), collIndicesFound.end()), collIndicesFound.end());
+        collIndices.assign(collIndicesFound.begin(), collIndicesFound.end());
       }
       trackWithAmbiguousInfo(isAmbiguous, nBC, collIndices);
     }
@@ -127,6 +136,9 @@ struct ValidationGenLevel {
   Configurable<double> yVertexMax{"yVertexMax", 100., "max. y of generated primary vertex [cm]"};
   Configurable<double> zVertexMin{"zVertexMin", -100., "min. z of generated primary vertex [cm]"};
   Configurable<double> zVertexMax{"zVertexMax", 100., "max. z of generated primary vertex [cm]"};
+  Configurable<int> nThreads{"nThreads", 4, "max. number of threads for processConcurrent"};
+
+  static const int nCollisionsPerThreadMin = 20; // min. number of MC collisions per thread
 
   std::shared_ptr<TH1> hPromptCharmHadronsPtDistr, hPromptCharmHadronsYDistr, hNonPromptCharmHadronsPtDistr, hNonPromptCharmHadronsYDistr, hPromptCharmHadronsDecLenDistr, hNonPromptCharmHadronsDecLenDistr, hQuarkPerEvent;
 
@@ -169,6 +181,9 @@ struct ValidationGenLevel {
 
   void init(o2::framework::InitContext&)
   {
+    if (doprocessPerCollision == doprocessConcurrent) {
+      LOGF(fatal, "Enable exactly one of processPerCollision and processConcurrent");
+    }
     hPromptCharmHadronsPtDistr = registry.add<TH2>("hPromptCharmHadronsPtDistr", "Pt distribution vs prompt charm hadron in |#it{y}^{gen}|<0.5; ; #it{p}_{T}^{gen} (GeV/#it{c})", HistType::kTH2F, {axisSpecies, axisPt});
     hPromptCharmHadronsYDistr = registry.add<TH2>("hPromptCharmHadronsYDistr", "Y distribution vs prompt charm hadron; ; #it{y}^{gen}", HistType::kTH2F, {axisSpecies, axisY});
     hPromptCharmHadronsDecLenDistr = registry.add<TH2>("hPromptCharmHadronsDecLDistr", "Decay length distribution vs prompt charm hadron; ; decay length (#mum)", HistType::kTH2F, {axisSpecies, axisDecLen});
@@ -205,47 +220,59 @@ struct ValidationGenLevel {
     return true;
   }
 
-  void process(aod::McCollision const& mccollision, aod::McParticles const& particlesMC)
+  /// Histogram entries of one MC collision
+  /// \note Collected by the (possibly concurrent) analysis of the collision and filled in the registry afterwards.
+  struct GenLevelEntries {
+    std::array<int, 4> quarkCounts{};                        // c, cbar, b, bbar
+    std::vector<std::array<double, 2>> ptYCharmQuarks{};     // (pt, y) of charm quarks
+    std::vector<std::array<double, 2>> ptYBeautyQuarks{};    // (pt, y) of beauty quarks
+    std::vector<std::array<double, 6>> momentumDifferences{}; // (conservation result, px, py, pz, p, pt differences)
+    std::vector<std::array<double, 5>> hadrons{};            // (origin, hadron species, pt, y, decay length)
+    std::array<int, nCharmHadrons> counterPrompt{}, counterNonPrompt{};
+    bool hasSignal = false;
+  };
+
+  /// Analyses the MC particles of one collision.
+  /// \param mccollision  MC collision
+  /// \param particlesMC  table with the MC particles, used to access the mothers and daughters
+  /// \param rows  rows of the particles of the collision in particlesMC
+  /// \param entries  histogram entries of the collision
+  template <typename TCollision, typename TParticles, typename TRows>
+  void analyseCollision(TCollision const& mccollision, TParticles const& particlesMC, TRows const& rows, GenLevelEntries& entries)
   {
-    int cPerCollision = 0;
-    int cBarPerCollision = 0;
-    int bPerCollision = 0;
-    int bBarPerCollision = 0;
-
     // Particles and their decay checked in the second part of the task
     std::array<int, nCharmHadrons> PDGArrayParticle = {pdg::Code::kDPlus, 413, pdg::Code::kD0, 431, pdg::Code::kLambdaCPlus, pdg::Code::kXiCPlus, pdg::Code::kJpsi};
     std::array<std::array<int, 3>, nCharmHadrons> arrPDGFinal = {{{kPiPlus, kPiPlus, -kKPlus}, {kPiPlus, kPiPlus, -kKPlus}, {-kKPlus, kPiPlus, 0}, {kPiPlus, kKPlus, -kKPlus}, {kProton, -kKPlus, kPiPlus}, {kProton, -kKPlus, kPiPlus}, {kElectron, -kElectron, 0}}};
-    std::array<int, nCharmHadrons> counterPrompt{0}, counterNonPrompt{0};
     std::vector<int> listDaughters{};
 
-    bool hasSignal = false;
-
-    for (auto& particle : particlesMC) {
-      if (!selectVertex(mccollision))
-        continue;
+    if (!selectVertex(mccollision)) {
+      return;
+    }
 
+    for (auto row : rows) {
+      auto particle = particlesMC.rawIteratorAt(row);
       int particlePdgCode = particle.pdgCode();
       if (!particle.has_mothers()) {
         continue;
       }
-      auto mother = particle.mothers_as<aod::McParticles>().front();
+      auto mother = particle.template mothers_as<aod::McParticles>().front();
       if (particlePdgCode != mother.pdgCode()) {
         switch (particlePdgCode) {
           case kCharm:
-            cPerCollision++;
-            registry.fill(HIST("hPtVsYCharmQuark"), particle.pt(), particle.y());
+            entries.quarkCounts[0]++;
+            entries.ptYCharmQuarks.push_back({particle.pt(), particle.y()});
             break;
           case kCharmBar:
-            cBarPerCollision++;
-            registry.fill(HIST("hPtVsYCharmQuark"), particle.pt(), particle.y());
+            entries.quarkCounts[1]++;
+            entries.ptYCharmQuarks.push_back({particle.pt(), particle.y()});
             break;
           case kBottom:
-            bPerCollision++;
-            registry.fill(HIST("hPtVsYBeautyQuark"), particle.pt(), particle.y());
+            entries.quarkCounts[2]++;
+            entries.ptYBeautyQuarks.push_back({particle.pt(), particle.y()});
             break;
           case kBottomBar:
-            bBarPerCollision++;
-            registry.fill(HIST("hPtVsYBeautyQuark"), particle.pt(), particle.y());
+            entries.quarkCounts[3]++;
+            entries.ptYBeautyQuarks.push_back({particle.pt(), particle.y()});
             break;
         }
       }
@@ -265,12 +292,12 @@ struct ValidationGenLevel {
           std::size_t arrayPDGsize = arrPDGFinal[iD].size() - std::count(arrPDGFinal[iD].begin(), arrPDGFinal[iD].end(), 0);
           int origin = -1;
           if (listDaughters.size() == arrayPDGsize) {
-            hasSignal = true;
+            entries.hasSignal = true;
             origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
             if (origin == RecoDecay::OriginType::Prompt) {
-              counterPrompt[iD]++;
+              entries.counterPrompt[iD]++;
             } else if (origin == RecoDecay::OriginType::NonPrompt) {
-              counterNonPrompt[iD]++;
+              entries.counterNonPrompt[iD]++;
             }
           }
           for (std::size_t iDau = 0; iDau < listDaughters.size(); ++iDau) {
@@ -287,55 +314,125 @@ struct ValidationGenLevel {
           }
           double pDiff = RecoDecay::p(pxDiff, pyDiff, pzDiff);
           double ptDiff = RecoDecay::pt(pxDiff, pyDiff);
-          auto daughter0 = particle.daughters_as<aod::McParticles>().begin();
+          auto daughter0 = particle.template daughters_as<aod::McParticles>().begin();
           double vertexDau[3] = {daughter0.vx(), daughter0.vy(), daughter0.vz()};
           double vertexPrimary[3] = {mccollision.posX(), mccollision.posY(), mccollision.posZ()};
 
           auto decayLength = RecoDecay::distance(vertexPrimary, vertexDau);
-          // Filling histograms with per-component momentum conservation
-          registry.fill(HIST("hMomentumCheck"), float(momentumCheck));
-          registry.fill(HIST("hPxDiffMotherDaughterGen"), pxDiff);
-          registry.fill(HIST("hPyDiffMotherDaughterGen"), pyDiff);
-          registry.fill(HIST("hPzDiffMotherDaughterGen"), pzDiff);
-          registry.fill(HIST("hPDiffMotherDaughterGen"), pDiff);
-          registry.fill(HIST("hPtDiffMotherDaughterGen"), ptDiff);
-          if (origin == RecoDecay::OriginType::Prompt) {
-            if (std::abs(particle.y()) < 0.5) {
-              hPromptCharmHadronsPtDistr->Fill(whichHadron, particle.pt());
-            }
-            hPromptCharmHadronsYDistr->Fill(whichHadron, particle.y());
-            hPromptCharmHadronsDecLenDistr->Fill(whichHadron, decayLength * 10000);
-          } else if (origin == RecoDecay::OriginType::NonPrompt) {
-            if (std::abs(particle.y()) < 0.5) {
-              hNonPromptCharmHadronsPtDistr->Fill(whichHadron, particle.pt());
-            }
-            hNonPromptCharmHadronsYDistr->Fill(whichHadron, particle.y());
-            hNonPromptCharmHadronsDecLenDistr->Fill(whichHadron, decayLength * 10000);
+          // per-component momentum conservation
+          entries.momentumDifferences.push_back({float(momentumCheck), pxDiff, pyDiff, pzDiff, pDiff, ptDiff});
+          if (origin == RecoDecay::OriginType::Prompt || origin == RecoDecay::OriginType::NonPrompt) {
+            entries.hadrons.push_back({double(origin), double(whichHadron), particle.pt(), particle.y(), decayLength * 10000});
           }
         }
       }
     } // end particles
-    registry.fill(HIST("hCountAverageC"), cPerCollision);
-    registry.fill(HIST("hCountAverageB"), bPerCollision);
-    registry.fill(HIST("hCountAverageCbar"), cBarPerCollision);
-    registry.fill(HIST("hCountAverageBbar"), bBarPerCollision);
-    registry.fill(HIST("hCounterPerCollisionPromptDplus"), counterPrompt[0]);
-    registry.fill(HIST("hCounterPerCollisionPromptDstar"), counterPrompt[1]);
-    registry.fill(HIST("hCounterPerCollisionPromptDzero"), counterPrompt[2]);
-    registry.fill(HIST("hCounterPerCollisionPromptDs"), counterPrompt[3]);
-    registry.fill(HIST("hCounterPerCollisionPromptLambdaC"), counterPrompt[4]);
-    registry.fill(HIST("hCounterPerCollisionPromptXiC"), counterPrompt[5]);
-    registry.fill(HIST("hCounterPerCollisionPromptJPsi"), counterPrompt[6]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptDplus"), counterNonPrompt[0]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptDstar"), counterNonPrompt[1]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptDzero"), counterNonPrompt[2]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptDs"), counterNonPrompt[3]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptLambdaC"), counterNonPrompt[4]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptXiC"), counterNonPrompt[5]);
-    registry.fill(HIST("hCounterPerCollisionNonPromptJPsi"), counterNonPrompt[6]);
-
-    collWithHFSignal(hasSignal);
   }
+
+  /// Fills the histograms with the entries of one MC collision.
+  /// \param entries  histogram entries of the collision
+  void fillHistograms(GenLevelEntries const& entries)
+  {
+    for (auto const& [pt, y] : entries.ptYCharmQuarks) {
+      registry.fill(HIST("hPtVsYCharmQuark"), pt, y);
+    }
+    for (auto const& [pt, y] : entries.ptYBeautyQuarks) {
+      registry.fill(HIST("hPtVsYBeautyQuark"), pt, y);
+    }
+    for (auto const& [momentumCheck, pxDiff, pyDiff, pzDiff, pDiff, ptDiff] : entries.momentumDifferences) {
+      registry.fill(HIST("hMomentumCheck"), momentumCheck);
+      registry.fill(HIST("hPxDiffMotherDaughterGen"), pxDiff);
+      registry.fill(HIST("hPyDiffMotherDaughterGen"), pyDiff);
+      registry.fill(HIST("hPzDiffMotherDaughterGen"), pzDiff);
+      registry.fill(HIST("hPDiffMotherDaughterGen"), pDiff);
+      registry.fill(HIST("hPtDiffMotherDaughterGen"), ptDiff);
+    }
+    for (auto const& [origin, whichHadron, pt, y, decayLength] : entries.hadrons) {
+      if (int(origin) == RecoDecay::OriginType::Prompt) {
+        if (std::abs(y) < 0.5) {
+          hPromptCharmHadronsPtDistr->Fill(whichHadron, pt);
+        }
+        hPromptCharmHadronsYDistr->Fill(whichHadron, y);
+        hPromptCharmHadronsDecLenDistr->Fill(whichHadron, decayLength);
+      } else {
+        if (std::abs(y) < 0.5) {
+          hNonPromptCharmHadronsPtDistr->Fill(whichHadron, pt);
+        }
+        hNonPromptCharmHadronsYDistr->Fill(whichHadron, y);
+        hNonPromptCharmHadronsDecLenDistr->Fill(whichHadron, decayLength);
+      }
+    }
+    registry.fill(HIST("hCountAverageC"), entries.quarkCounts[0]);
+    registry.fill(HIST("hCountAverageB"), entries.quarkCounts[2]);
+    registry.fill(HIST("hCountAverageCbar"), entries.quarkCounts[1]);
+    registry.fill(HIST("hCountAverageBbar"), entries.quarkCounts[3]);
+    registry.fill(HIST("hCounterPerCollisionPromptDplus"), entries.counterPrompt[0]);
+    registry.fill(HIST("hCounterPerCollisionPromptDstar"), entries.counterPrompt[1]);
+    registry.fill(HIST("hCounterPerCollisionPromptDzero"), entries.counterPrompt[2]);
+    registry.fill(HIST("hCounterPerCollisionPromptDs"), entries.counterPrompt[3]);
+    registry.fill(HIST("hCounterPerCollisionPromptLambdaC"), entries.counterPrompt[4]);
+    registry.fill(HIST("hCounterPerCollisionPromptXiC"), entries.counterPrompt[5]);
+    registry.fill(HIST("hCounterPerCollisionPromptJPsi"), entries.counterPrompt[6]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptDplus"), entries.counterNonPrompt[0]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptDstar"), entries.counterNonPrompt[1]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptDzero"), entries.counterNonPrompt[2]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptDs"), entries.counterNonPrompt[3]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptLambdaC"), entries.counterNonPrompt[4]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptXiC"), entries.counterNonPrompt[5]);
+    registry.fill(HIST("hCounterPerCollisionNonPromptJPsi"), entries.counterNonPrompt[6]);
+  }
+
+  void processPerCollision(aod::McCollision const& mccollision, aod::McParticles const& particlesMC)
+  {
+    std::vector<int64_t> rows(particlesMC.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    GenLevelEntries entries{};
+    analyseCollision(mccollision, particlesMC, rows, entries);
+    fillHistograms(entries);
+    collWithHFSignal(entries.hasSignal);
+  }
+  PROCESS_SWITCH(ValidationGenLevel, processPerCollision, "Analyse the MC collisions one by one", true);
+
+  /// Analyses the MC collisions of the data frame concurrently.
+  /// The histograms are filled and the table is written afterwards in the order of the collisions, so the output does not depend on the number of threads.
+  void processConcurrent(aod::McCollisions const& mccollisions, aod::McParticles const& particlesMC)
+  {
+    // rows of the particles of each collision, in the order of the table
+    const std::size_t nCollisions = mccollisions.size();
+    std::vector<std::vector<int64_t>> rowsCollisions(nCollisions);
+    for (auto& particle : particlesMC) {
+      if (particle.has_mcCollision()) {
+        rowsCollisions[particle.mcCollisionId()].push_back(particle.globalIndex() - particlesMC.offset());
+      }
+    }
+
+    std::vector<GenLevelEntries> entriesCollisions(nCollisions);
+    auto analyseRange = [&](std::size_t first, std::size_t last) {
+      for (auto iCollision = first; iCollision < last; ++iCollision) {
+        analyseCollision(mccollisions.rawIteratorAt(iCollision), particlesMC, rowsCollisions[iCollision], entriesCollisions[iCollision]);
+      }
+    };
+    const std::size_t nThreadsUsed = std::clamp<std::size_t>(nCollisions / nCollisionsPerThreadMin, 1, std::max(1, nThreads.value));
+    if (nThreadsUsed == 1) {
+      analyseRange(0, nCollisions);
+    } else {
+      const std::size_t nCollisionsPerThread = (nCollisions + nThreadsUsed - 1) / nThreadsUsed;
+      std::vector<std::thread> threads;
+      for (std::size_t iThread = 0; iThread < nThreadsUsed; ++iThread) {
+        const auto first = iThread * nCollisionsPerThread;
+        threads.emplace_back(analyseRange, first, std::min(nCollisions, first + nCollisionsPerThread));
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+
+    for (auto const& entries : entriesCollisions) {
+      fillHistograms(entries);
+      collWithHFSignal(entries.hasSignal);
+    }
+  }
+  PROCESS_SWITCH(ValidationGenLevel, processConcurrent, "Analyse all the MC collisions of the data frame in parallel threads", false);
 };
 
 /// Rec Level Validation
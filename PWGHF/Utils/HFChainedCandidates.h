@@ -0,0 +1,309 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file HFChainedCandidates.h
+/// \brief Building blocks of the creators of candidates made of an HF candidate and additional prongs (Lb, B+, Xicc, X, chi_c)
+///
+/// The parent candidates of a collision are rebuilt once as tracks at their fitted vertex, with their impact parameter,
+/// and the bachelor tracks of the collision are converted once to track parametrisations split by charge, with their
+/// helix and impact parameter. The combinations are pruned on the estimated distance of closest approach to the parent
+/// and invariant mass before the vertex fit, and the surviving ones are fitted in one batch, in parallel if requested.
+
+#ifndef O2_ANALYSIS_HFCHAINEDCANDIDATES_H_
+#define O2_ANALYSIS_HFCHAINEDCANDIDATES_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "ReconstructionDataFormats/DCA.h"
+#include "Common/Core/DCAFitterCache.h"
+#include "Common/Core/ThreadPool.h"
+#include "Common/Core/trackUtilities.h"
+
+namespace o2::analysis::hf_chained
+{
+
+/// Parent HF candidate rebuilt at its secondary vertex
+struct Parent {
+  int64_t globalIndex = -1;                    ///< index of the candidate in its table
+  o2::track::TrackParCov track;                ///< parent track at its secondary vertex
+  TrackHelixXY helix;                          ///< helix of the parent track, with zero radius for neutral parents
+  std::array<float, 3> vertex{};               ///< secondary vertex
+  std::array<float, 3> pVec{};                 ///< momentum
+  std::array<int64_t, 3> prongIds{-1, -1, -1}; ///< global indices of the prong tracks, -1 for the missing ones
+  float chi2PCA = 0.f;                         ///< chi2 at the PCA of the parent vertex
+  int sign = 0;                                ///< charge sign, 0 for the neutral parents
+  o2::dataformats::DCA impactParameter;        ///< impact parameter of the parent track w.r.t. the primary vertex
+  int hfflag = 0;                              ///< decay channels of the parent candidate
+  int selection = 0;                           ///< selection bits of the task, e.g. the mass hypotheses passed
+
+  bool isProng(int64_t trackId) const { return std::find(prongIds.begin(), prongIds.end(), trackId) != prongIds.end(); }
+};
+
+/// Bachelor track of a collision
+struct Bachelor {
+  int64_t globalIndex = -1;             ///< index of the track
+  float pt = 0.f;                       ///< transverse momentum
+  float eta = 0.f;                      ///< pseudorapidity
+  o2::track::TrackParCov track;         ///< track parametrisation
+  TrackHelixXY helix;                   ///< helix at the reference point
+  o2::dataformats::DCA impactParameter; ///< impact parameter w.r.t. the primary vertex
+};
+
+/// Parents and bachelors of one collision
+class CandidateIndex
+{
+ public:
+  /// Forgets the candidates of the previous collision
+  /// \param primaryVertex  primary vertex of the collision
+  /// \param bz  magnetic field along z (kG)
+  void reset(const o2::dataformats::VertexBase& primaryVertex, float bz)
+  {
+    mPrimaryVertex = primaryVertex;
+    mBz = bz;
+    mParents.clear();
+    mBachelors[0].clear();
+    mBachelors[1].clear();
+  }
+
+  /// Adds a parent candidate, its impact parameter being computed on a copy of its track
+  Parent& addParent(int64_t globalIndex, const o2::track::TrackParCov& track, const std::array<float, 3>& vertex, const std::array<float, 3>& pVec)
+  {
+    auto& parent = mParents.emplace_back();
+    parent.globalIndex = globalIndex;
+    parent.track = track;
+    parent.helix = getTrackHelixXY(track, mBz);
+    parent.vertex = vertex;
+    parent.pVec = pVec;
+    auto trackAtPV = track;
+    trackAtPV.propagateToDCA(mPrimaryVertex, mBz, &parent.impactParameter);
+    return parent;
+  }
+
+  /// Fills the bachelors with the tracks passing the selection of the task, in the order of the table
+  /// \param select  callable returning whether a track is a bachelor candidate
+  template <typename TTracks, typename TSelect>
+  void fillBachelors(const TTracks& tracks, TSelect&& select)
+  {
+    for (const auto& track : tracks) {
+      if (!select(track)) {
+        continue;
+      }
+      auto& bachelor = mBachelors[track.sign() > 0 ? 1 : 0].emplace_back();
+      bachelor.globalIndex = track.globalIndex();
+      bachelor.pt = track.pt();
+      bachelor.eta = track.eta();
+      bachelor.track = getTrackParCov(track);
+      bachelor.helix = getTrackHelixXY(bachelor.track, mBz);
+      auto trackAtPV = bachelor.track;
+      trackAtPV.propagateToDCA(mPrimaryVertex, mBz, &bachelor.impactParameter);
+    }
+  }
+
+  std::vector<Parent>& parents() { return mParents; }
+  const std::vector<Parent>& parents() const { return mParents; }
+  /// \return bachelors of a given charge sign
+  const std::vector<Bachelor>& bachelors(int sign) const { return mBachelors[sign > 0 ? 1 : 0]; }
+  const o2::dataformats::VertexBase& primaryVertex() const { return mPrimaryVertex; }
+
+ private:
+  std::vector<Parent> mParents;                    ///< parent candidates
+  std::array<std::vector<Bachelor>, 2> mBachelors; ///< negative and positive bachelors
+  o2::dataformats::VertexBase mPrimaryVertex;      ///< primary vertex of the collision
+  float mBz = 0.f;                                 ///< magnetic field (kG)
+};
+
+/// Estimates the closest approach of a bachelor to a parent, from the crossings of their helices in the bending plane,
+/// the neutral parents being straight lines
+/// \param pVecParent,pVecBachelor  estimated momenta at the point of closest approach
+/// \return estimated distance of closest approach (cm), negative if no estimate could be made
+inline float getClosestApproach(const Parent& parent, const Bachelor& bachelor, std::array<float, 3>& pVecParent, std::array<float, 3>& pVecBachelor)
+{
+  std::array<float, 3> pca;
+  if (parent.helix.r != 0.f) {
+    return getHelixClosestApproach(parent.helix, bachelor.helix, pca, pVecParent, pVecBachelor);
+  }
+  const auto& helix = bachelor.helix;
+  const float ptParent = std::sqrt(parent.pVec[0] * parent.pVec[0] + parent.pVec[1] * parent.pVec[1]);
+  const float r = std::abs(helix.r);
+  if (r == 0.f || ptParent == 0.f) {
+    return -1.f;
+  }
+  pVecParent = parent.pVec;
+  // line x = vertex + t * u, crossings with the circle |x - centre| = r
+  const float ux = parent.pVec[0] / ptParent;
+  const float uy = parent.pVec[1] / ptParent;
+  const float dx = parent.vertex[0] - helix.xC;
+  const float dy = parent.vertex[1] - helix.yC;
+  const float b = ux * dx + uy * dy;
+  const float c = dx * dx + dy * dy - r * r;
+  const float discriminant = b * b - c;
+  std::array<std::array<float, 3>, 2> points; // {t, x and y on the circle}
+  int nPoints = 1;
+  if (discriminant >= 0.f) {
+    for (int i = 0; i < 2; i++) {
+      const float t = -b + (i == 0 ? -1.f : 1.f) * std::sqrt(discriminant);
+      points[i] = {t, parent.vertex[0] + t * ux, parent.vertex[1] + t * uy};
+    }
+    nPoints = 2;
+  } else {
+    // point of the line closest to the centre, and point of the circle in its direction
+    const float t = -b;
+    const float xL = dx + t * ux;
+    const float yL = dy + t * uy;
+    const float dL = std::sqrt(xL * xL + yL * yL);
+    points[0] = {t, helix.xC + r * xL / dL, helix.yC + r * yL / dL};
+  }
+  const float tglParent = parent.pVec[2] / ptParent;
+  float dca2 = -1.f;
+  for (int iPoint = 0; iPoint < nPoints; iPoint++) {
+    const auto& point = points[iPoint];
+    const float xLine = parent.vertex[0] + point[0] * ux;
+    const float yLine = parent.vertex[1] + point[0] * uy;
+    const float zLine = parent.vertex[2] + point[0] * tglParent;
+    const float xRef = helix.x0 - helix.xC;
+    const float yRef = helix.y0 - helix.yC;
+    const float xP = point[1] - helix.xC;
+    const float yP = point[2] - helix.yC;
+    const float dPhi = std::atan2(xRef * yP - yRef * xP, xRef * xP + yRef * yP);
+    const float zHelix = helix.z0 + helix.tgl * dPhi * helix.r;
+    const float dist2 = (point[1] - xLine) * (point[1] - xLine) + (point[2] - yLine) * (point[2] - yLine) + (zHelix - zLine) * (zHelix - zLine);
+    if (dca2 >= 0.f && dist2 >= dca2) {
+      continue;
+    }
+    dca2 = dist2;
+    pVecBachelor = {-yP / helix.r * helix.pt, xP / helix.r * helix.pt, helix.pt * helix.tgl};
+  }
+  return std::sqrt(dca2);
+}
+
+/// Cuts applied to the estimates of the closest approach before the vertex fit
+struct PruningSettings {
+  float maxDca = -1.f;  ///< max. estimated distance of closest approach of each bachelor to the parent (cm), not applied if negative
+  float massMin = 0.f;  ///< min. invariant mass from the estimated momenta
+  float massMax = -1.f; ///< max. invariant mass from the estimated momenta, the mass is not cut if not above massMin
+};
+
+/// Decides whether a combination of a parent with bachelors is fitted
+/// \param masses  mass hypotheses of the parent and of the bachelors
+/// \return false if the estimates exclude the combination; combinations without estimate are kept
+template <std::size_t nBachelors>
+bool passPruning(const PruningSettings& settings, const Parent& parent, const std::array<const Bachelor*, nBachelors>& bachelors, const std::array<float, nBachelors + 1>& masses)
+{
+  const bool cutDca = settings.maxDca >= 0.f;
+  const bool cutMass = settings.massMax > settings.massMin;
+  if (!cutDca && !cutMass) {
+    return true;
+  }
+  std::array<float, 3> pVecParent;
+  std::array<float, 4> pSum{}; // px, py, pz, E
+  bool hasEstimate = true;
+  for (std::size_t i = 0; i < nBachelors; i++) {
+    std::array<float, 3> pVecBachelor;
+    const float dca = getClosestApproach(parent, *bachelors[i], pVecParent, pVecBachelor);
+    if (dca < 0.f) {
+      hasEstimate = false;
+      break;
+    }
+    if (cutDca && dca > settings.maxDca) {
+      return false;
+    }
+    const float p2 = pVecBachelor[0] * pVecBachelor[0] + pVecBachelor[1] * pVecBachelor[1] + pVecBachelor[2] * pVecBachelor[2];
+    pSum = {pSum[0] + pVecBachelor[0], pSum[1] + pVecBachelor[1], pSum[2] + pVecBachelor[2], pSum[3] + std::sqrt(p2 + masses[i + 1] * masses[i + 1])};
+  }
+  if (!hasEstimate || !cutMass) {
+    return true;
+  }
+  // the parent momentum of the last estimate is used, the parent direction changes little between the bachelors
+  const float p2Parent = pVecParent[0] * pVecParent[0] + pVecParent[1] * pVecParent[1] + pVecParent[2] * pVecParent[2];
+  pSum = {pSum[0] + pVecParent[0], pSum[1] + pVecParent[1], pSum[2] + pVecParent[2], pSum[3] + std::sqrt(p2Parent + masses[0] * masses[0])};
+  const float mass2 = pSum[3] * pSum[3] - pSum[0] * pSum[0] - pSum[1] * pSum[1] - pSum[2] * pSum[2];
+  const float mass = std::sqrt(std::max(mass2, 0.f));
+  return mass >= settings.massMin && mass <= settings.massMax;
+}
+
+/// Combination of a parent with nProngs - 1 bachelors, and the result of its vertex fit
+template <int nProngs>
+struct Combination {
+  const Parent* parent = nullptr;                         ///< parent candidate
+  std::array<const Bachelor*, nProngs - 1> bachelors{};   ///< bachelor tracks
+  bool isVertexFound = false;                             ///< whether the fit converged
+  std::array<float, 3> secondaryVertex{};                 ///< fitted vertex
+  float chi2PCA = 0.f;                                    ///< chi2 at the PCA
+  std::array<float, 6> covMatrixPCA{};                    ///< covariance matrix of the fitted vertex
+  std::array<std::array<float, 3>, nProngs> pVecProngs{}; ///< momenta of the parent and of the bachelors at the fitted vertex
+};
+
+/// Vertex fitters of the combinations of a task, the batches being split in up to nThreads contiguous chunks fitted in parallel
+/// by the threads of the pool (Common/Core/ThreadPool.h), each chunk with its own copy of the fitter. The results are stored in
+/// the combinations, so they do not depend on the number of threads.
+template <int nProngs>
+class FitterPool
+{
+ public:
+  /// \param settings  fitter settings
+  /// \param nThreads  max. number of chunks fitted in parallel
+  /// \param nCombinationsPerThreadMin  min. number of combinations per thread, smaller batches are fitted in fewer threads
+  void configure(const DCAFitterSettings& settings, int nThreads, std::size_t nCombinationsPerThreadMin = 50)
+  {
+    mFitter.configure(settings);
+    mNThreads = std::max(1, nThreads);
+    mNCombinationsPerThreadMin = std::max<std::size_t>(1, nCombinationsPerThreadMin);
+  }
+
+  /// Fits the vertices of a batch of combinations
+  /// \param bz  magnetic field along z (kG)
+  void fit(std::vector<Combination<nProngs>>& combinations, float bz)
+  {
+    auto& fitter = mFitter.get(bz);
+    const std::size_t nCombinations = combinations.size();
+    const std::size_t nChunks = o2::analysis::ThreadPool::nChunks(nCombinations, mNCombinationsPerThreadMin, static_cast<int>(mNThreads));
+    if (nChunks == 1) {
+      fitRange(fitter, combinations, 0, nCombinations);
+      return;
+    }
+    std::vector<o2::vertexing::DCAFitterN<nProngs>> fittersChunk(nChunks, fitter);
+    o2::analysis::ThreadPool::instance().parallelFor(nCombinations, nChunks, [&](std::size_t iChunk, std::size_t first, std::size_t last) {
+      fitRange(fittersChunk[iChunk], combinations, first, last);
+    });
+  }
+
+ private:
+  static void fitRange(o2::vertexing::DCAFitterN<nProngs>& fitter, std::vector<Combination<nProngs>>& combinations, std::size_t first, std::size_t last)
+  {
+    for (auto iComb = first; iComb < last; ++iComb) {
+      auto& combination = combinations[iComb];
+      combination.isVertexFound = std::apply([&](auto const*... bachelor) { return fitter.process(combination.parent->track, bachelor->track...); }, combination.bachelors) > 0;
+      if (!combination.isVertexFound) {
+        continue;
+      }
+      combination.secondaryVertex = fitter.getPCACandidatePos();
+      combination.chi2PCA = fitter.getChi2AtPCACandidate();
+      combination.covMatrixPCA = fitter.calcPCACovMatrixFlat();
+      fitter.propagateTracksToVertex();
+      for (int iProng = 0; iProng < nProngs; ++iProng) {
+        fitter.getTrack(iProng).getPxPyPzGlo(combination.pVecProngs[iProng]);
+      }
+    }
+  }
+
+  DCAFitterCache<nProngs> mFitter;             ///< fitter of the main thread, copied to the chunks
+  std::size_t mNThreads = 1;                   ///< max. number of chunks fitted in parallel
+  std::size_t mNCombinationsPerThreadMin = 50; ///< min. number of combinations per thread
+};
+
+} // namespace o2::analysis::hf_chained
+
+#endif // O2_ANALYSIS_HFCHAINEDCANDIDATES_H_
@@ -13,8 +13,11 @@
 //
 // Author: Jochen Klein, Nima Zardoshti
 #include "PWGJE/Core/JetFinder.h"
+#include "Common/Core/ThreadPool.h"
 #include "Framework/Logger.h"
 
+#include <algorithm>
+
 /// Sets the jet finding parameters
 void JetFinder::setParams()
 {
@@ -41,6 +44,7 @@ void JetFinder::setBkgE()
   if (bkgSubMode == BkgSubMode::rhoAreaSub || bkgSubMode == BkgSubMode::constSub) {
     bkgE = decltype(bkgE)(new fastjet::JetMedianBackgroundEstimator(selRho, jetDefBkg, areaDefBkg));
   } else {
+    bkgE.reset();
     if (bkgSubMode != BkgSubMode::none) {
       LOGF(error, "requested subtraction mode not implemented!");
     }
@@ -50,6 +54,8 @@ void JetFinder::setBkgE()
 /// Sets the background subtraction pointer
 void JetFinder::setSub()
 {
+  sub.reset();
+  constituentSub.reset();
   //if rho < 1e-6 it is set to 1e-6 in AliPhysics
   if (bkgSubMode == BkgSubMode::rhoAreaSub) {
     sub = decltype(sub){new fastjet::Subtractor{bkgE.get()}};
@@ -68,6 +74,31 @@ void JetFinder::setSub()
   }
 }
 
+/// Parameters of the jet finding, the background estimation and the subtraction
+std::vector<double> JetFinder::getParams() const
+{
+  return {static_cast<double>(bkgSubMode), phiMin, phiMax, etaMin, etaMax,
+          jetR, jetPtMin, jetPtMax, jetPhiMin, jetPhiMax, jetEtaMin, jetEtaMax,
+          ghostEtaMin, ghostEtaMax, ghostArea, static_cast<double>(ghostRepeatN), ghostktMean, gridScatter, ktScatter,
+          jetBkgR, bkgPhiMin, bkgPhiMax, bkgEtaMin, bkgEtaMax, constSubAlpha, constSubRMax, static_cast<double>(isReclustering),
+          static_cast<double>(algorithm), static_cast<double>(recombScheme), static_cast<double>(strategy), static_cast<double>(areaType),
+          static_cast<double>(algorithmBkg), static_cast<double>(recombSchemeBkg), static_cast<double>(strategyBkg), static_cast<double>(areaTypeBkg)};
+}
+
+/// Sets up the jet finding, the background estimation and the subtraction, if the parameters changed
+void JetFinder::setup()
+{
+  if (getParams() == setupParams) {
+    return;
+  }
+  setParams();
+  setBkgE();
+  setSub();
+  // after setParams, which derives the jet eta range from the jet radius
+  setupParams = getParams();
+  multiRJetRs.clear();
+}
+
 /// Performs jet finding
 /// \note the input particle and jet lists are passed by reference
 /// \param inputParticles vector of input particles/tracks
@@ -75,13 +106,11 @@ void JetFinder::setSub()
 /// \return ClusterSequenceArea object needed to access constituents
 fastjet::ClusterSequenceArea JetFinder::findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets) //ideally find a way of passing the cluster sequence as a reeference
 {
-  setParams();
-  setBkgE();
+  setup();
   jets.clear();
 
   if (bkgE) {
     bkgE->set_particles(inputParticles);
-    setSub();
   }
   if (constituentSub) {
     inputParticles = constituentSub->subtract_event(inputParticles);
@@ -91,3 +120,121 @@ fastjet::ClusterSequenceArea JetFinder::findJets(std::vector<fastjet::PseudoJet>
   jets = selJets(jets);
   return clusterSeq;
 }
+
+/// Performs jet finding for several jet radii at once
+/// \param inputParticles vector of input particles/tracks
+/// \param jetRs jet radii
+/// \param jets vectors of jets to be filled, one per radius
+/// \param clusterSeqs cluster sequences to be filled, one per radius, needed to access the constituents
+/// \param nThreads max. number of chunks of radii clustered in parallel by the threads of the pool
+void JetFinder::findJets(std::vector<fastjet::PseudoJet>& inputParticles, const std::vector<double>& jetRs, std::vector<std::vector<fastjet::PseudoJet>>& jets,
+                         std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>>& clusterSeqs, int nThreads)
+{
+  const int nR = jetRs.size();
+  jets.assign(nR, {});
+  clusterSeqs.clear();
+  clusterSeqs.resize(nR);
+  if (nR == 0) {
+    return;
+  }
+
+  setupMultiR(jetRs);
+  const double actualGhostArea = ghostAreaSpec.actual_ghost_area();
+
+  if (bkgE) {
+    bkgE->set_particles(inputParticles);
+  }
+  if (constituentSub) {
+    inputParticles = constituentSub->subtract_event(inputParticles);
+  }
+
+  o2::analysis::ThreadPool::instance().parallelFor(nR, std::max(nThreads, 1), [&](std::size_t, std::size_t first, std::size_t last) {
+    for (auto i = first; i < last; i++) {
+      clusterSeqs[i] = std::make_unique<fastjet::ClusterSequenceActiveAreaExplicitGhosts>(inputParticles, multiRJetDefs[i], ghosts, actualGhostArea);
+      jets[i] = clusterSeqs[i]->inclusive_jets();
+    }
+  });
+
+  for (int i = 0; i < nR; i++) {
+    if (sub) {
+      jets[i] = (*sub)(jets[i]);
+    }
+    jets[i] = multiRSelectors[i](jets[i]);
+  }
+}
+
+/// Sets up the jet definitions, selections and ghosts of the explicit ghost clustering for the given radii
+void JetFinder::setupMultiR(const std::vector<double>& jetRs)
+{
+  jetR = jetRs.front();
+  setup();
+  if (jetRs != multiRJetRs) {
+    multiRJetDefs.clear();
+    multiRSelectors.clear();
+    for (auto R : jetRs) {
+      jetR = R;
+      setParams();
+      multiRJetDefs.push_back(jetDef);
+      multiRSelectors.push_back(selJets && !fastjet::SelectorIsPureGhost());
+    }
+    jetR = jetRs.front();
+    setParams();
+    // the ghosts are generated here, as their random generator is not thread safe,
+    // and the fastjet banner is printed before any clustering
+    ghosts.clear();
+    ghostAreaSpec.add_ghosts(ghosts);
+    fastjet::ClusterSequence::print_banner();
+    multiRJetRs = jetRs;
+  }
+}
+
+/// Performs jet finding on several input particle lists with the jet radius jetR
+/// \param inputParticles vectors of input particles/tracks, one per list
+/// \param jets vectors of jets to be filled, one per list
+/// \param clusterSeqs cluster sequences to be filled, one per list, needed to access the constituents
+/// \param nThreads max. number of chunks of lists clustered in parallel by the threads of the pool
+void JetFinder::findJets(std::vector<std::vector<fastjet::PseudoJet>>& inputParticles, std::vector<std::vector<fastjet::PseudoJet>>& jets,
+                         std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>>& clusterSeqs, int nThreads)
+{
+  const int nInputs = inputParticles.size();
+  jets.resize(nInputs);
+  clusterSeqs.resize(nInputs);
+  if (nInputs == 0) {
+    return;
+  }
+
+  setupMultiR({jetR});
+  const double actualGhostArea = ghostAreaSpec.actual_ghost_area();
+
+  // the background estimator and the subtractors keep their state, they are used list by list
+  // the background is always estimated from the particles before the constituent subtraction, as for a single list
+  std::vector<std::vector<fastjet::PseudoJet>> unsubtractedParticles;
+  if (constituentSub) {
+    if (sub && bkgE) {
+      unsubtractedParticles = inputParticles;
+    }
+    for (auto& particles : inputParticles) {
+      if (bkgE) {
+        bkgE->set_particles(particles);
+      }
+      particles = constituentSub->subtract_event(particles);
+    }
+  }
+
+  o2::analysis::ThreadPool::instance().parallelFor(nInputs, std::max(nThreads, 1), [&](std::size_t, std::size_t first, std::size_t last) {
+    for (auto i = first; i < last; i++) {
+      clusterSeqs[i] = std::make_unique<fastjet::ClusterSequenceActiveAreaExplicitGhosts>(inputParticles[i], multiRJetDefs.front(), ghosts, actualGhostArea);
+      jets[i] = clusterSeqs[i]->inclusive_jets();
+    }
+  });
+
+  for (int i = 0; i < nInputs; i++) {
+    if (sub) {
+      if (bkgE) {
+        bkgE->set_particles(unsubtractedParticles.empty() ? inputParticles[i] : unsubtractedParticles[i]);
+      }
+      jets[i] = (*sub)(jets[i]);
+    }
+    jets[i] = multiRSelectors.front()(jets[i]);
+  }
+}
@@ -22,12 +22,14 @@
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
+#include "fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh"
 #include "fastjet/AreaDefinition.hh"
 #include "fastjet/JetDefinition.hh"
 #include "fastjet/tools/JetMedianBackgroundEstimator.hh"
 #include "fastjet/tools/Subtractor.hh"
 #include "fastjet/contrib/ConstituentSubtractor.hh"
 
+#include <memory>
 #include <vector>
 
 class JetFinder
@@ -154,6 +156,10 @@ class JetFinder
   /// Sets the background subtraction pointer
   void setSub();
 
+  /// Sets up the jet finding, the background estimation and the subtraction,
+  /// only if the parameters changed since the last setup
+  void setup();
+
   /// Performs jet finding
   /// \note the input particle and jet lists are passed by reference
   /// \param inputParticles vector of input particles/tracks
@@ -161,13 +167,47 @@ class JetFinder
   /// \return ClusterSequenceArea object needed to access constituents
   fastjet::ClusterSequenceArea findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets); // ideally find a way of passing the cluster sequence as a reeference
 
+  /// Performs jet finding for several jet radii at once
+  /// The background estimate, the constituent subtraction and the ghosts do not depend on the jet radius and are done once,
+  /// then the radii are clustered concurrently with explicit ghosts
+  /// \note the jet constituents include the ghosts, which have to be skipped with fastjet::SelectorIsPureGhost
+  /// \note only one ghost repetition is done, whatever ghostRepeatN
+  /// \note the ghosts are generated when the parameters change and are then reused for all the events
+  /// \param inputParticles vector of input particles/tracks
+  /// \param jetRs jet radii
+  /// \param jets vectors of jets to be filled, one per radius
+  /// \param clusterSeqs cluster sequences to be filled, one per radius, needed to access the constituents
+  /// \param nThreads number of threads clustering the radii
+  void findJets(std::vector<fastjet::PseudoJet>& inputParticles, const std::vector<double>& jetRs, std::vector<std::vector<fastjet::PseudoJet>>& jets,
+                std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>>& clusterSeqs, int nThreads = 1);
+
+  /// Performs jet finding on several input particle lists with the same jet radius jetR
+  /// e.g. the event with the prongs of each HF candidate replaced by the candidate
+  /// The lists are clustered concurrently with explicit ghosts, with the same caveats as the multi-radius mode
+  /// \param inputParticles vectors of input particles/tracks, one per list
+  /// \param jets vectors of jets to be filled, one per list
+  /// \param clusterSeqs cluster sequences to be filled, one per list, needed to access the constituents
+  /// \param nThreads number of threads clustering the lists
+  void findJets(std::vector<std::vector<fastjet::PseudoJet>>& inputParticles, std::vector<std::vector<fastjet::PseudoJet>>& jets,
+                std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>>& clusterSeqs, int nThreads = 1);
+
  private:
+  /// Sets up the jet definitions, selections and ghosts of the explicit ghost clustering, if the radii changed
+  void setupMultiR(const std::vector<double>& jetRs);
   // void setParams();
   // void setBkgSub();
   std::unique_ptr<fastjet::BackgroundEstimatorBase> bkgE;
   std::unique_ptr<fastjet::Subtractor> sub;
   std::unique_ptr<fastjet::contrib::ConstituentSubtractor> constituentSub;
 
+  /// Parameters of the last setup
+  std::vector<double> getParams() const;
+  std::vector<double> setupParams;                   //!
+  std::vector<double> multiRJetRs;                   //! radii of the multi-radius setup
+  std::vector<fastjet::JetDefinition> multiRJetDefs; //! jet definitions of the multi-radius setup
+  std::vector<fastjet::Selector> multiRSelectors;    //! jet selections of the multi-radius setup
+  std::vector<fastjet::PseudoJet> ghosts;            //! ghosts of the multi-radius setup
+
   ClassDefNV(JetFinder, 1);
 };
 
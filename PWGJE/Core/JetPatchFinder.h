@@ -0,0 +1,101 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file JetPatchFinder.h
+/// \brief Maximum transverse momentum summed in square (eta, phi) patches of a coarse grid, as a cheap jet pre-trigger
+///
+/// The constituents are summed in cells of a grid covering the acceptance, then the sums of all the patches of
+/// nCells x nCells cells are computed with sliding windows, periodic in phi. The patches covering the 2R x 2R square
+/// of a jet of radius R collect most of its momentum, so that an event without any patch above a fraction of the
+/// jet threshold does not need the full clustering.
+
+#ifndef O2_ANALYSIS_JETPATCHFINDER_H
+#define O2_ANALYSIS_JETPATCHFINDER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class JetPatchFinder
+{
+ public:
+  JetPatchFinder() = default;
+
+  /// \param etaMin, etaMax  acceptance of the constituents
+  /// \param cellSize  size of the cells in eta and phi
+  /// \param patchSize  size of the patches, rounded up to a number of cells, and such that a patch contains any square of this size
+  void setup(float etaMin, float etaMax, float cellSize, float patchSize)
+  {
+    mEtaMin = etaMin;
+    mNEta = std::max(1, static_cast<int>(std::ceil((etaMax - etaMin) / cellSize)));
+    mNPhi = std::max(1, static_cast<int>(std::ceil(TwoPi / cellSize)));
+    mEtaScale = mNEta / (etaMax - etaMin);
+    mPhiScale = mNPhi / TwoPi;
+    mPatchEta = std::min(mNEta, static_cast<int>(std::ceil(patchSize * mEtaScale)) + 1);
+    mPatchPhi = std::min(mNPhi, static_cast<int>(std::ceil(patchSize * mPhiScale)) + 1);
+    mCells.assign(mNEta * mNPhi, 0.f);
+    mStrip.assign(mNPhi, 0.f);
+  }
+
+  void clear() { std::fill(mCells.begin(), mCells.end(), 0.f); }
+
+  /// Adds a constituent, the ones outside the acceptance being added to the border cells
+  void fill(float pt, float eta, float phi)
+  {
+    const int iEta = std::clamp(static_cast<int>((eta - mEtaMin) * mEtaScale), 0, mNEta - 1);
+    phi -= TwoPi * std::floor(phi / TwoPi);
+    const int iPhi = std::min(static_cast<int>(phi * mPhiScale), mNPhi - 1);
+    mCells[iEta * mNPhi + iPhi] += pt;
+  }
+
+  /// \return maximum pT sum of the patches of the filled constituents
+  float maxPatch()
+  {
+    float maximum = 0.f;
+    std::fill(mStrip.begin(), mStrip.end(), 0.f);
+    for (int iEta = 0; iEta < mNEta; iEta++) {
+      // strip of the mPatchEta rows ending at iEta, per phi cell
+      const float* added = &mCells[iEta * mNPhi];
+      const float* removed = iEta >= mPatchEta ? &mCells[(iEta - mPatchEta) * mNPhi] : nullptr;
+      for (int iPhi = 0; iPhi < mNPhi; iPhi++) {
+        mStrip[iPhi] += added[iPhi] - (removed ? removed[iPhi] : 0.f);
+      }
+      if (iEta + 1 < mPatchEta && iEta + 1 < mNEta) {
+        continue;
+      }
+      float window = 0.f;
+      for (int iPhi = 0; iPhi < mPatchPhi; iPhi++) {
+        window += mStrip[iPhi];
+      }
+      maximum = std::max(maximum, window);
+      for (int iPhi = 1; iPhi < mNPhi; iPhi++) {
+        window += mStrip[(iPhi + mPatchPhi - 1) % mNPhi] - mStrip[iPhi - 1];
+        maximum = std::max(maximum, window);
+      }
+    }
+    return maximum;
+  }
+
+ private:
+  static constexpr float TwoPi = 2.f * static_cast<float>(M_PI);
+
+  float mEtaMin = -0.9f;
+  float mEtaScale = 1.f;
+  float mPhiScale = 1.f;
+  int mNEta = 1;
+  int mNPhi = 1;
+  int mPatchEta = 1;
+  int mPatchPhi = 1;
+  std::vector<float> mCells; ///< pT sum per cell, phi cells contiguous
+  std::vector<float> mStrip; ///< pT sum of the rows of the current patch, per phi cell
+};
+
+#endif // O2_ANALYSIS_JETPATCHFINDER_H
@@ -0,0 +1,121 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// jet substructure of a batch of jets
+//
+// The constituents of each jet are reclustered with Cambridge/Aachen, without ghosts, and the
+// Soft Drop observables (zg, Rg, nSD) and the angularity are computed from the same reclustering.
+// The jets of a batch can be distributed over several threads.
+
+#ifndef O2_ANALYSIS_JETSUBSTRUCTUREENGINE_H
+#define O2_ANALYSIS_JETSUBSTRUCTUREENGINE_H
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequence.hh"
+#include "fastjet/JetDefinition.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+class JetSubstructureEngine
+{
+ public:
+  /// Substructure observables of a jet, negative zg, rg and angularity if not available
+  struct Result {
+    float zg = -1.0;
+    float rg = -1.0;
+    int nsd = 0;
+    float angularity = -1.0;
+  };
+
+  float zCut = 0.1;            ///< soft drop z cut
+  float beta = 0.0;            ///< soft drop beta
+  float jetR = 0.4;            ///< resolution parameter of the jets
+  float reclusteringR = 1.0;   ///< resolution parameter of the reclustering
+  float angularityKappa = 1.0; ///< momentum fraction exponent of the angularity
+  float angularityBeta = 1.0;  ///< angular exponent of the angularity
+
+  /// Computes the substructure of one jet
+  /// \param constituents constituents of the jet
+  Result compute(const std::vector<fastjet::PseudoJet>& constituents) const
+  {
+    Result result;
+    if (constituents.empty()) {
+      return result;
+    }
+    fastjet::ClusterSequence clusterSeq(constituents, fastjet::JetDefinition(fastjet::cambridge_algorithm, reclusteringR, fastjet::E_scheme, fastjet::Best));
+    auto reclustered = sorted_by_pt(clusterSeq.inclusive_jets());
+    const fastjet::PseudoJet& jet = reclustered[0];
+
+    // angularity with respect to the axis of the reclustered jet
+    double angularity = 0.;
+    for (const auto& constituent : jet.constituents()) {
+      angularity += std::pow(constituent.perp() / jet.perp(), angularityKappa) * std::pow(constituent.delta_R(jet) / jetR, angularityBeta);
+    }
+    result.angularity = angularity;
+
+    // soft drop along the hardest branch
+    fastjet::PseudoJet daughterSubJet = jet;
+    fastjet::PseudoJet parentSubJet1;
+    fastjet::PseudoJet parentSubJet2;
+    bool softDropped = false;
+    while (daughterSubJet.has_parents(parentSubJet1, parentSubJet2)) {
+      if (parentSubJet1.perp() < parentSubJet2.perp()) {
+        std::swap(parentSubJet1, parentSubJet2);
+      }
+      auto z = parentSubJet2.perp() / (parentSubJet1.perp() + parentSubJet2.perp());
+      auto r = parentSubJet1.delta_R(parentSubJet2);
+      if (z >= zCut * std::pow(r / jetR, beta)) {
+        if (!softDropped) {
+          result.zg = z;
+          result.rg = r;
+          softDropped = true;
+        }
+        result.nsd++;
+      }
+      daughterSubJet = parentSubJet1;
+    }
+    return result;
+  }
+
+  /// Computes the substructure of a batch of jets
+  /// \param constituents constituents of each jet
+  /// \param results filled with the substructure of each jet
+  /// \param nThreads number of threads over which the jets are distributed
+  void compute(const std::vector<std::vector<fastjet::PseudoJet>>& constituents, std::vector<Result>& results, int nThreads = 1) const
+  {
+    const int nJets = constituents.size();
+    results.assign(nJets, Result());
+    if (nJets == 0) {
+      return;
+    }
+    auto work = [&](int first, int stride) {
+      for (int i = first; i < nJets; i += stride) {
+        results[i] = compute(constituents[i]);
+      }
+    };
+    nThreads = std::clamp(nThreads, 1, nJets);
+    // the fastjet banner is printed before any concurrent clustering
+    fastjet::ClusterSequence::print_banner();
+    std::vector<std::thread> workers;
+    for (int thread = 1; thread < nThreads; thread++) {
+      workers.emplace_back(work, thread, nThreads);
+    }
+    work(0, nThreads);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+};
+
+#endif
@@ -17,9 +17,12 @@
 #ifndef O2_ANALYSIS_JETUTILITIES_H
 #define O2_ANALYSIS_JETUTILITIES_H
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <memory>
 #include <numeric>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -223,6 +226,275 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
   return std::make_tuple(baseToTagMap, tagToBaseMap);
 }
 
+/**
+ * Score of a candidate match: the geometrical distance.
+ *
+ * A score is called as score(iBase, iTag, distance) for the candidates within the matching distance,
+ * and the candidate with the lowest score is chosen, in both directions.
+ */
+struct DistanceScore {
+  template <typename T>
+  double operator()(std::size_t, std::size_t, T distance) const
+  {
+    return distance;
+  }
+};
+
+/**
+ * Score of a candidate match: the geometrical distance plus the relative pt difference times a weight.
+ */
+template <typename T>
+struct PtWeightedScore {
+  const std::vector<T>& jetsBasePt;
+  const std::vector<T>& jetsTagPt;
+  double ptWeight = 1.;
+
+  double operator()(std::size_t iBase, std::size_t iTag, T distance) const
+  {
+    return distance + ptWeight * std::abs(jetsBasePt[iBase] - jetsTagPt[iTag]) / jetsBasePt[iBase];
+  }
+};
+
+/**
+ * Score of a candidate match: minus the fraction of the base jet pt carried by constituents shared with the tag jet.
+ *
+ * The constituents are given by their indices, which must refer to the same table for both collections,
+ * sorted in increasing order.
+ */
+template <typename T>
+struct SharedConstituentsScore {
+  const std::vector<std::vector<int>>& jetsBaseConstituents;
+  const std::vector<std::vector<T>>& jetsBaseConstituentsPt;
+  const std::vector<std::vector<int>>& jetsTagConstituents;
+
+  double operator()(std::size_t iBase, std::size_t iTag, T) const
+  {
+    const auto& base = jetsBaseConstituents[iBase];
+    const auto& basePt = jetsBaseConstituentsPt[iBase];
+    const auto& tag = jetsTagConstituents[iTag];
+    double shared = 0., total = 0.;
+    auto itTag = tag.begin();
+    for (std::size_t i = 0; i < base.size(); i++) {
+      total += basePt[i];
+      itTag = std::lower_bound(itTag, tag.end(), base[i]);
+      if (itTag != tag.end() && *itTag == base[i]) {
+        shared += basePt[i];
+      }
+    }
+    return total > 0. ? -shared / total : 0.;
+  }
+};
+
+/**
+ * Geometrical jet matching, keeping its buffers from event to event.
+ *
+ * Same matching as `MatchJetsGeometrically`, where the candidates within the matching distance are found
+ * with a grid of eta x phi cells wrapping around in phi for small jet collections and with a KD-tree for large ones.
+ * The matched candidates are chosen according to a score, the distance by default.
+ *
+ * NOTE: Assumes, but does not validate, that 0 <= phi < 2pi.
+ */
+template <typename T>
+class GeometricalJetMatcher
+{
+ public:
+  /**
+   * Sets the largest collection, in number of jets, for which the grid is used.
+   */
+  void setGridMaxJets(std::size_t nJets) { gridMaxJets = nJets; }
+
+  /**
+   * Matches the base and the tag jets.
+   *
+   * @param jetsBasePhi Base jet collection phi.
+   * @param jetsBaseEta Base jet collection eta.
+   * @param jetsTagPhi Tag jet collection phi.
+   * @param jetsTagEta Tag jet collection eta.
+   * @param maxMatchingDistance Maximum matching distance.
+   * @param baseToTagMap Filled with the index of the tag jet uniquely matched to each base jet, -1 if none.
+   * @param tagToBaseMap Filled with the index of the base jet uniquely matched to each tag jet, -1 if none.
+   * @param score Score of the candidates, called as score(iBase, iTag, distance), the lowest is chosen.
+   */
+  template <typename Score = DistanceScore>
+  void match(const std::vector<T>& jetsBasePhi, const std::vector<T>& jetsBaseEta,
+             const std::vector<T>& jetsTagPhi, const std::vector<T>& jetsTagEta,
+             double maxMatchingDistance, std::vector<int>& baseToTagMap, std::vector<int>& tagToBaseMap,
+             Score score = {})
+  {
+    const std::size_t nJetsBase = jetsBaseEta.size();
+    const std::size_t nJetsTag = jetsTagEta.size();
+    if (jetsBasePhi.size() != nJetsBase) {
+      throw std::invalid_argument("Base collection eta and phi sizes don't match. Check the inputs.");
+    }
+    if (jetsTagPhi.size() != nJetsTag) {
+      throw std::invalid_argument("Tag collection eta and phi sizes don't match. Check the inputs.");
+    }
+    baseToTagMap.assign(nJetsBase, -1);
+    tagToBaseMap.assign(nJetsTag, -1);
+    if (!(nJetsBase && nJetsTag) || maxMatchingDistance <= 0) {
+      return;
+    }
+
+    const bool useGrid = std::max(nJetsBase, nJetsTag) <= gridMaxJets;
+    // Find the best tag jet for each base jet
+    findBest(jetsTagPhi, jetsTagEta, jetsBasePhi, jetsBaseEta, maxMatchingDistance, useGrid, matchIndexTag,
+             [&score](std::size_t iBase, std::size_t iTag, T distance) { return score(iBase, iTag, distance); });
+    // Find the best base jet for each tag jet
+    findBest(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, maxMatchingDistance, useGrid, matchIndexBase,
+             [&score](std::size_t iTag, std::size_t iBase, T distance) { return score(iBase, iTag, distance); });
+
+    // True matches are pairs where each jet is the best candidate of the other
+    for (std::size_t iBase = 0; iBase < nJetsBase; iBase++) {
+      const int iTag = matchIndexTag[iBase];
+      if (iTag > -1 && matchIndexBase[iTag] == static_cast<int>(iBase)) {
+        baseToTagMap[iBase] = iTag;
+        tagToBaseMap[iTag] = iBase;
+      }
+    }
+  }
+
+ private:
+  static T deltaPhi(T phi1, T phi2)
+  {
+    T dPhi = std::abs(phi1 - phi2);
+    return dPhi > M_PI ? 2 * M_PI - dPhi : dPhi;
+  }
+
+  /**
+   * For each query jet, finds the index of the candidate jet with the lowest score within the matching distance, -1 if none.
+   */
+  template <typename Score>
+  void findBest(const std::vector<T>& candPhi, const std::vector<T>& candEta,
+                const std::vector<T>& queryPhi, const std::vector<T>& queryEta,
+                double maxMatchingDistance, bool useGrid, std::vector<int>& best, Score&& score)
+  {
+    const std::size_t nQuery = queryEta.size();
+    best.assign(nQuery, -1);
+    if (useGrid) {
+      buildGrid(candPhi, candEta, maxMatchingDistance);
+    } else {
+      buildTree(candPhi, candEta, maxMatchingDistance);
+    }
+    for (std::size_t iQuery = 0; iQuery < nQuery; iQuery++) {
+      double bestScore = std::numeric_limits<double>::max();
+      auto consider = [&](std::size_t iCand) {
+        const T dEta = queryEta[iQuery] - candEta[iCand];
+        const T dPhi = deltaPhi(queryPhi[iQuery], candPhi[iCand]);
+        const T distance = std::sqrt(dEta * dEta + dPhi * dPhi);
+        if (distance < maxMatchingDistance) {
+          const double candScore = score(iQuery, iCand, distance);
+          if (candScore < bestScore) {
+            bestScore = candScore;
+            best[iQuery] = iCand;
+          }
+        }
+      };
+      if (useGrid) {
+        forEachInGrid(queryPhi[iQuery], queryEta[iQuery], maxMatchingDistance, consider);
+      } else {
+        T point[2] = {queryEta[iQuery], queryPhi[iQuery]};
+        treeResult.clear();
+        tree->FindInRange(point, maxMatchingDistance, treeResult);
+        for (auto index : treeResult) {
+          consider(treeMapToJetIndex[index]);
+        }
+      }
+    }
+  }
+
+  /**
+   * Sorts the jets into cells at least as large as the matching distance.
+   */
+  void buildGrid(const std::vector<T>& phi, const std::vector<T>& eta, double cellSize)
+  {
+    const std::size_t nJets = eta.size();
+    const auto [etaLow, etaHigh] = std::minmax_element(eta.begin(), eta.end());
+    gridEtaMin = *etaLow;
+    gridEtaCell = cellSize;
+    gridNEta = static_cast<int>((*etaHigh - gridEtaMin) / gridEtaCell) + 1;
+    gridNPhi = std::max(1, static_cast<int>(2 * M_PI / cellSize));
+    gridPhiCell = 2 * M_PI / gridNPhi;
+    // counting sort of the jets by cell
+    cellStart.assign(gridNEta * gridNPhi + 1, 0);
+    cellOfJet.resize(nJets);
+    for (std::size_t i = 0; i < nJets; i++) {
+      const int iEta = std::min(static_cast<int>((eta[i] - gridEtaMin) / gridEtaCell), gridNEta - 1);
+      const int iPhi = std::clamp(static_cast<int>(phi[i] / gridPhiCell), 0, gridNPhi - 1);
+      cellOfJet[i] = iEta * gridNPhi + iPhi;
+      cellStart[cellOfJet[i] + 1]++;
+    }
+    std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+    cellJets.resize(nJets);
+    cellFill.assign(cellStart.begin(), cellStart.end() - 1);
+    for (std::size_t i = 0; i < nJets; i++) {
+      cellJets[cellFill[cellOfJet[i]]++] = i;
+    }
+  }
+
+  template <typename F>
+  void forEachInGrid(T phi, T eta, double maxMatchingDistance, F&& f) const
+  {
+    const int iEtaLow = std::max(static_cast<int>(std::floor((eta - maxMatchingDistance - gridEtaMin) / gridEtaCell)), 0);
+    const int iEtaHigh = std::min(static_cast<int>(std::floor((eta + maxMatchingDistance - gridEtaMin) / gridEtaCell)), gridNEta - 1);
+    int iPhiLow = static_cast<int>(std::floor((phi - maxMatchingDistance) / gridPhiCell));
+    int iPhiHigh = static_cast<int>(std::floor((phi + maxMatchingDistance) / gridPhiCell));
+    if (iPhiHigh - iPhiLow + 1 >= gridNPhi) {
+      iPhiLow = 0;
+      iPhiHigh = gridNPhi - 1;
+    }
+    for (int iEta = iEtaLow; iEta <= iEtaHigh; iEta++) {
+      for (int iPhi = iPhiLow; iPhi <= iPhiHigh; iPhi++) {
+        const int cell = iEta * gridNPhi + (iPhi + gridNPhi) % gridNPhi;
+        for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+          f(cellJets[k]);
+        }
+      }
+    }
+  }
+
+  /**
+   * Builds the KD-tree of the jets, duplicated around the phi boundary.
+   */
+  void buildTree(const std::vector<T>& phi, const std::vector<T>& eta, double maxMatchingDistance)
+  {
+    const std::size_t nJets = eta.size();
+    treePhi.assign(phi.begin(), phi.end());
+    treeEta.assign(eta.begin(), eta.end());
+    treeMapToJetIndex.resize(nJets);
+    std::iota(treeMapToJetIndex.begin(), treeMapToJetIndex.end(), 0);
+    for (std::size_t i = 0; i < nJets; i++) {
+      if (phi[i] <= maxMatchingDistance) {
+        treePhi.emplace_back(phi[i] + 2 * M_PI);
+        treeEta.emplace_back(eta[i]);
+        treeMapToJetIndex.emplace_back(i);
+      }
+      if (phi[i] >= 2 * M_PI - maxMatchingDistance) {
+        treePhi.emplace_back(phi[i] - 2 * M_PI);
+        treeEta.emplace_back(eta[i]);
+        treeMapToJetIndex.emplace_back(i);
+      }
+    }
+    // TKDTree cannot be resized, only the coordinate buffers are kept
+    tree = std::make_unique<TKDTree<int, T>>(treeEta.size(), 2, 1);
+    tree->SetData(0, treeEta.data());
+    tree->SetData(1, treePhi.data());
+    tree->Build();
+  }
+
+  std::size_t gridMaxJets = 100;
+  /* best candidates */
+  std::vector<int> matchIndexTag, matchIndexBase;
+  /* grid */
+  T gridEtaMin = 0, gridEtaCell = 1, gridPhiCell = 1;
+  int gridNEta = 0, gridNPhi = 0;
+  std::vector<int> cellStart, cellFill, cellOfJet, cellJets;
+  /* KD-tree */
+  std::vector<T> treePhi, treeEta;
+  std::vector<std::size_t> treeMapToJetIndex;
+  std::vector<int> treeResult;
+  std::unique_ptr<TKDTree<int, T>> tree;
+};
+
 /**
  * Geometrical jet matching.
  *
@@ -242,38 +514,16 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
  */
 template <typename T>
 std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometrically(
-  std::vector<T> jetsBasePhi,
-  std::vector<T> jetsBaseEta,
-  std::vector<T> jetsTagPhi,
-  std::vector<T> jetsTagEta,
+  const std::vector<T>& jetsBasePhi,
+  const std::vector<T>& jetsBaseEta,
+  const std::vector<T>& jetsTagPhi,
+  const std::vector<T>& jetsTagEta,
   double maxMatchingDistance)
 {
-  // Validation
-  const std::size_t nJetsBase = jetsBaseEta.size();
-  const std::size_t nJetsTag = jetsTagEta.size();
-  if (!(nJetsBase && nJetsTag)) {
-    // There are no jets, so nothing to be done.
-    return std::make_tuple(std::vector<int>(nJetsBase), std::vector<int>(nJetsTag));
-  }
-  // Input sizes must match
-  if (jetsBasePhi.size() != jetsBaseEta.size()) {
-    throw std::invalid_argument("Base collection eta and phi sizes don't match. Check the inputs.");
-  }
-  if (jetsTagPhi.size() != jetsTagEta.size()) {
-    throw std::invalid_argument("Tag collection eta and phi sizes don't match. Check the inputs.");
-  }
-
-  // To perform matching with periodic boundary conditions (ie. phi) with a KDTree, we need
-  // to duplicate data up to maxMatchingDistance in phi because phi is periodic.
-  // NOTE: vectors are modified in place to avoid copies.
-  auto&& [jetMapBaseToJetIndex, jetsBasePhiComparison, jetsBaseEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsBasePhi, jetsBaseEta, maxMatchingDistance);
-  auto&& [jetMapTagToJetIndex, jetsTagPhiComparison, jetsTagEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsTagPhi, jetsTagEta, maxMatchingDistance);
-
-  // Finally, perform the actual matching.
-  auto&& [baseToTagMap, tagToBaseMap] = MatchJetsGeometricallyImpl(
-    jetsBasePhi, jetsBaseEta, jetsBasePhiComparison, jetsBaseEtaComparison, jetMapBaseToJetIndex,
-    jetsTagPhi, jetsTagEta, jetsTagPhiComparison, jetsTagEtaComparison, jetMapTagToJetIndex,
-    maxMatchingDistance);
+  // NOTE: Tasks matching for every event should keep their own GeometricalJetMatcher to reuse its buffers.
+  GeometricalJetMatcher<T> matcher;
+  std::vector<int> baseToTagMap, tagToBaseMap;
+  matcher.match(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, maxMatchingDistance, baseToTagMap, tagToBaseMap);
 
   return std::make_tuple(baseToTagMap, tagToBaseMap);
 }
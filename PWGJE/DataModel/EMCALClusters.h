@@ -111,5 +111,16 @@ DECLARE_SOA_INDEX_COLUMN(Track, track); //! linked to Track table only for track
 DECLARE_SOA_TABLE(EMCALMatchedTracks, "AOD", "EMCMATCHTRACKS",                                     //!
                   o2::soa::Index<>, emcalclustercell::EMCALClusterId, emcalmatchedtrack::TrackId); //!
 using EMCALMatchedTrack = EMCALMatchedTracks::iterator;
+namespace emcalclustertrack
+{
+DECLARE_SOA_INDEX_COLUMN(Track, track);                  //! closest track matched to the cluster, -1 if none
+DECLARE_SOA_COLUMN(DeltaEta, deltaEta, float);           //! eta difference between the cluster and its closest matched track
+DECLARE_SOA_COLUMN(DeltaPhi, deltaPhi, float);           //! phi difference between the cluster and its closest matched track at the EMCAL surface
+DECLARE_SOA_COLUMN(NMatchedTracks, nMatchedTracks, int); //! number of tracks matched to the cluster
+} // namespace emcalclustertrack
+// closest matched track of each cluster, joinable with EMCALClusters
+DECLARE_SOA_TABLE(EMCALClusterTrackMatches, "AOD", "EMCCLUSTRKMATCH", //!
+                  emcalclustertrack::TrackId, emcalclustertrack::DeltaEta, emcalclustertrack::DeltaPhi, emcalclustertrack::NMatchedTracks);
+using EMCALClusterTrackMatch = EMCALClusterTrackMatches::iterator;
 } // namespace o2::aod
 #endif
@@ -59,13 +59,31 @@ struct EmcalCorrectionTask {
   // Clusterizer and related
   // Apparently streaming these objects really doesn't work, and causes problems for setting up the workflow.
   // So we use unique_ptr and define them below.
+  // Cluster definitions differing only in their name, algorithm or storage ID share their clusterizer.
   std::vector<std::unique_ptr<o2::emcal::Clusterizer<o2::emcal::Cell>>> mClusterizers;
   std::vector<std::unique_ptr<o2::emcal::ClusterFactory<o2::emcal::Cell>>> mClusterFactories;
+  // index of the clusterizer of each cluster definition
+  std::vector<int> mClusterizerOfDefinition;
   // Cells and clusters
   std::vector<o2::emcal::Cell> mEmcalCells;
   // map of cellId (local in BC) to global cell index in cell table in AO2D
-  std::map<int, int64_t> mCellIdToCellGlobalIndex;
-  std::vector<o2::emcal::AnalysisCluster> mAnalysisClusters;
+  std::vector<int64_t> mCellIdToCellGlobalIndex;
+  // analysis clusters of each clusterizer, and whether they were built for the current BC
+  std::vector<std::vector<o2::emcal::AnalysisCluster>> mAnalysisClusters;
+  std::vector<bool> mClustersBuilt;
+  // eta, phi, row and column of the towers, computed once from the geometry
+  struct TowerGeometry {
+    bool cached = false;
+    double eta = 0.;
+    double phi = 0.;
+    int row = 0;
+    int col = 0;
+  };
+  std::vector<TowerGeometry> mTowerGeometry;
+  // tracks of the collision of the BC
+  std::vector<double> mTrackPhi;
+  std::vector<double> mTrackEta;
+  std::vector<int64_t> mTrackGlobalIndex;
 
   std::vector<o2::aod::EMCALClusterDefinition> mClusterDefinitions;
   // QA
@@ -108,9 +126,25 @@ struct EmcalCorrectionTask {
         mClusterDefinitions.push_back(clusDef);
       }
     }
-    for (auto& clusterDefinition : mClusterDefinitions) {
-      mClusterizers.emplace_back(std::make_unique<o2::emcal::Clusterizer<o2::emcal::Cell>>(1E9, clusterDefinition.timeMin, clusterDefinition.timeMax, clusterDefinition.gradientCut, clusterDefinition.doGradientCut, clusterDefinition.seedEnergy, clusterDefinition.minCellEnergy));
-      mClusterFactories.emplace_back(std::make_unique<o2::emcal::ClusterFactory<o2::emcal::Cell>>());
+    for (std::size_t iDef = 0; iDef < mClusterDefinitions.size(); iDef++) {
+      const auto& clusterDefinition = mClusterDefinitions[iDef];
+      // the clusterizer only depends on the thresholds and the cuts of the definition
+      int sharedDef = -1;
+      for (std::size_t iPrev = 0; iPrev < iDef && sharedDef < 0; iPrev++) {
+        const auto& prev = mClusterDefinitions[iPrev];
+        if (prev.timeMin == clusterDefinition.timeMin && prev.timeMax == clusterDefinition.timeMax && prev.gradientCut == clusterDefinition.gradientCut &&
+            prev.doGradientCut == clusterDefinition.doGradientCut && prev.seedEnergy == clusterDefinition.seedEnergy && prev.minCellEnergy == clusterDefinition.minCellEnergy) {
+          sharedDef = iPrev;
+        }
+      }
+      if (sharedDef < 0) {
+        mClusterizerOfDefinition.push_back(mClusterizers.size());
+        mClusterizers.emplace_back(std::make_unique<o2::emcal::Clusterizer<o2::emcal::Cell>>(1E9, clusterDefinition.timeMin, clusterDefinition.timeMax, clusterDefinition.gradientCut, clusterDefinition.doGradientCut, clusterDefinition.seedEnergy, clusterDefinition.minCellEnergy));
+        mClusterFactories.emplace_back(std::make_unique<o2::emcal::ClusterFactory<o2::emcal::Cell>>());
+      } else {
+        mClusterizerOfDefinition.push_back(mClusterizerOfDefinition[sharedDef]);
+        LOG(info) << "Cluster definition " << clusterDefinition.toString() << " shares the clusterizer of " << mClusterDefinitions[sharedDef].toString();
+      }
       LOG(info) << "Cluster definition initialized: " << clusterDefinition.toString();
       LOG(info) << "timeMin: " << clusterDefinition.timeMin;
       LOG(info) << "timeMax: " << clusterDefinition.timeMax;
@@ -122,6 +156,11 @@ struct EmcalCorrectionTask {
     for (auto& clusterizer : mClusterizers) {
       clusterizer->setGeometry(geometry);
     }
+    mAnalysisClusters.resize(mClusterizers.size());
+    mClustersBuilt.resize(mClusterizers.size());
+    if (geometry) {
+      mTowerGeometry.resize(geometry->GetNCells());
+    }
 
     if (mClusterizers.size() == 0) {
       LOG(error) << "No cluster definitions specified!";
@@ -164,7 +203,7 @@ struct EmcalCorrectionTask {
         cell.amplitude(),
         cell.time(),
         o2::emcal::intToChannelType(cell.cellType())));
-      mCellIdToCellGlobalIndex.insert(std::make_pair(c, cell.globalIndex()));
+      mCellIdToCellGlobalIndex.push_back(cell.globalIndex());
       LOG(debug) << "Creating map " << c << " -> " << cell.globalIndex();
       c++;
     }
@@ -175,11 +214,28 @@ struct EmcalCorrectionTask {
     for (auto& cell : mEmcalCells) {
       hCellE->Fill(cell.getEnergy());
       hCellTowerID->Fill(cell.getTower());
-      auto res = mClusterizers.at(0)->getGeometry()->EtaPhiFromIndex(cell.getTower());
-      hCellEtaPhi->Fill(std::get<0>(res), TVector2::Phi_0_2pi(std::get<1>(res)));
-      res = mClusterizers.at(0)->getGeometry()->GlobalRowColFromIndex(cell.getTower());
+      const auto& towerGeometry = getTowerGeometry(cell.getTower());
+      hCellEtaPhi->Fill(towerGeometry.eta, towerGeometry.phi);
       // NOTE: Reversed column and row because it's more natural for presentatin.
-      hCellRowCol->Fill(std::get<1>(res), std::get<0>(res));
+      hCellRowCol->Fill(towerGeometry.col, towerGeometry.row);
+    }
+
+    // The tracks of the collision are the same for all the clusterizers
+    mTrackPhi.clear();
+    mTrackEta.clear();
+    mTrackGlobalIndex.clear();
+    if (collisions.size() == 1) {
+      for (const auto& col : collisions) {
+        auto groupedTracks = tracks.sliceBy(perCollision, col.globalIndex());
+        for (auto& track : groupedTracks) {
+          // TODO this actually needs to use the eta phi
+          // of track propagated to EMC surface! Will be provided centrally according to Ruben
+          // TODO only consider tracks in current emcal/dcal acceptanc
+          mTrackPhi.emplace_back(TVector2::Phi_0_2pi(track.phi()));
+          mTrackEta.emplace_back(track.eta());
+          mTrackGlobalIndex.emplace_back(track.globalIndex());
+        }
+      }
     }
 
     // TODO: Helpful for now, but should be removed.
@@ -192,30 +248,38 @@ struct EmcalCorrectionTask {
     // this is a test
     // Run the clusterizers
     LOG(debug) << "Running clusterizers";
-    Int_t i = 0;
-    for (auto& clusterizer : mClusterizers) {
-      clusterizer->findClusters(mEmcalCells);
-
-      auto emcalClusters = clusterizer->getFoundClusters();
-      auto emcalClustersInputIndices = clusterizer->getFoundClustersInputIndices();
-      LOG(debug) << "Retrieved results. About to setup cluster factory.";
-
-      // Convert to analysis clusters.
-      // First, the cluster factory requires cluster and cell information in order to build the clusters.
-      mAnalysisClusters.clear();
-      mClusterFactories.at(i)->reset();
-      mClusterFactories.at(i)->setClustersContainer(*emcalClusters);
-      mClusterFactories.at(i)->setCellsContainer(mEmcalCells);
-      mClusterFactories.at(i)->setCellsIndicesContainer(*emcalClustersInputIndices);
-
-      LOG(debug) << "Cluster factory set up.";
-      // Convert to analysis clusters.
-      for (int icl = 0; icl < mClusterFactories.at(i)->getNumberOfClusters(); icl++) {
-        auto analysisCluster = mClusterFactories.at(i)->buildCluster(icl);
-        mAnalysisClusters.emplace_back(analysisCluster);
-        LOG(debug) << "Cluster " << icl << ": E: " << analysisCluster.E() << ", NCells " << analysisCluster.getNCells();
+    std::fill(mClustersBuilt.begin(), mClustersBuilt.end(), false);
+    for (std::size_t i = 0; i < mClusterDefinitions.size(); i++) {
+      const int iClusterizer = mClusterizerOfDefinition[i];
+      auto& analysisClusters = mAnalysisClusters[iClusterizer];
+      // Definitions sharing a clusterizer reuse its clusters
+      if (!mClustersBuilt[iClusterizer]) {
+        auto& clusterizer = mClusterizers[iClusterizer];
+        auto& clusterFactory = mClusterFactories[iClusterizer];
+        clusterizer->findClusters(mEmcalCells);
+
+        auto emcalClusters = clusterizer->getFoundClusters();
+        auto emcalClustersInputIndices = clusterizer->getFoundClustersInputIndices();
+        LOG(debug) << "Retrieved results. About to setup cluster factory.";
+
+        // Convert to analysis clusters.
+        // First, the cluster factory requires cluster and cell information in order to build the clusters.
+        analysisClusters.clear();
+        clusterFactory->reset();
+        clusterFactory->setClustersContainer(*emcalClusters);
+        clusterFactory->setCellsContainer(mEmcalCells);
+        clusterFactory->setCellsIndicesContainer(*emcalClustersInputIndices);
+
+        LOG(debug) << "Cluster factory set up.";
+        // Convert to analysis clusters.
+        for (int icl = 0; icl < clusterFactory->getNumberOfClusters(); icl++) {
+          auto analysisCluster = clusterFactory->buildCluster(icl);
+          analysisClusters.emplace_back(analysisCluster);
+          LOG(debug) << "Cluster " << icl << ": E: " << analysisCluster.E() << ", NCells " << analysisCluster.getNCells();
+        }
+        mClustersBuilt[iClusterizer] = true;
+        LOG(debug) << "Converted to analysis clusters.";
       }
-      LOG(debug) << "Converted to analysis clusters.";
 
       float vx = 0, vy = 0, vz = 0;
       bool hasCollision = false;
@@ -229,26 +293,11 @@ struct EmcalCorrectionTask {
           vz = col.posZ();
           hasCollision = true;
 
-          // store positions of all tracks of collision
-          auto groupedTracks = tracks.sliceBy(perCollision, col.globalIndex());
-
-          std::vector<double> trackPhi;
-          std::vector<double> trackEta;
-          std::vector<int64_t> trackGlobalIndex;
-          for (auto& track : groupedTracks) {
-            // TODO this actually needs to use the eta phi
-            // of track propagated to EMC surface! Will be provided centrally according to Ruben
-            // TODO only consider tracks in current emcal/dcal acceptanc
-            trackPhi.emplace_back(TVector2::Phi_0_2pi(track.phi()));
-            trackEta.emplace_back(track.eta());
-            trackGlobalIndex.emplace_back(track.globalIndex());
-          }
-
           std::vector<double> clusterPhi;
           std::vector<double> clusterEta;
 
           // TODO one loop that could in principle be combined with the other loop to improve performance
-          for (const auto& cluster : mAnalysisClusters) {
+          for (const auto& cluster : analysisClusters) {
             // Determine the cluster eta, phi, correcting for the vertex position.
             auto pos = cluster.getGlobalPosition();
             pos = pos - math_utils::Point3D<float>{vx, vy, vz};
@@ -257,13 +306,13 @@ struct EmcalCorrectionTask {
             clusterPhi.emplace_back(TVector2::Phi_0_2pi(pos.Phi()));
             clusterEta.emplace_back(pos.Eta());
           }
-          auto&& [clusterToTrackIndexMap, trackToClusterIndexMap] = JetUtilities::MatchClustersAndTracks(clusterPhi, clusterEta, trackPhi, trackEta, maxMatchingDistance, 5);
+          auto&& [clusterToTrackIndexMap, trackToClusterIndexMap] = JetUtilities::MatchClustersAndTracks(clusterPhi, clusterEta, mTrackPhi, mTrackEta, maxMatchingDistance, 5);
           // we found a collision, put the clusters into the none ambiguous table
-          clusters.reserve(mAnalysisClusters.size());
+          clusters.reserve(analysisClusters.size());
           int cellindex = -1;
 
           unsigned int k = 0;
-          for (const auto& cluster : mAnalysisClusters) {
+          for (const auto& cluster : analysisClusters) {
 
             // Determine the cluster eta, phi, correcting for the vertex position.
             auto pos = cluster.getGlobalPosition();
@@ -289,8 +338,8 @@ struct EmcalCorrectionTask {
             hClusterEtaPhi->Fill(pos.Eta(), TVector2::Phi_0_2pi(pos.Phi()));
             for (unsigned int iTrack = 0; iTrack < clusterToTrackIndexMap[k].size(); iTrack++) {
               if (clusterToTrackIndexMap[k][iTrack] >= 0) {
-                LOG(debug) << "Found track " << trackGlobalIndex[clusterToTrackIndexMap[k][iTrack]] << " in cluster " << cluster.getID();
-                matchedTracks(clusters.lastIndex(), trackGlobalIndex[clusterToTrackIndexMap[k][iTrack]]);
+                LOG(debug) << "Found track " << mTrackGlobalIndex[clusterToTrackIndexMap[k][iTrack]] << " in cluster " << cluster.getID();
+                matchedTracks(clusters.lastIndex(), mTrackGlobalIndex[clusterToTrackIndexMap[k][iTrack]]);
               }
             }
             k++;
@@ -305,8 +354,8 @@ struct EmcalCorrectionTask {
       // be identified.
       if (!hasCollision) { // ambiguous
         int cellindex = -1;
-        clustersAmbiguous.reserve(mAnalysisClusters.size());
-        for (const auto& cluster : mAnalysisClusters) {
+        clustersAmbiguous.reserve(analysisClusters.size());
+        for (const auto& cluster : analysisClusters) {
           auto pos = cluster.getGlobalPosition();
           pos = pos - math_utils::Point3D<float>{vx, vy, vz};
           // Normalize the vector and rescale by energy.
@@ -325,11 +374,27 @@ struct EmcalCorrectionTask {
           }
         }
       }
-      LOG(debug) << "Cluster loop done for clusterizer " << i;
-      i++;
-    } // end of clusterizer loop
+      LOG(debug) << "Cluster loop done for cluster definition " << i;
+    } // end of cluster definition loop
     LOG(debug) << "Done with process.";
   }
+
+  /// Eta, phi, row and column of a tower, computed from the geometry on the first call
+  const TowerGeometry& getTowerGeometry(int tower)
+  {
+    auto& towerGeometry = mTowerGeometry[tower];
+    if (!towerGeometry.cached) {
+      // For convenience, use the clusterizer stored geometry to get the eta-phi
+      auto res = mClusterizers.at(0)->getGeometry()->EtaPhiFromIndex(tower);
+      towerGeometry.eta = std::get<0>(res);
+      towerGeometry.phi = TVector2::Phi_0_2pi(std::get<1>(res));
+      auto rowCol = mClusterizers.at(0)->getGeometry()->GlobalRowColFromIndex(tower);
+      towerGeometry.row = std::get<0>(rowCol);
+      towerGeometry.col = std::get<1>(rowCol);
+      towerGeometry.cached = true;
+    }
+    return towerGeometry;
+  }
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -0,0 +1,152 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// EMCAL track matcher
+//
+// Matches the EMCAL clusters with the tracks of their collision. The tracks are extrapolated once
+// to the EMCAL surface, with a helix in the nominal field, and sorted into an (eta, phi) grid,
+// so each cluster only looks at the tracks of the neighbouring cells.
+// The closest matched track of each cluster is stored in a table joinable with EMCALClusters.
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/ASoA.h"
+
+#include "PWGJE/DataModel/EMCALClusters.h"
+#include "TVector2.h"
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::framework::expressions;
+
+struct EmcalTrackMatcher {
+  Produces<o2::aod::EMCALClusterTrackMatches> clusterTrackMatches;
+
+  Preslice<aod::Tracks> perCollision = aod::track::collisionId;
+
+  Configurable<float> maxDeltaEta{"maxDeltaEta", 0.015f, "Max eta difference between cluster and track"};
+  Configurable<float> maxDeltaPhi{"maxDeltaPhi", 0.03f, "Max phi difference between cluster and track at the EMCAL surface"};
+  Configurable<float> minTrackPt{"minTrackPt", 0.15f, "Min pt of the matched tracks"};
+  Configurable<float> maxTrackEta{"maxTrackEta", 0.9f, "Max |eta| of the matched tracks"};
+  Configurable<double> d_bz{"d_bz", 5.0, "bz field (kG) for the extrapolation of the tracks"};
+  Configurable<double> emcalRadius{"emcalRadius", 440., "Radius of the EMCAL surface (cm)"};
+
+  // grid of the extrapolated tracks of the current collision
+  float mCellSize = 0.05f;
+  int mNEta = 0;
+  int mNPhi = 0;
+  std::vector<int> mCellStart;
+  std::vector<int> mCellFill;
+  std::vector<int> mCellOfTrack;
+  std::vector<int> mCellTracks;
+  std::vector<float> mTrackEta;
+  std::vector<float> mTrackPhi;
+  std::vector<int64_t> mTrackGlobalIndex;
+
+  void init(InitContext const&)
+  {
+    // the cells are not smaller than the matching window, such that only the neighbouring cells are searched
+    mCellSize = std::max({mCellSize, static_cast<float>(maxDeltaEta), static_cast<float>(maxDeltaPhi)});
+    mNEta = static_cast<int>(std::ceil(2 * maxTrackEta / mCellSize));
+    mNPhi = std::max(3, static_cast<int>(2 * M_PI / mCellSize));
+  }
+
+  int etaCell(float eta) const { return std::clamp(static_cast<int>((eta + maxTrackEta) / mCellSize), 0, mNEta - 1); }
+  int phiCell(float phi) const { return std::clamp(static_cast<int>(phi / (2 * M_PI) * mNPhi), 0, mNPhi - 1); }
+
+  /// Extrapolates the tracks of a collision to the EMCAL surface and sorts them into the grid
+  template <typename TTracks>
+  void buildGrid(TTracks const& tracks)
+  {
+    mTrackEta.clear();
+    mTrackPhi.clear();
+    mTrackGlobalIndex.clear();
+    mCellOfTrack.clear();
+    // 0.3 * B * R / (2 pt), with B in T and R in m
+    const double curvature = 0.15 * d_bz * 0.1 * emcalRadius * 0.01;
+    for (const auto& track : tracks) {
+      if (track.pt() < minTrackPt || std::abs(track.eta()) > maxTrackEta) {
+        continue;
+      }
+      const double sinDeltaPhi = curvature * track.sign() / track.pt();
+      if (std::abs(sinDeltaPhi) >= 1.) {
+        // the track curls before reaching the EMCAL
+        continue;
+      }
+      mTrackEta.push_back(track.eta());
+      mTrackPhi.push_back(TVector2::Phi_0_2pi(track.phi() - std::asin(sinDeltaPhi)));
+      mTrackGlobalIndex.push_back(track.globalIndex());
+      mCellOfTrack.push_back(etaCell(mTrackEta.back()) * mNPhi + phiCell(mTrackPhi.back()));
+    }
+    // counting sort of the tracks by cell
+    mCellStart.assign(mNEta * mNPhi + 1, 0);
+    for (auto cell : mCellOfTrack) {
+      mCellStart[cell + 1]++;
+    }
+    std::partial_sum(mCellStart.begin(), mCellStart.end(), mCellStart.begin());
+    mCellFill.assign(mCellStart.begin(), mCellStart.end() - 1);
+    mCellTracks.resize(mCellOfTrack.size());
+    for (std::size_t i = 0; i < mCellOfTrack.size(); i++) {
+      mCellTracks[mCellFill[mCellOfTrack[i]]++] = i;
+    }
+  }
+
+  void process(aod::EMCALClusters const& clusters, aod::Tracks const& tracks)
+  {
+    int64_t currentCollision = -2;
+    for (const auto& cluster : clusters) {
+      if (cluster.collisionId() != currentCollision) {
+        currentCollision = cluster.collisionId();
+        buildGrid(tracks.sliceBy(perCollision, currentCollision));
+      }
+      int64_t closest = -1;
+      float closestDeltaEta = 0.f, closestDeltaPhi = 0.f;
+      float closestDistance2 = 0.f;
+      int nMatched = 0;
+      const int iEtaCluster = etaCell(cluster.eta());
+      const int iPhiCluster = phiCell(TVector2::Phi_0_2pi(cluster.phi()));
+      for (int iEta = std::max(iEtaCluster - 1, 0); iEta <= std::min(iEtaCluster + 1, mNEta - 1); iEta++) {
+        for (int dPhiCell = -1; dPhiCell <= 1; dPhiCell++) {
+          const int cell = iEta * mNPhi + (iPhiCluster + dPhiCell + mNPhi) % mNPhi;
+          for (int k = mCellStart[cell]; k < mCellStart[cell + 1]; k++) {
+            const int iTrack = mCellTracks[k];
+            const float deltaEta = mTrackEta[iTrack] - cluster.eta();
+            const float deltaPhi = TVector2::Phi_mpi_pi(mTrackPhi[iTrack] - cluster.phi());
+            if (std::abs(deltaEta) > maxDeltaEta || std::abs(deltaPhi) > maxDeltaPhi) {
+              continue;
+            }
+            nMatched++;
+            const float distance2 = deltaEta * deltaEta + deltaPhi * deltaPhi;
+            if (closest < 0 || distance2 < closestDistance2) {
+              closest = mTrackGlobalIndex[iTrack];
+              closestDeltaEta = deltaEta;
+              closestDeltaPhi = deltaPhi;
+              closestDistance2 = distance2;
+            }
+          }
+        }
+      }
+      clusterTrackMatches(closest, closestDeltaEta, closestDeltaPhi, nMatched);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<EmcalTrackMatcher>(cfgc, TaskName{"emcal-track-matcher"})};
+}
@@ -74,6 +74,8 @@ struct JetFinderTask {
   Configurable<bool> DoConstSub{"DoConstSub", false, "do constituent subtraction"};
   Configurable<float> jetPtMin{"jetPtMin", 10.0, "minimum jet pT"};
   Configurable<std::vector<double>> jetR{"jetR", {0.4}, "jet resolution parameters"};
+  Configurable<bool> multiRadius{"multiRadius", false, "find the jets of all the radii with the same ghosts and background estimate"};
+  Configurable<int> multiRadiusThreads{"multiRadiusThreads", 1, "number of threads clustering the radii in the multi-radius mode"};
   // FIXME: This should be named jetType. However, as of Aug 2021, it doesn't appear possible
   //        to set both global and task level options. This should be resolved when workflow
   //        level customization is available
@@ -84,6 +86,8 @@ struct JetFinderTask {
 
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
+  std::vector<std::vector<fastjet::PseudoJet>> jetsPerR;
+  std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>> clusterSeqsPerR;
   JetFinder jetFinder; //should be a configurable but for now this cant be changed on hyperloop
   // FIXME: Once configurables support enum, ideally we can
   JetType_t _jetType;
@@ -126,40 +130,57 @@ struct JetFinderTask {
     return true;
   }
 
+  template <typename T>
+  void fillJet(T const& collision, const fastjet::PseudoJet& jet, double R, const std::vector<fastjet::PseudoJet>& constituents)
+  {
+    jetsTable(collision, jet.pt(), jet.eta(), jet.phi(),
+              jet.E(), jet.m(), jet.area(), std::round(R * 100));
+    hJetPt->Fill(jet.pt(), R);
+    hJetPhi->Fill(jet.phi(), R);
+    hJetEta->Fill(jet.eta(), R);
+    hJetN->Fill(constituents.size(), R);
+    for (const auto& constituent : constituents) { //event or jetwise
+      if (DoConstSub) {
+        // Since we're copying the consituents, we can combine the tracks and clusters together
+        // We only have to keep the uncopied versions separated due to technical constraints.
+        constituentsSubTable(jetsTable.lastIndex(), constituent.pt(), constituent.eta(), constituent.phi(),
+                             constituent.E(), constituent.m(), constituent.user_index());
+      }
+      if (constituent.user_index() < 0) {
+        // Cluster
+        // -1 to account for the convention of negative indices for clusters.
+        clusterConstituentsTable(jetsTable.lastIndex(), -1 * constituent.user_index());
+      } else {
+        // Tracks
+        trackConstituentsTable(jetsTable.lastIndex(), constituent.user_index());
+      }
+    }
+  }
+
   template <typename T>
   void processImplementation(T const& collision)
   {
     LOG(debug) << "Process Implementation";
     // NOTE: Can't just iterate directly - we have to cast first
     auto jetRValues = static_cast<std::vector<double>>(jetR);
+    if (multiRadius) {
+      jetFinder.findJets(inputParticles, jetRValues, jetsPerR, clusterSeqsPerR, multiRadiusThreads);
+      // the ghosts are part of the constituents with explicit ghosts
+      const auto notGhost = !fastjet::SelectorIsPureGhost();
+      for (size_t iR = 0; iR < jetRValues.size(); iR++) {
+        for (const auto& jet : jetsPerR[iR]) {
+          fillJet(collision, jet, jetRValues[iR], notGhost(jet.constituents()));
+        }
+      }
+      return;
+    }
     for (auto R : jetRValues) {
       // Update jet finder R and find jets
       jetFinder.jetR = R;
       fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
 
       for (const auto& jet : jets) {
-        jetsTable(collision, jet.pt(), jet.eta(), jet.phi(),
-                  jet.E(), jet.m(), jet.area(), std::round(R * 100));
-        hJetPt->Fill(jet.pt(), R);
-        hJetPhi->Fill(jet.phi(), R);
-        hJetEta->Fill(jet.eta(), R);
-        hJetN->Fill(jet.constituents().size(), R);
-        for (const auto& constituent : jet.constituents()) { //event or jetwise
-          if (DoConstSub) {
-            // Since we're copying the consituents, we can combine the tracks and clusters together
-            // We only have to keep the uncopied versions separated due to technical constraints.
-            constituentsSubTable(jetsTable.lastIndex(), constituent.pt(), constituent.eta(), constituent.phi(),
-                                 constituent.E(), constituent.m(), constituent.user_index());
-          }
-          if (constituent.user_index() < 0) {
-            // Cluster
-            // -1 to account for the convention of negative indices for clusters.
-            clusterConstituentsTable(jetsTable.lastIndex(), -1 * constituent.user_index());
-          } else {
-            // Tracks
-            trackConstituentsTable(jetsTable.lastIndex(), constituent.user_index());
-          }
-        }
+        fillJet(collision, jet, R, jet.constituents());
       }
     }
   }
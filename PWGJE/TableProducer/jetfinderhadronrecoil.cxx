@@ -17,6 +17,10 @@
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoA.h"
+#include "Framework/HistogramRegistry.h"
+
+#include <random>
+#include <vector>
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
@@ -36,12 +40,24 @@ struct JetFinderHadronRecoilTask {
   Configurable<float> f_trackTTMin{"f_trackTTMin", 8.0, "TT hadron min pT"};
   Configurable<float> f_trackTTMax{"f_trackTTMax", 9.0, "TT hadron max pT"};
   Configurable<float> f_recoilWindow{"f_recoilWindow", 0.6, "jet finding phi window reecoilling from hadron"};
+  Configurable<float> f_trackTTRefMin{"f_trackTTRefMin", -1.0, "reference TT hadron min pT, reference class disabled if negative"};
+  Configurable<float> f_trackTTRefMax{"f_trackTTRefMax", -1.0, "reference TT hadron max pT"};
+  Configurable<int> f_trackTTChoice{"f_trackTTChoice", 0, "TT hadrons of an event: 0 highest pT, 1 one at random, 2 all of them"};
+  Configurable<int> f_randomSeed{"f_randomSeed", 0, "seed of the random choice of the TT hadron"};
+
+  // the jets of an event are clustered once, and the recoil jets of each trigger of each class are selected in phi
+  HistogramRegistry registry{"registry"};
+  enum TriggerClass { kSignal = 0,
+                      kReference,
+                      kNTriggerClasses };
+  std::vector<float> trackTTPhiCandidates[kNTriggerClasses];
+  std::vector<float> trackTTPtCandidates[kNTriggerClasses];
+  std::mt19937 randomGenerator;
 
   Filter trackCuts = aod::track::pt >= 0.15f && aod::track::eta > -0.9f && aod::track::eta < 0.9f;
   int collisionSplit = 0; //can we partition the collisions?
   //can we also directly filter the collision based on the max track::pt?
 
-  std::vector<float> trackTTPt;
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
   JetFinder jetFinder;
@@ -76,6 +92,53 @@ struct JetFinderHadronRecoilTask {
                                  120, 0., 60.));
     hJetHadronDeltaPhi.setObject(new TH1F("h_jet_hadron_deltaphi", "jet #eta;#eta",
                                           40, 0.0, 4.));
+    if (f_trackTTRefMin >= 0) {
+      registry.add("h_jet_pt_ref", "jet p_{T}, reference TT;jet p_{T} (GeV/#it{c})", {HistType::kTH1F, {{100, 0., 100.}}});
+      registry.add("h_hadron_pt_ref", "hadron p_{T}, reference TT;hadron p_{T} (GeV/#it{c})", {HistType::kTH1F, {{120, 0., 60.}}});
+      registry.add("h_jet_hadron_deltaphi_ref", "jet #eta, reference TT;#eta", {HistType::kTH1F, {{40, 0.0, 4.}}});
+    }
+    randomGenerator.seed(f_randomSeed);
+  }
+
+  // Keeps the triggers of the class given by f_trackTTChoice: one of highest pT or at random, or all of them
+  void chooseTriggers(int triggerClass)
+  {
+    auto& phis = trackTTPhiCandidates[triggerClass];
+    auto& pts = trackTTPtCandidates[triggerClass];
+    if (f_trackTTChoice == 2 || pts.size() < 2) {
+      return;
+    }
+    size_t chosen = 0;
+    if (f_trackTTChoice == 1) {
+      chosen = std::uniform_int_distribution<size_t>(0, pts.size() - 1)(randomGenerator);
+    } else {
+      for (size_t i = 1; i < pts.size(); i++) {
+        if (pts[i] >= pts[chosen]) { // the last one of highest pT, as in the previous single-trigger selection
+          chosen = i;
+        }
+      }
+    }
+    phis = {phis[chosen]};
+    pts = {pts[chosen]};
+  }
+
+  template <typename THadronPt, typename TJetPt, typename TDeltaPhi>
+  void fillRecoil(int triggerClass, THadronPt fillHadronPt, TJetPt fillJetPt, TDeltaPhi fillDeltaPhi)
+  {
+    const auto& phis = trackTTPhiCandidates[triggerClass];
+    const auto& pts = trackTTPtCandidates[triggerClass];
+    for (size_t i = 0; i < pts.size(); i++) {
+      fillHadronPt(pts[i]);
+      for (const auto& jet : jets) {
+        auto deltaPhi = TMath::Abs(relativePhi(jet.phi(), static_cast<double>(phis[i])));
+        if (deltaPhi >= (M_PI - f_recoilWindow)) {
+          fillJetPt(jet.pt());
+        }
+        if (deltaPhi >= M_PI / 2.0 && deltaPhi <= M_PI) {
+          fillDeltaPhi(deltaPhi);
+        }
+      }
+    }
   }
 
   void process(aod::Collision const& collision,
@@ -84,39 +147,38 @@ struct JetFinderHadronRecoilTask {
 
     jets.clear();
     inputParticles.clear();
-    auto trackTTPhi = 0.0;
-    auto trackTTPt = 0.0;
-    auto comparisonPt = 0.0;
-    bool isTT = false;
+    for (int triggerClass = 0; triggerClass < kNTriggerClasses; triggerClass++) {
+      trackTTPhiCandidates[triggerClass].clear();
+      trackTTPtCandidates[triggerClass].clear();
+    }
+    const bool useReference = f_trackTTRefMin >= 0;
     for (auto& track : tracks) {
       if (track.pt() >= f_trackTTMin && track.pt() < f_trackTTMax) { //can this also go into a partition?
-        isTT = true;
-        if (track.pt() >= comparisonPt) { //currently take highest pT but later to randomise
-          comparisonPt = track.pt();
-          trackTTPt = track.pt();
-          trackTTPhi = track.phi();
-        }
+        trackTTPhiCandidates[kSignal].push_back(track.phi());
+        trackTTPtCandidates[kSignal].push_back(track.pt());
+      }
+      if (useReference && track.pt() >= f_trackTTRefMin && track.pt() < f_trackTTRefMax) {
+        trackTTPhiCandidates[kReference].push_back(track.phi());
+        trackTTPtCandidates[kReference].push_back(track.pt());
       }
       auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
       inputParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
       inputParticles.back().set_user_index(track.globalIndex());
     }
-    if (!isTT) {
+    if (trackTTPtCandidates[kSignal].empty() && trackTTPtCandidates[kReference].empty()) {
       return;
     }
-    hHadronPt->Fill(trackTTPt);
+    chooseTriggers(kSignal);
+    chooseTriggers(kReference);
 
     // you can set phi selector here for jets
     fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
 
-    for (const auto& jet : jets) {
-      auto deltaPhi = TMath::Abs(relativePhi(jet.phi(), trackTTPhi));
-      if (deltaPhi >= (M_PI - f_recoilWindow)) {
-        hJetPt->Fill(jet.pt());
-      }
-      if (deltaPhi >= M_PI / 2.0 && deltaPhi <= M_PI) {
-        hJetHadronDeltaPhi->Fill(deltaPhi);
-      }
+    fillRecoil(
+      kSignal, [&](float pt) { hHadronPt->Fill(pt); }, [&](double pt) { hJetPt->Fill(pt); }, [&](double deltaPhi) { hJetHadronDeltaPhi->Fill(deltaPhi); });
+    if (useReference) {
+      fillRecoil(
+        kReference, [&](float pt) { registry.fill(HIST("h_hadron_pt_ref"), pt); }, [&](double pt) { registry.fill(HIST("h_jet_pt_ref"), pt); }, [&](double deltaPhi) { registry.fill(HIST("h_jet_hadron_deltaphi_ref"), deltaPhi); });
     }
   }
 };
@@ -39,6 +39,10 @@ struct JetFinderHFTask {
 
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
+  std::vector<fastjet::PseudoJet> trackParticles; // tracks of the collision, built once for all its candidates
+  std::vector<std::vector<fastjet::PseudoJet>> inputParticlesPerCandidate;
+  std::vector<std::vector<fastjet::PseudoJet>> jetsPerCandidate;
+  std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>> clusterSeqsPerCandidate;
   JetFinder jetFinder;
 
   void init(InitContext const&)
@@ -51,6 +55,8 @@ struct JetFinderHFTask {
 
   Configurable<int> d_selectionFlagD0{"d_selectionFlagD0", 1, "Selection Flag for D0"};
   Configurable<int> d_selectionFlagD0bar{"d_selectionFlagD0bar", 1, "Selection Flag for D0bar"};
+  Configurable<bool> batchCandidates{"batchCandidates", false, "find the jets of all the candidates of a collision at once, with the same explicit ghosts"};
+  Configurable<int> batchCandidatesThreads{"batchCandidatesThreads", 1, "number of threads clustering the candidates in the batch mode"};
 
   //need enum as configurable
   enum pdgCode { pdgD0 = 421 };
@@ -58,51 +64,87 @@ struct JetFinderHFTask {
   Filter trackCuts = (aod::track::pt > 0.15f && aod::track::eta > -0.9f && aod::track::eta < 0.9f);
   Filter seltrack = (aod::hf_selcandidate_d0::isSelD0 >= d_selectionFlagD0 || aod::hf_selcandidate_d0::isSelD0bar >= d_selectionFlagD0bar);
 
+  /// Fills the output with the first jet containing the candidate
+  template <typename TCandidate, typename TConstituentSelection>
+  void fillHFJet(aod::Collision const& collision, TCandidate const& candidate, std::vector<fastjet::PseudoJet> const& candidateJets, TConstituentSelection const& selectConstituents)
+  {
+    if (candidate.isSelD0() != 1 && candidate.isSelD0bar() != 1) {
+      return;
+    }
+    for (const auto& jet : candidateJets) {
+      auto constituents = selectConstituents(jet.constituents());
+      bool isHFJet = false;
+      for (const auto& constituent : constituents) {
+        if (constituent.user_index() == 1) {
+          isHFJet = true;
+          break;
+        }
+      }
+      if (isHFJet) {
+        jetsTable(collision, jet.eta(), jet.phi(), jet.pt(),
+                  jet.area(), jet.E(), jet.m(), jetFinder.jetR);
+        for (const auto& constituent : constituents) {
+          trackConstituents(jetsTable.lastIndex(), constituent.user_index());
+        }
+        hJetPt->Fill(jet.pt());
+        LOG(debug) << "Filling";
+        hD0Pt->Fill(candidate.pt());
+        break;
+      }
+    }
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<aod::Tracks> const& tracks,
                soa::Filtered<soa::Join<aod::HfCandProng2, aod::HFSelD0Candidate>> const& candidates)
   {
-    std::cout << "Per Event" << std::endl;
+    LOG(debug) << "Per Event";
     // TODO: retrieve pion mass from somewhere
-    bool isHFJet;
 
-    //this loop should be made more efficient
-    for (auto& candidate : candidates) {
-      jets.clear();
-      inputParticles.clear();
-      for (auto& track : tracks) {
-        auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
-        if (candidate.index0().globalIndex() == track.globalIndex() || candidate.index1().globalIndex() == track.globalIndex()) { //is it global index?
-          continue;
+    trackParticles.clear();
+    trackParticles.reserve(tracks.size());
+    for (auto& track : tracks) {
+      auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
+      trackParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
+      trackParticles.back().set_user_index(track.globalIndex());
+    }
+
+    // the tracks of the collision with the prongs of the candidate replaced by the candidate
+    auto fillCandidateInput = [&](auto const& candidate, std::vector<fastjet::PseudoJet>& particles) {
+      const int prong0Id = candidate.index0Id();
+      const int prong1Id = candidate.index1Id();
+      particles.clear();
+      particles.reserve(trackParticles.size() + 1);
+      for (const auto& particle : trackParticles) {
+        if (particle.user_index() != prong0Id && particle.user_index() != prong1Id) {
+          particles.push_back(particle);
         }
-        inputParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
-        inputParticles.back().set_user_index(track.globalIndex());
       }
-      inputParticles.emplace_back(candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
-      inputParticles.back().set_user_index(1);
+      particles.emplace_back(candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
+      particles.back().set_user_index(1);
+    };
+
+    if (batchCandidates) {
+      inputParticlesPerCandidate.resize(candidates.size());
+      int iCandidate = 0;
+      for (auto& candidate : candidates) {
+        fillCandidateInput(candidate, inputParticlesPerCandidate[iCandidate++]);
+      }
+      jetFinder.findJets(inputParticlesPerCandidate, jetsPerCandidate, clusterSeqsPerCandidate, batchCandidatesThreads);
+      // the ghosts are part of the constituents with explicit ghosts
+      const auto notGhost = !fastjet::SelectorIsPureGhost();
+      iCandidate = 0;
+      for (auto& candidate : candidates) {
+        fillHFJet(collision, candidate, jetsPerCandidate[iCandidate++], notGhost);
+      }
+      return;
+    }
 
+    for (auto& candidate : candidates) {
+      jets.clear();
+      fillCandidateInput(candidate, inputParticles);
       fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
-
-      for (const auto& jet : jets) {
-        isHFJet = false;
-        for (const auto& constituent : jet.constituents()) {
-          if (constituent.user_index() == 1 && (candidate.isSelD0() == 1 || candidate.isSelD0bar() == 1)) {
-            isHFJet = true;
-            break;
-          }
-        }
-        if (isHFJet) {
-          jetsTable(collision, jet.eta(), jet.phi(), jet.pt(),
-                    jet.area(), jet.E(), jet.m(), jetFinder.jetR);
-          for (const auto& constituent : jet.constituents()) {
-            trackConstituents(jetsTable.lastIndex(), constituent.user_index());
-          }
-          hJetPt->Fill(jet.pt());
-          std::cout << "Filling" << std::endl;
-          hD0Pt->Fill(candidate.pt());
-          break;
-        }
-      }
+      fillHFJet(collision, candidate, jets, [](std::vector<fastjet::PseudoJet> const& constituents) { return constituents; });
     }
   }
 };
@@ -45,6 +45,11 @@ struct JetMatching {
   Produces<BaseJetCollectionMatching> jetsBaseMatching;
   Produces<TagJetCollectionMatching> jetsTagMatching;
 
+  // kept from event to event to avoid reallocations
+  JetUtilities::GeometricalJetMatcher<double> matcher;
+  std::vector<double> jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta;
+  std::vector<int> baseToTagIndexMap, tagToBaseIndexMap;
+
   void init(InitContext const&)
   {
   }
@@ -56,19 +61,19 @@ struct JetMatching {
     BaseJetCollection const& jetsBase,
     TagJetCollection const& jetsTag)
   {
-    std::vector<double> jetsBasePhi(jetsBase.size());
-    std::vector<double> jetsBaseEta(jetsBase.size());
+    jetsBasePhi.clear();
+    jetsBaseEta.clear();
     for (auto jet : jetsBase) {
       jetsBasePhi.emplace_back(jet.phi());
       jetsBaseEta.emplace_back(jet.eta());
     }
-    std::vector<double> jetsTagPhi(jetsTag.size());
-    std::vector<double> jetsTagEta(jetsTag.size());
+    jetsTagPhi.clear();
+    jetsTagEta.clear();
     for (auto& jet : jetsTag) {
       jetsTagPhi.emplace_back(jet.phi());
       jetsTagEta.emplace_back(jet.eta());
     }
-    auto&& [baseToTagIndexMap, tagToBaseIndexMap] = JetUtilities::MatchJetsGeometrically(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, maxMatchingDistance);
+    matcher.match(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, maxMatchingDistance, baseToTagIndexMap, tagToBaseIndexMap);
 
     unsigned int i = 0;
     for (auto& jet : jetsBase) {
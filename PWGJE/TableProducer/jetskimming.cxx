@@ -23,6 +23,15 @@
 // jet skimming task
 //
 // Author: Nima Zardoshti
+//
+// Each collision gets a JetSkimEvents row with a bitmask of the pre-filter checks it passed, ordered from the
+// cheapest to the most expensive: leading track pT, highest summed pT of the tracks in an eta-phi patch which
+// contains any cone of radius R, and summed pT in a cone of radius R around the seed tracks. The checks after a
+// failed required one are skipped. The constituents are written only for the events passing all the required checks.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
@@ -42,21 +51,143 @@ DECLARE_SOA_COLUMN(Pt, pt, float);
 DECLARE_SOA_COLUMN(Eta, eta, float);
 DECLARE_SOA_COLUMN(Phi, phi, float);
 DECLARE_SOA_COLUMN(Energy, energy, float);
+DECLARE_SOA_COLUMN(Selection, selection, uint8_t); //! Bitmask of the pre-filter checks passed by the event
 } // namespace jetskim
 DECLARE_SOA_TABLE(JetSkim, "AOD", "JETSKIM1",
                   jetskim::CollisionId,
                   jetskim::Pt, jetskim::Eta, jetskim::Phi, jetskim::Energy);
+DECLARE_SOA_TABLE(JetSkimEvents, "AOD", "JETSKIMEVT", //! Pre-filter bitmask, joinable with the collisions
+                  jetskim::Selection);
 } // namespace o2::aod
 
 struct JetSkimmingTask1 {
   Produces<o2::aod::JetSkim> skim;
+  Produces<o2::aod::JetSkimEvents> skimEvents;
+
+  enum SelectionBits : uint8_t {
+    kLeadingTrack = 0x1, // leading track above leadingTrackPtMin
+    kPatch = 0x2,        // summed pT of a patch above jetPtMin
+    kSeedCone = 0x4,     // summed pT in a cone around a seed above jetPtMin
+    kKept = 0x8          // all the required checks passed, constituents written
+  };
+
+  Configurable<int> requiredSelection{"requiredSelection", 0, "Checks required to write the constituents of an event: 1 leading track, 2 patch, 4 seed cone, 0 keeps all the events"};
+  Configurable<float> leadingTrackPtMin{"leadingTrackPtMin", 5.f, "Minimal pT of the leading track"};
+  Configurable<float> jetPtMin{"jetPtMin", 10.f, "Minimal summed track pT of the patches and of the seed cones"};
+  Configurable<float> jetR{"jetR", 0.4f, "Jet radius, size of the patch cells (a patch is 3x3 cells) and radius of the seed cones"};
+  Configurable<float> patchEtaMax{"patchEtaMax", 0.9f, "Eta range of the patch grid, the tracks beyond it are put in the edge cells"};
+  Configurable<float> seedPtMin{"seedPtMin", 2.f, "Minimal pT of the tracks seeding the cones"};
 
   Filter trackCuts = aod::track::pt > 0.15f;
   float mPionSquared = 0.139 * 0.139;
 
+  int mNCellsEta = 0;
+  int mNCellsPhi = 0;
+  std::vector<float> mCellPt;
+  std::vector<float> mSeedEta;
+  std::vector<float> mSeedPhi;
+
+  void init(InitContext const&)
+  {
+    // cells of size R, so that any cone of radius R is contained in a patch of 3x3 cells
+    mNCellsEta = std::max(1, static_cast<int>(std::ceil(2.f * patchEtaMax / jetR)));
+    mNCellsPhi = std::max(3, static_cast<int>(2.f * M_PI / jetR));
+    mCellPt.resize(mNCellsEta * mNCellsPhi);
+  }
+
+  template <typename TTracks>
+  float maxPatchPt(TTracks const& tracks)
+  {
+    std::fill(mCellPt.begin(), mCellPt.end(), 0.f);
+    const float etaScale = mNCellsEta / (2.f * patchEtaMax);
+    const float phiScale = mNCellsPhi / (2.f * M_PI);
+    for (auto& track : tracks) {
+      const int iEta = std::clamp(static_cast<int>((track.eta() + patchEtaMax) * etaScale), 0, mNCellsEta - 1);
+      const int iPhi = std::clamp(static_cast<int>(track.phi() * phiScale), 0, mNCellsPhi - 1);
+      mCellPt[iEta * mNCellsPhi + iPhi] += track.pt();
+    }
+    float maxPt = 0.f;
+    for (int iEta = 0; iEta < mNCellsEta; iEta++) {
+      for (int iPhi = 0; iPhi < mNCellsPhi; iPhi++) {
+        float sumPt = 0.f;
+        for (int jEta = std::max(iEta - 1, 0); jEta <= std::min(iEta + 1, mNCellsEta - 1); jEta++) {
+          for (int dPhi = -1; dPhi <= 1; dPhi++) {
+            sumPt += mCellPt[jEta * mNCellsPhi + (iPhi + dPhi + mNCellsPhi) % mNCellsPhi];
+          }
+        }
+        maxPt = std::max(maxPt, sumPt);
+      }
+    }
+    return maxPt;
+  }
+
+  template <typename TTracks>
+  float maxSeedConePt(TTracks const& tracks)
+  {
+    mSeedEta.clear();
+    mSeedPhi.clear();
+    for (auto& track : tracks) {
+      if (track.pt() > seedPtMin) {
+        mSeedEta.push_back(track.eta());
+        mSeedPhi.push_back(track.phi());
+      }
+    }
+    const float r2 = jetR * jetR;
+    float maxPt = 0.f;
+    for (size_t iSeed = 0; iSeed < mSeedEta.size(); iSeed++) {
+      const float seedEta = mSeedEta[iSeed];
+      const float seedPhi = mSeedPhi[iSeed];
+      float sumPt = 0.f;
+      for (auto& track : tracks) {
+        const float dEta = track.eta() - seedEta;
+        float dPhi = std::abs(track.phi() - seedPhi);
+        if (dPhi > M_PI) {
+          dPhi = 2.f * M_PI - dPhi;
+        }
+        if (dEta * dEta + dPhi * dPhi < r2) {
+          sumPt += track.pt();
+        }
+      }
+      maxPt = std::max(maxPt, sumPt);
+      if (maxPt > jetPtMin) {
+        break;
+      }
+    }
+    return maxPt;
+  }
+
   void process(aod::Collision const& collision,
                soa::Filtered<aod::Tracks> const& tracks)
   {
+    const uint8_t required = requiredSelection;
+    uint8_t selection = 0;
+    float leadingPt = 0.f;
+    for (auto& track : tracks) {
+      leadingPt = std::max(leadingPt, track.pt());
+    }
+    if (leadingPt > leadingTrackPtMin) {
+      selection |= kLeadingTrack;
+    }
+    if ((selection & kLeadingTrack) || !(required & kLeadingTrack)) {
+      if (maxPatchPt(tracks) > jetPtMin) {
+        selection |= kPatch;
+      }
+      if ((selection & kPatch) || !(required & kPatch)) {
+        if (leadingPt > seedPtMin && maxSeedConePt(tracks) > jetPtMin) {
+          selection |= kSeedCone;
+        }
+      }
+    }
+    const bool kept = (selection & required) == required;
+    if (kept) {
+      selection |= kKept;
+    }
+    skimEvents(selection);
+    if (!kept) {
+      return;
+    }
+
+    skim.reserve(tracks.size());
     for (auto& track : tracks) {
       float energy = std::sqrt(track.p() * track.p() + mPionSquared);
       skim(collision, track.pt(), track.eta(), track.phi(), energy);
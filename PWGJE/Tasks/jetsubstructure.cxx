@@ -24,6 +24,7 @@
 
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/Core/JetFinder.h"
+#include "PWGJE/Core/JetSubstructureEngine.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -36,8 +37,9 @@ namespace jetsubstructure
 DECLARE_SOA_COLUMN(Zg, zg, float);
 DECLARE_SOA_COLUMN(Rg, rg, float);
 DECLARE_SOA_COLUMN(Nsd, nsd, float);
+DECLARE_SOA_COLUMN(Angularity, angularity, float);
 } // namespace jetsubstructure
-DECLARE_SOA_TABLE(JetSubtructure, "AOD", "JETSUBSTRUCTURE", jetsubstructure::Zg, jetsubstructure::Rg, jetsubstructure::Nsd);
+DECLARE_SOA_TABLE(JetSubtructure, "AOD", "JETSUBSTRUCTURE", jetsubstructure::Zg, jetsubstructure::Rg, jetsubstructure::Nsd, jetsubstructure::Angularity);
 } // namespace o2::aod
 
 struct JetSubstructure {
@@ -45,16 +47,21 @@ struct JetSubstructure {
   OutputObj<TH1F> hZg{"h_jet_zg"};
   OutputObj<TH1F> hRg{"h_jet_rg"};
   OutputObj<TH1F> hNsd{"h_jet_nsd"};
+  OutputObj<TH1F> hAngularity{"h_jet_angularity"};
 
   Configurable<float> f_jetPtMin{"f_jetPtMin", 0.0, "minimum jet pT cut"};
   Configurable<float> f_zCut{"f_zCut", 0.1, "soft drop z cut"};
   Configurable<float> f_beta{"f_beta", 0.0, "soft drop beta"};
   Configurable<float> f_jetR{"f_jetR", 0.4, "jer resolution parameter"}; //possible to get configurable from another task? jetR
   Configurable<bool> b_DoConstSub{"b_DoConstSub", false, "do constituent subtraction"};
+  Configurable<float> f_angularityKappa{"f_angularityKappa", 1.0, "angularity momentum fraction exponent"};
+  Configurable<float> f_angularityBeta{"f_angularityBeta", 1.0, "angularity angular exponent"};
+  Configurable<int> i_nThreads{"i_nThreads", 1, "number of threads computing the substructure of the jets in the batch mode"};
 
   std::vector<fastjet::PseudoJet> jetConstituents;
-  std::vector<fastjet::PseudoJet> jetReclustered;
-  JetFinder jetReclusterer;
+  std::vector<std::vector<fastjet::PseudoJet>> batchConstituents;
+  std::vector<JetSubstructureEngine::Result> batchResults;
+  JetSubstructureEngine substructureEngine;
 
   void init(InitContext const&)
   {
@@ -64,9 +71,25 @@ struct JetSubstructure {
                            10, 0.0, 0.5));
     hNsd.setObject(new TH1F("h_jet_nsd", "nsd ;nsd",
                             7, -0.5, 6.5));
-    jetReclusterer.isReclustering = true;
-    jetReclusterer.algorithm = fastjet::JetAlgorithm::cambridge_algorithm;
-    jetReclusterer.jetR = f_jetR * 2.5;
+    hAngularity.setObject(new TH1F("h_jet_angularity", "angularity ;#lambda",
+                                   20, 0.0, 1.0));
+    substructureEngine.zCut = f_zCut;
+    substructureEngine.beta = f_beta;
+    substructureEngine.jetR = f_jetR;
+    substructureEngine.reclusteringR = f_jetR * 2.5;
+    substructureEngine.angularityKappa = f_angularityKappa;
+    substructureEngine.angularityBeta = f_angularityBeta;
+  }
+
+  void fillSubstructure(const JetSubstructureEngine::Result& result)
+  {
+    if (result.zg >= 0) {
+      hZg->Fill(result.zg);
+      hRg->Fill(result.rg);
+    }
+    hNsd->Fill(result.nsd);
+    hAngularity->Fill(result.angularity);
+    jetSubstructure(result.zg, result.rg, result.nsd, result.angularity);
   }
 
   //Filter jetCuts = aod::jet::pt > f_jetPtMin; //how does this work?
@@ -77,7 +100,6 @@ struct JetSubstructure {
                aod::JetConstituentsSub const& constituentsSub)
   {
     jetConstituents.clear();
-    jetReclustered.clear();
     if (b_DoConstSub) {
       for (const auto& constituent : constituentsSub) {
         fillConstituents(constituent, jetConstituents);
@@ -88,36 +110,39 @@ struct JetSubstructure {
         fillConstituents(constituent, jetConstituents);
       }
     }
-    fastjet::ClusterSequenceArea clusterSeq(jetReclusterer.findJets(jetConstituents, jetReclustered));
-    jetReclustered = sorted_by_pt(jetReclustered);
-    fastjet::PseudoJet daughterSubJet = jetReclustered[0];
-    fastjet::PseudoJet parentSubJet1;
-    fastjet::PseudoJet parentSubJet2;
-    bool softDropped = false;
-    int nsd = 0.0;
-    auto zg = -1.0;
-    auto rg = -1.0;
-    while (daughterSubJet.has_parents(parentSubJet1, parentSubJet2)) {
-      if (parentSubJet1.perp() < parentSubJet2.perp()) {
-        std::swap(parentSubJet1, parentSubJet2);
+    fillSubstructure(substructureEngine.compute(jetConstituents));
+  }
+
+  PROCESS_SWITCH(JetSubstructure, process, "Substructure of the jets, one jet at a time", true);
+
+  /// Computes the substructure of all the jets of the dataframe at once, distributed over i_nThreads threads
+  void processBatch(aod::Jets const& jets,
+                    aod::Tracks const& tracks,
+                    aod::JetTrackConstituents const& constituents,
+                    aod::JetConstituentsSub const& constituentsSub)
+  {
+    batchConstituents.resize(jets.size());
+    for (auto& jetConstituents : batchConstituents) {
+      jetConstituents.clear();
+    }
+    if (b_DoConstSub) {
+      for (const auto& constituent : constituentsSub) {
+        fillConstituents(constituent, batchConstituents[constituent.jetId()]);
       }
-      auto z = parentSubJet2.perp() / (parentSubJet1.perp() + parentSubJet2.perp());
-      auto r = parentSubJet1.delta_R(parentSubJet2);
-      if (z >= f_zCut * TMath::Power(r / f_jetR, f_beta)) {
-        if (!softDropped) {
-          zg = z;
-          rg = r;
-          hZg->Fill(zg);
-          hRg->Fill(rg);
-          softDropped = true;
-        }
-        nsd++;
+    } else {
+      for (const auto& constituentIndex : constituents) {
+        auto constituent = constituentIndex.track();
+        fillConstituents(constituent, batchConstituents[constituentIndex.jetId()]);
       }
-      daughterSubJet = parentSubJet1;
     }
-    hNsd->Fill(nsd);
-    jetSubstructure(zg, rg, nsd);
+    substructureEngine.compute(batchConstituents, batchResults, i_nThreads);
+    // the table is filled in the order of the jets
+    for (const auto& result : batchResults) {
+      fillSubstructure(result);
+    }
   }
+
+  PROCESS_SWITCH(JetSubstructure, processBatch, "Substructure of all the jets of the dataframe at once", false);
 };
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
 {
@@ -122,5 +122,177 @@ DECLARE_SOA_TABLE(LfCandNucleusMC, "AOD", "LFNUCLMC",
                   full::IsPhysicalPrimary,
                   full::ProducedByGenerator);
 
+// Skimmed nuclei candidates with binned columns
+namespace nucleiskim
+{
+/// Binning of the stored quantities on 16 bits, same convention as the binned PID tables
+template <typename T>
+struct binningBase {
+ public:
+  typedef T binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+};
+struct binningMomentum : binningBase<int16_t> { //! pT and TPC inner param, in GeV/c
+  static constexpr float binned_max = 32.767;
+  static constexpr float binned_min = -32.767;
+  static constexpr float bin_width = 0.001;
+};
+struct binningAngle : binningBase<int16_t> { //! eta and phi (in [0, 2pi))
+  static constexpr float binned_max = 6.5534;
+  static constexpr float binned_min = -6.5534;
+  static constexpr float bin_width = 0.0002;
+};
+struct binningFine : binningBase<int16_t> { //! DCAs in cm, beta and TPC crossed rows over findable clusters
+  static constexpr float binned_max = 3.2767;
+  static constexpr float binned_min = -3.2767;
+  static constexpr float bin_width = 0.0001;
+};
+struct binningSignal : binningBase<int16_t> { //! TPC signal
+  static constexpr float binned_max = 1638.35;
+  static constexpr float binned_min = -1638.35;
+  static constexpr float bin_width = 0.05;
+};
+struct binningNSigma : binningBase<int16_t> { //! nsigma and chi2
+  static constexpr float binned_max = 327.67;
+  static constexpr float binned_min = -327.67;
+  static constexpr float bin_width = 0.01;
+};
+
+/// Packs a float into a binned value, same convention as pidutils::packInTable
+template <typename binningType>
+typename binningType::binned_t packBinned(float value)
+{
+  if (value <= binningType::binned_min) {
+    return binningType::underflowBin;
+  }
+  if (value >= binningType::binned_max) {
+    return binningType::overflowBin;
+  }
+  if (value >= 0) {
+    return static_cast<typename binningType::binned_t>((value / binningType::bin_width) + 0.5f);
+  }
+  return static_cast<typename binningType::binned_t>((value / binningType::bin_width) - 0.5f);
+}
+
+/// Bits of the candidate mask, set when the TPC nsigma is in the band of the species
+enum CandidateBits : uint8_t {
+  kDeuteron = 0,
+  kTriton,
+  kHelium3
+};
+} // namespace nucleiskim
+
+namespace skimEvent
+{
+DECLARE_SOA_COLUMN(NDeuterons, nDeuterons, uint16_t); //! number of deuteron candidates
+DECLARE_SOA_COLUMN(NTritons, nTritons, uint16_t);     //! number of triton candidates
+DECLARE_SOA_COLUMN(NHelium3, nHelium3, uint16_t);     //! number of helium-3 candidates
+DECLARE_SOA_DYNAMIC_COLUMN(NCandidates, nCandidates, //! number of candidates of any species, a track can be counted for several species
+                           [](uint16_t nDeuterons, uint16_t nTritons, uint16_t nHelium3) -> int { return nDeuterons + nTritons + nHelium3; });
+} // namespace skimEvent
+DECLARE_SOA_TABLE(LfNuclSkimEvents, "AOD", "LFNUCLSKIMEV", //! Events of the nuclei skim, with the number of candidates
+                  o2::soa::Index<>,
+                  collision::PosZ,
+                  fullEvent::V0M,
+                  fullEvent::IsEventReject,
+                  fullEvent::RunNumber,
+                  skimEvent::NDeuterons,
+                  skimEvent::NTritons,
+                  skimEvent::NHelium3,
+                  skimEvent::NCandidates<skimEvent::NDeuterons, skimEvent::NTritons, skimEvent::NHelium3>);
+using LfNuclSkimEvent = LfNuclSkimEvents::iterator;
+
+namespace skim
+{
+DECLARE_SOA_INDEX_COLUMN(LfNuclSkimEvent, lfNuclSkimEvent); //!
+
+// Stored binned values
+DECLARE_SOA_COLUMN(PtStore, ptStore, nucleiskim::binningMomentum::binned_t);                       //! binned pT
+DECLARE_SOA_COLUMN(EtaStore, etaStore, nucleiskim::binningAngle::binned_t);                        //! binned eta
+DECLARE_SOA_COLUMN(PhiStore, phiStore, nucleiskim::binningAngle::binned_t);                        //! binned phi
+DECLARE_SOA_COLUMN(DCAxyStore, dcaxyStore, nucleiskim::binningFine::binned_t);                     //! binned DCAxy
+DECLARE_SOA_COLUMN(DCAzStore, dcazStore, nucleiskim::binningFine::binned_t);                       //! binned DCAz
+DECLARE_SOA_COLUMN(TPCInnerParamStore, tpcInnerParamStore, nucleiskim::binningMomentum::binned_t); //! binned TPC inner param
+DECLARE_SOA_COLUMN(TPCSignalStore, tpcSignalStore, nucleiskim::binningSignal::binned_t);           //! binned TPC signal
+DECLARE_SOA_COLUMN(BetaStore, betaStore, nucleiskim::binningFine::binned_t);                       //! binned TOF beta
+DECLARE_SOA_COLUMN(NSigTPCDeStore, nsigTPCDStore, nucleiskim::binningNSigma::binned_t);            //! binned TPC nsigma deuteron
+DECLARE_SOA_COLUMN(NSigTPCTrStore, nsigTPCTStore, nucleiskim::binningNSigma::binned_t);            //! binned TPC nsigma triton
+DECLARE_SOA_COLUMN(NSigTPC3HeStore, nsigTPC3HeStore, nucleiskim::binningNSigma::binned_t);         //! binned TPC nsigma helium-3
+DECLARE_SOA_COLUMN(NSigTOFDeStore, nsigTOFDStore, nucleiskim::binningNSigma::binned_t);            //! binned TOF nsigma deuteron
+DECLARE_SOA_COLUMN(NSigTOFTrStore, nsigTOFTStore, nucleiskim::binningNSigma::binned_t);            //! binned TOF nsigma triton
+DECLARE_SOA_COLUMN(NSigTOF3HeStore, nsigTOF3HeStore, nucleiskim::binningNSigma::binned_t);         //! binned TOF nsigma helium-3
+DECLARE_SOA_COLUMN(RTPCStore, rTPCStore, nucleiskim::binningFine::binned_t);                       //! binned TPC crossed rows over findable clusters
+DECLARE_SOA_COLUMN(Chi2TPCStore, chi2TPCStore, nucleiskim::binningNSigma::binned_t);               //! binned TPC chi2 per cluster
+DECLARE_SOA_COLUMN(Chi2ITSStore, chi2ITSStore, nucleiskim::binningNSigma::binned_t);               //! binned ITS chi2 per cluster
+DECLARE_SOA_COLUMN(Sign, sign, int8_t);                                                            //! charge sign
+DECLARE_SOA_COLUMN(HasTOF, hasTOF, bool);                                                          //! track with TOF signal
+DECLARE_SOA_COLUMN(NcrTPC, ncrTPC, uint8_t);                                                       //! TPC crossed rows
+DECLARE_SOA_COLUMN(CandidateMask, candidateMask, uint8_t);                                         //! bits of nucleiskim::CandidateBits
+
+// Unwrapped values
+#define DEFINE_UNWRAP_SKIM_COLUMN(COLUMN, COLUMN_NAME, BINNING) \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, COLUMN_NAME,               \
+                             [](BINNING::binned_t binned) -> float { return BINNING::bin_width * static_cast<float>(binned); });
+DEFINE_UNWRAP_SKIM_COLUMN(Pt, pt, nucleiskim::binningMomentum);                       //! pT
+DEFINE_UNWRAP_SKIM_COLUMN(Eta, eta, nucleiskim::binningAngle);                        //! eta
+DEFINE_UNWRAP_SKIM_COLUMN(Phi, phi, nucleiskim::binningAngle);                        //! phi
+DEFINE_UNWRAP_SKIM_COLUMN(DCAxy, dcaxy, nucleiskim::binningFine);                     //! DCAxy
+DEFINE_UNWRAP_SKIM_COLUMN(DCAz, dcaz, nucleiskim::binningFine);                       //! DCAz
+DEFINE_UNWRAP_SKIM_COLUMN(TPCInnerParam, tpcInnerParam, nucleiskim::binningMomentum); //! TPC inner param
+DEFINE_UNWRAP_SKIM_COLUMN(TPCSignal, tpcSignal, nucleiskim::binningSignal);           //! TPC signal
+DEFINE_UNWRAP_SKIM_COLUMN(Beta, beta, nucleiskim::binningFine);                       //! TOF beta
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTPCDe, nsigTPCD, nucleiskim::binningNSigma);            //! TPC nsigma deuteron
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTPCTr, nsigTPCT, nucleiskim::binningNSigma);            //! TPC nsigma triton
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTPC3He, nsigTPC3He, nucleiskim::binningNSigma);         //! TPC nsigma helium-3
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTOFDe, nsigTOFD, nucleiskim::binningNSigma);            //! TOF nsigma deuteron
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTOFTr, nsigTOFT, nucleiskim::binningNSigma);            //! TOF nsigma triton
+DEFINE_UNWRAP_SKIM_COLUMN(NSigTOF3He, nsigTOF3He, nucleiskim::binningNSigma);         //! TOF nsigma helium-3
+DEFINE_UNWRAP_SKIM_COLUMN(RTPC, rTPC, nucleiskim::binningFine);                       //! TPC crossed rows over findable clusters
+DEFINE_UNWRAP_SKIM_COLUMN(Chi2TPC, chi2TPC, nucleiskim::binningNSigma);               //! TPC chi2 per cluster
+DEFINE_UNWRAP_SKIM_COLUMN(Chi2ITS, chi2ITS, nucleiskim::binningNSigma);               //! ITS chi2 per cluster
+#undef DEFINE_UNWRAP_SKIM_COLUMN
+DECLARE_SOA_DYNAMIC_COLUMN(P, p, //! momentum
+                           [](nucleiskim::binningMomentum::binned_t ptBinned, nucleiskim::binningAngle::binned_t etaBinned) -> float {
+                             return nucleiskim::binningMomentum::bin_width * static_cast<float>(ptBinned) * std::cosh(nucleiskim::binningAngle::bin_width * static_cast<float>(etaBinned));
+                           });
+DECLARE_SOA_DYNAMIC_COLUMN(IsCandidate, isCandidate, //! checks the candidate bit of a species
+                           [](uint8_t mask, nucleiskim::CandidateBits species) -> bool { return mask & (1 << species); });
+} // namespace skim
+
+DECLARE_SOA_TABLE(LfNuclSkimCands, "AOD", "LFNUCLSKIM", //! Nuclei candidates of the skim, with binned columns
+                  o2::soa::Index<>,
+                  skim::LfNuclSkimEventId,
+                  skim::PtStore, skim::EtaStore, skim::PhiStore, skim::Sign,
+                  skim::DCAxyStore, skim::DCAzStore,
+                  skim::TPCInnerParamStore, skim::TPCSignalStore, skim::HasTOF, skim::BetaStore,
+                  skim::NSigTPCDeStore, skim::NSigTPCTrStore, skim::NSigTPC3HeStore,
+                  skim::NSigTOFDeStore, skim::NSigTOFTrStore, skim::NSigTOF3HeStore,
+                  skim::NcrTPC, skim::RTPCStore, skim::Chi2TPCStore, skim::Chi2ITSStore,
+                  skim::CandidateMask,
+
+                  // Dynamic columns
+                  skim::Pt<skim::PtStore>,
+                  skim::Eta<skim::EtaStore>,
+                  skim::Phi<skim::PhiStore>,
+                  skim::P<skim::PtStore, skim::EtaStore>,
+                  skim::DCAxy<skim::DCAxyStore>,
+                  skim::DCAz<skim::DCAzStore>,
+                  skim::TPCInnerParam<skim::TPCInnerParamStore>,
+                  skim::TPCSignal<skim::TPCSignalStore>,
+                  skim::Beta<skim::BetaStore>,
+                  skim::NSigTPCDe<skim::NSigTPCDeStore>,
+                  skim::NSigTPCTr<skim::NSigTPCTrStore>,
+                  skim::NSigTPC3He<skim::NSigTPC3HeStore>,
+                  skim::NSigTOFDe<skim::NSigTOFDeStore>,
+                  skim::NSigTOFTr<skim::NSigTOFTrStore>,
+                  skim::NSigTOF3He<skim::NSigTOF3HeStore>,
+                  skim::RTPC<skim::RTPCStore>,
+                  skim::Chi2TPC<skim::Chi2TPCStore>,
+                  skim::Chi2ITS<skim::Chi2ITSStore>,
+                  skim::IsCandidate<skim::CandidateMask>);
+using LfNuclSkimCand = LfNuclSkimCands::iterator;
+
 } // namespace o2::aod
 #endif
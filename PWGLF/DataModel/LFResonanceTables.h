@@ -44,6 +44,13 @@ DECLARE_SOA_TABLE(ResoCollisions, "AOD", "RESOCOL",
                   timestamp::Timestamp);
 using ResoCollision = ResoCollisions::iterator;
 
+namespace resocollision
+{
+DECLARE_SOA_COLUMN(MixingBin, mixingBin, int); //! Event mixing category (z-vertex and multiplicity bin), -1 if outside the binning
+} // namespace resocollision
+DECLARE_SOA_TABLE(ResoMixingKeys, "AOD", "RESOMIXKEY", //! Joinable table with ResoCollisions holding the event mixing category
+                  resocollision::MixingBin);
+
 // Resonance Daughters
 // inspired from PWGCF/DataModel/FemtoDerived.h
 namespace resodaughter
@@ -130,6 +137,19 @@ DECLARE_SOA_TABLE(ResoDaughters, "AOD", "RESODAUGHTERS",
                   resodaughter::DecayVtxZ);
 using ResoDaughter = ResoDaughters::iterator;
 
+DECLARE_SOA_TABLE(ResoMixDaughters, "AOD", "RESOMIXDAU", //! Compact copy of the track daughters, for the background estimation
+                  o2::soa::Index<>,
+                  resodaughter::ResoCollisionId,
+                  resodaughter::Px,
+                  resodaughter::Py,
+                  resodaughter::Pz,
+                  resodaughter::Sign,
+                  o2::aod::track::DcaXY,
+                  o2::aod::track::DcaZ,
+                  resodaughter::TPCPIDselectionFlag,
+                  resodaughter::TOFPIDselectionFlag);
+using ResoMixDaughter = ResoMixDaughters::iterator;
+
 using Reso2TracksExt = soa::Join<aod::FullTracks, aod::TracksExtra, aod::TracksDCA>;
 using Reso2TracksMC = soa::Join<aod::FullTracks, McTrackLabels>;
 using Reso2TracksPID = soa::Join<aod::FullTracks, aod::pidTPCPi, aod::pidTPCKa, aod::pidTPCPr, aod::pidTOFPi, aod::pidTOFKa, aod::pidTOFPr>;
@@ -43,6 +43,10 @@ DECLARE_SOA_COLUMN(DCAV0Daughters, dcaV0daughters, float); //! DCA between V0 da
 DECLARE_SOA_COLUMN(DCAPosToPV, dcapostopv, float);         //! DCA positive prong to PV
 DECLARE_SOA_COLUMN(DCANegToPV, dcanegtopv, float);         //! DCA negative prong to PV
 
+// Saved from finding: covariance matrices, for downstream fits starting from the V0
+DECLARE_SOA_COLUMN(PositionCovMat, positionCovMat, float[6]); //! decay position covariance (xx, xy, yy, xz, yz, zz)
+DECLARE_SOA_COLUMN(MomentumCovMat, momentumCovMat, float[6]); //! momentum covariance (pxpx, pxpy, pypy, pxpz, pypz, pzpz), sum of the daughters
+
 // Derived expressions
 // Momenta
 DECLARE_SOA_DYNAMIC_COLUMN(Pt, pt, //! V0 pT
@@ -191,6 +195,11 @@ DECLARE_SOA_EXTENDED_TABLE_USER(V0Datas, StoredV0Datas, "V0DATAEXT", //!
                                 v0data::Px, v0data::Py, v0data::Pz); // the table name has here to be the one with EXT which is not nice and under study
 
 using V0Data = V0Datas::iterator;
+
+DECLARE_SOA_TABLE(V0Covs, "AOD", "V0COVS", //! Joinable table with V0Datas holding the V0 vertex and momentum covariance, produced on request
+                  v0data::PositionCovMat, v0data::MomentumCovMat);
+
+using V0Cov = V0Covs::iterator;
 namespace v0data
 {
 DECLARE_SOA_INDEX_COLUMN(V0Data, v0Data); //! Index to V0Data entry
@@ -327,6 +336,203 @@ DECLARE_SOA_EXTENDED_TABLE_USER(CascDataExt, CascDataOrigin, "CascDATAEXT", //!
 
 using CascDataFull = CascDataExt;
 
+// Derived data: compact V0 format for analyses running without the AO2D track tables
+namespace stradata
+{
+/// Binning of the quantities stored on 16 bits (or 8 bits for the nsigma), same convention as the binned PID tables
+template <typename T>
+struct binningBase {
+ public:
+  typedef T binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+};
+struct binningMomentum : binningBase<int16_t> { //! pT and Armenteros qT, in GeV/c
+  static constexpr float binned_max = 32.767;
+  static constexpr float binned_min = -32.767;
+  static constexpr float bin_width = 0.001;
+};
+struct binningFine : binningBase<int16_t> { //! eta, phi (in [-pi, pi)) and Armenteros variables
+  static constexpr float binned_max = 3.2767;
+  static constexpr float binned_min = -3.2767;
+  static constexpr float bin_width = 0.0001;
+};
+struct binningMass : binningBase<int16_t> { //! invariant mass offsets from the PDG mass, in GeV/c^2
+  static constexpr float binned_max = 0.32767;
+  static constexpr float binned_min = -0.32767;
+  static constexpr float bin_width = 0.00001;
+};
+struct binningDCA : binningBase<int16_t> { //! DCAs, in cm
+  static constexpr float binned_max = 32.767;
+  static constexpr float binned_min = -32.767;
+  static constexpr float bin_width = 0.001;
+};
+struct binningLength : binningBase<int16_t> { //! decay radius and distance over momentum, in cm and cm/(GeV/c)
+  static constexpr float binned_max = 327.67;
+  static constexpr float binned_min = -327.67;
+  static constexpr float bin_width = 0.01;
+};
+struct binningNSigma : binningBase<int8_t> { //! TPC nsigma of the daughters
+  static constexpr float binned_max = 6.35;
+  static constexpr float binned_min = -6.35;
+  static constexpr float bin_width = 0.1;
+};
+
+/// Packs a float into a binned value, same convention as pidutils::packInTable
+template <typename binningType>
+typename binningType::binned_t packBinned(float value)
+{
+  if (value <= binningType::binned_min) {
+    return binningType::underflowBin;
+  }
+  if (value >= binningType::binned_max) {
+    return binningType::overflowBin;
+  }
+  if (value >= 0) {
+    return static_cast<typename binningType::binned_t>((value / binningType::bin_width) + 0.5f);
+  }
+  return static_cast<typename binningType::binned_t>((value / binningType::bin_width) - 0.5f);
+}
+
+/// Bits of the V0 selection mask, evaluated once by the derived-data builder with its configured cuts
+enum V0SelectionBits : uint16_t {
+  kV0Topology = 0,  // radius, cosPA, DCA between the daughters and DCAs of the daughters to the PV
+  kLambdaRapidity,  // rapidity in the Lambda hypothesis
+  kLambdaLifetime,  // proper length in the Lambda hypothesis
+  kPosProtonPID,    // positive daughter compatible with a proton (TPC)
+  kNegProtonPID,    // negative daughter compatible with an antiproton (TPC)
+  kPosPionPID,      // positive daughter compatible with a pion (TPC)
+  kNegPionPID,      // negative daughter compatible with a pion (TPC)
+  kK0ShortRapidity, // rapidity in the K0Short hypothesis
+  kK0ShortLifetime, // proper length in the K0Short hypothesis
+  kK0ShortArmenteros
+};
+} // namespace stradata
+
+namespace stracollision
+{
+DECLARE_SOA_COLUMN(PosX, posX, float);                      //! PV X
+DECLARE_SOA_COLUMN(PosY, posY, float);                      //! PV Y
+DECLARE_SOA_COLUMN(PosZ, posZ, float);                      //! PV Z
+DECLARE_SOA_COLUMN(Centrality, centrality, float);          //! centrality percentile, -1 if not available
+DECLARE_SOA_COLUMN(IsEventSelected, isEventSelected, bool); //! sel8 in Run 3, kINT7 and sel7 in Run 2
+} // namespace stracollision
+
+DECLARE_SOA_TABLE(StraCollisions, "AOD", "STRACOLLISION", //! Collisions of the strangeness derived data
+                  o2::soa::Index<>, stracollision::PosX, stracollision::PosY, stracollision::PosZ,
+                  stracollision::Centrality, stracollision::IsEventSelected);
+using StraCollision = StraCollisions::iterator;
+
+namespace strav0
+{
+DECLARE_SOA_INDEX_COLUMN(StraCollision, straCollision); //!
+
+// Stored binned values
+DECLARE_SOA_COLUMN(PtStore, ptStore, stradata::binningMomentum::binned_t);                         //! binned V0 pT
+DECLARE_SOA_COLUMN(EtaStore, etaStore, stradata::binningFine::binned_t);                           //! binned V0 eta
+DECLARE_SOA_COLUMN(PhiStore, phiStore, stradata::binningFine::binned_t);                           //! binned V0 phi in [-pi, pi)
+DECLARE_SOA_COLUMN(DeltaMLambdaStore, deltaMLambdaStore, stradata::binningMass::binned_t);         //! binned Lambda mass offset from the PDG mass
+DECLARE_SOA_COLUMN(DeltaMAntiLambdaStore, deltaMAntiLambdaStore, stradata::binningMass::binned_t); //! binned antiLambda mass offset from the PDG mass
+DECLARE_SOA_COLUMN(DeltaMK0ShortStore, deltaMK0ShortStore, stradata::binningMass::binned_t);       //! binned K0Short mass offset from the PDG mass
+DECLARE_SOA_COLUMN(V0RadiusStore, v0radiusStore, stradata::binningLength::binned_t);               //! binned V0 decay radius
+DECLARE_SOA_COLUMN(DistOverTotMomStore, distovertotmomStore, stradata::binningLength::binned_t);   //! binned PV to V0 decay distance over total momentum
+DECLARE_SOA_COLUMN(DCAV0DaughtersStore, dcaV0daughtersStore, stradata::binningDCA::binned_t);      //! binned DCA between the V0 daughters
+DECLARE_SOA_COLUMN(DCAPosToPVStore, dcapostopvStore, stradata::binningDCA::binned_t);              //! binned DCA of the positive daughter to the PV
+DECLARE_SOA_COLUMN(DCANegToPVStore, dcanegtopvStore, stradata::binningDCA::binned_t);              //! binned DCA of the negative daughter to the PV
+DECLARE_SOA_COLUMN(DCAV0ToPVStore, dcav0topvStore, stradata::binningDCA::binned_t);                //! binned DCA of the V0 to the PV
+DECLARE_SOA_COLUMN(AlphaStore, alphaStore, stradata::binningFine::binned_t);                       //! binned Armenteros alpha
+DECLARE_SOA_COLUMN(QtArmStore, qtarmStore, stradata::binningFine::binned_t);                       //! binned Armenteros qT
+DECLARE_SOA_COLUMN(V0CosPA, v0cosPA, float);                                                       //! V0 CosPA, not binned because of its precision near 1
+DECLARE_SOA_COLUMN(SelectionMask, selectionMask, uint16_t);                                        //! bits of stradata::V0SelectionBits
+
+// Unwrapped values
+#define DEFINE_UNWRAP_STRAV0_COLUMN(COLUMN, COLUMN_NAME, BINNING) \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, COLUMN_NAME,                 \
+                             [](BINNING::binned_t binned) -> float { return BINNING::bin_width * static_cast<float>(binned); });
+DEFINE_UNWRAP_STRAV0_COLUMN(Pt, pt, stradata::binningMomentum);                       //! V0 pT
+DEFINE_UNWRAP_STRAV0_COLUMN(Eta, eta, stradata::binningFine);                         //! V0 eta
+DEFINE_UNWRAP_STRAV0_COLUMN(V0Radius, v0radius, stradata::binningLength);             //! V0 decay radius
+DEFINE_UNWRAP_STRAV0_COLUMN(DistOverTotMom, distovertotmom, stradata::binningLength); //! PV to V0 decay distance over total momentum
+DEFINE_UNWRAP_STRAV0_COLUMN(DCAV0Daughters, dcaV0daughters, stradata::binningDCA);    //! DCA between the V0 daughters
+DEFINE_UNWRAP_STRAV0_COLUMN(DCAPosToPV, dcapostopv, stradata::binningDCA);            //! DCA of the positive daughter to the PV
+DEFINE_UNWRAP_STRAV0_COLUMN(DCANegToPV, dcanegtopv, stradata::binningDCA);            //! DCA of the negative daughter to the PV
+DEFINE_UNWRAP_STRAV0_COLUMN(DCAV0ToPV, dcav0topv, stradata::binningDCA);              //! DCA of the V0 to the PV
+DEFINE_UNWRAP_STRAV0_COLUMN(Alpha, alpha, stradata::binningFine);                     //! Armenteros alpha
+DEFINE_UNWRAP_STRAV0_COLUMN(QtArm, qtarm, stradata::binningFine);                     //! Armenteros qT
+DECLARE_SOA_DYNAMIC_COLUMN(Phi, phi, //! V0 phi in [0, 2pi)
+                           [](stradata::binningFine::binned_t binned) -> float { return RecoDecay::constrainAngle(stradata::binningFine::bin_width * static_cast<float>(binned)); });
+DECLARE_SOA_DYNAMIC_COLUMN(MLambda, mLambda, //! mass under lambda hypothesis
+                           [](stradata::binningMass::binned_t binned) -> float { return RecoDecay::getMassPDG(kLambda0) + stradata::binningMass::bin_width * static_cast<float>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(MAntiLambda, mAntiLambda, //! mass under antilambda hypothesis
+                           [](stradata::binningMass::binned_t binned) -> float { return RecoDecay::getMassPDG(kLambda0) + stradata::binningMass::bin_width * static_cast<float>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(MK0Short, mK0Short, //! mass under K0short hypothesis
+                           [](stradata::binningMass::binned_t binned) -> float { return RecoDecay::getMassPDG(kK0Short) + stradata::binningMass::bin_width * static_cast<float>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(YLambda, yLambda, //! V0 y with lambda or antilambda hypothesis
+                           [](stradata::binningMomentum::binned_t ptBinned, stradata::binningFine::binned_t etaBinned) -> float {
+                             float pt = stradata::binningMomentum::bin_width * static_cast<float>(ptBinned);
+                             float pz = pt * std::sinh(stradata::binningFine::bin_width * static_cast<float>(etaBinned));
+                             float e = RecoDecay::e(std::sqrt(pt * pt + pz * pz), RecoDecay::getMassPDG(kLambda0));
+                             return 0.5f * std::log((e + pz) / (e - pz));
+                           });
+DECLARE_SOA_DYNAMIC_COLUMN(YK0Short, yK0Short, //! V0 y with K0short hypothesis
+                           [](stradata::binningMomentum::binned_t ptBinned, stradata::binningFine::binned_t etaBinned) -> float {
+                             float pt = stradata::binningMomentum::bin_width * static_cast<float>(ptBinned);
+                             float pz = pt * std::sinh(stradata::binningFine::bin_width * static_cast<float>(etaBinned));
+                             float e = RecoDecay::e(std::sqrt(pt * pt + pz * pz), RecoDecay::getMassPDG(kK0Short));
+                             return 0.5f * std::log((e + pz) / (e - pz));
+                           });
+DECLARE_SOA_DYNAMIC_COLUMN(IsSelected, isSelected, //! checks the selection bits
+                           [](uint16_t mask, uint16_t bits) -> bool { return (mask & bits) == bits; });
+
+// Daughter PID
+DECLARE_SOA_COLUMN(PosTPCNSigmaPrStore, posTPCNSigmaPrStore, stradata::binningNSigma::binned_t); //! binned TPC nsigma proton of the positive daughter
+DECLARE_SOA_COLUMN(PosTPCNSigmaPiStore, posTPCNSigmaPiStore, stradata::binningNSigma::binned_t); //! binned TPC nsigma pion of the positive daughter
+DECLARE_SOA_COLUMN(NegTPCNSigmaPrStore, negTPCNSigmaPrStore, stradata::binningNSigma::binned_t); //! binned TPC nsigma proton of the negative daughter
+DECLARE_SOA_COLUMN(NegTPCNSigmaPiStore, negTPCNSigmaPiStore, stradata::binningNSigma::binned_t); //! binned TPC nsigma pion of the negative daughter
+DEFINE_UNWRAP_STRAV0_COLUMN(PosTPCNSigmaPr, posTPCNSigmaPr, stradata::binningNSigma);            //! TPC nsigma proton of the positive daughter
+DEFINE_UNWRAP_STRAV0_COLUMN(PosTPCNSigmaPi, posTPCNSigmaPi, stradata::binningNSigma);            //! TPC nsigma pion of the positive daughter
+DEFINE_UNWRAP_STRAV0_COLUMN(NegTPCNSigmaPr, negTPCNSigmaPr, stradata::binningNSigma);            //! TPC nsigma proton of the negative daughter
+DEFINE_UNWRAP_STRAV0_COLUMN(NegTPCNSigmaPi, negTPCNSigmaPi, stradata::binningNSigma);            //! TPC nsigma pion of the negative daughter
+#undef DEFINE_UNWRAP_STRAV0_COLUMN
+} // namespace strav0
+
+DECLARE_SOA_TABLE(StraV0s, "AOD", "STRAV0", //! V0s of the strangeness derived data, with binned kinematics and topology
+                  o2::soa::Index<>, strav0::StraCollisionId,
+                  strav0::PtStore, strav0::EtaStore, strav0::PhiStore,
+                  strav0::DeltaMLambdaStore, strav0::DeltaMAntiLambdaStore, strav0::DeltaMK0ShortStore,
+                  strav0::V0RadiusStore, strav0::DistOverTotMomStore,
+                  strav0::DCAV0DaughtersStore, strav0::DCAPosToPVStore, strav0::DCANegToPVStore, strav0::DCAV0ToPVStore,
+                  strav0::AlphaStore, strav0::QtArmStore, strav0::V0CosPA, strav0::SelectionMask,
+
+                  // Dynamic columns
+                  strav0::Pt<strav0::PtStore>,
+                  strav0::Eta<strav0::EtaStore>,
+                  strav0::Phi<strav0::PhiStore>,
+                  strav0::MLambda<strav0::DeltaMLambdaStore>,
+                  strav0::MAntiLambda<strav0::DeltaMAntiLambdaStore>,
+                  strav0::MK0Short<strav0::DeltaMK0ShortStore>,
+                  strav0::YLambda<strav0::PtStore, strav0::EtaStore>,
+                  strav0::YK0Short<strav0::PtStore, strav0::EtaStore>,
+                  strav0::V0Radius<strav0::V0RadiusStore>,
+                  strav0::DistOverTotMom<strav0::DistOverTotMomStore>,
+                  strav0::DCAV0Daughters<strav0::DCAV0DaughtersStore>,
+                  strav0::DCAPosToPV<strav0::DCAPosToPVStore>,
+                  strav0::DCANegToPV<strav0::DCANegToPVStore>,
+                  strav0::DCAV0ToPV<strav0::DCAV0ToPVStore>,
+                  strav0::Alpha<strav0::AlphaStore>,
+                  strav0::QtArm<strav0::QtArmStore>,
+                  strav0::IsSelected<strav0::SelectionMask>);
+using StraV0 = StraV0s::iterator;
+
+DECLARE_SOA_TABLE(StraV0PIDs, "AOD", "STRAV0PID", //! Joinable table with StraV0s holding the binned TPC PID of the daughters
+                  strav0::PosTPCNSigmaPrStore, strav0::PosTPCNSigmaPiStore,
+                  strav0::NegTPCNSigmaPrStore, strav0::NegTPCNSigmaPiStore,
+                  strav0::PosTPCNSigmaPr<strav0::PosTPCNSigmaPrStore>,
+                  strav0::PosTPCNSigmaPi<strav0::PosTPCNSigmaPiStore>,
+                  strav0::NegTPCNSigmaPr<strav0::NegTPCNSigmaPrStore>,
+                  strav0::NegTPCNSigmaPi<strav0::NegTPCNSigmaPiStore>);
+
 //Definition of labels for V0s
 namespace mcv0label
 {
@@ -29,6 +29,7 @@
 #include "Framework/runDataProcessing.h"
 #include "PWGLF/DataModel/LFResonanceTables.h"
 #include "PWGLF/Utils/collisionCuts.h"
+#include "PWGLF/Utils/resonanceMixing.h"
 #include "ReconstructionDataFormats/Track.h"
 
 using namespace o2;
@@ -41,10 +42,19 @@ struct reso2initializer {
 
   Produces<aod::ResoCollisions> resoCollisions;
   Produces<aod::ResoDaughters> reso2tracks;
+  Produces<aod::ResoMixingKeys> resoMixingKeys;
+  Produces<aod::ResoMixDaughters> resoMixDaughters;
 
   // Configurables
   Configurable<bool> ConfIsRun3{"ConfIsRun3", false, "Running on Pilot beam"}; // Choose if running on converted data or pilot beam
   Configurable<bool> ConfStoreV0{"ConfStoreV0", true, "True: store V0s"};
+  Configurable<bool> ConfStoreMixDaughters{"ConfStoreMixDaughters", true, "True: store the compact track daughters for the background estimation"};
+
+  /// Event mixing categories
+  ConfigurableAxis ConfMixVtxBins{"ConfMixVtxBins", {VARIABLE_WIDTH, -10.0f, -8.f, -6.f, -4.f, -2.f, 0.f, 2.f, 4.f, 6.f, 8.f, 10.f}, "Mixing bins - z-vertex"};
+  ConfigurableAxis ConfMixMultBins{"ConfMixMultBins", {VARIABLE_WIDTH, 0.0f, 20.0f, 40.0f, 60.0f, 80.0f, 100.0f, 200.0f, 99999.f}, "Mixing bins - multiplicity"};
+  std::vector<double> mixVtxEdges;
+  std::vector<double> mixMultEdges;
 
   /// Event cuts
   o2::analysis::CollisonCuts colCuts;
@@ -88,6 +98,19 @@ struct reso2initializer {
   {
     colCuts.setCuts(ConfEvtZvtx, ConfEvtTriggerCheck, ConfEvtTriggerSel, ConfEvtOfflineCheck, ConfIsRun3);
     colCuts.init(&qaRegistry);
+
+    auto getBinEdges = [](AxisSpec const& axis) {
+      if (!axis.nBins.has_value()) {
+        return axis.binEdges;
+      }
+      std::vector<double> edges;
+      for (int i = 0; i <= axis.nBins.value(); i++) {
+        edges.push_back(axis.binEdges[0] + i * (axis.binEdges[1] - axis.binEdges[0]) / axis.nBins.value());
+      }
+      return edges;
+    };
+    mixVtxEdges = getBinEdges(AxisSpec{ConfMixVtxBins});
+    mixMultEdges = getBinEdges(AxisSpec{ConfMixMultBins});
   }
 
   void process(const soa::Join<o2::aod::Collisions, o2::aod::EvSels, aod::Mults>::iterator& collision,
@@ -104,6 +127,7 @@ struct reso2initializer {
     } else {
       resoCollisions(collision.posX(), collision.posY(), collision.posZ(), collision.multFV0M(), colCuts.computeSphericity(collision, tracks), bc.timestamp());
     }
+    resoMixingKeys(o2::analysis::resonance::getMixingBin(mixVtxEdges, mixMultEdges, collision.posZ(), ConfIsRun3 ? collision.multFT0M() : collision.multFV0M()));
 
     int childIDs[2] = {0, 0}; // these IDs are necessary to keep track of the children
     // Loop over tracks
@@ -158,6 +182,17 @@ struct reso2initializer {
                   track.tofNSigmaPr(),
                   0, 0, 0,
                   0, 0, 0, 0);
+      if (ConfStoreMixDaughters) {
+        resoMixDaughters(resoCollisions.lastIndex(),
+                         track.px(),
+                         track.py(),
+                         track.pz(),
+                         track.sign(),
+                         track.dcaXY(),
+                         track.dcaZ(),
+                         tpcPIDselections,
+                         tofPIDselections);
+      }
     }
     /// V0s
     if (ConfStoreV0) {
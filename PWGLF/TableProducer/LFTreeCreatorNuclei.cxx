@@ -14,6 +14,8 @@
 /// \brief Writer of the nuclei candidates in the form of flat tables to be stored in TTrees.
 ///        Intended for debug or for the local optimization of analysis on small samples.
 ///        In this file are defined and filled the output tables
+///        With processSkimData only the (anti)deuteron, triton and helium-3 candidates of a TPC nsigma band
+///        are written, with binned columns, together with the number of candidates of each event
 ///
 /// \author Nicolò Jacazio <nicolo.jacazio@cern.ch> and Francesca Bellini <fbellini@cern.ch>
 ///
@@ -39,6 +41,7 @@
 #include <TObjArray.h>
 
 #include <cmath>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -49,11 +52,13 @@ struct LfTreeCreatorNuclei {
   Produces<o2::aod::LfCandNucleusFullEvents> tableEvents;
   Produces<o2::aod::LfCandNucleusFull> tableCandidate;
   Produces<o2::aod::LfCandNucleusMC> tableCandidateMC;
+  Produces<o2::aod::LfNuclSkimEvents> tableSkimEvents;
+  Produces<o2::aod::LfNuclSkimCands> tableSkimCandidates;
 
   void init(o2::framework::InitContext&)
   {
-    if (doprocessData == true && doprocessMC == true) {
-      LOGF(fatal, "Cannot enable processData and processMC at the same time. Please choose one.");
+    if (doprocessData + doprocessMC + doprocessSkimData > 1) {
+      LOGF(fatal, "Cannot enable more than one of processData, processMC and processSkimData at the same time. Please choose one.");
     }
   }
 
@@ -68,6 +73,9 @@ struct LfTreeCreatorNuclei {
   // events
   Configurable<float> cfgCutVertex{"cfgCutVertex", 10.0f, "Accepted z-vertex range"};
   Configurable<bool> useEvsel{"useEvsel", true, "Use sel8 for run3 Event Selection"};
+  // skim
+  Configurable<float> skimNsigmaTPCLow{"skimNsigmaTPCLow", -5.0, "Lower edge of the TPC nsigma band of the skimmed candidates"};
+  Configurable<float> skimNsigmaTPCHigh{"skimNsigmaTPCHigh", +5.0, "Upper edge of the TPC nsigma band of the skimmed candidates"};
 
   Filter collisionFilter = nabs(aod::collision::posZ) < cfgCutVertex;
   Filter trackFilter = (nabs(aod::track::eta) < cfgCutEta) && (requireGlobalTrackInFilter());
@@ -140,6 +148,83 @@ struct LfTreeCreatorNuclei {
     }
   }
 
+  // TPC nsigma of the tracks of one collision, for the band test of the skim
+  std::vector<float> nsigmaTPCDe;
+  std::vector<float> nsigmaTPCTr;
+  std::vector<float> nsigmaTPCHe;
+  std::vector<uint8_t> candidateMask;
+
+  template <typename TrackType, typename CollisionType>
+  void fillSkimForOneEvent(CollisionType const& collision, TrackType const& tracks)
+  {
+    using namespace o2::aod::nucleiskim;
+
+    // Band test in the TPC dE/dx vs p plane for all tracks of the collision, in a loop without branches
+    const auto nTracks = tracks.size();
+    nsigmaTPCDe.resize(nTracks);
+    nsigmaTPCTr.resize(nTracks);
+    nsigmaTPCHe.resize(nTracks);
+    candidateMask.resize(nTracks);
+    int iTrack = 0;
+    for (auto& track : tracks) {
+      nsigmaTPCDe[iTrack] = track.tpcNSigmaDe();
+      nsigmaTPCTr[iTrack] = track.tpcNSigmaTr();
+      nsigmaTPCHe[iTrack] = track.tpcNSigmaHe();
+      ++iTrack;
+    }
+    const float low = skimNsigmaTPCLow;
+    const float high = skimNsigmaTPCHigh;
+    uint16_t nDeuterons = 0, nTritons = 0, nHelium3 = 0;
+    for (int i = 0; i < nTracks; ++i) {
+      const uint8_t isDeuteron = (nsigmaTPCDe[i] > low) & (nsigmaTPCDe[i] < high);
+      const uint8_t isTriton = (nsigmaTPCTr[i] > low) & (nsigmaTPCTr[i] < high);
+      const uint8_t isHelium3 = (nsigmaTPCHe[i] > low) & (nsigmaTPCHe[i] < high);
+      candidateMask[i] = (isDeuteron << kDeuteron) | (isTriton << kTriton) | (isHelium3 << kHelium3);
+      nDeuterons += isDeuteron;
+      nTritons += isTriton;
+      nHelium3 += isHelium3;
+    }
+
+    // Filling event properties, also for the events without candidates
+    tableSkimEvents(collision.posZ(),
+                    collision.multFV0M(),
+                    collision.sel8(),
+                    collision.bc().runNumber(),
+                    nDeuterons, nTritons, nHelium3);
+
+    // Filling the binned properties of the candidates
+    iTrack = 0;
+    for (auto& track : tracks) {
+      const auto mask = candidateMask[iTrack++];
+      if (mask == 0) {
+        continue;
+      }
+      tableSkimCandidates(
+        tableSkimEvents.lastIndex(),
+        packBinned<binningMomentum>(track.pt()),
+        packBinned<binningAngle>(track.eta()),
+        packBinned<binningAngle>(track.phi()),
+        track.sign(),
+        packBinned<binningFine>(track.dcaXY()),
+        packBinned<binningFine>(track.dcaZ()),
+        packBinned<binningMomentum>(track.tpcInnerParam()),
+        packBinned<binningSignal>(track.tpcSignal()),
+        track.hasTOF(),
+        packBinned<binningFine>(track.beta()),
+        packBinned<binningNSigma>(track.tpcNSigmaDe()),
+        packBinned<binningNSigma>(track.tpcNSigmaTr()),
+        packBinned<binningNSigma>(track.tpcNSigmaHe()),
+        packBinned<binningNSigma>(track.tofNSigmaDe()),
+        packBinned<binningNSigma>(track.tofNSigmaTr()),
+        packBinned<binningNSigma>(track.tofNSigmaHe()),
+        track.tpcNClsCrossedRows(),
+        packBinned<binningFine>(track.tpcCrossedRowsOverFindableCls()),
+        packBinned<binningNSigma>(track.tpcChi2NCl()),
+        packBinned<binningNSigma>(track.itsChi2NCl()),
+        mask);
+    }
+  }
+
   Preslice<soa::Filtered<TrackCandidates>> perCollision = aod::track::collisionId;
 
   void processData(soa::Filtered<EventCandidates> const& collisions,
@@ -170,6 +255,27 @@ struct LfTreeCreatorNuclei {
   }
 
   PROCESS_SWITCH(LfTreeCreatorNuclei, processMC, "process MC", false);
+
+  using SkimTrackCandidates = soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksDCA, aod::TrackSelection,
+                                        aod::pidTOFbeta,
+                                        aod::pidTPCFullDe, aod::pidTOFFullDe,
+                                        aod::pidTPCFullTr, aod::pidTOFFullTr,
+                                        aod::pidTPCFullHe, aod::pidTOFFullHe>;
+  Preslice<soa::Filtered<SkimTrackCandidates>> perCollisionSkim = aod::track::collisionId;
+
+  void processSkimData(soa::Filtered<EventCandidates> const& collisions,
+                       soa::Filtered<SkimTrackCandidates> const& tracks, aod::BCs const&)
+  {
+    for (const auto& collision : collisions) {
+      if (useEvsel && !collision.sel8()) {
+        continue;
+      }
+      const auto& tracksInCollision = tracks.sliceBy(perCollisionSkim, collision.globalIndex());
+      fillSkimForOneEvent(collision, tracksInCollision);
+    }
+  }
+
+  PROCESS_SWITCH(LfTreeCreatorNuclei, processSkimData, "process Data into the compact nuclei skim", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
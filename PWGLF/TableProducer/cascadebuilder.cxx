@@ -39,13 +39,13 @@
 #include "ReconstructionDataFormats/Track.h"
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/DCAFitterCache.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
-#include "DataFormatsParameters/GRPObject.h"
-#include "DataFormatsParameters/GRPMagField.h"
+#include "Common/Core/RunConditionsCache.h"
 #include <CCDB/BasicCCDBManager.h>
 
 #include <TFile.h>
@@ -58,6 +58,7 @@
 #include <cmath>
 #include <array>
 #include <cstdlib>
+#include <type_traits>
 #include "Framework/ASoAHelpers.h"
 
 using namespace o2;
@@ -100,87 +101,66 @@ struct cascadeBuilder {
   Configurable<std::string> lutPath{"lutPath", "GLO/Param/MatLUT", "Path of the Lut parametrization"};
   Configurable<std::string> geoPath{"geoPath", "GLO/Config/GeometryAligned", "Path of the geometry file"};
 
-  int mRunNumber;
   float d_bz;
   float maxSnp;  // max sine phi for propagation
   float maxStep; // max step size (cm) for propagation
-  o2::base::MatLayerCylSet* lut = nullptr;
+  o2::analysis::RunConditionsCache runConditions;
+  o2::analysis::DCAFitterCache<2> fitterV0Cache;   // V0 fitter, updated only when the magnetic field changes
+  o2::analysis::DCAFitterCache<2> fitterCascCache; // cascade fitter, updated only when the magnetic field changes
 
   void init(InitContext& context)
   {
 
     // using namespace analysis::lambdakzerobuilder;
-    mRunNumber = 0;
     d_bz = 0;
     maxSnp = 0.85f;  // could be changed later
     maxStep = 2.00f; // could be changed later
 
+    // Define o2 fitters, 2-prong
+    o2::analysis::DCAFitterSettings fitterSettings;
+    fitterSettings.maxChi2 = 1e9;
+    fitterSettings.useAbsDCA = d_UseAbsDCA;
+    fitterV0Cache.configure(fitterSettings);
+    fitterCascCache.configure(fitterSettings);
+
     ccdb->setURL(ccdburl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
     ccdb->setFatalWhenNull(false);
 
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(lutPath));
-
-    if (!o2::base::GeometryManager::isGeometryLoaded()) {
-      ccdb->get<TGeoManager>(geoPath);
-    }
+    o2::analysis::RunConditionsSettings settings;
+    settings.grpPath = grpPath;
+    settings.grpmagPath = grpmagPath;
+    settings.lutPath = lutPath;
+    settings.geoPath = geoPath;
+    runConditions.init(&(*ccdb), settings);
+    runConditions.setRunChangeCallback([this](o2::analysis::RunConditions const& conditions) {
+      // magnetic field from the GRP object, or from the GRPMagField if there is none, unless given
+      d_bz = (d_bz_input < -990) ? conditions.bz : d_bz_input;
+    });
   }
 
   void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
   {
-    if (mRunNumber == bc.runNumber()) {
-      return;
-    }
-    auto run3grp_timestamp = bc.timestamp();
-
-    o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(grpPath, run3grp_timestamp);
-    o2::parameters::GRPMagField* grpmag = 0x0;
-    if (!grpo) {
-      grpmag = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(grpmagPath, run3grp_timestamp);
-      if (!grpmag) {
-        LOG(fatal) << "Got nullptr from CCDB for path " << grpmagPath << " of object GRPMagField and " << grpPath << " of object GRPObject for timestamp " << run3grp_timestamp;
-      }
-    }
-    if (grpo) {
-      o2::base::Propagator::initFieldFromGRP(grpo);
-      if (d_bz_input < -990) {
-        // Fetch magnetic field from ccdb for current collision
-        d_bz = grpo->getNominalL3Field();
-        LOG(info) << "Retrieved GRP for timestamp " << run3grp_timestamp << " with magnetic field of " << d_bz << " kZG";
-      } else {
-        d_bz = d_bz_input;
-      }
-    } else {
-      o2::base::Propagator::initFieldFromGRP(grpmag);
-    }
-    o2::base::Propagator::Instance()->setMatLUT(lut);
-    mRunNumber = bc.runNumber();
+    runConditions.update(bc);
   }
 
-  template <class TCascTracksTo>
-  void buildCascadeTable(aod::Collision const& collision, aod::V0Datas const& v0data, aod::Cascades const& cascades, Bool_t lRun3 = kTRUE)
+  /// Builds the cascade table
+  /// \param v0covs V0 covariance table joinable with V0Datas; if given, the V0 vertex, momenta and covariance
+  ///        are taken from the V0 builder output and only the bachelor-V0 fit is performed
+  template <class TCascTracksTo, typename TV0Covs = std::nullptr_t>
+  void buildCascadeTable(aod::Collision const& collision, aod::V0Datas const& v0data, aod::Cascades const& cascades, Bool_t lRun3 = kTRUE, TV0Covs const& v0covs = nullptr)
   {
+    constexpr bool useV0Covs = !std::is_same_v<TV0Covs, std::nullptr_t>;
+    if constexpr (useV0Covs) {
+      if (v0covs.size() != v0data.size()) {
+        LOG(fatal) << "V0Covs (" << v0covs.size() << " rows) is not joinable with V0Datas (" << v0data.size() << " rows): enable createV0CovMats in lambdakzero-builder";
+      }
+    }
 
-    // Define o2 fitter, 2-prong
-    o2::vertexing::DCAFitterN<2> fitterV0, fitterCasc;
-    fitterV0.setBz(d_bz);
-    fitterV0.setPropagateToPCA(true);
-    fitterV0.setMaxR(200.);
-    fitterV0.setMinParamChange(1e-3);
-    fitterV0.setMinRelChi2Change(0.9);
-    fitterV0.setMaxDZIni(1e9);
-    fitterV0.setMaxChi2(1e9);
-    fitterV0.setUseAbsDCA(d_UseAbsDCA);
-
-    fitterCasc.setBz(d_bz);
-    fitterCasc.setPropagateToPCA(true);
-    fitterCasc.setMaxR(200.);
-    fitterCasc.setMinParamChange(1e-3);
-    fitterCasc.setMinRelChi2Change(0.9);
-    fitterCasc.setMaxDZIni(1e9);
-    fitterCasc.setMaxChi2(1e9);
-    fitterCasc.setUseAbsDCA(d_UseAbsDCA);
+    // o2 fitters, 2-prong, configured in init
+    auto& fitterV0 = fitterV0Cache.get(d_bz);
+    auto& fitterCasc = fitterCascCache.get(d_bz);
 
     for (auto& casc : cascades) {
       auto v0 = casc.v0_as<o2::aod::V0sLinked>();
@@ -286,37 +266,55 @@ struct cascadeBuilder {
         charge = +1;
       }
 
-      int nCand = fitterV0.process(pTrack, nTrack);
-      if (nCand != 0) {
-        fitterV0.propagateTracksToVertex();
-        const auto& v0vtx = fitterV0.getPCACandidate();
-        for (int i = 0; i < 3; i++) {
-          pos[i] = v0vtx[i];
+      std::array<float, 21> covV0 = {0};
+      const int momInd[6] = {9, 13, 14, 18, 19, 20}; // cov matrix elements for momentum component
+      float dcaV0Daughters = 0.;
+      int nCand = 0;
+      if constexpr (useV0Covs) {
+        // V0 already fitted by the V0 builder: take vertex, momenta and covariance from its output
+        auto v0cov = v0covs.iteratorAt(v0data.globalIndex());
+        pos = {v0data.x(), v0data.y(), v0data.z()};
+        pvecpos = {v0data.pxpos(), v0data.pypos(), v0data.pzpos()};
+        pvecneg = {v0data.pxneg(), v0data.pyneg(), v0data.pzneg()};
+        for (int i = 0; i < 6; i++) {
+          covV0[i] = v0cov.positionCovMat()[i];
+          covV0[momInd[i]] = v0cov.momentumCovMat()[i];
         }
+        dcaV0Daughters = v0data.dcaV0daughters();
+        nCand = 1;
+      } else {
+        nCand = fitterV0.process(pTrack, nTrack);
+        if (nCand != 0) {
+          fitterV0.propagateTracksToVertex();
+          const auto& v0vtx = fitterV0.getPCACandidate();
+          for (int i = 0; i < 3; i++) {
+            pos[i] = v0vtx[i];
+          }
 
-        std::array<float, 21> cov0 = {0};
-        std::array<float, 21> cov1 = {0};
-        std::array<float, 21> covV0 = {0};
-
-        // Covariance matrix calculation
-        const int momInd[6] = {9, 13, 14, 18, 19, 20}; // cov matrix elements for momentum component
-        fitterV0.getTrack(0).getPxPyPzGlo(pvecpos);
-        fitterV0.getTrack(1).getPxPyPzGlo(pvecneg);
-        fitterV0.getTrack(0).getCovXYZPxPyPzGlo(cov0);
-        fitterV0.getTrack(1).getCovXYZPxPyPzGlo(cov1);
-        for (int i = 0; i < 6; i++) {
-          int j = momInd[i];
-          covV0[j] = cov0[j] + cov1[j];
+          std::array<float, 21> cov0 = {0};
+          std::array<float, 21> cov1 = {0};
+
+          // Covariance matrix calculation
+          fitterV0.getTrack(0).getPxPyPzGlo(pvecpos);
+          fitterV0.getTrack(1).getPxPyPzGlo(pvecneg);
+          fitterV0.getTrack(0).getCovXYZPxPyPzGlo(cov0);
+          fitterV0.getTrack(1).getCovXYZPxPyPzGlo(cov1);
+          for (int i = 0; i < 6; i++) {
+            int j = momInd[i];
+            covV0[j] = cov0[j] + cov1[j];
+          }
+          auto covVtxV0 = fitterV0.calcPCACovMatrix();
+          covV0[0] = covVtxV0(0, 0);
+          covV0[1] = covVtxV0(1, 0);
+          covV0[2] = covVtxV0(1, 1);
+          covV0[3] = covVtxV0(2, 0);
+          covV0[4] = covVtxV0(2, 1);
+          covV0[5] = covVtxV0(2, 2);
+          dcaV0Daughters = fitterV0.getChi2AtPCACandidate();
         }
-        auto covVtxV0 = fitterV0.calcPCACovMatrix();
-        covV0[0] = covVtxV0(0, 0);
-        covV0[1] = covVtxV0(1, 0);
-        covV0[2] = covVtxV0(1, 1);
-        covV0[3] = covVtxV0(2, 0);
-        covV0[4] = covVtxV0(2, 1);
-        covV0[5] = covVtxV0(2, 2);
-
-        const std::array<float, 3> vertex = {(float)v0vtx[0], (float)v0vtx[1], (float)v0vtx[2]};
+      }
+      if (nCand != 0) {
+        const std::array<float, 3> vertex = {pos[0], pos[1], pos[2]};
         const std::array<float, 3> momentum = {pvecpos[0] + pvecneg[0], pvecpos[1] + pvecneg[1], pvecpos[2] + pvecneg[2]};
 
         auto tV0 = o2::track::TrackParCov(vertex, momentum, covV0, 0);
@@ -351,7 +349,7 @@ struct cascadeBuilder {
         pvecpos[0], pvecpos[1], pvecpos[2],
         pvecneg[0], pvecneg[1], pvecneg[2],
         pvecbach[0], pvecbach[1], pvecbach[2],
-        fitterV0.getChi2AtPCACandidate(), fitterCasc.getChi2AtPCACandidate(),
+        dcaV0Daughters, fitterCasc.getChi2AtPCACandidate(),
         posTrackCast.dcaXY(),
         negTrackCast.dcaXY(),
         bachTrackCast.dcaXY());
@@ -383,6 +381,32 @@ struct cascadeBuilder {
     buildCascadeTable<FullTracksExtIU>(collision, v0data, cascades, kTRUE);
   }
   PROCESS_SWITCH(cascadeBuilder, processRun3, "Produce Run 3 cascade tables", false);
+
+  void processRun2FromV0Covs(aod::Collision const& collision, aod::V0sLinked const&, aod::V0Datas const& v0data, aod::V0Covs const& v0covs, aod::Cascades const& cascades, FullTracksExt const&, aod::BCsWithTimestamps const&)
+  {
+    hEventCounter->Fill(0.5);
+
+    // check previous run number, update if necessary
+    auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+    initCCDB(bc);
+
+    // do cascades reusing the V0 fit of the V0 builder, typecase correctly into tracks
+    buildCascadeTable<FullTracksExt>(collision, v0data, cascades, kFALSE, v0covs);
+  }
+  PROCESS_SWITCH(cascadeBuilder, processRun2FromV0Covs, "Produce Run 2 cascade tables reusing the V0 fit (requires V0Covs)", false);
+
+  void processRun3FromV0Covs(aod::Collision const& collision, aod::V0sLinked const&, aod::V0Datas const& v0data, aod::V0Covs const& v0covs, aod::Cascades const& cascades, FullTracksExtIU const&, aod::BCsWithTimestamps const&)
+  {
+    hEventCounter->Fill(0.5);
+
+    // check previous run number, update if necessary
+    auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+    initCCDB(bc);
+
+    // do cascades reusing the V0 fit of the V0 builder, typecase correctly into tracksIU (Run 3 use case)
+    buildCascadeTable<FullTracksExtIU>(collision, v0data, cascades, kTRUE, v0covs);
+  }
+  PROCESS_SWITCH(cascadeBuilder, processRun3FromV0Covs, "Produce Run 3 cascade tables reusing the V0 fit (requires V0Covs)", false);
 };
 
 struct cascadeLabelBuilder {
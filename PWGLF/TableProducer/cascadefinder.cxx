@@ -55,6 +55,9 @@
 #include <cmath>
 #include <array>
 #include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -176,6 +179,86 @@ struct cascadefinder {
   Configurable<float> dcav0dau{"dcacascdau", 1.0, "DCA Casc Daughters"};
   Configurable<float> v0radius{"cascradius", 1.0, "cascradius"};
 
+  // Geometric pruning of the V0-bachelor combinations
+  Configurable<bool> usePhiBinning{"usePhiBinning", false, "Only fit bachelors with an azimuth compatible with the V0 decay position"};
+  Configurable<int> nPhiBins{"nPhiBins", 36, "Number of azimuthal bins of the bachelor lists"};
+  Configurable<float> maxDeltaPhiBach{"maxDeltaPhiBach", 0.8, "Max |phi(bachelor) - phi(V0 decay position)| w.r.t. the PV"};
+
+  /// Bachelor track prepared once per collision for the combination with all V0s
+  struct Bachelor {
+    o2::track::TrackParCov track;
+    float phi;
+    float pt;
+    float dcaXY;
+  };
+  std::vector<Bachelor> negBachelors;
+  std::vector<Bachelor> posBachelors;
+  std::vector<int> negBinOffsets;
+  std::vector<int> posBinOffsets;
+  std::vector<int> selectedBachelors;
+
+  int getPhiBin(float phi) const
+  {
+    return std::min(static_cast<int>(RecoDecay::constrainAngle(phi) / o2::constants::math::TwoPI * nPhiBins), nPhiBins - 1);
+  }
+
+  /// Fills the list of bachelors of one charge.
+  /// With the azimuthal binning on, the bachelors are sorted by azimuthal bin, then by decreasing pT and DCA to the PV,
+  /// and binOffsets holds the position of the first bachelor of each bin.
+  template <typename TBachelors, typename TGetTrack>
+  void fillBachelors(TBachelors const& bachelorIds, TGetTrack getTrack, std::vector<Bachelor>& bachelors, std::vector<int>& binOffsets)
+  {
+    bachelors.clear();
+    for (auto& t0id : bachelorIds) {
+      auto t0 = getTrack(t0id);
+      bachelors.push_back({getTrackParCov(t0), t0.phi(), t0.pt(), t0id.dcaXY()});
+    }
+    if (!usePhiBinning) {
+      return;
+    }
+    std::sort(bachelors.begin(), bachelors.end(), [this](Bachelor const& a, Bachelor const& b) {
+      int binA = getPhiBin(a.phi), binB = getPhiBin(b.phi);
+      if (binA != binB) {
+        return binA < binB;
+      }
+      if (a.pt != b.pt) {
+        return a.pt > b.pt;
+      }
+      return a.dcaXY > b.dcaXY;
+    });
+    binOffsets.assign(nPhiBins + 1, 0);
+    for (auto const& bachelor : bachelors) {
+      binOffsets[getPhiBin(bachelor.phi) + 1]++;
+    }
+    std::partial_sum(binOffsets.begin(), binOffsets.end(), binOffsets.begin());
+  }
+
+  /// Selects the bachelors to be fitted with a V0.
+  /// \param bachelors  bachelors of the charge of the cascade
+  /// \param binOffsets  positions of the first bachelor of each azimuthal bin
+  /// \param phiV0  azimuth of the V0 decay position w.r.t. the PV
+  void selectBachelors(std::vector<Bachelor> const& bachelors, std::vector<int> const& binOffsets, float phiV0)
+  {
+    selectedBachelors.clear();
+    if (!usePhiBinning) {
+      selectedBachelors.resize(bachelors.size());
+      std::iota(selectedBachelors.begin(), selectedBachelors.end(), 0);
+      return;
+    }
+    // scan the bins within maxDeltaPhiBach, all bins at most once
+    int binV0 = getPhiBin(phiV0);
+    int nBinsHalf = static_cast<int>(std::ceil(maxDeltaPhiBach / (o2::constants::math::TwoPI / nPhiBins)));
+    int nBinsScan = std::min(2 * nBinsHalf + 1, nPhiBins.value);
+    for (int iBin = 0; iBin < nBinsScan; iBin++) {
+      int bin = ((binV0 - nBinsHalf + iBin) % nPhiBins + nPhiBins) % nPhiBins;
+      for (int i = binOffsets[bin]; i < binOffsets[bin + 1]; i++) {
+        if (std::abs(RecoDecay::constrainAngle(bachelors[i].phi - phiV0, -o2::constants::math::PI)) < maxDeltaPhiBach) {
+          selectedBachelors.push_back(i);
+        }
+      }
+    }
+  }
+
   // Process: subscribes to a lot of things!
   void process(aod::Collision const& collision,
                soa::Join<aod::FullTracks, aod::TracksCov> const& tracks,
@@ -207,6 +290,12 @@ struct cascadefinder {
 
     Long_t lNCand = 0;
 
+    // bachelor tracks propagated once per collision, not once per V0
+    fillBachelors(
+      nBachtracks, [](auto const& t0id) { return t0id.template goodNegTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>(); }, negBachelors, negBinOffsets);
+    fillBachelors(
+      pBachtracks, [](auto const& t0id) { return t0id.template goodPosTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>(); }, posBachelors, posBinOffsets);
+
     std::array<float, 3> pos = {0.};
     std::array<float, 3> posXi = {0.};
     std::array<float, 3> pvecpos = {0.};
@@ -256,11 +345,11 @@ struct cascadefinder {
         auto tV0 = o2::track::TrackParCov(vertex, momentum, covV0, 0);
         tV0.setQ2Pt(0); // No bending, please
 
-        for (auto& t0id : nBachtracks) {
-          auto t0 = t0id.goodNegTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>();
-          auto bTrack = getTrackParCov(t0);
+        selectBachelors(negBachelors, negBinOffsets, std::atan2(pos[1] - collision.posY(), pos[0] - collision.posX()));
+        for (auto iBach : selectedBachelors) {
+          auto const& bachelor = negBachelors[iBach];
 
-          int nCand2 = fitterCasc.process(tV0, bTrack);
+          int nCand2 = fitterCasc.process(tV0, bachelor.track);
           if (nCand2 != 0) {
             fitterCasc.propagateTracksToVertex();
             const auto& cascvtx = fitterCasc.getPCACandidate();
@@ -279,7 +368,7 @@ struct cascadefinder {
                      fitterV0.getChi2AtPCACandidate(), fitterCasc.getChi2AtPCACandidate(),
                      v0.dcapostopv(),
                      v0.dcanegtopv(),
-                     t0id.dcaXY());
+                     bachelor.dcaXY);
           } // end if cascade recoed
         }   // end loop over bachelor
       }     // end if v0 recoed
@@ -328,11 +417,11 @@ struct cascadefinder {
         auto tV0 = o2::track::TrackParCov(vertex, momentum, covV0, 0);
         tV0.setQ2Pt(0); // No bending, please
 
-        for (auto& t0id : pBachtracks) {
-          auto t0 = t0id.goodPosTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>();
-          auto bTrack = getTrackParCov(t0);
+        selectBachelors(posBachelors, posBinOffsets, std::atan2(pos[1] - collision.posY(), pos[0] - collision.posX()));
+        for (auto iBach : selectedBachelors) {
+          auto const& bachelor = posBachelors[iBach];
 
-          int nCand2 = fitterCasc.process(tV0, bTrack);
+          int nCand2 = fitterCasc.process(tV0, bachelor.track);
           if (nCand2 != 0) {
             fitterCasc.propagateTracksToVertex();
             const auto& cascvtx = fitterCasc.getPCACandidate();
@@ -351,7 +440,7 @@ struct cascadefinder {
                      fitterV0.getChi2AtPCACandidate(), fitterCasc.getChi2AtPCACandidate(),
                      v0.dcapostopv(),
                      v0.dcanegtopv(),
-                     t0id.dcaXY());
+                     bachelor.dcaXY);
           } // end if cascade recoed
         }   // end loop over bachelor
       }     // end if v0 recoed
@@ -39,13 +39,13 @@
 #include "ReconstructionDataFormats/Track.h"
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/DCAFitterCache.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
-#include "DataFormatsParameters/GRPObject.h"
-#include "DataFormatsParameters/GRPMagField.h"
+#include "Common/Core/RunConditionsCache.h"
 #include <CCDB/BasicCCDBManager.h>
 
 #include <TFile.h>
@@ -100,11 +100,11 @@ struct lambdakzeroBuilder {
   Configurable<int> mincrossedrows{"mincrossedrows", 70, "min crossed rows"};
   Configurable<int> isRun2{"isRun2", 0, "if Run2: demand TPC refit"};
 
-  int mRunNumber;
   float d_bz;
   float maxSnp;  // max sine phi for propagation
   float maxStep; // max step size (cm) for propagation
-  o2::base::MatLayerCylSet* lut = nullptr;
+  o2::analysis::RunConditionsCache runConditions;
+  o2::analysis::DCAFitterCache<2> fitterCache; // 2-prong fitter, updated only when the magnetic field changes
 
   // for debugging
 #ifdef MY_DEBUG
@@ -114,6 +114,7 @@ struct lambdakzeroBuilder {
 
   Produces<aod::StoredV0Datas> v0data;
   Produces<aod::V0DataLink> v0dataLink;
+  Produces<aod::V0Covs> v0covs; // optionally produced, joinable with V0Datas
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
   HistogramRegistry registry{
@@ -132,7 +133,12 @@ struct lambdakzeroBuilder {
   Configurable<double> v0cospa{"v0cospa", 0.995, "V0 CosPA"}; // double -> N.B. dcos(x)/dx = 0 at x=0)
   Configurable<float> dcav0dau{"dcav0dau", 1.0, "DCA V0 Daughters"};
   Configurable<float> v0radius{"v0radius", 5.0, "v0radius"};
+  Configurable<bool> useHelixPreselection{"useHelixPreselection", false, "apply the selections on the helix crossing estimate of the V0 vertex before the fitter minimization"};
+  Configurable<float> dcav0dauTolerance{"dcav0dauTolerance", 0.5, "DCA V0 daughters tolerance (cm) of the helix crossing preselection"};
+  Configurable<double> v0cospaTolerance{"v0cospaTolerance", 0.05, "V0 CosPA tolerance of the helix crossing preselection"};
+  Configurable<float> v0radiusTolerance{"v0radiusTolerance", 1.0, "v0radius tolerance (cm) of the helix crossing preselection"};
   Configurable<int> useMatCorrType{"useMatCorrType", 0, "0: none, 1: TGeo, 2: LUT"};
+  Configurable<bool> createV0CovMats{"createV0CovMats", false, "fill the V0Covs table with the V0 vertex and momentum covariance (needed by the cascade builder to reuse the V0 fit)"};
   Configurable<int> rejDiffCollTracks{"rejDiffCollTracks", 0, "rejDiffCollTracks"};
   Configurable<std::string> ccdburl{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> grpPath{"grpPath", "GLO/GRP/GRP", "Path of the grp file"};
@@ -149,20 +155,31 @@ struct lambdakzeroBuilder {
   void init(InitContext& context)
   {
     // using namespace analysis::lambdakzerobuilder;
-    mRunNumber = 0;
     d_bz = 0;
     maxSnp = 0.85f;  // could be changed later
     maxStep = 2.00f; // could be changed later
 
+    // Define o2 fitter, 2-prong
+    o2::analysis::DCAFitterSettings fitterSettings;
+    fitterSettings.maxChi2 = 1e9;
+    fitterSettings.useAbsDCA = true; // use d_UseAbsDCA once we want to use the weighted DCA
+    fitterCache.configure(fitterSettings);
+
     ccdb->setURL(ccdburl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
     ccdb->setFatalWhenNull(false);
 
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(lutPath));
-    if (!o2::base::GeometryManager::isGeometryLoaded()) {
-      ccdb->get<TGeoManager>(geoPath);
-    }
+    o2::analysis::RunConditionsSettings settings;
+    settings.grpPath = grpPath;
+    settings.grpmagPath = grpmagPath;
+    settings.lutPath = lutPath;
+    settings.geoPath = geoPath;
+    runConditions.init(&(*ccdb), settings);
+    runConditions.setRunChangeCallback([this](o2::analysis::RunConditions const& conditions) {
+      // magnetic field from the GRP object, or from the GRPMagField if there is none, unless given
+      d_bz = (d_bz_input < -990) ? conditions.bz : d_bz_input;
+    });
 
     if (doprocessRun3 && doprocessRun2) {
       LOGF(fatal, "processRun3 and processRun2 are both set to true; try again with only one of them set to true");
@@ -173,48 +190,40 @@ struct lambdakzeroBuilder {
   }
   void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
   {
-    if (mRunNumber == bc.runNumber()) {
-      return;
+    runConditions.update(bc);
+  }
+
+  /// Checks the V0 selections, loosened by the tolerances, on the helix crossing estimate of the decay vertex
+  /// \param pTrack is the positive daughter track
+  /// \param nTrack is the negative daughter track
+  /// \param collision is the collision
+  /// \return false if the V0 can be rejected before the fitter minimization
+  template <typename TTrackPar>
+  bool isV0HelixPreselected(TTrackPar const& pTrack, TTrackPar const& nTrack, aod::Collision const& collision)
+  {
+    std::array<float, 3> pos = {0.};
+    std::array<float, 3> pvec0 = {0.};
+    std::array<float, 3> pvec1 = {0.};
+    auto dcaV0Dau = getHelixClosestApproach(getTrackHelixXY(pTrack, d_bz), getTrackHelixXY(nTrack, d_bz), pos, pvec0, pvec1);
+    if (dcaV0Dau < 0.f) {
+      return true; // no estimate possible, leave the decision to the fitter
     }
-    auto run3grp_timestamp = bc.timestamp();
-
-    o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(grpPath, run3grp_timestamp);
-    o2::parameters::GRPMagField* grpmag = 0x0;
-    if (!grpo) {
-      grpmag = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(grpmagPath, run3grp_timestamp);
-      if (!grpmag) {
-        LOG(fatal) << "Got nullptr from CCDB for path " << grpmagPath << " of object GRPMagField and " << grpPath << " of object GRPObject for timestamp " << run3grp_timestamp;
-      }
+    // dcav0dau is applied on the fitter chi2, i.e. on the sum of the squared distances of the daughters from the PCA
+    if (dcaV0Dau > std::sqrt(2.f * dcav0dau) + dcav0dauTolerance) {
+      return false;
     }
-    if (grpo) {
-      o2::base::Propagator::initFieldFromGRP(grpo);
-      if (d_bz_input < -990) {
-        // Fetch magnetic field from ccdb for current collision
-        d_bz = grpo->getNominalL3Field();
-        LOG(info) << "Retrieved GRP for timestamp " << run3grp_timestamp << " with magnetic field of " << d_bz << " kZG";
-      } else {
-        d_bz = d_bz_input;
-      }
-    } else {
-      o2::base::Propagator::initFieldFromGRP(grpmag);
+    if (RecoDecay::sqrtSumOfSquares(pos[0], pos[1]) < v0radius - v0radiusTolerance) {
+      return false;
     }
-    o2::base::Propagator::Instance()->setMatLUT(lut);
-    mRunNumber = bc.runNumber();
+    auto V0CosinePA = RecoDecay::cpa(array{collision.posX(), collision.posY(), collision.posZ()}, pos, array{pvec0[0] + pvec1[0], pvec0[1] + pvec1[1], pvec0[2] + pvec1[2]});
+    return V0CosinePA >= v0cospa - v0cospaTolerance;
   }
 
   template <class TCascTracksTo>
   void buildLambdaKZeroTable(aod::Collision const& collision, aod::V0s const& V0s, Bool_t lRun3 = kTRUE)
   {
-    // Define o2 fitter, 2-prong
-    o2::vertexing::DCAFitterN<2> fitter;
-    fitter.setBz(d_bz);
-    fitter.setPropagateToPCA(true);
-    fitter.setMaxR(200.);
-    fitter.setMinParamChange(1e-3);
-    fitter.setMinRelChi2Change(0.9);
-    fitter.setMaxDZIni(1e9);
-    fitter.setMaxChi2(1e9);
-    fitter.setUseAbsDCA(true); // use d_UseAbsDCA once we want to use the weighted DCA
+    // o2 fitter, 2-prong, configured in init
+    auto& fitter = fitterCache.get(d_bz);
 
     registry.fill(HIST("hEventCounter"), 0.5);
 
@@ -298,6 +307,12 @@ struct lambdakzeroBuilder {
       // passes diff coll check
       registry.fill(HIST("hV0Criteria"), 4.5);
 
+      // Fast rejection on the helix crossing estimate of the V0 vertex
+      if (useHelixPreselection && !isV0HelixPreselected(pTrack, nTrack, collision)) {
+        v0dataLink(-1);
+        continue;
+      }
+
       // Act on copies for minimization
       auto pTrackCopy = o2::track::TrackParCov(pTrack);
       auto nTrackCopy = o2::track::TrackParCov(nTrack);
@@ -394,6 +409,28 @@ struct lambdakzeroBuilder {
         posTrackCast.dcaXY(),
         negTrackCast.dcaXY());
       v0dataLink(v0data.lastIndex());
+
+      if (createV0CovMats) {
+        // Covariance matrix calculation, same convention as in the cascade builder
+        std::array<float, 21> cov0 = {0};
+        std::array<float, 21> cov1 = {0};
+        float positionCovMat[6] = {0.};
+        float momentumCovMat[6] = {0.};
+        const int momInd[6] = {9, 13, 14, 18, 19, 20}; // cov matrix elements for momentum component
+        fitter.getTrack(0).getCovXYZPxPyPzGlo(cov0);
+        fitter.getTrack(1).getCovXYZPxPyPzGlo(cov1);
+        for (int i = 0; i < 6; i++) {
+          momentumCovMat[i] = cov0[momInd[i]] + cov1[momInd[i]];
+        }
+        auto covVtxV0 = fitter.calcPCACovMatrix();
+        positionCovMat[0] = covVtxV0(0, 0);
+        positionCovMat[1] = covVtxV0(1, 0);
+        positionCovMat[2] = covVtxV0(1, 1);
+        positionCovMat[3] = covVtxV0(2, 0);
+        positionCovMat[4] = covVtxV0(2, 1);
+        positionCovMat[5] = covVtxV0(2, 2);
+        v0covs(positionCovMat, momentumCovMat);
+      }
     }
   }
 
@@ -0,0 +1,171 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Strangeness derived data builder
+// ================================
+//
+// This code loops over the V0Data table and writes the compact
+// derived data of the strangeness analyses:
+//  - StraCollisions: PV position, centrality and event selection
+//  - StraV0s: binned kinematics and topology plus a selection mask
+//  - StraV0PIDs: binned TPC nsigma of the daughters
+//
+// The selection mask is evaluated once here, so that the analyses
+// running on the derived data do not need the AO2D track tables.
+// Only V0s passing the (loose) preselection below are stored.
+//
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Common/Core/RecoDecay.h"
+#include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "Common/DataModel/EventSelection.h"
+#include "Common/DataModel/Centrality.h"
+#include "Common/DataModel/PIDResponse.h"
+
+#include <TPDGCode.h>
+#include <cmath>
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::framework::expressions;
+using namespace o2::aod::stradata;
+
+using DaughterTracks = soa::Join<aod::Tracks, aod::pidTPCPi, aod::pidTPCPr>;
+
+struct strangederivedbuilder {
+  Produces<aod::StraCollisions> straCollisions;
+  Produces<aod::StraV0s> straV0s;
+  Produces<aod::StraV0PIDs> straV0PIDs;
+
+  // Preselection of the stored V0s
+  Configurable<float> dcav0dauMax{"dcav0dauMax", 1.5, "Max DCA V0 Daughters of the stored V0s"};
+  Configurable<float> dcanegtopvMin{"dcanegtopvMin", .05, "Min DCA Neg To PV of the stored V0s"};
+  Configurable<float> dcapostopvMin{"dcapostopvMin", .05, "Min DCA Pos To PV of the stored V0s"};
+  Configurable<double> v0cospaMin{"v0cospaMin", 0.97, "Min V0 CosPA of the stored V0s"};
+  Configurable<float> v0radiusMin{"v0radiusMin", 0.5, "Min v0radius of the stored V0s"};
+
+  // Cuts of the selection mask, same meaning as in lambdakzeroanalysis
+  Configurable<double> v0cospa{"v0cospa", 0.995, "V0 CosPA"}; // double -> N.B. dcos(x)/dx = 0 at x=0)
+  Configurable<float> dcav0dau{"dcav0dau", 1.0, "DCA V0 Daughters"};
+  Configurable<float> dcanegtopv{"dcanegtopv", .1, "DCA Neg To PV"};
+  Configurable<float> dcapostopv{"dcapostopv", .1, "DCA Pos To PV"};
+  Configurable<float> v0radius{"v0radius", 5.0, "v0radius"};
+  Configurable<float> rapidity{"rapidity", 0.5, "rapidity"};
+  Configurable<float> TpcPidNsigmaCut{"TpcPidNsigmaCut", 5, "TpcPidNsigmaCut"};
+  Configurable<float> paramArmenterosCut{"paramArmenterosCut", 0.2, "parameter Armenteros Cut"};
+  static constexpr float defaultLifetimeCuts[1][2] = {{25., 20.}};
+  Configurable<LabeledArray<float>> lifetimecut{"lifetimecut", {defaultLifetimeCuts[0], 2, {"lifetimecutLambda", "lifetimecutK0S"}}, "lifetimecut"};
+
+  Filter preFilterV0 = nabs(aod::v0data::dcapostopv) > dcapostopvMin&& nabs(aod::v0data::dcanegtopv) > dcanegtopvMin&& aod::v0data::dcaV0daughters < dcav0dauMax;
+
+  void init(InitContext const&)
+  {
+    if (doprocessRun3 == doprocessRun2) {
+      LOGF(fatal, "Exactly one of processRun3 and processRun2 must be enabled");
+    }
+  }
+
+  /// Writes the derived data of one collision.
+  /// \param collision  collision with the PV position
+  /// \param centrality  centrality percentile, -1 if not available
+  /// \param isEventSelected  event selection decision
+  /// \param v0s  V0s of the collision
+  template <typename TCollision, typename TV0s>
+  void fillDerivedData(TCollision const& collision, float centrality, bool isEventSelected, TV0s const& v0s)
+  {
+    straCollisions(collision.posX(), collision.posY(), collision.posZ(), centrality, isEventSelected);
+    auto indexCollision = straCollisions.lastIndex();
+
+    for (auto& v0 : v0s) {
+      auto cosPA = v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ());
+      if (v0.v0radius() < v0radiusMin || cosPA < v0cospaMin) {
+        continue;
+      }
+      auto distOverTotMom = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ());
+      auto posTrack = v0.template posTrack_as<DaughterTracks>();
+      auto negTrack = v0.template negTrack_as<DaughterTracks>();
+
+      uint16_t mask = 0;
+      if (v0.v0radius() > v0radius && cosPA > v0cospa && v0.dcaV0daughters() < dcav0dau &&
+          std::abs(v0.dcapostopv()) > dcapostopv && std::abs(v0.dcanegtopv()) > dcanegtopv) {
+        SETBIT(mask, kV0Topology);
+      }
+      if (std::abs(v0.yLambda()) < rapidity) {
+        SETBIT(mask, kLambdaRapidity);
+      }
+      if (distOverTotMom * RecoDecay::getMassPDG(kLambda0) < lifetimecut->get("lifetimecutLambda")) {
+        SETBIT(mask, kLambdaLifetime);
+      }
+      if (std::abs(posTrack.tpcNSigmaPr()) < TpcPidNsigmaCut) {
+        SETBIT(mask, kPosProtonPID);
+      }
+      if (std::abs(negTrack.tpcNSigmaPr()) < TpcPidNsigmaCut) {
+        SETBIT(mask, kNegProtonPID);
+      }
+      if (std::abs(posTrack.tpcNSigmaPi()) < TpcPidNsigmaCut) {
+        SETBIT(mask, kPosPionPID);
+      }
+      if (std::abs(negTrack.tpcNSigmaPi()) < TpcPidNsigmaCut) {
+        SETBIT(mask, kNegPionPID);
+      }
+      if (std::abs(v0.yK0Short()) < rapidity) {
+        SETBIT(mask, kK0ShortRapidity);
+      }
+      if (distOverTotMom * RecoDecay::getMassPDG(kK0Short) < lifetimecut->get("lifetimecutK0S")) {
+        SETBIT(mask, kK0ShortLifetime);
+      }
+      if (v0.qtarm() > paramArmenterosCut * std::abs(v0.alpha())) {
+        SETBIT(mask, kK0ShortArmenteros);
+      }
+
+      straV0s(indexCollision,
+              packBinned<binningMomentum>(v0.pt()),
+              packBinned<binningFine>(v0.eta()),
+              packBinned<binningFine>(RecoDecay::constrainAngle(v0.phi(), -o2::constants::math::PI)),
+              packBinned<binningMass>(v0.mLambda() - RecoDecay::getMassPDG(kLambda0)),
+              packBinned<binningMass>(v0.mAntiLambda() - RecoDecay::getMassPDG(kLambda0)),
+              packBinned<binningMass>(v0.mK0Short() - RecoDecay::getMassPDG(kK0Short)),
+              packBinned<binningLength>(v0.v0radius()),
+              packBinned<binningLength>(distOverTotMom),
+              packBinned<binningDCA>(v0.dcaV0daughters()),
+              packBinned<binningDCA>(v0.dcapostopv()),
+              packBinned<binningDCA>(v0.dcanegtopv()),
+              packBinned<binningDCA>(v0.dcav0topv(collision.posX(), collision.posY(), collision.posZ())),
+              packBinned<binningFine>(v0.alpha()),
+              packBinned<binningFine>(v0.qtarm()),
+              cosPA, mask);
+      straV0PIDs(packBinned<binningNSigma>(posTrack.tpcNSigmaPr()),
+                 packBinned<binningNSigma>(posTrack.tpcNSigmaPi()),
+                 packBinned<binningNSigma>(negTrack.tpcNSigmaPr()),
+                 packBinned<binningNSigma>(negTrack.tpcNSigmaPi()));
+    }
+  }
+
+  void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<aod::V0Datas> const& fullV0s, DaughterTracks const&)
+  {
+    fillDerivedData(collision, -1.f, collision.sel8(), fullV0s);
+  }
+  PROCESS_SWITCH(strangederivedbuilder, processRun3, "Process Run 3 data", true);
+
+  void processRun2(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>::iterator const& collision, soa::Filtered<aod::V0Datas> const& fullV0s, DaughterTracks const&)
+  {
+    fillDerivedData(collision, collision.centRun2V0M(), collision.alias()[kINT7] && collision.sel7(), fullV0s);
+  }
+  PROCESS_SWITCH(strangederivedbuilder, processRun2, "Process Run 2 data", false);
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<strangederivedbuilder>(cfgc)};
+}
@@ -20,6 +20,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/Centrality.h"
+#include "Common/Core/MCCollisionSelection.h"
 
 #include "Framework/HistogramRegistry.h"
 
@@ -69,24 +70,47 @@ struct NucleiSpectraEfficiencyGen {
     spectra.add("histGenPt", "generated particles", HistType::kTH1F, {ptAxis});
   }
 
-  void process(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles)
+  template <typename TParticle>
+  void fillGenerated(TParticle const& mcParticleGen)
+  {
+    if (mcParticleGen.pdgCode() != -1000020030) {
+      return;
+    }
+    if (!mcParticleGen.isPhysicalPrimary()) {
+      return;
+    }
+    if (abs(mcParticleGen.y()) > 0.5) {
+      return;
+    }
+    spectra.fill(HIST("histGenPt"), mcParticleGen.pt());
+  }
+
+  void processAll(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles)
   {
     //
     // loop over generated particles and fill generated particles
     //
     for (auto& mcParticleGen : mcParticles) {
-      if (mcParticleGen.pdgCode() != -1000020030) {
-        continue;
-      }
-      if (!mcParticleGen.isPhysicalPrimary()) {
-        continue;
-      }
-      if (abs(mcParticleGen.y()) > 0.5) {
-        continue;
+      fillGenerated(mcParticleGen);
+    }
+  }
+  PROCESS_SWITCH(NucleiSpectraEfficiencyGen, processAll, "Fill the particles of all the MC collisions", true);
+
+  Configurable<float> cfgCutVertex{"cfgCutVertex", 10.0f, "Accepted z-vertex range of the reconstructed collisions, for processReconstructed"};
+
+  o2::analysis::MCCollisionSelection reconstructedMcCollisions;
+
+  void processReconstructed(aod::McCollisions const& mcCollisions, aod::McParticles const& mcParticles, soa::Join<aod::Collisions, aod::McCollisionLabels> const& collisions)
+  {
+    // MC collisions with a reconstructed collision in the vertex range, flagged once per data frame from the collision labels
+    reconstructedMcCollisions.build(mcCollisions.size(), collisions, [this](const auto& collision) { return std::abs(collision.posZ()) < cfgCutVertex; });
+    for (auto& mcParticleGen : mcParticles) {
+      if (reconstructedMcCollisions.isSelected(mcParticleGen.mcCollisionId())) {
+        fillGenerated(mcParticleGen);
       }
-      spectra.fill(HIST("histGenPt"), mcParticleGen.pt());
     }
   }
+  PROCESS_SWITCH(NucleiSpectraEfficiencyGen, processReconstructed, "Fill the particles of the MC collisions reconstructed in the vertex range", false);
 };
 
 struct NucleiSpectraEfficiencyRec {
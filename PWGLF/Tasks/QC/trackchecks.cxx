@@ -15,6 +15,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "PWGLF/Utils/qaSampling.h"
 
 #include <cmath>
 #include <array>
@@ -73,11 +74,15 @@ struct TrackCheckTaskEvSel {
   Configurable<bool> isMC{"isMC", false, "option to flag mc"};
   Configurable<double> cfgCutY{"cfgCutY", 0.5, "option to configure rapidity cut"};
   Configurable<float> cfgCutVZ{"cfgCutVZ", 10.f, "option to configure z-vertex cut"};
+  Configurable<float> sampledFraction{"sampledFraction", 1.f, "fraction of the collisions filled, deterministic in their run and BC (1: all)"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "seed of the sampling of the collisions"};
 
   HistogramRegistry histograms{"histograms"};
+  o2::analysis::QASampling sampling;
 
   void init(InitContext&)
   {
+    sampling.init(sampledFraction, samplingSeed);
     histograms.add("hTrkPrimAftEvSel", "Reco Prim tracks AftEvSel (charged); #it{p}_{T} (GeV/#it{c}); Counts", {kTH1F, {{ptBins}}});
     histograms.add("hTrkPrimAftEvSel_truepid_el", "Gen tracks aft. ev. sel. (true El); #it{p}_{T} (GeV/#it{c}); Counts", {kTH1F, {{ptBins}}});
     histograms.add("hTrkPrimAftEvSel_truepid_pi", "Gen tracks aft. ev. sel. (true Pi); #it{p}_{T} (GeV/#it{c}); Counts", {kTH1F, {{ptBins}}});
@@ -89,8 +94,11 @@ struct TrackCheckTaskEvSel {
   //Filters
   Filter collfilter = nabs(aod::collision::posZ) < cfgCutVZ;
   void process(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& col,
-               soa::Join<aod::Tracks, aod::TracksExtra, aod::McTrackLabels>& tracks, aod::McParticles const& mcParticles)
+               soa::Join<aod::Tracks, aod::TracksExtra, aod::McTrackLabels>& tracks, aod::McParticles const& mcParticles, aod::BCs const&)
   {
+    if (!sampling.keepsAll() && !sampling.accept(col.bc_as<aod::BCs>())) {
+      return;
+    }
 
     //event selection
     if (!isMC && !col.alias()[kINT7]) { // trigger (should be skipped in MC)
@@ -148,11 +156,15 @@ struct TrackCheckTaskEvSelTrackSel {
   Configurable<bool> isMC{"isMC", false, "option to flag mc"};
   Configurable<double> cfgCutY{"cfgCutY", 0.5, "option to configure rapidity cut"};
   Configurable<float> cfgCutVZ{"cfgCutVZ", 10.f, "option to configure z-vertex cut"};
+  Configurable<float> sampledFraction{"sampledFraction", 1.f, "fraction of the collisions filled, deterministic in their run and BC (1: all)"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "seed of the sampling of the collisions"};
 
   HistogramRegistry histograms{"histograms"};
+  o2::analysis::QASampling sampling;
 
   void init(InitContext&)
   {
+    sampling.init(sampledFraction, samplingSeed);
     AxisSpec dcaAxis = {800, -4., 4.};
 
     histograms.add("hTrkPrimReco", "Reco Prim tracks (charged); #it{p}_{T} (GeV/#it{c}); Counts", {kTH1F, {{ptBins}}});
@@ -187,8 +199,11 @@ struct TrackCheckTaskEvSelTrackSel {
   void process(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& col,
                soa::Filtered<soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksDCA,
                                        aod::TrackSelection, aod::McTrackLabels>>& tracks,
-               aod::McParticles_000& mcParticles)
+               aod::McParticles_000& mcParticles, aod::BCs const&)
   {
+    if (!sampling.keepsAll() && !sampling.accept(col.bc_as<aod::BCs>())) {
+      return;
+    }
 
     //event selection
     if (!isMC && !col.alias()[kINT7]) { // trigger (should be skipped in MC)
@@ -29,6 +29,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
 #include "Common/DataModel/PIDResponse.h"
+#include "PWGLF/Utils/qaSampling.h"
 
 #include <TFile.h>
 #include <TH2F.h>
@@ -40,6 +41,7 @@
 #include <cmath>
 #include <array>
 #include <cstdlib>
+#include <string>
 #include "Framework/ASoAHelpers.h"
 
 using namespace o2;
@@ -54,6 +56,22 @@ struct v0cascadesQA {
 
   Configurable<bool> isMC{"isMC", false, "does the data have MC info"};
 
+  // sampling of the collisions, identical in all the tasks with the same seed
+  Configurable<float> sampledFraction{"sampledFraction", 1.f, "fraction of the collisions filled, deterministic in their run and BC (1: all)"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "seed of the sampling of the collisions"};
+  Configurable<bool> doEventsPerRun{"doEventsPerRun", false, "count the sampled collisions of each run"};
+
+  o2::analysis::QASampling sampling;
+  int lastRun = -1;
+  std::string lastRunLabel;
+
+  /// \return whether the collision is filled, its BC being looked up only when sampling
+  template <typename TCollision>
+  bool isSampled(TCollision const& collision)
+  {
+    return sampling.keepsAll() || sampling.accept(collision.template bc_as<aod::BCs>());
+  }
+
   HistogramRegistry histos_eve{
     "histos-eve",
     {
@@ -133,6 +151,16 @@ struct v0cascadesQA {
 
   void init(InitContext const&)
   {
+    sampling.init(sampledFraction, samplingSeed);
+    if (!sampling.keepsAll()) {
+      histos_eve.add("hEventSampling", "hEventSampling", {HistType::kTH1F, {{2, 0.0f, 2.0f}}});
+      histos_eve.get<TH1>(HIST("hEventSampling"))->GetXaxis()->SetBinLabel(1, "all");
+      histos_eve.get<TH1>(HIST("hEventSampling"))->GetXaxis()->SetBinLabel(2, "sampled");
+    }
+    if (doEventsPerRun) {
+      histos_eve.add("hEventsPerRun", "hEventsPerRun;run;sampled events", {HistType::kTH1F, {{1, 0.0f, 1.0f}}});
+      histos_eve.get<TH1>(HIST("hEventsPerRun"))->SetCanExtend(TH1::kAllAxes);
+    }
     if (isMC) {
       histos_eve.add("GeneratedParticles", "GeneratedParticles", {HistType::kTH3F, {{14, 0.0f, 14.0f}, {100, 0, 10}, {100, 0.f, 50.f}}});
 
@@ -151,9 +179,24 @@ struct v0cascadesQA {
   ////////// Collisions QA - reconstructed //////////
   ///////////////////////////////////////////////////
 
-  void processReconstructedEvent(aod::Collision const& Collision)
+  void processReconstructedEvent(aod::Collision const& Collision, aod::BCs const&)
   {
+    if (!sampling.keepsAll()) {
+      histos_eve.fill(HIST("hEventSampling"), 0.5);
+      if (!isSampled(Collision)) {
+        return;
+      }
+      histos_eve.fill(HIST("hEventSampling"), 1.5);
+    }
     histos_eve.fill(HIST("hEventCounter"), 0.5);
+    if (doEventsPerRun) {
+      const int run = Collision.bc_as<aod::BCs>().runNumber();
+      if (run != lastRun) {
+        lastRun = run;
+        lastRunLabel = std::to_string(run);
+      }
+      histos_eve.get<TH1>(HIST("hEventsPerRun"))->Fill(lastRunLabel.c_str(), 1.);
+    }
   }
   PROCESS_SWITCH(v0cascadesQA, processReconstructedEvent, "Process reconstructed level Event", true);
 
@@ -161,8 +204,11 @@ struct v0cascadesQA {
   ////////// Collision QA - MC //////////
   ///////////////////////////////////////
 
-  void processMcEvent(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles)
+  void processMcEvent(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles, aod::BCs const&)
   {
+    if (!isSampled(mcCollision)) {
+      return;
+    }
     double posx = mcCollision.posX();
     double posy = mcCollision.posY();
 
@@ -220,28 +266,39 @@ struct v0cascadesQA {
   static constexpr float defaultLifetimeCuts[1][2] = {{25., 20.}};
   Configurable<LabeledArray<float>> lifetimecut{"lifetimecut", {defaultLifetimeCuts[0], 2, {"lifetimecutLambda", "lifetimecutK0S"}}, "lifetimecut"};
 
-  void processReconstructedV0(aod::Collision const& collision, MyTracks const& tracks, aod::V0Datas const& fullV0s)
+  void processReconstructedV0(aod::Collision const& collision, MyTracks const& tracks, aod::V0Datas const& fullV0s, aod::BCs const&)
   {
+    if (!isSampled(collision)) {
+      return;
+    }
+    const float pvX = collision.posX();
+    const float pvY = collision.posY();
+    const float pvZ = collision.posZ();
+    const float massLambda = RecoDecay::getMassPDG(kLambda0);
+    const float massK0s = RecoDecay::getMassPDG(kK0Short);
     for (auto& v0 : fullV0s) {
-      histos_V0.fill(HIST("CosPA"), v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()));
+      // dynamic columns evaluated once per V0
+      const auto cosPA = v0.v0cosPA(pvX, pvY, pvZ);
+      const float distOverTotMom = v0.distovertotmom(pvX, pvY, pvZ);
+      histos_V0.fill(HIST("CosPA"), cosPA);
       histos_V0.fill(HIST("V0Radius"), v0.v0radius());
       histos_V0.fill(HIST("V0DCANegToPV"), v0.dcanegtopv());
       histos_V0.fill(HIST("V0DCAPosToPV"), v0.dcapostopv());
       histos_V0.fill(HIST("V0DCAV0Daughters"), v0.dcaV0daughters());
 
-      float decayLength = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ()) * RecoDecay::sqrtSumOfSquares(v0.px(), v0.py(), v0.pz());
+      float decayLength = distOverTotMom * RecoDecay::sqrtSumOfSquares(v0.px(), v0.py(), v0.pz());
       histos_V0.fill(HIST("DecayLength"), decayLength);
 
-      float CtauLambda = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ()) * RecoDecay::getMassPDG(kLambda0);
-      float CtauK0s = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ()) * RecoDecay::getMassPDG(kK0Short);
+      float CtauLambda = distOverTotMom * massLambda;
+      float CtauK0s = distOverTotMom * massK0s;
 
-      if (v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) > V0_cosPA) {
+      if (cosPA > V0_cosPA) {
         if (v0.v0radius() > V0_radius && v0.dcaV0daughters() < V0_dcav0dau && TMath::Abs(v0.dcapostopv()) > V0_dcapostopv && TMath::Abs(v0.dcanegtopv()) > V0_dcanegtopv) {
           if (TMath::Abs(v0.yK0Short()) < V0_rapidity && CtauK0s < lifetimecut->get("lifetimecutK0S")) { // that s what we have in lambdakzeroanalysis ; discuss with nicolo chiara if we want to have more like in th aliphysics macro or none like in David's O2 QA
             histos_V0.fill(HIST("CtauK0s"), CtauK0s);
             histos_V0.fill(HIST("DecayLengthK0s"), decayLength);
             histos_V0.fill(HIST("InvMassK0S"), v0.pt(), v0.mK0Short());
-            histos_V0.fill(HIST("V0DCAV0ToPVK0S"), v0.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
+            histos_V0.fill(HIST("V0DCAV0ToPVK0S"), v0.dcav0topv(pvX, pvY, pvZ));
           }
 
           if (TMath::Abs(v0.yLambda()) < V0_rapidity && CtauLambda < lifetimecut->get("lifetimecutLambda")) {
@@ -249,7 +306,7 @@ struct v0cascadesQA {
             histos_V0.fill(HIST("CtauLambda"), CtauLambda);
             histos_V0.fill(HIST("InvMassLambda"), v0.pt(), v0.mLambda());
             histos_V0.fill(HIST("InvMassLambda_Ctau"), CtauLambda, v0.mLambda());
-            histos_V0.fill(HIST("V0DCAV0ToPVLambda"), v0.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
+            histos_V0.fill(HIST("V0DCAV0ToPVLambda"), v0.dcav0topv(pvX, pvY, pvZ));
             // histos_V0.fill(HIST("ResponsePionFromLambda"), v0.pt(), v0.negTrack_as<MyTracks>().tpcNSigmaStorePi());
             // histos_V0.fill(HIST("ResponseProtonFromLambda"), v0.pt(), v0.posTrack_as<MyTracks>().tpcNSigmaStorePr());
           }
@@ -259,7 +316,7 @@ struct v0cascadesQA {
             histos_V0.fill(HIST("CtauAntiLambda"), CtauLambda);
             histos_V0.fill(HIST("InvMassAntiLambda"), v0.pt(), v0.mAntiLambda());
             histos_V0.fill(HIST("InvMassAntiLambda_Ctau"), CtauLambda, v0.mAntiLambda());
-            histos_V0.fill(HIST("V0DCAV0ToPVAntiLambda"), v0.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
+            histos_V0.fill(HIST("V0DCAV0ToPVAntiLambda"), v0.dcav0topv(pvX, pvY, pvZ));
           }
         }
       }
@@ -271,8 +328,11 @@ struct v0cascadesQA {
   ////////// V0 QA - MC //////////
   ////////////////////////////////
 
-  void processMcV0(aod::Collision const& collision, MyTracksMC const& tracks, aod::V0Datas const& fullV0s, aod::McParticles const& mcParticles)
+  void processMcV0(aod::Collision const& collision, MyTracksMC const& tracks, aod::V0Datas const& fullV0s, aod::McParticles const& mcParticles, aod::BCs const&)
   {
+    if (!isSampled(collision)) {
+      return;
+    }
     for (auto& v0 : fullV0s) {
 
       float CtauLambda = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ()) * RecoDecay::getMassPDG(kLambda0);
@@ -372,13 +432,23 @@ struct v0cascadesQA {
   // if( (part==5) && (TMath::Abs(fCasc_NSigPosPion)>3 || TMath::Abs(fCasc_NSigNegProton)>3 || TMath::Abs(fCasc_NSigBacKaon)>3) ) return kFALSE;
   // if( (part==6) && (TMath::Abs(fCasc_NSigNegPion)>3 || TMath::Abs(fCasc_NSigPosProton)>3 || TMath::Abs(fCasc_NSigBacKaon)>3) ) return kFALSE;
 
-  void processReconstructedCascade(aod::Collision const& collision, aod::CascDataExt const& Cascades, aod::V0Datas const& fullV0s)
+  void processReconstructedCascade(aod::Collision const& collision, aod::CascDataExt const& Cascades, aod::V0Datas const& fullV0s, aod::BCs const&)
   {
+    if (!isSampled(collision)) {
+      return;
+    }
+    const float pvX = collision.posX();
+    const float pvY = collision.posY();
+    const float pvZ = collision.posZ();
     for (auto& casc : Cascades) {
+      // dynamic columns evaluated once per cascade
+      const auto cascCosPA = casc.casccosPA(pvX, pvY, pvZ);
+      const auto v0CosPA = casc.v0cosPA(pvX, pvY, pvZ);
+      const auto dcaV0ToPV = casc.dcav0topv(pvX, pvY, pvZ);
       // histos_Casc.fill(HIST("XiProgSelections"), );
       // histos_Casc.fill(HIST("OmegaProgSelections"), );
-      histos_Casc.fill(HIST("CascCosPA"), casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()), casc.sign());
-      histos_Casc.fill(HIST("V0CosPA"), casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()), casc.sign());
+      histos_Casc.fill(HIST("CascCosPA"), cascCosPA, casc.sign());
+      histos_Casc.fill(HIST("V0CosPA"), v0CosPA, casc.sign());
 
       // double v0cospatoxi = RecoDecay::CPA(array{casc.x(), casc.y(), casc.z()}, array{casc.xlambda(), casc.ylambda(), casc.zlambda()}, array{v0.px(), v0.py(), v0.pz()});
       double v0cospatoxi = RecoDecay::cpa(array{casc.x(), casc.y(), casc.z()}, array{casc.xlambda(), casc.ylambda(), casc.zlambda()}, array{casc.pxpos() + casc.pxneg(), casc.pypos() + casc.pyneg(), casc.pzpos() + casc.pzneg()});
@@ -389,7 +459,7 @@ struct v0cascadesQA {
       histos_Casc.fill(HIST("CascyXi"), casc.yXi(), casc.sign());
       histos_Casc.fill(HIST("CascyOmega"), casc.yOmega(), casc.sign());
 
-      float cascDecayLength = std::sqrt(std::pow(casc.x() - collision.posX(), 2) + std::pow(casc.y() - collision.posY(), 2) + std::pow(casc.z() - collision.posZ(), 2));
+      float cascDecayLength = std::sqrt(std::pow(casc.x() - pvX, 2) + std::pow(casc.y() - pvY, 2) + std::pow(casc.z() - pvZ, 2));
       histos_Casc.fill(HIST("CascDecayLength"), cascDecayLength, casc.sign());
       histos_Casc.fill(HIST("CascDecayLengthXi"), cascDecayLength, casc.sign());
       histos_Casc.fill(HIST("CascDecayLengthOmega"), cascDecayLength, casc.sign());
@@ -408,7 +478,7 @@ struct v0cascadesQA {
       histos_Casc.fill(HIST("CascPt"), casc.pt(), casc.sign());
       histos_Casc.fill(HIST("DcaV0Daughters"), casc.dcaV0daughters(), casc.sign());
       histos_Casc.fill(HIST("DcaCascDaughters"), casc.dcacascdaughters(), casc.sign());
-      histos_Casc.fill(HIST("DcaV0ToPV"), casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()), casc.sign());
+      histos_Casc.fill(HIST("DcaV0ToPV"), dcaV0ToPV, casc.sign());
       histos_Casc.fill(HIST("DcaBachToPV"), casc.dcabachtopv(), casc.sign());
       histos_Casc.fill(HIST("DcaPosToPV"), casc.dcapostopv(), casc.sign());
       histos_Casc.fill(HIST("DcaNegToPV"), casc.dcanegtopv(), casc.sign());
@@ -416,9 +486,9 @@ struct v0cascadesQA {
 
       if (casc.v0radius() > Casc_v0radius &&
           casc.cascradius() > Casc_cascradius &&
-          casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) > Casc_v0cospa &&
-          casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()) > Casc_casccospa &&
-          TMath::Abs(casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ())) > Casc_dcav0topv &&
+          v0CosPA > Casc_v0cospa &&
+          cascCosPA > Casc_casccospa &&
+          TMath::Abs(dcaV0ToPV) > Casc_dcav0topv &&
           TMath::Abs(casc.dcapostopv()) > Casc_dcapostopv && TMath::Abs(casc.dcanegtopv()) > Casc_dcanegtopv && TMath::Abs(casc.dcabachtopv()) > Casc_dcabachtopv &&
           casc.dcaV0daughters() < Casc_dcav0dau && casc.dcacascdaughters() < Casc_dcacascdau) {
         if (casc.sign() < 0) {
@@ -445,8 +515,11 @@ struct v0cascadesQA {
   ////////// Cascade QA - MC ///////////
   //////////////////////////////////////
 
-  void processMcCascade(aod::Collision const& collision, aod::CascDataExt const& Cascades, aod::V0sLinked const&, aod::V0Datas const& fullV0s, MyTracksMC const& tracks, aod::McParticles const& mcParticles)
+  void processMcCascade(aod::Collision const& collision, aod::CascDataExt const& Cascades, aod::V0sLinked const&, aod::V0Datas const& fullV0s, MyTracksMC const& tracks, aod::McParticles const& mcParticles, aod::BCs const&)
   {
+    if (!isSampled(collision)) {
+      return;
+    }
     for (auto& casc : Cascades) {
 
       histos_Casc.fill(HIST("QA_XinusCandidates"), 0.5);
@@ -40,6 +40,7 @@
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/Core/TrackSelection.h"
+#include "Common/Core/MCCollisionSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
@@ -78,6 +79,7 @@ struct cascadeGenerated {
 
   Configurable<float> maxPt{"maxPt", 20.0, "max generated pT"};
   Configurable<int> nPtBins{"nPtBins", 200, "number of pT bins"};
+  Configurable<bool> eventSelection{"eventSelection", true, "event selection of the reconstructed collisions, for processSelected"};
 
   void init(InitContext const&)
   {
@@ -90,7 +92,22 @@ struct cascadeGenerated {
     registry.add("hPtOmegaPlus", "hPtOmegaPlus", {HistType::kTH1F, {ptAxis}});
   }
 
-  void process(aod::McCollision const& collision, aod::McParticles const& mcparts)
+  template <typename TParticle>
+  void fillGenerated(TParticle const& particle)
+  {
+    if (TMath::Abs(particle.y()) > 0.5)
+      return;
+    if (particle.pdgCode() == 3312)
+      registry.fill(HIST("hPtXiMinus"), particle.pt());
+    if (particle.pdgCode() == 3334)
+      registry.fill(HIST("hPtXiPlus"), particle.pt());
+    if (particle.pdgCode() == -3312)
+      registry.fill(HIST("hPtOmegaMinus"), particle.pt());
+    if (particle.pdgCode() == -3334)
+      registry.fill(HIST("hPtOmegaPlus"), particle.pt());
+  }
+
+  void processAll(aod::McCollision const& collision, aod::McParticles const& mcparts)
   {
     //Count monte carlo events
     //WARNING: MC collision <-> real collision association has to be understood
@@ -99,18 +116,29 @@ struct cascadeGenerated {
     //Count all generated MC particles
     //WARNING: event-level losses have to be understood too
     for (auto& particle : mcparts) {
-      if (TMath::Abs(particle.y()) > 0.5)
-        continue;
-      if (particle.pdgCode() == 3312)
-        registry.fill(HIST("hPtXiMinus"), particle.pt());
-      if (particle.pdgCode() == 3334)
-        registry.fill(HIST("hPtXiPlus"), particle.pt());
-      if (particle.pdgCode() == -3312)
-        registry.fill(HIST("hPtOmegaMinus"), particle.pt());
-      if (particle.pdgCode() == -3334)
-        registry.fill(HIST("hPtOmegaPlus"), particle.pt());
+      fillGenerated(particle);
+    }
+  }
+  PROCESS_SWITCH(cascadeGenerated, processAll, "Count the particles of all the MC collisions", true);
+
+  o2::analysis::MCCollisionSelection selectedMcCollisions;
+
+  void processSelected(aod::McCollisions const& mcCollisions, aod::McParticles const& mcparts, soa::Join<aod::Collisions, aod::McCollisionLabels, aod::EvSels> const& collisions)
+  {
+    // MC collisions with a reconstructed collision passing sel8, flagged once per data frame from the collision labels
+    selectedMcCollisions.build(mcCollisions.size(), collisions, [this](const auto& collision) { return !eventSelection || collision.sel8(); });
+    for (const auto& mcCollision : mcCollisions) {
+      if (selectedMcCollisions.isSelected(mcCollision.globalIndex())) {
+        registry.fill(HIST("hEventCounter"), 0.5f);
+      }
+    }
+    for (auto& particle : mcparts) {
+      if (selectedMcCollisions.isSelected(particle.mcCollisionId())) {
+        fillGenerated(particle);
+      }
     }
   }
+  PROCESS_SWITCH(cascadeGenerated, processSelected, "Count the particles of the reconstructed and selected MC collisions", false);
 };
 
 struct cascadeQaMC {
@@ -195,6 +223,13 @@ struct cascadeAnalysisMC {
     registry.add("h2dMassXiPlus", "h2dMassXiPlus", {HistType::kTH2F, {ptAxis, massAxisXi}});
     registry.add("h2dMassOmegaMinus", "h2dMassOmegaMinus", {HistType::kTH2F, {ptAxis, massAxisOmega}});
     registry.add("h2dMassOmegaPlus", "h2dMassOmegaPlus", {HistType::kTH2F, {ptAxis, massAxisOmega}});
+    if (doCentralityStudy) {
+      AxisSpec centAxis = {100, 0.0f, 100.0f, "mult percentile"};
+      registry.add("h3dMassXiMinus", "h3dMassXiMinus", {HistType::kTH3F, {centAxis, ptAxis, massAxisXi}});
+      registry.add("h3dMassXiPlus", "h3dMassXiPlus", {HistType::kTH3F, {centAxis, ptAxis, massAxisXi}});
+      registry.add("h3dMassOmegaMinus", "h3dMassOmegaMinus", {HistType::kTH3F, {centAxis, ptAxis, massAxisOmega}});
+      registry.add("h3dMassOmegaPlus", "h3dMassOmegaPlus", {HistType::kTH3F, {centAxis, ptAxis, massAxisOmega}});
+    }
   }
 
   // Selection criteria
@@ -229,90 +264,75 @@ struct cascadeAnalysisMC {
   Filter preFilter =
     nabs(aod::cascdata::dcapostopv) > dcapostopv&& nabs(aod::cascdata::dcanegtopv) > dcanegtopv&& nabs(aod::cascdata::dcabachtopv) > dcabachtopv&& aod::cascdata::dcaV0daughters < dcav0dau&& aod::cascdata::dcacascdaughters < dcacascdau;
 
-  template <class TCascTracksTo, typename TCascade>
-  int checkCascadeTPCPID(TCascade& lCascade)
+  /// Daughter quantities of a cascade, gathered with a single dereference of each daughter
+  struct CascadeDaughters {
+    int tpcNClsBac, tpcNClsPos, tpcNClsNeg;
+    int itsNClsBac, itsNClsPos, itsNClsNeg;
+    float nSigmaPiBac, nSigmaKaBac; // TPC n sigma, filled only with PID
+    float nSigmaPrPos, nSigmaPiPos;
+    float nSigmaPrNeg, nSigmaPiNeg;
+  };
+
+  template <bool withPID, class TCascTracksTo, typename TV0Data, typename TCascade>
+  CascadeDaughters gatherDaughters(TCascade const& casc, TV0Data const& v0data)
+  {
+    const auto bachTrack = casc.template bachelor_as<TCascTracksTo>();
+    const auto posTrack = v0data.template posTrack_as<TCascTracksTo>();
+    const auto negTrack = v0data.template negTrack_as<TCascTracksTo>();
+    CascadeDaughters daughters{bachTrack.tpcNClsFound(), posTrack.tpcNClsFound(), negTrack.tpcNClsFound(),
+                               bachTrack.itsNCls(), posTrack.itsNCls(), negTrack.itsNCls(),
+                               0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    if constexpr (withPID) {
+      daughters.nSigmaPiBac = bachTrack.tpcNSigmaPi();
+      daughters.nSigmaKaBac = bachTrack.tpcNSigmaKa();
+      daughters.nSigmaPrPos = posTrack.tpcNSigmaPr();
+      daughters.nSigmaPiPos = posTrack.tpcNSigmaPi();
+      daughters.nSigmaPrNeg = negTrack.tpcNSigmaPr();
+      daughters.nSigmaPiNeg = negTrack.tpcNSigmaPi();
+    }
+    return daughters;
+  }
+
+  int checkCascadeTPCPID(CascadeDaughters const& daughters, int sign)
   //function to check PID of a certain cascade candidate for a hypothesis
   {
     bool lConsistentWithLambda = true;
     bool lConsistentWithXi = true;
     bool lConsistentWithOm = true;
-    auto v0 = lCascade.template v0_as<o2::aod::V0sLinked>();
-    if (!(v0.has_v0Data())) {
-      return 0; //reject
-    }
-    auto v0data = v0.v0Data(); // de-reference index to correct v0data in case it exists
-    auto bachTrack = lCascade.template bachelor_as<TCascTracksTo>();
-    auto posTrack = v0data.template posTrack_as<TCascTracksTo>();
-    auto negTrack = v0data.template negTrack_as<TCascTracksTo>();
 
     //Bachelor: depends on type
-    if (TMath::Abs(bachTrack.tpcNSigmaPi()) > tpcNsigmaBachelor && tpcNsigmaBachelor < 9.99)
+    if (TMath::Abs(daughters.nSigmaPiBac) > tpcNsigmaBachelor && tpcNsigmaBachelor < 9.99)
       lConsistentWithXi = false;
-    if (TMath::Abs(bachTrack.tpcNSigmaKa()) > tpcNsigmaBachelor && tpcNsigmaBachelor < 9.99)
+    if (TMath::Abs(daughters.nSigmaKaBac) > tpcNsigmaBachelor && tpcNsigmaBachelor < 9.99)
       lConsistentWithOm = false;
 
     //Proton check: depends on cascade sign
-    if (lCascade.sign() < 0 && TMath::Abs(posTrack.tpcNSigmaPr()) > tpcNsigmaProton && tpcNsigmaProton < 9.99)
+    if (sign < 0 && TMath::Abs(daughters.nSigmaPrPos) > tpcNsigmaProton && tpcNsigmaProton < 9.99)
       lConsistentWithLambda = false;
-    if (lCascade.sign() > 0 && TMath::Abs(negTrack.tpcNSigmaPr()) > tpcNsigmaProton && tpcNsigmaProton < 9.99)
+    if (sign > 0 && TMath::Abs(daughters.nSigmaPrNeg) > tpcNsigmaProton && tpcNsigmaProton < 9.99)
       lConsistentWithLambda = false;
 
     //Pion check: depends on cascade sign
-    if (lCascade.sign() < 0 && TMath::Abs(negTrack.tpcNSigmaPi()) > tpcNsigmaPion && tpcNsigmaPion < 9.99)
+    if (sign < 0 && TMath::Abs(daughters.nSigmaPiNeg) > tpcNsigmaPion && tpcNsigmaPion < 9.99)
       lConsistentWithLambda = false;
-    if (lCascade.sign() > 0 && TMath::Abs(posTrack.tpcNSigmaPi()) > tpcNsigmaPion && tpcNsigmaPion < 9.99)
+    if (sign > 0 && TMath::Abs(daughters.nSigmaPiPos) > tpcNsigmaPion && tpcNsigmaPion < 9.99)
       lConsistentWithLambda = false;
 
     //bit-packing (first bit -> consistent with Xi, second bit -> consistent with Omega)
     return lConsistentWithLambda * lConsistentWithXi + 2 * lConsistentWithLambda * lConsistentWithOm;
   }
 
-  template <class TCascTracksTo, typename TCascade>
-  void processCascadeCandidate(TCascade const& casc, float const& pvx, float const& pvy, float const& pvz, float lPercentile = 999.0f, int lPIDvalue = 3)
+  template <typename TCascade>
+  void processCascadeCandidate(TCascade const& casc, CascadeDaughters const& daughters, int lPDG, float pvx, float pvy, float pvz, float lPercentile, int lPIDvalue)
   //function to process cascades and generate corresponding invariant mass distributions
   {
-    registry.fill(HIST("hCandidateCounter"), 0.5); //all candidates
-
-    //check mc association if requested
-    Int_t lPDG = 0;
-    if (assocMC) {
-      if (!casc.has_mcParticle())
-        return;
-      auto cascmc = casc.mcParticle();
-      if (TMath::Abs(cascmc.pdgCode()) == 3312 || TMath::Abs(cascmc.pdgCode()) == 3334)
-        lPDG = cascmc.pdgCode();
-    }
-
-    auto v0 = casc.template v0_as<o2::aod::V0sLinked>();
-    if (!(v0.has_v0Data())) {
-      return; //skip those cascades for which V0 doesn't exist
-    }
-    registry.fill(HIST("hCandidateCounter"), 1.5); //v0data exists
-    auto v0data = v0.v0Data();                     // de-reference index to correct v0data in case it exists
-    auto bachTrackCast = casc.template bachelor_as<TCascTracksTo>();
-    auto posTrackCast = v0data.template posTrack_as<TCascTracksTo>();
-    auto negTrackCast = v0data.template negTrack_as<TCascTracksTo>();
-
     //track-level selections
-    Bool_t lEnoughTPCNClsBac = kTRUE;
-    Bool_t lEnoughTPCNClsPos = kTRUE;
-    Bool_t lEnoughTPCNClsNeg = kTRUE;
-    Bool_t lEnoughITSNClsBac = kTRUE;
-    Bool_t lEnoughITSNClsPos = kTRUE;
-    Bool_t lEnoughITSNClsNeg = kTRUE;
-
-    if (bachTrackCast.tpcNClsFound() < tpcClusters)
-      lEnoughTPCNClsBac = kFALSE;
-    if (posTrackCast.tpcNClsFound() < tpcClusters)
-      lEnoughTPCNClsPos = kFALSE;
-    if (negTrackCast.tpcNClsFound() < tpcClusters)
-      lEnoughTPCNClsNeg = kFALSE;
-    if (bachTrackCast.itsNCls() < itsClusters)
-      lEnoughITSNClsBac = kFALSE;
-    if (posTrackCast.itsNCls() < itsClusters)
-      lEnoughITSNClsPos = kFALSE;
-    if (negTrackCast.itsNCls() < itsClusters)
-      lEnoughITSNClsNeg = kFALSE;
+    const bool lEnoughTPCNClsBac = daughters.tpcNClsBac >= tpcClusters;
+    const bool lEnoughTPCNClsPos = daughters.tpcNClsPos >= tpcClusters;
+    const bool lEnoughTPCNClsNeg = daughters.tpcNClsNeg >= tpcClusters;
+    const bool lEnoughITSNClsBac = daughters.itsNClsBac >= itsClusters;
+    const bool lEnoughITSNClsPos = daughters.itsNClsPos >= itsClusters;
+    const bool lEnoughITSNClsNeg = daughters.itsNClsNeg >= itsClusters;
 
     //Logic: either you have enough TPC clusters, OR you enabled ITSSA and have enough ITS clusters as requested
     //N.B.: This will require dedicated studies!
@@ -385,131 +405,106 @@ struct cascadeAnalysisMC {
     }
   }
 
-  void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIU const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
+  /// Analysis of the cascades of a collision, each variant of the process functions being a set of compile-time options
+  /// \tparam run3  Run 3 (sel8) or Run 2 (kINT7 and sel7) event selection
+  /// \tparam withMultiplicity  collision joined with the V0M centrality
+  /// \tparam withPID  TPC PID of the daughters, the tracks being joined with the PID tables
+  /// \tparam TCascTracksTo  tracks of the daughters
+  template <bool run3, bool withMultiplicity, bool withPID, class TCascTracksTo, typename TCollision, typename TCascades>
+  void analyseCollision(TCollision const& collision, TCascades const& cascades)
   {
-    //Run 3 event selection criteria
-    if (eventSelection && !collision.sel8()) {
-      return;
+    if constexpr (run3) {
+      //Run 3 event selection criteria
+      if (eventSelection && !collision.sel8()) {
+        return;
+      }
+    } else {
+      //Run 2 event selection criteria
+      if (eventSelection && (!collision.alias()[kINT7] || !collision.sel7())) {
+        return;
+      }
     }
-    //fill cascade information with tracksIU typecast (Run 3)
-    for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ());
+    float lPercentile = 999.0f;
+    if constexpr (withMultiplicity) {
+      lPercentile = collision.centRun2V0M();
     }
+    const float pvx = collision.posX();
+    const float pvy = collision.posY();
+    const float pvz = collision.posZ();
+
+    for (const auto& casc : cascades) {
+      registry.fill(HIST("hCandidateCounter"), 0.5); //all candidates
+
+      //check mc association if requested
+      int lPDG = 0;
+      if (assocMC) {
+        if (!casc.has_mcParticle())
+          continue;
+        const int pdgCode = casc.mcParticle().pdgCode();
+        if (TMath::Abs(pdgCode) == 3312 || TMath::Abs(pdgCode) == 3334)
+          lPDG = pdgCode;
+      }
+
+      const auto v0 = casc.template v0_as<o2::aod::V0sLinked>();
+      if (!(v0.has_v0Data())) {
+        continue; //skip those cascades for which V0 doesn't exist
+      }
+      registry.fill(HIST("hCandidateCounter"), 1.5); //v0data exists
+      const auto daughters = gatherDaughters<withPID, TCascTracksTo>(casc, v0.v0Data());
+
+      int lPIDvalue = 3;
+      if constexpr (withPID) {
+        lPIDvalue = checkCascadeTPCPID(daughters, casc.sign());
+      }
+      processCascadeCandidate(casc, daughters, lPDG, pvx, pvy, pvz, lPercentile, lPIDvalue);
+    }
+  }
+
+  void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIU const&, aod::McParticles const&)
+  {
+    analyseCollision<true, false, false, FullTracksExtIU>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun3, "Process Run 3 data", true);
 
   void processRun2(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExt const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 2 event selection criteria
-    if (eventSelection && !collision.alias()[kINT7]) {
-      return;
-    }
-    if (eventSelection && !collision.sel7()) {
-      return;
-    }
-    //fill cascade information with tracks typecast (Run 2)
-    for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ());
-    }
+    analyseCollision<false, false, false, FullTracksExt>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun2, "Process Run 2 data", false);
 
   void processRun3VsMultiplicity(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIU const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 3 event selection criteria
-    if (eventSelection && !collision.sel8()) {
-      return;
-    }
-    //fill cascade information with tracksIU typecast (Run 3)
-    for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M());
-    }
+    analyseCollision<true, true, false, FullTracksExtIU>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun3VsMultiplicity, "Process Run 3 data vs multiplicity", false);
 
   void processRun2VsMultiplicity(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExt const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 2 event selection criteria
-    if (eventSelection && !collision.alias()[kINT7]) {
-      return;
-    }
-    if (eventSelection && !collision.sel7()) {
-      return;
-    }
-    //fill cascade information with tracks typecast (Run 2)
-    for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M());
-    }
+    analyseCollision<false, true, false, FullTracksExt>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun2VsMultiplicity, "Process Run 2 data vs multiplicity", false);
 
   void processRun3WithPID(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIUWithPID const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 3 event selection criteria
-    if (eventSelection && !collision.sel8()) {
-      return;
-    }
-    //fill cascade information with tracksIU typecast (Run 3)
-    for (auto& casc : Cascades) {
-      int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue);
-    }
+    analyseCollision<true, false, true, FullTracksExtIUWithPID>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun3WithPID, "Process Run 3 data  with PID", false);
 
   void processRun2WithPID(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtWithPID const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 2 event selection criteria
-    if (eventSelection && !collision.alias()[kINT7]) {
-      return;
-    }
-    if (eventSelection && !collision.sel7()) {
-      return;
-    }
-    //fill cascade information with tracks typecast (Run 2)
-    for (auto& casc : Cascades) {
-      int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue);
-    }
+    analyseCollision<false, false, true, FullTracksExtWithPID>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun2WithPID, "Process Run 2 data  with PID", false);
 
   void processRun3VsMultiplicityWithPID(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIUWithPID const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 3 event selection criteria
-    if (eventSelection && !collision.sel8()) {
-      return;
-    }
-    //fill cascade information with tracksIU typecast (Run 3)
-    for (auto& casc : Cascades) {
-      int lPIDvalue = checkCascadeTPCPID<FullTracksExtIUWithPID>(casc);
-      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue);
-    }
+    analyseCollision<true, true, true, FullTracksExtIUWithPID>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun3VsMultiplicityWithPID, "Process Run 3 data vs multiplicity with PID", false);
 
   void processRun2VsMultiplicityWithPID(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms>::iterator const& collision, soa::Filtered<LabeledCascades> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtWithPID const&, aod::McParticles const&)
-  //process function subscribing to Run 3-like analysis objects
   {
-    //Run 2 event selection criteria
-    if (eventSelection && !collision.alias()[kINT7]) {
-      return;
-    }
-    if (eventSelection && !collision.sel7()) {
-      return;
-    }
-    //fill cascade information with tracks typecast (Run 2)
-    for (auto& casc : Cascades) {
-      int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue);
-    }
+    analyseCollision<false, true, true, FullTracksExtWithPID>(collision, Cascades);
   }
   PROCESS_SWITCH(cascadeAnalysisMC, processRun2VsMultiplicityWithPID, "Process Run 2 data vs multiplicity with PID", false);
 };
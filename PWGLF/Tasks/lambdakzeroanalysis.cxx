@@ -76,7 +76,7 @@ struct lambdakzeroQa {
     registry.add("hMassLambda", "hMassLambda", {HistType::kTH1F, {massAxisLambda}});
     registry.add("hMassAntiLambda", "hMassAntiLambda", {HistType::kTH1F, {massAxisLambda}});
   }
-  void process(aod::Collision const& collision, aod::V0Datas const& fullV0s)
+  void processV0Datas(aod::Collision const& collision, aod::V0Datas const& fullV0s)
   {
 
     for (auto& v0 : fullV0s) {
@@ -92,6 +92,24 @@ struct lambdakzeroQa {
       registry.fill(HIST("hArmenterosPreAnalyserCuts"), v0.alpha(), v0.qtarm());
     }
   }
+  PROCESS_SWITCH(lambdakzeroQa, processV0Datas, "QA of V0Datas", true);
+
+  void processDerived(aod::StraCollision const&, aod::StraV0s const& fullV0s)
+  {
+    for (auto& v0 : fullV0s) {
+      registry.fill(HIST("hMassK0Short"), v0.mK0Short());
+      registry.fill(HIST("hMassLambda"), v0.mLambda());
+      registry.fill(HIST("hMassAntiLambda"), v0.mAntiLambda());
+
+      registry.fill(HIST("hV0Radius"), v0.v0radius());
+      registry.fill(HIST("hV0CosPA"), v0.v0cosPA());
+      registry.fill(HIST("hDCAPosToPV"), v0.dcapostopv());
+      registry.fill(HIST("hDCANegToPV"), v0.dcanegtopv());
+      registry.fill(HIST("hDCAV0Dau"), v0.dcaV0daughters());
+      registry.fill(HIST("hArmenterosPreAnalyserCuts"), v0.alpha(), v0.qtarm());
+    }
+  }
+  PROCESS_SWITCH(lambdakzeroQa, processDerived, "QA of strangeness derived data (StraV0s)", false);
 };
 
 struct lambdakzeroAnalysis {
@@ -125,11 +143,11 @@ struct lambdakzeroAnalysis {
     registry.get<TH1>(HIST("hEventSelection"))->GetXaxis()->SetBinLabel(2, "Sel8 cut");
     registry.get<TH1>(HIST("hEventSelection"))->GetXaxis()->SetBinLabel(3, "posZ cut");
 
-    if (doprocessRun3 && doprocessRun2) {
-      LOGF(fatal, "processRun3 and processRun2 are both set to true; try again with only one of them set to true");
+    if (doprocessRun3 + doprocessRun2 + doprocessDerived > 1) {
+      LOGF(fatal, "processRun3, processRun2 and processDerived: only one of them can be set to true");
     }
-    if (!doprocessRun3 && !doprocessRun2) {
-      LOGF(fatal, "processRun3 nor processRun2 are both set to false; try again with only one of them set to false");
+    if (!doprocessRun3 && !doprocessRun2 && !doprocessDerived) {
+      LOGF(fatal, "processRun3, processRun2 and processDerived are all set to false; try again with one of them set to true");
     }
   }
 
@@ -146,6 +164,7 @@ struct lambdakzeroAnalysis {
   Configurable<float> paramArmenterosCut{"paramArmenterosCut", 0.2, "parameter Armenteros Cut"};
   Configurable<bool> event_sel8_selection{"event_sel8_selection", true, "event selection count post sel8 cut"};
   Configurable<bool> event_posZ_selection{"event_posZ_selection", true, "event selection count post poZ cut"};
+  Configurable<bool> useDerivedSelection{"useDerivedSelection", false, "derived data: use the selection mask of the builder instead of the cuts above"};
 
   static constexpr float defaultLifetimeCuts[1][2] = {{25., 20.}};
   Configurable<LabeledArray<float>> lifetimecut{"lifetimecut", {defaultLifetimeCuts[0], 2, {"lifetimecutLambda", "lifetimecutK0S"}}, "lifetimecut"};
@@ -265,6 +284,70 @@ struct lambdakzeroAnalysis {
     }
   }
   PROCESS_SWITCH(lambdakzeroAnalysis, processRun2, "Process Run 2 data", false);
+
+  void processDerived(aod::StraCollision const& collision, soa::Join<aod::StraV0s, aod::StraV0PIDs> const& fullV0s)
+  {
+    using namespace o2::aod::stradata;
+    registry.fill(HIST("hEventSelection"), 0.5);
+    if (event_sel8_selection && !collision.isEventSelected()) {
+      return;
+    }
+    registry.fill(HIST("hEventSelection"), 1.5);
+    if (event_posZ_selection && abs(collision.posZ()) > 10.f) { // 10cm
+      return;
+    }
+    registry.fill(HIST("hEventSelection"), 2.5);
+
+    float centrality = collision.centrality() < 0.f ? 0.f : collision.centrality();
+    for (auto& v0 : fullV0s) {
+      bool isTopoSelected, isLambda, isAntiLambda, isK0Short;
+      if (useDerivedSelection) {
+        isTopoSelected = v0.isSelected(BIT(kV0Topology));
+        isLambda = v0.isSelected(BIT(kLambdaRapidity) | BIT(kLambdaLifetime) | BIT(kPosProtonPID));
+        isAntiLambda = v0.isSelected(BIT(kLambdaRapidity) | BIT(kLambdaLifetime) | BIT(kNegProtonPID));
+        isK0Short = v0.isSelected(BIT(kK0ShortRapidity) | BIT(kK0ShortLifetime)) && (v0.isSelected(BIT(kK0ShortArmenteros)) || !boolArmenterosCut);
+      } else {
+        isTopoSelected = v0.v0radius() > v0radius && v0.v0cosPA() > v0cospa && v0.dcaV0daughters() < dcav0dau &&
+                         TMath::Abs(v0.dcapostopv()) > dcapostopv && TMath::Abs(v0.dcanegtopv()) > dcanegtopv;
+        bool isLambdaKine = TMath::Abs(v0.yLambda()) < rapidity && v0.distovertotmom() * RecoDecay::getMassPDG(kLambda0) < lifetimecut->get("lifetimecutLambda");
+        isLambda = isLambdaKine && TMath::Abs(v0.posTPCNSigmaPr()) < TpcPidNsigmaCut;
+        isAntiLambda = isLambdaKine && TMath::Abs(v0.negTPCNSigmaPr()) < TpcPidNsigmaCut;
+        isK0Short = TMath::Abs(v0.yK0Short()) < rapidity && v0.distovertotmom() * RecoDecay::getMassPDG(kK0Short) < lifetimecut->get("lifetimecutK0S") &&
+                    ((v0.qtarm() > paramArmenterosCut * TMath::Abs(v0.alpha())) || !boolArmenterosCut);
+      }
+      if (!isTopoSelected) {
+        continue;
+      }
+
+      // Lambda
+      if (isLambda) {
+        registry.fill(HIST("h3dMassLambda"), centrality, v0.pt(), v0.mLambda());
+        registry.fill(HIST("hArmenterosPostAnalyserCuts"), v0.alpha(), v0.qtarm());
+        if (saveDcaHist == 1) {
+          registry.fill(HIST("h3dMassLambdaDca"), v0.dcaV0daughters(), v0.pt(), v0.mLambda());
+        }
+      }
+
+      // AntiLambda
+      if (isAntiLambda) {
+        registry.fill(HIST("h3dMassAntiLambda"), centrality, v0.pt(), v0.mAntiLambda());
+        registry.fill(HIST("hArmenterosPostAnalyserCuts"), v0.alpha(), v0.qtarm());
+        if (saveDcaHist == 1) {
+          registry.fill(HIST("h3dMassAntiLambdaDca"), v0.dcaV0daughters(), v0.pt(), v0.mAntiLambda());
+        }
+      }
+
+      // K0Short
+      if (isK0Short) {
+        registry.fill(HIST("h3dMassK0Short"), centrality, v0.pt(), v0.mK0Short());
+        registry.fill(HIST("hArmenterosPostAnalyserCuts"), v0.alpha(), v0.qtarm());
+        if (saveDcaHist == 1) {
+          registry.fill(HIST("h3dMassK0ShortDca"), v0.dcaV0daughters(), v0.pt(), v0.mK0Short());
+        }
+      }
+    }
+  }
+  PROCESS_SWITCH(lambdakzeroAnalysis, processDerived, "Process strangeness derived data (StraV0s)", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
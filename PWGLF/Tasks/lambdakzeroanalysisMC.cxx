@@ -31,6 +31,7 @@
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/Core/TrackSelection.h"
+#include "Common/Core/MCCollisionSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
@@ -473,31 +474,30 @@ struct lambdakzeroParticleCountMc {
   Configurable<bool> event_sel8_selection{"event_sel8_selection", true, "event selection MC count post sel8 cut"};
   Configurable<bool> event_posZ_selection{"event_posZ_selection", true, "event selection MC count post poZ cut"};
 
-  void process(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles, const soa::SmallGroups<o2::soa::Join<o2::aod::Collisions, o2::aod::McCollisionLabels, o2::aod::EvSels>>& collisions)
+  o2::analysis::MCCollisionSelection selectedMcCollisions;
+
+  void process(aod::McCollisions const& mcCollisions, aod::McParticles const& mcParticles, soa::Join<o2::aod::Collisions, o2::aod::McCollisionLabels, o2::aod::EvSels> const& collisions)
   {
-    std::vector<int64_t> SelectedEvents(collisions.size());
-    int nevts = 0;
-    for (const auto& collision : collisions) {
-      if (event_sel8_selection && !collision.sel8()) {
+    // MC collisions reconstructed and selected, flagged once per data frame from the collision labels
+    selectedMcCollisions.build(mcCollisions.size(), collisions, [this](const auto& collision) { return !event_sel8_selection || collision.sel8(); });
+
+    for (const auto& mcCollision : mcCollisions) {
+      registry.fill(HIST("hEventSelection"), 0.5);
+      if (!selectedMcCollisions.isSelected(mcCollision.globalIndex())) { // Check that the event is reconstructed and that the reconstructed events pass the selection
         continue;
       }
-      SelectedEvents[nevts++] = collision.mcCollision_as<aod::McCollisions>().globalIndex();
-    }
-    SelectedEvents.resize(nevts);
-
-    const auto evtReconstructedAndSelected = std::find(SelectedEvents.begin(), SelectedEvents.end(), mcCollision.globalIndex()) != SelectedEvents.end();
-
-    registry.fill(HIST("hEventSelection"), 0.5);
-    if (!evtReconstructedAndSelected) { // Check that the event is reconstructed and that the reconstructed events pass the selection
-      return;
-    }
-    registry.fill(HIST("hEventSelection"), 1.5);                  // hSelAndRecoMcCollCounter
-    if (event_posZ_selection && abs(mcCollision.posZ()) > 10.f) { // 10cm
-      return;
+      registry.fill(HIST("hEventSelection"), 1.5);                  // hSelAndRecoMcCollCounter
+      if (event_posZ_selection && abs(mcCollision.posZ()) > 10.f) { // 10cm
+        selectedMcCollisions.deselect(mcCollision.globalIndex());
+        continue;
+      }
+      registry.fill(HIST("hEventSelection"), 2.5);
     }
-    registry.fill(HIST("hEventSelection"), 2.5);
 
     for (auto& mcparticle : mcParticles) {
+      if (!selectedMcCollisions.isSelected(mcparticle.mcCollisionId())) {
+        continue;
+      }
       if (TMath::Abs(mcparticle.y()) < rapidityMCcut) {
         if (mcparticle.isPhysicalPrimary()) {
           if (!mcparticle.has_daughters()) {
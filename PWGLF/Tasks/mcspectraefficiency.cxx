@@ -14,6 +14,7 @@
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoAHelpers.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "Common/Core/MCCollisionSelection.h"
 
 // ROOT includes
 #include <TH1F.h>
@@ -59,29 +60,58 @@ struct GeneratedTask {
   int particles = 0;
   int primaryparticles = 0;
 
-  void process(aod::McCollision const& mcCollision, aod::McParticles& mcParticles)
+  template <typename TParticle>
+  void fillParticle(TParticle const& mcParticle)
+  {
+    if (abs(mcParticle.eta()) > 0.8) {
+      return;
+    }
+    if (mcParticle.isPhysicalPrimary()) {
+      const auto pdg = Form("%i", mcParticle.pdgCode());
+      pdgH->Fill(pdg, 1);
+      const float pdgbin = pdgH->GetXaxis()->GetBinCenter(pdgH->GetXaxis()->FindBin(pdg));
+      phiH->Fill(mcParticle.phi(), pdgbin);
+      etaH->Fill(mcParticle.eta(), pdgbin);
+      pH->Fill(sqrt(mcParticle.px() * mcParticle.px() + mcParticle.py() * mcParticle.py() + mcParticle.pz() * mcParticle.pz()), pdgbin);
+      ptH->Fill(mcParticle.pt(), pdgbin);
+      primaryparticles++;
+    }
+    particles++;
+  }
+
+  void processAll(aod::McCollision const& mcCollision, aod::McParticles& mcParticles)
   {
     LOGF(info, "MC. vtx-z = %f", mcCollision.posZ());
     for (auto& mcParticle : mcParticles) {
-      if (abs(mcParticle.eta()) > 0.8) {
-        continue;
+      fillParticle(mcParticle);
+    }
+    LOGF(info, "Events %i", events++ + 1);
+    LOGF(info, "Particles %i", particles);
+    LOGF(info, "Primaries %i", primaryparticles);
+  }
+  PROCESS_SWITCH(GeneratedTask, processAll, "Fill the particles of all the MC collisions", true);
+
+  o2::analysis::MCCollisionSelection reconstructedMcCollisions;
+
+  void processReconstructed(aod::McCollisions const& mcCollisions, aod::McParticles const& mcParticles, soa::Join<aod::Collisions, aod::McCollisionLabels> const& collisions)
+  {
+    // MC collisions with a reconstructed collision, flagged once per data frame from the collision labels
+    reconstructedMcCollisions.build(mcCollisions.size(), collisions);
+    for (const auto& mcCollision : mcCollisions) {
+      if (reconstructedMcCollisions.isSelected(mcCollision.globalIndex())) {
+        events++;
       }
-      if (mcParticle.isPhysicalPrimary()) {
-        const auto pdg = Form("%i", mcParticle.pdgCode());
-        pdgH->Fill(pdg, 1);
-        const float pdgbin = pdgH->GetXaxis()->GetBinCenter(pdgH->GetXaxis()->FindBin(pdg));
-        phiH->Fill(mcParticle.phi(), pdgbin);
-        etaH->Fill(mcParticle.eta(), pdgbin);
-        pH->Fill(sqrt(mcParticle.px() * mcParticle.px() + mcParticle.py() * mcParticle.py() + mcParticle.pz() * mcParticle.pz()), pdgbin);
-        ptH->Fill(mcParticle.pt(), pdgbin);
-        primaryparticles++;
+    }
+    for (auto& mcParticle : mcParticles) {
+      if (reconstructedMcCollisions.isSelected(mcParticle.mcCollisionId())) {
+        fillParticle(mcParticle);
       }
-      particles++;
     }
-    LOGF(info, "Events %i", events++ + 1);
+    LOGF(info, "Events %i", events);
     LOGF(info, "Particles %i", particles);
     LOGF(info, "Primaries %i", primaryparticles);
   }
+  PROCESS_SWITCH(GeneratedTask, processReconstructed, "Fill the particles of the reconstructed MC collisions", false);
 };
 
 // Access from tracks to MC particle
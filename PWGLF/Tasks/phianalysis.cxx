@@ -22,6 +22,7 @@
 #include "Framework/ASoAHelpers.h"
 #include "Framework/runDataProcessing.h"
 #include "PWGLF/DataModel/LFResonanceTables.h"
+#include "PWGLF/Utils/resonanceMixing.h"
 #include <CCDB/BasicCCDBManager.h>
 #include "DataFormatsParameters/GRPObject.h"
 
@@ -29,6 +30,7 @@ using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 using namespace o2::soa;
+using namespace o2::analysis;
 
 struct phianalysis {
   framework::Service<o2::ccdb::BasicCCDBManager> ccdb; /// Accessing the CCDB
@@ -75,6 +77,18 @@ struct phianalysis {
     // 3d histogram
     histos.add("h3phiinvmass", "Invariant mass of Phi", kTH3F, {{100, 0.0f, 100.0f}, {100, 0.0f, 10.0f}, {500, 0.8, 1.3}});
     histos.add("h3phiinvmassME", "Invariant mass of Phi mixed event", kTH3F, {{100, 0.0f, 100.0f}, {100, 0.0f, 10.0f}, {500, 0.8, 1.3}});
+
+    if (doprocessBackgrounds) {
+      if (doprocessME) {
+        LOGF(fatal, "processME and processBackgrounds both fill the mixed-event histograms; enable only one of them");
+      }
+      histos.add("phiinvmassLS", "Invariant mass of Phi like sign", kTH1F, {{500, 0.8, 1.3, "Invariant Mass (GeV/#it{c}^2)"}});
+      histos.add("phiinvmassRot", "Invariant mass of Phi rotated", kTH1F, {{500, 0.8, 1.3, "Invariant Mass (GeV/#it{c}^2)"}});
+      histos.add("h3phiinvmassLS", "Invariant mass of Phi like sign", kTH3F, {{100, 0.0f, 100.0f}, {100, 0.0f, 10.0f}, {500, 0.8, 1.3}});
+      histos.add("h3phiinvmassRot", "Invariant mass of Phi rotated", kTH3F, {{100, 0.0f, 100.0f}, {100, 0.0f, 10.0f}, {500, 0.8, 1.3}});
+      mixingPool.setup(cfgMixingDepth);
+      eventKaons.assign(2, resonance::DaughterBuffer{{static_cast<float>(massKa)}});
+    }
   }
 
   double massKa = TDatabasePDG::Instance()->GetParticle(kKPlus)->Mass();
@@ -151,6 +165,63 @@ struct phianalysis {
     }
   };
   PROCESS_SWITCH(phianalysis, processME, "Process EventMixing", false);
+
+  /// Background estimation from the compact daughters and mixing keys of the initializer
+  Configurable<int> cfgMixingDepth{"cfgMixingDepth", 5, "Number of events mixed with each event"};
+  Configurable<float> cfgRotationAngle{"cfgRotationAngle", M_PI, "Rotation angle of the second daughter for the rotational background"};
+  resonance::MixingPool mixingPool;
+  std::vector<resonance::DaughterBuffer> eventKaons; // positive and negative kaons of the current event
+  resonance::DaughterBuffer rotatedKaons;
+
+  void processBackgrounds(soa::Join<aod::ResoCollisions, aod::ResoMixingKeys>::iterator const& collision, aod::ResoMixDaughters const& daughters)
+  {
+    auto& posKaons = eventKaons[0];
+    auto& negKaons = eventKaons[1];
+    posKaons.clear();
+    negKaons.clear();
+    for (auto& daughter : daughters) {
+      // same selection as parts1 and parts2
+      if ((daughter.tpcPIDselectionFlag() & aod::resodaughter::kKaon) != aod::resodaughter::kKaon) {
+        continue;
+      }
+      if ((daughter.tofPIDselectionFlag() & aod::resodaughter::kHasTOF) && (daughter.tofPIDselectionFlag() & aod::resodaughter::kKaon) != aod::resodaughter::kKaon) {
+        continue;
+      }
+      if (std::abs(daughter.dcaZ()) <= cMinDCAzToPVcut || std::abs(daughter.dcaZ()) >= cMaxDCAzToPVcut || std::abs(daughter.dcaXY()) >= cMaxDCArToPVcut) {
+        continue;
+      }
+      (daughter.sign() > 0 ? posKaons : negKaons).add(daughter.px(), daughter.py(), daughter.pz());
+    }
+
+    const resonance::PairCuts cuts{};
+    auto mult = collision.multV0M();
+    // like-sign pairs
+    auto fillLS = [&](resonance::PairBatch const& pairs) {
+      for (std::size_t iPair = 0; iPair < pairs.size; iPair++) {
+        histos.fill(HIST("phiinvmassLS"), pairs.mass[iPair]);
+        histos.fill(HIST("h3phiinvmassLS"), mult, pairs.pt[iPair], pairs.mass[iPair]);
+      }
+    };
+    resonance::combine(posKaons, 0, posKaons, 0, true, cuts, fillLS);
+    resonance::combine(negKaons, 0, negKaons, 0, true, cuts, fillLS);
+    // unlike-sign pairs with the negative kaon rotated
+    negKaons.getRotated(cfgRotationAngle, rotatedKaons);
+    resonance::combine(posKaons, 0, rotatedKaons, 0, false, cuts, [&](resonance::PairBatch const& pairs) {
+      for (std::size_t iPair = 0; iPair < pairs.size; iPair++) {
+        histos.fill(HIST("phiinvmassRot"), pairs.mass[iPair]);
+        histos.fill(HIST("h3phiinvmassRot"), mult, pairs.pt[iPair], pairs.mass[iPair]);
+      }
+    });
+    // unlike-sign pairs with the kaons of the previous events of the same category
+    mixingPool.combineMixed(collision.mixingBin(), eventKaons, 0, 0, 1, 0, cuts, [&](resonance::PairBatch const& pairs) {
+      for (std::size_t iPair = 0; iPair < pairs.size; iPair++) {
+        histos.fill(HIST("phiinvmassME"), pairs.mass[iPair]);
+        histos.fill(HIST("h3phiinvmassME"), mult, pairs.pt[iPair], pairs.mass[iPair]);
+      }
+    });
+    mixingPool.addEvent(collision.mixingBin(), eventKaons);
+  }
+  PROCESS_SWITCH(phianalysis, processBackgrounds, "Process like-sign, rotated and mixed-event backgrounds from the compact daughters", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -14,17 +14,20 @@
 /// \author Nicola Rubini <nrubini@cern.ch>
 
 // O2 includes
+#include "Common/Core/FourVector.h"
+#include "Common/Core/FrameArena.h"
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Framework/AnalysisTask.h"
 #include "Framework/runDataProcessing.h"
 #include "Framework/ASoAHelpers.h"
-#include "TLorentzVector.h"
+#include "PWGLF/Utils/resonancePairs.h"
 
 using namespace std;
 using namespace o2;
 using namespace o2::framework;
+using namespace o2::analysis;
 
 enum EventSelection { kNoSelection = 0,
                       kTVXselection = 1,
@@ -66,6 +69,17 @@ struct rsn_analysis {
   Configurable<float> kPionsTPCstda{"kPionsTPCstda", 3.,
                                     "TPC NSigma for Pions Standalone"};
   //
+  //  Selected daughters, with the energies for the kaon and pion mass
+  resonance::DaughterBuffer kPosSelectedKaons{{.493677f}};
+  resonance::DaughterBuffer kNegSelectedKaons{{.493677f}};
+  resonance::DaughterBuffer kPosSelectedPions{{.139570f}};
+  resonance::DaughterBuffer kNegSelectedPions{{.139570f}};
+  const resonance::PairCuts kPhiPairCuts{0.90f, 1.10f, 0.5f};
+  const resonance::PairCuts kKstarPairCuts{0.70f, 1.10f, 0.5f};
+  //
+  //  Memory of the selected daughters with their MC particle, reset for each collision
+  FrameArena kArena;
+  //
   HistogramRegistry uHistograms{
     "Histograms",
     {},
@@ -317,12 +331,11 @@ struct rsn_analysis {
     uHistograms.fill(HIST("QA/Event/EnumEvents"), EventSelection::kVertexCut);
     uHistograms.fill(HIST("QA/Event/Selected/VertexZ"), kCurrentCollision.posZ());
     //
-    //  Storage for Kaons
-    //  --- PX  PY  PZ  HasPositiveCharge
-    std::vector<std::tuple<Float_t, Float_t, Float_t>> kPosSelectedKaons;
-    std::vector<std::tuple<Float_t, Float_t, Float_t>> kNegSelectedKaons;
-    std::vector<std::tuple<Float_t, Float_t, Float_t>> kPosSelectedPions;
-    std::vector<std::tuple<Float_t, Float_t, Float_t>> kNegSelectedPions;
+    //  Storage for Kaons and Pions
+    kPosSelectedKaons.clear();
+    kNegSelectedKaons.clear();
+    kPosSelectedPions.clear();
+    kNegSelectedPions.clear();
     //
     //  Loop on Tracks
     for (auto kCurrentTrack : kTracks) {
@@ -335,200 +348,54 @@ struct rsn_analysis {
       //
       if (uIsKaonSelected(kCurrentTrack)) {
         if (kCurrentTrack.sign() > 0)
-          kPosSelectedKaons.push_back(std::tuple<Float_t, Float_t, Float_t>(
-            kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz()));
+          kPosSelectedKaons.add(kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz());
         else
-          kNegSelectedKaons.push_back(std::tuple<Float_t, Float_t, Float_t>(
-            kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz()));
+          kNegSelectedKaons.add(kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz());
       }
       //
       if (uIsPionSelected(kCurrentTrack)) {
         if (kCurrentTrack.sign() > 0)
-          kPosSelectedPions.push_back(std::tuple<Float_t, Float_t, Float_t>(
-            kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz()));
+          kPosSelectedPions.add(kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz());
         else
-          kNegSelectedPions.push_back(std::tuple<Float_t, Float_t, Float_t>(
-            kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz()));
+          kNegSelectedPions.add(kCurrentTrack.px(), kCurrentTrack.py(), kCurrentTrack.pz());
       }
     }
     //
-    //  Invariant Mass for Phi
-    TLorentzVector lPositiveDecayDaughter;
-    TLorentzVector lNegativeDecayDaughter;
-    TLorentzVector lResonanceCandidate;
-    Int_t iUtility = 0;
-    Int_t jUtility = 0;
-    for (auto kPosKaon : kPosSelectedKaons) {
-      iUtility++;
-      for (auto kNegKaon : kNegSelectedKaons) {
-        jUtility++;
-        if (iUtility == jUtility)
-          continue;
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.90 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Phi/FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Phi/PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+    auto fillPhi = [&](resonance::PairBatch const& kPairs) {
+      for (std::size_t iPair = 0; iPair < kPairs.size; iPair++) {
+        uHistograms.fill(HIST("Analysis/Phi/FullInvariantMass"), kPairs.mass[iPair]);
+        uHistograms.fill(HIST("Analysis/Phi/PTInvariantMass"), kPairs.pt[iPair], kPairs.mass[iPair]);
       }
-    }
-    iUtility = 0;
-    jUtility = 0;
-    for (auto kPosKaon : kPosSelectedKaons) {
-      iUtility++;
-      for (auto kNegKaon : kPosSelectedKaons) {
-        jUtility++;
-        if (iUtility == jUtility)
-          continue;
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.90 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Phi/BKG_FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Phi/BKG_PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+    };
+    auto fillPhiBkg = [&](resonance::PairBatch const& kPairs) {
+      for (std::size_t iPair = 0; iPair < kPairs.size; iPair++) {
+        uHistograms.fill(HIST("Analysis/Phi/BKG_FullInvariantMass"), kPairs.mass[iPair]);
+        uHistograms.fill(HIST("Analysis/Phi/BKG_PTInvariantMass"), kPairs.pt[iPair], kPairs.mass[iPair]);
       }
-    }
-    iUtility = 0;
-    jUtility = 0;
-    for (auto kPosKaon : kNegSelectedKaons) {
-      iUtility++;
-      for (auto kNegKaon : kNegSelectedKaons) {
-        jUtility++;
-        if (iUtility == jUtility)
-          continue;
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.90 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Phi/BKG_FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Phi/BKG_PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+    };
+    auto fillKstar = [&](resonance::PairBatch const& kPairs) {
+      for (std::size_t iPair = 0; iPair < kPairs.size; iPair++) {
+        uHistograms.fill(HIST("Analysis/Kstar/FullInvariantMass"), kPairs.mass[iPair]);
+        uHistograms.fill(HIST("Analysis/Kstar/PTInvariantMass"), kPairs.pt[iPair], kPairs.mass[iPair]);
       }
-    }
-    //  Invariant Mass for K*
-    for (auto kPosKaon : kPosSelectedKaons) {
-      for (auto kNegPion : kNegSelectedPions) {
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegPion), get<1>(kNegPion),
-                                       get<2>(kNegPion), .139570);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.70 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Kstar/FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Kstar/PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
-      }
-    }
-    for (auto kPosPion : kPosSelectedPions) {
-      for (auto kNegKaon : kNegSelectedKaons) {
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosPion), get<1>(kPosPion),
-                                       get<2>(kPosPion), .139570);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.70 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Kstar/FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Kstar/PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+    };
+    auto fillKstarBkg = [&](resonance::PairBatch const& kPairs) {
+      for (std::size_t iPair = 0; iPair < kPairs.size; iPair++) {
+        uHistograms.fill(HIST("Analysis/Kstar/BKG_FullInvariantMass"), kPairs.mass[iPair]);
+        uHistograms.fill(HIST("Analysis/Kstar/BKG_PTInvariantMass"), kPairs.pt[iPair], kPairs.mass[iPair]);
       }
-    }
-    for (auto kPosKaon : kPosSelectedKaons) {
-      for (auto kNegPion : kPosSelectedPions) {
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegPion), get<1>(kNegPion),
-                                       get<2>(kNegPion), .139570);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.70 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Kstar/BKG_FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Kstar/BKG_PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
-      }
-    }
-    for (auto kPosPion : kNegSelectedPions) {
-      for (auto kNegKaon : kNegSelectedKaons) {
-        //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosPion), get<1>(kPosPion),
-                                       get<2>(kPosPion), .139570);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
-        lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
-        //
-        if (lResonanceCandidate.Mag() < 0.70 ||
-            lResonanceCandidate.Mag() > 1.10)
-          continue;
-        if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
-          continue;
-        //
-        uHistograms.fill(HIST("Analysis/Kstar/BKG_FullInvariantMass"),
-                         lResonanceCandidate.Mag());
-        uHistograms.fill(HIST("Analysis/Kstar/BKG_PTInvariantMass"),
-                         lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
-      }
-    }
+    };
+    //
+    //  Invariant Mass for Phi: unlike-sign and like-sign pairs
+    resonance::combine(kPosSelectedKaons, 0, kNegSelectedKaons, 0, false, kPhiPairCuts, fillPhi);
+    resonance::combine(kPosSelectedKaons, 0, kPosSelectedKaons, 0, true, kPhiPairCuts, fillPhiBkg);
+    resonance::combine(kNegSelectedKaons, 0, kNegSelectedKaons, 0, true, kPhiPairCuts, fillPhiBkg);
+    //
+    //  Invariant Mass for K*: unlike-sign and like-sign pairs
+    resonance::combine(kPosSelectedKaons, 0, kNegSelectedPions, 0, false, kKstarPairCuts, fillKstar);
+    resonance::combine(kPosSelectedPions, 0, kNegSelectedKaons, 0, false, kKstarPairCuts, fillKstar);
+    resonance::combine(kPosSelectedKaons, 0, kPosSelectedPions, 0, false, kKstarPairCuts, fillKstarBkg);
+    resonance::combine(kNegSelectedPions, 0, kNegSelectedKaons, 0, false, kKstarPairCuts, fillKstarBkg);
   }
   PROCESS_SWITCH(rsn_analysis, processData, "Process Data", true);
   //
@@ -556,10 +423,18 @@ struct rsn_analysis {
     //
     //  Storage for Kaons
     //  --- PX  PY  PZ  HasPositiveCharge
-    std::vector<std::tuple<Float_t, Float_t, Float_t, o2::aod::McParticles::iterator>> kPosSelectedKaons;
-    std::vector<std::tuple<Float_t, Float_t, Float_t, o2::aod::McParticles::iterator>> kNegSelectedKaons;
-    std::vector<std::tuple<Float_t, Float_t, Float_t, o2::aod::McParticles::iterator>> kPosSelectedPions;
-    std::vector<std::tuple<Float_t, Float_t, Float_t, o2::aod::McParticles::iterator>> kNegSelectedPions;
+    using kSelectedDaughter = std::tuple<Float_t, Float_t, Float_t, o2::aod::McParticles::iterator>;
+    kArena.reset();
+    const ArenaAllocator<kSelectedDaughter> kAllocator(kArena);
+    ArenaVector<kSelectedDaughter> kPosSelectedKaons(kAllocator);
+    ArenaVector<kSelectedDaughter> kNegSelectedKaons(kAllocator);
+    ArenaVector<kSelectedDaughter> kPosSelectedPions(kAllocator);
+    ArenaVector<kSelectedDaughter> kNegSelectedPions(kAllocator);
+    const auto kNTracks = kTracks.size();
+    kPosSelectedKaons.reserve(kNTracks);
+    kNegSelectedKaons.reserve(kNTracks);
+    kPosSelectedPions.reserve(kNTracks);
+    kNegSelectedPions.reserve(kNTracks);
     //
     //  Loop on Tracks
     for (auto kCurrentTrack : kTracks) {
@@ -593,12 +468,12 @@ struct rsn_analysis {
     }
     //
     //  Invariant Mass for Phi
-    TLorentzVector lPositiveDecayDaughter;
-    TLorentzVector lNegativeDecayDaughter;
-    TLorentzVector lPositiveDecayDaughterMC;
-    TLorentzVector lNegativeDecayDaughterMC;
-    TLorentzVector lResonanceCandidate;
-    TLorentzVector lResonanceCandidateMC;
+    FourVector lPositiveDecayDaughter;
+    FourVector lNegativeDecayDaughter;
+    FourVector lPositiveDecayDaughterMC;
+    FourVector lNegativeDecayDaughterMC;
+    FourVector lResonanceCandidate;
+    FourVector lResonanceCandidateMC;
     Int_t iUtility = 0;
     Int_t jUtility = 0;
     //
@@ -609,23 +484,23 @@ struct rsn_analysis {
         if (iUtility == jUtility)
           continue;
         //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
-                                       get<2>(kNegKaon), .493677);
+        lPositiveDecayDaughter = FourVector::fromXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
+                                                      get<2>(kPosKaon), .493677);
+        lNegativeDecayDaughter = FourVector::fromXYZM(get<0>(kNegKaon), get<1>(kNegKaon),
+                                                      get<2>(kNegKaon), .493677);
         lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
         //
-        if (lResonanceCandidate.Mag() < 0.90 ||
-            lResonanceCandidate.Mag() > 1.10)
+        if (lResonanceCandidate.M() < 0.90 ||
+            lResonanceCandidate.M() > 1.10)
           continue;
         if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
           continue;
         //
         uHistograms.fill(HIST("Analysis/Phi/FullInvariantMass"),
-                         lResonanceCandidate.Mag());
+                         lResonanceCandidate.M());
         uHistograms.fill(HIST("Analysis/Phi/PTInvariantMass"),
                          lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+                         lResonanceCandidate.M());
         auto kPositiveDecayDaughterMC = get<3>(kPosKaon);
         auto kNegativeDecayDaughterMC = get<3>(kNegKaon);
         //
@@ -645,12 +520,12 @@ struct rsn_analysis {
         if (fabs(kResonanceMCTruthParticle.y()) > 0.5)
           continue;
         //
-        lPositiveDecayDaughterMC.SetXYZM(kPositiveDecayDaughterMC.px(), kPositiveDecayDaughterMC.py(), kPositiveDecayDaughterMC.pz(), .493677);
-        lNegativeDecayDaughterMC.SetXYZM(kNegativeDecayDaughterMC.px(), kNegativeDecayDaughterMC.py(), kNegativeDecayDaughterMC.pz(), .493677);
+        lPositiveDecayDaughterMC = FourVector::fromXYZM(kPositiveDecayDaughterMC.px(), kPositiveDecayDaughterMC.py(), kPositiveDecayDaughterMC.pz(), .493677);
+        lNegativeDecayDaughterMC = FourVector::fromXYZM(kNegativeDecayDaughterMC.px(), kNegativeDecayDaughterMC.py(), kNegativeDecayDaughterMC.pz(), .493677);
         lResonanceCandidateMC = lPositiveDecayDaughterMC + lNegativeDecayDaughterMC;
         //
         uHistograms.fill(HIST("Analysis/Phi/MassResolution"),
-                         lResonanceCandidate.Mag() - lResonanceCandidateMC.Mag(),
+                         lResonanceCandidate.M() - lResonanceCandidateMC.M(),
                          lResonanceCandidate.Pt());
         //
         uHistograms.fill(HIST("Analysis/Phi/Reconstructed"),
@@ -661,23 +536,23 @@ struct rsn_analysis {
     for (auto kPosKaon : kPosSelectedKaons) {
       for (auto kNegPion : kNegSelectedPions) {
         //
-        lPositiveDecayDaughter.SetXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
-                                       get<2>(kPosKaon), .493677);
-        lNegativeDecayDaughter.SetXYZM(get<0>(kNegPion), get<1>(kNegPion),
-                                       get<2>(kNegPion), .139570);
+        lPositiveDecayDaughter = FourVector::fromXYZM(get<0>(kPosKaon), get<1>(kPosKaon),
+                                                      get<2>(kPosKaon), .493677);
+        lNegativeDecayDaughter = FourVector::fromXYZM(get<0>(kNegPion), get<1>(kNegPion),
+                                                      get<2>(kNegPion), .139570);
         lResonanceCandidate = lPositiveDecayDaughter + lNegativeDecayDaughter;
         //
-        if (lResonanceCandidate.Mag() < 0.70 ||
-            lResonanceCandidate.Mag() > 1.10)
+        if (lResonanceCandidate.M() < 0.70 ||
+            lResonanceCandidate.M() > 1.10)
           continue;
         if (fabs(lResonanceCandidate.Rapidity()) > 0.5)
           continue;
         //
         uHistograms.fill(HIST("Analysis/Kstar/FullInvariantMass"),
-                         lResonanceCandidate.Mag());
+                         lResonanceCandidate.M());
         uHistograms.fill(HIST("Analysis/Kstar/PTInvariantMass"),
                          lResonanceCandidate.Pt(),
-                         lResonanceCandidate.Mag());
+                         lResonanceCandidate.M());
         auto kPositiveDecayDaughterMC = get<3>(kPosKaon);
         auto kNegativeDecayDaughterMC = get<3>(kNegPion);
         //
@@ -697,12 +572,12 @@ struct rsn_analysis {
         if (fabs(kResonanceMCTruthParticle.y()) > 0.5)
           continue;
         //
-        lPositiveDecayDaughterMC.SetXYZM(kPositiveDecayDaughterMC.px(), kPositiveDecayDaughterMC.py(), kPositiveDecayDaughterMC.pz(), .493677);
-        lNegativeDecayDaughterMC.SetXYZM(kNegativeDecayDaughterMC.px(), kNegativeDecayDaughterMC.py(), kNegativeDecayDaughterMC.pz(), .139570);
+        lPositiveDecayDaughterMC = FourVector::fromXYZM(kPositiveDecayDaughterMC.px(), kPositiveDecayDaughterMC.py(), kPositiveDecayDaughterMC.pz(), .493677);
+        lNegativeDecayDaughterMC = FourVector::fromXYZM(kNegativeDecayDaughterMC.px(), kNegativeDecayDaughterMC.py(), kNegativeDecayDaughterMC.pz(), .139570);
         lResonanceCandidateMC = lPositiveDecayDaughterMC + lNegativeDecayDaughterMC;
         //
         uHistograms.fill(HIST("Analysis/Kstar/MassResolution"),
-                         lResonanceCandidate.Mag() - lResonanceCandidateMC.Mag(),
+                         lResonanceCandidate.M() - lResonanceCandidateMC.M(),
                          lResonanceCandidate.Pt());
         uHistograms.fill(HIST("Analysis/Kstar/Reconstructed"),
                          kResonanceMCTruthParticle.pt());
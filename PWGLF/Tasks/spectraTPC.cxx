@@ -26,6 +26,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
+#include "PWGLF/Utils/spectraSpeciesHistogram.h"
 
 using namespace o2;
 using namespace o2::track;
@@ -52,6 +53,10 @@ struct tpcSpectra {
   Configurable<float> minP{"minP", 0.01, "Minimum momentum in range"};
   Configurable<float> maxP{"maxP", 20, "Maximum momentum in range"};
   Configurable<bool> isRun2{"isRun2", false, "Flag to process Run 2 data"};
+  Configurable<bool> fillNSigmaSpecies{"fillNSigmaSpecies", false, "Fill the TPC nsigma of all species in one (species, pT, nsigma) histogram"};
+  Configurable<int> nBinsNSigma{"nBinsNSigma", 200, "Number of bins for the NSigma"};
+  Configurable<float> minNSigma{"minNSigma", -10.f, "Minimum NSigma in range"};
+  Configurable<float> maxNSigma{"maxNSigma", 10.f, "Maximum NSigma in range"};
 
   // Histograms
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
@@ -71,7 +76,8 @@ struct tpcSpectra {
                                                      "dcaxyphi/Ka", "dcaxyphi/Pr", "dcaxyphi/De",
                                                      "dcaxyphi/Tr", "dcaxyphi/He", "dcaxyphi/Al"};
 
-  TrackSelection globalTrackswoPrim; // Track without cut for primaries
+  TrackSelection globalTrackswoPrim;                      // Track without cut for primaries
+  o2::analysis::spectra::SpeciesHistogram nsigmaSpecies; // TPC nsigma of all species
 
   void init(o2::framework::InitContext&)
   {
@@ -111,16 +117,30 @@ struct tpcSpectra {
       histos.add(hdcaz[i].data(), pT[i], kTH2F, {ptAxis, dcaZAxis});
       histos.add(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pT[i]), kTH2F, {phiAxis, dcaXyAxis});
     }
+
+    // TPC nsigma of all species, filled once per track
+    if (fillNSigmaSpecies) {
+      const AxisSpec speciesAxis{Np, -0.5, Np - 0.5, "Species"};
+      const AxisSpec nSigmaTPCAxis{nBinsNSigma, minNSigma, maxNSigma, "N_{#sigma}^{TPC}"};
+      auto hNSigma = histos.add<TH3>("nsigmatpc/species", "Quality tracks, |y| < 0.5", kTH3F, {speciesAxis, ptAxis, nSigmaTPCAxis});
+      for (int i = 0; i < Np; i++) {
+        hNSigma->GetXaxis()->SetBinLabel(i + 1, pT[i]);
+      }
+      nsigmaSpecies.setup(hNSigma);
+    }
   }
 
   template <PID::ID id, typename T>
-  void fillParticleHistos(const T& track)
+  void fillParticleHistos(const T& track, int ptBin)
   {
     const float y = TMath::ASinH(track.pt() / TMath::Sqrt(PID::getMass2(id) + track.pt() * track.pt()) * TMath::SinH(track.eta()));
     if (abs(y) > 0.5) {
       return;
     }
     const auto& nsigma = o2::aod::pidutils::tpcNSigma<id>(track);
+    if (fillNSigmaSpecies) {
+      nsigmaSpecies.fill(id, ptBin, nsigma);
+    }
     if (std::abs(nsigma) < 2) {
       histos.fill(HIST(hdcaxy[id]), track.pt(), track.dcaXY());
       histos.fill(HIST(hdcaz[id]), track.pt(), track.dcaZ());
@@ -175,15 +195,19 @@ struct tpcSpectra {
       histos.fill(HIST("p/Unselected"), track.p());
       histos.fill(HIST("pt/Unselected"), track.pt());
 
-      fillParticleHistos<PID::Electron>(track);
-      fillParticleHistos<PID::Muon>(track);
-      fillParticleHistos<PID::Pion>(track);
-      fillParticleHistos<PID::Kaon>(track);
-      fillParticleHistos<PID::Proton>(track);
-      fillParticleHistos<PID::Deuteron>(track);
-      fillParticleHistos<PID::Triton>(track);
-      fillParticleHistos<PID::Helium3>(track);
-      fillParticleHistos<PID::Alpha>(track);
+      const int ptBin = fillNSigmaSpecies ? nsigmaSpecies.getPtBin(track.pt()) : 0;
+      fillParticleHistos<PID::Electron>(track, ptBin);
+      fillParticleHistos<PID::Muon>(track, ptBin);
+      fillParticleHistos<PID::Pion>(track, ptBin);
+      fillParticleHistos<PID::Kaon>(track, ptBin);
+      fillParticleHistos<PID::Proton>(track, ptBin);
+      fillParticleHistos<PID::Deuteron>(track, ptBin);
+      fillParticleHistos<PID::Triton>(track, ptBin);
+      fillParticleHistos<PID::Helium3>(track, ptBin);
+      fillParticleHistos<PID::Alpha>(track, ptBin);
+    }
+    if (fillNSigmaSpecies) {
+      nsigmaSpecies.flush();
     }
   } // end of the process function
 };  // end of spectra task
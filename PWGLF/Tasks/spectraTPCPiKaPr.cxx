@@ -23,6 +23,7 @@
 #include "Framework/HistogramRegistry.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "PWGLF/Utils/spectraSpeciesHistogram.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -35,6 +36,7 @@ struct tpcSpectraPiKaPr {
   static constexpr std::string_view hp[Np] = {"p/El", "p/Mu", "p/Pi", "p/Ka", "p/Pr", "p/De", "p/Tr", "p/He", "p/Al"};
   static constexpr std::string_view hpt[Np] = {"pt/El", "pt/Mu", "pt/Pi", "pt/Ka", "pt/Pr", "pt/De", "pt/Tr", "pt/He", "pt/Al"};
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
+  o2::analysis::spectra::SpeciesHistogram nsigmaSpecies; // TPC nsigma of pi, K and p
 
   void init(o2::framework::InitContext&)
   {
@@ -44,6 +46,13 @@ struct tpcSpectraPiKaPr {
       histos.add(hp[i].data(), Form("%s;#it{p} (GeV/#it{c})", pT[i]), kTH1F, {{100, 0, 20}});
       histos.add(hpt[i].data(), Form("%s;#it{p}_{T} (GeV/#it{c})", pT[i]), kTH1F, {{100, 0, 20}});
     }
+    if (fillNSigmaSpecies) {
+      auto hNSigma = histos.add<TH3>("nsigmatpc/species", ";;#it{p}_{T} (GeV/#it{c});N_{#sigma}^{TPC}", kTH3F, {{3, 1.5, 4.5}, {100, 0, 20}, {200, -10, 10}});
+      for (int i = 2; i < 5; i++) {
+        hNSigma->GetXaxis()->SetBinLabel(i - 1, pT[i]);
+      }
+      nsigmaSpecies.setup(hNSigma);
+    }
   }
 
   template <std::size_t i, typename T>
@@ -60,21 +69,30 @@ struct tpcSpectraPiKaPr {
   Configurable<float> cfgNSigmaCut{"cfgNSigmaCut", 3, "Value of the Nsigma cut"};
   Configurable<float> cfgCutVertex{"cfgCutVertex", 10.0f, "Accepted z-vertex range"};
   Configurable<float> cfgCutEta{"cfgCutEta", 0.8f, "Eta range for tracks"};
+  Configurable<bool> fillNSigmaSpecies{"fillNSigmaSpecies", false, "Fill the TPC nsigma of pi, K and p in one (species, pT, nsigma) histogram"};
   Filter collisionFilter = nabs(aod::collision::posZ) < cfgCutVertex;
   Filter trackFilter = (nabs(aod::track::eta) < cfgCutEta) && (requireGlobalTrackInFilter());
   using TrackCandidates = soa::Filtered<soa::Join<aod::Tracks, aod::TracksExtra,
                                                   aod::pidTPCFullPi, aod::pidTPCFullKa, aod::pidTPCFullPr,
                                                   aod::TrackSelection>>;
 
-  void process(TrackCandidates::iterator const& track)
+  void process(TrackCandidates const& tracks)
   {
-    histos.fill(HIST("p/Unselected"), track.p());
-    histos.fill(HIST("pt/Unselected"), track.pt());
-
-    fillParticleHistos<2>(track, track.tpcNSigmaPi());
-    fillParticleHistos<3>(track, track.tpcNSigmaKa());
-    fillParticleHistos<4>(track, track.tpcNSigmaPr());
+    for (const auto& track : tracks) {
+      histos.fill(HIST("p/Unselected"), track.p());
+      histos.fill(HIST("pt/Unselected"), track.pt());
 
+      const std::array<float, 3> nsigma = {track.tpcNSigmaPi(), track.tpcNSigmaKa(), track.tpcNSigmaPr()};
+      fillParticleHistos<2>(track, nsigma[0]);
+      fillParticleHistos<3>(track, nsigma[1]);
+      fillParticleHistos<4>(track, nsigma[2]);
+      if (fillNSigmaSpecies) {
+        nsigmaSpecies.fill(nsigmaSpecies.getPtBin(track.pt()), nsigma, {true, true, true});
+      }
+    }
+    if (fillNSigmaSpecies) {
+      nsigmaSpecies.flush();
+    }
   } // end of the process function
 };
 
@@ -0,0 +1,72 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file qaSampling.h
+/// \brief Deterministic sampling of the collisions filled in the QA histograms
+///
+/// Whether a collision is sampled only depends on its run, its bunch crossing and the seed, and not on the
+/// splitting of the input into jobs and data frames. The QA tasks of a train configured with the same seed and
+/// fraction therefore fill the same collisions, and a fraction of 1 keeps all of them without any lookup.
+
+#ifndef ANALYSIS_TASKS_PWGLF_QASAMPLING_H_
+#define ANALYSIS_TASKS_PWGLF_QASAMPLING_H_
+
+#include <cstdint>
+
+namespace o2::analysis
+{
+
+class QASampling
+{
+ public:
+  /// \param fraction  fraction of the collisions sampled, all of them if >= 1
+  /// \param seed  seed of the sampling, collisions sampled in one task are also sampled with the same seed in the others
+  void init(float fraction, uint64_t seed = 0)
+  {
+    mKeepAll = fraction >= 1.f;
+    mThreshold = fraction <= 0.f ? 0 : static_cast<uint64_t>(static_cast<double>(fraction) * 0x1.0p53);
+    mSeed = seed;
+  }
+
+  /// \return whether all the collisions are sampled, in which case the BC does not need to be looked up
+  bool keepsAll() const { return mKeepAll; }
+
+  /// \return whether the collision of the bunch crossing is sampled
+  bool accept(uint64_t run, uint64_t globalBC) const
+  {
+    if (mKeepAll) {
+      return true;
+    }
+    // splitmix64 finalizer of the key
+    uint64_t x = (run << 44) ^ globalBC ^ (mSeed * 0x9e3779b97f4a7c15ULL);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x = x ^ (x >> 31);
+    return (x >> 11) < mThreshold;
+  }
+
+  /// \param bc  bunch crossing of the collision, with the runNumber and globalBC columns
+  template <typename TBC>
+  bool accept(TBC const& bc) const
+  {
+    return mKeepAll || accept(bc.runNumber(), bc.globalBC());
+  }
+
+ private:
+  bool mKeepAll = true;
+  uint64_t mThreshold = 0; ///< sampled if the 53-bit hash is below
+  uint64_t mSeed = 0;
+};
+
+} // namespace o2::analysis
+
+#endif // ANALYSIS_TASKS_PWGLF_QASAMPLING_H_
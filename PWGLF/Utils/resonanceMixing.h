@@ -0,0 +1,114 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file resonanceMixing.h
+/// \brief Event mixing pool of resonance decay daughters
+///
+/// The pool keeps the daughter buffers (see resonancePairs.h) of the last events of each mixing category,
+/// so that the mixed-event background is built from the compact daughters of the derived data
+/// while streaming through the collisions, without reloading the tracks.
+
+#ifndef ANALYSIS_TASKS_PWGLF_RESONANCEMIXING_H_
+#define ANALYSIS_TASKS_PWGLF_RESONANCEMIXING_H_
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "PWGLF/Utils/resonancePairs.h"
+
+namespace o2::analysis::resonance
+{
+
+/// \param edgesVtx  z-vertex bin edges
+/// \param edgesMult  multiplicity bin edges
+/// \param vtxZ  z-vertex of the collision
+/// \param mult  multiplicity of the collision
+/// \return mixing category of the collision, -1 if outside the binning
+inline int getMixingBin(std::vector<double> const& edgesVtx, std::vector<double> const& edgesMult, float vtxZ, float mult)
+{
+  auto findBin = [](std::vector<double> const& edges, double value) {
+    if (edges.size() < 2 || value < edges.front() || value >= edges.back()) {
+      return -1;
+    }
+    return static_cast<int>(std::distance(edges.begin(), std::upper_bound(edges.begin(), edges.end(), value))) - 1;
+  };
+  int binVtx = findBin(edgesVtx, vtxZ);
+  int binMult = findBin(edgesMult, mult);
+  if (binVtx < 0 || binMult < 0) {
+    return -1;
+  }
+  return binVtx * (static_cast<int>(edgesMult.size()) - 1) + binMult;
+}
+
+/// Daughters of the previous events of each mixing category
+/// \note An event is a vector of daughter buffers, one per species and charge, in a fixed order chosen by the task.
+class MixingPool
+{
+ public:
+  /// \param depth  number of events kept per category
+  void setup(int depth)
+  {
+    mPools.clear();
+    mDepth = depth;
+  }
+
+  /// Combines the daughters of the current event with those of the pooled events of the same category.
+  /// Both orders are taken: current first with pooled second, and pooled first with current second.
+  /// \param bin  mixing category of the current event
+  /// \param current  daughter buffers of the current event
+  /// \param iFirst  buffer of the first daughters
+  /// \param massFirst  index of the mass hypothesis of the first daughters
+  /// \param iSecond  buffer of the second daughters
+  /// \param massSecond  index of the mass hypothesis of the second daughters
+  /// \param cuts  kinematic selection of the pairs
+  /// \param fill  function called with each batch of selected pairs
+  template <typename F>
+  void combineMixed(int bin, std::vector<DaughterBuffer> const& current, int iFirst, int massFirst, int iSecond, int massSecond, PairCuts const& cuts, F&& fill) const
+  {
+    if (bin < 0 || bin >= static_cast<int>(mPools.size())) {
+      return;
+    }
+    for (auto const& pooled : mPools[bin]) {
+      combine(current[iFirst], massFirst, pooled[iSecond], massSecond, false, cuts, fill);
+      combine(pooled[iFirst], massFirst, current[iSecond], massSecond, false, cuts, fill);
+    }
+  }
+
+  /// Adds the current event to the pool of its category, dropping the oldest one beyond the depth.
+  /// \param bin  mixing category of the current event
+  /// \param current  daughter buffers of the current event
+  void addEvent(int bin, std::vector<DaughterBuffer> const& current)
+  {
+    if (bin < 0) {
+      return;
+    }
+    if (bin >= static_cast<int>(mPools.size())) {
+      mPools.resize(bin + 1);
+    }
+    auto& pool = mPools[bin];
+    if (static_cast<int>(pool.size()) >= mDepth) {
+      pool.pop_front();
+    }
+    if (mDepth > 0) {
+      pool.push_back(current);
+    }
+  }
+
+ private:
+  std::vector<std::deque<std::vector<DaughterBuffer>>> mPools{}; ///< pooled events per mixing category, grown with the categories seen
+  int mDepth = 0;                                                ///< number of events kept per category
+};
+
+} // namespace o2::analysis::resonance
+
+#endif // ANALYSIS_TASKS_PWGLF_RESONANCEMIXING_H_
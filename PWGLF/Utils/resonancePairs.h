@@ -0,0 +1,168 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file resonancePairs.h
+/// \brief Pairing of resonance decay daughters stored as structure of arrays
+///
+/// The daughters of one species and charge are kept in contiguous float arrays,
+/// with their energies computed once for each mass hypothesis.
+/// The pair kinematics are evaluated in blocks by branch-free loops the compiler can vectorise,
+/// and the selected pairs are passed to the filling function in batches.
+/// The same combination serves unlike-sign, like-sign (same buffer) and mixed-event (buffers of two collisions) pairs.
+
+#ifndef ANALYSIS_TASKS_PWGLF_RESONANCEPAIRS_H_
+#define ANALYSIS_TASKS_PWGLF_RESONANCEPAIRS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace o2::analysis::resonance
+{
+
+/// Selected daughters of one species and charge
+class DaughterBuffer
+{
+ public:
+  /// \param masses  mass hypotheses for which the energies are computed
+  explicit DaughterBuffer(std::vector<float> const& masses = {}) : mMasses(masses), mE(masses.size()) {}
+
+  void clear()
+  {
+    mPx.clear();
+    mPy.clear();
+    mPz.clear();
+    mIndex.clear();
+    for (auto& e : mE) {
+      e.clear();
+    }
+  }
+
+  /// Adds a daughter.
+  /// \param px  momentum x component
+  /// \param py  momentum y component
+  /// \param pz  momentum z component
+  /// \param index  user index of the daughter, e.g. the track global index
+  void add(float px, float py, float pz, int index = -1)
+  {
+    mPx.push_back(px);
+    mPy.push_back(py);
+    mPz.push_back(pz);
+    mIndex.push_back(index);
+    float p2 = px * px + py * py + pz * pz;
+    for (std::size_t iMass = 0; iMass < mMasses.size(); ++iMass) {
+      mE[iMass].push_back(std::sqrt(p2 + mMasses[iMass] * mMasses[iMass]));
+    }
+  }
+
+  /// Rotates the daughters in the transverse plane, for the rotational background.
+  /// \param angle  rotation angle around the beam axis
+  /// \param rotated  rotated copy of the daughters, the energies are unchanged
+  void getRotated(float angle, DaughterBuffer& rotated) const
+  {
+    rotated = *this;
+    float cosAngle = std::cos(angle), sinAngle = std::sin(angle);
+    for (std::size_t i = 0; i < mPx.size(); ++i) {
+      rotated.mPx[i] = cosAngle * mPx[i] - sinAngle * mPy[i];
+      rotated.mPy[i] = sinAngle * mPx[i] + cosAngle * mPy[i];
+    }
+  }
+
+  std::size_t size() const { return mPx.size(); }
+  const float* px() const { return mPx.data(); }
+  const float* py() const { return mPy.data(); }
+  const float* pz() const { return mPz.data(); }
+  /// \param iMass  index of the mass hypothesis
+  const float* e(int iMass) const { return mE[iMass].data(); }
+  int index(std::size_t i) const { return mIndex[i]; }
+
+ private:
+  std::vector<float> mMasses;          ///< mass hypotheses
+  std::vector<float> mPx, mPy, mPz;    ///< momentum components
+  std::vector<std::vector<float>> mE;  ///< energies for each mass hypothesis
+  std::vector<int> mIndex;             ///< user indices
+};
+
+/// Kinematic selection of the pairs
+struct PairCuts {
+  float massMin = 0.f;
+  float massMax = 1.e10f;
+  float rapidityMax = 1.e10f;
+};
+
+/// Batch of selected pairs passed to the filling function
+struct PairBatch {
+  static constexpr std::size_t capacity = 256;
+  std::size_t size = 0;
+  float mass[capacity];
+  float pt[capacity];
+  float y[capacity];
+  int first[capacity];  ///< position of the first daughter in its buffer
+  int second[capacity]; ///< position of the second daughter in its buffer
+};
+
+/// Combines the daughters of two buffers and passes the selected pairs to fill(PairBatch const&).
+/// \param first  first daughters
+/// \param massFirst  index of the mass hypothesis of the first daughters
+/// \param second  second daughters
+/// \param massSecond  index of the mass hypothesis of the second daughters
+/// \param isSameBuffer  first and second are the same daughters (like-sign pairs): each pair is taken once and no daughter is paired with itself
+/// \param cuts  kinematic selection of the pairs
+/// \param fill  function called with each batch of selected pairs
+template <typename F>
+void combine(DaughterBuffer const& first, int massFirst, DaughterBuffer const& second, int massSecond, bool isSameBuffer, PairCuts const& cuts, F&& fill)
+{
+  constexpr std::size_t blockSize = PairBatch::capacity;
+  float mass[blockSize], pt[blockSize], y[blockSize];
+  PairBatch batch;
+
+  const float *px2 = second.px(), *py2 = second.py(), *pz2 = second.pz(), *e2 = second.e(massSecond);
+  const float *px1 = first.px(), *py1 = first.py(), *pz1 = first.pz(), *e1 = first.e(massFirst);
+  for (std::size_t i = 0; i < first.size(); ++i) {
+    for (std::size_t jBegin = isSameBuffer ? i + 1 : 0; jBegin < second.size(); jBegin += blockSize) {
+      std::size_t n = std::min(blockSize, second.size() - jBegin);
+      // kinematics of the block, no branches
+      for (std::size_t k = 0; k < n; ++k) {
+        std::size_t j = jBegin + k;
+        float px = px1[i] + px2[j];
+        float py = py1[i] + py2[j];
+        float pz = pz1[i] + pz2[j];
+        float e = e1[i] + e2[j];
+        mass[k] = std::sqrt(std::max(0.f, e * e - px * px - py * py - pz * pz));
+        pt[k] = std::sqrt(px * px + py * py);
+        y[k] = 0.5f * std::log((e + pz) / (e - pz));
+      }
+      // selection and compaction into the batch
+      for (std::size_t k = 0; k < n; ++k) {
+        if (mass[k] < cuts.massMin || mass[k] > cuts.massMax || std::abs(y[k]) > cuts.rapidityMax) {
+          continue;
+        }
+        batch.mass[batch.size] = mass[k];
+        batch.pt[batch.size] = pt[k];
+        batch.y[batch.size] = y[k];
+        batch.first[batch.size] = i;
+        batch.second[batch.size] = jBegin + k;
+        if (++batch.size == PairBatch::capacity) {
+          fill(static_cast<PairBatch const&>(batch));
+          batch.size = 0;
+        }
+      }
+    }
+  }
+  if (batch.size > 0) {
+    fill(static_cast<PairBatch const&>(batch));
+  }
+}
+
+} // namespace o2::analysis::resonance
+
+#endif // ANALYSIS_TASKS_PWGLF_RESONANCEPAIRS_H_
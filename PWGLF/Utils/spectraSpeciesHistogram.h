@@ -0,0 +1,139 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file spectraSpeciesHistogram.h
+/// \brief Dense (species, pT, nsigma) counts of the spectra tasks, filled for all species at once
+///
+/// The pT bin of a track is found once and the nsigma bins of all species are computed by arithmetic
+/// on the uniform nsigma axis, instead of one histogram fill with a bin search per species.
+/// The counts are added to a TH3 with the axes (species, pT, nsigma) when flushed.
+
+#ifndef ANALYSIS_TASKS_PWGLF_SPECTRASPECIESHISTOGRAM_H_
+#define ANALYSIS_TASKS_PWGLF_SPECTRASPECIESHISTOGRAM_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <TH3.h>
+
+namespace o2::analysis::spectra
+{
+
+/// Counts of the nsigma of several species in bins of pT
+/// \note The bins follow the ROOT numbering, including the underflow and overflow bins,
+/// so that the flushed histogram is the same as if it had been filled track by track.
+/// The nsigma axis must have uniform bins.
+class SpeciesHistogram
+{
+ public:
+  /// \param histogram  histogram with the axes (species, pT, nsigma) to which the counts are added
+  void setup(std::shared_ptr<TH3> histogram)
+  {
+    mHistogram = histogram;
+    mNSpecies = histogram->GetXaxis()->GetNbins();
+    auto ptAxis = histogram->GetYaxis();
+    mPtEdges.resize(ptAxis->GetNbins() + 1);
+    for (int iBin = 0; iBin <= ptAxis->GetNbins(); ++iBin) {
+      mPtEdges[iBin] = ptAxis->GetBinLowEdge(iBin + 1);
+    }
+    auto nsigmaAxis = histogram->GetZaxis();
+    mNBinsNSigma = nsigmaAxis->GetNbins();
+    mMinNSigma = nsigmaAxis->GetXmin();
+    mMaxNSigma = nsigmaAxis->GetXmax();
+    mCounts.assign(static_cast<std::size_t>(mNSpecies) * (mPtEdges.size() + 1) * (mNBinsNSigma + 2), 0);
+    mFilledCells.clear();
+    mEntries = 0;
+  }
+
+  /// \param pt  track pT
+  /// \return pT bin of the track, same as TAxis::FindBin
+  int getPtBin(double pt) const
+  {
+    return static_cast<int>(std::distance(mPtEdges.begin(), std::upper_bound(mPtEdges.begin(), mPtEdges.end(), pt)));
+  }
+
+  /// Adds the nsigma of one species.
+  /// \param species  index of the species, i.e. the species bin - 1
+  /// \param ptBin  pT bin of the track from getPtBin
+  /// \param nsigma  nsigma of the track for the species
+  void fill(int species, int ptBin, double nsigma)
+  {
+    int nsigmaBin = 0;
+    if (nsigma >= mMaxNSigma) {
+      nsigmaBin = mNBinsNSigma + 1;
+    } else if (nsigma >= mMinNSigma) {
+      nsigmaBin = 1 + static_cast<int>(mNBinsNSigma * (nsigma - mMinNSigma) / (mMaxNSigma - mMinNSigma));
+    }
+    std::size_t cell = (static_cast<std::size_t>(species) * (mPtEdges.size() + 1) + ptBin) * (mNBinsNSigma + 2) + nsigmaBin;
+    if (mCounts[cell]++ == 0) {
+      mFilledCells.push_back(cell);
+    }
+    ++mEntries;
+  }
+
+  /// Adds the nsigma of all species of a track.
+  /// \param ptBin  pT bin of the track from getPtBin
+  /// \param nsigma  nsigma of the track for each species
+  /// \param isSelected  species for which the track is counted
+  template <std::size_t N>
+  void fill(int ptBin, std::array<float, N> const& nsigma, std::array<bool, N> const& isSelected)
+  {
+    for (std::size_t iSpecies = 0; iSpecies < N; ++iSpecies) {
+      if (isSelected[iSpecies]) {
+        fill(iSpecies, ptBin, nsigma[iSpecies]);
+      }
+    }
+  }
+
+  /// Adds the counts to the histogram and clears them.
+  void flush()
+  {
+    if (mEntries == 0) {
+      return;
+    }
+    const std::size_t nCellsNSigma = mNBinsNSigma + 2;
+    const std::size_t nCellsPt = mPtEdges.size() + 1;
+    const bool hasSumw2 = mHistogram->GetSumw2N() > 0;
+    for (auto cell : mFilledCells) {
+      const int nsigmaBin = cell % nCellsNSigma;
+      const int ptBin = (cell / nCellsNSigma) % nCellsPt;
+      const int species = cell / nCellsNSigma / nCellsPt;
+      const int bin = mHistogram->GetBin(species + 1, ptBin, nsigmaBin);
+      mHistogram->AddBinContent(bin, mCounts[cell]);
+      if (hasSumw2) {
+        mHistogram->GetSumw2()->fArray[bin] += mCounts[cell];
+      }
+      mCounts[cell] = 0;
+    }
+    mHistogram->SetEntries(mHistogram->GetEntries() + mEntries);
+    mFilledCells.clear();
+    mEntries = 0;
+  }
+
+ private:
+  std::shared_ptr<TH3> mHistogram = nullptr; ///< histogram with the axes (species, pT, nsigma)
+  int mNSpecies = 0;                          ///< number of species
+  std::vector<double> mPtEdges{};             ///< pT bin edges
+  int mNBinsNSigma = 0;                       ///< number of nsigma bins
+  double mMinNSigma = 0.;                     ///< lower edge of the nsigma axis
+  double mMaxNSigma = 0.;                     ///< upper edge of the nsigma axis
+  std::vector<unsigned int> mCounts{};        ///< counts of the (species, pT, nsigma) cells, underflow and overflow included
+  std::vector<std::size_t> mFilledCells{};    ///< cells with counts since the last flush
+  std::size_t mEntries = 0;                   ///< number of fills since the last flush
+};
+
+} // namespace o2::analysis::spectra
+
+#endif // ANALYSIS_TASKS_PWGLF_SPECTRASPECIESHISTOGRAM_H_
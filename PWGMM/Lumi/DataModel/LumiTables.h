@@ -0,0 +1,54 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_ANALYSIS_LUMITABLES_H_
+#define O2_ANALYSIS_LUMITABLES_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace lumiwindow
+{
+DECLARE_SOA_COLUMN(RunNumber, runNumber, int);          //! run of the window
+DECLARE_SOA_COLUMN(FirstGlobalBC, firstGlobalBC, uint64_t); //! first global BC of the window
+DECLARE_SOA_COLUMN(Timestamp, timestamp, uint64_t);     //! timestamp of the first BC of the window found in the data (ms)
+DECLARE_SOA_COLUMN(NBCs, nBCs, int32_t);                //! number of BCs of the window found in the data
+DECLARE_SOA_COLUMN(NCollisions, nCollisions, int32_t);  //! number of collisions of the window
+DECLARE_SOA_COLUMN(NSelected, nSelected, int32_t);      //! number of collisions passing the vertex selection
+DECLARE_SOA_COLUMN(SumX, sumX, float);                  //! sum of the x of the selected vertices
+DECLARE_SOA_COLUMN(SumY, sumY, float);                  //! sum of the y of the selected vertices
+DECLARE_SOA_COLUMN(SumX2, sumX2, float);                //! sum of the x^2 of the selected vertices
+DECLARE_SOA_COLUMN(SumY2, sumY2, float);                //! sum of the y^2 of the selected vertices
+DECLARE_SOA_DYNAMIC_COLUMN(MeanX, meanX,                //! mean x of the selected vertices
+                           [](int32_t n, float sum) -> float { return n > 0 ? sum / n : 0.f; });
+DECLARE_SOA_DYNAMIC_COLUMN(MeanY, meanY, //! mean y of the selected vertices
+                           [](int32_t n, float sum) -> float { return n > 0 ? sum / n : 0.f; });
+DECLARE_SOA_DYNAMIC_COLUMN(RMSX, rmsX, //! standard deviation of the x of the selected vertices
+                           [](int32_t n, float sum, float sum2) -> float { return n > 0 ? std::sqrt(std::max(0.f, sum2 / n - (sum / n) * (sum / n))) : 0.f; });
+DECLARE_SOA_DYNAMIC_COLUMN(RMSY, rmsY, //! standard deviation of the y of the selected vertices
+                           [](int32_t n, float sum, float sum2) -> float { return n > 0 ? std::sqrt(std::max(0.f, sum2 / n - (sum / n) * (sum / n))) : 0.f; });
+} // namespace lumiwindow
+
+DECLARE_SOA_TABLE(LumiWindows, "AOD", "LUMIWINDOW", //! Collision counts and vertex moments per orbit window
+                  lumiwindow::RunNumber, lumiwindow::FirstGlobalBC, lumiwindow::Timestamp,
+                  lumiwindow::NBCs, lumiwindow::NCollisions, lumiwindow::NSelected,
+                  lumiwindow::SumX, lumiwindow::SumY, lumiwindow::SumX2, lumiwindow::SumY2,
+                  lumiwindow::MeanX<lumiwindow::NSelected, lumiwindow::SumX>,
+                  lumiwindow::MeanY<lumiwindow::NSelected, lumiwindow::SumY>,
+                  lumiwindow::RMSX<lumiwindow::NSelected, lumiwindow::SumX, lumiwindow::SumX2>,
+                  lumiwindow::RMSY<lumiwindow::NSelected, lumiwindow::SumY, lumiwindow::SumY2>);
+using LumiWindow = LumiWindows::iterator;
+} // namespace o2::aod
+#endif // O2_ANALYSIS_LUMITABLES_H_
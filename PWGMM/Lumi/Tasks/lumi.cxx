@@ -15,6 +15,7 @@
 // o2-analysis-trackselection -b --isRun3 0 | o2-analysis-mm-lumi -b
 // --configuration json://./config.json
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <iostream>
@@ -40,10 +41,13 @@
 #include "ReconstructionDataFormats/Vertex.h"
 
 #include "CCDB/BasicCCDBManager.h"
+#include "CommonConstants/LHCConstants.h"
 #include "DataFormatsParameters/GRPObject.h"
 
 #include "DetectorsBase/Propagator.h"
 
+#include "PWGMM/Lumi/DataModel/LumiTables.h"
+
 #include "CommonUtils/NameConf.h"
 
 #include "CCDB/BasicCCDBManager.h"
@@ -57,6 +61,9 @@ struct lumiTask {
   const char* ccdbpath_grp = "GLO/GRP/GRP";
   const char* ccdburl = "http://alice-ccdb.cern.ch";
   int mRunNumber;
+  o2::vertexing::PVertexer vertexer;
+
+  Produces<aod::LumiWindows> lumiWindows;
 
   Configurable<uint64_t> ftts{"ftts", 1530319778000,
                               "First time of time stamp"};
@@ -64,6 +71,8 @@ struct lumiTask {
                                 "Maximum number of contributors"};
   Configurable<int> nContribMin{"nContribMin", 10,
                                 "Minimum number of contributors"};
+  Configurable<int> nOrbitsPerWindow{"nOrbitsPerWindow", 1000,
+                                     "Number of orbits of the windows of the lumi time series"};
 
   HistogramRegistry histos{
     "histos",
@@ -108,12 +117,42 @@ struct lumiTask {
     mRunNumber = 0;
   }
 
-  void process(aod::Collision const& collision, aod::BCsWithTimestamps const&,
-               o2::soa::Join<o2::aod::Tracks, o2::aod::TrackSelection,
-                             o2::aod::TracksCov, o2::aod::TracksExtra,
-                             o2::aod::TracksDCA> const& tracks,
-               o2::soa::Join<o2::aod::Tracks, o2::aod::TracksCov,
-                             o2::aod::TracksExtra> const& unfiltered_tracks)
+  // magnetic field and vertexer, set up once per run
+  void initRun(aod::BCsWithTimestamps::iterator const& bc)
+  {
+    if (mRunNumber == bc.runNumber()) {
+      return;
+    }
+    auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(
+      ccdbpath_grp, bc.timestamp());
+    if (grpo != nullptr) {
+      o2::base::Propagator::initFieldFromGRP(grpo);
+    } else {
+      LOGF(fatal,
+           "GRP object is not available in CCDB for run=%d at timestamp=%llu",
+           bc.runNumber(), bc.timestamp());
+    }
+    // configure PVertexer
+    o2::conf::ConfigurableParam::updateFromString(
+      "pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o
+                                                  // MeanVertex constraint
+    vertexer.init();
+    mRunNumber = bc.runNumber();
+  }
+
+  bool isSelectedVertex(aod::Collision const& collision)
+  {
+    return collision.chi2() / collision.numContrib() <= 4 &&
+           collision.numContrib() <= nContribMax &&
+           collision.numContrib() >= nContribMin;
+  }
+
+  void processCollision(aod::Collision const& collision, aod::BCsWithTimestamps const&,
+                        o2::soa::Join<o2::aod::Tracks, o2::aod::TrackSelection,
+                                      o2::aod::TracksCov, o2::aod::TracksExtra,
+                                      o2::aod::TracksDCA> const& tracks,
+                        o2::soa::Join<o2::aod::Tracks, o2::aod::TracksCov,
+                                      o2::aod::TracksExtra> const& unfiltered_tracks)
   {
 
     auto bc = collision.bc_as<aod::BCsWithTimestamps>();
@@ -139,18 +178,7 @@ struct lumiTask {
 
     std::vector<bool> vec_useTrk_PVrefit(vec_globID_contr.size(), true);
 
-    if (mRunNumber != bc.runNumber()) {
-      auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(
-        ccdbpath_grp, bc.timestamp());
-      if (grpo != nullptr) {
-        o2::base::Propagator::initFieldFromGRP(grpo);
-      } else {
-        LOGF(fatal,
-             "GRP object is not available in CCDB for run=%d at timestamp=%llu",
-             bc.runNumber(), bc.timestamp());
-      }
-      mRunNumber = bc.runNumber();
-    }
+    initRun(bc);
 
     o2::dataformats::VertexBase Pvtx;
     Pvtx.setX(collision.posX());
@@ -158,15 +186,7 @@ struct lumiTask {
     Pvtx.setZ(collision.posZ());
     Pvtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(),
                 collision.covXZ(), collision.covYZ(), collision.covZZ());
-    // configure PVertexer
 
-    o2::dataformats::VertexBase PVbase_recalculated;
-
-    o2::vertexing::PVertexer vertexer;
-    o2::conf::ConfigurableParam::updateFromString(
-      "pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o
-                                                  // MeanVertex constraint
-    vertexer.init();
     bool PVrefit_doable = vertexer.prepareVertexRefit(vec_TrkContributos, Pvtx);
     double chi2;
     double refitX;
@@ -194,10 +214,7 @@ struct lumiTask {
                   refitY);
     }
     histos.fill(HIST("chisquare"), collision.chi2());
-    if (collision.chi2() / collision.numContrib() > 4)
-      return;
-    if (collision.numContrib() > nContribMax ||
-        collision.numContrib() < nContribMin)
+    if (!isSelectedVertex(collision))
       return;
 
     histos.fill(HIST("vertexx"), collision.posX());
@@ -216,6 +233,69 @@ struct lumiTask {
     }
 
   } // need selections
+  PROCESS_SWITCH(lumiTask, processCollision, "Vertex distributions and refit per collision", true);
+
+  // lumi time series: counts and vertex moments per window of nOrbitsPerWindow orbits,
+  // from one pass over the BCs and one over the collisions
+  struct Window {
+    int64_t key;
+    int runNumber;
+    uint64_t firstGlobalBC;
+    uint64_t timestamp;
+    int32_t nBCs = 0;
+    int32_t nCollisions = 0;
+    int32_t nSelected = 0;
+    double sumX = 0.;
+    double sumY = 0.;
+    double sumX2 = 0.;
+    double sumY2 = 0.;
+  };
+  std::vector<Window> windows;
+
+  void processWindows(aod::BCsWithTimestamps const& bcs, aod::Collisions const& collisions)
+  {
+    const uint64_t windowBCs = (uint64_t)nOrbitsPerWindow * o2::constants::lhc::LHCMaxBunches;
+    // the BCs are ordered in global BC, so are the windows
+    windows.clear();
+    for (const auto& bc : bcs) {
+      const int64_t key = bc.globalBC() / windowBCs;
+      if (windows.empty() || windows.back().key != key || windows.back().runNumber != bc.runNumber()) {
+        windows.push_back({key, bc.runNumber(), key * windowBCs, bc.timestamp()});
+      }
+      windows.back().nBCs++;
+    }
+    if (windows.empty()) {
+      return;
+    }
+
+    for (const auto& collision : collisions) {
+      if (!collision.has_bc()) {
+        continue;
+      }
+      const int64_t key = collision.bc_as<aod::BCsWithTimestamps>().globalBC() / windowBCs;
+      auto window = std::lower_bound(windows.begin(), windows.end(), key,
+                                     [](Window const& w, int64_t k) { return w.key < k; });
+      if (window == windows.end() || window->key != key) {
+        continue;
+      }
+      window->nCollisions++;
+      if (!isSelectedVertex(collision)) {
+        continue;
+      }
+      window->nSelected++;
+      window->sumX += collision.posX();
+      window->sumY += collision.posY();
+      window->sumX2 += collision.posX() * collision.posX();
+      window->sumY2 += collision.posY() * collision.posY();
+    }
+
+    for (const auto& window : windows) {
+      lumiWindows(window.runNumber, window.firstGlobalBC, window.timestamp,
+                  window.nBCs, window.nCollisions, window.nSelected,
+                  window.sumX, window.sumY, window.sumX2, window.sumY2);
+    }
+  }
+  PROCESS_SWITCH(lumiTask, processWindows, "Lumi time series per orbit window", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -0,0 +1,143 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file denseCounts.h
+/// \brief Dense 2D counts accumulated over one collision and added to TH2 histograms when flushed
+///
+/// The tracks of a collision share the z vertex, so most of their (eta, zvtx) fills land in a few cells:
+/// the counts are accumulated in uint32 cells and each filled cell is added once to the histograms,
+/// instead of one histogram fill per track.
+
+#ifndef PWGMM_MULT_CORE_DENSECOUNTS_H_
+#define PWGMM_MULT_CORE_DENSECOUNTS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <TH2.h>
+
+namespace o2::analysis::mult
+{
+
+/// Bins of one axis, with the ROOT numbering (0 underflow, nbins + 1 overflow)
+class DenseAxis
+{
+ public:
+  void setup(TAxis const* axis)
+  {
+    mNBins = axis->GetNbins();
+    mMin = axis->GetXmin();
+    mMax = axis->GetXmax();
+    mIsUniform = axis->GetXbins()->GetSize() == 0;
+    mEdges.clear();
+    if (!mIsUniform) {
+      mEdges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + mNBins + 1);
+    }
+  }
+
+  /// \return bin of x, same as TAxis::FindFixBin
+  int findBin(double x) const
+  {
+    if (x < mMin) {
+      return 0;
+    }
+    if (x >= mMax) {
+      return mNBins + 1;
+    }
+    if (mIsUniform) {
+      return std::min(mNBins, 1 + static_cast<int>(mNBins * (x - mMin) / (mMax - mMin)));
+    }
+    return static_cast<int>(std::distance(mEdges.begin(), std::upper_bound(mEdges.begin(), mEdges.end(), x)));
+  }
+
+  int getNCells() const { return mNBins + 2; }
+
+ private:
+  int mNBins = 0;
+  double mMin = 0.;
+  double mMax = 0.;
+  bool mIsUniform = true;
+  std::vector<double> mEdges{};
+};
+
+/// Counts of a TH2 between two flushes
+class DenseCounts2D
+{
+ public:
+  /// \param histogram  histogram to which the counts are added, it defines the binning
+  void setup(std::shared_ptr<TH2> histogram)
+  {
+    mHistogram = histogram;
+    mXAxis.setup(histogram->GetXaxis());
+    mYAxis.setup(histogram->GetYaxis());
+    mCounts.assign(static_cast<std::size_t>(mXAxis.getNCells()) * mYAxis.getNCells(), 0);
+    mFilledCells.clear();
+    mEntries = 0;
+  }
+
+  void fill(double x, double y)
+  {
+    std::size_t cell = static_cast<std::size_t>(mYAxis.findBin(y)) * mXAxis.getNCells() + mXAxis.findBin(x);
+    if (mCounts[cell]++ == 0) {
+      mFilledCells.push_back(cell);
+    }
+    ++mEntries;
+  }
+
+  /// Adds the counts to the histogram and to the optional partition histogram (e.g. of the current run), and clears them.
+  /// \param partition  histogram with the same binning as the one of setup, can be null
+  void flush(std::shared_ptr<TH2> const& partition = nullptr)
+  {
+    if (mEntries == 0) {
+      return;
+    }
+    add(mHistogram.get());
+    if (partition) {
+      add(partition.get());
+    }
+    for (auto cell : mFilledCells) {
+      mCounts[cell] = 0;
+    }
+    mFilledCells.clear();
+    mEntries = 0;
+  }
+
+ private:
+  void add(TH2* histogram) const
+  {
+    const bool hasSumw2 = histogram->GetSumw2N() > 0;
+    for (auto cell : mFilledCells) {
+      const int binX = cell % mXAxis.getNCells();
+      const int binY = cell / mXAxis.getNCells();
+      const int bin = histogram->GetBin(binX, binY);
+      histogram->AddBinContent(bin, mCounts[cell]);
+      if (hasSumw2) {
+        histogram->GetSumw2()->fArray[bin] += mCounts[cell];
+      }
+    }
+    histogram->SetEntries(histogram->GetEntries() + mEntries);
+  }
+
+  std::shared_ptr<TH2> mHistogram = nullptr; ///< histogram to which the counts are added
+  DenseAxis mXAxis;                          ///< x bins
+  DenseAxis mYAxis;                          ///< y bins
+  std::vector<uint32_t> mCounts{};           ///< counts of the (x, y) cells, underflow and overflow included
+  std::vector<std::size_t> mFilledCells{};   ///< cells with counts since the last flush
+  std::size_t mEntries = 0;                  ///< number of fills since the last flush
+};
+
+} // namespace o2::analysis::mult
+
+#endif // PWGMM_MULT_CORE_DENSECOUNTS_H_
@@ -0,0 +1,35 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef O2_ANALYSIS_FLATENICITY_H_
+#define O2_ANALYSIS_FLATENICITY_H_
+
+#include "Framework/AnalysisDataModel.h"
+namespace o2::aod
+{
+namespace flat
+{
+DECLARE_SOA_COLUMN(FlatenicityFV0, flatenicityFV0, float);   //! Flatenicity of the FV0 cells, 9999 if not computed
+DECLARE_SOA_COLUMN(FlatenicityMFT, flatenicityMFT, float);   //! Flatenicity of the MFT tracks in 2x8 eta-phi cells
+DECLARE_SOA_COLUMN(FlatenicityGlob, flatenicityGlob, float); //! Flatenicity of the global tracks in 4x8 eta-phi cells
+DECLARE_SOA_COLUMN(FlatenicityFT0A, flatenicityFT0A, float); //! Flatenicity of the FT0A sectors
+DECLARE_SOA_COLUMN(FlatenicityFT0C, flatenicityFT0C, float); //! Flatenicity of the FT0C sectors
+DECLARE_SOA_COLUMN(AmpFV0, ampFV0, float);                   //! Summed FV0 amplitude, calibrated as configured
+DECLARE_SOA_COLUMN(MultMFT, multMFT, float);                 //! Number of MFT tracks in -3.6 < eta < -2.5, calibrated as configured
+DECLARE_SOA_COLUMN(MultGlob, multGlob, int);                 //! Number of global tracks
+} // namespace flat
+DECLARE_SOA_TABLE(Flatenicities, "AOD", "FLATENICITY", //! Flatenicity estimators, joinable with the collisions
+                  flat::FlatenicityFV0, flat::FlatenicityMFT, flat::FlatenicityGlob,
+                  flat::FlatenicityFT0A, flat::FlatenicityFT0C,
+                  flat::AmpFV0, flat::MultMFT, flat::MultGlob);
+using Flatenicity = Flatenicities::iterator;
+} // namespace o2::aod
+#endif // O2_ANALYSIS_FLATENICITY_H_
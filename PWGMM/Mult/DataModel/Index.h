@@ -20,5 +20,13 @@ namespace idx
 DECLARE_SOA_ARRAY_INDEX_COLUMN(Track, tracks);
 }
 DECLARE_SOA_TABLE(ParticlesToTracks, "AOD", "P2T", idx::TrackIds);
+
+namespace fwdreassoc
+{
+DECLARE_SOA_INDEX_COLUMN_FULL(BestCollision, bestCollision, int32_t, Collisions, ""); //! collision with the smallest DCAxy
+DECLARE_SOA_COLUMN(BestDCAXY, bestDCAXY, float);                                      //! DCAxy to the best collision
+} // namespace fwdreassoc
+DECLARE_SOA_TABLE(BestCollisionsFwd, "AOD", "BESTCOLLFWD", //! Reassociation of the ambiguous MFT tracks to the collision with the smallest DCAxy
+                  ambiguous::MFTTrackId, fwdreassoc::BestCollisionId, fwdreassoc::BestDCAXY);
 } // namespace o2::aod
 #endif // O2_ANALYSIS_INDEX_H_
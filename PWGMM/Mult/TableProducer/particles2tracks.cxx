@@ -29,18 +29,46 @@ struct ParticlesToTracks {
   using LabeledTracks = soa::Join<aod::Tracks, aod::McTrackLabels>;
   Produces<aod::ParticlesToTracks> p2t;
   std::vector<int> trackIds;
+  std::vector<int> offsets;
+  std::vector<int> positions;
+  std::vector<int> sortedTrackIds;
 
   void init(InitContext&)
   {
   }
 
-  void processIndexing(aod::McParticle const&, soa::SmallGroups<LabeledTracks> const& tracks)
+  // the labeled tracks are sorted by particle with a counting sort, in one pass over the
+  // tracks of the data frame, instead of grouping the tracks for each particle
+  // the tracks of a particle keep the order of the tracks table
+  void processIndexing(aod::McParticles const& particles, LabeledTracks const& tracks)
   {
-    trackIds.clear();
+    const auto nParticles = particles.size();
+    offsets.assign(nParticles + 1, 0);
     for (auto& track : tracks) {
-      trackIds.push_back(track.globalIndex());
+      auto id = track.mcParticleId();
+      if (id >= 0 && id < nParticles) {
+        ++offsets[id + 1];
+      }
+    }
+    for (auto i = 0; i < nParticles; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+
+    // tracks of particle i are in [offsets[i], offsets[i + 1])
+    sortedTrackIds.resize(offsets[nParticles]);
+    positions.assign(offsets.begin(), offsets.end() - 1);
+    for (auto& track : tracks) {
+      auto id = track.mcParticleId();
+      if (id >= 0 && id < nParticles) {
+        sortedTrackIds[positions[id]++] = track.globalIndex();
+      }
+    }
+
+    p2t.reserve(nParticles);
+    for (auto i = 0; i < nParticles; ++i) {
+      trackIds.assign(sortedTrackIds.begin() + offsets[i], sortedTrackIds.begin() + offsets[i + 1]);
+      p2t(trackIds);
     }
-    p2t(trackIds);
   }
 
   PROCESS_SWITCH(ParticlesToTracks, processIndexing, "Create reverse index from particles to tracks", false);
@@ -26,6 +26,8 @@
 #include "TDatabasePDG.h"
 #include "MathUtils/Utils.h"
 
+#include "Index.h"
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
@@ -68,6 +70,11 @@ struct PseudorapidityDensityMFT {
     x->SetBinLabel(6, "BCs with collisions");
     x->SetBinLabel(7, "BCs with pile-up/splitting");
 
+    if (doprocessReassociated) {
+      registry.add({"TracksEtaZvtxReassoc", "; #eta; Z_{vtx}; tracks", {HistType::kTH2F, {{18, -4.6, -1.}, ZAxis}}});
+      registry.add({"TracksPhiEtaReassoc", "; #varphi; #eta; tracks", {HistType::kTH2F, {{600, 0, 2 * M_PI}, {18, -4.6, -1.}}}});
+    }
+
     if (doprocessGen) {
       registry.add({"EventsNtrkZvtxGen", "; N_{trk}; Z_{vtx}; events", {HistType::kTH2F, {{301, -0.5, 300.5}, ZAxis}}});
       registry.add({"EventsNtrkZvtxGen_t", "; N_{trk}; Z_{vtx}; events", {HistType::kTH2F, {{301, -0.5, 300.5}, ZAxis}}});
@@ -146,6 +153,23 @@ struct PseudorapidityDensityMFT {
     }
   }
 
+  // ambiguous MFT tracks counted in the collision they are reassociated to by vertexing-fwd
+  void processReassociated(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, aod::BestCollisionsFwd const& besttracks, aod::MFTTracks const&)
+  {
+    if (!useEvSel || (useEvSel && collision.sel8())) {
+      auto z = collision.posZ();
+      for (auto& besttrack : besttracks) {
+        auto track = besttrack.mfttrack();
+        registry.fill(HIST("TracksEtaZvtxReassoc"), track.eta(), z);
+        float phi = track.phi();
+        o2::math_utils::bringTo02Pi(phi);
+        registry.fill(HIST("TracksPhiEtaReassoc"), phi, track.eta());
+      }
+    }
+  }
+
+  PROCESS_SWITCH(PseudorapidityDensityMFT, processReassociated, "Process the ambiguous tracks reassociated by vertexing-fwd", false);
+
   using Particles = soa::Filtered<aod::McParticles>;
   expressions::Filter primaries = (aod::mcparticle::flags & (uint8_t)o2::aod::mcparticle::enums::PhysicalPrimary) == (uint8_t)o2::aod::mcparticle::enums::PhysicalPrimary;
   Partition<Particles> mcSample = (aod::mcparticle::eta < -2.8f) && (aod::mcparticle::eta > -3.2f);
@@ -9,11 +9,15 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include <array>
 #include <cmath>
+#include <map>
+#include <memory>
 
 #include "Common/CCDB/EventSelectionParams.h"
 #include "Common/DataModel/Centrality.h"
 #include "Common/DataModel/EventSelection.h"
+#include "Common/DataModel/McPrimaries.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "CommonConstants/MathConstants.h"
@@ -24,6 +28,7 @@
 #include "Framework/RuntimeError.h"
 #include "Framework/runDataProcessing.h"
 #include "Index.h"
+#include "PWGMM/Mult/Core/denseCounts.h"
 #include "ReconstructionDataFormats/GlobalTrackID.h"
 #include "TDatabasePDG.h"
 
@@ -81,6 +86,23 @@ struct MultiplicityCounter {
   Configurable<float> estimatorEta{"estimatorEta", 1.0, "eta range for INEL>0 sample definition"};
   Configurable<bool> useEvSel{"useEvSel", true, "use event selection"};
   Configurable<bool> fillResponse{"fillResponse", false, "Fill response matrix"};
+  Configurable<bool> splitByRun{"splitByRun", false, "Also fill the dN/deta histograms of each run"};
+
+  // dense counts of the track histograms of processCounting, added to the histograms after each collision
+  o2::analysis::mult::DenseCounts2D etaZvtxCounts;
+  o2::analysis::mult::DenseCounts2D etaZvtxGt0Counts;
+  o2::analysis::mult::DenseCounts2D phiEtaCounts;
+  o2::analysis::mult::DenseCounts2D extraEtaZvtxCounts;
+  o2::analysis::mult::DenseCounts2D extraPhiEtaCounts;
+
+  // histograms of the runs (NtrkZvtx, EtaZvtx, EtaZvtx_gt0), filled with splitByRun
+  enum RunHistograms { kNtrkZvtx = 0,
+                       kEtaZvtx,
+                       kEtaZvtxGt0,
+                       kNRunHistograms };
+  std::map<int, std::array<std::shared_ptr<TH2>, kNRunHistograms>> runHistograms;
+  int currentRun = -1;
+  std::array<std::shared_ptr<TH2>, kNRunHistograms> currentRunHistograms{};
 
   HistogramRegistry registry{
     "registry",
@@ -112,7 +134,7 @@ struct MultiplicityCounter {
     x->SetBinLabel(6, "BCs with collisions");
     x->SetBinLabel(7, "BCs with pile-up/splitting");
 
-    if (doprocessGen) {
+    if (doprocessGen || doprocessGenPrimaries) {
       registry.add({"Events/NtrkZvtxGen", "; N_{trk}; Z_{vtx} (cm); events", {HistType::kTH2F, {MultAxis, ZAxis}}});
       registry.add({"Events/NtrkZvtxGen_t", "; N_{part}; Z_{vtx} (cm); events", {HistType::kTH2F, {MultAxis, ZAxis}}});
       registry.add({"Tracks/EtaZvtxGen", "; #eta; Z_{vtx} (cm); tracks", {HistType::kTH2F, {EtaAxis, ZAxis}}});
@@ -142,6 +164,14 @@ struct MultiplicityCounter {
       x->SetBinLabel(5, "Selected INEL>0");
     }
 
+    if (doprocessCounting) {
+      etaZvtxCounts.setup(registry.get<TH2>(HIST("Tracks/EtaZvtx")));
+      etaZvtxGt0Counts.setup(registry.get<TH2>(HIST("Tracks/EtaZvtx_gt0")));
+      phiEtaCounts.setup(registry.get<TH2>(HIST("Tracks/PhiEta")));
+      extraEtaZvtxCounts.setup(registry.get<TH2>(HIST("Tracks/Control/ExtraTracksEtaZvtx")));
+      extraPhiEtaCounts.setup(registry.get<TH2>(HIST("Tracks/Control/ExtraTracksPhiEta")));
+    }
+
     if (doprocessTrackEfficiency) {
       registry.add({"Tracks/Control/PtGen", " ; p_{T} (GeV/c)", {HistType::kTH1F, {PtAxis}}});
       registry.add({"Tracks/Control/PtEfficiency", " ; p_{T} (GeV/c)", {HistType::kTH1F, {PtAxis}}});
@@ -194,6 +224,21 @@ struct MultiplicityCounter {
 
   PROCESS_SWITCH(MultiplicityCounter, processEventStat, "Collect event sample stats", false);
 
+  // histograms of a run, booked at its first collision
+  void setCurrentRun(int run)
+  {
+    currentRun = run;
+    auto found = runHistograms.find(run);
+    if (found != runHistograms.end()) {
+      currentRunHistograms = found->second;
+      return;
+    }
+    currentRunHistograms[kNtrkZvtx] = registry.add<TH2>(fmt::format("Runs/{}/Events/NtrkZvtx", run).c_str(), "; N_{trk}; Z_{vtx} (cm); events", HistType::kTH2F, {MultAxis, ZAxis});
+    currentRunHistograms[kEtaZvtx] = registry.add<TH2>(fmt::format("Runs/{}/Tracks/EtaZvtx", run).c_str(), "; #eta; Z_{vtx} (cm); tracks", HistType::kTH2F, {EtaAxis, ZAxis});
+    currentRunHistograms[kEtaZvtxGt0] = registry.add<TH2>(fmt::format("Runs/{}/Tracks/EtaZvtx_gt0", run).c_str(), "; #eta; Z_{vtx} (cm); tracks", HistType::kTH2F, {EtaAxis, ZAxis});
+    runHistograms[run] = currentRunHistograms;
+  }
+
   expressions::Filter trackSelectionProper = ((aod::track::trackCutFlag & trackSelectionITS) == trackSelectionITS) &&
                                              ifnode((aod::track::detectorMap & (uint8_t)o2::aod::track::TPC) == (uint8_t)o2::aod::track::TPC,
                                                     (aod::track::trackCutFlag & trackSelectionTPC) == trackSelectionTPC,
@@ -211,10 +256,14 @@ struct MultiplicityCounter {
 
   void processCounting(
     soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision,
+    aod::BCs const&,
     FiTracks const& tracks,
     soa::SmallGroups<soa::Join<aod::AmbiguousTracks, aod::BestCollisions>> const& atracks)
   {
     registry.fill(HIST("Events/Selection"), 1.);
+    if (splitByRun && collision.bc().runNumber() != currentRun) {
+      setCurrentRun(collision.bc().runNumber());
+    }
     if (!useEvSel || collision.sel8()) {
       registry.fill(HIST("Events/Selection"), 2.);
       auto z = collision.posZ();
@@ -224,31 +273,40 @@ struct MultiplicityCounter {
         registry.fill(HIST("Events/Selection"), 3.);
       }
       registry.fill(HIST("Events/NtrkZvtx"), Ntrk, z);
+      if (splitByRun) {
+        currentRunHistograms[kNtrkZvtx]->Fill(Ntrk, z);
+      }
 
       for (auto& track : tracks) {
-        registry.fill(HIST("Tracks/EtaZvtx"), track.eta(), z);
-        registry.fill(HIST("Tracks/PhiEta"), track.phi(), track.eta());
+        etaZvtxCounts.fill(track.eta(), z);
+        phiEtaCounts.fill(track.phi(), track.eta());
         registry.fill(HIST("Tracks/Control/PtEta"), track.pt(), track.eta());
         registry.fill(HIST("Tracks/Control/DCAXYPt"), track.pt(), track.dcaXY());
         registry.fill(HIST("Tracks/Control/DCAZPt"), track.pt(), track.dcaZ());
         if (Ntrk > 0) {
-          registry.fill(HIST("Tracks/EtaZvtx_gt0"), track.eta(), z);
+          etaZvtxGt0Counts.fill(track.eta(), z);
         }
       }
 
       for (auto& track : atracks) {
-        registry.fill(HIST("Tracks/EtaZvtx"), track.etas(), z);
-        registry.fill(HIST("Tracks/PhiEta"), track.phis(), track.etas());
-        registry.fill(HIST("Tracks/Control/ExtraTracksEtaZvtx"), track.etas(), z);
-        registry.fill(HIST("Tracks/Control/ExtraTracksPhiEta"), track.phis(), track.etas());
+        etaZvtxCounts.fill(track.etas(), z);
+        phiEtaCounts.fill(track.phis(), track.etas());
+        extraEtaZvtxCounts.fill(track.etas(), z);
+        extraPhiEtaCounts.fill(track.phis(), track.etas());
         registry.fill(HIST("Tracks/Control/PtEta"), track.pts(), track.etas());
         registry.fill(HIST("Tracks/Control/DCAXYPt"), track.pts(), track.bestDCAXY());
         registry.fill(HIST("Tracks/Control/DCAZPt"), track.pts(), track.bestDCAZ());
         if (Ntrk > 0) {
-          registry.fill(HIST("Tracks/EtaZvtx_gt0"), track.etas(), z);
+          etaZvtxGt0Counts.fill(track.etas(), z);
         }
       }
 
+      etaZvtxCounts.flush(currentRunHistograms[kEtaZvtx]);
+      etaZvtxGt0Counts.flush(currentRunHistograms[kEtaZvtxGt0]);
+      phiEtaCounts.flush();
+      extraEtaZvtxCounts.flush();
+      extraPhiEtaCounts.flush();
+
     } else {
       registry.fill(HIST("Events/Selection"), 4.);
     }
@@ -492,6 +550,41 @@ struct MultiplicityCounter {
   }
 
   PROCESS_SWITCH(MultiplicityCounter, processGen, "Process generator-level info", false);
+
+  // generator-level histograms of processGen, from the compact table of the mc-primaries task, without the reconstructed collisions
+  void processGenPrimaries(aod::McCollisions::iterator const& mcCollision, aod::McPrimaries const& particles)
+  {
+    auto nCharged = 0;
+    auto nInSample = 0;
+    for (auto& particle : particles) {
+      if (std::abs(particle.eta()) >= estimatorEta) {
+        continue;
+      }
+      nInSample++;
+      if (particle.isCharged()) {
+        nCharged++;
+      }
+    }
+    registry.fill(HIST("Events/NtrkZvtxGen_t"), nCharged, mcCollision.posZ());
+    registry.fill(HIST("Events/Efficiency"), 1.);
+    if (nCharged > 0) {
+      registry.fill(HIST("Events/Efficiency"), 2.);
+    }
+
+    for (auto& particle : particles) {
+      if (!particle.isCharged()) {
+        continue;
+      }
+      registry.fill(HIST("Tracks/EtaZvtxGen_t"), particle.eta(), mcCollision.posZ());
+      registry.fill(HIST("Tracks/Control/PtEtaGen"), particle.pt(), particle.eta());
+      if (nInSample > 0) {
+        registry.fill(HIST("Tracks/EtaZvtxGen_gt0t"), particle.eta(), mcCollision.posZ());
+      }
+      registry.fill(HIST("Tracks/PhiEtaGen"), particle.phi(), particle.eta());
+    }
+  }
+
+  PROCESS_SWITCH(MultiplicityCounter, processGenPrimaries, "Process generator-level info of the McPrimaries table only", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -9,6 +9,7 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include "Common/Core/SparseOutput.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/DataModel/EventSelection.h"
@@ -21,11 +22,13 @@
 #include "Framework/StaticFor.h"
 #include "Framework/runDataProcessing.h"
 #include "ReconstructionDataFormats/Track.h"
+#include "Flatenicity.h"
 #include <TF1.h>
 #include <TH1F.h>
 #include <TH2F.h>
 #include <TGraph.h>
 #include <TRandom.h>
+#include <array>
 #include <cmath>
 #include <vector>
 
@@ -34,12 +37,15 @@ using namespace o2::framework;
 using namespace o2::framework::expressions;
 
 struct flatenictyFV0 {
+  Produces<aod::Flatenicities> flatenicityTable;
 
   Configurable<bool> isMC{"isMC", false, "option to flag mc"};
   Configurable<bool> isRun3{"isRun3", true, "Is Run3 dataset"};
   Configurable<bool> applyCalibCh{"applyCalibCh", false, "equalize FV0"};
   Configurable<bool> applyCalibVtx{"applyCalibVtx", false, "equalize FV0 vs vtx"};
   Configurable<bool> applyNorm{"applyNorm", false, "normalization to eta"};
+  Configurable<bool> useSparseOutput{"useSparseOutput", false, "book the 2D histograms as THnSparse, which store and merge only the filled bins"};
+  Configurable<bool> fillChannelHistos{"fillChannelHistos", true, "fill the per-channel amplitude histograms"};
   // acceptance cuts
   Configurable<float> cfgTrkEtaCut{"cfgTrkEtaCut", 1.5f,
                                    "Eta range for tracks"};
@@ -58,8 +64,72 @@ struct flatenictyFV0 {
   static constexpr std::string_view nhPtEst[16] = {
     "ptVsGlobaltrack", "ptVsFDDAFDDCFT0CFV0MFT", "ptVsFDDAFDDCFV0MFT", "ptVsFV0MFT", "ptVsFV0", "ptVsMFTmult", "ptVs1flatencityFV0", "ptVs1flatencitytrkMFT", "ptVs1flatencitytrkMFTFV0", "ptVs1flatencityMFTFV0", "ptVsMFTmultFT0A", "ptVsFT0", "ptVs1flatencityFT0", "ptVs1flatencityMFTFT0A", "ptVsFV0FT0C", "ptVs1flatencityFV0FT0C"};
 
+  static constexpr float calib[48] = {1.01697, 1.122, 1.03854, 1.108, 1.11634, 1.14971, 1.19321, 1.06866, 0.954675, 0.952695, 0.969853, 0.957557, 0.989784, 1.01549, 1.02182, 0.976005, 1.01865, 1.06871, 1.06264, 1.02969, 1.07378, 1.06622, 1.15057, 1.0433, 0.83654, 0.847178, 0.890027, 0.920814, 0.888271, 1.04662, 0.8869, 0.856348, 0.863181, 0.906312, 0.902166, 1.00122, 1.03303, 0.887866, 0.892437, 0.906278, 0.884976, 0.864251, 0.917221, 1.10618, 1.04028, 0.893184, 0.915734, 0.892676};
+  // calibration T0C
+  static constexpr float calibT0C[28] = {0.949829, 1.05408, 1.00681, 1.00724, 0.990663, 0.973571, 0.9855, 1.03726, 1.02526, 1.00467, 0.983008, 0.979349, 0.952352, 0.985775, 1.013, 1.01721, 0.993948, 0.996421, 0.971871, 1.02921, 0.989641, 1.01885, 1.01259, 0.929502, 1.03969, 1.02496, 1.01385, 1.01711};
+  // calibration T0A
+  static constexpr float calibT0A[24] = {0.86041, 1.10607, 1.17724, 0.756397, 1.14954, 1.0879, 0.829438, 1.09014, 1.16515, 0.730077, 1.06722, 0.906344, 0.824167, 1.14716, 1.20692, 0.755034, 1.11734, 1.00556, 0.790522, 1.09138, 1.16225, 0.692458, 1.12428, 1.01127};
+  // calibration FDA
+  static constexpr float calibFDA[8] = {0.933485, 1.00743, 0.768484, 0.837354, 1.26397, 1.2159, 0.876259, 1.00434};
+  // calibration FDC
+  static constexpr float calibFDC[8] = {0.772909, 1.95841, 0.966258, 0.913508, 0.96176, 0.650286, 0.619638, 0.694932};
+  // calibration factor MFT vs vtx
+  static constexpr float biningVtxt[30] = {-14.5, -13.5, -12.5, -11.5, -10.5, -9.5, -8.5, -7.5, -6.5, -5.5, -4.5, -3.5, -2.5, -1.5, -0.5, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5, 10.5, 11.5, 12.5, 13.5, 14.5};
+  static constexpr float calibMFTvtx[30] = {1.27106, 1.239, 1.23555, 1.21115, 1.18538, 1.16585, 1.15052, 1.11002, 1.09909, 1.07341, 1.05511, 1.04538, 1.02291, 1.01254, 0.994646, 0.981465, 0.962609, 0.955254, 0.942117, 0.932826, 0.925284, 0.906386, 0.904621, 0.887349, 0.884237, 0.860509, 0.853699, 0.836858, 0.819485, 0.802514};
+
+  // calibration factor FV0 vs vtx
+  static constexpr float calibFV0vtx[30] = {0.907962, 0.934607, 0.938929, 0.950987, 0.950817, 0.966362, 0.968509, 0.972741, 0.982412, 0.984872, 0.994543, 0.996003, 0.99435, 1.00266, 0.998245, 1.00584, 1.01078, 1.01003, 1.00726, 1.00872, 1.01726, 1.02015, 1.0193, 1.01106, 1.02229, 1.02104, 1.03435, 1.00822, 1.01921, 1.01736};
+  // calibration FT0A vs vtx
+  static constexpr float calibFT0Avtx[30] = {0.924334, 0.950988, 0.959604, 0.965607, 0.970016, 0.979057, 0.978384, 0.982005, 0.992825, 0.990048, 0.998588, 0.997338, 1.00102, 1.00385, 0.99492, 1.01083, 1.00703, 1.00494, 1.00063, 1.0013, 1.00777, 1.01238, 1.01179, 1.00577, 1.01028, 1.017, 1.02975, 1.0085, 1.00856, 1.01662};
+  // calibration FT0C vs vtx
+  static constexpr float calibFT0Cvtx[30] = {1.02096, 1.01245, 1.02148, 1.03605, 1.03561, 1.03667, 1.04229, 1.0327, 1.03674, 1.02764, 1.01828, 1.02331, 1.01864, 1.015, 1.01197, 1.00615, 0.996845, 0.993051, 0.985635, 0.982883, 0.981914, 0.964635, 0.967812, 0.95475, 0.956687, 0.932816, 0.92773, 0.914892, 0.891724, 0.872382};
+  // calibration FDA vs vtx
+  static constexpr float calibFDAvtx[30] = {1.05852, 1.07943, 1.03542, 1.02851, 1.00617, 1.01377, 0.997411, 1.00899, 0.98556, 0.994506, 0.999267, 0.997915, 0.993361, 0.988509, 0.993386, 0.992661, 0.997844, 1.00428, 0.991939, 0.995139, 0.999882, 1.00976, 1.01239, 0.989125, 1.01432, 1.00652, 1.02114, 1.00582, 0.996546, 1.05708};
+  // calibration FDC vs vtx
+  static constexpr float calibFDCvtx[30] = {0.965937, 0.924875, 0.903078, 0.901217, 0.914662, 0.933606, 0.899319, 0.912335, 0.900467, 0.928819, 0.943352, 0.955755, 0.954358, 0.939799, 0.973757, 0.972073, 1.00221, 0.997195, 1.01809, 1.02407, 1.02722, 1.05898, 1.09503, 1.13893, 1.12981, 1.15516, 1.17394, 1.28468, 1.37351, 1.24345};
+
+  static constexpr int nCellsFV0 = 48; // 48 sectors in FV0
+  static constexpr int innerFV0 = 32;
+  static constexpr float maxEtaFV0 = 5.1;
+  static constexpr float minEtaFV0 = 2.2;
+
+  // FV0 geometry, per channel: index of the cell ordered in phi, eta and phi of its centre, and weight of its amplitude
+  // in the lattice (the outer ring has two channels per cell)
+  std::array<int, nCellsFV0> mFV0PhiIndex;
+  std::array<float, nCellsFV0> mFV0Eta;
+  std::array<float, nCellsFV0> mFV0Phi;
+  std::array<float, nCellsFV0> mFV0LatticeWeight;
+
+  static constexpr int nDetVtx = 6;
+  std::array<TGraph, nDetVtx> gVtx; // calibration factors vs vertex z: FV0, FT0A, FT0C, MFT, FDA, FDC
+
   void init(o2::framework::InitContext&)
   {
+    const float detaFV0 = (maxEtaFV0 - minEtaFV0) / 5.0;
+    for (int ich = 0; ich < nCellsFV0; ++ich) {
+      const int ringindex = getFV0Ring(ich);
+      const int channelv0phi = getFV0IndexPhi(ich);
+      mFV0PhiIndex[ich] = channelv0phi;
+      mFV0Eta[ich] = maxEtaFV0 - (detaFV0 / 2.0) * (2.0 * ringindex + 1);
+      if (ich < innerFV0) {
+        mFV0Phi[ich] = (2.0 * (channelv0phi - 8 * ringindex) + 1) * M_PI / (8.0);
+        mFV0LatticeWeight[ich] = 1.f;
+      } else {
+        mFV0Phi[ich] = ((2.0 * channelv0phi) + 1 - 64.0) * 2.0 * M_PI / (32.0);
+        mFV0LatticeWeight[ich] = 0.5f;
+      }
+    }
+
+    const float* calibVtx[nDetVtx] = {calibFV0vtx, calibFT0Avtx, calibFT0Cvtx, calibMFTvtx, calibFDAvtx, calibFDCvtx};
+    const char* nameDet[nDetVtx] = {"AmpV0", "AmpT0A", "AmpT0C", "MFT", "AmpFDA", "AmpFDC"};
+    for (int i_d = 0; i_d < nDetVtx; ++i_d) {
+      for (int i_v = 0; i_v < 30; ++i_v) {
+        gVtx[i_d].SetPoint(i_v, biningVtxt[i_v], calibVtx[i_d][i_v]);
+      }
+      gVtx[i_d].SetName(Form("g%s", nameDet[i_d]));
+    }
+
+    const HistType kTH2Output = o2::analysis::getOutputHistType(HistType::kTH2F, useSparseOutput);
     int nBinsEst[16] = {100, 600, 600, 600, 500, 200, 102, 102, 102, 102, 400, 200, 102, 102, 400, 102};
     float lowEdgeEst[16] = {-0.5, -0.5, -0.5, -0.5, -0.5, -0.5,
                             -0.01, -0.01, -0.01, -0.01, -0.5, -0.5, -0.01, -0.01, -0.5, -0.01};
@@ -101,7 +171,7 @@ struct flatenictyFV0 {
     // estimators
     for (int i_e = 0; i_e < 16; ++i_e) {
       flatenicity.add(
-        nhEst[i_e].data(), "", HistType::kTH2F,
+        nhEst[i_e].data(), "", kTH2Output,
         {{nBinsEst[i_e], lowEdgeEst[i_e], upEdgeEst[i_e], tEst[i_e].data()},
          {100, -0.5, +99.5, "Global track"}});
     }
@@ -117,110 +187,96 @@ struct flatenictyFV0 {
     flatenicity.add("fMultFv0", "FV0 amp", HistType::kTH1F,
                     {{1000, -0.5, +39999.5, "FV0 amplitude"}});
     flatenicity.add(
-      "hAmpV0VsCh", "", HistType::kTH2F,
+      "hAmpV0VsCh", "", kTH2Output,
       {{48, -0.5, 47.5, "channel"}, {500, -0.5, +19999.5, "FV0 amplitude"}});
     flatenicity.add(
-      "hAmpV0VsChBeforeCalibration", "", HistType::kTH2F,
+      "hAmpV0VsChBeforeCalibration", "", kTH2Output,
       {{48, -0.5, 47.5, "channel"}, {500, -0.5, +19999.5, "FV0 amplitude"}});
 
     flatenicity.add(
-      "hAmpT0AVsChBeforeCalibration", "", HistType::kTH2F,
+      "hAmpT0AVsChBeforeCalibration", "", kTH2Output,
       {{24, -0.5, 23.5, "channel"}, {600, -0.5, +5999.5, "FT0A amplitude"}});
     flatenicity.add(
-      "hAmpT0CVsChBeforeCalibration", "", HistType::kTH2F,
+      "hAmpT0CVsChBeforeCalibration", "", kTH2Output,
       {{28, -0.5, 27.5, "channel"}, {600, -0.5, +5999.5, "FT0C amplitude"}});
 
     flatenicity.add(
-      "hAmpT0AVsCh", "", HistType::kTH2F,
+      "hAmpT0AVsCh", "", kTH2Output,
       {{24, -0.5, 23.5, "channel"}, {600, -0.5, +5999.5, "FT0A amplitude"}});
     flatenicity.add(
-      "hAmpT0CVsCh", "", HistType::kTH2F,
+      "hAmpT0CVsCh", "", kTH2Output,
       {{28, -0.5, 27.5, "channel"}, {600, -0.5, +5999.5, "FT0C amplitude"}});
 
     flatenicity.add(
-      "hAmpFDAVsChBeforeCalibration", "", HistType::kTH2F,
+      "hAmpFDAVsChBeforeCalibration", "", kTH2Output,
       {{8, -0.5, 7.5, "channel"}, {600, -0.5, +599.5, "FDA amplitude"}});
     flatenicity.add(
-      "hAmpFDCVsChBeforeCalibration", "", HistType::kTH2F,
+      "hAmpFDCVsChBeforeCalibration", "", kTH2Output,
       {{8, -0.5, 7.5, "channel"}, {600, -0.5, +599.5, "FDC amplitude"}});
     flatenicity.add(
-      "hAmpFDAVsCh", "", HistType::kTH2F,
+      "hAmpFDAVsCh", "", kTH2Output,
       {{8, -0.5, 7.5, "channel"}, {600, -0.5, +599.5, "FDA amplitude"}});
     flatenicity.add(
-      "hAmpFDCVsCh", "", HistType::kTH2F,
+      "hAmpFDCVsCh", "", kTH2Output,
       {{8, -0.5, 7.5, "channel"}, {600, -0.5, +599.5, "FDC amplitude"}});
 
-    flatenicity.add("hFlatMFTvsFlatGlob", "", HistType::kTH2F,
+    flatenicity.add("hFlatMFTvsFlatGlob", "", kTH2Output,
                     {{20, -0.01, +1.01, "flatenicity (Glob)"},
                      {20, -0.01, +1.01, "flatenicity (MFT)"}});
-    flatenicity.add("hFlatMFTvsFlatFV0", "", HistType::kTH2F,
+    flatenicity.add("hFlatMFTvsFlatFV0", "", kTH2Output,
                     {{20, -0.01, +1.01, "flatenicity (FV0)"},
                      {20, -0.01, +1.01, "flatenicity (MFT)"}});
-    flatenicity.add("hFlatFT0CvsFlatFT0A", "", HistType::kTH2F,
+    flatenicity.add("hFlatFT0CvsFlatFT0A", "", kTH2Output,
                     {{20, -0.01, +1.01, "flatenicity (FT0C)"},
                      {20, -0.01, +1.01, "flatenicity (FT0A)"}});
-    flatenicity.add("fEtaPhiFv0", "eta vs phi", HistType::kTH2F,
+    flatenicity.add("fEtaPhiFv0", "eta vs phi", kTH2Output,
                     {{8, 0.0, 2 * M_PI, "#phi (rad)"}, {5, 2.2, 5.1, "#eta"}});
 
-    flatenicity.add("hAmpV0vsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hAmpV0vsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Trk mult"},
                      {1000, -0.5, +39999.5, "FV0 amplitude"}});
-    flatenicity.add("hAmpT0AvsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hAmpT0AvsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {600, -0.5, +5999.5, "FT0A amplitude"}});
-    flatenicity.add("hAmpT0CvsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hAmpT0CvsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {600, -0.5, +5999.5, "FT0C amplitude"}});
-    flatenicity.add("hMFTvsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hMFTvsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {200, -0.5, +199.5, "MFT mult (-3.6<#eta<-2.5)"}});
-    flatenicity.add("hAmpFDAvsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hAmpFDAvsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {6000, -0.5, 7999.5, "Ampl. FDA"}});
-    flatenicity.add("hAmpFDCvsVtxBeforeCalibration", "", HistType::kTH2F,
+    flatenicity.add("hAmpFDCvsVtxBeforeCalibration", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {6000, -0.5, 7999.5, "Ampl. FDC"}});
 
-    flatenicity.add("hAmpV0vsVtx", "", HistType::kTH2F,
+    flatenicity.add("hAmpV0vsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Trk mult"},
                      {1000, -0.5, +39999.5, "FV0 amplitude"}});
-    flatenicity.add("hAmpT0AvsVtx", "", HistType::kTH2F,
+    flatenicity.add("hAmpT0AvsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {600, -0.5, +5999.5, "FT0A amplitude"}});
-    flatenicity.add("hAmpT0CvsVtx", "", HistType::kTH2F,
+    flatenicity.add("hAmpT0CvsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {600, -0.5, +5999.5, "FT0C amplitude"}});
-    flatenicity.add("hMFTvsVtx", "", HistType::kTH2F,
+    flatenicity.add("hMFTvsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {200, -0.5, +199.5, "MFT mult (-3.6<#eta<-2.5)"}});
-    flatenicity.add("hAmpFDAvsVtx", "", HistType::kTH2F,
+    flatenicity.add("hAmpFDAvsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {6000, -0.5, 7999.5, "Ampl. FDA"}});
-    flatenicity.add("hAmpFDCvsVtx", "", HistType::kTH2F,
+    flatenicity.add("hAmpFDCvsVtx", "", kTH2Output,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {6000, -0.5, 7999.5, "Ampl. FDC"}});
   }
   int getT0ASector(int i_ch)
   {
-    int i_sec_t0a = -1;
-    for (int i_sec = 0; i_sec < 24; ++i_sec) {
-      if (i_ch >= 4 * i_sec && i_ch <= 3 + 4 * i_sec) {
-        i_sec_t0a = i_sec;
-        break;
-      }
-    }
-    return i_sec_t0a;
+    return (i_ch >= 0 && i_ch < 4 * 24) ? i_ch / 4 : -1;
   }
   int getT0CSector(int i_ch)
   {
-    int i_sec_t0c = -1;
-    for (int i_sec = 0; i_sec < 28; ++i_sec) {
-      if (i_ch >= 4 * i_sec && i_ch <= 3 + 4 * i_sec) {
-        i_sec_t0c = i_sec;
-        break;
-      }
-    }
-    return i_sec_t0c;
+    return (i_ch >= 0 && i_ch < 4 * 28) ? i_ch / 4 : -1;
   }
 
   int getFV0Ring(int i_ch)
@@ -334,26 +390,21 @@ struct flatenictyFV0 {
     }
     return i_ring;
   }
-  float GetFlatenicity(float signals[], int entries)
+  float GetFlatenicity(const float signals[], int entries)
   {
-    float flat = 9999;
-    float mRho = 0;
+    // mean and variance of the activity per cell from the sums of one pass
+    double sum = 0;
+    double sum2 = 0;
     for (int iCell = 0; iCell < entries; ++iCell) {
-      mRho += 1.0 * signals[iCell];
+      sum += signals[iCell];
+      sum2 += signals[iCell] * signals[iCell];
     }
-    // average activity per cell
-    mRho /= (1.0 * entries);
-    // get sigma
-    float sRho_tmp = 0;
-    for (int iCell = 0; iCell < entries; ++iCell) {
-      sRho_tmp += TMath::Power(1.0 * signals[iCell] - mRho, 2);
-    }
-    sRho_tmp /= (1.0 * entries * entries);
-    float sRho = TMath::Sqrt(sRho_tmp);
-    if (mRho > 0) {
-      flat = sRho / mRho;
+    const double mRho = sum / entries;
+    if (!(mRho > 0)) {
+      return 9999;
     }
-    return flat;
+    const double sRho2 = std::max(sum2 / entries - mRho * mRho, 0.) / entries;
+    return std::sqrt(sRho2) / mRho;
   }
 
   Filter trackFilter = (nabs(aod::track::eta) < cfgTrkEtaCut) &&
@@ -382,6 +433,7 @@ struct flatenictyFV0 {
     }
 
     if (!isGoodEvent) {
+      flatenicityTable(9999.f, 9999.f, 9999.f, 9999.f, 9999.f, 0.f, 0.f, 0);
       return;
     }
 
@@ -424,98 +476,27 @@ struct flatenictyFV0 {
     float ampl6[nEta6] = {0, 0};
 
     // V0A signal and flatenicity calculation
-    float flatenicity_fv0;
-    float calib[48] = {1.01697, 1.122, 1.03854, 1.108, 1.11634, 1.14971, 1.19321, 1.06866, 0.954675, 0.952695, 0.969853, 0.957557, 0.989784, 1.01549, 1.02182, 0.976005, 1.01865, 1.06871, 1.06264, 1.02969, 1.07378, 1.06622, 1.15057, 1.0433, 0.83654, 0.847178, 0.890027, 0.920814, 0.888271, 1.04662, 0.8869, 0.856348, 0.863181, 0.906312, 0.902166, 1.00122, 1.03303, 0.887866, 0.892437, 0.906278, 0.884976, 0.864251, 0.917221, 1.10618, 1.04028, 0.893184, 0.915734, 0.892676};
-    // calibration T0C
-    float calibT0C[28] = {0.949829, 1.05408, 1.00681, 1.00724, 0.990663, 0.973571, 0.9855, 1.03726, 1.02526, 1.00467, 0.983008, 0.979349, 0.952352, 0.985775, 1.013, 1.01721, 0.993948, 0.996421, 0.971871, 1.02921, 0.989641, 1.01885, 1.01259, 0.929502, 1.03969, 1.02496, 1.01385, 1.01711};
-    // calibration T0A
-    float calibT0A[24] = {0.86041, 1.10607, 1.17724, 0.756397, 1.14954, 1.0879, 0.829438, 1.09014, 1.16515, 0.730077, 1.06722, 0.906344, 0.824167, 1.14716, 1.20692, 0.755034, 1.11734, 1.00556, 0.790522, 1.09138, 1.16225, 0.692458, 1.12428, 1.01127};
-    // calibration FDA
-    float calibFDA[8] = {0.933485, 1.00743, 0.768484, 0.837354, 1.26397, 1.2159, 0.876259, 1.00434};
-    // calibration FDC
-    float calibFDC[8] = {0.772909, 1.95841, 0.966258, 0.913508, 0.96176, 0.650286, 0.619638, 0.694932};
-    // calibration factor MFT vs vtx
-    float biningVtxt[30] = {-14.5, -13.5, -12.5, -11.5, -10.5, -9.5, -8.5, -7.5, -6.5, -5.5, -4.5, -3.5, -2.5, -1.5, -0.5, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5, 10.5, 11.5, 12.5, 13.5, 14.5};
-    float calibMFTvtx[30] = {1.27106, 1.239, 1.23555, 1.21115, 1.18538, 1.16585, 1.15052, 1.11002, 1.09909, 1.07341, 1.05511, 1.04538, 1.02291, 1.01254, 0.994646, 0.981465, 0.962609, 0.955254, 0.942117, 0.932826, 0.925284, 0.906386, 0.904621, 0.887349, 0.884237, 0.860509, 0.853699, 0.836858, 0.819485, 0.802514};
-
-    // calibration factor FV0 vs vtx
-    float calibFV0vtx[30] = {0.907962, 0.934607, 0.938929, 0.950987, 0.950817, 0.966362, 0.968509, 0.972741, 0.982412, 0.984872, 0.994543, 0.996003, 0.99435, 1.00266, 0.998245, 1.00584, 1.01078, 1.01003, 1.00726, 1.00872, 1.01726, 1.02015, 1.0193, 1.01106, 1.02229, 1.02104, 1.03435, 1.00822, 1.01921, 1.01736};
-    // calibration FT0A vs vtx
-    float calibFT0Avtx[30] = {0.924334, 0.950988, 0.959604, 0.965607, 0.970016, 0.979057, 0.978384, 0.982005, 0.992825, 0.990048, 0.998588, 0.997338, 1.00102, 1.00385, 0.99492, 1.01083, 1.00703, 1.00494, 1.00063, 1.0013, 1.00777, 1.01238, 1.01179, 1.00577, 1.01028, 1.017, 1.02975, 1.0085, 1.00856, 1.01662};
-    // calibration FT0C vs vtx
-    float calibFT0Cvtx[30] = {1.02096, 1.01245, 1.02148, 1.03605, 1.03561, 1.03667, 1.04229, 1.0327, 1.03674, 1.02764, 1.01828, 1.02331, 1.01864, 1.015, 1.01197, 1.00615, 0.996845, 0.993051, 0.985635, 0.982883, 0.981914, 0.964635, 0.967812, 0.95475, 0.956687, 0.932816, 0.92773, 0.914892, 0.891724, 0.872382};
-    // calibration FDA vs vtx
-    float calibFDAvtx[30] = {1.05852, 1.07943, 1.03542, 1.02851, 1.00617, 1.01377, 0.997411, 1.00899, 0.98556, 0.994506, 0.999267, 0.997915, 0.993361, 0.988509, 0.993386, 0.992661, 0.997844, 1.00428, 0.991939, 0.995139, 0.999882, 1.00976, 1.01239, 0.989125, 1.01432, 1.00652, 1.02114, 1.00582, 0.996546, 1.05708};
-    // calibration FDC vs vtx
-    float calibFDCvtx[30] = {0.965937, 0.924875, 0.903078, 0.901217, 0.914662, 0.933606, 0.899319, 0.912335, 0.900467, 0.928819, 0.943352, 0.955755, 0.954358, 0.939799, 0.973757, 0.972073, 1.00221, 0.997195, 1.01809, 1.02407, 1.02722, 1.05898, 1.09503, 1.13893, 1.12981, 1.15516, 1.17394, 1.28468, 1.37351, 1.24345};
-
-    const int nDetVtx = 6;
-    TGraph* gVtx[nDetVtx];
-    const char* nameDet[nDetVtx] = {"AmpV0", "AmpT0A", "AmpT0C", "MFT", "AmpFDA", "AmpFDC"};
-    for (int i_d = 0; i_d < nDetVtx; ++i_d) {
-      gVtx[i_d] = 0;
-      gVtx[i_d] = new TGraph();
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[0]->SetPoint(i_v, biningVtxt[i_v], calibFV0vtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[1]->SetPoint(i_v, biningVtxt[i_v], calibFT0Avtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[2]->SetPoint(i_v, biningVtxt[i_v], calibFT0Cvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[3]->SetPoint(i_v, biningVtxt[i_v], calibMFTvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[4]->SetPoint(i_v, biningVtxt[i_v], calibFDAvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[5]->SetPoint(i_v, biningVtxt[i_v], calibFDCvtx[i_v]);
-    }
-
-    for (int i_d = 0; i_d < nDetVtx; ++i_d) {
-      gVtx[i_d]->SetName(Form("g%s", nameDet[i_d]));
-    }
+    float flatenicity_fv0 = 9999;
 
     float sumAmpFV0 = 0;
     float sumAmpFV01to4Ch = 0;
-    int innerFV0 = 32;
-    float maxEtaFV0 = 5.1;
-    float minEtaFV0 = 2.2;
-    float detaFV0 = (maxEtaFV0 - minEtaFV0) / 5.0;
-
-    const int nCells = 48; // 48 sectors in FV0
-    float amp_channel[nCells];
-    for (int iCell = 0; iCell < nCells; ++iCell) {
-      amp_channel[iCell] = 0.0;
-    }
-    float amp_channelBefore[nCells];
-    for (int iCell = 0; iCell < nCells; ++iCell) {
-      amp_channelBefore[iCell] = 0.0;
-    }
+
+    float amp_channel[nCellsFV0] = {};
+    float amp_channelBefore[nCellsFV0] = {};
 
     if (collision.has_foundFV0()) {
 
-      float RhoLattice[nCells];
-      for (Int_t iCh = 0; iCh < nCells; iCh++) {
-        RhoLattice[iCh] = 0;
-      }
+      float RhoLattice[nCellsFV0] = {};
       auto fv0 = collision.foundFV0();
-      for (std::size_t ich = 0; ich < fv0.amplitude().size(); ich++) {
-        float phiv0 = -999.0;
-        float etav0 = -999.0;
-        int channelv0 = fv0.channel()[ich];
-        float ampl_ch = fv0.amplitude()[ich];
-        int ringindex = getFV0Ring(channelv0);
-        int channelv0phi = getFV0IndexPhi(channelv0);
-        etav0 = maxEtaFV0 - (detaFV0 / 2.0) * (2.0 * ringindex + 1);
-        if (channelv0 < innerFV0) {
-          phiv0 = (2.0 * (channelv0phi - 8 * ringindex) + 1) * M_PI / (8.0);
-        } else {
-          phiv0 = ((2.0 * channelv0phi) + 1 - 64.0) * 2.0 * M_PI / (32.0);
+      const auto& amplitudes = fv0.amplitude();
+      const auto& channels = fv0.channel();
+      for (std::size_t ich = 0; ich < amplitudes.size(); ich++) {
+        int channelv0 = channels[ich];
+        if (channelv0 < 0 || channelv0 >= nCellsFV0) {
+          continue;
         }
+        float ampl_ch = amplitudes[ich];
+        int channelv0phi = mFV0PhiIndex[channelv0];
         amp_channelBefore[channelv0phi] = ampl_ch;
         if (applyCalibCh) {
           ampl_ch *= calib[channelv0phi];
@@ -525,19 +506,18 @@ struct flatenictyFV0 {
         if (channelv0 >= 8) { // exclude the 1st ch, eta 2.2,4.52
           sumAmpFV01to4Ch += ampl_ch;
         }
-        flatenicity.fill(HIST("fEtaPhiFv0"), phiv0, etav0, ampl_ch);
-        amp_channel[channelv0phi] = ampl_ch;
-        if (channelv0 < innerFV0) {
-          RhoLattice[channelv0phi] = ampl_ch;
-        } else {
-          RhoLattice[channelv0phi] = ampl_ch / 2.0; // two channels per bin
+        if (fillChannelHistos) {
+          flatenicity.fill(HIST("fEtaPhiFv0"), mFV0Phi[channelv0], mFV0Eta[channelv0], ampl_ch);
         }
+        amp_channel[channelv0phi] = ampl_ch;
+        RhoLattice[channelv0phi] = ampl_ch * mFV0LatticeWeight[channelv0];
       }
-      flatenicity_fv0 = GetFlatenicity(RhoLattice, nCells);
+      flatenicity_fv0 = GetFlatenicity(RhoLattice, nCellsFV0);
       flatenicity.fill(HIST("hAmpV0vsVtxBeforeCalibration"), vtxZ, sumAmpFV0);
       if (applyCalibVtx) {
-        sumAmpFV0 *= gVtx[0]->Eval(vtxZ);
-        sumAmpFV01to4Ch *= gVtx[0]->Eval(vtxZ);
+        const float calibVtx = gVtx[0].Eval(vtxZ);
+        sumAmpFV0 *= calibVtx;
+        sumAmpFV01to4Ch *= calibVtx;
       }
       flatenicity.fill(HIST("hAmpV0vsVtx"), vtxZ, sumAmpFV0);
     }
@@ -549,14 +529,7 @@ struct flatenictyFV0 {
     const int nRings1 = 2;
     const int nSectors1 = 8;
     const int nCells1 = nRings1 * nSectors1;
-    float maxEta1[nRings1] = {-3.05, -2.50};
-    float minEta1[nRings1] = {-3.60, -3.05};
-    float maxPhi1[nSectors1] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
-    float minPhi1[nSectors1] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
-    float RhoLattice1[nCells1];
-    for (int iCh = 0; iCh < nCells1; iCh++) {
-      RhoLattice1[iCh] = 0.0;
-    }
+    float RhoLattice1[nCells1] = {};
 
     for (auto& track : mfttracks) {
 
@@ -569,16 +542,11 @@ struct flatenictyFV0 {
         continue;
       }
 
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings1; ir++) {
-        for (int is = 0; is < nSectors1; is++) {
-          if (eta_a >= minEta1[ir] && eta_a < maxEta1[ir] &&
-              phi_a >= minPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1) &&
-              phi_a < maxPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1)) {
-            RhoLattice1[i_ch]++;
-          }
-          i_ch++;
-        }
+      // rings -3.6 < eta < -3.05 and -3.05 < eta < -2.5, sectors of 2 pi / 8
+      const int ir = eta_a < -3.05f ? 0 : 1;
+      const int is = static_cast<int>(phi_a * nSectors1 / (2.0 * M_PI));
+      if (eta_a < -2.5f && is >= 0 && is < nSectors1) {
+        RhoLattice1[ir * nSectors1 + is]++;
       }
 
       multMFTTrack++;
@@ -590,8 +558,9 @@ struct flatenictyFV0 {
     }
     flatenicity.fill(HIST("hMFTvsVtxBeforeCalibration"), vtxZ, multMFTTrack);
     if (applyCalibVtx) {
-      multMFTTrack *= gVtx[3]->Eval(vtxZ);
-      multMFTTrackParc *= gVtx[3]->Eval(vtxZ);
+      const float calibVtx = gVtx[3].Eval(vtxZ);
+      multMFTTrack *= calibVtx;
+      multMFTTrackParc *= calibVtx;
     }
     flatenicity.fill(HIST("hMFTvsVtx"), vtxZ, multMFTTrack);
 
@@ -602,14 +571,7 @@ struct flatenictyFV0 {
     const int nRings2 = 4;
     const int nSectors2 = 8;
     const int nCells2 = nRings2 * nSectors2;
-    float maxEta2[nRings2] = {-0.4, 0.0, +0.4, +0.8};
-    float minEta2[nRings2] = {-0.8, -0.4, +0.0, +0.4};
-    float maxPhi2[nSectors2] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
-    float minPhi2[nSectors2] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
-    float RhoLattice2[nCells2];
-    for (int iCh = 0; iCh < nCells2; iCh++) {
-      RhoLattice2[iCh] = 0.0;
-    }
+    float RhoLattice2[nCells2] = {};
     int multGlob = 0;
     for (auto& track : tracks) {
       if (!track.isGlobalTrack()) {
@@ -619,16 +581,11 @@ struct flatenictyFV0 {
       float phi_a = track.phi();
       multGlob++;
 
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings2; ir++) {
-        for (int is = 0; is < nSectors2; is++) {
-          if (eta_a >= minEta2[ir] && eta_a < maxEta2[ir] &&
-              phi_a >= minPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2) &&
-              phi_a < maxPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2)) {
-            RhoLattice2[i_ch]++;
-          }
-          i_ch++;
-        }
+      // rings of 0.4 in -0.8 < eta < 0.8, sectors of 2 pi / 8
+      const int ir = static_cast<int>(std::floor((eta_a + 0.8f) / 0.4f));
+      const int is = static_cast<int>(std::floor(phi_a * nSectors2 / (2.0 * M_PI)));
+      if (ir >= 0 && ir < nRings2 && is >= 0 && is < nSectors2) {
+        RhoLattice2[ir * nSectors2 + is]++;
       }
     }
 
@@ -639,54 +596,60 @@ struct flatenictyFV0 {
     float sumAmpFT0A = 0.f;
     float sumAmpFT0C = 0.f;
     const int nCellsT0A = 24;
-    float RhoLatticeT0A[nCellsT0A];
-    for (int iCh = 0; iCh < nCellsT0A; iCh++) {
-      RhoLatticeT0A[iCh] = 0.0;
-    }
+    float RhoLatticeT0A[nCellsT0A] = {};
     const int nCellsT0C = 28;
-    float RhoLatticeT0C[nCellsT0C];
-    for (int iCh = 0; iCh < nCellsT0C; iCh++) {
-      RhoLatticeT0C[iCh] = 0.0;
-    }
+    float RhoLatticeT0C[nCellsT0C] = {};
 
     if (collision.has_foundFT0()) {
       auto ft0 = collision.foundFT0();
-      for (std::size_t i_a = 0; i_a < ft0.amplitudeA().size(); i_a++) {
-        float amplitude = ft0.amplitudeA()[i_a];
-        uint8_t channel = ft0.channelA()[i_a];
+      const auto& amplitudesA = ft0.amplitudeA();
+      const auto& channelsA = ft0.channelA();
+      for (std::size_t i_a = 0; i_a < amplitudesA.size(); i_a++) {
+        float amplitude = amplitudesA[i_a];
+        uint8_t channel = channelsA[i_a];
         int sector = getT0ASector(channel);
         if (sector >= 0 && sector < 24) {
           RhoLatticeT0A[sector] += amplitude;
-          flatenicity.fill(HIST("hAmpT0AVsChBeforeCalibration"), sector, amplitude);
+          if (fillChannelHistos) {
+            flatenicity.fill(HIST("hAmpT0AVsChBeforeCalibration"), sector, amplitude);
+          }
           if (applyCalibCh) {
             amplitude *= calibT0A[sector];
           }
-          flatenicity.fill(HIST("hAmpT0AVsCh"), sector, amplitude);
+          if (fillChannelHistos) {
+            flatenicity.fill(HIST("hAmpT0AVsCh"), sector, amplitude);
+          }
         }
         sumAmpFT0A += amplitude;
         flatenicity.fill(HIST("hFT0A"), amplitude);
       }
 
-      for (std::size_t i_c = 0; i_c < ft0.amplitudeC().size(); i_c++) {
-        float amplitude = ft0.amplitudeC()[i_c];
+      const auto& amplitudesC = ft0.amplitudeC();
+      const auto& channelsC = ft0.channelC();
+      for (std::size_t i_c = 0; i_c < amplitudesC.size(); i_c++) {
+        float amplitude = amplitudesC[i_c];
         sumAmpFT0C += amplitude;
-        uint8_t channel = ft0.channelC()[i_c];
+        uint8_t channel = channelsC[i_c];
         int sector = getT0CSector(channel);
         if (sector >= 0 && sector < 28) {
           RhoLatticeT0C[sector] += amplitude;
-          flatenicity.fill(HIST("hAmpT0CVsChBeforeCalibration"), sector, amplitude);
+          if (fillChannelHistos) {
+            flatenicity.fill(HIST("hAmpT0CVsChBeforeCalibration"), sector, amplitude);
+          }
           if (applyCalibCh) {
             amplitude *= calibT0C[sector];
           }
-          flatenicity.fill(HIST("hAmpT0CVsCh"), sector, amplitude);
+          if (fillChannelHistos) {
+            flatenicity.fill(HIST("hAmpT0CVsCh"), sector, amplitude);
+          }
         }
         flatenicity.fill(HIST("hFT0C"), amplitude);
       }
       flatenicity.fill(HIST("hAmpT0AvsVtxBeforeCalibration"), vtxZ, sumAmpFT0A);
       flatenicity.fill(HIST("hAmpT0CvsVtxBeforeCalibration"), vtxZ, sumAmpFT0C);
       if (applyCalibVtx) {
-        sumAmpFT0A *= gVtx[1]->Eval(vtxZ);
-        sumAmpFT0C *= gVtx[2]->Eval(vtxZ);
+        sumAmpFT0A *= gVtx[1].Eval(vtxZ);
+        sumAmpFT0C *= gVtx[2].Eval(vtxZ);
       }
       flatenicity.fill(HIST("hAmpT0AvsVtx"), vtxZ, sumAmpFT0A);
       flatenicity.fill(HIST("hAmpT0CvsVtx"), vtxZ, sumAmpFT0C);
@@ -706,31 +669,42 @@ struct flatenictyFV0 {
       for (std::size_t ich = 0; ich < 8; ich++) {
         float amplitude = fdd.chargeA()[ich];
         sumAmpFDDA += amplitude;
-        flatenicity.fill(HIST("hAmpFDAVsChBeforeCalibration"), ich, amplitude);
+        if (fillChannelHistos) {
+          flatenicity.fill(HIST("hAmpFDAVsChBeforeCalibration"), ich, amplitude);
+        }
         if (applyCalibCh) {
           amplitude *= calibFDA[ich];
         }
-        flatenicity.fill(HIST("hAmpFDAVsCh"), ich, amplitude);
+        if (fillChannelHistos) {
+          flatenicity.fill(HIST("hAmpFDAVsCh"), ich, amplitude);
+        }
       }
       for (std::size_t ich = 0; ich < 8; ich++) {
         float amplitude = fdd.chargeC()[ich];
         sumAmpFDDC += amplitude;
-        flatenicity.fill(HIST("hAmpFDCVsChBeforeCalibration"), ich, amplitude);
+        if (fillChannelHistos) {
+          flatenicity.fill(HIST("hAmpFDCVsChBeforeCalibration"), ich, amplitude);
+        }
         if (applyCalibCh) {
           amplitude *= calibFDC[ich];
         }
-        flatenicity.fill(HIST("hAmpFDCVsCh"), ich, amplitude);
+        if (fillChannelHistos) {
+          flatenicity.fill(HIST("hAmpFDCVsCh"), ich, amplitude);
+        }
       }
       flatenicity.fill(HIST("hAmpFDAvsVtxBeforeCalibration"), vtxZ, sumAmpFDDA);
       flatenicity.fill(HIST("hAmpFDCvsVtxBeforeCalibration"), vtxZ, sumAmpFDDC);
       if (applyCalibVtx) {
-        sumAmpFDDA *= gVtx[4]->Eval(vtxZ);
-        sumAmpFDDC *= gVtx[5]->Eval(vtxZ);
+        sumAmpFDDA *= gVtx[4].Eval(vtxZ);
+        sumAmpFDDC *= gVtx[5].Eval(vtxZ);
       }
       flatenicity.fill(HIST("hAmpFDAvsVtx"), vtxZ, sumAmpFDDA);
       flatenicity.fill(HIST("hAmpFDCvsVtx"), vtxZ, sumAmpFDDC);
     }
 
+    flatenicityTable(flatenicity_fv0, flatenicity_mft, flatenicity_glob, flatenicity_t0a, flatenicity_t0c,
+                     sumAmpFV0, multMFTTrack, multGlob);
+
     float combined_estimator1 = 0;
     float combined_estimator2 = 0;
     float combined_estimator3 = 0;
@@ -900,10 +874,12 @@ struct flatenictyFV0 {
         });
       }
 
-      for (int iCh = 0; iCh < 48; ++iCh) {
-        flatenicity.fill(HIST("hAmpV0VsCh"), iCh, amp_channel[iCh]);
-        flatenicity.fill(HIST("hAmpV0VsChBeforeCalibration"), iCh,
-                         amp_channelBefore[iCh]);
+      if (fillChannelHistos) {
+        for (int iCh = 0; iCh < nCellsFV0; ++iCh) {
+          flatenicity.fill(HIST("hAmpV0VsCh"), iCh, amp_channel[iCh]);
+          flatenicity.fill(HIST("hAmpV0VsChBeforeCalibration"), iCh,
+                           amp_channelBefore[iCh]);
+        }
       }
       flatenicity.fill(HIST("fMultFv0"), sumAmpFV0);
       flatenicity.fill(HIST("hFlatFT0CvsFlatFT0A"), flatenicity_t0c, flatenicity_t0a);
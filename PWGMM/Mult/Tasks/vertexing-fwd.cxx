@@ -16,7 +16,9 @@
 // \brief This code loops over every ambiguous MFT tracks and associates
 // them to a collision that has the smallest DCAxy
 
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 #include "ReconstructionDataFormats/TrackFwd.h"
 #include "Math/MatrixFunctions.h"
 #include "Math/SMatrix.h"
@@ -29,6 +31,8 @@
 #include "CommonConstants/MathConstants.h"
 #include "CommonConstants/LHCConstants.h"
 
+#include "Index.h"
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::track;
@@ -52,11 +56,17 @@ struct vertexingfwd {
   /// into different std::vector to easily handle them later outside the loops
   std::vector<int> vecCollForAmb;        // vector for collisions associated to an ambiguous track
   std::vector<double> vecDCACollForAmb;  // vector for dca collision associated to an ambiguous track
-  std::vector<double> vecAmbTrack;       // vector for ambiguous track quantities like chi2 and z
   std::vector<double> vecZposCollForAmb; // vector for z vertex of collisions associated to an ambiguous track
 
   Configurable<float> maxDCAXY{"maxDCAXY", 6.0, "max allowed transverse DCA"}; // To be used when associating ambitrack to collision using best DCA
 
+  Produces<aod::BestCollisionsFwd> bestCollisions;
+
+  // collisions ordered by BC, so that the collisions compatible with an ambiguous track
+  // are found by a binary search in its BC slice instead of a loop over all collisions
+  std::vector<int> collisionsByBC;
+  std::vector<int64_t> sortedBCIds;
+
   HistogramRegistry registry{
     "registry",
     {{"TracksDCAXY", "; DCA_{xy} (cm); counts", {HistType::kTH1F, {{100, -1, 10}}}},
@@ -105,6 +115,49 @@ struct vertexingfwd {
     return indice;
   }
 
+  template <typename C>
+  void sortCollisionsByBC(C const& collisions)
+  {
+    collisionsByBC.resize(collisions.size());
+    std::iota(collisionsByBC.begin(), collisionsByBC.end(), 0);
+    sortedBCIds.resize(collisions.size());
+    for (auto& collision : collisions) {
+      sortedBCIds[collision.globalIndex()] = collision.bcId();
+    }
+    std::stable_sort(collisionsByBC.begin(), collisionsByBC.end(), [&](int a, int b) { return sortedBCIds[a] < sortedBCIds[b]; });
+    for (std::size_t i = 0; i < collisionsByBC.size(); ++i) {
+      sortedBCIds[i] = collisions.iteratorAt(collisionsByBC[i]).bcId();
+    }
+  }
+
+  // positions in collisionsByBC of the collisions with a BC in the BC slice of the ambiguous track
+  template <typename A>
+  std::pair<int, int> compatibleCollisions(A const& ambitrack)
+  {
+    auto bcambis = ambitrack.bc();
+    if (bcambis.size() == 0) {
+      return {0, 0};
+    }
+    auto first = bcambis.rawIteratorAt(0).globalIndex();
+    auto last = bcambis.rawIteratorAt(bcambis.size() - 1).globalIndex();
+    auto begin = std::lower_bound(sortedBCIds.begin(), sortedBCIds.end(), first) - sortedBCIds.begin();
+    auto end = std::upper_bound(sortedBCIds.begin() + begin, sortedBCIds.end(), last) - sortedBCIds.begin();
+    return {begin, end};
+  }
+
+  // MFT track parameters with a null covariance matrix, propagated to each candidate vertex
+  template <typename T>
+  o2::track::TrackParCovFwd getTrackParCov(T const& track)
+  {
+    SMatrix5 tpars(track.x(), track.y(), track.phi(), track.tgl(), track.signed1Pt());
+    //            std::vector<double> v1{extAmbiTrack.cXX(), extAmbiTrack.cXY(), extAmbiTrack.cYY(), extAmbiTrack.cPhiX(), extAmbiTrack.cPhiY(),
+    //                                   extAmbiTrack.cPhiPhi(), extAmbiTrack.cTglX(), extAmbiTrack.cTglY(), extAmbiTrack.cTglPhi(), extAmbiTrack.cTglTgl(),
+    //                                   extAmbiTrack.c1PtX(), extAmbiTrack.c1PtY(), extAmbiTrack.c1PtPhi(), extAmbiTrack.c1PtTgl(), extAmbiTrack.c1Pt21Pt2()};
+    std::vector<double> v1; // Temporary null vector for the computation of the covariance matrix
+    SMatrix55 tcovs(v1.begin(), v1.end());
+    return o2::track::TrackParCovFwd{track.z(), tpars, tcovs, track.chi2()};
+  }
+
   template <typename T>
   void doProcess(T const& ambitracks, aod::BCs const& bcs, MFTTracksLabeled const& tracks, FullCollision const& collisions, aod::McParticles const& mcParticles, aod::McCollisions const& mcCollisions)
   {
@@ -114,10 +167,11 @@ struct vertexingfwd {
     registry.fill(HIST("AmbiguousTracksStatus"), 0.0, ntracks);
     registry.fill(HIST("AmbiguousTracksStatus"), 1.0, nambitracks);
 
+    sortCollisionsByBC(collisions);
+
     for (auto& ambitrack : ambitracks) {
       vecCollForAmb.clear();
       vecDCACollForAmb.clear();
-      vecAmbTrack.clear();
       vecZposCollForAmb.clear();
 
       double value = 0.0;    // matching value for collision association to an ambiguous track
@@ -141,72 +195,49 @@ struct vertexingfwd {
         registry.fill(HIST("AmbiguousTracksStatus"), 4.0);
       }
 
-      // Fill the std::vector for ambiguous tracks with the quantities needed
-      vecAmbTrack.push_back(track.x());
-      vecAmbTrack.push_back(track.y());
-      vecAmbTrack.push_back(track.phi());
-      vecAmbTrack.push_back(track.tgl());
-      vecAmbTrack.push_back(track.signed1Pt());
-      vecAmbTrack.push_back(track.z());
-      vecAmbTrack.push_back(track.chi2());
+      auto pars0 = getTrackParCov(track);
 
-      auto bcambis = ambitrack.bc();
+      // the collisions with their most probable BC in the BC slice of the ambiguous track
+      auto [begin, end] = compatibleCollisions(ambitrack);
 
       int collCounter = 0;
-      for (auto& collision : collisions) {
-        uint64_t mostProbableBC = collision.bc().globalBC();
+      for (auto iColl = begin; iColl < end; ++iColl) {
+        auto collision = collisions.iteratorAt(collisionsByBC[iColl]);
         //uint64_t meanBC = mostProbableBC - std::lround(collision.collisionTime() / (o2::constants::lhc::LHCBunchSpacingNS / 1000));
         //int deltaBC = std::ceil(collision.collisionTimeRes() / (o2::constants::lhc::LHCBunchSpacingNS / 1000) * 4);
 
-        for (auto& bcambi : bcambis) {
-
-          if (bcambi.globalBC() != mostProbableBC) {
-            continue;
-          }
-          //here the bc of the ambitrack is the bc of the collision we are looking at
-          collCounter++;
-
-          // We compute the DCAxy of this track wrt the primary vertex of the current collision
-          SMatrix5 tpars(vecAmbTrack[0], vecAmbTrack[1], vecAmbTrack[2], vecAmbTrack[3], vecAmbTrack[4]);
-          //            std::vector<double> v1{extAmbiTrack.cXX(), extAmbiTrack.cXY(), extAmbiTrack.cYY(), extAmbiTrack.cPhiX(), extAmbiTrack.cPhiY(),
-          //                                   extAmbiTrack.cPhiPhi(), extAmbiTrack.cTglX(), extAmbiTrack.cTglY(), extAmbiTrack.cTglPhi(), extAmbiTrack.cTglTgl(),
-          //                                   extAmbiTrack.c1PtX(), extAmbiTrack.c1PtY(), extAmbiTrack.c1PtPhi(), extAmbiTrack.c1PtTgl(), extAmbiTrack.c1Pt21Pt2()};
-
-          std::vector<double> v1; // Temporary null vector for the computation of the covariance matrix
-          SMatrix55 tcovs(v1.begin(), v1.end());
-          o2::track::TrackParCovFwd pars1{vecAmbTrack[5], tpars, tcovs, vecAmbTrack[6]};
+        //here the bc of the ambitrack is the bc of the collision we are looking at
+        collCounter++;
 
-          // o2::track::TrackParCovFwd pars1{extAmbiTrack.z(), tpars, tcovs, chi2};
-          pars1.propagateToZlinear(collision.posZ()); // track parameters propagation to the position of the z vertex
+        // We compute the DCAxy of this track wrt the primary vertex of the current collision
+        auto pars1 = pars0;
+        pars1.propagateToZlinear(collision.posZ()); // track parameters propagation to the position of the z vertex
 
-          const auto dcaX(pars1.getX() - collision.posX());
-          const auto dcaY(pars1.getY() - collision.posY());
-          auto dcaXY = std::sqrt(dcaX * dcaX + dcaY * dcaY);
+        const auto dcaX(pars1.getX() - collision.posX());
+        const auto dcaY(pars1.getY() - collision.posY());
+        auto dcaXY = std::sqrt(dcaX * dcaX + dcaY * dcaY);
 
-          registry.fill(HIST("TracksDCAXY"), dcaXY);
-          registry.fill(HIST("TracksDCAX"), dcaX);
-          registry.fill(HIST("TracksDCAY"), dcaY);
-          registry.fill(HIST("NumberOfContributors"), collision.numContrib());
+        registry.fill(HIST("TracksDCAXY"), dcaXY);
+        registry.fill(HIST("TracksDCAX"), dcaX);
+        registry.fill(HIST("TracksDCAY"), dcaY);
+        registry.fill(HIST("NumberOfContributors"), collision.numContrib());
 
-          if (dcaXY > maxDCAXY) {
-            continue;
-          }
+        if (dcaXY > maxDCAXY) {
+          continue;
+        }
 
-          vecDCACollForAmb.push_back(dcaXY);
+        vecDCACollForAmb.push_back(dcaXY);
 
-          if (!collision.has_mcCollision()) {
-            continue;
-          }
+        if (!collision.has_mcCollision()) {
+          continue;
+        }
 
-          int mcCollindex = collision.mcCollision().globalIndex();
-          vecCollForAmb.push_back(mcCollindex);
+        int mcCollindex = collision.mcCollision().globalIndex();
+        vecCollForAmb.push_back(mcCollindex);
 
-          vecZposCollForAmb.push_back(collision.mcCollision().posZ());
+        vecZposCollForAmb.push_back(collision.mcCollision().posZ());
 
-          registry.fill(HIST("DeltaZvtx"), collision.mcCollision().posZ() - zVtxMCAmbi);
-          break; //once we found a bc that corresponds to the bc of the collision we are working on, go out of the bcambi loop
-          //We then look at the next collision
-        }
+        registry.fill(HIST("DeltaZvtx"), collision.mcCollision().posZ() - zVtxMCAmbi);
       }
 
       registry.fill(HIST("NbCollComp"), collCounter);
@@ -269,6 +300,38 @@ struct vertexingfwd {
     doProcess(ambitracks, bcs, tracks, collisions, mcParticles, mcCollisions);
   }
   PROCESS_SWITCH(vertexingfwd, processOld, "Process ambiguous track DCA", false);
+
+  // producer mode: reassociation of each ambiguous MFT track to the compatible collision with the smallest DCAxy
+  void processReassociation(aod::AmbiguousMFTTracks const& ambitracks, aod::BCs const&, aod::MFTTracks const&, aod::Collisions const& collisions)
+  {
+    sortCollisionsByBC(collisions);
+    bestCollisions.reserve(ambitracks.size());
+    for (auto& ambitrack : ambitracks) {
+      auto pars0 = getTrackParCov(ambitrack.mfttrack());
+      auto [begin, end] = compatibleCollisions(ambitrack);
+      int bestCollision = -1;
+      float bestDCAXY = 0.;
+      for (auto iColl = begin; iColl < end; ++iColl) {
+        auto collision = collisions.iteratorAt(collisionsByBC[iColl]);
+        auto pars1 = pars0;
+        pars1.propagateToZlinear(collision.posZ());
+        const auto dcaX(pars1.getX() - collision.posX());
+        const auto dcaY(pars1.getY() - collision.posY());
+        float dcaXY = std::sqrt(dcaX * dcaX + dcaY * dcaY);
+        if (dcaXY > maxDCAXY) {
+          continue;
+        }
+        if (bestCollision < 0 || dcaXY < bestDCAXY) {
+          bestDCAXY = dcaXY;
+          bestCollision = collision.globalIndex();
+        }
+      }
+      if (bestCollision >= 0) {
+        bestCollisions(ambitrack.mfttrackId(), bestCollision, bestDCAXY);
+      }
+    }
+  }
+  PROCESS_SWITCH(vertexingfwd, processReassociation, "Produce the best collision of the ambiguous MFT tracks", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
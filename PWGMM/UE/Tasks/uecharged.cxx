@@ -47,6 +47,23 @@ struct ueCharged {
   // acceptance cuts
   Configurable<float> cfgTrkEtaCut{"cfgTrkEtaCut", 0.8f, "Eta range for tracks"};
   Configurable<float> cfgTrkLowPtCut{"cfgTrkLowPtCut", 0.15f, "Minimum constituent pT"};
+  // additional region distributions for events above leading pT thresholds
+  Configurable<std::vector<float>> cfgPtLeadingThresholds{"cfgPtLeadingThresholds", {}, "Leading pT thresholds of the region multiplicity and sum pT distributions"};
+
+  // track selection, set up once
+  TrackSelection mTrackSelection;
+
+  // tracks of the event kept for the region assignment after the leading particle is found
+  struct RegionTrack {
+    float phi;
+    float pt;
+    int index;
+  };
+  std::vector<RegionTrack> regionTracks;
+  std::vector<double> regionDPhi[3];
+  std::vector<double> regionPt[3];
+  std::vector<double> regionPtLeading;
+  static int getRegion(double dphi);
 
   HistogramRegistry ue;
   static constexpr std::string_view pNumDenMeasuredPS[3] = {"pNumDenMeasuredPS_NS", "pNumDenMeasuredPS_AS", "pNumDenMeasuredPS_TS"};
@@ -117,8 +134,20 @@ float ueCharged::DeltaPhi(float phia, float phib,
   return dphi;
 }
 
+// topological region of a particle at dphi from the leading particle: 0 near, 1 away, 2 transverse side
+int ueCharged::getRegion(double dphi)
+{
+  if (TMath::Abs(dphi) < M_PI / 3.0) {
+    return 0;
+  } else if (TMath::Abs(dphi - M_PI) < M_PI / 3.0) {
+    return 1;
+  }
+  return 2;
+}
+
 void ueCharged::init(InitContext const&)
 {
+  mTrackSelection = myTrackSelection();
 
   ConfigurableAxis ptBinningt{"ptBinningt", {0, 0.15, 0.50, 1.00, 1.50, 2.00, 2.50, 3.00, 3.50, 4.00, 4.50, 5.00, 6.00, 7.00, 8.00, 9.00, 10.0, 12.0, 14.0, 16.0, 18.0, 20.0, 25.0, 30.0, 40.0, 50.0}, "pTtrig bin limits"};
   AxisSpec ptAxist = {ptBinningt, "#it{p}_{T}^{trig} (GeV/#it{c})"};
@@ -167,6 +196,11 @@ void ueCharged::init(InitContext const&)
     ue.add(pSumPtData[i].data(), "", HistType::kTProfile, {ptAxist});
   }
   ue.add("hPtLeadingData", " ", HistType::kTH1D, {{ptAxist}});
+  auto nThresholds = cfgPtLeadingThresholds->size();
+  if (nThresholds > 0) {
+    ue.add("hNumDenThresholds", "; #it{p}_{T}^{trig} threshold; region (NS, AS, TS); #it{N}_{trk}", HistType::kTH3D, {{(int)nThresholds, -0.5, nThresholds - 0.5}, {3, -0.5, 2.5}, {100, -0.5, 99.5}});
+    ue.add("hSumPtThresholds", "; #it{p}_{T}^{trig} threshold; region (NS, AS, TS); #sum#it{p}_{T}", HistType::kTH3D, {{(int)nThresholds, -0.5, nThresholds - 0.5}, {3, -0.5, 2.5}, {ptAxis}});
+  }
   ue.add("hPTVsDCAData", " ", HistType::kTH2D, {{ptAxis}, {121, -3.025, 3.025, "#it{DCA}_{xy} (cm)"}});
 }
 
@@ -250,41 +284,30 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
   ue.fill(HIST("hCounter"), 2);
 
   ue.fill(HIST("hvtxZ"), vtxZ);
-  // loop over selected tracks
+  // single loop over selected tracks: running leading particle, the tracks are kept
+  // in a compact buffer and assigned to the regions once the leading particle is known
   double flPt = 0; // leading pT
   double flPhi = 0;
   int flIndex = 0;
-  for (auto& track : tracks) {
-    if (!track.isGlobalTrack()) {
-      continue;
-    }
-
-    ue.fill(HIST("hdNdeta"), track.eta());
-    ue.fill(HIST("vtxZEta"), track.eta(), vtxZ);
-    ue.fill(HIST("phiEta"), track.eta(), track.phi());
-
-    if (flPt < track.pt()) {
-      flPt = track.pt();
-      flPhi = track.phi();
-      flIndex = track.globalIndex();
-    }
-  }
-  ue.fill(HIST("hPtLeadingRecPS"), flPt);
-  std::vector<double> ue_rec;
-  ue_rec.clear();
-  int nchm_top[3];
-  double sumptm_top[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_top[i] = 0;
-    sumptm_top[i] = 0;
-  }
   std::vector<Float_t> ptArray;
   std::vector<Float_t> phiArray;
   std::vector<int> indexArray;
+  regionTracks.clear();
 
   for (auto& track : tracks) {
+    if (track.isGlobalTrack()) {
+      ue.fill(HIST("hdNdeta"), track.eta());
+      ue.fill(HIST("vtxZEta"), track.eta(), vtxZ);
+      ue.fill(HIST("phiEta"), track.eta(), track.phi());
+
+      if (flPt < track.pt()) {
+        flPt = track.pt();
+        flPhi = track.phi();
+        flIndex = track.globalIndex();
+      }
+    }
 
-    if (myTrackSelection().IsSelected(track)) { // TODO: set cuts w/o DCA cut
+    if (mTrackSelection.IsSelected(track)) { // TODO: set cuts w/o DCA cut
       ue.fill(HIST("hPTVsDCAData"), track.pt(), track.dcaXY());
     }
     if constexpr (IS_MC) {
@@ -292,7 +315,7 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
         if (track.isGlobalTrack()) {
           ue.fill(HIST("hPtOut"), track.pt());
         }
-        if (myTrackSelection().IsSelected(track)) {
+        if (mTrackSelection.IsSelected(track)) {
           ue.fill(HIST("hPtDCAall"), track.pt(), track.dcaXY());
         }
         const auto& particle = track.template mcParticle_as<aod::McParticles>();
@@ -301,7 +324,7 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
           if (track.isGlobalTrack()) {
             ue.fill(HIST("hPtOutPrim"), track.pt());
           }
-          if (myTrackSelection().IsSelected(track)) {
+          if (mTrackSelection.IsSelected(track)) {
             ue.fill(HIST("hPtDCAPrimary"), track.pt(), track.dcaXY());
           }
           // LOGP(info, "this track has MC particle {}", 1);
@@ -309,7 +332,7 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
           if (track.isGlobalTrack()) {
             ue.fill(HIST("hPtOutSec"), track.pt());
           }
-          if (myTrackSelection().IsSelected(track)) {
+          if (mTrackSelection.IsSelected(track)) {
             if (particle.getGenStatusCode() >= 0) { // i guess these are decays
               ue.fill(HIST("hPtDCAWeak"), track.pt(), track.dcaXY());
             } else { // i guess these are from material
@@ -326,29 +349,54 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
       indexArray.push_back(track.globalIndex());
     }
 
+    regionTracks.push_back({track.phi(), track.pt(), (int)track.globalIndex()});
+  }
+  ue.fill(HIST("hPtLeadingRecPS"), flPt);
+
+  // definition of the topological regions
+  std::vector<double> ue_rec;
+  int nchm_top[3];
+  double sumptm_top[3];
+  for (int i = 0; i < 3; ++i) {
+    nchm_top[i] = 0;
+    sumptm_top[i] = 0;
+    regionDPhi[i].clear();
+    regionPt[i].clear();
+  }
+  for (auto const& regionTrack : regionTracks) {
     // remove the autocorrelation
-    if (flIndex == track.globalIndex()) {
+    if (flIndex == regionTrack.index) {
       continue;
     }
+    double DPhi = DeltaPhi(regionTrack.phi, flPhi);
+    int region = getRegion(DPhi);
+    regionDPhi[region].push_back(DPhi);
+    regionPt[region].push_back(regionTrack.pt);
+    nchm_top[region]++;
+    sumptm_top[region] += regionTrack.pt;
+  }
 
-    double DPhi = DeltaPhi(track.phi(), flPhi);
-
-    // definition of the topological regions
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      ue.fill(HIST(hPhi[0]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingData[0]), flPt, track.pt());
-      nchm_top[0]++;
-      sumptm_top[0] += track.pt();
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      ue.fill(HIST(hPhi[1]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingData[1]), flPt, track.pt());
-      nchm_top[1]++;
-      sumptm_top[1] += track.pt();
-    } else { // transverse side
-      ue.fill(HIST(hPhi[2]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingData[2]), flPt, track.pt());
-      nchm_top[2]++;
-      sumptm_top[2] += track.pt();
+  // region histograms filled in bulk
+  static_for<0, 2>([&](auto i_reg) {
+    constexpr int index = i_reg.value;
+    const int nTracks = regionPt[index].size();
+    if (nTracks == 0) {
+      return;
+    }
+    regionPtLeading.assign(nTracks, flPt);
+    ue.get<TH1>(HIST(hPhi[index]))->FillN(nTracks, regionDPhi[index].data(), nullptr);
+    ue.get<TH2>(HIST(hPtVsPtLeadingData[index]))->FillN(nTracks, regionPtLeading.data(), regionPt[index].data(), nullptr);
+  });
+
+  // region distributions of the events above each leading pT threshold
+  auto const& thresholds = cfgPtLeadingThresholds.value;
+  for (std::size_t i_thr = 0; i_thr < thresholds.size(); ++i_thr) {
+    if (flPt < thresholds[i_thr]) {
+      continue;
+    }
+    for (int i_reg = 0; i_reg < 3; ++i_reg) {
+      ue.fill(HIST("hNumDenThresholds"), i_thr, i_reg, nchm_top[i_reg]);
+      ue.fill(HIST("hSumPtThresholds"), i_thr, i_reg, sumptm_top[i_reg]);
     }
   }
 
@@ -400,17 +448,9 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
     if (indexArray[i] == flIndexdd) {
       continue;
     }
-    double DPhi = DeltaPhi(phiArray[i], flPhidd);
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      nchm_topdd[0]++;
-      sumptm_topdd[0] += ptArray[i];
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      nchm_topdd[1]++;
-      sumptm_topdd[1] += ptArray[i];
-    } else { // transverse side
-      nchm_topdd[2]++;
-      sumptm_topdd[2] += ptArray[i];
-    }
+    int region = getRegion(DeltaPhi(phiArray[i], flPhidd));
+    nchm_topdd[region]++;
+    sumptm_topdd[region] += ptArray[i];
   }
 
   ue.fill(HIST(hNumDenMCDd[0]), flPtdd, nchm_topdd[0]);
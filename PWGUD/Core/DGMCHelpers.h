@@ -16,9 +16,13 @@
 #ifndef O2_ANALYSIS_DGMCHELPER_H_
 #define O2_ANALYSIS_DGMCHELPER_H_
 
+#include <array>
+#include <vector>
+
 #include "Framework/Logger.h"
 #include "CommonConstants/LHCConstants.h"
 #include "Common/DataModel/EventSelection.h"
+#include "PWGUD/DataModel/DiffMCTables.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -122,6 +126,75 @@ bool isGraniittiCDE(T MCparts)
   return true;
 }
 
+// -----------------------------------------------------------------------------
+// Classification of all McCollisions of a data frame in one pass over the
+// McParticles, with the same criteria as isPythiaCDE and isGraniittiCDE, instead
+// of slicing the McParticles for each collision. The McParticles of a McCollision
+// are contiguous, so the position of a particle in its McCollision is counted
+// while scanning. The results are in the order of the McCollisions.
+class DiffMCClassifier
+{
+ public:
+  template <typename TMcParts>
+  void scan(int64_t nMcCollisions, TMcParts const& mcParts)
+  {
+    mHistory.assign(nMcCollisions, 0);
+    mFITActivity.assign(nMcCollisions, 0);
+    mNCentral.assign(nMcCollisions, 0);
+    mPositions.assign(nMcCollisions, 0);
+    mGraniittiMatches.assign(nMcCollisions, 0);
+
+    for (auto const& mcpart : mcParts) {
+      auto col = mcpart.mcCollisionId();
+      if (col < 0 || col >= nMcCollisions) {
+        continue;
+      }
+      auto position = mPositions[col]++;
+      auto pdg = mcpart.pdgCode();
+      if (pdg == 9900110) {
+        mHistory[col] |= (1 << o2::aod::diffmc::kPythiaCD);
+      }
+      if (position < (int)graniittiStack.size() && pdg == graniittiStack[position]) {
+        mGraniittiMatches[col]++;
+      }
+      if (mcpart.isPhysicalPrimary()) {
+        auto eta = mcpart.eta();
+        if (std::abs(eta) < 0.9) {
+          mNCentral[col]++;
+        }
+        for (auto det = 0; det < (int)fitAcceptance.size(); det++) {
+          if (eta > fitAcceptance[det][0] && eta < fitAcceptance[det][1]) {
+            mFITActivity[col] |= (1 << det);
+          }
+        }
+      }
+    }
+
+    for (auto col = 0; col < nMcCollisions; col++) {
+      if (mGraniittiMatches[col] == (int)graniittiStack.size()) {
+        mHistory[col] |= (1 << o2::aod::diffmc::kGraniittiCD);
+      }
+    }
+  }
+
+  int64_t size() const { return mHistory.size(); }
+  uint8_t history(int64_t col) const { return mHistory[col]; }
+  uint8_t fitActivity(int64_t col) const { return mFITActivity[col]; }
+  uint16_t nCentralPrimaries(int64_t col) const { return mNCentral[col]; }
+
+ private:
+  // start of the stack of GRANIITTI events
+  static constexpr std::array<int, 7> graniittiStack{2212, 2212, 99, 2212, 2212, 99, 90};
+  // eta ranges of FV0A, FT0A, FT0C, FDDA, FDDC
+  static constexpr std::array<std::array<float, 2>, 5> fitAcceptance{{{2.2, 5.1}, {3.5, 4.9}, {-3.3, -2.1}, {4.7, 6.3}, {-6.9, -4.9}}};
+
+  std::vector<uint8_t> mHistory;
+  std::vector<uint8_t> mFITActivity;
+  std::vector<uint16_t> mNCentral;
+  std::vector<int> mPositions;
+  std::vector<int> mGraniittiMatches;
+};
+
 // -----------------------------------------------------------------------------
 
 #endif // O2_ANALYSIS_DGMCHELPER_H_
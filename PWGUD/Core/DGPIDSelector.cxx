@@ -44,6 +44,26 @@ DGParticle::DGParticle(TDatabasePDG* pdg, DGAnaparHolder anaPars, UDTracksFull c
   mtrkinds = comb;
 }
 
+// -----------------------------------------------------------------------------
+DGParticle::DGParticle(std::vector<float> const& masses, UDTracksFull const& tracks, std::vector<uint> const& comb)
+{
+  // compute invariant mass
+  TLorentzVector lvtmp;
+
+  // loop over tracks and update mIVM
+  mIVM = TLorentzVector(0., 0., 0., 0.);
+  auto cnt = -1;
+  for (auto ind : comb) {
+    cnt++;
+    auto track = tracks.rawIteratorAt(ind);
+    lvtmp.SetXYZM(track.px(), track.py(), track.pz(), masses[cnt]);
+    mIVM += lvtmp;
+  }
+
+  // set array of track indices
+  mtrkinds = comb;
+}
+
 // -----------------------------------------------------------------------------
 void DGParticle::Print()
 {
@@ -59,6 +79,21 @@ DGPIDSelector::DGPIDSelector()
   fPDG = TDatabasePDG::Instance();
 }
 
+// -----------------------------------------------------------------------------
+void DGPIDSelector::init(DGAnaparHolder anaPars)
+{
+  mAnaPars = anaPars;
+  mIVMs.clear();
+
+  // PID hypotheses and masses of the particles
+  mPIDInfo = mAnaPars.TPCnSigmas();
+  mMasses.resize(mPIDInfo.size() / 12);
+  for (uint cnt = 0; cnt < mMasses.size(); cnt++) {
+    mMasses[cnt] = particleMass(fPDG, mPIDInfo[cnt * 12]);
+  }
+  mPermsNCombine = -1;
+}
+
 // -----------------------------------------------------------------------------
 float DGPIDSelector::getTPCnSigma(UDTrackFull track, int hypo)
 {
@@ -80,16 +115,27 @@ float DGPIDSelector::getTPCnSigma(UDTrackFull track, int hypo)
 
 // -----------------------------------------------------------------------------
 bool DGPIDSelector::isGoodTrack(UDTrackFull track, int cnt)
+{
+  float nSigmas[5];
+  for (auto hypo = 0; hypo < 5; hypo++) {
+    nSigmas[hypo] = getTPCnSigma(track, hypo);
+  }
+  return isGoodTrack(track.sign(), nSigmas, cnt);
+}
+
+// -----------------------------------------------------------------------------
+// check the track sign and the TPC nSigmas (in the order of getTPCnSigma) against the hypothesis of particle cnt
+bool DGPIDSelector::isGoodTrack(int sign, const float* nSigmas, int cnt)
 {
   // extract PID information
-  auto pidinfo = mAnaPars.TPCnSigmas();
+  auto const& pidinfo = mPIDInfo;
 
   // get pid of particle cnt
   auto ind = cnt * 12;
   auto pidhypo = pid2ind(pidinfo[ind]);
 
   // check sign
-  if (pidinfo[ind + 1] != 0 && track.sign() != pidinfo[ind + 1]) {
+  if (pidinfo[ind + 1] != 0 && sign != pidinfo[ind + 1]) {
     return false;
   }
 
@@ -100,7 +146,7 @@ bool DGPIDSelector::isGoodTrack(UDTrackFull track, int cnt)
 
   // check nSigma
   for (auto hypo = 0; hypo < 5; hypo++) {
-    auto nSigma = getTPCnSigma(track, hypo);
+    auto nSigma = nSigmas[hypo];
     ind += 2;
     if (pidinfo[ind] == 0. && pidinfo[ind + 1] == 0.) {
       continue;
@@ -126,30 +172,71 @@ int DGPIDSelector::computeIVMs(int nCombine, UDTracksFull const& tracks)
   // reset
   mIVMs.clear();
 
-  // create combinations including permutations
-  auto combs = combinations(nCombine, tracks.size());
-
-  // loop over combinations
-  for (auto comb : combs) {
-    // is tracks compatible with PID requirements?
-    bool isGoodComb = true;
-    auto cnt = -1;
-    for (auto ind : comb) {
-      cnt++;
-      if (!isGoodTrack(tracks.rawIteratorAt(ind), cnt)) {
-        isGoodComb = false;
-        break;
+  // loop over the combinations, including permutations, which are compatible with PID requirements
+  // and update list of IVMs
+  forEachGoodCombination(nCombine, tracks, [&](std::vector<uint> const& comb) {
+    mIVMs.emplace_back(mMasses, tracks, comb);
+  });
+
+  return mIVMs.size();
+}
+
+// -----------------------------------------------------------------------------
+TLorentzVector DGPIDSelector::IVM(UDTracksFull const& tracks, std::vector<uint> const& inds)
+{
+  TLorentzVector ivm(0., 0., 0., 0.), lvtmp;
+  auto cnt = -1;
+  for (auto ind : inds) {
+    cnt++;
+    auto track = tracks.rawIteratorAt(ind);
+    lvtmp.SetXYZM(track.px(), track.py(), track.pz(), mMasses[cnt]);
+    ivm += lvtmp;
+  }
+  return ivm;
+}
+
+// -----------------------------------------------------------------------------
+// compute the permutations of nCombine elements once
+void DGPIDSelector::setupPermutations(int nCombine)
+{
+  if (nCombine == mPermsNCombine) {
+    return;
+  }
+  std::vector<std::vector<uint>> perms;
+  permutations(nCombine, perms);
+  mPerms.clear();
+  for (auto const& perm : perms) {
+    mPerms.insert(mPerms.end(), perm.begin(), perm.end());
+  }
+  mComb.resize(nCombine);
+  mInds.resize(nCombine);
+  mPermsNCombine = nCombine;
+}
+
+// -----------------------------------------------------------------------------
+// PID compatibility of each track with each of the nCombine particles
+// only the tracks compatible with at least one particle are candidates
+void DGPIDSelector::computeTrackMasks(int nCombine, UDTracksFull const& tracks)
+{
+  mCandidates.clear();
+  mMasks.clear();
+  float nSigmas[5];
+  for (auto ind = 0; ind < tracks.size(); ind++) {
+    auto track = tracks.rawIteratorAt(ind);
+    for (auto hypo = 0; hypo < 5; hypo++) {
+      nSigmas[hypo] = getTPCnSigma(track, hypo);
+    }
+    uint32_t mask = 0;
+    for (auto cnt = 0; cnt < nCombine; cnt++) {
+      if (isGoodTrack(track.sign(), nSigmas, cnt)) {
+        mask |= (1u << cnt);
       }
     }
-
-    // update list of IVMs
-    if (isGoodComb) {
-      DGParticle IVM(fPDG, mAnaPars, tracks, comb);
-      mIVMs.push_back(IVM);
+    if (mask != 0) {
+      mCandidates.push_back(ind);
+      mMasks.push_back(mask);
     }
   }
-
-  return mIVMs.size();
 }
 
 // -----------------------------------------------------------------------------
@@ -233,87 +320,4 @@ int DGPIDSelector::permutations(int n0, std::vector<std::vector<uint>>& perms)
   return perms.size();
 }
 
-//-----------------------------------------------------------------------------
-// find selections of np out of n0
-void DGPIDSelector::combinations(int n0, std::vector<uint>& pool, int np, std::vector<uint>& inds, int n,
-                                 std::vector<std::vector<uint>>& combs)
-{
-  // loop over pool
-  for (auto ii = 0; ii < n0 - n; ii++) {
-
-    inds[n] = pool[ii];
-
-    // if all inds are defined then print them out
-    // else get next inds
-    if (np == 1) {
-
-      std::vector<uint> comb(n + 1, 0);
-      for (uint ii = 0; ii < inds.size(); ii++) {
-        comb[ii] = inds[ii];
-      }
-      combs.push_back(comb);
-
-    } else {
-
-      auto n0new = n0 - ii;
-      std::vector<uint> newpool(n0new, 0);
-      for (auto kk = 0; kk < n0new; kk++) {
-        newpool[kk] = pool[kk + ii + 1];
-      }
-
-      auto npnew = np - 1;
-      auto nnew = n + 1;
-      combinations(n0new, newpool, npnew, inds, nnew, combs);
-    }
-  }
-}
-
-// -----------------------------------------------------------------------------
-// find all possible selections of np out of n0
-int DGPIDSelector::combinations(int n0, int np, std::vector<std::vector<uint>>& combs)
-{
-  // initialisations
-  combs.clear();
-  if (n0 < np) {
-    return 0;
-  }
-
-  std::vector<uint> pool(n0, 0);
-  for (auto ii = 0; ii < n0; ii++) {
-    pool[ii] = ii;
-  }
-  std::vector<uint> inds(np, 0);
-
-  // iterate recursively
-  combinations(n0, pool, np, inds, 0, combs);
-
-  return combs.size();
-}
-
-// -----------------------------------------------------------------------------
-std::vector<std::vector<uint>> DGPIDSelector::combinations(int nCombine, int nPool)
-{
-  // all permutations of nCombine elements
-  std::vector<std::vector<uint>> perms;
-  permutations(nCombine, perms);
-
-  // all selections of nCombine elements from nPool elements
-  std::vector<std::vector<uint>> combs;
-  combinations(nPool, nCombine, combs);
-
-  // permute the combinations
-  std::vector<std::vector<uint>> copes;
-  for (auto comb : combs) {
-    for (auto perm : perms) {
-      std::vector<uint> cope(nCombine, 0);
-      for (auto ii = 0; ii < nCombine; ii++) {
-        cope[perm[ii]] = comb[ii];
-      }
-      copes.push_back(cope);
-    }
-  }
-
-  return copes;
-}
-
 // -----------------------------------------------------------------------------
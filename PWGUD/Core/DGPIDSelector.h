@@ -31,6 +31,7 @@ struct DGParticle {
  public:
   DGParticle() = default;
   DGParticle(TDatabasePDG* pdg, DGAnaparHolder anaPars, UDTracksFull const& tracks, std::vector<uint> comb);
+  DGParticle(std::vector<float> const& masses, UDTracksFull const& tracks, std::vector<uint> const& comb);
 
   // getter
   std::vector<uint> trkinds() { return mtrkinds; }
@@ -55,11 +56,7 @@ struct DGPIDSelector {
   DGPIDSelector();
 
   // setters
-  void init(DGAnaparHolder anaPars)
-  {
-    mAnaPars = anaPars;
-    mIVMs.clear();
-  };
+  void init(DGAnaparHolder anaPars);
 
   // getters
   std::vector<DGParticle> IVMs() { return mIVMs; }
@@ -67,6 +64,73 @@ struct DGPIDSelector {
   bool isGoodTrack(UDTrackFull track, int cnt);
   int computeIVMs(int nCombine, UDTracksFull const& tracks);
 
+  // mass of the particle cnt of the PID hypotheses
+  float mass(int cnt) { return mMasses[cnt]; }
+  // invariant mass of the tracks with indices inds, with the masses of the PID hypotheses
+  TLorentzVector IVM(UDTracksFull const& tracks, std::vector<uint> const& inds);
+
+  // Loops over the track combinations which are compatible with the PID hypotheses
+  // and calls f(inds) for each of them, inds[cnt] being the index of the track
+  // used as particle cnt. The combinations are the same as in computeIVMs.
+  // The PID compatibility of each track with each particle is computed once per
+  // event as a bit mask, the permutations are computed once per nCombine, and
+  // the combinations are iterated in place, without allocations once the
+  // buffers have their size.
+  // Returns the number of good combinations.
+  template <typename F>
+  int forEachGoodCombination(int nCombine, UDTracksFull const& tracks, F&& f)
+  {
+    if (nCombine <= 0) {
+      return 0;
+    }
+    setupPermutations(nCombine);
+    computeTrackMasks(nCombine, tracks);
+    const int nCand = mCandidates.size();
+    if (nCand < nCombine) {
+      return 0;
+    }
+    const int nPerms = mPerms.size() / nCombine;
+
+    // loop over selections of nCombine of the candidate tracks, in increasing order
+    int nGood = 0;
+    for (auto ii = 0; ii < nCombine; ii++) {
+      mComb[ii] = ii;
+    }
+    while (true) {
+      // loop over permutations
+      for (auto ip = 0; ip < nPerms; ip++) {
+        const uint* perm = &mPerms[ip * nCombine];
+        bool isGoodComb = true;
+        for (auto ii = 0; ii < nCombine; ii++) {
+          if (!(mMasks[mComb[ii]] & (1u << perm[ii]))) {
+            isGoodComb = false;
+            break;
+          }
+          mInds[perm[ii]] = mCandidates[mComb[ii]];
+        }
+        if (isGoodComb) {
+          nGood++;
+          f(static_cast<std::vector<uint> const&>(mInds));
+        }
+      }
+
+      // next selection
+      auto ii = nCombine - 1;
+      while (ii >= 0 && mComb[ii] == nCand - nCombine + ii) {
+        ii--;
+      }
+      if (ii < 0) {
+        break;
+      }
+      mComb[ii]++;
+      for (auto jj = ii + 1; jj < nCombine; jj++) {
+        mComb[jj] = mComb[jj - 1] + 1;
+      }
+    }
+
+    return nGood;
+  }
+
  private:
   // analysis parameters
   DGAnaparHolder mAnaPars;
@@ -78,13 +142,24 @@ struct DGPIDSelector {
   TDatabasePDG* fPDG;
   int pid2ind(int pid);
 
-  // helper functions for computeIVMs
+  // PID hypotheses, copy of mAnaPars.TPCnSigmas(), and masses of the particles
+  std::vector<float> mPIDInfo;
+  std::vector<float> mMasses;
+
+  // buffers for forEachGoodCombination
+  int mPermsNCombine = -1;          // nCombine of mPerms
+  std::vector<uint> mPerms;         // permutations of nCombine elements, flattened
+  std::vector<uint> mCandidates;    // indices of the tracks compatible with at least one particle
+  std::vector<uint32_t> mMasks;     // bit cnt is set if candidate is compatible with particle cnt
+  std::vector<int> mComb;           // current selection of candidates
+  std::vector<uint> mInds;          // track indices of the current combination
+
+  // helper functions for forEachGoodCombination
+  bool isGoodTrack(int sign, const float* nSigmas, int cnt);
+  void setupPermutations(int nCombine);
+  void computeTrackMasks(int nCombine, UDTracksFull const& tracks);
   void permutations(std::vector<uint>& ref, int n0, int np, std::vector<std::vector<uint>>& perms);
   int permutations(int n0, std::vector<std::vector<uint>>& perms);
-  void combinations(int n0, std::vector<uint>& pool, int np, std::vector<uint>& inds, int n,
-                    std::vector<std::vector<uint>>& combs);
-  int combinations(int n0, int np, std::vector<std::vector<uint>>& combs);
-  std::vector<std::vector<uint>> combinations(int nCombine, int nPool);
 
   ClassDefNV(DGPIDSelector, 1);
 };
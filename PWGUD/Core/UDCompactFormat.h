@@ -0,0 +1,120 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+///
+/// \brief Writing and reading of the compact UD collisions (UDCollisionsCompact, UDBCAnchors, UDFITTails)
+/// \since  14.10.2026
+
+#ifndef O2_ANALYSIS_UDCOMPACTFORMAT_H_
+#define O2_ANALYSIS_UDCOMPACTFORMAT_H_
+
+#include <array>
+#include <vector>
+
+#include "Framework/Logger.h"
+#include "EventFiltering/PWGUD/BCFITIndex.h"
+#include "PWGUD/DataModel/UDTables.h"
+
+// -----------------------------------------------------------------------------
+// global BCs of the candidates as differences to the previous candidate
+// reset at the beginning of each data frame, so that each data frame can be decoded alone
+class UDBCDeltaEncoder
+{
+ public:
+  void reset() { mHasLastBC = false; }
+
+  // difference to store in UDCollisionsCompact
+  // isAnchor is set if the global BC must be stored in UDBCAnchors, i.e. for the first
+  // candidate of the data frame and if the difference is negative or does not fit
+  uint32_t encode(uint64_t globalBC, bool& isAnchor)
+  {
+    isAnchor = !mHasLastBC || globalBC < mLastBC || globalBC - mLastBC >= o2::aod::udcompact::bcDeltaAnchor;
+    uint32_t delta = isAnchor ? o2::aod::udcompact::bcDeltaAnchor : globalBC - mLastBC;
+    mLastBC = globalBC;
+    mHasLastBC = true;
+    return delta;
+  }
+
+ private:
+  bool mHasLastBC = false;
+  uint64_t mLastBC = 0;
+};
+
+// -----------------------------------------------------------------------------
+// global BCs of the candidates from the differences, in the order of the candidates
+class UDBCDeltaDecoder
+{
+ public:
+  void reset()
+  {
+    mLastBC = 0;
+    mNextAnchor = 0;
+  }
+
+  template <typename TAnchors>
+  uint64_t decode(uint32_t delta, TAnchors const& anchors)
+  {
+    if (delta == o2::aod::udcompact::bcDeltaAnchor) {
+      if (mNextAnchor >= anchors.size()) {
+        LOGF(error, "Missing global BC anchor %d of %d", mNextAnchor, anchors.size());
+        return mLastBC;
+      }
+      mLastBC = anchors.iteratorAt(mNextAnchor++).globalBC();
+    } else {
+      mLastBC += delta;
+    }
+    return mLastBC;
+  }
+
+ private:
+  uint64_t mLastBC = 0;
+  int64_t mNextAnchor = 0;
+};
+
+// -----------------------------------------------------------------------------
+// quantized FIT amplitudes in the BCs from globalBC - nBCs to globalBC + nBCs,
+// -1 for the BCs without signal, in the order of BCFITIndex::FITAmplitudes
+inline void packFITTails(BCFITIndex const& bcIndex, uint64_t globalBC, int nBCs,
+                         std::array<std::vector<int16_t>, BCFITIndex::kNFITAmplitudes>& tails)
+{
+  using binning = o2::aod::udcompact::binningAmplitude;
+  for (auto& tail : tails) {
+    tail.assign(2 * nBCs + 1, o2::aod::udcompact::packBinned<binning>(-1.));
+  }
+  for (int offset = -nBCs; offset <= nBCs; offset++) {
+    if (offset < 0 && globalBC < (uint64_t)(-offset)) {
+      continue;
+    }
+    auto position = bcIndex.find(globalBC + offset);
+    if (position < 0) {
+      continue;
+    }
+    for (int det = 0; det < BCFITIndex::kNFITAmplitudes; det++) {
+      if (bcIndex.hasSignal(position, det)) {
+        tails[det][offset + nBCs] = o2::aod::udcompact::packBinned<binning>(bcIndex.amplitude(position, det));
+      }
+    }
+  }
+}
+
+// amplitudes of a tail of UDFITTails, -1 for the BCs without signal
+// the amplitude of BC offset is at position offset + N
+inline std::vector<float> unpackFITTail(std::vector<int16_t> const& tail)
+{
+  using binning = o2::aod::udcompact::binningAmplitude;
+  std::vector<float> amplitudes(tail.size());
+  for (std::size_t i = 0; i < tail.size(); i++) {
+    amplitudes[i] = o2::aod::udcompact::unpackBinned<binning>(tail[i], -1.);
+  }
+  return amplitudes;
+}
+
+// -----------------------------------------------------------------------------
+#endif // O2_ANALYSIS_UDCOMPACTFORMAT_H_
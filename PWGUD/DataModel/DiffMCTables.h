@@ -0,0 +1,62 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_ANALYSIS_UDDIFFMCTABLES_H
+#define O2_ANALYSIS_UDDIFFMCTABLES_H
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace diffmc
+{
+// bits of HistoryFlags
+enum DiffMCHistory : uint8_t {
+  kPythiaCD = 0, // PYTHIA central diffractive particle 9900110 in the stack
+  kGraniittiCD   // GRANIITTI stack 2212/2212/99/2212/2212/99/90
+};
+
+// bits of FITActivity, physical primaries in the acceptance of the FIT detectors
+// in the order of DGCutparHolder::FITAmpLimits
+enum DiffMCFITActivity : uint8_t {
+  kFV0A = 0,
+  kFT0A,
+  kFT0C,
+  kFDDA,
+  kFDDC
+};
+
+DECLARE_SOA_COLUMN(HistoryFlags, historyFlags, uint8_t);            //! bits of DiffMCHistory
+DECLARE_SOA_COLUMN(FITActivity, fitActivity, uint8_t);              //! bits of DiffMCFITActivity
+DECLARE_SOA_COLUMN(NCentralPrimaries, nCentralPrimaries, uint16_t); //! number of physical primaries with |eta| < 0.9
+DECLARE_SOA_DYNAMIC_COLUMN(IsPythiaCD, isPythiaCD,                  //! PYTHIA central diffractive event
+                           [](uint8_t flags) -> bool { return flags & (1 << kPythiaCD); });
+DECLARE_SOA_DYNAMIC_COLUMN(IsGraniittiCD, isGraniittiCD, //! GRANIITTI central diffractive event
+                           [](uint8_t flags) -> bool { return flags & (1 << kGraniittiCD); });
+DECLARE_SOA_DYNAMIC_COLUMN(HasGapA, hasGapA, //! no physical primary in FV0A, FT0A, and FDDA
+                           [](uint8_t activity) -> bool { return !(activity & ((1 << kFV0A) | (1 << kFT0A) | (1 << kFDDA))); });
+DECLARE_SOA_DYNAMIC_COLUMN(HasGapC, hasGapC, //! no physical primary in FT0C and FDDC
+                           [](uint8_t activity) -> bool { return !(activity & ((1 << kFT0C) | (1 << kFDDC))); });
+} // namespace diffmc
+
+DECLARE_SOA_TABLE(DiffMCEvents, "AOD", "DIFFMCEVENT", //! MCTruth classification of the McCollisions, joinable with McCollisions
+                  diffmc::HistoryFlags,
+                  diffmc::FITActivity,
+                  diffmc::NCentralPrimaries,
+                  diffmc::IsPythiaCD<diffmc::HistoryFlags>,
+                  diffmc::IsGraniittiCD<diffmc::HistoryFlags>,
+                  diffmc::HasGapA<diffmc::FITActivity>,
+                  diffmc::HasGapC<diffmc::FITActivity>);
+
+using DiffMCEvent = DiffMCEvents::iterator;
+
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_UDDIFFMCTABLES_H
@@ -18,6 +18,7 @@
 #include "MathUtils/Utils.h"
 #include "Common/DataModel/PIDResponse.h"
 #include <cmath>
+#include <vector>
 
 namespace o2::aod
 {
@@ -107,6 +108,142 @@ DECLARE_SOA_TABLE(UDCollisions, "AOD", "UDCOLLISION",
 
 using UDCollision = UDCollisions::iterator;
 
+// Compact variant of the UD collisions, for large skims
+// - the global BC is stored as the difference to the one of the previous candidate of the data frame,
+//   the first candidate of a data frame and the large differences are stored in UDBCAnchors
+// - the FIT amplitudes and times are quantized to 16 bits
+// - the FIT amplitudes of the BCs around the candidate are stored in UDFITTails
+// the rows are in the order of the UDCollisions they replace, so that UDTrackCollisionIDs and
+// UDFwdTrackCollisionIDs are unchanged. UDCompactConverter restores UDCollisions for the UD tasks.
+namespace udcompact
+{
+template <class T>
+struct binningBase {
+  typedef T binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+};
+
+struct binningAmplitude : binningBase<int16_t> { //! FIT amplitudes, in ADC counts
+  static constexpr float binned_max = 32766.;
+  static constexpr float binned_min = -32766.;
+  static constexpr float bin_width = 1.;
+};
+
+struct binningTime : binningBase<int16_t> { //! FIT times, in ns
+  static constexpr float binned_max = 32.766;
+  static constexpr float binned_min = -32.766;
+  static constexpr float bin_width = 0.001;
+};
+
+struct binningFraction : binningBase<int8_t> { //! fractions between 0 and 1
+  static constexpr float binned_max = 1.26;
+  static constexpr float binned_min = -1.26;
+  static constexpr float bin_width = 0.01;
+};
+
+/// quantized value, the values out of range go to the underflow and overflow bins
+template <typename binningType>
+typename binningType::binned_t packBinned(float valueToBin)
+{
+  if (valueToBin <= binningType::binned_min) {
+    return binningType::underflowBin;
+  }
+  if (valueToBin >= binningType::binned_max) {
+    return binningType::overflowBin;
+  }
+  return static_cast<typename binningType::binned_t>(std::lround(valueToBin / binningType::bin_width));
+}
+
+/// value of a bin, the underflow bin stands for "no signal" and returns the sentinel of the full tables
+template <typename binningType>
+float unpackBinned(typename binningType::binned_t binned, float noSignal)
+{
+  if (binned == binningType::underflowBin) {
+    return noSignal;
+  }
+  return binningType::bin_width * static_cast<float>(binned);
+}
+
+/// value of the global BC differences stored in UDBCAnchors
+constexpr uint32_t bcDeltaAnchor = 0xFFFFFFFF;
+} // namespace udcompact
+
+namespace udcollcompact
+{
+DECLARE_SOA_COLUMN(GlobalBCDelta, globalBCDelta, uint32_t);                                                   //! global BC minus the one of the previous candidate, udcompact::bcDeltaAnchor if stored in UDBCAnchors
+DECLARE_SOA_COLUMN(RgtrwTOFStore, rgtrwTOFStore, udcompact::binningFraction::binned_t);                       //! quantized fraction of global tracks with TOF hit
+DECLARE_SOA_COLUMN(TotalFT0AmplitudeAStore, totalFT0AmplitudeAStore, udcompact::binningAmplitude::binned_t); //! quantized sum of amplitudes on A side of FT0
+DECLARE_SOA_COLUMN(TotalFT0AmplitudeCStore, totalFT0AmplitudeCStore, udcompact::binningAmplitude::binned_t); //! quantized sum of amplitudes on C side of FT0
+DECLARE_SOA_COLUMN(TimeFT0AStore, timeFT0AStore, udcompact::binningTime::binned_t);                           //! quantized FT0A average time
+DECLARE_SOA_COLUMN(TimeFT0CStore, timeFT0CStore, udcompact::binningTime::binned_t);                           //! quantized FT0C average time
+DECLARE_SOA_DYNAMIC_COLUMN(RgtrwTOF, rgtrwTOF,                                                                //! Fraction of global tracks with TOF hit
+                           [](udcompact::binningFraction::binned_t binned) -> float { return udcompact::unpackBinned<udcompact::binningFraction>(binned, 0.); });
+DECLARE_SOA_DYNAMIC_COLUMN(TotalFT0AmplitudeA, totalFT0AmplitudeA, //! sum of amplitudes on A side of FT0
+                           [](udcompact::binningAmplitude::binned_t binned) -> float { return udcompact::unpackBinned<udcompact::binningAmplitude>(binned, -1.); });
+DECLARE_SOA_DYNAMIC_COLUMN(TotalFT0AmplitudeC, totalFT0AmplitudeC, //! sum of amplitudes on C side of FT0
+                           [](udcompact::binningAmplitude::binned_t binned) -> float { return udcompact::unpackBinned<udcompact::binningAmplitude>(binned, -1.); });
+DECLARE_SOA_DYNAMIC_COLUMN(TimeFT0A, timeFT0A, //! FT0A average time
+                           [](udcompact::binningTime::binned_t binned) -> float { return udcompact::unpackBinned<udcompact::binningTime>(binned, -999.); });
+DECLARE_SOA_DYNAMIC_COLUMN(TimeFT0C, timeFT0C, //! FT0C average time
+                           [](udcompact::binningTime::binned_t binned) -> float { return udcompact::unpackBinned<udcompact::binningTime>(binned, -999.); });
+DECLARE_SOA_DYNAMIC_COLUMN(HasFT0, hasFT0, //! has FT0 signal in the same BC
+                           [](udcompact::binningTime::binned_t timeA, udcompact::binningTime::binned_t timeC) -> bool { return timeA != udcompact::binningTime::underflowBin && timeC != udcompact::binningTime::underflowBin; });
+} // namespace udcollcompact
+
+DECLARE_SOA_TABLE(UDCollisionsCompact, "AOD", "UDCOLLCOMPACT", //! compact variant of UDCollisions
+                  o2::soa::Index<>,
+                  udcollcompact::GlobalBCDelta,
+                  udcollision::RunNumber,
+                  collision::PosX,
+                  collision::PosY,
+                  collision::PosZ,
+                  collision::NumContrib,
+                  udcollision::NetCharge,
+                  udcollcompact::RgtrwTOFStore,
+                  udcollcompact::TotalFT0AmplitudeAStore,
+                  udcollcompact::TotalFT0AmplitudeCStore,
+                  udcollcompact::TimeFT0AStore,
+                  udcollcompact::TimeFT0CStore,
+                  udcollision::TriggerMaskFT0,
+                  udcollcompact::RgtrwTOF<udcollcompact::RgtrwTOFStore>,
+                  udcollcompact::TotalFT0AmplitudeA<udcollcompact::TotalFT0AmplitudeAStore>,
+                  udcollcompact::TotalFT0AmplitudeC<udcollcompact::TotalFT0AmplitudeCStore>,
+                  udcollcompact::TimeFT0A<udcollcompact::TimeFT0AStore>,
+                  udcollcompact::TimeFT0C<udcollcompact::TimeFT0CStore>,
+                  udcollcompact::HasFT0<udcollcompact::TimeFT0AStore, udcollcompact::TimeFT0CStore>);
+
+using UDCollisionCompact = UDCollisionsCompact::iterator;
+
+namespace udbcanchor
+{
+DECLARE_SOA_COLUMN(GlobalBC, globalBC, uint64_t); //! global BC of a candidate with udcompact::bcDeltaAnchor, in the order of the candidates
+} // namespace udbcanchor
+
+DECLARE_SOA_TABLE(UDBCAnchors, "AOD", "UDBCANCHOR", //! global BCs which are not stored as differences in UDCollisionsCompact
+                  udbcanchor::GlobalBC);
+
+namespace udfittail
+{
+// quantized amplitudes (udcompact::binningAmplitude) in the BCs from -N to +N around the candidate BC,
+// -1 for no signal, N is set by the producer
+DECLARE_SOA_COLUMN(FV0AAmplitudes, fv0aAmplitudes, std::vector<int16_t>); //! FV0A amplitudes around the candidate BC
+DECLARE_SOA_COLUMN(FT0AAmplitudes, ft0aAmplitudes, std::vector<int16_t>); //! FT0A amplitudes around the candidate BC
+DECLARE_SOA_COLUMN(FT0CAmplitudes, ft0cAmplitudes, std::vector<int16_t>); //! FT0C amplitudes around the candidate BC
+DECLARE_SOA_COLUMN(FDDAAmplitudes, fddaAmplitudes, std::vector<int16_t>); //! FDDA amplitudes around the candidate BC
+DECLARE_SOA_COLUMN(FDDCAmplitudes, fddcAmplitudes, std::vector<int16_t>); //! FDDC amplitudes around the candidate BC
+} // namespace udfittail
+
+DECLARE_SOA_TABLE(UDFITTails, "AOD", "UDFITTAIL", //! FIT activity around the candidates, joinable with UDCollisionsCompact and UDCollisions
+                  udfittail::FV0AAmplitudes,
+                  udfittail::FT0AAmplitudes,
+                  udfittail::FT0CAmplitudes,
+                  udfittail::FDDAAmplitudes,
+                  udfittail::FDDCAmplitudes);
+
+using UDFITTail = UDFITTails::iterator;
+
 namespace udtrack
 {
 DECLARE_SOA_INDEX_COLUMN(UDCollision, udCollision);    //!
@@ -30,6 +30,11 @@
 //           DiffCuts.mMaxnSigmaTPC(1000.)
 //           DiffCuts.mMaxnSigmaTOF(1000.)
 //           DiffCutsX.mFITAmpLimits({0., 0., 0., 0., 0.})
+//           compactOutput(false)
+//           nFITTailBCs(2)
+//
+//     with compactOutput the candidates are saved in UDCollisionsCompact, UDBCAnchors, and UDFITTails
+//     instead of UDCollisions, o2-analysis-udcompact-converter restores UDCollisions
 //
 //     usage: copts="--configuration json://DGCandProducerConfig.json --aod-writer-json DGCandProducerWriter.json -b"
 //
@@ -54,6 +59,7 @@
 #include "EventFiltering/PWGUD/DGHelpers.h"
 #include "PWGUD/Core/DGMCHelpers.h"
 #include "PWGUD/Core/UDHelperFunctions.h"
+#include "PWGUD/Core/UDCompactFormat.h"
 #include "PWGUD/DataModel/UDTables.h"
 
 using namespace o2;
@@ -69,6 +75,15 @@ struct DGCandProducer {
   // DG selector
   DGSelector dgSelector;
 
+  // compact output
+  Configurable<bool> compactOutput{"compactOutput", false, "Save the candidates in the compact format"};
+  Configurable<int> nFITTailBCs{"nFITTailBCs", 2, "Number of BCs before and after the candidate with FIT amplitudes in the compact format"};
+
+  // global BCs and FIT activity of the BCs of the data frame
+  BCFITIndex bcIndex;
+  UDBCDeltaEncoder bcEncoder;
+  std::array<std::vector<int16_t>, BCFITIndex::kNFITAmplitudes> fitTails;
+
   void init(InitContext&)
   {
     diffCuts = (DGCutparHolder)DGCuts;
@@ -81,6 +96,11 @@ struct DGCandProducer {
   Produces<aod::UDTracksExtra> outputTracksExtra;
   Produces<aod::UDTrackCollisionIDs> outputTracksCollisionsId;
 
+  // compact data tables
+  Produces<aod::UDCollisionsCompact> outputCollisionsCompact;
+  Produces<aod::UDBCAnchors> outputBCAnchors;
+  Produces<aod::UDFITTails> outputFITTails;
+
   // MC tables
   Produces<aod::UDMcCollisions> outputMcCollisions;
   Produces<aod::UDMcParticles> outputMcParticles;
@@ -105,6 +125,39 @@ struct DGCandProducer {
                           aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullPr>;
   using MCTC = MCTCs::iterator;
 
+  // function to update UDCollisions, or UDCollisionsCompact, UDBCAnchors, and UDFITTails
+  template <typename TCollision, typename TBC>
+  void updateUDCollisionTables(TCollision const& collision, TBC const& bc, int8_t netCharge, float rgtrwTOF)
+  {
+    float amplitudeA = 0., amplitudeC = 0., timeA = 0., timeC = 0.;
+    uint8_t triggerMask = 0;
+    if (!compactOutput) {
+      outputCollisions(bc.globalBC(), bc.runNumber(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       collision.numContrib(), netCharge, rgtrwTOF,
+                       amplitudeA, amplitudeC, timeA, timeC, triggerMask);
+      return;
+    }
+
+    bool isAnchor;
+    auto delta = bcEncoder.encode(bc.globalBC(), isAnchor);
+    if (isAnchor) {
+      outputBCAnchors(bc.globalBC());
+    }
+    outputCollisionsCompact(delta, bc.runNumber(),
+                            collision.posX(), collision.posY(), collision.posZ(),
+                            collision.numContrib(), netCharge,
+                            aod::udcompact::packBinned<aod::udcompact::binningFraction>(rgtrwTOF),
+                            aod::udcompact::packBinned<aod::udcompact::binningAmplitude>(amplitudeA),
+                            aod::udcompact::packBinned<aod::udcompact::binningAmplitude>(amplitudeC),
+                            aod::udcompact::packBinned<aod::udcompact::binningTime>(timeA),
+                            aod::udcompact::packBinned<aod::udcompact::binningTime>(timeC),
+                            triggerMask);
+    packFITTails(bcIndex, bc.globalBC(), nFITTailBCs, fitTails);
+    outputFITTails(fitTails[BCFITIndex::kFV0A], fitTails[BCFITIndex::kFT0A], fitTails[BCFITIndex::kFT0C],
+                   fitTails[BCFITIndex::kFDDA], fitTails[BCFITIndex::kFDDC]);
+  }
+
   // function to update UDTracks, UDTracksPID, and UDTracksExtra
   template <typename TTrack, typename TBC>
   void updateUDTrackTables(TTrack const& track, TBC const& bc)
@@ -136,7 +189,8 @@ struct DGCandProducer {
                       track.length(),
                       track.tofExpMom(),
                       track.detectorMap());
-    outputTracksCollisionsId(outputCollisions.lastIndex());
+    // the compact collisions are in the order of the UDCollisions they replace
+    outputTracksCollisionsId(compactOutput ? outputCollisionsCompact.lastIndex() : outputCollisions.lastIndex());
   }
 
   // this function properly updates UDMcCollisions and UDMcParticles and returns the value
@@ -216,22 +270,21 @@ struct DGCandProducer {
     // nominal BC
     auto bc = collision.bc_as<BCs>();
 
-    // obtain slice of compatible BCs
-    auto bcRange = compatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+    // obtain window of compatible BCs, the BC index is filled once per data frame
+    if (bcIndex.update(bcs)) {
+      bcEncoder.reset();
+    }
+    auto bcWindow = compatibleBCWindow(collision, diffCuts.NDtcoll(), bcIndex, diffCuts.minNBCs());
 
     // apply DG selection
-    auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bc, bcRange, tracks, fwdtracks);
+    auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bcIndex, bcWindow, tracks, fwdtracks);
 
     // save DG candidates
     if (isDGEvent == 0) {
       LOGF(info, "  Data: good collision!");
 
       // update DG candidates tables
-      outputCollisions(bc.globalBC(), bc.runNumber(),
-                       collision.posX(), collision.posY(), collision.posZ(),
-                       collision.numContrib(), netCharge(tracks),
-                       rPVtrwTOF(tracks, collision.numContrib()),
-                       0., 0., 0., 0., 0);
+      updateUDCollisionTables(collision, bc, netCharge(tracks), rPVtrwTOF(tracks, collision.numContrib()));
 
       // update DGTracks tables
       for (auto& track : tracks) {
@@ -272,6 +325,11 @@ struct DGCandProducer {
     // MC BC
     auto mcbc = McCol.bc_as<BCs>();
 
+    // the BC index is needed for the FIT tails of the compact output
+    if (compactOutput && bcIndex.update(bcs)) {
+      bcEncoder.reset();
+    }
+
     // save MCTruth of all diffractive events
     bool mcColIsSaved = false;
     int64_t deltaIndex = 0;
@@ -311,11 +369,7 @@ struct DGCandProducer {
         }
 
         // UDCollisions
-        outputCollisions(bc.globalBC(), bc.runNumber(),
-                         collision.posX(), collision.posY(), collision.posZ(),
-                         collision.numContrib(), netCharge(tracks),
-                         rPVtrwTOF(collisionTracks, collision.numContrib()),
-                         0., 0., 0., 0., 0);
+        updateUDCollisionTables(collision, bc, netCharge(tracks), rPVtrwTOF(collisionTracks, collision.numContrib()));
 
         // UDTracks, UDTrackCollisionID, UDTracksExtras, UDMcTrackLabels
         for (auto& track : collisionTracks) {
@@ -0,0 +1,54 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// \brief Classifies the McCollisions once (diffractive generator history, FIT gaps)
+//
+//     The table DiffMCEvents is joinable with McCollisions and is used by the
+//     diffractive MC QA tasks instead of scanning the McParticles of each collision.
+//
+//     usage: copts="--configuration json://DiffQAConfig.json -b"
+//
+//           o2-analysis-diff-mcevent-producer $copts |
+//           o2-analysis-ud-diff-mcqa $copts > diffQA.log
+//
+// \since  14.10.2026
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+
+#include "PWGUD/Core/DGMCHelpers.h"
+#include "PWGUD/DataModel/DiffMCTables.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct DiffMCEventProducer {
+  Produces<aod::DiffMCEvents> outputMcEvents;
+
+  DiffMCClassifier classifier;
+
+  void process(aod::McCollisions const& mcCols, aod::McParticles const& mcParts)
+  {
+    // one pass over all McParticles of the data frame
+    classifier.scan(mcCols.size(), mcParts);
+    outputMcEvents.reserve(mcCols.size());
+    for (auto col = 0; col < classifier.size(); col++) {
+      outputMcEvents(classifier.history(col), classifier.fitActivity(col), classifier.nCentralPrimaries(col));
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<DiffMCEventProducer>(cfgc, TaskName{"diffmcevent-producer"}),
+  };
+}
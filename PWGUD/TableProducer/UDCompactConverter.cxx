@@ -0,0 +1,58 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// \brief Restores UDCollisions from the compact UD collisions (UDCollisionsCompact, UDBCAnchors)
+//
+//     The rows of UDCollisions are in the order of UDCollisionsCompact, so that the tasks
+//     reading UDCollisions, UDTrackCollisionIDs, and UDFITTails run unchanged on the compact skims.
+//
+//     usage: copts="--aod-file AO2D.root -b"
+//
+//           o2-analysis-udcompact-converter $copts |
+//           o2-analysis-ud-dgcand-analyzer $copts > DGCandAnalyzer.log
+//
+// \since  14.10.2026
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+
+#include "PWGUD/Core/UDCompactFormat.h"
+#include "PWGUD/DataModel/UDTables.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct UDCompactConverter {
+  Produces<aod::UDCollisions> outputCollisions;
+
+  UDBCDeltaDecoder bcDecoder;
+
+  void process(aod::UDCollisionsCompact const& collisions, aod::UDBCAnchors const& anchors)
+  {
+    // the differences of the global BCs start again in each data frame
+    bcDecoder.reset();
+    outputCollisions.reserve(collisions.size());
+    for (auto const& collision : collisions) {
+      outputCollisions(bcDecoder.decode(collision.globalBCDelta(), anchors), collision.runNumber(),
+                       collision.posX(), collision.posY(), collision.posZ(),
+                       collision.numContrib(), collision.netCharge(), collision.rgtrwTOF(),
+                       collision.totalFT0AmplitudeA(), collision.totalFT0AmplitudeC(),
+                       collision.timeFT0A(), collision.timeFT0C(), collision.triggerMaskFT0());
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<UDCompactConverter>(cfgc, TaskName{"udcompact-converter"}),
+  };
+}
@@ -13,6 +13,8 @@
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 #include "PWGUD/DataModel/UDTables.h"
+#include "EventFiltering/PWGUD/BCFITIndex.h"
+#include "Common/Core/FrameArena.h"
 
 using namespace o2::framework;
 using namespace o2::framework::expressions;
@@ -27,6 +29,18 @@ struct UpcCandProducer {
   Configurable<int> fNFwdProngs{"nFwdProngs", 2, "Matched forward tracks per candidate"};
   Configurable<int> fNBarProngs{"nBarProngs", 0, "Matched barrel tracks per candidate"};
 
+  // global BCs with FT0 signal
+  BCFITIndex fBCsWithFT0;
+
+  // global BCs of the tracks and track IDs sorted by global BC, kept between time frames to reuse the memory
+  std::vector<uint64_t> fFwdTrackBCs;
+  std::vector<int32_t> fFwdTrackIds;
+  std::vector<uint64_t> fBarTrackBCs;
+  std::vector<int32_t> fBarTrackIds;
+
+  // memory of the candidate IDs of the tracks of a time frame, reused by the next time frames
+  o2::analysis::FrameArena fArena;
+
   // helper struct
   struct FT0Info {
     float amplitudeA = -1;
@@ -44,53 +58,37 @@ struct UpcCandProducer {
                         TFT0s const& ft0s)
   {
     // map track IDs to the respective event candidate IDs
-    std::vector<int32_t> barTrackCandIds;
-    std::vector<int32_t> fwdTrackCandIds;
-
-    std::map<uint64_t, int32_t> BCsWithFT0;
-    // collect BCs with FT0 signals
-    for (const auto& ft0 : ft0s) {
-      uint64_t bc = ft0.bc().globalBC();
-      BCsWithFT0[bc] = ft0.globalIndex();
-    }
+    fArena.reset();
+    o2::analysis::ArenaVector<int32_t> barTrackCandIds{o2::analysis::ArenaAllocator<int32_t>(fArena)};
+    o2::analysis::ArenaVector<int32_t> fwdTrackCandIds{o2::analysis::ArenaAllocator<int32_t>(fArena)};
 
-    // pairs of global BCs and vectors of matched track IDs:
-    // global BC <-> <vector of fwd. trackIDs, vector of barrel trackIDs>
-    std::map<uint64_t, std::pair<std::vector<int32_t>, std::vector<int32_t>>> bcsMatchedFwdTrIds;
+    // collect BCs with FT0 signals, with their FT0 amplitudes
+    fBCsWithFT0.fillFromFT0s(ft0s);
+
+    // global BCs of the tracks, and track IDs sorted by global BC:
+    // the tracks of one BC are contiguous in the sorted IDs, in the order of the tracks
+    fFwdTrackBCs.clear();
+    fBarTrackBCs.clear();
 
     // forward matching
     if (fwdTracks != nullptr) {
       fwdTrackCandIds.resize(fwdTracks->size(), -1);
+      fFwdTrackBCs.reserve(fwdTracks->size());
       for (const auto& fwdTr : *fwdTracks) {
-        uint64_t bc = fwdTr.globalBC();
-        // search for BC:
-        //  if found -> store track ID to vector of matched tracks
-        //  else make a new vector of matched tracks and store track ID
-        auto it = bcsMatchedFwdTrIds.find(bc);
-        if (it != bcsMatchedFwdTrIds.end()) {
-          it->second.first.emplace_back(fwdTr.globalIndex());
-        } else {
-          bcsMatchedFwdTrIds[bc] = std::make_pair(std::vector<int32_t>(1, fwdTr.globalIndex()), std::vector<int32_t>());
-        }
+        fFwdTrackBCs.push_back(fwdTr.globalBC());
       }
     }
+    sortByGlobalBC(fFwdTrackBCs, fFwdTrackIds);
 
     // central barrel tracks
     if (barTracks != nullptr) {
       barTrackCandIds.resize(barTracks->size(), -1);
+      fBarTrackBCs.reserve(barTracks->size());
       for (const auto& barTr : *barTracks) {
-        uint64_t bc = barTr.globalBC();
-        // search for BC:
-        //  if found -> store track ID to vector of matched tracks
-        //  else make a new vector of matched tracks and store track ID
-        auto it = bcsMatchedFwdTrIds.find(bc);
-        if (it != bcsMatchedFwdTrIds.end()) {
-          it->second.second.emplace_back(barTr.globalIndex());
-        } else if (!fDoSemiFwd) { // tag central-barrel tracks to forward tracks in semiforward case
-          bcsMatchedFwdTrIds[bc] = std::make_pair(std::vector<int32_t>(), std::vector<int32_t>(1, barTr.globalIndex()));
-        }
+        fBarTrackBCs.push_back(barTr.globalBC());
       }
     }
+    sortByGlobalBC(fBarTrackBCs, fBarTrackIds);
 
     // todo: calculate position of UD collision?
     float dummyX = 0.;
@@ -98,13 +96,33 @@ struct UpcCandProducer {
     float dummyZ = 0.;
 
     // storing n-prong matches
+    // one linear pass over the global BCs of the forward and barrel tracks, in increasing order
     int32_t candID = 0;
-    for (const auto& item : bcsMatchedFwdTrIds) {
-      uint64_t bc = item.first;
-      const std::vector<int32_t>& fwdTrackIDs = item.second.first;
-      const std::vector<int32_t>& barTrackIDs = item.second.second;
-      int32_t nFwdTracks = fwdTrackIDs.size();
-      int32_t nBarTracks = barTrackIDs.size();
+    const int32_t nFwd = fFwdTrackIds.size();
+    const int32_t nBar = fBarTrackIds.size();
+    int32_t iFwd = 0;
+    int32_t iBar = 0;
+    int64_t iFT0 = 0;
+    while (iFwd < nFwd || iBar < nBar) {
+      uint64_t bc = iFwd < nFwd ? fFwdTrackBCs[fFwdTrackIds[iFwd]] : fBarTrackBCs[fBarTrackIds[iBar]];
+      if (iBar < nBar && fBarTrackBCs[fBarTrackIds[iBar]] < bc) {
+        bc = fBarTrackBCs[fBarTrackIds[iBar]];
+      }
+      // tracks of this BC: [firstFwd, iFwd) and [firstBar, iBar)
+      int32_t firstFwd = iFwd;
+      while (iFwd < nFwd && fFwdTrackBCs[fFwdTrackIds[iFwd]] == bc) {
+        iFwd++;
+      }
+      int32_t firstBar = iBar;
+      while (iBar < nBar && fBarTrackBCs[fBarTrackIds[iBar]] == bc) {
+        iBar++;
+      }
+      int32_t nFwdTracks = iFwd - firstFwd;
+      int32_t nBarTracks = iBar - firstBar;
+      // tag central-barrel tracks to forward tracks in semiforward case
+      if (fDoSemiFwd && nFwdTracks == 0) {
+        continue;
+      }
       // skip candidate if it does not pass `number of tracks` requirement
       if (!(nFwdTracks == fNFwdProngs && nBarTracks == fNBarProngs)) {
         continue;
@@ -112,12 +130,14 @@ struct UpcCandProducer {
       int8_t netCharge = 0;
       uint16_t numContrib = nFwdTracks + nBarTracks;
       float RgtrwTOF = 0.;
-      for (auto id : fwdTrackIDs) {
+      for (int32_t i = firstFwd; i < iFwd; i++) {
+        auto id = fFwdTrackIds[i];
         fwdTrackCandIds[id] = candID;
         const auto& tr = fwdTracks->iteratorAt(id);
         netCharge += tr.sign();
       }
-      for (auto id : barTrackIDs) {
+      for (int32_t i = firstBar; i < iBar; i++) {
+        auto id = fBarTrackIds[i];
         barTrackCandIds[id] = candID;
         const auto& tr = barTracks->iteratorAt(id);
         netCharge += tr.sign();
@@ -129,19 +149,15 @@ struct UpcCandProducer {
       // fetching FT0 information
       // if there is no FT0 signal, dummy info will be used
       FT0Info ft0Info;
-      auto ft0Iter = BCsWithFT0.find(bc);
-      if (ft0Iter != BCsWithFT0.end()) {
-        const auto& ft0 = ft0s.iteratorAt(ft0Iter->second);
-        const auto& ampsA = ft0.amplitudeA();
-        const auto& ampsC = ft0.amplitudeC();
-        ft0Info.amplitudeA = 0.;
-        for (auto amp : ampsA) {
-          ft0Info.amplitudeA += amp;
-        }
-        ft0Info.amplitudeC = 0.;
-        for (auto amp : ampsC) {
-          ft0Info.amplitudeC += amp;
-        }
+      // the candidates are in increasing BC order, as the BCs with FT0 signals
+      while (iFT0 < fBCsWithFT0.size() && fBCsWithFT0.globalBC(iFT0) < bc) {
+        iFT0++;
+      }
+      if (iFT0 < fBCsWithFT0.size() && fBCsWithFT0.globalBC(iFT0) == bc) {
+        auto ft0Pos = iFT0;
+        const auto& ft0 = ft0s.iteratorAt(fBCsWithFT0.ft0Id(ft0Pos));
+        ft0Info.amplitudeA = fBCsWithFT0.amplitude(ft0Pos, BCFITIndex::kFT0A);
+        ft0Info.amplitudeC = fBCsWithFT0.amplitude(ft0Pos, BCFITIndex::kFT0C);
         ft0Info.timeA = ft0.timeA();
         ft0Info.timeC = ft0.timeC();
         ft0Info.triggerMask = ft0.triggerMask();
@@ -151,8 +167,6 @@ struct UpcCandProducer {
                       ft0Info.amplitudeA, ft0Info.amplitudeC, ft0Info.timeA, ft0Info.timeC, ft0Info.triggerMask);
       candID++;
     }
-    bcsMatchedFwdTrIds.clear();
-    BCsWithFT0.clear();
 
     if (fwdTracks != nullptr) {
       for (const auto& fwdTr : *fwdTracks) {
@@ -90,18 +90,17 @@ struct DGCandAnalyzer {
       return;
     }
 
-    // find track combinations which are compatible with anaPars.TPCnSigmas()
-    auto nIVMs = pidsel.computeIVMs(anaPars.nCombine(), dgtracks);
-
-    // update histograms
-    registry.get<TH1>(HIST("nIVMs"))->Fill(nIVMs, 1.);
-    for (auto ivm : pidsel.IVMs()) {
+    // loop over track combinations which are compatible with anaPars.TPCnSigmas()
+    // and update histograms
+    auto nIVMs = pidsel.forEachGoodCombination(anaPars.nCombine(), dgtracks, [&](std::vector<uint> const& inds) {
+      auto ivm = pidsel.IVM(dgtracks, inds);
       registry.get<TH2>(HIST("IVMptSysDG"))->Fill(ivm.M(), ivm.Perp());
-      for (auto ind : ivm.trkinds()) {
+      for (auto ind : inds) {
         auto track = dgtracks.rawIteratorAt(ind);
         registry.get<TH2>(HIST("IVMptTrkDG"))->Fill(ivm.M(), track.pt());
       }
-    }
+    });
+    registry.get<TH1>(HIST("nIVMs"))->Fill(nIVMs, 1.);
   }
 };
 
@@ -39,6 +39,7 @@
 ///           o2-analysis-ft0-corrected-table $copts |
 ///           o2-analysis-trackextension $copts |
 ///           o2-analysis-trackselection $copts |
+///           o2-analysis-diff-mcevent-producer $copts |
 ///           o2-analysis-ud-diff-mcqa $copts > diffQA.log
 ///
 /// \author Paul Buehler, paul.buehler@oeaw.ac.at
@@ -226,14 +227,15 @@ struct DiffMCQA {
     LOGF(info, "<DiffMCQA> Size of abcrs %i and afbcrs %i", abcrs.size(), afbcrs.size());
   }
 
-  Preslice<aod::McParticles> perMcCollision = aod::mcparticle::mcCollisionId;
+  // McCollisions with the MCTruth classification of DiffMCEventProducer
+  using MCCs = soa::Join<aod::McCollisions, aod::DiffMCEvents>;
 
   void process(CC const& collision, BCs const& bct0s,
                TCs& tracks, FWs& fwdtracks, ATs& ambtracks, AFTs& ambfwdtracks,
                aod::FT0s& ft0s, aod::FV0As& fv0as, aod::FDDs& fdds,
                aod::Zdcs& zdcs, aod::Calos& calos,
                aod::V0s& v0s, aod::Cascades& cascades,
-               aod::McCollisions& McCols, aod::McParticles const& McParts)
+               MCCs const& McCols)
   {
     bool isDGcandidate = true;
 
@@ -242,10 +244,9 @@ struct DiffMCQA {
     bool isPythiaDiff = false;
     bool isGraniittiDiff = false;
     if (collision.has_mcCollision()) {
-      auto MCCol = collision.mcCollision();
-      auto MCPartSlice = McParts.sliceBy(perMcCollision, MCCol.globalIndex());
-      isPythiaDiff = isPythiaCDE(MCPartSlice);
-      isGraniittiDiff = isGraniittiCDE(MCPartSlice);
+      auto MCCol = collision.mcCollision_as<MCCs>();
+      isPythiaDiff = MCCol.isPythiaCD();
+      isGraniittiDiff = MCCol.isGraniittiCD();
     }
 
     // global tracks
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+
+# Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+# See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+# All rights not expressly granted are reserved.
+#
+# This software is distributed under the terms of the GNU General Public
+# License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+#
+# In applying this license CERN does not waive the privileges and immunities
+# granted to it by virtue of its status as an Intergovernmental Organization
+# or submit itself to any jurisdiction.
+
+"""
+Script to merge the metrics files written by the ProcessTimer of the tasks (see Common/Core/ProcessTimer.h, enabled
+with O2PHYSICS_METRICS_DIR) into a report of a train. The files of all the subjobs given as arguments (files or
+directories searched recursively for *.metrics.json) are summed per task and process function, the peak memory of a
+task being the maximum over the subjobs. The report is printed as a table and written to a JSON file with the same
+structure as the metrics files, plus the number of subjobs of each task.
+With --reference, the report is compared to the one of a previous train: the functions whose time per row (per call if
+no rows are counted) or allocations per row increased by more than --threshold are listed, and the exit code is 1.
+"""
+
+import argparse
+import glob
+import json
+import os
+import sys
+
+SUMMED = ["calls", "rows", "wallTimeMs", "cpuTimeMs", "allocations", "allocatedBytes",
+          "ccdbFetches", "ccdbTimeMs", "onnxRuns", "onnxTimeMs"]
+PEAK_MEMORY = "peakMemoryKB"
+COMPARED = ["wallTimeMs", "cpuTimeMs", "allocations"]
+
+
+def find_files(paths):
+    """
+    Metrics files given directly or found in the directories
+    """
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            files += sorted(glob.glob(os.path.join(path, "**", "*.metrics.json"), recursive=True))
+        else:
+            files.append(path)
+    return files
+
+
+def aggregate(files):
+    """
+    Sums of the metrics per task and function, max. of the peak memory
+    """
+    tasks = {}
+    for name in files:
+        with open(name) as file:
+            metrics = json.load(file)
+        task = tasks.setdefault(metrics["task"], {"subjobs": 0, PEAK_MEMORY: 0, "functions": {}})
+        task["subjobs"] += 1
+        task[PEAK_MEMORY] = max(task[PEAK_MEMORY], metrics.get(PEAK_MEMORY, 0))
+        for function, values in metrics["functions"].items():
+            totals = task["functions"].setdefault(function, dict.fromkeys(SUMMED, 0))
+            for metric in SUMMED:
+                totals[metric] += values.get(metric, 0)
+    return tasks
+
+
+def normalised(values, metric):
+    """
+    Metric per row, per call if no rows are counted, None if the function was not called
+    """
+    count = values["rows"] or values["calls"]
+    return values[metric] / count if count > 0 else None
+
+
+def print_report(tasks):
+    print(f"{'task / function':<50} {'calls':>10} {'rows':>12} {'wall (s)':>10} {'CPU (s)':>10} {'us/row':>9}"
+          f" {'alloc/row':>10} {'CCDB':>6} {'CCDB (s)':>9} {'ONNX':>10} {'ONNX (s)':>9}")
+    for name, task in sorted(tasks.items()):
+        print(f"{name} ({task['subjobs']} subjobs, peak RSS {task[PEAK_MEMORY] / 1024:.0f} MB)")
+        for function, values in sorted(task["functions"].items()):
+            if values["calls"] == 0:
+                continue
+            time_per_row = 1.e3 * values["wallTimeMs"] / values["rows"] if values["rows"] > 0 else 0.
+            allocations_per_row = values["allocations"] / values["rows"] if values["rows"] > 0 else 0.
+            print(f"  {function:<48} {values['calls']:>10} {values['rows']:>12} {values['wallTimeMs'] / 1.e3:>10.2f}"
+                  f" {values['cpuTimeMs'] / 1.e3:>10.2f} {time_per_row:>9.3f} {allocations_per_row:>10.2f}"
+                  f" {values['ccdbFetches']:>6} {values['ccdbTimeMs'] / 1.e3:>9.2f} {values['onnxRuns']:>10}"
+                  f" {values['onnxTimeMs'] / 1.e3:>9.2f}")
+
+
+def compare(tasks, reference, threshold):
+    """
+    Functions whose normalised metrics increased by more than threshold with respect to the reference
+    """
+    regressions = []
+    for name, task in sorted(tasks.items()):
+        for function, values in sorted(task["functions"].items()):
+            reference_values = reference.get(name, {}).get("functions", {}).get(function)
+            if reference_values is None:
+                continue
+            for metric in COMPARED:
+                current = normalised(values, metric)
+                previous = normalised(reference_values, metric)
+                if current is not None and previous and current > (1. + threshold) * previous:
+                    regressions.append((name, function, metric, previous, current))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("inputs", nargs="+", help="Metrics files, or directories containing them")
+    parser.add_argument("--output", default="train-metrics.json", help="Output JSON file with the report")
+    parser.add_argument("--reference", default=None, help="Report of a previous train to compare to")
+    parser.add_argument("--threshold", type=float, default=0.1, help="Relative increase flagged as a regression")
+    args = parser.parse_args()
+
+    files = find_files(args.inputs)
+    if not files:
+        print("No metrics files found")
+        return 1
+    tasks = aggregate(files)
+    print_report(tasks)
+    with open(args.output, "w") as file:
+        json.dump(tasks, file, indent=2)
+    print(f"Report of {len(files)} files written to", args.output)
+
+    if args.reference is not None:
+        with open(args.reference) as file:
+            reference = json.load(file)
+        regressions = compare(tasks, reference, args.threshold)
+        for name, function, metric, previous, current in regressions:
+            print(f"Regression {name} / {function}: {metric} per row {previous:.4g} -> {current:.4g}"
+                  f" ({100. * (current / previous - 1.):+.0f}%)")
+        if regressions:
+            return 1
+        print("No regression with respect to", args.reference)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+
+# Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+# See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+# All rights not expressly granted are reserved.
+#
+# This software is distributed under the terms of the GNU General Public
+# License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+#
+# In applying this license CERN does not waive the privileges and immunities
+# granted to it by virtue of its status as an Intergovernmental Organization
+# or submit itself to any jurisdiction.
+
+"""
+Script to compare the skimmed and the direct analysis paths of the Tutorials/Skimming tasks on the same AO2D file.
+For each skim three pipelines are run in their own directories:
+  reference: the helper workflows and the reference task, on the input file
+  provider:  the helper workflows and the provider task, writing the derived tables to AO2D_skim.root
+  analyser:  the analyser task, on AO2D_skim.root
+The results give the speedup of the analyser (repeated analysis of the skim) and of provider + analyser (first pass)
+with respect to the reference, the ratio of the sizes of the skimmed and of the input files, and whether the
+histograms of the analyser are equal to the ones of the reference (compared by path within the task directory).
+The skims can be replaced with a JSON file with the same structure as DEFAULT_SKIMS.
+"""
+
+import argparse
+import json
+import os
+import shlex
+
+from benchmark_workflows import run_command
+
+RUN2_HELPERS = [
+    "o2-analysis-timestamp",
+    "o2-analysis-event-selection",
+    "o2-analysis-multiplicity-table",
+    "o2-analysis-trackselection",
+]
+
+DEFAULT_SKIMS = {
+    "tpcspectra": {
+        "helpers": RUN2_HELPERS + ["o2-analysis-pid-tpc-full"],
+        "reference": "o2-analysistutorial-tpcspectra-task-skim-reference",
+        "provider": "o2-analysistutorial-tpcspectra-task-skim-provider",
+        "analyser": "o2-analysistutorial-tpcspectra-task-skim-analyser",
+        "tables": ["AOD/LFTRACK/0"],
+        "configuration": {
+            "tpcspectra-task-skim-provider": {"saveTracks": "true", "trackPtCut": "0"},
+        },
+    },
+    "nucleispectra": {
+        "helpers": RUN2_HELPERS + ["o2-analysis-pid-tpc-full", "o2-analysis-pid-tof-base", "o2-analysis-pid-tof-full"],
+        "reference": "o2-analysistutorial-nucleispectra-task-skim-reference",
+        "provider": "o2-analysistutorial-nucleispectra-task-skim-provider",
+        "analyser": "o2-analysistutorial-nucleispectra-task-skim-analyser",
+        "tables": ["AOD/LFCOLLISION/0", "AOD/LFNUCLEITRACK/0"],
+        "configuration": {},
+    },
+    "upcspectra": {
+        "helpers": RUN2_HELPERS,
+        "reference": "o2-analysistutorial-upcspectra-task-skim-reference",
+        "provider": "o2-analysistutorial-upcspectra-task-skim-provider",
+        "analyser": "o2-analysistutorial-upcspectra-task-skim-analyser",
+        "tables": ["AOD/UDTRACK/0"],
+        "configuration": {},
+    },
+    "jetspectra": {
+        "helpers": RUN2_HELPERS + ["o2-analysis-jet-finder"],
+        "reference": "o2-analysistutorial-jetspectra-task-skim-reference",
+        "provider": "o2-analysistutorial-jet-task-skim-provider",
+        "analyser": "o2-analysistutorial-jetspectra-task-skim-analyser",
+        "tables": ["AOD/JEJET/0", "AOD/JECONSTITUENT/0"],
+        "configuration": {},
+    },
+}
+
+
+def run_pipeline(name, workflows, directory, configuration, aod, extra):
+    """
+    Runs a pipeline of workflows on an AO2D file and returns its exit code, wall time, CPU time and peak RSS (kB)
+    """
+    os.makedirs(directory, exist_ok=True)
+    configuration_file = os.path.abspath(os.path.join(directory, "configuration.json"))
+    with open(configuration_file, "w") as f:
+        json.dump(configuration, f, indent=2)
+    options = f"-b --configuration json://{configuration_file} {extra}"
+    command = " | ".join(f"{workflow} {options}" for workflow in workflows)
+    command += f" --aod-file {shlex.quote(aod)}"
+    print(f"Running {name}:", command)
+    code, wall_time, cpu_time, peak_rss = run_command(command, directory, os.path.join(directory, "pipeline.log"))
+    print(f"  exit code {code}, {wall_time:.1f} s wall, {cpu_time:.1f} s CPU, peak RSS {peak_rss / 1024:.0f} MB")
+    return {"exitCode": code, "wallTime": wall_time, "cpuTime": cpu_time, "peakRSSkB": peak_rss}
+
+
+def collect_histograms(directory, path, histograms):
+    """
+    Fills histograms with the histograms found in a directory or a collection, recursively, keyed by their path
+    """
+    objects = [key.ReadObj() for key in directory.GetListOfKeys()] if hasattr(directory, "GetListOfKeys") else list(directory)
+    for obj in objects:
+        name = f"{path}/{obj.GetName()}" if path else obj.GetName()
+        if obj.InheritsFrom("TH1"):
+            histograms[name] = obj
+        elif obj.InheritsFrom("TDirectory") or obj.InheritsFrom("TCollection"):
+            collect_histograms(obj, name, histograms)
+
+
+def compare_histograms(reference_file, analyser_file, reference_task, analyser_task):
+    """
+    Compares the histograms of the two tasks with the same path within their directories.
+    Returns None if ROOT is not available, otherwise the names of the equal, different and unmatched histograms.
+    """
+    try:
+        import ROOT
+    except ImportError:
+        print("  ROOT is not available, histograms not compared")
+        return None
+    results = {"equal": [], "different": [], "onlyReference": [], "onlyAnalyser": []}
+    histograms = []
+    for file_name, task in ((reference_file, reference_task), (analyser_file, analyser_task)):
+        task_histograms = {}
+        f = ROOT.TFile.Open(file_name)
+        if f and not f.IsZombie() and f.Get(task):
+            collect_histograms(f.Get(task), "", task_histograms)
+        histograms.append((f, task_histograms))
+    (_, reference), (_, analyser) = histograms
+    for name in sorted(set(reference) | set(analyser)):
+        if name not in analyser:
+            results["onlyReference"].append(name)
+            continue
+        if name not in reference:
+            results["onlyAnalyser"].append(name)
+            continue
+        h1, h2 = reference[name], analyser[name]
+        equal = h1.GetNcells() == h2.GetNcells() and h1.GetEntries() == h2.GetEntries()
+        for cell in range(h1.GetNcells() if equal else 0):
+            if h1.GetBinContent(cell) != h2.GetBinContent(cell) or h1.GetBinError(cell) != h2.GetBinError(cell):
+                equal = False
+                break
+        results["equal" if equal else "different"].append(name)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--aod", required=True, help="Input AO2D file")
+    parser.add_argument("--skims", default=None, help="JSON file with the skims to run, replacing the default ones")
+    parser.add_argument("--only", nargs="+", default=None, help="Names of the skims to run")
+    parser.add_argument("--workdir", default="skim-benchmark", help="Directory of the outputs of the pipelines")
+    parser.add_argument("--extra", default="", help="Options added to every workflow, e.g. --shm-segment-size")
+    parser.add_argument("--output", default="skim-benchmark.json", help="Output JSON file with the results")
+    args = parser.parse_args()
+
+    aod = os.path.abspath(args.aod)
+    skims = DEFAULT_SKIMS
+    if args.skims:
+        with open(args.skims) as f:
+            skims = json.load(f)
+    if args.only:
+        skims = {name: skims[name] for name in args.only}
+
+    results = {"aod": aod, "aodSize": os.path.getsize(aod), "skims": {}}
+    for name, skim in skims.items():
+        directory = os.path.join(args.workdir, name)
+        configuration = skim.get("configuration", {})
+        keep = ",".join(skim["tables"])
+        reference = run_pipeline(f"{name} reference", skim["helpers"] + [skim["reference"]],
+                                 os.path.join(directory, "reference"), configuration, aod, args.extra)
+        provider = run_pipeline(f"{name} provider", skim["helpers"] + [skim["provider"]],
+                                os.path.join(directory, "provider"), configuration, aod,
+                                f"{args.extra} --aod-writer-keep {keep} --aod-writer-resfile AO2D_skim")
+        skim_file = os.path.abspath(os.path.join(directory, "provider", "AO2D_skim.root"))
+        result = {"reference": reference, "provider": provider}
+        if provider["exitCode"] == 0 and os.path.isfile(skim_file):
+            analyser = run_pipeline(f"{name} analyser", [skim["analyser"]],
+                                    os.path.join(directory, "analyser"), configuration, skim_file, args.extra)
+            result["analyser"] = analyser
+            result["skimSize"] = os.path.getsize(skim_file)
+            result["sizeRatio"] = result["skimSize"] / results["aodSize"]
+            if analyser["wallTime"] > 0:
+                result["speedupAnalysis"] = reference["wallTime"] / analyser["wallTime"]
+                result["speedupFirstPass"] = reference["wallTime"] / (provider["wallTime"] + analyser["wallTime"])
+            # the task directories are named after the workflows, without the o2-analysis<component>- prefix
+            reference_task = skim["reference"].split("-", 2)[2]
+            analyser_task = skim["analyser"].split("-", 2)[2]
+            comparison = compare_histograms(os.path.join(directory, "reference", "AnalysisResults.root"),
+                                            os.path.join(directory, "analyser", "AnalysisResults.root"),
+                                            reference_task, analyser_task)
+            if comparison is not None:
+                result["histograms"] = comparison
+                result["histogramsEqual"] = not comparison["different"] and bool(comparison["equal"])
+            print(f"  size ratio {result['sizeRatio']:.4f}, speedup {result.get('speedupAnalysis', 0):.2f}"
+                  f" (analysis) {result.get('speedupFirstPass', 0):.2f} (first pass)"
+                  + (f", {len(comparison['equal'])} equal and {len(comparison['different'])} different histograms" if comparison else ""))
+        results["skims"][name] = result
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2)
+    print("Results written to", args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+
+# Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+# See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+# All rights not expressly granted are reserved.
+#
+# This software is distributed under the terms of the GNU General Public
+# License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+#
+# In applying this license CERN does not waive the privileges and immunities
+# granted to it by virtue of its status as an Intergovernmental Organization
+# or submit itself to any jurisdiction.
+
+"""
+Script to measure the throughput of analysis workflows on a synthetic AO2D file.
+The file is generated with o2-analysis-synthetic-aod-generator (unless one is given with --aod), then each pipeline
+of workflows is run on it in its own directory, with the resource monitoring of the framework enabled.
+For each pipeline the events per second, the wall and CPU time, the peak RSS of the largest process and the
+per-device metrics of performanceMetrics.json are written to the output JSON file, to be compared between releases.
+The pipelines can be replaced with a JSON file: {"name": {"workflows": ["o2-analysis-...", ...], "configuration": {...}}}
+"""
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import time
+
+DEFAULT_PIPELINES = {
+    "evsel-pid-hf": {
+        "workflows": [
+            "o2-analysis-timestamp",
+            "o2-analysis-event-selection",
+            "o2-analysis-track-propagation",
+            "o2-analysis-trackselection",
+            "o2-analysis-pid-tof-base",
+            "o2-analysis-pid-tof",
+            "o2-analysis-pid-tpc",
+            "o2-analysis-hf-track-index-skims-creator",
+        ],
+        "configuration": {
+            "bc-selection-task": {"processRun2": "false", "processRun3": "true"},
+            "event-selection-task": {"processRun2": "false", "processRun3": "true"},
+            "track-selection": {"isRun3": "true"},
+        },
+    },
+    "dq": {
+        "workflows": [
+            "o2-analysis-timestamp",
+            "o2-analysis-event-selection",
+            "o2-analysis-track-propagation",
+            "o2-analysis-trackselection",
+            "o2-analysis-pid-tof-base",
+            "o2-analysis-pid-tof",
+            "o2-analysis-pid-tpc",
+            "o2-analysis-dq-table-maker",
+            "o2-analysis-dq-table-reader",
+        ],
+        "configuration": {
+            "bc-selection-task": {"processRun2": "false", "processRun3": "true"},
+            "event-selection-task": {"processRun2": "false", "processRun3": "true"},
+            "track-selection": {"isRun3": "true"},
+            "table-maker": {"processBarrelOnly": "true"},
+            "analysis-event-selection": {"processSkimmed": "true"},
+            "analysis-track-selection": {"processSkimmed": "true"},
+            "analysis-muon-selection": {"processDummy": "true"},
+            "analysis-event-mixing": {"processDummy": "true"},
+            "analysis-same-event-pairing": {"processJpsiToEESkimmed": "true"},
+            "analysis-dilepton-hadron": {"processDummy": "true"},
+        },
+    },
+}
+
+
+def run_command(command, cwd, log_file):
+    """
+    Runs a shell command and returns its wall time, the CPU time and the peak RSS (kB) of the largest process it started
+    """
+    start = time.time()
+    with open(log_file, "w") as log:
+        process = subprocess.Popen(["bash", "-c", command], cwd=cwd, stdout=log, stderr=subprocess.STDOUT)
+        # the usage of the terminated and waited descendants is accumulated in the one of the child
+        _, status, usage = os.wait4(process.pid, 0)
+    wall_time = time.time() - start
+    return os.waitstatus_to_exitcode(status), wall_time, usage.ru_utime + usage.ru_stime, usage.ru_maxrss
+
+
+def to_float(value):
+    """
+    Value of a metric as a float, None if it is not a number
+    """
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return None
+
+
+def summarize_metrics(file_name):
+    """
+    Maximum and mean of the CPU and memory metrics of each device, as dumped by the framework
+    """
+    if not os.path.isfile(file_name):
+        return {}
+    with open(file_name) as f:
+        metrics = json.load(f)
+    summary = {}
+    for device, device_metrics in metrics.items():
+        if not isinstance(device_metrics, dict):
+            continue
+        for name, values in device_metrics.items():
+            if not any(key in name.lower() for key in ("cpu", "setsize", "memory")):
+                continue
+            values = [v.get("value") if isinstance(v, dict) else v for v in values] if isinstance(values, list) else [values]
+            values = [to_float(v) for v in values]
+            values = [v for v in values if v is not None]
+            if values:
+                summary.setdefault(device, {})[name] = {"max": max(values), "mean": sum(values) / len(values)}
+    return summary
+
+
+def generate(args):
+    """
+    Generates the synthetic AO2D file and returns its path and the number of collisions
+    """
+    os.makedirs(args.workdir, exist_ok=True)
+    command = f"o2-analysis-synthetic-aod-generator -b --aod-writer-keep dangling --aod-writer-resfile AO2D_synthetic" \
+              f" --nDataFrames {args.dataframes} --nCollisionsPerDataFrame {args.collisions} --system {args.system}" \
+              f" --multiplicityScale {args.multiplicity_scale} --pileUp {args.pileup} --produceMC {str(args.mc).lower()}" \
+              f" --summaryFile synthetic-aod-summary.json"
+    print("Generating:", command)
+    code, wall_time, _, _ = run_command(command, args.workdir, os.path.join(args.workdir, "generator.log"))
+    if code != 0:
+        raise RuntimeError(f"Generation failed with code {code}, see {args.workdir}/generator.log")
+    with open(os.path.join(args.workdir, "synthetic-aod-summary.json")) as f:
+        summary = json.load(f)
+    print(f"Generated {summary['collisions']} collisions and {summary['tracks']} tracks in {wall_time:.1f} s")
+    return os.path.abspath(os.path.join(args.workdir, "AO2D_synthetic.root")), summary["collisions"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--aod", default=None, help="Existing AO2D file, if not given a synthetic one is generated")
+    parser.add_argument("--events", type=int, default=0, help="Number of collisions of the file given with --aod")
+    parser.add_argument("--dataframes", type=int, default=10, help="Number of generated data frames")
+    parser.add_argument("--collisions", type=int, default=1000, help="Number of generated collisions per data frame")
+    parser.add_argument("--system", choices=["pp", "PbPb"], default="pp", help="Multiplicity profile of the generated collisions")
+    parser.add_argument("--multiplicity-scale", type=float, default=1.0, help="Factor applied to the mean generated multiplicity")
+    parser.add_argument("--pileup", type=float, default=0.0, help="Mean number of additional collisions in the BC of a generated collision")
+    parser.add_argument("--mc", action="store_true", help="Generate the MC tables")
+    parser.add_argument("--pipelines", default=None, help="JSON file with the pipelines to run, replacing the default ones")
+    parser.add_argument("--only", nargs="+", default=None, help="Names of the pipelines to run")
+    parser.add_argument("--workdir", default="workflow-benchmark", help="Directory of the generated file and of the outputs of the pipelines")
+    parser.add_argument("--extra", default="", help="Options added to every pipeline, e.g. --shm-segment-size")
+    parser.add_argument("--output", default="workflow-benchmark.json", help="Output JSON file with the results")
+    args = parser.parse_args()
+
+    if args.aod:
+        aod, events = os.path.abspath(args.aod), args.events
+    else:
+        aod, events = generate(args)
+
+    pipelines = DEFAULT_PIPELINES
+    if args.pipelines:
+        with open(args.pipelines) as f:
+            pipelines = json.load(f)
+    if args.only:
+        pipelines = {name: pipelines[name] for name in args.only}
+
+    results = {"aod": aod, "events": events, "pipelines": {}}
+    for name, pipeline in pipelines.items():
+        directory = os.path.join(args.workdir, name)
+        os.makedirs(directory, exist_ok=True)
+        configuration = os.path.abspath(os.path.join(directory, "configuration.json"))
+        with open(configuration, "w") as f:
+            json.dump(pipeline.get("configuration", {}), f, indent=2)
+        options = f"-b --configuration json://{configuration} --resources-monitoring 2 {args.extra}"
+        command = " | ".join(f"{workflow} {options}" for workflow in pipeline["workflows"])
+        command += f" --aod-file {shlex.quote(aod)}"
+        print(f"Running {name}:", command)
+        code, wall_time, cpu_time, peak_rss = run_command(command, directory, os.path.join(directory, "pipeline.log"))
+        result = {"exitCode": code,
+                  "wallTime": wall_time,
+                  "cpuTime": cpu_time,
+                  "eventsPerSecond": events / wall_time if wall_time > 0 else 0.,
+                  "peakRSSkB": peak_rss,
+                  "devices": summarize_metrics(os.path.join(directory, "performanceMetrics.json"))}
+        results["pipelines"][name] = result
+        print(f"  exit code {code}, {wall_time:.1f} s wall, {cpu_time:.1f} s CPU, {result['eventsPerSecond']:.1f} events/s, peak RSS {peak_rss / 1024:.0f} MB")
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2)
+    print("Results written to", args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+
+# Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+# See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+# All rights not expressly granted are reserved.
+#
+# This software is distributed under the terms of the GNU General Public
+# License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+#
+# In applying this license CERN does not waive the privileges and immunities
+# granted to it by virtue of its status as an Intergovernmental Organization
+# or submit itself to any jurisdiction.
+
+"""
+Script to convert the THnSparse of an analysis output file into dense TH1/TH2/TH3 histograms.
+The tasks booking their histograms with the sparse output mode (see Common/Core/SparseOutput.h) store and merge only
+the filled bins; this script reconstitutes histograms which can be drawn and analysed as the dense ones, once, after
+the merging. The directory structure and the names are preserved, the other objects are copied unchanged.
+"""
+
+import argparse
+
+import ROOT
+
+
+def densify(sparse, max_dimensions):
+    """
+    Dense projection of a THnSparse on all its axes, None if it has more dimensions than supported
+    """
+    dimensions = sparse.GetNdimensions()
+    if dimensions > max_dimensions:
+        return None
+    if dimensions == 1:
+        dense = sparse.Projection(0, "E")
+    elif dimensions == 2:
+        dense = sparse.Projection(1, 0, "E")  # Projection(y, x)
+    else:
+        dense = sparse.Projection(0, 1, 2, "E")
+    dense.SetName(sparse.GetName())
+    dense.SetTitle(sparse.GetTitle())
+    return dense
+
+
+def copy_directory(source, destination, max_dimensions, counters):
+    """
+    Copies the content of a directory (or of a list) into an output directory, densifying the THnSparse
+    """
+    keys = source.GetListOfKeys() if isinstance(source, ROOT.TDirectory) else None
+    objects = [key.ReadObj() for key in keys] if keys is not None else list(source)
+    for obj in objects:
+        if isinstance(obj, ROOT.TDirectory):
+            copy_directory(obj, destination.mkdir(obj.GetName()), max_dimensions, counters)
+        elif isinstance(obj, ROOT.TList) and not isinstance(obj, ROOT.THashList):
+            copy_directory(obj, destination.mkdir(obj.GetName()), max_dimensions, counters)
+        elif isinstance(obj, ROOT.THnSparse):
+            dense = densify(obj, max_dimensions)
+            destination.cd()
+            if dense is None:
+                obj.Write()
+                counters["kept"] += 1
+            else:
+                dense.Write()
+                counters["densified"] += 1
+        else:
+            destination.cd()
+            obj.Write(obj.GetName(), ROOT.TObject.kSingleKey)
+            counters["copied"] += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("input", help="Input file, e.g. the merged AnalysisResults.root")
+    parser.add_argument("output", help="Output file with the dense histograms")
+    parser.add_argument("--max-dimensions", type=int, default=3, choices=[1, 2, 3],
+                        help="THnSparse with more dimensions are copied unchanged")
+    args = parser.parse_args()
+
+    ROOT.TH1.AddDirectory(False)
+    input_file = ROOT.TFile.Open(args.input, "READ")
+    if not input_file or input_file.IsZombie():
+        raise RuntimeError(f"Cannot open {args.input}")
+    output_file = ROOT.TFile.Open(args.output, "RECREATE")
+    counters = {"densified": 0, "kept": 0, "copied": 0}
+    copy_directory(input_file, output_file, args.max_dimensions, counters)
+    output_file.Close()
+    input_file.Close()
+    print(f"{counters['densified']} sparse histograms densified, {counters['kept']} kept sparse, {counters['copied']} other objects copied to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
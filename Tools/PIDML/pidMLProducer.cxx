@@ -8,6 +8,9 @@
 // In applying this license CERN does not waive the privileges and immunities
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
+#include <cstdlib>
+#include <vector>
+#include <TRandom3.h>
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/HistogramRegistry.h"
@@ -32,12 +35,14 @@ struct CreateTableMc {
   Produces<aod::PidTracksMcMl> pidTracksTableML;
   Produces<aod::PidTracksMc> pidTracksTable;
 
+  Configurable<std::vector<float>> classFractions{"classFractions", std::vector<float>{1.f, 1.f, 1.f, 1.f, 1.f, 1.f}, "Fractions of the tracks written for each MC class, to balance the training samples: e, mu, pi, K, p, others"};
+  Configurable<int> randomSeed{"randomSeed", 0, "Seed of the sampling of the classes, 0 for a seed unique in space and time"};
+
   Filter trackFilter = requireGlobalTrackInFilter();
 
   using BigTracksML = soa::Filtered<soa::Join<aod::FullTracks, aod::TracksDCA, aod::pidTOFbeta, aod::TrackSelection, aod::TOFSignal, aod::McTrackLabels>>;
-  using MyCollisionML = aod::Collisions::iterator;
   using BigTracks = soa::Filtered<soa::Join<aod::FullTracks, aod::TracksDCA, aod::pidTOFbeta, aod::pidTPCFullEl, aod::pidTOFFullEl, aod::pidTPCFullMu, aod::pidTOFFullMu, aod::pidTPCFullPi, aod::pidTOFFullPi, aod::pidTPCFullKa, aod::pidTOFFullKa, aod::pidTPCFullPr, aod::pidTOFFullPr, aod::TrackSelection, aod::TOFSignal, aod::McTrackLabels>>;
-  using MyCollision = soa::Join<aod::Collisions, aod::CentRun2V0Ms, aod::Mults>::iterator;
+  using MyCollisions = soa::Join<aod::Collisions, aod::CentRun2V0Ms, aod::Mults>;
 
   HistogramRegistry registry{
     "registry",
@@ -45,11 +50,69 @@ struct CreateTableMc {
      {"hTOFBetavsPt", "TOF beta vs #it{p}_{T};#it{p}_{T} (GeV/#it{c});TOF beta", {HistType::kTH2F, {{500, 0., 10.}, {500, 0., 2.}}}},
      {"hTRDSigvsPt", "TRD signal vs #it{p}_{T};#it{p}_{T} (GeV/#it{c});TRD signal", {HistType::kTH2F, {{500, 0., 10.}, {2500, 0., 100.}}}}}};
 
-  void processML(MyCollisionML const& collision, BigTracksML const& tracks, aod::McParticles_000 const& mctracks)
+  // labels of the MC particles, gathered once per time frame and looked up with the MC label of the tracks
+  std::vector<int> mPdgCodes;
+  std::vector<uint8_t> mIsPrimary;
+  TRandom3 mRandom;
+
+  void init(InitContext const&)
+  {
+    mRandom.SetSeed(randomSeed);
+  }
+
+  void gatherMcLabels(aod::McParticles_000 const& mctracks)
+  {
+    mPdgCodes.resize(mctracks.size());
+    mIsPrimary.resize(mctracks.size());
+    int index = 0;
+    for (const auto& mcParticle : mctracks) {
+      mPdgCodes[index] = mcParticle.pdgCode();
+      mIsPrimary[index] = (uint8_t)mcParticle.isPhysicalPrimary();
+      index++;
+    }
+  }
+
+  /// \return whether a track of the given PDG code is sampled in the training table
+  bool sampleClass(int pdgCode)
+  {
+    int iClass = 5;
+    switch (std::abs(pdgCode)) {
+      case 11:
+        iClass = 0;
+        break;
+      case 13:
+        iClass = 1;
+        break;
+      case 211:
+        iClass = 2;
+        break;
+      case 321:
+        iClass = 3;
+        break;
+      case 2212:
+        iClass = 4;
+        break;
+    }
+    const auto& fractions = classFractions.value;
+    if (iClass >= (int)fractions.size() || fractions[iClass] >= 1.f) {
+      return true;
+    }
+    return mRandom.Rndm() < fractions[iClass];
+  }
+
+  void processML(BigTracksML const& tracks, aod::McParticles_000 const& mctracks)
   {
+    gatherMcLabels(mctracks);
+    pidTracksTableML.reserve(tracks.size());
     for (const auto& track : tracks) {
-      const auto mcParticle = track.mcParticle_as<aod::McParticles_000>();
-      uint8_t isPrimary = (uint8_t)mcParticle.isPhysicalPrimary();
+      const int label = track.mcParticleId();
+      if (!track.has_collision() || label < 0 || label >= (int)mPdgCodes.size()) {
+        continue;
+      }
+      const int pdgCode = mPdgCodes[label];
+      if (!sampleClass(pdgCode)) {
+        continue;
+      }
       pidTracksTableML(track.tpcSignal(), track.trdSignal(), track.trdPattern(),
                        track.tofSignal(), track.beta(),
                        track.p(), track.pt(), track.px(), track.py(), track.pz(),
@@ -59,8 +122,8 @@ struct CreateTableMc {
                        track.trackType(),
                        track.tpcNClsShared(),
                        track.dcaXY(), track.dcaZ(),
-                       mcParticle.pdgCode(),
-                       isPrimary);
+                       pdgCode,
+                       mIsPrimary[label]);
 
       registry.fill(HIST("hTPCSigvsPt"), track.pt(), track.tpcSignal());
       registry.fill(HIST("hTOFBetavsPt"), track.pt(), track.beta());
@@ -69,11 +132,20 @@ struct CreateTableMc {
   }
   PROCESS_SWITCH(CreateTableMc, processML, "Produce only ML MC essential data", true);
 
-  void processAll(MyCollision const& collision, BigTracks const& tracks, aod::McParticles_000 const& mctracks)
+  void processAll(MyCollisions const& collisions, BigTracks const& tracks, aod::McParticles_000 const& mctracks)
   {
+    gatherMcLabels(mctracks);
+    pidTracksTable.reserve(tracks.size());
     for (const auto& track : tracks) {
-      const auto mcParticle = track.mcParticle_as<aod::McParticles_000>();
-      uint8_t isPrimary = (uint8_t)mcParticle.isPhysicalPrimary();
+      const int label = track.mcParticleId();
+      if (!track.has_collision() || label < 0 || label >= (int)mPdgCodes.size()) {
+        continue;
+      }
+      const int pdgCode = mPdgCodes[label];
+      if (!sampleClass(pdgCode)) {
+        continue;
+      }
+      const auto collision = track.collision_as<MyCollisions>();
       pidTracksTable(collision.centRun2V0M(),
                      collision.multFV0A(), collision.multFV0C(), collision.multFV0M(),
                      collision.multFT0A(), collision.multFT0C(), collision.multFT0M(),
@@ -99,8 +171,8 @@ struct CreateTableMc {
                      track.tofNSigmaKa(), track.tofExpSigmaKa(), track.tofExpSignalDiffKa(),
                      track.tpcNSigmaPr(), track.tpcExpSigmaPr(), track.tpcExpSignalDiffPr(),
                      track.tofNSigmaPr(), track.tofExpSigmaPr(), track.tofExpSignalDiffPr(),
-                     mcParticle.pdgCode(),
-                     isPrimary);
+                     pdgCode,
+                     mIsPrimary[label]);
 
       registry.fill(HIST("hTPCSigvsPt"), track.pt(), track.tpcSignal());
       registry.fill(HIST("hTOFBetavsPt"), track.pt(), track.beta());
@@ -18,9 +18,14 @@
 #define O2_ANALYSIS_PIDONNXMODEL_H_
 
 #include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+#include "Common/Core/OnnxSessionRegistry.h"
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
+#include <gsl/span>
+#include <algorithm>
+#include <array>
 #include <string>
+#include <vector>
 
 // TODO: Copied from cefpTask, shall we put it in some common utils code?
 namespace
@@ -49,14 +54,13 @@ struct PidONNXModel {
     std::string modelFile;
     loadInputFiles(scalingParamsFile, useTOF, pid, modelFile);
 
-    Ort::SessionOptions sessionOptions;
-    mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "pid-onnx-inferer");
-    mSession.reset(new Ort::Experimental::Session{*mEnv, modelFile, sessionOptions});
+    // The session is shared with the other instances using the same model
+    mModel = o2::analysis::OnnxSessionRegistry::instance().getModel(modelFile);
 
-    mInputNames = mSession->GetInputNames();
-    mInputShapes = mSession->GetInputShapes();
-    mOutputNames = mSession->GetOutputNames();
-    mOutputShapes = mSession->GetOutputShapes();
+    mInputNames = mModel->inputNames();
+    mInputShapes = mModel->inputShapes();
+    mOutputNames = mModel->outputNames();
+    mOutputShapes = mModel->outputShapes();
 
     LOG(debug) << "Input Node Name/Shape (" << mInputNames.size() << "):";
     for (size_t i = 0; i < mInputNames.size(); i++) {
@@ -70,16 +74,23 @@ struct PidONNXModel {
 
     // Assume model has 1 input node and 1 output node.
     assert(mInputNames.size() == 1 && mOutputNames.size() == 1);
+    if (mInputShapes[0].back() != nInputFeatures) {
+      LOG(fatal) << "Model " << modelFile << " expects " << mInputShapes[0].back() << " input features, " << nInputFeatures << " are provided";
+    }
   }
   PidONNXModel() = default;
   PidONNXModel(PidONNXModel& other) = default;
   ~PidONNXModel() = default;
 
+  /// Attaches a histogram filled with the latency of each inference call (us)
+  void setLatencyHistogram(std::shared_ptr<TH1> histLatency) { mModel->setLatencyHistogram(histLatency); }
+
   template <typename T>
   float applyModel(const T& track)
   {
     auto input_shape = mInputShapes[0];
-    std::vector<float> inputTensorValues = createInputsSingle(track);
+    std::array<float, nInputFeatures> inputTensorValues;
+    fillInputsSingle(track, inputTensorValues.data());
     std::vector<Ort::Value> inputTensors;
     inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(inputTensorValues.data(), inputTensorValues.size(), input_shape));
 
@@ -89,7 +100,7 @@ struct PidONNXModel {
     LOG(debug) << "input tensor shape: " << printShape(inputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
 
     try {
-      auto outputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
+      auto outputTensors = mModel->run(inputTensors);
 
       // Double-check the dimensions of the output tensors
       // The number of output tensors is equal to the number of output nodes specifed in the Run() call
@@ -104,6 +115,53 @@ struct PidONNXModel {
     return -1.0f; // unreachable code
   }
 
+  /// Evaluates the model for all tracks of a table or a table slice, with one inference call per batch
+  /// instead of one per track. Input and output buffers are owned by the model and reused across calls.
+  /// \param tracks table (slice) providing the columns used by the model
+  /// \return model output, one value per track in the order of the table, valid until the next call
+  template <typename T>
+  gsl::span<const float> applyModelBatch(const T& tracks)
+  {
+    const int64_t nFeatures = nInputFeatures;
+    const size_t nTracks = tracks.size();
+    if (nTracks == 0) {
+      return {};
+    }
+
+    // Models exported with a fixed batch dimension are evaluated in chunks of that size, the last one zero-padded
+    const size_t batchSize = mInputShapes[0][0] > 0 ? mInputShapes[0][0] : nTracks;
+    const size_t nRows = (nTracks + batchSize - 1) / batchSize * batchSize;
+    mBatchInputValues.assign(nRows * nFeatures, 0.f); // no reallocation once the largest batch has been seen
+    mBatchOutputValues.resize(nRows);
+
+    size_t iTrack = 0;
+    for (const auto& track : tracks) {
+      fillInputsSingle(track, &mBatchInputValues[iTrack * nFeatures]);
+      iTrack++;
+    }
+
+    std::vector<int64_t> inputShape = mInputShapes[0];
+    std::vector<int64_t> outputShape = mOutputShapes[0]; // one score per track
+    inputShape[0] = batchSize;
+    outputShape[0] = batchSize;
+    std::vector<Ort::Value> inputTensors;
+    std::vector<Ort::Value> outputTensors;
+    for (size_t firstRow = 0; firstRow < nRows; firstRow += batchSize) {
+      // Tensors are non-owning views on the preallocated buffers, the output is written in place
+      inputTensors.clear();
+      outputTensors.clear();
+      inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(&mBatchInputValues[firstRow * nFeatures], batchSize * nFeatures, inputShape));
+      outputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(&mBatchOutputValues[firstRow], batchSize, outputShape));
+      try {
+        mModel->run(inputTensors, outputTensors);
+      } catch (const Ort::Exception& exception) {
+        LOG(error) << "Error running batched model inference: " << exception.what();
+        std::fill(mBatchOutputValues.begin() + firstRow, mBatchOutputValues.begin() + firstRow + batchSize, -1.0f);
+      }
+    }
+    return gsl::span<const float>(mBatchOutputValues.data(), nTracks);
+  }
+
  private:
   void loadInputFiles(const std::string& scalingParamsFile, bool useTOF, int pid, std::string& modelFile)
   {
@@ -145,6 +203,15 @@ struct PidONNXModel {
 
   template <typename T>
   std::vector<float> createInputsSingle(const T& track)
+  {
+    std::vector<float> inputValues(nInputFeatures);
+    fillInputsSingle(track, inputValues.data());
+    return inputValues;
+  }
+
+  /// Writes the scaled model inputs of one track to the given row of the input buffer
+  template <typename T>
+  void fillInputsSingle(const T& track, float* inputValues)
   {
     // TODO: Hardcoded for now. Planning to implement RowView extension to get runtime access to selected columns
     // sign is short, trackType and tpcNClsShared uint8_t
@@ -158,9 +225,8 @@ struct PidONNXModel {
     float scaledDcaXY = (track.dcaXY() - mScalingParams.at("fDcaXY").first) / mScalingParams.at("fDcaXY").second;
     float scaledDcaZ = (track.dcaZ() - mScalingParams.at("fDcaZ").first) / mScalingParams.at("fDcaZ").second;
 
-    std::vector<float> inputValues{scaledTPCSignal, scaledTOFSignal, track.beta(), track.px(), track.py(), track.pz(), (float)track.sign(), scaledX, scaledY, scaledZ, scaledAlpha, (float)track.trackType(), scaledTPCNClsShared, scaledDcaXY, scaledDcaZ, track.p()};
-
-    return inputValues;
+    const float values[] = {scaledTPCSignal, scaledTOFSignal, track.beta(), track.px(), track.py(), track.pz(), (float)track.sign(), scaledX, scaledY, scaledZ, scaledAlpha, (float)track.trackType(), scaledTPCNClsShared, scaledDcaXY, scaledDcaZ, track.p()};
+    std::copy(std::begin(values), std::end(values), inputValues);
   }
 
   // Pretty prints a shape dimension vector
@@ -173,18 +239,23 @@ struct PidONNXModel {
     return ss.str();
   }
 
+  static constexpr int64_t nInputFeatures = 16; // number of values written by fillInputsSingle
+
   std::string mModelDir;
   std::vector<std::string> mTrainColumns;
   std::map<std::string, std::pair<float, float>> mScalingParams;
 
-  std::shared_ptr<Ort::Env> mEnv = nullptr;
-  // No empty constructors for Session, we need a pointer
-  std::shared_ptr<Ort::Experimental::Session> mSession = nullptr;
+  // Model and session from the process-wide ONNX session registry
+  std::shared_ptr<o2::analysis::OnnxModel> mModel = nullptr;
 
   std::vector<std::string> mInputNames;
   std::vector<std::vector<int64_t>> mInputShapes;
   std::vector<std::string> mOutputNames;
   std::vector<std::vector<int64_t>> mOutputShapes;
+
+  // Buffers of the batched inference, reused across calls
+  std::vector<float> mBatchInputValues;
+  std::vector<float> mBatchOutputValues;
 };
 
 #endif // O2_ANALYSIS_PIDONNXMODEL_H_
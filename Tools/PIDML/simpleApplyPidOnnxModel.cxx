@@ -66,8 +66,11 @@ struct SimpleApplyOnnxModelTask {
 
   void process(BigTracks const& tracks)
   {
+    // one inference call for all the tracks of the time frame
+    auto scores = pidModel.applyModelBatch(tracks);
+    size_t iTrack = 0;
     for (auto& track : tracks) {
-      float pid = pidModel.applyModel(track);
+      float pid = scores[iTrack++];
       // pid > 0 --> track is predicted to be of this kind; pid < 0 --> rejected
       LOGF(info, "collision id: %d track id: %d pid: %.3f p: %.3f; x: %.3f, y: %.3f, z: %.3f",
            track.collisionId(), track.index(), pid, track.p(), track.x(), track.y(), track.z());
@@ -109,6 +109,17 @@ struct TPCSpectraProviderTask {
     float species3NSigma = -99.;
     float species4NSigma = -99.;
 
+    // at most one row per track in each of the skimmed tables
+    if (saveTracks) {
+      outputTracks.reserve(tracks.size());
+    }
+    if (saveSmallTracks) {
+      outputSmallTracks.reserve(tracks.size());
+    }
+    if (saveSingleTracks) {
+      outputSingleTracks.reserve(tracks.size());
+    }
+
     for (auto& track : tracks) {
 
       if (saveSmallTracks || saveSingleTracks) {
@@ -18,4 +18,6 @@ function(o2physics_define_options)
   option(ENABLE_CASSERT "Enable asserts" OFF)
 
   option(ENABLE_UPGRADES "Enable detectors for upgrades" OFF)
+
+  option(ENABLE_BENCHMARKS "Build the micro-benchmarks, requires Google Benchmark" OFF)
 endfunction()